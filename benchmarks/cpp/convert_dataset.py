@@ -0,0 +1,64 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Converts a dataset of prepare_dataset.py to the binary format that gptManagerBenchmark memory-maps.
+
+The input is the JSON output of prepare_dataset.py, or its --stdout output with one sample per line. The binary
+format, in little endian, is:
+    char magic[8] = "TLLMDS01"; uint64 numSamples; uint64 numTokens;
+    uint64 offsets[numSamples + 1]; int32 outputLens[numSamples]; int32 taskIds[numSamples]; int32 tokens[numTokens]
+"""
+import argparse
+import itertools
+import json
+import struct
+import sys
+from array import array
+
+MAGIC = b"TLLMDS01"
+
+
+def read_samples(path):
+    with open(path) as f:
+        text = f.read()
+    try:
+        return json.loads(text)["samples"]
+    except json.JSONDecodeError:
+        return [json.loads(line) for line in text.splitlines() if line.strip()]
+
+
+def write_binary(samples, path):
+    offsets = array("Q", [0])
+    offsets.extend(
+        itertools.accumulate(len(s["input_ids"]) for s in samples))
+    output_lens = array("i", (s["output_len"] for s in samples))
+    task_ids = array("i", (s.get("task_id", -1) for s in samples))
+    tokens = array("i", (t for s in samples for t in s["input_ids"]))
+    with open(path, "wb") as f:
+        f.write(MAGIC)
+        f.write(struct.pack("<QQ", len(samples), len(tokens)))
+        for values in (offsets, output_lens, task_ids, tokens):
+            if sys.byteorder != "little":
+                values.byteswap()
+            values.tofile(f)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("input", help="Dataset of prepare_dataset.py.")
+    parser.add_argument("output", help="Binary dataset.")
+    args = parser.parse_args()
+    samples = read_samples(args.input)
+    write_binary(samples, args.output)
+    print(f"Wrote {len(samples)} samples to {args.output}")
@@ -25,23 +25,35 @@
 #include "tensorrt_llm/executor/executor.h"
 #include "tensorrt_llm/executor/tensor.h"
 #include "tensorrt_llm/plugins/api/tllmPlugin.h"
+#include "tensorrt_llm/runtime/commTimingTracker.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/gptJsonConfig.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/utils/numpyUtils.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <cxxopts.hpp>
+#include <fcntl.h>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <map>
 #include <memory>
 #include <nlohmann/json.hpp>
 #include <numeric>
 #include <optional>
 #include <random>
+#include <sstream>
 #include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <thread>
+#include <unistd.h>
 #include <utility>
 
 using namespace tensorrt_llm::batch_manager;
@@ -169,9 +181,87 @@ struct BenchmarkParams
     float gpuWeightsPercent{1.0};
 
     // Decoding params
+    texec::DecodingMode decodingMode{texec::DecodingMode::Auto()};
     std::optional<std::vector<std::vector<SizeType32>>> medusaChoices;
+    std::optional<texec::LookaheadDecodingConfig> lookaheadConfig;
+
+    // Concurrency levels of a sweep, the benchmark is run once per level
+    std::vector<int> concurrencySweep;
+    // Token throughput of a baseline run, one value per concurrency level
+    std::vector<float> baselineTokenThroughput;
+
+    // Timestamped trace or tenant classes replacing the dataset and the request rate
+    std::optional<std::string> tracePath{std::nullopt};
+    std::optional<std::string> tenantsPath{std::nullopt};
+    // Service level objectives of the goodput report
+    std::optional<float> ttftSloMs{std::nullopt};
+    std::optional<float> itlSloMs{std::nullopt};
 };
 
+texec::DecodingConfig makeDecodingConfig(BenchmarkParams const& benchmarkParams)
+{
+    return texec::DecodingConfig(
+        benchmarkParams.decodingMode, benchmarkParams.lookaheadConfig, benchmarkParams.medusaChoices);
+}
+
+// Collectives of an iteration, logged after its stats
+std::string commStatsToJsonStr(texec::CommStats const& commStats)
+{
+    auto ops = nlohmann::json::array();
+    for (auto const& op : commStats.ops)
+    {
+        ops.push_back({{"Op", op.op}, {"Strategy", op.strategy}, {"Calls", op.numCalls}, {"Time (ms)", op.timeMs},
+            {"Bytes", op.bytes}});
+    }
+    nlohmann::json json;
+    json["Comm Time (ms)"] = commStats.totalTimeMs;
+    json["Comm Bytes"] = commStats.totalBytes;
+    json["Comm Ops"] = std::move(ops);
+    return json.dump();
+}
+
+// Collectives timed by the plugins of this process since the previous call
+texec::CommStats takeCommStats()
+{
+    texec::CommStats commStats{0., 0, {}};
+    for (auto const& op : CommTimingTracker::getInstance().takeStats())
+    {
+        commStats.totalTimeMs += op.timeMs;
+        commStats.totalBytes += op.bytes;
+        commStats.ops.push_back(
+            texec::CommOpStats{CommTimingTracker::getOpName(op.op), op.strategy, op.numCalls, op.timeMs, op.bytes});
+    }
+    return commStats;
+}
+
+// Memory per subsystem of an iteration, logged after its stats
+std::string memoryTimelineStatsToJsonStr(texec::MemoryTimelineStats const& memoryStats)
+{
+    auto tags = nlohmann::json::array();
+    for (auto const& tag : memoryStats.tags)
+    {
+        tags.push_back({{"Tag", tag.tag}, {"Memory Type", tag.memoryType}, {"Current Bytes", tag.currentBytes},
+            {"Peak Bytes", tag.peakBytes}, {"Allocations", tag.numAllocations}, {"Frees", tag.numFrees}});
+    }
+    nlohmann::json json;
+    json["Untracked GPU Bytes"] = memoryStats.untrackedGpuBytes;
+    json["Memory Tags"] = std::move(tags);
+    return json.dump();
+}
+
+// Allocations of this process since the previous call
+texec::MemoryTimelineStats takeMemoryTimelineStats()
+{
+    texec::MemoryTimelineStats memoryStats{{}, MemoryTimeline::getUntrackedGpuBytes()};
+    for (auto const& tag : MemoryTimeline::getInstance().takeStats())
+    {
+        memoryStats.tags.push_back(texec::MemoryTagStats{MemoryTimeline::getTagName(tag.tag),
+            MemoryTimeline::getMemoryTypeName(tag.memoryType), tag.currentBytes, tag.peakBytes, tag.numAllocations,
+            tag.numFrees});
+    }
+    return memoryStats;
+}
+
 class InferenceRequestsSyncSend
 {
 public:
@@ -381,6 +471,15 @@ struct BenchInfo
     float firstTokenLatency{};
     std::optional<float> avgGenT2TLatency{};
     bool firstTokenSeen{false};
+    // Number of streamed responses, i.e. decoding steps that produced tokens
+    int numSteps{0};
+    int firstStepLength{0};
+    // Output tokens per generation step, accepted draft tokens plus one with speculative decoding
+    std::optional<float> acceptanceLength{};
+    std::optional<float> avgStepLatency{}; // millisecond
+    // Requests of a trace may be streamed or not, only streamed ones have first token metrics
+    bool streaming{true};
+    std::string tenant;
 };
 
 class Recorder
@@ -389,13 +488,27 @@ class Recorder
 
 public:
     explicit Recorder(std::string opCsvFile, bool streaming = false, int beamWidth = 1,
-        std::string responsesJsonFile = "", bool excludeInputInOutput = false)
+        std::string responsesJsonFile = "", bool excludeInputInOutput = false, bool speculativeDecoding = false)
         : mOpCsvFile(std::move(opCsvFile))
         , mStreaming(streaming)
         , mBeamWidth(beamWidth)
         , mRespJsonFile(std::move(responsesJsonFile))
         , mOutputHasInput(!excludeInputInOutput)
+        , mSpeculativeDecoding(speculativeDecoding && streaming)
+    {
+    }
+
+    /// @brief Token throughput of the same workload without speculative decoding, reports the speedup over it
+    void setBaselineTokenThroughput(std::optional<float> baselineTokenThroughput)
+    {
+        mBaselineTokenThroughput = baselineTokenThroughput;
+    }
+
+    /// @brief Report the share of the requests meeting the time to first token and inter-token latency objectives
+    void setSlos(std::optional<float> ttftSloMs, std::optional<float> itlSloMs)
     {
+        mTtftSloMs = ttftSloMs;
+        mItlSloMs = itlSloMs;
     }
 
     void initialize()
@@ -425,9 +538,13 @@ public:
     //   - However, if eos_id != -1, the token size of output sequence may be less than max_output_len, and token
     //   throughput may be inaccurate
     void recordStart(SizeType32 inputLength, SizeType32 maxNewTokens, uint64_t requestId,
-        std::chrono::time_point<std::chrono::steady_clock> const& start)
+        std::chrono::time_point<std::chrono::steady_clock> const& start, bool streaming = true,
+        std::string const& tenant = "")
     {
-        mRequestBenchInfos[requestId] = BenchInfo(inputLength, start);
+        auto& info = mRequestBenchInfos[requestId];
+        info = BenchInfo(inputLength, start);
+        info.streaming = streaming;
+        info.tenant = tenant;
     }
 
     void recordEnd(uint64_t requestId, bool hasError)
@@ -436,7 +553,8 @@ public:
         mRequestBenchInfos[requestId].hasError = hasError;
     }
 
-    void recordToken(uint64_t requestId)
+    /// @brief Record a streamed response carrying numTokens new tokens, more than one with speculative decoding
+    void recordToken(uint64_t requestId, int numTokens = 1)
     {
         TLLM_CHECK(mStreaming);
         TLLM_CHECK_WITH_INFO(mBeamWidth == 1, "gptManagerBenchmark streaming mode does not support beam > 1");
@@ -445,9 +563,16 @@ public:
         {
             mRequestBenchInfos[requestId].firstTokenTs = std::chrono::steady_clock::now();
             mRequestBenchInfos[requestId].firstTokenSeen = true;
+            mRequestBenchInfos[requestId].firstStepLength = numTokens;
+        }
+        else if (mSpeculativeDecoding)
+        {
+            // The context step doesn't speculate, only generation steps count
+            mAcceptanceLengthHistogram[numTokens] += 1;
         }
 
-        mRequestBenchInfos[requestId].outputLength += 1;
+        mRequestBenchInfos[requestId].outputLength += numTokens;
+        mRequestBenchInfos[requestId].numSteps += 1;
     }
 
     void recordEnd(uint64_t requestId, std::list<NamedTensor> const& responseTensors, bool hasError)
@@ -489,7 +614,7 @@ public:
         // Get the actual output length
         if (!response.hasError())
         {
-            if (!mStreaming)
+            if (!mStreaming || !mRequestBenchInfos[requestId].streaming)
             {
                 auto outputTokenIds = response.getResult().outputTokenIds;
 
@@ -507,7 +632,7 @@ public:
             }
             else
             {
-                this->recordToken(requestId);
+                this->recordToken(requestId, static_cast<int>(response.getResult().outputTokenIds.at(0).size()));
             }
         }
     }
@@ -524,7 +649,7 @@ public:
         {
             reqInfo.second.latency
                 = std::chrono::duration<float, std::milli>(reqInfo.second.end - reqInfo.second.start).count();
-            if (mStreaming)
+            if (mStreaming && reqInfo.second.streaming)
             {
                 reqInfo.second.firstTokenLatency
                     = std::chrono::duration<float, std::milli>(reqInfo.second.firstTokenTs - reqInfo.second.start)
@@ -536,6 +661,16 @@ public:
                               .count()
                         / static_cast<float>(reqInfo.second.outputLength - 1);
                 }
+                if (reqInfo.second.numSteps > 1)
+                {
+                    reqInfo.second.acceptanceLength
+                        = static_cast<float>(reqInfo.second.outputLength - reqInfo.second.firstStepLength)
+                        / static_cast<float>(reqInfo.second.numSteps - 1);
+                    reqInfo.second.avgStepLatency
+                        = std::chrono::duration<float, std::milli>(reqInfo.second.end - reqInfo.second.firstTokenTs)
+                              .count()
+                        / static_cast<float>(reqInfo.second.numSteps - 1);
+                }
             }
         }
     }
@@ -547,6 +682,8 @@ public:
         std::vector<float> reqLatencies;
         std::vector<float> ftLatencies;
         std::vector<float> genT2TLatencies;
+        std::vector<float> acceptanceLengths;
+        std::vector<float> stepLatencies;
 
         int totalOutputTokens{0};
         mNumErrorSamples = 0;
@@ -558,7 +695,7 @@ public:
                 reqLatencies.push_back(reqInfo.second.latency);
                 totalOutputTokens += reqInfo.second.outputLength;
 
-                if (mStreaming)
+                if (mStreaming && reqInfo.second.streaming)
                 {
                     ftLatencies.push_back(reqInfo.second.firstTokenLatency);
 
@@ -566,6 +703,14 @@ public:
                     {
                         genT2TLatencies.push_back(reqInfo.second.avgGenT2TLatency.value());
                     }
+                    if (reqInfo.second.acceptanceLength)
+                    {
+                        acceptanceLengths.push_back(reqInfo.second.acceptanceLength.value());
+                    }
+                    if (reqInfo.second.avgStepLatency)
+                    {
+                        stepLatencies.push_back(reqInfo.second.avgStepLatency.value());
+                    }
                 }
                 ++mNumSamples;
             }
@@ -589,7 +734,7 @@ public:
         mMaxSeqLatency = reqLatencies.back();
         mMinSeqLatency = reqLatencies.front();
 
-        if (mStreaming)
+        if (mStreaming && !ftLatencies.empty())
         {
             mAvgFtLatency = std::accumulate(ftLatencies.begin(), ftLatencies.end(), 0.F) / ftLatencies.size();
 
@@ -615,6 +760,72 @@ public:
                 mMinGenT2TLatency = genT2TLatencies.front();
             }
         }
+
+        if (mSpeculativeDecoding && !acceptanceLengths.empty())
+        {
+            mAvgAcceptanceLength
+                = std::accumulate(acceptanceLengths.begin(), acceptanceLengths.end(), 0.F) / acceptanceLengths.size();
+
+            std::sort(acceptanceLengths.begin(), acceptanceLengths.end());
+
+            mP99AcceptanceLength = calcPercentile(acceptanceLengths, 99);
+            mP90AcceptanceLength = calcPercentile(acceptanceLengths, 90);
+            mP50AcceptanceLength = calcPercentile(acceptanceLengths, 50);
+            mMaxAcceptanceLength = acceptanceLengths.back();
+            mMinAcceptanceLength = acceptanceLengths.front();
+
+            if (!stepLatencies.empty())
+            {
+                mAvgStepLatency
+                    = std::accumulate(stepLatencies.begin(), stepLatencies.end(), 0.F) / stepLatencies.size();
+            }
+        }
+
+        if (mBaselineTokenThroughput && mBaselineTokenThroughput.value() > 0.F)
+        {
+            mTokenThroughputSpeedup = mTokenThroughput / mBaselineTokenThroughput.value();
+        }
+
+        if (mTtftSloMs || mItlSloMs)
+        {
+            calculateGoodput();
+        }
+    }
+
+    /// @brief Share of the requests meeting the objectives, overall and per tenant. Requests with errors miss them.
+    /// The first token of a request that is not streamed is only seen with the last one, its sequence latency counts.
+    void calculateGoodput()
+    {
+        std::map<std::string, std::pair<int, int>> tenantCounts; // tenant -> (met, total)
+        int numMet{0};
+        for (auto const& [reqId, info] : mRequestBenchInfos)
+        {
+            bool met = !info.hasError;
+            if (met && mTtftSloMs)
+            {
+                auto const ttft = mStreaming && info.streaming ? info.firstTokenLatency : info.latency;
+                met = ttft <= mTtftSloMs.value();
+            }
+            if (met && mItlSloMs && info.avgGenT2TLatency)
+            {
+                met = info.avgGenT2TLatency.value() <= mItlSloMs.value();
+            }
+            numMet += met;
+            auto& counts = tenantCounts[info.tenant];
+            counts.first += met;
+            counts.second += 1;
+        }
+        auto const numRequests = static_cast<int>(mRequestBenchInfos.size());
+        mSloAttainment = numRequests > 0 ? 100.F * numMet / numRequests : 0.F;
+        mGoodput = numMet / (mTotalLatency / 1000);
+        mTenantSloAttainment.clear();
+        if (tenantCounts.size() > 1)
+        {
+            for (auto const& [tenant, counts] : tenantCounts)
+            {
+                mTenantSloAttainment[tenant] = 100.F * counts.first / counts.second;
+            }
+        }
     }
 
     void report()
@@ -650,6 +861,44 @@ public:
             printf("[BENCHMARK] p90_inter_token_latency(ms) %.2f\n", mP90GenT2TLatency);
             printf("[BENCHMARK] p50_inter_token_latency(ms) %.2f\n\n", mP50GenT2TLatency);
         }
+
+        if (mSpeculativeDecoding)
+        {
+            printf("[BENCHMARK] avg_acceptance_length(token/step) %.2f\n", mAvgAcceptanceLength);
+            printf("[BENCHMARK] max_acceptance_length(token/step) %.2f\n", mMaxAcceptanceLength);
+            printf("[BENCHMARK] min_acceptance_length(token/step) %.2f\n", mMinAcceptanceLength);
+            printf("[BENCHMARK] p99_acceptance_length(token/step) %.2f\n", mP99AcceptanceLength);
+            printf("[BENCHMARK] p90_acceptance_length(token/step) %.2f\n", mP90AcceptanceLength);
+            printf("[BENCHMARK] p50_acceptance_length(token/step) %.2f\n", mP50AcceptanceLength);
+            printf("[BENCHMARK] avg_decoding_step_latency(ms) %.2f\n", mAvgStepLatency);
+            // Share of the decoding steps producing each number of tokens
+            std::uint64_t numSteps{0};
+            for (auto const& [numTokens, count] : mAcceptanceLengthHistogram)
+            {
+                numSteps += count;
+            }
+            for (auto const& [numTokens, count] : mAcceptanceLengthHistogram)
+            {
+                printf("[BENCHMARK] steps_with_%d_tokens(%%) %.2f\n", numTokens, 100.0 * count / numSteps);
+            }
+            printf("\n");
+        }
+
+        if (mTokenThroughputSpeedup)
+        {
+            printf("[BENCHMARK] token_throughput_speedup %.2f\n\n", mTokenThroughputSpeedup.value());
+        }
+
+        if (mSloAttainment)
+        {
+            printf("[BENCHMARK] slo_attainment(%%) %.2f\n", mSloAttainment.value());
+            printf("[BENCHMARK] goodput(seq/sec) %.2f\n", mGoodput);
+            for (auto const& [tenant, attainment] : mTenantSloAttainment)
+            {
+                printf("[BENCHMARK] slo_attainment_%s(%%) %.2f\n", tenant.c_str(), attainment);
+            }
+            printf("\n");
+        }
     }
 
     void writeOpMetricsToCsv()
@@ -672,6 +921,27 @@ public:
                 headers.insert(headers.end(), streamingHeaders.begin(), streamingHeaders.end());
             }
 
+            if (mSpeculativeDecoding)
+            {
+                std::vector<std::string> speculativeHeaders = {"avg_acceptance_length(token/step)",
+                    "max_acceptance_length(token/step)", "min_acceptance_length(token/step)",
+                    "p99_acceptance_length(token/step)", "p90_acceptance_length(token/step)",
+                    "p50_acceptance_length(token/step)", "avg_decoding_step_latency(ms)"};
+
+                headers.insert(headers.end(), speculativeHeaders.begin(), speculativeHeaders.end());
+            }
+
+            if (mTokenThroughputSpeedup)
+            {
+                headers.emplace_back("token_throughput_speedup");
+            }
+
+            if (mSloAttainment)
+            {
+                headers.emplace_back("slo_attainment(%)");
+                headers.emplace_back("goodput(seq/sec)");
+            }
+
             std::ofstream outputFile(mOpCsvFile);
 
             if (outputFile.is_open())
@@ -691,6 +961,20 @@ public:
                                << mAvgGenT2TLatency << "," << mMaxGenT2TLatency << "," << mMinGenT2TLatency << ","
                                << mP99GenT2TLatency << "," << mP90GenT2TLatency << "," << mP50GenT2TLatency;
                 }
+                if (mSpeculativeDecoding)
+                {
+                    outputFile << "," << mAvgAcceptanceLength << "," << mMaxAcceptanceLength << ","
+                               << mMinAcceptanceLength << "," << mP99AcceptanceLength << "," << mP90AcceptanceLength
+                               << "," << mP50AcceptanceLength << "," << mAvgStepLatency;
+                }
+                if (mTokenThroughputSpeedup)
+                {
+                    outputFile << "," << mTokenThroughputSpeedup.value();
+                }
+                if (mSloAttainment)
+                {
+                    outputFile << "," << mSloAttainment.value() << "," << mGoodput;
+                }
 
                 outputFile << "\n";
             }
@@ -755,6 +1039,22 @@ private:
     float mP50GenT2TLatency{};
     float mMaxGenT2TLatency{};
     float mMinGenT2TLatency{};
+    float mAvgAcceptanceLength{};
+    float mP99AcceptanceLength{};
+    float mP90AcceptanceLength{};
+    float mP50AcceptanceLength{};
+    float mMaxAcceptanceLength{};
+    float mMinAcceptanceLength{};
+    float mAvgStepLatency{};
+    std::optional<float> mBaselineTokenThroughput{};
+    std::optional<float> mTokenThroughputSpeedup{};
+    std::optional<float> mTtftSloMs{};
+    std::optional<float> mItlSloMs{};
+    std::optional<float> mSloAttainment{}; // percent
+    float mGoodput{};                      // requests meeting the objectives per second
+    std::map<std::string, float> mTenantSloAttainment;
+    // Number of decoding steps per number of tokens produced in the step
+    std::map<int, std::uint64_t> mAcceptanceLengthHistogram;
 
     std::string mOpCsvFile;
     bool mStreaming;
@@ -762,6 +1062,7 @@ private:
     std::string mRespJsonFile;
     std::unordered_map<uint64_t, TensorPtr> mResponseTensors;
     bool mOutputHasInput;
+    bool mSpeculativeDecoding;
 
 }; // class Recorder
 
@@ -802,9 +1103,7 @@ public:
             executorConfig.setMaxNumTokens(benchmarkParams.maxNumTokens.value());
         }
 
-        executorConfig.setDecodingConfig(texec::DecodingConfig(
-            benchmarkParams.medusaChoices.has_value() ? texec::DecodingMode::Medusa() : texec::DecodingMode::Auto(),
-            std::nullopt, benchmarkParams.medusaChoices));
+        executorConfig.setDecodingConfig(makeDecodingConfig(benchmarkParams));
 
         mExecutor = std::make_unique<texec::Executor>(trtEnginePath, texec::ModelType::kDECODER_ONLY, executorConfig);
 
@@ -823,16 +1122,18 @@ public:
         }
     }
 
-    void enqueue(std::vector<texec::Request> requests, bool warmup = false)
+    void enqueue(std::vector<texec::Request> requests, bool warmup = false, std::string const& tenant = "")
     {
         try
         {
             std::vector<SizeType32> inputLengths;
             std::vector<SizeType32> maxNewTokens;
+            std::vector<bool> streaming;
             for (auto const& request : requests)
             {
                 inputLengths.push_back(request.getInputTokenIds().size());
                 maxNewTokens.push_back(request.getMaxNewTokens());
+                streaming.push_back(request.getStreaming());
             }
             auto const start = std::chrono::steady_clock::now();
             auto reqIds = mExecutor->enqueueRequests(std::move(requests));
@@ -840,7 +1141,8 @@ public:
             {
                 if (!warmup)
                 {
-                    mRecorder->recordStart(inputLengths.at(req), maxNewTokens.at(req), reqIds.at(req), start);
+                    mRecorder->recordStart(
+                        inputLengths.at(req), maxNewTokens.at(req), reqIds.at(req), start, streaming.at(req), tenant);
                 }
                 mActiveCount++;
             }
@@ -856,6 +1158,16 @@ public:
         mNumFinished = 0;
     }
 
+    void setRecorder(std::shared_ptr<Recorder> recorder)
+    {
+        mRecorder = std::move(recorder);
+    }
+
+    void setConcurrency(std::optional<int> concurrency)
+    {
+        mConcurrency = concurrency;
+    }
+
     bool canEnqueue(int numSentRequests) const
     {
         return !mConcurrency || (numSentRequests - mNumFinished < mConcurrency);
@@ -883,7 +1195,8 @@ public:
                 {
                     if (!warmup && !response.hasError())
                     {
-                        mRecorder->recordToken(reqId);
+                        mRecorder->recordToken(
+                            reqId, static_cast<int>(response.getResult().outputTokenIds.at(0).size()));
                     }
                 }
             }
@@ -898,6 +1211,14 @@ public:
             for (auto const& iterStat : iterStats)
             {
                 TLLM_LOG_INFO(texec::JsonSerialization::toJsonStr(iterStat));
+                if (iterStat.commStats)
+                {
+                    TLLM_LOG_INFO(commStatsToJsonStr(iterStat.commStats.value()));
+                }
+                if (iterStat.memoryTimelineStats)
+                {
+                    TLLM_LOG_INFO(memoryTimelineStatsToJsonStr(iterStat.memoryTimelineStats.value()));
+                }
             }
             auto const waitSleep = std::chrono::milliseconds(50);
             std::this_thread::sleep_for(waitSleep);
@@ -946,6 +1267,15 @@ public:
             if (logIterationData)
             {
                 TLLM_LOG_INFO(log);
+                // The callback runs between iterations in this process, which also runs the plugins
+                if (CommTimingTracker::isEnabled())
+                {
+                    TLLM_LOG_INFO(commStatsToJsonStr(takeCommStats()));
+                }
+                if (MemoryTimeline::isEnabled())
+                {
+                    TLLM_LOG_INFO(memoryTimelineStatsToJsonStr(takeMemoryTimelineStats()));
+                }
             }
 
             if (mStaticEmulatedBatchSize)
@@ -1196,10 +1526,123 @@ struct Sample
     std::vector<int32_t> inputIds;
     int32_t outputLen;
     int32_t taskId;
+    // Set by a trace or a tenant class, overrides --streaming
+    std::optional<bool> streaming{std::nullopt};
+    std::string tenant{};
 };
 
 using Samples = std::vector<Sample>;
 
+// Binary dataset, memory-mapped so that the samples are only read when their requests are created:
+//   char magic[8] = "TLLMDS01"; uint64 numSamples; uint64 numTokens;
+//   uint64 offsets[numSamples + 1]; int32 outputLens[numSamples]; int32 taskIds[numSamples]; int32 tokens[numTokens]
+// in little endian, the prompt of sample i being tokens[offsets[i], offsets[i + 1]). See convert_dataset.py.
+class MappedDataset
+{
+public:
+    static constexpr char kMagic[8] = {'T', 'L', 'L', 'M', 'D', 'S', '0', '1'};
+
+    [[nodiscard]] static bool isBinary(std::filesystem::path const& datasetPath)
+    {
+        std::ifstream stream(datasetPath, std::ios::binary);
+        char magic[sizeof(kMagic)]{};
+        stream.read(magic, sizeof(magic));
+        return stream.good() && std::equal(std::begin(magic), std::end(magic), std::begin(kMagic));
+    }
+
+    explicit MappedDataset(std::filesystem::path const& datasetPath)
+    {
+        auto const fd = ::open(datasetPath.c_str(), O_RDONLY);
+        TLLM_CHECK_WITH_INFO(fd >= 0, "Cannot open dataset %s", datasetPath.c_str());
+        struct stat st;
+        if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= kHeaderSize)
+        {
+            mSize = static_cast<std::size_t>(st.st_size);
+            mData = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd);
+        TLLM_CHECK_WITH_INFO(mData != nullptr && mData != MAP_FAILED, "Cannot map dataset %s", datasetPath.c_str());
+
+        auto const* bytes = static_cast<char const*>(mData);
+        std::memcpy(&mNumSamples, bytes + sizeof(kMagic), sizeof(mNumSamples));
+        std::memcpy(&mNumTokens, bytes + sizeof(kMagic) + sizeof(mNumSamples), sizeof(mNumTokens));
+        auto const expectedSize = kHeaderSize + (mNumSamples + 1) * sizeof(std::uint64_t)
+            + (2 * mNumSamples + mNumTokens) * sizeof(std::int32_t);
+        TLLM_CHECK_WITH_INFO(mSize == expectedSize, "Dataset %s has %zu bytes, expected %zu for %lu samples",
+            datasetPath.c_str(), mSize, expectedSize, mNumSamples);
+        mOffsets = reinterpret_cast<std::uint64_t const*>(bytes + kHeaderSize);
+        mOutputLens = reinterpret_cast<std::int32_t const*>(mOffsets + mNumSamples + 1);
+        mTaskIds = mOutputLens + mNumSamples;
+        mTokens = mTaskIds + mNumSamples;
+        TLLM_CHECK_WITH_INFO(mOffsets[mNumSamples] == mNumTokens, "Corrupted dataset %s", datasetPath.c_str());
+        // The samples are read in order
+        ::madvise(mData, mSize, MADV_SEQUENTIAL);
+    }
+
+    ~MappedDataset()
+    {
+        ::munmap(mData, mSize);
+    }
+
+    MappedDataset(MappedDataset const&) = delete;
+    MappedDataset& operator=(MappedDataset const&) = delete;
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return mNumSamples;
+    }
+
+    [[nodiscard]] Sample getSample(std::size_t index, std::optional<SizeType32> const maxPromptLen) const
+    {
+        TLLM_CHECK(index < mNumSamples);
+        auto const begin = mOffsets[index];
+        auto end = mOffsets[index + 1];
+        TLLM_CHECK_WITH_INFO(begin <= end && end <= mNumTokens, "Corrupted sample %zu", index);
+        if (maxPromptLen)
+        {
+            end = std::min(end, begin + static_cast<std::uint64_t>(maxPromptLen.value()));
+        }
+        return Sample{std::vector<int32_t>(mTokens + begin, mTokens + end), mOutputLens[index], mTaskIds[index]};
+    }
+
+private:
+    static constexpr std::size_t kHeaderSize = sizeof(kMagic) + 2 * sizeof(std::uint64_t);
+
+    void* mData{nullptr};
+    std::size_t mSize{0};
+    std::uint64_t mNumSamples{0};
+    std::uint64_t mNumTokens{0};
+    std::uint64_t const* mOffsets{nullptr};
+    std::int32_t const* mOutputLens{nullptr};
+    std::int32_t const* mTaskIds{nullptr};
+    std::int32_t const* mTokens{nullptr};
+};
+
+struct Workload
+{
+    Samples samples;
+    // Arrival time of each sample in seconds from the start, empty if the request rate paces the samples
+    std::vector<double> arrivalTimes;
+    // Binary dataset the samples are read from when their requests are created, instead of samples
+    std::shared_ptr<MappedDataset> dataset;
+    std::size_t numDatasetSamples{0};
+    std::optional<SizeType32> maxPromptLen;
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return dataset ? numDatasetSamples : samples.size();
+    }
+
+    [[nodiscard]] Sample getSample(std::size_t index) const
+    {
+        return dataset ? dataset->getSample(index, maxPromptLen) : samples.at(index);
+    }
+};
+
+// Token ids of synthesized prompts, below the vocab size of any model
+auto constexpr kMinSyntheticTokenId = 100;
+auto constexpr kMaxSyntheticTokenId = 999;
+
 Samples parseWorkloadJson(
     std::filesystem::path const& datasetPath, int maxNumSamples, std::optional<SizeType32> const maxPromptLen)
 {
@@ -1226,6 +1669,201 @@ Samples parseWorkloadJson(
     return samples;
 }
 
+// Reads all the samples of a JSON or binary dataset
+Samples loadSamples(
+    std::filesystem::path const& datasetPath, int maxNumSamples, std::optional<SizeType32> const maxPromptLen)
+{
+    if (!MappedDataset::isBinary(datasetPath))
+    {
+        return parseWorkloadJson(datasetPath, maxNumSamples, maxPromptLen);
+    }
+    MappedDataset const dataset(datasetPath);
+    auto const numSamples = std::min(dataset.size(), static_cast<std::size_t>(std::max(maxNumSamples, 0)));
+    Samples samples;
+    samples.reserve(numSamples);
+    for (std::size_t i = 0; i < numSamples; ++i)
+    {
+        samples.emplace_back(dataset.getSample(i, maxPromptLen));
+    }
+    return samples;
+}
+
+// Replay of a timestamped trace:
+//   {"requests": [{"arrival_time": 0.52, "input_len": 812, "output_len": 128, "prefix_id": 3, "prefix_len": 512,
+//                  "task_id": 2, "streaming": true, "tenant": "chat"}, ...]}
+// Arrival times are in seconds, relative to the earliest one. Prompts are given as input_ids or synthesized from
+// input_len, requests with the same prefix_id then share their first prefix_len tokens.
+Workload parseTraceJson(std::filesystem::path const& tracePath, int maxNumSamples,
+    std::optional<SizeType32> const maxPromptLen, int randomSeed)
+{
+    TLLM_CHECK_WITH_INFO(std::filesystem::exists(tracePath), "File does not exist: %s", tracePath.c_str());
+    std::ifstream jsonStream(tracePath);
+    auto const json = nlohmann::json::parse(jsonStream, nullptr, true, true);
+
+    std::mt19937 gen(randomSeed);
+    std::uniform_int_distribution<int32_t> tokenDist(kMinSyntheticTokenId, kMaxSyntheticTokenId);
+    std::vector<std::pair<double, Sample>> entries;
+    for (auto const& request : json["requests"])
+    {
+        if (entries.size() >= maxNumSamples)
+            break;
+        std::vector<int32_t> inputIds;
+        if (request.count("input_ids"))
+        {
+            inputIds = request["input_ids"].get<std::vector<int32_t>>();
+        }
+        else
+        {
+            auto const inputLen = request["input_len"].get<SizeType32>();
+            if (request.count("prefix_id"))
+            {
+                auto const prefixLen = std::min(request.value("prefix_len", 0), inputLen);
+                std::mt19937 prefixGen(request["prefix_id"].get<std::uint32_t>());
+                std::generate_n(std::back_inserter(inputIds), prefixLen, [&]() { return tokenDist(prefixGen); });
+            }
+            std::generate_n(std::back_inserter(inputIds), inputLen - inputIds.size(), [&]() { return tokenDist(gen); });
+        }
+        if (maxPromptLen && (inputIds.size() > maxPromptLen.value()))
+        {
+            inputIds.resize(maxPromptLen.value());
+        }
+        Sample sample{std::move(inputIds), request["output_len"].get<int32_t>(), request.value("task_id", -1)};
+        if (request.count("streaming"))
+        {
+            sample.streaming = request["streaming"].get<bool>();
+        }
+        sample.tenant = request.value("tenant", "");
+        entries.emplace_back(request["arrival_time"].get<double>(), std::move(sample));
+    }
+    TLLM_CHECK_WITH_INFO(!entries.empty(), "Trace %s has no requests", tracePath.c_str());
+
+    std::stable_sort(
+        entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+    Workload workload;
+    auto const firstArrival = entries.front().first;
+    for (auto& [arrival, sample] : entries)
+    {
+        workload.arrivalTimes.push_back(arrival - firstArrival);
+        workload.samples.emplace_back(std::move(sample));
+    }
+    return workload;
+}
+
+// Arrival times of a Markov-modulated Poisson process, which stays in state i for an exponentially distributed time
+// with mean dwellTimes[i] seconds, with Poisson arrivals at rates[i] requests per second, then moves on to state i + 1.
+// Bursts are states with a high rate, a single state is a Poisson process.
+std::vector<double> generateMmppArrivals(
+    std::vector<double> const& rates, std::vector<double> const& dwellTimes, int count, std::mt19937& gen)
+{
+    TLLM_CHECK_WITH_INFO(!rates.empty(), "An arrival process needs at least one rate");
+    TLLM_CHECK_WITH_INFO(rates.size() == 1 || dwellTimes.size() == rates.size(), "One dwell time per rate expected");
+    TLLM_CHECK_WITH_INFO(std::any_of(rates.begin(), rates.end(), [](auto rate) { return rate > 0.0; }),
+        "An arrival process needs a positive rate");
+
+    auto constexpr never = std::numeric_limits<double>::infinity();
+    std::size_t state = 0;
+    double time = 0.0;
+    auto const nextSwitch = [&]()
+    {
+        return rates.size() > 1 ? time + std::exponential_distribution<double>(1.0 / dwellTimes.at(state))(gen)
+                                : never;
+    };
+    auto switchTime = nextSwitch();
+
+    std::vector<double> arrivals;
+    arrivals.reserve(count);
+    while (arrivals.size() < count)
+    {
+        auto const rate = rates.at(state);
+        auto const arrival = rate > 0.0 ? time + std::exponential_distribution<double>(rate)(gen) : never;
+        if (arrival < switchTime)
+        {
+            time = arrival;
+            arrivals.push_back(time);
+        }
+        else
+        {
+            // Memoryless, the arrival drawn past the switch is dropped
+            time = switchTime;
+            state = (state + 1) % rates.size();
+            switchTime = nextSwitch();
+        }
+    }
+    return arrivals;
+}
+
+// A mix of tenant classes, each with its own dataset and arrival process:
+//   {"tenants": [{"name": "chat", "dataset": "chat.json", "num_requests": 400, "rates": [2.0, 20.0],
+//                 "dwell_times": [30.0, 5.0], "streaming": true}, ...]}
+// The samples of a dataset are reused in order when it has fewer than num_requests.
+Workload generateTenantWorkload(
+    std::filesystem::path const& tenantsPath, std::optional<SizeType32> const maxPromptLen, int randomSeed)
+{
+    TLLM_CHECK_WITH_INFO(std::filesystem::exists(tenantsPath), "File does not exist: %s", tenantsPath.c_str());
+    std::ifstream jsonStream(tenantsPath);
+    auto const json = nlohmann::json::parse(jsonStream, nullptr, true, true);
+
+    std::vector<std::pair<double, Sample>> entries;
+    int tenantIdx = 0;
+    for (auto const& tenant : json["tenants"])
+    {
+        auto const name = tenant.value("name", "tenant" + std::to_string(tenantIdx));
+        auto const numRequests = tenant["num_requests"].get<int>();
+        auto const dataset = loadSamples(tenant["dataset"].get<std::string>(), numRequests, maxPromptLen);
+        TLLM_CHECK_WITH_INFO(!dataset.empty(), "Dataset of tenant %s has no samples", name.c_str());
+
+        std::mt19937 gen(randomSeed + tenantIdx);
+        auto const arrivals = generateMmppArrivals(tenant["rates"].get<std::vector<double>>(),
+            tenant.value("dwell_times", std::vector<double>{}), numRequests, gen);
+        for (int i = 0; i < numRequests; ++i)
+        {
+            auto sample = dataset.at(i % dataset.size());
+            if (tenant.count("streaming"))
+            {
+                sample.streaming = tenant["streaming"].get<bool>();
+            }
+            sample.tenant = name;
+            entries.emplace_back(arrivals.at(i), std::move(sample));
+        }
+        ++tenantIdx;
+    }
+    TLLM_CHECK_WITH_INFO(!entries.empty(), "No tenants in %s", tenantsPath.c_str());
+
+    std::stable_sort(
+        entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+    Workload workload;
+    for (auto& [arrival, sample] : entries)
+    {
+        workload.arrivalTimes.push_back(arrival);
+        workload.samples.emplace_back(std::move(sample));
+    }
+    return workload;
+}
+
+Workload loadWorkload(std::filesystem::path const& datasetPath, int maxNumSamples,
+    std::optional<SizeType32> const maxPromptLen, BenchmarkParams const& benchmarkParams)
+{
+    if (benchmarkParams.tracePath)
+    {
+        return parseTraceJson(
+            benchmarkParams.tracePath.value(), maxNumSamples, maxPromptLen, benchmarkParams.randomSeed);
+    }
+    if (benchmarkParams.tenantsPath)
+    {
+        return generateTenantWorkload(benchmarkParams.tenantsPath.value(), maxPromptLen, benchmarkParams.randomSeed);
+    }
+    if (MappedDataset::isBinary(datasetPath))
+    {
+        Workload workload;
+        workload.dataset = std::make_shared<MappedDataset>(datasetPath);
+        workload.numDatasetSamples
+            = std::min(workload.dataset->size(), static_cast<std::size_t>(std::max(maxNumSamples, 0)));
+        workload.maxPromptLen = maxPromptLen;
+        return workload;
+    }
+    return Workload{parseWorkloadJson(datasetPath, maxNumSamples, maxPromptLen), {}};
+}
+
 std::vector<double> generateRandomExponentialValues(int count, float lambda, int seed)
 {
     // Set a constant seed for reproducibility
@@ -1268,6 +1906,18 @@ std::vector<double> computeTimeDelays(BenchmarkParams const& benchmarkParams, in
     return timeDelays;
 }
 
+// Output CSV of one concurrency level of a sweep, e.g. metrics.csv -> metrics_concurrency4.csv
+std::string sweepCsvFile(std::string const& opCsvFile, int concurrency)
+{
+    if (opCsvFile.empty())
+    {
+        return opCsvFile;
+    }
+    std::filesystem::path const path{opCsvFile};
+    auto const fileName = path.stem().string() + "_concurrency" + std::to_string(concurrency);
+    return (path.parent_path() / (fileName + path.extension().string())).string();
+}
+
 std::shared_ptr<InferenceRequest> makeRequest(std::uint64_t reqId, Sample const& sample, bool streaming,
     ITensor::SharedPtr const& beamWidthTensor, ITensor::SharedPtr const& eosId, ITensor::SharedPtr const& padId,
     BufferManager const& bufferManager, ITensor::SharedPtr const& returnContextLogits = nullptr,
@@ -1342,6 +1992,10 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
     std::optional<std::chrono::milliseconds> const batchTimeout, bool logIterationData, bool excludeInputInOutput,
     std::string const& responsesJsonFile, std::optional<SizeType32> const maxPromptLen, bool dumpProfile)
 {
+    TLLM_CHECK_WITH_INFO(benchmarkParams.concurrencySweep.empty(), "Concurrency sweeps only work if --api is executor");
+    TLLM_CHECK_WITH_INFO(!benchmarkParams.tracePath && !benchmarkParams.tenantsPath,
+        "Traces and tenant classes only work if --api is executor");
+
     TrtGptModelOptionalParams optionalParams;
 
     if (benchmarkParams.maxTokensInPagedKvCache)
@@ -1371,9 +2025,7 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
     optionalParams.maxBatchSize = benchmarkParams.maxBatchSize;
     optionalParams.maxNumTokens = benchmarkParams.maxNumTokens;
     optionalParams.schedulerConfig = texec::SchedulerConfig{capacitySchedulerPolicy};
-    optionalParams.decodingConfig = texec::DecodingConfig(
-        benchmarkParams.medusaChoices.has_value() ? texec::DecodingMode::Medusa() : texec::DecodingMode::Auto(),
-        std::nullopt, benchmarkParams.medusaChoices);
+    optionalParams.decodingConfig = makeDecodingConfig(benchmarkParams);
 
     auto const jsonConfig = GptJsonConfig::parse(engineDir / "config.json");
     auto const worldConfig = WorldConfig::mpi(jsonConfig.getGpusPerNode(), jsonConfig.getTensorParallelism(),
@@ -1385,7 +2037,7 @@ void benchmarkGptManager(std::filesystem::path const& engineDir, TrtGptModelType
         bufferManager.copyFrom(&beamWidth, ITensor::makeShape({1}), MemoryType::kPINNED)};
 
     // Load dataset
-    auto const samples = parseWorkloadJson(datasetPath, maxNumSamples, maxPromptLen);
+    auto const samples = loadSamples(datasetPath, maxNumSamples, maxPromptLen);
     auto const numSamples = samples.size();
 
     auto recorder = std::make_shared<Recorder>(
@@ -1507,11 +2159,24 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
     auto const& world = tensorrt_llm::mpi::MpiComm::world();
     auto worldRank = world.getRank();
 
-    // Load dataset
-    auto const samples = parseWorkloadJson(datasetPath, maxNumSamples, maxPromptLen);
-    auto const numSamples = samples.size();
-
-    auto recorder = std::make_shared<Recorder>(opCsvFile, benchmarkParams.streaming, beamWidth);
+    // Load dataset, trace or tenant classes
+    auto const workload = loadWorkload(datasetPath, maxNumSamples, maxPromptLen, benchmarkParams);
+    auto const& samples = workload.samples;
+    auto const& arrivalTimes = workload.arrivalTimes;
+    auto const numSamples = workload.size();
+
+    bool const isSpeculative = !benchmarkParams.decodingMode.isAuto();
+    // Streamed if any request is
+    bool const streaming = benchmarkParams.streaming
+        || std::any_of(
+            samples.begin(), samples.end(), [](auto const& sample) { return sample.streaming.value_or(false); });
+    auto const makeRecorder = [&](std::string const& csvFile)
+    {
+        auto recorder = std::make_shared<Recorder>(csvFile, streaming, beamWidth, "", false, isSpeculative);
+        recorder->setSlos(benchmarkParams.ttftSloMs, benchmarkParams.itlSloMs);
+        return recorder;
+    };
+    auto recorder = makeRecorder(opCsvFile);
 
     auto executorServer = std::make_shared<ExecutorServer>(engineDir, modelType, beamWidth, capacitySchedulerPolicy,
         benchmarkParams, recorder, waitSleep, staticEmulatedBatchSize, logIterationData);
@@ -1541,34 +2206,53 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
             std::vector<texec::Request> requests;
             for (auto i = 0; i < warmUp; ++i)
             {
-                requests.emplace_back(makeExecutorRequest(samples[0], beamWidth, eosId, padId,
+                requests.emplace_back(makeExecutorRequest(workload.getSample(0), beamWidth, eosId, padId,
                     benchmarkParams.streaming, returnContextLogits, returnGenerationLogits));
             }
             executorServer->enqueue(std::move(requests), true);
             executorServer->waitForResponses(warmUp, true);
         }
 
-        // Benchmark
+        // Benchmark, once per concurrency level of the sweep
+        std::vector<std::optional<int>> concurrencies{benchmarkParams.concurrency};
+        if (!benchmarkParams.concurrencySweep.empty())
         {
+            concurrencies.assign(benchmarkParams.concurrencySweep.begin(), benchmarkParams.concurrencySweep.end());
+        }
+        bool const isSweep = concurrencies.size() > 1;
+        for (std::size_t level = 0; level < concurrencies.size(); ++level)
+        {
+            auto const& concurrency = concurrencies.at(level);
+            if (isSweep)
+            {
+                printf("[BENCHMARK] concurrency %d\n", concurrency.value());
+                recorder = makeRecorder(sweepCsvFile(opCsvFile, concurrency.value()));
+                executorServer->setRecorder(recorder);
+                executorServer->setConcurrency(concurrency);
+            }
+            if (level < benchmarkParams.baselineTokenThroughput.size())
+            {
+                recorder->setBaselineTokenThroughput(benchmarkParams.baselineTokenThroughput.at(level));
+            }
+
             auto timeDelays = computeTimeDelays(benchmarkParams, numSamples - 1);
 
-            // Create requests
+            // Requests are created when they are enqueued, so that the samples of a binary dataset are read lazily
             recorder->initialize();
-            std::vector<texec::Request> requests;
-
-            for (std::size_t i = 0; i < numSamples; ++i)
+            auto const makeSampleRequest = [&](Sample const& sample)
             {
                 std::optional<texec::LoraConfig> loraConfig;
-                if (samples[i].taskId >= 0)
+                if (sample.taskId >= 0)
                 {
-                    loraConfig = texec::LoraConfig(samples[i].taskId);
+                    loraConfig = texec::LoraConfig(sample.taskId);
                 }
-                requests.emplace_back(makeExecutorRequest(samples[i], beamWidth, eosId, padId,
-                    benchmarkParams.streaming, returnContextLogits, returnGenerationLogits, loraConfig));
-            }
+                return makeExecutorRequest(sample, beamWidth, eosId, padId,
+                    sample.streaming.value_or(benchmarkParams.streaming), returnContextLogits, returnGenerationLogits,
+                    loraConfig);
+            };
 
-            bool const hasDelay
-                = std::any_of(timeDelays.begin(), timeDelays.end(), [](auto const& delay) { return delay > 0.0; });
+            bool const hasDelay = !arrivalTimes.empty()
+                || std::any_of(timeDelays.begin(), timeDelays.end(), [](auto const& delay) { return delay > 0.0; });
             executorServer->resetNumFinished();
             if (!staticEmulatedBatchSize)
             {
@@ -1577,13 +2261,22 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
                     [numSamples, executorServer]() { executorServer->waitForResponses(numSamples); });
 
                 // Enqueue requests one by one
+                auto const benchmarkStart = std::chrono::steady_clock::now();
                 int numSentRequests = 0;
                 while (numSentRequests < numSamples)
                 {
                     if (executorServer->canEnqueue(numSentRequests))
                     {
-                        executorServer->enqueue({requests.at(numSentRequests)});
-                        if (hasDelay && numSentRequests < numSamples - 1)
+                        if (!arrivalTimes.empty())
+                        {
+                            // Absolute arrival times, so that the time spent enqueuing doesn't accumulate
+                            std::this_thread::sleep_until(benchmarkStart
+                                + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(arrivalTimes.at(numSentRequests))));
+                        }
+                        auto const sample = workload.getSample(numSentRequests);
+                        executorServer->enqueue({makeSampleRequest(sample)}, false, sample.tenant);
+                        if (arrivalTimes.empty() && hasDelay && numSentRequests < numSamples - 1)
                         {
                             std::this_thread::sleep_for(
                                 std::chrono::milliseconds(static_cast<int>(timeDelays.at(numSentRequests) * 1000)));
@@ -1597,25 +2290,28 @@ void benchmarkExecutor(std::filesystem::path const& engineDir, TrtGptModelType m
             {
                 TLLM_CHECK_WITH_INFO(
                     !hasDelay, "Executor benchmark doesn't support delays with emulated static batch sizes");
-                SizeType32 numRequests = requests.size();
+                SizeType32 numRequests = numSamples;
                 SizeType32 maxBatchSize = staticEmulatedBatchSize.value();
                 for (SizeType32 req = 0; req < numRequests; req += maxBatchSize)
                 {
                     auto batchSize = std::min(maxBatchSize, numRequests - req);
 
-                    std::vector<texec::Request> requestsBatch(std::make_move_iterator(requests.begin() + req),
-                        std::make_move_iterator(requests.begin() + req + batchSize));
+                    std::vector<texec::Request> requestsBatch;
+                    for (SizeType32 i = req; i < req + batchSize; ++i)
+                    {
+                        requestsBatch.emplace_back(makeSampleRequest(workload.getSample(i)));
+                    }
                     // Enqueue in batches
                     executorServer->enqueue(std::move(requestsBatch));
                     // Wait for current batch to be done
                     executorServer->waitForResponses(batchSize);
                 }
             }
+            recorder->finalize();
+            recorder->calculateMetrics();
+            recorder->report();
+            recorder->writeOpMetricsToCsv();
         }
-        recorder->finalize();
-        recorder->calculateMetrics();
-        recorder->report();
-        recorder->writeOpMetricsToCsv();
         // Send terminateReqId to terminate servers on all ranks
         // Sever on rank 0 will broadcast the terminate signal to other servers on multi-GPU cases
         // gptServer->enqueue(std::make_shared<InferenceRequest>(terminateReqId));
@@ -1648,6 +2344,23 @@ std::vector<std::vector<SizeType32>> parseVectorOfVectors(std::string const& inp
     return result;
 }
 
+template <typename T>
+std::vector<T> parseCommaSeparatedList(std::string const& input)
+{
+    std::vector<T> result;
+    std::istringstream stream(input);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        T value;
+        std::istringstream itemStream(item);
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(itemStream >> value), "Invalid list item '%s' in '%s'", item.c_str(),
+            input.c_str());
+        result.push_back(value);
+    }
+    return result;
+}
+
 } // namespace
 
 int main(int argc, char* argv[])
@@ -1660,7 +2373,8 @@ int main(int argc, char* argv[])
         "api", "API type: gptManager or executor.", cxxopts::value<std::string>()->default_value("executor"));
     options.add_options()("type", "Batching type: IFB, UIFB (unfused IFB) or V1 (non-IFB) batching.",
         cxxopts::value<std::string>()->default_value("IFB"));
-    options.add_options()("dataset", "Dataset that is used for benchmarking BatchManager.",
+    options.add_options()("dataset",
+        "Dataset that is used for benchmarking BatchManager, JSON or binary from convert_dataset.py.",
         cxxopts::value<std::string>()->default_value(""));
     options.add_options()(
         "output_csv", "Write output metrics to CSV", cxxopts::value<std::string>()->default_value(""));
@@ -1682,7 +2396,10 @@ int main(int argc, char* argv[])
     options.add_options()("request_rate",
         "request rate in reqs/sec. Skipping this arg or negative value will trigger offline/0-delay.",
         cxxopts::value<float>());
-    options.add_options()("concurrency", "Concurrent number of connections with the server.", cxxopts::value<int>());
+    options.add_options()("concurrency",
+        "Concurrent number of connections with the server. A comma-separated list, e.g. 1,4,16, runs the benchmark "
+        "once per level (only works if --api is executor).",
+        cxxopts::value<std::string>());
     options.add_options()("max_batch_size", "The max runtime batch size when benchmarking", cxxopts::value<int>());
     options.add_options()(
         "max_num_tokens", "The max runtime number of tokens per batch when benchmarking", cxxopts::value<int>());
@@ -1740,11 +2457,38 @@ int main(int argc, char* argv[])
         "max_prompt_len", "Truncate all prompts from dataset to the length specified.", cxxopts::value<SizeType32>());
 
     options.add_options()("dump_profile", "Print profile information per layer.", cxxopts::value<bool>());
+    options.add_options()("memory_timeline_file",
+        "Write the allocations recorded with TRTLLM_ENABLE_MEMORY_TIMELINE=1 as a Chrome trace to this file, with the "
+        "rank appended when there are several.",
+        cxxopts::value<std::string>());
     options.add_options()("gpu_weights_percent",
         "Specify the percentage of weights that reside on GPU (from 0.0 to 1.0).",
         cxxopts::value<float>()->default_value("1.0"));
     options.add_options()(
         "medusa_choices", "Medusa choices in the format of [[0], [0, 1], [0, 0, 1]]", cxxopts::value<std::string>());
+    options.add_options()("speculative_decoding_mode",
+        "Speculative decoding mode of the engine: none, medusa, lookahead or explicit_draft_tokens. Acceptance "
+        "statistics are reported in streaming mode.",
+        cxxopts::value<std::string>()->default_value("none"));
+    options.add_options()("lookahead_config",
+        "Lookahead decoding config in the format of [window_size, ngram_size, verification_set_size]",
+        cxxopts::value<std::string>());
+    options.add_options()("trace",
+        "Timestamped trace to replay instead of the dataset, with arrival time, prompt and output lengths, "
+        "shared-prefix id, LoRA task id, streaming flag and tenant of each request (only works if --api is executor).",
+        cxxopts::value<std::string>());
+    options.add_options()("tenants",
+        "Tenant classes to mix instead of the dataset, each with its dataset and Markov-modulated Poisson arrivals "
+        "(only works if --api is executor).",
+        cxxopts::value<std::string>());
+    options.add_options()("ttft_slo_ms", "Time to first token objective of the goodput report, in ms.",
+        cxxopts::value<float>());
+    options.add_options()("itl_slo_ms", "Inter-token latency objective of the goodput report, in ms.",
+        cxxopts::value<float>());
+    options.add_options()("baseline_token_throughput",
+        "Token throughput (token/sec) of the workload without speculative decoding, one value per concurrency level. "
+        "Reports the speedup over it.",
+        cxxopts::value<std::string>());
 
     auto result = options.parse(argc, argv);
 
@@ -1843,7 +2587,16 @@ int main(int argc, char* argv[])
     // Argument: concurrency
     if (result.count("concurrency"))
     {
-        benchmarkParams.concurrency = result["concurrency"].as<int>();
+        auto const concurrencies = parseCommaSeparatedList<int>(result["concurrency"].as<std::string>());
+        TLLM_CHECK_WITH_INFO(!concurrencies.empty(), "--concurrency must not be empty");
+        if (concurrencies.size() == 1)
+        {
+            benchmarkParams.concurrency = concurrencies.front();
+        }
+        else
+        {
+            benchmarkParams.concurrencySweep = concurrencies;
+        }
     }
 
     // Argument: request rate
@@ -1897,6 +2650,84 @@ int main(int argc, char* argv[])
         benchmarkParams.medusaChoices = parseVectorOfVectors(result["medusa_choices"].as<std::string>());
     }
 
+    // Argument: Speculative decoding mode
+    auto speculativeDecodingMode = result["speculative_decoding_mode"].as<std::string>();
+    if (benchmarkParams.medusaChoices && speculativeDecodingMode == "none")
+    {
+        speculativeDecodingMode = "medusa";
+    }
+    if (speculativeDecodingMode == "medusa")
+    {
+        benchmarkParams.decodingMode = texec::DecodingMode::Medusa();
+    }
+    else if (speculativeDecodingMode == "lookahead")
+    {
+        benchmarkParams.decodingMode = texec::DecodingMode::Lookahead();
+    }
+    else if (speculativeDecodingMode == "explicit_draft_tokens")
+    {
+        benchmarkParams.decodingMode = texec::DecodingMode::ExplicitDraftTokens();
+    }
+    else if (speculativeDecodingMode != "none")
+    {
+        TLLM_LOG_ERROR("Unexpected speculative decoding mode: " + speculativeDecodingMode);
+        return 1;
+    }
+    if (speculativeDecodingMode != "none" && !benchmarkParams.streaming)
+    {
+        TLLM_LOG_WARNING("Acceptance length statistics are only reported with --streaming");
+    }
+
+    // Argument: Lookahead config for the lookahead speculative decoding.
+    if (result.count("lookahead_config"))
+    {
+        TLLM_CHECK_WITH_INFO(speculativeDecodingMode == "lookahead",
+            "--lookahead_config requires --speculative_decoding_mode lookahead");
+        auto const config = parseVectorOfVectors(result["lookahead_config"].as<std::string>());
+        TLLM_CHECK_WITH_INFO(config.size() == 1 && config.front().size() == 3,
+            "--lookahead_config must be in the format of [window_size, ngram_size, verification_set_size]");
+        auto const windowSize = config.front().at(0);
+        auto const ngramSize = config.front().at(1);
+        auto const verificationSetSize = config.front().at(2);
+        TLLM_CHECK_WITH_INFO(texec::LookaheadDecodingConfig::isLegal(windowSize, ngramSize, verificationSetSize),
+            "Illegal lookahead config [%d, %d, %d]", windowSize, ngramSize, verificationSetSize);
+        benchmarkParams.lookaheadConfig = texec::LookaheadDecodingConfig(windowSize, ngramSize, verificationSetSize);
+    }
+
+    // Argument: Baseline token throughput per concurrency level
+    if (result.count("baseline_token_throughput"))
+    {
+        benchmarkParams.baselineTokenThroughput
+            = parseCommaSeparatedList<float>(result["baseline_token_throughput"].as<std::string>());
+        auto const numLevels = std::max<std::size_t>(benchmarkParams.concurrencySweep.size(), 1);
+        TLLM_CHECK_WITH_INFO(benchmarkParams.baselineTokenThroughput.size() == numLevels,
+            "--baseline_token_throughput needs one value per concurrency level");
+    }
+
+    // Argument: Trace or tenant classes
+    TLLM_CHECK_WITH_INFO(!(result.count("trace") && result.count("tenants")),
+        "trace and tenants cannot be specified at the same time.");
+    if (result.count("trace"))
+    {
+        benchmarkParams.tracePath = result["trace"].as<std::string>();
+    }
+    if (result.count("tenants"))
+    {
+        benchmarkParams.tenantsPath = result["tenants"].as<std::string>();
+    }
+    TLLM_CHECK_WITH_INFO(!((benchmarkParams.tracePath || benchmarkParams.tenantsPath) && benchmarkParams.requestRate),
+        "request_rate cannot be specified with a trace or tenant classes, they set the arrival times.");
+
+    // Argument: Service level objectives
+    if (result.count("ttft_slo_ms"))
+    {
+        benchmarkParams.ttftSloMs = result["ttft_slo_ms"].as<float>();
+    }
+    if (result.count("itl_slo_ms"))
+    {
+        benchmarkParams.itlSloMs = result["itl_slo_ms"].as<float>();
+    }
+
     std::optional<TokenIdType> padId;
     // Argument: Padding token id
     if (result.count("pad_id"))
@@ -2029,5 +2860,17 @@ int main(int argc, char* argv[])
         return 1;
     }
 
+    if (result.count("memory_timeline_file") && MemoryTimeline::isEnabled())
+    {
+        auto& comm = COMM_SESSION;
+        auto path = result["memory_timeline_file"].as<std::string>();
+        if (comm.getSize() > 1)
+        {
+            path += "." + std::to_string(comm.getRank());
+        }
+        MemoryTimeline::getInstance().dump(path);
+        TLLM_LOG_INFO("Memory timeline written to %s", path.c_str());
+    }
+
     return 0;
 }
@@ -427,6 +427,8 @@ int main(int argc, char* argv[])
 
     options.add_options()("ctx_micro_batch_size", "Batch size for context phase.", cxxopts::value<int>());
     options.add_options()("gen_micro_batch_size", "Batch size for generation phase.", cxxopts::value<int>());
+    options.add_options()("finished_sync_interval",
+        "Wait for the finished state of the decoder only every this many generation steps.", cxxopts::value<int>());
     options.add_options()("max_attention_window", "Max kv cache length per sequence.", cxxopts::value<int>());
     options.add_options()("max_tokens_in_paged_kvcache", "Max tokens in paged K-V Cache.", cxxopts::value<int>());
     options.add_options()("sink_token_len", "Sink token length in kv cache per sequence.", cxxopts::value<int>());
@@ -527,6 +529,11 @@ int main(int argc, char* argv[])
     {
         sessionConfig.genMicroBatchSize = result["gen_micro_batch_size"].as<int>();
     }
+    // Argument: Finished sync interval
+    if (result.count("finished_sync_interval"))
+    {
+        sessionConfig.finishedSyncInterval = result["finished_sync_interval"].as<int>();
+    }
     // Argument: Max tokens in paged K-V Cache
     if (result.count("max_tokens_in_paged_kvcache"))
     {
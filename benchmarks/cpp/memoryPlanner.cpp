@@ -0,0 +1,232 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Memory forecast of an engine: loads the engine once to measure its weights and activation memory, then computes the
+// KV and LoRA cache split and the max batch and tokens for traffic shapes without running the engine.
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/plugins/api/tllmPlugin.h"
+#include "tensorrt_llm/runtime/gptJsonConfig.h"
+#include "tensorrt_llm/runtime/memoryPlanner.h"
+#include "tensorrt_llm/runtime/rawEngine.h"
+#include "tensorrt_llm/runtime/tllmLogger.h"
+#include "tensorrt_llm/runtime/tllmRuntime.h"
+
+#include <NvInfer.h>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+
+using namespace tensorrt_llm::runtime;
+
+namespace trt = nvinfer1;
+
+namespace
+{
+std::size_t getFreeGpuMemory()
+{
+    std::size_t freeBytes{0};
+    std::size_t totalBytes{0};
+    TLLM_CUDA_CHECK(cudaMemGetInfo(&freeBytes, &totalBytes));
+    return freeBytes;
+}
+
+void planMemory(std::filesystem::path const& dataPath, std::vector<TrafficShape> const& trafficShapes,
+    MemoryPlannerConfig config, std::optional<trt::DataType> kvCacheType, std::optional<SizeType32> tokensPerBlock,
+    bool measureGpuMemory, std::shared_ptr<nvinfer1::ILogger> const& logger)
+{
+    auto const json = GptJsonConfig::parse(dataPath / "config.json");
+    auto const modelConfig = json.getModelConfig();
+    auto const worldConfig
+        = WorldConfig::mpi(json.getGpusPerNode(), json.getTensorParallelism(), json.getPipelineParallelism());
+    auto const enginePath = dataPath / json.engineFilename(worldConfig);
+    config.kvCacheType = kvCacheType.value_or(modelConfig.getKvDataType());
+    config.tokensPerBlock = tokensPerBlock.value_or(modelConfig.getTokensPerBlock());
+
+    // The CUDA context exists at this point, the memory it takes is not usable by the engine either
+    TLLM_CUDA_CHECK(cudaSetDevice(worldConfig.getDevice()));
+    TLLM_CUDA_CHECK(cudaFree(nullptr));
+    auto const freeBefore = getFreeGpuMemory();
+    if (measureGpuMemory)
+    {
+        config.gpuMemoryBytes = freeBefore;
+    }
+
+    EngineMemory engineMemory{};
+    {
+        // The runtime allocates the execution context memory along with the weights
+        TllmRuntime const runtime{RawEngine{enginePath}, logger.get()};
+        auto const loaded = freeBefore - getFreeGpuMemory();
+        engineMemory.activationBytes = runtime.getEngine().getDeviceMemorySize();
+        engineMemory.weightsBytes = loaded > engineMemory.activationBytes ? loaded - engineMemory.activationBytes : 0;
+    }
+
+    MemoryPlanner const planner{modelConfig, worldConfig};
+    for (auto const& traffic : trafficShapes)
+    {
+        auto const plan = planner.plan(engineMemory, config, traffic);
+        printf("[MEMORY] rank %d input_length %d output_length %d beam_width %d\n%s\n", worldConfig.getRank(),
+            traffic.inputLength, traffic.outputLength, traffic.beamWidth, plan.report().c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options("TensorRT-LLM memory planner",
+        "Forecasts the memory split of an engine and the batch it can hold before deploying it.");
+    options.add_options()("h,help", "Print usage");
+    options.add_options()("engine_dir", "Directory that store the engines.", cxxopts::value<std::string>());
+    options.add_options()("input_output_len",
+        "Mean input and output lengths of the traffic. Multiple pairs can be separated by \";\", example: "
+        "\"128,128;2048,256\".",
+        cxxopts::value<std::string>()->default_value("128,128"));
+    options.add_options()("beam_width", "Beam width of the traffic.", cxxopts::value<int>()->default_value("1"));
+    options.add_options()("kv_cache_type", "KV cache data type: fp32, fp16, bf16, fp8 or int8. Defaults to the engine.",
+        cxxopts::value<std::string>());
+    options.add_options()(
+        "tokens_per_block", "Tokens per KV cache block. Defaults to the engine.", cxxopts::value<int>());
+    options.add_options()("kv_cache_free_gpu_mem_fraction", "Fraction of the free GPU memory used for the KV cache.",
+        cxxopts::value<float>()->default_value("0.9"));
+    options.add_options()("gpu_memory_gb",
+        "GPU memory of a rank to plan for, in GiB. Defaults to the free memory of the device before loading the "
+        "engine.",
+        cxxopts::value<double>());
+    options.add_options()("reserved_mb",
+        "Memory to keep outside of the caches for communicators, decoder and other runtime buffers, in MiB.",
+        cxxopts::value<double>()->default_value("0"));
+    options.add_options()("lora_device_module_layers",
+        "Size of the LoRA device cache in module layers, see PeftCacheConfig::numDeviceModuleLayer.",
+        cxxopts::value<int>()->default_value("0"));
+    options.add_options()("lora_adapter_size", "Adapter size the LoRA device cache is sized for.",
+        cxxopts::value<int>()->default_value("8"));
+    options.add_options()("lora_device_cache_percent",
+        "Fraction of the memory left after the KV cache for the LoRA device cache, used without "
+        "--lora_device_module_layers.",
+        cxxopts::value<float>()->default_value("0"));
+    options.add_options()("log_level", "Choose log level between verbose/info/warning/error/internal_error.",
+        cxxopts::value<std::string>()->default_value("error"));
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    if (!result.count("engine_dir"))
+    {
+        std::cout << options.help() << std::endl;
+        TLLM_LOG_ERROR("Please specify engine directory.");
+        return 1;
+    }
+
+    auto const beamWidth = result["beam_width"].as<int>();
+    std::vector<TrafficShape> trafficShapes;
+    std::istringstream ssInOutLenArg{result["input_output_len"].as<std::string>()};
+    for (std::string token; std::getline(ssInOutLenArg, token, ';');)
+    {
+        auto const comma = token.find(',');
+        if (comma == std::string::npos)
+        {
+            TLLM_LOG_ERROR("Expected input and output lengths separated by \",\" but got: %s", token.c_str());
+            return 1;
+        }
+        trafficShapes.push_back(
+            TrafficShape{std::stoi(token.substr(0, comma)), std::stoi(token.substr(comma + 1)), beamWidth});
+    }
+
+    std::optional<trt::DataType> kvCacheType;
+    if (result.count("kv_cache_type"))
+    {
+        static std::unordered_map<std::string, trt::DataType> const kvCacheTypes{{"fp32", trt::DataType::kFLOAT},
+            {"fp16", trt::DataType::kHALF}, {"bf16", trt::DataType::kBF16}, {"fp8", trt::DataType::kFP8},
+            {"int8", trt::DataType::kINT8}};
+        auto const name = result["kv_cache_type"].as<std::string>();
+        auto const it = kvCacheTypes.find(name);
+        if (it == kvCacheTypes.end())
+        {
+            TLLM_LOG_ERROR("Unexpected KV cache type: " + name);
+            return 1;
+        }
+        kvCacheType = it->second;
+    }
+    std::optional<SizeType32> tokensPerBlock;
+    if (result.count("tokens_per_block"))
+    {
+        tokensPerBlock = result["tokens_per_block"].as<int>();
+    }
+
+    MemoryPlannerConfig config{};
+    config.freeGpuMemoryFraction = result["kv_cache_free_gpu_mem_fraction"].as<float>();
+    config.reservedBytes = static_cast<std::size_t>(result["reserved_mb"].as<double>() * (1 << 20));
+    config.numDeviceLoraModuleLayer = result["lora_device_module_layers"].as<int>();
+    config.optimalLoraAdapterSize = result["lora_adapter_size"].as<int>();
+    config.loraDeviceCachePercent = result["lora_device_cache_percent"].as<float>();
+    auto const measureGpuMemory = !result.count("gpu_memory_gb");
+    if (!measureGpuMemory)
+    {
+        config.gpuMemoryBytes = static_cast<std::size_t>(result["gpu_memory_gb"].as<double>() * (1 << 30));
+    }
+
+    auto logger = std::make_shared<TllmLogger>();
+    auto const logLevel = result["log_level"].as<std::string>();
+    if (logLevel == "verbose")
+    {
+        logger->setLevel(trt::ILogger::Severity::kVERBOSE);
+    }
+    else if (logLevel == "info")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINFO);
+    }
+    else if (logLevel == "warning")
+    {
+        logger->setLevel(trt::ILogger::Severity::kWARNING);
+    }
+    else if (logLevel == "error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kERROR);
+    }
+    else if (logLevel == "internal_error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINTERNAL_ERROR);
+    }
+    else
+    {
+        TLLM_LOG_ERROR("Unexpected log level: " + logLevel);
+        return 1;
+    }
+
+    initTrtLlmPlugins(logger.get());
+
+    try
+    {
+        planMemory(result["engine_dir"].as<std::string>(), trafficShapes, config, kvCacheType, tokensPerBlock,
+            measureGpuMemory, logger);
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Per-layer roofline report of an engine: runs the engine on fixed batch sizes and lengths with the layer profiler
+// and compares the achieved FLOP/s and bytes/s of every layer with the peaks of the GPU.
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/plugins/api/tllmPlugin.h"
+#include "tensorrt_llm/runtime/gptJsonConfig.h"
+#include "tensorrt_llm/runtime/gptSession.h"
+#include "tensorrt_llm/runtime/rooflineModel.h"
+#include "tensorrt_llm/runtime/tllmLogger.h"
+
+#include <NvInfer.h>
+#include <algorithm>
+#include <cxxopts.hpp>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+
+using namespace tensorrt_llm::runtime;
+
+namespace trt = nvinfer1;
+
+namespace
+{
+struct RunConfig
+{
+    SizeType32 batchSize;
+    SizeType32 inputLength;
+    SizeType32 outputLength;
+};
+
+void reportRoofline(std::filesystem::path const& dataPath, std::vector<RunConfig> const& runConfigs,
+    SizeType32 beamWidth, std::shared_ptr<nvinfer1::ILogger> const& logger, int warmUp, int numRuns,
+    std::optional<GpuPeaks> const& peaksOverride, std::size_t numFlagged)
+{
+    auto const json = GptJsonConfig::parse(dataPath / "config.json");
+    auto const modelConfig = json.getModelConfig();
+    auto const worldConfig
+        = WorldConfig::mpi(json.getGpusPerNode(), json.getTensorParallelism(), json.getPipelineParallelism());
+    auto const enginePath = dataPath / json.engineFilename(worldConfig);
+    auto const peaks = peaksOverride.value_or(GpuPeaks::fromDevice(worldConfig.getDevice()));
+    RooflineModel const roofline{modelConfig, worldConfig, peaks};
+
+    SamplingConfig samplingConfig{beamWidth};
+    samplingConfig.topK = std::vector{1};
+
+    for (auto const& rc : runConfigs)
+    {
+        GptSession::Config sessionConfig{rc.batchSize, beamWidth, rc.inputLength + rc.outputLength};
+        sessionConfig.decoderPerRequest = false;
+        // Generate all the tokens of the workload
+        samplingConfig.minLength = std::vector{rc.outputLength};
+        GptSession session{sessionConfig, modelConfig, worldConfig, enginePath.string(), logger};
+        auto& bufferManager = session.getBufferManager();
+
+        auto constexpr endId = 50256;
+        auto constexpr padId = 50256;
+        std::vector<SizeType32> inputLengthsHost(rc.batchSize, rc.inputLength);
+        std::vector<TokenIdType> inputsHost(rc.batchSize * rc.inputLength);
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<TokenIdType> tokenDist(0, modelConfig.getVocabSize() - 1);
+        std::generate(inputsHost.begin(), inputsHost.end(), [&]() { return tokenDist(gen); });
+        auto const inputPacked = modelConfig.usePackedInput();
+        auto const inputShape = inputPacked ? ITensor::makeShape({rc.batchSize * rc.inputLength})
+                                            : ITensor::makeShape({rc.batchSize, rc.inputLength});
+        GenerationInput generationInput{endId, padId, bufferManager.copyFrom(inputsHost, inputShape, MemoryType::kGPU),
+            bufferManager.copyFrom(inputLengthsHost, ITensor::makeShape({rc.batchSize}), MemoryType::kGPU),
+            inputPacked};
+        GenerationOutput generationOutput{bufferManager.emptyTensor(MemoryType::kGPU, nvinfer1::DataType::kINT32),
+            bufferManager.emptyTensor(MemoryType::kGPU, nvinfer1::DataType::kINT32)};
+
+        for (auto r = 0; r < warmUp; ++r)
+        {
+            session.generate(generationOutput, generationInput, samplingConfig);
+        }
+        bufferManager.getStream().synchronize();
+
+        session.setLayerProfiler();
+        for (auto r = 0; r < numRuns; ++r)
+        {
+            session.generate(generationOutput, generationInput, samplingConfig);
+        }
+        bufferManager.getStream().synchronize();
+
+        auto const layers = roofline.analyze(session.getLayerTimes(),
+            RooflineWorkload{rc.batchSize, rc.inputLength, rc.outputLength, beamWidth}, numRuns);
+        // Every pipeline stage has its own layers
+        if (worldConfig.getTensorParallelRank() == 0)
+        {
+            printf("[ROOFLINE] pipeline_rank %d batch_size %d input_length %d output_length %d runs %d\n%s\n",
+                worldConfig.getPipelineParallelRank(), rc.batchSize, rc.inputLength, rc.outputLength, numRuns,
+                roofline.report(layers, numFlagged).c_str());
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    cxxopts::Options options(
+        "TensorRT-LLM roofline report", "Per-layer efficiency of an engine against the roofline of the GPU.");
+    options.add_options()("h,help", "Print usage");
+    options.add_options()("engine_dir", "Directory that store the engines.", cxxopts::value<std::string>());
+    options.add_options()("batch_size",
+        "Batch sizes of the workload. Multiple batch sizes can be separated by \";\", example: \"1;8;64\".",
+        cxxopts::value<std::string>()->default_value("8"));
+    options.add_options()("input_output_len",
+        "Input and output lengths of the workload. Multiple pairs can be separated by \";\", example: "
+        "\"60,20;128,20\".",
+        cxxopts::value<std::string>()->default_value("128,20"));
+    options.add_options()("beam_width", "Beam width of the workload.", cxxopts::value<int>()->default_value("1"));
+    options.add_options()("warm_up", "Warm up runs before profiling.", cxxopts::value<int>()->default_value("2"));
+    options.add_options()("num_runs", "Profiled runs per configuration.", cxxopts::value<int>()->default_value("5"));
+    options.add_options()("peak_tflops",
+        "Dense 16-bit tensor core TFLOP/s of the GPU, estimated from the device if not set.", cxxopts::value<double>());
+    options.add_options()("peak_bandwidth_gbs",
+        "Memory bandwidth of the GPU in GB/s, estimated from the device if not set.", cxxopts::value<double>());
+    options.add_options()("num_flagged", "Number of layers with the most time lost to flag.",
+        cxxopts::value<std::size_t>()->default_value("10"));
+    options.add_options()("log_level", "Choose log level between verbose/info/warning/error/internal_error.",
+        cxxopts::value<std::string>()->default_value("error"));
+
+    auto result = options.parse(argc, argv);
+
+    if (result.count("help"))
+    {
+        std::cout << options.help() << std::endl;
+        return 0;
+    }
+
+    if (!result.count("engine_dir"))
+    {
+        std::cout << options.help() << std::endl;
+        TLLM_LOG_ERROR("Please specify engine directory.");
+        return 1;
+    }
+
+    std::vector<SizeType32> batchSizes;
+    std::istringstream ssBatchSizesArg{result["batch_size"].as<std::string>()};
+    for (std::string token; std::getline(ssBatchSizesArg, token, ';');)
+    {
+        batchSizes.push_back(std::stoi(token));
+    }
+    std::vector<RunConfig> runConfigs;
+    std::istringstream ssInOutLenArg{result["input_output_len"].as<std::string>()};
+    for (std::string token; std::getline(ssInOutLenArg, token, ';');)
+    {
+        auto const comma = token.find(',');
+        if (comma == std::string::npos)
+        {
+            TLLM_LOG_ERROR("Expected input and output lengths separated by \",\" but got: %s", token.c_str());
+            return 1;
+        }
+        for (auto const batchSize : batchSizes)
+        {
+            runConfigs.push_back(
+                RunConfig{batchSize, std::stoi(token.substr(0, comma)), std::stoi(token.substr(comma + 1))});
+        }
+    }
+
+    std::optional<GpuPeaks> peaks;
+    if (result.count("peak_tflops") || result.count("peak_bandwidth_gbs"))
+    {
+        if (!result.count("peak_tflops") || !result.count("peak_bandwidth_gbs"))
+        {
+            TLLM_LOG_ERROR("--peak_tflops and --peak_bandwidth_gbs must be set together.");
+            return 1;
+        }
+        peaks = GpuPeaks{result["peak_tflops"].as<double>() * 1e12, result["peak_bandwidth_gbs"].as<double>() * 1e9};
+    }
+
+    auto logger = std::make_shared<TllmLogger>();
+    auto const logLevel = result["log_level"].as<std::string>();
+    if (logLevel == "verbose")
+    {
+        logger->setLevel(trt::ILogger::Severity::kVERBOSE);
+    }
+    else if (logLevel == "info")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINFO);
+    }
+    else if (logLevel == "warning")
+    {
+        logger->setLevel(trt::ILogger::Severity::kWARNING);
+    }
+    else if (logLevel == "error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kERROR);
+    }
+    else if (logLevel == "internal_error")
+    {
+        logger->setLevel(trt::ILogger::Severity::kINTERNAL_ERROR);
+    }
+    else
+    {
+        TLLM_LOG_ERROR("Unexpected log level: " + logLevel);
+        return 1;
+    }
+
+    initTrtLlmPlugins(logger.get());
+
+    try
+    {
+        reportRoofline(result["engine_dir"].as<std::string>(), runConfigs, result["beam_width"].as<int>(), logger,
+            result["warm_up"].as<int>(), result["num_runs"].as<int>(), peaks,
+            result["num_flagged"].as<std::size_t>());
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_ERROR(e.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import json
+import os
+from enum import Enum
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from pydantic import BaseModel, field_validator
+
+
+class BenchmarkKind(str, Enum):
+    GPT_SESSION = "gptSessionBenchmark"
+    GPT_MANAGER = "gptManagerBenchmark"
+    BERT = "bertBenchmark"
+    # A google-benchmark target of cpp/micro_benchmarks, named by `binary`
+    MICRO = "micro_benchmark"
+
+
+class Direction(str, Enum):
+    HIGHER = "higher"
+    LOWER = "lower"
+    # Reported but never flagged, e.g. the configuration echoed by a benchmark
+    NONE = "none"
+
+
+class BenchmarkConfig(BaseModel):
+    name: str
+    kind: BenchmarkKind
+    # Target name of a micro benchmark, e.g. decodingBenchmark
+    binary: Optional[str] = None
+    # Environment variables are expanded, e.g. ${ENGINE_ROOT}/llama_7b
+    args: List[str] = []
+    # Separate processes, the samples of the confidence intervals
+    repetitions: int = 5
+    timeout: int = 3600
+    # Direction of the metrics the name does not tell, see stats.infer_direction
+    metrics: Dict[str, Direction] = {}
+
+    @field_validator('repetitions')
+    def check_repetitions(cls, v: int) -> int:
+        if v < 2:
+            raise ValueError(
+                "At least 2 repetitions are needed for a confidence interval")
+        return v
+
+    @field_validator('binary')
+    def check_binary(cls, v: Optional[str], info) -> Optional[str]:
+        if info.data.get('kind') == BenchmarkKind.MICRO and not v:
+            raise ValueError("Micro benchmarks need the target name in binary")
+        return v
+
+    def command(self, build_dir: Path) -> List[str]:
+        if self.kind == BenchmarkKind.MICRO:
+            binary = build_dir / "micro_benchmarks" / self.binary
+        else:
+            binary = build_dir / "benchmarks" / (self.binary or self.kind.value)
+        return [str(binary)] + [os.path.expandvars(arg) for arg in self.args]
+
+
+class SuiteConfig(BaseModel):
+    name: str
+    # The cpp build directory, holding benchmarks/ and micro_benchmarks/
+    build_dir: str
+    benchmarks: List[BenchmarkConfig]
+
+    @field_validator('benchmarks')
+    def check_unique_names(
+            cls, v: List[BenchmarkConfig]) -> List[BenchmarkConfig]:
+        names = [benchmark.name for benchmark in v]
+        duplicates = {name for name in names if names.count(name) > 1}
+        if duplicates:
+            raise ValueError(f"Duplicate benchmark names: {duplicates}")
+        return v
+
+    @classmethod
+    def from_file(cls, path: str) -> "SuiteConfig":
+        with open(path) as f:
+            return cls(**json.load(f))
+
+    def get_build_dir(self) -> Path:
+        return Path(os.path.expandvars(self.build_dir))
@@ -0,0 +1,118 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import datetime
+import logging
+import platform
+import re
+import socket
+import subprocess
+from pathlib import Path
+from typing import Dict, List, Optional
+
+from pydantic import BaseModel
+
+GPU_QUERY = "name,driver_version,memory.total,clocks.max.sm,clocks.max.mem"
+
+
+class GpuInfo(BaseModel):
+    name: str
+    driver_version: str
+    memory_total: str
+    max_sm_clock: str
+    max_memory_clock: str
+
+
+class Metadata(BaseModel):
+    timestamp: str
+    hostname: str
+    platform: str
+    gpus: List[GpuInfo]
+    cuda_version: Optional[str]
+    git_commit: Optional[str]
+    # Versions of the libraries the benchmarks were built with
+    build: Dict[str, str]
+
+    def gpu_name(self) -> str:
+        return self.gpus[0].name if self.gpus else "unknown"
+
+    def differences(self, other: "Metadata") -> List[str]:
+        """The differences that make the comparison of two runs unfair."""
+        diffs = []
+        if [g.name for g in self.gpus] != [g.name for g in other.gpus]:
+            diffs.append(f"GPUs {self.gpu_name()} vs {other.gpu_name()}")
+        own_clocks = [(g.max_sm_clock, g.max_memory_clock) for g in self.gpus]
+        other_clocks = [(g.max_sm_clock, g.max_memory_clock)
+                        for g in other.gpus]
+        if own_clocks != other_clocks:
+            diffs.append("GPU max clocks")
+        return diffs
+
+
+def _run(command: List[str], cwd: Optional[Path] = None) -> Optional[str]:
+    try:
+        return subprocess.run(command,
+                              capture_output=True,
+                              text=True,
+                              check=True,
+                              cwd=cwd).stdout.strip()
+    except (OSError, subprocess.CalledProcessError) as e:
+        logging.warning(f"Cannot run {command[0]}: {e}")
+        return None
+
+
+def _query_gpus() -> List[GpuInfo]:
+    output = _run([
+        "nvidia-smi", f"--query-gpu={GPU_QUERY}", "--format=csv,noheader"
+    ])
+    gpus = []
+    for line in (output or "").splitlines():
+        fields = [field.strip() for field in line.split(",")]
+        if len(fields) == len(GPU_QUERY.split(",")):
+            gpus.append(GpuInfo(**dict(zip(GpuInfo.model_fields, fields))))
+    return gpus
+
+
+def _cuda_version() -> Optional[str]:
+    output = _run(["nvidia-smi"])
+    match = re.search(r"CUDA Version:\s*([\d.]+)", output or "")
+    return match.group(1) if match else None
+
+
+def _build_versions(build_dir: Path) -> Dict[str, str]:
+    """Versions recorded by CMake in the build directory."""
+    versions = {}
+    cache = build_dir / "CMakeCache.txt"
+    if not cache.exists():
+        return versions
+    pattern = re.compile(
+        r"^(CMAKE_CUDA_COMPILER_VERSION|CMAKE_BUILD_TYPE|TRT_LIB_DIR|"
+        r"CMAKE_CUDA_ARCHITECTURES)[^=]*=(.*)$")
+    for line in cache.read_text().splitlines():
+        match = pattern.match(line)
+        if match:
+            versions[match.group(1)] = match.group(2)
+    return versions
+
+
+def collect(build_dir: Path) -> Metadata:
+    repo_dir = Path(__file__).resolve().parent
+    return Metadata(
+        timestamp=datetime.datetime.now(datetime.timezone.utc).isoformat(),
+        hostname=socket.gethostname(),
+        platform=platform.platform(),
+        gpus=_query_gpus(),
+        cuda_version=_cuda_version(),
+        git_commit=_run(["git", "rev-parse", "HEAD"], cwd=repo_dir),
+        build=_build_versions(build_dir))
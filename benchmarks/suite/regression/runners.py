@@ -0,0 +1,123 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import json
+import logging
+import subprocess
+import tempfile
+from pathlib import Path
+from typing import Dict, List
+
+from regression.config import BenchmarkConfig, BenchmarkKind
+
+# case -> metric -> value of one run
+RunResult = Dict[str, Dict[str, float]]
+# case -> metric -> values of all the runs
+Samples = Dict[str, Dict[str, List[float]]]
+
+# Keys of a [BENCHMARK] line that identify the configuration, not a measurement
+CASE_KEYS = ("batch_size", "input_length", "output_length", "input_len",
+             "beam_width")
+
+# Fields of a google-benchmark JSON entry that are not counters
+GBENCH_FIELDS = {
+    "name", "family_index", "per_family_instance_index", "run_name",
+    "run_type", "repetitions", "repetition_index", "threads", "iterations",
+    "real_time", "cpu_time", "time_unit", "label", "error_occurred",
+    "error_message", "aggregate_name", "aggregate_unit", "skipped",
+    "skip_message"
+}
+
+
+def parse_benchmark_lines(output: str) -> RunResult:
+    """Parses the `[BENCHMARK] key value ...` lines of the cpp benchmarks.
+
+    Lines with case keys, e.g. gptSessionBenchmark with one line per batch
+    size, make a case each. The lines of gptManagerBenchmark, one metric per
+    line, go to the empty case. Values that are not numbers, e.g. N/A, are
+    skipped.
+    """
+    result: RunResult = {}
+    for line in output.splitlines():
+        line = line.strip()
+        if not line.startswith("[BENCHMARK]"):
+            continue
+        tokens = line[len("[BENCHMARK]"):].split()
+        pairs = list(zip(tokens[0::2], tokens[1::2]))
+        case = ",".join(f"{key}={value}" for key, value in pairs
+                        if key in CASE_KEYS)
+        metrics = result.setdefault(case, {})
+        for key, value in pairs:
+            if key in CASE_KEYS:
+                continue
+            try:
+                metrics[key] = float(value)
+            except ValueError:
+                continue
+    return result
+
+
+def parse_gbench_json(report: dict) -> RunResult:
+    """One case per google-benchmark entry: its real time and its counters."""
+    result: RunResult = {}
+    for entry in report.get("benchmarks", []):
+        if entry.get("error_occurred") or entry.get("skipped"):
+            continue
+        if entry.get("run_type", "iteration") != "iteration":
+            continue
+        metrics = {f"real_time({entry['time_unit']})": entry["real_time"]}
+        for key, value in entry.items():
+            if key not in GBENCH_FIELDS and isinstance(value, (int, float)):
+                metrics[key] = float(value)
+        result[entry["name"]] = metrics
+    return result
+
+
+def run_once(benchmark: BenchmarkConfig, build_dir: Path) -> RunResult:
+    command = benchmark.command(build_dir)
+    with tempfile.TemporaryDirectory() as tmp:
+        gbench_out = Path(tmp) / "gbench.json"
+        if benchmark.kind == BenchmarkKind.MICRO:
+            command += [
+                "--benchmark_format=console", f"--benchmark_out={gbench_out}",
+                "--benchmark_out_format=json"
+            ]
+        logging.debug(f"Running {' '.join(command)}")
+        process = subprocess.run(command,
+                                 capture_output=True,
+                                 text=True,
+                                 timeout=benchmark.timeout)
+        if process.returncode != 0:
+            raise RuntimeError(
+                f"{benchmark.name} failed with exit code {process.returncode}:"
+                f"\n{process.stderr[-4000:]}")
+        if benchmark.kind == BenchmarkKind.MICRO:
+            with open(gbench_out) as f:
+                return parse_gbench_json(json.load(f))
+        return parse_benchmark_lines(process.stdout)
+
+
+def run_benchmark(benchmark: BenchmarkConfig, build_dir: Path) -> Samples:
+    """Runs the benchmark in separate processes and collects the samples."""
+    samples: Samples = {}
+    for repetition in range(benchmark.repetitions):
+        logging.info(f"{benchmark.name}: repetition {repetition + 1}/"
+                     f"{benchmark.repetitions}")
+        for case, metrics in run_once(benchmark, build_dir).items():
+            case_samples = samples.setdefault(case, {})
+            for metric, value in metrics.items():
+                case_samples.setdefault(metric, []).append(value)
+    if not samples:
+        raise RuntimeError(f"{benchmark.name} reported no results")
+    return samples
@@ -0,0 +1,140 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import random
+import statistics
+from enum import Enum
+from typing import Dict, List, Optional, Tuple
+
+from pydantic import BaseModel
+from regression.config import Direction
+
+# Parts of metric names that tell their direction, checked in order
+LOWER_IS_BETTER = ("latency", "time", "(ms)", "(us)", "(ns)", "_ms", "_us",
+                   "_ns", "overhead", "evictions", "misses")
+HIGHER_IS_BETTER = ("throughput", "persec", "per_second", "gbps", "tflops",
+                    "roofline", "hit_rate", "max_batch_size")
+
+
+class Status(str, Enum):
+    REGRESSION = "regression"
+    IMPROVEMENT = "improvement"
+    # The interval still holds a regression of the threshold, more
+    # repetitions are needed to tell
+    INCONCLUSIVE = "inconclusive"
+    UNCHANGED = "unchanged"
+
+
+class Comparison(BaseModel):
+    benchmark: str
+    case: str
+    metric: str
+    direction: Direction
+    baseline_mean: float
+    current_mean: float
+    # Relative change of the mean, current / baseline - 1
+    change: float
+    ci_low: float
+    ci_high: float
+    status: Status
+
+
+def infer_direction(metric: str) -> Direction:
+    name = metric.lower()
+    if any(part in name for part in HIGHER_IS_BETTER):
+        return Direction.HIGHER
+    if any(part in name for part in LOWER_IS_BETTER):
+        return Direction.LOWER
+    return Direction.NONE
+
+
+def bootstrap_change(baseline: List[float],
+                     current: List[float],
+                     confidence: float,
+                     resamples: int,
+                     seed: int = 0) -> Tuple[float, float, float]:
+    """Relative change of the means and its percentile bootstrap interval.
+
+    Both sets of runs are resampled independently, which makes no assumption
+    on the distribution of the run times, unlike a t-interval.
+    """
+    baseline_mean = statistics.fmean(baseline)
+    change = statistics.fmean(current) / baseline_mean - 1.0
+    rng = random.Random(seed)
+    changes = []
+    for _ in range(resamples):
+        b = statistics.fmean(rng.choices(baseline, k=len(baseline)))
+        c = statistics.fmean(rng.choices(current, k=len(current)))
+        if b != 0.0:
+            changes.append(c / b - 1.0)
+    changes.sort()
+    alpha = (1.0 - confidence) / 2.0
+    low = changes[int(alpha * (len(changes) - 1))]
+    high = changes[int((1.0 - alpha) * (len(changes) - 1))]
+    return change, low, high
+
+
+def classify(change: float, low: float, high: float, direction: Direction,
+             threshold: float) -> Status:
+    if direction == Direction.NONE:
+        return Status.UNCHANGED
+    # Positive is better from here on
+    if direction == Direction.LOWER:
+        change, low, high = -change, -high, -low
+    if high < 0.0 and change <= -threshold:
+        return Status.REGRESSION
+    if low > 0.0 and change >= threshold:
+        return Status.IMPROVEMENT
+    if low <= -threshold and high >= 0.0:
+        return Status.INCONCLUSIVE
+    return Status.UNCHANGED
+
+
+def compare(baseline: Dict[str, Dict[str, Dict[str, List[float]]]],
+            current: Dict[str, Dict[str, Dict[str, List[float]]]],
+            threshold: float,
+            confidence: float,
+            resamples: int,
+            overrides: Optional[Dict[str, Dict[str, Direction]]] = None
+            ) -> List[Comparison]:
+    """Compares the samples of the benchmarks, cases and metrics in both."""
+    overrides = overrides or {}
+    comparisons = []
+    for benchmark, cases in current.items():
+        for case, metrics in cases.items():
+            for metric, samples in metrics.items():
+                baseline_samples = baseline.get(benchmark, {}).get(
+                    case, {}).get(metric)
+                if not baseline_samples or statistics.fmean(
+                        baseline_samples) == 0.0:
+                    continue
+                direction = overrides.get(benchmark, {}).get(
+                    metric, infer_direction(metric))
+                change, low, high = bootstrap_change(baseline_samples,
+                                                     samples, confidence,
+                                                     resamples)
+                comparisons.append(
+                    Comparison(benchmark=benchmark,
+                               case=case,
+                               metric=metric,
+                               direction=direction,
+                               baseline_mean=statistics.fmean(
+                                   baseline_samples),
+                               current_mean=statistics.fmean(samples),
+                               change=change,
+                               ci_low=low,
+                               ci_high=high,
+                               status=classify(change, low, high, direction,
+                                               threshold)))
+    return comparisons
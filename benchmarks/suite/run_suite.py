@@ -0,0 +1,185 @@
+# SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+# SPDX-License-Identifier: Apache-2.0
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+import json
+import logging
+import re
+import sys
+from pathlib import Path
+from typing import Dict, List
+
+import click
+from pydantic import BaseModel
+from regression import metadata, runners, stats
+from regression.config import Direction, SuiteConfig
+
+
+class SuiteResults(BaseModel):
+    suite: str
+    metadata: metadata.Metadata
+    # benchmark -> case -> metric -> samples
+    results: Dict[str, runners.Samples]
+    # benchmark -> metric -> direction, from the suite config
+    directions: Dict[str, Dict[str, Direction]] = {}
+
+    @classmethod
+    def load(cls, path: Path) -> "SuiteResults":
+        with open(path) as f:
+            return cls(**json.load(f))
+
+    def save(self, path: Path) -> None:
+        path.parent.mkdir(parents=True, exist_ok=True)
+        with open(path, "w") as f:
+            f.write(self.model_dump_json(indent=2))
+
+
+def baseline_path(baseline_dir: Path, results: SuiteResults) -> Path:
+    """Baselines are kept per suite and GPU: <dir>/<suite>/<gpu>.json."""
+    gpu = re.sub(r"[^A-Za-z0-9]+", "_", results.metadata.gpu_name()).strip("_")
+    return baseline_dir / results.suite / f"{gpu}.json"
+
+
+@click.group()
+@click.option("--log-level",
+              default="info",
+              type=click.Choice(['info', 'debug']),
+              help="Logging level.")
+def cli(log_level: str):
+    logging.basicConfig(format="%(asctime)s %(levelname)s %(message)s",
+                        level=logging.getLevelName(log_level.upper()))
+
+
+@cli.command()
+@click.option("--config",
+              required=True,
+              type=click.Path(exists=True, dir_okay=False),
+              help="Suite config, see configs/example_suite.json.")
+@click.option("--output",
+              required=True,
+              type=click.Path(dir_okay=False),
+              help="Output json filename.")
+@click.option("--only",
+              multiple=True,
+              help="Run only the benchmarks with these names.")
+def run(config: str, output: str, only: List[str]):
+    """Runs the benchmarks of a suite and stores their samples."""
+    suite = SuiteConfig.from_file(config)
+    build_dir = suite.get_build_dir()
+    results = SuiteResults(suite=suite.name,
+                           metadata=metadata.collect(build_dir),
+                           results={},
+                           directions={
+                               benchmark.name: benchmark.metrics
+                               for benchmark in suite.benchmarks
+                           })
+    failed = []
+    for benchmark in suite.benchmarks:
+        if only and benchmark.name not in only:
+            continue
+        try:
+            results.results[benchmark.name] = runners.run_benchmark(
+                benchmark, build_dir)
+        except Exception as e:
+            logging.error(f"{benchmark.name}: {e}")
+            failed.append(benchmark.name)
+    results.save(Path(output))
+    logging.info(f"Results written to {output}")
+    if failed:
+        logging.error(f"Failed benchmarks: {', '.join(failed)}")
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--baseline",
+              required=True,
+              type=click.Path(exists=True),
+              help="Baseline results, or a baseline directory in which the "
+              "baseline of the suite and GPU of the results is used.")
+@click.option("--results",
+              required=True,
+              type=click.Path(exists=True, dir_okay=False),
+              help="Results of the run to check.")
+@click.option("--threshold",
+              type=float,
+              default=3.0,
+              help="Smallest change in percent reported as a regression.")
+@click.option("--confidence",
+              type=float,
+              default=0.95,
+              help="Confidence level of the intervals.")
+@click.option("--resamples",
+              type=int,
+              default=2000,
+              help="Bootstrap resamples per metric.")
+@click.option("--show-all",
+              is_flag=True,
+              default=False,
+              help="Also print the unchanged metrics.")
+def compare(baseline: str, results: str, threshold: float, confidence: float,
+            resamples: int, show_all: bool):
+    """Compares results with a baseline, exits with 1 on a regression."""
+    current = SuiteResults.load(Path(results))
+    baseline_file = Path(baseline)
+    if baseline_file.is_dir():
+        baseline_file = baseline_path(baseline_file, current)
+    reference = SuiteResults.load(baseline_file)
+
+    for diff in current.metadata.differences(reference.metadata):
+        logging.warning(f"Different hardware, the comparison is unfair: "
+                        f"{diff}")
+    comparisons = stats.compare(reference.results, current.results,
+                                threshold / 100.0, confidence, resamples,
+                                current.directions)
+
+    print(f"{'status':<13} {'change':>8} {'interval':>19}  benchmark / case / "
+          f"metric")
+    for c in sorted(comparisons, key=lambda c: (c.status.value, c.change)):
+        if not show_all and c.status == stats.Status.UNCHANGED:
+            continue
+        print(f"{c.status.value:<13} {c.change * 100:>+7.2f}% "
+              f"[{c.ci_low * 100:>+7.2f}%, {c.ci_high * 100:>+7.2f}%]  "
+              f"{c.benchmark} / {c.case or '-'} / {c.metric}")
+
+    counts = {status: 0 for status in stats.Status}
+    for c in comparisons:
+        counts[c.status] += 1
+    print(", ".join(f"{count} {status.value}"
+                    for status, count in counts.items()))
+    missing = set(reference.results) - set(current.results)
+    if missing:
+        logging.warning(f"Benchmarks missing from the results: "
+                        f"{', '.join(sorted(missing))}")
+    if counts[stats.Status.REGRESSION] > 0:
+        sys.exit(1)
+
+
+@cli.command()
+@click.option("--results",
+              required=True,
+              type=click.Path(exists=True, dir_okay=False),
+              help="Results to store as the baseline.")
+@click.option("--baseline-dir",
+              required=True,
+              type=click.Path(file_okay=False),
+              help="Directory of the baselines.")
+def promote(results: str, baseline_dir: str):
+    """Stores results as the baseline of their suite and GPU."""
+    current = SuiteResults.load(Path(results))
+    path = baseline_path(Path(baseline_dir), current)
+    current.save(path)
+    logging.info(f"Baseline written to {path}")
+
+
+if __name__ == "__main__":
+    cli()
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/sloScheduler.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Sizes context chunks so that the estimated latency of every iteration stays within a budget.
+//! \details An alternative to the fixed token budget of the chunking policies, for the owner of the scheduling loop to
+//! size the context chunks of each iteration with. The cost of context tokens and generation requests is learned from
+//! the measured iteration latencies by an IterationCostModel. The token budget of an iteration is what the model
+//! predicts to fit into the latency budget next to the generation requests, bounded by maxNumTokens. At least one
+//! chunk unit is scheduled, so that the context phase progresses even if the generation requests alone exceed the
+//! latency budget.
+class AdaptiveChunkSizer
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    //! \param latencyBudgetMs Target latency of an iteration, e.g. 40 ms.
+    //! \param maxNumTokens Maximum number of tokens per iteration.
+    //! \param chunkUnitSize Context chunks are multiples of this size, unless they finish the context.
+    AdaptiveChunkSizer(double latencyBudgetMs, SizeType32 maxNumTokens, SizeType32 chunkUnitSize,
+        IterationCostModel costModel = IterationCostModel{})
+        : mLatencyBudgetMs{latencyBudgetMs}
+        , mMaxNumTokens{maxNumTokens}
+        , mChunkUnitSize{chunkUnitSize}
+        , mCostModel{costModel}
+    {
+        TLLM_CHECK(mLatencyBudgetMs > 0.0);
+        TLLM_CHECK(mChunkUnitSize > 0);
+        TLLM_CHECK(mMaxNumTokens >= mChunkUnitSize);
+    }
+
+    //! \brief Feed the measured latency of the last iteration, IterationStats::iterLatencyMS.
+    void update(SizeType32 numContextTokens, SizeType32 numGenerationRequests, double iterLatencyMs)
+    {
+        mCostModel.update(numContextTokens, numGenerationRequests, iterLatencyMs);
+    }
+
+    //! \brief Context tokens that fit into the next iteration, a multiple of the chunk unit size.
+    [[nodiscard]] SizeType32 getContextTokenBudget(SizeType32 numGenerationRequests) const
+    {
+        auto const maxContextTokens = mMaxNumTokens - numGenerationRequests;
+        if (maxContextTokens < mChunkUnitSize)
+        {
+            return std::max(maxContextTokens, 0);
+        }
+        auto const budget
+            = std::min(mCostModel.maxContextTokens(numGenerationRequests, mLatencyBudgetMs), maxContextTokens);
+        return std::max(budget / mChunkUnitSize * mChunkUnitSize, mChunkUnitSize);
+    }
+
+    //! \brief Chunk sizes of the context requests in scheduling order, first come first served within the budget.
+    //! \param numRemainingContextTokens Context tokens still to be processed per request.
+    //! \return Chunk size per request, 0 for requests that are not scheduled in this iteration.
+    [[nodiscard]] std::vector<SizeType32> computeChunkSizes(
+        std::vector<SizeType32> const& numRemainingContextTokens, SizeType32 numGenerationRequests) const
+    {
+        std::vector<SizeType32> chunkSizes(numRemainingContextTokens.size(), 0);
+        auto tokenBudget = getContextTokenBudget(numGenerationRequests);
+        for (std::size_t i = 0; i < numRemainingContextTokens.size() && tokenBudget > 0; ++i)
+        {
+            auto chunkSize = std::min(numRemainingContextTokens[i], tokenBudget);
+            if (chunkSize < numRemainingContextTokens[i])
+            {
+                chunkSize = chunkSize / mChunkUnitSize * mChunkUnitSize;
+            }
+            chunkSizes[i] = chunkSize;
+            tokenBudget -= chunkSize;
+        }
+        return chunkSizes;
+    }
+
+    [[nodiscard]] IterationCostModel const& getCostModel() const noexcept
+    {
+        return mCostModel;
+    }
+
+    [[nodiscard]] double getLatencyBudgetMs() const noexcept
+    {
+        return mLatencyBudgetMs;
+    }
+
+private:
+    double mLatencyBudgetMs;
+    SizeType32 mMaxNumTokens;
+    SizeType32 mChunkUnitSize;
+    IterationCostModel mCostModel;
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,479 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+using PrefixHashType = std::uint64_t;
+
+//! \brief Rolling hash over a token sequence, extended one token at a time.
+//! \details The hash is chained through the whole prefix, so the value at a block boundary identifies the block
+//! together with all of its predecessors. The hashes of all full blocks are cached, which makes extending the
+//! sequence cost O(new tokens) and makes a lookup of block i a single hash map access. The chain starts from a seed
+//! that scopes the reuse, sequences with different seeds never share blocks.
+class PrefixHashState
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    using VecTokens = std::vector<TokenIdType>;
+
+    static constexpr PrefixHashType kRootHash = 0x9e3779b97f4a7c15ULL;
+
+    explicit PrefixHashState(SizeType32 tokensPerBlock, PrefixHashType seed = kRootHash)
+        : mTokensPerBlock{tokensPerBlock}
+        , mNumTokens{0}
+        , mSeed{seed}
+        , mCurrentHash{seed}
+    {
+        TLLM_CHECK(mTokensPerBlock > 0);
+    }
+
+    //! \brief Seed of the sequences whose KV cache also depends on a LoRA adapter or a prompt embedding table.
+    //! \details The same tokens give different keys and values with another adapter or table, so they only share
+    //! blocks with the sequences of the same adapter and table. kRootHash without either.
+    //! \param promptTableHash Hash of the content of the prompt embedding table.
+    [[nodiscard]] static PrefixHashType makeSeed(
+        std::optional<std::uint64_t> loraTaskId, std::optional<std::uint64_t> promptTableHash) noexcept
+    {
+        auto seed = kRootHash;
+        if (loraTaskId)
+        {
+            seed = combine64(combine(seed, kLoraTag), loraTaskId.value());
+        }
+        if (promptTableHash)
+        {
+            seed = combine64(combine(seed, kPromptTableTag), promptTableHash.value());
+        }
+        return seed;
+    }
+
+    [[nodiscard]] static PrefixHashType combine(PrefixHashType seed, TokenIdType token) noexcept
+    {
+        // splitmix64 finalizer applied to the seed mixed with the token
+        auto x = seed ^ (static_cast<PrefixHashType>(static_cast<std::uint32_t>(token)) + 0x9e3779b97f4a7c15ULL);
+        x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+        return x ^ (x >> 31);
+    }
+
+    void addToken(TokenIdType token)
+    {
+        mCurrentHash = combine(mCurrentHash, token);
+        ++mNumTokens;
+        if (mNumTokens % mTokensPerBlock == 0)
+        {
+            mBlockHashes.push_back(mCurrentHash);
+        }
+    }
+
+    //! \brief Hash only the tokens that were not seen yet.
+    //! \details `tokens` must start with the tokens that were already added.
+    void extend(VecTokens const& tokens)
+    {
+        TLLM_CHECK(static_cast<SizeType32>(tokens.size()) >= mNumTokens);
+        for (auto it = tokens.begin() + mNumTokens; it != tokens.end(); ++it)
+        {
+            addToken(*it);
+        }
+    }
+
+    //! \brief Drop the last n tokens, e.g. after rejected draft tokens.
+    //! \details Only the partial tail block is rehashed, `tokens` has to contain the tokens that were added.
+    void removeTokens(VecTokens const& tokens, SizeType32 n)
+    {
+        TLLM_CHECK(n <= mNumTokens);
+        TLLM_CHECK(static_cast<SizeType32>(tokens.size()) >= mNumTokens);
+        auto const newNumTokens = mNumTokens - n;
+        auto const numFullBlocks = newNumTokens / mTokensPerBlock;
+        mBlockHashes.resize(numFullBlocks);
+        mCurrentHash = numFullBlocks > 0 ? mBlockHashes.back() : mSeed;
+        for (SizeType32 ti = numFullBlocks * mTokensPerBlock; ti < newNumTokens; ++ti)
+        {
+            mCurrentHash = combine(mCurrentHash, tokens[ti]);
+        }
+        mNumTokens = newNumTokens;
+    }
+
+    [[nodiscard]] SizeType32 getTokensPerBlock() const noexcept
+    {
+        return mTokensPerBlock;
+    }
+
+    [[nodiscard]] SizeType32 getNumTokens() const noexcept
+    {
+        return mNumTokens;
+    }
+
+    [[nodiscard]] PrefixHashType getSeed() const noexcept
+    {
+        return mSeed;
+    }
+
+    [[nodiscard]] SizeType32 getNumFullBlocks() const noexcept
+    {
+        return static_cast<SizeType32>(mBlockHashes.size());
+    }
+
+    //! \brief Hash of the prefix ending with full block blockIdx.
+    [[nodiscard]] PrefixHashType getBlockHash(SizeType32 blockIdx) const
+    {
+        return mBlockHashes.at(blockIdx);
+    }
+
+    //! \brief Hash of the whole prefix, including the trailing partial block.
+    [[nodiscard]] PrefixHashType getHash() const noexcept
+    {
+        return mCurrentHash;
+    }
+
+private:
+    // Tags of the parts of a seed, so that a LoRA task id and a table hash of the same value give different seeds
+    static constexpr TokenIdType kLoraTag = 1;
+    static constexpr TokenIdType kPromptTableTag = 2;
+
+    [[nodiscard]] static PrefixHashType combine64(PrefixHashType seed, std::uint64_t value) noexcept
+    {
+        seed = combine(seed, static_cast<TokenIdType>(static_cast<std::uint32_t>(value)));
+        return combine(seed, static_cast<TokenIdType>(static_cast<std::uint32_t>(value >> 32)));
+    }
+
+    SizeType32 mTokensPerBlock;
+    SizeType32 mNumTokens;
+    PrefixHashType mSeed;
+    PrefixHashType mCurrentHash;
+    std::vector<PrefixHashType> mBlockHashes;
+};
+
+//! \brief Counters describing how deep reuse lookups matched.
+struct BlockRadixTreeStats
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    //! Number of match() calls
+    SizeType32 numLookups{0};
+    //! Number of lookups that matched at least one token
+    SizeType32 numHits{0};
+    //! Sum of matched full blocks over all lookups
+    SizeType32 numFullBlockHits{0};
+    //! Number of lookups that ended in a partially matched block
+    SizeType32 numPartialBlockHits{0};
+    //! Deepest match in blocks, including a partial block
+    SizeType32 maxHitDepth{0};
+};
+
+//! \brief Prefix index of cached blocks, keyed by the chained hash of all tokens up to the end of each block.
+//! \details Every node is one block. A node's key is the PrefixHashState hash at its last token, which makes the
+//! tree a flat hash map and walking a prompt of n blocks n hash map accesses without hashing or copying any token
+//! vector. Nodes keep their own tokens to resolve partial-block matches and to guard against hash collisions.
+//! Partially filled blocks can be stored as leaves. The first blocks of the sequences of all seeds hang off the same
+//! root, the seed of a block restricts the partial matches to the sequences of that seed.
+template <typename ValueT>
+class BlockRadixTree
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    using VecTokens = std::vector<TokenIdType>;
+
+    struct MatchResult
+    {
+        //! Values of the matched full blocks, in sequence order
+        std::vector<ValueT> blocks;
+        //! Value of the block matched partially after the full blocks, if any
+        std::optional<ValueT> partialBlock;
+        //! Number of tokens matched in partialBlock
+        SizeType32 numPartialTokens{0};
+        //! Total number of matched tokens
+        SizeType32 numMatchedTokens{0};
+    };
+
+    explicit BlockRadixTree(SizeType32 tokensPerBlock)
+        : mTokensPerBlock{tokensPerBlock}
+    {
+        TLLM_CHECK(mTokensPerBlock > 0);
+        mNodes.emplace(PrefixHashState::kRootHash, Node{});
+    }
+
+    //! \brief Insert the blocks of a sequence.
+    //! \param tokens Tokens of the sequence. The last block may be partial.
+    //! \param values One value per block of `tokens`.
+    //! \param seed Seed of the sequence, see PrefixHashState::makeSeed.
+    //! \return Number of blocks that were not in the tree yet.
+    SizeType32 insert(
+        VecTokens const& tokens, std::vector<ValueT> const& values, PrefixHashType seed = PrefixHashState::kRootHash)
+    {
+        auto const numTokens = static_cast<SizeType32>(tokens.size());
+        auto const numBlocks = (numTokens + mTokensPerBlock - 1) / mTokensPerBlock;
+        TLLM_CHECK_WITH_INFO(static_cast<SizeType32>(values.size()) >= numBlocks,
+            "Expected %d block values, got %zu", numBlocks, values.size());
+        SizeType32 numInserted{0};
+        auto parentHash = PrefixHashState::kRootHash;
+        for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+        {
+            auto const begin = tokens.begin() + bi * mTokensPerBlock;
+            auto const end = tokens.begin() + std::min(numTokens, (bi + 1) * mTokensPerBlock);
+            auto hash = bi == 0 ? seed : parentHash;
+            for (auto it = begin; it != end; ++it)
+            {
+                hash = PrefixHashState::combine(hash, *it);
+            }
+            auto const isFull = end - begin == mTokensPerBlock;
+            auto [it, inserted] = mNodes.try_emplace(hash);
+            auto& node = it->second;
+            if (inserted)
+            {
+                node.value = values[bi];
+                node.parent = parentHash;
+                node.seed = seed;
+                node.tokens.assign(begin, end);
+                node.isFull = isFull;
+                mNodes.at(parentHash).children.push_back(hash);
+                ++numInserted;
+            }
+            else
+            {
+                TLLM_CHECK_WITH_INFO(std::equal(begin, end, node.tokens.begin(), node.tokens.end()),
+                    "Prefix hash collision in block radix tree");
+            }
+            parentHash = hash;
+        }
+        return numInserted;
+    }
+
+    //! \brief Insert one block below a cached full block, e.g. when restoring a snapshot.
+    //! \param parentHash Hash of the parent block, PrefixHashState::kRootHash for the first block of a sequence.
+    //! \param seed Seed of the sequence, only used for the first block, the other blocks have the seed of the parent.
+    //! \return Hash of the block, std::nullopt if the parent is not cached or is partial.
+    std::optional<PrefixHashType> insertChild(PrefixHashType parentHash, VecTokens const& blockTokens,
+        ValueT const& value, PrefixHashType seed = PrefixHashState::kRootHash)
+    {
+        auto const numTokens = static_cast<SizeType32>(blockTokens.size());
+        TLLM_CHECK(numTokens > 0 && numTokens <= mTokensPerBlock);
+        auto const parentIt = mNodes.find(parentHash);
+        if (parentIt == mNodes.end() || !parentIt->second.isFull)
+        {
+            return std::nullopt;
+        }
+        auto const isFirstBlock = parentHash == PrefixHashState::kRootHash;
+        auto const blockSeed = isFirstBlock ? seed : parentIt->second.seed;
+        auto hash = isFirstBlock ? seed : parentHash;
+        for (auto const token : blockTokens)
+        {
+            hash = PrefixHashState::combine(hash, token);
+        }
+        auto [it, inserted] = mNodes.try_emplace(hash);
+        auto& node = it->second;
+        if (inserted)
+        {
+            node.value = value;
+            node.parent = parentHash;
+            node.seed = blockSeed;
+            node.tokens = blockTokens;
+            node.isFull = numTokens == mTokensPerBlock;
+            mNodes.at(parentHash).children.push_back(hash);
+        }
+        else
+        {
+            TLLM_CHECK_WITH_INFO(node.tokens == blockTokens, "Prefix hash collision in block radix tree");
+        }
+        return hash;
+    }
+
+    //! \brief Call fn(hash, parentHash, seed, tokens, value) for every cached block, parents before their children.
+    template <typename Fn>
+    void forEachBlock(Fn&& fn) const
+    {
+        std::vector<PrefixHashType> level{mNodes.at(PrefixHashState::kRootHash).children};
+        while (!level.empty())
+        {
+            std::vector<PrefixHashType> nextLevel;
+            for (auto const hash : level)
+            {
+                auto const& node = mNodes.at(hash);
+                fn(hash, node.parent, node.seed, node.tokens, node.value);
+                nextLevel.insert(nextLevel.end(), node.children.begin(), node.children.end());
+            }
+            level = std::move(nextLevel);
+        }
+    }
+
+    //! \brief Find the longest cached prefix of `tokens`.
+    //! \param tokens Tokens of the sequence.
+    //! \param state Hash state that already covers `tokens`, maintained incrementally by the caller.
+    //! \param maxTokens Do not match more than this many tokens, e.g. to leave the last token for the context phase.
+    //! \param recordStats Count the lookup in the stats, false for probes that don't reuse the blocks.
+    [[nodiscard]] MatchResult match(VecTokens const& tokens, PrefixHashState const& state,
+        std::optional<SizeType32> maxTokens = std::nullopt, bool recordStats = true)
+    {
+        TLLM_CHECK(state.getTokensPerBlock() == mTokensPerBlock);
+        TLLM_CHECK(state.getNumTokens() <= static_cast<SizeType32>(tokens.size()));
+        auto const numTokens = std::min(state.getNumTokens(), maxTokens.value_or(state.getNumTokens()));
+        MatchResult result;
+        auto parentHash = PrefixHashState::kRootHash;
+        auto const numFullBlocks = numTokens / mTokensPerBlock;
+        for (SizeType32 bi = 0; bi < numFullBlocks; ++bi)
+        {
+            auto const hash = state.getBlockHash(bi);
+            auto const it = mNodes.find(hash);
+            if (it == mNodes.end() || !it->second.isFull || it->second.parent != parentHash)
+            {
+                break;
+            }
+            // A hash collision must not hand out the keys and values of other tokens.
+            auto const blockBegin = tokens.begin() + bi * mTokensPerBlock;
+            auto const& blockTokens = it->second.tokens;
+            if (!std::equal(blockBegin, blockBegin + mTokensPerBlock, blockTokens.begin(), blockTokens.end()))
+            {
+                break;
+            }
+            result.blocks.push_back(it->second.value);
+            parentHash = hash;
+        }
+        auto const numMatchedBlocks = static_cast<SizeType32>(result.blocks.size());
+        result.numMatchedTokens = numMatchedBlocks * mTokensPerBlock;
+
+        // Partial match: the child of the last matched node sharing the longest prefix with the next block.
+        auto const begin = tokens.begin() + result.numMatchedTokens;
+        auto const end = tokens.begin() + std::min(numTokens, result.numMatchedTokens + mTokensPerBlock);
+        if (begin != end)
+        {
+            SizeType32 bestLength{0};
+            for (auto const childHash : mNodes.at(parentHash).children)
+            {
+                auto const& child = mNodes.at(childHash);
+                if (child.seed != state.getSeed())
+                {
+                    continue;
+                }
+                auto const length = static_cast<SizeType32>(
+                    std::mismatch(begin, end, child.tokens.begin(), child.tokens.end()).first - begin);
+                if (length > bestLength)
+                {
+                    bestLength = length;
+                    result.partialBlock = child.value;
+                }
+            }
+            result.numPartialTokens = bestLength;
+            result.numMatchedTokens += bestLength;
+        }
+
+        if (!recordStats)
+        {
+            return result;
+        }
+        ++mStats.numLookups;
+        if (result.numMatchedTokens > 0)
+        {
+            ++mStats.numHits;
+        }
+        mStats.numFullBlockHits += numMatchedBlocks;
+        if (result.partialBlock)
+        {
+            ++mStats.numPartialBlockHits;
+        }
+        mStats.maxHitDepth = std::max(mStats.maxHitDepth, numMatchedBlocks + (result.partialBlock ? 1 : 0));
+        return result;
+    }
+
+    //! \brief Remove a leaf block, e.g. when it is evicted for reuse.
+    //! \return False if the block is not in the tree or still has children.
+    bool eraseLeaf(PrefixHashType hash)
+    {
+        auto const it = mNodes.find(hash);
+        if (hash == PrefixHashState::kRootHash || it == mNodes.end() || !it->second.children.empty())
+        {
+            return false;
+        }
+        auto& siblings = mNodes.at(it->second.parent).children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), hash));
+        mNodes.erase(it);
+        return true;
+    }
+
+    //! \brief Remove a block and all blocks cached below it, e.g. when the block was reallocated to other content.
+    //! \return Values of the removed blocks, empty if the block is not in the tree.
+    std::vector<ValueT> eraseSubtree(PrefixHashType hash)
+    {
+        std::vector<ValueT> erased;
+        auto const it = mNodes.find(hash);
+        if (hash == PrefixHashState::kRootHash || it == mNodes.end())
+        {
+            return erased;
+        }
+        auto& siblings = mNodes.at(it->second.parent).children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), hash));
+        std::vector<PrefixHashType> pending{hash};
+        while (!pending.empty())
+        {
+            auto const nodeIt = mNodes.find(pending.back());
+            pending.pop_back();
+            erased.push_back(nodeIt->second.value);
+            pending.insert(pending.end(), nodeIt->second.children.begin(), nodeIt->second.children.end());
+            mNodes.erase(nodeIt);
+        }
+        return erased;
+    }
+
+    [[nodiscard]] bool contains(PrefixHashType hash) const
+    {
+        return hash != PrefixHashState::kRootHash && mNodes.count(hash) > 0;
+    }
+
+    //! \brief Number of cached blocks.
+    [[nodiscard]] SizeType32 size() const noexcept
+    {
+        return static_cast<SizeType32>(mNodes.size()) - 1;
+    }
+
+    [[nodiscard]] SizeType32 getTokensPerBlock() const noexcept
+    {
+        return mTokensPerBlock;
+    }
+
+    [[nodiscard]] BlockRadixTreeStats const& getStats() const noexcept
+    {
+        return mStats;
+    }
+
+private:
+    struct Node
+    {
+        ValueT value{};
+        PrefixHashType parent{PrefixHashState::kRootHash};
+        PrefixHashType seed{PrefixHashState::kRootHash};
+        VecTokens tokens;
+        std::vector<PrefixHashType> children;
+        bool isFull{true};
+    };
+
+    SizeType32 mTokensPerBlock;
+    std::unordered_map<PrefixHashType, Node> mNodes;
+    BlockRadixTreeStats mStats;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
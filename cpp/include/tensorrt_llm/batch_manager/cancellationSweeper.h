@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/batch_manager/peftCacheManager.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Releases the resources of cancelled requests at once, at the next iteration boundary, instead of through
+//! the finish path of the scheduler an iteration or more later.
+//! \details cancel() may be called from any thread, e.g. when a client disconnects. sweep() is called by the
+//! iteration loop before scheduling: all the cancelled requests are removed in one pass, their KV cache sequences are
+//! removed, their PEFT pages released and their sequence slots returned, so that the capacity is available to the
+//! requests scheduled in the same iteration. The decoder state of a returned slot is initialized again when a new
+//! request takes it. The blocks of a cancelled request are only stored for reuse if `storeBlocksForReuse` is set,
+//! the prefix of an abandoned request is rarely requested again.
+//! \tparam TRequest The request type, LlmRequest.
+//! \tparam TKvCacheManager The KV cache manager type, KVCacheManager.
+//! \tparam TPeftCacheManager The PEFT cache manager type, BasePeftCacheManager.
+template <typename TRequest, typename TKvCacheManager, typename TPeftCacheManager>
+class BasicCancellationSweeper
+{
+public:
+    using SizeType32 = runtime::SizeType32;
+    using RequestIdType = std::uint64_t;
+    using RequestPtr = std::shared_ptr<TRequest>;
+    using RequestList = std::list<RequestPtr>;
+
+    struct Config
+    {
+        bool storeBlocksForReuse{false};
+    };
+
+    //! \brief What a sweep released.
+    struct Result
+    {
+        //! The cancelled requests, in the order of the lists, to send their final responses.
+        std::vector<RequestPtr> requests;
+        //! The sequence slots of the active requests among them, to free in the slot manager.
+        std::vector<SizeType32> seqSlots;
+    };
+
+    struct Stats
+    {
+        std::uint64_t numSweeps{0};
+        std::uint64_t numCancelled{0};
+        //! Cancelled ids that were neither active nor waiting, e.g. of requests finished before the sweep.
+        std::uint64_t numUnknown{0};
+    };
+
+    explicit BasicCancellationSweeper(Config const& config = Config{})
+        : mConfig{config}
+    {
+    }
+
+    //! \brief Mark a request for cancellation at the next sweep. Thread safe.
+    void cancel(RequestIdType requestId)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPending.insert(requestId);
+    }
+
+    [[nodiscard]] bool hasPending() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return !mPending.empty();
+    }
+
+    //! \brief Remove the cancelled requests from the lists and release their resources.
+    //! \param activeRequests requests with a sequence slot, whose KV cache and PEFT pages are released
+    //! \param waitingRequests requests not scheduled yet, which hold no resources
+    //! \param kvCacheManager nullptr if the model has no KV cache
+    //! \param peftCacheManager nullptr without PEFT
+    Result sweep(RequestList& activeRequests, RequestList& waitingRequests, TKvCacheManager* kvCacheManager,
+        TPeftCacheManager* peftCacheManager)
+    {
+        std::unordered_set<RequestIdType> pending;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            pending.swap(mPending);
+        }
+        Result result;
+        if (pending.empty())
+        {
+            return result;
+        }
+
+        for (auto it = activeRequests.begin(); it != activeRequests.end();)
+        {
+            auto const& request = *it;
+            if (pending.erase(request->mRequestId) == 0)
+            {
+                ++it;
+                continue;
+            }
+            if (request->mSeqSlot)
+            {
+                auto const seqSlot = *request->mSeqSlot;
+                if (kvCacheManager != nullptr)
+                {
+                    kvCacheManager->removeSequence(seqSlot, mConfig.storeBlocksForReuse ? request : nullptr);
+                }
+                result.seqSlots.push_back(seqSlot);
+                request->mSeqSlot.reset();
+            }
+            if (peftCacheManager != nullptr)
+            {
+                peftCacheManager->markRequestDone(request);
+            }
+            request->mState = REQUEST_STATE_GENERATION_COMPLETE;
+            result.requests.push_back(request);
+            it = activeRequests.erase(it);
+        }
+        for (auto it = waitingRequests.begin(); it != waitingRequests.end();)
+        {
+            if (pending.erase((*it)->mRequestId) == 0)
+            {
+                ++it;
+                continue;
+            }
+            (*it)->mState = REQUEST_STATE_GENERATION_COMPLETE;
+            result.requests.push_back(*it);
+            it = waitingRequests.erase(it);
+        }
+
+        ++mStats.numSweeps;
+        mStats.numCancelled += result.requests.size();
+        mStats.numUnknown += pending.size();
+        TLLM_LOG_DEBUG("Swept %zu cancelled requests, freed %zu sequence slots", result.requests.size(),
+            result.seqSlots.size());
+        return result;
+    }
+
+    [[nodiscard]] Stats const& getStats() const noexcept
+    {
+        return mStats;
+    }
+
+private:
+    Config mConfig;
+    mutable std::mutex mMutex;
+    std::unordered_set<RequestIdType> mPending;
+    Stats mStats;
+};
+
+using CancellationSweeper
+    = BasicCancellationSweeper<LlmRequest, kv_cache_manager::KVCacheManager, BasePeftCacheManager>;
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Packs the encoder inputs of encoder-decoder requests into padding-free encoder steps, scheduled separately
+//! from the decoder iterations.
+//! \details Called once per decoder iteration with the requests in the encoder phase. A step packs the inputs in
+//! arrival order up to maxNumTokens tokens, skipping inputs that no longer fit so that shorter ones fill the step,
+//! which the encoder engine consumes with removed padding. Small steps are deferred until minNumTokens tokens are
+//! pending or the oldest input waited maxWaitIterations decoder iterations, so that the decoder iterations are not
+//! slowed down by encoder steps that use little of the GPU.
+//! With chunkSize > 0, inputs are encoded in chunks of chunkSize tokens across steps. This is only correct for
+//! encoders whose attention does not cross chunks, e.g. streaming speech encoders, since the chunks are encoded
+//! independently. The caller writes the output of each chunk at its offset in the encoder output of the request.
+//! \tparam TRequest The request type, LlmRequest.
+template <typename TRequest>
+class BasicEncoderBatchScheduler
+{
+public:
+    using SizeType32 = runtime::SizeType32;
+    using RequestPtr = std::shared_ptr<TRequest>;
+    using RequestIdType = std::uint64_t;
+    using VecTokens = std::vector<runtime::TokenIdType>;
+
+    struct Config
+    {
+        //! Maximum number of tokens of an encoder step
+        SizeType32 maxNumTokens{8192};
+        SizeType32 maxBatchSize{64};
+        //! Encode inputs in chunks of this many tokens, 0 encodes them whole
+        SizeType32 chunkSize{0};
+        //! Defer steps with fewer tokens, unless an input waited maxWaitIterations iterations
+        SizeType32 minNumTokens{0};
+        SizeType32 maxWaitIterations{0};
+    };
+
+    //! \brief Part of the encoder input of a request encoded in a step.
+    struct Slice
+    {
+        RequestPtr request;
+        //! Offset of the slice in the encoder input
+        SizeType32 begin;
+        SizeType32 length;
+    };
+
+    struct EncoderBatch
+    {
+        std::vector<Slice> slices;
+        //! The tokens of all slices, packed without padding
+        VecTokens inputIds;
+        std::vector<SizeType32> inputLengths;
+    };
+
+    struct Stats
+    {
+        SizeType32 numSteps{0};
+        std::int64_t numTokens{0};
+        //! Tokens the steps would have had if padded to their longest slice
+        std::int64_t numPaddedTokens{0};
+    };
+
+    explicit BasicEncoderBatchScheduler(Config const& config)
+        : mConfig{config}
+    {
+        TLLM_CHECK(mConfig.maxNumTokens > 0);
+        TLLM_CHECK(mConfig.maxBatchSize > 0);
+        TLLM_CHECK_WITH_INFO(mConfig.chunkSize >= 0 && mConfig.chunkSize <= mConfig.maxNumTokens,
+            "The encoder chunk size (%d) must not exceed the encoder step size (%d)", mConfig.chunkSize,
+            mConfig.maxNumTokens);
+    }
+
+    //! \brief Select the encoder step of this iteration.
+    //! \param requests Active requests in arrival order. Only those in the encoder phase are considered.
+    //! \return The step to run, nullopt if there is no encoder input or the step is deferred.
+    [[nodiscard]] std::optional<EncoderBatch> schedule(std::vector<RequestPtr> const& requests)
+    {
+        SizeType32 numPendingTokens{0};
+        for (auto const& request : requests)
+        {
+            if (isPending(*request))
+            {
+                numPendingTokens += getRemaining(*request);
+            }
+        }
+        if (numPendingTokens == 0)
+        {
+            mNumWaitIterations = 0;
+            return std::nullopt;
+        }
+        if (numPendingTokens < mConfig.minNumTokens && mNumWaitIterations < mConfig.maxWaitIterations)
+        {
+            ++mNumWaitIterations;
+            return std::nullopt;
+        }
+        mNumWaitIterations = 0;
+
+        EncoderBatch batch;
+        SizeType32 tokenBudget = mConfig.maxNumTokens;
+        SizeType32 maxLength{0};
+        for (auto const& request : requests)
+        {
+            if (static_cast<SizeType32>(batch.slices.size()) == mConfig.maxBatchSize || tokenBudget == 0)
+            {
+                break;
+            }
+            if (!isPending(*request))
+            {
+                continue;
+            }
+            auto const remaining = getRemaining(*request);
+            auto const length = mConfig.chunkSize > 0 ? std::min(remaining, mConfig.chunkSize) : remaining;
+            TLLM_CHECK_WITH_INFO(length <= mConfig.maxNumTokens,
+                "Encoder input of %d tokens exceeds the encoder step size (%d), set a chunk size", length,
+                mConfig.maxNumTokens);
+            if (length > tokenBudget)
+            {
+                continue;
+            }
+            auto const begin = getProgress(request->mRequestId);
+            auto const& tokens = *request->getEncoderTokens().value();
+            batch.inputIds.insert(batch.inputIds.end(), tokens.begin() + begin, tokens.begin() + begin + length);
+            batch.inputLengths.push_back(length);
+            batch.slices.push_back(Slice{request, begin, length});
+            tokenBudget -= length;
+            maxLength = std::max(maxLength, length);
+        }
+
+        ++mStats.numSteps;
+        mStats.numTokens += static_cast<std::int64_t>(batch.inputIds.size());
+        mStats.numPaddedTokens += static_cast<std::int64_t>(maxLength) * static_cast<SizeType32>(batch.slices.size());
+        return batch;
+    }
+
+    //! \brief Record that a step was encoded.
+    //! \return The requests of the step whose whole encoder input is encoded, ready for the context phase.
+    std::vector<RequestPtr> finish(EncoderBatch const& batch)
+    {
+        std::vector<RequestPtr> encoded;
+        for (auto const& slice : batch.slices)
+        {
+            auto const requestId = slice.request->mRequestId;
+            auto const progress = slice.begin + slice.length;
+            if (progress == slice.request->getEncoderLen())
+            {
+                mProgress.erase(requestId);
+                encoded.push_back(slice.request);
+            }
+            else
+            {
+                mProgress[requestId] = progress;
+            }
+        }
+        return encoded;
+    }
+
+    //! \brief Forget the progress of a request that left the encoder phase early, e.g. because it was cancelled.
+    void remove(RequestIdType requestId)
+    {
+        mProgress.erase(requestId);
+    }
+
+    [[nodiscard]] Stats const& getStats() const noexcept
+    {
+        return mStats;
+    }
+
+private:
+    static bool isPending(TRequest const& request)
+    {
+        return request.isEncoderInitState() && request.getEncoderTokens().has_value();
+    }
+
+    [[nodiscard]] SizeType32 getProgress(RequestIdType requestId) const
+    {
+        auto const it = mProgress.find(requestId);
+        return it != mProgress.end() ? it->second : 0;
+    }
+
+    [[nodiscard]] SizeType32 getRemaining(TRequest const& request) const
+    {
+        return request.getEncoderLen() - getProgress(request.mRequestId);
+    }
+
+    Config const mConfig;
+    // Encoded tokens of the requests encoded in chunks
+    std::map<RequestIdType, SizeType32> mProgress;
+    SizeType32 mNumWaitIterations{0};
+    Stats mStats;
+};
+
+using EncoderBatchScheduler = BasicEncoderBatchScheduler<LlmRequest>;
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Encoder outputs of encoder-decoder requests, keyed by their encoder input tokens and LoRA task, so that a
+//! request whose encoder input was already encoded skips the encoder phase.
+//! \details The cached tensors are shared with the requests that use them and are never written after store(). The
+//! least recently used entries are dropped when the cache exceeds maxBytes, which is device memory outside of the KV
+//! cache. The cross-attention KV of a request is still computed from the encoder output in its decoder context phase.
+//! \tparam TRequest The request type, LlmRequest.
+template <typename TRequest>
+class BasicEncoderOutputCache
+{
+public:
+    using SizeType32 = runtime::SizeType32;
+    using TensorPtr = runtime::ITensor::SharedPtr;
+    using VecTokens = std::vector<runtime::TokenIdType>;
+
+    struct Stats
+    {
+        SizeType32 numHits{0};
+        SizeType32 numMisses{0};
+        SizeType32 numEntries{0};
+        std::size_t numBytes{0};
+    };
+
+    explicit BasicEncoderOutputCache(std::size_t maxBytes)
+        : mMaxBytes{maxBytes}
+    {
+    }
+
+    //! \brief Give a request in the encoder phase the cached output of its encoder input, and move it to the context
+    //! phase.
+    //! \return Whether the output was found, false if the request still needs the encoder.
+    bool lookup(TRequest& request)
+    {
+        if (!request.isEncoderInitState() || !request.getEncoderTokens())
+        {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mEntries.find(makeKey(request));
+        if (it == mEntries.end())
+        {
+            ++mStats.numMisses;
+            return false;
+        }
+        auto& entry = it->second;
+        mLru.splice(mLru.end(), mLru, entry.lruIt);
+        request.setEncoderOutput(entry.encoderOutput);
+        request.setEncoderHiddenStates(entry.encoderHiddenStates);
+        request.mState = REQUEST_STATE_CONTEXT_INIT;
+        ++mStats.numHits;
+        return true;
+    }
+
+    //! \brief Cache the encoder output of a request after its encoder phase. Does nothing if the output is already
+    //! cached or larger than the cache.
+    void store(TRequest const& request)
+    {
+        if (!request.getEncoderTokens() || !request.getEncoderOutput())
+        {
+            return;
+        }
+        auto const& encoderOutput = request.getEncoderOutput();
+        auto const& encoderHiddenStates = request.getEncoderHiddenStates();
+        auto const numBytes
+            = encoderOutput->getSizeInBytes() + (encoderHiddenStates ? encoderHiddenStates->getSizeInBytes() : 0);
+        if (numBytes > mMaxBytes)
+        {
+            TLLM_LOG_DEBUG("Encoder output of %zu bytes exceeds the cache of %zu bytes", numBytes, mMaxBytes);
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto key = makeKey(request);
+        if (mEntries.count(key) != 0)
+        {
+            return;
+        }
+        while (mStats.numBytes + numBytes > mMaxBytes)
+        {
+            auto lruIt = mEntries.find(*mLru.front());
+            mStats.numBytes -= lruIt->second.numBytes;
+            mLru.pop_front();
+            mEntries.erase(lruIt);
+        }
+        auto it = mEntries.emplace(std::move(key), Entry{encoderOutput, encoderHiddenStates, numBytes}).first;
+        it->second.lruIt = mLru.insert(mLru.end(), &it->first);
+        mStats.numBytes += numBytes;
+    }
+
+    [[nodiscard]] Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto stats = mStats;
+        stats.numEntries = static_cast<SizeType32>(mEntries.size());
+        return stats;
+    }
+
+private:
+    using Key = std::pair<std::optional<std::uint64_t>, VecTokens>;
+
+    struct Entry
+    {
+        TensorPtr encoderOutput;
+        TensorPtr encoderHiddenStates;
+        std::size_t numBytes;
+        typename std::list<Key const*>::iterator lruIt;
+    };
+
+    static Key makeKey(TRequest const& request)
+    {
+        auto const loraTaskId = request.getLoraTaskId();
+        return Key{loraTaskId ? std::optional<std::uint64_t>{*loraTaskId} : std::nullopt,
+            *request.getEncoderTokens().value()};
+    }
+
+    std::size_t const mMaxBytes;
+    mutable std::mutex mMutex;
+    std::map<Key, Entry> mEntries;
+    // Keys of mEntries, least recently used first
+    std::list<Key const*> mLru;
+    Stats mStats;
+};
+
+using EncoderOutputCache = BasicEncoderOutputCache<LlmRequest>;
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/freeBlockQueue.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <queue>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Retention hint of the KV cache blocks of a request, e.g. high priority for shared system prompts.
+struct KvCacheRetention
+{
+    using PriorityType = tensorrt_llm::executor::PriorityType;
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    static constexpr PriorityType kMinPriority = 0.0f;
+    static constexpr PriorityType kMaxPriority = 1.0f;
+    static constexpr PriorityType kDefaultPriority = 0.35f;
+    //! Priorities are quantized to this many levels above kMinPriority for eviction.
+    static constexpr SizeType32 kNumPriorityLevels = 100;
+
+    //! Blocks with lower priority are evicted first.
+    PriorityType priority{kDefaultPriority};
+    //! Time after the release of a block after which it falls back to kMinPriority.
+    std::optional<std::chrono::milliseconds> ttl{std::nullopt};
+
+    bool operator==(KvCacheRetention const& other) const
+    {
+        return priority == other.priority && ttl == other.ttl;
+    }
+
+    //! \brief Quantized priority, in [0, kNumPriorityLevels].
+    [[nodiscard]] static SizeType32 toLevel(PriorityType priority)
+    {
+        auto const clamped = std::clamp(priority, kMinPriority, kMaxPriority);
+        return static_cast<SizeType32>(std::lround((clamped - kMinPriority) / (kMaxPriority - kMinPriority)
+            * static_cast<PriorityType>(kNumPriorityLevels)));
+    }
+};
+
+//! \brief What the eviction policy knows about a free block.
+struct BlockEvictionInfo
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    KvCacheRetention retention{};
+    //! Number of blocks preceding the block in its sequence.
+    SizeType32 prefixDepth{0};
+};
+
+//! \brief Decides which free block is reused for new data, i.e. which cached block is evicted.
+//! \details All free blocks are candidates, blocks holding reusable data are released with their eviction info.
+class BaseEvictionPolicy
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = SizeType32;
+    using PriorityType = KvCacheRetention::PriorityType;
+    using Clock = std::chrono::steady_clock;
+
+    virtual ~BaseEvictionPolicy() = default;
+
+    //! \brief Make a block a candidate for eviction.
+    virtual void release(IdType blockId, BlockEvictionInfo const& info, Clock::time_point now) = 0;
+
+    //! \brief Remove a free block from the candidates, e.g. because it is reused.
+    //! \return False if the block is not free.
+    virtual bool claim(IdType blockId) = 0;
+
+    //! \brief Remove and return the block to evict next.
+    [[nodiscard]] virtual std::optional<IdType> evict(Clock::time_point now) = 0;
+
+    [[nodiscard]] virtual SizeType32 getNumFree() const = 0;
+};
+
+//! \brief Evicts the least recently released block, the behavior without an eviction policy.
+class LruEvictionPolicy : public BaseEvictionPolicy
+{
+public:
+    explicit LruEvictionPolicy(SizeType32 numBlocks)
+        : mQueue{numBlocks, false}
+    {
+    }
+
+    void release(IdType blockId, BlockEvictionInfo const& /* info */, Clock::time_point /* now */) override
+    {
+        mQueue.release(blockId);
+    }
+
+    bool claim(IdType blockId) override
+    {
+        return mQueue.claim(blockId);
+    }
+
+    [[nodiscard]] std::optional<IdType> evict(Clock::time_point /* now */) override
+    {
+        return mQueue.claimFront();
+    }
+
+    [[nodiscard]] SizeType32 getNumFree() const override
+    {
+        return mQueue.getNumFree();
+    }
+
+private:
+    FreeBlockQueue mQueue;
+};
+
+namespace detail
+{
+//! \brief Tracks when free blocks expire. Entries of blocks that were claimed or released again are skipped.
+class ExpiryQueue
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = SizeType32;
+    using Clock = std::chrono::steady_clock;
+
+    explicit ExpiryQueue(SizeType32 numBlocks)
+        : mGenerations(numBlocks, 0)
+    {
+    }
+
+    //! \brief Invalidate earlier entries of the block, and add a new one if it expires.
+    void update(IdType blockId, std::optional<Clock::time_point> expiry)
+    {
+        auto const generation = ++mGenerations.at(blockId);
+        if (expiry.has_value())
+        {
+            mEntries.push(Entry{expiry.value(), blockId, generation});
+        }
+    }
+
+    //! \brief Call `onExpired` for every valid entry that expired before `now`.
+    template <typename Fn>
+    void expire(Clock::time_point now, Fn&& onExpired)
+    {
+        while (!mEntries.empty() && mEntries.top().expiry <= now)
+        {
+            auto const entry = mEntries.top();
+            mEntries.pop();
+            if (entry.generation == mGenerations[entry.blockId])
+            {
+                onExpired(entry.blockId);
+            }
+        }
+    }
+
+private:
+    struct Entry
+    {
+        Clock::time_point expiry;
+        IdType blockId;
+        std::uint64_t generation;
+
+        bool operator>(Entry const& other) const
+        {
+            return expiry > other.expiry;
+        }
+    };
+
+    std::vector<std::uint64_t> mGenerations;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> mEntries;
+};
+
+inline std::optional<BaseEvictionPolicy::Clock::time_point> computeExpiry(
+    KvCacheRetention const& retention, BaseEvictionPolicy::Clock::time_point now)
+{
+    if (!retention.ttl.has_value())
+    {
+        return std::nullopt;
+    }
+    return now + retention.ttl.value();
+}
+} // namespace detail
+
+//! \brief Evicts the least recently released block of the lowest priority. Blocks whose TTL expired drop to the lowest
+//! priority.
+class PriorityEvictionPolicy : public BaseEvictionPolicy
+{
+public:
+    explicit PriorityEvictionPolicy(SizeType32 numBlocks)
+        : mNodes(numBlocks)
+        , mExpiry{numBlocks}
+        , mNumFree{0}
+    {
+        mHeads.fill(kInvalidId);
+        mTails.fill(kInvalidId);
+    }
+
+    void release(IdType blockId, BlockEvictionInfo const& info, Clock::time_point now) override
+    {
+        TLLM_CHECK_WITH_INFO(!mNodes.at(blockId).isFree, "Block %d released twice", blockId);
+        pushBack(blockId, KvCacheRetention::toLevel(info.retention.priority));
+        mExpiry.update(blockId, detail::computeExpiry(info.retention, now));
+    }
+
+    bool claim(IdType blockId) override
+    {
+        if (!mNodes.at(blockId).isFree)
+        {
+            return false;
+        }
+        remove(blockId);
+        mExpiry.update(blockId, std::nullopt);
+        return true;
+    }
+
+    [[nodiscard]] std::optional<IdType> evict(Clock::time_point now) override
+    {
+        mExpiry.expire(now,
+            [this](IdType blockId)
+            {
+                remove(blockId);
+                pushBack(blockId, 0);
+            });
+        for (auto const head : mHeads)
+        {
+            if (head != kInvalidId)
+            {
+                claim(head);
+                return head;
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] SizeType32 getNumFree() const override
+    {
+        return mNumFree;
+    }
+
+private:
+    static constexpr IdType kInvalidId = -1;
+    static constexpr auto kNumLevels = KvCacheRetention::kNumPriorityLevels + 1;
+
+    struct Node
+    {
+        IdType prev{kInvalidId};
+        IdType next{kInvalidId};
+        SizeType32 level{0};
+        bool isFree{false};
+    };
+
+    void pushBack(IdType blockId, SizeType32 level)
+    {
+        auto& node = mNodes[blockId];
+        node.level = level;
+        node.prev = mTails[level];
+        node.next = kInvalidId;
+        (mTails[level] == kInvalidId ? mHeads[level] : mNodes[mTails[level]].next) = blockId;
+        mTails[level] = blockId;
+        node.isFree = true;
+        ++mNumFree;
+    }
+
+    void remove(IdType blockId)
+    {
+        auto& node = mNodes[blockId];
+        auto const level = node.level;
+        (node.prev == kInvalidId ? mHeads[level] : mNodes[node.prev].next) = node.next;
+        (node.next == kInvalidId ? mTails[level] : mNodes[node.next].prev) = node.prev;
+        node.prev = kInvalidId;
+        node.next = kInvalidId;
+        node.isFree = false;
+        --mNumFree;
+    }
+
+    std::vector<Node> mNodes;
+    std::array<IdType, kNumLevels> mHeads;
+    std::array<IdType, kNumLevels> mTails;
+    detail::ExpiryQueue mExpiry;
+    SizeType32 mNumFree;
+};
+
+//! \brief Evicts the block that is cheapest to recompute, weighted by priority.
+//! \details Recomputing a block needs attention over all of its prefix, its cost is estimated as prefixDepth + 1.
+//! All blocks have the same size and number of layers, so the cost per byte orders like the cost. A block of priority
+//! level l counts (l + 1) times, see KvCacheRetention::toLevel, expired blocks count as kMinPriority. Ties are evicted
+//! in release order.
+class CostAwareEvictionPolicy : public BaseEvictionPolicy
+{
+public:
+    explicit CostAwareEvictionPolicy(SizeType32 numBlocks)
+        : mBlocks(numBlocks)
+        , mExpiry{numBlocks}
+        , mSequenceNumber{0}
+    {
+    }
+
+    void release(IdType blockId, BlockEvictionInfo const& info, Clock::time_point now) override
+    {
+        auto& block = mBlocks.at(blockId);
+        TLLM_CHECK_WITH_INFO(!block.key.has_value(), "Block %d released twice", blockId);
+        block.prefixDepth = info.prefixDepth;
+        insert(blockId, info.retention.priority);
+        mExpiry.update(blockId, detail::computeExpiry(info.retention, now));
+    }
+
+    bool claim(IdType blockId) override
+    {
+        auto& block = mBlocks.at(blockId);
+        if (!block.key.has_value())
+        {
+            return false;
+        }
+        mCandidates.erase(block.key.value());
+        block.key.reset();
+        mExpiry.update(blockId, std::nullopt);
+        return true;
+    }
+
+    [[nodiscard]] std::optional<IdType> evict(Clock::time_point now) override
+    {
+        mExpiry.expire(now,
+            [this](IdType blockId)
+            {
+                auto& block = mBlocks[blockId];
+                mCandidates.erase(block.key.value());
+                block.key.reset();
+                insert(blockId, KvCacheRetention::kMinPriority);
+            });
+        if (mCandidates.empty())
+        {
+            return std::nullopt;
+        }
+        auto const blockId = std::get<2>(*mCandidates.begin());
+        claim(blockId);
+        return blockId;
+    }
+
+    [[nodiscard]] SizeType32 getNumFree() const override
+    {
+        return static_cast<SizeType32>(mCandidates.size());
+    }
+
+    //! \brief Cost of keeping a block, blocks with the lowest cost are evicted first.
+    [[nodiscard]] static double computeCost(SizeType32 prefixDepth, PriorityType priority)
+    {
+        auto const recomputeCost = static_cast<double>(prefixDepth + 1);
+        return recomputeCost * (KvCacheRetention::toLevel(priority) + 1);
+    }
+
+private:
+    // Cost, release order, block id
+    using Key = std::tuple<double, std::uint64_t, IdType>;
+
+    struct Block
+    {
+        SizeType32 prefixDepth{0};
+        std::optional<Key> key{std::nullopt};
+    };
+
+    void insert(IdType blockId, PriorityType priority)
+    {
+        auto& block = mBlocks[blockId];
+        block.key = Key{computeCost(block.prefixDepth, priority), mSequenceNumber++, blockId};
+        mCandidates.insert(block.key.value());
+    }
+
+    std::vector<Block> mBlocks;
+    std::set<Key> mCandidates;
+    detail::ExpiryQueue mExpiry;
+    std::uint64_t mSequenceNumber;
+};
+
+//! \brief Keeps pinned blocks out of the candidates of another policy, e.g. the reusable blocks of queued requests.
+//! \details A pinned free block is claimed from the other policy and released to it again with its eviction info
+//! when the last pin is removed. A pinned block in use is held back when it is released. Pins are counted, a block
+//! stays pinned until every pin of it is removed. Pinned free blocks are not counted as free, they can't be evicted.
+class PinningEvictionPolicy : public BaseEvictionPolicy
+{
+public:
+    explicit PinningEvictionPolicy(std::unique_ptr<BaseEvictionPolicy> policy)
+        : mPolicy{std::move(policy)}
+    {
+        TLLM_CHECK(mPolicy != nullptr);
+    }
+
+    //! \brief Pin a block, free or in use.
+    //! \param info Eviction info of the block if it is free, it is released with it when unpinned.
+    void pin(IdType blockId, BlockEvictionInfo const& info)
+    {
+        auto& pinned = mPinned[blockId];
+        if (pinned.count++ == 0 && mPolicy->claim(blockId))
+        {
+            pinned.freeInfo = info;
+        }
+    }
+
+    //! \brief Remove a pin of a block, the block is a candidate for eviction again after its last pin if it is free.
+    void unpin(IdType blockId, Clock::time_point now)
+    {
+        auto const it = mPinned.find(blockId);
+        TLLM_CHECK_WITH_INFO(it != mPinned.end(), "Block %d is not pinned", blockId);
+        if (--it->second.count > 0)
+        {
+            return;
+        }
+        if (it->second.freeInfo)
+        {
+            mPolicy->release(blockId, it->second.freeInfo.value(), now);
+        }
+        mPinned.erase(it);
+    }
+
+    [[nodiscard]] bool isPinned(IdType blockId) const
+    {
+        return mPinned.count(blockId) > 0;
+    }
+
+    [[nodiscard]] SizeType32 getNumPinned() const noexcept
+    {
+        return static_cast<SizeType32>(mPinned.size());
+    }
+
+    void release(IdType blockId, BlockEvictionInfo const& info, Clock::time_point now) override
+    {
+        auto const it = mPinned.find(blockId);
+        if (it != mPinned.end())
+        {
+            it->second.freeInfo = info;
+            return;
+        }
+        mPolicy->release(blockId, info, now);
+    }
+
+    bool claim(IdType blockId) override
+    {
+        auto const it = mPinned.find(blockId);
+        if (it != mPinned.end())
+        {
+            // Reused, e.g. by the request it was pinned for. It stays pinned until it is unpinned.
+            auto const wasFree = it->second.freeInfo.has_value();
+            it->second.freeInfo.reset();
+            return wasFree;
+        }
+        return mPolicy->claim(blockId);
+    }
+
+    [[nodiscard]] std::optional<IdType> evict(Clock::time_point now) override
+    {
+        return mPolicy->evict(now);
+    }
+
+    [[nodiscard]] SizeType32 getNumFree() const override
+    {
+        return mPolicy->getNumFree();
+    }
+
+private:
+    struct Pinned
+    {
+        SizeType32 count{0};
+        //! Set while the block is free
+        std::optional<BlockEvictionInfo> freeInfo;
+    };
+
+    std::unique_ptr<BaseEvictionPolicy> mPolicy;
+    std::unordered_map<IdType, Pinned> mPinned;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
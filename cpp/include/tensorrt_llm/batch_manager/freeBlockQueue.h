@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Free list of a fixed set of blocks, addressed by block id.
+//! \details Links are stored in an array indexed by block id, so claiming and releasing never allocate. Blocks can be
+//! released from any thread without locking: they are pushed onto one of two lock-free stacks, which the owning
+//! (scheduler) thread drains into the queue on its next claim. Released blocks are queued at the back, in release
+//! order, unless released to the front, which makes them the next ones to be claimed.
+//! Except release(), all methods must be called from the owning thread.
+class FreeBlockQueue
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = SizeType32;
+
+    static constexpr IdType kInvalidId = -1;
+
+    //! \param numBlocks Number of blocks, ids are in [0, numBlocks).
+    //! \param allFree Whether all blocks start in the queue, in id order.
+    explicit FreeBlockQueue(SizeType32 numBlocks, bool allFree = true)
+        : mNodes(numBlocks)
+        , mHead{kInvalidId}
+        , mTail{kInvalidId}
+        , mNumQueued{0}
+        , mPendingFront{kInvalidId}
+        , mPendingBack{kInvalidId}
+        , mNumFree{0}
+    {
+        TLLM_CHECK(numBlocks >= 0);
+        if (allFree)
+        {
+            for (IdType id = 0; id < numBlocks; ++id)
+            {
+                mNodes[id].state.store(kQueued, std::memory_order_relaxed);
+                pushBack(id);
+            }
+            mNumFree.store(numBlocks, std::memory_order_relaxed);
+        }
+    }
+
+    FreeBlockQueue(FreeBlockQueue const&) = delete;
+    FreeBlockQueue& operator=(FreeBlockQueue const&) = delete;
+
+    //! \brief Return a claimed block to the queue. Lock-free, can be called from any thread.
+    void release(IdType id, bool toFront = false) noexcept
+    {
+        auto& node = mNodes[id];
+        [[maybe_unused]] auto const previous = node.state.exchange(kPending, std::memory_order_relaxed);
+        TLLM_CHECK_DEBUG_WITH_INFO(previous == kClaimed, "Block %d released twice", id);
+        auto& pending = toFront ? mPendingFront : mPendingBack;
+        auto top = pending.load(std::memory_order_relaxed);
+        do
+        {
+            node.pendingNext = top;
+        } while (!pending.compare_exchange_weak(top, id, std::memory_order_release, std::memory_order_relaxed));
+        mNumFree.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    //! \brief Claim the block at the front of the queue.
+    //! \return The block id, or std::nullopt if no block is free.
+    [[nodiscard]] std::optional<IdType> claimFront()
+    {
+        drainPending();
+        if (mHead == kInvalidId)
+        {
+            return std::nullopt;
+        }
+        auto const id = mHead;
+        claimQueued(id);
+        return id;
+    }
+
+    //! \brief Claim a specific block, e.g. a free block matched for reuse.
+    //! \return False if the block is not free.
+    bool claim(IdType id)
+    {
+        drainPending();
+        if (mNodes[id].state.load(std::memory_order_relaxed) != kQueued)
+        {
+            return false;
+        }
+        claimQueued(id);
+        return true;
+    }
+
+    //! \brief Find the first free block, in claim order, that satisfies `pred`.
+    template <typename Pred>
+    [[nodiscard]] std::optional<IdType> findFirst(Pred&& pred)
+    {
+        drainPending();
+        for (auto id = mHead; id != kInvalidId; id = mNodes[id].next)
+        {
+            if (pred(id))
+            {
+                return id;
+            }
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] bool isFree(IdType id) const noexcept
+    {
+        return mNodes[id].state.load(std::memory_order_relaxed) != kClaimed;
+    }
+
+    //! \brief Number of free blocks, including blocks whose release has not been drained yet.
+    [[nodiscard]] SizeType32 getNumFree() const noexcept
+    {
+        return mNumFree.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] SizeType32 getNumBlocks() const noexcept
+    {
+        return static_cast<SizeType32>(mNodes.size());
+    }
+
+private:
+    enum State : std::uint8_t
+    {
+        kClaimed = 0,
+        kPending = 1,
+        kQueued = 2,
+    };
+
+    struct Node
+    {
+        IdType prev{kInvalidId};
+        IdType next{kInvalidId};
+        // Link in one of the pending stacks, written by the releasing thread before publishing the node
+        IdType pendingNext{kInvalidId};
+        std::atomic<std::uint8_t> state{kClaimed};
+    };
+
+    void pushBack(IdType id) noexcept
+    {
+        auto& node = mNodes[id];
+        node.prev = mTail;
+        node.next = kInvalidId;
+        (mTail == kInvalidId ? mHead : mNodes[mTail].next) = id;
+        mTail = id;
+        ++mNumQueued;
+    }
+
+    void pushFront(IdType id) noexcept
+    {
+        auto& node = mNodes[id];
+        node.prev = kInvalidId;
+        node.next = mHead;
+        (mHead == kInvalidId ? mTail : mNodes[mHead].prev) = id;
+        mHead = id;
+        ++mNumQueued;
+    }
+
+    void claimQueued(IdType id) noexcept
+    {
+        auto& node = mNodes[id];
+        (node.prev == kInvalidId ? mHead : mNodes[node.prev].next) = node.next;
+        (node.next == kInvalidId ? mTail : mNodes[node.next].prev) = node.prev;
+        node.prev = kInvalidId;
+        node.next = kInvalidId;
+        node.state.store(kClaimed, std::memory_order_relaxed);
+        --mNumQueued;
+        mNumFree.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    //! \brief Move released blocks into the queue, in release order.
+    void drainPending()
+    {
+        auto const takeReversed = [this](std::atomic<IdType>& pending)
+        {
+            // The stack holds the most recent release on top, reverse it to restore release order.
+            IdType reversed = kInvalidId;
+            for (auto id = pending.exchange(kInvalidId, std::memory_order_acquire); id != kInvalidId;)
+            {
+                auto const next = mNodes[id].pendingNext;
+                mNodes[id].pendingNext = reversed;
+                reversed = id;
+                id = next;
+            }
+            return reversed;
+        };
+
+        for (auto id = takeReversed(mPendingBack); id != kInvalidId; id = mNodes[id].pendingNext)
+        {
+            mNodes[id].state.store(kQueued, std::memory_order_relaxed);
+            pushBack(id);
+        }
+        // The most recent release to the front ends up at the front.
+        for (auto id = takeReversed(mPendingFront); id != kInvalidId; id = mNodes[id].pendingNext)
+        {
+            mNodes[id].state.store(kQueued, std::memory_order_relaxed);
+            pushFront(id);
+        }
+    }
+
+    std::vector<Node> mNodes;
+    // Queue owned by the scheduler thread
+    IdType mHead;
+    IdType mTail;
+    SizeType32 mNumQueued;
+    // Pending stacks are written by releasing threads, keep them apart from the queue and from each other.
+    alignas(64) std::atomic<IdType> mPendingFront;
+    alignas(64) std::atomic<IdType> mPendingBack;
+    alignas(64) std::atomic<SizeType32> mNumFree;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
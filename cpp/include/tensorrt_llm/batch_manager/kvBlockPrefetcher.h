@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
+#include "tensorrt_llm/batch_manager/evictionPolicy.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Probes the reusable blocks of a request when it is enqueued, pins them against eviction and starts onboarding
+//! the ones in the secondary pool, so that the copies overlap the wait of the request in the queue instead of adding to
+//! its time to first token.
+//! \details The probe matches the prefix of the request in the reuse index without counting it in the reuse stats.
+//! The blocks stay pinned until the request is scheduled, when its reuse lookup takes them, or cancelled. At most
+//! maxPinnedBlocks blocks are pinned for all queued requests, so that a deep queue doesn't starve the pool; requests
+//! beyond it are not prefetched. The executor and the block manager do not call the prefetcher: its owner calls
+//! prefetch and release around the queueing of its requests and provides the onboard callback.
+class KvBlockPrefetcher
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = BaseEvictionPolicy::IdType;
+    using Clock = BaseEvictionPolicy::Clock;
+    using RequestIdType = std::uint64_t;
+    using VecTokens = std::vector<tensorrt_llm::runtime::TokenIdType>;
+    //! Whether a block is in the secondary pool
+    using IsSecondaryFn = std::function<bool(IdType)>;
+    //! Starts copying a block from the secondary pool to the primary pool, asynchronously
+    using OnboardFn = std::function<void(IdType)>;
+
+    struct Stats
+    {
+        SizeType32 numPrefetchedRequests{0};
+        SizeType32 numPinnedBlocks{0};
+        SizeType32 numOnboardedBlocks{0};
+    };
+
+    KvBlockPrefetcher(
+        PinningEvictionPolicy& evictionPolicy, SizeType32 maxPinnedBlocks, IsSecondaryFn isSecondary, OnboardFn onboard)
+        : mEvictionPolicy{evictionPolicy}
+        , mMaxPinnedBlocks{maxPinnedBlocks}
+        , mIsSecondary{std::move(isSecondary)}
+        , mOnboard{std::move(onboard)}
+    {
+        TLLM_CHECK(mMaxPinnedBlocks >= 0);
+        TLLM_CHECK(mIsSecondary && mOnboard);
+    }
+
+    //! \brief Pin the reusable blocks of an enqueued request and start onboarding them.
+    //! \param seed Seed of the prefix hashes of the request, LlmRequest::getKvCacheReuseSeed.
+    //! \return Number of blocks pinned for the request.
+    SizeType32 prefetch(RequestIdType requestId, BlockRadixTree<IdType>& tree, VecTokens const& tokens,
+        PrefixHashType seed = PrefixHashState::kRootHash)
+    {
+        TLLM_CHECK_WITH_INFO(mPinnedBlocks.count(requestId) == 0, "Request %lu was already prefetched",
+            static_cast<unsigned long>(requestId));
+        PrefixHashState state{tree.getTokensPerBlock(), seed};
+        state.extend(tokens);
+        // The last token is always computed by the context phase, as in the reuse lookup
+        auto const maxTokens = std::max(static_cast<SizeType32>(tokens.size()) - 1, 0);
+        auto match = tree.match(tokens, state, maxTokens, false);
+        if (match.partialBlock)
+        {
+            match.blocks.push_back(match.partialBlock.value());
+        }
+        auto const numBlocks
+            = std::min(static_cast<SizeType32>(match.blocks.size()), mMaxPinnedBlocks - mNumPinnedBlocks);
+        if (numBlocks <= 0)
+        {
+            return 0;
+        }
+        match.blocks.resize(numBlocks);
+
+        for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+        {
+            auto const blockId = match.blocks[bi];
+            mEvictionPolicy.pin(blockId, BlockEvictionInfo{KvCacheRetention{}, bi});
+            if (mIsSecondary(blockId) && mOnboarding.insert(blockId).second)
+            {
+                mOnboard(blockId);
+                ++mStats.numOnboardedBlocks;
+            }
+        }
+        mNumPinnedBlocks += numBlocks;
+        ++mStats.numPrefetchedRequests;
+        mStats.numPinnedBlocks += numBlocks;
+        mPinnedBlocks.emplace(requestId, std::move(match.blocks));
+        return numBlocks;
+    }
+
+    //! \brief Unpin the blocks of a request when it is scheduled or cancelled.
+    void release(RequestIdType requestId, Clock::time_point now)
+    {
+        auto const it = mPinnedBlocks.find(requestId);
+        if (it == mPinnedBlocks.end())
+        {
+            return;
+        }
+        for (auto const blockId : it->second)
+        {
+            mEvictionPolicy.unpin(blockId, now);
+            if (!mEvictionPolicy.isPinned(blockId))
+            {
+                mOnboarding.erase(blockId);
+            }
+        }
+        mNumPinnedBlocks -= static_cast<SizeType32>(it->second.size());
+        mPinnedBlocks.erase(it);
+    }
+
+    //! \brief Pins of all queued requests, a block pinned by two requests counts twice.
+    [[nodiscard]] SizeType32 getNumPinnedBlocks() const noexcept
+    {
+        return mNumPinnedBlocks;
+    }
+
+    [[nodiscard]] Stats const& getStats() const noexcept
+    {
+        return mStats;
+    }
+
+private:
+    PinningEvictionPolicy& mEvictionPolicy;
+    SizeType32 mMaxPinnedBlocks;
+    IsSecondaryFn mIsSecondary;
+    OnboardFn mOnboard;
+    std::unordered_map<RequestIdType, std::vector<IdType>> mPinnedBlocks;
+    //! Blocks whose onboarding was started by a prefetch and that are still pinned
+    std::unordered_set<IdType> mOnboarding;
+    SizeType32 mNumPinnedBlocks{0};
+    Stats mStats;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
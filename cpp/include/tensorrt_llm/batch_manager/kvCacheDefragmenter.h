@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Blocks of a primary KV cache pool by memory pool index.
+struct KvPoolLayout
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    //! Id of the block at each memory pool index, allocated or free.
+    std::vector<SizeType32> blockIds;
+    //! Whether the block at each memory pool index is free and holds nothing to keep, i.e. no reusable content.
+    std::vector<bool> isFree;
+    //! Memory pool indices of the blocks of each sequence, in order.
+    std::vector<std::vector<SizeType32>> sequences;
+};
+
+//! \brief How scattered the blocks of the sequences and the free blocks of a pool are.
+struct KvPoolFragmentation
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    SizeType32 numSequences{0};
+    SizeType32 numSequenceBlocks{0};
+    //! Runs of consecutive memory pool indices over all the sequences, numSequences if every sequence is contiguous.
+    SizeType32 numSequenceRuns{0};
+    SizeType32 numFreeBlocks{0};
+    SizeType32 numFreeExtents{0};
+    SizeType32 largestFreeExtent{0};
+
+    //! \brief Fraction of the breaks a sequence could have between its blocks that it has, 0 if all are contiguous.
+    [[nodiscard]] float getSequenceScatter() const noexcept
+    {
+        auto const possible = numSequenceBlocks - numSequences;
+        return possible > 0 ? static_cast<float>(numSequenceRuns - numSequences) / static_cast<float>(possible) : 0.f;
+    }
+
+    //! \brief Fraction of the free blocks outside of the largest free extent, 0 if the free blocks are contiguous.
+    [[nodiscard]] float getFreeFragmentation() const noexcept
+    {
+        return numFreeBlocks > 0
+            ? 1.f - static_cast<float>(largestFreeExtent) / static_cast<float>(numFreeBlocks)
+            : 0.f;
+    }
+};
+
+//! \brief Move of the data of an allocated block to a free block, see BlockManager::relocateBlocks.
+struct KvBlockMove
+{
+    tensorrt_llm::runtime::SizeType32 blockId;
+    tensorrt_llm::runtime::SizeType32 freeBlockId;
+};
+
+//! \brief Plans the moves that make the blocks of long-running sequences contiguous in the primary pool again.
+//! \details Under in-flight batching with reuse, the blocks of a sequence end up scattered over the pool, which hurts
+//! the locality of the attention kernels and leaves no contiguous free extents. Each round moves the most scattered
+//! sequences, one whole sequence at a time, to the smallest free extent that holds them, within a budget of
+//! `maxMovesPerRound` block copies so that a round fits into the idle time of the copy stream between iterations.
+//! Blocks shared by several sequences stay in place, and a round does not write into the blocks it frees, so that the
+//! moves of a round can be enqueued in any order.
+class KvCacheDefragmenter
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    struct Config
+    {
+        SizeType32 maxMovesPerRound{64};
+        //! Sequences with fewer blocks are left as they are.
+        SizeType32 minSequenceBlocks{2};
+    };
+
+    explicit KvCacheDefragmenter(Config const& config)
+        : mConfig{config}
+    {
+        TLLM_CHECK(mConfig.maxMovesPerRound > 0);
+        TLLM_CHECK(mConfig.minSequenceBlocks > 1);
+    }
+
+    [[nodiscard]] static KvPoolFragmentation measure(KvPoolLayout const& layout)
+    {
+        TLLM_CHECK(layout.blockIds.size() == layout.isFree.size());
+        KvPoolFragmentation fragmentation;
+        for (auto const& sequence : layout.sequences)
+        {
+            if (sequence.empty())
+            {
+                continue;
+            }
+            ++fragmentation.numSequences;
+            fragmentation.numSequenceBlocks += static_cast<SizeType32>(sequence.size());
+            fragmentation.numSequenceRuns += countRuns(sequence);
+        }
+        forEachFreeExtent(layout.isFree,
+            [&fragmentation](SizeType32, SizeType32 length)
+            {
+                fragmentation.numFreeBlocks += length;
+                ++fragmentation.numFreeExtents;
+                fragmentation.largestFreeExtent = std::max(fragmentation.largestFreeExtent, length);
+            });
+        return fragmentation;
+    }
+
+    //! \brief The moves of one round, to be applied before the next iteration.
+    [[nodiscard]] std::vector<KvBlockMove> plan(KvPoolLayout const& layout) const
+    {
+        TLLM_CHECK(layout.blockIds.size() == layout.isFree.size());
+        auto const poolSize = static_cast<SizeType32>(layout.blockIds.size());
+
+        std::vector<SizeType32> numOwners(poolSize, 0);
+        for (auto const& sequence : layout.sequences)
+        {
+            for (auto const poolIdx : sequence)
+            {
+                TLLM_CHECK(0 <= poolIdx && poolIdx < poolSize);
+                ++numOwners[poolIdx];
+            }
+        }
+
+        // The most scattered sequences first, the earlier ones on ties
+        std::vector<std::size_t> candidates;
+        std::vector<SizeType32> numBreaks(layout.sequences.size(), 0);
+        for (std::size_t si = 0; si < layout.sequences.size(); ++si)
+        {
+            auto const& sequence = layout.sequences[si];
+            if (static_cast<SizeType32>(sequence.size()) < mConfig.minSequenceBlocks)
+            {
+                continue;
+            }
+            numBreaks[si] = countRuns(sequence) - 1;
+            auto const isShared = std::any_of(
+                sequence.begin(), sequence.end(), [&numOwners](SizeType32 poolIdx) { return numOwners[poolIdx] > 1; });
+            if (numBreaks[si] > 0 && !isShared)
+            {
+                candidates.push_back(si);
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(),
+            [&numBreaks](std::size_t lhs, std::size_t rhs) { return numBreaks[lhs] > numBreaks[rhs]; });
+
+        auto isFree = layout.isFree;
+        std::vector<KvBlockMove> moves;
+        for (auto const si : candidates)
+        {
+            auto const& sequence = layout.sequences[si];
+            auto const numBlocks = static_cast<SizeType32>(sequence.size());
+            if (static_cast<SizeType32>(moves.size()) + numBlocks > mConfig.maxMovesPerRound)
+            {
+                continue;
+            }
+            auto const extentStart = findBestFit(isFree, numBlocks);
+            if (!extentStart)
+            {
+                continue;
+            }
+            for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+            {
+                auto const dstIdx = *extentStart + bi;
+                moves.push_back(KvBlockMove{layout.blockIds[sequence[bi]], layout.blockIds[dstIdx]});
+                isFree[dstIdx] = false;
+            }
+        }
+        return moves;
+    }
+
+    [[nodiscard]] Config const& getConfig() const noexcept
+    {
+        return mConfig;
+    }
+
+private:
+    [[nodiscard]] static SizeType32 countRuns(std::vector<SizeType32> const& sequence)
+    {
+        SizeType32 runs = sequence.empty() ? 0 : 1;
+        for (std::size_t bi = 1; bi < sequence.size(); ++bi)
+        {
+            runs += sequence[bi] != sequence[bi - 1] + 1 ? 1 : 0;
+        }
+        return runs;
+    }
+
+    template <typename TFunc>
+    static void forEachFreeExtent(std::vector<bool> const& isFree, TFunc&& func)
+    {
+        auto const poolSize = static_cast<SizeType32>(isFree.size());
+        for (SizeType32 start = 0; start < poolSize;)
+        {
+            if (!isFree[start])
+            {
+                ++start;
+                continue;
+            }
+            auto end = start;
+            while (end < poolSize && isFree[end])
+            {
+                ++end;
+            }
+            func(start, end - start);
+            start = end;
+        }
+    }
+
+    //! \brief Start of the smallest free extent of at least numBlocks blocks, the first one on ties.
+    [[nodiscard]] static std::optional<SizeType32> findBestFit(std::vector<bool> const& isFree, SizeType32 numBlocks)
+    {
+        std::optional<SizeType32> bestStart;
+        SizeType32 bestLength{0};
+        forEachFreeExtent(isFree,
+            [&](SizeType32 start, SizeType32 length)
+            {
+                if (length >= numBlocks && (!bestStart || length < bestLength))
+                {
+                    bestStart = start;
+                    bestLength = length;
+                }
+            });
+        return bestStart;
+    }
+
+    Config mConfig;
+};
+
+} // namespace tensorrt_llm::batch_manager
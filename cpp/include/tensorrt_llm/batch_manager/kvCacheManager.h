@@ -17,6 +17,9 @@
 #pragma once
 
 #include "tensorrt_llm/batch_manager/kvCacheConfig.h"
+#include "tensorrt_llm/batch_manager/kvCacheDefragmenter.h"
+#include "tensorrt_llm/batch_manager/kvCacheReuseIndex.h"
+#include "tensorrt_llm/batch_manager/kvCacheTelemetry.h"
 #include "tensorrt_llm/batch_manager/llmRequest.h" // TODO forward declare
 #include "tensorrt_llm/kernels/kvCacheIndex.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
@@ -28,6 +31,7 @@
 
 #include <NvInferRuntime.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <functional>
 #include <list>
@@ -87,6 +91,16 @@ struct KvCacheStats
     SizeType32 reusedBlocks;
 };
 
+// KV cache of one sequence as exported by the instance that ran its context phase, to be imported by the instance
+// running its generation phase. The block data itself is moved separately, see runtime::KvBlockTransfer.
+struct SequenceKvCacheExport
+{
+    SizeType32 numTokens;
+    SizeType32 beamWidth;
+    // Block ids per beam on the exporting instance
+    std::vector<std::vector<SizeType32>> cacheBlockIds;
+};
+
 // Basic building block of a paged KV cache - a single
 // cache block. This class just holds metadata, no pointers
 // since it is reused across all layers.
@@ -318,6 +332,47 @@ public:
 
     void replaceSharedBlock(GenerationRequest& sequence, SizeType32 blockIdx);
 
+    //! \brief Give beam `beamIdx` of the sequence a private copy of block `blockIdx` if the block is shared.
+    //! \details Blocks stay shared among beams and forked sequences until one of them writes to them, this has to be
+    //! called before writing into a block that might be shared.
+    //! \return True if the block was copied.
+    //! \throws If the block is shared and no block is free for the copy, the sequence is left unchanged.
+    bool copyOnWrite(GenerationRequest& sequence, SizeType32 beamIdx, SizeType32 blockIdx)
+    {
+        auto const blockId = sequence.getCacheBlockIds().at(beamIdx).at(blockIdx);
+        auto sharedBlock = mAllBlocksById.at(blockId);
+        if (!sharedBlock->isShared())
+        {
+            return false;
+        }
+        TLLM_CHECK_WITH_INFO(hasFreeBlocks(), "No free block to copy shared block %d on write", blockId);
+        auto newBlock = getFreeBlock();
+        copyBlock(sharedBlock, newBlock);
+        newBlock->incRefCount();
+        sharedBlock->decRefCount();
+        // Shared blocks are listed once per reference, replace the one of this beam.
+        auto& allocatedBlocks = mAllocatedBlocksPerSeq.at(sequence.getSequenceSlotIdx());
+        auto it = std::find(allocatedBlocks.begin(), allocatedBlocks.end(), sharedBlock);
+        TLLM_CHECK(it != allocatedBlocks.end());
+        *it = newBlock;
+        sequence.changeCacheBlock(beamIdx, blockIdx, newBlock->getBlockId());
+        return true;
+    }
+
+    //! \brief Assign all blocks of `srcSequence` to every beam of the new sequence `dstSequence`, without copying.
+    void forkSequence(GenerationRequest const& srcSequence, GenerationRequest& dstSequence)
+    {
+        auto const& srcBlockIds = srcSequence.getCacheBlockIds().at(0);
+        for (SizeType32 beamIdx = 0; beamIdx < dstSequence.getBeamWidth(); ++beamIdx)
+        {
+            for (auto const blockId : srcBlockIds)
+            {
+                auto block = mAllBlocksById.at(blockId);
+                addBlockToBeam(block, dstSequence, beamIdx, dstSequence.getSequenceSlotIdx());
+            }
+        }
+    }
+
     //! \brief Release blocks of the sequence. Store blocks for reuse if llmReqeust is provided.
     void releaseBlocks(GenerationRequest& sequence, std::shared_ptr<LlmRequest> const& llmRequest = nullptr);
 
@@ -389,6 +444,65 @@ public:
         return mSecondaryPool;
     }
 
+    //! \brief Get pointer to the raw data of a block in primary memory (K & V, all layers).
+    [[nodiscard]] void* getPrimaryBlockPointer(KVCacheBlock::IdType blockId) const
+    {
+        auto const& block = mAllBlocksById.at(blockId);
+        TLLM_CHECK_WITH_INFO(block->isPrimary(), "Block %d is not in primary memory", blockId);
+        auto const bytesPerBlock = mPrimaryPool->getSizeInBytes() / mPrimaryPool->getShape().d[0];
+        return static_cast<std::uint8_t*>(mPrimaryPool->data()) + block->getMemoryPoolBlockIndex() * bytesPerBlock;
+    }
+
+    //! \brief The blocks of the primary pool by memory pool index and the primary blocks of each sequence slot, in
+    //! allocation order, to plan a defragmentation with KvCacheDefragmenter. Free blocks stored for reuse are not free
+    //! in the layout, their content is kept.
+    [[nodiscard]] KvPoolLayout getPrimaryPoolLayout() const
+    {
+        KvPoolLayout layout;
+        layout.blockIds.assign(mNumPrimaryBlocks, -1);
+        layout.isFree.assign(mNumPrimaryBlocks, false);
+        for (auto const& block : mAllBlocksById)
+        {
+            if (block->isPrimary())
+            {
+                auto const poolIdx = static_cast<SizeType32>(block->getMemoryPoolBlockIndex());
+                layout.blockIds.at(poolIdx) = block->getBlockId();
+                layout.isFree.at(poolIdx) = !block->hasRefs() && block->getTokens().empty();
+            }
+        }
+        layout.sequences.reserve(mAllocatedBlocksPerSeq.size());
+        for (auto const& blocks : mAllocatedBlocksPerSeq)
+        {
+            auto& sequence = layout.sequences.emplace_back();
+            for (auto const& block : blocks)
+            {
+                if (block->isPrimary())
+                {
+                    sequence.push_back(static_cast<SizeType32>(block->getMemoryPoolBlockIndex()));
+                }
+            }
+        }
+        return layout;
+    }
+
+    //! \brief Move the data of allocated primary blocks to free primary blocks, see KvCacheDefragmenter::plan.
+    //! \details The blocks keep their ids and swap their memory pool indices, so only the block offsets of the
+    //! sequences change. The copies are enqueued on the stream of the block manager, as for copyOnWrite. To be called
+    //! between iterations, before the block offsets of the next one are copied.
+    void relocateBlocks(std::vector<KvBlockMove> const& moves)
+    {
+        for (auto const& move : moves)
+        {
+            auto const& block = mAllBlocksById.at(move.blockId);
+            auto const& freeBlock = mAllBlocksById.at(move.freeBlockId);
+            TLLM_CHECK_WITH_INFO(block->isPrimary() && freeBlock->isPrimary(), "Only primary blocks can be relocated");
+            TLLM_CHECK_WITH_INFO(
+                !freeBlock->hasRefs() && freeBlock->getTokens().empty(), "Block %d is not free", move.freeBlockId);
+            copyBlock(block, freeBlock);
+            block->swapMemoryPoolBlockOffset(freeBlock);
+        }
+    }
+
     //! \brief Get index in pool to K or V block.
     //! \param blockId the blockId as returned by getBlockId()
     //! \param fieldIdx either 0 (K) or 1 (V),
@@ -538,6 +652,78 @@ public:
         return kvCacheStats;
     }
 
+    //! \brief Add the live sequences to the telemetry of the current iteration, see KvCacheTelemetry.
+    void sampleTelemetry(KvCacheTelemetry& telemetry) const
+    {
+        for (auto const& sequence : mSequences)
+        {
+            if (sequence)
+            {
+                auto const& prepopulatedTokens = sequence->getNumPrepopulatedTokens();
+                telemetry.addSequence(sequence->getSequenceSlotIdx(), sequence->getNumTokens(),
+                    prepopulatedTokens.empty() ? 0 : prepopulatedTokens.front(), sequence->getCacheBlockIds());
+            }
+        }
+    }
+
+    //! \brief Record the blocks of a sequence in `index` as removeSequence stores them for reuse. To be called before
+    //! removeSequence, with reuse enabled.
+    void storeForReuse(KvCacheReuseIndex& index, SizeType32 seqSlotIdx, LlmRequest const& llmRequest) const
+    {
+        auto const& sequence = *mSequences.at(seqSlotIdx);
+        auto const& tokens = llmRequest.getTokens(0);
+        // The keys and values of the last token are not computed yet.
+        auto const numTokens = std::min(static_cast<SizeType32>(tokens.size()), sequence.getNumTokens()) - 1;
+        if (numTokens > 0)
+        {
+            index.store(VecTokens(tokens.begin(), tokens.begin() + numTokens), sequence.getCacheBlockIds().at(0),
+                llmRequest.getKvCacheReuseSeed());
+        }
+    }
+
+    //! \brief Remove the blocks from `index` that the block manager reallocated to the live sequences. To be called
+    //! once per iteration, after the sequences were added and extended.
+    void syncReuseIndex(KvCacheReuseIndex& index) const
+    {
+        std::vector<KvCacheReuseIndex::IdType> reallocated;
+        for (auto const& sequence : mSequences)
+        {
+            if (!sequence)
+            {
+                continue;
+            }
+            // Reused blocks hold the prepopulated tokens, all the other blocks were allocated for new content.
+            auto const& prepopulatedTokens = sequence->getNumPrepopulatedTokens();
+            auto const numReusedBlocks
+                = prepopulatedTokens.empty() ? 0 : prepopulatedTokens.front() / getTokensPerBlock();
+            for (auto const& beamBlockIds : sequence->getCacheBlockIds())
+            {
+                for (auto bi = static_cast<std::size_t>(numReusedBlocks); bi < beamBlockIds.size(); ++bi)
+                {
+                    if (index.contains(beamBlockIds[bi]))
+                    {
+                        reallocated.push_back(beamBlockIds[bi]);
+                    }
+                }
+            }
+        }
+        index.invalidate(reallocated);
+    }
+
+    //! \brief Run one round of defragmentation of the primary pool, see KvCacheDefragmenter. To be called between
+    //! iterations, e.g. when the copy stream is idle.
+    //! \return The fragmentation of the primary pool after the round.
+    KvPoolFragmentation defragment(KvCacheDefragmenter const& defragmenter)
+    {
+        mBlockManager.relocateBlocks(defragmenter.plan(mBlockManager.getPrimaryPoolLayout()));
+        return getPrimaryPoolFragmentation();
+    }
+
+    [[nodiscard]] KvPoolFragmentation getPrimaryPoolFragmentation() const
+    {
+        return KvCacheDefragmenter::measure(mBlockManager.getPrimaryPoolLayout());
+    }
+
     [[nodiscard]] SizeType32 getMaxBlocksPerSeq() const
     {
         return mMaxBlocksPerSeq;
@@ -617,6 +803,80 @@ public:
         return mCacheType == CacheType::kCROSS;
     }
 
+    //! \brief Add sequence `dstSeqSlotIdx` sharing all blocks of beam 0 of `srcSeqSlotIdx`, e.g. for parallel sampling.
+    //! \details Blocks are copied on write, see copyOnWriteLastBlock.
+    void forkSequence(SizeType32 srcSeqSlotIdx, SizeType32 dstSeqSlotIdx, SizeType32 beamWidth = 1)
+    {
+        auto const& srcSequence = *mSequences.at(srcSeqSlotIdx);
+        TLLM_CHECK_WITH_INFO(!mSequences.at(dstSeqSlotIdx), "Sequence slot %d is in use", dstSeqSlotIdx);
+        auto dstSequence = std::make_shared<GenerationRequest>(dstSeqSlotIdx, srcSequence.getNumTokens(), beamWidth);
+        mBlockManager.forkSequence(srcSequence, *dstSequence);
+        mSequences[dstSeqSlotIdx] = dstSequence;
+        cacheBlockOffsets(*dstSequence, dstSeqSlotIdx);
+    }
+
+    //! \brief Make the last block of every beam private before the next token is written into it.
+    //! \return Number of blocks copied.
+    SizeType32 copyOnWriteLastBlock(SizeType32 seqSlotIdx)
+    {
+        auto& sequence = *mSequences.at(seqSlotIdx);
+        if (sequence.getNumTokens() % getTokensPerBlock() == 0)
+        {
+            // The next token starts a new block
+            return 0;
+        }
+        SizeType32 numCopied{0};
+        for (SizeType32 beamIdx = 0; beamIdx < sequence.getBeamWidth(); ++beamIdx)
+        {
+            auto const blockIdx = static_cast<SizeType32>(sequence.getCacheBlockIds().at(beamIdx).size()) - 1;
+            if (mBlockManager.copyOnWrite(sequence, beamIdx, blockIdx))
+            {
+                ++numCopied;
+                updateNewBlockPointer(sequence, seqSlotIdx, blockIdx);
+            }
+        }
+        return numCopied;
+    }
+
+    //! \brief Export the block list of a sequence, e.g. after its context phase, to continue it on another instance.
+    [[nodiscard]] SequenceKvCacheExport exportSequence(SizeType32 seqSlotIdx) const
+    {
+        auto const& sequence = *mSequences.at(seqSlotIdx);
+        return SequenceKvCacheExport{sequence.getNumTokens(), sequence.getBeamWidth(), sequence.getCacheBlockIds()};
+    }
+
+    //! \brief Get pointers to the blocks of a sequence, beam after beam, in the order of getCacheBlockIds.
+    //! \details Used on both sides of a transfer: the exporting instance sends from, and the importing instance
+    //! receives into, these pointers.
+    [[nodiscard]] std::vector<void*> getSequenceBlockPointers(SizeType32 seqSlotIdx) const
+    {
+        std::vector<void*> pointers;
+        for (auto const& beamBlockIds : mSequences.at(seqSlotIdx)->getCacheBlockIds())
+        {
+            for (auto const blockId : beamBlockIds)
+            {
+                pointers.push_back(mBlockManager.getPrimaryBlockPointer(blockId));
+            }
+        }
+        return pointers;
+    }
+
+    //! \brief Add a sequence exported by another instance. Allocates blocks matching the exported block list, their
+    //! content has to be received into getSequenceBlockPointers(seqSlotIdx).
+    void importSequence(SizeType32 seqSlotIdx, SequenceKvCacheExport const& exported,
+        std::shared_ptr<LlmRequest> const& llmRequest = nullptr)
+    {
+        addSequence(seqSlotIdx, exported.numTokens, exported.beamWidth, llmRequest);
+        auto const& cacheBlockIds = mSequences.at(seqSlotIdx)->getCacheBlockIds();
+        TLLM_CHECK(cacheBlockIds.size() == exported.cacheBlockIds.size());
+        for (std::size_t beamIdx = 0; beamIdx < cacheBlockIds.size(); ++beamIdx)
+        {
+            TLLM_CHECK_WITH_INFO(cacheBlockIds[beamIdx].size() == exported.cacheBlockIds[beamIdx].size(),
+                "Imported sequence has %lu blocks in beam %lu, expected %lu", cacheBlockIds[beamIdx].size(), beamIdx,
+                exported.cacheBlockIds[beamIdx].size());
+        }
+    }
+
 private:
     void setOffsets(kernels::KVCacheIndex* offsetsPtr, nvinfer1::Dims const& offsetsShape, SizeType32 seqSlotIdx,
         SizeType32 beamIdx, SizeType32 blockIdx, KVCacheBlock::IdType blockId) const;
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Prefix index of the blocks the KV cache manager stored for reuse, by block id.
+//! \details Kept next to the KVCacheManager by the owner of the scheduling loop, see KVCacheManager::storeForReuse and
+//! KVCacheManager::syncReuseIndex. A lookup costs one hash map access per block of the prompt, e.g. to estimate the
+//! blocks a request needs before it is scheduled or to prefetch its blocks, see KvBlockPrefetcher. The block manager
+//! itself keeps matching its own tree when a sequence is added, so the index is a hint of what it will reuse: blocks
+//! that are reallocated to other content are only removed at the next sync.
+class KvCacheReuseIndex
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = std::int32_t;
+    using Tree = BlockRadixTree<IdType>;
+    using VecTokens = Tree::VecTokens;
+    using MatchResult = Tree::MatchResult;
+
+    explicit KvCacheReuseIndex(SizeType32 tokensPerBlock)
+        : mTree{tokensPerBlock}
+    {
+    }
+
+    //! \brief Record the blocks of a sequence that are stored for reuse.
+    //! \param tokens Tokens whose keys and values are in the blocks, the last block may be partial.
+    //! \param blockIds Ids of the blocks of the sequence, at least one per block of `tokens`.
+    //! \param seed Seed of the sequence, LlmRequest::getKvCacheReuseSeed.
+    void store(VecTokens const& tokens, std::vector<IdType> const& blockIds, PrefixHashType seed)
+    {
+        if (tokens.empty())
+        {
+            return;
+        }
+        mTree.insert(tokens, blockIds, seed);
+        PrefixHashState state{mTree.getTokensPerBlock(), seed};
+        state.extend(tokens);
+        for (SizeType32 bi = 0; bi < state.getNumFullBlocks(); ++bi)
+        {
+            mBlockKeys[blockIds.at(bi)] = state.getBlockHash(bi);
+        }
+        if (state.getNumTokens() % mTree.getTokensPerBlock() != 0)
+        {
+            mBlockKeys[blockIds.at(state.getNumFullBlocks())] = state.getHash();
+        }
+    }
+
+    //! \brief Forget blocks that hold other content now, with the blocks cached below them.
+    void invalidate(std::vector<IdType> const& blockIds)
+    {
+        for (auto const blockId : blockIds)
+        {
+            auto const it = mBlockKeys.find(blockId);
+            if (it == mBlockKeys.end())
+            {
+                continue;
+            }
+            auto const hash = it->second;
+            mBlockKeys.erase(it);
+            for (auto const erasedId : mTree.eraseSubtree(hash))
+            {
+                mBlockKeys.erase(erasedId);
+            }
+        }
+    }
+
+    //! \brief Whether the block is indexed, i.e. stored for reuse and not reallocated since.
+    [[nodiscard]] bool contains(IdType blockId) const
+    {
+        return mBlockKeys.count(blockId) > 0;
+    }
+
+    //! \brief Find the longest cached prefix of `tokens`, see BlockRadixTree::match.
+    [[nodiscard]] MatchResult match(VecTokens const& tokens, PrefixHashState const& state,
+        std::optional<SizeType32> maxTokens = std::nullopt, bool recordStats = true)
+    {
+        return mTree.match(tokens, state, maxTokens, recordStats);
+    }
+
+    //! \brief Find the longest cached prefix of `tokens`, hashing all of them.
+    [[nodiscard]] MatchResult match(VecTokens const& tokens, PrefixHashType seed = PrefixHashState::kRootHash,
+        std::optional<SizeType32> maxTokens = std::nullopt)
+    {
+        PrefixHashState state{mTree.getTokensPerBlock(), seed};
+        state.extend(tokens);
+        return mTree.match(tokens, state, maxTokens);
+    }
+
+    [[nodiscard]] BlockRadixTreeStats const& getStats() const noexcept
+    {
+        return mTree.getStats();
+    }
+
+    //! \brief Number of indexed blocks.
+    [[nodiscard]] SizeType32 size() const noexcept
+    {
+        return mTree.size();
+    }
+
+    [[nodiscard]] SizeType32 getTokensPerBlock() const noexcept
+    {
+        return mTree.getTokensPerBlock();
+    }
+
+    //! \brief The tree of the index, e.g. for KvBlockPrefetcher. Blocks have to be added with store, blocks inserted
+    //! into the tree directly are never invalidated.
+    [[nodiscard]] Tree& getTree() noexcept
+    {
+        return mTree;
+    }
+
+private:
+    Tree mTree;
+    // Key of each indexed block in mTree
+    std::unordered_map<IdType, PrefixHashType> mBlockKeys;
+};
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
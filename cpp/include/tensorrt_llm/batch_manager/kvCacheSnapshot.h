@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Header of a snapshot of the reusable blocks.
+//! \details A snapshot is only restored by an engine with the same fingerprint, block size and tokens per block.
+struct KvCacheSnapshotHeader
+{
+    static constexpr std::uint64_t kMagic = 0x504e534b4d4c4c54ULL; // "TLLMKSNP"
+    static constexpr std::uint32_t kVersion = 2;
+
+    std::uint64_t magic{kMagic};
+    std::uint32_t version{kVersion};
+    std::uint32_t tokensPerBlock{0};
+    //! Identifies the engine that produced the block contents, see computeSnapshotFingerprint.
+    std::uint64_t engineFingerprint{0};
+    std::uint64_t blockSizeBytes{0};
+    std::uint64_t numBlocks{0};
+};
+
+//! \brief FNV-1a hash of e.g. the engine config, to tie snapshots to an engine.
+[[nodiscard]] inline std::uint64_t computeSnapshotFingerprint(void const* data, std::size_t size) noexcept
+{
+    auto const* bytes = static_cast<unsigned char const*>(data);
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (std::size_t i = 0; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+namespace detail
+{
+// Index of the parent record of blocks that start a sequence
+constexpr std::uint64_t kSnapshotRootIndex = std::numeric_limits<std::uint64_t>::max();
+} // namespace detail
+
+//! \brief Write the tokens and contents of all blocks in `tree` to `path`.
+//! \details Blocks are written parents first. Each record holds the index of the parent record, the seed of the
+//! sequence, see PrefixHashState::makeSeed, the tokens of the block and its contents. The snapshot is written to a
+//! temporary file and renamed, so a crash never leaves a truncated snapshot behind.
+//! \param readBlock Copies the contents of a block, blockSizeBytes bytes, to host memory.
+//! \return Number of blocks written.
+template <typename ValueT>
+std::uint64_t saveKvCacheSnapshot(std::filesystem::path const& path, BlockRadixTree<ValueT> const& tree,
+    std::uint64_t engineFingerprint, std::uint64_t blockSizeBytes,
+    std::function<void(ValueT const&, void*)> const& readBlock)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    auto tmpPath = path;
+    tmpPath += ".tmp";
+    std::ofstream os{tmpPath, std::ios::binary | std::ios::trunc};
+    TLLM_CHECK_WITH_INFO(os.good(), "Failed to open %s", tmpPath.string().c_str());
+
+    KvCacheSnapshotHeader header;
+    header.tokensPerBlock = static_cast<std::uint32_t>(tree.getTokensPerBlock());
+    header.engineFingerprint = engineFingerprint;
+    header.blockSizeBytes = blockSizeBytes;
+    header.numBlocks = static_cast<std::uint64_t>(tree.size());
+    os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+    std::unordered_map<PrefixHashType, std::uint64_t> recordIndex;
+    std::vector<char> contents(blockSizeBytes);
+    tree.forEachBlock(
+        [&](PrefixHashType hash, PrefixHashType parentHash, PrefixHashType seed, std::vector<TokenIdType> const& tokens,
+            ValueT const& value)
+        {
+            auto const parentIndex
+                = parentHash == PrefixHashState::kRootHash ? detail::kSnapshotRootIndex : recordIndex.at(parentHash);
+            auto const numTokens = static_cast<std::uint32_t>(tokens.size());
+            readBlock(value, contents.data());
+            os.write(reinterpret_cast<char const*>(&parentIndex), sizeof(parentIndex));
+            os.write(reinterpret_cast<char const*>(&seed), sizeof(seed));
+            os.write(reinterpret_cast<char const*>(&numTokens), sizeof(numTokens));
+            os.write(reinterpret_cast<char const*>(tokens.data()), numTokens * sizeof(TokenIdType));
+            os.write(contents.data(), static_cast<std::streamsize>(contents.size()));
+            recordIndex.emplace(hash, recordIndex.size());
+        });
+    os.close();
+    TLLM_CHECK_WITH_INFO(!os.fail(), "Failed to write %s", tmpPath.string().c_str());
+    std::filesystem::rename(tmpPath, path);
+    TLLM_LOG_INFO("Saved %lu reusable blocks to %s", static_cast<unsigned long>(header.numBlocks),
+        path.string().c_str());
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return header.numBlocks;
+}
+
+//! \brief Restore the blocks of a snapshot into the empty `tree`, on startup.
+//! \details Blocks are restored parents first, so when the pool runs out the most shared prefixes are kept. Blocks
+//! whose parent was not restored are skipped. A missing snapshot, or one written for another engine, restores nothing.
+//! \param restoreBlock Allocates a block and copies the contents into it, returns std::nullopt if no block is free.
+//! \return Number of restored blocks.
+template <typename ValueT>
+std::uint64_t loadKvCacheSnapshot(std::filesystem::path const& path, BlockRadixTree<ValueT>& tree,
+    std::uint64_t engineFingerprint, std::uint64_t blockSizeBytes,
+    std::function<std::optional<ValueT>(void const*)> const& restoreBlock)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    using TokenIdType = tensorrt_llm::runtime::TokenIdType;
+    TLLM_CHECK_WITH_INFO(tree.size() == 0, "KV cache snapshots are restored into an empty tree");
+    std::ifstream is{path, std::ios::binary};
+    if (!is.good())
+    {
+        TLLM_LOG_INFO("No KV cache snapshot at %s", path.string().c_str());
+        return 0;
+    }
+    KvCacheSnapshotHeader header;
+    is.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!is.good() || header.magic != KvCacheSnapshotHeader::kMagic
+        || header.version != KvCacheSnapshotHeader::kVersion
+        || header.tokensPerBlock != static_cast<std::uint32_t>(tree.getTokensPerBlock())
+        || header.engineFingerprint != engineFingerprint || header.blockSizeBytes != blockSizeBytes)
+    {
+        TLLM_LOG_WARNING("KV cache snapshot %s does not match the engine, ignoring it", path.string().c_str());
+        return 0;
+    }
+
+    // Hash of the restored block of each record
+    std::vector<std::optional<PrefixHashType>> restored;
+    restored.reserve(header.numBlocks);
+    std::vector<TokenIdType> tokens;
+    std::vector<char> contents(blockSizeBytes);
+    std::uint64_t numRestored{0};
+    for (std::uint64_t i = 0; i < header.numBlocks; ++i)
+    {
+        std::uint64_t parentIndex{0};
+        PrefixHashType seed{PrefixHashState::kRootHash};
+        std::uint32_t numTokens{0};
+        is.read(reinterpret_cast<char*>(&parentIndex), sizeof(parentIndex));
+        is.read(reinterpret_cast<char*>(&seed), sizeof(seed));
+        is.read(reinterpret_cast<char*>(&numTokens), sizeof(numTokens));
+        if (!is.good() || numTokens == 0 || numTokens > header.tokensPerBlock
+            || (parentIndex != detail::kSnapshotRootIndex && parentIndex >= i))
+        {
+            TLLM_LOG_WARNING("KV cache snapshot %s is corrupted after %lu blocks", path.string().c_str(),
+                static_cast<unsigned long>(i));
+            break;
+        }
+        tokens.resize(numTokens);
+        is.read(reinterpret_cast<char*>(tokens.data()), numTokens * sizeof(TokenIdType));
+        is.read(contents.data(), static_cast<std::streamsize>(contents.size()));
+        if (!is.good())
+        {
+            TLLM_LOG_WARNING("KV cache snapshot %s is truncated", path.string().c_str());
+            break;
+        }
+
+        auto const parent = parentIndex == detail::kSnapshotRootIndex
+            ? std::optional<PrefixHashType>{PrefixHashState::kRootHash}
+            : restored[parentIndex];
+        std::optional<PrefixHashType> hash;
+        if (parent.has_value())
+        {
+            if (auto value = restoreBlock(contents.data()))
+            {
+                hash = tree.insertChild(parent.value(), tokens, value.value(), seed);
+                numRestored += hash.has_value() ? 1 : 0;
+            }
+        }
+        restored.push_back(hash);
+    }
+    TLLM_LOG_INFO("Restored %lu of %lu reusable blocks from %s", static_cast<unsigned long>(numRestored),
+        static_cast<unsigned long>(header.numBlocks), path.string().c_str());
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return numRestored;
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager::kv_cache_manager
+{
+
+//! \brief Histogram with power-of-two buckets.
+//! \details Bucket 0 counts zeros, bucket i > 0 counts values in [2^(i-1), 2^i). The last bucket also counts all
+//! larger values.
+class Log2Histogram
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    static constexpr SizeType32 kDefaultNumBuckets = 16;
+
+    explicit Log2Histogram(SizeType32 numBuckets = kDefaultNumBuckets)
+        : mCounts(numBuckets, 0)
+    {
+        TLLM_CHECK(numBuckets > 0);
+    }
+
+    [[nodiscard]] static SizeType32 bucketIndex(std::uint64_t value, SizeType32 numBuckets) noexcept
+    {
+        SizeType32 index{0};
+        while (value != 0 && index < numBuckets - 1)
+        {
+            value >>= 1;
+            ++index;
+        }
+        return index;
+    }
+
+    void add(std::uint64_t value, SizeType32 count = 1) noexcept
+    {
+        mCounts[bucketIndex(value, static_cast<SizeType32>(mCounts.size()))] += count;
+    }
+
+    void reset() noexcept
+    {
+        std::fill(mCounts.begin(), mCounts.end(), 0);
+    }
+
+    [[nodiscard]] std::vector<SizeType32> const& getCounts() const noexcept
+    {
+        return mCounts;
+    }
+
+private:
+    std::vector<SizeType32> mCounts;
+};
+
+//! \brief Token slots of one sequence that do not hold a token yet.
+struct SequenceFragmentation
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    SizeType32 seqSlotIdx{0};
+    // Token slots of the blocks of all beams
+    SizeType32 numAllocatedTokenSlots{0};
+    SizeType32 numUnusedTokenSlots{0};
+    // numUnusedTokenSlots relative to numAllocatedTokenSlots
+    float fragmentation{0.f};
+};
+
+//! \brief Per-iteration snapshot of KvCacheTelemetry.
+struct KvCacheTelemetryStats
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    // Lifetimes of the blocks released in the iteration, in iterations, see Log2Histogram for the buckets
+    std::vector<SizeType32> blockLifetimeHistogram;
+    // Reused depth in blocks of the sequences added in the iteration, bucket 0 counts the sequences without reuse
+    std::vector<SizeType32> reuseDepthHistogram;
+    // Fragmentation of every live sequence, in the order they were added
+    std::vector<SequenceFragmentation> sequences;
+    // Allocated token slots that do not hold a token, over all sequences
+    SizeType32 numUnusedTokenSlots{0};
+    // numUnusedTokenSlots relative to all allocated token slots
+    float fragmentation{0.f};
+};
+
+//! \brief Collects per-iteration KV cache telemetry from the block ids of the live sequences: block lifetimes, reuse
+//! depth and fragmentation per sequence.
+//! \details The owner of the iteration loop adds every live sequence once per iteration, e.g. with
+//! KVCacheManager::sampleTelemetry, and ends the iteration with takeStats. Blocks are tracked by their id between two
+//! samples, so a block released and allocated again within one iteration counts as one block. The telemetry is kept
+//! outside of the block manager, whose implementation is prebuilt, so events inside the block manager, like
+//! evictions and transfers between the primary and secondary pool, are not observed.
+class KvCacheTelemetry
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using IdType = SizeType32;
+    using IterationType = std::uint64_t;
+
+    explicit KvCacheTelemetry(SizeType32 tokensPerBlock, SizeType32 numBuckets = Log2Histogram::kDefaultNumBuckets)
+        : mTokensPerBlock{tokensPerBlock}
+        , mIteration{0}
+        , mBlockLifetimes{numBuckets}
+        , mReuseDepths{numBuckets}
+    {
+        TLLM_CHECK(tokensPerBlock > 0);
+    }
+
+    //! \brief Add a live sequence to the current iteration.
+    //! \param numPrepopulatedTokens Tokens of the sequence found in reused blocks when it was added.
+    //! \param cacheBlockIds Ids of the blocks of the sequence, per beam.
+    void addSequence(SizeType32 seqSlotIdx, SizeType32 numTokens, SizeType32 numPrepopulatedTokens,
+        std::vector<std::vector<IdType>> const& cacheBlockIds)
+    {
+        SequenceFragmentation sequence{seqSlotIdx};
+        for (auto const& beamBlockIds : cacheBlockIds)
+        {
+            auto const numSlots = static_cast<SizeType32>(beamBlockIds.size()) * mTokensPerBlock;
+            sequence.numAllocatedTokenSlots += numSlots;
+            sequence.numUnusedTokenSlots += std::max(numSlots - numTokens, 0);
+            mCurrentBlocks.insert(beamBlockIds.begin(), beamBlockIds.end());
+        }
+        sequence.fragmentation = sequence.numAllocatedTokenSlots > 0
+            ? static_cast<float>(sequence.numUnusedTokenSlots) / static_cast<float>(sequence.numAllocatedTokenSlots)
+            : 0.f;
+        mNumAllocatedTokenSlots += sequence.numAllocatedTokenSlots;
+        mStats.numUnusedTokenSlots += sequence.numUnusedTokenSlots;
+        mStats.sequences.push_back(sequence);
+
+        // A slot is taken by a new sequence if it was free before or its first block changed.
+        auto const firstBlock = cacheBlockIds.empty() || cacheBlockIds.front().empty()
+            ? std::optional<IdType>{}
+            : std::optional<IdType>{cacheBlockIds.front().front()};
+        auto const previous = mSequenceFirstBlocks.find(seqSlotIdx);
+        if (previous == mSequenceFirstBlocks.end() || previous->second != firstBlock)
+        {
+            mReuseDepths.add((std::max(numPrepopulatedTokens, 0) + mTokensPerBlock - 1) / mTokensPerBlock);
+        }
+        mCurrentSequenceFirstBlocks[seqSlotIdx] = firstBlock;
+    }
+
+    //! \brief End the iteration, return its stats and reset all counters.
+    [[nodiscard]] KvCacheTelemetryStats takeStats()
+    {
+        for (auto it = mLiveBlocks.begin(); it != mLiveBlocks.end();)
+        {
+            if (mCurrentBlocks.count(it->first) == 0)
+            {
+                mBlockLifetimes.add(mIteration - it->second);
+                it = mLiveBlocks.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        for (auto const blockId : mCurrentBlocks)
+        {
+            mLiveBlocks.try_emplace(blockId, mIteration);
+        }
+        mCurrentBlocks.clear();
+        mSequenceFirstBlocks = std::move(mCurrentSequenceFirstBlocks);
+        mCurrentSequenceFirstBlocks.clear();
+
+        auto stats = std::move(mStats);
+        stats.blockLifetimeHistogram = mBlockLifetimes.getCounts();
+        stats.reuseDepthHistogram = mReuseDepths.getCounts();
+        stats.fragmentation = mNumAllocatedTokenSlots > 0
+            ? static_cast<float>(stats.numUnusedTokenSlots) / static_cast<float>(mNumAllocatedTokenSlots)
+            : 0.f;
+
+        mStats = KvCacheTelemetryStats{};
+        mBlockLifetimes.reset();
+        mReuseDepths.reset();
+        mNumAllocatedTokenSlots = 0;
+        ++mIteration;
+        return stats;
+    }
+
+    [[nodiscard]] IterationType getIteration() const noexcept
+    {
+        return mIteration;
+    }
+
+private:
+    SizeType32 mTokensPerBlock;
+    IterationType mIteration;
+    // Blocks of the previous iterations and the iteration they were first seen in
+    std::unordered_map<IdType, IterationType> mLiveBlocks;
+    std::unordered_set<IdType> mCurrentBlocks;
+    // First block of the sequence in each slot, to tell new sequences from the ones of the previous iteration
+    std::unordered_map<SizeType32, std::optional<IdType>> mSequenceFirstBlocks;
+    std::unordered_map<SizeType32, std::optional<IdType>> mCurrentSequenceFirstBlocks;
+    Log2Histogram mBlockLifetimes;
+    Log2Histogram mReuseDepths;
+    SizeType32 mNumAllocatedTokenSlots{0};
+    KvCacheTelemetryStats mStats;
+};
+
+//! \brief Serialize the telemetry of one iteration to a JSON object, e.g. to log it next to the iteration stats of
+//! executor::JsonSerialization::toJsonStr.
+[[nodiscard]] inline std::string toJsonStr(KvCacheTelemetryStats const& stats)
+{
+    auto const writeList = [](std::ostringstream& os, auto const& values)
+    {
+        os << '[';
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            os << (i > 0 ? "," : "") << values[i];
+        }
+        os << ']';
+    };
+    std::ostringstream os;
+    os << "{\"blockLifetimeHistogram\":";
+    writeList(os, stats.blockLifetimeHistogram);
+    os << ",\"fragmentation\":" << stats.fragmentation << ",\"numUnusedTokenSlots\":" << stats.numUnusedTokenSlots
+       << ",\"reuseDepthHistogram\":";
+    writeList(os, stats.reuseDepthHistogram);
+    os << ",\"sequences\":[";
+    for (std::size_t i = 0; i < stats.sequences.size(); ++i)
+    {
+        auto const& sequence = stats.sequences[i];
+        os << (i > 0 ? "," : "") << "{\"fragmentation\":" << sequence.fragmentation
+           << ",\"numAllocatedTokenSlots\":" << sequence.numAllocatedTokenSlots
+           << ",\"numUnusedTokenSlots\":" << sequence.numUnusedTokenSlots
+           << ",\"seqSlotIdx\":" << sequence.seqSlotIdx << '}';
+    }
+    os << "]}";
+    return os.str();
+}
+
+} // namespace tensorrt_llm::batch_manager::kv_cache_manager
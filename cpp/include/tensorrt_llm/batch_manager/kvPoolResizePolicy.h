@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Decides the size of a resizable primary KV cache pool, see runtime::VirtualMemoryPool, from the free device
+//! memory, so that the pool takes the memory other users leave and gives it back when they need it.
+//! \details The pool is kept such that the free device memory stays between `lowFreeFraction` and `highFreeFraction`
+//! of the total. Outside of that band the pool is resized to bring the free memory back to `targetFreeFraction`, by
+//! at most `maxStepBlocks` at a time. The pool only grows after `growPatience` consecutive decisions with free memory
+//! above the band, so that a transient release of memory, e.g. by the caching allocator of another engine, does not
+//! cause a grow followed by a shrink. It shrinks at once, but only by the free blocks at the end of the pool, which
+//! the block manager no longer uses.
+class KvPoolResizePolicy
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    struct Config
+    {
+        float lowFreeFraction{0.05f};
+        float targetFreeFraction{0.1f};
+        float highFreeFraction{0.15f};
+        SizeType32 minNumBlocks{1};
+        SizeType32 maxNumBlocks{0};
+        SizeType32 maxStepBlocks{1024};
+        SizeType32 growPatience{3};
+    };
+
+    KvPoolResizePolicy(std::size_t blockSizeInBytes, Config const& config)
+        : mBlockSizeInBytes{blockSizeInBytes}
+        , mConfig{config}
+    {
+        TLLM_CHECK(mBlockSizeInBytes > 0);
+        TLLM_CHECK(0.f <= mConfig.lowFreeFraction && mConfig.lowFreeFraction <= mConfig.targetFreeFraction
+            && mConfig.targetFreeFraction <= mConfig.highFreeFraction && mConfig.highFreeFraction < 1.f);
+        TLLM_CHECK(0 < mConfig.minNumBlocks && mConfig.minNumBlocks <= mConfig.maxNumBlocks);
+        TLLM_CHECK(mConfig.maxStepBlocks > 0);
+        TLLM_CHECK(mConfig.growPatience > 0);
+    }
+
+    //! \brief The number of blocks of the pool after this decision.
+    //! \param freeBytes free device memory, e.g. from cudaMemGetInfo
+    //! \param totalBytes total device memory
+    //! \param numBlocks current number of blocks of the pool
+    //! \param numFreeTailBlocks blocks at the end of the pool that are not used, the most the pool can shrink by
+    [[nodiscard]] SizeType32 decide(
+        std::size_t freeBytes, std::size_t totalBytes, SizeType32 numBlocks, SizeType32 numFreeTailBlocks)
+    {
+        TLLM_CHECK(freeBytes <= totalBytes);
+        TLLM_CHECK(0 <= numFreeTailBlocks && numFreeTailBlocks <= numBlocks);
+        auto const freeFraction = static_cast<double>(freeBytes) / static_cast<double>(totalBytes);
+        auto const targetFreeBytes = static_cast<std::int64_t>(
+            static_cast<double>(mConfig.targetFreeFraction) * static_cast<double>(totalBytes));
+        auto const blockSize = static_cast<std::int64_t>(mBlockSizeInBytes);
+
+        if (freeFraction > mConfig.highFreeFraction && numBlocks < mConfig.maxNumBlocks)
+        {
+            if (++mNumGrowSignals < mConfig.growPatience)
+            {
+                return numBlocks;
+            }
+            mNumGrowSignals = 0;
+            auto const excessBlocks = (static_cast<std::int64_t>(freeBytes) - targetFreeBytes) / blockSize;
+            auto const grow = std::min<std::int64_t>({excessBlocks, mConfig.maxStepBlocks,
+                static_cast<std::int64_t>(mConfig.maxNumBlocks) - numBlocks});
+            return numBlocks + static_cast<SizeType32>(std::max<std::int64_t>(grow, 0));
+        }
+        mNumGrowSignals = 0;
+
+        if (freeFraction < mConfig.lowFreeFraction && numBlocks > mConfig.minNumBlocks)
+        {
+            // Round up, the memory of a partial block is still needed
+            auto const missingBlocks
+                = (targetFreeBytes - static_cast<std::int64_t>(freeBytes) + blockSize - 1) / blockSize;
+            auto const shrink = std::min<std::int64_t>({missingBlocks, mConfig.maxStepBlocks, numFreeTailBlocks,
+                static_cast<std::int64_t>(numBlocks) - mConfig.minNumBlocks});
+            return numBlocks - static_cast<SizeType32>(std::max<std::int64_t>(shrink, 0));
+        }
+        return numBlocks;
+    }
+
+    [[nodiscard]] Config const& getConfig() const noexcept
+    {
+        return mConfig;
+    }
+
+private:
+    std::size_t mBlockSizeInBytes;
+    Config mConfig;
+    SizeType32 mNumGrowSignals{0};
+};
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Selects the tokens a sequence keeps when its KV cache is compressed to a budget, as in H2O and SnapKV.
+//! \details Each head group keeps the first `numSinkTokens` and the last `numRecentTokens` tokens, plus the most
+//! important of the tokens between them, see kernels::invokeAccumulateKvTokenImportance. All head groups keep the same
+//! number of tokens so that the sequence keeps the same blocks. The cache is only compacted, see
+//! kernels::invokeCompactKvCache, once it exceeds the budget by a block, so that each compaction releases blocks and
+//! the importance accumulates over a block of steps in between.
+class KvTokenEvictionPolicy
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    struct Config
+    {
+        //! Tokens each sequence keeps after a compaction.
+        SizeType32 tokenBudget{0};
+        SizeType32 numSinkTokens{4};
+        SizeType32 numRecentTokens{64};
+        SizeType32 tokensPerBlock{0};
+    };
+
+    explicit KvTokenEvictionPolicy(Config const& config)
+        : mConfig{config}
+    {
+        TLLM_CHECK(mConfig.tokensPerBlock > 0);
+        TLLM_CHECK(mConfig.numSinkTokens >= 0 && mConfig.numRecentTokens >= 0);
+        TLLM_CHECK_WITH_INFO(mConfig.numSinkTokens + mConfig.numRecentTokens <= mConfig.tokenBudget,
+            "The token budget %d does not cover %d sink and %d recent tokens", mConfig.tokenBudget,
+            mConfig.numSinkTokens, mConfig.numRecentTokens);
+    }
+
+    //! \brief Whether a sequence with `numTokens` tokens in its KV cache should be compacted.
+    [[nodiscard]] bool needsCompaction(SizeType32 numTokens) const noexcept
+    {
+        return numTokens - mConfig.tokenBudget >= mConfig.tokensPerBlock;
+    }
+
+    //! \brief Number of blocks a compaction of a sequence with `numTokens` tokens releases.
+    [[nodiscard]] SizeType32 getNumReleasedBlocks(SizeType32 numTokens) const noexcept
+    {
+        auto const numBlocks
+            = [this](SizeType32 n) { return (n + mConfig.tokensPerBlock - 1) / mConfig.tokensPerBlock; };
+        return std::max(numBlocks(numTokens) - numBlocks(mConfig.tokenBudget), 0);
+    }
+
+    //! \brief The tokens each head group keeps.
+    //! \param importance host buffer [numKvHeads, stride], importance of the tokens of each head group.
+    //! \param numTokens number of tokens in the KV cache, more than the budget.
+    //! \return [numKvHeads, tokenBudget], ascending indices of the kept tokens of each head group, as expected by
+    //! kernels::invokeCompactKvCache.
+    [[nodiscard]] std::vector<SizeType32> selectTokens(
+        float const* importance, SizeType32 stride, SizeType32 numKvHeads, SizeType32 numTokens) const
+    {
+        TLLM_CHECK(numTokens > mConfig.tokenBudget && numTokens <= stride);
+        auto const budget = mConfig.tokenBudget;
+        auto const middleBegin = mConfig.numSinkTokens;
+        auto const middleEnd = numTokens - mConfig.numRecentTokens;
+        auto const numMiddleKept = budget - mConfig.numSinkTokens - mConfig.numRecentTokens;
+
+        std::vector<SizeType32> kept(static_cast<std::size_t>(numKvHeads) * budget);
+        std::vector<SizeType32> candidates(middleEnd - middleBegin);
+        for (SizeType32 hi = 0; hi < numKvHeads; ++hi)
+        {
+            auto const* headImportance = importance + static_cast<std::size_t>(hi) * stride;
+            auto headKept = kept.begin() + static_cast<std::ptrdiff_t>(hi) * budget;
+            std::iota(headKept, headKept + mConfig.numSinkTokens, 0);
+            // The most important tokens first, the earlier ones on ties.
+            std::iota(candidates.begin(), candidates.end(), middleBegin);
+            std::nth_element(candidates.begin(), candidates.begin() + numMiddleKept, candidates.end(),
+                [headImportance](SizeType32 lhs, SizeType32 rhs)
+                {
+                    return headImportance[lhs] > headImportance[rhs]
+                        || (headImportance[lhs] == headImportance[rhs] && lhs < rhs);
+                });
+            auto const middleKept = headKept + mConfig.numSinkTokens;
+            std::copy_n(candidates.begin(), numMiddleKept, middleKept);
+            std::sort(middleKept, middleKept + numMiddleKept);
+            std::iota(middleKept + numMiddleKept, headKept + budget, middleEnd);
+        }
+        return kept;
+    }
+
+    [[nodiscard]] Config const& getConfig() const noexcept
+    {
+        return mConfig;
+    }
+
+private:
+    Config mConfig;
+};
+
+} // namespace tensorrt_llm::batch_manager
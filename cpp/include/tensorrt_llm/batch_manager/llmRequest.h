@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
 #include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/executor/executor.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
@@ -657,6 +658,18 @@ public:
         mEncoderHiddenStates = std::move(manager.emptyTensor(runtime::MemoryType::kGPU, dataType));
     }
 
+    //! \brief Use the encoder output of an earlier request with the same encoder input, see EncoderOutputCache. The
+    //! tensor is shared and must not be written.
+    void setEncoderOutput(TensorPtr encoderOutput)
+    {
+        mEncoderOutput = std::move(encoderOutput);
+    }
+
+    void setEncoderHiddenStates(TensorPtr encoderHiddenStates)
+    {
+        mEncoderHiddenStates = std::move(encoderHiddenStates);
+    }
+
     void freeEncoderOutputBuffers()
     {
         TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
@@ -1159,6 +1172,38 @@ public:
         TensorPtr gpuLoraWeights = manager.copyFrom(*mLoraWeights.value(), runtime::MemoryType::kGPU);
         mLoraWeights = gpuLoraWeights;
     }
+
+    //! \brief FNV-1a hash of the content of the prompt embedding table, std::nullopt without a table or once the
+    //! table is on the GPU, see movePromptEmbeddingTableToGpu.
+    [[nodiscard]] std::optional<std::uint64_t> getPromptEmbeddingTableHash() const
+    {
+        if (!mPromptEmbeddingTable.has_value()
+            || mPromptEmbeddingTable.value()->getMemoryType() == runtime::MemoryType::kGPU)
+        {
+            return std::nullopt;
+        }
+        auto const& table = *mPromptEmbeddingTable.value();
+        auto const* bytes = static_cast<unsigned char const*>(table.data());
+        std::uint64_t hash = 0xcbf29ce484222325ULL;
+        for (std::size_t i = 0; i < table.getSizeInBytes(); ++i)
+        {
+            hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    //! \brief Seed of the prefix hashes of the blocks of the request for KV cache reuse, the blocks are only shared
+    //! with the requests of the same LoRA task and prompt embedding table, see PrefixHashState::makeSeed.
+    [[nodiscard]] kv_cache_manager::PrefixHashType getKvCacheReuseSeed() const
+    {
+        std::optional<std::uint64_t> promptTableHash;
+        if (mPromptEmbeddingTable.has_value())
+        {
+            // A table of unknown content gets a seed of its own, the request shares no blocks then
+            promptTableHash = getPromptEmbeddingTableHash().value_or(~mRequestId);
+        }
+        return kv_cache_manager::PrefixHashState::makeSeed(mLoraTaskId, promptTableHash);
+    }
 };
 
 } // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Priority of a request, in [0, 1], higher runs first. The default is executor::Request::kDefaultPriority.
+using PriorityType = tensorrt_llm::executor::PriorityType;
+
+//! \brief How the KV cache of a preempted request is freed.
+enum class PreemptionMode : std::uint8_t
+{
+    //! Offload the blocks to the secondary pool and onboard them on resume.
+    kSWAP = 0,
+    //! Drop the blocks and recompute the context on resume.
+    kRECOMPUTE = 1,
+};
+
+//! \brief Running or waiting request as seen by the preemption policy.
+struct PreemptionCandidate
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using RequestIdType = std::uint64_t;
+
+    RequestIdType requestId;
+    PriorityType priority;
+    //! Position in arrival order, smaller arrived earlier.
+    std::uint64_t arrivalIndex;
+    //! Blocks allocated to the request.
+    SizeType32 numBlocks;
+    //! Tokens in the KV cache of the request, recomputed on resume with PreemptionMode::kRECOMPUTE.
+    SizeType32 numTokens;
+};
+
+//! \brief Order a queue of waiting requests: higher priority first, arrival order within a priority.
+inline void sortByPriority(std::vector<PreemptionCandidate>& queue)
+{
+    std::stable_sort(queue.begin(), queue.end(),
+        [](PreemptionCandidate const& lhs, PreemptionCandidate const& rhs)
+        {
+            return lhs.priority != rhs.priority ? lhs.priority > rhs.priority : lhs.arrivalIndex < rhs.arrivalIndex;
+        });
+}
+
+//! \brief Select running requests to preempt so that `numBlocksNeeded` blocks become available to a request of
+//! priority `priority`.
+//! \details Only requests of strictly lower priority are preempted: lowest priority first, most recent arrival first
+//! within a priority, which keeps the progress of older requests. If the blocks can't be freed, nothing is preempted.
+//! \return Ids of the requests to preempt.
+inline std::vector<PreemptionCandidate::RequestIdType> selectRequestsToPreempt(
+    std::vector<PreemptionCandidate> running, tensorrt_llm::runtime::SizeType32 numBlocksNeeded, PriorityType priority)
+{
+    std::vector<PreemptionCandidate::RequestIdType> preempted;
+    if (numBlocksNeeded <= 0)
+    {
+        return preempted;
+    }
+    running.erase(std::remove_if(running.begin(), running.end(),
+                      [priority](PreemptionCandidate const& candidate) { return candidate.priority >= priority; }),
+        running.end());
+    std::sort(running.begin(), running.end(),
+        [](PreemptionCandidate const& lhs, PreemptionCandidate const& rhs)
+        {
+            return lhs.priority != rhs.priority ? lhs.priority < rhs.priority : lhs.arrivalIndex > rhs.arrivalIndex;
+        });
+    tensorrt_llm::runtime::SizeType32 numFreed{0};
+    for (auto const& candidate : running)
+    {
+        if (numFreed >= numBlocksNeeded)
+        {
+            break;
+        }
+        preempted.push_back(candidate.requestId);
+        numFreed += candidate.numBlocks;
+    }
+    if (numFreed < numBlocksNeeded)
+    {
+        preempted.clear();
+    }
+    return preempted;
+}
+
+//! \brief Choose between swapping and recomputing the KV cache of a preempted request.
+//! \details Swapping costs the transfer of the blocks in both directions, recomputing costs a context phase over all
+//! tokens of the request. Swapping requires room in the secondary pool.
+//! \param bytesPerBlock Size of one block, all layers.
+//! \param hostBandwidthBytesPerMs Bandwidth of the transfers between the pools.
+//! \param msPerContextToken Estimated cost of recomputing one token, e.g. from IterationCostModel.
+inline PreemptionMode choosePreemptionMode(PreemptionCandidate const& candidate,
+    tensorrt_llm::runtime::SizeType32 numFreeSecondaryBlocks, double bytesPerBlock, double hostBandwidthBytesPerMs,
+    double msPerContextToken)
+{
+    TLLM_CHECK(hostBandwidthBytesPerMs > 0.0);
+    if (candidate.numBlocks > numFreeSecondaryBlocks)
+    {
+        return PreemptionMode::kRECOMPUTE;
+    }
+    auto const swapMs = 2.0 * candidate.numBlocks * bytesPerBlock / hostBandwidthBytesPerMs;
+    auto const recomputeMs = candidate.numTokens * msPerContextToken;
+    return swapMs <= recomputeMs ? PreemptionMode::kSWAP : PreemptionMode::kRECOMPUTE;
+}
+
+} // namespace tensorrt_llm::batch_manager
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Runs the common prefix of concurrent context requests once.
+//! \details Blocks become reusable only once the request that computes them stores them, so requests with the same
+//! prefix that arrive together would all compute it. Each request is added on arrival. A request whose prefix shares
+//! at least minSharedBlocks full blocks with the prefix of an earlier request in flight follows that request, its
+//! leader: it is held back until the leader reported the shared blocks as stored, then its context phase reuses them
+//! through the block reuse lookup. The blocks a request adds beyond its leader can be followed in turn. Prefixes are
+//! matched by the chained block hashes of PrefixHashState, so only requests with the same reuse seed are coalesced.
+//! The capacity scheduler does not consult the coalescer: the owner of the scheduling loop skips the context requests
+//! that are not isReady and reports the blocks stored for reuse with onBlocksStored.
+class PrefillCoalescer
+{
+public:
+    using SizeType32 = runtime::SizeType32;
+    using RequestIdType = std::uint64_t;
+    using VecTokens = std::vector<runtime::TokenIdType>;
+    using PrefixHashState = kv_cache_manager::PrefixHashState;
+    using PrefixHashType = kv_cache_manager::PrefixHashType;
+
+    struct Stats
+    {
+        //! Requests that followed a leader
+        SizeType32 numCoalesced{0};
+        //! Context tokens the followers did not compute themselves
+        std::int64_t numSharedTokens{0};
+    };
+
+    //! \param minSharedBlocks Requests are only held back for a shared prefix of at least this many blocks.
+    explicit PrefillCoalescer(SizeType32 tokensPerBlock, SizeType32 minSharedBlocks = 1)
+        : mTokensPerBlock{tokensPerBlock}
+        , mMinSharedBlocks{minSharedBlocks}
+    {
+        TLLM_CHECK(mTokensPerBlock > 0);
+        TLLM_CHECK(mMinSharedBlocks > 0);
+    }
+
+    //! \brief Add a context request, in arrival order.
+    //! \param seed Seed of the prefix hashes of the request, LlmRequest::getKvCacheReuseSeed.
+    //! \return The leader of the request, std::nullopt if it computes its prefix itself.
+    std::optional<RequestIdType> add(
+        RequestIdType requestId, VecTokens const& tokens, PrefixHashType seed = PrefixHashState::kRootHash)
+    {
+        TLLM_CHECK_WITH_INFO(mRequests.count(requestId) == 0, "Request %lu was already added",
+            static_cast<unsigned long>(requestId));
+        auto& request = mRequests[requestId];
+        // The last token is always computed by the context phase, as in the reuse lookup
+        auto const numBlocks = std::max(static_cast<SizeType32>(tokens.size()) - 1, 0) / mTokensPerBlock;
+        PrefixHashState state{mTokensPerBlock, seed};
+        state.extend(tokens);
+        request.blockHashes.reserve(numBlocks);
+        for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+        {
+            request.blockHashes.push_back(state.getBlockHash(bi));
+        }
+        attach(requestId, request);
+        return request.leader;
+    }
+
+    //! \brief Whether the request may run its context phase, false while it waits for the blocks of its leader.
+    [[nodiscard]] bool isReady(RequestIdType requestId) const
+    {
+        auto const it = mRequests.find(requestId);
+        if (it == mRequests.end() || !it->second.leader)
+        {
+            return true;
+        }
+        auto const& leader = mRequests.at(it->second.leader.value());
+        return leader.numStoredBlocks >= it->second.numSharedBlocks;
+    }
+
+    //! \brief The first numStoredTokens tokens of the request are in blocks stored for reuse.
+    void onBlocksStored(RequestIdType requestId, SizeType32 numStoredTokens)
+    {
+        auto const it = mRequests.find(requestId);
+        if (it != mRequests.end())
+        {
+            it->second.numStoredBlocks = std::max(it->second.numStoredBlocks, numStoredTokens / mTokensPerBlock);
+        }
+    }
+
+    //! \brief Remove a finished, cancelled or preempted request.
+    //! \details Followers still waiting for its blocks follow another request with their prefix or compute it
+    //! themselves, in arrival order.
+    void remove(RequestIdType requestId)
+    {
+        auto const it = mRequests.find(requestId);
+        if (it == mRequests.end())
+        {
+            return;
+        }
+        auto request = std::move(it->second);
+        mRequests.erase(it);
+        for (auto const hash : request.blockHashes)
+        {
+            auto const ownerIt = mBlockOwners.find(hash);
+            if (ownerIt != mBlockOwners.end() && ownerIt->second == requestId)
+            {
+                mBlockOwners.erase(ownerIt);
+            }
+        }
+        if (request.leader)
+        {
+            auto const leaderIt = mRequests.find(request.leader.value());
+            if (leaderIt != mRequests.end())
+            {
+                auto& followers = leaderIt->second.followers;
+                followers.erase(std::remove(followers.begin(), followers.end(), requestId), followers.end());
+            }
+        }
+        for (auto const followerId : request.followers)
+        {
+            auto& follower = mRequests.at(followerId);
+            follower.leader.reset();
+            if (request.numStoredBlocks >= follower.numSharedBlocks)
+            {
+                // The shared blocks are stored, the follower reuses them
+                follower.numSharedBlocks = 0;
+                continue;
+            }
+            mStats.numSharedTokens -= static_cast<std::int64_t>(follower.numSharedBlocks) * mTokensPerBlock;
+            --mStats.numCoalesced;
+            follower.numSharedBlocks = 0;
+            attach(followerId, follower);
+        }
+    }
+
+    [[nodiscard]] std::optional<RequestIdType> getLeader(RequestIdType requestId) const
+    {
+        auto const it = mRequests.find(requestId);
+        return it != mRequests.end() ? it->second.leader : std::nullopt;
+    }
+
+    [[nodiscard]] SizeType32 getNumRequests() const noexcept
+    {
+        return static_cast<SizeType32>(mRequests.size());
+    }
+
+    [[nodiscard]] Stats const& getStats() const noexcept
+    {
+        return mStats;
+    }
+
+private:
+    struct Request
+    {
+        std::vector<PrefixHashType> blockHashes;
+        std::optional<RequestIdType> leader;
+        SizeType32 numSharedBlocks{0};
+        SizeType32 numStoredBlocks{0};
+        std::vector<RequestIdType> followers;
+    };
+
+    //! \brief Follow the request that owns the longest prefix of the blocks of `request`, and own the blocks beyond it.
+    void attach(RequestIdType requestId, Request& request)
+    {
+        // The hashes are chained, the owner of block i has the whole prefix up to block i
+        SizeType32 numShared{0};
+        std::optional<RequestIdType> owner;
+        for (auto const hash : request.blockHashes)
+        {
+            auto const it = mBlockOwners.find(hash);
+            if (it == mBlockOwners.end() || it->second == requestId)
+            {
+                break;
+            }
+            owner = it->second;
+            ++numShared;
+        }
+        if (owner && numShared >= mMinSharedBlocks)
+        {
+            request.leader = owner;
+            request.numSharedBlocks = numShared;
+            mRequests.at(owner.value()).followers.push_back(requestId);
+            ++mStats.numCoalesced;
+            mStats.numSharedTokens += static_cast<std::int64_t>(numShared) * mTokensPerBlock;
+        }
+        for (auto bi = static_cast<std::size_t>(numShared); bi < request.blockHashes.size(); ++bi)
+        {
+            mBlockOwners.emplace(request.blockHashes[bi], requestId);
+        }
+    }
+
+    SizeType32 mTokensPerBlock;
+    SizeType32 mMinSharedBlocks;
+    std::unordered_map<RequestIdType, Request> mRequests;
+    //! Request computing each block of a prefix in flight
+    std::unordered_map<PrefixHashType, RequestIdType> mBlockOwners;
+    Stats mStats;
+};
+
+} // namespace tensorrt_llm::batch_manager
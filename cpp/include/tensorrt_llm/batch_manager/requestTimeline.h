@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <chrono>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Lifecycle transitions of a request, in the order they usually happen
+enum class RequestTimingEvent
+{
+    //! \brief The request was received by the executor
+    kENQUEUED,
+    //! \brief The request was scheduled for the first time
+    kFIRST_SCHEDULED,
+    //! \brief A context chunk, or the whole context, was processed
+    kCONTEXT_CHUNK,
+    //! \brief The request was paused, e.g. to free KV cache blocks for other requests
+    kPAUSED,
+    //! \brief A paused request was scheduled again
+    kRESUMED,
+    //! \brief The request waited for KV cache blocks to be onboarded from secondary memory
+    kKV_ONBOARD_WAIT,
+    //! \brief The request waited for its LoRA weights to be loaded into the device cache
+    kLORA_LOAD_WAIT,
+    //! \brief The first output tokens were ready to be returned
+    kFIRST_TOKEN,
+    //! \brief The last output tokens were ready to be returned
+    kFINISHED,
+};
+
+//! \brief A lifecycle transition of a request
+struct RequestTimelineEvent
+{
+    RequestTimingEvent event;
+    //! \brief Time since the request was enqueued
+    std::chrono::microseconds time;
+    //! \brief For kCONTEXT_CHUNK, the number of context tokens of the chunk
+    runtime::SizeType32 numTokens{0};
+    //! \brief For kKV_ONBOARD_WAIT and kLORA_LOAD_WAIT, the time waited before `time`
+    std::chrono::microseconds waitTime{0};
+};
+
+//! \brief Timestamps of the lifecycle transitions of a request and where its latency went
+struct RequestTimeline
+{
+    //! \brief The transitions in the order they were recorded
+    std::vector<RequestTimelineEvent> events;
+    //! \brief From enqueued to first scheduled
+    std::chrono::microseconds queueTime{0};
+    //! \brief From first scheduled to the first token, including pauses and waits in the context phase
+    std::chrono::microseconds contextTime{0};
+    //! \brief From the first token to the last one
+    std::chrono::microseconds generationTime{0};
+    //! \brief Total time between a pause and the following resume
+    std::chrono::microseconds pausedTime{0};
+    //! \brief Total time waited for KV cache blocks to be onboarded
+    std::chrono::microseconds kvOnboardWaitTime{0};
+    //! \brief Total time waited for LoRA weights to be loaded
+    std::chrono::microseconds loraLoadWaitTime{0};
+};
+
+//! \brief Records the lifecycle transitions of a request as they happen, into a RequestTimeline.
+//! \details Repeated transitions keep their first occurrence where only one makes sense: a request that is already
+//! paused is not paused again, and only the first response records the first token. The recorder is driven by the
+//! owner of the request loop. The executor and its LlmRequest are prebuilt and do not record timelines, so the timeline
+//! is not part of executor::Result.
+class RequestTimelineRecorder
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using TimePoint = Clock::time_point;
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using Event = RequestTimingEvent;
+
+    explicit RequestTimelineRecorder(TimePoint enqueueTime = Clock::now())
+        : mEnqueueTime(enqueueTime)
+    {
+        add(Event::kENQUEUED, enqueueTime);
+    }
+
+    //! \brief The request is scheduled in an iteration. Records the first schedule and the resume after a pause.
+    void onScheduled(TimePoint now = Clock::now())
+    {
+        if (mPausedSince)
+        {
+            add(Event::kRESUMED, now);
+            mTimeline.pausedTime += sinceEnqueue(now) - sinceEnqueue(mPausedSince.value());
+            mPausedSince.reset();
+        }
+        else if (!mFirstScheduled)
+        {
+            add(Event::kFIRST_SCHEDULED, now);
+            mFirstScheduled = now;
+        }
+    }
+
+    //! \brief A context chunk of numTokens tokens, or the whole context, was processed.
+    void onContextChunk(SizeType32 numTokens, TimePoint now = Clock::now())
+    {
+        add(Event::kCONTEXT_CHUNK, now).numTokens = numTokens;
+    }
+
+    void onPaused(TimePoint now = Clock::now())
+    {
+        if (!mPausedSince)
+        {
+            add(Event::kPAUSED, now);
+            mPausedSince = now;
+        }
+    }
+
+    //! \brief The request could not proceed for waitTime, ending now, waiting for KV cache onboarding or LoRA loading.
+    void onWait(Event event, std::chrono::microseconds waitTime, TimePoint now = Clock::now())
+    {
+        TLLM_CHECK_WITH_INFO(event == Event::kKV_ONBOARD_WAIT || event == Event::kLORA_LOAD_WAIT,
+            "Only KV cache onboarding and LoRA loading are waits");
+        add(event, now).waitTime = waitTime;
+        (event == Event::kKV_ONBOARD_WAIT ? mTimeline.kvOnboardWaitTime : mTimeline.loraLoadWaitTime) += waitTime;
+    }
+
+    //! \brief Output tokens of the request are ready to be returned.
+    void onResponse(bool isFinal, TimePoint now = Clock::now())
+    {
+        if (!mFirstToken)
+        {
+            add(Event::kFIRST_TOKEN, now);
+            mFirstToken = now;
+        }
+        if (isFinal && !mFinished)
+        {
+            add(Event::kFINISHED, now);
+            mFinished = now;
+        }
+    }
+
+    //! \brief The events so far and the breakdown of the phases that are complete.
+    [[nodiscard]] RequestTimeline getTimeline() const
+    {
+        auto timeline = mTimeline;
+        if (mFirstScheduled)
+        {
+            timeline.queueTime = sinceEnqueue(mFirstScheduled.value());
+            if (mFirstToken)
+            {
+                timeline.contextTime = sinceEnqueue(mFirstToken.value()) - timeline.queueTime;
+            }
+        }
+        if (mFirstToken && mFinished)
+        {
+            timeline.generationTime = sinceEnqueue(mFinished.value()) - sinceEnqueue(mFirstToken.value());
+        }
+        return timeline;
+    }
+
+private:
+    [[nodiscard]] std::chrono::microseconds sinceEnqueue(TimePoint time) const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(time - mEnqueueTime);
+    }
+
+    RequestTimelineEvent& add(Event event, TimePoint time)
+    {
+        return mTimeline.events.emplace_back(RequestTimelineEvent{event, sinceEnqueue(time)});
+    }
+
+    TimePoint mEnqueueTime;
+    std::optional<TimePoint> mFirstScheduled;
+    std::optional<TimePoint> mPausedSince;
+    std::optional<TimePoint> mFirstToken;
+    std::optional<TimePoint> mFinished;
+    RequestTimeline mTimeline;
+};
+
+} // namespace tensorrt_llm::batch_manager
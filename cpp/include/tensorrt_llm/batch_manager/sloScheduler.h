@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::batch_manager
+{
+
+//! \brief Latency targets of a request.
+struct RequestSlo
+{
+    //! Time to first token, relative to the arrival of the request.
+    std::optional<std::chrono::milliseconds> ttftDeadline{std::nullopt};
+    //! Time per output token once the request is generating.
+    std::optional<double> tpotTargetMs{std::nullopt};
+};
+
+//! \brief Estimates the latency of an iteration as overhead + a * contextTokens + b * generationRequests.
+//! \details The coefficients are fitted online to measured iteration latencies (IterationStats::iterLatencyMS) with
+//! recursive least squares. The forgetting factor lets the fit track changes of the load.
+class IterationCostModel
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+    explicit IterationCostModel(double overheadMs = 5.0, double msPerContextToken = 0.05,
+        double msPerGenerationRequest = 0.1, double forgettingFactor = 0.98)
+        : mTheta{overheadMs, msPerContextToken, msPerGenerationRequest}
+        , mP{}
+        , mForgettingFactor{forgettingFactor}
+    {
+        TLLM_CHECK(0.0 < mForgettingFactor && mForgettingFactor <= 1.0);
+        for (std::size_t i = 0; i < kNumFeatures; ++i)
+        {
+            mP[i][i] = kInitialCovariance;
+        }
+    }
+
+    void update(SizeType32 numContextTokens, SizeType32 numGenerationRequests, double iterLatencyMs)
+    {
+        auto const x = features(numContextTokens, numGenerationRequests);
+        std::array<double, kNumFeatures> px{};
+        for (std::size_t i = 0; i < kNumFeatures; ++i)
+        {
+            for (std::size_t j = 0; j < kNumFeatures; ++j)
+            {
+                px[i] += mP[i][j] * x[j];
+            }
+        }
+        double xpx{0.0};
+        double prediction{0.0};
+        for (std::size_t i = 0; i < kNumFeatures; ++i)
+        {
+            xpx += x[i] * px[i];
+            prediction += mTheta[i] * x[i];
+        }
+        auto const denominator = mForgettingFactor + xpx;
+        auto const error = iterLatencyMs - prediction;
+        for (std::size_t i = 0; i < kNumFeatures; ++i)
+        {
+            mTheta[i] += px[i] / denominator * error;
+        }
+        // P is symmetric, so x^T P = (P x)^T
+        for (std::size_t i = 0; i < kNumFeatures; ++i)
+        {
+            for (std::size_t j = 0; j < kNumFeatures; ++j)
+            {
+                mP[i][j] = (mP[i][j] - px[i] * px[j] / denominator) / mForgettingFactor;
+            }
+        }
+    }
+
+    [[nodiscard]] double estimate(SizeType32 numContextTokens, SizeType32 numGenerationRequests) const
+    {
+        return getOverheadMs() + getMsPerContextToken() * numContextTokens
+            + getMsPerGenerationRequest() * numGenerationRequests;
+    }
+
+    //! \brief Largest number of context tokens for which the estimated latency stays within `latencyBudgetMs`.
+    [[nodiscard]] SizeType32 maxContextTokens(SizeType32 numGenerationRequests, double latencyBudgetMs) const
+    {
+        auto const remainingMs = latencyBudgetMs - estimate(0, numGenerationRequests);
+        if (remainingMs <= 0.0)
+        {
+            return 0;
+        }
+        auto const msPerToken = getMsPerContextToken();
+        if (msPerToken <= 0.0)
+        {
+            return std::numeric_limits<SizeType32>::max();
+        }
+        return static_cast<SizeType32>(
+            std::min(remainingMs / msPerToken, static_cast<double>(std::numeric_limits<SizeType32>::max())));
+    }
+
+    // Coefficients are clamped at zero, a noisy fit must not predict negative costs.
+    [[nodiscard]] double getOverheadMs() const noexcept
+    {
+        return std::max(mTheta[0], 0.0);
+    }
+
+    [[nodiscard]] double getMsPerContextToken() const noexcept
+    {
+        return std::max(mTheta[1], 0.0);
+    }
+
+    [[nodiscard]] double getMsPerGenerationRequest() const noexcept
+    {
+        return std::max(mTheta[2], 0.0);
+    }
+
+private:
+    static constexpr std::size_t kNumFeatures = 3;
+    static constexpr double kInitialCovariance = 1e3;
+
+    [[nodiscard]] static std::array<double, kNumFeatures> features(
+        SizeType32 numContextTokens, SizeType32 numGenerationRequests)
+    {
+        return {1.0, static_cast<double>(numContextTokens), static_cast<double>(numGenerationRequests)};
+    }
+
+    std::array<double, kNumFeatures> mTheta;
+    std::array<std::array<double, kNumFeatures>, kNumFeatures> mP;
+    double mForgettingFactor;
+};
+
+//! \brief Request as seen by the SLO-aware scheduler.
+struct SloCandidate
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using RequestIdType = std::uint64_t;
+    using Clock = std::chrono::steady_clock;
+
+    RequestIdType requestId;
+    Clock::time_point arrivalTime;
+    RequestSlo slo;
+    //! Whether the context phase is done.
+    bool inGeneration;
+    //! Context tokens still to be processed, 0 for generation requests.
+    SizeType32 numRemainingContextTokens;
+    //! Blocks a generation request needs for its next token.
+    SizeType32 numRequiredBlocks;
+};
+
+//! \brief Requests selected for one iteration.
+struct SloSchedule
+{
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using RequestIdType = SloCandidate::RequestIdType;
+
+    std::vector<RequestIdType> generationRequests;
+    //! Context requests and the size of the chunk processed in this iteration.
+    std::vector<std::pair<RequestIdType, SizeType32>> contextChunks;
+    //! Generation requests that do not fit and are paused.
+    std::vector<RequestIdType> pausedRequests;
+};
+
+//! \brief Selects and chunks requests to maximize the fraction meeting their latency targets.
+//! \details Generation requests with a TPOT target run first, and the tightest target among them bounds the
+//! estimated latency of the iteration, which bounds the context tokens added to it. Context requests are served by
+//! least laxity, i.e. the time left until their TTFT deadline minus the estimated time to process their remaining
+//! context. Context requests without deadline follow in arrival order, and requests that cannot meet their deadline
+//! anymore come last, so they do not delay requests that still can. The owner of the scheduling loop attributes the
+//! allocations of schedule to the scheduler, see MemoryTimeline::ScopedTag and MemoryTimeline::Tag::kSCHEDULER.
+class SloAwareScheduler
+{
+public:
+    using SizeType32 = tensorrt_llm::runtime::SizeType32;
+    using Clock = SloCandidate::Clock;
+
+    //! \param maxNumTokens Maximum number of tokens per iteration.
+    //! \param maxNumRequests Maximum number of requests per iteration.
+    //! \param tokensPerBlock Tokens per KV cache block.
+    //! \param chunkUnitSize Context chunks are multiples of this size, unless they finish the context.
+    SloAwareScheduler(
+        SizeType32 maxNumTokens, SizeType32 maxNumRequests, SizeType32 tokensPerBlock, SizeType32 chunkUnitSize)
+        : mMaxNumTokens{maxNumTokens}
+        , mMaxNumRequests{maxNumRequests}
+        , mTokensPerBlock{tokensPerBlock}
+        , mChunkUnitSize{chunkUnitSize}
+    {
+        TLLM_CHECK(mMaxNumTokens > 0 && mMaxNumRequests > 0 && mTokensPerBlock > 0 && mChunkUnitSize > 0);
+    }
+
+    [[nodiscard]] IterationCostModel& getCostModel() noexcept
+    {
+        return mCostModel;
+    }
+
+    [[nodiscard]] IterationCostModel const& getCostModel() const noexcept
+    {
+        return mCostModel;
+    }
+
+    [[nodiscard]] SloSchedule schedule(
+        std::vector<SloCandidate> const& candidates, SizeType32 numFreeBlocks, Clock::time_point now) const
+    {
+        std::vector<SloCandidate const*> generation;
+        std::vector<SloCandidate const*> context;
+        for (auto const& candidate : candidates)
+        {
+            (candidate.inGeneration ? generation : context).push_back(&candidate);
+        }
+
+        // Tightest TPOT target first, requests without target in arrival order
+        std::stable_sort(generation.begin(), generation.end(),
+            [](SloCandidate const* lhs, SloCandidate const* rhs)
+            {
+                auto const lhsTarget = lhs->slo.tpotTargetMs.value_or(std::numeric_limits<double>::infinity());
+                auto const rhsTarget = rhs->slo.tpotTargetMs.value_or(std::numeric_limits<double>::infinity());
+                return lhsTarget != rhsTarget ? lhsTarget < rhsTarget : lhs->arrivalTime < rhs->arrivalTime;
+            });
+
+        SloSchedule schedule;
+        auto latencyBudgetMs = std::numeric_limits<double>::infinity();
+        SizeType32 numRequests{0};
+        for (auto const* candidate : generation)
+        {
+            if (numRequests < mMaxNumRequests && numRequests < mMaxNumTokens
+                && candidate->numRequiredBlocks <= numFreeBlocks)
+            {
+                schedule.generationRequests.push_back(candidate->requestId);
+                numFreeBlocks -= candidate->numRequiredBlocks;
+                ++numRequests;
+                latencyBudgetMs = std::min(
+                    latencyBudgetMs, candidate->slo.tpotTargetMs.value_or(std::numeric_limits<double>::infinity()));
+            }
+            else
+            {
+                schedule.pausedRequests.push_back(candidate->requestId);
+            }
+        }
+
+        auto const numGenerationRequests = numRequests;
+        auto tokenBudget = std::min(mMaxNumTokens - numGenerationRequests,
+            mCostModel.maxContextTokens(numGenerationRequests, latencyBudgetMs));
+        // Always make some progress on the context phase, the TPOT targets can't be met at the cost of starving it.
+        tokenBudget = std::min(std::max(tokenBudget, mChunkUnitSize), mMaxNumTokens - numGenerationRequests);
+
+        for (auto const* candidate : orderContextRequests(context, numGenerationRequests, now))
+        {
+            if (tokenBudget <= 0 || numRequests >= mMaxNumRequests)
+            {
+                break;
+            }
+            auto chunkSize = std::min(candidate->numRemainingContextTokens, tokenBudget);
+            chunkSize = std::min(chunkSize, numFreeBlocks * mTokensPerBlock);
+            if (chunkSize < candidate->numRemainingContextTokens)
+            {
+                chunkSize = chunkSize / mChunkUnitSize * mChunkUnitSize;
+            }
+            if (chunkSize <= 0)
+            {
+                continue;
+            }
+            schedule.contextChunks.emplace_back(candidate->requestId, chunkSize);
+            tokenBudget -= chunkSize;
+            numFreeBlocks -= (chunkSize + mTokensPerBlock - 1) / mTokensPerBlock;
+            ++numRequests;
+        }
+        return schedule;
+    }
+
+private:
+    [[nodiscard]] std::vector<SloCandidate const*> orderContextRequests(
+        std::vector<SloCandidate const*> const& context, SizeType32 numGenerationRequests, Clock::time_point now) const
+    {
+        using Milliseconds = std::chrono::duration<double, std::milli>;
+        enum class Class
+        {
+            kFEASIBLE = 0,
+            kNO_DEADLINE = 1,
+            kINFEASIBLE = 2,
+        };
+        struct Entry
+        {
+            Class cls;
+            double laxityMs;
+            SloCandidate const* candidate;
+        };
+
+        std::vector<Entry> entries;
+        entries.reserve(context.size());
+        for (auto const* candidate : context)
+        {
+            if (!candidate->slo.ttftDeadline.has_value())
+            {
+                entries.push_back(Entry{Class::kNO_DEADLINE, 0.0, candidate});
+                continue;
+            }
+            auto const deadline = candidate->arrivalTime + candidate->slo.ttftDeadline.value();
+            auto const laxityMs = Milliseconds(deadline - now).count()
+                - mCostModel.estimate(candidate->numRemainingContextTokens, numGenerationRequests);
+            entries.push_back(Entry{laxityMs >= 0.0 ? Class::kFEASIBLE : Class::kINFEASIBLE, laxityMs, candidate});
+        }
+        std::stable_sort(entries.begin(), entries.end(),
+            [](Entry const& lhs, Entry const& rhs)
+            {
+                if (lhs.cls != rhs.cls)
+                {
+                    return lhs.cls < rhs.cls;
+                }
+                if (lhs.cls == Class::kFEASIBLE && lhs.laxityMs != rhs.laxityMs)
+                {
+                    return lhs.laxityMs < rhs.laxityMs;
+                }
+                return lhs.candidate->arrivalTime < rhs.candidate->arrivalTime;
+            });
+
+        std::vector<SloCandidate const*> ordered;
+        ordered.reserve(entries.size());
+        for (auto const& entry : entries)
+        {
+            ordered.push_back(entry.candidate);
+        }
+        return ordered;
+    }
+
+    SizeType32 mMaxNumTokens;
+    SizeType32 mMaxNumRequests;
+    SizeType32 mTokensPerBlock;
+    SizeType32 mChunkUnitSize;
+    IterationCostModel mCostModel;
+};
+
+} // namespace tensorrt_llm::batch_manager
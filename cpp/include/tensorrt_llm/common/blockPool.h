@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+namespace tensorrt_llm::common
+{
+
+//!
+//! \brief Per-thread free lists of memory blocks of `kBlockSize` bytes, for small objects that are created and
+//! destroyed at a high rate, e.g. as the class specific operator new and delete.
+//! \details Freed blocks are kept by the freeing thread, up to `kMaxFreeBlocks`, and reused by its next allocations
+//! without a call into the global allocator. Blocks come from the global operator new, so a block may be freed by any
+//! thread. Requests of another size go to the global allocator. The free blocks of a thread are released when it
+//! exits.
+//!
+template <std::size_t kBlockSize, std::size_t kMaxFreeBlocks = 4096>
+class ThreadLocalBlockPool
+{
+public:
+    static_assert(kBlockSize >= sizeof(void*), "Blocks must be able to hold a pointer");
+
+    [[nodiscard]] static void* allocate(std::size_t size)
+    {
+        auto& freeList = sFreeList;
+        if (size != kBlockSize || freeList.head == nullptr)
+        {
+            return ::operator new(size);
+        }
+        auto* node = freeList.head;
+        freeList.head = node->next;
+        --freeList.size;
+        return node;
+    }
+
+    static void deallocate(void* ptr, std::size_t size) noexcept
+    {
+        if (ptr == nullptr)
+        {
+            return;
+        }
+        auto& freeList = sFreeList;
+        if (size != kBlockSize || freeList.size >= freeList.maxSize)
+        {
+            ::operator delete(ptr);
+            return;
+        }
+        // Registers the release of the free blocks at the exit of the thread
+        static_cast<void>(&sReleaser);
+        auto* node = static_cast<Node*>(ptr);
+        node->next = freeList.head;
+        freeList.head = node;
+        ++freeList.size;
+    }
+
+    //! \brief Number of free blocks kept by the calling thread.
+    [[nodiscard]] static std::size_t getNumFree() noexcept
+    {
+        return sFreeList.size;
+    }
+
+    //! \brief Release the free blocks of the calling thread to the global allocator.
+    static void release() noexcept
+    {
+        auto& freeList = sFreeList;
+        while (freeList.head != nullptr)
+        {
+            auto* node = freeList.head;
+            freeList.head = node->next;
+            ::operator delete(node);
+        }
+        freeList.size = 0;
+    }
+
+private:
+    struct Node
+    {
+        Node* next;
+    };
+
+    // Trivially destructible, so it remains usable while the other thread local objects are destroyed
+    struct FreeList
+    {
+        Node* head;
+        std::size_t size;
+        std::size_t maxSize;
+    };
+
+    struct Releaser
+    {
+        ~Releaser()
+        {
+            release();
+            // Blocks freed later in the exit of the thread go to the global allocator
+            sFreeList.maxSize = 0;
+        }
+    };
+
+    static thread_local FreeList sFreeList;
+    static thread_local Releaser sReleaser;
+};
+
+template <std::size_t kBlockSize, std::size_t kMaxFreeBlocks>
+thread_local typename ThreadLocalBlockPool<kBlockSize, kMaxFreeBlocks>::FreeList
+    ThreadLocalBlockPool<kBlockSize, kMaxFreeBlocks>::sFreeList{nullptr, 0, kMaxFreeBlocks};
+
+template <std::size_t kBlockSize, std::size_t kMaxFreeBlocks>
+thread_local typename ThreadLocalBlockPool<kBlockSize, kMaxFreeBlocks>::Releaser
+    ThreadLocalBlockPool<kBlockSize, kMaxFreeBlocks>::sReleaser{};
+
+} // namespace tensorrt_llm::common
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/mpiUtils.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::mpi
+{
+
+//!
+//! \brief Broadcasts the messages of an iteration from a root rank, e.g. the requests the leader enqueued, with one
+//! non-blocking collective instead of one blocking broadcast per message.
+//! \details The messages of an iteration are packed into a persistent buffer of `inlineCapacity` bytes, which is
+//! broadcast whole so that every rank knows its size. A batch that does not fit sends the rest with a second
+//! broadcast. The root alternates between two buffers, so post() returns as soon as the broadcast is started and only
+//! waits for the one of the iteration before the previous. The other ranks can post the receive of the next iteration
+//! early, e.g. before the forward pass, and wait for it when they schedule.
+//! All ranks must post the same number of iterations.
+//!
+class MpiCoalescedBroadcast
+{
+public:
+    using Message = std::vector<char>;
+
+    static constexpr std::size_t kDefaultInlineCapacity = 16 * 1024;
+
+    //! \param inlineCapacity Bytes broadcast every iteration, the same on all ranks.
+    MpiCoalescedBroadcast(MpiComm const& comm, int root, std::size_t inlineCapacity = kDefaultInlineCapacity);
+
+    //! \brief Waits for the broadcasts still in flight from the root. A receive posted by another rank is left pending.
+    ~MpiCoalescedBroadcast();
+
+    MpiCoalescedBroadcast(MpiCoalescedBroadcast const&) = delete;
+    MpiCoalescedBroadcast& operator=(MpiCoalescedBroadcast const&) = delete;
+
+    [[nodiscard]] bool isRoot() const;
+
+    //! \brief Adds a message to the batch of the current iteration. Root only.
+    void add(char const* data, std::size_t size);
+
+    void add(Message const& message)
+    {
+        add(message.data(), message.size());
+    }
+
+    //! \brief Starts the broadcast of the batch of the current iteration, possibly empty, and starts a new batch. Root
+    //! only.
+    void post();
+
+    //! \brief Starts receiving the batch of the next iteration without waiting for it. Other ranks only.
+    void postReceive();
+
+    //! \brief Waits for the batch of the next iteration, posting its receive first if needed. Other ranks only.
+    //! \return The messages in the order they were added.
+    [[nodiscard]] std::vector<Message> receive();
+
+private:
+    struct Slot
+    {
+        std::vector<char> inlineBuffer;
+        std::vector<char> overflowBuffer;
+        std::shared_ptr<MpiRequest> inlineRequest;
+        std::shared_ptr<MpiRequest> overflowRequest;
+    };
+
+    static void wait(Slot& slot);
+
+    MpiComm const& mComm;
+    int mRoot;
+    std::size_t mInlineCapacity;
+    // Root: alternate between the two. Other ranks: only the first one.
+    std::array<Slot, 2> mSlots;
+    int mNextSlot{0};
+    // Root: messages of the current iteration, each prefixed by its size.
+    std::vector<char> mBatch;
+    std::uint64_t mBatchSize{0};
+    bool mReceivePosted{false};
+};
+
+} // namespace tensorrt_llm::mpi
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#endif
+
+namespace tensorrt_llm::common
+{
+
+//!
+//! \brief Bounded lock-free multi-producer single-consumer ring.
+//! \details Every slot carries a sequence number telling whether it is ready to be written or read in the current lap,
+//! producers claim slots by advancing the write position with a CAS. Only one thread may pop at a time.
+//!
+template <typename T>
+class MpscRing
+{
+public:
+    //! \param capacity Number of slots, rounded up to a power of two.
+    explicit MpscRing(std::size_t capacity)
+        : mSlots(roundUpToPowerOfTwo(capacity))
+        , mMask{mSlots.size() - 1}
+        , mWritePos{0}
+        , mReadPos{0}
+    {
+        for (std::size_t i = 0; i < mSlots.size(); ++i)
+        {
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscRing(MpscRing const&) = delete;
+    MpscRing& operator=(MpscRing const&) = delete;
+
+    //! \brief Push a value, can be called from any thread.
+    //! \return False if the ring is full, `value` is left untouched then.
+    bool tryPush(T&& value)
+    {
+        auto pos = mWritePos.load(std::memory_order_relaxed);
+        while (true)
+        {
+            auto& slot = mSlots[pos & mMask];
+            auto const sequence = slot.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::int64_t>(sequence) - static_cast<std::int64_t>(pos);
+            if (diff == 0)
+            {
+                if (mWritePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.value.emplace(std::move(value));
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = mWritePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    //! \brief Pop the oldest value, must only be called by the consumer.
+    [[nodiscard]] std::optional<T> tryPop()
+    {
+        auto& slot = mSlots[mReadPos & mMask];
+        if (slot.sequence.load(std::memory_order_acquire) != mReadPos + 1)
+        {
+            return std::nullopt;
+        }
+        std::optional<T> value{std::move(slot.value)};
+        slot.value.reset();
+        slot.sequence.store(mReadPos + mSlots.size(), std::memory_order_release);
+        ++mReadPos;
+        return value;
+    }
+
+    [[nodiscard]] std::size_t capacity() const noexcept
+    {
+        return mSlots.size();
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{0};
+        std::optional<T> value{std::nullopt};
+    };
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value)
+    {
+        TLLM_CHECK(value > 0);
+        std::size_t result{1};
+        while (result < value)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    std::vector<Slot> mSlots;
+    std::size_t mMask;
+    // Producers and the consumer write different positions, keep them on different cache lines.
+    alignas(64) std::atomic<std::size_t> mWritePos;
+    alignas(64) std::size_t mReadPos;
+};
+
+//!
+//! \brief MpscRing with a file descriptor that becomes readable when values are pushed, for use with epoll/poll.
+//! \details Only the first push after the consumer drained the queue signals the descriptor, so a burst of pushes
+//! costs one wakeup. The descriptor is only available on Linux, getFd() returns -1 elsewhere.
+//!
+template <typename T>
+class NotifyingMpscQueue
+{
+public:
+    explicit NotifyingMpscQueue(std::size_t capacity)
+        : mRing{capacity}
+        , mSignaled{false}
+    {
+#if defined(__linux__)
+        mFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        TLLM_CHECK_WITH_INFO(mFd >= 0, "Failed to create eventfd: %s", std::strerror(errno));
+#endif
+    }
+
+    ~NotifyingMpscQueue()
+    {
+#if defined(__linux__)
+        ::close(mFd);
+#endif
+    }
+
+    NotifyingMpscQueue(NotifyingMpscQueue const&) = delete;
+    NotifyingMpscQueue& operator=(NotifyingMpscQueue const&) = delete;
+
+    //! \brief Push a value and signal the descriptor, can be called from any thread.
+    //! \return False if the queue is full.
+    bool tryPush(T&& value)
+    {
+        if (!mRing.tryPush(std::move(value)))
+        {
+            return false;
+        }
+        if (!mSignaled.exchange(true, std::memory_order_acq_rel))
+        {
+#if defined(__linux__)
+            [[maybe_unused]] auto const result = ::eventfd_write(mFd, 1);
+#endif
+        }
+        return true;
+    }
+
+    //! \brief Pop all queued values and clear the descriptor, must only be called by the consumer.
+    [[nodiscard]] std::vector<T> popAll()
+    {
+        // Clear the descriptor, then the flag, then drain: a value pushed after the flag is cleared signals again,
+        // values pushed before are drained below.
+        if (mSignaled.load(std::memory_order_acquire))
+        {
+#if defined(__linux__)
+            eventfd_t count{0};
+            [[maybe_unused]] auto const result = ::eventfd_read(mFd, &count);
+#endif
+            mSignaled.exchange(false, std::memory_order_acq_rel);
+        }
+        std::vector<T> values;
+        while (auto value = mRing.tryPop())
+        {
+            values.push_back(std::move(value.value()));
+        }
+        return values;
+    }
+
+    //! \brief Descriptor that is readable while values are queued.
+    [[nodiscard]] int getFd() const noexcept
+    {
+        return mFd;
+    }
+
+private:
+    MpscRing<T> mRing;
+    std::atomic<bool> mSignaled;
+    int mFd{-1};
+};
+
+} // namespace tensorrt_llm::common
@@ -92,6 +92,18 @@ public:
         return QuantMode(BaseType(1u) << 8);
     }
 
+    // E2M1 weights with an e4m3 scale per 16 elements and a per tensor fp32 scale
+    static constexpr QuantMode nvfp4Weights() noexcept
+    {
+        return QuantMode(BaseType(1u) << 9);
+    }
+
+    // E2M1 weights with a power of two (ue8m0) scale per 32 elements
+    static constexpr QuantMode mxfp4Weights() noexcept
+    {
+        return QuantMode(BaseType(1u) << 10);
+    }
+
     constexpr BaseType value() const noexcept
     {
         return mValue;
@@ -157,14 +169,34 @@ public:
         return hasInt8KvCache() || hasFp8KvCache();
     }
 
+    constexpr bool hasNvfp4Weights() const noexcept
+    {
+        return isSet(nvfp4Weights());
+    }
+
+    constexpr bool hasMxfp4Weights() const noexcept
+    {
+        return isSet(mxfp4Weights());
+    }
+
+    constexpr bool hasFp4Weights() const noexcept
+    {
+        return hasNvfp4Weights() || hasMxfp4Weights();
+    }
+
     static constexpr QuantMode fromDescription(bool quantizeWeights = false, bool quantizeActivations = false,
         bool perToken = false, bool perChannel = false, bool perGroup = false, bool useInt4Weights = false,
-        bool useInt8KvCache = false, bool useFp8KvCache = false, bool useFp8Qdq = false)
+        bool useInt8KvCache = false, bool useFp8KvCache = false, bool useFp8Qdq = false, bool useNvfp4Weights = false,
+        bool useMxfp4Weights = false)
     {
         QuantMode quantMode{};
         if (quantizeWeights)
         {
-            if (useInt4Weights)
+            if (useNvfp4Weights)
+                quantMode += nvfp4Weights();
+            else if (useMxfp4Weights)
+                quantMode += mxfp4Weights();
+            else if (useInt4Weights)
                 quantMode += int4Weights();
             else
                 quantMode += int8Weights();
@@ -216,6 +248,11 @@ public:
         return fromDescription(true, false, false, false, perGroup, useInt4Weights);
     }
 
+    static constexpr QuantMode useWeightOnlyFp4(bool useMxfp4 = false)
+    {
+        return fromDescription(true, false, false, false, true, false, false, false, false, !useMxfp4, useMxfp4);
+    }
+
     static const QuantMode fromQuantAlgo(
         std::optional<std::string> quantAlgo = std::nullopt, std::optional<std::string> kvCacheQuantAlgo = std::nullopt)
     {
@@ -260,6 +297,14 @@ public:
         {
             quantMode = useSmoothQuant(true, false);
         }
+        else if (quantAlgo == "W4A16_NVFP4")
+        {
+            quantMode = useWeightOnlyFp4(false);
+        }
+        else if (quantAlgo == "W4A16_MXFP4")
+        {
+            quantMode = useWeightOnlyFp4(true);
+        }
         else if (quantAlgo == "FP8")
         {
             quantMode = fromDescription(false, false, false, false, false, false, false, false, true);
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace tensorrt_llm::common
+{
+
+//!
+//! \brief Single-producer single-consumer message ring in POSIX shared memory, to exchange messages between processes
+//! on the same node without copies through a communicator.
+//! \details Messages are length-prefixed and contiguous, a message that does not fit before the end of the ring
+//! starts at its beginning. The producer reserves room, writes the message in place, e.g. with Serialization through
+//! a SpanStreamBuf, and commits it. The consumer peeks at the next message and releases it once done.
+//! The process that creates the ring unlinks it on destruction.
+//!
+class ShmRing
+{
+public:
+    //! \brief Create a ring, `name` as for shm_open, e.g. "/trtllm_orchestrator_0".
+    //! \param capacity Bytes for messages and their headers, rounded up to a multiple of 8.
+    [[nodiscard]] static ShmRing create(std::string const& name, std::size_t capacity);
+
+    //! \brief Open a ring created by another process.
+    [[nodiscard]] static ShmRing open(std::string const& name);
+
+    ~ShmRing();
+    ShmRing(ShmRing&& other) noexcept;
+    ShmRing& operator=(ShmRing&& other) noexcept;
+    ShmRing(ShmRing const&) = delete;
+    ShmRing& operator=(ShmRing const&) = delete;
+
+    //! \brief Reserve room for a message of `size` bytes. Producer only.
+    //! \return Where to write the message, nullptr if the ring is too full.
+    [[nodiscard]] char* tryReserve(std::size_t size);
+
+    //! \brief Publish the message reserved last.
+    void commit();
+
+    //! \brief Reserve, write with `write` through an ostream over the reserved room, and commit a message.
+    //! \param size Size of the message, e.g. from Serialization::serializedSize.
+    //! \return False if the ring is too full.
+    bool tryWrite(std::size_t size, std::function<void(std::ostream&)> const& write);
+
+    struct Message
+    {
+        char const* data;
+        std::size_t size;
+    };
+
+    //! \brief Next message, valid until release(). Consumer only.
+    [[nodiscard]] std::optional<Message> tryPeek();
+
+    //! \brief Consume the message returned by the last tryPeek().
+    void release();
+
+    [[nodiscard]] std::size_t getCapacity() const noexcept;
+
+private:
+    struct Header;
+
+    ShmRing(std::string name, bool owner, int fd, void* mapping, std::size_t mappingSize);
+
+    [[nodiscard]] Header& header() const noexcept;
+    [[nodiscard]] char* data() const noexcept;
+
+    std::string mName;
+    bool mOwner;
+    int mFd;
+    void* mMapping;
+    std::size_t mMappingSize;
+    // Producer: position after the reserved message. Consumer: position after the peeked message.
+    std::optional<std::uint64_t> mPendingPos;
+};
+
+} // namespace tensorrt_llm::common
@@ -0,0 +1,57 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cstddef>
+#include <streambuf>
+
+namespace tensorrt_llm::common
+{
+
+//!
+//! \brief Stream buffer over a fixed memory range, to serialize into or deserialize from memory without copies.
+//! \details Writes past the end of the range fail the stream instead of reallocating.
+//!
+class SpanStreamBuf : public std::streambuf
+{
+public:
+    SpanStreamBuf(char* data, std::size_t size)
+    {
+        setg(data, data, data + size);
+        setp(data, data + size);
+    }
+
+    SpanStreamBuf(char const* data, std::size_t size)
+        : SpanStreamBuf(const_cast<char*>(data), size)
+    {
+        // Only the get area may be used for a const range.
+        setp(nullptr, nullptr);
+    }
+
+    //! \brief Number of bytes written so far.
+    [[nodiscard]] std::size_t getNumWritten() const noexcept
+    {
+        return static_cast<std::size_t>(pptr() - pbase());
+    }
+
+    //! \brief Number of bytes read so far.
+    [[nodiscard]] std::size_t getNumRead() const noexcept
+    {
+        return static_cast<std::size_t>(gptr() - eback());
+    }
+};
+
+} // namespace tensorrt_llm::common
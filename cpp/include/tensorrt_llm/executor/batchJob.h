@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/serialization.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Runs an offline batch of requests through an executor, reordered for throughput.
+///
+///        Requests are read from a source a window at a time and reordered within the window: requests that share
+///        their first KV cache block form a group and are sorted by prompt, so that requests with a common prefix are
+///        enqueued one after the other and the block manager reuses their blocks while they are still cached. Groups
+///        are ordered by the bin of their output length, longest first, so that requests in flight together finish
+///        together and the last requests of the job are short ones. The bins are powers of two of maxNewTokens.
+///        Up to maxInFlightRequests requests are kept in the executor. Requests are not streamed, every request gets
+///        one final response, passed to the sink with the position of the request in the source.
+/// @tparam TExecutor The executor type, Executor. It must provide enqueueRequests and awaitResponses.
+template <typename TExecutor>
+class BasicBatchJob
+{
+public:
+    /// @brief The next request of the job, std::nullopt at the end.
+    using Source = std::function<std::optional<Request>()>;
+    /// @brief Called with the position of the request in the source and its final response, in completion order.
+    using Sink = std::function<void(std::size_t index, Response const& response)>;
+
+    struct Config
+    {
+        /// @brief Granularity of the shared prefixes, the tokens per block of the KV cache.
+        SizeType32 tokensPerBlock{64};
+        /// @brief Requests read from the source and reordered together.
+        SizeType32 windowSize{4096};
+        /// @brief Requests enqueued in the executor and not finished yet.
+        SizeType32 maxInFlightRequests{512};
+        /// @brief Time awaitResponses waits for responses.
+        std::chrono::milliseconds pollTimeout{100};
+    };
+
+    struct Stats
+    {
+        std::size_t numRequests{0};
+        std::size_t numErrors{0};
+        /// @brief Groups of requests sharing their first block, over all windows.
+        std::size_t numPrefixGroups{0};
+        /// @brief Whole prompt blocks shared with the request enqueued just before, over all requests.
+        std::size_t numSharedBlocks{0};
+    };
+
+    BasicBatchJob(std::shared_ptr<TExecutor> executor, Config const& config = Config{})
+        : mExecutor{std::move(executor)}
+        , mConfig{config}
+    {
+        TLLM_CHECK(mExecutor);
+        TLLM_CHECK(mConfig.tokensPerBlock > 0);
+        TLLM_CHECK(mConfig.windowSize > 0);
+        TLLM_CHECK(mConfig.maxInFlightRequests > 0);
+    }
+
+    /// @brief Run all the requests of `source` and pass their responses to `sink`. Returns when all responses are
+    /// passed.
+    Stats run(Source const& source, Sink const& sink)
+    {
+        Stats stats;
+        // Reordered requests of the current windows, with their position in the source
+        std::deque<std::pair<std::size_t, Request>> pending;
+        std::unordered_map<IdType, std::size_t> inFlight;
+        // Last prompt enqueued, to count the blocks shared across windows
+        VecTokens previousPrompt;
+        auto exhausted = false;
+
+        while (true)
+        {
+            // Read the next window before the executor drains, so that it is never idle
+            if (!exhausted && pending.size() < static_cast<std::size_t>(mConfig.maxInFlightRequests))
+            {
+                exhausted = !readWindow(source, pending, previousPrompt, stats);
+            }
+            if (pending.empty() && inFlight.empty())
+            {
+                break;
+            }
+
+            auto const numToEnqueue = std::min(pending.size(),
+                static_cast<std::size_t>(mConfig.maxInFlightRequests) - inFlight.size());
+            if (numToEnqueue > 0)
+            {
+                std::vector<Request> requests;
+                std::vector<std::size_t> indices;
+                requests.reserve(numToEnqueue);
+                indices.reserve(numToEnqueue);
+                for (std::size_t i = 0; i < numToEnqueue; ++i)
+                {
+                    indices.push_back(pending.front().first);
+                    requests.push_back(std::move(pending.front().second));
+                    pending.pop_front();
+                }
+                auto const ids = mExecutor->enqueueRequests(requests);
+                TLLM_CHECK(ids.size() == indices.size());
+                for (std::size_t i = 0; i < ids.size(); ++i)
+                {
+                    inFlight.emplace(ids[i], indices[i]);
+                }
+            }
+
+            for (auto const& response : mExecutor->awaitResponses(mConfig.pollTimeout))
+            {
+                auto const it = inFlight.find(response.getRequestId());
+                if (it == inFlight.end())
+                {
+                    continue;
+                }
+                auto const isError = response.hasError();
+                if (!isError && !response.getResult().isFinal)
+                {
+                    continue;
+                }
+                stats.numErrors += isError ? 1 : 0;
+                auto const index = it->second;
+                inFlight.erase(it);
+                sink(index, response);
+            }
+        }
+        return stats;
+    }
+
+    /// @brief The order in which `requests` are enqueued, a permutation of their indices.
+    [[nodiscard]] std::vector<std::size_t> plan(std::vector<Request> const& requests) const
+    {
+        std::vector<VecTokens> prompts;
+        std::vector<SizeType32> maxNewTokens;
+        prompts.reserve(requests.size());
+        maxNewTokens.reserve(requests.size());
+        for (auto const& request : requests)
+        {
+            prompts.push_back(request.getInputTokenIds());
+            maxNewTokens.push_back(request.getMaxNewTokens());
+        }
+        std::size_t numGroups{0};
+        return planWindow(prompts, maxNewTokens, numGroups);
+    }
+
+    /// @brief Number of whole blocks shared by the prompts `a` and `b` from their start.
+    [[nodiscard]] SizeType32 countSharedBlocks(VecTokens const& a, VecTokens const& b) const
+    {
+        auto const shared = std::mismatch(a.begin(), a.end(), b.begin(), b.end()).first;
+        return static_cast<SizeType32>(std::distance(a.begin(), shared)) / mConfig.tokensPerBlock;
+    }
+
+    /// @brief Read the requests of a file of requests serialized one after the other with Serialization::serialize.
+    [[nodiscard]] static Source makeStreamSource(std::istream& is)
+    {
+        return [&is]() -> std::optional<Request>
+        {
+            if (is.peek() == std::istream::traits_type::eof())
+            {
+                return std::nullopt;
+            }
+            return Serialization::deserializeRequest(is);
+        };
+    }
+
+private:
+    [[nodiscard]] std::vector<std::size_t> planWindow(std::vector<VecTokens> const& prompts,
+        std::vector<SizeType32> const& maxNewTokens, std::size_t& numGroups) const
+    {
+        auto const numRequests = prompts.size();
+        auto const blockSize = static_cast<std::size_t>(mConfig.tokensPerBlock);
+
+        // Groups of the requests with the same first block, in order of first appearance. Prompts shorter than a
+        // block share nothing and are groups of their own.
+        std::vector<std::vector<std::size_t>> groups;
+        std::unordered_map<std::uint64_t, std::vector<std::size_t>> groupsByHash;
+        for (std::size_t i = 0; i < numRequests; ++i)
+        {
+            auto const& prompt = prompts[i];
+            std::optional<std::size_t> group;
+            std::uint64_t hash{0};
+            if (prompt.size() >= blockSize)
+            {
+                for (std::size_t ti = 0; ti < blockSize; ++ti)
+                {
+                    auto const token = static_cast<std::uint32_t>(prompt[ti]);
+                    hash ^= token + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+                }
+                for (auto const candidate : groupsByHash[hash])
+                {
+                    auto const& first = prompts[groups[candidate].front()];
+                    if (std::equal(prompt.begin(), prompt.begin() + blockSize, first.begin()))
+                    {
+                        group = candidate;
+                        break;
+                    }
+                }
+            }
+            if (!group)
+            {
+                group = groups.size();
+                groups.emplace_back();
+                if (prompt.size() >= blockSize)
+                {
+                    groupsByHash[hash].push_back(*group);
+                }
+            }
+            groups[*group].push_back(i);
+        }
+
+        // Bin of the mean output length of each group
+        std::vector<SizeType32> groupBins(groups.size());
+        for (std::size_t g = 0; g < groups.size(); ++g)
+        {
+            std::int64_t total{0};
+            for (auto const i : groups[g])
+            {
+                total += std::max(maxNewTokens[i], 1);
+            }
+            groupBins[g] = getLengthBin(total / static_cast<std::int64_t>(groups[g].size()));
+        }
+
+        std::vector<std::size_t> groupOrder(groups.size());
+        std::iota(groupOrder.begin(), groupOrder.end(), 0);
+        std::stable_sort(groupOrder.begin(), groupOrder.end(),
+            [&groupBins](std::size_t a, std::size_t b) { return groupBins[a] > groupBins[b]; });
+
+        std::vector<std::size_t> order;
+        order.reserve(numRequests);
+        for (auto const g : groupOrder)
+        {
+            auto& members = groups[g];
+            // Longer common prefixes end up next to each other
+            std::stable_sort(members.begin(), members.end(),
+                [&prompts](std::size_t a, std::size_t b) { return prompts[a] < prompts[b]; });
+            order.insert(order.end(), members.begin(), members.end());
+        }
+        numGroups = groups.size();
+        return order;
+    }
+
+    [[nodiscard]] static SizeType32 getLengthBin(std::int64_t maxNewTokens)
+    {
+        SizeType32 bin{0};
+        while (maxNewTokens > 1)
+        {
+            maxNewTokens >>= 1;
+            ++bin;
+        }
+        return bin;
+    }
+
+    /// @return false if the source is exhausted.
+    bool readWindow(Source const& source, std::deque<std::pair<std::size_t, Request>>& pending,
+        VecTokens& previousPrompt, Stats& stats)
+    {
+        std::vector<Request> window;
+        auto exhausted = false;
+        while (window.size() < static_cast<std::size_t>(mConfig.windowSize))
+        {
+            auto request = source();
+            if (!request)
+            {
+                exhausted = true;
+                break;
+            }
+            // One final response per request
+            request->setStreaming(false);
+            window.push_back(std::move(*request));
+        }
+
+        std::vector<VecTokens> prompts;
+        std::vector<SizeType32> maxNewTokens;
+        prompts.reserve(window.size());
+        maxNewTokens.reserve(window.size());
+        for (auto const& request : window)
+        {
+            prompts.push_back(request.getInputTokenIds());
+            maxNewTokens.push_back(request.getMaxNewTokens());
+        }
+        std::size_t numGroups{0};
+        auto const order = planWindow(prompts, maxNewTokens, numGroups);
+
+        auto const* previous = &previousPrompt;
+        for (auto const index : order)
+        {
+            stats.numSharedBlocks += countSharedBlocks(*previous, prompts[index]);
+            previous = &prompts[index];
+            pending.emplace_back(stats.numRequests + index, std::move(window[index]));
+        }
+        if (!order.empty())
+        {
+            previousPrompt = *previous;
+        }
+        stats.numRequests += window.size();
+        stats.numPrefixGroups += numGroups;
+        return !exhausted;
+    }
+
+    std::shared_ptr<TExecutor> mExecutor;
+    Config const mConfig;
+};
+
+using BatchJob = BasicBatchJob<Executor>;
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,214 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/spanStreamBuf.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/serialization.h"
+
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief How BatchSerialization serializes a type. Specialized for the types with a Serialization::deserialize
+/// overload.
+template <typename T>
+struct SerializationTraits
+{
+    [[nodiscard]] static std::size_t serializedSize(T const& value)
+    {
+        return Serialization::serializedSize(value);
+    }
+
+    static void serialize(T const& value, std::ostream& os)
+    {
+        Serialization::serialize(value, os);
+    }
+};
+
+template <>
+struct SerializationTraits<Request>
+{
+    [[nodiscard]] static std::size_t serializedSize(Request const& value)
+    {
+        return Serialization::serializedSize(value);
+    }
+
+    static void serialize(Request const& value, std::ostream& os)
+    {
+        Serialization::serialize(value, os);
+    }
+
+    [[nodiscard]] static Request deserialize(std::istream& is)
+    {
+        return Serialization::deserializeRequest(is);
+    }
+};
+
+template <>
+struct SerializationTraits<Response>
+{
+    [[nodiscard]] static std::size_t serializedSize(Response const& value)
+    {
+        return Serialization::serializedSize(value);
+    }
+
+    static void serialize(Response const& value, std::ostream& os)
+    {
+        Serialization::serialize(value, os);
+    }
+
+    [[nodiscard]] static Response deserialize(std::istream& is)
+    {
+        return Serialization::deserializeResponse(is);
+    }
+};
+
+template <>
+struct SerializationTraits<Result>
+{
+    [[nodiscard]] static std::size_t serializedSize(Result const& value)
+    {
+        return Serialization::serializedSize(value);
+    }
+
+    static void serialize(Result const& value, std::ostream& os)
+    {
+        Serialization::serialize(value, os);
+    }
+
+    [[nodiscard]] static Result deserialize(std::istream& is)
+    {
+        return Serialization::deserializeResult(is);
+    }
+};
+
+/// @brief Serializes a batch of objects, e.g. Requests, into one buffer sized up front from their serializedSize.
+///
+///        The buffer holds uint64 numItems, uint64 offsets[numItems + 1] relative to the start of the buffer and the
+///        items. Serialization writes every item in place, through a stream over its slot of the buffer, so a batch
+///        takes one allocation, or none with a caller-provided buffer. Items can be deserialized in place, also
+///        individually.
+class BatchSerialization
+{
+public:
+    /// @brief Size of the buffer holding `items`.
+    template <typename T>
+    [[nodiscard]] static std::size_t packedSize(std::vector<T> const& items)
+    {
+        auto size = headerSize(items.size());
+        for (auto const& item : items)
+        {
+            size += SerializationTraits<T>::serializedSize(item);
+        }
+        return size;
+    }
+
+    /// @brief Serialize `items` into the caller-provided buffer `data`, e.g. an arena or a shared-memory ring.
+    /// @return Number of bytes written, packedSize(items).
+    template <typename T>
+    static std::size_t pack(std::vector<T> const& items, char* data, std::size_t size)
+    {
+        auto const numItems = static_cast<std::uint64_t>(items.size());
+        auto offset = static_cast<std::uint64_t>(headerSize(items.size()));
+        TLLM_CHECK_WITH_INFO(offset <= size, "Buffer of %lu bytes is too small for %lu items", size, items.size());
+        std::memcpy(data, &numItems, sizeof(numItems));
+        for (std::size_t i = 0; i < items.size(); ++i)
+        {
+            auto const itemSize = SerializationTraits<T>::serializedSize(items[i]);
+            TLLM_CHECK_WITH_INFO(offset + itemSize <= size, "Buffer of %lu bytes is too small", size);
+            writeOffset(data, i, offset);
+            common::SpanStreamBuf buffer{data + offset, itemSize};
+            std::ostream os{&buffer};
+            SerializationTraits<T>::serialize(items[i], os);
+            TLLM_CHECK_WITH_INFO(os.good() && buffer.getNumWritten() == itemSize,
+                "Serialized size of item %lu does not match serializedSize", i);
+            offset += itemSize;
+        }
+        writeOffset(data, items.size(), offset);
+        return offset;
+    }
+
+    /// @brief Serialize `items` into a buffer allocated once.
+    template <typename T>
+    [[nodiscard]] static std::vector<char> pack(std::vector<T> const& items)
+    {
+        std::vector<char> buffer(packedSize(items));
+        pack(items, buffer.data(), buffer.size());
+        return buffer;
+    }
+
+    [[nodiscard]] static std::size_t getNumItems(char const* data, std::size_t size)
+    {
+        TLLM_CHECK_WITH_INFO(size >= sizeof(std::uint64_t), "Truncated batch buffer");
+        std::uint64_t numItems{0};
+        std::memcpy(&numItems, data, sizeof(numItems));
+        TLLM_CHECK_WITH_INFO(headerSize(numItems) <= size, "Truncated batch buffer");
+        return numItems;
+    }
+
+    /// @brief Deserialize item `index`, reading from the buffer in place.
+    template <typename T>
+    [[nodiscard]] static T unpackItem(char const* data, std::size_t size, std::size_t index)
+    {
+        TLLM_CHECK(index < getNumItems(data, size));
+        auto const begin = readOffset(data, index);
+        auto const end = readOffset(data, index + 1);
+        TLLM_CHECK_WITH_INFO(begin <= end && end <= size, "Corrupted batch buffer");
+        common::SpanStreamBuf buffer{data + begin, end - begin};
+        std::istream is{&buffer};
+        return SerializationTraits<T>::deserialize(is);
+    }
+
+    template <typename T>
+    [[nodiscard]] static std::vector<T> unpack(char const* data, std::size_t size)
+    {
+        auto const numItems = getNumItems(data, size);
+        std::vector<T> items;
+        items.reserve(numItems);
+        for (std::size_t i = 0; i < numItems; ++i)
+        {
+            items.push_back(unpackItem<T>(data, size, i));
+        }
+        return items;
+    }
+
+private:
+    [[nodiscard]] static std::size_t headerSize(std::size_t numItems) noexcept
+    {
+        return sizeof(std::uint64_t) * (numItems + 2);
+    }
+
+    static void writeOffset(char* data, std::size_t index, std::uint64_t offset) noexcept
+    {
+        std::memcpy(data + sizeof(std::uint64_t) * (index + 1), &offset, sizeof(offset));
+    }
+
+    [[nodiscard]] static std::uint64_t readOffset(char const* data, std::size_t index) noexcept
+    {
+        std::uint64_t offset{0};
+        std::memcpy(&offset, data + sizeof(std::uint64_t) * (index + 1), sizeof(offset));
+        return offset;
+    }
+};
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Precision of the KV cache of a replica, and the one a request is admitted with.
+enum class KvPrecisionTier : std::int8_t
+{
+    /// @brief The KV cache type of the model, e.g. FP16, for the traffic whose quality matters most.
+    kFULL = 0,
+    /// @brief An 8-bit KV cache, FP8 or INT8, which fits about twice the tokens in the same memory.
+    kQUANTIZED = 1,
+};
+
+/// @brief Routes requests across data-parallel replicas of an executor, by prefix affinity and by load.
+///
+///        A request goes to the replica that received the longest prefix of its prompt before, in whole KV cache
+///        blocks, so that the block manager of that replica can reuse the blocks. The prefix is ignored when that
+///        replica is busier than the least loaded one by more than maxLoadImbalance requests, or lacks the free blocks
+///        for the rest of the prompt. The load of a replica is its queued and active requests and its free KV cache
+///        blocks from its latest iteration stats, plus the requests routed to it since.
+///        Replicas can be added and removed while requests are routed.
+///        The KV cache type of an engine is fixed when it is built, so a deployment that serves requests with both
+///        full precision and quantized KV caches runs replicas of both precisions, e.g. of engines built with and
+///        without an FP8 KV cache. Each request is routed to the replicas of its tier only, see KvPrecisionTier.
+/// @tparam TExecutor The replica type, Executor. It must provide enqueueRequest and getLatestIterationStats.
+template <typename TExecutor>
+class BasicDataParallelRouter
+{
+public:
+    using ReplicaId = SizeType32;
+
+    struct Config
+    {
+        /// @brief Granularity of the prefixes, the tokens per block of the KV cache of the replicas.
+        SizeType32 tokensPerBlock{64};
+        /// @brief Requests a replica may have above the least loaded one and still get a request by affinity.
+        SizeType32 maxLoadImbalance{4};
+        /// @brief Number of prefix blocks remembered, the least recently routed are forgotten first.
+        std::size_t maxTrackedBlocks{1 << 18};
+    };
+
+    /// @brief Id of a routed request: the replica and the id given by that replica.
+    struct RoutedId
+    {
+        ReplicaId replica;
+        IdType requestId;
+    };
+
+    explicit BasicDataParallelRouter(Config const& config = Config{})
+        : mConfig{config}
+    {
+        TLLM_CHECK(mConfig.tokensPerBlock > 0);
+        TLLM_CHECK(mConfig.maxTrackedBlocks > 0);
+    }
+
+    BasicDataParallelRouter(BasicDataParallelRouter const&) = delete;
+    BasicDataParallelRouter& operator=(BasicDataParallelRouter const&) = delete;
+
+    /// @brief Start routing requests to a replica.
+    /// @param tier The precision of the KV cache of the replica.
+    ReplicaId addReplica(std::shared_ptr<TExecutor> executor, KvPrecisionTier tier = KvPrecisionTier::kFULL)
+    {
+        TLLM_CHECK(executor);
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const id = mNextReplicaId++;
+        mReplicas.emplace(id, Replica{std::move(executor), tier});
+        return id;
+    }
+
+    /// @brief Stop routing requests to a replica. The requests it has are not affected, the caller drains it.
+    void removeReplica(ReplicaId replica)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        TLLM_CHECK_WITH_INFO(mReplicas.erase(replica) == 1, "Unknown replica %d", replica);
+        // Prefixes of the replica are forgotten when they are looked up.
+    }
+
+    [[nodiscard]] SizeType32 getNumReplicas() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return static_cast<SizeType32>(mReplicas.size());
+    }
+
+    /// @brief Update the load of a replica from its latest iteration stats.
+    void updateLoad(ReplicaId replica, IterationStats const& stats)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mReplicas.find(replica);
+        if (it == mReplicas.end())
+        {
+            return;
+        }
+        auto& state = it->second;
+        state.numRequests = stats.numQueuedRequests + stats.numActiveRequests;
+        state.freeNumBlocks = stats.kvCacheStats ? std::optional{stats.kvCacheStats->freeNumBlocks} : std::nullopt;
+        state.numRoutedRequests = 0;
+        state.numRoutedBlocks = 0;
+    }
+
+    /// @brief Update the load of all replicas with the latest of their iteration stats. The stats are consumed, call
+    /// updateLoad instead if they are used elsewhere.
+    void refreshLoads()
+    {
+        for (auto const& [replica, executor] : getExecutors())
+        {
+            auto stats = executor->getLatestIterationStats();
+            if (!stats.empty())
+            {
+                updateLoad(replica, stats.back());
+            }
+        }
+    }
+
+    /// @brief Choose the replica of a request and account for it in the load of the replica.
+    /// @param tier The precision of the KV cache the request is admitted with, e.g. by its priority. Quantized requests
+    /// fall back to the full precision replicas when there is no quantized replica, full precision requests never run
+    /// on quantized replicas.
+    [[nodiscard]] ReplicaId route(Request const& request, KvPrecisionTier tier = KvPrecisionTier::kFULL)
+    {
+        auto const loraTaskId = request.getLoraConfig() ? request.getLoraConfig()->getTaskId() : IdType{0};
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (tier == KvPrecisionTier::kQUANTIZED && !hasReplicaOfTier(tier))
+        {
+            tier = KvPrecisionTier::kFULL;
+        }
+        TLLM_CHECK_WITH_INFO(hasReplicaOfTier(tier), "No replica to route the request to");
+        // The blocks of the tiers are not interchangeable
+        auto const blockHashes = hashBlocks(request.getInputTokenIds(), loraTaskId, tier);
+        auto const numBlocks = static_cast<SizeType32>(blockHashes.size());
+
+        // Longest prefix of whole blocks routed to each replica
+        std::map<ReplicaId, SizeType32> matchedBlocks;
+        for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+        {
+            auto it = mBlocks.find(blockHashes[bi]);
+            if (it == mBlocks.end())
+            {
+                continue;
+            }
+            if (mReplicas.count(it->second.first) == 0)
+            {
+                mLruBlocks.erase(it->second.second);
+                mBlocks.erase(it);
+                continue;
+            }
+            matchedBlocks[it->second.first] = bi + 1;
+        }
+
+        auto const leastLoaded = findLeastLoaded(numBlocks, tier);
+        auto const minLoad = mReplicas.at(leastLoaded).getLoad();
+        auto chosen = leastLoaded;
+        SizeType32 chosenMatch{0};
+        for (auto const& [replica, numMatched] : matchedBlocks)
+        {
+            auto const& state = mReplicas.at(replica);
+            if (numMatched > chosenMatch && state.getLoad() <= minLoad + mConfig.maxLoadImbalance
+                && state.hasFreeBlocks(numBlocks - numMatched))
+            {
+                chosen = replica;
+                chosenMatch = numMatched;
+            }
+        }
+
+        auto& state = mReplicas.at(chosen);
+        ++state.numRoutedRequests;
+        state.numRoutedBlocks += numBlocks - chosenMatch;
+        for (auto const hash : blockHashes)
+        {
+            rememberBlock(hash, chosen);
+        }
+        return chosen;
+    }
+
+    /// @brief Route a request and enqueue it in the chosen replica.
+    [[nodiscard]] RoutedId enqueueRequest(Request const& request, KvPrecisionTier tier = KvPrecisionTier::kFULL)
+    {
+        auto const replica = route(request, tier);
+        std::shared_ptr<TExecutor> executor;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            executor = mReplicas.at(replica).executor;
+        }
+        return RoutedId{replica, executor->enqueueRequest(request)};
+    }
+
+    /// @brief The executor of a replica, e.g. to await its responses or cancel one of its requests.
+    [[nodiscard]] std::shared_ptr<TExecutor> getExecutor(ReplicaId replica) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto it = mReplicas.find(replica);
+        TLLM_CHECK_WITH_INFO(it != mReplicas.end(), "Unknown replica %d", replica);
+        return it->second.executor;
+    }
+
+private:
+    struct Replica
+    {
+        std::shared_ptr<TExecutor> executor;
+        KvPrecisionTier tier{KvPrecisionTier::kFULL};
+        // From the latest iteration stats
+        SizeType32 numRequests{0};
+        std::optional<SizeType32> freeNumBlocks;
+        // Routed since the latest iteration stats
+        SizeType32 numRoutedRequests{0};
+        SizeType32 numRoutedBlocks{0};
+
+        [[nodiscard]] SizeType32 getLoad() const
+        {
+            return numRequests + numRoutedRequests;
+        }
+
+        [[nodiscard]] SizeType32 getFreeBlocks() const
+        {
+            return freeNumBlocks ? *freeNumBlocks - numRoutedBlocks : std::numeric_limits<SizeType32>::max();
+        }
+
+        [[nodiscard]] bool hasFreeBlocks(SizeType32 numBlocks) const
+        {
+            return getFreeBlocks() >= numBlocks;
+        }
+    };
+
+    [[nodiscard]] std::vector<std::pair<ReplicaId, std::shared_ptr<TExecutor>>> getExecutors() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<std::pair<ReplicaId, std::shared_ptr<TExecutor>>> executors;
+        for (auto const& [id, state] : mReplicas)
+        {
+            executors.emplace_back(id, state.executor);
+        }
+        return executors;
+    }
+
+    [[nodiscard]] bool hasReplicaOfTier(KvPrecisionTier tier) const
+    {
+        return std::any_of(
+            mReplicas.begin(), mReplicas.end(), [tier](auto const& replica) { return replica.second.tier == tier; });
+    }
+
+    /// @brief Replicas with the free blocks for the request first, then the fewest requests, then the most free blocks.
+    [[nodiscard]] ReplicaId findLeastLoaded(SizeType32 numBlocks, KvPrecisionTier tier) const
+    {
+        auto const ofTier = [tier](auto const& replica) { return replica.second.tier == tier; };
+        auto best = std::find_if(mReplicas.begin(), mReplicas.end(), ofTier);
+        for (auto it = std::next(best); it != mReplicas.end(); ++it)
+        {
+            if (!ofTier(*it))
+            {
+                continue;
+            }
+            auto const& state = it->second;
+            auto const& bestState = best->second;
+            auto const fits = state.hasFreeBlocks(numBlocks);
+            auto const bestFits = bestState.hasFreeBlocks(numBlocks);
+            if (fits != bestFits)
+            {
+                best = fits ? it : best;
+            }
+            else if (state.getLoad() != bestState.getLoad())
+            {
+                best = state.getLoad() < bestState.getLoad() ? it : best;
+            }
+            else if (state.getFreeBlocks() > bestState.getFreeBlocks())
+            {
+                best = it;
+            }
+        }
+        return best->first;
+    }
+
+    /// @brief Hash of every whole block of the prompt, each one covering the blocks before it like the block keys of
+    /// the block manager.
+    [[nodiscard]] std::vector<std::uint64_t> hashBlocks(
+        VecTokens const& tokens, IdType loraTaskId, KvPrecisionTier tier) const
+    {
+        auto const numBlocks = static_cast<SizeType32>(tokens.size()) / mConfig.tokensPerBlock;
+        std::vector<std::uint64_t> hashes(numBlocks);
+        std::uint64_t hash = loraTaskId ^ (static_cast<std::uint64_t>(tier) << 63);
+        for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+        {
+            for (SizeType32 ti = 0; ti < mConfig.tokensPerBlock; ++ti)
+            {
+                auto const token = static_cast<std::uint32_t>(tokens[bi * mConfig.tokensPerBlock + ti]);
+                hash ^= token + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2);
+            }
+            hashes[bi] = hash;
+        }
+        return hashes;
+    }
+
+    void rememberBlock(std::uint64_t hash, ReplicaId replica)
+    {
+        auto it = mBlocks.find(hash);
+        if (it != mBlocks.end())
+        {
+            mLruBlocks.splice(mLruBlocks.end(), mLruBlocks, it->second.second);
+            it->second.first = replica;
+            return;
+        }
+        if (mBlocks.size() >= mConfig.maxTrackedBlocks)
+        {
+            mBlocks.erase(mLruBlocks.front());
+            mLruBlocks.pop_front();
+        }
+        mBlocks.emplace(hash, std::make_pair(replica, mLruBlocks.insert(mLruBlocks.end(), hash)));
+    }
+
+    Config const mConfig;
+    mutable std::mutex mMutex;
+    std::map<ReplicaId, Replica> mReplicas;
+    ReplicaId mNextReplicaId{0};
+    // Replica that last received each prefix block, and position in mLruBlocks
+    std::unordered_map<std::uint64_t, std::pair<ReplicaId, std::list<std::uint64_t>::iterator>> mBlocks;
+    std::list<std::uint64_t> mLruBlocks;
+};
+
+using DataParallelRouter = BasicDataParallelRouter<Executor>;
+
+} // namespace tensorrt_llm::executor
@@ -269,6 +269,9 @@ public:
     /// @brief This logits postprocessor name will dispatch to the batched logits postprocessor
     static auto constexpr kBatchedPostProcessorName = "batched";
 
+    /// @brief Priority of requests without explicit priority. Priorities are in [0, 1], higher runs first.
+    static PriorityType constexpr kDefaultPriority = 0.5f;
+
     Request(Request const& other);
     Request(Request&& other) noexcept;
     Request& operator=(Request const& other);
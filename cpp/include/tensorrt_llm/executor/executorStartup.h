@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Phases of the startup of an executor, in order.
+enum class StartupPhase : std::int8_t
+{
+    /// @brief The engine is deserialized, its contexts are created and its pools allocated.
+    kCREATING = 0,
+    /// @brief Synthetic batches run through the executor, to build the JIT kernels and CUDA graphs and to look up the
+    /// tactics before real requests need them.
+    kWARMING_UP = 1,
+    kREADY = 2,
+    kFAILED = 3,
+};
+
+/// @brief Creates an executor and warms it up in the background, and reports the phase of the startup, e.g. to the
+/// readiness probe of an autoscaler so that no traffic is sent to a cold instance.
+///
+///        The warm-up runs, for each bucket of the config, one batch of batchSize requests of inputLength synthetic
+///        tokens, which generate maxNewTokens tokens each. The buckets are usually the batch sizes and sequence
+///        lengths the engine was built for. The prompts of the requests differ, so that they are not reused from the
+///        KV cache of each other. With serveWhileWarming, the executor serves as soon as it is created, the first
+///        requests of each shape may then be slower. Requests served while warming must be awaited by id, the
+///        responses of the warm-up requests are awaited by the warm-up.
+/// @tparam TExecutor The executor type, Executor. It must provide enqueueRequests and awaitResponses by ids.
+template <typename TExecutor>
+class BasicExecutorStartup
+{
+public:
+    /// @brief Creates the executor, e.g. from an engine directory. Runs in the startup thread.
+    using Factory = std::function<std::shared_ptr<TExecutor>()>;
+
+    struct Bucket
+    {
+        SizeType32 batchSize{1};
+        SizeType32 inputLength{1};
+    };
+
+    struct Config
+    {
+        std::vector<Bucket> buckets;
+        /// @brief Tokens generated by each warm-up request, more than one to warm up the generation phase as well.
+        SizeType32 maxNewTokens{2};
+        /// @brief The synthetic tokens are in [1, maxTokenId], below the vocabulary size of the model.
+        TokenIdType maxTokenId{100};
+        /// @brief Serve requests during the warm-up rather than after it.
+        bool serveWhileWarming{false};
+    };
+
+    struct Stats
+    {
+        std::chrono::milliseconds creationTime{0};
+        std::chrono::milliseconds warmupTime{0};
+        /// @brief Buckets warmed up so far.
+        SizeType32 numWarmedBuckets{0};
+        /// @brief Warm-up requests that returned an error.
+        SizeType32 numFailedRequests{0};
+    };
+
+    /// @brief Start creating and warming up the executor in a background thread.
+    BasicExecutorStartup(Factory factory, Config config)
+        : mConfig{std::move(config)}
+    {
+        TLLM_CHECK(factory);
+        TLLM_CHECK(mConfig.maxNewTokens > 0);
+        TLLM_CHECK(mConfig.maxTokenId > 0);
+        for (auto const& bucket : mConfig.buckets)
+        {
+            TLLM_CHECK_WITH_INFO(bucket.batchSize > 0 && bucket.inputLength > 0,
+                "Invalid warm-up bucket of %d requests of %d tokens", bucket.batchSize, bucket.inputLength);
+        }
+        mThread = std::thread([this, factory = std::move(factory)]() { run(factory); });
+    }
+
+    ~BasicExecutorStartup()
+    {
+        mThread.join();
+    }
+
+    BasicExecutorStartup(BasicExecutorStartup const&) = delete;
+    BasicExecutorStartup& operator=(BasicExecutorStartup const&) = delete;
+
+    [[nodiscard]] StartupPhase getPhase() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mPhase;
+    }
+
+    /// @brief Whether requests can be sent to the executor: it is ready, or warming up with serveWhileWarming.
+    [[nodiscard]] bool isServing() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return isServingLocked();
+    }
+
+    /// @brief Wait until the executor serves or the startup fails.
+    /// @return Whether the executor serves, false on failure or timeout.
+    [[nodiscard]] bool waitUntilServing(std::optional<std::chrono::milliseconds> const& timeout = std::nullopt)
+    {
+        std::unique_lock<std::mutex> lock(mMutex);
+        auto const done = [this]() { return isServingLocked() || mPhase == StartupPhase::kFAILED; };
+        if (timeout)
+        {
+            mCondition.wait_for(lock, *timeout, done);
+        }
+        else
+        {
+            mCondition.wait(lock, done);
+        }
+        return isServingLocked();
+    }
+
+    /// @brief The executor, once it serves.
+    [[nodiscard]] std::shared_ptr<TExecutor> getExecutor() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        TLLM_CHECK_WITH_INFO(isServingLocked(), "The executor does not serve yet");
+        return mExecutor;
+    }
+
+    /// @brief The reason of the failure of the startup, if it failed.
+    [[nodiscard]] std::optional<std::string> getError() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mError;
+    }
+
+    [[nodiscard]] Stats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    [[nodiscard]] bool isServingLocked() const
+    {
+        return mPhase == StartupPhase::kREADY || (mPhase == StartupPhase::kWARMING_UP && mConfig.serveWhileWarming);
+    }
+
+    void setPhase(StartupPhase phase)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mPhase = phase;
+        }
+        mCondition.notify_all();
+    }
+
+    [[nodiscard]] static std::chrono::milliseconds since(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start);
+    }
+
+    void run(Factory const& factory)
+    {
+        try
+        {
+            auto const creationStart = Clock::now();
+            auto executor = factory();
+            TLLM_CHECK_WITH_INFO(executor != nullptr, "The factory created no executor");
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mExecutor = executor;
+                mStats.creationTime = since(creationStart);
+            }
+            setPhase(StartupPhase::kWARMING_UP);
+
+            auto const warmupStart = Clock::now();
+            for (auto const& bucket : mConfig.buckets)
+            {
+                auto const numFailed = warmUp(*executor, bucket);
+                std::lock_guard<std::mutex> lock(mMutex);
+                ++mStats.numWarmedBuckets;
+                mStats.numFailedRequests += numFailed;
+                mStats.warmupTime = since(warmupStart);
+            }
+            setPhase(StartupPhase::kREADY);
+        }
+        catch (std::exception const& e)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mMutex);
+                mError = e.what();
+            }
+            setPhase(StartupPhase::kFAILED);
+        }
+    }
+
+    /// @brief Run one batch of the bucket to completion.
+    /// @return The number of requests that failed.
+    SizeType32 warmUp(TExecutor& executor, Bucket const& bucket)
+    {
+        std::vector<Request> requests;
+        requests.reserve(bucket.batchSize);
+        for (SizeType32 ri = 0; ri < bucket.batchSize; ++ri)
+        {
+            VecTokens tokens(bucket.inputLength);
+            for (SizeType32 ti = 0; ti < bucket.inputLength; ++ti)
+            {
+                tokens[ti] = 1 + static_cast<TokenIdType>((mNumWarmupRequests + ti) % mConfig.maxTokenId);
+            }
+            ++mNumWarmupRequests;
+            requests.emplace_back(std::move(tokens), mConfig.maxNewTokens);
+        }
+
+        auto pending = executor.enqueueRequests(requests);
+        SizeType32 numFailed{0};
+        while (!pending.empty())
+        {
+            auto const responses = executor.awaitResponses(pending);
+            std::vector<IdType> stillPending;
+            for (std::size_t i = 0; i < pending.size(); ++i)
+            {
+                auto finished = false;
+                for (auto const& response : responses.at(i))
+                {
+                    if (response.hasError())
+                    {
+                        ++numFailed;
+                        finished = true;
+                    }
+                    else
+                    {
+                        finished = finished || response.getResult().isFinal;
+                    }
+                }
+                if (!finished)
+                {
+                    stillPending.push_back(pending[i]);
+                }
+            }
+            pending = std::move(stillPending);
+        }
+        return numFailed;
+    }
+
+    Config const mConfig;
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    StartupPhase mPhase{StartupPhase::kCREATING};
+    std::shared_ptr<TExecutor> mExecutor;
+    std::optional<std::string> mError;
+    Stats mStats;
+    // Used by the startup thread only
+    std::uint64_t mNumWarmupRequests{0};
+    // Started last, it uses the members above
+    std::thread mThread;
+};
+
+using ExecutorStartup = BasicExecutorStartup<Executor>;
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,370 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <variant>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Monotonic counter, updated without locks.
+class MetricsCounter
+{
+public:
+    void add(std::uint64_t value = 1) noexcept
+    {
+        mValue.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::uint64_t get() const noexcept
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<std::uint64_t> mValue{0};
+};
+
+/// @brief Last value of a quantity, updated without locks.
+class MetricsGauge
+{
+public:
+    void set(double value) noexcept
+    {
+        mValue.store(value, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] double get() const noexcept
+    {
+        return mValue.load(std::memory_order_relaxed);
+    }
+
+private:
+    std::atomic<double> mValue{0.};
+};
+
+/// @brief Histogram of non-negative integers with a bounded relative error, in the style of HDR histograms, updated
+///        without locks.
+/// @details Values below 2^precisionBits have a bucket each. Above, each power of two is split into 2^precisionBits
+///          buckets, so the relative error is below 2^-precisionBits. Values from 2^maxExponent on share the last
+///          bucket.
+class MetricsHistogram
+{
+public:
+    explicit MetricsHistogram(SizeType32 precisionBits = 4, SizeType32 maxExponent = 40)
+        : mPrecisionBits{precisionBits}
+        , mMaxExponent{maxExponent}
+        , mNumBuckets{(static_cast<std::size_t>(maxExponent - precisionBits) + 1) << precisionBits}
+        , mCounts{std::make_unique<std::atomic<std::uint64_t>[]>(mNumBuckets)}
+    {
+        TLLM_CHECK(precisionBits >= 0 && maxExponent > precisionBits && maxExponent < 64);
+    }
+
+    void record(std::uint64_t value, std::uint64_t count = 1) noexcept
+    {
+        mCounts[bucketIndex(value)].fetch_add(count, std::memory_order_relaxed);
+        mSum.fetch_add(value * count, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::size_t getNumBuckets() const noexcept
+    {
+        return mNumBuckets;
+    }
+
+    [[nodiscard]] std::size_t bucketIndex(std::uint64_t value) const noexcept
+    {
+        auto const subBuckets = std::uint64_t{1} << mPrecisionBits;
+        if (value < subBuckets)
+        {
+            return value;
+        }
+        auto const msb = static_cast<SizeType32>(63 - __builtin_clzll(value));
+        if (msb >= mMaxExponent)
+        {
+            return mNumBuckets - 1;
+        }
+        auto const shift = msb - mPrecisionBits;
+        return ((shift + 1) << mPrecisionBits) + ((value >> shift) - subBuckets);
+    }
+
+    /// @brief Largest value counted in a bucket.
+    [[nodiscard]] std::uint64_t bucketUpperBound(std::size_t index) const noexcept
+    {
+        auto const subBuckets = std::size_t{1} << mPrecisionBits;
+        if (index < subBuckets)
+        {
+            return index;
+        }
+        if (index == mNumBuckets - 1)
+        {
+            return std::numeric_limits<std::uint64_t>::max();
+        }
+        auto const shift = (index >> mPrecisionBits) - 1;
+        auto const sub = (index & (subBuckets - 1)) + subBuckets;
+        return ((sub + 1) << shift) - 1;
+    }
+
+    [[nodiscard]] std::uint64_t getCount() const noexcept
+    {
+        std::uint64_t count{0};
+        for (std::size_t i = 0; i < mNumBuckets; ++i)
+        {
+            count += mCounts[i].load(std::memory_order_relaxed);
+        }
+        return count;
+    }
+
+    [[nodiscard]] std::uint64_t getSum() const noexcept
+    {
+        return mSum.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] std::uint64_t getBucketCount(std::size_t index) const noexcept
+    {
+        return mCounts[index].load(std::memory_order_relaxed);
+    }
+
+    /// @brief Upper bound of the bucket holding the given quantile in [0, 1], 0 if nothing was recorded.
+    [[nodiscard]] std::uint64_t getQuantile(double quantile) const noexcept
+    {
+        auto const count = getCount();
+        if (count == 0)
+        {
+            return 0;
+        }
+        auto const rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(quantile * count)));
+        std::uint64_t seen{0};
+        for (std::size_t i = 0; i < mNumBuckets; ++i)
+        {
+            seen += mCounts[i].load(std::memory_order_relaxed);
+            if (seen >= rank)
+            {
+                return bucketUpperBound(i);
+            }
+        }
+        return bucketUpperBound(mNumBuckets - 1);
+    }
+
+private:
+    SizeType32 mPrecisionBits;
+    SizeType32 mMaxExponent;
+    std::size_t mNumBuckets;
+    std::unique_ptr<std::atomic<std::uint64_t>[]> mCounts;
+    std::atomic<std::uint64_t> mSum{0};
+};
+
+/// @brief Named metrics rendered in the OpenMetrics text format, e.g. for a Prometheus scrape endpoint.
+/// @details Metrics are registered once and keep their address, updating them takes no lock. Rendering reads the
+///          current values, it doesn't need to stop the updates. Histograms are exposed with one bucket per power of
+///          two, their full resolution is available through MetricsHistogram::getQuantile.
+class MetricsRegistry
+{
+public:
+    MetricsCounter& addCounter(std::string name, std::string help)
+    {
+        return add<MetricsCounter>(std::move(name), std::move(help));
+    }
+
+    MetricsGauge& addGauge(std::string name, std::string help)
+    {
+        return add<MetricsGauge>(std::move(name), std::move(help));
+    }
+
+    MetricsHistogram& addHistogram(std::string name, std::string help)
+    {
+        return add<MetricsHistogram>(std::move(name), std::move(help));
+    }
+
+    [[nodiscard]] std::string renderOpenMetrics() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::ostringstream os;
+        for (auto const& entry : mEntries)
+        {
+            std::visit([&](auto const& metric) { render(os, entry.name, entry.help, *metric); }, entry.metric);
+        }
+        os << "# EOF\n";
+        return os.str();
+    }
+
+private:
+    using MetricPtr = std::variant<std::unique_ptr<MetricsCounter>, std::unique_ptr<MetricsGauge>,
+        std::unique_ptr<MetricsHistogram>>;
+
+    struct Entry
+    {
+        std::string name;
+        std::string help;
+        MetricPtr metric;
+    };
+
+    template <typename TMetric>
+    TMetric& add(std::string name, std::string help)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        TLLM_CHECK_WITH_INFO(std::none_of(mEntries.begin(), mEntries.end(),
+                                 [&name](auto const& entry) { return entry.name == name; }),
+            "Metric %s is already registered", name.c_str());
+        auto metric = std::make_unique<TMetric>();
+        auto& ref = *metric;
+        mEntries.push_back(Entry{std::move(name), std::move(help), std::move(metric)});
+        return ref;
+    }
+
+    static void render(std::ostream& os, std::string const& name, std::string const& help, MetricsCounter const& metric)
+    {
+        os << "# TYPE " << name << " counter\n# HELP " << name << " " << help << "\n";
+        os << name << "_total " << metric.get() << "\n";
+    }
+
+    static void render(std::ostream& os, std::string const& name, std::string const& help, MetricsGauge const& metric)
+    {
+        os << "# TYPE " << name << " gauge\n# HELP " << name << " " << help << "\n";
+        os << name << " " << metric.get() << "\n";
+    }
+
+    static void render(
+        std::ostream& os, std::string const& name, std::string const& help, MetricsHistogram const& metric)
+    {
+        os << "# TYPE " << name << " histogram\n# HELP " << name << " " << help << "\n";
+        // Cumulative counts at the powers of two, which are bucket boundaries at any precision
+        std::uint64_t cumulative{0};
+        std::uint64_t nextBound{1};
+        for (std::size_t i = 0; i + 1 < metric.getNumBuckets(); ++i)
+        {
+            cumulative += metric.getBucketCount(i);
+            if (metric.bucketUpperBound(i) == nextBound - 1)
+            {
+                os << name << "_bucket{le=\"" << nextBound - 1 << "\"} " << cumulative << "\n";
+                nextBound <<= 1;
+            }
+        }
+        cumulative += metric.getBucketCount(metric.getNumBuckets() - 1);
+        os << name << "_bucket{le=\"+Inf\"} " << cumulative << "\n";
+        os << name << "_count " << cumulative << "\n";
+        os << name << "_sum " << metric.getSum() << "\n";
+    }
+
+    mutable std::mutex mMutex;
+    std::deque<Entry> mEntries;
+};
+
+/// @brief Metrics of the iterations of an executor, fed with the stats of Executor::getLatestIterationStats instead
+///        of their JSON strings. The distributions of the iterations are kept, not only their latest values.
+class IterationStatsMetrics
+{
+public:
+    explicit IterationStatsMetrics(std::string const& prefix = "trtllm_")
+        : mIterations{mRegistry.addCounter(prefix + "iterations", "Executor iterations")}
+        , mContextTokens{mRegistry.addCounter(prefix + "context_tokens", "Context tokens processed")}
+        , mGenerationTokens{mRegistry.addCounter(prefix + "generation_tokens", "Tokens generated")}
+        , mIterationLatency{mRegistry.addHistogram(
+              prefix + "iteration_latency_microseconds", "Latency of the iterations in microseconds")}
+        , mBatchSize{mRegistry.addHistogram(prefix + "batch_size", "Requests scheduled per iteration")}
+        , mTokensPerIteration{mRegistry.addHistogram(
+              prefix + "tokens_per_iteration", "Context and generation tokens per iteration")}
+        , mQueueDepth{mRegistry.addHistogram(prefix + "queue_depth", "Queued requests per iteration")}
+        , mActiveRequests{mRegistry.addGauge(prefix + "active_requests", "Active requests")}
+        , mQueuedRequests{mRegistry.addGauge(prefix + "queued_requests", "Queued requests")}
+        , mKvCacheUtilization{mRegistry.addGauge(prefix + "kv_cache_utilization", "Share of the KV cache blocks used")}
+        , mGpuMemory{mRegistry.addGauge(prefix + "gpu_memory_bytes", "GPU memory used in bytes")}
+    {
+    }
+
+    void observe(IterationStats const& stats)
+    {
+        mIterations.add();
+        mIterationLatency.record(static_cast<std::uint64_t>(std::llround(stats.iterLatencyMS * 1000.)));
+        mQueueDepth.record(static_cast<std::uint64_t>(std::max(stats.numQueuedRequests, 0)));
+        mActiveRequests.set(stats.numActiveRequests);
+        mQueuedRequests.set(stats.numQueuedRequests);
+        mGpuMemory.set(static_cast<double>(stats.gpuMemUsage));
+
+        std::uint64_t batchSize{0};
+        std::uint64_t contextTokens{0};
+        std::uint64_t generationTokens{0};
+        if (stats.inflightBatchingStats)
+        {
+            auto const& ifb = stats.inflightBatchingStats.value();
+            batchSize = ifb.numScheduledRequests;
+            contextTokens = ifb.numCtxTokens;
+            generationTokens = static_cast<std::uint64_t>(
+                std::llround(ifb.numGenRequests * std::max(ifb.avgNumDecodedTokensPerIter, 1.f)));
+        }
+        else if (stats.staticBatchingStats)
+        {
+            auto const& sb = stats.staticBatchingStats.value();
+            batchSize = sb.numScheduledRequests;
+            contextTokens = sb.numCtxTokens;
+            generationTokens = sb.numGenTokens;
+        }
+        mBatchSize.record(batchSize);
+        mTokensPerIteration.record(contextTokens + generationTokens);
+        mContextTokens.add(contextTokens);
+        mGenerationTokens.add(generationTokens);
+
+        if (stats.kvCacheStats && stats.kvCacheStats->maxNumBlocks > 0)
+        {
+            mKvCacheUtilization.set(
+                static_cast<double>(stats.kvCacheStats->usedNumBlocks) / stats.kvCacheStats->maxNumBlocks);
+        }
+    }
+
+    [[nodiscard]] MetricsRegistry& getRegistry()
+    {
+        return mRegistry;
+    }
+
+    [[nodiscard]] MetricsHistogram const& getIterationLatency() const
+    {
+        return mIterationLatency;
+    }
+
+    [[nodiscard]] std::string renderOpenMetrics() const
+    {
+        return mRegistry.renderOpenMetrics();
+    }
+
+private:
+    MetricsRegistry mRegistry;
+    MetricsCounter& mIterations;
+    MetricsCounter& mContextTokens;
+    MetricsCounter& mGenerationTokens;
+    MetricsHistogram& mIterationLatency;
+    MetricsHistogram& mBatchSize;
+    MetricsHistogram& mTokensPerIteration;
+    MetricsHistogram& mQueueDepth;
+    MetricsGauge& mActiveRequests;
+    MetricsGauge& mQueuedRequests;
+    MetricsGauge& mKvCacheUtilization;
+    MetricsGauge& mGpuMemory;
+};
+
+} // namespace tensorrt_llm::executor
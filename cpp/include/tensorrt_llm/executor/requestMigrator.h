@@ -0,0 +1,297 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/serialization.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief What it takes to resume a paused request on another executor: the original request and the tokens it
+/// generated before the pause.
+struct RequestMigrationState
+{
+    /// @brief The request as first enqueued.
+    Request request;
+    /// @brief Tokens generated before the pause, over all the executors the request ran on.
+    VecTokens generatedTokens;
+
+    /// @brief The request that continues the generation: the generated tokens are appended to the prompt and count
+    /// against maxNewTokens. The random seed is derived from the original seed and the number of generated tokens, so
+    /// a resumed request samples deterministically, though not the tokens the uninterrupted request would have.
+    [[nodiscard]] Request makeResumeRequest() const
+    {
+        auto prompt = request.getInputTokenIds();
+        prompt.insert(prompt.end(), generatedTokens.begin(), generatedTokens.end());
+        auto const numGenerated = static_cast<SizeType32>(generatedTokens.size());
+        TLLM_CHECK_WITH_INFO(numGenerated < request.getMaxNewTokens(), "The request has no token left to generate");
+
+        auto samplingConfig = request.getSamplingConfig();
+        if (numGenerated > 0)
+        {
+            auto const seed = samplingConfig.getRandomSeed().value_or(0);
+            samplingConfig.setRandomSeed(seed ^ (0x9e3779b97f4a7c15ULL * static_cast<RandomSeedType>(numGenerated)));
+        }
+        return Request{std::move(prompt), request.getMaxNewTokens() - numGenerated, request.getStreaming(),
+            samplingConfig, request.getOutputConfig(), request.getEndId(), request.getPadId(), request.getBadWords(),
+            request.getStopWords(), request.getEmbeddingBias(), request.getExternalDraftTokensConfig(),
+            request.getPromptTuningConfig(), request.getLoraConfig(), request.getLogitsPostProcessorName(),
+            request.getEncoderInputTokenIds(), request.getReturnAllGeneratedTokens()};
+    }
+
+    void serialize(std::ostream& os) const
+    {
+        runtime::MemoryTimeline::ScopedTag const memoryTag{runtime::MemoryTimeline::Tag::kSERIALIZATION};
+        Serialization::serialize(request, os);
+        auto const numTokens = static_cast<std::uint64_t>(generatedTokens.size());
+        os.write(reinterpret_cast<char const*>(&numTokens), sizeof(numTokens));
+        os.write(reinterpret_cast<char const*>(generatedTokens.data()),
+            static_cast<std::streamsize>(numTokens * sizeof(TokenIdType)));
+    }
+
+    [[nodiscard]] static RequestMigrationState deserialize(std::istream& is)
+    {
+        runtime::MemoryTimeline::ScopedTag const memoryTag{runtime::MemoryTimeline::Tag::kSERIALIZATION};
+        auto request = Serialization::deserializeRequest(is);
+        std::uint64_t numTokens{0};
+        is.read(reinterpret_cast<char*>(&numTokens), sizeof(numTokens));
+        TLLM_CHECK_WITH_INFO(is.good(), "Truncated request migration state");
+        VecTokens generatedTokens(numTokens);
+        is.read(reinterpret_cast<char*>(generatedTokens.data()),
+            static_cast<std::streamsize>(numTokens * sizeof(TokenIdType)));
+        TLLM_CHECK_WITH_INFO(is.good(), "Truncated request migration state");
+        return RequestMigrationState{std::move(request), std::move(generatedTokens)};
+    }
+};
+
+/// @brief Tracks the tokens generated by the requests of an executor, so that they can be paused and resumed on
+/// another executor, e.g. to drain an instance before a deploy or to rebalance instances.
+///
+///        Requests are enqueued and their responses awaited through the migrator. pause() cancels a request, drains
+///        its responses and returns its migration state, resume() continues it on the executor of another migrator.
+///        The responses of a resumed request are rebased, the client sees the tokens of the whole generation.
+///        The KV cache of the generated tokens is recomputed by the context phase of the resumed request, in one
+///        pass, or reused if its blocks were transferred to the new executor beforehand, e.g. with
+///        KVCacheManager::exportSequence and KvBlockTransfer. Only requests with a beam width of 1 can be migrated.
+/// @tparam TExecutor The executor type, Executor. It must provide enqueueRequest, awaitResponses and cancelRequest.
+template <typename TExecutor>
+class BasicRequestMigrator
+{
+public:
+    /// @brief Result of a pause: the state to resume the request with and the responses drained while pausing, to
+    /// pass to the client. None of them is final, unless the request reached its end or failed before it could be
+    /// paused, in which case there is nothing to resume.
+    struct PausedRequest
+    {
+        RequestMigrationState state;
+        std::vector<Response> responses;
+        bool finished{false};
+    };
+
+    explicit BasicRequestMigrator(std::shared_ptr<TExecutor> executor)
+        : mExecutor{std::move(executor)}
+    {
+        TLLM_CHECK(mExecutor);
+    }
+
+    [[nodiscard]] IdType enqueueRequest(Request const& request)
+    {
+        TLLM_CHECK_WITH_INFO(request.getSamplingConfig().getBeamWidth() == 1,
+            "Only requests with a beam width of 1 can be migrated");
+        auto const requestId = mExecutor->enqueueRequest(request);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequests.emplace(requestId, Tracked{RequestMigrationState{request, {}}, request.getInputTokenIds(), {}});
+        return requestId;
+    }
+
+    /// @brief Continue a paused request on the executor of this migrator.
+    [[nodiscard]] IdType resume(RequestMigrationState const& state)
+    {
+        auto resumeRequest = state.makeResumeRequest();
+        auto prompt = resumeRequest.getInputTokenIds();
+        auto const requestId = mExecutor->enqueueRequest(resumeRequest);
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRequests.emplace(requestId, Tracked{state, std::move(prompt), {}});
+        return requestId;
+    }
+
+    /// @brief Await responses of the executor, rebased for the resumed requests.
+    [[nodiscard]] std::vector<Response> awaitResponses(
+        std::optional<std::chrono::milliseconds> const& timeout = std::nullopt)
+    {
+        auto responses = mExecutor->awaitResponses(timeout);
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& response : responses)
+        {
+            response = observe(response);
+        }
+        return responses;
+    }
+
+    /// @brief Cancel a request and return what it takes to resume it. Waits for the final response of the request.
+    [[nodiscard]] PausedRequest pause(IdType requestId)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            TLLM_CHECK_WITH_INFO(mRequests.count(requestId) == 1, "Unknown request %lu", requestId);
+        }
+        mExecutor->cancelRequest(requestId);
+
+        std::vector<Response> drained;
+        auto finished = false;
+        auto done = false;
+        while (!done)
+        {
+            auto const responses = mExecutor->awaitResponses(requestId);
+            std::lock_guard<std::mutex> lock(mMutex);
+            auto const& tracked = mRequests.at(requestId);
+            for (auto const& response : responses)
+            {
+                if (response.hasError())
+                {
+                    drained.push_back(response);
+                    finished = done = true;
+                    continue;
+                }
+                auto result = observe(response, false).getResult();
+                if (result.isFinal)
+                {
+                    // The final response of the cancellation, unless the request reached its end before
+                    done = true;
+                    finished = hasReachedEnd(tracked);
+                    result.isFinal = finished;
+                }
+                drained.emplace_back(requestId, std::move(result));
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto node = mRequests.extract(requestId);
+        auto& tracked = node.mapped();
+        auto state = std::move(tracked.state);
+        state.generatedTokens.insert(
+            state.generatedTokens.end(), tracked.generatedTokens.begin(), tracked.generatedTokens.end());
+        return PausedRequest{std::move(state), std::move(drained), finished};
+    }
+
+    /// @brief Ids of the requests not finished yet, e.g. to pause all of them to drain the executor.
+    [[nodiscard]] std::vector<IdType> getRequestIds() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        std::vector<IdType> requestIds;
+        requestIds.reserve(mRequests.size());
+        for (auto const& [requestId, tracked] : mRequests)
+        {
+            requestIds.push_back(requestId);
+        }
+        return requestIds;
+    }
+
+private:
+    struct Tracked
+    {
+        // The original request and the tokens generated before it was resumed here
+        RequestMigrationState state;
+        // The prompt of the request enqueued here
+        VecTokens prompt;
+        // Tokens generated here
+        VecTokens generatedTokens;
+    };
+
+    /// @brief Whether the request generated maxNewTokens or its end id.
+    [[nodiscard]] static bool hasReachedEnd(Tracked const& tracked)
+    {
+        auto const& request = tracked.state.request;
+        auto const numGenerated = tracked.state.generatedTokens.size() + tracked.generatedTokens.size();
+        auto const& lastTokens
+            = tracked.generatedTokens.empty() ? tracked.state.generatedTokens : tracked.generatedTokens;
+        auto const endId = request.getEndId();
+        return numGenerated >= static_cast<std::size_t>(request.getMaxNewTokens())
+            || (endId && !lastTokens.empty() && lastTokens.back() == *endId);
+    }
+
+    /// @brief Record the tokens of a response and rebase it on the tokens generated before the request was resumed.
+    /// Full outputs are those of non-streaming requests and of requests that return all generated tokens, the others
+    /// only have the new tokens. Full outputs start with the prompt unless excludeInputFromOutput is set.
+    [[nodiscard]] Response observe(Response const& response, bool forgetFinal = true)
+    {
+        auto it = mRequests.find(response.getRequestId());
+        if (it == mRequests.end() || response.hasError())
+        {
+            if (it != mRequests.end() && forgetFinal)
+            {
+                mRequests.erase(it);
+            }
+            return response;
+        }
+        auto& tracked = it->second;
+        auto const& request = tracked.state.request;
+        auto result = response.getResult();
+        if (result.outputTokenIds.empty())
+        {
+            return response;
+        }
+        auto& tokens = result.outputTokenIds.front();
+        auto const fullOutput = !request.getStreaming() || request.getReturnAllGeneratedTokens();
+        auto const excludeInput = request.getOutputConfig().excludeInputFromOutput;
+        if (!fullOutput)
+        {
+            tracked.generatedTokens.insert(tracked.generatedTokens.end(), tokens.begin(), tokens.end());
+        }
+        else
+        {
+            auto const promptLength = excludeInput ? std::size_t{0} : std::min(tracked.prompt.size(), tokens.size());
+            tracked.generatedTokens.assign(tokens.begin() + static_cast<std::ptrdiff_t>(promptLength), tokens.end());
+            // With the prompt, the output already starts with the tokens generated before the request was resumed
+            if (excludeInput && !tracked.state.generatedTokens.empty())
+            {
+                auto const& before = tracked.state.generatedTokens;
+                tokens.insert(tokens.begin(), before.begin(), before.end());
+            }
+        }
+        if (result.isFinal && forgetFinal)
+        {
+            mRequests.erase(it);
+        }
+        return Response{response.getRequestId(), std::move(result)};
+    }
+
+    std::shared_ptr<TExecutor> mExecutor;
+    mutable std::mutex mMutex;
+    std::unordered_map<IdType, Tracked> mRequests;
+};
+
+using RequestMigrator = BasicRequestMigrator<Executor>;
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,327 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/types.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Change of one beam since the previous response of its request
+struct BeamDelta
+{
+    /// @brief Number of tokens of the previous response that are kept, the beam continues with newTokens after them.
+    /// Smaller than the previous length if beam search replaced the end of the beam.
+    SizeType32 keepLength{0};
+
+    /// @brief Tokens appended after the kept ones
+    VecTokens newTokens;
+
+    /// @brief Log probabilities of the new tokens
+    std::optional<VecLogProbs> newLogProbs;
+
+    FinishReason finishReason{FinishReason::kNOT_FINISHED};
+
+    bool operator==(BeamDelta const& other) const
+    {
+        return keepLength == other.keepLength && newTokens == other.newTokens && newLogProbs == other.newLogProbs
+            && finishReason == other.finishReason;
+    }
+};
+
+/// @brief Change of the output of one request since its previous response
+struct ResultDelta
+{
+    IdType requestId{0};
+    bool isFinal{false};
+    std::optional<std::string> errorMsg;
+    std::vector<BeamDelta> beams;
+};
+
+namespace detail
+{
+template <typename T>
+void appendBytes(std::vector<char>& buffer, T const* data, std::size_t count)
+{
+    static_assert(std::is_trivially_copyable_v<T>);
+    auto const offset = buffer.size();
+    buffer.resize(offset + count * sizeof(T));
+    if (count > 0)
+    {
+        std::memcpy(buffer.data() + offset, data, count * sizeof(T));
+    }
+}
+
+template <typename T>
+void appendValue(std::vector<char>& buffer, T const& value)
+{
+    appendBytes(buffer, &value, 1);
+}
+
+class ByteReader
+{
+public:
+    explicit ByteReader(std::vector<char> const& buffer)
+        : mPos{buffer.data()}
+        , mEnd{buffer.data() + buffer.size()}
+    {
+    }
+
+    template <typename T>
+    void readInto(T* data, std::size_t count)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        auto const numBytes = count * sizeof(T);
+        TLLM_CHECK_WITH_INFO(static_cast<std::size_t>(mEnd - mPos) >= numBytes, "Truncated delta buffer");
+        if (count > 0)
+        {
+            std::memcpy(data, mPos, numBytes);
+        }
+        mPos += numBytes;
+    }
+
+    template <typename T>
+    [[nodiscard]] T read()
+    {
+        T value;
+        readInto(&value, 1);
+        return value;
+    }
+
+    [[nodiscard]] bool done() const noexcept
+    {
+        return mPos == mEnd;
+    }
+
+private:
+    char const* mPos;
+    char const* mEnd;
+};
+} // namespace detail
+
+/// @brief Encodes streaming results as deltas against the previously sent output, for all ready requests into one
+/// contiguous buffer.
+///
+///        The size of a buffer grows with the number of new tokens, not with the length of the sequences, also with
+///        getReturnAllGeneratedTokens() and beam search. The buffer uses the byte order of the host:
+///        uint32 numRecords, then per record uint64 requestId, uint8 flags (isFinal, hasError, hasLogProbs), and
+///        either uint32 length + error message, or uint32 numBeams and per beam uint8 finishReason,
+///        uint32 keepLength, uint32 numNewTokens, int32 tokens[numNewTokens] and float logProbs[numNewTokens].
+class ResultDeltaEncoder
+{
+public:
+    static constexpr std::uint8_t kIsFinal = 1 << 0;
+    static constexpr std::uint8_t kHasError = 1 << 1;
+    static constexpr std::uint8_t kHasLogProbs = 1 << 2;
+
+    /// @param returnAllGeneratedTokens Whether results hold the complete beams, see
+    /// OutputConfig::returnAllGeneratedTokens. Otherwise results hold the new tokens only.
+    explicit ResultDeltaEncoder(bool returnAllGeneratedTokens)
+        : mReturnAllGeneratedTokens{returnAllGeneratedTokens}
+    {
+        startBatch();
+    }
+
+    /// @brief Add the delta of a result to the current batch.
+    /// @param finishReasons Finish reason per beam, empty if not known.
+    void add(IdType requestId, Result const& result, std::vector<FinishReason> const& finishReasons = {})
+    {
+        auto const numBeams = static_cast<SizeType32>(result.outputTokenIds.size());
+        TLLM_CHECK(finishReasons.empty() || static_cast<SizeType32>(finishReasons.size()) == numBeams);
+        auto const hasLogProbs = result.logProbs.has_value();
+
+        std::uint8_t flags = result.isFinal ? kIsFinal : 0;
+        flags |= hasLogProbs ? kHasLogProbs : 0;
+        appendHeader(requestId, flags);
+        detail::appendValue(mBuffer, static_cast<std::uint32_t>(numBeams));
+
+        auto& sent = mSentTokens[requestId];
+        sent.resize(std::max(sent.size(), result.outputTokenIds.size()));
+        for (SizeType32 beam = 0; beam < numBeams; ++beam)
+        {
+            auto const& tokens = result.outputTokenIds[beam];
+            auto& sentTokens = sent[beam];
+            std::size_t keepLength = sentTokens.size();
+            if (mReturnAllGeneratedTokens)
+            {
+                auto const limit = std::min(sentTokens.size(), tokens.size());
+                keepLength = std::mismatch(sentTokens.begin(), sentTokens.begin() + limit, tokens.begin()).first
+                    - sentTokens.begin();
+            }
+            auto const newOffset = mReturnAllGeneratedTokens ? keepLength : 0;
+            auto const numNewTokens = tokens.size() - newOffset;
+
+            auto const finishReason = finishReasons.empty() ? FinishReason::kNOT_FINISHED : finishReasons[beam];
+            detail::appendValue(mBuffer, finishReason);
+            detail::appendValue(mBuffer, static_cast<std::uint32_t>(keepLength));
+            detail::appendValue(mBuffer, static_cast<std::uint32_t>(numNewTokens));
+            detail::appendBytes(mBuffer, tokens.data() + newOffset, numNewTokens);
+            if (hasLogProbs)
+            {
+                // Log probs are aligned with the end of the beam, take the ones of the new tokens.
+                auto const& logProbs = result.logProbs.value().at(beam);
+                TLLM_CHECK_WITH_INFO(logProbs.size() >= numNewTokens, "Missing log probs for request %lu beam %d",
+                    requestId, beam);
+                detail::appendBytes(mBuffer, logProbs.data() + logProbs.size() - numNewTokens, numNewTokens);
+            }
+
+            sentTokens.resize(keepLength);
+            sentTokens.insert(sentTokens.end(), tokens.begin() + newOffset, tokens.end());
+        }
+        if (result.isFinal)
+        {
+            mSentTokens.erase(requestId);
+        }
+    }
+
+    /// @brief Add an error to the current batch, the request is finished.
+    void addError(IdType requestId, std::string const& errorMsg)
+    {
+        appendHeader(requestId, kIsFinal | kHasError);
+        detail::appendValue(mBuffer, static_cast<std::uint32_t>(errorMsg.size()));
+        detail::appendBytes(mBuffer, errorMsg.data(), errorMsg.size());
+        mSentTokens.erase(requestId);
+    }
+
+    void add(Response const& response)
+    {
+        if (response.hasError())
+        {
+            addError(response.getRequestId(), response.getErrorMsg());
+        }
+        else
+        {
+            add(response.getRequestId(), response.getResult());
+        }
+    }
+
+    /// @brief Return the buffer of the current batch and start a new one.
+    [[nodiscard]] std::vector<char> flush()
+    {
+        auto buffer = std::move(mBuffer);
+        startBatch();
+        return buffer;
+    }
+
+    /// @brief Number of unfinished requests whose sent output is tracked.
+    [[nodiscard]] SizeType32 getNumTrackedRequests() const noexcept
+    {
+        return static_cast<SizeType32>(mSentTokens.size());
+    }
+
+private:
+    void startBatch()
+    {
+        mBuffer.clear();
+        mNumRecords = 0;
+        detail::appendValue(mBuffer, mNumRecords);
+    }
+
+    void appendHeader(IdType requestId, std::uint8_t flags)
+    {
+        ++mNumRecords;
+        std::memcpy(mBuffer.data(), &mNumRecords, sizeof(mNumRecords));
+        detail::appendValue(mBuffer, requestId);
+        detail::appendValue(mBuffer, flags);
+    }
+
+    bool mReturnAllGeneratedTokens;
+    std::vector<char> mBuffer;
+    std::uint32_t mNumRecords{0};
+    // Output sent so far per unfinished request
+    std::unordered_map<IdType, BeamTokens> mSentTokens;
+};
+
+/// @brief Decodes the buffers of ResultDeltaEncoder and reconstructs the beams of the requests.
+class ResultDeltaDecoder
+{
+public:
+    [[nodiscard]] static std::vector<ResultDelta> decode(std::vector<char> const& buffer)
+    {
+        detail::ByteReader reader{buffer};
+        auto const numRecords = reader.read<std::uint32_t>();
+        std::vector<ResultDelta> deltas(numRecords);
+        for (auto& delta : deltas)
+        {
+            delta.requestId = reader.read<IdType>();
+            auto const flags = reader.read<std::uint8_t>();
+            delta.isFinal = flags & ResultDeltaEncoder::kIsFinal;
+            if (flags & ResultDeltaEncoder::kHasError)
+            {
+                std::string errorMsg(reader.read<std::uint32_t>(), '\0');
+                reader.readInto(errorMsg.data(), errorMsg.size());
+                delta.errorMsg = std::move(errorMsg);
+                continue;
+            }
+            delta.beams.resize(reader.read<std::uint32_t>());
+            for (auto& beam : delta.beams)
+            {
+                beam.finishReason = reader.read<FinishReason>();
+                beam.keepLength = static_cast<SizeType32>(reader.read<std::uint32_t>());
+                beam.newTokens.resize(reader.read<std::uint32_t>());
+                reader.readInto(beam.newTokens.data(), beam.newTokens.size());
+                if (flags & ResultDeltaEncoder::kHasLogProbs)
+                {
+                    beam.newLogProbs.emplace(beam.newTokens.size());
+                    reader.readInto(beam.newLogProbs->data(), beam.newLogProbs->size());
+                }
+            }
+        }
+        TLLM_CHECK_WITH_INFO(reader.done(), "Trailing bytes in delta buffer");
+        return deltas;
+    }
+
+    /// @brief Apply a delta to the beams of its request.
+    /// @return The complete beams of the request after the delta.
+    BeamTokens apply(ResultDelta const& delta)
+    {
+        auto& beams = mTokens[delta.requestId];
+        beams.resize(std::max(beams.size(), delta.beams.size()));
+        for (std::size_t i = 0; i < delta.beams.size(); ++i)
+        {
+            auto const& beamDelta = delta.beams[i];
+            auto& tokens = beams[i];
+            TLLM_CHECK_WITH_INFO(static_cast<std::size_t>(beamDelta.keepLength) <= tokens.size(),
+                "Delta of request %lu keeps more tokens than received", delta.requestId);
+            tokens.resize(beamDelta.keepLength);
+            tokens.insert(tokens.end(), beamDelta.newTokens.begin(), beamDelta.newTokens.end());
+        }
+        if (!delta.isFinal)
+        {
+            return beams;
+        }
+        auto result = std::move(beams);
+        mTokens.erase(delta.requestId);
+        return result;
+    }
+
+private:
+    std::unordered_map<IdType, BeamTokens> mTokens;
+};
+
+} // namespace tensorrt_llm::executor
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/mpscQueue.h"
+#include "tensorrt_llm/executor/executor.h"
+
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::executor
+{
+
+/// @brief Push-based delivery of responses: a dedicated thread awaits the ready responses in bulk and hands every
+/// batch to a callback.
+///
+///        A single thread waits for all requests, instead of one polling thread per consumer. Batches can also go to a
+///        lock-free queue whose file descriptor can be added to an epoll set.
+/// @tparam T The response type, Response for the executor.
+template <typename T>
+class BasicResponseDispatcher
+{
+public:
+    using Batch = std::vector<T>;
+    using AwaitFn = std::function<Batch(std::chrono::milliseconds const&)>;
+    using Callback = std::function<void(Batch&&)>;
+    using Queue = common::NotifyingMpscQueue<Batch>;
+
+    static constexpr std::chrono::milliseconds kDefaultPollTimeout{100};
+
+    /// @param awaitFn Returns the responses that are ready, waiting at most the given timeout.
+    /// @param callback Invoked with every non-empty batch of responses, from the dispatcher thread.
+    /// @param pollTimeout Longest wait in awaitFn, bounds the time stop() takes.
+    BasicResponseDispatcher(
+        AwaitFn awaitFn, Callback callback, std::chrono::milliseconds pollTimeout = kDefaultPollTimeout)
+        : mAwaitFn{std::move(awaitFn)}
+        , mCallback{std::move(callback)}
+        , mPollTimeout{pollTimeout}
+        , mStop{false}
+    {
+        TLLM_CHECK(mAwaitFn && mCallback);
+        mThread = std::thread(&BasicResponseDispatcher::run, this);
+    }
+
+    /// @brief Push every batch of responses to `queue`. The dispatcher waits while the queue is full.
+    BasicResponseDispatcher(AwaitFn awaitFn, Queue& queue, std::chrono::milliseconds pollTimeout = kDefaultPollTimeout)
+        : BasicResponseDispatcher(
+            std::move(awaitFn),
+            [this, &queue](Batch&& batch)
+            {
+                while (!queue.tryPush(std::move(batch)))
+                {
+                    if (mStop.load(std::memory_order_relaxed))
+                    {
+                        TLLM_LOG_WARNING("Response dispatcher stopped with a full queue, dropping %zu responses",
+                            batch.size());
+                        return;
+                    }
+                    std::this_thread::yield();
+                }
+            },
+            pollTimeout)
+    {
+    }
+
+    ~BasicResponseDispatcher()
+    {
+        stop();
+    }
+
+    BasicResponseDispatcher(BasicResponseDispatcher const&) = delete;
+    BasicResponseDispatcher& operator=(BasicResponseDispatcher const&) = delete;
+
+    /// @brief Stop delivering and join the dispatcher thread.
+    void stop()
+    {
+        mStop.store(true, std::memory_order_relaxed);
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+    }
+
+private:
+    void run()
+    {
+        while (!mStop.load(std::memory_order_relaxed))
+        {
+            try
+            {
+                auto batch = mAwaitFn(mPollTimeout);
+                if (!batch.empty())
+                {
+                    mCallback(std::move(batch));
+                }
+            }
+            catch (std::exception const& e)
+            {
+                TLLM_LOG_ERROR("Response dispatcher: %s", e.what());
+            }
+        }
+    }
+
+    AwaitFn mAwaitFn;
+    Callback mCallback;
+    std::chrono::milliseconds mPollTimeout;
+    std::atomic<bool> mStop;
+    std::thread mThread;
+};
+
+using ResponseDispatcher = BasicResponseDispatcher<Response>;
+
+/// @brief Await function of a ResponseDispatcher for all responses of an executor.
+[[nodiscard]] inline ResponseDispatcher::AwaitFn awaitAllResponses(Executor& executor)
+{
+    return [&executor](std::chrono::milliseconds const& timeout) { return executor.awaitResponses(timeout); };
+}
+
+} // namespace tensorrt_llm::executor
@@ -51,6 +51,8 @@ using BeamTokens = std::vector<VecTokens>;
 using IdType = std::uint64_t;
 using IterationType = std::uint64_t;
 using RandomSeedType = std::uint64_t;
+//! Priority of a request or of its cached blocks, in [0, 1], higher is more important
+using PriorityType = float;
 using VecLogProbs = std::vector<FloatType>;
 using StreamPtr = std::shared_ptr<tensorrt_llm::runtime::CudaStream>;
 using LogitsPostProcessor = std::function<void(IdType, Tensor&, BeamTokens const&, StreamPtr const&)>;
@@ -215,6 +217,25 @@ enum class CommunicationMode
                    // execution of the model
 };
 
+/// @brief Why the generation of a beam stopped
+enum class FinishReason : std::uint8_t
+{
+    /// @brief The beam is still being generated
+    kNOT_FINISHED = 0,
+
+    /// @brief The beam generated the end id
+    kEND_ID = 1,
+
+    /// @brief The beam generated one of the stop words
+    kSTOP_WORDS = 2,
+
+    /// @brief The beam reached the maximum number of new tokens
+    kLENGTH = 3,
+
+    /// @brief The request was cancelled
+    kCANCELLED = 4,
+};
+
 /// @brief Struct that holds the stats of a KV cache manager
 struct KvCacheStats
 {
@@ -268,6 +289,69 @@ struct InflightBatchingStats
     float avgNumDecodedTokensPerIter;
 };
 
+/// @brief Struct that holds the expert load of the MoE layers of this rank for a single iteration
+struct MoeLoadStats
+{
+    /// @brief First expert counted by this rank, per MoE layer
+    std::vector<SizeType32> firstExpert;
+    /// @brief Number of tokens routed to each local expert since the previous iteration, per MoE layer
+    std::vector<std::vector<SizeType32>> expertTokenCounts;
+};
+
+/// @brief Struct that holds the time spent in the collectives of one type and strategy of this rank for a single
+/// iteration
+struct CommOpStats
+{
+    /// @brief Collective: "allreduce", "allgather", "reduce_scatter", "send" or "recv"
+    std::string op;
+    /// @brief Implementation of the allreduce, e.g. "NCCL" or "ONESHOT", empty for the other collectives
+    std::string strategy;
+    /// @brief Number of collectives
+    SizeType32 numCalls;
+    /// @brief Time from the start to the end of the collectives on their streams (ms), including the waits for peers
+    double timeMs;
+    /// @brief Size of the reduced, gathered or sent tensors in bytes
+    std::uint64_t bytes;
+};
+
+/// @brief Struct that holds the time spent in the collectives of this rank for a single iteration
+struct CommStats
+{
+    /// @brief Time of all collectives (ms)
+    double totalTimeMs;
+    /// @brief Bytes of all collectives
+    std::uint64_t totalBytes;
+    /// @brief Collectives per type and strategy
+    std::vector<CommOpStats> ops;
+};
+
+/// @brief Struct that holds the memory of one subsystem in one memory type for a single iteration
+struct MemoryTagStats
+{
+    /// @brief Subsystem that allocated the memory: "kv_cache", "decoder", "lora", "workspace", "runtime" or "untagged"
+    std::string tag;
+    /// @brief Memory type: "GPU", "CPU", "PINNED" or "UVM"
+    std::string memoryType;
+    /// @brief Memory at the end of the iteration in bytes
+    size_t currentBytes;
+    /// @brief Highest memory during the iteration in bytes
+    size_t peakBytes;
+    /// @brief Number of allocations during the iteration
+    std::uint64_t numAllocations;
+    /// @brief Number of frees during the iteration
+    std::uint64_t numFrees;
+};
+
+/// @brief Struct that holds the memory recorded by the allocation timeline of this rank for a single iteration
+struct MemoryTimelineStats
+{
+    /// @brief Memory per subsystem and memory type
+    std::vector<MemoryTagStats> tags;
+    /// @brief GPU memory in use that no allocator counts in bytes: CUDA context, library workspaces, NCCL buffers and
+    /// memory allocated by TensorRT itself
+    size_t untrackedGpuBytes;
+};
+
 /// @brief Struct that holds the stats of a single iteration
 struct IterationStats
 {
@@ -297,6 +381,12 @@ struct IterationStats
     std::optional<StaticBatchingStats> staticBatchingStats;
     /// @brief Stats specific to inflight batching
     std::optional<InflightBatchingStats> inflightBatchingStats;
+    /// @brief Stats of the expert load of the MoE layers, set when TRTLLM_ENABLE_MOE_LOAD_STATS=1
+    std::optional<MoeLoadStats> moeLoadStats;
+    /// @brief Stats of the collectives of this rank, set when TRTLLM_ENABLE_COMM_TIMING_STATS=1
+    std::optional<CommStats> commStats;
+    /// @brief Stats of the allocations of this rank, set when TRTLLM_ENABLE_MEMORY_TIMELINE=1
+    std::optional<MemoryTimelineStats> memoryTimelineStats;
 };
 
 /// @brief Enum class that represents the state of a request
@@ -462,6 +552,30 @@ public:
         return *this;
     }
 
+    /// @brief Restrict the sampled tokens of requests with a grammar to the grammar, see ConstrainedDecodingLayer
+    auto constexpr useConstrainedDecoding(bool constrainedDecoding)
+    {
+        mState = setBitTo(kUseConstrainedDecoding, constrainedDecoding);
+        return *this;
+    }
+
+    /// @brief Apply the penalties and sample top-k in one pass over the logits when all requests of a step allow it,
+    /// see FusedSamplingLayer
+    auto constexpr useFusedSampling(bool fusedSampling)
+    {
+        mState = setBitTo(kUseFusedSampling, fusedSampling);
+        return *this;
+    }
+
+    /// @brief Make the sampled tokens of a request depend only on its own logits and random seed, not on the other
+    /// requests of the batch. Pins the kernel configurations of TopK and TopP sampling and always computes the
+    /// probabilities. Can't be combined with fused sampling
+    auto constexpr useBatchInvariant(bool batchInvariant)
+    {
+        mState = setBitTo(kUseBatchInvariant, batchInvariant);
+        return *this;
+    }
+
     [[nodiscard]] bool constexpr isAuto() const
     {
         return anyBitSet(kAuto);
@@ -577,6 +691,21 @@ public:
         return anyBitSet(kStandardStopCriteria | kUseExplicitEosStop);
     }
 
+    bool constexpr isUseConstrainedDecoding() const
+    {
+        return anyBitSet(kUseConstrainedDecoding);
+    }
+
+    bool constexpr isUseFusedSampling() const
+    {
+        return anyBitSet(kUseFusedSampling);
+    }
+
+    bool constexpr isUseBatchInvariant() const
+    {
+        return anyBitSet(kUseBatchInvariant);
+    }
+
     using UnderlyingType = uint32_t;
 
     bool operator==(DecodingMode const& other) const
@@ -621,6 +750,10 @@ private:
     static UnderlyingType constexpr kLookahead{1u << (kNumFlags + 5)};
     static UnderlyingType constexpr kExplicitDraftTokens{1u << (kNumFlags + 6)};
     static UnderlyingType constexpr kTopKTopP{kTopK | kTopP};
+    // After the modes, so that the bits of the existing flags do not change
+    static UnderlyingType constexpr kUseConstrainedDecoding{1u << (kNumFlags + 7)};
+    static UnderlyingType constexpr kUseFusedSampling{1u << (kNumFlags + 8)};
+    static UnderlyingType constexpr kUseBatchInvariant{1u << (kNumFlags + 9)};
 
     [[nodiscard]] bool constexpr anyBitSet(UnderlyingType bits) const
     {
@@ -745,4 +878,12 @@ static_assert(!DecodingMode::ExplicitDraftTokens().isUsePenalty());
 static_assert(DecodingMode::ExplicitDraftTokens().isUseStopCriteria());
 static_assert(!DecodingMode::ExplicitDraftTokens().isUseBanWords());
 static_assert(DecodingMode::ExplicitDraftTokens().isExplicitDraftTokens());
+
+static_assert(!DecodingMode::TopK().isUseFusedSampling());
+static_assert(DecodingMode::TopK().useFusedSampling(true).isUseFusedSampling());
+static_assert(DecodingMode::TopK().useFusedSampling(true).isTopK());
+
+static_assert(!DecodingMode::TopKTopP().isUseBatchInvariant());
+static_assert(DecodingMode::TopKTopP().useBatchInvariant(true).isUseBatchInvariant());
+static_assert(DecodingMode::TopKTopP().useBatchInvariant(true).isTopKandTopP());
 } // namespace tensorrt_llm::executor
@@ -85,6 +85,21 @@ public:
         return -1;
     }
 
+    [[nodiscard]] __host__ __device__ static constexpr float getMinP()
+    {
+        return 0.0f;
+    }
+
+    [[nodiscard]] __host__ __device__ static constexpr float getTypicalP()
+    {
+        return 1.0f;
+    }
+
+    [[nodiscard]] __host__ __device__ static constexpr float getEta()
+    {
+        return 0.0f;
+    }
+
     [[nodiscard]] __host__ __device__ static constexpr float getBeamSearchDiversity()
     {
         return 0.f;
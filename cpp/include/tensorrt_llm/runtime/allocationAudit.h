@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "tensorrt_llm/runtime/iBuffer.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Counts the host heap and device allocations per subsystem, to check that the steady state of the generation
+//! loop does not allocate.
+//! \details The subsystem of an allocation is the MemoryTimeline tag of its thread, see MemoryTimeline::ScopedTag. The
+//! allocators of tllmBuffers.h report their allocations, CPU buffers as host allocations and the other memory types
+//! as device allocations. Host heap allocations made with new are only counted by binaries that replace the global
+//! operator new with one that calls recordHostAllocation, as tests/runtime/allocationAuditTest.cpp does. The counters
+//! are statically initialized and never allocate, so that they can be used from operator new. Disabled by default.
+class AllocationAudit
+{
+public:
+    using Tag = MemoryTimeline::Tag;
+
+    struct Counts
+    {
+        std::uint64_t numHostAllocations{0};
+        std::uint64_t numDeviceAllocations{0};
+    };
+
+    using TagCounts = std::array<Counts, MemoryTimeline::kNumTags>;
+
+    static void setEnabled(bool enabled) noexcept;
+
+    [[nodiscard]] static bool isEnabled() noexcept;
+
+    static void recordHostAllocation() noexcept;
+
+    static void recordAllocation(MemoryType memoryType) noexcept;
+
+    //! \brief Allocations per tag since the previous call, which resets them. Called e.g. once per iteration.
+    [[nodiscard]] static TagCounts takeCounts() noexcept;
+
+    //! \brief The tags that allocated in `counts`, e.g. "decoder: 2 host, 1 device". Empty if none did.
+    [[nodiscard]] static std::string toString(TagCounts const& counts);
+
+    //! \brief Throws if anything was allocated since the previous takeCounts, naming the tags that did.
+    //! \param where what ran since the previous takeCounts, for the message.
+    static void checkNoAllocations(char const* where);
+};
+
+} // namespace tensorrt_llm::runtime
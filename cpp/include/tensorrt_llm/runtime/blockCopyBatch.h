@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <array>
+#include <memory>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Collects the block copies of one scheduling step, e.g. KV cache onboarding and offloading, and issues them
+//! as a single batched copy kernel on a dedicated copy stream.
+//! \details flush() returns an event recorded after the copies. Only work that depends on the copied blocks has to
+//! wait for it, the compute stream is not serialized with the copies otherwise.
+class BlockCopyBatch
+{
+public:
+    using CudaStreamPtr = std::shared_ptr<CudaStream>;
+    using EventPtr = std::shared_ptr<CudaEvent>;
+
+    //! \param blockSizeInBytes Size of every block.
+    //! \param maxNumCopies Maximum number of copies queued between two flushes.
+    //! \param copyStream Stream the copies are issued on.
+    BlockCopyBatch(std::size_t blockSizeInBytes, SizeType32 maxNumCopies, CudaStreamPtr copyStream);
+
+    //! \brief Queue a copy of one block. Both pointers must be device accessible.
+    //! \details Queues are flushed automatically when they are full.
+    void add(void const* src, void* dst);
+
+    //! \brief Issue all queued copies on the copy stream.
+    //! \return Event recorded on the copy stream after the copies, or nullptr if nothing was queued.
+    EventPtr flush();
+
+    [[nodiscard]] SizeType32 getNumQueued() const noexcept
+    {
+        return mNumQueued;
+    }
+
+    [[nodiscard]] CudaStream const& getStream() const noexcept
+    {
+        return *mStream;
+    }
+
+    //! \brief Number of copies issued so far.
+    [[nodiscard]] std::size_t getNumCopied() const noexcept
+    {
+        return mNumCopied;
+    }
+
+private:
+    // Pointer arrays are double buffered, the kernel of the previous flush may still read from the other one.
+    static auto constexpr kNumBuffers = 2;
+
+    std::size_t mBlockSizeInBytes;
+    SizeType32 mMaxNumCopies;
+    CudaStreamPtr mStream;
+
+    std::array<IBuffer::SharedPtr, kNumBuffers> mSrcPointers;
+    std::array<IBuffer::SharedPtr, kNumBuffers> mDstPointers;
+    std::array<EventPtr, kNumBuffers> mBufferDone;
+    SizeType32 mCurrentBuffer;
+    SizeType32 mNumQueued;
+    std::size_t mNumCopied;
+};
+
+} // namespace tensorrt_llm::runtime
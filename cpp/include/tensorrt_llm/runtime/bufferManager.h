@@ -64,6 +64,13 @@ public:
     //! \brief Allocates an `ITensor` of the given dimensions on the GPU, using cudaMallocAsync.
     [[nodiscard]] ITensorPtr gpu(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE) const;
 
+    //! \brief Allocates an `IBuffer` of the given size on the GPU, from the caching pool of the device, with free
+    //! lists per size class and stream. For buffers that are reallocated every iteration.
+    [[nodiscard]] IBufferPtr gpuCached(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE) const;
+
+    //! \brief Allocates an `ITensor` of the given dimensions on the GPU, from the caching pool of the device.
+    [[nodiscard]] ITensorPtr gpuCached(nvinfer1::Dims dims, nvinfer1::DataType type = kBYTE_TYPE) const;
+
     //! \brief Allocates an `IBuffer` of the given size on the GPU, using cudaMalloc.
     [[nodiscard]] static IBufferPtr gpuSync(std::size_t size, nvinfer1::DataType type = kBYTE_TYPE);
 
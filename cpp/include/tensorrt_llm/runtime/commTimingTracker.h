@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Time spent in the collectives enqueued by the communication plugins of this process, measured with CUDA
+//! events around every collective on its stream.
+//! \details The time of a collective includes the wait for its peers, so a slow link or a late peer shows as a long
+//! collective. Collectives enqueued during CUDA graph capture are not timed. Enabled with
+//! TRTLLM_ENABLE_COMM_TIMING_STATS=1.
+class CommTimingTracker
+{
+public:
+    enum class OpType : std::int8_t
+    {
+        kALLREDUCE = 0,
+        kALLGATHER = 1,
+        kREDUCE_SCATTER = 2,
+        kSEND = 3,
+        kRECV = 4,
+    };
+
+    //! Collectives of one type and strategy since the previous takeStats
+    struct OpStats
+    {
+        OpType op;
+        //! Implementation of the allreduce, e.g. "ONESHOT", empty for the other collectives
+        std::string strategy;
+        SizeType32 numCalls{0};
+        float timeMs{0.f};
+        //! Size of the reduced, gathered or sent tensors
+        std::uint64_t bytes{0};
+    };
+
+    //! \brief Times the work enqueued on a stream during its lifetime as one collective. Does nothing when timing is
+    //! disabled or the stream is being captured.
+    class ScopedTiming
+    {
+    public:
+        ScopedTiming(OpType op, std::size_t bytes, cudaStream_t stream, char const* strategy = "");
+
+        ~ScopedTiming();
+
+        ScopedTiming(ScopedTiming const&) = delete;
+        ScopedTiming& operator=(ScopedTiming const&) = delete;
+
+    private:
+        OpType mOp;
+        std::size_t mBytes;
+        cudaStream_t mStream;
+        char const* mStrategy;
+        cudaEvent_t mStart{nullptr};
+    };
+
+    static CommTimingTracker& getInstance();
+
+    [[nodiscard]] static bool isEnabled();
+
+    [[nodiscard]] static char const* getOpName(OpType op);
+
+    //! \brief Wait for the timed collectives and return their time per type and strategy, then clear them.
+    //! \details Call between iterations, the collectives have completed by then.
+    [[nodiscard]] std::vector<OpStats> takeStats();
+
+private:
+    struct Record
+    {
+        OpType op;
+        std::string strategy;
+        std::size_t bytes;
+        cudaEvent_t start;
+        cudaEvent_t end;
+    };
+
+    cudaEvent_t acquireEvent();
+
+    void addRecord(Record record);
+
+    std::mutex mMutex;
+    std::vector<Record> mRecords;
+    // Events are reused across iterations, they are released with the CUDA context.
+    std::vector<cudaEvent_t> mFreeEvents;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,216 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Shape of a generation step a CUDA graph was captured for.
+struct CudaGraphKey
+{
+    SizeType32 batchSize;
+    SizeType32 beamWidth;
+    SizeType32 attentionWindow;
+
+    bool operator==(CudaGraphKey const& other) const
+    {
+        return batchSize == other.batchSize && beamWidth == other.beamWidth && attentionWindow == other.attentionWindow;
+    }
+};
+
+struct CudaGraphKeyHash
+{
+    std::size_t operator()(CudaGraphKey const& key) const
+    {
+        auto seed = std::hash<SizeType32>{}(key.batchSize);
+        for (auto const value : {key.beamWidth, key.attentionWindow})
+        {
+            seed ^= std::hash<SizeType32>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        }
+        return seed;
+    }
+};
+
+//! \brief Rounds the shapes of in-flight generation steps up to a small set of buckets, so that a few captured graphs
+//! cover all batches. The batch is padded to the batch size of its bucket.
+//! \details Kept with a BasicCudaGraphCache by the owner of the generation loop, which pads the step to the bucket of
+//! getKey, launches the cached graph of the bucket or captures one, and captures the graphs of getKeys during warm-up.
+//! Neither class captures or launches graphs itself, and no model option enables them.
+class CudaGraphBuckets
+{
+public:
+    //! \details Batch sizes are bucketed in powers of two up to `maxBatchSize`, attention windows in powers of two
+    //! from `minAttentionWindow` up to `maxAttentionWindow`. The largest bucket is always the maximum itself.
+    CudaGraphBuckets(SizeType32 maxBatchSize, SizeType32 maxBeamWidth, SizeType32 maxAttentionWindow,
+        SizeType32 minAttentionWindow = 1024)
+        : mBatchSizes{makeBuckets(1, maxBatchSize)}
+        , mMaxBeamWidth{maxBeamWidth}
+        , mAttentionWindows{makeBuckets(std::min(minAttentionWindow, maxAttentionWindow), maxAttentionWindow)}
+    {
+        TLLM_CHECK(maxBeamWidth > 0);
+    }
+
+    //! \brief Bucket of a generation step, std::nullopt if the step is larger than all buckets.
+    [[nodiscard]] std::optional<CudaGraphKey> getKey(
+        SizeType32 batchSize, SizeType32 beamWidth, SizeType32 attentionWindow) const
+    {
+        auto const paddedBatchSize = roundUp(mBatchSizes, batchSize);
+        auto const paddedWindow = roundUp(mAttentionWindows, attentionWindow);
+        if (!paddedBatchSize || !paddedWindow || beamWidth <= 0 || beamWidth > mMaxBeamWidth)
+        {
+            return std::nullopt;
+        }
+        return CudaGraphKey{paddedBatchSize.value(), beamWidth, paddedWindow.value()};
+    }
+
+    //! \brief All buckets of beam width `beamWidth`, e.g. to capture the graphs during warm-up.
+    [[nodiscard]] std::vector<CudaGraphKey> getKeys(SizeType32 beamWidth) const
+    {
+        std::vector<CudaGraphKey> keys;
+        keys.reserve(mBatchSizes.size() * mAttentionWindows.size());
+        for (auto const batchSize : mBatchSizes)
+        {
+            for (auto const window : mAttentionWindows)
+            {
+                keys.push_back(CudaGraphKey{batchSize, beamWidth, window});
+            }
+        }
+        return keys;
+    }
+
+    [[nodiscard]] std::vector<SizeType32> const& getBatchSizes() const
+    {
+        return mBatchSizes;
+    }
+
+    [[nodiscard]] std::vector<SizeType32> const& getAttentionWindows() const
+    {
+        return mAttentionWindows;
+    }
+
+private:
+    static std::vector<SizeType32> makeBuckets(SizeType32 minValue, SizeType32 maxValue)
+    {
+        TLLM_CHECK(0 < minValue && minValue <= maxValue);
+        std::vector<SizeType32> buckets;
+        for (auto value = static_cast<std::int64_t>(minValue); value < maxValue; value *= 2)
+        {
+            buckets.push_back(static_cast<SizeType32>(value));
+        }
+        buckets.push_back(maxValue);
+        return buckets;
+    }
+
+    static std::optional<SizeType32> roundUp(std::vector<SizeType32> const& buckets, SizeType32 value)
+    {
+        auto const it = std::lower_bound(buckets.begin(), buckets.end(), value);
+        if (value <= 0 || it == buckets.end())
+        {
+            return std::nullopt;
+        }
+        return *it;
+    }
+
+    std::vector<SizeType32> mBatchSizes;
+    SizeType32 mMaxBeamWidth;
+    std::vector<SizeType32> mAttentionWindows;
+};
+
+//! \brief Captured graphs by bucket, the least recently launched graph is dropped when the cache is full.
+//! \tparam GraphT Instantiated graph, e.g. owning a cudaGraphExec_t.
+template <typename GraphT>
+class BasicCudaGraphCache
+{
+public:
+    //! \param capacity Maximum number of graphs, each graph holds device memory for its kernel parameters.
+    explicit BasicCudaGraphCache(SizeType32 capacity)
+        : mCapacity{capacity}
+    {
+        TLLM_CHECK(mCapacity > 0);
+    }
+
+    //! \brief Graph of `key` or nullptr, marks the graph as most recently used.
+    [[nodiscard]] GraphT* find(CudaGraphKey const& key)
+    {
+        auto const it = mGraphs.find(key);
+        if (it == mGraphs.end())
+        {
+            return nullptr;
+        }
+        mLru.splice(mLru.end(), mLru, it->second.lruPosition);
+        return &it->second.graph;
+    }
+
+    //! \brief Add or replace the graph of `key`, evicting the least recently used graph if the cache is full.
+    GraphT& insert(CudaGraphKey const& key, GraphT&& graph)
+    {
+        if (auto* existing = find(key))
+        {
+            *existing = std::move(graph);
+            return *existing;
+        }
+        if (mGraphs.size() >= static_cast<std::size_t>(mCapacity))
+        {
+            mGraphs.erase(mLru.front());
+            mLru.pop_front();
+        }
+        auto const lruPosition = mLru.insert(mLru.end(), key);
+        return mGraphs.emplace(key, Entry{std::move(graph), lruPosition}).first->second.graph;
+    }
+
+    void clear()
+    {
+        mGraphs.clear();
+        mLru.clear();
+    }
+
+    [[nodiscard]] SizeType32 size() const
+    {
+        return static_cast<SizeType32>(mGraphs.size());
+    }
+
+    [[nodiscard]] SizeType32 getCapacity() const
+    {
+        return mCapacity;
+    }
+
+private:
+    struct Entry
+    {
+        GraphT graph;
+        typename std::list<CudaGraphKey>::iterator lruPosition;
+    };
+
+    SizeType32 mCapacity;
+    std::list<CudaGraphKey> mLru;
+    std::unordered_map<CudaGraphKey, Entry, CudaGraphKeyHash> mGraphs;
+};
+
+} // namespace tensorrt_llm::runtime
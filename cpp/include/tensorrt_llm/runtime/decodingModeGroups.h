@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <iterator>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Decoding mode of each batch slot, to decode requests with different decoding modes in one batch.
+//! \details Kept by the owner of the decoding loop next to one decoder per mode, e.g. a GptDecoderBatch set up with
+//! getModes()[group]. The caller assigns the mode of a request when it takes a slot, sets up the new requests of each
+//! group with the decoder of the group, see splitSlots, and forwards each decoder with the active slots of its group
+//! only, see getActive. Slots of different groups are disjoint, so the decoders can share the sequence lengths and
+//! cache indirection of the step. Speculative decoding modes change the number of tokens the engine produces per step
+//! and can't be mixed, all modes of the groups must be explicit.
+class DecodingModeGroups
+{
+public:
+    using DecodingMode = executor::DecodingMode;
+
+    //! \param modes Decoding modes of the groups, duplicates are merged. Slots use modes[0] by default.
+    DecodingModeGroups(std::vector<DecodingMode> const& modes, SizeType32 maxBatchSize)
+        : mSlotGroups(maxBatchSize, 0)
+    {
+        TLLM_CHECK_WITH_INFO(!modes.empty(), "At least one decoding mode is required");
+        TLLM_CHECK(maxBatchSize > 0);
+        for (auto const& mode : modes)
+        {
+            TLLM_CHECK_WITH_INFO(!mode.isAuto(), "Decoding mode of a group must be explicit");
+            TLLM_CHECK_WITH_INFO(!mode.isMedusa() && !mode.isLookahead() && !mode.isExplicitDraftTokens(),
+                "Speculative decoding modes can't be used in a decoding mode group");
+            if (std::find(mModes.begin(), mModes.end(), mode) == mModes.end())
+            {
+                mModes.push_back(mode);
+            }
+        }
+    }
+
+    [[nodiscard]] std::vector<DecodingMode> const& getModes() const
+    {
+        return mModes;
+    }
+
+    [[nodiscard]] SizeType32 getNumGroups() const
+    {
+        return static_cast<SizeType32>(mModes.size());
+    }
+
+    //! \brief Assign the decoding mode of the request that takes `slot`, the default mode if `mode` is not set.
+    //! \returns the group of the slot
+    SizeType32 setSlotMode(SizeType32 slot, std::optional<DecodingMode> const& mode)
+    {
+        SizeType32 group{0};
+        if (mode.has_value())
+        {
+            auto const it = std::find(mModes.begin(), mModes.end(), mode.value());
+            TLLM_CHECK_WITH_INFO(it != mModes.end(), "The decoding mode of the request is not one of the groups");
+            group = static_cast<SizeType32>(std::distance(mModes.begin(), it));
+        }
+        mSlotGroups.at(slot) = group;
+        return group;
+    }
+
+    [[nodiscard]] SizeType32 getGroup(SizeType32 slot) const
+    {
+        return mSlotGroups.at(slot);
+    }
+
+    //! \brief Indices in `slots` of the slots of each group, in order, e.g. to set up new requests group by group.
+    [[nodiscard]] std::vector<std::vector<SizeType32>> splitSlots(std::vector<SizeType32> const& slots) const
+    {
+        std::vector<std::vector<SizeType32>> indices(mModes.size());
+        for (SizeType32 i = 0; i < static_cast<SizeType32>(slots.size()); ++i)
+        {
+            indices[getGroup(slots[i])].push_back(i);
+        }
+        return indices;
+    }
+
+    //! \brief Active slots of `group` in a step whose active slots are `active`, the decoder of the group skips the
+    //! other slots, including those it decoded before they were taken by a request of another group.
+    [[nodiscard]] std::vector<bool> getActive(SizeType32 group, std::vector<bool> const& active) const
+    {
+        TLLM_CHECK(active.size() <= mSlotGroups.size());
+        std::vector<bool> groupActive(active.size());
+        for (std::size_t slot = 0; slot < active.size(); ++slot)
+        {
+            groupActive[slot] = active[slot] && mSlotGroups[slot] == group;
+        }
+        return groupActive;
+    }
+
+    //! \returns true if some active slot of `active` belongs to `group`, so the decoder of the group has work
+    [[nodiscard]] bool hasActive(SizeType32 group, std::vector<bool> const& active) const
+    {
+        TLLM_CHECK(active.size() <= mSlotGroups.size());
+        for (std::size_t slot = 0; slot < active.size(); ++slot)
+        {
+            if (active[slot] && mSlotGroups[slot] == group)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    std::vector<DecodingMode> mModes;
+    // Index in mModes of the mode of each batch slot
+    std::vector<SizeType32> mSlotGroups;
+};
+
+} // namespace tensorrt_llm::runtime
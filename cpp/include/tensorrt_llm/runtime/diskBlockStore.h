@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <condition_variable>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+class WorkerPool;
+
+//! \brief Fixed-size block store in a file on local storage, used as the tier below the host KV cache pool.
+//! \details Blocks are written asynchronously from pinned staging buffers, so the caller can reuse the source block as
+//! soon as storeAsync returns. Reads go directly into pinned host memory, or through a staging buffer for device
+//! destinations.
+class DiskBlockStore
+{
+public:
+    using SlotIdType = SizeType32;
+
+    //! \param path File backing the store. It is created, and removed on destruction.
+    //! \param blockSize Size of one block in bytes.
+    //! \param numBlocks Capacity of the store in blocks.
+    //! \param numStagingBuffers Number of pinned buffers used to stage writes and device reads.
+    //! \param numWorkers Number of threads issuing file I/O.
+    DiskBlockStore(std::filesystem::path path, std::size_t blockSize, SizeType32 numBlocks,
+        SizeType32 numStagingBuffers = 4, SizeType32 numWorkers = 1);
+
+    ~DiskBlockStore();
+
+    DiskBlockStore(DiskBlockStore const&) = delete;
+    DiskBlockStore& operator=(DiskBlockStore const&) = delete;
+
+    //! \brief Write a block to a free slot.
+    //! \details `src` is copied to a staging buffer before returning, blocks if all staging buffers are in flight.
+    //! \return The slot the block is written to, or std::nullopt if the store is full.
+    [[nodiscard]] std::optional<SlotIdType> storeAsync(IBuffer const& src);
+
+    //! \brief Read the block in `slot` into `dst`, after a pending write to that slot completed.
+    //! \details The memory of `dst` must stay allocated until the returned future is ready, `dst` itself may be a
+    //! temporary view of it.
+    [[nodiscard]] std::shared_future<void> loadAsync(SlotIdType slot, IBuffer& dst);
+
+    //! \brief Return `slot` to the free slots. Pending I/O on the slot is waited for.
+    void release(SlotIdType slot);
+
+    //! \brief Wait until all pending writes completed.
+    void sync();
+
+    [[nodiscard]] std::size_t getBlockSize() const noexcept
+    {
+        return mBlockSize;
+    }
+
+    [[nodiscard]] SizeType32 getMaxNumBlocks() const noexcept
+    {
+        return mNumBlocks;
+    }
+
+    [[nodiscard]] SizeType32 getNumFreeBlocks() const;
+
+private:
+    [[nodiscard]] IBuffer::SharedPtr acquireStagingBuffer();
+
+    void releaseStagingBuffer(IBuffer::SharedPtr buffer);
+
+    void writeBlock(SlotIdType slot, IBuffer const& src) const;
+
+    void readBlock(SlotIdType slot, void* dst) const;
+
+    std::filesystem::path mPath;
+    std::size_t mBlockSize;
+    SizeType32 mNumBlocks;
+    int mFd;
+
+    mutable std::mutex mMutex;
+    std::vector<SlotIdType> mFreeSlots;
+    std::vector<std::shared_future<void>> mPendingIo;
+
+    std::mutex mStagingMutex;
+    std::condition_variable mStagingCv;
+    std::vector<IBuffer::SharedPtr> mFreeStagingBuffers;
+
+    std::unique_ptr<WorkerPool> mWorkerPool;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Decides which checks of the finished state of the decoder block the generation loop of GptSession.
+//! \details With an interval of 1 every check waits for the decoder step. Otherwise only every `interval` steps do, and
+//! the other checks read the finished state only if the decoder step has already completed. Checks always block close
+//! to the maximum sequence length, so that the loop never runs past the KV cache and the output buffers, and when
+//! generation logits are gathered, which have one slot per step.
+class FinishedSyncPolicy
+{
+public:
+    explicit FinishedSyncPolicy(SizeType32 interval = 1)
+        : mInterval{interval}
+    {
+        TLLM_CHECK_WITH_INFO(interval > 0, "finishedSyncInterval must be positive");
+    }
+
+    //! \brief Whether some checks don't block, which then poll an event recorded after each decoder step.
+    [[nodiscard]] bool isPolling() const
+    {
+        return mInterval > 1;
+    }
+
+    //! \brief Whether the check of generation step `step`, counted from 1, waits for the decoder step before it.
+    [[nodiscard]] bool isBlocking(
+        SizeType32 step, SizeType32 maxInputLength, SizeType32 maxSeqLength, bool gatherGenerationLogits) const
+    {
+        return !isPolling() || step % mInterval == 0 || maxInputLength + step + 1 >= maxSeqLength
+            || gatherGenerationLogits;
+    }
+
+    [[nodiscard]] SizeType32 getInterval() const
+    {
+        return mInterval;
+    }
+
+private:
+    SizeType32 mInterval;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief A plugin layer of an engine. TensorRT can't fuse across it, its inputs and outputs go through global memory.
+struct FusionBarrier
+{
+    std::string name;
+    std::string layerType;
+    //! Bytes of the inputs and outputs of the layer per token, the dynamic dimensions counted as one
+    double inputBytesPerToken{0};
+    double outputBytesPerToken{0};
+    //! A plugin that only forwards its input, e.g. the identity plugin that keeps a tensor in the graph
+    bool isNoOp{false};
+
+    [[nodiscard]] double getBytesPerToken() const
+    {
+        return inputBytesPerToken + outputBytesPerToken;
+    }
+};
+
+//! \brief The plugin boundaries of an engine and the activation traffic they cause, from the engine information of
+//! the IEngineInspector.
+//! \details The shapes and types of the layers are only in the engine information of engines built with the detailed
+//! profiling verbosity, otherwise the plugins are found by name and their traffic is unknown. The bytes per token are
+//! an estimate for the tensors whose token dimension is the only dynamic one, e.g. [numTokens, hiddenSize].
+class FusionBarrierReport
+{
+public:
+    //! \param engineInformation The engine information in JSON format, see IEngineInspector::getEngineInformation.
+    explicit FusionBarrierReport(std::string const& engineInformation);
+
+    //! \brief The plugin layers, sorted by decreasing bytes per token.
+    [[nodiscard]] std::vector<FusionBarrier> const& getBarriers() const noexcept
+    {
+        return mBarriers;
+    }
+
+    [[nodiscard]] SizeType32 getNbLayers() const noexcept
+    {
+        return mNbLayers;
+    }
+
+    //! \brief Whether the shapes and types of the layers were available.
+    [[nodiscard]] bool isDetailed() const noexcept
+    {
+        return mDetailed;
+    }
+
+    [[nodiscard]] double getTotalBytesPerToken() const;
+
+    //! \brief Summary and the `numListed` plugin layers with the most traffic, plus all the no-op plugins.
+    [[nodiscard]] std::string report(std::size_t numListed = 20) const;
+
+private:
+    std::vector<FusionBarrier> mBarriers;
+    SizeType32 mNbLayers{0};
+    bool mDetailed{false};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -65,6 +65,7 @@ namespace tensorrt_llm::runtime
 //!    `gather_all_token_logits` parameter enabled.
 //!
 //!    Generation logits can also be obtained through `GenerationOutput.generationLogits` after inference is completed.
+//!    To copy only some positions of the context or generation logits, gather them with `LogitsGatherer`.
 //!  * `onTokenGenerated`, is a callback function invoked in the generation loop to
 //!    pass newly generated tokens to the caller while the loop continues to
 //!    execute. An implementation of that callback must accept the output `ids`
@@ -69,6 +69,13 @@ public:
         ITensor const& finishedVec, ITensor& finishedFinal, ITensor& finishedSum, ITensor const& batchSlots,
         BufferManager::CudaStreamPtr const& stream);
 
+    //! \param finishedSlots [divUp(maxBatchSize, 32)], optional, on gpu. Bit `slot % 32` of word `slot / 32` is set
+    //! if the request in `slot` finishes within its accepted tokens. The bits of the other slots are left unchanged.
+    static void acceptDraftTokensByIds(ITensor const& targetTokenIds, ITensor const& draftTokenIds,
+        ITensor const& contextLengths, ITensor const& numDraftTokens, ITensor& sequenceLengths,
+        ITensor const& finishedVec, ITensor& finishedFinal, ITensor& finishedSum, ITensor* finishedSlots,
+        ITensor const& batchSlots, BufferManager::CudaStreamPtr const& stream);
+
     static void acceptDraftTokensByLogits(ITensor& draftLogits, ITensor const& targetLogits, ITensor& draftProbs,
         ITensor& targetProbs, ITensor const& numDraftTokens, ITensor& finished, ITensor const& batchSlots,
         SizeType32 vocabSize, SizeType32 vocabSizePadded, bool useRandomAcceptThreshold, float randomAcceptThreshold,
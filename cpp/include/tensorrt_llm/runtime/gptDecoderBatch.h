@@ -30,6 +30,11 @@
 namespace tensorrt_llm::runtime
 {
 
+namespace kernels
+{
+struct NewRequestSetup;
+} // namespace kernels
+
 //! GPT decoder class with support for in-flight batching
 class GptDecoderBatch : public IGptDecoderBatch
 {
@@ -47,7 +52,8 @@ public:
     GptDecoderBatch(std::size_t vocabSize, std::size_t vocabSizePadded, CudaStreamPtr stream,
         SpeculativeDecodingMode const& speculativeDecodingMode);
 
-    //! Setup the decoder before calling `forward()`
+    //! Setup the decoder before calling `forward()`. All slots are decoded by the fused decoder, `fusedDecoder` must be
+    //! true.
     void setup(executor::DecodingMode const& mode, SizeType32 maxBatchSize, SizeType32 maxBeamWidth,
         SizeType32 maxAttentionWindow, SizeType32 sinkTokenLength, SizeType32 maxSequenceLength,
         SizeType32 maxTokensPerStep, bool fusedDecoder, nvinfer1::DataType dtype,
@@ -206,8 +212,10 @@ private:
     [[nodiscard]] CudaEvent postProcessRequest(SizeType32 batchIdx,
         std::optional<std::reference_wrapper<SamplingConfig const>> samplingConfig = std::nullopt) const;
 
-    //! @brief Initialize the decoder at `batchSlot` with a new `request`.
-    void newRequest(SizeType32 batchSlot, decoder_batch::Request const& request, SamplingConfig const& samplingConfig);
+    //! @brief Initialize the decoder at `batchSlot` with a new `request`. The fills of the joint buffers are left to
+    //! kernels::invokeInitNewRequests, the request is described in `setup` for it.
+    void newRequest(SizeType32 batchSlot, decoder_batch::Request const& request, SamplingConfig const& samplingConfig,
+        kernels::NewRequestSetup& setup);
 
     //! @brief Allocate buffers for speculative decoding.
     void allocateSpeculativeDecodingBuffers();
@@ -238,13 +246,9 @@ private:
     //! @brief Sets inputs for explicit draft tokens.
     void setExplicitDraftTokensInputs(decoder_batch::Input const& input);
 
-    //! @brief Calls unfused or fused decoders for tokens per engine step
+    //! @brief Calls the fused decoder for tokens per engine step
     void forwardDispatch(decoder_batch::Output& output, decoder_batch::Input const& input, ForwardType forwardType);
 
-    //! @brief Calls unfused decoder for whole batch in loop
-    void forwardUnfusedDecoder(
-        SizeType32 step, decoder_batch::Output& output, decoder_batch::Input const& input, ForwardType forwardType);
-
     //! @brief Calls fused decoder for whole batch
     void forwardFusedDecoder(
         SizeType32 step, decoder_batch::Output& output, decoder_batch::Input const& input, ForwardType forwardType);
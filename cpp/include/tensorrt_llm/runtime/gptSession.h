@@ -28,10 +28,12 @@
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/finishedSyncPolicy.h"
 #include "tensorrt_llm/runtime/generationInput.h"
 #include "tensorrt_llm/runtime/generationOutput.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/modelConfig.h"
+#include "tensorrt_llm/runtime/pipelineBubbleTracker.h"
 #include "tensorrt_llm/runtime/rawEngine.h"
 #include "tensorrt_llm/runtime/samplingConfig.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
@@ -39,9 +41,11 @@
 #include <NvInferRuntime.h>
 
 #include <cstdint>
+#include <filesystem>
 #include <functional>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace tensorrt_llm::batch_manager
@@ -106,6 +110,8 @@ public:
         bool decoderPerRequest{false};
         // Whether the session will use CUDA graphs for the engine   execution in generation phase
         bool cudaGraphMode{false};
+        // Whether the session shares the engine weights with the other sessions of the process on the same engine
+        bool shareEngine{false};
         KvCacheConfig kvCacheConfig{};
         // The micro batch size to be used in context phase.
         // Batches entered in `GptSession::generation` will be split into smaller micro batches of this size
@@ -113,6 +119,22 @@ public:
         // The micro batch size to be used in generation phase.
         // Batches entered in `GptSession::generation` will be split into smaller micro batches of this size.
         std::optional<SizeType32> genMicroBatchSize = std::nullopt;
+        // The number of generation micro batches per pipeline stage if no micro batch size is set.
+        // More micro batches than stages keep every stage busy while the decoder results of a micro batch travel back
+        // from the last stage, at the cost of smaller batches.
+        SizeType32 genMicroBatchesPerStage{1};
+        // Check the finished state of the decoder without blocking except every `finishedSyncInterval` steps.
+        // Between blocking checks the host enqueues the next steps while the GPU still runs the previous ones and
+        // stops only once the decoder results are available, at the cost of a few extra steps on finished sequences.
+        SizeType32 finishedSyncInterval{1};
+        // Whether to sort the requests by input length before splitting a batch into micro batches. Each micro batch
+        // is then padded to its own longest input, or packed from its own inputs, and the outputs keep the order of the
+        // inputs. Not applied when context logits or a token callback are requested.
+        bool sortMicroBatchesByInputLength{false};
+        // Attention window of each attention layer, repeated over the layers if shorter than the number of layers, e.g.
+        // alternating sliding-window and global layers. The KV cache is sized for the largest window, smaller windows
+        // reuse their blocks cyclically. Overrides kvCacheConfig.maxAttentionWindow.
+        std::optional<std::vector<SizeType32>> maxAttentionWindowVec = std::nullopt;
         std::optional<executor::DecodingMode> decodingMode = std::nullopt;
         bool normalizeLogProbs = true;
     };
@@ -240,12 +262,34 @@ public:
     void generate(GenerationOutput& outputs, GenerationInput const& inputs, SamplingConfig const& samplingConfig,
         std::shared_ptr<GenerationProfiler> const generationProfiler = nullptr);
 
+    //! @brief Replace weights of the engine in place between two calls of generate, e.g. with a fine-tuned version.
+    //! The KV cache and the other buffers of the session are kept.
+    //! @param weights New values by the name of the weights in the engine, see TllmRuntime::refitWeights.
+    void refitWeights(StringPtrMap<ITensor> const& weights);
+
     //! @brief Set LayerProfiler to collect performance per layer.
     void setLayerProfiler();
 
+    //! @brief Set LayerProfiler to collect performance per layer.
+    //! @param recordTimeline Also record the layer times of every step as a timeline.
+    void setLayerProfiler(bool recordTimeline);
+
+    //! @brief Write the layer timeline in Chrome trace format, one event per layer and step.
+    void writeLayerTimeline(std::filesystem::path const& path) const;
+
     //! @brief Print profile information per layer.
     [[nodiscard]] std::string getLayerProfileInfo() const;
 
+    //! @brief Total time in milliseconds of every layer since the last getLayerProfileInfo.
+    [[nodiscard]] std::vector<std::pair<std::string, float>> getLayerTimes() const;
+
+    //! @brief Share of the last generation loop in which this rank waited for the decoder results of a micro batch,
+    //! an estimate of the pipeline bubble with pipeline parallelism.
+    [[nodiscard]] double getPipelineBubbleFraction() const
+    {
+        return mBubbleTracker.getBubbleFraction();
+    }
+
 private:
     [[nodiscard]] bool useCudaGraphs()
     {
@@ -277,7 +321,8 @@ private:
     void decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchId);
 
     //! @brief Synchronize with the decoder and return the `shouldStop` flag.
-    bool shouldStopSync(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 microBatchId);
+    //! @param blocking Return `false` without waiting if the decoder step has not completed yet.
+    bool shouldStopSync(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 microBatchId, bool blocking = true);
 
     //! @brief Collect final output ids and log probs on last PP rank and send them to first PP rank.
     //! @details Receives are asynchronous on host, so synchronization is required before access.
@@ -337,7 +382,8 @@ private:
         }
 
         explicit MicroBatchConfig(SizeType32 maxBatchSize, SizeType32 pipelineParallelism,
-            std::optional<SizeType32> genMicroBatchSize, std::optional<SizeType32> ctxMicroBatchSize);
+            std::optional<SizeType32> genMicroBatchSize, std::optional<SizeType32> ctxMicroBatchSize,
+            SizeType32 genMicroBatchesPerStage = 1);
 
         constexpr SizeType32 numCtxPerGen() const
         {
@@ -370,6 +416,7 @@ private:
 
     SizeType32 mDecoderMaxSequenceLength{};
     SizeType32 mDecoderMaxAttentionWindow{};
+    std::vector<SizeType32> mDecoderMaxAttentionWindowVec{};
     SizeType32 mDecoderSinkTokenLength{};
 
     LoggerPtr mLogger;
@@ -381,12 +428,18 @@ private:
     std::vector<std::shared_ptr<IStatefulGptDecoder>> mDecoders;
     std::vector<std::shared_ptr<RuntimeBuffers>> mBuffers;
     std::vector<CudaEvent> mReceivedEvents;
+    // recorded after the decoder step on the last PP rank, to poll its finished state
+    std::vector<CudaEvent> mDecoderStepEvents;
+    FinishedSyncPolicy mFinishedSync;
+    bool mSortMicroBatchesByInputLength{false};
 
     bool mCudaGraphMode{false};
     // ping-pong instances
     std::vector<CudaGraphExecutor> mCudaGraphInstances;
 
     bool mNormalizeLogProbs = true;
+
+    PipelineBubbleTracker mBubbleTracker;
 };
 
 } // namespace tensorrt_llm::runtime
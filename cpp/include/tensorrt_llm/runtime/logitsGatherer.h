@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Gathers selected positions of the context and generation logits of GenerationOutput into compact tensors.
+//! \details The logits stay on the device, in the buffers of GenerationOutput, until the next call of
+//! GptSession::generate, so positions can be gathered on demand, e.g. the last few positions of a prompt or the
+//! positions of the tokens to score, and more can be gathered later. Only the gathered rows are copied, in a single
+//! launch. To score a continuation, run its prompt and the continuation as the input of one request and gather the
+//! log-probabilities of the continuation tokens with getScoringRows and gatherLogProbs.
+class LogitsGatherer
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    explicit LogitsGatherer(BufferManager const& manager);
+
+    //! \brief Gather `rows` of `logits`, viewed as [numRows, vocabSizePadded].
+    //! \param logits on gpu, the vocabulary is the last dimension
+    //! \return [rows.size(), vocabSizePadded], in `memoryType`
+    [[nodiscard]] TensorPtr gather(
+        ITensor const& logits, std::vector<SizeType32> const& rows, MemoryType memoryType = MemoryType::kGPU) const;
+
+    //! \brief Log-probabilities of `tokenIds` under `rows` of `logits`, one token per row. The log-softmax is computed
+    //! on the device, only the log-probabilities are copied.
+    //! \param vocabSize the entries after vocabSize are padding and excluded from the softmax
+    //! \return [rows.size()], float, in `memoryType`
+    [[nodiscard]] TensorPtr gatherLogProbs(ITensor const& logits, std::vector<SizeType32> const& rows,
+        std::vector<TokenIdType> const& tokenIds, SizeType32 vocabSize,
+        MemoryType memoryType = MemoryType::kGPU) const;
+
+    //! \brief Rows of the context logits of `positions` of the prompt of `batchIdx`.
+    //! \param contextLogits [batchSize, maxInputLength, vocabSizePadded], or [packedSize, vocabSizePadded] if packed
+    //! \param inputLengths the lengths of the prompts of the batch
+    [[nodiscard]] static std::vector<SizeType32> getContextRows(ITensor const& contextLogits,
+        std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, std::vector<SizeType32> const& positions);
+
+    //! \brief Rows of the context logits of the last `numPositions` positions of the prompt of `batchIdx`.
+    [[nodiscard]] static std::vector<SizeType32> getLastContextRows(ITensor const& contextLogits,
+        std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, SizeType32 numPositions);
+
+    //! \brief Rows of the context logits predicting the tokens from `begin` to the end of the prompt of `batchIdx`,
+    //! to score a continuation appended to the prompt. The logits of position p predict the token at p + 1.
+    [[nodiscard]] static std::vector<SizeType32> getScoringRows(ITensor const& contextLogits,
+        std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, SizeType32 begin);
+
+    //! \brief Rows of the generation logits of `steps` of `beam` of `batchIdx`.
+    //! \param generationLogits [batchSize, beamWidth, maxOutputLength, vocabSizePadded]
+    [[nodiscard]] static std::vector<SizeType32> getGenerationRows(ITensor const& generationLogits, SizeType32 batchIdx,
+        SizeType32 beam, std::vector<SizeType32> const& steps);
+
+private:
+    static void checkRows(ITensor const& logits, std::vector<SizeType32> const& rows);
+
+    BufferManager const& mManager;
+};
+
+} // namespace tensorrt_llm::runtime
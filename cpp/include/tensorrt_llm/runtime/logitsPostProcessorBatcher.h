@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/tensor.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Adapts a logits post-processor working on the whole batch to executor::LogitsPostProcessorBatched.
+//! \details The executor calls the batched post-processor once per step with one logits tensor per request. The
+//! batcher hands them to `callback` as a single [numRequests, beamWidth, vocabSizePadded] tensor on the device, so a
+//! custom bias can be applied to the whole batch in one kernel on the stream of the decoder. When the logits of the
+//! requests are consecutive rows of one buffer, the tensor is a view of them. Otherwise they are gathered into a
+//! scratch buffer and scattered back after the callback, one launch each. Every request is given a slot, stable for
+//! its lifetime, to index the per request state of the post-processor. release() frees the slot of a finished request.
+class LogitsPostProcessorBatcher
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using RequestIdType = executor::IdType;
+    using BeamTokensRefs = std::vector<std::reference_wrapper<executor::BeamTokens const>>;
+
+    //! \param requestIds the ids of the requests of the batch
+    //! \param slots the slot of each request, in [0, maxNumSlots)
+    //! \param logits [numRequests, beamWidth, vocabSizePadded], on gpu, modified in place
+    //! \param beamTokens the tokens of each request
+    using Callback = std::function<void(std::vector<RequestIdType> const& requestIds,
+        std::vector<SizeType32> const& slots, ITensor& logits, BeamTokensRefs const& beamTokens,
+        CudaStream const& stream)>;
+
+    struct Stats
+    {
+        //! Calls of the post-processor
+        SizeType32 numCalls{0};
+        //! Calls where the logits were viewed in place
+        SizeType32 numViews{0};
+        //! Calls where the logits were gathered and scattered back
+        SizeType32 numGathers{0};
+    };
+
+    LogitsPostProcessorBatcher(SizeType32 maxNumSlots, Callback callback);
+
+    //! \brief The post-processor to set with ExecutorConfig::setLogitsPostProcessorBatched. The batcher must outlive
+    //! the executor.
+    [[nodiscard]] executor::LogitsPostProcessorBatched getLogitsPostProcessorBatched();
+
+    void operator()(std::vector<RequestIdType> const& requestIds, std::vector<executor::Tensor>& logits,
+        BeamTokensRefs const& beamTokens, executor::StreamPtr const& stream);
+
+    //! \brief Free the slot of a finished request. Safe to call from any thread, and for requests without a slot.
+    void release(RequestIdType requestId);
+
+    //! \return the slot of `requestId`, or -1 if it has none
+    [[nodiscard]] SizeType32 getSlot(RequestIdType requestId) const;
+
+    [[nodiscard]] SizeType32 getNumUsedSlots() const;
+
+    [[nodiscard]] Stats getStats() const;
+
+private:
+    std::vector<SizeType32> acquireSlots(std::vector<RequestIdType> const& requestIds);
+
+    SizeType32 mMaxNumSlots;
+    Callback mCallback;
+
+    mutable std::mutex mMutex;
+    std::unordered_map<RequestIdType, SizeType32> mSlots;
+    // Free slots, the lowest last
+    std::vector<SizeType32> mFreeSlots;
+    Stats mStats;
+
+    // Only used by the thread of the executor
+    TensorPtr mScratch;
+};
+
+} // namespace tensorrt_llm::runtime
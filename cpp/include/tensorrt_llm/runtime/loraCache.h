@@ -27,6 +27,7 @@
 
 #include <NvInferRuntime.h>
 
+#include <atomic>
 #include <deque>
 #include <list>
 #include <map>
@@ -194,6 +195,17 @@ public:
      */
     void put(TaskIdType taskId, TensorPtr weights, TensorPtr config, bool load = true);
 
+    /**
+     * \brief put a task that is not used yet, e.g. the adapter of a queued request, and load its weights.
+     * Unlike put the task is marked done once loaded, so it stays evictable until it is put. Does nothing if the task
+     * is already in the cache.
+     *
+     * \param[in] taskId: the task id
+     * \param[in] weights: lora weights tensor
+     * \param[in] config: lora config tensor
+     */
+    void prefetch(TaskIdType taskId, TensorPtr weights, TensorPtr config);
+
     /**
      * \brief load task weights.  This method must be called after put.  It is designed to be called asynchronously
      * after put returns with load = false
@@ -210,7 +222,6 @@ public:
      */
     [[nodiscard]] inline bool isLoaded(TaskIdType taskId) const
     {
-        std::lock_guard<std::mutex> lk(mCacheMutex);
         return kVALUE_STATUS_LOADED == getStatus(taskId);
     }
 
@@ -226,7 +237,6 @@ public:
      */
     [[nodiscard]] inline bool has(TaskIdType taskId) const
     {
-        std::lock_guard<std::mutex> lk(mCacheMutex);
         return kVALUE_STATUS_MISSING != getStatus(taskId);
     }
 
@@ -317,6 +327,18 @@ public:
      */
     static void splitTransposeCpu(ITensor& output, ITensor const& input, SizeType32 tpSize, SizeType32 tpRank);
 
+    /**
+     * \brief splits second dim of input into tpSize parts and writes the tpRank split to output. When input or output
+     * is in device memory, the split is a single strided copy on the stream of manager instead of a host loop
+     * \param[out] output: output tensor
+     * \param[in] input: input tensor
+     * \param[in] tpSize: number of splits
+     * \param[in] tpRank: the split to write to output
+     * \param[in] manager: a BufferManager whose stream performs the copy
+     */
+    static void splitTranspose(
+        ITensor& output, ITensor const& input, SizeType32 tpSize, SizeType32 tpRank, BufferManager const& manager);
+
 private:
     /**
      * \brief Holds configuration and state for a single task
@@ -333,23 +355,23 @@ private:
         /* indicates if the task is inProgress (in mInProgress list, not evictable)
          * if inProgress=false the task is in mDoneTasks list.
          */
-        bool inProgress;
+        std::atomic<bool> inProgress;
         /*
          * indicates the weights have been copied into the cache.
          * If inProgress=true and loaded=false we are in the middle of adding the task to the cache.
          * We cannot evict or copyTask tasks in this state.
          */
-        bool loaded;
+        std::atomic<bool> loaded;
         /**
          * Marks a task a done.  This is used to mark a task as done during loading.
          * if done=true at the end of loading (end of put, loadweights, or copyTask) the task will be marked as done
          */
-        bool done;
+        std::atomic<bool> done;
         /**
          * Indicates weights are loading either in put or loadWeights
          * This is used to block concurrent loadWeights calls for the same task.
          */
-        bool loadInProgress;
+        std::atomic<bool> loadInProgress;
 
         TaskValue() = delete;
         ~TaskValue() = default;
@@ -366,32 +388,23 @@ private:
         {
         }
 
-        TaskValue(TaskValue&& o) noexcept
-        {
-            std::swap(pageIds, o.pageIds);
-            std::swap(configs, o.configs);
-            std::swap(it, o.it);
-            std::swap(inProgress, o.inProgress);
-            std::swap(loaded, o.loaded);
-            std::swap(done, o.done);
-            std::swap(loadInProgress, o.loadInProgress);
-        }
-
-        TaskValue& operator=(TaskValue&& o)
-        {
-            std::swap(pageIds, o.pageIds);
-            std::swap(configs, o.configs);
-            std::swap(it, o.it);
-            std::swap(inProgress, o.inProgress);
-            std::swap(loaded, o.loaded);
-            std::swap(done, o.done);
-            std::swap(loadInProgress, o.loadInProgress);
-            return *this;
-        }
+        // Tasks are shared through TaskValuePtr
+        TaskValue(TaskValue const&) = delete;
+        TaskValue& operator=(TaskValue const&) = delete;
     };
 
+    // The flags keep the size and alignment of the bools they replaced
+    static_assert(sizeof(std::atomic<bool>) == sizeof(bool) && alignof(std::atomic<bool>) == alignof(bool));
+
     using TaskValuePtr = std::shared_ptr<TaskValue>;
 
+    /**
+     * Sharded index of the tasks in mCacheMap for lookups without mCacheMutex, defined in loraCache.cpp. It is kept
+     * out of line, per instance, so that LoraCache keeps the layout the prebuilt PeftCacheManager that creates and
+     * destroys it was built against.
+     */
+    class TaskMap;
+
     enum ValueStatus
     {
         // task is not in the cache (inProgress or Done)
@@ -412,7 +425,8 @@ private:
 
     /*
      * Protects mutations of mCacheMap, mInProgressTasks and mDoneTasks
-     * And the state booleans in TaskValue (ie inProgress, loaded, done, loadInProgress)
+     * And the transitions of the state booleans in TaskValue (ie inProgress, loaded, done, loadInProgress), which are
+     * atomic so that they can be read without it.
      * mCacheMutex does not protect other values within a TaskValue (ie weights, pageIds, etc)
      */
     mutable std::mutex mCacheMutex;
@@ -428,10 +442,20 @@ private:
     template <typename T>
     static void splitTransposeCpuInner(ITensor& output, ITensor const& input, SizeType32 tpSize, SizeType32 tpRank);
 
+    void putTask(TaskIdType taskId, TensorPtr weights, TensorPtr config, bool load, bool prefetch);
     void loadWeights(TaskValue& cacheValue, TensorPtr weights, TensorPtr config);
     void bumpTaskInProgress(TaskIdType taskId);
     [[nodiscard]] ValueStatus getStatus(TaskIdType taskId) const;
 
+    //! \brief The index of this cache, registered by the constructor
+    [[nodiscard]] TaskMap& getTaskMap() const;
+    //! \brief Adds a task to mCacheMap and to the index, requires mCacheMutex
+    void insertTask(TaskIdType taskId, TaskValuePtr const& taskValue);
+    //! \brief Removes a task from mCacheMap and from the index, requires mCacheMutex
+    void eraseTask(TaskIdType taskId);
+    //! \brief The task in mCacheMap or nullptr, requires mCacheMutex
+    [[nodiscard]] TaskValuePtr findTask(TaskIdType taskId) const;
+
     /**
      * \brief claim numPages, evicting tasks if needed
      * \param[in] numPages: number of pages to claim
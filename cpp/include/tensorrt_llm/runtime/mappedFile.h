@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstddef>
+#include <filesystem>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Read-only memory mapping of a file, e.g. an engine, prefetched into the page cache in parallel.
+//! \details Deserializing from the mapping avoids a second copy of the file in host memory. The prefetch reads the file
+//! in chunks from several threads, which is much faster than a single sequential reader on network and NVMe storage,
+//! and advises the kernel of sequential access.
+class MappedFile
+{
+public:
+    static constexpr std::size_t kDefaultChunkSize = std::size_t{64} << 20;
+
+    //! \param numPrefetchThreads Threads reading the file into the page cache, 0 to not prefetch.
+    //! \param chunkSize Bytes read at once by a prefetch thread.
+    explicit MappedFile(std::filesystem::path const& path, SizeType32 numPrefetchThreads = 8,
+        std::size_t chunkSize = kDefaultChunkSize);
+
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    [[nodiscard]] void const* data() const noexcept
+    {
+        return mData;
+    }
+
+    [[nodiscard]] std::size_t size() const noexcept
+    {
+        return mSize;
+    }
+
+private:
+    void prefetch(SizeType32 numThreads, std::size_t chunkSize) const;
+
+    std::filesystem::path mPath;
+    int mFd;
+    void* mData;
+    std::size_t mSize;
+};
+
+} // namespace tensorrt_llm::runtime
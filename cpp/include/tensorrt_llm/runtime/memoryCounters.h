@@ -54,6 +54,24 @@ public:
         return mUVM;
     }
 
+    //! \brief Free GPU memory kept for reuse by the caching allocator, included in getGpu().
+    [[nodiscard]] SizeType32 getGpuCached() const
+    {
+        return mGpuCached;
+    }
+
+    //! \brief GPU memory lost to rounding allocations up to their size class in the caching allocator.
+    [[nodiscard]] SizeType32 getGpuPadding() const
+    {
+        return mGpuPadding;
+    }
+
+    void setGpuCacheStats(SizeType32 cached, SizeType32 padding)
+    {
+        mGpuCached = cached;
+        mGpuPadding = padding;
+    }
+
     [[nodiscard]] DiffType getGpuDiff() const
     {
         return mGpuDiff;
@@ -149,6 +167,8 @@ public:
 private:
     std::atomic<SizeType32> mGpu{}, mCpu{}, mPinned{}, mUVM{};
     std::atomic<DiffType> mGpuDiff{}, mCpuDiff{}, mPinnedDiff{}, mUVMDiff{};
+    // After the counters above, whose offsets the inline accessors of prebuilt libraries rely on
+    std::atomic<SizeType32> mGpuCached{}, mGpuPadding{};
 };
 
 } // namespace tensorrt_llm::runtime
@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/modelConfig.h"
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <NvInferRuntime.h>
+
+#include <cstddef>
+#include <string>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Device memory of an engine on one rank that does not depend on the traffic.
+struct EngineMemory
+{
+    //! Weights of the engine on the GPU, measured when deserializing it
+    std::size_t weightsBytes;
+    //! Execution context memory, ICudaEngine::getDeviceMemorySize: activations and plugin workspaces of the largest
+    //! optimization profile, shared by all the contexts of a runtime
+    std::size_t activationBytes;
+};
+
+//! \brief The requests to plan for, all sequences are assumed to have the mean lengths.
+struct TrafficShape
+{
+    SizeType32 inputLength;
+    SizeType32 outputLength;
+    SizeType32 beamWidth{1};
+};
+
+//! \brief How the memory left after loading the engine is split, with the semantics of KvCacheConfig and
+//! PeftCacheManagerConfig.
+struct MemoryPlannerConfig
+{
+    //! Usable GPU memory of a rank
+    std::size_t gpuMemoryBytes;
+    nvinfer1::DataType kvCacheType{nvinfer1::DataType::kHALF};
+    SizeType32 tokensPerBlock{64};
+    //! Fraction of the free memory given to the KV cache, see KvCacheConfig::freeGpuMemoryFraction
+    float freeGpuMemoryFraction{0.9f};
+    //! LoRA device cache in module layers of optimalAdapterSize, see PeftCacheManagerConfig::numDeviceModuleLayer.
+    //! Takes precedence over loraDeviceCachePercent.
+    SizeType32 numDeviceLoraModuleLayer{0};
+    SizeType32 optimalLoraAdapterSize{8};
+    //! Fraction of the memory left after the KV cache, see PeftCacheManagerConfig::deviceCachePercent
+    float loraDeviceCachePercent{0.f};
+    //! Memory outside of the engine and the caches: CUDA context, communicators, decoder and other runtime buffers
+    std::size_t reservedBytes{0};
+};
+
+//! \brief Split of the device memory of a rank and the traffic it can hold.
+struct MemoryPlan
+{
+    std::size_t weightsBytes;
+    std::size_t activationBytes;
+    //! Logits buffers of the engine max batch size, the largest of the runtime buffers
+    std::size_t logitsBytes;
+    std::size_t reservedBytes;
+    std::size_t kvCacheBytes;
+    std::size_t loraCacheBytes;
+    std::size_t kvBytesPerBlock;
+    SizeType32 numKvBlocks;
+    //! KV cache blocks of one sequence of the traffic shape, all its beams included
+    SizeType32 blocksPerSequence;
+    //! Sequences of the traffic shape held at the same time, capped by the max batch size of the engine
+    SizeType32 maxBatchSize;
+    //! Tokens the KV cache holds
+    SizeType32 maxNumTokens;
+    //! The engine max batch size caps maxBatchSize, not the KV cache
+    bool limitedByEngine;
+
+    [[nodiscard]] std::string report() const;
+};
+
+//! \brief Forecasts how the device memory of a rank is split between the engine, the KV cache and the LoRA cache and
+//! the batch the KV cache can hold, before deploying the engine.
+//! \details Mirrors the order of the runtime: the engine and its runtime buffers are loaded first, the KV cache takes
+//! freeGpuMemoryFraction of the free memory, the LoRA device cache is sized from what remains. The dimensions are the
+//! ones of a tensor and pipeline parallel rank.
+class MemoryPlanner
+{
+public:
+    MemoryPlanner(ModelConfig const& modelConfig, WorldConfig const& worldConfig);
+
+    //! \brief Bytes of one KV cache block of the layers of this rank.
+    [[nodiscard]] std::size_t getKvBytesPerBlock(nvinfer1::DataType kvCacheType, SizeType32 tokensPerBlock) const;
+
+    //! \brief Blocks of one sequence: the full context blocks are shared by the beams, the rest is per beam.
+    [[nodiscard]] SizeType32 getBlocksPerSequence(TrafficShape const& traffic, SizeType32 tokensPerBlock) const;
+
+    //! \brief Bytes of the logits buffers the runtime allocates for the engine max batch size.
+    [[nodiscard]] std::size_t getLogitsBytes() const;
+
+    //! \brief Bytes of the LoRA device cache in module layers of the adapter size, one slot per rank row.
+    [[nodiscard]] std::size_t getLoraBytes(SizeType32 numModuleLayers, SizeType32 adapterSize) const;
+
+    [[nodiscard]] MemoryPlan plan(
+        EngineMemory const& engine, MemoryPlannerConfig const& config, TrafficShape const& traffic) const;
+
+private:
+    ModelConfig mModelConfig;
+    WorldConfig mWorldConfig;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/chromeTrace.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <cuda_runtime_api.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Log of the allocations and frees of the allocators of tllmBuffers.h, by memory type and owning subsystem.
+//! \details MemoryCounters only keeps the totals. The timeline records the size, address, stream and time of every
+//! allocation and free, tagged with the subsystem that made it, to find which subsystem holds the memory at the peak
+//! and how the memory of the caching allocator and of CUDA itself adds up. The subsystem is set per thread with
+//! ScopedTag, a free is attributed to the tag of its allocation. The last TRTLLM_MEMORY_TIMELINE_CAPACITY events are
+//! kept, the per-tag totals cover all of them. Enabled with TRTLLM_ENABLE_MEMORY_TIMELINE=1.
+class MemoryTimeline
+{
+public:
+    enum class Tag : std::uint8_t
+    {
+        kUNTAGGED = 0,
+        kKV_CACHE = 1,
+        kDECODER = 2,
+        kLORA = 3,
+        //! Device memory of the TensorRT execution contexts
+        kWORKSPACE = 4,
+        //! Inputs and outputs of the engine
+        kRUNTIME = 5,
+        kSCHEDULER = 6,
+        //! Serialization of requests, responses and states
+        kSERIALIZATION = 7,
+    };
+
+    static constexpr std::size_t kNumTags = 8;
+    static constexpr std::size_t kNumMemoryTypes = 4;
+
+    struct Event
+    {
+        //! Since the creation of the timeline
+        std::int64_t timeNs;
+        void const* address;
+        //! Negative for a free
+        std::int64_t size;
+        cudaStream_t stream;
+        MemoryType memoryType;
+        Tag tag;
+        //! Memory of the tag and memory type after the event
+        std::size_t tagBytes;
+    };
+
+    //! Memory of one tag and memory type since the previous takeStats
+    struct TagStats
+    {
+        Tag tag;
+        MemoryType memoryType;
+        std::size_t currentBytes{0};
+        std::size_t peakBytes{0};
+        std::uint64_t numAllocations{0};
+        std::uint64_t numFrees{0};
+    };
+
+    //! \brief Attributes the allocations of this thread to `tag` for its lifetime.
+    class ScopedTag
+    {
+    public:
+        explicit ScopedTag(Tag tag);
+
+        ~ScopedTag();
+
+        ScopedTag(ScopedTag const&) = delete;
+        ScopedTag& operator=(ScopedTag const&) = delete;
+
+    private:
+        Tag mPrevious;
+    };
+
+    explicit MemoryTimeline(std::size_t capacity);
+
+    static MemoryTimeline& getInstance();
+
+    [[nodiscard]] static bool isEnabled();
+
+    [[nodiscard]] static Tag getCurrentTag();
+
+    [[nodiscard]] static char const* getTagName(Tag tag);
+
+    [[nodiscard]] static char const* getMemoryTypeName(MemoryType memoryType);
+
+    //! \brief GPU memory used on the current device that no allocator of tllmBuffers.h counts: the CUDA context,
+    //! library workspaces, NCCL buffers and memory allocated by TensorRT itself.
+    [[nodiscard]] static std::size_t getUntrackedGpuBytes();
+
+    void recordAllocation(MemoryType memoryType, void const* address, std::size_t size, cudaStream_t stream = nullptr);
+
+    void recordFree(MemoryType memoryType, void const* address, std::size_t size, cudaStream_t stream = nullptr);
+
+    //! \brief Memory per tag and memory type, for the pairs that had memory since the previous call. Resets the peaks
+    //! to the current memory and the allocation counts to zero.
+    [[nodiscard]] std::vector<TagStats> takeStats();
+
+    //! \brief The kept events, oldest first.
+    [[nodiscard]] std::vector<Event> getEvents() const;
+
+    //! \brief Events recorded but no longer kept.
+    [[nodiscard]] std::uint64_t getNumDropped() const;
+
+    //! \brief The memory of every tag and memory type as counters, one process per memory type.
+    [[nodiscard]] common::ChromeTrace toChromeTrace() const;
+
+    void dump(std::filesystem::path const& path) const;
+
+    //! \brief Write the kept events as CSV: time, memory type, tag, stream, address, size and tag memory.
+    void writeCsv(std::filesystem::path const& path) const;
+
+    //! \brief Drop the events and the totals.
+    void clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void record(MemoryType memoryType, Tag tag, void const* address, std::int64_t size, cudaStream_t stream);
+
+    [[nodiscard]] TagStats& getStats(MemoryType memoryType, Tag tag)
+    {
+        return mStats[static_cast<std::size_t>(memoryType) * kNumTags + static_cast<std::size_t>(tag)];
+    }
+
+    Clock::time_point const mEpoch;
+    std::size_t const mCapacity;
+
+    mutable std::mutex mMutex;
+    // Ring buffer of the last mCapacity events
+    std::vector<Event> mEvents;
+    std::uint64_t mNumRecorded{0};
+    std::array<TagStats, kNumMemoryTypes * kNumTags> mStats;
+    // Tag of the live allocations, so that frees are attributed to the allocating subsystem
+    std::unordered_map<void const*, Tag> mLiveTags;
+};
+
+} // namespace tensorrt_llm::runtime
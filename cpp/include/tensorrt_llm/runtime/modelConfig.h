@@ -23,6 +23,7 @@
 #include "tensorrt_llm/runtime/speculativeDecodingModule.h"
 
 #include <NvInferRuntime.h>
+#include <algorithm>
 #include <array>
 
 namespace tensorrt_llm::runtime
@@ -557,6 +558,23 @@ public:
         mLayerTypes = layerTypes;
     }
 
+    //! \brief Number of layers of `layerType` on the pipeline ranks before `pipelineParallelismRank`, i.e. the index of
+    //! the first local layer of that type among all the layers of that type.
+    [[nodiscard]] SizeType32 countLowerRankLayers(
+        LayerType layerType, SizeType32 pipelineParallelism = 1, SizeType32 pipelineParallelismRank = 0) const
+    {
+        if (mLayerTypes.empty())
+        {
+            auto const nbLocalLayers = layerType == LayerType::kATTENTION ? getNbAttentionLayers(pipelineParallelism)
+                                                                          : getNbRnnLayers(pipelineParallelism);
+            return pipelineParallelismRank * nbLocalLayers;
+        }
+        // The layers of all types are split evenly over the ranks.
+        auto const nbLocalLayers = static_cast<SizeType32>(mLayerTypes.size()) / pipelineParallelism;
+        auto const firstLocalLayer = mLayerTypes.begin() + pipelineParallelismRank * nbLocalLayers;
+        return static_cast<SizeType32>(std::count(mLayerTypes.begin(), firstLocalLayer, layerType));
+    }
+
     [[nodiscard]] SpeculativeDecodingMode constexpr getSpeculativeDecodingMode() const noexcept
     {
         return mSpeculativeDecodingMode;
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Device counters of the tokens routed to each expert by the MoE layers running in this process.
+//! \details Every MoE plugin registers its layer once, the MoE runner then adds the rows routed to each expert of this
+//! rank to the counters on every enqueue. Layers are reported in registration order, which is the order of the layers
+//! in the engine. Layers with an expert capacity also count the rows that did not fit. Enabled with
+//! TRTLLM_ENABLE_MOE_LOAD_STATS=1.
+class MoeExpertLoadTracker
+{
+public:
+    struct Layer
+    {
+        //! First expert counted by this rank, experts [firstExpert, firstExpert + numExperts) are local
+        SizeType32 firstExpert;
+        SizeType32 numExperts;
+        //! numExperts int64 counters on the device
+        IBuffer::SharedPtr counts;
+        //! numExperts + 1 int64 counters on the device, the rows beyond the capacity of each expert and the rows that
+        //! were dropped in the end, see kernels::CutlassMoeFCRunnerInterface::capacity_factor
+        IBuffer::SharedPtr overflow;
+    };
+
+    struct LayerStats
+    {
+        SizeType32 firstExpert;
+        std::vector<std::int64_t> expertTokenCounts;
+        std::vector<std::int64_t> expertOverflowCounts;
+        std::int64_t droppedRows{0};
+    };
+
+    static MoeExpertLoadTracker& getInstance();
+
+    //! \brief Allocate zeroed counters for a new layer. The layer is reported as long as the returned pointer lives.
+    [[nodiscard]] std::shared_ptr<Layer> addLayer(SizeType32 firstExpert, SizeType32 numExperts);
+
+    //! \brief Copy the counters of all live layers to the host and clear them.
+    //! \details Call between iterations, after the work that updated the counters has completed.
+    [[nodiscard]] std::vector<LayerStats> takeStats(CudaStream const& stream);
+
+private:
+    std::mutex mMutex;
+    std::vector<std::weak_ptr<Layer>> mLayers;
+};
+
+//! \brief Which EP ranks serve each expert of one MoE layer and how its tokens are split between them.
+struct ExpertReplicationPlan
+{
+    //! Ranks serving each expert, the owning rank first
+    std::vector<std::vector<SizeType32>> expertRanks;
+    //! Expected tokens per rank when the tokens of an expert are split evenly between its ranks
+    std::vector<double> rankLoads;
+    //! Highest rank load over the mean rank load, 1 is perfectly balanced
+    double imbalance{1.0};
+};
+
+//! \brief Chooses hot experts to replicate on other EP ranks from the expert token counts of one MoE layer.
+//! \details The load of each expert is an exponential moving average of the counts passed to addCounts. plan()
+//! repeatedly takes the expert with the highest per-replica load on the most loaded rank and adds a replica on the
+//! least loaded rank with a free slot, as long as that lowers the highest rank load. Expert e is owned by rank
+//! e / (numExperts / epSize), matching MOEParallelismConfig.
+class ExpertReplicationPlanner
+{
+public:
+    //! \param maxReplicasPerRank Expert slots each rank has for copies of experts it does not own.
+    //! \param decay Weight of the history in the moving average, 0 only uses the last counts.
+    ExpertReplicationPlanner(
+        SizeType32 numExperts, SizeType32 epSize, SizeType32 maxReplicasPerRank, double decay = 0.9);
+
+    //! \brief Fold the token counts of all numExperts experts from one period into the expert load.
+    void addCounts(std::vector<std::int64_t> const& expertTokenCounts);
+
+    [[nodiscard]] std::vector<double> const& getExpertLoads() const noexcept
+    {
+        return mExpertLoads;
+    }
+
+    [[nodiscard]] ExpertReplicationPlan plan() const;
+
+private:
+    SizeType32 mNumExperts;
+    SizeType32 mEpSize;
+    SizeType32 mMaxReplicasPerRank;
+    double mDecay;
+    bool mHasCounts{false};
+    std::vector<double> mExpertLoads;
+};
+
+} // namespace tensorrt_llm::runtime
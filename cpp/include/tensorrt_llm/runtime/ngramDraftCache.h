@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <deque>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Draft tokens retrieved from the outputs of all requests, shared between requests.
+//! \details Sequences, e.g. prompts, finished outputs and in-flight outputs, are indexed by their n-grams of
+//! `minNgramLength` to `maxNgramLength` tokens. The draft of a context continues the most recent occurrence of its
+//! longest indexed suffix. Only n-grams followed by a token are indexed, so a sequence never proposes its own end.
+//! The oldest sequences are dropped when the cache holds more than `maxNumTokens` tokens.
+//! The draft tokens are passed to the decoder like external draft tokens, see SpeculativeDecodingMode
+//! DraftTokensExternal, so prompt lookup needs no draft model. All methods are thread safe.
+class NgramDraftCache
+{
+public:
+    using SequenceIdType = std::uint64_t;
+    using VecTokens = std::vector<TokenIdType>;
+
+    struct Config
+    {
+        SizeType32 minNgramLength{2};
+        SizeType32 maxNgramLength{4};
+        //! Tokens kept in the cache, all sequences included.
+        std::size_t maxNumTokens{1U << 24U};
+    };
+
+    explicit NgramDraftCache(Config const& config);
+
+    //! \brief Adds a sequence, e.g. a prompt or a finished output.
+    //! \return Id to extend the sequence with appendTokens.
+    SequenceIdType addSequence(VecTokens const& tokens);
+
+    //! \brief Extends a sequence, e.g. with the tokens generated by a request in the last step.
+    //! \details Does nothing if the sequence was dropped.
+    void appendTokens(SequenceIdType sequenceId, VecTokens const& tokens);
+
+    //! \brief Stops indexing a sequence early, e.g. when its request is cancelled.
+    void removeSequence(SequenceIdType sequenceId);
+
+    //! \brief Draft of at most `maxDraftLength` tokens following `context`, empty if no suffix of it is indexed.
+    [[nodiscard]] VecTokens propose(VecTokens const& context, SizeType32 maxDraftLength) const;
+
+    [[nodiscard]] std::size_t getNumTokens() const;
+
+    [[nodiscard]] std::size_t getNumSequences() const;
+
+private:
+    struct Location
+    {
+        SequenceIdType sequenceId;
+        //! Position of the last token of the n-gram in the sequence.
+        SizeType32 end;
+    };
+
+    [[nodiscard]] static std::uint64_t hashNgram(TokenIdType const* tokens, SizeType32 length);
+
+    //! Indexes all n-grams that end right before `position`.
+    void indexPosition(SequenceIdType sequenceId, VecTokens const& tokens, SizeType32 position);
+
+    //! Removes the index entries that still point into the sequence.
+    void eraseSequence(SequenceIdType sequenceId);
+
+    void evict(SequenceIdType keepId);
+
+    Config const mConfig;
+    mutable std::shared_mutex mMutex;
+    SequenceIdType mNextSequenceId{0};
+    std::size_t mNumTokens{0};
+    std::unordered_map<SequenceIdType, VecTokens> mSequences;
+    //! Sequence ids in insertion order, may contain removed ids.
+    std::deque<SequenceIdType> mOrder;
+    //! Most recent occurrence of each n-gram by hash, collisions are resolved by comparing the tokens.
+    std::unordered_map<std::uint64_t, Location> mIndex;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Measures the pipeline bubble of a pipeline-parallel rank: the share of the generation loop in which the rank
+//! waits for the decoder results of a micro-batch instead of enqueuing work.
+class PipelineBubbleTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::duration<double, std::milli>;
+
+    //! \brief Bubble of filling and draining a pipeline of `numStages` stages with `numMicroBatches` micro-batches that
+    //! each pass through all stages once, e.g. the context phase.
+    [[nodiscard]] static double estimateFillDrainBubble(SizeType32 numMicroBatches, SizeType32 numStages)
+    {
+        TLLM_CHECK(numMicroBatches > 0 && numStages > 0);
+        return static_cast<double>(numStages - 1) / (numMicroBatches + numStages - 1);
+    }
+
+    void addWait(Duration wait)
+    {
+        mWait += wait;
+    }
+
+    void addLoop(Duration loop)
+    {
+        mLoop += loop;
+    }
+
+    //! \brief Waiting time over loop time, 0 before the first loop.
+    [[nodiscard]] double getBubbleFraction() const
+    {
+        return mLoop.count() > 0 ? std::min(1.0, mWait / mLoop) : 0.0;
+    }
+
+    [[nodiscard]] Duration getWait() const
+    {
+        return mWait;
+    }
+
+    [[nodiscard]] Duration getLoop() const
+    {
+        return mLoop;
+    }
+
+    void reset()
+    {
+        mWait = Duration::zero();
+        mLoop = Duration::zero();
+    }
+
+private:
+    Duration mWait{Duration::zero()};
+    Duration mLoop{Duration::zero()};
+};
+
+} // namespace tensorrt_llm::runtime
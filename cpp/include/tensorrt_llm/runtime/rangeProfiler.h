@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/chromeTrace.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Always-on profiler of named, categorized ranges on the hot paths, cheap enough for production.
+//! \details Every range is an NVTX range. In addition, one in TRTLLM_RANGE_PROFILER_SAMPLE_PERIOD outermost ranges
+//! of a thread is recorded with all its nested ranges: CPU timestamps and, for ranges given a stream, CUDA events
+//! around the work they enqueue. Each thread records into its own ring buffer of its last
+//! TRTLLM_RANGE_PROFILER_CAPACITY ranges. The buffers are dumped on demand, or when a latency exceeds its objective,
+//! as a Chrome trace that Perfetto opens, so the tail latency of a deployment can be looked at without nsys.
+class RangeProfiler
+{
+public:
+    enum class Category : std::uint8_t
+    {
+        kSCHEDULER = 0,
+        kDECODER = 1,
+        kPLUGIN = 2,
+        kRUNTIME = 3,
+    };
+
+    using RangeId = std::uint32_t;
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr RangeId kMaxRanges = 1024;
+
+    //! \brief An NVTX range for its lifetime, recorded if sampled, with the work enqueued on `stream` if one is given.
+    //! \details The work on a stream being captured into a CUDA graph is not timed.
+    class ScopedRange
+    {
+    public:
+        explicit ScopedRange(RangeId id, cudaStream_t stream = nullptr);
+
+        ~ScopedRange();
+
+        ScopedRange(ScopedRange const&) = delete;
+        ScopedRange& operator=(ScopedRange const&) = delete;
+
+    private:
+        RangeId mId;
+        cudaStream_t mStream;
+        bool mSampled{false};
+        Clock::time_point mStart;
+        cudaEvent_t mGpuStart{nullptr};
+    };
+
+    static RangeProfiler& getInstance();
+
+    //! \brief Register a range once, typically in a function-local static, see TLLM_PROFILE_RANGE.
+    static RangeId registerRange(Category category, char const* name);
+
+    [[nodiscard]] static char const* getCategoryName(Category category);
+
+    [[nodiscard]] static bool isEnabled();
+
+    //! \brief The recorded ranges of all threads. The work of the GPU ranges still executing is left out.
+    [[nodiscard]] common::ChromeTrace dump();
+
+    void dump(std::filesystem::path const& path);
+
+    //! \brief Dump to a new file in `dir` if latencyMs exceeds sloMs, at most once per minInterval.
+    //! \return The path of the dump, if one was written.
+    std::optional<std::filesystem::path> dumpOnSloViolation(double latencyMs, double sloMs,
+        std::filesystem::path const& dir, std::chrono::seconds minInterval = std::chrono::seconds{60});
+
+    //! \brief Drop the recorded ranges.
+    void clear();
+
+private:
+    struct RangeInfo
+    {
+        Category category;
+        std::string name;
+    };
+
+    struct Record
+    {
+        RangeId id;
+        std::int64_t startNs;
+        std::int64_t endNs;
+        // Set for the ranges with a stream, released to the pool when the slot is overwritten
+        cudaEvent_t gpuStart{nullptr};
+        cudaEvent_t gpuEnd{nullptr};
+        int device{-1};
+    };
+
+    //! \brief Ring buffer of one thread. Only its thread writes, the mutex is contended only while dumping.
+    struct ThreadRing
+    {
+        std::int64_t tid;
+        std::mutex mutex;
+        std::vector<Record> records;
+        std::uint64_t numRecorded{0};
+    };
+
+    RangeProfiler();
+
+    [[nodiscard]] RangeInfo const& getRange(RangeId id) const
+    {
+        return mRanges[id];
+    }
+
+    ThreadRing& getThreadRing();
+
+    void addRecord(Record record);
+
+    cudaEvent_t acquireEvent();
+
+    void releaseEvents(Record& record);
+
+    [[nodiscard]] std::int64_t toNs(Clock::time_point time) const
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(time - mEpoch).count();
+    }
+
+    Clock::time_point const mEpoch;
+    std::size_t const mCapacity;
+
+    std::mutex mRangesMutex;
+    // Fixed size, so that ranges are read without a lock while others are registered
+    std::array<RangeInfo, kMaxRanges> mRanges;
+    std::atomic<RangeId> mNumRanges{0};
+
+    std::mutex mThreadsMutex;
+    std::vector<std::shared_ptr<ThreadRing>> mThreadRings;
+
+    std::mutex mEventsMutex;
+    // Events are reused, they are released with the CUDA context.
+    std::vector<cudaEvent_t> mFreeEvents;
+
+    std::mutex mSloDumpMutex;
+    std::optional<Clock::time_point> mLastSloDump;
+    std::uint32_t mNumSloDumps{0};
+};
+
+} // namespace tensorrt_llm::runtime
+
+#define TLLM_PROFILE_RANGE_CONCAT_IMPL(a, b) a##b
+#define TLLM_PROFILE_RANGE_CONCAT(a, b) TLLM_PROFILE_RANGE_CONCAT_IMPL(a, b)
+
+//! \brief Profile the rest of the scope as range `name` of `category`, a RangeProfiler::Category enumerator.
+#define TLLM_PROFILE_RANGE(category, name) TLLM_PROFILE_GPU_RANGE(category, name, nullptr)
+
+//! \brief Like TLLM_PROFILE_RANGE, also timing the work enqueued on `stream` in the scope.
+#define TLLM_PROFILE_GPU_RANGE(category, name, stream)                                                                 \
+    static auto const TLLM_PROFILE_RANGE_CONCAT(tllmProfileRangeId, __LINE__)                                          \
+        = ::tensorrt_llm::runtime::RangeProfiler::registerRange(                                                       \
+            ::tensorrt_llm::runtime::RangeProfiler::Category::category, name);                                         \
+    ::tensorrt_llm::runtime::RangeProfiler::ScopedRange TLLM_PROFILE_RANGE_CONCAT(tllmProfileRange, __LINE__)          \
+    {                                                                                                                  \
+        TLLM_PROFILE_RANGE_CONCAT(tllmProfileRangeId, __LINE__), stream                                                \
+    }
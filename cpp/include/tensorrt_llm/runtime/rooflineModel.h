@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/modelConfig.h"
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Peak throughputs of a GPU, the roofs of the roofline.
+struct GpuPeaks
+{
+    //! Dense tensor core FLOP/s in the precision of the activations
+    double flopsPerSec;
+    double bytesPerSec;
+
+    //! \brief Estimated from the SM count, clocks and memory bus of a device. Approximate, the clocks under load are
+    //! usually lower than the maximum clocks used here.
+    static GpuPeaks fromDevice(int device);
+};
+
+//! \brief Requests of one run of the engine: a context phase of all requests, then generation steps.
+struct RooflineWorkload
+{
+    SizeType32 batchSize;
+    SizeType32 inputLength;
+    SizeType32 outputLength;
+    SizeType32 beamWidth{1};
+};
+
+//! \brief Achieved throughput of a layer against the roofline of the GPU.
+struct LayerEfficiency
+{
+    enum class Kind : std::int8_t
+    {
+        kQKV_GEMM,
+        kATTENTION,
+        kATTENTION_DENSE_GEMM,
+        kMLP_FC_GEMM,
+        kMLP_PROJ_GEMM,
+        kLM_HEAD_GEMM,
+        kNORM,
+        kOTHER,
+    };
+
+    std::string name;
+    Kind kind;
+    float timeMs;
+    //! Estimated work of the layer in the measured runs, zero for the kinds without an estimate
+    double flops{0};
+    double bytes{0};
+    //! Time the layer would take at the roofline
+    float rooflineTimeMs{0.f};
+
+    [[nodiscard]] double getAchievedFlopsPerSec() const
+    {
+        return timeMs > 0.f ? flops / (timeMs * 1e-3) : 0.;
+    }
+
+    [[nodiscard]] double getAchievedBytesPerSec() const
+    {
+        return timeMs > 0.f ? bytes / (timeMs * 1e-3) : 0.;
+    }
+
+    //! \brief FLOP per byte moved.
+    [[nodiscard]] double getArithmeticIntensity() const
+    {
+        return bytes > 0. ? flops / bytes : 0.;
+    }
+
+    //! \brief Fraction of the roofline achieved, in [0, 1] unless the estimate is off.
+    [[nodiscard]] double getEfficiency() const
+    {
+        return timeMs > 0.f ? rooflineTimeMs / timeMs : 0.;
+    }
+
+    //! \brief Time above the roofline, what the layer could gain at most.
+    [[nodiscard]] float getLostTimeMs() const
+    {
+        return rooflineTimeMs > 0.f ? timeMs - rooflineTimeMs : 0.f;
+    }
+};
+
+//! \brief Estimates the FLOPs and bytes of the layers of an engine from their names and the model config, and compares
+//! them with profiled layer times.
+//! \details The dimensions are the ones of a tensor parallel rank. Layers are classified by the names the model
+//! definitions give them, e.g. "attention/qkv" or "mlp/proj". Layers TensorRT fused under another name, and
+//! the layers without an estimate, are reported as kOTHER. Weights are read once per forward; the context phase of
+//! attention is causal.
+class RooflineModel
+{
+public:
+    using Kind = LayerEfficiency::Kind;
+
+    RooflineModel(ModelConfig const& modelConfig, WorldConfig const& worldConfig, GpuPeaks const& peaks);
+
+    [[nodiscard]] static Kind classify(std::string const& layerName);
+
+    [[nodiscard]] static char const* getKindName(Kind kind);
+
+    //! \brief FLOPs and bytes of one run of the workload for a layer of a kind.
+    [[nodiscard]] std::pair<double, double> estimate(Kind kind, RooflineWorkload const& workload) const;
+
+    //! \brief The layers with their times summed over numRuns runs of the workload, sorted by decreasing lost time.
+    [[nodiscard]] std::vector<LayerEfficiency> analyze(std::vector<std::pair<std::string, float>> const& layerTimesMs,
+        RooflineWorkload const& workload, SizeType32 numRuns) const;
+
+    //! \brief Table of the layers, the `numFlagged` layers with the most lost time marked, and a summary per kind.
+    [[nodiscard]] std::string report(std::vector<LayerEfficiency> const& layers, std::size_t numFlagged = 10) const;
+
+private:
+    [[nodiscard]] std::pair<double, double> estimateGemm(
+        double k, double n, double numTokens, double numForwards) const;
+
+    ModelConfig mModelConfig;
+    SizeType32 mTensorParallelism;
+    GpuPeaks mPeaks;
+    double mActivationBytes;
+    double mWeightBytes;
+    double mKvBytes;
+    //! Peak of the GEMMs, twice the peak for 8-bit activations
+    double mGemmFlopsPerSec;
+};
+
+} // namespace tensorrt_llm::runtime
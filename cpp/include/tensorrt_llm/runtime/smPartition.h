@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Two streams of the current device that run on disjoint sets of SMs, e.g. to give the generation phase a
+//! guaranteed share of the GPU while the context phase runs concurrently on the rest, see
+//! TllmRuntime::setContextStream.
+//! \details The SMs are split with green contexts, which requires CUDA 12.5. Without them, the partition falls back to
+//! two streams of the whole device, the reserved one with the highest priority, so that its kernels are scheduled
+//! first but without a guarantee. The partition must outlive its streams.
+class SmPartition
+{
+public:
+    //! \param numReservedSms SMs of the reserved partition, rounded up to the granularity of the device. The other
+    //! partition gets the remaining SMs.
+    explicit SmPartition(SizeType32 numReservedSms);
+
+    ~SmPartition();
+
+    SmPartition(SmPartition const&) = delete;
+    SmPartition& operator=(SmPartition const&) = delete;
+
+    //! \return whether the SMs are actually split, false for the fallback to stream priorities
+    [[nodiscard]] bool isPartitioned() const noexcept
+    {
+        return !mGreenContexts.empty();
+    }
+
+    [[nodiscard]] BufferManager::CudaStreamPtr getReservedStream() const noexcept
+    {
+        return mReservedStream;
+    }
+
+    [[nodiscard]] BufferManager::CudaStreamPtr getRemainingStream() const noexcept
+    {
+        return mRemainingStream;
+    }
+
+    //! \return the SMs of the reserved partition, all the SMs of the device if not partitioned
+    [[nodiscard]] SizeType32 getNumReservedSms() const noexcept
+    {
+        return mNumReservedSms;
+    }
+
+    [[nodiscard]] SizeType32 getNumRemainingSms() const noexcept
+    {
+        return mNumRemainingSms;
+    }
+
+private:
+    bool createGreenContexts(SizeType32 numReservedSms, int highestPriority, int lowestPriority);
+
+    BufferManager::CudaStreamPtr mReservedStream;
+    BufferManager::CudaStreamPtr mRemainingStream;
+    // CUgreenCtx of the reserved and of the remaining partition
+    std::vector<void*> mGreenContexts;
+    SizeType32 mNumReservedSms{0};
+    SizeType32 mNumRemainingSms{0};
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <queue>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Chooses the number of draft tokens of every request each step from its measured acceptance rate and the
+//! cost of the batch.
+//! \details Draft tokens are assumed to be accepted independently with the per-request rate a, so k draft tokens
+//! yield (1 - a^(k+1)) / (1 - a) tokens per step. The engine step costs one unit while the batch is memory bound and
+//! grows linearly with the tokens once they exceed `computeBoundTokens`. Drafting costs `draftTokenCost` units per
+//! draft token of the longest draft, e.g. the draft model steps of external draft tokens, 0 for Medusa and lookahead.
+//! The draft lengths maximize the expected tokens per unit of cost, so speculation stops when the batch is compute
+//! bound or the acceptance is low.
+class SpeculationLengthController
+{
+public:
+    using RequestIdType = std::uint64_t;
+
+    struct Config
+    {
+        //! Draft tokens per request supported by the engine.
+        SizeType32 maxDraftLength{0};
+        //! Tokens per engine step above which the step time grows linearly with the tokens.
+        SizeType32 computeBoundTokens{0};
+        //! Cost of drafting one token relative to an engine step.
+        double draftTokenCost{0.0};
+        //! Weight of the history in the acceptance rate, per step.
+        double acceptanceDecay{0.9};
+        //! Acceptance rate of a request without history.
+        double initialAcceptanceRate{0.5};
+    };
+
+    explicit SpeculationLengthController(Config const& config)
+        : mConfig{config}
+    {
+        TLLM_CHECK(mConfig.maxDraftLength >= 0);
+        TLLM_CHECK(mConfig.computeBoundTokens > 0);
+        TLLM_CHECK(mConfig.draftTokenCost >= 0.0);
+        TLLM_CHECK(mConfig.acceptanceDecay >= 0.0 && mConfig.acceptanceDecay < 1.0);
+        TLLM_CHECK(mConfig.initialAcceptanceRate >= 0.0 && mConfig.initialAcceptanceRate < 1.0);
+    }
+
+    //! \brief Record the outcome of a step, `numAcceptedTokens` of the `numDraftTokens` draft tokens of the request
+    //! were accepted, e.g. from the accepted lengths of acceptDraftTokensByIds or acceptDraftTokensByLogits.
+    void update(RequestIdType requestId, SizeType32 numDraftTokens, SizeType32 numAcceptedTokens)
+    {
+        TLLM_CHECK(0 <= numAcceptedTokens && numAcceptedTokens <= numDraftTokens);
+        if (numDraftTokens == 0)
+        {
+            return;
+        }
+        auto& stats = mStats[requestId];
+        // Every accepted token is a success, the first rejected one is a failure
+        stats.accepted = mConfig.acceptanceDecay * stats.accepted + numAcceptedTokens;
+        stats.trials = mConfig.acceptanceDecay * stats.trials + numAcceptedTokens
+            + (numAcceptedTokens < numDraftTokens ? 1 : 0);
+    }
+
+    void removeRequest(RequestIdType requestId)
+    {
+        mStats.erase(requestId);
+    }
+
+    //! \brief Estimated probability that a draft token of the request is accepted.
+    [[nodiscard]] double getAcceptanceRate(RequestIdType requestId) const
+    {
+        auto const it = mStats.find(requestId);
+        if (it == mStats.end() || it->second.trials <= 0.0)
+        {
+            return mConfig.initialAcceptanceRate;
+        }
+        // Clamp away from 1 to keep the expected tokens finite
+        return std::min(it->second.accepted / it->second.trials, kMaxAcceptanceRate);
+    }
+
+    //! \brief Expected tokens of a step with `draftLength` draft tokens, the token of the target model included.
+    [[nodiscard]] static double expectedTokens(double acceptanceRate, SizeType32 draftLength)
+    {
+        return (1.0 - std::pow(acceptanceRate, draftLength + 1)) / (1.0 - acceptanceRate);
+    }
+
+    //! \brief Cost of a step with `numTokens` tokens in the engine and `maxDraftLength` as the longest draft.
+    [[nodiscard]] double stepCost(SizeType32 numTokens, SizeType32 maxDraftLength) const
+    {
+        auto const engineCost = std::max(1.0, static_cast<double>(numTokens) / mConfig.computeBoundTokens);
+        return engineCost + mConfig.draftTokenCost * maxDraftLength;
+    }
+
+    //! \brief Draft lengths of the requests for the next step, in the order of `requestIds`.
+    //! \details Draft tokens are added greedily in order of decreasing marginal expected tokens, the prefix with the
+    //! highest expected tokens per cost is kept.
+    [[nodiscard]] std::vector<SizeType32> computeDraftLengths(std::vector<RequestIdType> const& requestIds) const
+    {
+        auto const numRequests = static_cast<SizeType32>(requestIds.size());
+        std::vector<double> acceptanceRates(numRequests);
+        // Marginal expected tokens of the next draft token, request index, draft length after adding it
+        using Candidate = std::tuple<double, SizeType32, SizeType32>;
+        std::priority_queue<Candidate> candidates;
+        // Every request gets the token of the target model
+        auto tokens = static_cast<double>(numRequests);
+        for (SizeType32 ri = 0; ri < numRequests; ++ri)
+        {
+            acceptanceRates[ri] = getAcceptanceRate(requestIds[ri]);
+            if (mConfig.maxDraftLength > 0)
+            {
+                candidates.emplace(acceptanceRates[ri], ri, 1);
+            }
+        }
+
+        // Request of every added draft token, the first `bestNumAdded` form the best prefix
+        std::vector<SizeType32> added;
+        std::size_t bestNumAdded{0};
+        SizeType32 numTokens{numRequests};
+        SizeType32 maxLength{0};
+        auto bestThroughput = numRequests > 0 ? tokens / stepCost(numTokens, maxLength) : 0.0;
+        while (!candidates.empty())
+        {
+            auto const [gain, ri, length] = candidates.top();
+            candidates.pop();
+            added.push_back(ri);
+            tokens += gain;
+            numTokens += 1;
+            maxLength = std::max(maxLength, length);
+            auto const throughput = tokens / stepCost(numTokens, maxLength);
+            if (throughput > bestThroughput)
+            {
+                bestThroughput = throughput;
+                bestNumAdded = added.size();
+            }
+            if (length < mConfig.maxDraftLength)
+            {
+                candidates.emplace(gain * acceptanceRates[ri], ri, length + 1);
+            }
+        }
+
+        std::vector<SizeType32> lengths(numRequests, 0);
+        for (std::size_t ai = 0; ai < bestNumAdded; ++ai)
+        {
+            ++lengths[added[ai]];
+        }
+        return lengths;
+    }
+
+private:
+    static constexpr double kMaxAcceptanceRate = 0.99;
+
+    struct Stats
+    {
+        double accepted{0.0};
+        double trials{0.0};
+    };
+
+    Config mConfig;
+    std::unordered_map<RequestIdType, Stats> mStats;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Ring of the last `capacity` positions of the output ids and log probs of every slot, in pinned host memory,
+//! written by the GPU after each decoder step.
+//! \details Owned by the caller of the decoder, which enqueues resetSlot for every new request and publish after every
+//! forward on the stream of the decoder, e.g. with GptDecoderBatch::getOutputIds and getLogProbs. Every slot has a
+//! counter, the sequence length published so far. publish() copies the new positions of the output ids to the ring and
+//! advances the counters only after the positions are visible to the host, so a response thread can stream tokens by
+//! polling the counters, without a copy or a stream synchronization of its own. Positions older than `capacity` behind
+//! the counter are overwritten. A second counter, advanced before the copy, lets read() detect it, the caller falls
+//! back to the output ids of the decoder then.
+class TokenRing
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    TokenRing(SizeType32 maxBatchSize, SizeType32 maxBeamWidth, SizeType32 capacity);
+
+    //! \brief Publish the positions of the first `batchSize` slots up to their sequence length.
+    //! \param outputIds [maxBatchSize, maxBeamWidth, maxSequenceLength], on gpu
+    //! \param logProbs [maxBatchSize, maxBeamWidth, maxSequenceLength], on gpu, optional
+    //! \param sequenceLengths [batchSize, maxBeamWidth], on gpu
+    void publish(ITensor const& outputIds, ITensor const* logProbs, ITensor const& sequenceLengths,
+        SizeType32 batchSize, CudaStream const& stream);
+
+    //! \brief Start publishing a new request in `slot` from `length`, the input length, as the input is not streamed.
+    //! Enqueued on `stream`, so the publishing of the previous request of the slot is not affected.
+    void resetSlot(SizeType32 slot, SizeType32 length, CudaStream const& stream);
+
+    //! \brief The sequence length published for `slot`. Valid for a new request once the first decoder step of the
+    //! request has completed, until then it may be the length of the previous request of the slot.
+    [[nodiscard]] SizeType32 getPublishedLength(SizeType32 slot) const;
+
+    //! \brief Append the positions [begin, end) of `beam` of `slot` to `tokens` and, if given, `logProbs`.
+    //! \return false if the positions are not published yet or were overwritten, nothing is appended then.
+    bool read(SizeType32 slot, SizeType32 beam, SizeType32 begin, SizeType32 end, std::vector<TokenIdType>& tokens,
+        std::vector<float>* logProbs = nullptr) const;
+
+    [[nodiscard]] SizeType32 getCapacity() const noexcept
+    {
+        return mCapacity;
+    }
+
+    //! @returns [maxBatchSize, capacity, maxBeamWidth], in pinned host memory
+    [[nodiscard]] TensorPtr getTokens() const
+    {
+        return mTokens;
+    }
+
+    //! @returns [maxBatchSize, capacity, maxBeamWidth], in pinned host memory
+    [[nodiscard]] TensorPtr getLogProbs() const
+    {
+        return mLogProbs;
+    }
+
+    //! @returns [maxBatchSize, 2], the published sequence lengths and the lengths being written, in pinned host memory
+    [[nodiscard]] TensorPtr getCounters() const
+    {
+        return mCounters;
+    }
+
+private:
+    [[nodiscard]] SizeType32 getWrittenLength(SizeType32 slot) const;
+
+    SizeType32 mMaxBeamWidth;
+    SizeType32 mCapacity;
+
+    TensorPtr mTokens;
+    TensorPtr mLogProbs;
+    TensorPtr mCounters;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Device memory pool of blocks that grows and shrinks at runtime at a fixed address, e.g. the primary pool of
+//! the KV cache.
+//! \details The address range of `maxNumBlocks` blocks is reserved up front, with the CUDA virtual memory management
+//! API, and physical memory is mapped into it in chunks as the pool grows and unmapped and released as it shrinks.
+//! The base pointer never changes, so block offsets, e.g. those of a KVBlockArray, stay valid across a resize. Only
+//! the mapped chunks count as GPU memory. Chunks are a multiple of the allocation granularity of the device, a block
+//! may span two chunks.
+class VirtualMemoryPool
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    //! \param blockShape the shape of one block, the pool tensor is [numBlocks, blockShape...]
+    //! \param minChunkSizeInBytes lower bound of the chunk size, rounded up to the allocation granularity
+    VirtualMemoryPool(ITensor::Shape const& blockShape, nvinfer1::DataType dataType, SizeType32 maxNumBlocks,
+        std::size_t minChunkSizeInBytes = std::size_t{1} << 25);
+
+    ~VirtualMemoryPool();
+
+    VirtualMemoryPool(VirtualMemoryPool const&) = delete;
+    VirtualMemoryPool& operator=(VirtualMemoryPool const&) = delete;
+
+    //! \brief Back the first `numBlocks` blocks with physical memory, mapping or unmapping chunks at the end.
+    //! \details On shrink, the blocks after `numBlocks` must not be used anymore and no pending work may access them,
+    //! the caller synchronizes first. On grow, the new blocks are uninitialized. If the device runs out of memory
+    //! while growing, the pool keeps the chunks it could map.
+    //! \return the number of blocks backed, at least `numBlocks` unless the device ran out of memory.
+    SizeType32 resize(SizeType32 numBlocks);
+
+    //! \return the base of the pool, the same for the lifetime of the pool
+    [[nodiscard]] void* data() const noexcept
+    {
+        return reinterpret_cast<void*>(mBase);
+    }
+
+    //! \return the blocks backed by the mapped chunks, possibly more than requested by resize
+    [[nodiscard]] SizeType32 getNumBlocks() const noexcept
+    {
+        return mNumBlocks;
+    }
+
+    [[nodiscard]] SizeType32 getMaxNumBlocks() const noexcept
+    {
+        return mMaxNumBlocks;
+    }
+
+    [[nodiscard]] std::size_t getBlockSizeInBytes() const noexcept
+    {
+        return mBlockSizeInBytes;
+    }
+
+    [[nodiscard]] std::size_t getChunkSizeInBytes() const noexcept
+    {
+        return mChunkSizeInBytes;
+    }
+
+    [[nodiscard]] std::size_t getMappedBytes() const noexcept
+    {
+        return mChunks.size() * mChunkSizeInBytes;
+    }
+
+    //! \return a view of the backed blocks, [getNumBlocks(), blockShape...], invalidated by a shrink
+    [[nodiscard]] TensorPtr getTensor() const;
+
+private:
+    bool mapChunk();
+    void unmapChunk();
+
+    ITensor::Shape mBlockShape;
+    nvinfer1::DataType mDataType;
+    SizeType32 mMaxNumBlocks;
+    std::size_t mBlockSizeInBytes;
+    int mDevice;
+    std::size_t mChunkSizeInBytes;
+    std::size_t mReservedBytes;
+    std::uint64_t mBase;
+    // Physical allocation of every mapped chunk, in address order
+    std::vector<std::uint64_t> mChunks;
+    SizeType32 mNumBlocks;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,679 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/common/nvtxUtils.h"
+#include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/plugins/gptAttentionPlugin/gptAttentionPlugin.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <algorithm>
+#include <cuda.h>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace tensorrt_llm::kernels;
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+using tensorrt_llm::plugins::GPTAttentionPlugin;
+using tensorrt_llm::plugins::GPTAttentionPluginCommon;
+
+static BufferManager::CudaStreamPtr streamPtr;
+static std::unique_ptr<BufferManager> bufferManager;
+static int deviceCount;
+static char* workloadFile = nullptr;
+// Roofline peaks, 0 means the bandwidth is derived from the device attributes and the compute roofline is not reported
+static double peakBandwidthGBps = 0.0;
+static double peakTFlops = 0.0;
+
+constexpr bool VERBOSE = false;
+
+enum class AttentionBackend : int
+{
+    // Generation phase, masked multi-head attention
+    MMHA = 0,
+    // Generation phase, XQA kernels. TRTLLM_ENABLE_XQA_JIT selects the precompiled or the JIT implementation
+    XQA = 1,
+    // Context phase, fused multi-head attention
+    CONTEXT_FMHA = 2,
+    // Context phase, unfused attention (BMM + softmax + BMM)
+    UNFUSED = 3,
+};
+
+enum class KVCacheDataType : int
+{
+    // Same type as the activations
+    AUTO = 0,
+    INT8 = 1,
+    FP8 = 2,
+};
+
+inline bool isGenerationBackend(AttentionBackend backend)
+{
+    return backend == AttentionBackend::MMHA || backend == AttentionBackend::XQA;
+}
+
+inline std::string getBackendName(AttentionBackend backend)
+{
+    switch (backend)
+    {
+    case AttentionBackend::MMHA: return "mmha";
+    case AttentionBackend::XQA:
+    {
+        // Mirrors DecoderXQARunner, which uses JIT unless TRTLLM_ENABLE_XQA_JIT=0
+        auto const jit = getEnvEnableXQAJIT();
+        return (!jit.has_value() || *jit) ? "xqa_jit" : "xqa_precompiled";
+    }
+    case AttentionBackend::CONTEXT_FMHA: return "context_fmha";
+    case AttentionBackend::UNFUSED: return "unfused";
+    }
+    return "unknown";
+}
+
+namespace
+{
+/**
+ * Describes the sequence lengths of a batch. Either an explicit list of lengths (one per sequence) or a weighted
+ * distribution of lengths that the batch is sampled from
+ */
+struct SequenceLengthConfig
+{
+    std::string name;
+    std::vector<int> lengths;
+    // Empty for an explicit list of lengths
+    std::vector<float> weights;
+    int batch_size;
+
+    SequenceLengthConfig(std::string name, std::vector<int> lengths, std::vector<float> weights, int batch_size)
+        : name(std::move(name))
+        , lengths(std::move(lengths))
+        , weights(std::move(weights))
+        , batch_size(batch_size)
+    {
+        TLLM_CHECK_WITH_INFO(!this->lengths.empty(), "Sequence length config %s has no lengths", this->name.c_str());
+        TLLM_CHECK_WITH_INFO(this->weights.empty() || this->weights.size() == this->lengths.size(),
+            "Sequence length config %s must have one weight per length", this->name.c_str());
+        TLLM_CHECK_WITH_INFO(
+            std::all_of(this->lengths.begin(), this->lengths.end(), [](int l) { return l > 0; }),
+            "Sequence length config %s has non-positive lengths", this->name.c_str());
+        if (this->weights.empty())
+        {
+            this->batch_size = static_cast<int>(this->lengths.size());
+        }
+        TLLM_CHECK_WITH_INFO(this->batch_size > 0, "Sequence length config %s has no sequences", this->name.c_str());
+    }
+
+    // Sampled with a fixed seed so every backend and dtype sees the same batch
+    std::vector<int> sampleBatch() const
+    {
+        if (weights.empty())
+        {
+            return lengths;
+        }
+        std::mt19937_64 twister{0xD5};
+        std::discrete_distribution<int> dist(weights.begin(), weights.end());
+        std::vector<int> batch(batch_size);
+        std::generate(batch.begin(), batch.end(), [&] { return lengths[dist(twister)]; });
+        return batch;
+    }
+};
+
+/**
+ * Exposes the phase entry points of the attention plugin, so the benchmark runs the same kernel selection and
+ * workspace layout as an engine without building one
+ */
+class AttentionBenchmarkPlugin : public GPTAttentionPlugin
+{
+public:
+    using GPTAttentionPlugin::GPTAttentionPlugin;
+
+    using GPTAttentionPluginCommon::EnqueueContextParams;
+    using GPTAttentionPluginCommon::EnqueueGenerationParams;
+    using GPTAttentionPluginCommon::enqueueContext;
+    using GPTAttentionPluginCommon::enqueueGeneration;
+    using GPTAttentionPluginCommon::getWorkspaceSizeForContext;
+    using GPTAttentionPluginCommon::getWorkspaceSizeForGeneration;
+    using GPTAttentionPluginCommon::prepareEnqueueGeneration;
+    using GPTAttentionPluginCommon::reserveSemaphoreArray;
+
+    bool usesContextFMHA() const
+    {
+        return mEnableContextFMHA;
+    }
+
+    int32_t* getSemaphores() const
+    {
+        return mMultiBlockSemaphores.get();
+    }
+
+    // Same check as the first branch of enqueueGeneration
+    template <typename T, typename KVCacheBuffer>
+    bool selectsXQA(EnqueueGenerationParams<T, KVCacheBuffer> const& params)
+    {
+        XQAParams xqaParams{};
+        return XQADispatchHelper<T, KVCacheBuffer>::CanSupport && mDecoderXQARunner.get() != nullptr
+            && this->template convertMMHAParamsToXQAParams<T, KVCacheBuffer>(
+                xqaParams, params, /*forConfigurePlugin=*/false)
+            && mDecoderXQARunner->shouldUse(xqaParams, /*forConfigurePlugin=*/false);
+    }
+};
+
+}; // namespace
+
+constexpr int DEFAULT_SEQ_LEN_CONFIG = 0;
+std::vector<SequenceLengthConfig> seqLenConfigCache{
+    SequenceLengthConfig{"fixed_1k", {1024}, {1.f}, 64},
+    SequenceLengthConfig{"chat_mix", {128, 512, 1024, 2048, 4096, 8192}, {0.1f, 0.3f, 0.3f, 0.15f, 0.1f, 0.05f}, 64},
+    SequenceLengthConfig{"long_tail", {512, 32768}, {0.9f, 0.1f}, 32},
+};
+
+template <class DataType_>
+class AttentionBackendBenchmark : public ::benchmark::Fixture
+{
+public:
+    using DataType = DataType_;
+    constexpr static bool IS_FLOAT = std::is_same_v<DataType, float>;
+
+    template <typename KVCacheBuffer>
+    using ContextParams = AttentionBenchmarkPlugin::EnqueueContextParams<DataType, KVCacheBuffer>;
+    template <typename KVCacheBuffer>
+    using GenerationParams = AttentionBenchmarkPlugin::EnqueueGenerationParams<DataType, KVCacheBuffer>;
+
+    std::vector<BufferManager::IBufferPtr> managed_buffers;
+
+    constexpr static nvinfer1::DataType toDTypeID()
+    {
+        if (std::is_same_v<DataType, float>)
+            return nvinfer1::DataType::kFLOAT;
+        if (std::is_same_v<DataType, half>)
+            return nvinfer1::DataType::kHALF;
+#ifdef ENABLE_BF16
+        if (std::is_same_v<DataType, nv_bfloat16>)
+            return nvinfer1::DataType::kBF16;
+#endif
+        return nvinfer1::DataType::kBOOL;
+    };
+
+    // Deprecated, just here to suppress warnings
+    void SetUp(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    void TearDown(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    cudaEvent_t mStartEvent, mEndEvent;
+
+    void SetUp(benchmark::State& s) override
+    {
+        assert(bufferManager);
+        // Makes sure nothing from a previous iteration hangs around
+        check_cuda_error(cudaDeviceSynchronize());
+        check_cuda_error(cudaEventCreate(&mStartEvent));
+        check_cuda_error(cudaEventCreate(&mEndEvent));
+    }
+
+    void TearDown(benchmark::State& s) override
+    {
+        mPlugin.reset();
+        managed_buffers.clear();
+
+        check_cuda_error(cudaEventDestroy(mStartEvent));
+        check_cuda_error(cudaEventDestroy(mEndEvent));
+        check_cuda_error(cudaDeviceSynchronize());
+    }
+
+    std::unique_ptr<AttentionBenchmarkPlugin> mPlugin;
+
+    AttentionBackend mBackend = AttentionBackend::MMHA;
+    KVCacheDataType mKVDataType = KVCacheDataType::AUTO;
+    int mNumHeads{};
+    int mNumKVHeads{};
+    int mHeadSize{};
+    // 0 selects the contiguous KV cache
+    int mTokensPerBlock{};
+    bool mMultiBlockMode{};
+
+    // Past KV length of each sequence for generation, input length for context
+    std::vector<int> mSeqLengths;
+    int mBatchSize{};
+    int mMaxSeqLength{};
+    int mNumTokens{};
+    int mMaxAttentionWindow{};
+    int mMaxBlocksPerSeq{};
+
+    DataType* mAttentionInput{};
+    DataType* mContextBuf{};
+    void* mKVCache{};
+    KVBlockArray::DataType* mBlockOffsets{};
+    std::vector<int32_t> mHostBlockOffsets;
+    std::vector<int32_t> mHostPastKVLengths;
+    int* mQSeqLengths{};
+    int* mKVSeqLengths{};
+    float* mKVScaleOrigQuant{};
+    float* mKVScaleQuantOrig{};
+    void* mWorkspace{};
+
+    bool isPaged() const
+    {
+        return mTokensPerBlock > 0;
+    }
+
+    int getKVCacheElemSize() const
+    {
+        return mKVDataType == KVCacheDataType::AUTO ? sizeof(DataType) : 1;
+    }
+
+    int getKVCacheQuantMode() const
+    {
+        switch (mKVDataType)
+        {
+        case KVCacheDataType::INT8: return QuantMode::int8KvCache().value();
+        case KVCacheDataType::FP8: return QuantMode::fp8KvCache().value();
+        default: return QuantMode::none().value();
+        }
+    }
+
+    // Returns a reason to skip the configuration, or std::nullopt if it can run
+    std::optional<std::string> checkSupported() const
+    {
+        if (mNumKVHeads <= 0 || mNumHeads % mNumKVHeads != 0)
+            return "num_heads must be a multiple of num_kv_heads";
+        if (isPaged() && (mTokensPerBlock & (mTokensPerBlock - 1)) != 0)
+            return "tokens_per_block must be a power of 2";
+        if (mBackend != AttentionBackend::MMHA && mBackend != AttentionBackend::UNFUSED && IS_FLOAT)
+            return getBackendName(mBackend) + " does not support float";
+        if (mKVDataType == KVCacheDataType::FP8)
+        {
+#ifndef ENABLE_FP8
+            return "FP8 KV cache is not enabled in this build";
+#else
+            if (getSMVersion() < 89)
+                return "GPU does not support FP8";
+#endif
+        }
+        return std::nullopt;
+    }
+
+    template <class T>
+    T* allocBuffer(size_t size)
+    {
+        auto i_buffer = bufferManager->gpu(size * sizeof(T));
+        check_cuda_error(cudaGetLastError());
+        managed_buffers.emplace_back(std::move(i_buffer));
+        T* ptr = static_cast<T*>(managed_buffers.back()->data());
+        check_cuda_error(cudaMemsetAsync(ptr, 0x0, size * sizeof(T), streamPtr->get()));
+        return ptr;
+    }
+
+    template <class T>
+    T* allocBuffer(std::vector<T> const& host)
+    {
+        T* ptr = allocBuffer<T>(host.size());
+        check_cuda_error(
+            cudaMemcpyAsync(ptr, host.data(), host.size() * sizeof(T), cudaMemcpyHostToDevice, streamPtr->get()));
+        return ptr;
+    }
+
+    void initPlugin()
+    {
+        auto const context_fmha_type
+            = mBackend == AttentionBackend::CONTEXT_FMHA ? ContextFMHAType::ENABLED : ContextFMHAType::DISABLED;
+        mPlugin = std::make_unique<AttentionBenchmarkPlugin>(/*layer_idx=*/0, mNumHeads, /*vision_start=*/-1,
+            /*vision_length=*/-1, mNumKVHeads, mHeadSize, /*unidirectional=*/1, /*q_scaling=*/1.f,
+            /*qk_tanh_scale=*/0.f, PositionEmbeddingType::kLEARNED_ABSOLUTE, /*rotary_embedding_dim=*/0,
+            /*rotary_embedding_base=*/10000.f, RotaryScalingType::kNONE, /*rotary_embedding_scale=*/1.f,
+            /*rotary_embedding_short_m_scale=*/1.f, /*rotary_embedding_long_m_scale=*/1.f,
+            /*rotary_embedding_max_positions=*/0, /*rotary_embedding_original_max_positions=*/0, /*tp_size=*/1,
+            /*tp_rank=*/0, /*unfuse_qkv_gemm=*/false, context_fmha_type, mMultiBlockMode,
+            /*enable_xqa=*/mBackend == AttentionBackend::XQA, getKVCacheQuantMode(), /*remove_input_padding=*/true,
+            AttentionMaskType::CAUSAL, BlockSparseParams{}, isPaged(), mTokensPerBlock, toDTypeID(),
+            /*max_context_length=*/mMaxSeqLength, /*qkv_bias_enabled=*/false);
+        mPlugin->initialize();
+    }
+
+    void initBuffers(std::vector<int> const& seq_lengths)
+    {
+        managed_buffers.clear();
+
+        mSeqLengths = seq_lengths;
+        mBatchSize = static_cast<int>(mSeqLengths.size());
+        mMaxSeqLength = *std::max_element(mSeqLengths.begin(), mSeqLengths.end());
+        bool const is_generation = isGenerationBackend(mBackend);
+        mNumTokens = is_generation ? mBatchSize : std::accumulate(mSeqLengths.begin(), mSeqLengths.end(), 0);
+        // Generation appends one token to the past KV of each sequence
+        mMaxAttentionWindow = mMaxSeqLength + (is_generation ? 1 : 0);
+
+        auto const qkv_hidden = static_cast<size_t>(mNumHeads + 2 * mNumKVHeads) * mHeadSize;
+        mAttentionInput = allocBuffer<DataType>(mNumTokens * qkv_hidden);
+        mContextBuf = allocBuffer<DataType>(static_cast<size_t>(mNumTokens) * mNumHeads * mHeadSize);
+
+        auto const bytes_per_token = static_cast<size_t>(mNumKVHeads) * mHeadSize * getKVCacheElemSize();
+        if (isPaged())
+        {
+            // Only the blocks each sequence needs are allocated, K block 2 * i and V block 2 * i + 1 in the pool
+            mMaxBlocksPerSeq = ceilDiv(mMaxAttentionWindow, mTokensPerBlock);
+            mHostBlockOffsets.assign(static_cast<size_t>(mBatchSize) * 2 * mMaxBlocksPerSeq, 0);
+            int num_blocks = 0;
+            for (int si = 0; si < mBatchSize; ++si)
+            {
+                int const seq_blocks = ceilDiv(mSeqLengths[si] + (is_generation ? 1 : 0), mTokensPerBlock);
+                for (int bi = 0; bi < seq_blocks; ++bi, ++num_blocks)
+                {
+                    mHostBlockOffsets[(si * 2) * mMaxBlocksPerSeq + bi] = 2 * num_blocks;
+                    mHostBlockOffsets[(si * 2 + 1) * mMaxBlocksPerSeq + bi] = 2 * num_blocks + 1;
+                }
+            }
+            mKVCache = allocBuffer<int8_t>(static_cast<size_t>(num_blocks) * 2 * mTokensPerBlock * bytes_per_token);
+            mBlockOffsets = reinterpret_cast<KVBlockArray::DataType*>(allocBuffer<int32_t>(mHostBlockOffsets));
+        }
+        else
+        {
+            mMaxBlocksPerSeq = 0;
+            mHostBlockOffsets.clear();
+            mKVCache = allocBuffer<int8_t>(static_cast<size_t>(mBatchSize) * 2 * mMaxAttentionWindow * bytes_per_token);
+            mBlockOffsets = nullptr;
+        }
+
+        if (is_generation)
+        {
+            // The sequence length includes the token being generated
+            std::vector<int> sequence_lengths(mSeqLengths);
+            std::for_each(sequence_lengths.begin(), sequence_lengths.end(), [](int& l) { l += 1; });
+            mQSeqLengths = allocBuffer<int>(mSeqLengths);
+            mKVSeqLengths = allocBuffer<int>(sequence_lengths);
+        }
+        else
+        {
+            mQSeqLengths = allocBuffer<int>(mSeqLengths);
+            mKVSeqLengths = allocBuffer<int>(mSeqLengths);
+        }
+        mHostPastKVLengths.assign(mSeqLengths.begin(), mSeqLengths.end());
+
+        mKVScaleOrigQuant = allocBuffer<float>(std::vector<float>{1.f});
+        mKVScaleQuantOrig = allocBuffer<float>(std::vector<float>{1.f});
+
+        check_cuda_error(cudaStreamSynchronize(streamPtr->get()));
+    }
+
+    void allocWorkspace()
+    {
+        size_t const workspace_size = isGenerationBackend(mBackend)
+            ? mPlugin->getWorkspaceSizeForGeneration(toDTypeID(), mBatchSize, mMaxAttentionWindow, mNumTokens)
+            : mPlugin->getWorkspaceSizeForContext(toDTypeID(), mBatchSize, mMaxSeqLength, 0, mNumTokens);
+        mWorkspace = allocBuffer<int8_t>(workspace_size);
+    }
+
+    template <typename KVCacheBuffer>
+    ContextParams<KVCacheBuffer> makeContextParams()
+    {
+        ContextParams<KVCacheBuffer> params{
+            mAttentionInput, /*qkv_bias=*/nullptr, /*rotary_cos_sin=*/nullptr, mMaxSeqLength,
+            /*max_past_kv_len=*/mMaxSeqLength, mMaxAttentionWindow, mMaxAttentionWindow, /*sink_token_length=*/0,
+            mQSeqLengths, mKVSeqLengths, mKVScaleOrigQuant, mKVScaleQuantOrig, /*attention_output_orig_quant=*/nullptr,
+            /*alibi_slopes=*/nullptr, mContextBuf, isPaged() ? nullptr : mKVCache, mBlockOffsets,
+            isPaged() ? reinterpret_cast<KVBlockArray::DataType*>(mHostBlockOffsets.data()) : nullptr,
+            isPaged() ? mKVCache : nullptr, /*host_secondary_pool_pointer=*/nullptr, mBatchSize, mNumTokens,
+            mMaxBlocksPerSeq, mWorkspace};
+        return params;
+    }
+
+    template <typename KVCacheBuffer>
+    GenerationParams<KVCacheBuffer> makeGenerationParams()
+    {
+        GenerationParams<KVCacheBuffer> params{
+            mAttentionInput, /*qkv_bias=*/nullptr, /*input_seq_length=*/1, mKVSeqLengths,
+            /*max_past_kv_length=*/mMaxSeqLength, /*beam_width=*/1, mQSeqLengths, mKVScaleOrigQuant, mKVScaleQuantOrig,
+            /*attention_output_orig_quant=*/nullptr, /*rotary_embedding_scaling_factors=*/nullptr,
+            /*alibi_slopes=*/nullptr, mContextBuf, isPaged() ? nullptr : mKVCache, mBlockOffsets,
+            isPaged() ? mKVCache : nullptr, /*host_secondary_pool_pointer=*/nullptr, mMaxAttentionWindow,
+            mMaxAttentionWindow, /*sink_token_length=*/0, mBatchSize, mMaxBlocksPerSeq, /*cache_indir=*/nullptr,
+            mPlugin->getSemaphores(), mWorkspace, mHostPastKVLengths.data()};
+        params.total_num_input_tokens = mNumTokens;
+        return params;
+    }
+
+    // Returns a reason to skip the configuration if the plugin would not run the requested backend
+    template <typename KVCacheBuffer>
+    std::optional<std::string> prepareBackend()
+    {
+        if (mBackend == AttentionBackend::CONTEXT_FMHA && !mPlugin->usesContextFMHA())
+        {
+            return "Context FMHA does not support this configuration";
+        }
+        if (isGenerationBackend(mBackend))
+        {
+            // Multi-block mode may be forced when the shared memory is not enough, like in configurePlugin()
+            mPlugin->reserveSemaphoreArray(mNumHeads * mBatchSize);
+            auto const params = makeGenerationParams<KVCacheBuffer>();
+            // Compiles the JIT XQA kernels outside of the timed region
+            mPlugin->prepareEnqueueGeneration(params);
+            if (mBackend == AttentionBackend::XQA && !mPlugin->selectsXQA(params))
+            {
+                return "XQA does not support this configuration";
+            }
+        }
+        return std::nullopt;
+    }
+
+    template <typename KVCacheBuffer>
+    void runAttention()
+    {
+        auto const stream = streamPtr->get();
+        if (isGenerationBackend(mBackend))
+        {
+            mPlugin->enqueueGeneration(makeGenerationParams<KVCacheBuffer>(), stream);
+        }
+        else
+        {
+            mPlugin->enqueueContext(makeContextParams<KVCacheBuffer>(), stream);
+        }
+    }
+
+    template <typename KVCacheBuffer>
+    float benchmarkLoop()
+    {
+        {
+            NVTX3_SCOPED_RANGE(BenchmarkLoopIteration);
+            check_cuda_error(cudaEventRecord(mStartEvent, streamPtr->get()));
+            runAttention<KVCacheBuffer>();
+            check_cuda_error(cudaEventRecord(mEndEvent, streamPtr->get()));
+            check_cuda_error(cudaStreamSynchronize(streamPtr->get()));
+        }
+
+        float ms;
+        check_cuda_error(cudaEventElapsedTime(&ms, mStartEvent, mEndEvent));
+        return ms;
+    }
+
+    // Minimum DRAM traffic of one call: the kernels must read Q/K/V and the KV cache and write the output
+    double getMinBytes() const
+    {
+        size_t const elem_size = sizeof(DataType);
+        size_t const kv_elem_size = getKVCacheElemSize();
+        size_t const q_size = static_cast<size_t>(mNumHeads) * mHeadSize;
+        size_t const kv_size = static_cast<size_t>(mNumKVHeads) * mHeadSize;
+        double bytes = 0.0;
+        if (isGenerationBackend(mBackend))
+        {
+            for (auto const len : mSeqLengths)
+            {
+                // New QKV and output, the past KV is read and the new K/V appended
+                bytes += (2 * q_size + 2 * kv_size) * elem_size + 2.0 * (len + 1) * kv_size * kv_elem_size;
+            }
+        }
+        else
+        {
+            // QKV read, output written and K/V written to the cache
+            bytes += static_cast<double>(mNumTokens)
+                * ((2 * q_size + 2 * kv_size) * elem_size + 2 * kv_size * kv_elem_size);
+        }
+        return bytes;
+    }
+
+    // Causal attention FLOPs of one call: QK^T and PV
+    double getFlops() const
+    {
+        double flops = 0.0;
+        for (auto const len : mSeqLengths)
+        {
+            double const scores = isGenerationBackend(mBackend) ? len + 1.0 : 0.5 * len * (len + 1.0);
+            flops += 4.0 * mNumHeads * mHeadSize * scores;
+        }
+        return flops;
+    }
+
+    static double getPeakBandwidthGBps()
+    {
+        if (peakBandwidthGBps > 0.0)
+            return peakBandwidthGBps;
+        int device, mem_clock_khz, bus_width_bits;
+        check_cuda_error(cudaGetDevice(&device));
+        check_cuda_error(cudaDeviceGetAttribute(&mem_clock_khz, cudaDevAttrMemoryClockRate, device));
+        check_cuda_error(cudaDeviceGetAttribute(&bus_width_bits, cudaDevAttrGlobalMemoryBusWidth, device));
+        // Double data rate
+        return 2.0 * mem_clock_khz * 1e3 * (bus_width_bits / 8) / 1e9;
+    }
+
+    template <typename KVCacheBuffer>
+    void runBenchmarkImpl(benchmark::State& state);
+
+    void runBenchmark(benchmark::State& state);
+};
+
+template <class DataType_>
+template <typename KVCacheBuffer>
+void AttentionBackendBenchmark<DataType_>::runBenchmarkImpl(benchmark::State& state)
+{
+    if (auto const reason = prepareBackend<KVCacheBuffer>())
+    {
+        state.SkipWithMessage(reason->c_str());
+        return;
+    }
+
+    // Warm-Up run
+    benchmarkLoop<KVCacheBuffer>();
+
+    double total_ms = 0.0;
+    {
+        NVTX3_SCOPED_RANGE(BenchmarkRun);
+        for (auto _ : state)
+        {
+            float ms = benchmarkLoop<KVCacheBuffer>();
+            state.SetIterationTime(ms / 1000.f);
+            total_ms += ms;
+        }
+    }
+
+    double const seconds_per_iter = total_ms / 1000.0 / static_cast<double>(state.iterations());
+    double const bytes = getMinBytes();
+    double const flops = getFlops();
+    double const peak_bandwidth = getPeakBandwidthGBps();
+    double const bandwidth = bytes / seconds_per_iter / 1e9;
+    state.counters["bandwidth_GBps"] = bandwidth;
+    state.counters["peak_bandwidth_GBps"] = peak_bandwidth;
+    state.counters["bandwidth_roofline"] = bandwidth / peak_bandwidth;
+    state.counters["TFLOPs"] = flops / seconds_per_iter / 1e12;
+    // The roofline time is bound by whichever of the memory traffic and the math takes longer
+    double roofline_seconds = bytes / (peak_bandwidth * 1e9);
+    if (peakTFlops > 0.0)
+    {
+        roofline_seconds = std::max(roofline_seconds, flops / (peakTFlops * 1e12));
+    }
+    state.counters["roofline_fraction"] = roofline_seconds / seconds_per_iter;
+
+    state.SetItemsProcessed(state.iterations() * mNumTokens);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+template <class DataType_>
+void AttentionBackendBenchmark<DataType_>::runBenchmark(benchmark::State& state)
+{
+    NVTX3_SCOPED_RANGE(FullBenchmark);
+    mBackend = static_cast<AttentionBackend>(state.range(0));
+    mNumHeads = state.range(1);
+    mNumKVHeads = state.range(2);
+    mHeadSize = state.range(3);
+    mTokensPerBlock = state.range(4);
+    mMultiBlockMode = state.range(5);
+    mKVDataType = static_cast<KVCacheDataType>(state.range(6));
+    int const seq_len_config = state.range(7);
+
+    auto const& seq_config = seqLenConfigCache.at(seq_len_config);
+    auto const seq_lengths = seq_config.sampleBatch();
+
+    state.counters["num_heads"] = mNumHeads;
+    state.counters["num_kv_heads"] = mNumKVHeads;
+    state.counters["head_size"] = mHeadSize;
+    state.counters["tokens_per_block"] = mTokensPerBlock;
+    state.counters["multi_block_mode"] = (int) mMultiBlockMode;
+    state.counters["kv_dtype"] = (int) mKVDataType;
+    state.counters["batch_size"] = seq_lengths.size();
+    state.counters["max_seq_len"] = *std::max_element(seq_lengths.begin(), seq_lengths.end());
+    state.counters["mean_seq_len"]
+        = std::accumulate(seq_lengths.begin(), seq_lengths.end(), 0.0) / static_cast<double>(seq_lengths.size());
+    state.counters["dtype"] = (int) toDTypeID();
+
+    state.SetLabel(getBackendName(mBackend) + "," + seq_config.name);
+
+    if (auto const reason = checkSupported())
+    {
+        state.SkipWithMessage(reason->c_str());
+        return;
+    }
+
+    try
+    {
+        initBuffers(seq_lengths);
+        initPlugin();
+        allocWorkspace();
+
+        if (isPaged())
+            runBenchmarkImpl<KVBlockArray>(state);
+        else
+            runBenchmarkImpl<KVLinearBuffer>(state);
+    }
+    catch (std::exception const& e)
+    {
+        if (VERBOSE)
+            std::cout << "Benchmark failed to run with: " << e.what() << std::endl;
+        check_cuda_error(cudaDeviceSynchronize());
+        state.SkipWithError(e.what());
+    }
+
+    // Cleanup all the benchmark state
+    mPlugin.reset();
+    managed_buffers.clear();
+    check_cuda_error(cudaDeviceSynchronize());
+}
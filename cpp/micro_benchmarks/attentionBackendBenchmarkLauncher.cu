@@ -0,0 +1,479 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Include the fixture with the actual benchmark code
+#include "attentionBackendBenchmarkFixture.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+/*
+ * Below is all the setup for parameterising the benchmarks
+ */
+
+#define BENCHMARK_BASIC(dtype)                                                                                         \
+    BENCHMARK_TEMPLATE_DEFINE_F(AttentionBackendBenchmark, Basic_##dtype, dtype)(benchmark::State & state)             \
+    {                                                                                                                  \
+        runBenchmark(state);                                                                                           \
+    }
+
+#define BENCHMARK_BASIC_DO_REGISTER(dtype)                                                                             \
+    BENCHMARK_REGISTER_F(AttentionBackendBenchmark, Basic_##dtype)->Apply(argGen<AttentionBackendBenchmark<dtype>>)
+
+struct WorkloadConfig
+{
+    std::vector<int64_t> args;
+    // Empty runs all dtypes
+    std::vector<std::string> dtypes;
+};
+
+AttentionBackend parseBackend(std::string const& name)
+{
+    static std::unordered_map<std::string, AttentionBackend> const backend_map{
+        {"mmha", AttentionBackend::MMHA},
+        {"xqa", AttentionBackend::XQA},
+        {"context_fmha", AttentionBackend::CONTEXT_FMHA},
+        {"unfused", AttentionBackend::UNFUSED},
+    };
+    auto it = backend_map.find(name);
+    if (it == backend_map.end())
+    {
+        throw std::invalid_argument("Invalid backend " + name);
+    }
+    return it->second;
+}
+
+KVCacheDataType parseKVDataType(std::string const& name)
+{
+    static std::unordered_map<std::string, KVCacheDataType> const kv_dtype_map{
+        {"auto", KVCacheDataType::AUTO},
+        {"int8", KVCacheDataType::INT8},
+        {"fp8", KVCacheDataType::FP8},
+    };
+    auto it = kv_dtype_map.find(name);
+    if (it == kv_dtype_map.end())
+    {
+        throw std::invalid_argument("Invalid kv_dtype " + name);
+    }
+    return it->second;
+}
+
+// A field can be a single value or an array of values to sweep
+template <class ValueType, class Parser>
+std::vector<int64_t> parseSweep(nlohmann::json const& run_config, char const* name, ValueType def, Parser parser)
+{
+    std::vector<int64_t> values;
+    if (!run_config.contains(name))
+    {
+        values.push_back(static_cast<int64_t>(parser(def)));
+    }
+    else if (run_config[name].is_array())
+    {
+        for (auto const& v : run_config[name])
+            values.push_back(static_cast<int64_t>(parser(v.template get<ValueType>())));
+    }
+    else
+    {
+        values.push_back(static_cast<int64_t>(parser(run_config[name].template get<ValueType>())));
+    }
+    return values;
+}
+
+int getSeqLenConfigIdx(std::string const& name)
+{
+    for (int i = 0; i < seqLenConfigCache.size(); i++)
+    {
+        if (seqLenConfigCache[i].name == name)
+            return i;
+    }
+    return -1;
+}
+
+int loadSeqLenConfig(nlohmann::json const& run_config, std::string const& config_name)
+{
+    if (run_config.contains("seq_lens") && run_config["seq_lens"].is_string())
+    {
+        int const idx = getSeqLenConfigIdx(run_config["seq_lens"].get<std::string>());
+        if (idx < 0)
+        {
+            throw std::invalid_argument("Invalid seq_lens value, could not find config "
+                + run_config["seq_lens"].get<std::string>());
+        }
+        return idx;
+    }
+
+    if (getSeqLenConfigIdx(config_name) >= 0)
+    {
+        throw std::invalid_argument("Redefinition of seq_len_name " + config_name);
+    }
+
+    if (run_config.contains("seq_lens"))
+    {
+        std::vector<int> lengths;
+        run_config["seq_lens"].get_to(lengths);
+        seqLenConfigCache.emplace_back(config_name, std::move(lengths), std::vector<float>{}, 0);
+    }
+    else if (run_config.contains("seq_len_distribution"))
+    {
+        auto const& dist = run_config["seq_len_distribution"];
+        std::vector<int> lengths;
+        std::vector<float> weights;
+        dist.at("lengths").get_to(lengths);
+        dist.at("weights").get_to(weights);
+        seqLenConfigCache.emplace_back(
+            config_name, std::move(lengths), std::move(weights), run_config.at("batch_size").get<int>());
+    }
+    else
+    {
+        return DEFAULT_SEQ_LEN_CONFIG;
+    }
+    return static_cast<int>(seqLenConfigCache.size()) - 1;
+}
+
+// The file is only parsed once, the sequence length configs must not be registered again for each data type
+std::vector<WorkloadConfig> const& loadWorkloadFile()
+{
+    static std::optional<std::vector<WorkloadConfig>> workloads;
+    if (workloads)
+        return *workloads;
+
+    /*
+     * See help text for schema description
+     */
+    std::ifstream file{workloadFile};
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto file_contents = buffer.str();
+    if (VERBOSE)
+        std::cout << "Loaded benchmark file: " << file_contents << std::endl;
+    auto source_data = nlohmann::json::parse(file_contents);
+
+    workloads.emplace();
+    int i = 0;
+    for (auto run_config : source_data)
+    {
+        if (VERBOSE)
+            std::cout << "Parsing run config: " << run_config.dump(2) << std::endl;
+        std::string config_name = "config_" + std::to_string(i++);
+        if (run_config.contains("seq_len_name"))
+        {
+            run_config["seq_len_name"].get_to(config_name);
+        }
+        int const seq_len_config = loadSeqLenConfig(run_config, config_name);
+
+        auto const identity = [](auto v) { return v; };
+        auto const backends = parseSweep<std::string>(run_config, "backend", "mmha", parseBackend);
+        int const num_heads = run_config.at("num_heads").get<int>();
+        int const num_kv_heads
+            = run_config.contains("num_kv_heads") ? run_config["num_kv_heads"].get<int>() : num_heads;
+        int const head_size = run_config.at("head_size").get<int>();
+        auto const tokens_per_block = parseSweep<int>(run_config, "tokens_per_block", 64, identity);
+        auto const multi_block_mode = parseSweep<int>(run_config, "multi_block_mode", 1, identity);
+        auto const kv_dtypes = parseSweep<std::string>(run_config, "kv_dtype", "auto", parseKVDataType);
+
+        std::vector<std::string> dtypes;
+        if (run_config.contains("dtypes"))
+        {
+            run_config["dtypes"].get_to(dtypes);
+        }
+
+        for (auto backend : backends)
+            for (auto tpb : tokens_per_block)
+                for (auto multi_block : multi_block_mode)
+                    for (auto kv_dtype : kv_dtypes)
+                    {
+                        workloads->push_back({{backend, num_heads, num_kv_heads, head_size, tpb, multi_block, kv_dtype,
+                                                 seq_len_config},
+                            dtypes});
+                    }
+    }
+    return *workloads;
+}
+
+template <class BenchClass>
+void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
+{
+    for (auto const& workload : loadWorkloadFile())
+    {
+        // Filter out the types we don't care about testing
+        if (!workload.dtypes.empty())
+        {
+            auto const& dtypes = workload.dtypes;
+            auto hasDtype = [&](char const* d)
+            { return std::any_of(dtypes.begin(), dtypes.end(), [&](auto const& n) { return n == d; }); };
+
+            using DataType = typename BenchClass::DataType;
+            if (std::is_same_v<DataType, float> && !hasDtype("float") && !hasDtype("float32"))
+            {
+                continue;
+            }
+            else if (std::is_same_v<DataType, half> && !hasDtype("float16") && !hasDtype("half"))
+            {
+                continue;
+            }
+#ifdef ENABLE_BF16
+            else if (std::is_same_v<DataType, __nv_bfloat16> && !hasDtype("bfloat16") && !hasDtype("bf16"))
+            {
+                continue;
+            }
+#endif
+        }
+        benchmark->Args(workload.args);
+    }
+}
+
+template <class BenchClass>
+void argGenHardcoded(benchmark::internal::Benchmark* benchmark)
+{
+    auto backends = {AttentionBackend::MMHA, AttentionBackend::XQA, AttentionBackend::CONTEXT_FMHA,
+        AttentionBackend::UNFUSED};
+    auto num_heads = {32};
+    auto gqa_ratio = {1, 4}; // {1, 4, 8};
+    auto head_size = {128};  // {64, 128, 256};
+    auto tokens_per_block = {64}; // {0, 16, 32, 64, 128};
+    auto multi_block_mode = {1};  // {0, 1};
+    auto kv_dtype = {KVCacheDataType::AUTO}; // {KVCacheDataType::AUTO, KVCacheDataType::INT8, KVCacheDataType::FP8};
+    auto seq_len_config = {0, 1};            // {0, 1, 2};
+
+    for (auto backend : backends)
+        for (auto heads : num_heads)
+            for (auto ratio : gqa_ratio)
+                for (auto size : head_size)
+                    for (auto tpb : tokens_per_block)
+                        for (auto multi_block : multi_block_mode)
+                            for (auto kv : kv_dtype)
+                                for (auto seq_lens : seq_len_config)
+                                    benchmark->Args({(int) backend, heads, heads / ratio, size, tpb, multi_block,
+                                        (int) kv, seq_lens});
+}
+
+template <class BenchClass>
+void argGen(benchmark::internal::Benchmark* benchmark)
+{
+    // Generic setup
+    benchmark->UseManualTime();
+    benchmark->ArgNames({"Backend", "Num Heads", "Num KV Heads", "Head Size", "Tokens Per Block", "Multi Block",
+        "KV DType", "Seq Len ID"});
+
+    if (workloadFile)
+        argGenLoadFile<BenchClass>(benchmark);
+    else
+        argGenHardcoded<BenchClass>(benchmark);
+}
+
+BENCHMARK_BASIC(float)
+BENCHMARK_BASIC(half)
+#ifdef ENABLE_BF16
+BENCHMARK_BASIC(nv_bfloat16)
+#endif
+
+void delayedRegisterBenchmark()
+{
+    BENCHMARK_BASIC_DO_REGISTER(half);
+    if (workloadFile)
+    {
+        // Extra ones we don't want for hardcoded runs
+        BENCHMARK_BASIC_DO_REGISTER(float);
+#ifdef ENABLE_BF16
+        BENCHMARK_BASIC_DO_REGISTER(nv_bfloat16);
+#endif
+    }
+}
+
+void doCleanup()
+{
+    bufferManager.reset();
+    streamPtr.reset();
+}
+
+void help()
+{
+    std::cout << "Usage: attentionBackendBenchmark [--input_file <file>] [--xqa_impl <jit|precompiled>] "
+                 "[--peak_bandwidth <GB/s>] [--peak_tflops <TFLOP/s>] [benchmark options]\n";
+    std::cout
+        << "--input_file\t\tA JSON file describing the benchmark configurations\n"
+        << "--xqa_impl\t\tThe XQA implementation used by the xqa backend. Sets TRTLLM_ENABLE_XQA_JIT, defaults to jit\n"
+        << "--peak_bandwidth\tThe DRAM bandwidth roofline. Defaults to the bandwidth reported by the device\n"
+        << "--peak_tflops\t\tThe math roofline of the data type. Only the bandwidth roofline is used if omitted\n\n"
+        << "File schema\n"
+           "[\n"
+           "  {\n"
+           "    \"backend\": string or [string, ...], (optional)\n"
+           "    \"num_heads\": int,\n"
+           "    \"num_kv_heads\": int, (optional)\n"
+           "    \"head_size\": int,\n"
+           "    \"tokens_per_block\": int or [int, ...], (optional)\n"
+           "    \"multi_block_mode\": int or [int, ...], (optional)\n"
+           "    \"kv_dtype\": string or [string, ...], (optional)\n"
+           "    \"dtypes\": [string, ...], (optional)\n"
+           "    \"seq_len_name\": string, (optional)\n"
+           "    \"seq_lens\": [int, ...] or string, (optional)\n"
+           "    \"seq_len_distribution\": {\"lengths\": [int, ...], \"weights\": [float, ...]}, (optional)\n"
+           "    \"batch_size\": int, (required with seq_len_distribution)\n"
+           "  },\n"
+           "  ...\n"
+           "]\n"
+           "Explanation:\n"
+           "- \"backend\" - The attention implementation. Defaults to \"mmha\". Allowed values are:\n"
+           "  \"mmha\", \"xqa\" - generation phase, one new token per sequence attending to its past KV cache\n"
+           "  \"context_fmha\", \"unfused\" - context phase, causal attention over the whole sequence\n"
+           "Configurations the plugin would run with a different implementation (e.g. XQA for an unsupported head "
+           "size)\nare skipped with a message\n"
+           "- \"num_heads\" - The number of query heads\n"
+           "- \"num_kv_heads\" - The number of KV heads, num_heads / num_kv_heads is the GQA ratio. Defaults to "
+           "num_heads\n"
+           "- \"head_size\" - The head size\n"
+           "- \"tokens_per_block\" - The paged KV cache block size, a power of 2. 0 uses the contiguous KV cache. "
+           "Defaults to 64\n"
+           "- \"multi_block_mode\" - If the generation kernels may split long sequences across CTAs. Defaults to 1\n"
+           "- \"kv_dtype\" - The KV cache data type. Allowed values are: auto, int8, fp8. Defaults to auto, which is "
+           "the activation data type\n"
+           "- \"dtypes\" - A list of dtypes to run this config through.\n"
+           "Allowed values are: float, half, bfloat16\n"
+           "If this argument is omitted all dtypes will be run\n"
+           "- \"seq_len_name\" - a name to help identify the sequence lengths. This can be used by later benchmarks "
+           "to reuse them\n"
+           "- \"seq_lens\" - the sequence length of each sequence in the batch, or a string referencing the name of a "
+           "previous config.\n"
+           "For generation this is the past KV length, for context the input length. There are pre-defined configs "
+           "\"fixed_1k\" (64 x 1024), \"chat_mix\" (64 sequences of 128 to 8192 tokens) and \"long_tail\" (32 "
+           "sequences of 512 or 32768 tokens).\n"
+           "Defaults to \"fixed_1k\"\n"
+           "- \"seq_len_distribution\" - instead of explicitly setting seq_lens, a weighted distribution of lengths "
+           "that \"batch_size\" sequences are sampled from. The sampling is seeded, so every backend sees the same "
+           "batch\n"
+           "\n"
+           "Each benchmark reports the achieved bandwidth (bandwidth_GBps) computed from the minimum traffic of the "
+           "call (QKV, output and KV cache), the fraction of the bandwidth roofline (bandwidth_roofline), the achieved "
+           "TFLOPs and the fraction of the roofline time (roofline_fraction)\n"
+           "\n";
+
+    std::cout << "benchmark options:\n";
+    benchmark::PrintDefaultHelp();
+}
+
+void gbenchCustomHelp()
+{
+    help();
+    // google-benchmark calls exit() so we need to cleanup manually
+    doCleanup();
+}
+
+int parseArgsAndRunBench(int argc, char** argv)
+{
+    try
+    {
+        int shift = 0;
+        for (int i = 1; i < argc; i++)
+        {
+            argv[i - shift] = argv[i];
+            if (strcmp("--input_file", argv[i]) == 0)
+            {
+                i += 1;
+                if (i == argc)
+                {
+                    std::cerr << "Missing file name for input_file\n";
+                    return -1;
+                }
+                workloadFile = argv[i];
+                if (workloadFile[0] == '-')
+                {
+                    std::cerr << "Workload file " << workloadFile << " not a valid file name\n";
+                    return -2;
+                }
+                shift += 2;
+            }
+            else if (strcmp("--xqa_impl", argv[i]) == 0)
+            {
+                i += 1;
+                if (i == argc || (strcmp("jit", argv[i]) != 0 && strcmp("precompiled", argv[i]) != 0))
+                {
+                    std::cerr << "xqa_impl must be jit or precompiled\n";
+                    return -1;
+                }
+                // Must happen before the first XQA runner reads the variable, it is cached for the process
+                setenv("TRTLLM_ENABLE_XQA_JIT", strcmp("jit", argv[i]) == 0 ? "1" : "0", 1);
+                shift += 2;
+            }
+            else if (strcmp("--peak_bandwidth", argv[i]) == 0 || strcmp("--peak_tflops", argv[i]) == 0)
+            {
+                bool const is_bandwidth = strcmp("--peak_bandwidth", argv[i]) == 0;
+                i += 1;
+                if (i == argc || std::atof(argv[i]) <= 0.0)
+                {
+                    std::cerr << "Missing or invalid value for " << argv[i - 1] << "\n";
+                    return -1;
+                }
+                (is_bandwidth ? peakBandwidthGBps : peakTFlops) = std::atof(argv[i]);
+                shift += 2;
+            }
+            else if (strcmp("--help", argv[i]) == 0 || strcmp("-h", argv[i]) == 0)
+            {
+                help();
+                return 0;
+            }
+        }
+        argc -= shift;
+
+        // Delay after we know if the user passed a config file
+        delayedRegisterBenchmark();
+
+        benchmark::Initialize(&argc, argv, &gbenchCustomHelp);
+
+        if (argc > 1)
+        {
+            help();
+            std::cout << std::flush; // Force flush
+            // Print the error second, so it's easy to see
+            std::cerr << "\nUnrecognised argument: " << argv[1] << std::endl;
+            return -4;
+        }
+
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+
+        return 0;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Exiting benchmarks with exception: " << e.what() << std::endl;
+        return -3;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    deviceCount = getDeviceCount();
+    if (deviceCount < 0)
+        return 0;
+    streamPtr = std::make_shared<CudaStream>();
+    bufferManager = std::make_unique<BufferManager>(streamPtr);
+
+    int res = -1;
+    try
+    {
+        res = parseArgsAndRunBench(argc, argv);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Benchmark exited with unhandled exception: " << e.what() << std::endl;
+    }
+
+    doCleanup();
+    return res;
+}
@@ -0,0 +1,709 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+
+#include "tensorrt_llm/common/cudaAllocator.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/nvtxUtils.h"
+#include "tensorrt_llm/common/tensorConversion.h"
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/decodingKernels.h"
+#include "tensorrt_llm/kernels/penaltyKernels.h"
+#include "tensorrt_llm/kernels/samplingTopKKernels.h"
+#include "tensorrt_llm/kernels/samplingTopPKernels.h"
+#include "tensorrt_llm/kernels/stopCriteriaKernels.h"
+#include "tensorrt_llm/layers/dynamicDecodeLayer.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cuda.h>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+using namespace tensorrt_llm::kernels;
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::layers;
+using namespace tensorrt_llm::runtime;
+
+namespace tcc = tensorrt_llm::common::conversion;
+namespace tle = tensorrt_llm::executor;
+namespace trk = tensorrt_llm::runtime::kernels;
+
+static BufferManager::CudaStreamPtr streamPtr;
+static std::unique_ptr<BufferManager> bufferManager;
+static int deviceCount;
+static char* workloadFile = nullptr;
+// Bandwidth roofline, 0 means it is derived from the device attributes
+static double peakBandwidthGBps = 0.0;
+
+constexpr bool VERBOSE = false;
+
+enum class DecodingOp : int
+{
+    // DynamicDecodeLayer::forwardAsync in top-k/top-p sampling mode, with penalties and stop words
+    DYNAMIC_DECODE_LAYER = 0,
+    TOP_K_SAMPLING = 1,
+    AIR_TOP_P_SAMPLING = 2,
+    // Temperature, repetition, presence and frequency penalties in the generation phase
+    APPLY_PENALTY = 3,
+    STOP_WORDS = 4,
+    // Beam search finalization
+    GATHER_TREE = 5,
+};
+
+inline std::string getOpName(DecodingOp op)
+{
+    switch (op)
+    {
+    case DecodingOp::DYNAMIC_DECODE_LAYER: return "dynamic_decode_layer";
+    case DecodingOp::TOP_K_SAMPLING: return "top_k_sampling";
+    case DecodingOp::AIR_TOP_P_SAMPLING: return "air_top_p_sampling";
+    case DecodingOp::APPLY_PENALTY: return "apply_penalty";
+    case DecodingOp::STOP_WORDS: return "stop_words";
+    case DecodingOp::GATHER_TREE: return "gather_tree";
+    }
+    return "unknown";
+}
+
+// The ops that run with a beam width above 1, sampling and the layer in sampling mode only run with beam width 1
+inline bool supportsBeamSearch(DecodingOp op)
+{
+    return op == DecodingOp::APPLY_PENALTY || op == DecodingOp::STOP_WORDS || op == DecodingOp::GATHER_TREE;
+}
+
+// The ops whose cost depends on the vocab size
+inline bool dependsOnVocab(DecodingOp op)
+{
+    return op != DecodingOp::STOP_WORDS && op != DecodingOp::GATHER_TREE;
+}
+
+// The ops that check stop words
+inline bool usesStopWords(DecodingOp op)
+{
+    return op == DecodingOp::DYNAMIC_DECODE_LAYER || op == DecodingOp::STOP_WORDS;
+}
+
+template <class DataType_>
+class DecodingBenchmark : public ::benchmark::Fixture
+{
+public:
+    using DataType = DataType_;
+    using TensorPtr = ITensor::SharedPtr;
+
+    // Every request is in the generation phase: kInputLength prompt tokens and kSequenceLength tokens so far
+    constexpr static SizeType32 kMaxSeqLength = 1024;
+    constexpr static SizeType32 kInputLength = 512;
+    constexpr static SizeType32 kSequenceLength = 768;
+    constexpr static SizeType32 kTopK = 50;
+    constexpr static float kTopP = 0.9f;
+    // Tokens per stop word
+    constexpr static SizeType32 kStopWordLength = 2;
+    constexpr static uint64_t kSeed = 0xD5;
+
+    constexpr static nvinfer1::DataType toDTypeID()
+    {
+        return TRTDataType<DataType>::value;
+    }
+
+    // Deprecated, just here to suppress warnings
+    void SetUp(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    void TearDown(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    cudaEvent_t mStartEvent, mEndEvent;
+
+    void SetUp(benchmark::State& s) override
+    {
+        assert(bufferManager);
+        // Makes sure nothing from a previous iteration hangs around
+        check_cuda_error(cudaDeviceSynchronize());
+        check_cuda_error(cudaEventCreate(&mStartEvent));
+        check_cuda_error(cudaEventCreate(&mEndEvent));
+    }
+
+    void TearDown(benchmark::State& s) override
+    {
+        freeBuffers();
+
+        check_cuda_error(cudaEventDestroy(mStartEvent));
+        check_cuda_error(cudaEventDestroy(mEndEvent));
+        check_cuda_error(cudaDeviceSynchronize());
+    }
+
+    DecodingOp mOp = DecodingOp::DYNAMIC_DECODE_LAYER;
+    SizeType32 mBatchSize{};
+    SizeType32 mVocabSize{};
+    SizeType32 mVocabSizePadded{};
+    SizeType32 mBeamWidth{};
+    SizeType32 mNumStopWords{};
+    SizeType32 mMaxStopWordsLen{};
+
+    // Order is important, the layer uses the allocator in its destructor
+    std::shared_ptr<CudaAllocator> mAllocator;
+    std::unique_ptr<DynamicDecodeLayer<DataType>> mDecodeLayer;
+
+    // [batchSize, 1, beamWidth, vocabSizePadded], the layer masks and scales the logits in place
+    TensorPtr mLogits;
+    TensorPtr mLogitsInit;
+    // Probabilities of the logits, the input of Air top-P
+    TensorPtr mProbs;
+    TensorPtr mPenaltyLogits;
+    TensorPtr mLogitsPtrs;
+    TensorPtr mPenaltyWorkspace;
+    TensorPtr mPenaltyWorkspacePrev;
+    TensorPtr mTemperatures;
+    TensorPtr mRepetitionPenalties;
+    TensorPtr mPresencePenalties;
+    TensorPtr mFrequencyPenalties;
+
+    // [batchSize, beamWidth, maxSeqLength]
+    TensorPtr mOutputIds;
+    TensorPtr mParentIds;
+    TensorPtr mGatheredIds;
+    TensorPtr mOutputIdsPtrs;
+    TensorPtr mParentIdsPtrs;
+
+    // [batchSize, beamWidth]
+    TensorPtr mSequenceLengths;
+    TensorPtr mSequenceLengthsInit;
+    TensorPtr mInputLengths;
+    TensorPtr mFinished;
+    TensorPtr mCumLogProbs;
+
+    TensorPtr mEndIds;
+    TensorPtr mBatchSlots;
+    TensorPtr mFinishedSum;
+    TensorPtr mNewTokens;
+    TensorPtr mCurandStates;
+    TensorPtr mTopPs;
+    TensorPtr mWorkspace;
+
+    // [batchSize, 2, maxStopWordsLen]
+    TensorPtr mStopWords;
+    TensorPtr mStopWordsPtrs;
+    TensorPtr mStopWordsLens;
+
+    std::shared_ptr<BaseDecodingInputs> mLayerInputs;
+    std::shared_ptr<BaseDecodingOutputs> mLayerOutputs;
+
+    void freeBuffers()
+    {
+        mLayerInputs.reset();
+        mLayerOutputs.reset();
+        mDecodeLayer.reset();
+        mAllocator.reset();
+        for (auto* tensor : {&mLogits, &mLogitsInit, &mProbs, &mPenaltyLogits, &mLogitsPtrs, &mPenaltyWorkspace,
+                 &mPenaltyWorkspacePrev, &mTemperatures, &mRepetitionPenalties, &mPresencePenalties,
+                 &mFrequencyPenalties, &mOutputIds, &mParentIds, &mGatheredIds, &mOutputIdsPtrs, &mParentIdsPtrs,
+                 &mSequenceLengths, &mSequenceLengthsInit, &mInputLengths, &mFinished, &mCumLogProbs, &mEndIds,
+                 &mBatchSlots, &mFinishedSum, &mNewTokens, &mCurandStates, &mTopPs, &mWorkspace, &mStopWords,
+                 &mStopWordsPtrs, &mStopWordsLens})
+        {
+            tensor->reset();
+        }
+    }
+
+    // Returns a reason to skip the configuration, or std::nullopt if it can run
+    std::optional<std::string> checkSupported() const
+    {
+        if (mBatchSize <= 0 || mVocabSize <= 0 || mBeamWidth <= 0)
+            return "batch_size, vocab_size and beam_width must be positive";
+        if (mBeamWidth > 1 && !supportsBeamSearch(mOp))
+            return getOpName(mOp) + " only runs with beam width 1";
+        if (mBeamWidth > 32)
+            return "beam width is limited to 32";
+        if (mOp == DecodingOp::STOP_WORDS && mNumStopWords <= 0)
+            return "stop_words needs at least one stop word";
+        return std::nullopt;
+    }
+
+    TensorPtr gpu(ITensor::Shape const& shape, nvinfer1::DataType type)
+    {
+        TensorPtr tensor = bufferManager->gpu(shape, type);
+        check_cuda_error(cudaMemsetAsync(tensor->data(), 0x0, tensor->getSizeInBytes(), streamPtr->get()));
+        return tensor;
+    }
+
+    TensorPtr pinned(ITensor::Shape const& shape, nvinfer1::DataType type)
+    {
+        TensorPtr tensor = BufferManager::pinned(shape, type);
+        std::memset(tensor->data(), 0x0, tensor->getSizeInBytes());
+        return tensor;
+    }
+
+    template <class T>
+    TensorPtr gpuFilled(ITensor::Shape const& shape, T value)
+    {
+        auto tensor = gpu(shape, TRTDataType<T>::value);
+        trk::invokeFill(*tensor, value, *streamPtr);
+        return tensor;
+    }
+
+    // Pointers to the rows of each batch slot, [batchSize]
+    TensorPtr rowPointers(TensorPtr const& tensor)
+    {
+        auto ptrs = pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT64);
+        auto const rowSize = static_cast<size_t>(mBeamWidth) * kMaxSeqLength;
+        for (SizeType32 bi = 0; bi < mBatchSize; ++bi)
+        {
+            bufferCast<int64_t>(*ptrs)[bi] = reinterpret_cast<int64_t>(bufferCast<SizeType32>(*tensor) + bi * rowSize);
+        }
+        return ptrs;
+    }
+
+    void initBuffers()
+    {
+        auto const batchBeamShape = ITensor::makeShape({mBatchSize, mBeamWidth});
+        auto const idsShape = ITensor::makeShape({mBatchSize, mBeamWidth, kMaxSeqLength});
+        auto const stream = streamPtr->get();
+
+        // Every row has the same logits, the work of the kernels does not depend on the row
+        std::mt19937 gen(kSeed);
+        std::normal_distribution<float> logitDist(0.f, 2.f);
+        std::vector<float> logitsRow(mVocabSizePadded, -INFINITY);
+        std::generate(logitsRow.begin(), logitsRow.begin() + mVocabSize, [&] { return logitDist(gen); });
+        std::vector<DataType> logitsRowHost(logitsRow.begin(), logitsRow.end());
+        mLogitsInit = gpu(ITensor::makeShape({mBatchSize, 1, mBeamWidth, mVocabSizePadded}), toDTypeID());
+        auto const rowBytes = logitsRowHost.size() * sizeof(DataType);
+        for (SizeType32 ri = 0; ri < mBatchSize * mBeamWidth; ++ri)
+        {
+            check_cuda_error(cudaMemcpyAsync(static_cast<int8_t*>(mLogitsInit->data()) + ri * rowBytes,
+                logitsRowHost.data(), rowBytes, cudaMemcpyHostToDevice, stream));
+        }
+        mLogits = gpu(mLogitsInit->getShape(), toDTypeID());
+        bufferManager->copy(*mLogitsInit, *mLogits);
+
+        if (mOp == DecodingOp::AIR_TOP_P_SAMPLING)
+        {
+            auto const maxLogit = *std::max_element(logitsRow.begin(), logitsRow.end());
+            double sum = 0.0;
+            for (auto const logit : logitsRow)
+                sum += std::exp(logit - maxLogit);
+            std::vector<DataType> probsRowHost(mVocabSizePadded);
+            std::transform(logitsRow.begin(), logitsRow.end(), probsRowHost.begin(),
+                [&](float logit) { return static_cast<DataType>(std::exp(logit - maxLogit) / sum); });
+            mProbs = gpu(mLogitsInit->getShape(), toDTypeID());
+            for (SizeType32 bi = 0; bi < mBatchSize; ++bi)
+            {
+                check_cuda_error(cudaMemcpyAsync(static_cast<int8_t*>(mProbs->data()) + bi * rowBytes,
+                    probsRowHost.data(), rowBytes, cudaMemcpyHostToDevice, stream));
+            }
+        }
+
+        // The past tokens are from the first half of the vocab and the stop words from the second, so the stop words
+        // are checked in full but never match
+        std::uniform_int_distribution<TokenIdType> pastTokenDist(0, mVocabSize / 2 - 1);
+        std::vector<TokenIdType> idsHost(static_cast<size_t>(mBatchSize) * mBeamWidth * kMaxSeqLength);
+        std::generate(idsHost.begin(), idsHost.end(), [&] { return pastTokenDist(gen); });
+        mOutputIds = bufferManager->copyFrom(idsHost, idsShape, MemoryType::kGPU);
+        // All the beams descend from beam 0
+        mParentIds = gpu(idsShape, nvinfer1::DataType::kINT32);
+        mGatheredIds = gpu(idsShape, nvinfer1::DataType::kINT32);
+        mOutputIdsPtrs = rowPointers(mOutputIds);
+        mParentIdsPtrs = rowPointers(mParentIds);
+
+        mSequenceLengthsInit = gpuFilled(batchBeamShape, kSequenceLength);
+        mSequenceLengths = gpuFilled(batchBeamShape, kSequenceLength);
+        mInputLengths = gpuFilled(batchBeamShape, kInputLength);
+        mFinished = gpu(batchBeamShape, TRTDataType<FinishedState::UnderlyingType>::value);
+        mCumLogProbs = gpu(batchBeamShape, nvinfer1::DataType::kFLOAT);
+        mEndIds = gpuFilled(ITensor::makeShape({mBatchSize}), TokenIdType{mVocabSize - 1});
+        mFinishedSum = pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        mNewTokens = pinned(ITensor::makeShape({1, mBatchSize}), nvinfer1::DataType::kINT32);
+        mBatchSlots = pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT32);
+        auto* batchSlots = bufferCast<SizeType32>(*mBatchSlots);
+        std::iota(batchSlots, batchSlots + mBatchSize, 0);
+
+        if (mOp == DecodingOp::APPLY_PENALTY)
+        {
+            auto const workspaceShape = ITensor::makeShape({mBatchSize, mBeamWidth, mVocabSize});
+            mPenaltyWorkspace = gpu(workspaceShape, nvinfer1::DataType::kINT32);
+            mPenaltyWorkspacePrev = gpu(workspaceShape, nvinfer1::DataType::kINT32);
+            mPenaltyLogits = gpu(mLogits->getShape(), toDTypeID());
+            mLogitsPtrs = pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT64);
+            auto const rowSize = static_cast<size_t>(mBeamWidth) * mVocabSizePadded;
+            for (SizeType32 bi = 0; bi < mBatchSize; ++bi)
+            {
+                bufferCast<int64_t>(*mLogitsPtrs)[bi]
+                    = reinterpret_cast<int64_t>(bufferCast<DataType>(*mLogits) + bi * rowSize);
+            }
+            auto const slotShape = ITensor::makeShape({mBatchSize});
+            mTemperatures = gpuFilled(slotShape, 0.8f);
+            mRepetitionPenalties = gpuFilled(slotShape, 1.1f);
+            mPresencePenalties = gpuFilled(slotShape, 0.5f);
+            mFrequencyPenalties = gpuFilled(slotShape, 0.5f);
+        }
+
+        if (mOp == DecodingOp::TOP_K_SAMPLING || mOp == DecodingOp::AIR_TOP_P_SAMPLING)
+        {
+            mCurandStates = gpu(
+                ITensor::makeShape({mBatchSize, static_cast<ITensor::DimType64>(sizeof(curandState_t))}),
+                nvinfer1::DataType::kINT8);
+            invokeCurandInitialize(reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStates)), batchSlots,
+                mBatchSize, kSeed, stream);
+        }
+        if (mOp == DecodingOp::TOP_K_SAMPLING)
+        {
+            auto const workspaceSize = getTopKWorkspaceSize<DataType>(mBatchSize, 1, kTopK, mVocabSizePadded);
+            mWorkspace = gpu(
+                ITensor::makeShape({static_cast<ITensor::DimType64>(workspaceSize)}), nvinfer1::DataType::kINT8);
+        }
+        if (mOp == DecodingOp::AIR_TOP_P_SAMPLING)
+        {
+            mTopPs = gpuFilled(ITensor::makeShape({mBatchSize}), kTopP);
+            auto const workspaceSize = getAirTopPWorkspaceSize<DataType>(mBatchSize, mVocabSizePadded, true);
+            mWorkspace = gpu(
+                ITensor::makeShape({static_cast<ITensor::DimType64>(workspaceSize)}), nvinfer1::DataType::kINT8);
+        }
+
+        mMaxStopWordsLen = usesStopWords(mOp) ? mNumStopWords * kStopWordLength : 0;
+        if (mMaxStopWordsLen > 0)
+        {
+            auto const stopWordsShape = ITensor::makeShape({mBatchSize, 2, mMaxStopWordsLen});
+            mStopWords = pinned(stopWordsShape, nvinfer1::DataType::kINT32);
+            mStopWordsPtrs = pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT64);
+            mStopWordsLens = pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT32);
+            std::uniform_int_distribution<TokenIdType> stopTokenDist(mVocabSize / 2, mVocabSize - 2);
+            for (SizeType32 bi = 0; bi < mBatchSize; ++bi)
+            {
+                // Token ids, then the end offset of each word
+                auto* words = bufferCast<TokenIdType>(*mStopWords) + bi * 2 * mMaxStopWordsLen;
+                std::generate(words, words + mMaxStopWordsLen, [&] { return stopTokenDist(gen); });
+                std::fill(words + mMaxStopWordsLen, words + 2 * mMaxStopWordsLen, -1);
+                for (SizeType32 wi = 0; wi < mNumStopWords; ++wi)
+                {
+                    words[mMaxStopWordsLen + wi] = (wi + 1) * kStopWordLength;
+                }
+                bufferCast<int64_t>(*mStopWordsPtrs)[bi] = reinterpret_cast<int64_t>(words);
+                bufferCast<SizeType32>(*mStopWordsLens)[bi] = mMaxStopWordsLen;
+            }
+        }
+
+        check_cuda_error(cudaStreamSynchronize(stream));
+    }
+
+    void initDecodeLayer()
+    {
+        auto const stream = streamPtr->get();
+        mAllocator = std::make_shared<CudaAllocator>(*bufferManager);
+        auto const decodingDomain = DecoderDomain(
+            mBatchSize, mBeamWidth, mVocabSize, mVocabSizePadded, std::make_shared<SpeculativeDecodingModule>(0, 0, 1));
+        mDecodeLayer = std::make_unique<DynamicDecodeLayer<DataType>>(
+            tle::DecodingMode::TopKTopP(), decodingDomain, stream, mAllocator);
+
+        auto setupParams = std::make_shared<DynamicDecodeSetupParams>();
+        setupParams->penaltyParams = std::make_shared<PenaltySetupParams>();
+        setupParams->penaltyParams->temperature = std::vector<float>{0.8f};
+        setupParams->penaltyParams->repetitionPenalty = std::vector<float>{1.1f};
+        setupParams->banWordsParams = std::make_shared<BanWordsSetupParams>();
+        auto samplingParams = std::make_shared<SamplingSetupParams>();
+        samplingParams->randomSeed = std::vector<uint64_t>{kSeed};
+        samplingParams->runtimeTopK = std::vector<SizeType32>{kTopK};
+        samplingParams->runtimeTopP = std::vector<float>{kTopP};
+        setupParams->decodingParams = samplingParams;
+        mDecodeLayer->setup(mBatchSize, mBeamWidth, bufferCast<SizeType32>(*mBatchSlots), setupParams);
+
+        auto inputs = std::make_shared<SamplingInputs>(
+            tcc::toTllmTensor(*mEndIds), /*step=*/kSequenceLength, /*ite=*/0, mBatchSize);
+        inputs->logits = tcc::toTllmTensor(*mLogits);
+        inputs->finished = tcc::toTllmTensor(*mFinished);
+        inputs->batchSlots = tcc::toTllmTensor(*mBatchSlots);
+        inputs->banWordsInputs = std::make_shared<BanWordsDecodingInputs>(mBatchSize);
+        inputs->stopCriteriaInputs = std::make_shared<StopCriteriaDecodingInputs>(mBatchSize);
+        if (mMaxStopWordsLen > 0)
+        {
+            inputs->stopCriteriaInputs->stopWordsPtr = tcc::toTllmTensor(*mStopWordsPtrs);
+            inputs->stopCriteriaInputs->stopWordsLengths = tcc::toTllmTensor(*mStopWordsLens);
+            inputs->stopCriteriaInputs->maxStopWordsLen = mMaxStopWordsLen;
+        }
+        mLayerInputs = inputs;
+
+        mLayerOutputs = std::make_shared<BaseDecodingOutputs>(tcc::toTllmTensor(*mOutputIds));
+        mLayerOutputs->sequenceLength = tcc::toTllmTensor(*mSequenceLengths);
+        mLayerOutputs->finished = tcc::toTllmTensor(*mFinished);
+        mLayerOutputs->finishedSum = tcc::toTllmTensor(*mFinishedSum);
+        mLayerOutputs->newTokens = tcc::toTllmTensor(*mNewTokens);
+
+        check_cuda_error(cudaStreamSynchronize(stream));
+    }
+
+    // Undoes what the previous iteration changed outside of the timed region: sampling appends a token and may finish
+    // the request, and the layer updates the logits in place
+    void resetState()
+    {
+        if (mOp == DecodingOp::DYNAMIC_DECODE_LAYER)
+        {
+            bufferManager->copy(*mLogitsInit, *mLogits);
+        }
+        bufferManager->copy(*mSequenceLengthsInit, *mSequenceLengths);
+        check_cuda_error(cudaMemsetAsync(mFinished->data(), 0x0, mFinished->getSizeInBytes(), streamPtr->get()));
+    }
+
+    void runTopKSampling()
+    {
+        TopKSamplingKernelParams<DataType> params;
+        params.logProbs = bufferCast<DataType>(*mLogits);
+        params.outputIdsPtrs = reinterpret_cast<TokenIdType**>(bufferCast<int64_t>(*mOutputIdsPtrs));
+        params.workspace = mWorkspace->data();
+        params.endIds = bufferCast<TokenIdType>(*mEndIds);
+        params.sequenceLengths = bufferCast<SizeType32>(*mSequenceLengths);
+        params.batchSlots = bufferCast<SizeType32>(*mBatchSlots);
+        params.finishedInput = reinterpret_cast<FinishedState*>(bufferCast<FinishedState::UnderlyingType>(*mFinished));
+        params.finishedOutput = reinterpret_cast<FinishedState*>(bufferCast<FinishedState::UnderlyingType>(*mFinished));
+        params.curandState = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStates));
+        params.maxTopK = kTopK;
+        params.batchSize = mBatchSize;
+        params.maxBatchSize = mBatchSize;
+        params.vocabSizePadded = mVocabSizePadded;
+        params.maxTokensPerStep = 1;
+        params.maxSeqLen = kMaxSeqLength;
+        invokeBatchTopKSampling(params, streamPtr->get());
+    }
+
+    void runAirTopPSampling()
+    {
+        int device, smCount;
+        check_cuda_error(cudaGetDevice(&device));
+        check_cuda_error(cudaDeviceGetAttribute(&smCount, cudaDevAttrMultiProcessorCount, device));
+
+        TopPSamplingKernelParams<DataType> params;
+        params.probs = bufferCast<DataType>(*mProbs);
+        params.outputIds = reinterpret_cast<TokenIdType**>(bufferCast<int64_t>(*mOutputIdsPtrs));
+        params.workspace = mWorkspace->data();
+        params.topPs = bufferCast<float>(*mTopPs);
+        params.sequenceLength = bufferCast<SizeType32>(*mSequenceLengths);
+        params.endIds = bufferCast<TokenIdType>(*mEndIds);
+        params.batchSlots = bufferCast<SizeType32>(*mBatchSlots);
+        params.finishedInput = reinterpret_cast<FinishedState*>(bufferCast<FinishedState::UnderlyingType>(*mFinished));
+        params.finishedOutput = reinterpret_cast<FinishedState*>(bufferCast<FinishedState::UnderlyingType>(*mFinished));
+        params.curandState = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStates));
+        params.blockNum = calcAirTopPBlockNum<DataType>(mBatchSize, mVocabSizePadded, smCount, true);
+        params.isDeterministic = true;
+        params.batchSize = mBatchSize;
+        params.maxBatchSize = mBatchSize;
+        params.vocabSizePadded = mVocabSizePadded;
+        invokeBatchAirTopPSampling(params, streamPtr->get());
+    }
+
+    void runApplyPenalty()
+    {
+        InvokeBatchApplyPenaltyParams<DataType> params{
+            reinterpret_cast<DataType const* const*>(bufferCast<int64_t>(*mLogitsPtrs)),
+            bufferCast<DataType>(*mPenaltyLogits), /*biases=*/nullptr, bufferCast<TokenIdType>(*mPenaltyWorkspace),
+            bufferCast<TokenIdType>(*mPenaltyWorkspacePrev), bufferCast<float>(*mTemperatures),
+            bufferCast<float>(*mRepetitionPenalties), bufferCast<float>(*mPresencePenalties),
+            bufferCast<float>(*mFrequencyPenalties), mBatchSize, mBeamWidth, kMaxSeqLength, mVocabSize,
+            mVocabSizePadded, reinterpret_cast<TokenIdType const**>(bufferCast<int64_t>(*mOutputIdsPtrs)),
+            reinterpret_cast<SizeType32 const**>(bufferCast<int64_t>(*mParentIdsPtrs)),
+            bufferCast<SizeType32>(*mInputLengths), bufferCast<SizeType32>(*mSequenceLengths), /*minLengths=*/nullptr,
+            bufferCast<TokenIdType>(*mEndIds), bufferCast<SizeType32>(*mBatchSlots), /*maxTokensPerStep=*/1,
+            /*tokensPerStep=*/nullptr, streamPtr->get()};
+        invokeBatchApplyPenalty(params);
+    }
+
+    void runStopWords()
+    {
+        invokeStopWordsCriterion(reinterpret_cast<TokenIdType const**>(bufferCast<int64_t>(*mOutputIdsPtrs)),
+            reinterpret_cast<SizeType32 const**>(bufferCast<int64_t>(*mParentIdsPtrs)),
+            reinterpret_cast<TokenIdType const**>(bufferCast<int64_t>(*mStopWordsPtrs)),
+            reinterpret_cast<FinishedState*>(bufferCast<FinishedState::UnderlyingType>(*mFinished)),
+            bufferCast<SizeType32>(*mSequenceLengths), bufferCast<SizeType32>(*mBatchSlots),
+            bufferCast<SizeType32>(*mStopWordsLens), /*numNewTokens=*/nullptr, mMaxStopWordsLen, mBatchSize,
+            mBeamWidth, kMaxSeqLength, /*skipSlots=*/nullptr, streamPtr->get());
+    }
+
+    void runGatherTree()
+    {
+        gatherTreeParam param;
+        param.sequenceLengths = bufferCast<SizeType32>(*mSequenceLengths);
+        // Keeps the sequence lengths unchanged, the kernel adds maxSequenceLengthFinalStep - 1
+        param.maxSequenceLengthFinalStep = 1;
+        param.inputLengths = bufferCast<SizeType32>(*mInputLengths);
+        param.maxSeqLen = kMaxSeqLength;
+        param.batchSize = mBatchSize;
+        param.beamWidth = mBeamWidth;
+        param.stepIds = bufferCast<TokenIdType>(*mOutputIds);
+        param.parentIds = bufferCast<SizeType32>(*mParentIds);
+        param.endTokens = bufferCast<TokenIdType>(*mEndIds);
+        param.outputIds = bufferCast<TokenIdType>(*mGatheredIds);
+        param.stream = streamPtr->get();
+        param.cumLogProbs = bufferCast<float>(*mCumLogProbs);
+        invokeGatherTree(param);
+    }
+
+    void runOp()
+    {
+        switch (mOp)
+        {
+        case DecodingOp::DYNAMIC_DECODE_LAYER: mDecodeLayer->forwardAsync(mLayerOutputs, mLayerInputs); break;
+        case DecodingOp::TOP_K_SAMPLING: runTopKSampling(); break;
+        case DecodingOp::AIR_TOP_P_SAMPLING: runAirTopPSampling(); break;
+        case DecodingOp::APPLY_PENALTY: runApplyPenalty(); break;
+        case DecodingOp::STOP_WORDS: runStopWords(); break;
+        case DecodingOp::GATHER_TREE: runGatherTree(); break;
+        }
+    }
+
+    float benchmarkLoop()
+    {
+        resetState();
+        {
+            NVTX3_SCOPED_RANGE(BenchmarkLoopIteration);
+            check_cuda_error(cudaEventRecord(mStartEvent, streamPtr->get()));
+            runOp();
+            check_cuda_error(cudaEventRecord(mEndEvent, streamPtr->get()));
+            check_cuda_error(cudaStreamSynchronize(streamPtr->get()));
+        }
+
+        float ms;
+        check_cuda_error(cudaEventElapsedTime(&ms, mStartEvent, mEndEvent));
+        return ms;
+    }
+
+    // Minimum DRAM traffic of one call
+    double getMinBytes() const
+    {
+        double const numRows = static_cast<double>(mBatchSize) * mBeamWidth;
+        double const logitsBytes = numRows * mVocabSizePadded * sizeof(DataType);
+        switch (mOp)
+        {
+        // The logits are read at least once, the layer also writes them back when applying the penalties
+        case DecodingOp::DYNAMIC_DECODE_LAYER: return 2 * logitsBytes;
+        case DecodingOp::TOP_K_SAMPLING:
+        case DecodingOp::AIR_TOP_P_SAMPLING: return logitsBytes;
+        case DecodingOp::APPLY_PENALTY:
+            // Beams copy the token counts of their parent beam
+            return 2 * logitsBytes + (mBeamWidth > 1 ? 2.0 * numRows * mVocabSize * sizeof(SizeType32) : 0.0);
+        // The stop words and the last tokens of the sequence they are compared with
+        case DecodingOp::STOP_WORDS: return numRows * 3.0 * mMaxStopWordsLen * sizeof(TokenIdType);
+        // The step and parent ids are read up to the sequence length and the output ids written in full
+        case DecodingOp::GATHER_TREE: return numRows * (2.0 * kSequenceLength + kMaxSeqLength) * sizeof(TokenIdType);
+        }
+        return 0.0;
+    }
+
+    static double getPeakBandwidthGBps()
+    {
+        if (peakBandwidthGBps > 0.0)
+            return peakBandwidthGBps;
+        int device, mem_clock_khz, bus_width_bits;
+        check_cuda_error(cudaGetDevice(&device));
+        check_cuda_error(cudaDeviceGetAttribute(&mem_clock_khz, cudaDevAttrMemoryClockRate, device));
+        check_cuda_error(cudaDeviceGetAttribute(&bus_width_bits, cudaDevAttrGlobalMemoryBusWidth, device));
+        // Double data rate
+        return 2.0 * mem_clock_khz * 1e3 * (bus_width_bits / 8) / 1e9;
+    }
+
+    void runBenchmarkImpl(benchmark::State& state);
+
+    void runBenchmark(benchmark::State& state);
+};
+
+template <class DataType_>
+void DecodingBenchmark<DataType_>::runBenchmarkImpl(benchmark::State& state)
+{
+    // Warm-Up run
+    benchmarkLoop();
+
+    double total_ms = 0.0;
+    {
+        NVTX3_SCOPED_RANGE(BenchmarkRun);
+        for (auto _ : state)
+        {
+            float ms = benchmarkLoop();
+            state.SetIterationTime(ms / 1000.f);
+            total_ms += ms;
+        }
+    }
+
+    double const seconds_per_iter = total_ms / 1000.0 / static_cast<double>(state.iterations());
+    double const bytes = getMinBytes();
+    double const peak_bandwidth = getPeakBandwidthGBps();
+    double const bandwidth = bytes / seconds_per_iter / 1e9;
+    state.counters["bandwidth_GBps"] = bandwidth;
+    state.counters["peak_bandwidth_GBps"] = peak_bandwidth;
+    state.counters["bandwidth_roofline"] = bandwidth / peak_bandwidth;
+
+    state.SetItemsProcessed(state.iterations() * mBatchSize * mBeamWidth);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes));
+}
+
+template <class DataType_>
+void DecodingBenchmark<DataType_>::runBenchmark(benchmark::State& state)
+{
+    NVTX3_SCOPED_RANGE(FullBenchmark);
+    mOp = static_cast<DecodingOp>(state.range(0));
+    mBatchSize = state.range(1);
+    mVocabSize = state.range(2);
+    mBeamWidth = state.range(3);
+    mNumStopWords = state.range(4);
+    mVocabSizePadded = ceilDiv(mVocabSize, 8) * 8;
+
+    state.counters["batch_size"] = mBatchSize;
+    state.counters["vocab_size"] = mVocabSize;
+    state.counters["beam_width"] = mBeamWidth;
+    state.counters["num_stop_words"] = mNumStopWords;
+    state.counters["dtype"] = (int) toDTypeID();
+
+    state.SetLabel(getOpName(mOp));
+
+    if (auto const reason = checkSupported())
+    {
+        state.SkipWithMessage(reason->c_str());
+        return;
+    }
+
+    try
+    {
+        initBuffers();
+        if (mOp == DecodingOp::DYNAMIC_DECODE_LAYER)
+            initDecodeLayer();
+
+        runBenchmarkImpl(state);
+    }
+    catch (std::exception const& e)
+    {
+        if (VERBOSE)
+            std::cout << "Benchmark failed to run with: " << e.what() << std::endl;
+        check_cuda_error(cudaDeviceSynchronize());
+        state.SkipWithError(e.what());
+    }
+
+    // Cleanup all the benchmark state
+    freeBuffers();
+    check_cuda_error(cudaDeviceSynchronize());
+}
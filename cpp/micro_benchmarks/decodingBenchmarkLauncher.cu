@@ -0,0 +1,364 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Include the fixture with the actual benchmark code
+#include "decodingBenchmarkFixture.h"
+
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+
+/*
+ * Below is all the setup for parameterising the benchmarks
+ */
+
+#define BENCHMARK_BASIC(dtype)                                                                                         \
+    BENCHMARK_TEMPLATE_DEFINE_F(DecodingBenchmark, Basic_##dtype, dtype)(benchmark::State & state)                     \
+    {                                                                                                                  \
+        runBenchmark(state);                                                                                           \
+    }
+
+#define BENCHMARK_BASIC_DO_REGISTER(dtype)                                                                             \
+    BENCHMARK_REGISTER_F(DecodingBenchmark, Basic_##dtype)->Apply(argGen<DecodingBenchmark<dtype>>)
+
+struct WorkloadConfig
+{
+    std::vector<int64_t> args;
+    // Empty runs all dtypes
+    std::vector<std::string> dtypes;
+};
+
+DecodingOp parseOp(std::string const& name)
+{
+    static std::unordered_map<std::string, DecodingOp> const op_map{
+        {"dynamic_decode_layer", DecodingOp::DYNAMIC_DECODE_LAYER},
+        {"top_k_sampling", DecodingOp::TOP_K_SAMPLING},
+        {"air_top_p_sampling", DecodingOp::AIR_TOP_P_SAMPLING},
+        {"apply_penalty", DecodingOp::APPLY_PENALTY},
+        {"stop_words", DecodingOp::STOP_WORDS},
+        {"gather_tree", DecodingOp::GATHER_TREE},
+    };
+    auto it = op_map.find(name);
+    if (it == op_map.end())
+    {
+        throw std::invalid_argument("Invalid op " + name);
+    }
+    return it->second;
+}
+
+// A field can be a single value or an array of values to sweep
+template <class ValueType, class Parser>
+std::vector<int64_t> parseSweep(nlohmann::json const& run_config, char const* name, ValueType def, Parser parser)
+{
+    std::vector<int64_t> values;
+    if (!run_config.contains(name))
+    {
+        values.push_back(static_cast<int64_t>(parser(def)));
+    }
+    else if (run_config[name].is_array())
+    {
+        for (auto const& v : run_config[name])
+            values.push_back(static_cast<int64_t>(parser(v.template get<ValueType>())));
+    }
+    else
+    {
+        values.push_back(static_cast<int64_t>(parser(run_config[name].template get<ValueType>())));
+    }
+    return values;
+}
+
+// The file is only parsed once for all the data types
+std::vector<WorkloadConfig> const& loadWorkloadFile()
+{
+    static std::optional<std::vector<WorkloadConfig>> workloads;
+    if (workloads)
+        return *workloads;
+
+    /*
+     * See help text for schema description
+     */
+    std::ifstream file{workloadFile};
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto file_contents = buffer.str();
+    if (VERBOSE)
+        std::cout << "Loaded benchmark file: " << file_contents << std::endl;
+    auto source_data = nlohmann::json::parse(file_contents);
+
+    workloads.emplace();
+    for (auto run_config : source_data)
+    {
+        if (VERBOSE)
+            std::cout << "Parsing run config: " << run_config.dump(2) << std::endl;
+
+        auto const identity = [](auto v) { return v; };
+        auto const ops = parseSweep<std::string>(run_config, "op", "dynamic_decode_layer", parseOp);
+        auto const batch_sizes = parseSweep<int>(run_config, "batch_size", 64, identity);
+        auto const vocab_sizes = parseSweep<int>(run_config, "vocab_size", 32000, identity);
+        auto const beam_widths = parseSweep<int>(run_config, "beam_width", 1, identity);
+        auto const num_stop_words = parseSweep<int>(run_config, "num_stop_words", 0, identity);
+
+        std::vector<std::string> dtypes;
+        if (run_config.contains("dtypes"))
+        {
+            run_config["dtypes"].get_to(dtypes);
+        }
+
+        for (auto op : ops)
+            for (auto batch_size : batch_sizes)
+                for (auto vocab_size : vocab_sizes)
+                    for (auto beam_width : beam_widths)
+                        for (auto stop_words : num_stop_words)
+                        {
+                            workloads->push_back({{op, batch_size, vocab_size, beam_width, stop_words}, dtypes});
+                        }
+    }
+    return *workloads;
+}
+
+template <class BenchClass>
+void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
+{
+    for (auto const& workload : loadWorkloadFile())
+    {
+        // Filter out the types we don't care about testing
+        if (!workload.dtypes.empty())
+        {
+            auto const& dtypes = workload.dtypes;
+            auto hasDtype = [&](char const* d)
+            { return std::any_of(dtypes.begin(), dtypes.end(), [&](auto const& n) { return n == d; }); };
+
+            using DataType = typename BenchClass::DataType;
+            if (std::is_same_v<DataType, float> && !hasDtype("float") && !hasDtype("float32"))
+            {
+                continue;
+            }
+            else if (std::is_same_v<DataType, half> && !hasDtype("float16") && !hasDtype("half"))
+            {
+                continue;
+            }
+        }
+        benchmark->Args(workload.args);
+    }
+}
+
+template <class BenchClass>
+void argGenHardcoded(benchmark::internal::Benchmark* benchmark)
+{
+    auto ops = {DecodingOp::DYNAMIC_DECODE_LAYER, DecodingOp::TOP_K_SAMPLING, DecodingOp::AIR_TOP_P_SAMPLING,
+        DecodingOp::APPLY_PENALTY, DecodingOp::STOP_WORDS, DecodingOp::GATHER_TREE};
+    auto batch_sizes = {1, 8, 64, 256};
+    auto vocab_sizes = {32000, 128256, 256000};
+    auto beam_widths = {1, 4};     // {1, 2, 4, 8};
+    auto num_stop_words = {0, 16}; // {0, 1, 16, 64};
+
+    for (auto op : ops)
+        for (auto batch_size : batch_sizes)
+            for (auto vocab_size : vocab_sizes)
+                for (auto beam_width : beam_widths)
+                    for (auto stop_words : num_stop_words)
+                    {
+                        // Only sweep the dimensions the op depends on
+                        if ((!dependsOnVocab(op) && vocab_size != *vocab_sizes.begin())
+                            || (!supportsBeamSearch(op) && beam_width != 1)
+                            || (!usesStopWords(op) && stop_words != 0)
+                            || (op == DecodingOp::STOP_WORDS && stop_words == 0))
+                        {
+                            continue;
+                        }
+                        benchmark->Args({(int) op, batch_size, vocab_size, beam_width, stop_words});
+                    }
+}
+
+template <class BenchClass>
+void argGen(benchmark::internal::Benchmark* benchmark)
+{
+    // Generic setup
+    benchmark->UseManualTime();
+    benchmark->ArgNames({"Op", "Batch Size", "Vocab Size", "Beam Width", "Num Stop Words"});
+
+    if (workloadFile)
+        argGenLoadFile<BenchClass>(benchmark);
+    else
+        argGenHardcoded<BenchClass>(benchmark);
+}
+
+BENCHMARK_BASIC(float)
+BENCHMARK_BASIC(half)
+
+void delayedRegisterBenchmark()
+{
+    BENCHMARK_BASIC_DO_REGISTER(half);
+    if (workloadFile)
+    {
+        // Extra ones we don't want for hardcoded runs
+        BENCHMARK_BASIC_DO_REGISTER(float);
+    }
+}
+
+void doCleanup()
+{
+    bufferManager.reset();
+    streamPtr.reset();
+}
+
+void help()
+{
+    std::cout << "Usage: decodingBenchmark [--input_file <file>] [--peak_bandwidth <GB/s>] [benchmark options]\n";
+    std::cout
+        << "--input_file\t\tA JSON file describing the benchmark configurations\n"
+        << "--peak_bandwidth\tThe DRAM bandwidth roofline. Defaults to the bandwidth reported by the device\n\n"
+        << "File schema\n"
+           "[\n"
+           "  {\n"
+           "    \"op\": string or [string, ...], (optional)\n"
+           "    \"batch_size\": int or [int, ...], (optional)\n"
+           "    \"vocab_size\": int or [int, ...], (optional)\n"
+           "    \"beam_width\": int or [int, ...], (optional)\n"
+           "    \"num_stop_words\": int or [int, ...], (optional)\n"
+           "    \"dtypes\": [string, ...], (optional)\n"
+           "  },\n"
+           "  ...\n"
+           "]\n"
+           "Explanation:\n"
+           "- \"op\" - The part of the decoding stack to run. Defaults to \"dynamic_decode_layer\". Allowed values "
+           "are:\n"
+           "  \"dynamic_decode_layer\" - DynamicDecodeLayer::forwardAsync in top-k/top-p sampling mode with a "
+           "temperature, a repetition penalty and the stop words. Beam width 1 only\n"
+           "  \"top_k_sampling\" - invokeBatchTopKSampling with k = 50. Beam width 1 only\n"
+           "  \"air_top_p_sampling\" - invokeBatchAirTopPSampling with p = 0.9. Beam width 1 only\n"
+           "  \"apply_penalty\" - invokeBatchApplyPenalty with temperature, repetition, presence and frequency "
+           "penalties\n"
+           "  \"stop_words\" - invokeStopWordsCriterion\n"
+           "  \"gather_tree\" - invokeGatherTree, the final beam search step\n"
+           "Configurations an op does not support are skipped with a message\n"
+           "- \"batch_size\" - The number of requests. Defaults to 64\n"
+           "- \"vocab_size\" - The vocab size, padded to a multiple of 8. Defaults to 32000\n"
+           "- \"beam_width\" - The beam width. Defaults to 1\n"
+           "- \"num_stop_words\" - The number of stop words of each request, every stop word has 2 tokens. Defaults "
+           "to 0\n"
+           "- \"dtypes\" - A list of dtypes to run this config through.\n"
+           "Allowed values are: float, half\n"
+           "If this argument is omitted all dtypes will be run\n"
+           "\n"
+           "Every request is in the generation phase with 768 tokens, 512 of them from the prompt, out of at most "
+           "1024.\n"
+           "Each benchmark reports the achieved bandwidth (bandwidth_GBps) computed from the minimum traffic of the "
+           "call and its fraction of the bandwidth roofline (bandwidth_roofline)\n"
+           "\n";
+
+    std::cout << "benchmark options:\n";
+    benchmark::PrintDefaultHelp();
+}
+
+void gbenchCustomHelp()
+{
+    help();
+    // google-benchmark calls exit() so we need to cleanup manually
+    doCleanup();
+}
+
+int parseArgsAndRunBench(int argc, char** argv)
+{
+    try
+    {
+        int shift = 0;
+        for (int i = 1; i < argc; i++)
+        {
+            argv[i - shift] = argv[i];
+            if (strcmp("--input_file", argv[i]) == 0)
+            {
+                i += 1;
+                if (i == argc)
+                {
+                    std::cerr << "Missing file name for input_file\n";
+                    return -1;
+                }
+                workloadFile = argv[i];
+                if (workloadFile[0] == '-')
+                {
+                    std::cerr << "Workload file " << workloadFile << " not a valid file name\n";
+                    return -2;
+                }
+                shift += 2;
+            }
+            else if (strcmp("--peak_bandwidth", argv[i]) == 0)
+            {
+                i += 1;
+                if (i == argc || std::atof(argv[i]) <= 0.0)
+                {
+                    std::cerr << "Missing or invalid value for " << argv[i - 1] << "\n";
+                    return -1;
+                }
+                peakBandwidthGBps = std::atof(argv[i]);
+                shift += 2;
+            }
+            else if (strcmp("--help", argv[i]) == 0 || strcmp("-h", argv[i]) == 0)
+            {
+                help();
+                return 0;
+            }
+        }
+        argc -= shift;
+
+        // Delay after we know if the user passed a config file
+        delayedRegisterBenchmark();
+
+        benchmark::Initialize(&argc, argv, &gbenchCustomHelp);
+
+        if (argc > 1)
+        {
+            help();
+            std::cout << std::flush; // Force flush
+            // Print the error second, so it's easy to see
+            std::cerr << "\nUnrecognised argument: " << argv[1] << std::endl;
+            return -4;
+        }
+
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+
+        return 0;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Exiting benchmarks with exception: " << e.what() << std::endl;
+        return -3;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    deviceCount = getDeviceCount();
+    if (deviceCount < 0)
+        return 0;
+    streamPtr = std::make_shared<CudaStream>();
+    bufferManager = std::make_unique<BufferManager>(streamPtr);
+
+    int res = -1;
+    try
+    {
+        res = parseArgsAndRunBench(argc, argv);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Benchmark exited with unhandled exception: " << e.what() << std::endl;
+    }
+
+    doCleanup();
+    return res;
+}
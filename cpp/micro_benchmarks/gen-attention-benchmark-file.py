@@ -0,0 +1,96 @@
+import argparse
+import json
+
+template = '''{{
+  "backend": {backend},
+  "num_heads": {num_heads},
+  "num_kv_heads": {num_kv_heads},
+  "head_size": {head_size},
+  "tokens_per_block": {tokens_per_block},
+  "multi_block_mode": {multi_block_mode},
+  "kv_dtype": {kv_dtype},
+  {dtype_string}
+  {seq_len_string}
+}}'''
+
+
+def make_dtype_string(dtypes=None):
+    if dtypes is None:
+        return ""
+    if not isinstance(dtypes, list):
+        dtypes = [dtypes]
+    return f'"dtypes": {json.dumps(dtypes)},'
+
+
+def make_seq_len_string(name=None,
+                        lengths=None,
+                        weights=None,
+                        batch_size=None):
+    values = []
+    if lengths is None:
+        # Reference a previous or pre-defined config
+        values.append(f'"seq_lens": "{name}"')
+    elif weights is None:
+        values.append(f'"seq_lens": {json.dumps(lengths)}')
+    else:
+        values.append(
+            f'"seq_len_distribution": {json.dumps({"lengths": lengths, "weights": weights})}'
+        )
+        values.append(f'"batch_size": {batch_size}')
+    if lengths is not None and name is not None:
+        values.append(f'"seq_len_name": "{name}"')
+    return ", ".join(values)
+
+
+def populate_benchmark_config(**kwargs):
+    return template.format(**kwargs)
+
+
+# Default Llama-3-8B configuration with TP 1
+num_heads = 32
+num_kv_heads = 8
+head_size = 128
+tokens_per_block = json.dumps([32, 64, 128])
+kv_dtype = json.dumps(["auto", "int8", "fp8"])
+dtype_string = make_dtype_string(["float16", "bfloat16"])
+
+# A chat-like mix of sequence lengths, the first config defines it and the others reuse it by name
+seq_len_strings = [
+    make_seq_len_string(name="chat",
+                        lengths=[256, 1024, 2048, 4096, 16384],
+                        weights=[0.2, 0.35, 0.25, 0.15, 0.05],
+                        batch_size=64),
+    make_seq_len_string(name="chat"),
+]
+
+# Multi-block mode only applies to the generation phase
+backends = [('["mmha", "xqa"]', "[0, 1]"), ('"context_fmha"', "1")]
+
+configs = []
+for (backend, multi_block_mode), seq_len_string in zip(backends,
+                                                       seq_len_strings):
+    configs.append(
+        populate_benchmark_config(
+            backend=backend,
+            num_heads=num_heads,
+            num_kv_heads=num_kv_heads,
+            head_size=head_size,
+            tokens_per_block=tokens_per_block,
+            multi_block_mode=multi_block_mode,
+            kv_dtype=kv_dtype,
+            dtype_string=dtype_string,
+            seq_len_string=seq_len_string,
+        ))
+
+full_string = "[\n" + ",\n".join(configs) + "\n]"
+
+parser = argparse.ArgumentParser()
+parser.add_argument('filename',
+                    type=str,
+                    help='The name of the file to generate',
+                    nargs='?',
+                    default="attention-benchmark-file.json")
+args = parser.parse_args()
+
+with open(args.filename, "w+") as f:
+    f.write(full_string)
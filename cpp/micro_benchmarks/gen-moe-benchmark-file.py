@@ -41,53 +41,71 @@ def make_routing_string(name=None, values=None, is_distribution=False):
     return values
 
 
+def make_trace_string(path):
+    # Configs replaying the same file share the trace, so no name is needed
+    return f'"routing_trace": "{path}",'
+
+
 def populate_benchmark_config(**kwargs):
     return template.format(**kwargs)
 
 
+parser = argparse.ArgumentParser()
+parser.add_argument('filename',
+                    type=str,
+                    help='The name of the file to generate',
+                    nargs='?',
+                    default="moe-benchmark-file.json")
+parser.add_argument(
+    '--routing_trace',
+    type=str,
+    default=None,
+    help='Replay router logits dumped with TRTLLM_MOE_ROUTING_DUMP_DIR')
+parser.add_argument('--ep_sizes',
+                    type=int,
+                    nargs='+',
+                    default=[1],
+                    help='The EP sizes to sweep, TP covers the rest of GPUs')
+args = parser.parse_args()
+
 # Default Mixtral configurations
 num_experts = 8
 k = 2
 hidden_size = 4096
 inter_size = 14336
-tp_size = 4
-ep_size = 1
+num_gpus = 4
 world_rank = 0
 act_fn = 3
 norm_mode = 1
 dtype_string = make_dtype_string()  # All dtypes
-routing_string = make_routing_string(
-    name="balanced")  # Use the default uniform distribution
+if args.routing_trace is not None:
+    routing_string = make_trace_string(args.routing_trace)
+else:
+    routing_string = make_routing_string(
+        name="balanced")  # Use the default uniform distribution
 tactic_id = '"auto"'
 
 configs = []
-for num_tokens in [1, 8, 64, 2048, 65536]:
-    configs.append(
-        populate_benchmark_config(
-            num_experts=num_experts,
-            k=k,
-            hidden_size=hidden_size,
-            inter_size=inter_size,
-            tp_size=tp_size,
-            ep_size=ep_size,
-            world_rank=world_rank,
-            num_tokens=num_tokens,
-            act_fn=act_fn,
-            norm_mode=norm_mode,
-            dtype_string=dtype_string,
-            routing_string=routing_string,
-            tactic_id=tactic_id,
-        ))
+for ep_size in args.ep_sizes:
+    for num_tokens in [1, 8, 64, 2048, 65536]:
+        configs.append(
+            populate_benchmark_config(
+                num_experts=num_experts,
+                k=k,
+                hidden_size=hidden_size,
+                inter_size=inter_size,
+                tp_size=num_gpus // ep_size,
+                ep_size=ep_size,
+                world_rank=world_rank,
+                num_tokens=num_tokens,
+                act_fn=act_fn,
+                norm_mode=norm_mode,
+                dtype_string=dtype_string,
+                routing_string=routing_string,
+                tactic_id=tactic_id,
+            ))
 
 full_string = "[\n" + ",\n".join(configs) + "\n]"
 
-parser = argparse.ArgumentParser()
-parser.add_argument('filename',
-                    type=str,
-                    help='The name of the file to generate',
-                    nargs='?',
-                    default="moe-benchmark-file.json")
-args = parser.parse_args()
-
 with open(args.filename, "w+") as f:
     f.write(full_string)
@@ -0,0 +1,640 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include <nlohmann/json.hpp>
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/batch_manager/llmRequest.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/nvtxUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/loraCache.h"
+#include "tensorrt_llm/runtime/loraModule.h"
+#include "tensorrt_llm/runtime/loraUtils.h"
+#include "tensorrt_llm/runtime/modelConfig.h"
+#include "tensorrt_llm/runtime/samplingConfig.h"
+#include "tensorrt_llm/runtime/worldConfig.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tbm = tensorrt_llm::batch_manager;
+namespace tkv = tensorrt_llm::batch_manager::kv_cache_manager;
+
+static BufferManager::CudaStreamPtr streamPtr;
+static std::unique_ptr<BufferManager> bufferManager;
+static int deviceCount;
+static char* workloadFile = nullptr;
+// Request trace in the format of gptManagerBenchmark --trace, a synthetic workload is generated if not set
+static char* traceFile = nullptr;
+
+constexpr bool VERBOSE = false;
+
+enum class ManagerOp : int
+{
+    // Scheduler loop over KVCacheManager: addSequence with reuse lookup, addToken, removeSequence storing the blocks
+    // for reuse and sampleTelemetry every iteration
+    KV_CACHE_REPLAY = 0,
+    // Host LoraCache of PeftCacheManager: put with eviction when a request is scheduled, put of the running tasks
+    // every iteration and markTaskDone when the last request of a task finishes
+    LORA_CACHE_REPLAY = 1,
+};
+
+inline std::string getOpName(ManagerOp op)
+{
+    switch (op)
+    {
+    case ManagerOp::KV_CACHE_REPLAY: return "kv_cache_replay";
+    case ManagerOp::LORA_CACHE_REPLAY: return "lora_cache_replay";
+    }
+    return "unknown";
+}
+
+// A request of the replayed workload, scheduling follows the arrival order and ignores the arrival times
+struct ReplayRequest
+{
+    std::shared_ptr<tbm::LlmRequest::VecTokens> inputIds;
+    SizeType32 outputLen;
+    // -1 without an adapter
+    std::int64_t taskId;
+};
+
+// Same token range and prefix generation as gptManagerBenchmark, so reuse hits match the trace replay there
+constexpr std::int32_t kMinSyntheticTokenId = 100;
+constexpr std::int32_t kMaxSyntheticTokenId = 999;
+
+inline std::vector<ReplayRequest> loadTrace(std::filesystem::path const& tracePath)
+{
+    TLLM_CHECK_WITH_INFO(std::filesystem::exists(tracePath), "File does not exist: %s", tracePath.c_str());
+    std::ifstream jsonStream(tracePath);
+    auto const json = nlohmann::json::parse(jsonStream, nullptr, true, true);
+
+    std::mt19937 gen(0);
+    std::uniform_int_distribution<std::int32_t> tokenDist(kMinSyntheticTokenId, kMaxSyntheticTokenId);
+    std::vector<std::pair<double, ReplayRequest>> entries;
+    for (auto const& request : json["requests"])
+    {
+        auto inputIds = std::make_shared<tbm::LlmRequest::VecTokens>();
+        if (request.count("input_ids"))
+        {
+            *inputIds = request["input_ids"].get<tbm::LlmRequest::VecTokens>();
+        }
+        else
+        {
+            auto const inputLen = request["input_len"].get<SizeType32>();
+            if (request.count("prefix_id"))
+            {
+                auto const prefixLen = std::min(request.value("prefix_len", 0), inputLen);
+                std::mt19937 prefixGen(request["prefix_id"].get<std::uint32_t>());
+                std::generate_n(std::back_inserter(*inputIds), prefixLen, [&]() { return tokenDist(prefixGen); });
+            }
+            std::generate_n(
+                std::back_inserter(*inputIds), inputLen - inputIds->size(), [&]() { return tokenDist(gen); });
+        }
+        entries.emplace_back(request["arrival_time"].get<double>(),
+            ReplayRequest{std::move(inputIds), request["output_len"].get<SizeType32>(), request.value("task_id", -1)});
+    }
+    TLLM_CHECK_WITH_INFO(!entries.empty(), "Trace %s has no requests", tracePath.c_str());
+
+    std::stable_sort(
+        entries.begin(), entries.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+    std::vector<ReplayRequest> requests;
+    requests.reserve(entries.size());
+    for (auto& entry : entries)
+    {
+        requests.emplace_back(std::move(entry.second));
+    }
+    return requests;
+}
+
+class KvCacheManagerBenchmark : public ::benchmark::Fixture
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using Clock = std::chrono::steady_clock;
+
+    // The pools only hold a few bytes per token, the copies of offload and onboard are negligible against the host
+    // work of the managers
+    constexpr static SizeType32 kNumLayers = 1;
+    constexpr static SizeType32 kNumKvHeads = 1;
+    constexpr static SizeType32 kSizePerHead = 8;
+    // Synthetic workload: kRequestsPerSequence requests per sequence slot, half of them share one of kNumPrefixes
+    // prompt prefixes
+    constexpr static SizeType32 kRequestsPerSequence = 4;
+    constexpr static SizeType32 kNumPrefixes = 16;
+    constexpr static SizeType32 kPrefixLength = 256;
+    constexpr static SizeType32 kMinInputLength = 128;
+    constexpr static SizeType32 kMaxInputLength = 1024;
+    constexpr static SizeType32 kMinOutputLength = 32;
+    constexpr static SizeType32 kMaxOutputLength = 256;
+    // Adapters of the LoRA replay: rank 8 on the QKV projection of a 2 layer model, the host cache holds a quarter
+    constexpr static SizeType32 kHiddenSize = 16;
+    constexpr static SizeType32 kLoraNumLayers = 2;
+    constexpr static SizeType32 kAdapterSize = 8;
+    constexpr static SizeType32 kCachedAdapterFraction = 4;
+    constexpr static uint64_t kSeed = 0xCA;
+
+    // Deprecated, just here to suppress warnings
+    void SetUp(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    void TearDown(benchmark::State const& s) override
+    {
+        abort();
+    }
+
+    ManagerOp mOp{};
+    SizeType32 mMaxNumSequences{};
+    SizeType32 mTokensPerBlock{};
+    bool mEnableBlockReuse{};
+    // Secondary pool size in percent of the primary pool
+    SizeType32 mSecondaryPercent{};
+    SizeType32 mNumAdapters{};
+
+    std::vector<ReplayRequest> mRequests;
+
+    // Host time spent in the managers, summed over a replay
+    struct OpTimes
+    {
+        Clock::duration addSequence{};
+        Clock::duration addToken{};
+        Clock::duration removeSequence{};
+        Clock::duration stats{};
+        Clock::duration loraPut{};
+        Clock::duration loraDone{};
+        // Of the busiest scheduler iteration
+        Clock::duration maxIteration{};
+        std::int64_t numIterations{};
+        std::int64_t numAddSequence{};
+        std::int64_t numAddToken{};
+        std::int64_t numRemoveSequence{};
+        std::int64_t numLoraPut{};
+        std::int64_t maxActive{};
+
+        [[nodiscard]] Clock::duration total() const
+        {
+            return addSequence + addToken + removeSequence + stats + loraPut + loraDone;
+        }
+    };
+
+    // Counters of the KV cache stats, accumulated over the iterations of a replay
+    struct CacheCounters
+    {
+        std::int64_t reuseLookups{};
+        std::int64_t reuseHits{};
+        std::int64_t releasedBlocks{};
+        std::int64_t unusedTokenSlots{};
+        // Puts of a task that is not in the LoRA cache, the first put of a task included
+        std::int64_t loraMisses{};
+    };
+
+    CacheCounters mCounters;
+
+    std::optional<std::string> checkSupported() const
+    {
+        if (mMaxNumSequences <= 0 || mTokensPerBlock <= 0)
+            return "Invalid number of sequences or tokens per block";
+        if (mOp == ManagerOp::LORA_CACHE_REPLAY && mNumAdapters <= 0 && !traceFile)
+            return "The LoRA cache replay needs adapters";
+        return std::nullopt;
+    }
+
+    void initRequests()
+    {
+        if (traceFile)
+        {
+            // The trace is parsed once for all the configurations
+            static std::vector<ReplayRequest> const trace = loadTrace(traceFile);
+            mRequests = trace;
+            if (mNumAdapters > 0)
+            {
+                // Fold the adapters of the trace so the number of distinct tasks follows the configuration
+                for (auto& request : mRequests)
+                    if (request.taskId >= 0)
+                        request.taskId %= mNumAdapters;
+            }
+            return;
+        }
+
+        std::mt19937_64 gen(kSeed);
+        std::uniform_int_distribution<std::int32_t> tokenDist(kMinSyntheticTokenId, kMaxSyntheticTokenId);
+        std::uniform_int_distribution<SizeType32> inputDist(kMinInputLength, kMaxInputLength);
+        std::uniform_int_distribution<SizeType32> outputDist(kMinOutputLength, kMaxOutputLength);
+        std::uniform_int_distribution<SizeType32> prefixDist(0, 2 * kNumPrefixes - 1);
+        std::uniform_int_distribution<std::int64_t> taskDist(0, std::max(mNumAdapters - 1, 0));
+
+        mRequests.clear();
+        mRequests.reserve(static_cast<std::size_t>(mMaxNumSequences) * kRequestsPerSequence);
+        for (SizeType32 r = 0; r < mMaxNumSequences * kRequestsPerSequence; ++r)
+        {
+            auto const inputLen = inputDist(gen);
+            auto inputIds = std::make_shared<tbm::LlmRequest::VecTokens>();
+            inputIds->reserve(inputLen);
+            if (auto const prefixId = prefixDist(gen); prefixId < kNumPrefixes)
+            {
+                std::mt19937 prefixGen(prefixId);
+                std::generate_n(std::back_inserter(*inputIds), std::min(kPrefixLength, inputLen),
+                    [&]() { return tokenDist(prefixGen); });
+            }
+            std::generate_n(
+                std::back_inserter(*inputIds), inputLen - inputIds->size(), [&]() { return tokenDist(gen); });
+            auto const taskId = mNumAdapters > 0 ? taskDist(gen) : -1;
+            mRequests.push_back(ReplayRequest{std::move(inputIds), outputDist(gen), taskId});
+        }
+    }
+
+    [[nodiscard]] SizeType32 maxSequenceLength() const
+    {
+        SizeType32 maxLength = 0;
+        for (auto const& request : mRequests)
+            maxLength = std::max(maxLength, static_cast<SizeType32>(request.inputIds->size()) + request.outputLen);
+        return maxLength;
+    }
+
+    [[nodiscard]] SizeType32 numBlocks(SizeType32 numTokens) const
+    {
+        return ceilDiv(numTokens, mTokensPerBlock);
+    }
+
+    // The primary pool holds mMaxNumSequences sequences of the mean length, so long traces also exercise eviction
+    [[nodiscard]] SizeType32 primaryPoolBlocks() const
+    {
+        std::int64_t totalBlocks = 0;
+        for (auto const& request : mRequests)
+            totalBlocks += numBlocks(static_cast<SizeType32>(request.inputIds->size()) + request.outputLen);
+        auto const meanBlocks = ceilDiv(totalBlocks, static_cast<std::int64_t>(mRequests.size()));
+        return static_cast<SizeType32>(std::max<std::int64_t>(
+            meanBlocks * mMaxNumSequences, numBlocks(maxSequenceLength())));
+    }
+
+    struct ActiveSequence
+    {
+        std::shared_ptr<tbm::LlmRequest> llmRequest;
+        SizeType32 slot;
+        SizeType32 remainingTokens;
+        SizeType32 reservedBlocks;
+    };
+
+    OpTimes replayKvCache()
+    {
+        auto const maxSeqLength = maxSequenceLength();
+        auto const primaryBlocks = primaryPoolBlocks();
+        auto const secondaryBlocks
+            = static_cast<SizeType32>(static_cast<std::int64_t>(primaryBlocks) * mSecondaryPercent / 100);
+        tkv::KVCacheManager manager(kNumLayers, kNumKvHeads, kSizePerHead, mTokensPerBlock, primaryBlocks,
+            secondaryBlocks, mMaxNumSequences, 1, maxSeqLength, 0, false, streamPtr, mEnableBlockReuse);
+        manager.allocatePools(nvinfer1::DataType::kHALF);
+
+        SamplingConfig const samplingConfig{1};
+        std::vector<SizeType32> freeSlots(mMaxNumSequences);
+        std::iota(freeSlots.rbegin(), freeSlots.rend(), 0);
+        std::vector<ActiveSequence> active;
+        active.reserve(mMaxNumSequences);
+        std::size_t nextRequest = 0;
+        OpTimes times;
+        tkv::KvCacheTelemetry telemetry{mTokensPerBlock};
+        // Index of the blocks stored for reuse, to look up the cached prefix of a request before it is added
+        tkv::KvCacheReuseIndex reuseIndex{mTokensPerBlock};
+        // Blocks held by the active sequences at their full length, admission never has to preempt
+        std::int64_t reservedBlocks = 0;
+
+        while (nextRequest < mRequests.size() || !active.empty())
+        {
+            auto const iterationStart = times.total();
+
+            // Generation phase of the running sequences
+            for (auto it = active.begin(); it != active.end();)
+            {
+                auto const start = Clock::now();
+                manager.addToken(it->slot);
+                times.addToken += Clock::now() - start;
+                ++times.numAddToken;
+                it->llmRequest->addNewToken(kMinSyntheticTokenId, 0);
+                if (--it->remainingTokens > 0)
+                {
+                    ++it;
+                    continue;
+                }
+                auto const removeStart = Clock::now();
+                if (mEnableBlockReuse)
+                {
+                    manager.storeForReuse(reuseIndex, it->slot, *it->llmRequest);
+                }
+                manager.removeSequence(it->slot, it->llmRequest);
+                times.removeSequence += Clock::now() - removeStart;
+                ++times.numRemoveSequence;
+                reservedBlocks -= it->reservedBlocks;
+                freeSlots.push_back(it->slot);
+                *it = std::move(active.back());
+                active.pop_back();
+            }
+
+            // Context phase of the newly scheduled requests, the first token comes out of the context phase
+            while (nextRequest < mRequests.size() && !freeSlots.empty())
+            {
+                auto const& request = mRequests[nextRequest];
+                auto const promptLen = static_cast<SizeType32>(request.inputIds->size());
+                auto const neededBlocks = numBlocks(promptLen + request.outputLen);
+                if (reservedBlocks + neededBlocks > primaryBlocks)
+                    break;
+                auto llmRequest = std::make_shared<tbm::LlmRequest>(
+                    static_cast<tbm::LlmRequest::RequestIdType>(nextRequest), request.outputLen, request.inputIds,
+                    samplingConfig, false);
+                auto const slot = freeSlots.back();
+                freeSlots.pop_back();
+                auto const start = Clock::now();
+                if (mEnableBlockReuse)
+                {
+                    // The last prompt token is always computed by the context phase
+                    (void) reuseIndex.match(*request.inputIds, llmRequest->getKvCacheReuseSeed(), promptLen - 1);
+                }
+                manager.addSequence(slot, promptLen, 1, llmRequest);
+                times.addSequence += Clock::now() - start;
+                ++times.numAddSequence;
+                llmRequest->addNewToken(kMinSyntheticTokenId, 0);
+                reservedBlocks += neededBlocks;
+                ++nextRequest;
+                if (request.outputLen > 1)
+                {
+                    active.push_back(ActiveSequence{std::move(llmRequest), slot, request.outputLen - 1, neededBlocks});
+                }
+                else
+                {
+                    if (mEnableBlockReuse)
+                    {
+                        manager.storeForReuse(reuseIndex, slot, *llmRequest);
+                    }
+                    manager.removeSequence(slot, llmRequest);
+                    reservedBlocks -= neededBlocks;
+                    freeSlots.push_back(slot);
+                }
+            }
+            TLLM_CHECK_WITH_INFO(!active.empty() || nextRequest == mRequests.size(),
+                "Request %lu does not fit in the KV cache", nextRequest);
+
+            auto const statsStart = Clock::now();
+            manager.syncReuseIndex(reuseIndex);
+            manager.sampleTelemetry(telemetry);
+            auto const stats = telemetry.takeStats();
+            times.stats += Clock::now() - statsStart;
+            mCounters.releasedBlocks += std::accumulate(
+                stats.blockLifetimeHistogram.begin(), stats.blockLifetimeHistogram.end(), std::int64_t{0});
+            mCounters.unusedTokenSlots += stats.numUnusedTokenSlots;
+
+            ++times.numIterations;
+            times.maxIteration = std::max(times.maxIteration, times.total() - iterationStart);
+            times.maxActive = std::max(times.maxActive, static_cast<std::int64_t>(active.size()));
+        }
+
+        auto const& reuseStats = reuseIndex.getStats();
+        mCounters.reuseLookups += reuseStats.numLookups;
+        mCounters.reuseHits += reuseStats.numHits;
+        return times;
+    }
+
+    // Adapter weights and config of a task, rank kAdapterSize on the QKV projection of every layer
+    std::pair<TensorPtr, TensorPtr> makeAdapter(LoraModule const& module, std::int64_t taskId) const
+    {
+        auto const rowSize = module.flattenedInOutSize(kAdapterSize);
+        auto weights = BufferManager::cpu(ITensor::makeShape({kLoraNumLayers, rowSize}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*weights), kLoraNumLayers * rowSize, static_cast<float>(taskId));
+        auto config = BufferManager::cpu(
+            ITensor::makeShape({kLoraNumLayers, lora::kLORA_CONFIG_ROW_SIZE}), nvinfer1::DataType::kINT32);
+        auto* configPtr = bufferCast<std::int32_t>(*config);
+        for (SizeType32 layer = 0; layer < kLoraNumLayers; ++layer)
+        {
+            configPtr[layer * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_MODULE_OFF] = module.value();
+            configPtr[layer * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_LAYER_OFF] = layer;
+            configPtr[layer * lora::kLORA_CONFIG_ROW_SIZE + lora::kLORA_CONFIG_ADAPTER_SIZE_OFF] = kAdapterSize;
+        }
+        return {weights, config};
+    }
+
+    OpTimes replayLoraCache()
+    {
+        ModelConfig modelConfig(0, kLoraNumLayers, 0, 1, kHiddenSize, nvinfer1::DataType::kFLOAT);
+        modelConfig.setMlpHiddenSize(2 * kHiddenSize);
+        LoraModule const module(LoraModule::ModuleType::kATTN_QKV, kHiddenSize, 3 * kHiddenSize, false, true, -1, 0);
+        modelConfig.setLoraModules({module});
+        WorldConfig const worldConfig{};
+
+        // Adapters are built before replaying, the copy into the pages is part of put as in PeftCacheManager
+        std::unordered_map<std::int64_t, std::pair<TensorPtr, TensorPtr>> adapters;
+        for (auto const& request : mRequests)
+            if (request.taskId >= 0 && !adapters.count(request.taskId))
+                adapters.emplace(request.taskId, makeAdapter(module, request.taskId));
+        TLLM_CHECK_WITH_INFO(!adapters.empty(), "The workload has no requests with an adapter");
+
+        // One slot per row and one page per adapter, the cache holds 1 / kCachedAdapterFraction of the adapters
+        auto const pageWidth = module.flattenedInOutSize(kAdapterSize);
+        auto const numPages = std::max(1, static_cast<SizeType32>(adapters.size()) / kCachedAdapterFraction);
+        LoraCachePageManagerConfig pageConfig(
+            MemoryType::kCPU, nvinfer1::DataType::kFLOAT, numPages, 64, kLoraNumLayers, pageWidth, 1);
+        LoraCache cache(pageConfig, modelConfig, worldConfig, *bufferManager);
+
+        std::vector<std::pair<std::int64_t, SizeType32>> active;
+        active.reserve(mMaxNumSequences);
+        std::unordered_map<std::int64_t, SizeType32> runningPerTask;
+        std::size_t nextRequest = 0;
+        OpTimes times;
+
+        auto const put = [&](std::int64_t taskId)
+        {
+            auto const& [weights, config] = adapters.at(taskId);
+            if (!cache.has(taskId))
+                ++mCounters.loraMisses;
+            auto const start = Clock::now();
+            cache.put(taskId, weights, config);
+            times.loraPut += Clock::now() - start;
+            ++times.numLoraPut;
+        };
+
+        while (nextRequest < mRequests.size() || !active.empty())
+        {
+            auto const iterationStart = times.total();
+
+            for (auto it = active.begin(); it != active.end();)
+            {
+                if (--it->second > 0)
+                {
+                    ++it;
+                    continue;
+                }
+                if (auto const taskId = it->first; taskId >= 0 && --runningPerTask[taskId] == 0)
+                {
+                    auto const start = Clock::now();
+                    cache.markTaskDone(taskId);
+                    times.loraDone += Clock::now() - start;
+                    runningPerTask.erase(taskId);
+                }
+                ++times.numRemoveSequence;
+                *it = active.back();
+                active.pop_back();
+            }
+
+            // The tasks of the running requests are put every iteration, as ensureBatch does for the scheduled batch
+            for (auto const& task : runningPerTask)
+                put(task.first);
+
+            // A new task only fits if an adapter that is done can be evicted
+            while (nextRequest < mRequests.size() && active.size() < static_cast<std::size_t>(mMaxNumSequences))
+            {
+                auto const& request = mRequests[nextRequest];
+                if (request.taskId >= 0 && !runningPerTask.count(request.taskId)
+                    && static_cast<SizeType32>(runningPerTask.size()) >= numPages)
+                    break;
+                if (request.taskId >= 0 && runningPerTask[request.taskId]++ == 0)
+                    put(request.taskId);
+                ++times.numAddSequence;
+                active.emplace_back(request.taskId, request.outputLen);
+                ++nextRequest;
+            }
+
+            ++times.numIterations;
+            times.maxIteration = std::max(times.maxIteration, times.total() - iterationStart);
+            times.maxActive = std::max(times.maxActive, static_cast<std::int64_t>(active.size()));
+        }
+        return times;
+    }
+
+    OpTimes replay()
+    {
+        return mOp == ManagerOp::KV_CACHE_REPLAY ? replayKvCache() : replayLoraCache();
+    }
+
+    void runBenchmarkImpl(benchmark::State& state);
+
+    void runBenchmark(benchmark::State& state);
+};
+
+void KvCacheManagerBenchmark::runBenchmarkImpl(benchmark::State& state)
+{
+    // Warm-Up run
+    replay();
+
+    OpTimes sum;
+    mCounters = CacheCounters{};
+    {
+        NVTX3_SCOPED_RANGE(BenchmarkRun);
+        for (auto _ : state)
+        {
+            auto const times = replay();
+            state.SetIterationTime(std::chrono::duration<double>(times.total()).count());
+            sum.addSequence += times.addSequence;
+            sum.addToken += times.addToken;
+            sum.removeSequence += times.removeSequence;
+            sum.stats += times.stats;
+            sum.loraPut += times.loraPut;
+            sum.loraDone += times.loraDone;
+            sum.maxIteration = std::max(sum.maxIteration, times.maxIteration);
+            sum.numIterations += times.numIterations;
+            sum.numAddSequence += times.numAddSequence;
+            sum.numAddToken += times.numAddToken;
+            sum.numRemoveSequence += times.numRemoveSequence;
+            sum.numLoraPut += times.numLoraPut;
+            sum.maxActive = std::max(sum.maxActive, times.maxActive);
+        }
+    }
+
+    auto const nsPerCall = [](Clock::duration duration, std::int64_t calls)
+    { return calls > 0 ? std::chrono::duration<double, std::nano>(duration).count() / calls : 0.0; };
+    auto const runs = static_cast<double>(state.iterations());
+
+    // The number that limits the batch size: host time of the managers per scheduler iteration
+    state.counters["iteration_overhead_us"]
+        = std::chrono::duration<double, std::micro>(sum.total()).count() / std::max<std::int64_t>(sum.numIterations, 1);
+    state.counters["max_iteration_overhead_us"] = std::chrono::duration<double, std::micro>(sum.maxIteration).count();
+    state.counters["scheduler_iterations"] = sum.numIterations / runs;
+    state.counters["max_active_sequences"] = sum.maxActive;
+    if (mOp == ManagerOp::KV_CACHE_REPLAY)
+    {
+        state.counters["add_sequence_ns"] = nsPerCall(sum.addSequence, sum.numAddSequence);
+        state.counters["add_token_ns"] = nsPerCall(sum.addToken, sum.numAddToken);
+        state.counters["remove_sequence_ns"] = nsPerCall(sum.removeSequence, sum.numRemoveSequence);
+        state.counters["stats_ns"] = nsPerCall(sum.stats, sum.numIterations);
+        state.counters["reuse_hit_rate"]
+            = mCounters.reuseLookups > 0 ? static_cast<double>(mCounters.reuseHits) / mCounters.reuseLookups : 0.0;
+        state.counters["released_blocks"] = mCounters.releasedBlocks / runs;
+        state.counters["mean_unused_token_slots"]
+            = static_cast<double>(mCounters.unusedTokenSlots) / std::max<std::int64_t>(sum.numIterations, 1);
+        state.SetItemsProcessed(sum.numAddToken);
+    }
+    else
+    {
+        state.counters["lora_put_ns"] = nsPerCall(sum.loraPut, sum.numLoraPut);
+        state.counters["lora_misses"] = mCounters.loraMisses / runs;
+        state.SetItemsProcessed(sum.numLoraPut);
+    }
+}
+
+void KvCacheManagerBenchmark::runBenchmark(benchmark::State& state)
+{
+    NVTX3_SCOPED_RANGE(FullBenchmark);
+    mOp = static_cast<ManagerOp>(state.range(0));
+    mMaxNumSequences = state.range(1);
+    mTokensPerBlock = state.range(2);
+    mEnableBlockReuse = state.range(3) != 0;
+    mSecondaryPercent = state.range(4);
+    mNumAdapters = state.range(5);
+
+    state.counters["max_sequences"] = mMaxNumSequences;
+    state.counters["tokens_per_block"] = mTokensPerBlock;
+    state.counters["block_reuse"] = mEnableBlockReuse;
+    state.counters["secondary_percent"] = mSecondaryPercent;
+    state.counters["num_adapters"] = mNumAdapters;
+
+    state.SetLabel(getOpName(mOp));
+
+    if (auto const reason = checkSupported())
+    {
+        state.SkipWithMessage(reason->c_str());
+        return;
+    }
+
+    try
+    {
+        initRequests();
+        runBenchmarkImpl(state);
+    }
+    catch (std::exception const& e)
+    {
+        if (VERBOSE)
+            std::cout << "Benchmark failed with exception: " << e.what() << std::endl;
+        state.SkipWithError(e.what());
+    }
+    mRequests.clear();
+}
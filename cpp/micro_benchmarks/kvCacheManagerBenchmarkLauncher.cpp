@@ -0,0 +1,310 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Include the fixture with the actual benchmark code
+#include "kvCacheManagerBenchmarkFixture.h"
+
+#include <cstring>
+#include <sstream>
+
+/*
+ * Below is all the setup for parameterising the benchmarks
+ */
+
+BENCHMARK_DEFINE_F(KvCacheManagerBenchmark, Basic)(benchmark::State& state)
+{
+    runBenchmark(state);
+}
+
+ManagerOp parseOp(std::string const& name)
+{
+    static std::unordered_map<std::string, ManagerOp> const op_map{
+        {"kv_cache_replay", ManagerOp::KV_CACHE_REPLAY},
+        {"lora_cache_replay", ManagerOp::LORA_CACHE_REPLAY},
+    };
+    auto it = op_map.find(name);
+    if (it == op_map.end())
+    {
+        throw std::invalid_argument("Invalid op " + name);
+    }
+    return it->second;
+}
+
+// A field can be a single value or an array of values to sweep
+template <class ValueType, class Parser>
+std::vector<int64_t> parseSweep(nlohmann::json const& run_config, char const* name, ValueType def, Parser parser)
+{
+    std::vector<int64_t> values;
+    if (!run_config.contains(name))
+    {
+        values.push_back(static_cast<int64_t>(parser(def)));
+    }
+    else if (run_config[name].is_array())
+    {
+        for (auto const& v : run_config[name])
+            values.push_back(static_cast<int64_t>(parser(v.template get<ValueType>())));
+    }
+    else
+    {
+        values.push_back(static_cast<int64_t>(parser(run_config[name].template get<ValueType>())));
+    }
+    return values;
+}
+
+std::vector<std::vector<int64_t>> const& loadWorkloadFile()
+{
+    static std::optional<std::vector<std::vector<int64_t>>> workloads;
+    if (workloads)
+        return *workloads;
+
+    /*
+     * See help text for schema description
+     */
+    std::ifstream file{workloadFile};
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    auto file_contents = buffer.str();
+    if (VERBOSE)
+        std::cout << "Loaded benchmark file: " << file_contents << std::endl;
+    auto source_data = nlohmann::json::parse(file_contents);
+
+    workloads.emplace();
+    for (auto run_config : source_data)
+    {
+        if (VERBOSE)
+            std::cout << "Parsing run config: " << run_config.dump(2) << std::endl;
+
+        auto const identity = [](auto v) { return v; };
+        auto const ops = parseSweep<std::string>(run_config, "op", "kv_cache_replay", parseOp);
+        auto const max_sequences = parseSweep<int>(run_config, "max_sequences", 1024, identity);
+        auto const tokens_per_block = parseSweep<int>(run_config, "tokens_per_block", 64, identity);
+        auto const block_reuse = parseSweep<bool>(run_config, "block_reuse", true, identity);
+        auto const secondary_percent = parseSweep<int>(run_config, "secondary_percent", 0, identity);
+        auto const num_adapters = parseSweep<int>(run_config, "num_adapters", 0, identity);
+
+        for (auto op : ops)
+            for (auto sequences : max_sequences)
+                for (auto block_size : tokens_per_block)
+                    for (auto reuse : block_reuse)
+                        for (auto secondary : secondary_percent)
+                            for (auto adapters : num_adapters)
+                            {
+                                workloads->push_back({op, sequences, block_size, reuse, secondary, adapters});
+                            }
+    }
+    return *workloads;
+}
+
+void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
+{
+    for (auto const& workload : loadWorkloadFile())
+    {
+        benchmark->Args(workload);
+    }
+}
+
+void argGenHardcoded(benchmark::internal::Benchmark* benchmark)
+{
+    auto max_sequences = {256, 1024, 4096, 16384};
+    auto tokens_per_block = {32, 64};
+    auto block_reuse = {0, 1};
+    auto secondary_percent = {0, 50};
+    auto num_adapters = {16, 1024};
+
+    for (auto sequences : max_sequences)
+        for (auto block_size : tokens_per_block)
+            for (auto reuse : block_reuse)
+                for (auto secondary : secondary_percent)
+                {
+                    // Blocks are only offloaded for reuse
+                    if (!reuse && secondary != 0)
+                        continue;
+                    benchmark->Args({(int) ManagerOp::KV_CACHE_REPLAY, sequences, block_size, reuse, secondary, 0});
+                }
+
+    for (auto sequences : max_sequences)
+        for (auto adapters : num_adapters)
+        {
+            benchmark->Args({(int) ManagerOp::LORA_CACHE_REPLAY, sequences, *tokens_per_block.begin(), 0, 0, adapters});
+        }
+}
+
+void argGen(benchmark::internal::Benchmark* benchmark)
+{
+    // Generic setup
+    benchmark->UseManualTime();
+    benchmark->Unit(benchmark::kMillisecond);
+    benchmark->ArgNames(
+        {"Op", "Max Sequences", "Tokens Per Block", "Block Reuse", "Secondary Percent", "Num Adapters"});
+
+    if (workloadFile)
+        argGenLoadFile(benchmark);
+    else
+        argGenHardcoded(benchmark);
+}
+
+void delayedRegisterBenchmark()
+{
+    BENCHMARK_REGISTER_F(KvCacheManagerBenchmark, Basic)->Apply(argGen);
+}
+
+void doCleanup()
+{
+    bufferManager.reset();
+    streamPtr.reset();
+}
+
+void help()
+{
+    std::cout << "Usage: kvCacheManagerBenchmark [--input_file <file>] [--trace <file>] [benchmark options]\n";
+    std::cout
+        << "--input_file\t\tA JSON file describing the benchmark configurations\n"
+        << "--trace\t\t\tA request trace in the format of gptManagerBenchmark --trace to replay. Defaults to a "
+           "synthetic workload\n\n"
+        << "File schema\n"
+           "[\n"
+           "  {\n"
+           "    \"op\": string or [string, ...], (optional)\n"
+           "    \"max_sequences\": int or [int, ...], (optional)\n"
+           "    \"tokens_per_block\": int or [int, ...], (optional)\n"
+           "    \"block_reuse\": bool or [bool, ...], (optional)\n"
+           "    \"secondary_percent\": int or [int, ...], (optional)\n"
+           "    \"num_adapters\": int or [int, ...], (optional)\n"
+           "  },\n"
+           "  ...\n"
+           "]\n"
+           "Explanation:\n"
+           "- \"op\" - The manager to replay the workload through. Defaults to \"kv_cache_replay\". Allowed values "
+           "are:\n"
+           "  \"kv_cache_replay\" - KVCacheManager: addSequence with the reuse lookup when a request is scheduled, "
+           "addToken for every running sequence, removeSequence storing the blocks for reuse when it finishes and "
+           "sampleTelemetry every iteration\n"
+           "  \"lora_cache_replay\" - The host LoraCache of PeftCacheManager: put with eviction when a request with "
+           "a new task is scheduled, put of the running tasks every iteration and markTaskDone when the last "
+           "request of a task finishes\n"
+           "- \"max_sequences\" - The number of sequence slots, the number of requests running concurrently. "
+           "Defaults to 1024\n"
+           "- \"tokens_per_block\" - The tokens per KV cache block. Defaults to 64\n"
+           "- \"block_reuse\" - Enables KV cache block reuse. Defaults to true\n"
+           "- \"secondary_percent\" - The size of the secondary (host) pool in percent of the primary pool, blocks "
+           "evicted for reuse are offloaded to it. Defaults to 0\n"
+           "- \"num_adapters\" - The number of distinct LoRA tasks, the task ids of the trace are folded into this "
+           "range. 0 keeps the task ids of the trace. Defaults to 0\n"
+           "\n"
+           "Without a trace the workload has 4 requests per sequence slot with 128 to 1024 prompt tokens, half of "
+           "them starting with one of 16 shared 256 token prefixes, and 32 to 256 output tokens.\n"
+           "The requests are scheduled in arrival order as soon as a slot and the blocks of their full length are "
+           "free, each iteration generates one token for every running request.\n"
+           "The time of a run is the host time spent in the managers. Each benchmark reports it per scheduler "
+           "iteration (iteration_overhead_us) next to the time per call of every operation, the reuse hit rate "
+           "and the offloaded and onboarded bytes\n"
+           "The KV cache pools use a single layer and head of 8 elements, so the copies of offload and onboard "
+           "are negligible next to the host work\n"
+           "\n";
+
+    std::cout << "benchmark options:\n";
+    benchmark::PrintDefaultHelp();
+}
+
+void gbenchCustomHelp()
+{
+    help();
+    // google-benchmark calls exit() so we need to cleanup manually
+    doCleanup();
+}
+
+int parseArgsAndRunBench(int argc, char** argv)
+{
+    try
+    {
+        int shift = 0;
+        for (int i = 1; i < argc; i++)
+        {
+            argv[i - shift] = argv[i];
+            if (strcmp("--input_file", argv[i]) == 0 || strcmp("--trace", argv[i]) == 0)
+            {
+                auto& file = strcmp("--trace", argv[i]) == 0 ? traceFile : workloadFile;
+                i += 1;
+                if (i == argc)
+                {
+                    std::cerr << "Missing file name for " << argv[i - 1] << "\n";
+                    return -1;
+                }
+                file = argv[i];
+                if (file[0] == '-')
+                {
+                    std::cerr << "File " << file << " not a valid file name\n";
+                    return -2;
+                }
+                shift += 2;
+            }
+            else if (strcmp("--help", argv[i]) == 0 || strcmp("-h", argv[i]) == 0)
+            {
+                help();
+                return 0;
+            }
+        }
+        argc -= shift;
+
+        // Delay after we know if the user passed a config file
+        delayedRegisterBenchmark();
+
+        benchmark::Initialize(&argc, argv, &gbenchCustomHelp);
+
+        if (argc > 1)
+        {
+            help();
+            std::cout << std::flush; // Force flush
+            // Print the error second, so it's easy to see
+            std::cerr << "\nUnrecognised argument: " << argv[1] << std::endl;
+            return -4;
+        }
+
+        benchmark::RunSpecifiedBenchmarks();
+        benchmark::Shutdown();
+
+        return 0;
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Exiting benchmarks with exception: " << e.what() << std::endl;
+        return -3;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    // The KV cache pools are allocated on the device even though only the host work is timed
+    deviceCount = getDeviceCount();
+    if (deviceCount < 0)
+        return 0;
+    streamPtr = std::make_shared<CudaStream>();
+    bufferManager = std::make_unique<BufferManager>(streamPtr);
+
+    int res = -1;
+    try
+    {
+        res = parseArgsAndRunBench(argc, argv);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Benchmark exited with unhandled exception: " << e.what() << std::endl;
+    }
+
+    doCleanup();
+    return res;
+}
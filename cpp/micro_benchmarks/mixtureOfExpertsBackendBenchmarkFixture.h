@@ -30,6 +30,7 @@
 
 #include <algorithm>
 #include <cuda.h>
+#include <fstream>
 #include <memory>
 #include <numeric>
 #include <random>
@@ -246,6 +247,64 @@ struct VectoredRoutingConfig : public RoutingConfig
     }
 };
 
+/**
+ * Replays router logits recorded from a real model, see TRTLLM_MOE_ROUTING_DUMP_DIR. The trace is a raw float32 file
+ * of `num_experts` values per token. Each call consumes the next `num_tokens` rows, wrapping around at the end
+ */
+struct TraceRoutingConfig : public RoutingConfig
+{
+    std::vector<float> trace;
+    std::pair<int64_t, int64_t> shape;
+    std::string path;
+    std::string name;
+    int64_t cursor = 0;
+
+    TraceRoutingConfig(std::string path, int64_t num_experts, std::string name = "trace")
+        : path(std::move(path))
+        , name(std::move(name))
+    {
+        std::ifstream file(this->path, std::ios::binary | std::ios::ate);
+        TLLM_CHECK_WITH_INFO(file.good(), "Cannot open routing trace %s", this->path.c_str());
+        int64_t const num_values = file.tellg() / static_cast<int64_t>(sizeof(float));
+        TLLM_CHECK_WITH_INFO(num_values > 0 && num_values % num_experts == 0,
+            "Routing trace %s does not contain a whole number of rows of %ld experts", this->path.c_str(),
+            num_experts);
+        trace.resize(num_values);
+        file.seekg(0);
+        file.read(reinterpret_cast<char*>(trace.data()), num_values * sizeof(float));
+        shape = {num_values / num_experts, num_experts};
+    }
+
+    std::string getName() override
+    {
+        return name;
+    }
+
+    bool isDeterministic() const override
+    {
+        return false;
+    }
+
+    void setRouting(float* routing_output, int64_t num_experts, int64_t k, int64_t num_tokens) override
+    {
+        TLLM_CHECK(shape.second == num_experts);
+        for (int64_t i = 0; i < num_tokens;)
+        {
+            int64_t num_to_copy = std::min(num_tokens - i, shape.first - cursor);
+            check_cuda_error(cudaMemcpyAsync(routing_output + i * num_experts, trace.data() + cursor * num_experts,
+                num_to_copy * num_experts * sizeof(float), cudaMemcpyHostToDevice, streamPtr->get()));
+            i += num_to_copy;
+            cursor = (cursor + num_to_copy) % shape.first;
+        }
+        check_cuda_error(cudaStreamSynchronize(streamPtr->get()));
+    }
+
+    bool supportsConfig(int64_t num_experts, int64_t, int64_t) const override
+    {
+        return shape.second == num_experts;
+    }
+};
+
 }; // namespace
 
 constexpr int LOAD_BALANCED_ROUTING_CONFIG = 0;
@@ -287,6 +287,22 @@ std::optional<int> loadRoutingValues(nlohmann::json entry, int64_t num_experts,
     return routing_config;
 }
 
+int loadRoutingTrace(nlohmann::json entry, int64_t num_experts, std::string config_name)
+{
+    auto path = entry.get<std::string>();
+    // Share the trace between configs that replay the same file
+    for (size_t i = 0; i < routingConfigCache.size(); i++)
+    {
+        auto conf = std::dynamic_pointer_cast<TraceRoutingConfig>(routingConfigCache[i]);
+        if (conf && conf->path == path && conf->supportsConfig(num_experts, {}, {}))
+        {
+            return i;
+        }
+    }
+    routingConfigCache.push_back(std::make_shared<TraceRoutingConfig>(std::move(path), num_experts, config_name));
+    return routingConfigCache.size() - 1;
+}
+
 // This is suboptimal for large benchmark files as we reread it for every data type
 template <class BenchClass>
 void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
@@ -315,7 +331,8 @@ void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
         if (run_config.contains("routing_values_name"))
         {
             run_config["routing_values_name"].get_to(config_name);
-            if (!run_config.contains("routing_values") && !run_config.contains("routing_distribution"))
+            if (!run_config.contains("routing_values") && !run_config.contains("routing_distribution")
+                && !run_config.contains("routing_trace"))
             {
                 throw std::invalid_argument("Setting routing value configuration name but missing routing values");
             }
@@ -350,6 +367,10 @@ void argGenLoadFile(benchmark::internal::Benchmark* benchmark)
                 routing_config = loadRoutingValues<RandomDistributionRoutingConfig>(
                     run_config["routing_distribution"], num_experts, config_name);
             }
+            else if (run_config.contains("routing_trace"))
+            {
+                routing_config = loadRoutingTrace(run_config["routing_trace"], num_experts, config_name);
+            }
         }
         // Use the selected config or fall back to balanced
         routing_config = routing_config.value_or(LOAD_BALANCED_ROUTING_CONFIG);
@@ -559,6 +580,7 @@ void help()
            "    \"routing_values_name\": string, (optional)\n"
            "    \"routing_values\": [float, ...], or string, (optional, length is a multiple of num_experts)\n"
            "    \"routing_distribution\": [float, ...], or string, (optional, length is num_experts)\n"
+           "    \"routing_trace\": string, (optional)\n"
            "  },\n"
            "  ...\n"
            "]\n"
@@ -611,6 +633,9 @@ void help()
            "- \"routing_distribution\" - instead of explicitly setting routing_values, define a random distribution "
            "that experts will be randomly sampled from."
            "There is also pre-defined config \"uniform\", which is short-hand for a random uniform distribution\n"
+           "- \"routing_trace\" - instead of routing_values, the path to router logits recorded from a real model by "
+           "setting\n"
+           "TRTLLM_MOE_ROUTING_DUMP_DIR. Each benchmark iteration replays the next `num_tokens` tokens of the trace\n"
            "\n";
 
     std::cout << "benchmark options:\n";
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::common
+{
+
+//! \brief Timeline in the Chrome trace event format, which chrome://tracing and Perfetto open.
+class ChromeTrace
+{
+public:
+    using Args = std::vector<std::pair<std::string, std::int64_t>>;
+
+    //! \brief Complete event ("X") of duration `durationUs` starting at `startUs`, on thread `tid` of process `pid`.
+    void addEvent(std::string name, std::string category, std::int64_t pid, std::int64_t tid, double startUs,
+        double durationUs, Args args = {})
+    {
+        mEvents.push_back(
+            Event{std::move(name), std::move(category), pid, tid, startUs, durationUs, std::move(args)});
+    }
+
+    //! \brief Counter event ("C"): the values of the series of counter `name` of process `pid` from `timeUs` on.
+    void addCounter(std::string name, std::int64_t pid, double timeUs, Args values)
+    {
+        mCounters.push_back(Counter{std::move(name), pid, timeUs, std::move(values)});
+    }
+
+    //! \brief Name of a thread, shown instead of its id.
+    void setThreadName(std::int64_t pid, std::int64_t tid, std::string name)
+    {
+        mThreadNames.push_back(ThreadName{pid, tid, std::move(name)});
+    }
+
+    [[nodiscard]] std::size_t getNumEvents() const
+    {
+        return mEvents.size() + mCounters.size();
+    }
+
+    void clear()
+    {
+        mEvents.clear();
+        mCounters.clear();
+        mThreadNames.clear();
+    }
+
+    [[nodiscard]] std::string toJson() const
+    {
+        std::ostringstream os;
+        os.precision(3);
+        os << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool first = true;
+        auto const separator = [&os, &first]()
+        {
+            os << (first ? "\n" : ",\n");
+            first = false;
+        };
+        for (auto const& thread : mThreadNames)
+        {
+            separator();
+            os << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << thread.pid << ",\"tid\":" << thread.tid
+               << ",\"args\":{\"name\":\"" << escape(thread.name) << "\"}}";
+        }
+        for (auto const& event : mEvents)
+        {
+            separator();
+            os << "{\"name\":\"" << escape(event.name) << "\",\"cat\":\"" << escape(event.category)
+               << "\",\"ph\":\"X\",\"pid\":" << event.pid << ",\"tid\":" << event.tid << ",\"ts\":" << event.startUs
+               << ",\"dur\":" << event.durationUs << ",\"args\":";
+            writeArgs(os, event.args);
+            os << "}";
+        }
+        for (auto const& counter : mCounters)
+        {
+            separator();
+            os << "{\"name\":\"" << escape(counter.name) << "\",\"ph\":\"C\",\"pid\":" << counter.pid
+               << ",\"ts\":" << counter.timeUs << ",\"args\":";
+            writeArgs(os, counter.values);
+            os << "}";
+        }
+        os << "\n]}\n";
+        return os.str();
+    }
+
+    void write(std::filesystem::path const& path) const
+    {
+        std::ofstream file{path};
+        TLLM_CHECK_WITH_INFO(file.good(), "Error opening trace file %s", path.string().c_str());
+        file << toJson();
+        TLLM_CHECK_WITH_INFO(file.good(), "Error writing trace file %s", path.string().c_str());
+    }
+
+    //! \brief Escape a string for a JSON string literal.
+    static std::string escape(std::string_view value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (auto const c : value)
+        {
+            switch (c)
+            {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20)
+                {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", static_cast<unsigned>(c));
+                    escaped += buffer;
+                }
+                else
+                {
+                    escaped += c;
+                }
+            }
+        }
+        return escaped;
+    }
+
+private:
+    static void writeArgs(std::ostream& os, Args const& args)
+    {
+        os << "{";
+        for (std::size_t i = 0; i < args.size(); ++i)
+        {
+            os << (i == 0 ? "" : ",") << "\"" << escape(args[i].first) << "\":" << args[i].second;
+        }
+        os << "}";
+    }
+
+    struct Event
+    {
+        std::string name;
+        std::string category;
+        std::int64_t pid;
+        std::int64_t tid;
+        double startUs;
+        double durationUs;
+        Args args;
+    };
+
+    struct Counter
+    {
+        std::string name;
+        std::int64_t pid;
+        double timeUs;
+        Args values;
+    };
+
+    struct ThreadName
+    {
+        std::int64_t pid;
+        std::int64_t tid;
+        std::string name;
+    };
+
+    std::vector<Event> mEvents;
+    std::vector<Counter> mCounters;
+    std::vector<ThreadName> mThreadNames;
+};
+
+} // namespace tensorrt_llm::common
@@ -53,32 +53,51 @@ CublasMMWrapper::CublasMMWrapper(CublasMMWrapper const& wrapper)
 void CublasMMWrapper::createDescriptors(cublasOperation_t transa, cublasOperation_t transb, int const m, int const n,
     int const k, int const lda, int const ldb, int const ldc)
 {
-    // --------------------------------------
-    // Create descriptors for the original matrices
-    check_cuda_error(
-        cublasLtMatrixLayoutCreate(&mADesc, mAType, transa == CUBLAS_OP_N ? m : k, transa == CUBLAS_OP_N ? k : m, lda));
-    check_cuda_error(
-        cublasLtMatrixLayoutCreate(&mBDesc, mBType, transb == CUBLAS_OP_N ? k : n, transb == CUBLAS_OP_N ? n : k, ldb));
-    check_cuda_error(cublasLtMatrixLayoutCreate(&mCDesc, mCType, m, n, ldc));
-    check_cuda_error(cublasLtMatmulDescCreate(&mOperationDesc, mComputeType, mScaleType));
-    check_cuda_error(cublasLtMatmulDescSetAttribute(
-        mOperationDesc, CUBLASLT_MATMUL_DESC_TRANSA, &transa, sizeof(cublasOperation_t)));
-    check_cuda_error(cublasLtMatmulDescSetAttribute(
-        mOperationDesc, CUBLASLT_MATMUL_DESC_TRANSB, &transb, sizeof(cublasOperation_t)));
+    DescriptorsKey const key{mAType, mBType, mCType, mComputeType, mScaleType, transa, transb, m, n, k, lda, ldb, ldc};
+    mCurrentDescriptors = &mDescriptorsCache.get(key,
+        [&]()
+        {
+            // --------------------------------------
+            // Create descriptors for the original matrices
+            Descriptors descriptors{};
+            check_cuda_error(cublasLtMatrixLayoutCreate(
+                &descriptors.aDesc, mAType, transa == CUBLAS_OP_N ? m : k, transa == CUBLAS_OP_N ? k : m, lda));
+            check_cuda_error(cublasLtMatrixLayoutCreate(
+                &descriptors.bDesc, mBType, transb == CUBLAS_OP_N ? k : n, transb == CUBLAS_OP_N ? n : k, ldb));
+            check_cuda_error(cublasLtMatrixLayoutCreate(&descriptors.cDesc, mCType, m, n, ldc));
+            check_cuda_error(cublasLtMatmulDescCreate(&descriptors.operationDesc, mComputeType, mScaleType));
+            check_cuda_error(cublasLtMatmulDescSetAttribute(
+                descriptors.operationDesc, CUBLASLT_MATMUL_DESC_TRANSA, &transa, sizeof(cublasOperation_t)));
+            check_cuda_error(cublasLtMatmulDescSetAttribute(
+                descriptors.operationDesc, CUBLASLT_MATMUL_DESC_TRANSB, &transb, sizeof(cublasOperation_t)));
+            return descriptors;
+        });
+
+    auto const& descriptors = mCurrentDescriptors->descriptors;
+    mOperationDesc = descriptors.operationDesc;
+    mADesc = descriptors.aDesc;
+    mBDesc = descriptors.bDesc;
+    mCDesc = descriptors.cDesc;
 }
 
 void CublasMMWrapper::destroyDescriptors()
 {
-    check_cuda_error(cublasLtMatmulDescDestroy(mOperationDesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mADesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mBDesc));
-    check_cuda_error(cublasLtMatrixLayoutDestroy(mCDesc));
+    // The descriptors stay in the cache
+    mCurrentDescriptors = nullptr;
     mOperationDesc = NULL;
     mADesc = NULL;
     mBDesc = NULL;
     mCDesc = NULL;
 }
 
+void CublasMMWrapper::destroyCachedDescriptors(Descriptors const& descriptors)
+{
+    check_cuda_error(cublasLtMatmulDescDestroy(descriptors.operationDesc));
+    check_cuda_error(cublasLtMatrixLayoutDestroy(descriptors.aDesc));
+    check_cuda_error(cublasLtMatrixLayoutDestroy(descriptors.bDesc));
+    check_cuda_error(cublasLtMatrixLayoutDestroy(descriptors.cDesc));
+}
+
 void CublasMMWrapper::Gemm(cublasOperation_t transa, cublasOperation_t transb, int const m, int const n, int const k,
     void const* A, int const lda, void const* B, int const ldb, void* C, int const ldc)
 {
@@ -290,14 +309,16 @@ bool CublasMMWrapper::checkTactic(cublasOperation_t transa, cublasOperation_t tr
     TLLM_CHECK_WITH_INFO(
         descriptorsCreated(), "Descriptors are not created! Call createDescriptors before calling this function");
 
-    int workspaceSize = mCublasWorkspace == NULL ? 0 : CUBLAS_WORKSPACE_SIZE;
-
-    cublasLtMatmulHeuristicResult_t heurResult;
-    cublasStatus_t algoStatus = cublasLtMatmulAlgoCheck(
-        getCublasLtHandle(), mOperationDesc, mADesc, mBDesc, mCDesc, mCDesc, &algo, &heurResult);
-
-    if (algoStatus != CUBLAS_STATUS_SUCCESS || heurResult.state != CUBLAS_STATUS_SUCCESS
-        || heurResult.workspaceSize > CUBLAS_WORKSPACE_SIZE)
+    // The GEMMs of a shape use the same algo, it is checked with the descriptors of the shape only once
+    auto const check = [this](cublasLtMatmulAlgo_t const& algo)
+    {
+        cublasLtMatmulHeuristicResult_t heurResult;
+        cublasStatus_t algoStatus = cublasLtMatmulAlgoCheck(
+            getCublasLtHandle(), mOperationDesc, mADesc, mBDesc, mCDesc, mCDesc, &algo, &heurResult);
+        return algoStatus == CUBLAS_STATUS_SUCCESS && heurResult.state == CUBLAS_STATUS_SUCCESS
+            && heurResult.workspaceSize <= CUBLAS_WORKSPACE_SIZE;
+    };
+    if (!CublasDescriptorsCache::checkAlgo(*mCurrentDescriptors, algo, check))
     {
         return false;
     }
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/descriptorsCache.h"
 #include <cublasLt.h>
 #include <cublas_v2.h>
 #include <cuda_runtime.h>
@@ -24,6 +25,7 @@
 #include <mutex>
 #include <optional>
 #include <string>
+#include <tuple>
 
 namespace tensorrt_llm
 {
@@ -54,6 +56,31 @@ protected:
     void* mCublasWorkspace = nullptr;
 
 private:
+    //! Data types, compute and scale types, transposes, m, n, k, lda, ldb and ldc of a GEMM
+    using DescriptorsKey = std::tuple<cudaDataType_t, cudaDataType_t, cudaDataType_t, cublasComputeType_t,
+        cudaDataType_t, cublasOperation_t, cublasOperation_t, int, int, int, int, int, int>;
+
+    struct Descriptors
+    {
+        cublasLtMatmulDesc_t operationDesc;
+        cublasLtMatrixLayout_t aDesc;
+        cublasLtMatrixLayout_t bDesc;
+        cublasLtMatrixLayout_t cDesc;
+    };
+
+    using CublasDescriptorsCache = DescriptorsCache<DescriptorsKey, Descriptors, cublasLtMatmulAlgo_t>;
+
+    static void destroyCachedDescriptors(Descriptors const& descriptors);
+
+public:
+    //! Most GEMMs of an engine repeat every step, so the descriptors are created once per shape
+    static constexpr std::size_t kMaxCachedDescriptors{256};
+
+private:
+    CublasDescriptorsCache mDescriptorsCache{kMaxCachedDescriptors, &CublasMMWrapper::destroyCachedDescriptors};
+    //! The cache entry of the current descriptors
+    CublasDescriptorsCache::Entry* mCurrentDescriptors{nullptr};
+
     bool descriptorsCreated() const
     {
         return mOperationDesc != NULL && mADesc != NULL && mBDesc != NULL && mCDesc != NULL;
@@ -67,6 +94,8 @@ public:
 
     CublasMMWrapper(CublasMMWrapper const& wrapper);
 
+    CublasMMWrapper& operator=(CublasMMWrapper const& wrapper) = delete;
+
     /********************** GEMMs **********************/
     void Gemm(cublasOperation_t transa, cublasOperation_t transb, int const m, int const n, int const k, void const* A,
         int const lda, void const* B, int const ldb, void* C, int const ldc);
@@ -130,8 +159,10 @@ public:
 
     CublasDataType getCublasDataType(cudaDataType_t data_type);
 
+    //! \brief Set the descriptors of a GEMM, they are taken from a cache of the recently used shapes if possible.
     void createDescriptors(cublasOperation_t transa, cublasOperation_t transb, int const m, int const n, int const k,
         int const lda, int const ldb, int const ldc);
+    //! \brief Release the current descriptors, cached descriptors are kept for the next GEMM of the same shape.
     void destroyDescriptors();
 
     cublasHandle_t getCublasHandle()
@@ -86,6 +86,23 @@ CUDADriverWrapper::CUDADriverWrapper()
     *(void**) (&_cuLaunchKernel) = load_sym(handle, "cuLaunchKernel");
     *(void**) (&_cuTensorMapEncodeTiled) = load_sym(handle, "cuTensorMapEncodeTiled");
     *(void**) (&_cuMemcpyDtoH) = load_sym(handle, "cuMemcpyDtoH_v2");
+    *(void**) (&_cuMemAddressReserve) = load_sym(handle, "cuMemAddressReserve");
+    *(void**) (&_cuMemAddressFree) = load_sym(handle, "cuMemAddressFree");
+    *(void**) (&_cuMemCreate) = load_sym(handle, "cuMemCreate");
+    *(void**) (&_cuMemRelease) = load_sym(handle, "cuMemRelease");
+    *(void**) (&_cuMemMap) = load_sym(handle, "cuMemMap");
+    *(void**) (&_cuMemUnmap) = load_sym(handle, "cuMemUnmap");
+    *(void**) (&_cuMemSetAccess) = load_sym(handle, "cuMemSetAccess");
+    *(void**) (&_cuMemGetAllocationGranularity) = load_sym(handle, "cuMemGetAllocationGranularity");
+#if CUDA_VERSION >= 12050
+    // Missing from drivers before 12.5, see hasGreenContexts.
+    *(void**) (&_cuDeviceGetDevResource) = load_sym(handle, "cuDeviceGetDevResource");
+    *(void**) (&_cuDevSmResourceSplitByCount) = load_sym(handle, "cuDevSmResourceSplitByCount");
+    *(void**) (&_cuDevResourceGenerateDesc) = load_sym(handle, "cuDevResourceGenerateDesc");
+    *(void**) (&_cuGreenCtxCreate) = load_sym(handle, "cuGreenCtxCreate");
+    *(void**) (&_cuGreenCtxDestroy) = load_sym(handle, "cuGreenCtxDestroy");
+    *(void**) (&_cuGreenCtxStreamCreate) = load_sym(handle, "cuGreenCtxStreamCreate");
+#endif
 }
 
 CUDADriverWrapper::~CUDADriverWrapper()
@@ -181,5 +198,94 @@ CUresult CUDADriverWrapper::cuMemcpyDtoH(void* dstHost, CUdeviceptr srcDevice, s
     return (*_cuMemcpyDtoH)(dstHost, srcDevice, ByteCount);
 }
 
+CUresult CUDADriverWrapper::cuMemAddressReserve(
+    CUdeviceptr* ptr, size_t size, size_t alignment, CUdeviceptr addr, unsigned long long flags) const
+{
+    return (*_cuMemAddressReserve)(ptr, size, alignment, addr, flags);
+}
+
+CUresult CUDADriverWrapper::cuMemAddressFree(CUdeviceptr ptr, size_t size) const
+{
+    return (*_cuMemAddressFree)(ptr, size);
+}
+
+CUresult CUDADriverWrapper::cuMemCreate(
+    CUmemGenericAllocationHandle* handle, size_t size, CUmemAllocationProp const* prop, unsigned long long flags) const
+{
+    return (*_cuMemCreate)(handle, size, prop, flags);
+}
+
+CUresult CUDADriverWrapper::cuMemRelease(CUmemGenericAllocationHandle handle) const
+{
+    return (*_cuMemRelease)(handle);
+}
+
+CUresult CUDADriverWrapper::cuMemMap(
+    CUdeviceptr ptr, size_t size, size_t offset, CUmemGenericAllocationHandle handle, unsigned long long flags) const
+{
+    return (*_cuMemMap)(ptr, size, offset, handle, flags);
+}
+
+CUresult CUDADriverWrapper::cuMemUnmap(CUdeviceptr ptr, size_t size) const
+{
+    return (*_cuMemUnmap)(ptr, size);
+}
+
+CUresult CUDADriverWrapper::cuMemSetAccess(
+    CUdeviceptr ptr, size_t size, CUmemAccessDesc const* desc, size_t count) const
+{
+    return (*_cuMemSetAccess)(ptr, size, desc, count);
+}
+
+CUresult CUDADriverWrapper::cuMemGetAllocationGranularity(
+    size_t* granularity, CUmemAllocationProp const* prop, CUmemAllocationGranularity_flags option) const
+{
+    return (*_cuMemGetAllocationGranularity)(granularity, prop, option);
+}
+
+#if CUDA_VERSION >= 12050
+bool CUDADriverWrapper::hasGreenContexts() const
+{
+    return _cuDeviceGetDevResource != nullptr && _cuDevSmResourceSplitByCount != nullptr
+        && _cuDevResourceGenerateDesc != nullptr && _cuGreenCtxCreate != nullptr && _cuGreenCtxDestroy != nullptr
+        && _cuGreenCtxStreamCreate != nullptr;
+}
+
+CUresult CUDADriverWrapper::cuDeviceGetDevResource(
+    CUdevice device, CUdevResource* resource, CUdevResourceType type) const
+{
+    return (*_cuDeviceGetDevResource)(device, resource, type);
+}
+
+CUresult CUDADriverWrapper::cuDevSmResourceSplitByCount(CUdevResource* result, unsigned int* nbGroups,
+    CUdevResource const* input, CUdevResource* remaining, unsigned int useFlags, unsigned int minCount) const
+{
+    return (*_cuDevSmResourceSplitByCount)(result, nbGroups, input, remaining, useFlags, minCount);
+}
+
+CUresult CUDADriverWrapper::cuDevResourceGenerateDesc(
+    CUdevResourceDesc* desc, CUdevResource* resources, unsigned int nbResources) const
+{
+    return (*_cuDevResourceGenerateDesc)(desc, resources, nbResources);
+}
+
+CUresult CUDADriverWrapper::cuGreenCtxCreate(
+    CUgreenCtx* ctx, CUdevResourceDesc desc, CUdevice device, unsigned int flags) const
+{
+    return (*_cuGreenCtxCreate)(ctx, desc, device, flags);
+}
+
+CUresult CUDADriverWrapper::cuGreenCtxDestroy(CUgreenCtx ctx) const
+{
+    return (*_cuGreenCtxDestroy)(ctx);
+}
+
+CUresult CUDADriverWrapper::cuGreenCtxStreamCreate(
+    CUstream* stream, CUgreenCtx ctx, unsigned int flags, int priority) const
+{
+    return (*_cuGreenCtxStreamCreate)(stream, ctx, flags, priority);
+}
+#endif
+
 } // namespace common
 } // namespace tensorrt_llm
@@ -82,6 +82,45 @@ public:
 
     CUresult cuMemcpyDtoH(void* dstHost, CUdeviceptr srcDevice, size_t ByteCount) const;
 
+    CUresult cuMemAddressReserve(CUdeviceptr* ptr, size_t size, size_t alignment, CUdeviceptr addr,
+        unsigned long long flags) const;
+
+    CUresult cuMemAddressFree(CUdeviceptr ptr, size_t size) const;
+
+    CUresult cuMemCreate(CUmemGenericAllocationHandle* handle, size_t size, CUmemAllocationProp const* prop,
+        unsigned long long flags) const;
+
+    CUresult cuMemRelease(CUmemGenericAllocationHandle handle) const;
+
+    CUresult cuMemMap(CUdeviceptr ptr, size_t size, size_t offset, CUmemGenericAllocationHandle handle,
+        unsigned long long flags) const;
+
+    CUresult cuMemUnmap(CUdeviceptr ptr, size_t size) const;
+
+    CUresult cuMemSetAccess(CUdeviceptr ptr, size_t size, CUmemAccessDesc const* desc, size_t count) const;
+
+    CUresult cuMemGetAllocationGranularity(
+        size_t* granularity, CUmemAllocationProp const* prop, CUmemAllocationGranularity_flags option) const;
+
+#if CUDA_VERSION >= 12050
+    //! \brief Whether the driver supports green contexts, i.e. the partitioning of the SMs of a device.
+    [[nodiscard]] bool hasGreenContexts() const;
+
+    CUresult cuDeviceGetDevResource(CUdevice device, CUdevResource* resource, CUdevResourceType type) const;
+
+    CUresult cuDevSmResourceSplitByCount(CUdevResource* result, unsigned int* nbGroups, CUdevResource const* input,
+        CUdevResource* remaining, unsigned int useFlags, unsigned int minCount) const;
+
+    CUresult cuDevResourceGenerateDesc(
+        CUdevResourceDesc* desc, CUdevResource* resources, unsigned int nbResources) const;
+
+    CUresult cuGreenCtxCreate(CUgreenCtx* ctx, CUdevResourceDesc desc, CUdevice device, unsigned int flags) const;
+
+    CUresult cuGreenCtxDestroy(CUgreenCtx ctx) const;
+
+    CUresult cuGreenCtxStreamCreate(CUstream* stream, CUgreenCtx ctx, unsigned int flags, int priority) const;
+#endif
+
 private:
     void* handle;
     CUresult (*_cuGetErrorName)(CUresult, char const**);
@@ -106,6 +145,23 @@ private:
         cuuint32_t const* boxDim, cuuint32_t const* elementStrides, CUtensorMapInterleave interleave,
         CUtensorMapSwizzle swizzle, CUtensorMapL2promotion l2Promotion, CUtensorMapFloatOOBfill oobFill);
     CUresult (*_cuMemcpyDtoH)(void* dstHost, CUdeviceptr srcDevice, size_t ByteCount);
+    CUresult (*_cuMemAddressReserve)(CUdeviceptr*, size_t, size_t, CUdeviceptr, unsigned long long);
+    CUresult (*_cuMemAddressFree)(CUdeviceptr, size_t);
+    CUresult (*_cuMemCreate)(CUmemGenericAllocationHandle*, size_t, CUmemAllocationProp const*, unsigned long long);
+    CUresult (*_cuMemRelease)(CUmemGenericAllocationHandle);
+    CUresult (*_cuMemMap)(CUdeviceptr, size_t, size_t, CUmemGenericAllocationHandle, unsigned long long);
+    CUresult (*_cuMemUnmap)(CUdeviceptr, size_t);
+    CUresult (*_cuMemSetAccess)(CUdeviceptr, size_t, CUmemAccessDesc const*, size_t);
+    CUresult (*_cuMemGetAllocationGranularity)(size_t*, CUmemAllocationProp const*, CUmemAllocationGranularity_flags);
+#if CUDA_VERSION >= 12050
+    CUresult (*_cuDeviceGetDevResource)(CUdevice, CUdevResource*, CUdevResourceType);
+    CUresult (*_cuDevSmResourceSplitByCount)(
+        CUdevResource*, unsigned int*, CUdevResource const*, CUdevResource*, unsigned int, unsigned int);
+    CUresult (*_cuDevResourceGenerateDesc)(CUdevResourceDesc*, CUdevResource*, unsigned int);
+    CUresult (*_cuGreenCtxCreate)(CUgreenCtx*, CUdevResourceDesc, CUdevice, unsigned int);
+    CUresult (*_cuGreenCtxDestroy)(CUgreenCtx);
+    CUresult (*_cuGreenCtxStreamCreate)(CUstream*, CUgreenCtx, unsigned int, int);
+#endif
 };
 
 inline void cuErrCheck_(CUresult stat, CUDADriverWrapper const* wrap, char const* file, int line)
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <map>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+namespace tensorrt_llm::common
+{
+
+//! \brief LRU cache of the descriptors of GEMM shapes, with the last algo checked against each shape.
+//! \details Used by CublasMMWrapper for its cuBLASLt descriptors, most GEMMs of an engine repeat every step so the
+//! descriptors are created once per shape. The cache owns the descriptors and destroys them with `destroy` when they
+//! are evicted or the cache is destroyed. References to entries stay valid until the entry is evicted.
+template <typename Key, typename Descriptors, typename Algo>
+class DescriptorsCache
+{
+    static_assert(std::is_trivially_copyable_v<Algo>, "Algos are compared bytewise");
+
+public:
+    struct Entry
+    {
+        Key key;
+        Descriptors descriptors;
+        //! The last algo checked with the descriptors and whether it is usable
+        std::optional<Algo> checkedAlgo;
+        bool checkedAlgoValid{false};
+    };
+
+    using Destroy = std::function<void(Descriptors const&)>;
+
+    DescriptorsCache(std::size_t capacity, Destroy destroy)
+        : mCapacity{capacity}
+        , mDestroy{std::move(destroy)}
+    {
+        TLLM_CHECK(mCapacity > 0);
+    }
+
+    ~DescriptorsCache()
+    {
+        for (auto const& entry : mEntries)
+        {
+            mDestroy(entry.descriptors);
+        }
+    }
+
+    DescriptorsCache(DescriptorsCache const&) = delete;
+    DescriptorsCache& operator=(DescriptorsCache const&) = delete;
+
+    //! \brief The entry of `key`, marked as most recently used. On a miss the descriptors are created with `create()`
+    //! and the least recently used entry is evicted if the cache is full.
+    template <typename Create>
+    Entry& get(Key const& key, Create&& create)
+    {
+        if (auto const it = mIndex.find(key); it != mIndex.end())
+        {
+            mEntries.splice(mEntries.begin(), mEntries, it->second);
+            return mEntries.front();
+        }
+        auto descriptors = create();
+        if (mEntries.size() >= mCapacity)
+        {
+            auto const& leastRecentlyUsed = mEntries.back();
+            mIndex.erase(leastRecentlyUsed.key);
+            mDestroy(leastRecentlyUsed.descriptors);
+            mEntries.pop_back();
+        }
+        mEntries.push_front(Entry{key, std::move(descriptors)});
+        mIndex.emplace(key, mEntries.begin());
+        return mEntries.front();
+    }
+
+    //! \brief Whether `algo` is usable with the descriptors of `entry`. `check(algo)` is only called if `algo` is not
+    //! the algo last checked with the entry, the GEMMs of a shape usually run the same algo.
+    template <typename Check>
+    static bool checkAlgo(Entry& entry, Algo const& algo, Check&& check)
+    {
+        if (entry.checkedAlgo && std::memcmp(&entry.checkedAlgo.value(), &algo, sizeof(Algo)) == 0)
+        {
+            return entry.checkedAlgoValid;
+        }
+        entry.checkedAlgoValid = check(algo);
+        entry.checkedAlgo = algo;
+        return entry.checkedAlgoValid;
+    }
+
+    [[nodiscard]] bool contains(Key const& key) const
+    {
+        return mIndex.find(key) != mIndex.end();
+    }
+
+    [[nodiscard]] std::size_t size() const
+    {
+        return mEntries.size();
+    }
+
+    [[nodiscard]] std::size_t capacity() const
+    {
+        return mCapacity;
+    }
+
+private:
+    std::size_t mCapacity;
+    Destroy mDestroy;
+    //! Most recently used first
+    std::list<Entry> mEntries;
+    std::map<Key, typename std::list<Entry>::iterator> mIndex;
+};
+
+} // namespace tensorrt_llm::common
@@ -17,7 +17,9 @@
 
 #include "envUtils.h"
 #include "tensorrt_llm/common/logger.h"
+#include <algorithm>
 #include <cstdlib>
+#include <thread>
 
 namespace tensorrt_llm::common
 {
@@ -83,6 +85,164 @@ std::optional<bool> getEnvEnableXQAJIT()
     }
 }
 
+std::optional<std::string> getEnvXQAJITCacheDir()
+{
+    static std::optional<std::string> const cacheDir = []() -> std::optional<std::string>
+    {
+        char const* const env = std::getenv("TRTLLM_XQA_JIT_CACHE_DIR");
+        if (env == nullptr || env[0] == '\0')
+        {
+            return std::nullopt;
+        }
+        return std::string{env};
+    }();
+    return cacheDir;
+}
+
+int32_t getEnvXQAJITCompileThreads()
+{
+    static int32_t const numThreads = getIntEnv("TRTLLM_XQA_JIT_COMPILE_THREADS")
+                                          .value_or(std::max(1U, std::thread::hardware_concurrency()));
+    return numThreads;
+}
+
+bool getEnvEnableMoeLoadStats()
+{
+    static bool const enableMoeLoadStats = (getIntEnv("TRTLLM_ENABLE_MOE_LOAD_STATS").value_or(0) != 0);
+    return enableMoeLoadStats;
+}
+
+std::optional<std::string> getEnvMoeRoutingDumpDir()
+{
+    static std::optional<std::string> const dumpDir = []() -> std::optional<std::string>
+    {
+        char const* const env = std::getenv("TRTLLM_MOE_ROUTING_DUMP_DIR");
+        if (env == nullptr || env[0] == '\0')
+        {
+            return std::nullopt;
+        }
+        return std::string{env};
+    }();
+    return dumpDir;
+}
+
+std::optional<std::string> getEnvWeightPreprocessCacheDir()
+{
+    static std::optional<std::string> const cacheDir = []() -> std::optional<std::string>
+    {
+        char const* const env = std::getenv("TRTLLM_WEIGHT_PREPROCESS_CACHE_DIR");
+        if (env == nullptr || env[0] == '\0')
+        {
+            return std::nullopt;
+        }
+        return std::string{env};
+    }();
+    return cacheDir;
+}
+
+int32_t getEnvWeightPreprocessThreads()
+{
+    static int32_t const numThreads = std::max(1,
+        getIntEnv("TRTLLM_WEIGHT_PREPROCESS_THREADS")
+            .value_or(static_cast<int32_t>(std::max(1U, std::thread::hardware_concurrency()))));
+    return numThreads;
+}
+
+std::optional<std::string> getEnvAllReduceTuningCacheDir()
+{
+    static std::optional<std::string> const cacheDir = []() -> std::optional<std::string>
+    {
+        char const* const env = std::getenv("TRTLLM_ALLREDUCE_TUNING_CACHE_DIR");
+        if (env == nullptr || env[0] == '\0')
+        {
+            return std::nullopt;
+        }
+        return std::string{env};
+    }();
+    return cacheDir;
+}
+
+int32_t getEnvAllReduceHierarchicalChunkSize()
+{
+    static int32_t const chunkSize = getIntEnv("TRTLLM_ALLREDUCE_HIERARCHICAL_CHUNK_SIZE").value_or(4 * 1024 * 1024);
+    return chunkSize;
+}
+
+bool getEnvDisableTopologyAwarePlacement()
+{
+    static bool const disable = (getIntEnv("TRTLLM_DISABLE_TOPOLOGY_AWARE_PLACEMENT").value_or(0) != 0);
+    return disable;
+}
+
+bool getEnvDisableNumaLocalPinnedMemory()
+{
+    static bool const disable = (getIntEnv("TRTLLM_DISABLE_NUMA_LOCAL_PINNED_MEMORY").value_or(0) != 0);
+    return disable;
+}
+
+std::size_t getEnvPinnedHugePageSize()
+{
+    static std::size_t const hugePageSize = []() -> std::size_t
+    {
+        auto const sizeMb = getIntEnv("TRTLLM_PINNED_HUGE_PAGE_SIZE_MB").value_or(0);
+        if (sizeMb != 0 && sizeMb != 2 && sizeMb != 1024)
+        {
+            TLLM_LOG_WARNING("TRTLLM_PINNED_HUGE_PAGE_SIZE_MB must be 2 or 1024, huge pages are disabled");
+            return 0;
+        }
+        return static_cast<std::size_t>(sizeMb) << 20;
+    }();
+    return hugePageSize;
+}
+
+bool getEnvPluginWeightStreaming()
+{
+    static bool const enable = (getIntEnv("TRTLLM_PLUGIN_WEIGHT_STREAMING").value_or(0) != 0);
+    return enable;
+}
+
+bool getEnvEnableCommTimingStats()
+{
+    static bool const enableCommTimingStats = (getIntEnv("TRTLLM_ENABLE_COMM_TIMING_STATS").value_or(0) != 0);
+    return enableCommTimingStats;
+}
+
+int32_t getEnvRangeProfilerSamplePeriod()
+{
+    static int32_t const samplePeriod = std::max(getIntEnv("TRTLLM_RANGE_PROFILER_SAMPLE_PERIOD").value_or(100), 0);
+    return samplePeriod;
+}
+
+int32_t getEnvRangeProfilerCapacity()
+{
+    static int32_t const capacity = std::max(getIntEnv("TRTLLM_RANGE_PROFILER_CAPACITY").value_or(4096), 1);
+    return capacity;
+}
+
+bool getEnvEnableMemoryTimeline()
+{
+    static bool const enableMemoryTimeline = (getIntEnv("TRTLLM_ENABLE_MEMORY_TIMELINE").value_or(0) != 0);
+    return enableMemoryTimeline;
+}
+
+int32_t getEnvMemoryTimelineCapacity()
+{
+    static int32_t const capacity = std::max(getIntEnv("TRTLLM_MEMORY_TIMELINE_CAPACITY").value_or(1 << 18), 1);
+    return capacity;
+}
+
+bool getEnvEnableRnnStateReuse()
+{
+    static bool const enableRnnStateReuse = (getIntEnv("TRTLLM_ENABLE_RNN_STATE_REUSE").value_or(0) != 0);
+    return enableRnnStateReuse;
+}
+
+bool getEnvReportFusionBarriers()
+{
+    static bool const reportFusionBarriers = (getIntEnv("TRTLLM_REPORT_FUSION_BARRIERS").value_or(0) != 0);
+    return reportFusionBarriers;
+}
+
 // Tune the number of blocks per sequence for accuracy/performance purpose.
 bool getEnvMmhaMultiblockDebug()
 {
@@ -16,8 +16,10 @@
  */
 
 #pragma once
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <string>
 
 namespace tensorrt_llm::common
 {
@@ -38,6 +40,83 @@ std::optional<int32_t> envXqaNbCtaPerKVHead();
 // Returns the value of TRTLLM_ENABLE_XQA_JIT env var. If such env var doesn't exist, std::nullopt is returned.
 std::optional<bool> getEnvEnableXQAJIT();
 
+// Directory of the on-disk cache of XQA JIT cubins, shared by processes.
+//
+// Returns the value of TRTLLM_XQA_JIT_CACHE_DIR env var. If such env var doesn't exist, std::nullopt is returned and
+// cubins are only cached in memory.
+std::optional<std::string> getEnvXQAJITCacheDir();
+
+// Number of threads compiling XQA JIT cubins, TRTLLM_XQA_JIT_COMPILE_THREADS or the number of hardware threads.
+int32_t getEnvXQAJITCompileThreads();
+
+// Whether the MoE plugins count the tokens routed to each expert, see runtime::MoeExpertLoadTracker.
+bool getEnvEnableMoeLoadStats();
+
+// Directory the MoE plugins append their router logits to, for replay in the MoE micro benchmark.
+//
+// Returns the value of TRTLLM_MOE_ROUTING_DUMP_DIR env var. If such env var doesn't exist, std::nullopt is returned and
+// nothing is dumped.
+std::optional<std::string> getEnvMoeRoutingDumpDir();
+
+// Directory of the on-disk cache of weights preprocessed for the mixed type GEMMs, keyed by a hash of their content.
+//
+// Returns the value of TRTLLM_WEIGHT_PREPROCESS_CACHE_DIR env var. If such env var doesn't exist, std::nullopt is
+// returned and weights are preprocessed on every load.
+std::optional<std::string> getEnvWeightPreprocessCacheDir();
+
+// Number of threads preprocessing weights, TRTLLM_WEIGHT_PREPROCESS_THREADS or the number of hardware threads.
+int32_t getEnvWeightPreprocessThreads();
+
+// Directory of the allreduce strategies measured on this machine, keyed by GPU, group size, link and data type.
+//
+// Returns the value of TRTLLM_ALLREDUCE_TUNING_CACHE_DIR env var. If such env var doesn't exist, std::nullopt is
+// returned and the AUTO allreduce strategy uses its static message size thresholds.
+std::optional<std::string> getEnvAllReduceTuningCacheDir();
+
+// Bytes of each pipelined chunk of the hierarchical allreduce, TRTLLM_ALLREDUCE_HIERARCHICAL_CHUNK_SIZE or 4 MiB.
+int32_t getEnvAllReduceHierarchicalChunkSize();
+
+// Whether WorldConfig::mpi keeps the ranks on the devices in order instead of placing tensor parallel groups within
+// NVLink islands, TRTLLM_DISABLE_TOPOLOGY_AWARE_PLACEMENT.
+bool getEnvDisableTopologyAwarePlacement();
+
+// Whether pinned host buffers may be allocated on any NUMA node instead of the one of their GPU,
+// TRTLLM_DISABLE_NUMA_LOCAL_PINNED_MEMORY.
+bool getEnvDisableNumaLocalPinnedMemory();
+
+// Bytes of the huge pages backing large pinned host allocations, TRTLLM_PINNED_HUGE_PAGE_SIZE_MB, 2 or 1024. The pages
+// must be reserved in /proc/sys/vm/nr_hugepages or the per-size sysfs entry. Default 0, pinned memory is allocated
+// with cudaHostAlloc.
+std::size_t getEnvPinnedHugePageSize();
+
+// Whether the GEMM plugins stage weights that reside in host memory into device memory with a layer-ahead prefetch,
+// see plugins::WeightStreamer, TRTLLM_PLUGIN_WEIGHT_STREAMING.
+bool getEnvPluginWeightStreaming();
+
+// Whether the communication plugins time their collectives with CUDA events, see runtime::CommTimingTracker.
+bool getEnvEnableCommTimingStats();
+
+// One in this many outermost ranges of runtime::RangeProfiler is recorded with its nested ranges,
+// TRTLLM_RANGE_PROFILER_SAMPLE_PERIOD, default 100. 0 disables the recording, the NVTX ranges remain.
+int32_t getEnvRangeProfilerSamplePeriod();
+
+// Ranges kept per thread by runtime::RangeProfiler, TRTLLM_RANGE_PROFILER_CAPACITY, default 4096.
+int32_t getEnvRangeProfilerCapacity();
+
+// Whether the allocators record every allocation and free in runtime::MemoryTimeline, TRTLLM_ENABLE_MEMORY_TIMELINE.
+bool getEnvEnableMemoryTimeline();
+
+// Events kept by runtime::MemoryTimeline, TRTLLM_MEMORY_TIMELINE_CAPACITY, default 262144.
+int32_t getEnvMemoryTimelineCapacity();
+
+// Whether the context phase of the recurrent layers starts from the state in the slot of the request, restored by
+// runtime::RnnStatePool, instead of zeros.
+bool getEnvEnableRnnStateReuse();
+
+// Whether TllmRuntime logs the plugin layers of an engine at load, the boundaries TensorRT can't fuse across, see
+// runtime::FusionBarrierReport, TRTLLM_REPORT_FUSION_BARRIERS.
+bool getEnvReportFusionBarriers();
+
 // Tune the number of blocks per sequence for accuracy/performance purpose.
 bool getEnvMmhaMultiblockDebug();
 
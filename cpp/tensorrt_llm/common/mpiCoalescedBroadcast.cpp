@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/mpiCoalescedBroadcast.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace tensorrt_llm::mpi
+{
+
+namespace
+{
+// Start of the inline buffer: number of messages and bytes of the whole batch, header included.
+struct BatchHeader
+{
+    std::uint64_t numMessages;
+    std::uint64_t numBytes;
+};
+
+using MessageSize = std::uint64_t;
+
+void checkCount(std::size_t size)
+{
+    TLLM_CHECK_WITH_INFO(size <= static_cast<std::size_t>(std::numeric_limits<int>::max()),
+        "Batch of %zu bytes is too large for one broadcast", size);
+}
+} // namespace
+
+MpiCoalescedBroadcast::MpiCoalescedBroadcast(MpiComm const& comm, int root, std::size_t inlineCapacity)
+    : mComm{comm}
+    , mRoot{root}
+    , mInlineCapacity{inlineCapacity}
+{
+    TLLM_CHECK_WITH_INFO(mInlineCapacity >= sizeof(BatchHeader), "Inline capacity of %zu bytes is below the header",
+        mInlineCapacity);
+    checkCount(mInlineCapacity);
+    for (auto& slot : mSlots)
+    {
+        slot.inlineBuffer.resize(mInlineCapacity);
+    }
+}
+
+MpiCoalescedBroadcast::~MpiCoalescedBroadcast()
+{
+    if (isRoot())
+    {
+        for (auto& slot : mSlots)
+        {
+            wait(slot);
+        }
+    }
+    else if (mReceivePosted)
+    {
+        TLLM_LOG_WARNING("MpiCoalescedBroadcast destroyed with a receive still posted");
+    }
+}
+
+bool MpiCoalescedBroadcast::isRoot() const
+{
+    return mComm.getRank() == mRoot;
+}
+
+void MpiCoalescedBroadcast::wait(Slot& slot)
+{
+    for (auto* request : {&slot.inlineRequest, &slot.overflowRequest})
+    {
+        if (*request)
+        {
+            (*request)->wait();
+            request->reset();
+        }
+    }
+}
+
+void MpiCoalescedBroadcast::add(char const* data, std::size_t size)
+{
+    TLLM_CHECK_WITH_INFO(isRoot(), "Only the root adds messages");
+    auto const offset = mBatch.size();
+    mBatch.resize(offset + sizeof(MessageSize) + size);
+    MessageSize const messageSize = size;
+    std::memcpy(mBatch.data() + offset, &messageSize, sizeof(MessageSize));
+    std::memcpy(mBatch.data() + offset + sizeof(MessageSize), data, size);
+    ++mBatchSize;
+}
+
+void MpiCoalescedBroadcast::post()
+{
+    TLLM_CHECK_WITH_INFO(isRoot(), "Only the root posts batches");
+    auto& slot = mSlots[mNextSlot];
+    mNextSlot = 1 - mNextSlot;
+    // The buffers of this slot are reused, the broadcast of the iteration before the previous one must be done.
+    wait(slot);
+
+    BatchHeader const header{mBatchSize, sizeof(BatchHeader) + mBatch.size()};
+    std::memcpy(slot.inlineBuffer.data(), &header, sizeof(BatchHeader));
+    auto const numInline = std::min(mBatch.size(), mInlineCapacity - sizeof(BatchHeader));
+    std::copy_n(mBatch.begin(), numInline, slot.inlineBuffer.begin() + sizeof(BatchHeader));
+    slot.overflowBuffer.assign(mBatch.begin() + numInline, mBatch.end());
+    checkCount(slot.overflowBuffer.size());
+
+    slot.inlineRequest = mComm.bcastAsync(slot.inlineBuffer.data(), mInlineCapacity, MpiType::kBYTE, mRoot);
+    if (!slot.overflowBuffer.empty())
+    {
+        TLLM_LOG_DEBUG("Batch of %lu bytes exceeds the inline capacity of %zu bytes", header.numBytes, mInlineCapacity);
+        slot.overflowRequest
+            = mComm.bcastAsync(slot.overflowBuffer.data(), slot.overflowBuffer.size(), MpiType::kBYTE, mRoot);
+    }
+    mBatch.clear();
+    mBatchSize = 0;
+}
+
+void MpiCoalescedBroadcast::postReceive()
+{
+    TLLM_CHECK_WITH_INFO(!isRoot(), "The root does not receive batches");
+    TLLM_CHECK_WITH_INFO(!mReceivePosted, "The receive of the next batch is already posted");
+    auto& slot = mSlots[0];
+    slot.inlineRequest = mComm.bcastAsync(slot.inlineBuffer.data(), mInlineCapacity, MpiType::kBYTE, mRoot);
+    mReceivePosted = true;
+}
+
+std::vector<MpiCoalescedBroadcast::Message> MpiCoalescedBroadcast::receive()
+{
+    if (!mReceivePosted)
+    {
+        postReceive();
+    }
+    auto& slot = mSlots[0];
+    slot.inlineRequest->wait();
+    slot.inlineRequest.reset();
+    mReceivePosted = false;
+
+    BatchHeader header{};
+    std::memcpy(&header, slot.inlineBuffer.data(), sizeof(BatchHeader));
+    auto const numBytes = static_cast<std::size_t>(header.numBytes);
+    // The overflow broadcast follows the inline one on the root, before any later batch.
+    slot.overflowBuffer.resize(numBytes > mInlineCapacity ? numBytes - mInlineCapacity : 0);
+    if (!slot.overflowBuffer.empty())
+    {
+        mComm.bcast(slot.overflowBuffer.data(), slot.overflowBuffer.size(), MpiType::kBYTE, mRoot);
+    }
+
+    // Reads the batch across the end of the inline buffer and the overflow buffer.
+    std::size_t pos = sizeof(BatchHeader);
+    auto const read = [&](char* dst, std::size_t size)
+    {
+        while (size > 0)
+        {
+            auto const inOverflow = pos >= mInlineCapacity;
+            auto const* src = inOverflow ? slot.overflowBuffer.data() + (pos - mInlineCapacity)
+                                         : slot.inlineBuffer.data() + pos;
+            auto const available = inOverflow ? numBytes - pos : std::min(numBytes, mInlineCapacity) - pos;
+            auto const chunk = std::min(size, available);
+            std::memcpy(dst, src, chunk);
+            dst += chunk;
+            pos += chunk;
+            size -= chunk;
+        }
+    };
+
+    std::vector<Message> messages(header.numMessages);
+    for (auto& message : messages)
+    {
+        MessageSize size{0};
+        read(reinterpret_cast<char*>(&size), sizeof(MessageSize));
+        message.resize(size);
+        read(message.data(), size);
+    }
+    TLLM_CHECK_WITH_INFO(pos == numBytes, "Read %zu bytes of a batch of %zu bytes", pos, numBytes);
+    return messages;
+}
+
+} // namespace tensorrt_llm::mpi
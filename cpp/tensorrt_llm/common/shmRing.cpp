@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/shmRing.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/spanStreamBuf.h"
+
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tensorrt_llm::common
+{
+
+namespace
+{
+constexpr std::uint64_t kMagic = 0x74726c6c6d73686dULL;
+// Length of a message header telling the consumer to continue at the start of the ring
+constexpr std::uint64_t kWrapMarker = std::numeric_limits<std::uint64_t>::max();
+constexpr std::size_t kAlignment = 8;
+// Messages start after the header, on their own cache line
+constexpr std::size_t kDataOffset = 192;
+
+constexpr std::size_t roundUp(std::size_t value, std::size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+} // namespace
+
+struct ShmRing::Header
+{
+    std::uint64_t magic;
+    std::uint64_t capacity;
+    // Positions grow monotonically, the offset in the ring is position % capacity.
+    alignas(64) std::atomic<std::uint64_t> writePos;
+    alignas(64) std::atomic<std::uint64_t> readPos;
+};
+
+ShmRing ShmRing::create(std::string const& name, std::size_t capacity)
+{
+    TLLM_CHECK(capacity > 0);
+#if defined(_WIN32)
+    TLLM_THROW("ShmRing is not supported on Windows");
+#else
+    capacity = roundUp(capacity, kAlignment);
+    auto const mappingSize = kDataOffset + capacity;
+    auto const fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    TLLM_CHECK_WITH_INFO(fd >= 0, "Failed to create shared memory %s: %s", name.c_str(), std::strerror(errno));
+    if (::ftruncate(fd, static_cast<off_t>(mappingSize)) != 0)
+    {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        TLLM_THROW("Failed to size shared memory %s: %s", name.c_str(), std::strerror(errno));
+    }
+    auto* mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(fd);
+        ::shm_unlink(name.c_str());
+        TLLM_THROW("Failed to map shared memory %s: %s", name.c_str(), std::strerror(errno));
+    }
+    auto* header = new (mapping) Header{};
+    header->capacity = capacity;
+    header->writePos.store(0, std::memory_order_relaxed);
+    header->readPos.store(0, std::memory_order_relaxed);
+    header->magic = kMagic;
+    return ShmRing{name, true, fd, mapping, mappingSize};
+#endif
+}
+
+ShmRing ShmRing::open(std::string const& name)
+{
+#if defined(_WIN32)
+    TLLM_THROW("ShmRing is not supported on Windows");
+#else
+    auto const fd = ::shm_open(name.c_str(), O_RDWR, 0600);
+    TLLM_CHECK_WITH_INFO(fd >= 0, "Failed to open shared memory %s: %s", name.c_str(), std::strerror(errno));
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) <= kDataOffset)
+    {
+        ::close(fd);
+        TLLM_THROW("Shared memory %s is not a ring", name.c_str());
+    }
+    auto const mappingSize = static_cast<std::size_t>(st.st_size);
+    auto* mapping = ::mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        ::close(fd);
+        TLLM_THROW("Failed to map shared memory %s: %s", name.c_str(), std::strerror(errno));
+    }
+    ShmRing ring{name, false, fd, mapping, mappingSize};
+    auto const& header = ring.header();
+    TLLM_CHECK_WITH_INFO(header.magic == kMagic && kDataOffset + header.capacity == mappingSize,
+        "Shared memory %s is not a ring", name.c_str());
+    return ring;
+#endif
+}
+
+ShmRing::ShmRing(std::string name, bool owner, int fd, void* mapping, std::size_t mappingSize)
+    : mName{std::move(name)}
+    , mOwner{owner}
+    , mFd{fd}
+    , mMapping{mapping}
+    , mMappingSize{mappingSize}
+{
+}
+
+ShmRing::~ShmRing()
+{
+#if !defined(_WIN32)
+    if (mMapping != nullptr)
+    {
+        ::munmap(mMapping, mMappingSize);
+        ::close(mFd);
+        if (mOwner)
+        {
+            ::shm_unlink(mName.c_str());
+        }
+    }
+#endif
+}
+
+ShmRing::ShmRing(ShmRing&& other) noexcept
+    : mName{std::move(other.mName)}
+    , mOwner{other.mOwner}
+    , mFd{other.mFd}
+    , mMapping{other.mMapping}
+    , mMappingSize{other.mMappingSize}
+    , mPendingPos{other.mPendingPos}
+{
+    other.mMapping = nullptr;
+    other.mFd = -1;
+}
+
+ShmRing& ShmRing::operator=(ShmRing&& other) noexcept
+{
+    // The resources of this ring are released with `other`.
+    std::swap(mName, other.mName);
+    std::swap(mOwner, other.mOwner);
+    std::swap(mFd, other.mFd);
+    std::swap(mMapping, other.mMapping);
+    std::swap(mMappingSize, other.mMappingSize);
+    std::swap(mPendingPos, other.mPendingPos);
+    return *this;
+}
+
+ShmRing::Header& ShmRing::header() const noexcept
+{
+    static_assert(sizeof(Header) <= kDataOffset);
+    return *static_cast<Header*>(mMapping);
+}
+
+char* ShmRing::data() const noexcept
+{
+    return static_cast<char*>(mMapping) + kDataOffset;
+}
+
+std::size_t ShmRing::getCapacity() const noexcept
+{
+    return header().capacity;
+}
+
+char* ShmRing::tryReserve(std::size_t size)
+{
+    auto& hdr = header();
+    auto const capacity = hdr.capacity;
+    auto const needed = sizeof(std::uint64_t) + roundUp(size, kAlignment);
+    TLLM_CHECK_WITH_INFO(needed <= capacity, "Message of %lu bytes exceeds the ring capacity of %lu bytes", size,
+        static_cast<std::size_t>(capacity));
+
+    auto pos = hdr.writePos.load(std::memory_order_relaxed);
+    auto const readPos = hdr.readPos.load(std::memory_order_acquire);
+    auto const tillEnd = capacity - pos % capacity;
+    auto const skipped = needed > tillEnd ? tillEnd : 0;
+    if (pos + skipped + needed - readPos > capacity)
+    {
+        return nullptr;
+    }
+    if (skipped > 0)
+    {
+        std::memcpy(data() + pos % capacity, &kWrapMarker, sizeof(kWrapMarker));
+        pos += skipped;
+    }
+    auto* message = data() + pos % capacity;
+    std::uint64_t const length = size;
+    std::memcpy(message, &length, sizeof(length));
+    mPendingPos = pos + needed;
+    return message + sizeof(length);
+}
+
+void ShmRing::commit()
+{
+    TLLM_CHECK_WITH_INFO(mPendingPos.has_value(), "No message reserved");
+    header().writePos.store(mPendingPos.value(), std::memory_order_release);
+    mPendingPos.reset();
+}
+
+bool ShmRing::tryWrite(std::size_t size, std::function<void(std::ostream&)> const& write)
+{
+    auto* message = tryReserve(size);
+    if (message == nullptr)
+    {
+        return false;
+    }
+    SpanStreamBuf buffer{message, size};
+    std::ostream os{&buffer};
+    write(os);
+    TLLM_CHECK_WITH_INFO(os.good() && buffer.getNumWritten() == size, "Wrote %lu bytes into a message of %lu bytes",
+        buffer.getNumWritten(), size);
+    commit();
+    return true;
+}
+
+std::optional<ShmRing::Message> ShmRing::tryPeek()
+{
+    auto& hdr = header();
+    auto const capacity = hdr.capacity;
+    auto pos = hdr.readPos.load(std::memory_order_relaxed);
+    if (pos == hdr.writePos.load(std::memory_order_acquire))
+    {
+        return std::nullopt;
+    }
+    std::uint64_t length{0};
+    std::memcpy(&length, data() + pos % capacity, sizeof(length));
+    if (length == kWrapMarker)
+    {
+        pos += capacity - pos % capacity;
+        std::memcpy(&length, data() + pos % capacity, sizeof(length));
+    }
+    mPendingPos = pos + sizeof(length) + roundUp(length, kAlignment);
+    return Message{data() + pos % capacity + sizeof(length), static_cast<std::size_t>(length)};
+}
+
+void ShmRing::release()
+{
+    TLLM_CHECK_WITH_INFO(mPendingPos.has_value(), "No message peeked");
+    header().readPos.store(mPendingPos.value(), std::memory_order_release);
+    mPendingPos.reset();
+}
+
+} // namespace tensorrt_llm::common
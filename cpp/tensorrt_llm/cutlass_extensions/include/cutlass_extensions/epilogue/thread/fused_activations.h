@@ -98,6 +98,23 @@ struct GELU_taylor<float>
     }
 };
 
+/////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Squared ReLU, relu(z) * relu(z)
+template <typename T>
+struct SquaredReLu
+{
+    static bool const kIsHeavy = false;
+
+    CUTLASS_HOST_DEVICE
+    T operator()(T const& z) const
+    {
+        ReLu<T> relu;
+        T const r = relu(z);
+        return r * r;
+    }
+};
+
 } // namespace thread
 } // namespace epilogue
 } // namespace cutlass
@@ -34,6 +34,7 @@
 
 #include "cutlass_extensions/gemm/kernel/gemm_moe_problem_visitor.h"
 #include "cutlass_extensions/tile_interleaved_layout.h"
+#include "cutlass_extensions/weight_only_quant_op.h"
 
 #include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_sm90_traits.h"
 
@@ -62,6 +63,19 @@ struct use_dq_gemm<Mma, void_t<typename Mma::IteratorScale>> : platform::true_ty
 {
 };
 
+// The scale layout of the dequantizing gemm, plain gemms are treated as per column so the group size is gemm_k
+template <typename Mma, bool = use_dq_gemm<Mma>::value>
+struct moe_quant_op
+{
+    static constexpr WeightOnlyQuantOp value = WeightOnlyQuantOp::PER_COLUMN_SCALE_ONLY;
+};
+
+template <typename Mma>
+struct moe_quant_op<Mma, true>
+{
+    static constexpr WeightOnlyQuantOp value = Mma::QuantOp;
+};
+
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename Mma_,          ///! Threadblock-scoped matrix multiply-accumulate
@@ -256,6 +270,7 @@ public:
             problem_visitor = typename ProblemVisitor::Params(
                 args.total_rows_before_expert, args.gemm_n, args.gemm_k, args.problem_count, workspace, tile_count);
             threadblock_count = args.threadblock_count;
+            group_size = args.group_size;
             output_op = args.output_op;
             ptr_A = args.ptr_A;
             ptr_B = args.ptr_B;
@@ -289,6 +304,8 @@ public:
 
     static Status can_implement(Arguments const& args)
     {
+        constexpr WeightOnlyQuantOp kQuantOp = moe_quant_op<Mma>::value;
+        static_assert(!hasZero(kQuantOp), "MoeFCGemm does not support weight zero points");
         if (platform::is_same<uint8_t, ElementB>::value || platform::is_same<uint4b_t, ElementB>::value)
         {
             if (args.weight_scales == nullptr)
@@ -296,6 +313,17 @@ public:
                 CUTLASS_TRACE_HOST("MoeFCGemm::can_implement() - weight scales are required for uint8_t and uint4b_t");
                 return Status::kInvalid;
             }
+            if (isFinegrained(kQuantOp)
+                && ((args.group_size != 64 && args.group_size != 128) || args.gemm_k % args.group_size != 0))
+            {
+                CUTLASS_TRACE_HOST("MoeFCGemm::can_implement() - group size must be 64 or 128 and divide gemm_k");
+                return Status::kInvalid;
+            }
+            if (!isFinegrained(kQuantOp) && args.group_size != args.gemm_k)
+            {
+                CUTLASS_TRACE_HOST("MoeFCGemm::can_implement() - scale shape should be (1, gemm_n)");
+                return Status::kInvalid;
+            }
         }
         else if (args.weight_scales != nullptr)
         {
@@ -427,10 +455,21 @@ public:
             __syncthreads();
 
             // Compute threadblock-scoped matrix multiply-add
-            ElementScale* weight_scale_ptr = params.weight_scales + problem_idx * problem_size.n();
+            if constexpr (use_dq_gemm<Mma>::value && isFinegrained(moe_quant_op<Mma>::value))
+            {
+                // Scales are [gemm_k / group_size, gemm_n] per expert. The iterator addresses rows in units of 64
+                // elements of K and steps to the next scale row every group_size / 64 of them
+                ElementScale* weight_scale_ptr
+                    = params.weight_scales + problem_idx * (gemm_k / params.group_size) * problem_size.n();
+                const MatrixCoord scale_extent = {problem_size.k() / 64, problem_size.n()};
+                typename Mma::IteratorScale iterator_scale(Mma::IteratorScale::Layout(scale_extent.column()),
+                    weight_scale_ptr, nullptr, scale_extent, thread_idx, tb_offset_scale, params.group_size);
 
-            if constexpr (use_dq_gemm<Mma>::value)
+                mma(gemm_k_iterations, accumulators, iterator_A, iterator_B, iterator_scale, accumulators);
+            }
+            else if constexpr (use_dq_gemm<Mma>::value)
             {
+                ElementScale* weight_scale_ptr = params.weight_scales + problem_idx * problem_size.n();
                 const MatrixCoord scale_extent = {1, problem_size.n()};
                 typename Mma::IteratorScale iterator_scale(Mma::IteratorScale::Layout(scale_extent.column()),
                     weight_scale_ptr, scale_extent, thread_idx, tb_offset_scale);
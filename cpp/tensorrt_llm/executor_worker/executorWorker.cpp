@@ -17,10 +17,12 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/common/spanStreamBuf.h"
 #include "tensorrt_llm/executor/executor.h"
 #include "tensorrt_llm/executor/serialization.h"
 #include "tensorrt_llm/plugins/api/tllmPlugin.h"
 #include <csignal>
+#include <istream>
 
 namespace tle = tensorrt_llm::executor;
 
@@ -68,7 +70,9 @@ int main(int argc, char* argv[])
     MPICHECK(MPI_Bcast(&bufferSize, 1, MPI_INT64_T, 0, parentComm));
     std::vector<char> buffer(bufferSize);
     MPICHECK(MPI_Bcast(buffer.data(), bufferSize, MPI_CHAR, 0, parentComm));
-    std::istringstream is(std::string(buffer.begin(), buffer.end()));
+    // Deserialize in place, without copying the buffer into a string.
+    tensorrt_llm::common::SpanStreamBuf streamBuf{buffer.data(), buffer.size()};
+    std::istream is(&streamBuf);
     auto modelPath = tle::Serialization::deserializeString(is);
     auto modelType = tle::Serialization::deserializeModelType(is);
     auto executorConfig = tle::Serialization::deserializeExecutorConfig(is);
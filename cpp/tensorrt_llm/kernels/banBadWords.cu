@@ -29,7 +29,7 @@ template <typename T>
 __global__ void ban_bad_words(T* logits, TokenIdType const** output_ids_ptr, SizeType32 const** parent_ids_ptr,
     SizeType32 const* batch_slots, SizeType32 beam_width, TokenIdType const** bad_words_ptrs,
     SizeType32 const* bad_words_lens, SizeType32 vocab_size_padded, SizeType32 const* sequence_lengths,
-    SizeType32 max_seq_len)
+    SizeType32 max_seq_len, bool const* skip_slots)
 {
     auto const id = blockIdx.x * blockDim.x + threadIdx.x;
     auto const batch_idx = blockIdx.y / beam_width;
@@ -37,6 +37,11 @@ __global__ void ban_bad_words(T* logits, TokenIdType const** output_ids_ptr, Siz
     auto const batch_slot = batch_slots != nullptr ? batch_slots[batch_idx] : batch_idx;
     auto const batch_beam_idx = batch_slot * beam_width + beam_idx;
 
+    if (skip_slots != nullptr && skip_slots[batch_slot])
+    {
+        return;
+    }
+
     auto const* base_bad_words = bad_words_ptrs[batch_slot];
     auto const bad_words_len = bad_words_lens[batch_slot];
     auto const* base_bad_words_offsets = base_bad_words + bad_words_len;
@@ -101,7 +106,7 @@ template <typename T>
 void invokeBanBadWords(T* logits, TokenIdType const** output_ids_ptr, SizeType32 const** parent_ids_ptr,
     SizeType32 const* batch_slot, SizeType32 batch_size, SizeType32 beam_width, TokenIdType const** bad_words,
     SizeType32 const* bad_words_lens, SizeType32 max_bad_words_len, SizeType32 vocab_size_padded,
-    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, cudaStream_t stream)
+    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, bool const* skip_slots, cudaStream_t stream)
 {
     dim3 block, grid;
     constexpr SizeType32 max_blocks{256};
@@ -110,24 +115,25 @@ void invokeBanBadWords(T* logits, TokenIdType const** output_ids_ptr, SizeType32
     grid.y = batch_size * beam_width;
 
     ban_bad_words<<<grid, block, 0, stream>>>(logits, output_ids_ptr, parent_ids_ptr, batch_slot, beam_width, bad_words,
-        bad_words_lens, vocab_size_padded, sequence_lengths, max_seq_len);
+        bad_words_lens, vocab_size_padded, sequence_lengths, max_seq_len, skip_slots);
     sync_check_cuda_error();
 }
 
 template void invokeBanBadWords(half* logits, TokenIdType const** output_ids_ptr, SizeType32 const** parent_ids_ptr,
     SizeType32 const* batch_slot, SizeType32 batch_size, SizeType32 beam_width, TokenIdType const** bad_words,
     SizeType32 const* bad_words_lens, SizeType32 max_bad_words_len, SizeType32 vocab_size_padded,
-    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, cudaStream_t stream);
+    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, bool const* skip_slots, cudaStream_t stream);
 #ifdef ENABLE_BF16
 template void invokeBanBadWords(__nv_bfloat16* logits, TokenIdType const** output_ids_ptr,
     SizeType32 const** parent_ids_ptr, SizeType32 const* batch_slot, SizeType32 batch_size, SizeType32 beam_width,
     TokenIdType const** bad_words, SizeType32 const* bad_words_lens, SizeType32 max_bad_words_len,
-    SizeType32 vocab_size_padded, SizeType32 const* sequence_lengths, SizeType32 max_seq_len, cudaStream_t stream);
+    SizeType32 vocab_size_padded, SizeType32 const* sequence_lengths, SizeType32 max_seq_len, bool const* skip_slots,
+    cudaStream_t stream);
 #endif
 template void invokeBanBadWords(float* logits, TokenIdType const** output_ids_ptr, SizeType32 const** parent_ids_ptr,
     SizeType32 const* batch_slot, SizeType32 batch_size, SizeType32 beam_width, TokenIdType const** bad_words,
     SizeType32 const* bad_words_lens, SizeType32 max_bad_words_len, SizeType32 vocab_size_padded,
-    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, cudaStream_t stream);
+    SizeType32 const* sequence_lengths, SizeType32 max_seq_len, bool const* skip_slots, cudaStream_t stream);
 
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -25,12 +25,15 @@ namespace tensorrt_llm
 namespace kernels
 {
 
+//! \brief Sets the logits of the last token of the bad words whose other tokens end the sequence to -INF.
+//! \param skip_slots input buffer [maxBatchSize], optional. Requests to skip, e.g. banned with invokeBanWordsAutomaton
 template <typename T>
 void invokeBanBadWords(T* logits, runtime::TokenIdType const** output_ids_ptr,
     runtime::SizeType32 const** parent_ids_ptr, runtime::SizeType32 const* batch_slot, runtime::SizeType32 batch_size,
     runtime::SizeType32 beam_width, runtime::TokenIdType const** bad_words, runtime::SizeType32 const* bad_words_len,
     runtime::SizeType32 max_bad_words_len, runtime::SizeType32 vocab_size_padded,
-    runtime::SizeType32 const* sequence_lengths, runtime::SizeType32 max_seq_len, cudaStream_t stream);
+    runtime::SizeType32 const* sequence_lengths, runtime::SizeType32 max_seq_len, bool const* skip_slots,
+    cudaStream_t stream);
 
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -162,6 +162,158 @@ void invokeBanRepeatNgram(T* logits, TokenIdType const** output_ids_buf, Finishe
     sync_check_cuda_error();
 }
 
+namespace
+{
+constexpr std::uint64_t kEmptyNgramEntry = ~std::uint64_t{0};
+
+__device__ std::uint32_t hash_tokens(TokenIdType const* tokens, SizeType32 length)
+{
+    // FNV-1a over the token ids, followed by the murmur3 finalizer to spread the low bits used as index
+    std::uint32_t hash = 2166136261u;
+    for (SizeType32 idx = 0; idx < length; ++idx)
+    {
+        hash = (hash ^ static_cast<std::uint32_t>(tokens[idx])) * 16777619u;
+    }
+    hash ^= hash >> 16;
+    hash *= 0x85ebca6bu;
+    hash ^= hash >> 13;
+    hash *= 0xc2b2ae35u;
+    hash ^= hash >> 16;
+    return hash;
+}
+
+__device__ bool tokens_equal(TokenIdType const* tokens, SizeType32 lhs, SizeType32 rhs, SizeType32 length)
+{
+    for (SizeType32 idx = 0; idx < length; ++idx)
+    {
+        if (tokens[lhs + idx] != tokens[rhs + idx])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Entries are the hash of the (ngram_size - 1) first tokens of the n-gram in the high bits and its position in the low
+// bits, n-grams with the same first tokens are in the same probe sequence
+__device__ void insert_ngram(std::uint64_t* table, SizeType32 table_capacity, TokenIdType const* tokens,
+    SizeType32 pos, SizeType32 ngram_size)
+{
+    auto const hash = hash_tokens(tokens + pos, ngram_size - 1);
+    auto const entry = (static_cast<std::uint64_t>(hash) << 32) | static_cast<std::uint32_t>(pos);
+    auto const mask = static_cast<std::uint32_t>(table_capacity - 1);
+    for (auto idx = hash & mask;; idx = (idx + 1) & mask)
+    {
+        auto const prev = static_cast<std::uint64_t>(atomicCAS(reinterpret_cast<unsigned long long*>(table + idx),
+            static_cast<unsigned long long>(kEmptyNgramEntry), static_cast<unsigned long long>(entry)));
+        if (prev == kEmptyNgramEntry)
+        {
+            return;
+        }
+        // The n-gram is already in the set
+        if (static_cast<std::uint32_t>(prev >> 32) == hash
+            && tokens_equal(tokens, static_cast<SizeType32>(prev & 0xffffffffu), pos, ngram_size))
+        {
+            return;
+        }
+    }
+}
+} // namespace
+
+template <typename T>
+__global__ void ban_repeat_ngram_hashed(T* logits, TokenIdType const** output_ids_buf,
+    FinishedState const* finished_buf, SizeType32 const* batch_slots, SizeType32 const* sequence_lengths,
+    SizeType32 const* no_repeat_ngram_size_buf, SizeType32 vocab_size_padded, std::uint64_t* ngram_tables,
+    SizeType32* num_indexed_buf, SizeType32 table_capacity)
+{
+    auto const local_batch_idx = static_cast<SizeType32>(blockIdx.x);
+    auto const batch_slot = batch_slots != nullptr ? batch_slots[local_batch_idx] : local_batch_idx;
+    auto const no_repeat_ngram_size = no_repeat_ngram_size_buf[batch_slot];
+    auto const step = sequence_lengths[batch_slot];
+
+    if (no_repeat_ngram_size == 0 || step < no_repeat_ngram_size)
+    {
+        return;
+    }
+    if ((finished_buf != nullptr) && (finished_buf[batch_slot].isFinished()))
+    {
+        return;
+    }
+
+    auto* table = ngram_tables + static_cast<std::size_t>(batch_slot) * table_capacity;
+    auto const* tokens = output_ids_buf[batch_slot];
+    auto num_indexed = num_indexed_buf[batch_slot];
+    if (num_indexed < 0 || num_indexed > step)
+    {
+        for (auto idx = static_cast<SizeType32>(threadIdx.x); idx < table_capacity;
+             idx += static_cast<SizeType32>(blockDim.x))
+        {
+            table[idx] = kEmptyNgramEntry;
+        }
+        num_indexed = 0;
+        __syncthreads();
+    }
+
+    // Add the n-grams ending at the tokens accepted since the last call
+    auto const first_pos = max(0, num_indexed - no_repeat_ngram_size + 1);
+    auto const last_pos = step - no_repeat_ngram_size;
+    for (auto pos = first_pos + static_cast<SizeType32>(threadIdx.x); pos <= last_pos;
+         pos += static_cast<SizeType32>(blockDim.x))
+    {
+        insert_ngram(table, table_capacity, tokens, pos, no_repeat_ngram_size);
+    }
+    __syncthreads();
+
+    if (threadIdx.x == 0)
+    {
+        num_indexed_buf[batch_slot] = step;
+
+        // Ban the continuations of the n-grams starting with the last (ngram_size - 1) tokens
+        auto const prefix_pos = step - no_repeat_ngram_size + 1;
+        auto const prefix_length = no_repeat_ngram_size - 1;
+        auto const hash = hash_tokens(tokens + prefix_pos, prefix_length);
+        auto const mask = static_cast<std::uint32_t>(table_capacity - 1);
+        for (auto idx = hash & mask;; idx = (idx + 1) & mask)
+        {
+            auto const entry = table[idx];
+            if (entry == kEmptyNgramEntry)
+            {
+                break;
+            }
+            auto const pos = static_cast<SizeType32>(entry & 0xffffffffu);
+            if (static_cast<std::uint32_t>(entry >> 32) == hash && tokens_equal(tokens, pos, prefix_pos, prefix_length))
+            {
+                auto const banned_token = tokens[pos + prefix_length];
+                logits[local_batch_idx * vocab_size_padded + banned_token] = static_cast<T>(-INFINITY);
+            }
+        }
+    }
+}
+
+SizeType32 getBanRepeatNgramTableCapacity(SizeType32 max_seq_len)
+{
+    // Power of 2 of at least twice the number of n-grams, probe sequences stay short
+    SizeType32 capacity{64};
+    while (capacity < 2 * max_seq_len)
+    {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+template <typename T>
+void invokeBanRepeatNgramHashed(T* logits, TokenIdType const** output_ids_buf, FinishedState const* finished_buf,
+    SizeType32 const* batch_slot, SizeType32 const* sequence_lengths, SizeType32 batch_size,
+    SizeType32 const* no_repeat_ngram_size_buf, SizeType32 vocab_size_padded, std::uint64_t* ngram_tables,
+    SizeType32* num_indexed_buf, SizeType32 table_capacity, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO((table_capacity & (table_capacity - 1)) == 0, "table_capacity must be a power of 2");
+    constexpr SizeType32 block_size{256};
+    ban_repeat_ngram_hashed<<<batch_size, block_size, 0, stream>>>(logits, output_ids_buf, finished_buf, batch_slot,
+        sequence_lengths, no_repeat_ngram_size_buf, vocab_size_padded, ngram_tables, num_indexed_buf, table_capacity);
+    sync_check_cuda_error();
+}
+
 #define INVOKE_BAN_REPEAT_NGRAM(T)                                                                                     \
     template void invokeBanRepeatNgram(T* logits, TokenIdType const** output_ids_buf,                                  \
         const FinishedState* finished_buf, SizeType32 const** parent_ids_buf, SizeType32 const* batch_slot,            \
@@ -176,6 +328,19 @@ INVOKE_BAN_REPEAT_NGRAM(__nv_bfloat16)
 #endif
 #undef INVOKE_BAN_REPEAT_NGRAM
 
+#define INVOKE_BAN_REPEAT_NGRAM_HASHED(T)                                                                              \
+    template void invokeBanRepeatNgramHashed(T* logits, TokenIdType const** output_ids_buf,                            \
+        FinishedState const* finished_buf, SizeType32 const* batch_slot, SizeType32 const* sequence_lengths,           \
+        SizeType32 batch_size, SizeType32 const* no_repeat_ngram_size_buf, SizeType32 vocab_size_padded,               \
+        std::uint64_t* ngram_tables, SizeType32* num_indexed_buf, SizeType32 table_capacity, cudaStream_t stream);
+
+INVOKE_BAN_REPEAT_NGRAM_HASHED(float)
+INVOKE_BAN_REPEAT_NGRAM_HASHED(half)
+#ifdef ENABLE_BF16
+INVOKE_BAN_REPEAT_NGRAM_HASHED(__nv_bfloat16)
+#endif
+#undef INVOKE_BAN_REPEAT_NGRAM_HASHED
+
 } // namespace kernels
 
 } // namespace tensorrt_llm
@@ -21,6 +21,8 @@
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
 
+#include <cstdint>
+
 namespace tensorrt_llm
 {
 namespace kernels
@@ -33,5 +35,27 @@ void invokeBanRepeatNgram(T* logits, runtime::TokenIdType const** output_ids_buf
     runtime::SizeType32 max_seq_len, runtime::SizeType32 const* no_repeat_ngram_size_buf,
     runtime::SizeType32 vocab_size_padded, runtime::SizeType32 max_step, cudaStream_t stream);
 
+//! \brief Number of entries of the n-gram hash table of a request with at most max_seq_len tokens.
+runtime::SizeType32 getBanRepeatNgramTableCapacity(runtime::SizeType32 max_seq_len);
+
+//! \brief Same as invokeBanRepeatNgram for beam_width 1, with a persistent hash set of the n-grams of each request.
+//! The n-grams ending at the tokens accepted since the last call are added to the set, any number of them, and the
+//! continuations of the last (ngram_size - 1) tokens are looked up, so a step costs O(1) instead of O(sequence length).
+//! Entries point to the position of their n-gram in output_ids_buf and are checked against it, there are no false
+//! bans on hash collisions. The set of a request is rebuilt from its tokens when num_indexed_buf is negative, e.g. for
+//! a new request, or when the sequence got shorter.
+//!
+//! \param ngram_tables input/output buffer [maxBatchSize, table_capacity]. Hash sets of the requests
+//! \param num_indexed_buf input/output buffer [maxBatchSize]. Number of tokens of the request whose n-grams are in its
+//! set, -1 to rebuild the set
+//! \param table_capacity entries of the set of a request, from getBanRepeatNgramTableCapacity
+template <typename T>
+void invokeBanRepeatNgramHashed(T* logits, runtime::TokenIdType const** output_ids_buf,
+    FinishedState const* finished_buf, runtime::SizeType32 const* batch_slot,
+    runtime::SizeType32 const* sequence_lengths, runtime::SizeType32 batch_size,
+    runtime::SizeType32 const* no_repeat_ngram_size_buf, runtime::SizeType32 vocab_size_padded,
+    std::uint64_t* ngram_tables, runtime::SizeType32* num_indexed_buf, runtime::SizeType32 table_capacity,
+    cudaStream_t stream);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,352 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/blockSparseAttentionKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace
+{
+SizeType32 constexpr SUMMARY_BLOCK_SIZE = 128;
+SizeType32 constexpr SELECT_BLOCK_SIZE = 256;
+SizeType32 constexpr ATTENTION_BLOCK_SIZE = 256;
+static_assert(ATTENTION_BLOCK_SIZE >= BLOCK_SPARSE_ATTENTION_MAX_HEAD_SIZE);
+
+//! Sum or max of val over the thread block, returned to all the threads.
+template <bool IS_MAX>
+__device__ float blockAllReduce(float val, float* sWarpReduce)
+{
+    val = IS_MAX ? warpReduceMax(val) : warpReduceSum(val);
+    if (threadIdx.x % 32 == 0)
+    {
+        sWarpReduce[threadIdx.x / 32] = val;
+    }
+    __syncthreads();
+    float result = IS_MAX ? -INFINITY : 0.f;
+    for (unsigned wi = 0; wi < blockDim.x / 32; ++wi)
+    {
+        result = IS_MAX ? fmaxf(result, sWarpReduce[wi]) : result + sWarpReduce[wi];
+    }
+    __syncthreads();
+    return result;
+}
+
+template <typename T>
+__global__ void updateBlockKeySummaries(BlockSparseAttentionParams<T> params, bool onlyFilledBlocks)
+{
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const kvHeadIdx = static_cast<SizeType32>(blockIdx.z);
+    auto const tokensPerBlock = params.kvCache.mTokensPerBlock;
+    auto const seqLength = params.seqLengths[seqIdx];
+
+    SizeType32 kvBlockIdx{0};
+    if (onlyFilledBlocks)
+    {
+        // The last token of the sequence completes its block.
+        if (seqLength == 0 || seqLength % tokensPerBlock != 0)
+        {
+            return;
+        }
+        kvBlockIdx = seqLength / tokensPerBlock - 1;
+    }
+    else
+    {
+        kvBlockIdx = static_cast<SizeType32>(blockIdx.y);
+        if ((kvBlockIdx + 1) * tokensPerBlock > seqLength)
+        {
+            return;
+        }
+    }
+
+    auto const blockBegin = kvBlockIdx * tokensPerBlock;
+    auto const* kBlock = reinterpret_cast<T const*>(params.kvCache.getKBlockPtr(seqIdx, blockBegin));
+    auto* summary = params.blockKeySummaries
+        + ((seqIdx * params.kvCache.mMaxBlocksPerSeq + kvBlockIdx) * params.numKvHeads + kvHeadIdx) * params.headSize;
+    for (auto di = static_cast<SizeType32>(threadIdx.x); di < params.headSize; di += SUMMARY_BLOCK_SIZE)
+    {
+        float sum{0.f};
+        for (SizeType32 ti = 0; ti < tokensPerBlock; ++ti)
+        {
+            sum += static_cast<float>(
+                kBlock[params.kvCache.getKVLocalIdx(blockBegin + ti, kvHeadIdx, params.headSize, di)]);
+        }
+        summary[di] = sum / static_cast<float>(tokensPerBlock);
+    }
+}
+
+//! Picks the blocks attended by the KV head blockIdx.y of the sequence blockIdx.x. The sink blocks come first and the
+//! recent blocks last, so the only partial block is the last selected one.
+template <typename T>
+__global__ void selectBlocks(BlockSparseAttentionParams<T> params)
+{
+    extern __shared__ float sMem[];
+    __shared__ float sWarpScores[SELECT_BLOCK_SIZE / 32];
+    __shared__ SizeType32 sWarpIndices[SELECT_BLOCK_SIZE / 32];
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const kvHeadIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const headSize = params.headSize;
+    auto const headsPerKv = params.numHeads / params.numKvHeads;
+    auto const maxBlocksPerSeq = params.kvCache.mMaxBlocksPerSeq;
+    auto const numBlocks = divUp(params.seqLengths[seqIdx], params.kvCache.mTokensPerBlock);
+    auto const maxSelected = params.getMaxSelectedBlocks();
+    auto const row = seqIdx * params.numKvHeads + kvHeadIdx;
+    auto* selected = params.selectedBlocks + row * maxSelected;
+
+    if (numBlocks <= maxSelected)
+    {
+        for (auto bi = tid; bi < numBlocks; bi += SELECT_BLOCK_SIZE)
+        {
+            selected[bi] = bi;
+        }
+        if (tid == 0)
+        {
+            params.numSelectedBlocks[row] = numBlocks;
+        }
+        return;
+    }
+
+    auto* sQ = sMem;
+    auto* sScores = sMem + headsPerKv * headSize;
+    for (auto idx = tid; idx < headsPerKv * headSize; idx += SELECT_BLOCK_SIZE)
+    {
+        sQ[idx] = static_cast<float>(params.q[(seqIdx * params.numHeads + kvHeadIdx * headsPerKv) * headSize + idx]);
+    }
+    __syncthreads();
+
+    auto const candidateBegin = params.numSinkBlocks;
+    auto const candidateEnd = numBlocks - params.numRecentBlocks;
+    for (auto bi = candidateBegin + tid; bi < candidateEnd; bi += SELECT_BLOCK_SIZE)
+    {
+        auto const* summary
+            = params.blockKeySummaries + ((seqIdx * maxBlocksPerSeq + bi) * params.numKvHeads + kvHeadIdx) * headSize;
+        float score = -INFINITY;
+        for (SizeType32 hi = 0; hi < headsPerKv; ++hi)
+        {
+            float dot{0.f};
+            for (SizeType32 di = 0; di < headSize; ++di)
+            {
+                dot += sQ[hi * headSize + di] * summary[di];
+            }
+            score = fmaxf(score, dot);
+        }
+        sScores[bi] = score;
+    }
+    __syncthreads();
+
+    // One block per round, ties go to the earlier block. Picked blocks are marked with NaN.
+    for (SizeType32 ki = 0; ki < params.topK; ++ki)
+    {
+        float bestScore = -INFINITY;
+        SizeType32 bestIdx = candidateEnd;
+        for (auto bi = candidateBegin + tid; bi < candidateEnd; bi += SELECT_BLOCK_SIZE)
+        {
+            if (!isnan(sScores[bi]) && (bestIdx == candidateEnd || sScores[bi] > bestScore))
+            {
+                bestScore = sScores[bi];
+                bestIdx = bi;
+            }
+        }
+        for (int mask = 16; mask > 0; mask >>= 1)
+        {
+            auto const otherScore = __shfl_xor_sync(FINAL_MASK, bestScore, mask, 32);
+            auto const otherIdx = __shfl_xor_sync(FINAL_MASK, bestIdx, mask, 32);
+            if (otherScore > bestScore || (otherScore == bestScore && otherIdx < bestIdx))
+            {
+                bestScore = otherScore;
+                bestIdx = otherIdx;
+            }
+        }
+        if (tid % 32 == 0)
+        {
+            sWarpScores[tid / 32] = bestScore;
+            sWarpIndices[tid / 32] = bestIdx;
+        }
+        __syncthreads();
+        if (tid == 0)
+        {
+            for (SizeType32 wi = 1; wi < SELECT_BLOCK_SIZE / 32; ++wi)
+            {
+                if (sWarpScores[wi] > bestScore || (sWarpScores[wi] == bestScore && sWarpIndices[wi] < bestIdx))
+                {
+                    bestScore = sWarpScores[wi];
+                    bestIdx = sWarpIndices[wi];
+                }
+            }
+            selected[params.numSinkBlocks + ki] = bestIdx;
+            sScores[bestIdx] = NAN;
+        }
+        __syncthreads();
+    }
+
+    for (auto bi = tid; bi < params.numSinkBlocks; bi += SELECT_BLOCK_SIZE)
+    {
+        selected[bi] = bi;
+    }
+    for (auto bi = tid; bi < params.numRecentBlocks; bi += SELECT_BLOCK_SIZE)
+    {
+        selected[params.numSinkBlocks + params.topK + bi] = candidateEnd + bi;
+    }
+    if (tid == 0)
+    {
+        params.numSelectedBlocks[row] = maxSelected;
+    }
+}
+
+//! Attention of the query of head blockIdx.y of the sequence blockIdx.x over the selected blocks, in tiles of
+//! ATTENTION_BLOCK_SIZE keys with the online softmax. Thread t computes the score of key t of the tile and accumulates
+//! channel t of the output.
+template <typename T>
+__global__ void attendSelectedBlocks(BlockSparseAttentionParams<T> params)
+{
+    extern __shared__ float sQ[];
+    __shared__ float sProbs[ATTENTION_BLOCK_SIZE];
+    __shared__ SizeType32 sTokens[ATTENTION_BLOCK_SIZE];
+    __shared__ float sWarpReduce[ATTENTION_BLOCK_SIZE / 32];
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const headIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const headSize = params.headSize;
+    auto const kvHeadIdx = headIdx / (params.numHeads / params.numKvHeads);
+    auto const tokensPerBlock = params.kvCache.mTokensPerBlock;
+    auto const seqLength = params.seqLengths[seqIdx];
+    auto const row = seqIdx * params.numKvHeads + kvHeadIdx;
+    auto const numSelected = params.numSelectedBlocks[row];
+    auto const* selected = params.selectedBlocks + row * params.getMaxSelectedBlocks();
+    // All the selected blocks are full but the last one, the block of the generated token.
+    auto const numKeys = numSelected > 0
+        ? (numSelected - 1) * tokensPerBlock + seqLength - (divUp(seqLength, tokensPerBlock) - 1) * tokensPerBlock
+        : 0;
+
+    for (auto di = tid; di < headSize; di += ATTENTION_BLOCK_SIZE)
+    {
+        sQ[di] = static_cast<float>(params.q[(seqIdx * params.numHeads + headIdx) * headSize + di]) * params.qkScale;
+    }
+    __syncthreads();
+
+    float runningMax = -INFINITY;
+    float runningSum{0.f};
+    float acc{0.f};
+    for (SizeType32 tileBegin = 0; tileBegin < numKeys; tileBegin += ATTENTION_BLOCK_SIZE)
+    {
+        auto const keyIdx = tileBegin + tid;
+        bool const isValid = keyIdx < numKeys;
+        auto const tokenIdx
+            = isValid ? selected[keyIdx / tokensPerBlock] * tokensPerBlock + keyIdx % tokensPerBlock : 0;
+        float score = -INFINITY;
+        if (isValid)
+        {
+            auto const* kBlock = reinterpret_cast<T const*>(params.kvCache.getKBlockPtr(seqIdx, tokenIdx));
+            auto const kOffset = params.kvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, headSize, 0);
+            score = 0.f;
+            for (SizeType32 di = 0; di < headSize; ++di)
+            {
+                score += sQ[di] * static_cast<float>(kBlock[kOffset + di]);
+            }
+        }
+
+        auto const newMax = fmaxf(runningMax, blockAllReduce<true>(score, sWarpReduce));
+        auto const prob = isValid ? __expf(score - newMax) : 0.f;
+        sProbs[tid] = prob;
+        sTokens[tid] = tokenIdx;
+        auto const tileSum = blockAllReduce<false>(prob, sWarpReduce);
+        auto const correction = runningMax == -INFINITY ? 1.f : __expf(runningMax - newMax);
+        runningSum = runningSum * correction + tileSum;
+        runningMax = newMax;
+
+        if (tid < headSize)
+        {
+            acc *= correction;
+            auto const numTileKeys = min(ATTENTION_BLOCK_SIZE, numKeys - tileBegin);
+            for (SizeType32 ki = 0; ki < numTileKeys; ++ki)
+            {
+                auto const vTokenIdx = sTokens[ki];
+                auto const* vBlock = reinterpret_cast<T const*>(params.kvCache.getVBlockPtr(seqIdx, vTokenIdx));
+                auto const vOffset = params.kvCache.getKVLocalIdx(vTokenIdx, kvHeadIdx, headSize, tid);
+                acc += sProbs[ki] * static_cast<float>(vBlock[vOffset]);
+            }
+        }
+        __syncthreads();
+    }
+
+    if (tid < headSize)
+    {
+        params.out[(seqIdx * params.numHeads + headIdx) * headSize + tid]
+            = static_cast<T>(runningSum > 0.f ? acc / runningSum : 0.f);
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeUpdateBlockKeySummaries(BlockSparseAttentionParams<T> const& params, bool onlyFilledBlocks,
+    cudaStream_t stream)
+{
+    TLLM_CHECK(params.blockKeySummaries);
+    TLLM_CHECK(params.seqLengths);
+    dim3 const grid(params.numSeqs, onlyFilledBlocks ? 1 : params.kvCache.mMaxBlocksPerSeq, params.numKvHeads);
+    updateBlockKeySummaries<T><<<grid, SUMMARY_BLOCK_SIZE, 0, stream>>>(params, onlyFilledBlocks);
+}
+
+template <typename T>
+void invokeBlockSparseAttention(BlockSparseAttentionParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    {
+        dim3 const grid(params.numSeqs, params.numKvHeads);
+        auto const smemSize
+            = (params.numHeads / params.numKvHeads * params.headSize + params.kvCache.mMaxBlocksPerSeq) * sizeof(float);
+        if (smemSize >= (48 << 10))
+        {
+            TLLM_CUDA_CHECK(
+                cudaFuncSetAttribute(selectBlocks<T>, cudaFuncAttributeMaxDynamicSharedMemorySize, smemSize));
+        }
+        selectBlocks<T><<<grid, SELECT_BLOCK_SIZE, smemSize, stream>>>(params);
+    }
+    {
+        dim3 const grid(params.numSeqs, params.numHeads);
+        auto const smemSize = params.headSize * sizeof(float);
+        attendSelectedBlocks<T><<<grid, ATTENTION_BLOCK_SIZE, smemSize, stream>>>(params);
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+#define INSTANTIATE_BLOCK_SPARSE_ATTENTION(T)                                                                          \
+    template void invokeUpdateBlockKeySummaries(                                                                       \
+        BlockSparseAttentionParams<T> const& params, bool onlyFilledBlocks, cudaStream_t stream);                      \
+    template void invokeBlockSparseAttention(BlockSparseAttentionParams<T> const& params, cudaStream_t stream)
+
+INSTANTIATE_BLOCK_SPARSE_ATTENTION(float);
+INSTANTIATE_BLOCK_SPARSE_ATTENTION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_BLOCK_SPARSE_ATTENTION(__nv_bfloat16);
+#endif
+#undef INSTANTIATE_BLOCK_SPARSE_ATTENTION
+} // namespace kernels
+} // namespace tensorrt_llm
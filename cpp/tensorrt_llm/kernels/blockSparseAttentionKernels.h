@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+//! Largest head size supported by the block-sparse attention kernels.
+static constexpr runtime::SizeType32 BLOCK_SPARSE_ATTENTION_MAX_HEAD_SIZE = 256;
+
+template <typename T>
+struct BlockSparseAttentionParams
+{
+    //! input buffer [numSeqs, numHeads, headSize], required. Queries of the generated token, after the position
+    //! embedding.
+    T const* q{nullptr};
+    //! input buffer [numSeqs], required. Number of tokens in the KV cache of each sequence, including the generated
+    //! token.
+    runtime::SizeType32 const* seqLengths{nullptr};
+    //! Paged KV cache of type T, without sliding window.
+    KVBlockArray kvCache;
+
+    //! buffer [numSeqs, maxBlocksPerSeq, numKvHeads, headSize], required. Mean key of each full block of each
+    //! sequence, written by invokeUpdateBlockKeySummaries. Entries of blocks which are not full are not read.
+    float* blockKeySummaries{nullptr};
+    //! workspace [numSeqs, numKvHeads, getMaxSelectedBlocks()], required. Indices of the attended blocks.
+    runtime::SizeType32* selectedBlocks{nullptr};
+    //! workspace [numSeqs, numKvHeads], required. Number of attended blocks.
+    runtime::SizeType32* numSelectedBlocks{nullptr};
+    //! output buffer [numSeqs, numHeads, headSize], required.
+    T* out{nullptr};
+
+    runtime::SizeType32 numSeqs{0};
+    runtime::SizeType32 numHeads{0};
+    runtime::SizeType32 numKvHeads{0};
+    runtime::SizeType32 headSize{0};
+    //! Scale of the scores, usually 1 / sqrt(headSize).
+    float qkScale{1.f};
+
+    //! Blocks at the start of each sequence which are always attended.
+    runtime::SizeType32 numSinkBlocks{1};
+    //! Blocks at the end of each sequence which are always attended, including the block of the generated token.
+    runtime::SizeType32 numRecentBlocks{1};
+    //! Blocks between the sink and the recent blocks with the highest summary scores which are attended.
+    runtime::SizeType32 topK{0};
+
+    __host__ __device__ [[nodiscard]] runtime::SizeType32 getMaxSelectedBlocks() const
+    {
+        return numSinkBlocks + topK + numRecentBlocks;
+    }
+
+    void checkParams() const
+    {
+        TLLM_CHECK(numSeqs > 0);
+        TLLM_CHECK(numKvHeads > 0 && numHeads % numKvHeads == 0);
+        TLLM_CHECK(0 < headSize && headSize <= BLOCK_SPARSE_ATTENTION_MAX_HEAD_SIZE);
+        TLLM_CHECK(numSinkBlocks >= 0 && topK >= 0);
+        TLLM_CHECK_WITH_INFO(numRecentBlocks > 0, "The block of the generated token is always attended.");
+        TLLM_CHECK(q);
+        TLLM_CHECK(seqLengths);
+        TLLM_CHECK(blockKeySummaries);
+        TLLM_CHECK(selectedBlocks);
+        TLLM_CHECK(numSelectedBlocks);
+        TLLM_CHECK(out);
+    }
+};
+
+//! \brief Computes the mean key of the full blocks of each sequence into params.blockKeySummaries.
+//! \param onlyFilledBlocks when true, only summarizes the block completed by the last token of each sequence, which
+//! keeps the summaries up to date when called after each generation step. When false, summarizes all the full blocks,
+//! e.g. after the context phase.
+template <typename T>
+void invokeUpdateBlockKeySummaries(BlockSparseAttentionParams<T> const& params, bool onlyFilledBlocks,
+    cudaStream_t stream);
+
+//! \brief Generation attention over a subset of the KV cache blocks of each sequence. For each KV head, the blocks
+//! between the sink and the recent blocks are scored with the largest dot product of the queries of the head group
+//! with the block key summaries, and only the sink blocks, the params.topK best blocks and the recent blocks are
+//! attended. Sequences with no more than params.getMaxSelectedBlocks() blocks get the full attention.
+template <typename T>
+void invokeBlockSparseAttention(BlockSparseAttentionParams<T> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/cascadeAttentionKernels.h"
+
+#include <algorithm>
+#include <numeric>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+SharedPrefixGroups buildSharedPrefixGroups(KVCacheIndex const* hostBlockOffsets, SizeType32 const* hostSeqLengths,
+    SizeType32 numSeqs, SizeType32 maxBlocksPerSeq, SizeType32 tokensPerBlock, SizeType32 minPrefixBlocks)
+{
+    TLLM_CHECK(minPrefixBlocks > 0);
+    TLLM_CHECK(tokensPerBlock > 0);
+
+    SharedPrefixGroups groups;
+    groups.groupOffsets.push_back(0);
+    groups.seqPrefixLengths.assign(numSeqs, 0);
+
+    // The K offsets come first in the row of each sequence.
+    auto const getBlock = [&](SizeType32 seqIdx, SizeType32 blockIdx)
+    { return hostBlockOffsets[seqIdx * maxBlocksPerSeq * 2 + blockIdx]; };
+    auto const isSameBlock = [](KVCacheIndex const& lhs, KVCacheIndex const& rhs)
+    { return lhs.get() == rhs.get() && lhs.isPrimary() == rhs.isPrimary(); };
+    // Only full blocks are shared, and the generated token is always in the suffix.
+    auto const getMaxPrefixBlocks = [&](SizeType32 seqIdx)
+    { return std::min(maxBlocksPerSeq, std::max(hostSeqLengths[seqIdx] - 1, 0) / tokensPerBlock); };
+
+    std::vector<SizeType32> candidates;
+    for (SizeType32 si = 0; si < numSeqs; ++si)
+    {
+        if (getMaxPrefixBlocks(si) >= minPrefixBlocks)
+        {
+            candidates.push_back(si);
+        }
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [&](SizeType32 lhs, SizeType32 rhs)
+        {
+            auto const lhsBlock = getBlock(lhs, 0);
+            auto const rhsBlock = getBlock(rhs, 0);
+            return lhsBlock.isPrimary() != rhsBlock.isPrimary() ? lhsBlock.isPrimary()
+                                                                : lhsBlock.get() < rhsBlock.get();
+        });
+
+    for (size_t begin = 0; begin < candidates.size();)
+    {
+        auto end = begin + 1;
+        while (end < candidates.size() && isSameBlock(getBlock(candidates[begin], 0), getBlock(candidates[end], 0)))
+        {
+            ++end;
+        }
+        if (end - begin > 1)
+        {
+            // The prefix of the group is the longest one shared by all its sequences.
+            auto const leader = candidates[begin];
+            auto numBlocks = getMaxPrefixBlocks(leader);
+            for (auto ci = begin + 1; ci < end; ++ci)
+            {
+                auto const seqIdx = candidates[ci];
+                numBlocks = std::min(numBlocks, getMaxPrefixBlocks(seqIdx));
+                SizeType32 numShared = 1;
+                while (numShared < numBlocks && isSameBlock(getBlock(leader, numShared), getBlock(seqIdx, numShared)))
+                {
+                    ++numShared;
+                }
+                numBlocks = numShared;
+            }
+            if (numBlocks >= minPrefixBlocks)
+            {
+                auto const prefixLength = numBlocks * tokensPerBlock;
+                for (auto ci = begin; ci < end; ++ci)
+                {
+                    groups.groupSeqIndices.push_back(candidates[ci]);
+                    groups.seqPrefixLengths[candidates[ci]] = prefixLength;
+                }
+                groups.groupOffsets.push_back(static_cast<SizeType32>(groups.groupSeqIndices.size()));
+                groups.groupPrefixLengths.push_back(prefixLength);
+            }
+        }
+        begin = end;
+    }
+    return groups;
+}
+
+namespace
+{
+SizeType32 constexpr ATTENTION_BLOCK_SIZE = 256;
+//! Queries of a group attending the prefix in one block, they share the loads of the KV cache.
+SizeType32 constexpr PREFIX_QUERIES_PER_BLOCK = 8;
+
+//! Attention of Q_PER_BLOCK queries over the keys [kvBegin, kvEnd) of one sequence, in tiles of
+//! ATTENTION_BLOCK_SIZE / Q_PER_BLOCK keys with the online softmax. Thread (q, t) of the tile computes the score of
+//! key t for query q. Writes the normalized output and the log-sum-exp of each query to the partial buffers of pass
+//! PREFIX ? 0 : 1.
+template <typename T, SizeType32 Q_PER_BLOCK, bool PREFIX>
+__global__ void attendKvRange(CascadeAttentionParams<T> params)
+{
+    SizeType32 constexpr TILE_SIZE = ATTENTION_BLOCK_SIZE / Q_PER_BLOCK;
+    SizeType32 constexpr WARPS_PER_QUERY = TILE_SIZE / 32;
+    static_assert(TILE_SIZE % 32 == 0);
+
+    extern __shared__ float sMem[];
+    __shared__ float sProbs[ATTENTION_BLOCK_SIZE];
+    __shared__ float sWarpReduce[ATTENTION_BLOCK_SIZE / 32];
+    __shared__ float sMax[Q_PER_BLOCK];
+    __shared__ float sSum[Q_PER_BLOCK];
+    __shared__ float sCorrection[Q_PER_BLOCK];
+    __shared__ SizeType32 sSeqIndices[Q_PER_BLOCK];
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const headIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const headSize = params.headSize;
+    auto const kvHeadIdx = headIdx / (params.numHeads / params.numKvHeads);
+    auto* sQ = sMem;
+    auto* sAcc = sMem + Q_PER_BLOCK * headSize;
+
+    SizeType32 kvSeqIdx{0};
+    SizeType32 kvBegin{0};
+    SizeType32 kvEnd{0};
+    SizeType32 numQueries{1};
+    SizeType32 const* seqIndices{nullptr};
+    if constexpr (PREFIX)
+    {
+        auto const groupIdx = static_cast<SizeType32>(blockIdx.x);
+        auto const groupBegin = params.groupOffsets[groupIdx];
+        auto const queryBegin = groupBegin + static_cast<SizeType32>(blockIdx.z) * Q_PER_BLOCK;
+        numQueries = min(Q_PER_BLOCK, params.groupOffsets[groupIdx + 1] - queryBegin);
+        if (numQueries <= 0)
+        {
+            return;
+        }
+        kvSeqIdx = params.groupSeqIndices[groupBegin];
+        kvEnd = params.groupPrefixLengths[groupIdx];
+        seqIndices = params.groupSeqIndices + queryBegin;
+    }
+    else
+    {
+        kvSeqIdx = static_cast<SizeType32>(blockIdx.x);
+        kvBegin = params.seqPrefixLengths[kvSeqIdx];
+        kvEnd = params.seqLengths[kvSeqIdx];
+        seqIndices = &kvSeqIdx;
+    }
+    auto const passOffset = PREFIX ? 0 : params.numSeqs;
+
+    if (tid < Q_PER_BLOCK)
+    {
+        sSeqIndices[tid] = tid < numQueries ? seqIndices[tid] : 0;
+        sMax[tid] = -INFINITY;
+        sSum[tid] = 0.f;
+    }
+    __syncthreads();
+    for (auto idx = tid; idx < numQueries * headSize; idx += ATTENTION_BLOCK_SIZE)
+    {
+        auto const qi = idx / headSize;
+        auto const di = idx % headSize;
+        sQ[idx] = static_cast<float>(params.q[(sSeqIndices[qi] * params.numHeads + headIdx) * headSize + di])
+            * params.qkScale;
+        sAcc[idx] = 0.f;
+    }
+    __syncthreads();
+
+    auto const queryIdx = tid / TILE_SIZE;
+    auto const keyIdx = tid % TILE_SIZE;
+    auto const warpIdx = tid / 32;
+    for (auto tileBegin = kvBegin; tileBegin < kvEnd; tileBegin += TILE_SIZE)
+    {
+        auto const tokenIdx = tileBegin + keyIdx;
+        bool const isValid = queryIdx < numQueries && tokenIdx < kvEnd;
+        float score = -INFINITY;
+        if (isValid)
+        {
+            auto const* kBlock = reinterpret_cast<T const*>(params.kvCache.getKBlockPtr(kvSeqIdx, tokenIdx));
+            auto const kOffset = params.kvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, headSize, 0);
+            score = 0.f;
+            for (SizeType32 di = 0; di < headSize; ++di)
+            {
+                score += sQ[queryIdx * headSize + di] * static_cast<float>(kBlock[kOffset + di]);
+            }
+        }
+
+        auto const warpMax = warpReduceMax(score);
+        if (tid % 32 == 0)
+        {
+            sWarpReduce[warpIdx] = warpMax;
+        }
+        __syncthreads();
+        float tileMax = -INFINITY;
+        for (SizeType32 wi = 0; wi < WARPS_PER_QUERY; ++wi)
+        {
+            tileMax = fmaxf(tileMax, sWarpReduce[queryIdx * WARPS_PER_QUERY + wi]);
+        }
+        auto const prevMax = sMax[queryIdx];
+        auto const newMax = fmaxf(prevMax, tileMax);
+        auto const prob = isValid ? __expf(score - newMax) : 0.f;
+        sProbs[tid] = prob;
+        __syncthreads();
+
+        auto const warpSum = warpReduceSum(prob);
+        if (tid % 32 == 0)
+        {
+            sWarpReduce[warpIdx] = warpSum;
+        }
+        __syncthreads();
+        if (keyIdx == 0 && queryIdx < numQueries)
+        {
+            float tileSum = 0.f;
+            for (SizeType32 wi = 0; wi < WARPS_PER_QUERY; ++wi)
+            {
+                tileSum += sWarpReduce[queryIdx * WARPS_PER_QUERY + wi];
+            }
+            auto const correction = newMax == -INFINITY ? 1.f : __expf(prevMax - newMax);
+            sSum[queryIdx] = sSum[queryIdx] * correction + tileSum;
+            sMax[queryIdx] = newMax;
+            sCorrection[queryIdx] = correction;
+        }
+        __syncthreads();
+
+        auto const numTileKeys = min(TILE_SIZE, kvEnd - tileBegin);
+        for (auto idx = tid; idx < numQueries * headSize; idx += ATTENTION_BLOCK_SIZE)
+        {
+            auto const qi = idx / headSize;
+            auto const di = idx % headSize;
+            auto acc = sAcc[idx] * sCorrection[qi];
+            for (SizeType32 ki = 0; ki < numTileKeys; ++ki)
+            {
+                auto const vTokenIdx = tileBegin + ki;
+                auto const* vBlock = reinterpret_cast<T const*>(params.kvCache.getVBlockPtr(kvSeqIdx, vTokenIdx));
+                acc += sProbs[qi * TILE_SIZE + ki]
+                    * static_cast<float>(vBlock[params.kvCache.getKVLocalIdx(vTokenIdx, kvHeadIdx, headSize, di)]);
+            }
+            sAcc[idx] = acc;
+        }
+        __syncthreads();
+    }
+
+    for (auto idx = tid; idx < numQueries * headSize; idx += ATTENTION_BLOCK_SIZE)
+    {
+        auto const qi = idx / headSize;
+        auto const di = idx % headSize;
+        auto const row = (passOffset + sSeqIndices[qi]) * params.numHeads + headIdx;
+        auto const sum = sSum[qi];
+        params.partialOut[row * headSize + di] = sum > 0.f ? sAcc[idx] / sum : 0.f;
+        if (di == 0)
+        {
+            params.partialLse[row] = sum > 0.f ? sMax[qi] + __logf(sum) : -INFINITY;
+        }
+    }
+
+    if constexpr (!PREFIX)
+    {
+        // Sequences without a shared prefix have no prefix pass, give them an empty prefix for the merge.
+        if (kvBegin == 0)
+        {
+            auto const row = kvSeqIdx * params.numHeads + headIdx;
+            for (auto di = tid; di < headSize; di += ATTENTION_BLOCK_SIZE)
+            {
+                params.partialOut[row * headSize + di] = 0.f;
+            }
+            if (tid == 0)
+            {
+                params.partialLse[row] = -INFINITY;
+            }
+        }
+    }
+}
+
+template <typename T>
+__global__ void mergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB,
+    T* out, SizeType32 headSize)
+{
+    auto const row = static_cast<SizeType32>(blockIdx.x);
+    auto const maxLse = fmaxf(lseA[row], lseB[row]);
+    auto const weightA = maxLse == -INFINITY ? 0.f : __expf(lseA[row] - maxLse);
+    auto const weightB = maxLse == -INFINITY ? 0.f : __expf(lseB[row] - maxLse);
+    auto const sum = weightA + weightB;
+    auto const scaleA = sum > 0.f ? weightA / sum : 0.f;
+    auto const scaleB = sum > 0.f ? weightB / sum : 0.f;
+    for (auto di = static_cast<SizeType32>(threadIdx.x); di < headSize; di += static_cast<SizeType32>(blockDim.x))
+    {
+        auto const idx = row * headSize + di;
+        out[idx] = static_cast<T>(scaleA * outA[idx] + scaleB * outB[idx]);
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeMergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB, T* out,
+    SizeType32 numRows, SizeType32 headSize, cudaStream_t stream)
+{
+    SizeType32 constexpr BLOCK_SIZE = 128;
+    mergeAttentionStates<T><<<numRows, BLOCK_SIZE, 0, stream>>>(outA, lseA, outB, lseB, out, headSize);
+}
+
+template <typename T>
+void invokeCascadeAttention(CascadeAttentionParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    if (params.numGroups > 0)
+    {
+        dim3 const grid(params.numGroups, params.numHeads, divUp(params.maxGroupSize, PREFIX_QUERIES_PER_BLOCK));
+        auto const smemSize = 2 * PREFIX_QUERIES_PER_BLOCK * params.headSize * sizeof(float);
+        attendKvRange<T, PREFIX_QUERIES_PER_BLOCK, true>
+            <<<grid, ATTENTION_BLOCK_SIZE, smemSize, stream>>>(params);
+    }
+    {
+        dim3 const grid(params.numSeqs, params.numHeads);
+        auto const smemSize = 2 * params.headSize * sizeof(float);
+        attendKvRange<T, 1, false><<<grid, ATTENTION_BLOCK_SIZE, smemSize, stream>>>(params);
+    }
+
+    auto const numRows = params.numSeqs * params.numHeads;
+    auto const passSize = numRows * params.headSize;
+    invokeMergeAttentionStates(params.partialOut, params.partialLse, params.partialOut + passSize,
+        params.partialLse + numRows, params.out, numRows, params.headSize, stream);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeCascadeAttention(CascadeAttentionParams<float> const& params, cudaStream_t stream);
+template void invokeCascadeAttention(CascadeAttentionParams<half> const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeCascadeAttention(CascadeAttentionParams<__nv_bfloat16> const& params, cudaStream_t stream);
+#endif
+
+template void invokeMergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB,
+    float* out, SizeType32 numRows, SizeType32 headSize, cudaStream_t stream);
+template void invokeMergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB,
+    half* out, SizeType32 numRows, SizeType32 headSize, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeMergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB,
+    __nv_bfloat16* out, SizeType32 numRows, SizeType32 headSize, cudaStream_t stream);
+#endif
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+#include <vector>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+//! Largest head size supported by the cascade attention kernels.
+static constexpr runtime::SizeType32 CASCADE_ATTENTION_MAX_HEAD_SIZE = 256;
+
+//! \brief Sequences of the batch whose KV cache starts with the same blocks of the pool, e.g. a system prompt shared
+//! through block reuse. Sequences that share no block with another one are not part of any group.
+struct SharedPrefixGroups
+{
+    //! [numGroups + 1], groupSeqIndices[groupOffsets[g], groupOffsets[g + 1]) are the sequences of group g.
+    std::vector<runtime::SizeType32> groupOffsets;
+    //! [numGroupedSeqs], indices of the sequences in the KV cache block array.
+    std::vector<runtime::SizeType32> groupSeqIndices;
+    //! [numGroups], number of tokens of the shared prefix, a multiple of the tokens per block.
+    std::vector<runtime::SizeType32> groupPrefixLengths;
+    //! [numSeqs], length of the shared prefix of each sequence, 0 for sequences that are not grouped.
+    std::vector<runtime::SizeType32> seqPrefixLengths;
+
+    [[nodiscard]] runtime::SizeType32 getNumGroups() const
+    {
+        return static_cast<runtime::SizeType32>(groupPrefixLengths.size());
+    }
+};
+
+//! \brief Groups the sequences by the blocks at the start of their KV cache.
+//! \param hostBlockOffsets host buffer [numSeqs, 2, maxBlocksPerSeq], block offsets of the K and V caches of each
+//! sequence, as in KVBlockArray. Two sequences share a block when their K offsets are equal.
+//! \param hostSeqLengths host buffer [numSeqs], number of tokens in the KV cache of each sequence, including the
+//! generated token.
+//! \param minPrefixBlocks shortest prefix worth sharing. The prefix always leaves at least one token of each sequence
+//! to the suffix.
+SharedPrefixGroups buildSharedPrefixGroups(KVCacheIndex const* hostBlockOffsets,
+    runtime::SizeType32 const* hostSeqLengths, runtime::SizeType32 numSeqs, runtime::SizeType32 maxBlocksPerSeq,
+    runtime::SizeType32 tokensPerBlock, runtime::SizeType32 minPrefixBlocks);
+
+template <typename T>
+struct CascadeAttentionParams
+{
+    //! input buffer [numSeqs, numHeads, headSize], required. Queries of the generated token, after the position
+    //! embedding.
+    T const* q{nullptr};
+    //! input buffer [numSeqs], required. Number of tokens in the KV cache of each sequence, including the generated
+    //! token.
+    runtime::SizeType32 const* seqLengths{nullptr};
+    //! input buffers, required if numGroups > 0. Device copies of the members of SharedPrefixGroups.
+    runtime::SizeType32 const* groupOffsets{nullptr};
+    runtime::SizeType32 const* groupSeqIndices{nullptr};
+    runtime::SizeType32 const* groupPrefixLengths{nullptr};
+    //! input buffer [numSeqs], required.
+    runtime::SizeType32 const* seqPrefixLengths{nullptr};
+    //! Paged KV cache of type T, without sliding window.
+    KVBlockArray kvCache;
+
+    //! workspace [2, numSeqs, numHeads, headSize], required. Normalized outputs of the prefix and of the suffix.
+    float* partialOut{nullptr};
+    //! workspace [2, numSeqs, numHeads], required. Log-sum-exp of the scores of the prefix and of the suffix.
+    float* partialLse{nullptr};
+    //! output buffer [numSeqs, numHeads, headSize], required.
+    T* out{nullptr};
+
+    runtime::SizeType32 numSeqs{0};
+    runtime::SizeType32 numGroups{0};
+    //! Largest number of sequences in a group.
+    runtime::SizeType32 maxGroupSize{0};
+    runtime::SizeType32 numHeads{0};
+    runtime::SizeType32 numKvHeads{0};
+    runtime::SizeType32 headSize{0};
+    //! Scale of the scores, usually 1 / sqrt(headSize).
+    float qkScale{1.f};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(numSeqs > 0);
+        TLLM_CHECK(numGroups >= 0);
+        TLLM_CHECK(numGroups == 0 || (maxGroupSize > 1 && groupOffsets && groupSeqIndices && groupPrefixLengths));
+        TLLM_CHECK(numKvHeads > 0 && numHeads % numKvHeads == 0);
+        TLLM_CHECK(0 < headSize && headSize <= CASCADE_ATTENTION_MAX_HEAD_SIZE);
+        TLLM_CHECK(q);
+        TLLM_CHECK(seqLengths);
+        TLLM_CHECK(seqPrefixLengths);
+        TLLM_CHECK(partialOut);
+        TLLM_CHECK(partialLse);
+        TLLM_CHECK(out);
+    }
+};
+
+//! \brief Generation attention which reads the KV cache of a shared prefix once per group of sequences. The queries
+//! of a group attend the prefix blocks together, each sequence then attends its own suffix, and the two normalized
+//! outputs are merged with their log-sum-exp. Sequences without a shared prefix only run the suffix pass.
+template <typename T>
+void invokeCascadeAttention(CascadeAttentionParams<T> const& params, cudaStream_t stream);
+
+//! \brief Merges two attention outputs over disjoint sets of keys.
+//! \param outA, outB input buffers [numRows, headSize], outputs normalized over their own keys.
+//! \param lseA, lseB input buffers [numRows], log-sum-exp of the scores of their keys, -inf for no key.
+//! \param out output buffer [numRows, headSize], the output over the union of the keys.
+template <typename T>
+void invokeMergeAttentionStates(float const* outA, float const* lseA, float const* outB, float const* lseB, T* out,
+    runtime::SizeType32 numRows, runtime::SizeType32 headSize, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
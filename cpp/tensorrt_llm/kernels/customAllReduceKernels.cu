@@ -241,6 +241,132 @@ inline __device__ int4 rms_norm(float denom, PackedStruct& vec, PackedStruct& we
     return ret.packed;
 }
 
+// Unpermutes the expert outputs of one row and does the k-way reduction, like finalizeMoeRoutingKernel in
+// mixtureOfExperts/moe_kernels.cu
+template <typename T>
+inline __device__ int4 moe_finalize(MoeFinalizeFusionParams const& moe, int64_t row, int64_t num_rows, int hidden_size,
+    int offset)
+{
+    static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
+    using PackedStruct = typename PackedOn16Bytes<T>::Type;
+
+    T const* permuted_rows = reinterpret_cast<T const*>(moe.permuted_rows);
+    T const* bias = reinterpret_cast<T const*>(moe.bias);
+
+    float acc[kPackedSize] = {};
+    float scale_sum = 0.f;
+    bool has_valid = false;
+    for (int k_idx = 0; k_idx < moe.k; ++k_idx)
+    {
+        int64_t const permuted_row = moe.source_to_permuted_row[row + k_idx * num_rows];
+        float const scale = moe.scales[row * moe.k + k_idx];
+        scale_sum += scale;
+        if (moe.num_valid_rows && permuted_row >= *moe.num_valid_rows)
+        {
+            continue;
+        }
+
+        PackedStruct vals, bias_vals;
+        vals.packed = *reinterpret_cast<int4 const*>(permuted_rows + permuted_row * hidden_size + offset);
+        if (bias)
+        {
+            int64_t const expert = moe.experts[row * moe.k + k_idx];
+            bias_vals.packed = *reinterpret_cast<int4 const*>(bias + expert * hidden_size + offset);
+        }
+#pragma unroll
+        for (int i = 0; i < kPackedSize; ++i)
+        {
+            float v = static_cast<float>(reinterpret_cast<T*>(vals.unpacked)[i]);
+            if (bias)
+            {
+                v += static_cast<float>(reinterpret_cast<T*>(bias_vals.unpacked)[i]);
+            }
+            acc[i] += scale * v;
+        }
+        has_valid = true;
+    }
+
+    float const rescale = (moe.renormalize && has_valid) ? __fdividef(1.f, scale_sum) : 1.f;
+    PackedStruct ret;
+#pragma unroll
+    for (int i = 0; i < kPackedSize; ++i)
+    {
+        reinterpret_cast<T*>(ret.unpacked)[i] = static_cast<T>(acc[i] * rescale);
+    }
+    return ret.packed;
+}
+
+template <typename T>
+__global__ void moe_finalize_kernel(AllReduceParams params)
+{
+    static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
+    int const hidden_size = params.fusion_params.hidden_size;
+    int64_t const num_rows = params.elts_total / hidden_size;
+    T* output = reinterpret_cast<T*>(params.local_output_buffer_ptr) + blockIdx.x * hidden_size;
+    for (int offset = threadIdx.x * kPackedSize; offset < hidden_size; offset += blockDim.x * kPackedSize)
+    {
+        *reinterpret_cast<int4*>(&output[offset])
+            = moe_finalize<T>(params.fusion_params.moe_finalize, blockIdx.x, num_rows, hidden_size, offset);
+    }
+}
+
+template <typename T>
+void moe_finalize_kernel_launcher(AllReduceParams params, cudaStream_t stream)
+{
+    static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
+    TLLM_CHECK(params.fusion_params.hidden_size % kPackedSize == 0);
+    int need_threads = params.fusion_params.hidden_size / kPackedSize;
+    int cta_size = std::min(roundUp(need_threads, details::kWarpSize), details::kMaxCtaSize);
+    int cta_num = params.elts_total / params.fusion_params.hidden_size;
+    moe_finalize_kernel<T><<<cta_num, cta_size, 0, stream>>>(params);
+}
+
+// Gathers the embedding of one token into the shareable buffer, like lookup_kernel in lookupKernels.cu
+template <typename T>
+__global__ void embedding_lookup_kernel(AllReduceParams params)
+{
+    static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
+    EmbeddingLookupFusionParams const& lookup = params.fusion_params.embedding_lookup;
+    int const hidden_size = params.fusion_params.hidden_size;
+    int64_t const row = blockIdx.x;
+    T* output = reinterpret_cast<T*>(params.peer_comm_buffer_ptrs[params.local_rank]) + row * hidden_size;
+
+    int const id = lookup.input_ids[row];
+    T const* embedding = nullptr;
+    if (lookup.prompt_table != nullptr && id >= lookup.vocab_size)
+    {
+        if (lookup.vocab_start == 0)
+        {
+            int64_t const prompt_row = static_cast<int64_t>(lookup.tasks[row]) * *lookup.task_vocab_size + id
+                - lookup.vocab_size;
+            embedding = reinterpret_cast<T const*>(lookup.prompt_table) + prompt_row * hidden_size;
+        }
+    }
+    else if (id >= lookup.vocab_start && id < lookup.vocab_start + lookup.local_vocab_size)
+    {
+        embedding
+            = reinterpret_cast<T const*>(lookup.weight) + static_cast<int64_t>(id - lookup.vocab_start) * hidden_size;
+    }
+
+    for (int offset = threadIdx.x * kPackedSize; offset < hidden_size; offset += blockDim.x * kPackedSize)
+    {
+        *reinterpret_cast<int4*>(&output[offset]) = embedding != nullptr
+            ? *reinterpret_cast<int4 const*>(&embedding[offset])
+            : make_int4(0, 0, 0, 0);
+    }
+}
+
+template <typename T>
+void embedding_lookup_kernel_launcher(AllReduceParams params, cudaStream_t stream)
+{
+    static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
+    TLLM_CHECK(params.fusion_params.hidden_size % kPackedSize == 0);
+    int need_threads = params.fusion_params.hidden_size / kPackedSize;
+    int cta_size = std::min(roundUp(need_threads, details::kWarpSize), details::kMaxCtaSize);
+    int cta_num = params.elts_total / params.fusion_params.hidden_size;
+    embedding_lookup_kernel<T><<<cta_num, cta_size, 0, stream>>>(params);
+}
+
 template <typename T, bool Bias = false, bool Residual = false, bool Affine = false, bool UseSmem = false>
 __global__ void rms_norm_kernel(AllReduceParams params)
 {
@@ -337,7 +463,8 @@ void rms_norm_kernel_launcher(AllReduceParams params, cudaStream_t stream)
     }
 }
 
-template <typename T, int RanksPerNode, bool Bias = false, bool Affine = false, bool UseSmem = false>
+template <typename T, int RanksPerNode, bool Bias = false, bool Affine = false, bool UseSmem = false,
+    bool MoeFinalize = false>
 static __global__ void __launch_bounds__(1024, 1) one_shot_all_reduce_norm_kernel(AllReduceParams params)
 {
     static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
@@ -362,7 +489,10 @@ static __global__ void __launch_bounds__(1024, 1) one_shot_all_reduce_norm_kerne
     int block_offset = bid * norm_per_block * params.fusion_params.hidden_size;
     int thread_offset = tid * kPackedSize;
 
-    local_input_buffer += block_offset;
+    if constexpr (!MoeFinalize)
+    {
+        local_input_buffer += block_offset;
+    }
     residual_buffer += block_offset;
     local_shared_buffer += block_offset;
     local_final_output_buffer += block_offset;
@@ -378,8 +508,19 @@ static __global__ void __launch_bounds__(1024, 1) one_shot_all_reduce_norm_kerne
     for (int offset = thread_offset; offset < norm_this_block * params.fusion_params.hidden_size;
          offset += blockDim.x * kPackedSize)
     {
-        *reinterpret_cast<int4*>(&local_shared_buffer[offset])
-            = *reinterpret_cast<int4 const*>(&local_input_buffer[offset]);
+        if constexpr (MoeFinalize)
+        {
+            // Reduce the expert outputs straight into the shareable buffer
+            int const hidden_size = params.fusion_params.hidden_size;
+            *reinterpret_cast<int4*>(&local_shared_buffer[offset])
+                = moe_finalize<T>(params.fusion_params.moe_finalize, bid * norm_per_block + offset / hidden_size,
+                    norm_num, hidden_size, offset % hidden_size);
+        }
+        else
+        {
+            *reinterpret_cast<int4*>(&local_shared_buffer[offset])
+                = *reinterpret_cast<int4 const*>(&local_input_buffer[offset]);
+        }
     }
     block_barrier(
         params.peer_barrier_ptrs_in, params.barrier_flag, params.local_rank, RanksPerNode, tid, bid, gridDim.x);
@@ -437,7 +578,7 @@ static __global__ void __launch_bounds__(1024, 1) one_shot_all_reduce_norm_kerne
     }
 }
 
-template <typename T, int RanksPerNode, bool Bias, bool Affine>
+template <typename T, int RanksPerNode, bool Bias, bool Affine, bool MoeFinalize>
 void one_shot_all_reduce_norm_kernel_launcher(AllReduceParams params, cudaStream_t stream)
 {
     static constexpr int kPackedSize = details::kBytesPerAccess / sizeof(T);
@@ -458,12 +599,12 @@ void one_shot_all_reduce_norm_kernel_launcher(AllReduceParams params, cudaStream
     if (cta_size * kPackedSize < params.fusion_params.hidden_size)
     {
         smem_size = params.fusion_params.hidden_size * sizeof(T);
-        one_shot_all_reduce_norm_kernel<T, RanksPerNode, Bias, Affine, true>
+        one_shot_all_reduce_norm_kernel<T, RanksPerNode, Bias, Affine, true, MoeFinalize>
             <<<cta_num, cta_size, smem_size, stream>>>(params);
     }
     else
     {
-        one_shot_all_reduce_norm_kernel<T, RanksPerNode, Bias, Affine, false>
+        one_shot_all_reduce_norm_kernel<T, RanksPerNode, Bias, Affine, false, MoeFinalize>
             <<<cta_num, cta_size, smem_size, stream>>>(params);
     }
 }
@@ -587,6 +728,117 @@ static __global__ void oneShotAllReduceKernel(AllReduceParams params)
     }
 }
 
+#ifdef ENABLE_FP8
+// Elements sharing one scale in the FP8 compressed all reduce
+static constexpr int FP8_SCALE_BLOCK = 128;
+
+template <int N>
+struct alignas(N) PackedFp8
+{
+    __nv_fp8_e4m3 vals[N];
+};
+
+template <typename T, int RANKS_PER_NODE>
+static __global__ void oneShotFp8AllReduceKernel(AllReduceParams params)
+{
+    // One-shot all reduce exchanging the partial sums in FP8 E4M3 with one float scale per FP8_SCALE_BLOCK elements.
+    // Each rank's shareable buffer holds its quantized message followed by its scales:
+    //   [elts_total x fp8 | elts_total / FP8_SCALE_BLOCK x float]
+    // 1. Each thread quantizes its PACKED_ELTS elements, the lanes covering one scale block agree on its amax
+    // 2. block_barrier, like the one-shot kernel with COPY_INPUT
+    // 3. Each thread dequantizes the elements of all ranks and accumulates them in fp32, always from rank 0 so that
+    //    all ranks produce the same output
+
+    int const bidx = blockIdx.x;
+    int const tidx = threadIdx.x;
+    int const grid_size = gridDim.x;
+
+    static constexpr int PACKED_ELTS = 16 / sizeof(T);
+    static constexpr int LANES_PER_SCALE = FP8_SCALE_BLOCK / PACKED_ELTS;
+    static_assert(LANES_PER_SCALE <= WARP_SIZE && WARP_SIZE % LANES_PER_SCALE == 0);
+    using PackedStruct = typename PackedOn16Bytes<T>::Type;
+    using PackedQuant = PackedFp8<PACKED_ELTS>;
+
+    int const lane = tidx % WARP_SIZE;
+    uint32_t const scale_lanes_mask = LANES_PER_SCALE == WARP_SIZE
+        ? ~0U
+        : ((1U << LANES_PER_SCALE) - 1) << (lane & ~(LANES_PER_SCALE - 1));
+
+    T const* local_input_buffer = reinterpret_cast<T const*>(params.local_input_buffer_ptr);
+    T* local_output_buffer = reinterpret_cast<T*>(params.local_output_buffer_ptr);
+
+    size_t const chunk_start = bidx * params.elts_per_block + tidx * PACKED_ELTS;
+    size_t const chunk_end = std::min((bidx + 1) * params.elts_per_block, params.elts_total);
+
+    __nv_fp8_e4m3* quant_buffers[RANKS_PER_NODE];
+    float* scale_buffers[RANKS_PER_NODE];
+#pragma unroll
+    for (int ii = 0; ii < RANKS_PER_NODE; ++ii)
+    {
+        quant_buffers[ii] = reinterpret_cast<__nv_fp8_e4m3*>(params.peer_comm_buffer_ptrs[ii]);
+        scale_buffers[ii] = reinterpret_cast<float*>(quant_buffers[ii] + params.elts_total);
+    }
+
+    for (size_t iter_offset = chunk_start; iter_offset < chunk_end; iter_offset += blockDim.x * PACKED_ELTS)
+    {
+        PackedStruct vals;
+        vals.packed = *reinterpret_cast<int4 const*>(&local_input_buffer[iter_offset]);
+        float amax = 0.f;
+#pragma unroll
+        for (int i = 0; i < PACKED_ELTS; ++i)
+        {
+            amax = fmaxf(amax, fabsf(static_cast<float>(reinterpret_cast<T*>(vals.unpacked)[i])));
+        }
+#pragma unroll
+        for (int mask = LANES_PER_SCALE / 2; mask > 0; mask /= 2)
+        {
+            amax = fmaxf(amax, __shfl_xor_sync(scale_lanes_mask, amax, mask));
+        }
+        float const scale = amax > 0.f ? amax / 448.f : 1.f;
+        float const inv_scale = 1.f / scale;
+
+        PackedQuant quant;
+#pragma unroll
+        for (int i = 0; i < PACKED_ELTS; ++i)
+        {
+            quant.vals[i] = __nv_fp8_e4m3(static_cast<float>(reinterpret_cast<T*>(vals.unpacked)[i]) * inv_scale);
+        }
+        *reinterpret_cast<PackedQuant*>(&quant_buffers[params.local_rank][iter_offset]) = quant;
+        if (iter_offset % FP8_SCALE_BLOCK == 0)
+        {
+            scale_buffers[params.local_rank][iter_offset / FP8_SCALE_BLOCK] = scale;
+        }
+    }
+
+    // wait for equivalent blocks of other GPUs to have written their quantized chunk
+    block_barrier(
+        params.peer_barrier_ptrs_in, params.barrier_flag, params.local_rank, RANKS_PER_NODE, tidx, bidx, grid_size);
+
+    for (size_t iter_offset = chunk_start; iter_offset < chunk_end; iter_offset += blockDim.x * PACKED_ELTS)
+    {
+        float sums[PACKED_ELTS] = {};
+#pragma unroll
+        for (int rank = 0; rank < RANKS_PER_NODE; ++rank)
+        {
+            auto const quant = *reinterpret_cast<PackedQuant const*>(&quant_buffers[rank][iter_offset]);
+            float const scale = scale_buffers[rank][iter_offset / FP8_SCALE_BLOCK];
+#pragma unroll
+            for (int i = 0; i < PACKED_ELTS; ++i)
+            {
+                sums[i] += static_cast<float>(quant.vals[i]) * scale;
+            }
+        }
+        PackedStruct out;
+#pragma unroll
+        for (int i = 0; i < PACKED_ELTS; ++i)
+        {
+            reinterpret_cast<T*>(out.unpacked)[i] = static_cast<T>(sums[i]);
+        }
+        *reinterpret_cast<int4*>(&local_output_buffer[iter_offset]) = out.packed;
+    }
+}
+#endif // ENABLE_FP8
+
 template <typename T, int RANKS_PER_NODE, bool COPY_INPUT = true, bool PUSH_MODE = false, bool Bias = false,
     bool Residual = false>
 static __global__ void __launch_bounds__(512, 1) twoShotAllReduceKernel(AllReduceParams params)
@@ -851,14 +1103,35 @@ template <typename T, int RANKS_PER_NODE, bool PUSH_MODE = false, bool USE_MEMCP
 void AllReduceNormKernelLaunch(AllReduceStrategyType algo, AllReduceStrategyConfig config, AllReduceFusionOp fusionOp,
     AllReduceParams& params, cudaStream_t stream)
 {
-    TLLM_CHECK_WITH_INFO(fusionOp == AllReduceFusionOp::RESIDUAL_RMS_NORM, "Unsupported AllReduceFusionOp: %d",
-        static_cast<int>(fusionOp));
+    TLLM_CHECK_WITH_INFO(fusionOp == AllReduceFusionOp::RESIDUAL_RMS_NORM
+            || fusionOp == AllReduceFusionOp::MOE_FINALIZE_RESIDUAL_RMS_NORM,
+        "Unsupported AllReduceFusionOp: %d", static_cast<int>(fusionOp));
+    bool const moe_finalize = fusionOp == AllReduceFusionOp::MOE_FINALIZE_RESIDUAL_RMS_NORM;
     if (algo == AllReduceStrategyType::ONESHOT)
     {
-        reduce_fusion::one_shot_all_reduce_norm_kernel_launcher<T, RANKS_PER_NODE, Bias, Affine>(params, stream);
+        if (moe_finalize)
+        {
+            reduce_fusion::one_shot_all_reduce_norm_kernel_launcher<T, RANKS_PER_NODE, Bias, Affine, true>(
+                params, stream);
+        }
+        else
+        {
+            reduce_fusion::one_shot_all_reduce_norm_kernel_launcher<T, RANKS_PER_NODE, Bias, Affine, false>(
+                params, stream);
+        }
     }
     else
     {
+        if (moe_finalize)
+        {
+            // The reduced rows are the input of the all reduce. The intermediate buffer is free until the
+            // all reduce writes the new residual, and each thread reads its input before writing the same elements
+            auto output_ptr = params.local_output_buffer_ptr;
+            params.local_output_buffer_ptr = params.fusion_params.intermediate_buffer;
+            reduce_fusion::moe_finalize_kernel_launcher<T>(params, stream);
+            params.local_output_buffer_ptr = output_ptr;
+            params.local_input_buffer_ptr = params.fusion_params.intermediate_buffer;
+        }
         TLLM_CHECK_WITH_INFO(!(USE_MEMCPY && PUSH_MODE), "Memcpy cannot be used with PUSH_MODE.");
         size_t elts_per_thread = 16 / sizeof(T);
         auto [blocks_per_grid, threads_per_block] = kernelLaunchConfig(algo, params, elts_per_thread);
@@ -906,9 +1179,44 @@ template <typename T, int RANKS_PER_NODE, bool PUSH_MODE = false, bool USE_MEMCP
 void AllReduceDispatch(AllReduceStrategyType algo, AllReduceStrategyConfig config, AllReduceFusionOp fusionOp,
     AllReduceParams& params, cudaStream_t stream)
 {
-    TLLM_CHECK(fusionOp == AllReduceFusionOp::NONE);
+    TLLM_CHECK(fusionOp == AllReduceFusionOp::NONE || fusionOp == AllReduceFusionOp::EMBEDDING_LOOKUP);
     TLLM_CHECK_WITH_INFO(!(USE_MEMCPY && PUSH_MODE), "Memcpy cannot be used with PUSH_MODE.");
     size_t elts_per_thread = 16 / sizeof(T);
+    if (fusionOp == AllReduceFusionOp::EMBEDDING_LOOKUP)
+    {
+        // The push mode writes the input into the buffers of the peers, the lookup only fills the local one
+        TLLM_CHECK_WITH_INFO(!PUSH_MODE, "The embedding lookup fusion does not support PUSH_MODE.");
+        reduce_fusion::embedding_lookup_kernel_launcher<T>(params, stream);
+        auto [blocks_per_grid, threads_per_block] = kernelLaunchConfig(algo, params, elts_per_thread);
+        if (algo == AllReduceStrategyType::ONESHOT)
+        {
+            oneShotAllReduceKernel<T, RANKS_PER_NODE, false, false>
+                <<<blocks_per_grid, threads_per_block, 0, stream>>>(params);
+        }
+        else
+        {
+            twoShotAllReduceKernel<T, RANKS_PER_NODE, false, false>
+                <<<blocks_per_grid, threads_per_block, 0, stream>>>(params);
+        }
+        return;
+    }
+#ifdef ENABLE_FP8
+    bool const fp8_compression = static_cast<std::underlying_type_t<AllReduceStrategyConfig>>(config)
+        & static_cast<std::underlying_type_t<AllReduceStrategyConfig>>(AllReduceStrategyConfig::FP8_COMPRESSION);
+    // The quantization writes the shareable buffer itself, messages not made of whole scale blocks are exchanged
+    // uncompressed
+    if (fp8_compression && algo == AllReduceStrategyType::ONESHOT && !USE_MEMCPY && !PUSH_MODE
+        && params.elts_total % FP8_SCALE_BLOCK == 0)
+    {
+        size_t const total_threads = roundUp(params.elts_total / elts_per_thread, WARP_SIZE);
+        int const threads_per_block = std::min(DEFAULT_BLOCK_SIZE, total_threads);
+        int const blocks_per_grid
+            = std::min(static_cast<size_t>(MAX_ALL_REDUCE_BLOCKS), divUp(total_threads, threads_per_block));
+        params.elts_per_block = roundUp(divUp(params.elts_total, blocks_per_grid), FP8_SCALE_BLOCK);
+        oneShotFp8AllReduceKernel<T, RANKS_PER_NODE><<<blocks_per_grid, threads_per_block, 0, stream>>>(params);
+        return;
+    }
+#endif // ENABLE_FP8
     auto [blocks_per_grid, threads_per_block] = kernelLaunchConfig(algo, params, elts_per_thread);
     if (USE_MEMCPY)
     {
@@ -931,7 +1239,7 @@ template <typename T, int RANKS_PER_NODE, bool PUSH_MODE = false, bool USE_MEMCP
 void AllReduceDispatchMemcpy(AllReduceStrategyType algo, AllReduceStrategyConfig config, AllReduceFusionOp fusionOp,
     AllReduceParams& params, cudaStream_t stream)
 {
-    if (fusionOp == AllReduceFusionOp::NONE)
+    if (fusionOp == AllReduceFusionOp::NONE || fusionOp == AllReduceFusionOp::EMBEDDING_LOOKUP)
     {
         AllReduceDispatch<T, RANKS_PER_NODE, PUSH_MODE, USE_MEMCPY>(algo, config, fusionOp, params, stream);
     }
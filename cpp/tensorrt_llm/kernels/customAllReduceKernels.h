@@ -40,18 +40,68 @@ enum class AllReduceStrategyType : int8_t
     ONESHOT = 1,
     TWOSHOT = 2,
     AUTO = 3,
+    // Reduce-scatter within each node, allreduce of the shards across nodes and allgather within each node, for
+    // groups spanning several nodes. Runs over NCCL in the allreduce plugin, the custom kernels do not support it.
+    HIERARCHICAL = 4,
 };
 
 enum class AllReduceStrategyConfig : int8_t
 {
     USE_MEMCPY = 1 << 0,
     PUSH_MODE = 1 << 1,
+    // Exchange the partial sums in FP8 E4M3 with a float scale per 128 elements and accumulate in fp32. Halves the
+    // traffic of 16-bit activations at a small accuracy cost. Only used by the one-shot kernel without fusion, other
+    // configurations and messages that are not a multiple of 128 elements ignore it. Needs ENABLE_FP8.
+    FP8_COMPRESSION = 1 << 2,
 };
 
 enum class AllReduceFusionOp : int8_t
 {
     NONE = 0,
     RESIDUAL_RMS_NORM = 1,
+    // The input is the permuted output of the MoE experts, the k-way reduction is done before the all reduce
+    MOE_FINALIZE_RESIDUAL_RMS_NORM = 2,
+    // The input is gathered from the vocab-parallel embedding table, with the prompt table rows of virtual tokens,
+    // straight into the shareable buffer, the all reduce does not read an input tensor
+    EMBEDDING_LOOKUP = 3,
+};
+
+struct MoeFinalizeFusionParams
+{
+    // expert outputs in permuted order, [num_rows * k, hidden_size]
+    void const* permuted_rows = nullptr;
+    // permuted row of each expanded source row, [k, num_rows]
+    int const* source_to_permuted_row = nullptr;
+    // routing scales, [num_rows, k]
+    float const* scales = nullptr;
+    // node local expert of each expanded source row, [num_rows, k], only read with a bias
+    int const* experts = nullptr;
+    // expert bias, [num_experts_per_node, hidden_size]
+    void const* bias = nullptr;
+    // permuted rows at or above this count were skipped by the experts, nullptr if all rows are valid
+    int64_t const* num_valid_rows = nullptr;
+    int k = 0;
+    // divide by the sum of the routing scales
+    bool renormalize = false;
+};
+
+struct EmbeddingLookupFusionParams
+{
+    // token ids, [num_tokens]
+    int const* input_ids = nullptr;
+    // vocab shard of this rank, [local_vocab_size, hidden_size]
+    void const* weight = nullptr;
+    // first token id of the shard, ids outside of it give zero rows
+    int vocab_start = 0;
+    int local_vocab_size = 0;
+    // ids at or above vocab_size are virtual tokens of prompt tuning, looked up in the prompt table by the shard that
+    // starts at 0, [num_tasks * task_vocab_size, hidden_size], optional
+    void const* prompt_table = nullptr;
+    // prompt task of each token, [num_tokens]
+    int const* tasks = nullptr;
+    // on the device, [1]
+    int const* task_vocab_size = nullptr;
+    int vocab_size = 0;
 };
 
 struct AllReduceFusionParams
@@ -74,6 +124,10 @@ struct AllReduceFusionParams
     float eps;
     // new residual
     void* intermediate_buffer;
+    // moe finalize
+    MoeFinalizeFusionParams moe_finalize;
+    // embedding lookup
+    EmbeddingLookupFusionParams embedding_lookup;
 };
 
 struct AllReduceParams
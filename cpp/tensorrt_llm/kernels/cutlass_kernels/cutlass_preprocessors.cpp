@@ -17,10 +17,24 @@
 #include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaBf16Wrapper.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/stringUtils.h"
 
 #include "cutlass_extensions/gemm/kernel/mixed_gemm_B_layout.h"
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cuda_fp8.h>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <thread>
+#include <utility>
+
 using namespace tensorrt_llm::common;
 
 namespace tensorrt_llm
@@ -30,6 +44,59 @@ namespace kernels
 namespace cutlass_kernels
 {
 
+// Threads of parallel_for during the preprocess_weights_for_mixed_gemm call that runs on this thread, 0 to use
+// TRTLLM_WEIGHT_PREPROCESS_THREADS
+thread_local int preprocess_num_threads = 0;
+
+// Runs func(begin, end) on contiguous chunks of [0, num_items) on up to TRTLLM_WEIGHT_PREPROCESS_THREADS threads. The
+// exception of a worker, if any, is rethrown on the calling thread.
+template <typename Func>
+void parallel_for(size_t num_items, Func const& func)
+{
+    auto const max_threads = preprocess_num_threads > 0 ? preprocess_num_threads : getEnvWeightPreprocessThreads();
+    size_t const num_threads = std::min(static_cast<size_t>(max_threads), num_items);
+    if (num_threads <= 1)
+    {
+        func(size_t{0}, num_items);
+        return;
+    }
+    size_t const chunk_size = (num_items + num_threads - 1) / num_threads;
+    std::vector<std::exception_ptr> errors(num_threads);
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads);
+    for (size_t tid = 0; tid < num_threads; ++tid)
+    {
+        threads.emplace_back(
+            [&func, &errors, tid, chunk_size, num_items]()
+            {
+                try
+                {
+                    size_t const begin = tid * chunk_size;
+                    size_t const end = std::min(begin + chunk_size, num_items);
+                    if (begin < end)
+                    {
+                        func(begin, end);
+                    }
+                }
+                catch (...)
+                {
+                    errors[tid] = std::current_exception();
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (auto const& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 struct LayoutDetails
 {
     enum class Layout
@@ -217,29 +284,25 @@ void permute_B_rows_for_mixed_gemm(int8_t* permuted_quantized_tensor, int8_t con
 
     TLLM_CHECK_WITH_INFO(size_t(B_ROWS_PER_MMA) == row_permutation.size(), "Unexpected number of LDSM rows permuted.");
 
-    for (int expert = 0; expert < num_experts; ++expert)
-    {
-        const int64_t matrix_offset = expert * int64_t(num_rows) * int64_t(num_vec_cols);
-        for (int base_row = 0; base_row < num_rows; base_row += B_ROWS_PER_MMA)
+    // Each work item is one group of B_ROWS_PER_MMA rows of one expert
+    size_t const row_groups_per_expert = num_rows / B_ROWS_PER_MMA;
+    parallel_for(num_experts * row_groups_per_expert,
+        [&](size_t begin, size_t end)
         {
-            for (int tile_row = 0; tile_row < B_ROWS_PER_MMA; ++tile_row)
+            for (size_t item = begin; item < end; ++item)
             {
-
-                for (int write_col = 0; write_col < num_vec_cols; ++write_col)
+                const int64_t expert = item / row_groups_per_expert;
+                const int64_t base_row = (item % row_groups_per_expert) * B_ROWS_PER_MMA;
+                const int64_t matrix_offset = expert * int64_t(num_rows) * int64_t(num_vec_cols);
+                for (int tile_row = 0; tile_row < B_ROWS_PER_MMA; ++tile_row)
                 {
-                    int const write_row = base_row + tile_row;
-                    int const tile_read_row = row_permutation[tile_row];
-                    int const read_row = base_row + tile_read_row;
-                    int const read_col = write_col;
-
-                    const int64_t read_offset = matrix_offset + int64_t(read_row) * num_vec_cols + read_col;
-                    const int64_t write_offset = matrix_offset + int64_t(write_row) * num_vec_cols + write_col;
-
-                    output_byte_ptr[write_offset] = input_byte_ptr[read_offset];
+                    const int64_t write_row = base_row + tile_row;
+                    const int64_t read_row = base_row + row_permutation[tile_row];
+                    std::memcpy(output_byte_ptr + matrix_offset + write_row * num_vec_cols,
+                        input_byte_ptr + matrix_offset + read_row * num_vec_cols, num_vec_cols * sizeof(uint32_t));
                 }
             }
-        }
-    }
+        });
 }
 
 // We need to use this transpose to correctly handle packed int4 and int8 data
@@ -269,7 +332,6 @@ void subbyte_transpose_impl(
 
     static constexpr int M_TILE_L1 = 64;
     static constexpr int N_TILE_L1 = M_TILE_L1 / ELTS_PER_BYTE;
-    uint8_t cache_buf[M_TILE_L1][N_TILE_L1];
 
     static constexpr int VECTOR_WIDTH = std::min(32, N_TILE_L1);
 
@@ -284,105 +346,110 @@ void subbyte_transpose_impl(
     int const num_m_tiles = (num_rows + M_TILE_L1 - 1) / M_TILE_L1;
     int const num_n_tiles = (col_bytes + N_TILE_L1 - 1) / N_TILE_L1;
 
-    for (size_t expert = 0; expert < num_experts; ++expert)
-    {
-        const size_t matrix_offset = expert * num_rows * col_bytes;
-        for (size_t row_tile_start = 0; row_tile_start < num_rows; row_tile_start += M_TILE_L1)
+    // Each work item is one row of tiles of one expert
+    parallel_for(num_experts * num_m_tiles,
+        [&](size_t begin, size_t end)
         {
-            for (size_t col_tile_start_byte = 0; col_tile_start_byte < col_bytes; col_tile_start_byte += N_TILE_L1)
+            uint8_t cache_buf[M_TILE_L1][N_TILE_L1];
+            for (size_t item = begin; item < end; ++item)
             {
-
-                int const row_limit = std::min(row_tile_start + M_TILE_L1, num_rows);
-                int const col_limit = std::min(col_tile_start_byte + N_TILE_L1, col_bytes);
-
-                for (int ii = 0; ii < M_TILE_L1; ++ii)
+                const size_t expert = item / num_m_tiles;
+                const size_t row_tile_start = (item % num_m_tiles) * M_TILE_L1;
+                const size_t matrix_offset = expert * num_rows * col_bytes;
+                for (size_t col_tile_start_byte = 0; col_tile_start_byte < col_bytes; col_tile_start_byte += N_TILE_L1)
                 {
-                    int const row = row_tile_start + ii;
 
-                    for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
-                    {
-                        int const col = col_tile_start_byte + jj;
+                    int const row_limit = std::min(row_tile_start + M_TILE_L1, num_rows);
+                    int const col_limit = std::min(col_tile_start_byte + N_TILE_L1, col_bytes);
 
-                        const size_t logical_src_offset = matrix_offset + row * col_bytes + col;
+                    for (int ii = 0; ii < M_TILE_L1; ++ii)
+                    {
+                        int const row = row_tile_start + ii;
 
-                        if (row < row_limit && col < col_limit)
+                        for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
                         {
-                            for (int v = 0; v < VECTOR_WIDTH; ++v)
+                            int const col = col_tile_start_byte + jj;
+
+                            const size_t logical_src_offset = matrix_offset + row * col_bytes + col;
+
+                            if (row < row_limit && col < col_limit)
                             {
-                                cache_buf[ii][jj + v] = input_byte_ptr[logical_src_offset + v];
+                                for (int v = 0; v < VECTOR_WIDTH; ++v)
+                                {
+                                    cache_buf[ii][jj + v] = input_byte_ptr[logical_src_offset + v];
+                                }
                             }
                         }
                     }
-                }
 
-                if constexpr (bits_per_elt == 8)
-                {
-                    for (int ii = 0; ii < M_TILE_L1; ++ii)
+                    if constexpr (bits_per_elt == 8)
                     {
-                        for (int jj = ii + 1; jj < N_TILE_L1; ++jj)
+                        for (int ii = 0; ii < M_TILE_L1; ++ii)
                         {
-                            std::swap(cache_buf[ii][jj], cache_buf[jj][ii]);
+                            for (int jj = ii + 1; jj < N_TILE_L1; ++jj)
+                            {
+                                std::swap(cache_buf[ii][jj], cache_buf[jj][ii]);
+                            }
                         }
                     }
-                }
-                else if constexpr (bits_per_elt == 4)
-                {
-
-                    for (int ii = 0; ii < M_TILE_L1; ++ii)
+                    else if constexpr (bits_per_elt == 4)
                     {
-                        // Using M_TILE_L1 here is deliberate since we assume that the cache tile
-                        // is square in the number of elements (not necessarily the number of bytes).
-                        for (int jj = ii + 1; jj < M_TILE_L1; ++jj)
+
+                        for (int ii = 0; ii < M_TILE_L1; ++ii)
                         {
-                            int const ii_byte = ii / ELTS_PER_BYTE;
-                            int const ii_bit_offset = ii % ELTS_PER_BYTE;
+                            // Using M_TILE_L1 here is deliberate since we assume that the cache tile
+                            // is square in the number of elements (not necessarily the number of bytes).
+                            for (int jj = ii + 1; jj < M_TILE_L1; ++jj)
+                            {
+                                int const ii_byte = ii / ELTS_PER_BYTE;
+                                int const ii_bit_offset = ii % ELTS_PER_BYTE;
 
-                            int const jj_byte = jj / ELTS_PER_BYTE;
-                            int const jj_bit_offset = jj % ELTS_PER_BYTE;
+                                int const jj_byte = jj / ELTS_PER_BYTE;
+                                int const jj_bit_offset = jj % ELTS_PER_BYTE;
 
-                            uint8_t src_elt = 0xF & (cache_buf[ii][jj_byte] >> (4 * jj_bit_offset));
-                            uint8_t tgt_elt = 0xF & (cache_buf[jj][ii_byte] >> (4 * ii_bit_offset));
+                                uint8_t src_elt = 0xF & (cache_buf[ii][jj_byte] >> (4 * jj_bit_offset));
+                                uint8_t tgt_elt = 0xF & (cache_buf[jj][ii_byte] >> (4 * ii_bit_offset));
 
-                            cache_buf[ii][jj_byte] &= (0xF0 >> (4 * jj_bit_offset));
-                            cache_buf[jj][ii_byte] &= (0xF0 >> (4 * ii_bit_offset));
+                                cache_buf[ii][jj_byte] &= (0xF0 >> (4 * jj_bit_offset));
+                                cache_buf[jj][ii_byte] &= (0xF0 >> (4 * ii_bit_offset));
 
-                            cache_buf[ii][jj_byte] |= (tgt_elt << (4 * jj_bit_offset));
-                            cache_buf[jj][ii_byte] |= (src_elt << (4 * ii_bit_offset));
+                                cache_buf[ii][jj_byte] |= (tgt_elt << (4 * jj_bit_offset));
+                                cache_buf[jj][ii_byte] |= (src_elt << (4 * ii_bit_offset));
+                            }
                         }
                     }
-                }
-                else
-                {
-                    TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type.");
-                }
+                    else
+                    {
+                        TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type.");
+                    }
 
-                const size_t row_tile_start_trans = col_tile_start_byte * ELTS_PER_BYTE;
-                const size_t col_tile_start_byte_trans = row_tile_start / ELTS_PER_BYTE;
+                    const size_t row_tile_start_trans = col_tile_start_byte * ELTS_PER_BYTE;
+                    const size_t col_tile_start_byte_trans = row_tile_start / ELTS_PER_BYTE;
 
-                int const row_limit_trans = std::min(row_tile_start_trans + M_TILE_L1, num_cols);
-                int const col_limit_trans = std::min(col_tile_start_byte_trans + N_TILE_L1, col_bytes_trans);
+                    int const row_limit_trans = std::min(row_tile_start_trans + M_TILE_L1, num_cols);
+                    int const col_limit_trans = std::min(col_tile_start_byte_trans + N_TILE_L1, col_bytes_trans);
 
-                for (int ii = 0; ii < M_TILE_L1; ++ii)
-                {
-                    int const row = row_tile_start_trans + ii;
-                    for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
+                    for (int ii = 0; ii < M_TILE_L1; ++ii)
                     {
-                        int const col = col_tile_start_byte_trans + jj;
+                        int const row = row_tile_start_trans + ii;
+                        for (int jj = 0; jj < N_TILE_L1; jj += VECTOR_WIDTH)
+                        {
+                            int const col = col_tile_start_byte_trans + jj;
 
-                        const size_t logical_tgt_offset = matrix_offset + row * col_bytes_trans + col;
+                            const size_t logical_tgt_offset = matrix_offset + row * col_bytes_trans + col;
 
-                        if (row < row_limit_trans && col < col_limit_trans)
-                        {
-                            for (int v = 0; v < VECTOR_WIDTH; ++v)
+                            if (row < row_limit_trans && col < col_limit_trans)
                             {
-                                output_byte_ptr[logical_tgt_offset + v] = cache_buf[ii][jj + v];
+                                for (int v = 0; v < VECTOR_WIDTH; ++v)
+                                {
+                                    output_byte_ptr[logical_tgt_offset + v] = cache_buf[ii][jj + v];
+                                }
                             }
                         }
                     }
                 }
             }
-        }
-    }
+        });
 }
 
 void subbyte_transpose(int8_t* transposed_quantized_tensor, int8_t const* quantized_tensor,
@@ -410,11 +477,8 @@ void subbyte_transpose(int8_t* transposed_quantized_tensor, int8_t const* quanti
 
 void add_bias_and_interleave_int8s_inplace(int8_t* int8_tensor, const size_t num_elts)
 {
-    for (int ii = 0; ii < num_elts; ++ii)
-    {
-        int8_tensor[ii] = int8_t(int(int8_tensor[ii]) + 128);
-    }
-
+    // Step 1 adds 128 to every element, which is flipping its sign bit, to make them unsigned.
+    //
     // Step 2 will transform the layout of a 32-bit register in CUDA in order to match the int4 layout. This has no
     // performance benefit and is purely so that int4 and int8 have the same layout.
     // Pictorially, this does the following:
@@ -424,38 +488,32 @@ void add_bias_and_interleave_int8s_inplace(int8_t* int8_tensor, const size_t num
     // And it will rearrange the output 32 bit register to be the following:
     // bit 32                                                      0
     //      [elt_3  elt_1  elt_2  elt_0] (each elt occupies 8 bits)
+    //
+    // Both steps work on whole registers so that the compiler vectorizes the loop.
 
     TLLM_CHECK_WITH_INFO(num_elts % 4 == 0, "Dimensions of int8 tensor must be a multiple of 4 for register relayout");
-    for (size_t base = 0; base < num_elts; base += 4)
-    {
-        std::swap(int8_tensor[base + 1], int8_tensor[base + 2]);
-    }
+    const size_t num_registers = num_elts / 4;
+
+    uint32_t* register_ptr = reinterpret_cast<uint32_t*>(int8_tensor);
+    parallel_for(num_registers,
+        [register_ptr](size_t begin, size_t end)
+        {
+            for (size_t ii = begin; ii < end; ++ii)
+            {
+                uint32_t const biased_register = register_ptr[ii] ^ 0x80808080u;
+                uint32_t const swapped_bits = (biased_register ^ (biased_register >> 8)) & 0x0000FF00u;
+                register_ptr[ii] = biased_register ^ swapped_bits ^ (swapped_bits << 8);
+            }
+        });
 }
 
 void add_bias_and_interleave_int4s_inplace(int8_t* packed_int4_tensor, const size_t num_elts)
 {
-    int const num_bytes = num_elts / 2;
+    const size_t num_bytes = num_elts / 2;
 
     // Step 1 will be to transform all the int4s to unsigned in order to make the dequantize take as little
-    // instructions as possible in the CUDA code.
-    for (size_t ii = 0; ii < num_bytes; ++ii)
-    {
-        int8_t transformed_packed_int4s = 0;
-        int8_t transformed_first_elt
-            = (int8_t(packed_int4_tensor[ii] << 4) >> 4) + 8; // The double shift here is to ensure sign extension
-        int8_t transformed_second_elt = (packed_int4_tensor[ii] >> 4) + 8;
-
-        TLLM_CHECK_WITH_INFO(
-            transformed_first_elt >= 0 && transformed_first_elt <= 15, "Illegal result for int4 transform (first elt)");
-        TLLM_CHECK_WITH_INFO(transformed_second_elt >= 0 && transformed_second_elt <= 15,
-            "Illegal result for int4 transform (second elt)");
-
-        // We don't need to mask in these ops since everything should be in the range 0-15
-        transformed_packed_int4s |= transformed_first_elt;
-        transformed_packed_int4s |= (transformed_second_elt << 4);
-        packed_int4_tensor[ii] = transformed_packed_int4s;
-    }
-
+    // instructions as possible in the CUDA code. Adding 8 to an int4 is flipping its sign bit.
+    //
     // Step 2 will transform the layout of a 32-bit register in CUDA in order to minimize the number of shift & logical
     // instructions That are needed to extract the int4s in the GEMM main loop. Pictorially, the loop below will do the
     // following: Take as input a 32 bit register with layout: bit 32 0
@@ -464,27 +522,26 @@ void add_bias_and_interleave_int4s_inplace(int8_t* packed_int4_tensor, const siz
     // And it will rearrange the output 32 bit register to be the following:
     // bit 32                                                      0
     //      [elt_7  elt_5  elt_3  elt_1  elt_6  elt_4  elt_2  elt_0] (each elt occupies 4 bits)
+    //
+    // The relayout is two swaps of bit fields within the register, so the loop vectorizes like the int8 one.
 
     TLLM_CHECK_WITH_INFO(num_bytes % 4 == 0, "Dimensions of int4 tensor must be a multiple of 8 for register relayout");
     const size_t num_registers = num_bytes / 4;
 
     uint32_t* register_ptr = reinterpret_cast<uint32_t*>(packed_int4_tensor);
-    for (size_t ii = 0; ii < num_registers; ++ii)
-    {
-        const uint32_t current_register = register_ptr[ii];
-        uint32_t transformed_register = 0;
-
-        for (int dest_idx = 0; dest_idx < 8; ++dest_idx)
+    parallel_for(num_registers,
+        [register_ptr](size_t begin, size_t end)
         {
-            int const src_idx = dest_idx < 4 ? 2 * dest_idx : 2 * (dest_idx - 4) + 1;
-            int const src_shift = 4 * src_idx;
-            int const dest_shift = 4 * dest_idx;
-
-            const uint32_t src_bits = (current_register >> src_shift) & 0xF;
-            transformed_register |= (src_bits << dest_shift);
-        }
-        register_ptr[ii] = transformed_register;
-    }
+            for (size_t ii = begin; ii < end; ++ii)
+            {
+                uint32_t transformed_register = register_ptr[ii] ^ 0x88888888u;
+                uint32_t swapped_bits = (transformed_register ^ (transformed_register >> 4)) & 0x00F000F0u;
+                transformed_register ^= swapped_bits ^ (swapped_bits << 4);
+                swapped_bits = (transformed_register ^ (transformed_register >> 8)) & 0x0000FF00u;
+                transformed_register ^= swapped_bits ^ (swapped_bits << 8);
+                register_ptr[ii] = transformed_register;
+            }
+        });
 }
 
 void add_bias_and_interleave_quantized_tensor_inplace(int8_t* tensor, const size_t num_elts, QuantType quant_type)
@@ -536,27 +593,183 @@ void interleave_column_major_tensor(int8_t* interleaved_quantized_tensor, int8_t
     int const vec_rows_per_tile = rows_per_tile / elts_in_int32;
     int const interleave = details.columns_interleaved;
 
-    for (int expert = 0; expert < num_experts; ++expert)
-    {
-        const int64_t matrix_offset = expert * int64_t(num_vec_rows) * int64_t(num_cols);
-        for (int read_col = 0; read_col < num_cols; ++read_col)
+    // Each work item is one column of one expert
+    parallel_for(num_experts * num_cols,
+        [&](size_t begin, size_t end)
         {
-            const int64_t write_col = read_col / interleave;
-            for (int base_vec_row = 0; base_vec_row < num_vec_rows; base_vec_row += vec_rows_per_tile)
+            for (size_t item = begin; item < end; ++item)
             {
-                for (int vec_read_row = base_vec_row;
-                     vec_read_row < std::min(num_vec_rows, base_vec_row + vec_rows_per_tile); ++vec_read_row)
+                const int64_t expert = item / num_cols;
+                const int64_t read_col = item % num_cols;
+                const int64_t matrix_offset = expert * int64_t(num_vec_rows) * int64_t(num_cols);
+                const int64_t write_col = read_col / interleave;
+                for (int base_vec_row = 0; base_vec_row < num_vec_rows; base_vec_row += vec_rows_per_tile)
                 {
-                    const int64_t vec_write_row = interleave * base_vec_row
-                        + vec_rows_per_tile * (read_col % interleave) + vec_read_row % vec_rows_per_tile;
-
-                    const int64_t read_offset = matrix_offset + int64_t(read_col) * num_vec_rows + vec_read_row;
-                    const int64_t write_offset
-                        = matrix_offset + int64_t(write_col) * num_vec_rows * interleave + vec_write_row;
-                    output_byte_ptr[write_offset] = input_byte_ptr[read_offset];
+                    // Each tile of the column is a contiguous run of registers in both layouts
+                    int const tile_vec_rows = std::min(num_vec_rows - base_vec_row, vec_rows_per_tile);
+                    const int64_t vec_write_row
+                        = interleave * base_vec_row + vec_rows_per_tile * (read_col % interleave);
+
+                    const int64_t read_offset = matrix_offset + read_col * num_vec_rows + base_vec_row;
+                    const int64_t write_offset = matrix_offset + write_col * num_vec_rows * interleave + vec_write_row;
+                    std::memcpy(output_byte_ptr + write_offset, input_byte_ptr + read_offset,
+                        tile_vec_rows * sizeof(uint32_t));
                 }
             }
+        });
+}
+
+// The on-disk cache of preprocessed weights. The preprocessed layout is a function of the quantized weight, its shape,
+// the quant type and the arch, so files are named after a hash of all of them and never invalidated. The header
+// repeats the key and a checksum of the payload, a file that doesn't match is recomputed and overwritten. Bump the
+// version when the layouts change.
+constexpr uint32_t kPreprocessCacheMagic = 0x43505057; // "WPPC"
+constexpr uint32_t kPreprocessCacheVersion = 2;
+constexpr size_t kPreprocessCacheMaxDims = 3;
+
+struct PreprocessCacheHeader
+{
+    uint32_t magic;
+    uint32_t version;
+    int32_t quant_type;
+    int32_t arch;
+    uint64_t num_dims;
+    uint64_t shape[kPreprocessCacheMaxDims];
+    uint64_t weight_hash;
+    uint64_t num_bytes;
+    uint64_t payload_hash;
+};
+
+// 64-bit FNV-1a over 8-byte words of chunks hashed in parallel, combined with FNV-1a over the chunk hashes
+uint64_t hash_bytes(int8_t const* data, size_t num_bytes)
+{
+    constexpr uint64_t kOffsetBasis = 0xcbf29ce484222325ULL;
+    constexpr uint64_t kPrime = 0x100000001b3ULL;
+    constexpr size_t kChunkBytes = size_t{64} << 20;
+    auto const hash_range = [](uint8_t const* bytes, size_t size)
+    {
+        uint64_t hash = kOffsetBasis ^ size;
+        size_t offset = 0;
+        for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + offset, sizeof(word));
+            hash = (hash ^ word) * kPrime;
         }
+        for (; offset < size; ++offset)
+        {
+            hash = (hash ^ bytes[offset]) * kPrime;
+        }
+        return hash;
+    };
+
+    auto const* bytes = reinterpret_cast<uint8_t const*>(data);
+    size_t const num_chunks = (num_bytes + kChunkBytes - 1) / kChunkBytes;
+    std::vector<uint64_t> chunk_hashes(num_chunks);
+    parallel_for(num_chunks,
+        [&](size_t begin, size_t end)
+        {
+            for (size_t chunk = begin; chunk < end; ++chunk)
+            {
+                size_t const offset = chunk * kChunkBytes;
+                chunk_hashes[chunk] = hash_range(bytes + offset, std::min(kChunkBytes, num_bytes - offset));
+            }
+        });
+    return hash_range(reinterpret_cast<uint8_t const*>(chunk_hashes.data()), chunk_hashes.size() * sizeof(uint64_t));
+}
+
+// The header of the cache file of a weight, without the payload hash
+PreprocessCacheHeader make_preprocess_cache_header(int8_t const* row_major_quantized_weight, size_t num_bytes,
+    std::vector<size_t> const& shape, QuantType quant_type, int arch)
+{
+    TLLM_CHECK(shape.size() <= kPreprocessCacheMaxDims);
+    PreprocessCacheHeader header{};
+    header.magic = kPreprocessCacheMagic;
+    header.version = kPreprocessCacheVersion;
+    header.quant_type = static_cast<int32_t>(quant_type);
+    header.arch = arch;
+    header.num_dims = shape.size();
+    std::copy(shape.begin(), shape.end(), header.shape);
+    header.weight_hash = hash_bytes(row_major_quantized_weight, num_bytes);
+    header.num_bytes = num_bytes;
+    return header;
+}
+
+std::filesystem::path get_preprocess_cache_path(std::string const& cache_dir, PreprocessCacheHeader const& header)
+{
+    std::string name = fmtstr("%016llx_q%d_sm%d", static_cast<unsigned long long>(header.weight_hash),
+        static_cast<int>(header.quant_type), static_cast<int>(header.arch));
+    for (size_t dim = 0; dim < header.num_dims; ++dim)
+    {
+        name += "_" + std::to_string(header.shape[dim]);
+    }
+    return std::filesystem::path(cache_dir) / (name + ".bin");
+}
+
+// Returns false if the file doesn't exist, or doesn't hold the preprocessed weight of `expected` intact
+bool load_preprocessed_weight(
+    std::filesystem::path const& path, int8_t* preprocessed_quantized_weight, PreprocessCacheHeader const& expected)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    PreprocessCacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != kPreprocessCacheMagic || header.version != kPreprocessCacheVersion)
+    {
+        TLLM_LOG_WARNING("Ignoring preprocessed weight cache %s, it was written by another version.", path.c_str());
+        return false;
+    }
+    if (header.quant_type != expected.quant_type || header.arch != expected.arch
+        || header.num_dims != expected.num_dims
+        || !std::equal(header.shape, header.shape + kPreprocessCacheMaxDims, expected.shape)
+        || header.weight_hash != expected.weight_hash || header.num_bytes != expected.num_bytes)
+    {
+        TLLM_LOG_WARNING("Ignoring preprocessed weight cache %s, it was written for another weight.", path.c_str());
+        return false;
+    }
+    auto const num_bytes = static_cast<size_t>(header.num_bytes);
+    file.read(reinterpret_cast<char*>(preprocessed_quantized_weight), static_cast<std::streamsize>(num_bytes));
+    if (!file || file.peek() != std::ifstream::traits_type::eof())
+    {
+        TLLM_LOG_WARNING("Ignoring truncated preprocessed weight cache %s.", path.c_str());
+        return false;
+    }
+    if (hash_bytes(preprocessed_quantized_weight, num_bytes) != header.payload_hash)
+    {
+        TLLM_LOG_WARNING("Ignoring corrupt preprocessed weight cache %s.", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+// The cache only saves load time, failing to write it must not fail the load. The file is replaced atomically, so
+// concurrent processes sharing the cache always read a complete file.
+void save_preprocessed_weight(
+    std::filesystem::path const& path, int8_t const* preprocessed_quantized_weight, PreprocessCacheHeader header)
+{
+    try
+    {
+        std::filesystem::create_directories(path.parent_path());
+        auto tmp_path = path;
+        tmp_path += ".tmp." + std::to_string(std::random_device{}());
+        {
+            std::ofstream file(tmp_path, std::ios::binary | std::ios::trunc);
+            TLLM_CHECK_WITH_INFO(file.good(), "Can't write %s", tmp_path.c_str());
+            auto const num_bytes = static_cast<size_t>(header.num_bytes);
+            header.payload_hash = hash_bytes(preprocessed_quantized_weight, num_bytes);
+            file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+            file.write(
+                reinterpret_cast<char const*>(preprocessed_quantized_weight), static_cast<std::streamsize>(num_bytes));
+            TLLM_CHECK_WITH_INFO(file.good(), "Can't write %s", tmp_path.c_str());
+        }
+        std::filesystem::rename(tmp_path, path);
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_WARNING("Failed to save the preprocessed weight cache %s: %s", path.c_str(), e.what());
     }
 }
 
@@ -569,6 +782,30 @@ void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, in
         // Workaround for MOE which doesn't have specialised Hopper kernels yet
         arch = 80;
     }
+    preprocess_weights_for_mixed_gemm(preprocessed_quantized_weight, row_major_quantized_weight, shape, quant_type,
+        arch, getEnvWeightPreprocessThreads(), getEnvWeightPreprocessCacheDir());
+}
+
+void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, int8_t const* row_major_quantized_weight,
+    std::vector<size_t> const& shape, QuantType quant_type, int arch, int num_threads,
+    std::optional<std::string> const& cache_dir)
+{
+    TLLM_CHECK(num_threads > 0);
+    struct NumThreadsScope
+    {
+        explicit NumThreadsScope(int num_threads)
+            : previous{std::exchange(preprocess_num_threads, num_threads)}
+        {
+        }
+
+        ~NumThreadsScope()
+        {
+            preprocess_num_threads = previous;
+        }
+
+        int previous;
+    } const num_threads_scope{num_threads};
+
     LayoutDetails details = getLayoutDetailsForTransform(quant_type, arch);
 
     TLLM_CHECK_WITH_INFO(shape.size() == 2 || shape.size() == 3, "Shape must be 2-D or 3-D");
@@ -581,6 +818,19 @@ void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, in
 
     const size_t num_bytes = num_elts * get_weight_quant_bits(quant_type) / 8;
 
+    std::optional<PreprocessCacheHeader> cache_header;
+    std::optional<std::filesystem::path> cache_path;
+    if (cache_dir)
+    {
+        cache_header = make_preprocess_cache_header(row_major_quantized_weight, num_bytes, shape, quant_type, arch);
+        cache_path = get_preprocess_cache_path(*cache_dir, *cache_header);
+    }
+    if (cache_path && load_preprocessed_weight(*cache_path, preprocessed_quantized_weight, *cache_header))
+    {
+        TLLM_LOG_DEBUG("Loaded preprocessed weight from %s", cache_path->c_str());
+        return;
+    }
+
     std::vector<int8_t> src_buf(num_bytes);
     std::vector<int8_t> dst_buf(num_bytes);
     std::copy(row_major_quantized_weight, row_major_quantized_weight + num_bytes, src_buf.begin());
@@ -609,6 +859,11 @@ void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, in
         add_bias_and_interleave_quantized_tensor_inplace(src_buf.data(), num_elts, quant_type);
     }
     std::copy(src_buf.begin(), src_buf.end(), preprocessed_quantized_weight);
+
+    if (cache_path)
+    {
+        save_preprocessed_weight(*cache_path, preprocessed_quantized_weight, *cache_header);
+    }
 }
 
 /*
@@ -690,14 +945,18 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
             per_col_max[jj] = 0.f;
         }
 
-        for (int ii = 0; ii < num_rows; ++ii)
-        {
-            WeightType const* current_weight_row = current_weight + ii * num_cols;
-            for (int jj = 0; jj < num_cols; ++jj)
+        parallel_for(num_cols,
+            [&](size_t col_begin, size_t col_end)
             {
-                per_col_max[jj] = std::max(per_col_max[jj], std::abs(float(current_weight_row[jj])));
-            }
-        }
+                for (size_t ii = 0; ii < num_rows; ++ii)
+                {
+                    WeightType const* current_weight_row = current_weight + ii * num_cols;
+                    for (size_t jj = col_begin; jj < col_end; ++jj)
+                    {
+                        per_col_max[jj] = std::max(per_col_max[jj], std::abs(float(current_weight_row[jj])));
+                    }
+                }
+            });
 
         // Then, we construct the scales
         ComputeType* current_scales = scale_ptr + expert * num_cols;
@@ -708,50 +967,55 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
         }
 
         // Finally, construct the weights.
-        for (int ii = 0; ii < num_rows; ++ii)
-        {
-            int8_t* current_quantized_weight_row = current_quantized_weight + ii * bytes_per_out_col;
-            WeightType const* current_weight_row = current_weight + ii * num_cols;
-            for (int jj = 0; jj < bytes_per_out_col; ++jj)
+        parallel_for(num_rows,
+            [&](size_t row_begin, size_t row_end)
             {
-
-                if (bits_per_weigtht_element == 8)
+                for (size_t ii = row_begin; ii < row_end; ++ii)
                 {
-                    float const col_scale = per_col_max[jj];
-                    float const weight_elt = float(current_weight_row[jj]);
-                    float const scaled_weight = (col_scale != 0.0f) ? round(weight_elt / col_scale) : 0.0f;
-                    const int8_t clipped_weight = int8_t(std::max(-128.f, std::min(127.f, scaled_weight)));
-                    current_quantized_weight_row[jj] = clipped_weight;
-                }
-                else if (bits_per_weigtht_element == 4)
-                {
-
-                    // We will pack two int4 elements per iteration of the inner loop.
-                    int8_t packed_int4s = 0;
-                    for (int packed_idx = 0; packed_idx < 2; ++packed_idx)
+                    int8_t* current_quantized_weight_row = current_quantized_weight + ii * bytes_per_out_col;
+                    WeightType const* current_weight_row = current_weight + ii * num_cols;
+                    for (int jj = 0; jj < bytes_per_out_col; ++jj)
                     {
-                        int const input_idx = 2 * jj + packed_idx;
-                        if (input_idx < num_cols)
+
+                        if (bits_per_weigtht_element == 8)
                         {
-                            float const col_scale = per_col_max[input_idx];
-                            float const weight_elt = float(current_weight_row[input_idx]);
+                            float const col_scale = per_col_max[jj];
+                            float const weight_elt = float(current_weight_row[jj]);
                             float const scaled_weight = (col_scale != 0.0f) ? round(weight_elt / col_scale) : 0.0f;
-                            int int_weight = int(scaled_weight);
-                            const int8_t clipped_weight = std::max(-8, std::min(7, int_weight));
+                            const int8_t clipped_weight = int8_t(std::max(-128.f, std::min(127.f, scaled_weight)));
+                            current_quantized_weight_row[jj] = clipped_weight;
+                        }
+                        else if (bits_per_weigtht_element == 4)
+                        {
 
-                            // Kill the sign extension bits (hence 0x0F mask) then shift to upper bits
-                            // if packing the second int4 and or the bits into the final result.
-                            packed_int4s |= ((clipped_weight & 0x0F) << (4 * packed_idx));
+                            // We will pack two int4 elements per iteration of the inner loop.
+                            int8_t packed_int4s = 0;
+                            for (int packed_idx = 0; packed_idx < 2; ++packed_idx)
+                            {
+                                int const input_idx = 2 * jj + packed_idx;
+                                if (input_idx < num_cols)
+                                {
+                                    float const col_scale = per_col_max[input_idx];
+                                    float const weight_elt = float(current_weight_row[input_idx]);
+                                    float const scaled_weight
+                                        = (col_scale != 0.0f) ? round(weight_elt / col_scale) : 0.0f;
+                                    int int_weight = int(scaled_weight);
+                                    const int8_t clipped_weight = std::max(-8, std::min(7, int_weight));
+
+                                    // Kill the sign extension bits (hence 0x0F mask) then shift to upper bits
+                                    // if packing the second int4 and or the bits into the final result.
+                                    packed_int4s |= ((clipped_weight & 0x0F) << (4 * packed_idx));
+                                }
+                            }
+                            current_quantized_weight_row[jj] = packed_int4s;
+                        }
+                        else
+                        {
+                            TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type");
                         }
                     }
-                    current_quantized_weight_row[jj] = packed_int4s;
-                }
-                else
-                {
-                    TLLM_CHECK_WITH_INFO(false, "Unsupported quantization type");
                 }
-            }
-        }
+            });
     }
 
     preprocess_weights_for_mixed_gemm(
@@ -802,6 +1066,126 @@ template void symmetric_quantize<__nv_bfloat16, float>(
     int8_t*, __nv_bfloat16*, float const*, std::vector<size_t> const&, QuantType, bool);
 #endif
 
+namespace
+{
+constexpr float kE2M1Max = 6.f;
+constexpr float kE4M3Max = 448.f;
+// floor(log2) of the largest E2M1 value, the OCP MX scale exponent is floor(log2(amax)) minus this
+constexpr int kE2M1MaxExponent = 2;
+
+// Nearest E2M1 encoding with ties to the even mantissa, saturating at +-6
+uint8_t quantize_e2m1(float value)
+{
+    static constexpr float kMagnitudes[8] = {0.f, 0.5f, 1.f, 1.5f, 2.f, 3.f, 4.f, 6.f};
+    float const magnitude = std::min(std::abs(value), kE2M1Max);
+    uint8_t code = 0;
+    for (uint8_t candidate = 1; candidate < 8; ++candidate)
+    {
+        float const diff = std::abs(magnitude - kMagnitudes[candidate]);
+        float const best = std::abs(magnitude - kMagnitudes[code]);
+        if (diff < best || (diff == best && candidate % 2 == 0))
+        {
+            code = candidate;
+        }
+    }
+    return code | (value < 0.f ? 0x8 : 0x0);
+}
+} // namespace
+
+template <typename WeightType>
+void block_scaled_fp4_quantize(int8_t* packed_weight, uint8_t* block_scales, float* global_scales,
+    WeightType const* input_weight_ptr, std::vector<size_t> const& shape, Fp4Format format)
+{
+    TLLM_CHECK_WITH_INFO(packed_weight, "Packed weight pointer is NULL");
+    TLLM_CHECK_WITH_INFO(block_scales, "Block scale output pointer is NULL");
+    TLLM_CHECK_WITH_INFO(input_weight_ptr, "Input weight pointer is NULL");
+
+    TLLM_CHECK_WITH_INFO(shape.size() == 2 || shape.size() == 3, "Shape must be 2-D or 3-D");
+    const size_t num_experts = shape.size() == 2 ? 1 : shape[0];
+    const size_t num_rows = shape.size() == 2 ? shape[0] : shape[1];
+    const size_t num_cols = shape.size() == 2 ? shape[1] : shape[2];
+
+    const size_t block_size = get_fp4_block_size(format);
+    TLLM_CHECK_WITH_INFO(
+        num_rows % block_size == 0, "The number of rows (%zu) must be a multiple of %zu", num_rows, block_size);
+    const size_t num_blocks = num_rows / block_size;
+
+    std::vector<float> block_max(num_cols);
+    for (size_t expert = 0; expert < num_experts; ++expert)
+    {
+        WeightType const* current_weight = input_weight_ptr + expert * num_rows * num_cols;
+        int8_t* current_packed_weight = packed_weight + expert * num_cols * num_rows / 2;
+        uint8_t* current_scales = block_scales + expert * num_blocks * num_cols;
+
+        // The NVFP4 per tensor scale maps the largest block scale to the largest e4m3 value
+        float global_scale = 1.f;
+        if (format == Fp4Format::NVFP4)
+        {
+            float tensor_max = 0.f;
+            for (size_t ii = 0; ii < num_rows * num_cols; ++ii)
+            {
+                tensor_max = std::max(tensor_max, std::abs(float(current_weight[ii])));
+            }
+            global_scale = tensor_max > 0.f ? tensor_max / (kE2M1Max * kE4M3Max) : 1.f;
+        }
+        if (global_scales != nullptr)
+        {
+            global_scales[expert] = global_scale;
+        }
+        std::fill(current_packed_weight, current_packed_weight + num_cols * num_rows / 2, 0);
+
+        for (size_t block = 0; block < num_blocks; ++block)
+        {
+            std::fill(block_max.begin(), block_max.end(), 0.f);
+            for (size_t ii = block * block_size; ii < (block + 1) * block_size; ++ii)
+            {
+                for (size_t jj = 0; jj < num_cols; ++jj)
+                {
+                    block_max[jj] = std::max(block_max[jj], std::abs(float(current_weight[ii * num_cols + jj])));
+                }
+            }
+
+            for (size_t jj = 0; jj < num_cols; ++jj)
+            {
+                // Scale that the stored element is multiplied by, as decoded by the kernel
+                float scale;
+                if (format == Fp4Format::NVFP4)
+                {
+                    __nv_fp8_e4m3 const stored_scale(block_max[jj] / kE2M1Max / global_scale);
+                    current_scales[block * num_cols + jj] = stored_scale.__x;
+                    scale = float(stored_scale) * global_scale;
+                }
+                else
+                {
+                    int const exponent = block_max[jj] > 0.f
+                        ? std::max(-127, std::min(127, std::ilogb(block_max[jj]) - kE2M1MaxExponent))
+                        : -127;
+                    current_scales[block * num_cols + jj] = static_cast<uint8_t>(exponent + 127);
+                    scale = std::ldexp(1.f, exponent);
+                }
+
+                for (size_t ii = block * block_size; ii < (block + 1) * block_size; ++ii)
+                {
+                    float const weight_elt = float(current_weight[ii * num_cols + jj]);
+                    uint8_t const code = scale != 0.f ? quantize_e2m1(weight_elt / scale) : 0;
+                    current_packed_weight[(jj * num_rows + ii) / 2] |= code << (4 * (ii % 2));
+                }
+            }
+        }
+    }
+}
+
+template void block_scaled_fp4_quantize<float>(
+    int8_t*, uint8_t*, float*, float const*, std::vector<size_t> const&, Fp4Format);
+
+template void block_scaled_fp4_quantize<half>(
+    int8_t*, uint8_t*, float*, half const*, std::vector<size_t> const&, Fp4Format);
+
+#ifdef ENABLE_BF16
+template void block_scaled_fp4_quantize<__nv_bfloat16>(
+    int8_t*, uint8_t*, float*, __nv_bfloat16 const*, std::vector<size_t> const&, Fp4Format);
+#endif
+
 } // namespace cutlass_kernels
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -17,7 +17,9 @@
 #pragma once
 
 #include <cstddef>
+#include <optional>
 #include <stdint.h>
+#include <string>
 #include <vector>
 
 #include "tensorrt_llm/common/cudaUtils.h"
@@ -60,6 +62,13 @@ void add_bias_and_interleave_quantized_tensor_inplace(int8_t* tensor, const size
 void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, int8_t const* row_major_quantized_weight,
     std::vector<size_t> const& shape, QuantType quant_type, bool force_interleave = false);
 
+// Same as above for the layout of `arch`, on up to `num_threads` threads and with the on-disk cache in `cache_dir`, if
+// set. The overload above uses the current GPU, TRTLLM_WEIGHT_PREPROCESS_THREADS and
+// TRTLLM_WEIGHT_PREPROCESS_CACHE_DIR. The output doesn't depend on the number of threads.
+void preprocess_weights_for_mixed_gemm(int8_t* preprocessed_quantized_weight, int8_t const* row_major_quantized_weight,
+    std::vector<size_t> const& shape, QuantType quant_type, int arch, int num_threads,
+    std::optional<std::string> const& cache_dir);
+
 template <typename ComputeType, typename WeightType>
 void symmetric_quantize(int8_t* processed_quantized_weight, ComputeType* scale_ptr, WeightType const* input_weight_ptr,
     std::vector<size_t> const& shape, QuantType quant_type, bool force_interleave);
@@ -71,6 +80,29 @@ void symmetric_quantize(int8_t* processed_quantized_weight, int8_t* unprocessed_
     ComputeType* scale_ptr, WeightType const* input_weight_ptr, std::vector<size_t> const& shape, QuantType quant_type,
     bool force_interleave);
 
+// Block scaled fp4 formats, both store E2M1 elements. NVFP4 has an e4m3 scale per 16 elements and a per tensor fp32
+// scale, MXFP4 has a power of two scale per 32 elements stored as its ue8m0 exponent.
+enum class Fp4Format
+{
+    NVFP4,
+    MXFP4
+};
+
+constexpr int get_fp4_block_size(Fp4Format format)
+{
+    return format == Fp4Format::NVFP4 ? 16 : 32;
+}
+
+// Quantizes a weight with 2-D shape [num_rows, num_cols] or 3-D shape [num_experts, num_rows, num_cols], where the
+// rows are the K dimension, to a block scaled fp4 format. The blocks run along K.
+//   packed_weight   - [num_experts, num_cols, num_rows / 2], two elements per byte with the lower row in the low
+//                     nibble. This is the non-interleaved column major layout of the weight-only GEMV.
+//   block_scales    - [num_experts, num_rows / get_fp4_block_size(format), num_cols], e4m3 or ue8m0.
+//   global_scales   - [num_experts], the NVFP4 per tensor scale to apply as the GEMM alpha, 1 for MXFP4. May be null.
+template <typename WeightType>
+void block_scaled_fp4_quantize(int8_t* packed_weight, uint8_t* block_scales, float* global_scales,
+    WeightType const* input_weight_ptr, std::vector<size_t> const& shape, Fp4Format format);
+
 } // namespace cutlass_kernels
 } // namespace kernels
 } // namespace tensorrt_llm
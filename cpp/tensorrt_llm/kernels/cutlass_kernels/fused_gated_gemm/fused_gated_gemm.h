@@ -32,6 +32,15 @@ namespace kernels
 namespace cutlass_kernels
 {
 
+// Activation of the gate, the output is (scale_d0 * up) * act(scale_d1 * gate)
+enum class GatedActivationType
+{
+    kSilu = 0,    // SwiGLU
+    kGelu,        // GeGLU, tanh approximation
+    kRelu,        // ReGLU
+    kSquaredRelu, // Gated squared ReLU
+};
+
 /*
   This runner supports:
 
@@ -61,7 +70,7 @@ template <typename T>
 class CutlassFusedGatedGemmRunner : public virtual CutlassFusedGatedGemmRunnerInterface
 {
 public:
-    CutlassFusedGatedGemmRunner();
+    explicit CutlassFusedGatedGemmRunner(GatedActivationType activation = GatedActivationType::kSilu);
     ~CutlassFusedGatedGemmRunner();
 
     void gemm(void* D, void const* A, void const* B, void const* C_bias, tk::QuantMode quantOption, int m, int n, int k,
@@ -81,6 +90,7 @@ private:
     size_t getWorkspaceSizeImpl(int const m, int const n, int const k);
 
     int mSm;
+    GatedActivationType mActivation;
 };
 
 } // namespace cutlass_kernels
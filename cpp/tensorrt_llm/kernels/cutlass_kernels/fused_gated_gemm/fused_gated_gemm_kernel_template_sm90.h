@@ -32,6 +32,7 @@
 #include "cutlass/gemm/dispatch_policy.hpp"
 
 #include "cutlass/epilogue/thread/activation.h"
+#include "cutlass_extensions/epilogue/thread/fused_activations.h"
 #include "cutlass_extensions/gemm/collective/collective_builder_gated.hpp"
 #include "cutlass_extensions/gemm/kernel/gemm_universal_gated.hpp"
 
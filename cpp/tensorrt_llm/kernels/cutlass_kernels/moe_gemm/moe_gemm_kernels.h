@@ -164,11 +164,12 @@ public:
 
     void moeGemmBiasAct(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
         int64_t* total_rows_before_expert, HopperGroupedGemmInput layout_info, int64_t total_rows, int64_t gemm_n,
-        int64_t gemm_k, int num_experts, ActivationType activation_type, bool use_fused_moe, cudaStream_t stream);
+        int64_t gemm_k, int64_t group_size, int num_experts, ActivationType activation_type, bool use_fused_moe,
+        cudaStream_t stream);
 
     void moeGemm(T const* A, WeightType const* B, T const* weight_scales, T* C, int64_t* total_rows_before_expert,
-        HopperGroupedGemmInput layout_info, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-        bool use_fused_moe, cudaStream_t stream);
+        HopperGroupedGemmInput layout_info, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+        int num_experts, bool use_fused_moe, cudaStream_t stream);
 
     std::vector<cutlass_extensions::CutlassGemmConfig> getConfigs() const;
     static std::vector<cutlass_extensions::CutlassGemmConfig> getConfigs(int sm);
@@ -187,13 +188,13 @@ private:
     template <typename EpilogueTag>
     void dispatchToArch(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
         int64_t* total_rows_before_expert, HopperGroupedGemmInput layout_info, int64_t total_rows, int64_t gemm_n,
-        int64_t gemm_k, int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, bool use_fused_moe,
-        cudaStream_t stream, int* occupancy = nullptr);
+        int64_t gemm_k, int64_t group_size, int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config,
+        bool use_fused_moe, cudaStream_t stream, int* occupancy = nullptr);
 
     template <typename EpilogueTag>
     void runGemm(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
         int64_t* total_rows_before_expert, HopperGroupedGemmInput layout_info, int64_t total_rows, int64_t gemm_n,
-        int64_t gemm_k, int num_experts, bool use_fused_moe, cudaStream_t stream);
+        int64_t gemm_k, int64_t group_size, int num_experts, bool use_fused_moe, cudaStream_t stream);
 
 private:
     int sm_{};
@@ -70,10 +70,11 @@ namespace kernels::cutlass_kernels
 {
 
 // ============================= Variable batched Gemm things ===========================
-template <typename T, typename WeightType, typename arch, typename EpilogueTag, typename ThreadblockShape,
-    typename WarpShape, int Stages>
+template <typename T, typename WeightType, typename arch, cutlass::WeightOnlyQuantOp QuantOp, typename EpilogueTag,
+    typename ThreadblockShape, typename WarpShape, int Stages>
 void genericMoeGemmKernelLauncher(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
+    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts,
     cutlass_extensions::CutlassGemmConfig gemm_config, int const multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* kernel_occupancy = nullptr)
 {
@@ -107,6 +108,9 @@ void genericMoeGemmKernelLauncher(T const* A, WeightType const* B, T const* weig
         using EpilogueOp = typename tensorrt_llm::cutlass_extensions::Epilogue<ElementType,
             MixedGemmArchTraits::ElementsPerAccessC, ElementAccumulator, EpilogueTag>::Op;
 
+        using Operator = typename MixedGemmArchTraits::Operator;
+        using TaggedOperator = typename cutlass::arch::TagOperator<Operator, QuantOp>::TaggedOperator;
+
         // Finally, set up the kernel.
         using GemmKernel_ = typename cutlass::gemm::kernel::DefaultGemmGrouped<ElementType, cutlass::layout::RowMajor,
             cutlass::ComplexTransform::kNone, MixedGemmArchTraits::ElementsPerAccessA, CutlassWeightType,
@@ -115,7 +119,7 @@ void genericMoeGemmKernelLauncher(T const* A, WeightType const* B, T const* weig
             typename MixedGemmArchTraits::OperatorClass, arch, ThreadblockShape, WarpShape,
             typename MixedGemmArchTraits::InstructionShape, EpilogueOp,
             cutlass::gemm::threadblock::GemmBatchedIdentityThreadblockSwizzle, Stages,
-            cutlass::gemm::kernel::GroupScheduleMode::kDeviceOnly, typename MixedGemmArchTraits::Operator>::GemmKernel;
+            cutlass::gemm::kernel::GroupScheduleMode::kDeviceOnly, TaggedOperator>::GemmKernel;
 
         using GemmKernel = cutlass::gemm::kernel::MoeFCGemm<typename GemmKernel_::Mma, typename GemmKernel_::Epilogue,
             typename GemmKernel_::ThreadblockSwizzle,
@@ -136,7 +140,6 @@ void genericMoeGemmKernelLauncher(T const* A, WeightType const* B, T const* weig
         typename EpilogueOp::Params epilogue_op(
             ElementAccumulator(1.f), biases ? ElementAccumulator(1.f) : ElementAccumulator(0.f));
 
-        int const group_size = gemm_k;
         typename GemmGrouped::Arguments args(num_experts, threadblock_count, group_size, epilogue_op,
             reinterpret_cast<ElementType const*>(A), reinterpret_cast<CutlassWeightType const*>(B),
             reinterpret_cast<ElementType const*>(weight_scales), reinterpret_cast<ElementType const*>(biases),
@@ -176,17 +179,31 @@ void genericMoeGemmKernelLauncher(T const* A, WeightType const* B, T const* weig
 template <typename T, typename WeightType, typename Arch, typename EpilogueTag, typename ThreadblockShape,
     typename WarpShape, int Stages>
 static void dispatch(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
+    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* occupancy = nullptr)
 {
     static_assert(!std::is_same_v<Arch, cutlass::arch::Sm90>, "Use TMA specialised functions for arch SM90");
     constexpr bool isFp8 = std::is_same_v<T, __nv_fp8_e4m3> || std::is_same_v<T, __nv_fp8_e5m2>;
     if constexpr ((Stages == 2 || Arch::kMinComputeCapability >= 80) && !isFp8)
     {
-        kernels::cutlass_kernels::genericMoeGemmKernelLauncher<T, WeightType, Arch, EpilogueTag, ThreadblockShape,
-            WarpShape, Stages>(A, B, weight_scales, biases, C, total_rows_before_expert, num_rows, gemm_n, gemm_k,
-            num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+        // Groupwise scales are only instantiated for the weight only quantized GEMMs using the multistage mainloop
+        if constexpr (!std::is_same_v<T, WeightType> && Arch::kMinComputeCapability >= 80)
+        {
+            if (group_size != gemm_k)
+            {
+                kernels::cutlass_kernels::genericMoeGemmKernelLauncher<T, WeightType, Arch,
+                    cutlass::WeightOnlyQuantOp::FINEGRAINED_SCALE_ONLY, EpilogueTag, ThreadblockShape, WarpShape,
+                    Stages>(A, B, weight_scales, biases, C, total_rows_before_expert, num_rows, gemm_n, gemm_k,
+                    group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+                return;
+            }
+        }
+        TLLM_CHECK_WITH_INFO(group_size == gemm_k, "Groupwise scales require weight only quantization on SM80+");
+        kernels::cutlass_kernels::genericMoeGemmKernelLauncher<T, WeightType, Arch,
+            cutlass::WeightOnlyQuantOp::PER_COLUMN_SCALE_ONLY, EpilogueTag, ThreadblockShape, WarpShape, Stages>(A, B,
+            weight_scales, biases, C, total_rows_before_expert, num_rows, gemm_n, gemm_k, group_size, num_experts,
+            gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
     }
     else
     {
@@ -198,26 +215,26 @@ static void dispatch(T const* A, WeightType const* B, T const* weight_scales, T
 template <typename T, typename WeightType, typename arch, typename EpilogueTag, typename ThreadblockShape,
     typename WarpShape>
 void dispatchGemmConfig(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
+    int64_t* total_rows_before_expert, int64_t num_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* occupancy = nullptr)
 {
     switch (gemm_config.stages)
     {
     case 2:
         dispatch<T, WeightType, arch, EpilogueTag, ThreadblockShape, WarpShape, 2>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, num_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, num_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count, use_fused_moe, stream, occupancy);
         break;
     case 3:
         dispatch<T, WeightType, arch, EpilogueTag, ThreadblockShape, WarpShape, 3>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, num_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, num_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count, use_fused_moe, stream, occupancy);
         break;
     case 4:
         dispatch<T, WeightType, arch, EpilogueTag, ThreadblockShape, WarpShape, 4>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, num_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, num_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count, use_fused_moe, stream, occupancy);
         break;
     default: TLLM_THROW("dispatchGemmConfig does not support stages %d", gemm_config.stages); break;
     }
@@ -228,8 +245,8 @@ void dispatchGemmConfig(T const* A, WeightType const* B, T const* weight_scales,
 template <typename T, typename WeightType, typename arch, typename EpilogueTag,
     typename std::enable_if<!std::is_same<T, float>::value && std::is_same<T, WeightType>::value>::type* = nullptr>
 void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
+    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* occupancy = nullptr)
 {
     switch (gemm_config.tile_config)
@@ -240,8 +257,8 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
         {
             dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<16, 128, 64>,
                 cutlass::gemm::GemmShape<16, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert,
-                total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
-                occupancy);
+                total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe,
+                stream, occupancy);
         }
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape16x256x64_WarpShape16x64x64:
@@ -250,24 +267,27 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
         {
             dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<16, 256, 64>,
                 cutlass::gemm::GemmShape<16, 64, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert,
-                total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
-                occupancy);
+                total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe,
+                stream, occupancy);
         }
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape32x128x64_WarpShape32x32x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<32, 128, 64>,
             cutlass::gemm::GemmShape<32, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape64x128x64_WarpShape32x64x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<64, 128, 64>,
             cutlass::gemm::GemmShape<32, 64, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape128x128x64_WarpShape64x32x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<128, 128, 64>,
             cutlass::gemm::GemmShape<64, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::Undefined: TLLM_THROW("GEMM config undefined."); break;
     case cutlass_extensions::CutlassTileConfig::ChooseWithHeuristic:
@@ -283,8 +303,8 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
 template <typename T, typename WeightType, typename arch, typename EpilogueTag,
     typename std::enable_if<!std::is_same<T, float>::value && !std::is_same<T, WeightType>::value>::type* = nullptr>
 void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
+    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* occupancy = nullptr)
 {
     switch (gemm_config.tile_config)
@@ -295,8 +315,8 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
         {
             dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<16, 128, 64>,
                 cutlass::gemm::GemmShape<16, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert,
-                total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
-                occupancy);
+                total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe,
+                stream, occupancy);
         }
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape16x256x64_WarpShape16x64x64:
@@ -305,24 +325,27 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
         {
             dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<16, 256, 64>,
                 cutlass::gemm::GemmShape<16, 64, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert,
-                total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
-                occupancy);
+                total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe,
+                stream, occupancy);
         }
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape32x128x64_WarpShape32x32x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<32, 128, 64>,
             cutlass::gemm::GemmShape<32, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape64x128x64_WarpShape64x32x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<64, 128, 64>,
             cutlass::gemm::GemmShape<64, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::CtaShape128x128x64_WarpShape128x32x64:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<128, 128, 64>,
             cutlass::gemm::GemmShape<128, 32, 64>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::Undefined: TLLM_THROW("GEMM config undefined."); break;
     case cutlass_extensions::CutlassTileConfig::ChooseWithHeuristic:
@@ -336,8 +359,8 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
 template <typename T, typename WeightType, typename arch, typename EpilogueTag,
     typename std::enable_if<std::is_same<T, float>::value>::type* = nullptr>
 void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_scales, T const* biases, T* C,
-    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int num_experts,
-    cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
+    int64_t* total_rows_before_expert, int64_t total_rows, int64_t gemm_n, int64_t gemm_k, int64_t group_size,
+    int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config, int multi_processor_count, bool use_fused_moe,
     cudaStream_t stream, int* occupancy = nullptr)
 {
     switch (gemm_config.tile_config)
@@ -345,7 +368,8 @@ void dispatchMoeGemmToCutlass(T const* A, WeightType const* B, T const* weight_s
     case cutlass_extensions::CutlassTileConfig::CtaShape128x128x8_WarpShape64x64x8:
         dispatchGemmConfig<T, WeightType, arch, EpilogueTag, cutlass::gemm::GemmShape<128, 128, 8>,
             cutlass::gemm::GemmShape<64, 64, 8>>(A, B, weight_scales, biases, C, total_rows_before_expert, total_rows,
-            gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream, occupancy);
+            gemm_n, gemm_k, group_size, num_experts, gemm_config, multi_processor_count, use_fused_moe, stream,
+            occupancy);
         break;
     case cutlass_extensions::CutlassTileConfig::Undefined: TLLM_THROW("GEMM config undefined."); break;
     case cutlass_extensions::CutlassTileConfig::ChooseWithHeuristic:
@@ -464,8 +488,8 @@ template <typename T, typename WeightType>
 template <typename EpilogueTag>
 void MoeGemmRunner<T, WeightType>::dispatchToArch<EpilogueTag>(T const* A, WeightType const* B, T const* weight_scales,
     T const* biases, T* C, int64_t* total_rows_before_expert, HopperGroupedGemmInput hopper_input, int64_t total_rows,
-    int64_t gemm_n, int64_t gemm_k, int num_experts, cutlass_extensions::CutlassGemmConfig gemm_config,
-    bool use_fused_moe, cudaStream_t stream, int* occupancy)
+    int64_t gemm_n, int64_t gemm_k, int64_t group_size, int num_experts,
+    cutlass_extensions::CutlassGemmConfig gemm_config, bool use_fused_moe, cudaStream_t stream, int* occupancy)
 {
 
     TLLM_CHECK_WITH_INFO(
@@ -476,20 +500,20 @@ void MoeGemmRunner<T, WeightType>::dispatchToArch<EpilogueTag>(T const* A, Weigh
     if (sm_ >= 70 && sm_ < 75)
     {
         dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm70, EpilogueTag>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count_,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count_, use_fused_moe, stream, occupancy);
     }
     else if (sm_ >= 75 && sm_ < 80)
     {
         dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm75, EpilogueTag>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count_,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count_, use_fused_moe, stream, occupancy);
     }
     else if (sm_ >= 80 && sm_ < 90)
     {
         dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm80, EpilogueTag>(A, B, weight_scales, biases, C,
-            total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count_,
-            use_fused_moe, stream, occupancy);
+            total_rows_before_expert, total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+            multi_processor_count_, use_fused_moe, stream, occupancy);
     }
     else if (sm_ >= 90)
     {
@@ -521,8 +545,8 @@ void MoeGemmRunner<T, WeightType>::dispatchToArch<EpilogueTag>(T const* A, Weigh
                 "GEMM config is for SM90 configuration, but this configuration is not valid for Hppper");
 
             dispatchMoeGemmToCutlass<T, WeightType, cutlass::arch::Sm80, EpilogueTag>(A, B, weight_scales, biases, C,
-                total_rows_before_expert, total_rows, gemm_n, gemm_k, num_experts, gemm_config, multi_processor_count_,
-                use_fused_moe, stream, occupancy);
+                total_rows_before_expert, total_rows, gemm_n, gemm_k, group_size, num_experts, gemm_config,
+                multi_processor_count_, use_fused_moe, stream, occupancy);
         }
         else
         {
@@ -587,45 +611,45 @@ template <typename T, typename WeightType>
 template <typename EpilogueTag>
 void MoeGemmRunner<T, WeightType>::runGemm<EpilogueTag>(T const* A, WeightType const* B, T const* weight_scales,
     T const* biases, T* C, int64_t* total_rows_before_expert, HopperGroupedGemmInput hopper_input, int64_t total_rows,
-    int64_t gemm_n, int64_t gemm_k, int num_experts, bool use_fused_moe, cudaStream_t stream)
+    int64_t gemm_n, int64_t gemm_k, int64_t group_size, int num_experts, bool use_fused_moe, cudaStream_t stream)
 {
     TLLM_CHECK_WITH_INFO(this->best_config_, "No MOE GEMM config set at runtime");
     auto chosen_conf = *this->best_config_;
     dispatchToArch<EpilogueTag>(A, B, weight_scales, biases, C, total_rows_before_expert, hopper_input, total_rows,
-        gemm_n, gemm_k, num_experts, chosen_conf, use_fused_moe, stream);
+        gemm_n, gemm_k, group_size, num_experts, chosen_conf, use_fused_moe, stream);
 }
 
 template <typename T, typename WeightType>
 void MoeGemmRunner<T, WeightType>::moeGemmBiasAct(T const* A, WeightType const* B, T const* weight_scales,
     T const* biases, T* C, int64_t* total_rows_before_expert, HopperGroupedGemmInput hopper_input, int64_t total_rows,
-    int64_t gemm_n, int64_t gemm_k, int num_experts, ActivationType activation_type, bool use_fused_moe,
-    cudaStream_t stream)
+    int64_t gemm_n, int64_t gemm_k, int64_t group_size, int num_experts, ActivationType activation_type,
+    bool use_fused_moe, cudaStream_t stream)
 {
     switch (activation_type)
     {
     case ActivationType::Relu:
         runGemm<cutlass_extensions::EpilogueOpDefaultReLU>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::Gelu:
         runGemm<cutlass_extensions::EpilogueOpDefaultFtGelu>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::Silu:
         runGemm<cutlass_extensions::EpilogueOpDefaultSilu>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::Identity:
         runGemm<cutlass_extensions::EpilogueOpDefault>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::Swiglu:
         runGemm<cutlass_extensions::EpilogueOpDefaultSilu>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::Geglu:
         runGemm<cutlass_extensions::EpilogueOpDefaultFtGelu>(A, B, weight_scales, biases, C, total_rows_before_expert,
-            hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+            hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
         break;
     case ActivationType::InvalidType: TLLM_THROW("Activation type for fpA_intB must be valid."); break;
     default: TLLM_THROW("Invalid activation type."); break;
@@ -635,10 +659,10 @@ void MoeGemmRunner<T, WeightType>::moeGemmBiasAct(T const* A, WeightType const*
 template <typename T, typename WeightType>
 void MoeGemmRunner<T, WeightType>::moeGemm(T const* A, WeightType const* B, T const* weight_scales, T* C,
     int64_t* total_rows_before_expert, HopperGroupedGemmInput hopper_input, int64_t total_rows, int64_t gemm_n,
-    int64_t gemm_k, int num_experts, bool use_fused_moe, cudaStream_t stream)
+    int64_t gemm_k, int64_t group_size, int num_experts, bool use_fused_moe, cudaStream_t stream)
 {
     runGemm<cutlass_extensions::EpilogueOpDefault>(A, B, weight_scales, nullptr, C, total_rows_before_expert,
-        hopper_input, total_rows, gemm_n, gemm_k, num_experts, use_fused_moe, stream);
+        hopper_input, total_rows, gemm_n, gemm_k, group_size, num_experts, use_fused_moe, stream);
 }
 
 } // namespace tensorrt_llm
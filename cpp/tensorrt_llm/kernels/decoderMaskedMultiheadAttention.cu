@@ -30,8 +30,7 @@ namespace mmha
 // Forward declaration of the kernel launcher to avoid including decoderMaskedMultiheadAttentionLaunch.h
 template <typename T, typename KVCacheBuffer, typename T_PARAMS, int Dh, bool BLOCK_SPARSE_ATTN,
     bool IMPLICIT_REL_ATTN_BIAS, bool QK_TANH_SCALE>
-void mmha_launch_kernel(const T_PARAMS& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream);
+void mmha_launch_kernel(const T_PARAMS& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream);
 
 } // namespace mmha
 
@@ -40,19 +39,19 @@ namespace
 
 #define MMHA_LAUNCH_KERNEL(Dh)                                                                                         \
     mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, false, false>(                           \
-        params, kv_cache_buffer, shift_k_cache, stream);                                                               \
+        params, kv_cache_buffer, stream);                                                                              \
     break;
 
 #define MMHA_LAUNCH_KERNE_EX1(Dh)                                                                                      \
     if (has_implicit_rel_attn_bias)                                                                                    \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, true, false>(                        \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     else                                                                                                               \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, false, false>(                       \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     break;
 
@@ -60,28 +59,28 @@ namespace
     if (has_implicit_rel_attn_bias)                                                                                    \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, true, false>(                        \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     else if (has_qk_tanh_scale)                                                                                        \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, false, true>(                        \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     else if (has_block_sparse_attn)                                                                                    \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, true, false, false>(                        \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     else                                                                                                               \
     {                                                                                                                  \
         mmha::mmha_launch_kernel<T, KVCacheBuffer, KERNEL_PARAMS_TYPE, Dh, false, false, false>(                       \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     break;
 
 template <typename T, typename KVCacheBuffer, typename KERNEL_PARAMS_TYPE>
-void multihead_attention_(const KERNEL_PARAMS_TYPE& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream)
+void multihead_attention_(
+    const KERNEL_PARAMS_TYPE& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream)
 {
     bool const has_implicit_rel_attn_bias = params.max_distance > 0 && params.relative_attention_bias != nullptr;
     bool const has_qk_tanh_scale = params.qk_tanh_scale > 0.f;
@@ -138,16 +137,16 @@ bool mmha_supported(int head_size)
 
 #define INSTANTIATE_MMHA_NORMAL_AND_PAGED(T, CROSS_ATTENTION)                                                          \
     void masked_multihead_attention(const Multihead_attention_params<T, CROSS_ATTENTION>& params,                      \
-        const KVBlockArray& kv_cache_buffer, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream)          \
+        const KVBlockArray& kv_cache_buffer, const cudaStream_t& stream)                                               \
     {                                                                                                                  \
         multihead_attention_<T, KVBlockArray, Multihead_attention_params<T, CROSS_ATTENTION>>(                         \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }                                                                                                                  \
     void masked_multihead_attention(const Multihead_attention_params<T, CROSS_ATTENTION>& params,                      \
-        const KVLinearBuffer& kv_cache_buffer, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream)        \
+        const KVLinearBuffer& kv_cache_buffer, const cudaStream_t& stream)                                             \
     {                                                                                                                  \
         multihead_attention_<T, KVLinearBuffer, Multihead_attention_params<T, CROSS_ATTENTION>>(                       \
-            params, kv_cache_buffer, shift_k_cache, stream);                                                           \
+            params, kv_cache_buffer, stream);                                                                          \
     }
 INSTANTIATE_MMHA_NORMAL_AND_PAGED(float, true)
 INSTANTIATE_MMHA_NORMAL_AND_PAGED(float, false)
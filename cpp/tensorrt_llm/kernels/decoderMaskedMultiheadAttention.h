@@ -181,6 +181,9 @@ struct Multihead_attention_params_base
 
     mutable int min_seq_len_tile = 1;
     mutable int max_seq_len_tile = 1;
+    // Sum of the kv lengths of the sequences in the batch, known on the host. Balances seq_len_tile on the actual
+    // lengths instead of the longest sequence, 0 if unknown.
+    int64_t total_kv_length = 0;
     // The partial output buffer. Dimensions max_seq_len_tile x B x D. (for each timestep only seq_len_tile x B x D is
     // needed)
     T* partial_out = nullptr;
@@ -244,13 +247,13 @@ bool mmha_supported(int head_size);
 
 #define DECLARE_MMHA_NORMAL_AND_PAGED(T)                                                                               \
     void masked_multihead_attention(const Masked_multihead_attention_params<T>& params,                                \
-        const KVBlockArray& block_array, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);             \
+        const KVBlockArray& block_array, const cudaStream_t& stream);                                                  \
     void masked_multihead_attention(const Masked_multihead_attention_params<T>& params,                                \
-        const KVLinearBuffer& kv_cache_buffer, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);       \
+        const KVLinearBuffer& kv_cache_buffer, const cudaStream_t& stream);                                            \
     void masked_multihead_attention(const Cross_multihead_attention_params<T>& params,                                 \
-        const KVBlockArray& block_array, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);             \
+        const KVBlockArray& block_array, const cudaStream_t& stream);                                                  \
     void masked_multihead_attention(const Cross_multihead_attention_params<T>& params,                                 \
-        const KVLinearBuffer& kv_cache_buffer, const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);
+        const KVLinearBuffer& kv_cache_buffer, const cudaStream_t& stream);
 DECLARE_MMHA_NORMAL_AND_PAGED(float);
 DECLARE_MMHA_NORMAL_AND_PAGED(uint16_t);
 #ifdef ENABLE_BF16
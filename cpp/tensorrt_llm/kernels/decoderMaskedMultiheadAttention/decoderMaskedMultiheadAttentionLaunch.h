@@ -109,6 +109,18 @@ inline void multi_block_grid_setup(dim3& grid, Multihead_attention_params<T, DO_
     int const threads_per_value = mmha::threads_per_value<T>(mmha::dh_max(Dh));
     // Make sure that each block at least processes one loop of kv (unroll size is default at 8).
     int const seq_len_per_kv_loop = mmha::divUp(block_size, threads_per_value) * 8;
+
+    if (params.total_kv_length > 0)
+    {
+        // Balance the work of the actual lengths of the batch over one wave of blocks instead of assuming that all
+        // the sequences are as long as the longest one. A skewed batch splits the long sequences further, the tiles
+        // past the end of the short sequences skip their kv loops. Equal lengths give the same split as above.
+        auto const total_work = static_cast<int64_t>(params.num_heads) * params.total_kv_length;
+        auto const timesteps_per_tile = std::max(static_cast<int64_t>(seq_len_per_kv_loop),
+            mmha::divUp(total_work, static_cast<int64_t>(params.multi_processor_count)));
+        int const kv_length = std::min(tlength, params.cyclic_attention_window_size) + 1;
+        balanced_seq_len_tile = static_cast<int>(mmha::divUp(static_cast<int64_t>(kv_length), timesteps_per_tile));
+    }
     int max_seq_len_tile = params.max_seq_len_tile;
 
     bool const multi_block_debug_flag = getEnvMmhaMultiblockDebug();
@@ -306,14 +318,23 @@ void mmha_launch_kernel_ex(KernelParamsType const& params, KVCacheBuffer const&
 
 template <typename T, typename T_cache, typename KVCacheBuffer, typename KernelParamsType, int Dh, int THDS_PER_BLOCK,
     bool HAS_BEAMS, bool DO_MULTI_BLOCK, bool BLOCK_SPARSE_ATTN, bool IMPLICIT_REL_ATTN_BIAS, bool QK_TANH_SCALE>
-void mmha_launch_kernel_dispatch_pos_shift(KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream, int tlength)
+void mmha_launch_kernel_dispatch_pos_shift(
+    KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream, int tlength)
 {
+    TLLM_CHECK_WITH_INFO(
+        !kv_cache_buffer.hasTokenScales() || (!params.position_shift_enabled && !KernelParamsType::DO_CROSS_ATTENTION),
+        "Per-token kv cache scales are not supported with position shift or cross attention.");
     if (params.position_shift_enabled && !KernelParamsType::DO_CROSS_ATTENTION)
     {
-        mmha_launch_kernel_ex<T, T_cache, T, KVCacheBuffer, KVLinearBuffer, KernelParamsType, Dh, THDS_PER_BLOCK,
+        // The cache holds the keys without position embedding, and the kernel rotates them at their position in the
+        // attention window. GPT-NeoX pairs vectors of channels half a rotary dimension apart.
+        TLLM_CHECK_WITH_INFO((params.position_embedding_type != PositionEmbeddingType::kROPE_GPT_NEOX
+                                 && params.position_embedding_type != PositionEmbeddingType::kLONG_ROPE)
+                || (params.rotary_embedding_dim / 2) % (16 / sizeof(T)) == 0,
+            "Position shift doesn't support the rotary embedding dimension %d.", params.rotary_embedding_dim);
+        mmha_launch_kernel_ex<T, T_cache, T_cache, KVCacheBuffer, KVCacheBuffer, KernelParamsType, Dh, THDS_PER_BLOCK,
             HAS_BEAMS, DO_MULTI_BLOCK, true, BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            params, kv_cache_buffer, kv_cache_buffer, stream, tlength);
     }
     else
     {
@@ -325,55 +346,53 @@ void mmha_launch_kernel_dispatch_pos_shift(KernelParamsType const& params, KVCac
 
 template <typename T, typename KVCacheBuffer, typename KernelParamsType, int Dh, int THDS_PER_BLOCK, bool HAS_BEAMS,
     bool DO_MULTI_BLOCK, bool BLOCK_SPARSE_ATTN, bool IMPLICIT_REL_ATTN_BIAS, bool QK_TANH_SCALE>
-void mmha_launch_kernel_dispatch_8bits_kv_cache(KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream, int tlength)
+void mmha_launch_kernel_dispatch_8bits_kv_cache(
+    KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream, int tlength)
 {
     if (params.int8_kv_cache)
     {
         mmha_launch_kernel_dispatch_pos_shift<T, int8_t, KVCacheBuffer, KernelParamsType, Dh, THDS_PER_BLOCK, HAS_BEAMS,
             DO_MULTI_BLOCK, BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            params, kv_cache_buffer, stream, tlength);
     }
 #ifdef ENABLE_FP8
     else if (params.fp8_kv_cache)
     {
         mmha_launch_kernel_dispatch_pos_shift<T, __nv_fp8_e4m3, KVCacheBuffer, KernelParamsType, Dh, THDS_PER_BLOCK,
             HAS_BEAMS, DO_MULTI_BLOCK, BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            params, kv_cache_buffer, stream, tlength);
     }
 #endif // ENABLE_FP8
     else
     {
         mmha_launch_kernel_dispatch_pos_shift<T, T, KVCacheBuffer, KernelParamsType, Dh, THDS_PER_BLOCK, HAS_BEAMS,
             DO_MULTI_BLOCK, BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            params, kv_cache_buffer, stream, tlength);
     }
 }
 
 template <typename T, typename KVCacheBuffer, typename KernelParamsType, int Dh, bool HAS_BEAMS, bool BLOCK_SPARSE_ATTN,
     bool IMPLICIT_REL_ATTN_BIAS, bool QK_TANH_SCALE>
-void mmha_launch_kernel_dispatch(KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream)
+void mmha_launch_kernel_dispatch(
+    KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream)
 {
     int const tlength = params.timestep;
     if (params.multi_block_mode)
     {
         mmha_launch_kernel_dispatch_8bits_kv_cache<T, KVCacheBuffer, KernelParamsType, Dh, 256, HAS_BEAMS, true,
-            BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, stream, tlength);
     }
     else
     {
         mmha_launch_kernel_dispatch_8bits_kv_cache<T, KVCacheBuffer, KernelParamsType, Dh, 256, HAS_BEAMS, false,
-            BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(
-            params, kv_cache_buffer, shift_k_cache, stream, tlength);
+            BLOCK_SPARSE_ATTN, IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, stream, tlength);
     }
 }
 
 template <typename T, typename KVCacheBuffer, typename KernelParamsType, int Dh, bool BLOCK_SPARSE_ATTN,
     bool IMPLICIT_REL_ATTN_BIAS, bool QK_TANH_SCALE>
-void mmha_launch_kernel(KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer,
-    KVLinearBuffer const& shift_k_cache, cudaStream_t const& stream)
+void mmha_launch_kernel(
+    KernelParamsType const& params, KVCacheBuffer const& kv_cache_buffer, cudaStream_t const& stream)
 {
     assert((params.rotary_embedding_dim != 0)
         == (params.position_embedding_type == PositionEmbeddingType::kROPE_GPT_NEOX
@@ -382,12 +401,12 @@ void mmha_launch_kernel(KernelParamsType const& params, KVCacheBuffer const& kv_
     if (params.beam_width == 1)
     {
         mmha_launch_kernel_dispatch<T, KVCacheBuffer, KernelParamsType, Dh, false, BLOCK_SPARSE_ATTN,
-            IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, shift_k_cache, stream);
+            IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, stream);
     }
     else
     {
         mmha_launch_kernel_dispatch<T, KVCacheBuffer, KernelParamsType, Dh, true, BLOCK_SPARSE_ATTN,
-            IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, shift_k_cache, stream);
+            IMPLICIT_REL_ATTN_BIAS, QK_TANH_SCALE>(params, kv_cache_buffer, stream);
     }
 }
 
@@ -396,58 +415,58 @@ void mmha_launch_kernel(KernelParamsType const& params, KVCacheBuffer const& kv_
 #define INSTANTIATE_MMHA_LAUNCHERS(T, Dh)                                                                              \
     template void mmha_launch_kernel<T, KVLinearBuffer, Masked_multihead_attention_params<T>, Dh, false, false,        \
         false>(const Masked_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,              \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Masked_multihead_attention_params<T>, Dh, false, false, false>(  \
         const Masked_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                       \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVLinearBuffer, Cross_multihead_attention_params<T>, Dh, false, false, false>( \
         const Cross_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                      \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Cross_multihead_attention_params<T>, Dh, false, false, false>(   \
         const Cross_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                        \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);
+        const cudaStream_t& stream);
 
 #define INSTANTIATE_MMHA_LAUNCHERS_WITH_IMPLICIT_REL_ATTN_BIAS(T, Dh)                                                  \
     template void mmha_launch_kernel<T, KVLinearBuffer, Masked_multihead_attention_params<T>, Dh, false, true, false>( \
         const Masked_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                     \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Masked_multihead_attention_params<T>, Dh, false, true, false>(   \
         const Masked_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                       \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVLinearBuffer, Cross_multihead_attention_params<T>, Dh, false, true, false>(  \
         const Cross_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                      \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Cross_multihead_attention_params<T>, Dh, false, true, false>(    \
         const Cross_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                        \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);
+        const cudaStream_t& stream);
 
 #define INSTANTIATE_MMHA_LAUNCHERS_WITH_QK_TANH_SCALE(T, Dh)                                                           \
     template void mmha_launch_kernel<T, KVLinearBuffer, Masked_multihead_attention_params<T>, Dh, false, false, true>( \
         const Masked_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                     \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Masked_multihead_attention_params<T>, Dh, false, false, true>(   \
         const Masked_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                       \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVLinearBuffer, Cross_multihead_attention_params<T>, Dh, false, false, true>(  \
         const Cross_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                      \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Cross_multihead_attention_params<T>, Dh, false, false, true>(    \
         const Cross_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                        \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);
+        const cudaStream_t& stream);
 
 #define INSTANTIATE_MMHA_LAUNCHERS_WITH_BLOCK_SPARSE_ATTN(T, Dh)                                                       \
     template void mmha_launch_kernel<T, KVLinearBuffer, Masked_multihead_attention_params<T>, Dh, true, false, false>( \
         const Masked_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                     \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Masked_multihead_attention_params<T>, Dh, true, false, false>(   \
         const Masked_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                       \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVLinearBuffer, Cross_multihead_attention_params<T>, Dh, true, false, false>(  \
         const Cross_multihead_attention_params<T>& params, const KVLinearBuffer& kv_cache_buffer,                      \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);                                              \
+        const cudaStream_t& stream);                                                                                   \
     template void mmha_launch_kernel<T, KVBlockArray, Cross_multihead_attention_params<T>, Dh, true, false, false>(    \
         const Cross_multihead_attention_params<T>& params, const KVBlockArray& kv_cache_buffer,                        \
-        const KVLinearBuffer& shift_k_cache, const cudaStream_t& stream);
+        const cudaStream_t& stream);
 
 } // namespace kernels
 } // namespace tensorrt_llm
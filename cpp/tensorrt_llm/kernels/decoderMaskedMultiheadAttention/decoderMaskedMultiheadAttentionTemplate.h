@@ -951,23 +951,108 @@ struct Qk_dot<uint16_t, THREADS_PER_KEY>
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+template <typename Tcache>
+inline __device__ float cache_elt_to_float(Tcache u)
+{
+    return convert_to_float(u);
+}
+
+template <>
+inline __device__ float cache_elt_to_float(int8_t u)
+{
+    return float_from_int8(u);
+}
+
+#ifdef ENABLE_FP8
+template <>
+inline __device__ float cache_elt_to_float(__nv_fp8_e4m3 u)
+{
+    return float(u);
+}
+#endif // ENABLE_FP8
+
+// The position in the attention window of the key at index ti of the kv loop, with position shift.
+// Without one more block, the cyclic part of the cache is not in the order of the positions once it wraps around.
+template <typename KVCacheBuffer>
+inline __device__ int pos_shift_key_position(KVCacheBuffer const& kv_cache, int const ti, int const sink_token_len,
+    int const tlength, int const kv_loop_length, bool const enable_use_seq_idx_kv)
+{
+    if (ti < sink_token_len || enable_use_seq_idx_kv)
+    {
+        return ti;
+    }
+    int const cyclic_len = kv_cache.mCyclicCacheLen;
+    return sink_token_len + ((ti - sink_token_len + kv_loop_length - tlength) % cyclic_len + cyclic_len) % cyclic_len;
+}
+
+// Loads the channels [jj, jj + N) of a key from a cache that holds the keys without position embedding (position
+// shift), and applies on the fly the rotary embedding of its position in the attention window. The keys of 8bits
+// caches are rotated before dequantization since the rotation is linear.
+template <typename Tk, typename Tcache, typename K_vec_k, typename K_vec_m, typename KVCacheBuffer>
+inline __device__ K_vec_k load_pos_shift_key(KVCacheBuffer const& kv_cache, Tcache const* k_cache_batch,
+    int const token_idx, int const hi_kv, int const Dh, int const jj, int const pos,
+    PositionEmbeddingType const position_embedding_type, int const rot_embed_dim, float const base, float const scale)
+{
+    constexpr int N = num_elems<K_vec_k>::value;
+    static_assert(N % 2 == 0);
+    bool const gptj = position_embedding_type == PositionEmbeddingType::kROPE_GPTJ;
+    bool const gpt_neox = position_embedding_type == PositionEmbeddingType::kROPE_GPT_NEOX
+        || position_embedding_type == PositionEmbeddingType::kLONG_ROPE;
+    int const half_rot_embed_dim = rot_embed_dim / 2;
+
+    K_vec_m const k
+        = *reinterpret_cast<K_vec_m const*>(&k_cache_batch[kv_cache.getKVLocalIdx(token_idx, hi_kv, Dh, jj)]);
+    // GPT-NeoX rotates channel c with channel c +/- rot_embed_dim / 2, which belongs to another vector.
+    K_vec_m k_pair = k;
+    if (gpt_neox && jj < rot_embed_dim)
+    {
+        int const jj_pair = jj < half_rot_embed_dim ? jj + half_rot_embed_dim : jj - half_rot_embed_dim;
+        k_pair = *reinterpret_cast<K_vec_m const*>(
+            &k_cache_batch[kv_cache.getKVLocalIdx(token_idx, hi_kv, Dh, jj_pair)]);
+    }
+
+    Tcache const* k_elts = reinterpret_cast<Tcache const*>(&k);
+    Tcache const* k_pair_elts = reinterpret_cast<Tcache const*>(&k_pair);
+    K_vec_k k_rotated;
+    Tk* k_rotated_elts = reinterpret_cast<Tk*>(&k_rotated);
+#pragma unroll
+    for (int ii = 0; ii < N; ++ii)
+    {
+        int const c = jj + ii;
+        float x = cache_elt_to_float(k_elts[ii]);
+        if ((gptj || gpt_neox) && c < rot_embed_dim)
+        {
+            float const y = cache_elt_to_float(gptj ? k_elts[ii ^ 1] : k_pair_elts[ii]);
+            int const zid = gptj ? (c & ~1) : 2 * (c % half_rot_embed_dim);
+            float2 const coef = rotary_embedding_coefficient(zid, rot_embed_dim, base, scale, pos);
+            bool const is_first = gptj ? (c % 2 == 0) : (c < half_rot_embed_dim);
+            x = is_first ? x * coef.x - y * coef.y : x * coef.x + y * coef.y;
+        }
+        convert_from_float(&k_rotated_elts[ii], x);
+    }
+    return k_rotated;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// v_token_scale is the dequantization scale of the value for caches with per-token scales, 1 otherwise.
 template <typename Tk, typename V_vec_accum, typename V_vec_m, bool INT8_KV_CACHE, bool FP8_KV_CACHE>
-inline __device__ void Logit_value_fma(
-    V_vec_accum& out, Tk const* logits_smem, V_vec_m const& v_vec, float const v_scale, bool const is_mask)
+inline __device__ void Logit_value_fma(V_vec_accum& out, Tk const* logits_smem, V_vec_m const& v_vec,
+    float const v_scale, float const v_token_scale, bool const is_mask)
 {
 #if defined(MMHA_USE_FP32_ACCUM_FOR_LOGITS)
     float logit = is_mask ? 0.f : reinterpret_cast<float*>(logits_smem)[0];
     if constexpr (INT8_KV_CACHE)
     {
-        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale, v_vec);
+        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale * v_token_scale, v_vec);
         out = fma(logit, cast_to_float(v_vec_), out);
     }
     else if constexpr (FP8_KV_CACHE)
     {
 #ifdef MMHA_FP8_SCALE_P_INSTEAD_OF_V
-        out = fma(logit, cast_to_float(v_vec), out);
+        out = fma(logit * v_token_scale, cast_to_float(v_vec), out);
 #else
-        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale, v_vec);
+        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale * v_token_scale, v_vec);
         out = fma(logit, cast_to_float(v_vec_), out);
 #endif // MMHA_FP8_SCALE_P_INSTEAD_OF_V
     }
@@ -979,15 +1064,17 @@ inline __device__ void Logit_value_fma(
     Tk logit = is_mask ? Tk(0.f) : logits_smem[0];
     if constexpr (INT8_KV_CACHE)
     {
-        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale, v_vec);
+        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale * v_token_scale, v_vec);
         out = fma(logit, v_vec_, out);
     }
     else if constexpr (FP8_KV_CACHE)
     {
 #ifdef MMHA_FP8_SCALE_P_INSTEAD_OF_V
-        out = fma(logit, v_vec, out);
+        Tk scaled_logit;
+        convert_from_float(&scaled_logit, convert_to_float(logit) * v_token_scale);
+        out = fma(scaled_logit, v_vec, out);
 #else
-        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale, v_vec);
+        V_vec_accum v_vec_ = mul<V_vec_accum, float, V_vec_m>(v_scale * v_token_scale, v_vec);
         out = fma(logit, v_vec_, out);
 #endif // MMHA_FP8_SCALE_P_INSTEAD_OF_V
     }
@@ -1317,6 +1404,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     static constexpr bool FP8_KV_CACHE = std::is_same<Tcache, __nv_fp8_e4m3>::value;
     // INT8 KV Cache.
     static constexpr bool INT8_KV_CACHE = std::is_same<Tcache, int8_t>::value;
+    // 8bits KV cache with one scale per token and kv head.
+    static constexpr bool SUPPORTS_TOKEN_KV_SCALES = ENABLE_8BITS_KV_CACHE && !POS_SHIFT && !DO_CROSS_ATTENTION;
+#ifdef MMHA_FP8_SCALE_Q_INSTEAD_OF_K
+    // The dequantization scale of the fp8 K cache is applied to Q.
+    static constexpr bool K_SCALE_IN_Q = FP8_K_CACHE;
+#else
+    static constexpr bool K_SCALE_IN_Q = false;
+#endif // MMHA_FP8_SCALE_Q_INSTEAD_OF_K
 
     // The size of a warp.
     constexpr unsigned WARP_SIZE{32};
@@ -1424,6 +1519,9 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     constexpr auto bias_smem_size = DO_CROSS_ATTENTION ? Dh_MAX : 1u;
     __shared__ __align__(mmha::const_max(mmha::const_max(sizeof(Qk_vec_k), sizeof(K_vec_k)), sizeof(V_vec_k)))
         [[maybe_unused]] Tk bias_smem[bias_smem_size];
+    // Shares the value of the current timestep to compute its scale when the cache has per-token scales.
+    constexpr auto v_current_smem_size = SUPPORTS_TOKEN_KV_SCALES ? Dh_MAX : 1u;
+    __shared__ __align__(sizeof(V_vec_k)) [[maybe_unused]] Tk v_current_smem[v_current_smem_size];
 
     // The number of elements per vector.
     constexpr unsigned QK_VEC_SIZE{sizeof(Qk_vec_m) / sizeof(T)};
@@ -1511,10 +1609,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     bool const write_attention_quant = params.attention_out_scale_orig_quant != nullptr;
 
     // Quant/Dequant scales for 8bits kv cache.
+    // Caches with one scale per token and kv head apply them to the scores and values instead of the layer scale.
+    bool const use_token_kv_scales = SUPPORTS_TOKEN_KV_SCALES && kvCacheBuffer.hasTokenScales();
     using T_scale = typename kv_cache_scale_type_t<T, Tcache>::Type;
     T_scale kv_scale_orig_quant, k_scale_quant_orig;
-    float const k_scale_quant_orig_f = (ENABLE_8BITS_K_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
-    float const kv_scale_quant_orig_f = (ENABLE_8BITS_KV_CACHE ? params.kv_scale_quant_orig[0] : 1.0f);
+    float const k_scale_quant_orig_f
+        = (ENABLE_8BITS_K_CACHE && !use_token_kv_scales ? params.kv_scale_quant_orig[0] : 1.0f);
+    float const kv_scale_quant_orig_f
+        = (ENABLE_8BITS_KV_CACHE && !use_token_kv_scales ? params.kv_scale_quant_orig[0] : 1.0f);
     convert_from_float(&k_scale_quant_orig, k_scale_quant_orig_f);
     convert_from_float(&kv_scale_orig_quant, (ENABLE_8BITS_KV_CACHE ? params.kv_scale_orig_quant[0] : 1.0f));
 
@@ -1878,8 +1980,16 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     // - for cross attn, no-beam/beam search: cache length is fixed, not differ context/generation cache -->
     // context_length = tlength Suggestion: we could have a flag HANDLE_GEN_CACHE
 
+    auto const c_tile_times_timesteps_per_block = c_tile * timesteps_per_block; // 0 if !MULTI_BLOCK_FLAG
+
+    // In multi-block mode, only the timesteps of the tile within the context are loaded. The tiles past the end of
+    // the shorter sequences of the batch skip the loop.
     auto const context_ti_end = MULTI_BLOCK_FLAG
-        ? divUp(timesteps_per_block, UNROLLED_K_PER_WARP) * UNROLLED_K_PER_WARP
+        ? divUp(static_cast<unsigned>(
+                    min(static_cast<int>(timesteps_per_block),
+                        max(context_length - static_cast<int>(c_tile_times_timesteps_per_block), 0))),
+              UNROLLED_K_PER_WARP)
+            * UNROLLED_K_PER_WARP
         : divUp(static_cast<unsigned>(context_length), UNROLLED_K_PER_WARP) * UNROLLED_K_PER_WARP;
 
     // The generation ti_end.
@@ -1896,14 +2006,24 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     // cyclic_attention_window_size.
     int const* beam_indices = HAS_BEAMS ? &params.cache_indir[bi_seq_len_offset] : nullptr;
 
-    auto const c_tile_times_timesteps_per_block = c_tile * timesteps_per_block; // 0 if !MULTI_BLOCK_FLAG
-
     ////////////////////////////////////////////////////////////////////////////////////////////////
     // Key cache loops for dot(Q, K).
 
     // Is it the leader?
     bool const is_leader = Qk_dot<T, THREADS_PER_KEY>::is_leader(tidx);
 
+    // The rotary embedding of the keys applied on the fly with position shift, the cache holds the keys without
+    // position embedding. Dynamic scaling depends on the number of cached keys in the window.
+    float k_rotary_embedding_base = params.rotary_embedding_base;
+    float k_rotary_embedding_scale = params.rotary_embedding_scale;
+    if constexpr (POS_SHIFT)
+    {
+        int const cache_length = kv_loop_length;
+        mmha::update_rotary_base_n_scale(k_rotary_embedding_base, k_rotary_embedding_scale,
+            params.rotary_embedding_scale_type, params.rotary_embedding_dim, params.rotary_embedding_max_positions,
+            cache_length);
+    }
+
     // The slope for ALiBi.
     float linear_bias_slope = 0.f;
     if (params.linear_bias_slopes != nullptr)
@@ -1921,6 +2041,10 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
         // The keys loaded from the key cache.
         K_vec_m k_vec_cache[K_LOOP_UNROLL][K_VECS_PER_THREAD];
+        // The keys with the rotary embedding applied on the fly, for position shift.
+        K_vec_k k_vec_shifted[K_LOOP_UNROLL][K_VECS_PER_THREAD];
+        // The dequantization scales of the keys for caches with per-token scales.
+        float k_token_scale[K_LOOP_UNROLL];
 
 #pragma unroll
         for (int k_loop = 0; k_loop < K_LOOP_UNROLL; ++k_loop)
@@ -1933,6 +2057,9 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 // Seq OOB values will be masked out when storing back to smem.
                 auto const jj = min(k_idx.y + k_vec_i * K_ELTS_PER_CHUNK, Dh - K_VEC_SIZE);
                 int valid_time_now = min(time_now + k_loop * K_PER_ITER, context_length - 1);
+                int const key_pos = POS_SHIFT ? pos_shift_key_position(kvCacheBuffer, valid_time_now, sink_token_len,
+                                        tlength, kv_loop_length, enable_use_seq_idx_kv)
+                                              : valid_time_now;
                 if (POS_SHIFT && valid_time_now >= sink_token_len)
                 {
                     // If one more block mode is enabled, we use the index in sequence as tokenIdx.
@@ -1949,8 +2076,22 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 // Base pointer to k cache block for beam's batch
                 TKcache* k_cache_batch = reinterpret_cast<TKcache*>(pastKCache.getKBlockPtr(seqIdx, valid_time_now));
 
-                int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
-                k_vec_cache[k_loop][k_vec_i] = *reinterpret_cast<K_vec_m const*>(&k_cache_batch[inBlockIdx]);
+                if constexpr (POS_SHIFT)
+                {
+                    k_vec_shifted[k_loop][k_vec_i] = load_pos_shift_key<Tk, TKcache, K_vec_k, K_vec_m>(pastKCache,
+                        k_cache_batch, valid_time_now, hi_kv, Dh, jj, key_pos, params.position_embedding_type,
+                        params.rotary_embedding_dim, k_rotary_embedding_base, k_rotary_embedding_scale);
+                }
+                else
+                {
+                    int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
+                    k_vec_cache[k_loop][k_vec_i] = *reinterpret_cast<K_vec_m const*>(&k_cache_batch[inBlockIdx]);
+                }
+                if (k_vec_i == 0)
+                {
+                    k_token_scale[k_loop]
+                        = use_token_kv_scales ? *pastKCache.getKScalePtr(seqIdx, valid_time_now, hi_kv) : 1.f;
+                }
             }
         }
 
@@ -2007,24 +2148,39 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
             // Compute the dot product between Q and K.
             // Note that dot will convert 8bit vec to the accumulation data type (float by default).
             float qk_ = 0.f;
-#ifdef MMHA_FP8_SCALE_Q_INSTEAD_OF_K
-            if constexpr (FP8_K_CACHE)
+            if constexpr (POS_SHIFT)
             {
-                qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec_shifted[k_loop]) * params.inv_sqrt_dh;
+                if constexpr (ENABLE_8BITS_K_CACHE && !K_SCALE_IN_Q)
+                {
+                    qk_ *= k_scale_quant_orig_f;
+                }
             }
             else
-#endif // MMHA_FP8_SCALE_Q_INSTEAD_OF_K
             {
-                if constexpr (ENABLE_8BITS_K_CACHE)
+#ifdef MMHA_FP8_SCALE_Q_INSTEAD_OF_K
+                if constexpr (FP8_K_CACHE)
                 {
-                    qk_ = Qk_dot<T, THREADS_PER_KEY>::scale_dot(q_vec, k_vec, k_scale_quant_orig_f)
-                        * params.inv_sqrt_dh;
+                    qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
                 }
                 else
+#endif // MMHA_FP8_SCALE_Q_INSTEAD_OF_K
                 {
-                    qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                    if constexpr (ENABLE_8BITS_K_CACHE)
+                    {
+                        qk_ = Qk_dot<T, THREADS_PER_KEY>::scale_dot(q_vec, k_vec, k_scale_quant_orig_f)
+                            * params.inv_sqrt_dh;
+                    }
+                    else
+                    {
+                        qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                    }
                 }
             }
+            if constexpr (SUPPORTS_TOKEN_KV_SCALES)
+            {
+                qk_ *= k_token_scale[k_loop];
+            }
 
             // Grok tanh scale for qk product.
             if constexpr (QK_TANH_SCALE)
@@ -2088,6 +2244,10 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
             // The keys loaded from the key cache.
             K_vec_m k_vec[K_VECS_PER_THREAD];
+            // The keys with the rotary embedding applied on the fly, for position shift.
+            K_vec_k k_vec_shifted[K_VECS_PER_THREAD];
+            // The dequantization scale of the key for caches with per-token scales.
+            float k_token_scale = 1.f;
 
 #pragma unroll
             for (int k_vec_i = 0; k_vec_i < K_VECS_PER_THREAD; ++k_vec_i)
@@ -2095,6 +2255,9 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 int const jj = min(k_idx.y + k_vec_i * K_ELTS_PER_CHUNK, Dh - K_VEC_SIZE);
                 int valid_time_now = min(time_now, kv_loop_length - 1);
                 int beam_offset = beam_indices[valid_time_now];
+                int const key_pos = POS_SHIFT ? pos_shift_key_position(kvCacheBuffer, valid_time_now, sink_token_len,
+                                        tlength, kv_loop_length, enable_use_seq_idx_kv)
+                                              : valid_time_now;
                 if (POS_SHIFT && valid_time_now >= sink_token_len)
                 {
                     // If one more block mode is enabled, we use the index in sequence as tokenIdx.
@@ -2110,8 +2273,21 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 // Base pointer to k cache block for beam's batch, before offsetting with indirection buffer
                 TKcache* k_cache_batch = reinterpret_cast<TKcache*>(pastKCache.getKBlockPtr(seqIdx, valid_time_now));
 
-                int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
-                k_vec[k_vec_i] = (*reinterpret_cast<K_vec_m const*>(&k_cache_batch[inBlockIdx]));
+                if constexpr (POS_SHIFT)
+                {
+                    k_vec_shifted[k_vec_i] = load_pos_shift_key<Tk, TKcache, K_vec_k, K_vec_m>(pastKCache,
+                        k_cache_batch, valid_time_now, hi_kv, Dh, jj, key_pos, params.position_embedding_type,
+                        params.rotary_embedding_dim, k_rotary_embedding_base, k_rotary_embedding_scale);
+                }
+                else
+                {
+                    int inBlockIdx = pastKCache.getKVLocalIdx(valid_time_now, hi_kv, Dh, jj);
+                    k_vec[k_vec_i] = (*reinterpret_cast<K_vec_m const*>(&k_cache_batch[inBlockIdx]));
+                }
+                if (k_vec_i == 0 && use_token_kv_scales)
+                {
+                    k_token_scale = *pastKCache.getKScalePtr(seqIdx, valid_time_now, hi_kv);
+                }
             }
 
             // Is it active?
@@ -2153,24 +2329,39 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
             // WARNING: ALL THE THREADS OF A WARP MUST ENTER!!!
             // Note that dot will convert 8bit vec to the accumulation data type (float by default).
             float qk_ = 0.f;
-#ifdef MMHA_FP8_SCALE_Q_INSTEAD_OF_K
-            if constexpr (FP8_K_CACHE)
+            if constexpr (POS_SHIFT)
             {
-                qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec_shifted) * params.inv_sqrt_dh;
+                if constexpr (ENABLE_8BITS_K_CACHE && !K_SCALE_IN_Q)
+                {
+                    qk_ *= k_scale_quant_orig_f;
+                }
             }
             else
-#endif // MMHA_FP8_SCALE_Q_INSTEAD_OF_K
             {
-                if constexpr (ENABLE_8BITS_K_CACHE)
+#ifdef MMHA_FP8_SCALE_Q_INSTEAD_OF_K
+                if constexpr (FP8_K_CACHE)
                 {
-                    qk_ = Qk_dot<T, THREADS_PER_KEY>::scale_dot(q_vec, k_vec, k_scale_quant_orig_f)
-                        * params.inv_sqrt_dh;
+                    qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
                 }
                 else
+#endif // MMHA_FP8_SCALE_Q_INSTEAD_OF_K
                 {
-                    qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                    if constexpr (ENABLE_8BITS_K_CACHE)
+                    {
+                        qk_ = Qk_dot<T, THREADS_PER_KEY>::scale_dot(q_vec, k_vec, k_scale_quant_orig_f)
+                            * params.inv_sqrt_dh;
+                    }
+                    else
+                    {
+                        qk_ = Qk_dot<T, THREADS_PER_KEY>::dot(q_vec, k_vec) * params.inv_sqrt_dh;
+                    }
                 }
             }
+            if constexpr (SUPPORTS_TOKEN_KV_SCALES)
+            {
+                qk_ *= k_token_scale;
+            }
 
             // Grok tanh scale for qk product.
             if constexpr (QK_TANH_SCALE)
@@ -2276,7 +2467,24 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
         if constexpr (ENABLE_8BITS_KV_CACHE)
         {
-            store_8bits_kv_cache_vec(reinterpret_cast<Tcache*>(k_cache), k_vec, inBlockIdx, kv_scale_orig_quant);
+            T_scale k_scale_orig_quant = kv_scale_orig_quant;
+            if (use_token_kv_scales)
+            {
+                // The whole head of the current key is in shared memory.
+                float k_abs_max = 0.f;
+#pragma unroll
+                for (int ki = 0; ki < Dh; ki += QK_VEC_SIZE)
+                {
+                    k_abs_max = fmaxf(k_abs_max, vec_abs_max(*reinterpret_cast<Qk_vec_k const*>(&k_smem[ki])));
+                }
+                float const k_token_scale_orig_quant = kv_cache_token_scale_orig_quant<Tcache>(k_abs_max);
+                if (tidx == 0)
+                {
+                    *kvCacheBuffer.getKScalePtr(batch_beam_idx, cyclic_tlength, hi_kv) = 1.f / k_token_scale_orig_quant;
+                }
+                convert_from_float(&k_scale_orig_quant, k_token_scale_orig_quant);
+            }
+            store_8bits_kv_cache_vec(reinterpret_cast<Tcache*>(k_cache), k_vec, inBlockIdx, k_scale_orig_quant);
         }
         else
         {
@@ -2424,11 +2632,16 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         // Take all previous cache as context when we have no beam searching in order to batch as many LDGs as possible.
         int const context_length
             = DO_CROSS_ATTENTION ? kv_loop_length : (HAS_BEAMS ? beam0_context_length : kv_loop_length);
-        int context_v_loop_end = MULTI_BLOCK_FLAG ? timesteps_per_block : context_length;
+        int context_v_loop_end = MULTI_BLOCK_FLAG
+            ? min(static_cast<int>(timesteps_per_block),
+                max(context_length - static_cast<int>(c_tile_times_timesteps_per_block), 0))
+            : context_length;
         int generation_v_loop_end = MULTI_BLOCK_FLAG ? timesteps_per_block : kv_loop_length;
         for (int ti = vo; ti < context_v_loop_end; ti += UNROLLED_V_PER_ITER)
         {
             V_vec_m v_vec_cache[V_LOOP_UNROLL];
+            // The dequantization scales of the values for caches with per-token scales.
+            float v_token_scale[V_LOOP_UNROLL];
 #pragma unroll
             for (int v_loop = 0; v_loop < V_LOOP_UNROLL; v_loop++)
             {
@@ -2453,6 +2666,8 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                 Tcache* v_cache_batch = reinterpret_cast<Tcache*>(kvCacheBuffer.getVBlockPtr(rowIdx, time_idx));
 
                 v_vec_cache[v_loop] = *reinterpret_cast<V_vec_m const*>(&v_cache_batch[inBlockIdx]);
+                v_token_scale[v_loop]
+                    = use_token_kv_scales ? *kvCacheBuffer.getVScalePtr(rowIdx, time_idx, hi_kv) : 1.f;
             }
 
 #pragma unroll
@@ -2468,8 +2683,9 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
 
                 // Load the logits from shared memory.
                 // Note that fma will convert 8bit vec to the accumulation data type (float by default).
-                Logit_value_fma<Tk, V_vec_accum, V_vec_m, INT8_KV_CACHE, FP8_KV_CACHE>(
-                    out, reinterpret_cast<Tk*>(logits_smem + local_time_idx), v_vec, kv_scale_quant_orig_f, is_mask);
+                Logit_value_fma<Tk, V_vec_accum, V_vec_m, INT8_KV_CACHE, FP8_KV_CACHE>(out,
+                    reinterpret_cast<Tk*>(logits_smem + local_time_idx), v_vec, kv_scale_quant_orig_f,
+                    v_token_scale[v_loop], is_mask);
             }
         }
 
@@ -2508,11 +2724,14 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
                     // The base pointer for the value in the cache buffer.
                     Tcache* v_cache_batch = reinterpret_cast<Tcache*>(kvCacheBuffer.getVBlockPtr(rowIdx, time_idx));
                     V_vec_m v_vec = reinterpret_cast<V_vec_m const*>(&v_cache_batch[inBlockIdx])[0];
+                    float const v_token_scale
+                        = use_token_kv_scales ? *kvCacheBuffer.getVScalePtr(rowIdx, time_idx, hi_kv) : 1.f;
 
                     // Load the logits from shared memory.
                     // Note that fma will convert 8bit vec to the accumulation data type (float by default).
-                    Logit_value_fma<Tk, V_vec_accum, V_vec_m, INT8_KV_CACHE, FP8_KV_CACHE>(
-                        out, reinterpret_cast<Tk*>(logits_smem + local_time_idx), v_vec, kv_scale_quant_orig_f, false);
+                    Logit_value_fma<Tk, V_vec_accum, V_vec_m, INT8_KV_CACHE, FP8_KV_CACHE>(out,
+                        reinterpret_cast<Tk*>(logits_smem + local_time_idx), v_vec, kv_scale_quant_orig_f,
+                        v_token_scale, false);
                 }
             }
         }
@@ -2522,13 +2741,16 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
     __syncthreads();
 
     // One group of threads computes the product(s) for the current timestep.
-    if (vo == kv_loop_length % V_PER_ITER && is_valid_vi && (!MULTI_BLOCK_FLAG || (c_tile == current_step_ctile_idx)))
+    bool const is_current_v_group = vo == kv_loop_length % V_PER_ITER && is_valid_vi
+        && (!MULTI_BLOCK_FLAG || (c_tile == current_step_ctile_idx));
+    V_vec_k v;
+    zero(v);
+    if (is_current_v_group)
     {
         int const inBlockIdx = kvCacheBuffer.getKVLocalIdx(cyclic_tlength, hi_kv, Dh, vi);
         // The base pointer for the value in the cache buffer.
         Tcache* v_cache_base = reinterpret_cast<Tcache*>(kvCacheBuffer.getVBlockPtr(batch_beam_idx, cyclic_tlength));
 
-        V_vec_k v;
         if (DO_CROSS_ATTENTION)
         {
             v = vec_conversion<V_vec_k, V_vec_k>(*reinterpret_cast<V_vec_k const*>(&v_cache_base[inBlockIdx]));
@@ -2570,6 +2792,23 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
             }
         }
 
+        if (use_token_kv_scales)
+        {
+            *reinterpret_cast<V_vec_k*>(&v_current_smem[vi]) = v;
+        }
+    }
+
+    if (use_token_kv_scales)
+    {
+        __syncthreads();
+    }
+
+    if (is_current_v_group)
+    {
+        int const inBlockIdx = kvCacheBuffer.getKVLocalIdx(cyclic_tlength, hi_kv, Dh, vi);
+        // The base pointer for the value in the cache buffer.
+        Tcache* v_cache_base = reinterpret_cast<Tcache*>(kvCacheBuffer.getVBlockPtr(batch_beam_idx, cyclic_tlength));
+
         // Store the values with bias back to global memory in the cache for V.
         //*reinterpret_cast<V_vec_k*>(&v_cache[params.timestep*Dh]) = v;
         // For MQA/GQA mode, write only with the first Q head of each group per KV head.
@@ -2577,7 +2816,25 @@ __global__ void __launch_bounds__(MAX_THEADS_PER_BLOCK, MIN_BLOCKS_PER_SM) maske
         {
             if (ENABLE_8BITS_KV_CACHE)
             {
-                store_8bits_kv_cache_vec(v_cache_base, v, inBlockIdx, kv_scale_orig_quant);
+                T_scale v_scale_orig_quant = kv_scale_orig_quant;
+                if (use_token_kv_scales)
+                {
+                    float v_abs_max = 0.f;
+#pragma unroll
+                    for (int vj = 0; vj < Dh; vj += V_VEC_SIZE)
+                    {
+                        v_abs_max = fmaxf(
+                            v_abs_max, vec_abs_max(*reinterpret_cast<V_vec_k const*>(&v_current_smem[vj])));
+                    }
+                    float const v_token_scale_orig_quant = kv_cache_token_scale_orig_quant<Tcache>(v_abs_max);
+                    if (vi == 0)
+                    {
+                        *kvCacheBuffer.getVScalePtr(batch_beam_idx, cyclic_tlength, hi_kv)
+                            = 1.f / v_token_scale_orig_quant;
+                    }
+                    convert_from_float(&v_scale_orig_quant, v_token_scale_orig_quant);
+                }
+                store_8bits_kv_cache_vec(v_cache_base, v, inBlockIdx, v_scale_orig_quant);
             }
             else
             {
@@ -34,8 +34,8 @@ CubinObj::CubinObj(void const* buffer_, size_t buffer_size)
     uint8_t const* buffer = static_cast<uint8_t const*>(buffer_);
     size_t remaining_buffer_size = buffer_size;
     uint32_t len = readFromBuffer<uint32_t>(buffer, remaining_buffer_size);
-    mContent.resize(len);
     TLLM_CHECK(len <= remaining_buffer_size);
+    mContent.resize(len);
     memcpy(mContent.data(), buffer, len);
 }
 
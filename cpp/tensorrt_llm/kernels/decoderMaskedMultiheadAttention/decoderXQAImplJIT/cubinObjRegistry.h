@@ -18,9 +18,22 @@
 
 #include "compileEngine.h"
 #include "serializationUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplCommon.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <filesystem>
+#include <fstream>
 #include <functional>
+#include <iterator>
+#include <random>
+#include <string>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 namespace tensorrt_llm
 {
@@ -76,39 +89,165 @@ public:
     size_t getSerializationSize() const noexcept
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        size_t result = sizeof(uint32_t);
-        for (auto&& p : mMap)
-        {
-            result += 2 * sizeof(uint32_t);
-            result += p.first.getSerializationSize() + p.second.getSerializationSize();
-        }
-        return result;
+        return getSerializationSizeImpl();
     }
 
     void serialize(void* buffer_, size_t buffer_size) const noexcept
     {
         std::lock_guard<std::mutex> lock(mMutex);
-        size_t remaining_buffer_size = buffer_size;
-        uint8_t* buffer = static_cast<uint8_t*>(buffer_);
-        uint32_t n = mMap.size();
-        writeToBuffer<uint32_t>(n, buffer, remaining_buffer_size);
-        for (auto&& p : mMap)
+        serializeImpl(buffer_, buffer_size);
+    }
+
+    // Name of the file of the cubins of `sm` compiled with `driverVersion` in the cache directory. Cubins compiled by
+    // another driver may not load, so each driver has its own file.
+    static std::string getCacheFileName(int sm, int32_t driverVersion)
+    {
+        return "xqa_jit_sm" + std::to_string(sm) + "_driver" + std::to_string(driverVersion) + ".cubins";
+    }
+
+    // Loads the cubins saved by saveToFile() and adds those not found in mMap. Returns false and adds nothing if the
+    // file doesn't exist, was saved by another driver or format, e.g. by another node sharing the cache directory, or
+    // is corrupted. The cubins are then compiled again and the file is replaced.
+    bool loadFromFile(std::filesystem::path const& path, int32_t driverVersion)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
         {
-            uint32_t key_size = p.first.getSerializationSize();
-            TLLM_CHECK(key_size <= remaining_buffer_size);
-            writeToBuffer<uint32_t>(key_size, buffer, remaining_buffer_size);
-            p.first.serialize(buffer, key_size);
-            buffer += key_size;
-            remaining_buffer_size -= key_size;
+            return false;
+        }
+        std::vector<uint8_t> const content{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        size_t remaining_buffer_size = content.size();
+        uint8_t const* buffer = content.data();
+        if (remaining_buffer_size < kFileHeaderSize
+            || readFromBuffer<uint32_t>(buffer, remaining_buffer_size) != kFileMagic
+            || readFromBuffer<uint32_t>(buffer, remaining_buffer_size) != kFileVersion
+            || readFromBuffer<int32_t>(buffer, remaining_buffer_size) != driverVersion
+            || readFromBuffer<uint32_t>(buffer, remaining_buffer_size) != sizeof(Key))
+        {
+            TLLM_LOG_WARNING("Ignoring XQA JIT cubin cache %s, it was written by another version.", path.c_str());
+            return false;
+        }
+        // A flipped bit in a cubin would still deserialize, and only fail when the cubin is loaded
+        if (readFromBuffer<uint64_t>(buffer, remaining_buffer_size) != hashBytes(buffer, remaining_buffer_size))
+        {
+            TLLM_LOG_WARNING("Ignoring corrupted XQA JIT cubin cache %s: checksum mismatch", path.c_str());
+            return false;
+        }
+        try
+        {
+            CubinObjRegistryTemplate<Key, Hash> loaded(buffer, remaining_buffer_size);
+            std::lock_guard<std::mutex> lock(mMutex);
+            merge(loaded);
+        }
+        catch (std::exception const& e)
+        {
+            TLLM_LOG_WARNING("Ignoring corrupted XQA JIT cubin cache %s: %s", path.c_str(), e.what());
+            return false;
+        }
+        return true;
+    }
 
-            uint32_t obj_size = p.second.getSerializationSize();
-            TLLM_CHECK(obj_size <= remaining_buffer_size);
-            writeToBuffer<uint32_t>(obj_size, buffer, remaining_buffer_size);
-            p.second.serialize(buffer, obj_size);
-            buffer += obj_size;
-            remaining_buffer_size -= obj_size;
+    // Writes all cubins to `path`. The file is replaced atomically, so concurrent processes sharing the cache always
+    // read a complete file.
+    void saveToFile(std::filesystem::path const& path, int32_t driverVersion) const
+    {
+        std::vector<uint8_t> content(kFileHeaderSize);
+        {
+            uint8_t* buffer = content.data();
+            size_t remaining_buffer_size = content.size();
+            writeToBuffer<uint32_t>(kFileMagic, buffer, remaining_buffer_size);
+            writeToBuffer<uint32_t>(kFileVersion, buffer, remaining_buffer_size);
+            writeToBuffer<int32_t>(driverVersion, buffer, remaining_buffer_size);
+            writeToBuffer<uint32_t>(sizeof(Key), buffer, remaining_buffer_size);
         }
-        TLLM_CHECK(remaining_buffer_size == 0);
+        {
+            // Size and content must be taken under the same lock, cubins may be inserted concurrently.
+            std::lock_guard<std::mutex> lock(mMutex);
+            size_t const size = getSerializationSizeImpl();
+            content.resize(kFileHeaderSize + size);
+            serializeImpl(content.data() + kFileHeaderSize, size);
+        }
+        {
+            uint8_t* buffer = content.data() + kFileHeaderSize - sizeof(uint64_t);
+            size_t remaining_buffer_size = sizeof(uint64_t);
+            writeToBuffer<uint64_t>(hashBytes(content.data() + kFileHeaderSize, content.size() - kFileHeaderSize),
+                buffer, remaining_buffer_size);
+        }
+        auto tmpPath = path;
+        tmpPath += ".tmp." + std::to_string(std::random_device{}());
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            TLLM_CHECK_WITH_INFO(file.good(), "Can't write the XQA JIT cubin cache %s", tmpPath.c_str());
+            file.write(reinterpret_cast<char const*>(content.data()), static_cast<std::streamsize>(content.size()));
+        }
+        std::filesystem::rename(tmpPath, path);
+    }
+
+    // Compiles the cubins of the keys not found in mMap on up to `numThreads` threads and inserts them. The lock is
+    // not held while compiling, so lookups of other cubins aren't blocked. Returns the number of compiled cubins.
+    size_t insertCubinsIfNotExists(
+        std::vector<std::pair<Key, CompileEngine const*>> const& entries, size_t numThreads)
+    {
+        std::vector<std::pair<Key, CompileEngine const*>> missing;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            std::unordered_set<Key, Hash> seen;
+            for (auto const& entry : entries)
+            {
+                TLLM_CHECK(entry.second != nullptr);
+                if (mMap.find(entry.first) == mMap.end() && seen.insert(entry.first).second)
+                {
+                    missing.push_back(entry);
+                }
+            }
+        }
+        if (missing.empty())
+        {
+            return 0;
+        }
+
+        std::vector<CubinObj> compiled(missing.size());
+        std::vector<std::exception_ptr> errors(missing.size());
+        std::atomic<size_t> next{0};
+        auto const worker = [&]()
+        {
+            for (auto i = next++; i < missing.size(); i = next++)
+            {
+                try
+                {
+                    compiled[i] = missing[i].second->compile();
+                }
+                catch (...)
+                {
+                    errors[i] = std::current_exception();
+                }
+            }
+        };
+        std::vector<std::thread> threads;
+        auto const numWorkers = std::clamp<size_t>(numThreads, 1, missing.size());
+        for (size_t ti = 1; ti < numWorkers; ++ti)
+        {
+            threads.emplace_back(worker);
+        }
+        worker();
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (auto const& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (size_t i = 0; i < missing.size(); ++i)
+        {
+            mMap.insert({missing[i].first, std::move(compiled[i])});
+        }
+        return missing.size();
     }
 
     // Compiles and inserts the cubin if not found in mMap. Does nothing otherwise.
@@ -164,6 +303,61 @@ public:
     }
 
 private:
+    static constexpr uint32_t kFileMagic = 0x43415158; // "XQAC"
+    // Bumped when the layout of the file changes
+    static constexpr uint32_t kFileVersion = 2;
+    // Magic, version, driver version, key size and the hash of the cubins that follow
+    static constexpr size_t kFileHeaderSize = 3 * sizeof(uint32_t) + sizeof(int32_t) + sizeof(uint64_t);
+
+    // FNV-1a
+    static uint64_t hashBytes(uint8_t const* data, size_t size) noexcept
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash = (hash ^ data[i]) * 0x100000001b3ULL;
+        }
+        return hash;
+    }
+
+    // Requires mMutex.
+    size_t getSerializationSizeImpl() const noexcept
+    {
+        size_t result = sizeof(uint32_t);
+        for (auto&& p : mMap)
+        {
+            result += 2 * sizeof(uint32_t);
+            result += p.first.getSerializationSize() + p.second.getSerializationSize();
+        }
+        return result;
+    }
+
+    // Requires mMutex.
+    void serializeImpl(void* buffer_, size_t buffer_size) const noexcept
+    {
+        size_t remaining_buffer_size = buffer_size;
+        uint8_t* buffer = static_cast<uint8_t*>(buffer_);
+        uint32_t n = mMap.size();
+        writeToBuffer<uint32_t>(n, buffer, remaining_buffer_size);
+        for (auto&& p : mMap)
+        {
+            uint32_t key_size = p.first.getSerializationSize();
+            TLLM_CHECK(key_size <= remaining_buffer_size);
+            writeToBuffer<uint32_t>(key_size, buffer, remaining_buffer_size);
+            p.first.serialize(buffer, key_size);
+            buffer += key_size;
+            remaining_buffer_size -= key_size;
+
+            uint32_t obj_size = p.second.getSerializationSize();
+            TLLM_CHECK(obj_size <= remaining_buffer_size);
+            writeToBuffer<uint32_t>(obj_size, buffer, remaining_buffer_size);
+            p.second.serialize(buffer, obj_size);
+            buffer += obj_size;
+            remaining_buffer_size -= obj_size;
+        }
+        TLLM_CHECK(remaining_buffer_size == 0);
+    }
+
     std::unordered_map<Key, CubinObj, Hash> mMap;
     mutable std::mutex mMutex;
 };
@@ -16,7 +16,9 @@
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT/decoderXQAImplJIT.h"
 
 #include "compileEngine.h"
+#include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/cubin/xqa_kernel_cubin.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAConstants.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT/decoderXQAImplJIT.h"
@@ -25,6 +27,12 @@
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/tensorMapUtils.h"
 #include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
 
+#include <exception>
+#include <filesystem>
+#include <mutex>
+#include <optional>
+#include <vector>
+
 namespace
 {
 
@@ -38,6 +46,58 @@ XQAKernelRuntimeHashKey getRuntimeHashKeyFromKernelMeta(XQAKernelMetaInfo const&
         kernelMeta.mMTileSize, kernelMeta.mTokensPerPage, kernelMeta.mPagedKVCache, kernelMeta.mMultiQueryTokens};
 }
 
+int32_t getDriverVersion()
+{
+    int driverVersion{0};
+    TLLM_CUDA_CHECK(cudaDriverGetVersion(&driverVersion));
+    return driverVersion;
+}
+
+// File of the on-disk cubin cache for this SM and driver, cubins compiled by another driver may not load.
+std::optional<std::filesystem::path> getCubinCachePath(int sm)
+{
+    auto const cacheDir = tensorrt_llm::common::getEnvXQAJITCacheDir();
+    if (!cacheDir)
+    {
+        return std::nullopt;
+    }
+    return std::filesystem::path(*cacheDir)
+        / tensorrt_llm::kernels::jit::CubinObjRegistry::getCacheFileName(sm, getDriverVersion());
+}
+
+//! Loads the on-disk cache into the global registry, once per process.
+void loadCubinCacheOnce(tensorrt_llm::kernels::jit::CubinObjRegistry& registry, int sm)
+{
+    static std::once_flag loaded;
+    std::call_once(loaded,
+        [&registry, sm]()
+        {
+            if (auto const path = getCubinCachePath(sm); path && registry.loadFromFile(*path, getDriverVersion()))
+            {
+                TLLM_LOG_INFO("Loaded XQA JIT cubins from %s", path->c_str());
+            }
+        });
+}
+
+void saveCubinCache(tensorrt_llm::kernels::jit::CubinObjRegistry const& registry, int sm)
+{
+    auto const path = getCubinCachePath(sm);
+    if (!path)
+    {
+        return;
+    }
+    // The cache only saves compilation time, failing to write it must not fail the engine.
+    try
+    {
+        std::filesystem::create_directories(path->parent_path());
+        registry.saveToFile(*path, getDriverVersion());
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_WARNING("Failed to save XQA JIT cubins to %s: %s", path->c_str(), e.what());
+    }
+}
+
 } // anonymous namespace
 
 namespace tensorrt_llm
@@ -110,18 +170,34 @@ jit::CubinObjKey DecoderXQAImplJIT::getCubinObjKeyFromXQAParams(XQAParams const&
     return {loadKey, runtimeKey};
 }
 
-void DecoderXQAImplJIT::prepareForActualXQAParams(XQAParams const& xqaParams)
+void DecoderXQAImplJIT::prepareForActualXQAParams(std::vector<XQAParams> const& xqaParamsList)
 {
-    jit::CubinObjKey currentKey = getCubinObjKeyFromXQAParams(xqaParams);
+    auto registryGlobal = DecoderXQARunner::getResourceGlobal()->getCubinObjRegistry();
+    loadCubinCacheOnce(*registryGlobal, mSM);
 
-    jit::CompileEngine compileEngine(mSM, xqaParams);
+    // CompileEngine keeps a reference to the XQAParams, xqaParamsList outlives the compilation.
+    std::vector<jit::CompileEngine> compileEngines;
+    compileEngines.reserve(xqaParamsList.size());
+    std::vector<std::pair<jit::CubinObjKey, jit::CompileEngine const*>> entries;
+    for (auto const& xqaParams : xqaParamsList)
+    {
+        if (supportConfig(xqaParams, true))
+        {
+            compileEngines.emplace_back(mSM, xqaParams);
+            entries.emplace_back(getCubinObjKeyFromXQAParams(xqaParams), &compileEngines.back());
+        }
+    }
 
-    auto registryGlobal = DecoderXQARunner::getResourceGlobal()->getCubinObjRegistry();
+    auto const numCompiled = registryGlobal->insertCubinsIfNotExists(
+        entries, static_cast<size_t>(tensorrt_llm::common::getEnvXQAJITCompileThreads()));
+    if (numCompiled > 0)
+    {
+        saveCubinCache(*registryGlobal, mSM);
+    }
 
-    if (supportConfig(xqaParams, true))
+    for (auto const& entry : entries)
     {
-        jit::CubinObjKey key = getCubinObjKeyFromXQAParams(xqaParams);
-        registryGlobal->insertCubinIfNotExists(key, &compileEngine);
+        auto const& key = entry.first;
         if (mInitializedCubinObjRegistry.getCubin(key) == nullptr)
         {
             // Get an unintiailized cubin from registryGlobal, initialize it, then put it in
@@ -136,12 +212,15 @@ void DecoderXQAImplJIT::prepareForActualXQAParams(XQAParams const& xqaParams)
 
 void DecoderXQAImplJIT::prepare(XQAParams const& umbrellaXQAParams)
 {
+    // Warm up every beam width up to the umbrella one, all compiled in parallel.
+    std::vector<XQAParams> actualXQAParamsList;
     for (int beam_width = 1; beam_width <= umbrellaXQAParams.beam_width; ++beam_width)
     {
         XQAParams actualXQAParams = umbrellaXQAParams;
         actualXQAParams.beam_width = beam_width;
-        prepareForActualXQAParams(actualXQAParams);
+        actualXQAParamsList.push_back(actualXQAParams);
     }
+    prepareForActualXQAParams(actualXQAParamsList);
 }
 
 void DecoderXQAImplJIT::runWithKVLinearBuffer(
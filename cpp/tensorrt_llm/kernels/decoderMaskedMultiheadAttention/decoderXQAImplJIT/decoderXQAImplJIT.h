@@ -20,6 +20,7 @@
 #include "cubinObjRegistry.h"
 #include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplCommon.h"
 #include <unordered_set>
+#include <vector>
 
 namespace tensorrt_llm
 {
@@ -48,7 +49,8 @@ private:
     //! Whether DecoderXQAImplJIT has perf gain over the default (non-XQA-optimized) implementation.
     bool mayHavePerfGain(XQAParams const& xqaParams) const;
 
-    void prepareForActualXQAParams(XQAParams const& xqaParams);
+    //! Compiles the cubins of all xqaParams missing in the global registry in parallel, then initializes them.
+    void prepareForActualXQAParams(std::vector<XQAParams> const& xqaParamsList);
 
     template <typename T, typename KVCacheBuffer>
     void runImpl(XQAParams const& xqaParams, KVCacheBuffer const& kv_cache_buffer, int multiprocessor_count,
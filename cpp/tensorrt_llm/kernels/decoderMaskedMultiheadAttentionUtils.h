@@ -3309,6 +3309,13 @@ inline __device__ float2 convert_to_float(uint32_t u)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+inline __device__ float convert_to_float(uint16_t u)
+{
+    return half_to_float(u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 inline __device__ float convert_to_float(half u)
 {
     return static_cast<float>(u);
@@ -3868,6 +3875,67 @@ struct kv_cache_scale_type_t<__nv_bfloat16, __nv_fp8_e4m3>
     using Type = __nv_bfloat16;
 };
 #endif // ENALBE_FP8
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Largest magnitude of the 8-bit cache type, the per-token scales map the absolute max of a head to it.
+template <typename T_cache>
+struct kv_cache_quant_max
+{
+    static constexpr float value = 127.f;
+};
+
+#ifdef ENABLE_FP8
+template <>
+struct kv_cache_quant_max<__nv_fp8_e4m3>
+{
+    static constexpr float value = 448.f;
+};
+#endif // ENABLE_FP8
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename Vec>
+inline __device__ float vec_abs_max(Vec const& vec)
+{
+    using Vec_f = decltype(convert_to_float(vec));
+    constexpr int NUM_ELEMS = num_elems<Vec_f>::value;
+    Vec_f const vec_f = convert_to_float(vec);
+    float const* elems = reinterpret_cast<float const*>(&vec_f);
+    float abs_max = 0.f;
+#pragma unroll
+    for (int i = 0; i < NUM_ELEMS; ++i)
+    {
+        abs_max = fmaxf(abs_max, fabsf(elems[i]));
+    }
+    return abs_max;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Reduces the absolute max over the GROUP_SIZE consecutive threads of a warp. All threads of the warp must participate.
+template <int GROUP_SIZE>
+inline __device__ float group_abs_max(float abs_max)
+{
+    static_assert(GROUP_SIZE <= 32 && (GROUP_SIZE & (GROUP_SIZE - 1)) == 0, "GROUP_SIZE must be a power of 2 <= 32");
+#pragma unroll
+    for (int mask = GROUP_SIZE / 2; mask > 0; mask >>= 1)
+    {
+        abs_max = fmaxf(abs_max, __shfl_xor_sync(uint32_t(-1), abs_max, mask));
+    }
+    return abs_max;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Quantization scale of one head of one token. It is bounded so that half scales can represent it.
+template <typename T_cache>
+inline __device__ float kv_cache_token_scale_orig_quant(float abs_max)
+{
+    constexpr float QUANT_MAX = kv_cache_quant_max<T_cache>::value;
+    return QUANT_MAX / fmaxf(abs_max, QUANT_MAX * 1e-4f);
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 template <typename Vec_T, typename T>
@@ -143,6 +143,24 @@ static_assert(FinishedState::finishedEOS().isFinishedEOS());
 static_assert(FinishedState::finishedStopWords().isFinishedStopWords());
 static_assert(FinishedState::finishedMaxLength().isFinishedMaxLength());
 
+#ifdef __CUDACC__
+//! \brief Stateless counter-based random number in (0, 1], Philox4x32-10 of the counter (step, draw) under the key
+//! seed. The numbers of a request depend neither on its batch slot nor on the numbers drawn before them, so no state is
+//! kept or initialized per slot, and a request resumed at the same step, e.g. after a migration or a preemption with
+//! recompute, draws the same numbers.
+//!
+//! \param seed random seed of the request
+//! \param step step of the request, usually its sequence length
+//! \param draw index of the number among those the request draws at this step
+__device__ __forceinline__ float philoxUniform(uint64_t seed, uint64_t step, uint64_t draw)
+{
+    curandStatePhilox4_32_10_t state;
+    // Skipping ahead is a counter increment for Philox
+    curand_init(seed, step, draw, &state);
+    return curand_uniform(&state);
+}
+#endif
+
 //! \brief Initialize batchSize curand states with given seed.
 //!
 //! \param state output buffer [maxBatchSize]. Curand states to be initialized
@@ -28,6 +28,9 @@
 #include "3rdparty/cub/cub.cuh"
 #endif
 
+#include <algorithm>
+#include <cmath>
+
 using namespace tensorrt_llm::common;
 using namespace tensorrt_llm::runtime;
 
@@ -281,7 +284,32 @@ void invokeGatherTree(gatherTreeParam param)
     }
 }
 
-__global__ void insertUnfinishedPathKernel(BeamHypotheses bh)
+// Threads per block of insertUnfinishedPathKernel, and the shared memory it may use for the chunk maps
+static constexpr int kInsertUnfinishedPathThreads = 256;
+static constexpr size_t kInsertUnfinishedPathMaxSmem = 48 * 1024;
+
+__device__ __forceinline__ int insertUnfinishedSegment(BeamHypotheses const& bh, int const bid, int const dstBeam,
+    int beam, int const stepHi, int const stepLo, bool const bOutputLogProbs)
+{
+    // Copy the tokens in [stepLo, stepHi] of the path whose token at `stepHi` is on beam `beam`
+    // Return the beam of the path at `stepLo - 1`
+    int const nBM{bh.nBeamWidth};
+    int const nMBS{bh.nMaxBatchSize};
+    int const nMSL{bh.nMaxSeqLen};
+    for (int j = stepHi; j >= stepLo; --j)
+    {
+        int const index = bid * nBM * nMSL + beam * nMSL + j;
+        bh.outputIdsCBA[dstBeam * nMSL + j] = bh.outputIdsUnfinish[index];
+        if (bOutputLogProbs)
+        {
+            bh.logProbsCBA[dstBeam * nMSL + j] = bh.logProbsTiled[j * nMBS * nBM + bid * nBM + beam];
+        }
+        beam = bh.parentIdsUnfinish[index];
+    }
+    return beam;
+}
+
+__global__ void insertUnfinishedPathKernel(BeamHypotheses bh, int const nChunkSize)
 {
     // Move ALL unfinished beams from bh.outputIdsUnfinish to bh.outputIdsCBA
     // So here might be more than `nBM` beams in bh.outputIdsCBA after the call
@@ -291,11 +319,20 @@ __global__ void insertUnfinishedPathKernel(BeamHypotheses bh)
     // bh.logProbsTiled     -> bh.logProbsCBA
     // update bh.normedScoresCBA
     // update bh.numBeamsCBA
+    //
+    // The backtrack along bh.parentIdsUnfinish is split into chunks of `nChunkSize` steps, a path ending at `step`
+    // has `step / nChunkSize` full chunks below its top chunk [step / nChunkSize * nChunkSize, step]
+    // 1. Every full chunk is composed into a map from the beam at its last step to the beam before its first step,
+    //    concurrently with the copy of the top chunks
+    // 2. The beam at the last step of every full chunk of each path is found by walking the maps, one hop per chunk
+    // 3. All (path, full chunk) pairs are copied concurrently
+    // So the serial depth is O(nChunkSize + MSL / nChunkSize) dependent loads instead of O(BM * MSL)
 
     int const bid = blockIdx.x;       // Index of Batch
+    int const tid = threadIdx.x;
     int const nBM{bh.nBeamWidth};
-    int const nMBS{bh.nMaxBatchSize}; // Only for bh.logProbsTiled
     int const nMSL{bh.nMaxSeqLen};
+    int const nChunk{(nMSL + nChunkSize - 1) / nChunkSize};
     bool const bOutputLogProbs{bh.logProbsCBA != nullptr && bh.logProbsTiled != nullptr};
     int const indexDstStart{bh.numBeamsCBA[bid]};
 
@@ -304,50 +341,92 @@ __global__ void insertUnfinishedPathKernel(BeamHypotheses bh)
         return;
     }
 
+    extern __shared__ int smemInsert[];
+    int* smemChunkMap = smemInsert;                   // [nChunk, nBM], beam before the chunk for a beam at its end
+    int* smemChunkBeam = smemChunkMap + nChunk * nBM; // [nChunk, nBM], beam of each path at the end of the chunk
+
+    int maxStep{0};
     for (int i = 0; i < nBM; ++i)
     {
-        int const srcBeam = bid * nBM + i;
-        int const dstBeam = bid * nBM * 2 + i + indexDstStart;
-        int const step = bh.sequenceLengths[srcBeam] - 1;
+        maxStep = max(maxStep, bh.sequenceLengths[bid * nBM + i] - 1);
+    }
+    int const nFullChunk{maxStep / nChunkSize};
 
-        // The last token
-        int const srcId = srcBeam * nMSL + step;
-        int const dstId = dstBeam * nMSL + step;
-        bh.outputIdsCBA[dstId] = bh.outputIdsUnfinish[srcId];
-        if (bOutputLogProbs)
+    // 1. Chunk maps and top chunks
+    for (int task = tid; task < (nFullChunk + 1) * nBM; task += blockDim.x)
+    {
+        if (task < nFullChunk * nBM)
         {
-            bh.logProbsCBA[dstId] = bh.logProbsTiled[step * nMBS * nBM + srcBeam];
+            int const chunk = task / nBM;
+            int beam = task % nBM;
+            for (int j = (chunk + 1) * nChunkSize - 1; j >= chunk * nChunkSize; --j)
+            {
+                beam = bh.parentIdsUnfinish[bid * nBM * nMSL + beam * nMSL + j];
+            }
+            smemChunkMap[task] = beam;
         }
-        // Previous tokens
-        int prevId = bh.parentIdsUnfinish[srcId];
-        for (int j = step - 1; j >= 0; --j)
+        else
         {
-            int const index = bid * nBM * nMSL + prevId * nMSL + j;
-            bh.outputIdsCBA[dstBeam * nMSL + j] = bh.outputIdsUnfinish[index];
-            prevId = bh.parentIdsUnfinish[index];
-        }
-        if (bOutputLogProbs)
-        {
-            prevId = bh.parentIdsUnfinish[srcId];
-            for (int j = step - 1; j >= 0; --j)
+            int const i = task - nFullChunk * nBM;
+            int const dstBeam = bid * nBM * 2 + i + indexDstStart;
+            int const step = bh.sequenceLengths[bid * nBM + i] - 1;
+            int const chunk = step / nChunkSize;
+            int const beam = insertUnfinishedSegment(bh, bid, dstBeam, i, step, chunk * nChunkSize, bOutputLogProbs);
+            if (chunk > 0)
             {
-                int const index = bid * nBM * nMSL + prevId * nMSL + j;
-                bh.logProbsCBA[dstBeam * nMSL + j] = bh.logProbsTiled[j * nMBS * nBM + bid * nBM + prevId];
-                prevId = bh.parentIdsUnfinish[index];
+                smemChunkBeam[(chunk - 1) * nBM + i] = beam;
             }
         }
-        // Other parameters
+    }
+    __syncthreads();
+
+    // 2. Beams at the chunk boundaries, other parameters
+    if (tid < nBM)
+    {
+        int const srcBeam = bid * nBM + tid;
+        int const dstBeam = bid * nBM * 2 + tid + indexDstStart;
+        int const step = bh.sequenceLengths[srcBeam] - 1;
+        for (int chunk = step / nChunkSize - 1; chunk > 0; --chunk)
+        {
+            smemChunkBeam[(chunk - 1) * nBM + tid] = smemChunkMap[chunk * nBM + smemChunkBeam[chunk * nBM + tid]];
+        }
         bh.sequenceLengthsCBA[dstBeam] = bh.sequenceLengths[srcBeam];
         bh.normedScoresCBA[dstBeam]
             = applyLengthPenalty(bh.cumLogProbs[srcBeam], step - bh.inputLengths[srcBeam] + 1, bh.lengthPenalties[bid]);
         bh.cumLogProbsCBA[dstBeam] = bh.cumLogProbs[srcBeam];
-        bh.numBeamsCBA[bid]++;
+    }
+    if (tid == 0)
+    {
+        bh.numBeamsCBA[bid] = indexDstStart + nBM;
+    }
+    __syncthreads();
+
+    // 3. Full chunks
+    for (int task = tid; task < nFullChunk * nBM; task += blockDim.x)
+    {
+        int const chunk = task / nBM;
+        int const i = task % nBM;
+        if (chunk >= (bh.sequenceLengths[bid * nBM + i] - 1) / nChunkSize)
+        {
+            continue;
+        }
+        int const dstBeam = bid * nBM * 2 + i + indexDstStart;
+        insertUnfinishedSegment(bh, bid, dstBeam, smemChunkBeam[task], (chunk + 1) * nChunkSize - 1,
+            chunk * nChunkSize, bOutputLogProbs);
     }
 }
 
 void invokeInsertUnfinishedPath(BeamHypotheses& bh, cudaStream_t stream)
 {
-    insertUnfinishedPathKernel<<<bh.nBatchSize, 1, 0, stream>>>(bh);
+    // Chunks of about sqrt(MSL) steps balance the serial walks inside a chunk and across the chunks
+    int const nBM{bh.nBeamWidth};
+    int const nMSL{bh.nMaxSeqLen};
+    int const nMaxChunk = std::max(1, static_cast<int>(kInsertUnfinishedPathMaxSmem / (2 * nBM * sizeof(int))));
+    int const nChunkTarget = std::min(static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nMSL)))), nMaxChunk);
+    int const nChunkSize = (nMSL + nChunkTarget - 1) / nChunkTarget;
+    int const nChunk = (nMSL + nChunkSize - 1) / nChunkSize;
+    size_t const smemSize = 2 * nChunk * nBM * sizeof(int);
+    insertUnfinishedPathKernel<<<bh.nBatchSize, kInsertUnfinishedPathThreads, smemSize, stream>>>(bh, nChunkSize);
 }
 
 __global__ void finalizeKernel(BeamHypotheses bh)
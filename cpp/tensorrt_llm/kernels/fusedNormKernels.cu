@@ -0,0 +1,396 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/fusedNormKernels.h"
+
+#include <algorithm>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+template <typename T, int VEC>
+struct alignas(sizeof(T) * VEC) PackedVec
+{
+    T data[VEC];
+};
+
+template <typename QuantT>
+struct QuantMax;
+
+template <>
+struct QuantMax<int8_t>
+{
+    static constexpr float value = 127.f;
+};
+
+#ifdef ENABLE_FP8
+template <>
+struct QuantMax<__nv_fp8_e4m3>
+{
+    static constexpr float value = 448.f;
+};
+#endif
+
+// Rows of up to this many vectors per lane are handled by one warp each.
+constexpr int kMaxVecsPerLane = 4;
+constexpr int kRowsPerWarpBlock = 4;
+
+// Sum of the values over the threads of a row, returned to all of them.
+template <bool WARP_PER_ROW, int NUM>
+__device__ inline void rowAllReduceSum(float* vals)
+{
+    if constexpr (WARP_PER_ROW)
+    {
+        warpReduceSumV2<float, NUM>(vals);
+    }
+    else
+    {
+        __shared__ float s_vals[NUM];
+        blockReduceSumV2<float, NUM>(vals);
+        if (threadIdx.x == 0)
+        {
+#pragma unroll
+            for (int i = 0; i < NUM; i++)
+            {
+                s_vals[i] = vals[i];
+            }
+        }
+        __syncthreads();
+#pragma unroll
+        for (int i = 0; i < NUM; i++)
+        {
+            vals[i] = s_vals[i];
+        }
+        // s_vals may be written again by the next reduction
+        __syncthreads();
+    }
+}
+
+template <bool WARP_PER_ROW>
+__device__ inline float rowAllReduceMax(float val)
+{
+    if constexpr (WARP_PER_ROW)
+    {
+        return warpReduceMax(val);
+    }
+    else
+    {
+        return blockAllReduceMax(val);
+    }
+}
+
+template <typename T, int VEC>
+__device__ inline void normalizeVec(float* normed, PackedVec<T, VEC> const& val, PackedVec<T, VEC> const* gamma,
+    PackedVec<T, VEC> const* beta, int i, float mean, float inv_std)
+{
+    PackedVec<T, VEC> const g = gamma[i];
+#pragma unroll
+    for (int k = 0; k < VEC; k++)
+    {
+        normed[k] = (cuda_cast<float>(val.data[k]) - mean) * inv_std * cuda_cast<float>(g.data[k]);
+    }
+    if (beta != nullptr)
+    {
+        PackedVec<T, VEC> const b = beta[i];
+#pragma unroll
+        for (int k = 0; k < VEC; k++)
+        {
+            normed[k] += cuda_cast<float>(b.data[k]);
+        }
+    }
+}
+
+template <typename QuantT, int VEC>
+__device__ inline void storeQuantized(PackedVec<QuantT, VEC>* out, float const* normed, float scale)
+{
+    PackedVec<QuantT, VEC> q;
+#pragma unroll
+    for (int k = 0; k < VEC; k++)
+    {
+        q.data[k] = cuda_cast<QuantT>(normed[k] * scale);
+    }
+    *out = q;
+}
+
+/* Computes out <- norm(input + residual) * gamma + beta, with
+ *   RMSNorm:   norm(x) = x / Sqrt(E[x²] + eps)
+ *   LayerNorm: norm(x) = (x - E[x]) / Sqrt(Var[x] + eps)
+ * input is [tokens, hidden_dim], the statistics are per row (i.e. per token).
+ *
+ * The row is read once with VEC-wide accesses, the sum with the residual is written to residual_out and cached in
+ * shared memory for the following passes. With WARP_PER_ROW, a warp handles a row and the reductions are warp
+ * shuffles, otherwise a CTA handles a row.
+ *
+ * With per-token quantization, the normalization pass only finds the amax of the row. A final pass normalizes again
+ * from shared memory, scales to QuantT accordingly and writes out_quant.
+ */
+template <typename T, typename QuantT, NormType NORM, int VEC, bool WARP_PER_ROW>
+__global__ void fusedAddNorm(FusedNormParams<T, QuantT> const params)
+{
+    using Vec = PackedVec<T, VEC>;
+    using QuantVec = PackedVec<QuantT, VEC>;
+
+    extern __shared__ __align__(16) char _shmem[];
+
+    int const n_vecs = params.hidden_dim / VEC;
+    int64_t row;
+    int tidx;
+    int stride;
+    Vec* cache = reinterpret_cast<Vec*>(_shmem);
+    if constexpr (WARP_PER_ROW)
+    {
+        int const warp = threadIdx.x / 32;
+        row = static_cast<int64_t>(blockIdx.x) * (blockDim.x / 32) + warp;
+        tidx = threadIdx.x % 32;
+        stride = 32;
+        cache += warp * n_vecs;
+        if (row >= params.tokens)
+        {
+            return;
+        }
+    }
+    else
+    {
+        row = blockIdx.x;
+        tidx = threadIdx.x;
+        stride = blockDim.x;
+    }
+
+    int64_t const row_offset = row * n_vecs;
+    auto const* input = reinterpret_cast<Vec const*>(params.input) + row_offset;
+    auto const* residual = reinterpret_cast<Vec const*>(params.residual);
+    auto* residual_out = reinterpret_cast<Vec*>(params.residual_out);
+    auto const* gamma = reinterpret_cast<Vec const*>(params.gamma);
+    auto const* beta = reinterpret_cast<Vec const*>(params.beta);
+    auto* out = reinterpret_cast<Vec*>(params.out);
+    auto* out_quant = reinterpret_cast<QuantVec*>(params.out_quant);
+
+    float local_sum = 0.0f;
+    float local_var_sum = 0.0f;
+    for (int i = tidx; i < n_vecs; i += stride)
+    {
+        Vec val = input[i];
+        if (residual != nullptr)
+        {
+            Vec const res = residual[row_offset + i];
+#pragma unroll
+            for (int k = 0; k < VEC; k++)
+            {
+                val.data[k] = cuda_cast<T>(cuda_cast<float>(val.data[k]) + cuda_cast<float>(res.data[k]));
+            }
+            if (residual_out != nullptr)
+            {
+                residual_out[row_offset + i] = val;
+            }
+        }
+        cache[i] = val;
+
+#pragma unroll
+        for (int k = 0; k < VEC; k++)
+        {
+            float const val_f = cuda_cast<float>(val.data[k]);
+            local_sum += val_f;
+            local_var_sum += val_f * val_f;
+        }
+    }
+
+    float mean = 0.0f;
+    float variance;
+    if constexpr (NORM == NormType::RMSNORM)
+    {
+        float packed[1] = {local_var_sum};
+        rowAllReduceSum<WARP_PER_ROW, 1>(packed);
+        variance = packed[0] / params.hidden_dim; // E[x²]
+    }
+    else if (params.use_diff_of_squares)
+    {
+        float packed[2] = {local_sum, local_var_sum};
+        rowAllReduceSum<WARP_PER_ROW, 2>(packed);
+        mean = packed[0] / params.hidden_dim;
+        variance = packed[1] / params.hidden_dim - mean * mean; // Var[x] = E[x²] - E[x]²
+    }
+    else
+    {
+        float packed[1] = {local_sum};
+        rowAllReduceSum<WARP_PER_ROW, 1>(packed);
+        mean = packed[0] / params.hidden_dim;
+
+        local_var_sum = 0.0f;
+        for (int i = tidx; i < n_vecs; i += stride)
+        {
+            Vec const val = cache[i];
+#pragma unroll
+            for (int k = 0; k < VEC; k++)
+            {
+                float const diff = cuda_cast<float>(val.data[k]) - mean;
+                local_var_sum += diff * diff;
+            }
+        }
+        packed[0] = local_var_sum;
+        rowAllReduceSum<WARP_PER_ROW, 1>(packed);
+        variance = packed[0] / params.hidden_dim; // Var[x] = E[(x - E[x])²]
+    }
+    float const inv_std = rsqrtf(variance + params.eps);
+
+    bool const with_per_token_scaling = out_quant != nullptr && params.scale_orig_quant_per_token != nullptr;
+    bool const with_per_tensor_scaling = out_quant != nullptr && params.scale_orig_quant_per_token == nullptr;
+    float const scale_orig_quant
+        = params.scale_orig_quant_per_tensor != nullptr ? *params.scale_orig_quant_per_tensor : 1.0f;
+    float amax = 1e-6f;
+
+    for (int i = tidx; i < n_vecs; i += stride)
+    {
+        float normed[VEC];
+        normalizeVec(normed, cache[i], gamma, beta, i, mean, inv_std);
+
+        if (out != nullptr)
+        {
+            Vec val;
+#pragma unroll
+            for (int k = 0; k < VEC; k++)
+            {
+                val.data[k] = cuda_cast<T>(normed[k]);
+            }
+            out[row_offset + i] = val;
+        }
+        if (with_per_token_scaling)
+        {
+#pragma unroll
+            for (int k = 0; k < VEC; k++)
+            {
+                amax = fmaxf(amax, fabsf(normed[k]));
+            }
+        }
+        else if (with_per_tensor_scaling)
+        {
+            storeQuantized(out_quant + row_offset + i, normed, scale_orig_quant);
+        }
+    }
+
+    if (with_per_token_scaling)
+    {
+        float const abs_max_f = rowAllReduceMax<WARP_PER_ROW>(amax);
+        float const dynamic_per_token_scale = QuantMax<QuantT>::value / abs_max_f;
+        for (int i = tidx; i < n_vecs; i += stride)
+        {
+            float normed[VEC];
+            normalizeVec(normed, cache[i], gamma, beta, i, mean, inv_std);
+            storeQuantized(out_quant + row_offset + i, normed, dynamic_per_token_scale);
+        }
+        if (tidx == 0)
+        {
+            params.scale_orig_quant_per_token[row] = abs_max_f / QuantMax<QuantT>::value;
+        }
+    }
+}
+
+template <typename T, typename QuantT, NormType NORM, int VEC>
+void launchFusedAddNorm(FusedNormParams<T, QuantT> const& params, cudaStream_t stream)
+{
+    int const n_vecs = params.hidden_dim / VEC;
+    size_t const row_size = params.hidden_dim * sizeof(T);
+    if (n_vecs <= 32 * kMaxVecsPerLane)
+    {
+        dim3 const grid(divUp(params.tokens, kRowsPerWarpBlock));
+        dim3 const block(32 * kRowsPerWarpBlock);
+        fusedAddNorm<T, QuantT, NORM, VEC, true>
+            <<<grid, block, kRowsPerWarpBlock * row_size, stream>>>(params);
+    }
+    else
+    {
+        dim3 const grid(params.tokens);
+        // Make sure block.x is multiple of 32 for warp shuffle to work
+        dim3 const block(32 * divUp(std::min(n_vecs, 1024), 32));
+        if (row_size >= (48 << 10))
+        {
+            cudaError_t ret = cudaFuncSetAttribute(
+                fusedAddNorm<T, QuantT, NORM, VEC, false>, cudaFuncAttributeMaxDynamicSharedMemorySize, row_size);
+        }
+        fusedAddNorm<T, QuantT, NORM, VEC, false><<<grid, block, row_size, stream>>>(params);
+    }
+}
+
+template <typename T, typename QuantT, int VEC>
+void dispatchFusedAddNorm(FusedNormParams<T, QuantT> const& params, cudaStream_t stream)
+{
+    if (params.norm_type == NormType::RMSNORM)
+    {
+        launchFusedAddNorm<T, QuantT, NormType::RMSNORM, VEC>(params, stream);
+    }
+    else
+    {
+        launchFusedAddNorm<T, QuantT, NormType::LAYERNORM, VEC>(params, stream);
+    }
+}
+
+bool isAligned(void const* ptr, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % alignment == 0;
+}
+
+} // namespace
+
+template <typename T, typename QuantT>
+void invokeFusedAddNorm(FusedNormParams<T, QuantT> const& params, cudaStream_t stream)
+{
+    // 128-bit accesses
+    constexpr int kVec = 16 / sizeof(T);
+    constexpr size_t kAlignment = 16;
+    bool const use_vec_type = params.hidden_dim % kVec == 0 && isAligned(params.input, kAlignment)
+        && isAligned(params.residual, kAlignment) && isAligned(params.residual_out, kAlignment)
+        && isAligned(params.gamma, kAlignment) && isAligned(params.beta, kAlignment)
+        && isAligned(params.out, kAlignment) && isAligned(params.out_quant, kVec * sizeof(QuantT));
+
+    if (use_vec_type)
+    {
+        dispatchFusedAddNorm<T, QuantT, kVec>(params, stream);
+    }
+    else
+    {
+        dispatchFusedAddNorm<T, QuantT, 1>(params, stream);
+    }
+}
+
+#define INSTANTIATE_FUSED_ADD_NORM(T, QuantT)                                                                          \
+    template void invokeFusedAddNorm(FusedNormParams<T, QuantT> const& params, cudaStream_t stream)
+
+INSTANTIATE_FUSED_ADD_NORM(float, int8_t);
+INSTANTIATE_FUSED_ADD_NORM(half, int8_t);
+#ifdef ENABLE_BF16
+INSTANTIATE_FUSED_ADD_NORM(__nv_bfloat16, int8_t);
+#endif
+
+#ifdef ENABLE_FP8
+INSTANTIATE_FUSED_ADD_NORM(float, __nv_fp8_e4m3);
+INSTANTIATE_FUSED_ADD_NORM(half, __nv_fp8_e4m3);
+#ifdef ENABLE_BF16
+INSTANTIATE_FUSED_ADD_NORM(__nv_bfloat16, __nv_fp8_e4m3);
+#endif
+#endif
+
+#undef INSTANTIATE_FUSED_ADD_NORM
+
+} // namespace kernels
+} // namespace tensorrt_llm
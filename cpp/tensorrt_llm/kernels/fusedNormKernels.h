@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+enum class NormType
+{
+    RMSNORM = 0,
+    LAYERNORM,
+};
+
+// Residual add, RMSNorm or LayerNorm and quantization of the normalized rows in one pass over the input.
+// QuantT is int8_t or __nv_fp8_e4m3.
+template <typename T, typename QuantT>
+struct FusedNormParams
+{
+    NormType norm_type = NormType::RMSNORM;
+    // For LayerNorm, compute the variance as E[x²] - E[x]² in the same reduction as the mean.
+    bool use_diff_of_squares = false;
+    float eps = 1e-6f;
+    int tokens = 0;
+    int hidden_dim = 0;
+
+    T const* input = nullptr;    // (tokens, hidden_dim)
+    T const* residual = nullptr; // (tokens, hidden_dim), optional, added to the input before the norm
+    T* residual_out = nullptr;   // (tokens, hidden_dim), optional, the un-normalized sum, may alias input
+    T const* gamma = nullptr;    // (hidden_dim,)
+    T const* beta = nullptr;     // (hidden_dim,), optional
+
+    T* out = nullptr;            // (tokens, hidden_dim), optional
+    QuantT* out_quant = nullptr; // (tokens, hidden_dim), optional
+    // Scale of the quantized output, unless it is quantized per token.
+    float const* scale_orig_quant_per_tensor = nullptr;
+    // With it set, the quantized output is scaled by the amax of its row and the dequantization scales are written.
+    float* scale_orig_quant_per_token = nullptr; // (tokens,)
+};
+
+// Rows are loaded with 128-bit accesses when the hidden dimension and the pointers allow it. Small rows are handled
+// by one warp each, large ones by one CTA each.
+template <typename T, typename QuantT>
+void invokeFusedAddNorm(FusedNormParams<T, QuantT> const& params, cudaStream_t stream = 0);
+
+} // namespace kernels
+} // namespace tensorrt_llm
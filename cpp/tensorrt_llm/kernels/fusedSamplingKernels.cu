@@ -0,0 +1,547 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/fusedSamplingKernels.h"
+#include "tensorrt_llm/layers/defaultDecodingParams.h"
+
+#include <float.h>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+// Logits masked by the min length, excluded from the softmax and the top-k
+constexpr float kMaskedLogit = -FLT_MAX;
+
+struct Penalties
+{
+    float invTemperature;
+    float repetitionPenalty;
+    float presencePenalty;
+    float frequencyPenalty;
+    SizeType32 minLength;
+    bool hasTemperature;
+    bool accumulateVocab;
+    bool hasMinLength;
+};
+
+__device__ bool almostEqual(float a, float b, float epsilon)
+{
+    return fabs(a - b) < epsilon;
+}
+
+// Same as batchApplyPenalty
+template <typename T>
+__device__ Penalties loadPenalties(FusedSamplingKernelParams<T> const& params, SizeType32 batchSlot)
+{
+    Penalties penalties{layers::DefaultDecodingParams::getTemperature(),
+        layers::DefaultDecodingParams::getRepetitionPenalty(), layers::DefaultDecodingParams::getPresencePenalty(),
+        layers::DefaultDecodingParams::getFrequencyPenalty(), layers::DefaultDecodingParams::getMinLength(), false,
+        false, false};
+    if (params.temperatures != nullptr)
+    {
+        auto const temperature = params.temperatures[batchSlot];
+        penalties.invTemperature = 1.0f / (temperature + 1e-6f);
+        penalties.hasTemperature
+            = !almostEqual(temperature, layers::DefaultDecodingParams::getTemperature(), 1e-9);
+    }
+    if (params.repetitionPenalties != nullptr)
+    {
+        penalties.repetitionPenalty = params.repetitionPenalties[batchSlot];
+        penalties.accumulateVocab |= !almostEqual(
+            penalties.repetitionPenalty, layers::DefaultDecodingParams::getRepetitionPenalty(), 1e-9);
+    }
+    if (params.presencePenalties != nullptr)
+    {
+        penalties.presencePenalty = params.presencePenalties[batchSlot];
+        penalties.accumulateVocab
+            |= !almostEqual(penalties.presencePenalty, layers::DefaultDecodingParams::getPresencePenalty(), 1e-9);
+    }
+    if (params.frequencyPenalties != nullptr)
+    {
+        penalties.frequencyPenalty = params.frequencyPenalties[batchSlot];
+        penalties.accumulateVocab
+            |= !almostEqual(penalties.frequencyPenalty, layers::DefaultDecodingParams::getFrequencyPenalty(), 1e-9);
+    }
+    if (params.minLengths != nullptr)
+    {
+        penalties.minLength = params.minLengths[batchSlot];
+        penalties.hasMinLength = penalties.minLength > 0;
+    }
+    return penalties;
+}
+
+template <typename T>
+__device__ bool isSkipped(FusedSamplingKernelParams<T> const& params, SizeType32 batchSlot)
+{
+    auto const finishState
+        = params.finishedInput != nullptr ? params.finishedInput[batchSlot] : FinishedState::empty();
+    return (params.skipDecode != nullptr && params.skipDecode[batchSlot]) || finishState.isSkipDecoding()
+        || finishState.isFinished();
+}
+
+//! Running maximum and sum of exp(x - maximum), merged like the online softmax
+struct MaxSum
+{
+    float max;
+    float sum;
+
+    __device__ void insert(float value)
+    {
+        if (value > max)
+        {
+            sum = sum * __expf(max - value) + 1.0f;
+            max = value;
+        }
+        else
+        {
+            sum += __expf(value - max);
+        }
+    }
+};
+
+__device__ __forceinline__ MaxSum reduceMaxSumOp(MaxSum const& a, MaxSum const& b)
+{
+    auto const max = fmaxf(a.max, b.max);
+    return MaxSum{max, a.sum * __expf(a.max - max) + b.sum * __expf(b.max - max)};
+}
+
+//! Candidates of the vocab shards in the workspace, each shard uses shardSize bytes laid out as
+//! getFusedSamplingWorkspaceSizes
+struct ShardCandidates
+{
+    char* workspace;
+    size_t shardSize;
+    size_t idsOffset;
+    size_t valsOffset;
+    size_t maxsOffset;
+    size_t sumsOffset;
+
+    template <typename U>
+    __host__ __device__ U* get(SizeType32 shard, size_t offset) const
+    {
+        return reinterpret_cast<U*>(workspace + shard * shardSize + offset);
+    }
+};
+
+template <typename T>
+ShardCandidates getShardCandidates(FusedSamplingKernelParams<T> const& params)
+{
+    auto const vocabShardSize = params.getVocabShardSize();
+    auto const workspaceSizes = getFusedSamplingWorkspaceSizes(params.batchSize, params.maxTopK, vocabShardSize);
+    std::vector<void*> alignedPointers;
+    calcAlignedPointers(alignedPointers, nullptr, workspaceSizes);
+    auto const offset = [&alignedPointers](size_t i) { return reinterpret_cast<size_t>(alignedPointers[i]); };
+    return ShardCandidates{static_cast<char*>(params.workspace),
+        getFusedSamplingShardWorkspaceSize(params.batchSize, params.maxTopK, vocabShardSize), offset(0), offset(1),
+        offset(2), offset(3)};
+}
+
+} // namespace
+
+template <typename T>
+__global__ void fusedUpdateOccurrences(FusedSamplingKernelParams<T> params)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const batchSlot = params.batchSlots == nullptr ? batchIdx : params.batchSlots[batchIdx];
+    if (!loadPenalties(params, batchSlot).accumulateVocab)
+    {
+        return;
+    }
+
+    auto const inputLen = params.inputLengths == nullptr ? SizeType32{0} : params.inputLengths[batchSlot];
+    auto const currentStep = params.sequenceLengths[batchSlot];
+    auto const* outputIds = params.outputIdsPtrs[batchSlot];
+    auto* occurrences = params.penaltyWorkspace + batchIdx * params.vocabSize;
+    if (currentStep <= inputLen)
+    { // Context phase
+        for (auto index = static_cast<SizeType32>(threadIdx.x); index < params.vocabSize;
+             index += static_cast<SizeType32>(blockDim.x))
+        {
+            occurrences[index] = 0;
+        }
+        __syncthreads();
+        for (auto step = static_cast<SizeType32>(threadIdx.x); step < inputLen;
+             step += static_cast<SizeType32>(blockDim.x))
+        {
+            auto const tokenId = outputIds[step];
+            if (tokenId < params.vocabSize)
+            {
+                atomicAdd(&occurrences[tokenId], 1);
+            }
+        }
+    }
+    else if (threadIdx.x == 0)
+    { // Generation phase
+        auto const tokenId = outputIds[currentStep - 1];
+        if (tokenId < params.vocabSize)
+        {
+            occurrences[tokenId] += 1;
+        }
+    }
+}
+
+//! Penalizes a chunk of the logits shard of each request in shared memory and selects its top-k.
+//! grid [batchSize, numChunks]
+template <typename T, SizeType32 BLOCK_SIZE_>
+__global__ void fusedPenaltyTopKStage1(FusedSamplingKernelParams<T> params, ShardCandidates candidates)
+{
+    typedef cub::BlockReduce<TopK_2<float>, BLOCK_SIZE_> TopKReduce;
+    typedef cub::BlockReduce<MaxSum, BLOCK_SIZE_> MaxSumReduce;
+    __shared__ union
+    {
+        typename TopKReduce::TempStorage topK;
+        typename MaxSumReduce::TempStorage maxSum;
+    } tempStorage;
+    __shared__ float sLogits[FUSED_SAMPLING_CHUNK_SIZE];
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const chunkIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const numChunks = static_cast<SizeType32>(gridDim.y);
+    auto const batchSlot = params.batchSlots == nullptr ? batchIdx : params.batchSlots[batchIdx];
+    if (isSkipped(params, batchSlot))
+    {
+        return;
+    }
+
+    auto const penalties = loadPenalties(params, batchSlot);
+    auto const inputLen = params.inputLengths == nullptr ? SizeType32{0} : params.inputLengths[batchSlot];
+    auto const currentStep = params.sequenceLengths[batchSlot];
+    auto const maskedEndId = penalties.hasMinLength && currentStep - inputLen < penalties.minLength
+        ? params.endIds[batchSlot]
+        : TokenIdType{-1};
+    auto const* logits = params.logitsPtrs[batchIdx];
+    auto const* biases = params.biases != nullptr ? params.biases + batchSlot * params.vocabSizePadded : nullptr;
+    auto const* occurrences
+        = penalties.accumulateVocab ? params.penaltyWorkspace + batchIdx * params.vocabSize : nullptr;
+
+    // Offset of the chunk in the shard, and of its first token in the vocabulary. Chunks past the end of the
+    // vocabulary in the last shard are empty and only write masked candidates.
+    auto const chunkBegin = chunkIdx * FUSED_SAMPLING_CHUNK_SIZE;
+    auto const shardSize = min(params.getVocabShardSize(), params.vocabSize - params.vocabShardBegin);
+    auto const chunkSize = min(FUSED_SAMPLING_CHUNK_SIZE, shardSize - chunkBegin);
+    auto const chunkTokenBegin = params.vocabShardBegin + chunkBegin;
+
+    MaxSum partialMaxSum{kMaskedLogit, 0.0f};
+    for (auto index = tid; index < chunkSize; index += BLOCK_SIZE_)
+    {
+        auto const tokenId = chunkTokenBegin + index;
+        auto logit = static_cast<float>(logits[chunkBegin + index]);
+        if (biases != nullptr)
+        {
+            logit += static_cast<float>(biases[tokenId]);
+        }
+        if (penalties.hasTemperature)
+        {
+            logit *= penalties.invTemperature;
+        }
+        if (occurrences != nullptr)
+        {
+            auto const numOccurrences = occurrences[tokenId];
+            if (numOccurrences > 0)
+            {
+                if (params.repetitionPenalties != nullptr)
+                {
+                    logit = logit < 0.0f ? logit * penalties.repetitionPenalty : logit / penalties.repetitionPenalty;
+                }
+                if (params.presencePenalties != nullptr)
+                {
+                    logit -= penalties.presencePenalty;
+                }
+                if (params.frequencyPenalties != nullptr)
+                {
+                    logit -= penalties.frequencyPenalty * numOccurrences;
+                }
+            }
+        }
+        if (tokenId == maskedEndId)
+        {
+            logit = kMaskedLogit;
+        }
+        else
+        {
+            partialMaxSum.insert(logit);
+        }
+        sLogits[index] = logit;
+    }
+
+    auto const chunkMaxSum = MaxSumReduce(tempStorage.maxSum).Reduce(partialMaxSum, reduceMaxSumOp);
+    auto const chunkOffset = batchIdx * numChunks + chunkIdx;
+    if (tid == 0)
+    {
+        candidates.get<float>(params.shardRank, candidates.maxsOffset)[chunkOffset] = chunkMaxSum.max;
+        candidates.get<float>(params.shardRank, candidates.sumsOffset)[chunkOffset] = chunkMaxSum.sum;
+    }
+    __syncthreads();
+
+    auto const k = params.topKs != nullptr ? params.topKs[batchSlot] : params.maxTopK;
+    auto const candidateOffset = chunkOffset * params.maxTopK;
+    auto* candidateIds = candidates.get<SizeType32>(params.shardRank, candidates.idsOffset);
+    auto* candidateVals = candidates.get<float>(params.shardRank, candidates.valsOffset);
+    for (SizeType32 ite = 0; ite < k; ite++)
+    {
+        TopK_2<float> partial;
+        for (auto index = tid; index < chunkSize; index += BLOCK_SIZE_)
+        {
+            partial.insert(sLogits[index], index);
+        }
+
+        TopK_2<float> total = TopKReduce(tempStorage.topK).Reduce(partial, reduce_topk_op_2<float>);
+
+        if (tid == 0)
+        {
+            candidateIds[candidateOffset + ite] = total.p >= 0 ? chunkTokenBegin + total.p : -1;
+            candidateVals[candidateOffset + ite] = total.u;
+            if (total.p >= 0)
+            {
+                sLogits[total.p] = kMaskedLogit;
+            }
+        }
+        __syncthreads();
+    }
+}
+
+//! Merges the top-k of the chunks of all shards and samples from it, same as topKStage2Sampling.
+//! grid [batchSize]
+template <typename T, SizeType32 BLOCK_SIZE_>
+__global__ void fusedTopKStage2Sampling(
+    FusedSamplingKernelParams<T> params, ShardCandidates candidates, SizeType32 numChunks)
+{
+    typedef cub::BlockReduce<TopK_2<float>, BLOCK_SIZE_> TopKReduce;
+    typedef cub::BlockReduce<MaxSum, BLOCK_SIZE_> MaxSumReduce;
+    __shared__ union
+    {
+        typename TopKReduce::TempStorage topK;
+        typename MaxSumReduce::TempStorage maxSum;
+    } tempStorage;
+    extern __shared__ char array[];
+    __shared__ float sMax;
+    __shared__ float sLogSum;
+    __shared__ float sSum;
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const batchSlot = params.batchSlots == nullptr ? batchIdx : params.batchSlots[batchIdx];
+    auto const finishState
+        = params.finishedInput != nullptr ? params.finishedInput[batchSlot] : FinishedState::empty();
+    if ((params.skipDecode != nullptr && params.skipDecode[batchSlot]) || finishState.isSkipDecoding())
+    {
+        return;
+    }
+    if (finishState.isFinished())
+    {
+        if (tid == 0 && params.finishedOutput != nullptr)
+        {
+            params.finishedOutput[batchSlot] = finishState;
+        }
+        return;
+    }
+
+    // Softmax statistics of the penalized logits over the vocabulary, numChunks per shard
+    MaxSum partialMaxSum{kMaskedLogit, 0.0f};
+    for (auto index = tid; index < params.numShards * numChunks; index += BLOCK_SIZE_)
+    {
+        auto const shard = index / numChunks;
+        auto const chunkOffset = batchIdx * numChunks + index % numChunks;
+        auto const chunkMax = candidates.get<float const>(shard, candidates.maxsOffset)[chunkOffset];
+        auto const chunkSum = candidates.get<float const>(shard, candidates.sumsOffset)[chunkOffset];
+        partialMaxSum = reduceMaxSumOp(partialMaxSum, MaxSum{chunkMax, chunkSum});
+    }
+    auto const maxSum = MaxSumReduce(tempStorage.maxSum).Reduce(partialMaxSum, reduceMaxSumOp);
+    if (tid == 0)
+    {
+        sMax = maxSum.max;
+        sLogSum = __logf(maxSum.sum);
+        sSum = 0.0f;
+    }
+    __syncthreads();
+
+    auto const k = params.topKs != nullptr ? params.topKs[batchSlot] : params.maxTopK;
+    auto const probThreshold = params.topPs != nullptr ? params.topPs[batchSlot] : params.maxTopP;
+    // Candidate index is shard * numShardCandidates + index in the candidates of the request in the shard
+    auto const numShardCandidates = numChunks * params.maxTopK;
+    auto const numCandidates = params.numShards * numShardCandidates;
+    auto const candidateOffset = batchIdx * numShardCandidates;
+    auto const candidateVal = [&](SizeType32 index) -> float&
+    {
+        auto* vals = candidates.get<float>(index / numShardCandidates, candidates.valsOffset);
+        return vals[candidateOffset + index % numShardCandidates];
+    };
+    auto const candidateId = [&](SizeType32 index)
+    {
+        auto const* ids = candidates.get<SizeType32 const>(index / numShardCandidates, candidates.idsOffset);
+        return ids[candidateOffset + index % numShardCandidates];
+    };
+    auto* sId = reinterpret_cast<SizeType32*>(array);
+    auto* sExpLogits = reinterpret_cast<float*>(sId + params.maxTopK);
+
+    for (SizeType32 ite = 0; ite < k; ite++)
+    {
+        TopK_2<float> partial;
+        for (auto index = tid; index < numCandidates; index += BLOCK_SIZE_)
+        {
+            // Only the first k candidates of each chunk are set
+            if (index % params.maxTopK < k)
+            {
+                partial.insert(candidateVal(index), index);
+            }
+        }
+
+        TopK_2<float> total = TopKReduce(tempStorage.topK).Reduce(partial, reduce_topk_op_2<float>);
+
+        if (tid == 0)
+        {
+            sId[ite] = total.p;
+            if (total.p >= 0)
+            {
+                candidateVal(total.p) = kMaskedLogit;
+                sExpLogits[ite] = __expf(total.u - sMax);
+            }
+            else
+            {
+                sExpLogits[ite] = 0.0f;
+            }
+            sSum += sExpLogits[ite];
+        }
+        __syncthreads();
+    }
+
+    if (tid == 0)
+    {
+        auto randNum = static_cast<float>(curand_uniform(params.curandState + batchSlot) * probThreshold * sSum);
+        auto* outputIds = params.outputIdsPtrs[batchSlot];
+        auto const seqLen = params.sequenceLengths[batchSlot];
+        for (SizeType32 ki = 0; ki < k; ki++)
+        {
+            auto const expLogit = sExpLogits[ki];
+            randNum = randNum - expLogit;
+            if (randNum <= 0.0f || ki == k - 1)
+            {
+                auto const idx = sId[ki];
+                // If sId is -1 here we force output token to the last from vocabulary to get vivid indicator of smth
+                // going wrong for the debug
+                auto const outputId = idx != -1 ? candidateId(idx) : params.vocabSize - 1;
+                outputIds[seqLen] = outputId;
+                if (params.cumLogProbs != nullptr || params.outputLogProbs != nullptr)
+                {
+                    // log P(i | i is in vocab), the logits are not normalized
+                    auto const logProb = __logf(expLogit) - sLogSum;
+                    if (params.cumLogProbs != nullptr)
+                    {
+                        params.cumLogProbs[batchSlot] += logProb;
+                    }
+                    if (params.outputLogProbs != nullptr)
+                    {
+                        params.outputLogProbs[seqLen * params.maxBatchSize + batchSlot]
+                            = params.normalizeLogProbs ? __logf(expLogit) - __logf(sSum) : logProb;
+                    }
+                }
+                if (params.finishedOutput != nullptr && outputId == params.endIds[batchSlot])
+                {
+                    params.finishedOutput[batchSlot].setFinishedEOS();
+                    // Do not increase seq len when EOS is generated. Seq len should always contain only tokens to be
+                    // outputted
+                }
+                else
+                {
+                    params.sequenceLengths[batchSlot] += 1;
+                }
+                break;
+            }
+        }
+    }
+}
+
+template <typename T>
+void invokeFusedPenaltyTopKCandidates(FusedSamplingKernelParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    auto const candidates = getShardCandidates(params);
+    auto const numChunks = static_cast<SizeType32>(divUp(params.getVocabShardSize(), FUSED_SAMPLING_CHUNK_SIZE));
+    SizeType32 constexpr blockSize = 256;
+
+    if (params.repetitionPenalties != nullptr || params.presencePenalties != nullptr
+        || params.frequencyPenalties != nullptr)
+    {
+        fusedUpdateOccurrences<T><<<params.batchSize, 512, 0, stream>>>(params);
+    }
+    dim3 grid(params.batchSize, numChunks);
+    fusedPenaltyTopKStage1<T, blockSize><<<grid, blockSize, 0, stream>>>(params, candidates);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void invokeFusedTopKSamplingFromCandidates(FusedSamplingKernelParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    auto const candidates = getShardCandidates(params);
+    auto const numChunks = static_cast<SizeType32>(divUp(params.getVocabShardSize(), FUSED_SAMPLING_CHUNK_SIZE));
+    SizeType32 constexpr blockSize = 256;
+
+    auto const sharedMemSize = params.maxTopK * (sizeof(SizeType32) + sizeof(float));
+    fusedTopKStage2Sampling<T, blockSize>
+        <<<params.batchSize, blockSize, sharedMemSize, stream>>>(params, candidates, numChunks);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void invokeFusedPenaltyTopKSampling(FusedSamplingKernelParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(params.numShards == 1, "Sharded vocab requires to exchange the candidates between the shards");
+    invokeFusedPenaltyTopKCandidates(params, stream);
+    invokeFusedTopKSamplingFromCandidates(params, stream);
+}
+
+#define INSTANTIATE_FUSED_SAMPLING(T)                                                                                  \
+    template void invokeFusedPenaltyTopKCandidates(FusedSamplingKernelParams<T> const& params, cudaStream_t stream);  \
+    template void invokeFusedTopKSamplingFromCandidates(                                                               \
+        FusedSamplingKernelParams<T> const& params, cudaStream_t stream);                                              \
+    template void invokeFusedPenaltyTopKSampling(FusedSamplingKernelParams<T> const& params, cudaStream_t stream);
+
+INSTANTIATE_FUSED_SAMPLING(float);
+INSTANTIATE_FUSED_SAMPLING(half);
+
+#undef INSTANTIATE_FUSED_SAMPLING
+
+} // namespace kernels
+} // namespace tensorrt_llm
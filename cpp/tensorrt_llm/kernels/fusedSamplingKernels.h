@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/runtime/common.h"
+#include <curand_kernel.h>
+
+#include <vector>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! Largest K supported by the fused kernel, larger K fall back to the separate penalty and sampling kernels.
+static constexpr runtime::SizeType32 FUSED_SAMPLING_TOP_K_MAX = 64;
+//! Logits processed per block, the penalized chunk is kept in shared memory while its top-k is selected.
+static constexpr runtime::SizeType32 FUSED_SAMPLING_CHUNK_SIZE = 4096;
+
+template <typename T>
+struct FusedSamplingKernelParams
+{
+    //! input buffer [batchSize][vocabSizePadded] array of pointers to the raw logits of each request.
+    T const* const* logitsPtrs{nullptr};
+    //! input buffer [maxBatchSize, vocabSizePadded], optional. Embedding bias added to the logits.
+    T const* biases{nullptr};
+
+    //! input/output buffer [batchSize, vocabSize], required with any of the occurrence penalties.
+    //! Number of occurrences of each token in the request, shared with invokeBatchApplyPenalty.
+    runtime::SizeType32* penaltyWorkspace{nullptr};
+    //! input buffers [maxBatchSize], optional. Penalties per request, not applied if nullptr.
+    float const* temperatures{nullptr};
+    float const* repetitionPenalties{nullptr};
+    float const* presencePenalties{nullptr};
+    float const* frequencyPenalties{nullptr};
+    runtime::SizeType32 const* minLengths{nullptr};
+    //! input buffer [maxBatchSize], optional. Length of the prompts, 0 if nullptr.
+    runtime::SizeType32 const* inputLengths{nullptr};
+
+    //! input/output buffer [maxBatchSize][maxSeqLen]. Pointers to the rows with the tokens of each request.
+    //! Read for the occurrence penalties, the sampled token is written at sequenceLengths.
+    runtime::TokenIdType** outputIdsPtrs{nullptr};
+
+    //! Required. Pointer to the workspace of size returned by getFusedSamplingWorkspaceSize.
+    void* workspace{nullptr};
+
+    //! input buffer [maxBatchSize]. EOS token ids per request
+    runtime::TokenIdType const* endIds{nullptr};
+    //! input/output buffer [maxBatchSize]. Current sequence length of the request, incremented unless EOS is sampled.
+    runtime::SizeType32* sequenceLengths{nullptr};
+    //! input buffer[batchSize], optional. Indices of rows of data in memory pool.
+    //! Linear indexing (batchIdx) is used if nullptr.
+    runtime::SizeType32 const* batchSlots{nullptr};
+
+    //! input buffer [maxBatchSize], optional. If true, request exits early.
+    FinishedState const* finishedInput{nullptr};
+    //! output buffer [maxBatchSize], optional. Set to finished if EOS is sampled.
+    FinishedState* finishedOutput{nullptr};
+    //! input buffer [maxBatchSize], optional. Flags whether to skip decoding per request
+    bool const* skipDecode{nullptr};
+
+    //! input/output buffer [maxBatchSize], optional. Cumulative log probability of selected tokens.
+    float* cumLogProbs{nullptr};
+    //! output buffer [maxSeqLen, maxBatchSize], optional. Log probability of the selected token over the vocabulary,
+    //! or over the top-k tokens if normalizeLogProbs is true.
+    float* outputLogProbs{nullptr};
+
+    //! input buffer [maxBatchSize]. Initialized curand states
+    curandState_t* curandState{nullptr};
+    //! input buffer [maxBatchSize], optional. K per request in [1; maxTopK], maxTopK is used if nullptr.
+    runtime::SizeType32 const* topKs{nullptr};
+    //! input buffer [maxBatchSize], optional. P per request in (0.0, 1.0], maxTopP is used if nullptr.
+    float const* topPs{nullptr};
+    runtime::SizeType32 maxTopK{FUSED_SAMPLING_TOP_K_MAX};
+    float maxTopP{1.0f};
+
+    runtime::SizeType32 batchSize{-1};
+    runtime::SizeType32 maxBatchSize{-1};
+    runtime::SizeType32 vocabSize{-1};
+    runtime::SizeType32 vocabSizePadded{-1};
+    runtime::SizeType32 maxSeqLen{-1};
+
+    //! First token of the local logits when the vocabulary is sharded over numShards ranks, e.g. with tensor
+    //! parallelism. logitsPtrs point to the shard, token ids, biases and occurrences span the whole vocabulary.
+    runtime::SizeType32 vocabShardBegin{0};
+    //! Number of tokens per shard, the same for all shards, the whole vocabulary if -1. The last shard ends at
+    //! vocabSize, its logits are padded.
+    runtime::SizeType32 vocabShardSize{-1};
+    //! Number of shards and index of the local shard. Each shard writes its candidates to its own part of the
+    //! workspace, see getFusedSamplingShardWorkspaceSize.
+    runtime::SizeType32 numShards{1};
+    runtime::SizeType32 shardRank{0};
+
+    //! when set to True outputLogProbs are normalized to TopK
+    bool normalizeLogProbs{false};
+
+    [[nodiscard]] __host__ __device__ runtime::SizeType32 getVocabShardSize() const
+    {
+        return vocabShardSize < 0 ? vocabSize : vocabShardSize;
+    }
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxBatchSize >= batchSize);
+        TLLM_CHECK(vocabSize > 0);
+        TLLM_CHECK(vocabSizePadded >= vocabSize);
+        TLLM_CHECK(maxSeqLen > 0);
+
+        TLLM_CHECK(logitsPtrs);
+        TLLM_CHECK(outputIdsPtrs);
+        TLLM_CHECK(workspace);
+        TLLM_CHECK(curandState);
+        TLLM_CHECK(endIds);
+        TLLM_CHECK(sequenceLengths);
+        TLLM_CHECK(penaltyWorkspace || (!repetitionPenalties && !presencePenalties && !frequencyPenalties));
+
+        TLLM_CHECK(0 < maxTopP && maxTopP <= 1.f);
+        TLLM_CHECK_WITH_INFO(0 < maxTopK && maxTopK <= FUSED_SAMPLING_TOP_K_MAX,
+            "Fused sampling kernel supports 1 <= k <= %d but got k=%d", FUSED_SAMPLING_TOP_K_MAX, maxTopK);
+
+        TLLM_CHECK(0 < numShards && 0 <= shardRank && shardRank < numShards);
+        TLLM_CHECK(0 <= vocabShardBegin && vocabShardBegin < vocabSize && 0 < getVocabShardSize());
+        TLLM_CHECK(numShards == 1 || vocabShardSize > 0);
+    }
+};
+
+//! \brief Applies the embedding bias, temperature, repetition, presence and frequency penalties and min length to the
+//! logits and performs top K **and** top P sampling, reading the logits once. Equivalent to invokeBatchApplyPenalty
+//! followed by invokeBatchTopKSampling for beam width 1 and one token per step, without writing the penalized logits.
+//! Log probs are computed over the vocabulary from the penalized logits, as if their softmax was computed.
+template <typename T>
+void invokeFusedPenaltyTopKSampling(FusedSamplingKernelParams<T> const& params, cudaStream_t stream);
+
+//! \brief First half of invokeFusedPenaltyTopKSampling over the local vocab shard. Penalizes the logits of the shard
+//! and writes its top-k candidates and softmax statistics to the part shardRank of the workspace.
+template <typename T>
+void invokeFusedPenaltyTopKCandidates(FusedSamplingKernelParams<T> const& params, cudaStream_t stream);
+
+//! \brief Second half of invokeFusedPenaltyTopKSampling. Merges the candidates of all numShards parts of the
+//! workspace, e.g. after they are all-gathered over the ranks, and samples the token of each request.
+//! All shards sample the same tokens if their random states are the same.
+template <typename T>
+void invokeFusedTopKSamplingFromCandidates(FusedSamplingKernelParams<T> const& params, cudaStream_t stream);
+
+[[nodiscard]] inline std::vector<size_t> getFusedSamplingWorkspaceSizes(
+    runtime::SizeType32 batchSize, runtime::SizeType32 maxTopK, runtime::SizeType32 vocabShardSize)
+{
+    auto const numChunks = static_cast<size_t>(common::ceilDiv(vocabShardSize, FUSED_SAMPLING_CHUNK_SIZE));
+    auto const numCandidates = static_cast<size_t>(batchSize) * numChunks * maxTopK;
+    auto const candidateIdsBufSize = sizeof(runtime::SizeType32) * numCandidates;
+    auto const candidateValsBufSize = sizeof(float) * numCandidates;
+    // Max and sum of exponentials of each chunk
+    auto const chunkStatsBufSize = sizeof(float) * batchSize * numChunks;
+
+    return {candidateIdsBufSize, candidateValsBufSize, chunkStatsBufSize, chunkStatsBufSize};
+}
+
+//! \brief Returns the size in bytes of the candidates of one vocab shard in the workspace, i.e. the size exchanged
+//! between the shards.
+//! \param batchSize batch size
+//! \param maxTopK maximum among all topKs K for topK sampling
+//! \param vocabShardSize size of the vocab shard
+[[nodiscard]] inline size_t getFusedSamplingShardWorkspaceSize(
+    runtime::SizeType32 batchSize, runtime::SizeType32 maxTopK, runtime::SizeType32 vocabShardSize)
+{
+    auto const workspaceSizes = getFusedSamplingWorkspaceSizes(batchSize, maxTopK, vocabShardSize);
+    return tensorrt_llm::common::calcAlignedSize(workspaceSizes, 256);
+}
+
+//! \brief Returns workspace size in bytes needed by invokeFusedPenaltyTopKSampling
+//! \param batchSize batch size
+//! \param maxTopK maximum among all topKs K for topK sampling
+//! \param vocabShardSize size of vocab, or of a vocab shard
+//! \param numShards number of vocab shards
+[[nodiscard]] inline size_t getFusedSamplingWorkspaceSize(runtime::SizeType32 batchSize, runtime::SizeType32 maxTopK,
+    runtime::SizeType32 vocabShardSize, runtime::SizeType32 numShards = 1)
+{
+    return numShards * getFusedSamplingShardWorkspaceSize(batchSize, maxTopK, vocabShardSize);
+}
+
+} // namespace kernels
+} // namespace tensorrt_llm
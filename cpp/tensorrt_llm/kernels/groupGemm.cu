@@ -57,12 +57,29 @@ int64_t getGroupedGemmParamsWorkSpaceSize(int64_t problem_count)
     return gemm_coord_size + ptr_size + ldd_size;
 }
 
+GroupedGemmParams getGroupedGemmParams(void* gemmParamsWorkspace, int64_t problem_count)
+{
+    auto gemm_coord_size = getGemmCoordSize(problem_count);
+    auto ptr_size = getPtrSize(problem_count);
+    auto ldd_size = getLddSize(problem_count);
+
+    char* base = static_cast<char*>(gemmParamsWorkspace);
+    GroupedGemmParams params;
+    params.problem_sizes = reinterpret_cast<cutlass::gemm::GemmCoord*>(base);
+    params.ptrA = reinterpret_cast<void**>(base + gemm_coord_size);
+    params.ptrB = reinterpret_cast<void**>(base + gemm_coord_size + ptr_size);
+    params.ptrC = reinterpret_cast<void**>(base + gemm_coord_size + 2 * ptr_size);
+    params.ptrD = reinterpret_cast<void**>(base + gemm_coord_size + 3 * ptr_size);
+    params.lda = reinterpret_cast<int64_t*>(base + gemm_coord_size + 4 * ptr_size + 0 * ldd_size);
+    params.ldb = reinterpret_cast<int64_t*>(base + gemm_coord_size + 4 * ptr_size + 1 * ldd_size);
+    params.ldc = reinterpret_cast<int64_t*>(base + gemm_coord_size + 4 * ptr_size + 2 * ldd_size);
+    params.ldd = reinterpret_cast<int64_t*>(base + gemm_coord_size + 4 * ptr_size + 3 * ldd_size);
+    return params;
+}
+
 template <int M1, int N1, int K1, int M2, int N2, int K2, typename cutlassType>
-void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vector<void*> ptrA, std::vector<void*> ptrB,
-    std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkSpace, int64_t gemmParamsWorkSpaceSize,
-    void* gemmWorkSpace, int64_t gemmWorkspaceSize, nvinfer1::DataType dataType, cudaStream_t stream)
+struct GroupedGemmKernel
 {
-    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     using ElementA = cutlassType;
     using ElementB = cutlassType;
     using ElementOutput = cutlassType;
@@ -72,10 +89,8 @@ void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vect
     using LayoutB = cutlass::layout::ColumnMajor;
     using LayoutC = cutlass::layout::RowMajor;
 
-    int const kAlignmentA = 8;
-    int const kAlignmentB = 8;
-
-    int problem_count = problem_sizes.size();
+    static int const kAlignmentA = 8;
+    static int const kAlignmentB = 8;
 
     using GemmKernel = typename cutlass::gemm::kernel::DefaultGemmGrouped<ElementA, LayoutA,
         cutlass::ComplexTransform::kNone, kAlignmentA, ElementB, LayoutB, cutlass::ComplexTransform::kNone, kAlignmentB,
@@ -91,70 +106,31 @@ void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vect
         cutlass::gemm::kernel::GroupScheduleMode::kDeviceOnly>::GemmKernel;
 
     using Gemm = cutlass::gemm::device::GemmGrouped<GemmKernel>;
+};
+
+// The problems are scheduled on the device, host_problem_sizes is only used to size the grid and may be null
+template <typename Gemm>
+void runGroupedGemm_(int problem_count, cutlass::gemm::GemmCoord* host_problem_sizes, GroupedGemmParams const& params,
+    void* gemmWorkSpace, int64_t gemmWorkspaceSize, cudaStream_t stream)
+{
+    using ElementA = typename Gemm::ElementA;
+    using ElementB = typename Gemm::ElementB;
+    using ElementOutput = typename Gemm::ElementC;
 
     float alpha = 1.0f;
     float beta = 0.0f;
     typename Gemm::EpilogueOutputOp::Params epilogue_op(alpha, beta);
 
-    auto gemm_coord_size = getGemmCoordSize(problem_count);
-    auto ptr_size = getPtrSize(problem_count);
-    auto ldd_size = getLddSize(problem_count);
+    int threadblock_count = Gemm::sufficient(host_problem_sizes, problem_count);
 
-    char* host_workspace = (char*) std::malloc(gemmParamsWorkSpaceSize);
-    cutlass::gemm::GemmCoord* problem_sizes_host = reinterpret_cast<cutlass::gemm::GemmCoord*>(host_workspace);
-    ElementA** ptr_A_host = reinterpret_cast<ElementA**>(host_workspace + gemm_coord_size);
-    ElementB** ptr_B_host = reinterpret_cast<ElementB**>(host_workspace + gemm_coord_size + ptr_size);
-    ElementOutput** ptr_C_host = reinterpret_cast<ElementOutput**>(host_workspace + gemm_coord_size + 2 * ptr_size);
-    ElementOutput** ptr_D_host = reinterpret_cast<ElementOutput**>(host_workspace + gemm_coord_size + 3 * ptr_size);
-    int64_t* lda_host = reinterpret_cast<int64_t*>(host_workspace + gemm_coord_size + 4 * ptr_size + 0 * ldd_size);
-    int64_t* ldb_host = reinterpret_cast<int64_t*>(host_workspace + gemm_coord_size + 4 * ptr_size + 1 * ldd_size);
-    int64_t* ldc_host = reinterpret_cast<int64_t*>(host_workspace + gemm_coord_size + 4 * ptr_size + 2 * ldd_size);
-    int64_t* ldd_host = reinterpret_cast<int64_t*>(host_workspace + gemm_coord_size + 4 * ptr_size + 3 * ldd_size);
-
-    for (int32_t i = 0; i < problem_count; ++i)
-    {
-        problem_sizes_host[i] = problem_sizes.at(i);
-        ptr_A_host[i] = (ElementA*) ptrA.at(i);
-        ptr_B_host[i] = (ElementB*) ptrB.at(i);
-        ptr_C_host[i] = (ElementOutput*) ptrC.at(i);
-        ptr_D_host[i] = (ElementOutput*) ptrD.at(i);
-
-        auto problem = problem_sizes.at(i);
-        lda_host[i] = LayoutA::packed({problem.m(), problem.k()}).stride(0);
-        ldb_host[i] = LayoutB::packed({problem.k(), problem.n()}).stride(0);
-        ldc_host[i] = LayoutC::packed({problem.m(), problem.n()}).stride(0);
-        ldd_host[i] = LayoutC::packed({problem.m(), problem.n()}).stride(0);
-    }
-
-    cutlass::gemm::GemmCoord* problem_sizes_device = reinterpret_cast<cutlass::gemm::GemmCoord*>(gemmParamsWorkSpace);
-    ElementA** ptr_A = reinterpret_cast<ElementA**>((char*) gemmParamsWorkSpace + gemm_coord_size);
-    ElementB** ptr_B = reinterpret_cast<ElementB**>((char*) gemmParamsWorkSpace + gemm_coord_size + ptr_size);
-    ElementOutput** ptr_C
-        = reinterpret_cast<ElementOutput**>((char*) gemmParamsWorkSpace + gemm_coord_size + 2 * ptr_size);
-    ElementOutput** ptr_D
-        = reinterpret_cast<ElementOutput**>((char*) gemmParamsWorkSpace + gemm_coord_size + 3 * ptr_size);
-    int64_t* lda
-        = reinterpret_cast<int64_t*>((char*) gemmParamsWorkSpace + gemm_coord_size + 4 * ptr_size + 0 * ldd_size);
-    int64_t* ldb
-        = reinterpret_cast<int64_t*>((char*) gemmParamsWorkSpace + gemm_coord_size + 4 * ptr_size + 1 * ldd_size);
-    int64_t* ldc
-        = reinterpret_cast<int64_t*>((char*) gemmParamsWorkSpace + gemm_coord_size + 4 * ptr_size + 2 * ldd_size);
-    int64_t* ldd
-        = reinterpret_cast<int64_t*>((char*) gemmParamsWorkSpace + gemm_coord_size + 4 * ptr_size + 3 * ldd_size);
-
-    TLLM_CHECK(((char*) ldc_host - (char*) host_workspace) == ((char*) ldc - (char*) gemmParamsWorkSpace));
-    tensorrt_llm::common::cudaAutoCpy(
-        (int8_t*) gemmParamsWorkSpace, (int8_t*) host_workspace, gemmParamsWorkSpaceSize, stream);
-
-    int threadblock_count = Gemm::sufficient(problem_sizes.data(), problem_count);
-
-    typename Gemm::Arguments args(problem_sizes_device, problem_count, threadblock_count, epilogue_op, ptr_A, ptr_B,
-        ptr_C, ptr_D, lda, ldb, ldc, ldd, problem_sizes.data());
+    typename Gemm::Arguments args(params.problem_sizes, problem_count, threadblock_count, epilogue_op,
+        reinterpret_cast<ElementA**>(params.ptrA), reinterpret_cast<ElementB**>(params.ptrB),
+        reinterpret_cast<ElementOutput**>(params.ptrC), reinterpret_cast<ElementOutput**>(params.ptrD), params.lda,
+        params.ldb, params.ldc, params.ldd, host_problem_sizes);
 
     // Initialize the GEMM object
     Gemm gemm;
 
-    size_t workspace_size = gemm.get_workspace_size(args);
     TLLM_CHECK(gemm.get_workspace_size(args) <= gemmWorkspaceSize);
 
     cutlass::Status status = gemm.initialize(args, gemmWorkSpace);
@@ -165,11 +141,59 @@ void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vect
     status = gemm.run(stream);
 
     TLLM_CHECK_WITH_INFO(status == cutlass::Status::kSuccess, "Failed to run CUTLASS Grouped GEMM kernel.");
+}
+
+template <int M1, int N1, int K1, int M2, int N2, int K2, typename cutlassType>
+void groupedGemm_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vector<void*> ptrA, std::vector<void*> ptrB,
+    std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkSpace, int64_t gemmParamsWorkSpaceSize,
+    void* gemmWorkSpace, int64_t gemmWorkspaceSize, nvinfer1::DataType dataType, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    using Kernel = GroupedGemmKernel<M1, N1, K1, M2, N2, K2, cutlassType>;
+    using LayoutA = typename Kernel::LayoutA;
+    using LayoutB = typename Kernel::LayoutB;
+    using LayoutC = typename Kernel::LayoutC;
+
+    int problem_count = problem_sizes.size();
+
+    // Same layout as the device workspace
+    char* host_workspace = (char*) std::malloc(gemmParamsWorkSpaceSize);
+    auto host_params = getGroupedGemmParams(host_workspace, problem_count);
+
+    for (int32_t i = 0; i < problem_count; ++i)
+    {
+        host_params.problem_sizes[i] = problem_sizes.at(i);
+        host_params.ptrA[i] = ptrA.at(i);
+        host_params.ptrB[i] = ptrB.at(i);
+        host_params.ptrC[i] = ptrC.at(i);
+        host_params.ptrD[i] = ptrD.at(i);
+
+        auto problem = problem_sizes.at(i);
+        host_params.lda[i] = LayoutA::packed({problem.m(), problem.k()}).stride(0);
+        host_params.ldb[i] = LayoutB::packed({problem.k(), problem.n()}).stride(0);
+        host_params.ldc[i] = LayoutC::packed({problem.m(), problem.n()}).stride(0);
+        host_params.ldd[i] = LayoutC::packed({problem.m(), problem.n()}).stride(0);
+    }
+
+    tensorrt_llm::common::cudaAutoCpy(
+        (int8_t*) gemmParamsWorkSpace, (int8_t*) host_workspace, gemmParamsWorkSpaceSize, stream);
+
+    runGroupedGemm_<typename Kernel::Gemm>(problem_count, problem_sizes.data(),
+        getGroupedGemmParams(gemmParamsWorkSpace, problem_count), gemmWorkSpace, gemmWorkspaceSize, stream);
 
     std::free(host_workspace);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+template <int M1, int N1, int K1, int M2, int N2, int K2, typename cutlassType>
+void groupedGemmDevice_(int64_t problem_count, void* gemmParamsWorkSpace, void* gemmWorkSpace,
+    int64_t gemmWorkspaceSize, cudaStream_t stream)
+{
+    using Kernel = GroupedGemmKernel<M1, N1, K1, M2, N2, K2, cutlassType>;
+    runGroupedGemm_<typename Kernel::Gemm>(problem_count, nullptr,
+        getGroupedGemmParams(gemmParamsWorkSpace, problem_count), gemmWorkSpace, gemmWorkspaceSize, stream);
+}
+
 template <int M1, int N1, int K1, int M2, int N2, int K2>
 void groupedGemmType_(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vector<void*> ptrA,
     std::vector<void*> ptrB, std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkSpace,
@@ -210,6 +234,43 @@ void groupedGemm(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vecto
     }
 }
 
+template <int M1, int N1, int K1, int M2, int N2, int K2>
+void groupedGemmDeviceType_(int64_t problem_count, void* gemmParamsWorkSpace, void* gemmWorkSpace,
+    int64_t gemmWorkspaceSize, nvinfer1::DataType dataType, cudaStream_t stream)
+{
+    if (dataType == nvinfer1::DataType::kHALF)
+    {
+        groupedGemmDevice_<M1, N1, K1, M2, N2, K2, cutlass::half_t>(
+            problem_count, gemmParamsWorkSpace, gemmWorkSpace, gemmWorkspaceSize, stream);
+    }
+    else if (dataType == nvinfer1::DataType::kFLOAT)
+    {
+        TLLM_CHECK_WITH_INFO(false, "not support float input/output");
+    }
+#ifdef ENABLE_BF16
+    else if (dataType == nvinfer1::DataType::kBF16)
+    {
+        groupedGemmDevice_<M1, N1, K1, M2, N2, K2, cutlass::bfloat16_t>(
+            problem_count, gemmParamsWorkSpace, gemmWorkSpace, gemmWorkspaceSize, stream);
+    }
+#endif
+}
+
+void groupedGemm(int64_t problem_count, void* gemmParamsWorkSpace, void* gemmWorkSpace, int64_t gemmWorkspaceSize,
+    bool isLoraIn, nvinfer1::DataType dataType, cudaStream_t stream)
+{
+    if (isLoraIn)
+    {
+        groupedGemmDeviceType_<16, 32, 64, 16, 32, 64>(
+            problem_count, gemmParamsWorkSpace, gemmWorkSpace, gemmWorkspaceSize, dataType, stream);
+    }
+    else
+    {
+        groupedGemmDeviceType_<32, 128, 32, 32, 32, 32>(
+            problem_count, gemmParamsWorkSpace, gemmWorkSpace, gemmWorkspaceSize, dataType, stream);
+    }
+}
+
 } // namespace kernels
 
 } // namespace tensorrt_llm
@@ -25,10 +25,32 @@ namespace kernels
 
 int64_t getGroupedGemmParamsWorkSpaceSize(int64_t problem_count);
 
+// Problem sizes, pointers and leading dimensions of the grouped GEMM problems inside a params workspace of
+// getGroupedGemmParamsWorkSpaceSize(problem_count) bytes
+struct GroupedGemmParams
+{
+    cutlass::gemm::GemmCoord* problem_sizes;
+    void** ptrA;
+    void** ptrB;
+    void** ptrC;
+    void** ptrD;
+    int64_t* lda;
+    int64_t* ldb;
+    int64_t* ldc;
+    int64_t* ldd;
+};
+
+GroupedGemmParams getGroupedGemmParams(void* gemmParamsWorkspace, int64_t problem_count);
+
 void groupedGemm(std::vector<cutlass::gemm::GemmCoord> problem_sizes, std::vector<void*> ptrA, std::vector<void*> ptrB,
     std::vector<void*> ptrC, std::vector<void*> ptrD, void* gemmParamsWorkspace, int64_t gemmParamsWorkSpaceSize,
     void* gemmWorkSpace, int64_t gemmWorkspaceSize, bool isLoraIn, nvinfer1::DataType dataType, cudaStream_t stream);
 
+// Runs the problems a kernel wrote to gemmParamsWorkSpace, see getGroupedGemmParams. The params are not read on the
+// host so the launch can be captured in a CUDA graph. Problems with an empty extent are skipped
+void groupedGemm(int64_t problem_count, void* gemmParamsWorkSpace, void* gemmWorkSpace, int64_t gemmWorkspaceSize,
+    bool isLoraIn, nvinfer1::DataType dataType, cudaStream_t stream);
+
 } // namespace kernels
 
 } // namespace tensorrt_llm
@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/kvCacheEvictionKernels.h"
+
+#include <cstdint>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+SizeType32 constexpr IMPORTANCE_BLOCK_SIZE = 256;
+SizeType32 constexpr COMPACTION_BLOCK_SIZE = 128;
+
+template <typename T>
+__device__ float computeScore(KVBlockArray const& kvCache, float const* sQ, SizeType32 seqIdx, SizeType32 kvHeadIdx,
+    SizeType32 tokenIdx, SizeType32 headSize)
+{
+    auto const* kBlock = reinterpret_cast<T const*>(kvCache.getKBlockPtr(seqIdx, tokenIdx));
+    auto const kOffset = kvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, headSize, 0);
+    float score = 0.f;
+    for (SizeType32 di = 0; di < headSize; ++di)
+    {
+        score += sQ[di] * static_cast<float>(kBlock[kOffset + di]);
+    }
+    return score;
+}
+
+//! One block per sequence, head and query. The first pass computes the maximum and the sum of the softmax, the second
+//! one recomputes the scores and adds the probabilities to the importance of the tokens.
+template <typename T>
+__global__ void accumulateKvTokenImportance(KvTokenImportanceParams<T> params)
+{
+    extern __shared__ float sQ[];
+    __shared__ float sMax;
+    __shared__ float sSum;
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const headIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const queryIdx = static_cast<SizeType32>(blockIdx.z);
+    auto const headSize = params.headSize;
+    auto const kvHeadIdx = headIdx / (params.numHeads / params.numKvHeads);
+    // The query attends the tokens up to its own.
+    auto const queryPos = params.seqLengths[seqIdx] - params.numQueries + queryIdx;
+    if (queryPos < 0)
+    {
+        return;
+    }
+
+    auto const* q = params.q + ((seqIdx * params.numQueries + queryIdx) * params.numHeads + headIdx) * headSize;
+    for (auto di = tid; di < headSize; di += IMPORTANCE_BLOCK_SIZE)
+    {
+        sQ[di] = static_cast<float>(q[di]) * params.qkScale;
+    }
+    __syncthreads();
+
+    float threadMax = -INFINITY;
+    float threadSum = 0.f;
+    for (auto tokenIdx = tid; tokenIdx <= queryPos; tokenIdx += IMPORTANCE_BLOCK_SIZE)
+    {
+        auto const score = computeScore<T>(params.kvCache, sQ, seqIdx, kvHeadIdx, tokenIdx, headSize);
+        auto const newMax = fmaxf(threadMax, score);
+        threadSum = threadSum * __expf(threadMax - newMax) + __expf(score - newMax);
+        threadMax = newMax;
+    }
+    auto const blockMax = blockReduceMax<float>(threadMax);
+    if (tid == 0)
+    {
+        sMax = blockMax;
+    }
+    __syncthreads();
+    auto const maxScore = sMax;
+    auto const blockSum
+        = blockReduceSum<float>(threadMax == -INFINITY ? 0.f : threadSum * __expf(threadMax - maxScore));
+    if (tid == 0)
+    {
+        sSum = blockSum;
+    }
+    __syncthreads();
+    auto const invSum = 1.f / sSum;
+
+    auto* importance = params.importance + (seqIdx * params.numKvHeads + kvHeadIdx) * params.maxSeqLength;
+    for (auto tokenIdx = tid; tokenIdx <= queryPos; tokenIdx += IMPORTANCE_BLOCK_SIZE)
+    {
+        auto const score = computeScore<T>(params.kvCache, sQ, seqIdx, kvHeadIdx, tokenIdx, headSize);
+        atomicAdd(importance + tokenIdx, __expf(score - maxScore) * invSum);
+    }
+}
+
+//! One block per sequence, head group and K or V. The kept tokens are moved in ascending order, a token is never
+//! moved after its position was overwritten since kept[i] >= i. Each thread moves the same words of every token.
+__global__ void compactKvCache(KvCacheCompactionParams params)
+{
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const kvHeadIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const kvIdx = blockIdx.z == 0 ? KVIdxType::K_IDX : KVIdxType::V_IDX;
+    auto const& kvCache = params.kvCache;
+    auto const wordsPerHead = params.bytesPerHead / static_cast<SizeType32>(sizeof(std::uint32_t));
+    auto const numKept = params.numKeptTokens[seqIdx];
+    auto const* kept = params.keptTokens + (seqIdx * params.numKvHeads + kvHeadIdx) * params.maxKeptTokens;
+    auto* importance = params.importance != nullptr && kvIdx == KVIdxType::K_IDX
+        ? params.importance + (seqIdx * params.numKvHeads + kvHeadIdx) * params.maxSeqLength
+        : nullptr;
+
+    for (SizeType32 dstIdx = 0; dstIdx < numKept; ++dstIdx)
+    {
+        auto const srcIdx = kept[dstIdx];
+        if (srcIdx == dstIdx)
+        {
+            continue;
+        }
+        auto const* src = reinterpret_cast<std::uint32_t const*>(kvCache.getBlockPtr(seqIdx, srcIdx, kvIdx));
+        auto* dst = reinterpret_cast<std::uint32_t*>(kvCache.getBlockPtr(seqIdx, dstIdx, kvIdx));
+        for (auto wi = tid; wi < wordsPerHead; wi += COMPACTION_BLOCK_SIZE)
+        {
+            dst[kvCache.getKVLocalIdx(dstIdx, kvHeadIdx, wordsPerHead, wi)]
+                = src[kvCache.getKVLocalIdx(srcIdx, kvHeadIdx, wordsPerHead, wi)];
+        }
+        if (tid == 0)
+        {
+            if (kvCache.hasTokenScales())
+            {
+                *kvCache.getScalePtr(seqIdx, dstIdx, kvIdx, kvHeadIdx)
+                    = *kvCache.getScalePtr(seqIdx, srcIdx, kvIdx, kvHeadIdx);
+            }
+            if (importance != nullptr)
+            {
+                importance[dstIdx] = importance[srcIdx];
+            }
+        }
+    }
+
+    if (importance != nullptr)
+    {
+        __syncthreads();
+        for (auto tokenIdx = numKept + tid; tokenIdx < params.seqLengths[seqIdx]; tokenIdx += COMPACTION_BLOCK_SIZE)
+        {
+            importance[tokenIdx] = 0.f;
+        }
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeAccumulateKvTokenImportance(KvTokenImportanceParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+    dim3 const grid(params.numSeqs, params.numHeads, params.numQueries);
+    auto const smemSize = params.headSize * sizeof(float);
+    accumulateKvTokenImportance<T><<<grid, IMPORTANCE_BLOCK_SIZE, smemSize, stream>>>(params);
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void invokeCompactKvCache(KvCacheCompactionParams const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+    dim3 const grid(params.numSeqs, params.numKvHeads, 2);
+    compactKvCache<<<grid, COMPACTION_BLOCK_SIZE, 0, stream>>>(params);
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeAccumulateKvTokenImportance(KvTokenImportanceParams<float> const& params, cudaStream_t stream);
+template void invokeAccumulateKvTokenImportance(KvTokenImportanceParams<half> const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeAccumulateKvTokenImportance(
+    KvTokenImportanceParams<__nv_bfloat16> const& params, cudaStream_t stream);
+#endif
+} // namespace kernels
+} // namespace tensorrt_llm
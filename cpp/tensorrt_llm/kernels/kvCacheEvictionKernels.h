@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+//! Largest head size supported by invokeAccumulateKvTokenImportance.
+static constexpr runtime::SizeType32 KV_TOKEN_IMPORTANCE_MAX_HEAD_SIZE = 256;
+
+template <typename T>
+struct KvTokenImportanceParams
+{
+    //! input buffer [numSeqs, numQueries, numHeads, headSize], required. Queries of the last numQueries tokens of each
+    //! sequence, the observation window, after the position embedding.
+    T const* q{nullptr};
+    //! input buffer [numSeqs], required. Number of tokens in the KV cache of each sequence, at least numQueries.
+    runtime::SizeType32 const* seqLengths{nullptr};
+    //! Paged KV cache of type T of one layer, without cyclic window.
+    KVBlockArray kvCache;
+    //! input/output buffer [numSeqs, numKvHeads, maxSeqLength], required. The attention probabilities of the queries
+    //! of each head group are added to the importance of the tokens.
+    float* importance{nullptr};
+
+    runtime::SizeType32 numSeqs{0};
+    runtime::SizeType32 numQueries{1};
+    runtime::SizeType32 numHeads{0};
+    runtime::SizeType32 numKvHeads{0};
+    runtime::SizeType32 headSize{0};
+    runtime::SizeType32 maxSeqLength{0};
+    //! Scale of the scores, usually 1 / sqrt(headSize).
+    float qkScale{1.f};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(numSeqs > 0);
+        TLLM_CHECK(numQueries > 0);
+        TLLM_CHECK(numKvHeads > 0 && numHeads % numKvHeads == 0);
+        TLLM_CHECK(0 < headSize && headSize <= KV_TOKEN_IMPORTANCE_MAX_HEAD_SIZE);
+        TLLM_CHECK(maxSeqLength > 0);
+        TLLM_CHECK(q);
+        TLLM_CHECK(seqLengths);
+        TLLM_CHECK(importance);
+    }
+};
+
+//! \brief Accumulates the importance of the cached tokens for the eviction of the KV cache, as in SnapKV: the
+//! softmax of the scores of the observation window queries over the tokens before them, summed over the queries and
+//! the heads of each group. Called on the layers whose importance drives the eviction, e.g. every few steps.
+template <typename T>
+void invokeAccumulateKvTokenImportance(KvTokenImportanceParams<T> const& params, cudaStream_t stream);
+
+struct KvCacheCompactionParams
+{
+    //! Paged KV cache of one layer, without cyclic window. Its element type does not matter.
+    KVBlockArray kvCache;
+    //! input buffer [numSeqs, numKvHeads, maxKeptTokens], required. Ascending indices of the tokens each head group
+    //! keeps, the first numKeptTokens[s] of each row are used.
+    runtime::SizeType32 const* keptTokens{nullptr};
+    //! input buffer [numSeqs], required. Number of tokens each sequence keeps, the same for all its head groups.
+    runtime::SizeType32 const* numKeptTokens{nullptr};
+    //! input buffer [numSeqs], required if importance is set. Number of tokens in the KV cache before the compaction.
+    runtime::SizeType32 const* seqLengths{nullptr};
+    //! input/output buffer [numSeqs, numKvHeads, maxSeqLength], optional. Compacted along with the cache, and cleared
+    //! after the kept tokens, so that the accumulation continues at the new positions.
+    float* importance{nullptr};
+
+    runtime::SizeType32 numSeqs{0};
+    runtime::SizeType32 numKvHeads{0};
+    runtime::SizeType32 maxKeptTokens{0};
+    runtime::SizeType32 maxSeqLength{0};
+    //! Size of the K or V of one head of one token, a multiple of 4 bytes.
+    runtime::SizeType32 bytesPerHead{0};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(numSeqs > 0);
+        TLLM_CHECK(numKvHeads > 0);
+        TLLM_CHECK(maxKeptTokens > 0);
+        TLLM_CHECK_WITH_INFO(bytesPerHead > 0 && bytesPerHead % 4 == 0, "Unsupported head size of %d bytes",
+            static_cast<int>(bytesPerHead));
+        TLLM_CHECK(keptTokens);
+        TLLM_CHECK(numKeptTokens);
+        TLLM_CHECK(importance == nullptr || (seqLengths && maxSeqLength > 0));
+    }
+};
+
+//! \brief Moves the kept tokens of each head group to the start of the KV cache of their sequence, in place. The
+//! blocks after the kept tokens can then be released, e.g. with KVCacheManager::rewindKVCache. As with the sink tokens
+//! of StreamingLLM, the keys must be rotated by their position in the cache when they are read, i.e. with position
+//! shift in MMHA, for the compacted cache to stay consistent.
+void invokeCompactKvCache(KvCacheCompactionParams const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
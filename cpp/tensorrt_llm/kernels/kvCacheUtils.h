@@ -102,6 +102,13 @@ struct KVBlockArray : public KVBlockArrayForContextFMHA
     int32_t mBubbleLen;
     // Enable one more block to save the kv tokens
     bool mEnableOneMoreBlock;
+    // Pointers to the pools of per-token dequantization scales of 8-bit caches, nullptr for one scale per layer.
+    // Each block of the KV pools has a block of scales of shape [H, T] at the same offset, where
+    // H is number of kv heads and T is tokens per block.
+    float* mPrimaryScalePoolPtr{nullptr};
+    float* mSecondaryScalePoolPtr{nullptr};
+    // Number of scales per block (H*T).
+    int32_t mScalesPerBlock{0};
 
     KVBlockArray() = default;
 
@@ -184,6 +191,42 @@ struct KVBlockArray : public KVBlockArrayForContextFMHA
         return headIdx * mTokensPerBlock * dimsPerHead + getLocalIdx(globalTokenIdx) * dimsPerHead + channelIdx;
     }
 
+    void setTokenScalePools(float* primaryScalePoolPtr, float* secondaryScalePoolPtr, int32_t numKvHeads)
+    {
+        TLLM_CHECK_WITH_INFO(primaryScalePoolPtr != nullptr || secondaryScalePoolPtr == nullptr,
+            "The secondary scale pool requires a primary scale pool");
+        mPrimaryScalePoolPtr = primaryScalePoolPtr;
+        mSecondaryScalePoolPtr = secondaryScalePoolPtr;
+        mScalesPerBlock = numKvHeads * mTokensPerBlock;
+    }
+
+    __host__ __device__ [[nodiscard]] inline bool hasTokenScales() const
+    {
+        return mPrimaryScalePoolPtr != nullptr;
+    }
+
+    __host__ __device__ [[nodiscard]] inline float* getScalePtr(
+        int32_t seqIdx, int32_t tokenIdx, KVIdxType kvIdx, int32_t headIdx) const
+    {
+        // Returns pointer to the dequantization scale of one head of one token, tokenIdx is the kv token idx.
+        auto const offset = getRowPtr(kvIdx, seqIdx)[tokenIdx >> mTokensPerBlockLog2];
+        float* pool = offset.isPrimary() ? mPrimaryScalePoolPtr : mSecondaryScalePoolPtr;
+        return pool + offset.get() * static_cast<uint64_t>(mScalesPerBlock) + headIdx * mTokensPerBlock
+            + getLocalIdx(tokenIdx);
+    }
+
+    __host__ __device__ [[nodiscard]] inline float* getKScalePtr(
+        int32_t seqIdx, int32_t tokenIdx, int32_t headIdx) const
+    {
+        return getScalePtr(seqIdx, tokenIdx, KVIdxType::K_IDX, headIdx);
+    }
+
+    __host__ __device__ [[nodiscard]] inline float* getVScalePtr(
+        int32_t seqIdx, int32_t tokenIdx, int32_t headIdx) const
+    {
+        return getScalePtr(seqIdx, tokenIdx, KVIdxType::V_IDX, headIdx);
+    }
+
 private:
     __host__ __device__ [[nodiscard]] void* getPoolPtr(DataType offset) const
     {
@@ -289,6 +332,24 @@ struct KVLinearBuffer
     {
         return headIdx * mMaxSeqLen * dimsPerHead + tokenIdx * dimsPerHead + channelIdx;
     }
+
+    // Contiguous caches only support one scale per layer.
+    __host__ __device__ [[nodiscard]] inline bool hasTokenScales() const
+    {
+        return false;
+    }
+
+    __host__ __device__ [[nodiscard]] inline float* getKScalePtr(
+        int32_t /*seqIdx*/, int32_t /*tokenIdx*/, int32_t /*headIdx*/) const
+    {
+        return nullptr;
+    }
+
+    __host__ __device__ [[nodiscard]] inline float* getVScalePtr(
+        int32_t /*seqIdx*/, int32_t /*tokenIdx*/, int32_t /*headIdx*/) const
+    {
+        return nullptr;
+    }
 };
 
 } // namespace tensorrt_llm::kernels
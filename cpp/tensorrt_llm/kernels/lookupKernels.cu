@@ -37,18 +37,30 @@ input IDs and get the correct results.
  * The total thread number equals to token_num*hidden
  *
  * If the input ids is out of range it writes zero, otherwise it writes the correct embedding result.
+ *
+ * With a prompt table, the virtual tokens (ids >= vocab_size) take their row from the prompt table of their task
+ * instead, in one pass with the regular tokens.
  */
 template <typename Tout, typename Tin, typename Idx>
 __global__ void lookup_kernel(Tout* output, Idx const* input, Tin const* weight, int64_t const token_num,
-    Idx const offset, Idx const size, Idx const n_embed, Tout const* perTokenScales)
+    Idx const offset, Idx const size, Idx const n_embed, Tout const* perTokenScales, Tout const* prompt_table,
+    Idx const* tasks, Idx const* task_vocab_size, Idx const vocab_size)
 {
     for (int64_t index = blockIdx.x * blockDim.x + threadIdx.x; index < token_num * n_embed;
          index += blockDim.x * gridDim.x)
     {
-        int64_t const word_index = input[index / n_embed] - offset;
+        int64_t const token_index = index / n_embed;
+        Idx const id = input[token_index];
+        int64_t const word_index = id - offset;
         Idx const col_index = index % n_embed;
         Tout embedding;
-        if (word_index < 0 || word_index >= size)
+        if (prompt_table != nullptr && id >= vocab_size)
+        {
+            // Only one shard writes the prompt rows, so that the all reduce of the shards keeps them
+            int64_t const prompt_index = static_cast<int64_t>(tasks[token_index]) * *task_vocab_size + id - vocab_size;
+            embedding = offset == 0 ? prompt_table[prompt_index * n_embed + col_index] : Tout(0.f);
+        }
+        else if (word_index < 0 || word_index >= size)
         {
             embedding = Tout(0.f);
         }
@@ -66,20 +78,21 @@ __global__ void lookup_kernel(Tout* output, Idx const* input, Tin const* weight,
 
 template <typename Tout, typename Tin, typename Idx>
 void invokeLookUp(Tout* out, Idx const* input, Tin const* weight, int64_t const token_num, Idx const offset,
-    Idx const size, Idx const n_embed, Tout const* perTokenScales, cudaStream_t stream)
+    Idx const size, Idx const n_embed, Tout const* perTokenScales, cudaStream_t stream, Tout const* promptTable,
+    Idx const* tasks, Idx const* taskVocabSize, Idx const vocabSize)
 {
     int64_t constexpr max_block_num = 65536;
     Idx constexpr max_block_size = 512;
     dim3 grid(min(token_num, max_block_num));
     dim3 block(min(n_embed, max_block_size));
-    lookup_kernel<Tout, Tin, Idx>
-        <<<grid, block, 0, stream>>>(out, input, weight, token_num, offset, size, n_embed, perTokenScales);
+    lookup_kernel<Tout, Tin, Idx><<<grid, block, 0, stream>>>(out, input, weight, token_num, offset, size, n_embed,
+        perTokenScales, promptTable, tasks, taskVocabSize, vocabSize);
 }
 
 #define INSTANTIATE_LOOK_UP(Tout, Tin, Idx)                                                                            \
     template void invokeLookUp<Tout, Tin, Idx>(Tout * out, Idx const* input, Tin const* weight,                        \
         int64_t const token_num, Idx const offset, Idx const size, Idx const n_embed, Tout const* perTokenScales,      \
-        cudaStream_t stream)
+        cudaStream_t stream, Tout const* promptTable, Idx const* tasks, Idx const* taskVocabSize, Idx const vocabSize)
 
 INSTANTIATE_LOOK_UP(float, float, int);
 INSTANTIATE_LOOK_UP(float, int8_t, int);
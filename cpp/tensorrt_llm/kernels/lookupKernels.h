@@ -25,9 +25,14 @@ namespace tensorrt_llm
 {
 namespace kernels
 {
+// Ids at or above vocabSize are the virtual tokens of prompt tuning. With a promptTable, the shard at offset 0 writes
+// their row promptTable[tasks[token] * taskVocabSize + id - vocabSize], the other shards write zeros like for the ids
+// outside of their shard.
 template <typename Tout, typename Tin, typename Idx>
 void invokeLookUp(Tout* out, Idx const* input, Tin const* weight, int64_t const token_num, Idx const offset,
-    Idx const size, Idx const n_embed, Tout const* perTokenScales, cudaStream_t stream = 0);
+    Idx const size, Idx const n_embed, Tout const* perTokenScales, cudaStream_t stream = 0,
+    Tout const* promptTable = nullptr, Idx const* tasks = nullptr, Idx const* taskVocabSize = nullptr,
+    Idx const vocabSize = 0);
 
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2019-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/loraGroupGemmParams.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/dataType.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+__device__ bool sameLoraWeights(LoraGroupGemmRequests const& requests, int64_t a, int64_t b)
+{
+    return requests.ranks[a] == requests.ranks[b] && requests.weights_ptrs[a * 2] == requests.weights_ptrs[b * 2]
+        && requests.weights_ptrs[a * 2 + 1] == requests.weights_ptrs[b * 2 + 1];
+}
+
+// One thread per module and request
+__global__ void setupLoraGroupGemmParamsKernel(LoraGroupGemmRequests requests, int batch_size, int num_modules,
+    char const* input, int64_t in_hidden_size, char* low_rank_buffer, int64_t low_rank_module_stride,
+    int max_low_rank, int weight_index, int64_t type_size, GroupedGemmParams in_params, GroupedGemmParams out_params)
+{
+    int64_t const idx = blockIdx.x * static_cast<int64_t>(blockDim.x) + threadIdx.x;
+    if (idx >= static_cast<int64_t>(batch_size) * num_modules)
+    {
+        return;
+    }
+    int const module = idx / batch_size;
+    int const request = idx % batch_size;
+
+    int64_t token_offset = 0;
+    for (int i = 0; i < request; ++i)
+    {
+        token_offset += requests.num_tokens[i];
+    }
+
+    // A request that continues the run of its predecessor is handled by the first request of the run
+    bool const merged = request > 0 && sameLoraWeights(requests, idx, idx - 1);
+    int64_t num_rows = 0;
+    for (int i = request; !merged && i < batch_size && sameLoraWeights(requests, idx, idx + i - request); ++i)
+    {
+        num_rows += requests.num_tokens[i];
+    }
+
+    int64_t const K = in_hidden_size;
+    int64_t const N = requests.ranks[idx];
+    int64_t const N2 = requests.out_hidden_sizes[module];
+    int64_t const M = N > 0 ? num_rows : 0;
+
+    char const* in_weights = reinterpret_cast<char const*>(requests.weights_ptrs[idx * 2]);
+    char const* out_weights = reinterpret_cast<char const*>(requests.weights_ptrs[idx * 2 + 1]);
+    char* low_rank = low_rank_buffer + (module * low_rank_module_stride + token_offset * max_low_rank) * type_size;
+    char* output = reinterpret_cast<char*>(requests.outputs[module]) + token_offset * N2 * type_size;
+
+    // [M, K] x [K, N] -> [M, N], row major activations and column major weights
+    in_params.problem_sizes[idx] = cutlass::gemm::GemmCoord(M, N, K);
+    in_params.ptrA[idx] = const_cast<char*>(input + token_offset * K * type_size);
+    in_params.ptrB[idx] = const_cast<char*>(in_weights + K * N * type_size * weight_index);
+    in_params.ptrC[idx] = low_rank;
+    in_params.ptrD[idx] = low_rank;
+    in_params.lda[idx] = K;
+    in_params.ldb[idx] = K;
+    in_params.ldc[idx] = N;
+    in_params.ldd[idx] = N;
+
+    // [M, N] x [N, N2] -> [M, N2]
+    out_params.problem_sizes[idx] = cutlass::gemm::GemmCoord(M, N2, N);
+    out_params.ptrA[idx] = low_rank;
+    out_params.ptrB[idx] = const_cast<char*>(out_weights + N2 * N * type_size * weight_index);
+    out_params.ptrC[idx] = output;
+    out_params.ptrD[idx] = output;
+    out_params.lda[idx] = N;
+    out_params.ldb[idx] = N;
+    out_params.ldc[idx] = N2;
+    out_params.ldd[idx] = N2;
+}
+
+} // namespace
+
+void setupLoraGroupGemmParams(LoraGroupGemmRequests const& requests, int batch_size, int num_modules,
+    void const* input, int64_t in_hidden_size, void* low_rank_buffer, int64_t max_context_length, int max_low_rank,
+    int weight_index, nvinfer1::DataType dataType, void* in_gemm_params, void* out_gemm_params, cudaStream_t stream)
+{
+    int64_t const problem_count = static_cast<int64_t>(batch_size) * num_modules;
+    if (problem_count == 0)
+    {
+        return;
+    }
+
+    int const threads = 128;
+    int const blocks = common::divUp(problem_count, threads);
+    setupLoraGroupGemmParamsKernel<<<blocks, threads, 0, stream>>>(requests, batch_size, num_modules,
+        static_cast<char const*>(input), in_hidden_size, static_cast<char*>(low_rank_buffer),
+        batch_size * max_context_length * max_low_rank, max_low_rank, weight_index, common::getDTypeSize(dataType),
+        getGroupedGemmParams(in_gemm_params, problem_count), getGroupedGemmParams(out_gemm_params, problem_count));
+    sync_check_cuda_error();
+}
+
+} // namespace kernels
+
+} // namespace tensorrt_llm
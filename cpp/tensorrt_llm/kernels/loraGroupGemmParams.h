@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2019-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/kernels/groupGemm.h"
+#include <NvInferRuntime.h>
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Per request LoRA table in device memory, in the layout of the LoRA plugin inputs
+struct LoraGroupGemmRequests
+{
+    // [num_modules, batch_size], 0 for requests without LoRA
+    int32_t const* ranks;
+    // [num_modules, batch_size, 2], addresses of the in and out weights
+    int64_t const* weights_ptrs;
+    // [batch_size], rows of each request in the input
+    int32_t const* num_tokens;
+    // [num_modules], addresses of the module outputs
+    int64_t const* outputs;
+    // [num_modules]
+    int32_t const* out_hidden_sizes;
+};
+
+// Writes the in and out grouped GEMM problems of every module and request to in_gemm_params and out_gemm_params,
+// see getGroupedGemmParams, without reading the requests on the host. Runs of consecutive requests with the same
+// weights are merged into one problem, the others are left empty. Problem i * batch_size + j is request j of module i.
+// The low rank results of module i start at low_rank_buffer + i * batch_size * max_context_length * max_low_rank
+void setupLoraGroupGemmParams(LoraGroupGemmRequests const& requests, int batch_size, int num_modules,
+    void const* input, int64_t in_hidden_size, void* low_rank_buffer, int64_t max_context_length, int max_low_rank,
+    int weight_index, nvinfer1::DataType dataType, void* in_gemm_params, void* out_gemm_params, cudaStream_t stream);
+
+} // namespace kernels
+
+} // namespace tensorrt_llm
@@ -0,0 +1,234 @@
+/*
+ * Copyright (c) 2019-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/kernels/loraSegmentedGemv.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+
+int constexpr kThreadsPerBlock = 256;
+int constexpr kWarpSize = 32;
+
+__device__ int64_t getTokenOffset(LoraGroupGemmRequests const& requests, int request)
+{
+    int64_t offset = 0;
+    for (int i = 0; i < request; ++i)
+    {
+        offset += requests.num_tokens[i];
+    }
+    return offset;
+}
+
+__device__ bool isAligned(void const* ptr)
+{
+    return reinterpret_cast<uintptr_t>(ptr) % sizeof(uint4) == 0;
+}
+
+// Partial dot product of the elements start, start + stride, ... of a and b, stride and start in elements
+template <typename T, typename U>
+__device__ float partialDot(T const* a, U const* b, int64_t size, int64_t start, int64_t stride)
+{
+    float acc = 0.f;
+    for (int64_t i = start; i < size; i += stride)
+    {
+        acc += cuda_cast<float>(a[i]) * cuda_cast<float>(b[i]);
+    }
+    return acc;
+}
+
+// Partial dot product of the 16B vectors lane, lane + num_lanes, ... of a and b, size must be a multiple of the
+// vector size and a, b 16B aligned
+template <typename T, typename U>
+__device__ float partialDotVec(T const* a, U const* b, int64_t size, int lane, int num_lanes)
+{
+    int constexpr kVecSize = sizeof(uint4) / sizeof(T);
+    float acc = 0.f;
+    for (int64_t i = lane * kVecSize; i < size; i += num_lanes * kVecSize)
+    {
+        uint4 const a_vec = *reinterpret_cast<uint4 const*>(a + i);
+        T const* a_elems = reinterpret_cast<T const*>(&a_vec);
+#pragma unroll
+        for (int j = 0; j < kVecSize; ++j)
+        {
+            acc += cuda_cast<float>(a_elems[j]) * cuda_cast<float>(b[i + j]);
+        }
+    }
+    return acc;
+}
+
+// grid (batch_size, num_modules), one warp per low rank column: low_rank[t, n] = sum_k input[t, k] * in_weights[n, k]
+template <typename T>
+__global__ void loraShrinkKernel(LoraGroupGemmRequests requests, T const* input, int64_t in_hidden_size,
+    T* low_rank_buffer, int64_t low_rank_module_stride, int max_low_rank, int weight_index)
+{
+    int const batch_size = gridDim.x;
+    int const request = blockIdx.x;
+    int const module = blockIdx.y;
+    int64_t const idx = static_cast<int64_t>(module) * batch_size + request;
+    int const rank = requests.ranks[idx];
+    if (rank == 0)
+    {
+        return;
+    }
+
+    int64_t const K = in_hidden_size;
+    int64_t const token_offset = getTokenOffset(requests, request);
+    int const num_tokens = requests.num_tokens[request];
+    T const* in_weights = reinterpret_cast<T const*>(requests.weights_ptrs[idx * 2]) + K * rank * weight_index;
+    T* low_rank = low_rank_buffer + module * low_rank_module_stride + token_offset * max_low_rank;
+    bool const vectorize
+        = K % (sizeof(uint4) / sizeof(T)) == 0 && isAligned(in_weights) && isAligned(input + token_offset * K);
+
+    int const warp = threadIdx.x / kWarpSize;
+    int const lane = threadIdx.x % kWarpSize;
+    int const num_warps = blockDim.x / kWarpSize;
+    for (int token = 0; token < num_tokens; ++token)
+    {
+        T const* x = input + (token_offset + token) * K;
+        for (int n = warp; n < rank; n += num_warps)
+        {
+            T const* w = in_weights + n * K;
+            float acc = vectorize ? partialDotVec(w, x, K, lane, kWarpSize) : partialDot(w, x, K, lane, kWarpSize);
+            acc = warpReduceSum(acc);
+            if (lane == 0)
+            {
+                low_rank[token * max_low_rank + n] = cuda_cast<T>(acc);
+            }
+        }
+    }
+}
+
+// grid (output column blocks, batch_size, num_modules), one thread per output column:
+// output[t, j] = sum_n low_rank[t, n] * out_weights[j, n]
+template <typename T>
+__global__ void loraExpandKernel(LoraGroupGemmRequests requests, T const* low_rank_buffer,
+    int64_t low_rank_module_stride, int max_low_rank, int weight_index)
+{
+    extern __shared__ float low_rank_row[];
+
+    int const batch_size = gridDim.y;
+    int const request = blockIdx.y;
+    int const module = blockIdx.z;
+    int64_t const idx = static_cast<int64_t>(module) * batch_size + request;
+    int const rank = requests.ranks[idx];
+    int64_t const N2 = requests.out_hidden_sizes[module];
+    int64_t const column = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (static_cast<int64_t>(blockIdx.x) * blockDim.x >= N2)
+    {
+        return;
+    }
+
+    int64_t const token_offset = getTokenOffset(requests, request);
+    int const num_tokens = requests.num_tokens[request];
+    T* output = reinterpret_cast<T*>(requests.outputs[module]) + token_offset * N2;
+    if (rank == 0)
+    {
+        for (int token = 0; token < num_tokens && column < N2; ++token)
+        {
+            output[token * N2 + column] = cuda_cast<T>(0.f);
+        }
+        return;
+    }
+
+    T const* out_weights = reinterpret_cast<T const*>(requests.weights_ptrs[idx * 2 + 1]) + N2 * rank * weight_index;
+    T const* low_rank = low_rank_buffer + module * low_rank_module_stride + token_offset * max_low_rank;
+    bool const vectorize = rank % (sizeof(uint4) / sizeof(T)) == 0 && isAligned(out_weights);
+    for (int token = 0; token < num_tokens; ++token)
+    {
+        __syncthreads();
+        for (int n = threadIdx.x; n < rank; n += blockDim.x)
+        {
+            low_rank_row[n] = cuda_cast<float>(low_rank[token * max_low_rank + n]);
+        }
+        __syncthreads();
+        if (column < N2)
+        {
+            T const* w = out_weights + column * rank;
+            float const acc
+                = vectorize ? partialDotVec(w, low_rank_row, rank, 0, 1) : partialDot(w, low_rank_row, rank, 0, 1);
+            output[token * N2 + column] = cuda_cast<T>(acc);
+        }
+    }
+}
+
+template <typename T>
+void loraSegmentedGemv_(LoraGroupGemmRequests const& requests, int batch_size, int num_modules, T const* input,
+    int64_t in_hidden_size, int64_t max_out_hidden_size, T* low_rank_buffer, int64_t max_context_length,
+    int max_low_rank, int weight_index, cudaStream_t stream)
+{
+    int64_t const low_rank_module_stride = batch_size * max_context_length * max_low_rank;
+
+    dim3 const shrinkGrid(batch_size, num_modules);
+    loraShrinkKernel<T><<<shrinkGrid, kThreadsPerBlock, 0, stream>>>(
+        requests, input, in_hidden_size, low_rank_buffer, low_rank_module_stride, max_low_rank, weight_index);
+    sync_check_cuda_error();
+
+    dim3 const expandGrid(common::divUp(max_out_hidden_size, kThreadsPerBlock), batch_size, num_modules);
+    loraExpandKernel<T><<<expandGrid, kThreadsPerBlock, max_low_rank * sizeof(float), stream>>>(
+        requests, low_rank_buffer, low_rank_module_stride, max_low_rank, weight_index);
+    sync_check_cuda_error();
+}
+
+} // namespace
+
+void loraSegmentedGemv(LoraGroupGemmRequests const& requests, int batch_size, int num_modules, void const* input,
+    int64_t in_hidden_size, int64_t max_out_hidden_size, void* low_rank_buffer, int64_t max_context_length,
+    int max_low_rank, int weight_index, nvinfer1::DataType dataType, cudaStream_t stream)
+{
+    if (batch_size == 0 || num_modules == 0)
+    {
+        return;
+    }
+
+    if (dataType == nvinfer1::DataType::kHALF)
+    {
+        loraSegmentedGemv_<half>(requests, batch_size, num_modules, static_cast<half const*>(input), in_hidden_size,
+            max_out_hidden_size, static_cast<half*>(low_rank_buffer), max_context_length, max_low_rank, weight_index,
+            stream);
+    }
+    else if (dataType == nvinfer1::DataType::kFLOAT)
+    {
+        loraSegmentedGemv_<float>(requests, batch_size, num_modules, static_cast<float const*>(input),
+            in_hidden_size, max_out_hidden_size, static_cast<float*>(low_rank_buffer), max_context_length,
+            max_low_rank, weight_index, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (dataType == nvinfer1::DataType::kBF16)
+    {
+        loraSegmentedGemv_<__nv_bfloat16>(requests, batch_size, num_modules,
+            static_cast<__nv_bfloat16 const*>(input), in_hidden_size, max_out_hidden_size,
+            static_cast<__nv_bfloat16*>(low_rank_buffer), max_context_length, max_low_rank, weight_index, stream);
+    }
+#endif
+    else
+    {
+        TLLM_THROW("Unsupported data type for the LoRA segmented GEMV");
+    }
+}
+
+} // namespace kernels
+
+} // namespace tensorrt_llm
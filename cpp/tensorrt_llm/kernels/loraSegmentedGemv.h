@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2019-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/kernels/loraGroupGemmParams.h"
+#include <NvInferRuntime.h>
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+// Computes the LoRA outputs of every module for a batch of requests with different adapters and ranks in two
+// launches, one block per module and request, reading the weights of each request from requests.weights_ptrs.
+// Meant for requests with few tokens each, e.g. generation, where grouped GEMM problems would only be a few rows tall.
+// The low rank results of module i are stored at low_rank_buffer + i * batch_size * max_context_length * max_low_rank
+// with a row stride of max_low_rank. The output rows of requests with rank 0 are zeroed.
+void loraSegmentedGemv(LoraGroupGemmRequests const& requests, int batch_size, int num_modules, void const* input,
+    int64_t in_hidden_size, int64_t max_out_hidden_size, void* low_rank_buffer, int64_t max_context_length,
+    int max_low_rank, int weight_index, nvinfer1::DataType dataType, cudaStream_t stream);
+
+} // namespace kernels
+
+} // namespace tensorrt_llm
@@ -206,7 +206,7 @@ __launch_bounds__(256, 1) __global__ void rg_lru_kernel(lruParams params)
 
         cuda::pipeline pipeline = cuda::make_pipeline(block, &pipeline_state, cuda::pipeline_role::consumer);
 
-        float state_reg = 0.f;
+        float state_reg = params.load_initial_state ? state[slot_idx * num_channels + channel] : 0.f;
         int stage = 0;
 
         for (int si = 0; si < seq_loops; si++)
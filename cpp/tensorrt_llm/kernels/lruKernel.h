@@ -45,6 +45,9 @@ struct lruParams
     void* __restrict__ out_ptr;
     int const* __restrict__ last_token_ids_ptr;
     int const* __restrict__ slot_mapping_ptr;
+    // The context phase starts from the state in the slot instead of zeros. Used to resume from a restored prefix, the
+    // state of new requests must be zero.
+    bool load_initial_state;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -300,6 +300,7 @@ __global__
     }
     else if (g_mxXs_)
     {
+        // The previous state is indexed by sample, also with a state slot mapping, see invokeMambaConv1dGatherState
 #pragma unroll
         for (int i = 0; i < (K_ - 1) * tileD_; i += STEP)
             if (i + STEP <= (K_ - 1) * tileD_ || i + thread * 8 < (K_ - 1) * tileD_)
@@ -307,7 +308,8 @@ __global__
                         + 2
                             * swizzle<tileD_ * 2, tileD_, T_>(
                                 i + thread * 8 + (warpL_ * laneL * pipe_ + 1 - K_) * tileD_),
-                    g_mxXs_ + sStart + (thread * 8 / tileD_) * D_ + i * (D_ / tileD_) + dStart + thread * 8 % tileD_);
+                    g_mxXs_ + blockIdx.z * (K_ - 1) * D_ + (thread * 8 / tileD_) * D_ + i * (D_ / tileD_) + dStart
+                        + thread * 8 % tileD_);
     }
     else
     {
@@ -580,6 +582,7 @@ __global__ std::enable_if_t<std::is_same_v<T_, float>> mambaConv1dContextKernel(
     }
     else if (g_mxXs_)
     {
+        // The previous state is indexed by sample, also with a state slot mapping, see invokeMambaConv1dGatherState
 #pragma unroll
         for (int i = 0; i < (K_ - 1) * tileD_; i += STEP)
             if (i + STEP <= (K_ - 1) * tileD_ || i + thread * 4 < (K_ - 1) * tileD_)
@@ -587,7 +590,8 @@ __global__ std::enable_if_t<std::is_same_v<T_, float>> mambaConv1dContextKernel(
                         + 4
                             * swizzle<tileD_ * 4, tileD_, T_>(
                                 i + thread * 4 + (warpL_ * laneL * pipe_ + 1 - K_) * tileD_),
-                    g_mxXs_ + sStart + (thread * 4 / tileD_) * D_ + i * (D_ / tileD_) + dStart + thread * 4 % tileD_);
+                    g_mxXs_ + blockIdx.z * (K_ - 1) * D_ + (thread * 4 / tileD_) * D_ + i * (D_ / tileD_) + dStart
+                        + thread * 4 % tileD_);
     }
     else
     {
@@ -1058,7 +1062,7 @@ void invokeMambaConv1dContext(MambaConv1dParamsBase& params, cudaStream_t stream
     input_t* ya = (input_t*) params.out_ptr;
     input_t* ys = (input_t*) params.state_out_ptr;
     input_t const* xa = (input_t const*) params.in_ptr;
-    input_t const* xs = nullptr; // (input_t const*) params.state_in_ptr;
+    input_t const* xs = params.load_initial_state ? (input_t const*) params.state_in_ptr : nullptr;
     input_t const* w = (input_t const*) params.weight_ptr;
     input_t const* b = (input_t const*) params.bias_ptr;
     bool rmpd = params.remove_padding;
@@ -1190,6 +1194,36 @@ void invokeMambaConv1dGeneration(MambaConv1dParamsBase& params, cudaStream_t str
         <<<grid, threadsPerBlock, 0, stream>>>(params, microBatchSize);
 }
 
+template <typename input_t>
+__global__ void mambaConv1dGatherStateKernel(
+    input_t* __restrict__ dst, input_t const* __restrict__ src, int const* __restrict__ slotMapping, int stateSize)
+{
+    int const sample = blockIdx.y;
+    int const slot = slotMapping[sample];
+    for (int i = blockIdx.x * blockDim.x + threadIdx.x; i < stateSize; i += gridDim.x * blockDim.x)
+    {
+        dst[sample * stateSize + i] = src[slot * stateSize + i];
+    }
+}
+
+template <typename input_t>
+void invokeMambaConv1dGatherState(MambaConv1dParamsBase const& params, void* dst, cudaStream_t stream)
+{
+    TLLM_CHECK(params.state_slot_mapping_ptr != nullptr);
+    int const stateSize = (params.dconv - 1) * params.dim;
+    int const threadsPerBlock = 256;
+    dim3 grid(std::min((stateSize + threadsPerBlock - 1) / threadsPerBlock, 64), params.batch);
+    mambaConv1dGatherStateKernel<input_t><<<grid, threadsPerBlock, 0, stream>>>(reinterpret_cast<input_t*>(dst),
+        reinterpret_cast<input_t const*>(params.state_in_ptr), params.state_slot_mapping_ptr, stateSize);
+}
+
+template void invokeMambaConv1dGatherState<float>(MambaConv1dParamsBase const& params, void* dst, cudaStream_t stream);
+template void invokeMambaConv1dGatherState<half>(MambaConv1dParamsBase const& params, void* dst, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeMambaConv1dGatherState<__nv_bfloat16>(
+    MambaConv1dParamsBase const& params, void* dst, cudaStream_t stream);
+#endif
+
 template void invokeMambaConv1dContext<float>(MambaConv1dParamsBase& params, cudaStream_t stream);
 template void invokeMambaConv1dContext<half>(MambaConv1dParamsBase& params, cudaStream_t stream);
 #ifdef ENABLE_BF16
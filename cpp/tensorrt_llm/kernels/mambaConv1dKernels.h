@@ -37,6 +37,9 @@ struct MambaConv1dParamsBase
     void* __restrict__ out_ptr;
     int const* __restrict__ last_token_ids_ptr;
     int const* __restrict__ state_slot_mapping_ptr;
+    // The context phase starts from the state in state_in_ptr, indexed by sample, instead of zeros. Used to resume
+    // from a restored prefix, the state of new requests must be zero.
+    bool load_initial_state;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -47,5 +50,10 @@ void invokeMambaConv1dContext(MambaConv1dParamsBase& params, cudaStream_t stream
 template <typename input_t>
 void invokeMambaConv1dGeneration(MambaConv1dParamsBase& params, cudaStream_t stream);
 
+// Copies the state of the slot of each sample in state_in_ptr to dst, [batch, dconv - 1, dim], so that the context
+// phase can start from it while it updates the slots in place.
+template <typename input_t>
+void invokeMambaConv1dGatherState(MambaConv1dParamsBase const& params, void* dst, cudaStream_t stream);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -21,6 +21,7 @@
 #include <float.h>
 #include <math.h>
 #include <sstream>
+#include <tuple>
 
 // Ignore CUTLASS warnings about type punning
 #pragma GCC diagnostic push
@@ -586,6 +587,91 @@ __global__ void computeTotalRowsBeforeExpertKernel(int const* sorted_experts, in
     total_rows_before_expert[expert] = findTotalEltsLeqTarget(sorted_experts, sorted_experts_len, expert);
 }
 
+// Adds the rows of each expert to the expert load counters, total_rows_before_expert holds inclusive end offsets
+__global__ void accumulateExpertLoadKernel(
+    int64_t const* total_rows_before_expert, int64_t const num_experts, int64_t* expert_load)
+{
+    int const expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expert >= num_experts)
+    {
+        return;
+    }
+
+    int64_t const start = expert == 0 ? 0 : total_rows_before_expert[expert - 1];
+    expert_load[expert] += total_rows_before_expert[expert] - start;
+}
+
+void accumulateExpertLoad(
+    int64_t const* total_rows_before_expert, int const num_experts, int64_t* expert_load, cudaStream_t stream)
+{
+    int const threads = std::min(1024, num_experts);
+    int const blocks = (num_experts + threads - 1) / threads;
+    accumulateExpertLoadKernel<<<blocks, threads, 0, stream>>>(total_rows_before_expert, num_experts, expert_load);
+}
+
+// ============================== Small Batch Sort =================================
+// For decode sized batches the radix sort and the separate offset kernel cost more than the routing itself.
+// A single block builds an expert histogram in shared memory, scans it, and scatters every row to its place in the
+// expert sorted order. The output matches CubKeyValueSorter (stable) followed by computeTotalRowsBeforeExpertKernel.
+constexpr static int SMALL_BATCH_SORT_MAX_ROWS = 1024;
+constexpr static int SMALL_BATCH_SORT_THREADS_PER_BLOCK = 256;
+
+__global__ void sortAndCountSmallBatchKernel(int const* experts, int const* source_rows, int* sorted_experts,
+    int* sorted_source_rows, int64_t* total_rows_before_expert, int const num_entries,
+    int64_t const num_active_entries, int const num_keys, int const num_experts_to_count)
+{
+    extern __shared__ int smem[];
+    int* expert_offsets = smem;
+    int* keys = smem + num_keys;
+
+    for (int i = threadIdx.x; i < num_keys; i += blockDim.x)
+    {
+        expert_offsets[i] = 0;
+    }
+    __syncthreads();
+
+    for (int i = threadIdx.x; i < num_entries; i += blockDim.x)
+    {
+        int const expert = experts[i];
+        keys[i] = expert;
+        atomicAdd(&expert_offsets[expert], 1);
+    }
+    __syncthreads();
+
+    // There are at most a few hundred experts, a serial exclusive scan is cheaper than synchronising a block scan
+    if (threadIdx.x == 0)
+    {
+        int running_total = 0;
+        for (int i = 0; i < num_keys; ++i)
+        {
+            int const count = expert_offsets[i];
+            expert_offsets[i] = running_total;
+            running_total += count;
+        }
+    }
+    __syncthreads();
+
+    // The start of the next expert is one past the last row of this one, clamped like the binary search would be
+    for (int expert = threadIdx.x; expert < num_experts_to_count; expert += blockDim.x)
+    {
+        total_rows_before_expert[expert] = min(static_cast<int64_t>(expert_offsets[expert + 1]), num_active_entries);
+    }
+
+    for (int i = threadIdx.x; i < num_entries; i += blockDim.x)
+    {
+        int const expert = keys[i];
+        // Rows keep their original relative order within an expert
+        int rank = 0;
+        for (int j = 0; j < i; ++j)
+        {
+            rank += keys[j] == expert;
+        }
+        int const dest = expert_offsets[expert] + rank;
+        sorted_experts[dest] = expert;
+        sorted_source_rows[dest] = source_rows[i];
+    }
+}
+
 namespace detail
 {
 // TODO these are copied from CUTLASS because the cutlass version is missing __device__ decorator
@@ -652,19 +738,12 @@ __device__ void computeHopperInputPointers(HopperGroupedGemmInput layout_info, i
     layout_info.ptr_d[out_idx] = output + num_tokens_before_expert * gemm_n;
 }
 
-// TODO Some of this setup could be cached
 template <class T, class WeightType>
-__global__ void computeStridesHopperKernel(int64_t const* total_rows_before_expert, HopperGroupedGemmInput layout_info,
-    int64_t gemm_n, int64_t gemm_k, int64_t const num_experts, T const* in, WeightType const* weights,
-    float const* fp8_dequant, T const* bias, typename HopperGroupedGemmInput::OutputTypeAdaptor_t<T>* output)
+__device__ void computeStridesHopperForExpert(int64_t const* total_rows_before_expert,
+    HopperGroupedGemmInput layout_info, int64_t gemm_n, int64_t gemm_k, int64_t const expert, T const* in,
+    WeightType const* weights, float const* fp8_dequant, T const* bias,
+    typename HopperGroupedGemmInput::OutputTypeAdaptor_t<T>* output)
 {
-    // First, compute the global tid. We only need 1 thread per expert.
-    int const expert = blockIdx.x * blockDim.x + threadIdx.x;
-    if (expert >= num_experts)
-    {
-        return;
-    }
-
     auto const num_tokens_including_expert = total_rows_before_expert[expert];
     auto const num_tokens_before_expert = expert > 0 ? total_rows_before_expert[expert - 1] : 0;
     auto const num_tokens_to_expert = num_tokens_including_expert - num_tokens_before_expert;
@@ -688,6 +767,30 @@ __global__ void computeStridesHopperKernel(int64_t const* total_rows_before_expe
         layout_info, gemm_m, gemm_n, gemm_k, num_tokens_before_expert, expert, in, weights, bias, output, expert);
 }
 
+// TODO Some of this setup could be cached
+// Sets up both grouped GEMMs in one launch straight from the routing offsets, so the persistent GEMM kernels read the
+// per expert row counts on the device without a host sync and no setup kernel runs between FC1 and FC2
+template <class T, class WeightType>
+__global__ void computeStridesHopperKernel(int64_t const* total_rows_before_expert,
+    HopperGroupedGemmInput fc1_layout_info, HopperGroupedGemmInput fc2_layout_info, int64_t fc1_out_size,
+    int64_t hidden_size, int64_t inter_size, int64_t const num_experts, T const* fc1_in, WeightType const* fc1_weights,
+    float const* fc1_fp8_dequant, typename HopperGroupedGemmInput::OutputTypeAdaptor_t<T>* fc1_output, T const* fc2_in,
+    WeightType const* fc2_weights, float const* fc2_fp8_dequant,
+    typename HopperGroupedGemmInput::OutputTypeAdaptor_t<T>* fc2_output)
+{
+    // First, compute the global tid. We only need 1 thread per expert.
+    int const expert = blockIdx.x * blockDim.x + threadIdx.x;
+    if (expert >= num_experts)
+    {
+        return;
+    }
+
+    computeStridesHopperForExpert(total_rows_before_expert, fc1_layout_info, fc1_out_size, hidden_size, expert, fc1_in,
+        fc1_weights, fc1_fp8_dequant, static_cast<T const*>(nullptr), fc1_output);
+    computeStridesHopperForExpert(total_rows_before_expert, fc2_layout_info, hidden_size, inter_size, expert, fc2_in,
+        fc2_weights, fc2_fp8_dequant, static_cast<T const*>(nullptr), fc2_output);
+}
+
 // ========================== Permutation things =======================================
 
 template <class T, class U>
@@ -785,7 +888,7 @@ template <typename T, typename OutputType, class GemmOutputType, ScaleMode SCALE
 __global__ void finalizeMoeRoutingKernel(GemmOutputType const* expanded_permuted_rows,
     OutputType* reduced_unpermuted_output, T const* bias, float const* scales,
     int const* expanded_source_row_to_expanded_dest_row, int const* expert_for_source_row, int64_t const orig_cols,
-    int64_t const k, int64_t const* num_valid_ptr)
+    int64_t const k, int64_t const* num_valid_ptr, bool const accumulate)
 {
     assert(orig_cols % 4 == 0);
     int64_t const original_row = blockIdx.x;
@@ -867,6 +970,12 @@ __global__ void finalizeMoeRoutingKernel(GemmOutputType const* expanded_permuted
             }
         }
 
+        // Add to the partial result of the experts handled by an earlier pass
+        if (accumulate)
+        {
+            thread_output = thread_output + arrayConvert<OutputElem, ComputeElem>(reduced_row_ptr_v[elem_index]);
+        }
+
         OutputElem output_elem = arrayConvert<ComputeElem, OutputElem>(thread_output);
         reduced_row_ptr_v[elem_index] = output_elem;
     }
@@ -877,7 +986,7 @@ void finalizeMoeRoutingKernelLauncher(GemmOutputType const* expanded_permuted_ro
     OutputType* reduced_unpermuted_output, T const* bias, float const* scales,
     int const* expanded_source_row_to_expanded_dest_row, int const* expert_for_source_row, int64_t const num_rows,
     int64_t const cols, int64_t const k, int64_t const* num_valid_ptr, MOEParallelismConfig parallelism_config,
-    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
+    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream, bool const accumulate = false)
 {
     int64_t const blocks = num_rows;
     int64_t const threads = FINALIZE_THREADS_PER_BLOCK;
@@ -909,7 +1018,7 @@ void finalizeMoeRoutingKernelLauncher(GemmOutputType const* expanded_permuted_ro
     };
     auto* const func = func_map[check_finished][int(renorm_scales)];
     func<<<blocks, threads, 0, stream>>>(expanded_permuted_rows, reduced_unpermuted_output, bias_ptr, scales,
-        expanded_source_row_to_expanded_dest_row, expert_for_source_row, cols, k, num_valid_ptr);
+        expanded_source_row_to_expanded_dest_row, expert_for_source_row, cols, k, num_valid_ptr, accumulate);
 }
 
 // ============================== Gated Activation =================================
@@ -1028,12 +1137,385 @@ void doActivation(T* output, HopperGroupedGemmInput::OutputTypeAdaptor_t<T> cons
         inter_size, isGatedActivation(activation_type));
 }
 
+// ============================== Expert Cache =================================
+
+constexpr static int EXPERT_CACHE_THREADS_PER_BLOCK = 256;
+
+// Picks the experts of this round and gives each one a cache slot, then maps every expanded row to the slot of its
+// expert. Rows of experts outside this round get the sentinel so they are sorted past the valid rows.
+// Round r covers the active experts ranked [r * num_slots, (r + 1) * num_slots) in expert order. Resident experts keep
+// their slot, the others take the least recently used slots not needed by this round and are listed in slot_fetch.
+// The slot bookkeeping is a serial loop over the experts and slots, which is small next to the weight copies it saves
+__global__ void assignExpertCacheSlotsKernel(int const* expert_for_source_row, int64_t const num_entries,
+    int const num_local_experts, int const sentinel, int const round, MoeExpertCache cache, int* slot_for_source_row,
+    int* slot_fetch)
+{
+    extern __shared__ int expert_cache_smem[];
+    // Slot of each local expert in this round, -1 when the expert is not part of it
+    int* expert_slot = expert_cache_smem;
+    int* slot_taken = expert_cache_smem + num_local_experts;
+
+    for (int i = threadIdx.x; i < num_local_experts; i += blockDim.x)
+    {
+        expert_slot[i] = 0;
+    }
+    for (int i = threadIdx.x; i < cache.num_slots; i += blockDim.x)
+    {
+        slot_taken[i] = 0;
+    }
+    __syncthreads();
+
+    for (int64_t i = threadIdx.x; i < num_entries; i += blockDim.x)
+    {
+        int const expert = expert_for_source_row[i];
+        if (expert < num_local_experts)
+        {
+            expert_slot[expert] = 1;
+        }
+    }
+    __syncthreads();
+
+    if (threadIdx.x == 0)
+    {
+        int64_t const step = *cache.step + 1;
+        int const first = round * cache.num_slots;
+        int const last = first + cache.num_slots;
+        int rank = 0;
+        for (int expert = 0; expert < num_local_experts; ++expert)
+        {
+            bool const active = expert_slot[expert];
+            expert_slot[expert] = active && rank >= first && rank < last ? -2 : -1;
+            rank += active;
+        }
+
+        for (int slot = 0; slot < cache.num_slots; ++slot)
+        {
+            slot_fetch[slot] = -1;
+            int const expert = cache.slot_expert[slot];
+            if (expert >= 0 && expert_slot[expert] == -2)
+            {
+                expert_slot[expert] = slot;
+                slot_taken[slot] = 1;
+                cache.slot_last_use[slot] = step;
+            }
+        }
+
+        for (int expert = 0; expert < num_local_experts; ++expert)
+        {
+            if (expert_slot[expert] != -2)
+            {
+                continue;
+            }
+            int victim = -1;
+            for (int slot = 0; slot < cache.num_slots; ++slot)
+            {
+                if (!slot_taken[slot] && (victim < 0 || cache.slot_last_use[slot] < cache.slot_last_use[victim]))
+                {
+                    victim = slot;
+                }
+            }
+            // A round never has more experts than slots
+            assert(victim >= 0);
+            expert_slot[expert] = victim;
+            slot_taken[victim] = 1;
+            slot_fetch[victim] = expert;
+            cache.slot_expert[victim] = expert;
+            cache.slot_last_use[victim] = step;
+        }
+        *cache.step = step;
+    }
+    __syncthreads();
+
+    for (int64_t i = threadIdx.x; i < num_entries; i += blockDim.x)
+    {
+        int const expert = expert_for_source_row[i];
+        int const slot = expert < num_local_experts ? expert_slot[expert] : -1;
+        slot_for_source_row[i] = slot >= 0 ? slot : sentinel;
+    }
+}
+
+// Copies the weights of the fetched experts from mapped host memory into their slots, blockIdx.y is the slot
+__global__ void fetchExpertWeightsKernel(int4 const* host_fc1_weights, int4 const* host_fc2_weights,
+    int64_t const fc1_expert_vecs, int64_t const fc2_expert_vecs, int4* fc1_slots, int4* fc2_slots,
+    int const* slot_fetch)
+{
+    int const slot = blockIdx.y;
+    int const expert = slot_fetch[slot];
+    if (expert < 0)
+    {
+        return;
+    }
+
+    auto const* fc1_src = host_fc1_weights + expert * fc1_expert_vecs;
+    auto const* fc2_src = host_fc2_weights + expert * fc2_expert_vecs;
+    auto* fc1_dst = fc1_slots + slot * fc1_expert_vecs;
+    auto* fc2_dst = fc2_slots + slot * fc2_expert_vecs;
+    int64_t const stride = static_cast<int64_t>(gridDim.x) * blockDim.x;
+    for (int64_t i = blockIdx.x * blockDim.x + threadIdx.x; i < fc1_expert_vecs; i += stride)
+    {
+        fc1_dst[i] = fc1_src[i];
+    }
+    for (int64_t i = blockIdx.x * blockDim.x + threadIdx.x; i < fc2_expert_vecs; i += stride)
+    {
+        fc2_dst[i] = fc2_src[i];
+    }
+}
+
+void fetchExpertCacheSlots(int const* expert_for_source_row, int64_t const num_entries, int const num_local_experts,
+    int const sentinel, int const round, MoeExpertCache const& cache, void const* host_fc1_weights,
+    void const* host_fc2_weights, size_t const fc1_expert_bytes, size_t const fc2_expert_bytes,
+    int* slot_for_source_row, int* slot_fetch, cudaStream_t stream)
+{
+    size_t const smem_size = (num_local_experts + cache.num_slots) * sizeof(int);
+    assignExpertCacheSlotsKernel<<<1, EXPERT_CACHE_THREADS_PER_BLOCK, smem_size, stream>>>(expert_for_source_row,
+        num_entries, num_local_experts, sentinel, round, cache, slot_for_source_row, slot_fetch);
+
+    TLLM_CHECK(fc1_expert_bytes % sizeof(int4) == 0 && fc2_expert_bytes % sizeof(int4) == 0);
+    // Enough blocks per slot to keep the PCIe link busy without starving the rest of the GPU
+    dim3 const grid(std::max(1, tensorrt_llm::common::getMultiProcessorCount() / cache.num_slots), cache.num_slots);
+    fetchExpertWeightsKernel<<<grid, EXPERT_CACHE_THREADS_PER_BLOCK, 0, stream>>>(
+        static_cast<int4 const*>(host_fc1_weights), static_cast<int4 const*>(host_fc2_weights),
+        fc1_expert_bytes / sizeof(int4), fc2_expert_bytes / sizeof(int4), static_cast<int4*>(cache.fc1_slots),
+        static_cast<int4*>(cache.fc2_slots), slot_fetch);
+}
+
+// ============================== Expert Capacity =================================
+
+constexpr static int CAPACITY_THREADS_PER_BLOCK = 256;
+
+// One block per expert. Walks the routed rows in priority order, every first choice before any second choice and the
+// tokens in order within a choice, and drops the rows of the expert that do not fit in the capacity left after
+// expert_fill. A dropped row of expert e is set to num_experts + e, so the other blocks never match it and the
+// original expert is still known. Finished rows hold num_experts and are never counted
+__global__ void applyExpertCapacityKernel(int* experts, int64_t const num_rows, int const k, int const num_experts,
+    int const capacity, int* expert_fill, int const start_expert, int const end_expert, int64_t* overflow_counts)
+{
+    using BlockScan = cub::BlockScan<int, CAPACITY_THREADS_PER_BLOCK>;
+    __shared__ typename BlockScan::TempStorage temp_storage;
+
+    int const expert = blockIdx.x;
+    int const base = expert_fill[expert];
+    int64_t const num_entries = num_rows * k;
+    int assigned = 0;
+    for (int64_t start = 0; start < num_entries; start += CAPACITY_THREADS_PER_BLOCK)
+    {
+        int64_t const priority = start + threadIdx.x;
+        int64_t const entry = priority < num_entries ? (priority % num_rows) * k + priority / num_rows : -1;
+        int const routed = entry >= 0 && experts[entry] == expert;
+
+        int rank;
+        int block_assigned;
+        BlockScan(temp_storage).ExclusiveSum(routed, rank, block_assigned);
+        if (routed && base + assigned + rank >= capacity)
+        {
+            experts[entry] = num_experts + expert;
+        }
+        assigned += block_assigned;
+        __syncthreads();
+    }
+
+    if (threadIdx.x == 0)
+    {
+        int const kept = min(assigned, max(capacity - base, 0));
+        expert_fill[expert] = base + kept;
+        if (overflow_counts && expert >= start_expert && expert < end_expert)
+        {
+            overflow_counts[expert - start_expert] += assigned - kept;
+        }
+    }
+}
+
+// Offers every dropped row the best scoring expert its token did not select that still has room after the first
+// pass. The j-th dropped row of a token is offered the j-th such expert, so the rows of a token never share an expert.
+// The scale is the softmax probability of the new expert, like the ones written by the top-k kernels
+__global__ void rerouteOverflowKernel(float const* gating_output, bool const* finished, int const* experts,
+    int const* expert_fill, int* reroute_experts, float* reroute_scales, int64_t const num_rows, int const k,
+    int const num_experts, int const capacity)
+{
+    int64_t const entry = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (entry >= num_rows * k)
+    {
+        return;
+    }
+    int64_t const row = entry / k;
+    int const k_idx = entry % k;
+    reroute_experts[entry] = num_experts;
+    if (experts[entry] < num_experts || (finished && finished[row]))
+    {
+        return;
+    }
+
+    int const* row_experts = experts + row * k;
+    int skip = 0;
+    for (int i = 0; i < k_idx; ++i)
+    {
+        skip += row_experts[i] >= num_experts;
+    }
+
+    float const* logits = gating_output + row * num_experts;
+    float max_logit = -FLT_MAX;
+    for (int expert = 0; expert < num_experts; ++expert)
+    {
+        max_logit = max(max_logit, logits[expert]);
+    }
+    float sum = 0.f;
+    for (int expert = 0; expert < num_experts; ++expert)
+    {
+        sum += expf(logits[expert] - max_logit);
+    }
+
+    // Candidates in order of decreasing logit, ties broken by the lower expert id
+    int chosen = -1;
+    for (int step = 0; step <= skip; ++step)
+    {
+        int best = -1;
+        for (int expert = 0; expert < num_experts; ++expert)
+        {
+            bool const below_previous = chosen < 0 || logits[expert] < logits[chosen]
+                || (logits[expert] == logits[chosen] && expert > chosen);
+            bool selected = false;
+            for (int i = 0; i < k; ++i)
+            {
+                selected |= row_experts[i] == expert;
+            }
+            bool const eligible = below_previous && !selected && expert_fill[expert] < capacity;
+            if (eligible && (best < 0 || logits[expert] > logits[best]))
+            {
+                best = expert;
+            }
+        }
+        chosen = best;
+        if (chosen < 0)
+        {
+            return;
+        }
+    }
+    reroute_experts[entry] = chosen;
+    reroute_scales[entry] = expf(logits[chosen] - max_logit) / sum;
+}
+
+// Takes the rerouted rows that fit, counts the rows of this node's experts that were dropped for good and maps the
+// experts to the ones of this node, with num_experts for the rows this node does not process
+__global__ void finalizeExpertCapacityKernel(int* experts, float* scales, int const* reroute_experts,
+    float const* reroute_scales, bool const* finished, int64_t const num_rows, int const k, int const num_experts,
+    int const start_expert, int const end_expert, int64_t* dropped_count)
+{
+    int64_t const entry = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (entry >= num_rows * k)
+    {
+        return;
+    }
+    int expert = experts[entry];
+    bool const row_is_active = !finished || !finished[entry / k];
+    if (row_is_active && expert >= num_experts)
+    {
+        int const original_expert = expert - num_experts;
+        if (reroute_experts && reroute_experts[entry] < num_experts)
+        {
+            expert = reroute_experts[entry];
+            scales[entry] = reroute_scales[entry];
+        }
+        else if (dropped_count && original_expert >= start_expert && original_expert < end_expert)
+        {
+            atomicAdd(reinterpret_cast<unsigned long long*>(dropped_count), 1ull);
+        }
+    }
+    bool const node_uses_expert = expert >= start_expert && expert < end_expert;
+    experts[entry] = row_is_active && node_uses_expert ? expert - start_expert : num_experts;
+}
+
+// Limits every expert to capacity rows, see CutlassMoeFCRunnerInterface::capacity_factor. expert_for_source_row holds
+// the global experts chosen by the top-k kernel and is rewritten with the experts of this node like the top-k kernel
+// would. All EP ranks see the same routing and make the same decisions, so every row is processed at most once
+void applyExpertCapacity(float const* gating_output, bool const* finished, float* expert_scales,
+    int* expert_for_source_row, int* expert_fill, int* reroute_experts, float* reroute_scales, int64_t const num_rows,
+    int const k, int const num_experts, int const capacity, int const start_expert, int const end_expert,
+    int64_t* overflow_counts, cudaStream_t stream)
+{
+    TLLM_CUDA_CHECK(cudaMemsetAsync(expert_fill, 0, num_experts * sizeof(int), stream));
+    applyExpertCapacityKernel<<<num_experts, CAPACITY_THREADS_PER_BLOCK, 0, stream>>>(expert_for_source_row, num_rows,
+        k, num_experts, capacity, expert_fill, start_expert, end_expert, overflow_counts);
+
+    int64_t const num_entries = num_rows * k;
+    int64_t const blocks = (num_entries + CAPACITY_THREADS_PER_BLOCK - 1) / CAPACITY_THREADS_PER_BLOCK;
+    if (reroute_experts)
+    {
+        rerouteOverflowKernel<<<blocks, CAPACITY_THREADS_PER_BLOCK, 0, stream>>>(gating_output, finished,
+            expert_for_source_row, expert_fill, reroute_experts, reroute_scales, num_rows, k, num_experts, capacity);
+        // The offered experts compete for the room that is left in the same priority order, the overflow was counted
+        applyExpertCapacityKernel<<<num_experts, CAPACITY_THREADS_PER_BLOCK, 0, stream>>>(reroute_experts, num_rows,
+            k, num_experts, capacity, expert_fill, start_expert, end_expert, nullptr);
+    }
+
+    int64_t* dropped_count = overflow_counts ? overflow_counts + (end_expert - start_expert) : nullptr;
+    finalizeExpertCapacityKernel<<<blocks, CAPACITY_THREADS_PER_BLOCK, 0, stream>>>(expert_for_source_row,
+        expert_scales, reroute_experts, reroute_scales, finished, num_rows, k, num_experts, start_expert, end_expert,
+        dropped_count);
+}
+
+// ============================== Shared Experts =================================
+
+constexpr static int SHARED_EXPERTS_THREADS_PER_BLOCK = 256;
+
+// Appends the shared experts to the top-k routing of every token, see CutlassMoeFCRunnerInterface::num_shared_experts.
+// The routed scales are renormalized here when requested, as the finalize kernel would also count the shared experts.
+// Routed rows this node does not process move to the sentinel num_experts + num_shared, which sorts after the shared
+// experts. Only the node running the shared experts gets them, so the reduction across nodes counts them once
+__global__ void appendSharedExpertsKernel(int const* routed_experts, float const* routed_scales, bool const* finished,
+    int* experts, float* scales, int* source_rows, int64_t const num_rows, int const k, int const num_shared,
+    int const num_experts, int const num_experts_per_node, bool const run_shared_experts, bool const renormalize)
+{
+    int64_t const row = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (row >= num_rows)
+    {
+        return;
+    }
+    int const k_total = k + num_shared;
+    int const sentinel = num_experts + num_shared;
+
+    float scale_sum = 0.f;
+    for (int k_idx = 0; k_idx < k; ++k_idx)
+    {
+        scale_sum += routed_scales[row * k + k_idx];
+    }
+    for (int k_idx = 0; k_idx < k; ++k_idx)
+    {
+        int const expert = routed_experts[row * k + k_idx];
+        float const scale = routed_scales[row * k + k_idx];
+        int64_t const idx = row * k_total + k_idx;
+        experts[idx] = expert < num_experts_per_node ? expert : sentinel;
+        scales[idx] = renormalize ? scale / scale_sum : scale;
+        source_rows[idx] = k_idx * num_rows + row;
+    }
+
+    bool const row_is_active = !finished || !finished[row];
+    for (int shared_idx = 0; shared_idx < num_shared; ++shared_idx)
+    {
+        int64_t const idx = row * k_total + k + shared_idx;
+        experts[idx] = row_is_active && run_shared_experts ? num_experts_per_node + shared_idx : sentinel;
+        scales[idx] = 1.f;
+        source_rows[idx] = (k + shared_idx) * num_rows + row;
+    }
+}
+
+void appendSharedExperts(int const* routed_experts, float const* routed_scales, bool const* finished, int* experts,
+    float* scales, int* source_rows, int64_t const num_rows, int const k, int const num_shared, int const num_experts,
+    int const num_experts_per_node, bool const run_shared_experts, bool const renormalize, cudaStream_t stream)
+{
+    int64_t const blocks = (num_rows + SHARED_EXPERTS_THREADS_PER_BLOCK - 1) / SHARED_EXPERTS_THREADS_PER_BLOCK;
+    appendSharedExpertsKernel<<<blocks, SHARED_EXPERTS_THREADS_PER_BLOCK, 0, stream>>>(routed_experts, routed_scales,
+        finished, experts, scales, source_rows, num_rows, k, num_shared, num_experts, num_experts_per_node,
+        run_shared_experts, renormalize);
+}
+
 template <class T, class WeightType, class OutputType, class Enable>
 std::vector<size_t> CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::getWorkspaceBufferSizes(
     int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size, int const num_experts,
     int const num_experts_per_node, int const k, ActivationType activation_type) const
 {
-    size_t const num_moe_inputs = k * num_rows;
+    // Every token is also routed to the shared experts, which run as extra groups after the routed ones
+    int const num_groups = num_experts_per_node + num_shared_experts;
+    size_t const num_moe_inputs = (k + num_shared_experts) * num_rows;
     size_t const permuted_elems = num_moe_inputs * hidden_size;
     size_t const interbuf_elems = num_moe_inputs * inter_size;
     size_t glu_inter_elems = 0;
@@ -1063,14 +1545,15 @@ std::vector<size_t> CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::getWo
     size_t const permuted_rows_size = num_moe_inputs * sizeof(int);
     size_t const permuted_experts_size = num_moe_inputs * sizeof(int);
     size_t const permuted_data_size = permuted_elems * sizeof(T);
-    size_t const total_rows_before_expert_size = num_experts_per_node * sizeof(int64_t);
+    size_t total_rows_before_expert_size = num_groups * sizeof(int64_t);
     size_t const softmax_out_size = num_softmax_outs * sizeof(float);
     size_t const glu_inter_size = glu_inter_elems * gemm_output_dtype; // May be an intermediate type for quantization
     size_t const fc1_result_size = interbuf_elems * sizeof(T);         // Acitvation quantizes so back to sizeof(T)
-    size_t const sorter_size = CubKeyValueSorter::getWorkspaceSize(num_rows, num_experts);
+    size_t const sorter_size = CubKeyValueSorter::getWorkspaceSize(num_rows, num_experts + num_shared_experts);
     size_t const fc2_result_size = permuted_elems * gemm_output_dtype; // May be an intermediate type for quantization
-    size_t const hopper_size = using_hopper ? HopperGroupedGemmInput::workspaceSize(num_experts_per_node) : 0;
-    size_t const gemm_workspace_size = moe_gemm_runner_.getMaxWorkspaceSize(num_experts_per_node);
+    // The FC1 and FC2 grouped GEMM arguments are set up together, so each needs its own copy
+    size_t const hopper_size = using_hopper ? 2 * HopperGroupedGemmInput::workspaceSize(num_groups) : 0;
+    size_t const gemm_workspace_size = moe_gemm_runner_.getMaxWorkspaceSize(num_groups);
 
     // We do some overlapping of the large workspace buffers. Although we could overlap some of the other buffers, they
     // are small enough (i.e no factor of hidden size) they will only be a couple MiB at most, so we don't bother
@@ -1092,6 +1575,41 @@ std::vector<size_t> CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::getWo
             = std::max(std::max(glu_inter_size, fc2_result_size), overlapped_gemm1_gemm2_outputs);
     }
 
+    size_t all_to_all_rows_size = 0;
+    size_t all_to_all_counts_size = 0;
+    int const ep_size = num_experts / num_experts_per_node;
+    if (use_all_to_all && ep_size > 1)
+    {
+        // Routing counts cover every expert, and the rows this rank routes need their own send/receive buffer
+        total_rows_before_expert_size = num_experts * sizeof(int64_t);
+        size_t const num_local_moe_inputs = k * ((num_rows + ep_size - 1) / ep_size);
+        all_to_all_rows_size = num_local_moe_inputs * hidden_size * std::max(sizeof(T), gemm_output_dtype);
+        // Send counts, receive counts and the number of valid routed rows
+        all_to_all_counts_size = (2 * num_experts + 1) * sizeof(int64_t);
+    }
+
+    size_t slot_for_source_row_size = 0;
+    size_t slot_fetch_size = 0;
+    if (expert_cache)
+    {
+        slot_for_source_row_size = num_moe_inputs * sizeof(int);
+        slot_fetch_size = expert_cache->num_slots * sizeof(int);
+    }
+
+    size_t expert_fill_size = 0;
+    size_t reroute_experts_size = 0;
+    size_t reroute_scales_size = 0;
+    if (capacity_factor > 0.f)
+    {
+        expert_fill_size = num_experts * sizeof(int);
+        reroute_experts_size = reroute_overflow ? num_moe_inputs * sizeof(int) : 0;
+        reroute_scales_size = reroute_overflow ? num_moe_inputs * sizeof(float) : 0;
+    }
+
+    // The top-k routing is written here before the shared experts are appended to it
+    size_t const routed_experts_size = num_shared_experts > 0 ? k * num_rows * sizeof(int) : 0;
+    size_t const routed_scales_size = num_shared_experts > 0 ? k * num_rows * sizeof(float) : 0;
+
     std::vector<size_t> workspace{     //
         source_rows_size,              //
         permuted_rows_size,            //
@@ -1103,7 +1621,16 @@ std::vector<size_t> CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::getWo
         overlapped_gemm1_gemm2_inputs,  //
         overlapped_gemm1_gemm2_outputs, //
         hopper_size,                    //
-        gemm_workspace_size};
+        gemm_workspace_size,            //
+        all_to_all_rows_size,           //
+        all_to_all_counts_size,         //
+        slot_for_source_row_size,       //
+        slot_fetch_size,                //
+        expert_fill_size,               //
+        reroute_experts_size,           //
+        reroute_scales_size,            //
+        routed_experts_size,            //
+        routed_scales_size};
     return workspace;
 }
 
@@ -1168,10 +1695,25 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::configureWsPtrs(char
     fc2_result_ = has_glu_inter_result ? (T*) ws_sliced[7] : (T*) ws_sliced[6];
 
     hopper_grouped_gemm_input_ = {};
+    hopper_fc2_grouped_gemm_input_ = {};
     if (moe_gemm_runner_.isHopperSpecialised())
     {
-        hopper_grouped_gemm_input_.configureWorkspace(ws_sliced[8], num_experts_per_node, ws_sliced[9], ws_sizes[9]);
-    }
+        // Both GEMMs share the CUTLASS workspace as they run one after the other
+        int const num_groups = num_experts_per_node + num_shared_experts;
+        hopper_grouped_gemm_input_.configureWorkspace(ws_sliced[8], num_groups, ws_sliced[9], ws_sizes[9]);
+        hopper_fc2_grouped_gemm_input_.configureWorkspace(
+            ws_sliced[8] + HopperGroupedGemmInput::workspaceSize(num_groups), num_groups, ws_sliced[9], ws_sizes[9]);
+    }
+
+    all_to_all_rows_ = ws_sizes[10] > 0 ? ws_sliced[10] : nullptr;
+    all_to_all_counts_ = ws_sizes[11] > 0 ? (int64_t*) ws_sliced[11] : nullptr;
+    slot_for_source_row_ = ws_sizes[12] > 0 ? (int*) ws_sliced[12] : nullptr;
+    slot_fetch_ = ws_sizes[13] > 0 ? (int*) ws_sliced[13] : nullptr;
+    expert_fill_ = ws_sizes[14] > 0 ? (int*) ws_sliced[14] : nullptr;
+    reroute_experts_ = ws_sizes[15] > 0 ? (int*) ws_sliced[15] : nullptr;
+    reroute_scales_ = ws_sizes[16] > 0 ? (float*) ws_sliced[16] : nullptr;
+    routed_experts_ = ws_sizes[17] > 0 ? (int*) ws_sliced[17] : nullptr;
+    routed_scales_ = ws_sizes[18] > 0 ? (float*) ws_sliced[18] : nullptr;
 }
 
 template <class T, class WeightType, class OutputType, class Enable>
@@ -1233,6 +1775,12 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
 
         TLLM_CHECK_WITH_INFO(fc1_fp8_dequant == nullptr && fc2_fp8_quant == nullptr && fc2_fp8_dequant == nullptr,
             "FP8 scales are provided for integer quantization");
+
+        auto const group_size = quant_params.group_size;
+        TLLM_CHECK_WITH_INFO(group_size == 0 || group_size == 64 || group_size == 128,
+            "Only group size 64 and 128 are supported for groupwise MoE weights");
+        TLLM_CHECK_WITH_INFO(group_size == 0 || (hidden_size % group_size == 0 && inter_size % group_size == 0),
+            "Hidden size and inter size must be multiples of the weight group size");
     }
     else if (fp8_scales_required)
     {
@@ -1247,6 +1795,7 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
 
         TLLM_CHECK_WITH_INFO(
             fc1_int_scales == nullptr && fc2_int_scales == nullptr, "Integer scales are provided for FP8 quantization");
+        TLLM_CHECK_WITH_INFO(quant_params.group_size == 0, "Groupwise scales are only supported for integer weights");
     }
     else
     {
@@ -1260,6 +1809,56 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
             fc2_fp8_quant == nullptr, "Scales are ignored for fp32/fp16/bf16 but received quant scale for FC2");
         TLLM_CHECK_WITH_INFO(
             fc2_fp8_dequant == nullptr, "Scales are ignored for fp32/fp16/bf16 but received quant scale for FC2");
+        TLLM_CHECK_WITH_INFO(quant_params.group_size == 0, "Groupwise scales are only supported for integer weights");
+    }
+
+    bool const use_capacity = capacity_factor > 0.f && !is_profiler;
+    if (use_capacity)
+    {
+        TLLM_CHECK_WITH_INFO(!use_all_to_all || parallelism_config.ep_size == 1,
+            "Expert capacity is not supported with all-to-all expert parallelism");
+        TLLM_CHECK_WITH_INFO(!expert_cache, "Expert capacity is not supported with the expert cache");
+    }
+
+    bool const use_shared_experts = num_shared_experts > 0;
+    if (use_shared_experts)
+    {
+        TLLM_CHECK_WITH_INFO(!use_all_to_all || parallelism_config.ep_size == 1,
+            "Shared experts are not supported with all-to-all expert parallelism");
+        TLLM_CHECK_WITH_INFO(!expert_cache, "Shared experts are not supported with the expert cache");
+    }
+
+    bool const use_fused_all_reduce = fused_all_reduce && !is_profiler;
+    if (use_fused_all_reduce)
+    {
+        TLLM_CHECK_WITH_INFO(!use_all_to_all || parallelism_config.ep_size == 1,
+            "The fused all reduce is not supported with all-to-all expert parallelism");
+        TLLM_CHECK_WITH_INFO(!expert_cache, "The fused all reduce is not supported with the expert cache");
+        TLLM_CHECK_WITH_INFO((std::is_same_v<T, OutputType> && std::is_same_v<HopperGemmOutputType, T>),
+            "The fused all reduce requires the MoE output in the activation type");
+    }
+
+    if (use_all_to_all && parallelism_config.ep_size > 1 && !is_profiler)
+    {
+        // The rows are finalized by the rank that routed them, which does not hold the bias of remote experts
+        TLLM_CHECK_WITH_INFO(
+            fc2_expert_biases == nullptr, "FC2 bias is not supported with all-to-all expert parallelism");
+        runMoeAllToAll(input_activations, gating_output, fc1_expert_weights, fc1_expert_biases, fc1_activation_type,
+            fc2_expert_weights, quant_params, num_rows, hidden_size, inter_size, num_experts, k, workspace_ptr,
+            final_output, finished, expert_scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row,
+            parallelism_config, normalization_mode, stream);
+        return;
+    }
+
+    bool const use_expert_cache = expert_cache && !is_profiler;
+    if (use_expert_cache)
+    {
+        TLLM_CHECK_WITH_INFO(!int_scales_required && !fp8_scales_required,
+            "The expert cache does not support quantized weights");
+        TLLM_CHECK_WITH_INFO(fc1_expert_biases == nullptr && fc2_expert_biases == nullptr,
+            "The expert cache does not support bias");
+        TLLM_CHECK_WITH_INFO(!use_all_to_all, "The expert cache does not support all-to-all expert parallelism");
+        TLLM_CHECK(expert_cache->num_slots > 0 && expert_cache->fc1_slots && expert_cache->fc2_slots);
     }
 
     int const num_experts_per_node = num_experts / parallelism_config.ep_size;
@@ -1268,56 +1867,142 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
 
     configureWsPtrs(
         workspace_ptr, num_rows, hidden_size, inter_size, num_experts, num_experts_per_node, k, fc1_activation_type);
-    topkGatingSoftmaxKernelLauncher(gating_output, finished, expert_scales, softmax_out_, expert_for_source_row,
-        source_rows_, num_rows, num_experts, k, start_expert, end_expert, stream);
 
-    sync_check_cuda_error();
+    // With shared experts the top-k routing goes to a temporary buffer and the shared experts are appended to it
+    int* routed_experts = use_shared_experts ? routed_experts_ : expert_for_source_row;
+    float* routed_scales = use_shared_experts ? routed_scales_ : expert_scales;
+    if (use_capacity)
+    {
+        // The capacity is applied to the global routing, so every EP rank drops the same rows
+        topkGatingSoftmaxKernelLauncher(gating_output, finished, routed_scales, softmax_out_, routed_experts,
+            source_rows_, num_rows, num_experts, k, 0, num_experts, stream);
+        int const capacity = std::max(1, static_cast<int>(std::ceil(capacity_factor * k * num_rows / num_experts)));
+        applyExpertCapacity(gating_output, finished, routed_scales, routed_experts, expert_fill_, reroute_experts_,
+            reroute_scales_, num_rows, k, num_experts, capacity, start_expert, end_expert, expert_overflow_counts,
+            stream);
+    }
+    else
+    {
+        topkGatingSoftmaxKernelLauncher(gating_output, finished, routed_scales, softmax_out_, routed_experts,
+            source_rows_, num_rows, num_experts, k, start_expert, end_expert, stream);
+    }
 
-    // We need to use the full num_experts because that is the sentinel value used by topk for disabled experts
-    sorter_.updateNumExperts(num_experts);
-    size_t const sorter_ws_size_bytes = pad_to_multiple_of_16(sorter_.getWorkspaceSize(k * num_rows, num_experts));
-    sorter_.run((void*) sorter_ws_, sorter_ws_size_bytes, expert_for_source_row, permuted_experts_, source_rows_,
-        permuted_rows_, k * num_rows, stream);
+    // Shared experts are extra groups after the routed experts of this node, the routing from here on includes them
+    int const num_groups = num_experts_per_node + num_shared_experts;
+    int const k_total = k + num_shared_experts;
+    int const num_sort_keys = num_experts + num_shared_experts;
+    if (use_shared_experts)
+    {
+        bool const renormalize = normalization_mode == MOEExpertScaleNormalizationMode::RENORMALIZE;
+        appendSharedExperts(routed_experts_, routed_scales_, finished, expert_for_source_row, expert_scales,
+            source_rows_, num_rows, k, num_shared_experts, num_experts, num_experts_per_node,
+            parallelism_config.ep_rank == 0, renormalize, stream);
+    }
+    auto const finalize_normalization_mode
+        = use_shared_experts ? MOEExpertScaleNormalizationMode::NONE : normalization_mode;
 
     sync_check_cuda_error();
 
-    bool const is_gated_activation = isGatedActivation(fc1_activation_type);
-    bool const use_fused_moe = moe_gemm_runner_.isFusedGatedActivation(is_gated_activation, inter_size, hidden_size);
-    size_t const fc1_out_size = ((!use_fused_moe) && is_gated_activation) ? inter_size * 2 : inter_size;
-
     // Upper bound on number of expanded rows
-    int64_t const expanded_active_expert_rows = k * active_rows;
-    computeTotalRowsBeforeExpert(
-        permuted_experts_, expanded_active_expert_rows, num_experts_per_node, total_rows_before_expert_, stream);
+    int64_t const expanded_active_expert_rows = k_total * active_rows;
 
-    bool const needs_num_valid = finished || parallelism_config.ep_size > 1;
-    int64_t const* num_valid_tokens_ptr
-        = needs_num_valid ? total_rows_before_expert_ + num_experts_per_node - 1 : nullptr;
+    if (use_expert_cache)
+    {
+        runMoeWithExpertCache(input_activations, fc1_expert_weights, fc1_activation_type, fc2_expert_weights,
+            quant_params, num_rows, hidden_size, inter_size, num_experts, num_experts_per_node, k,
+            expanded_active_expert_rows, final_output, expert_scales, expanded_source_row_to_expanded_dest_row,
+            expert_for_source_row, parallelism_config, normalization_mode, stream);
+        return;
+    }
+    sortExpertsAndComputeOffsets(expert_for_source_row, k_total * num_rows, expanded_active_expert_rows, num_sort_keys,
+        num_groups, stream);
+
+    sync_check_cuda_error();
+
+    if (expert_load_counts && !is_profiler)
+    {
+        accumulateExpertLoad(total_rows_before_expert_, num_experts_per_node, expert_load_counts, stream);
+    }
+
+    bool const needs_num_valid = finished || parallelism_config.ep_size > 1 || use_capacity;
+    int64_t const* num_valid_tokens_ptr = needs_num_valid ? total_rows_before_expert_ + num_groups - 1 : nullptr;
     expandInputRowsKernelLauncher(input_activations, permuted_data_, permuted_rows_,
-        expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k, stream);
+        expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k_total, stream);
 
     sync_check_cuda_error();
 
+    runExpertGemms(fc1_expert_weights, fc1_expert_biases, fc1_activation_type, fc2_expert_weights, quant_params,
+        num_valid_tokens_ptr, num_rows * k_total, expanded_active_expert_rows, hidden_size, inter_size, num_groups,
+        stream);
+
+    bool const using_hopper = moe_gemm_runner_.isHopperSpecialised();
+
+    if (use_fused_all_reduce)
+    {
+        runFusedAllReduce(final_output, fc2_expert_biases, expert_scales, expanded_source_row_to_expanded_dest_row,
+            expert_for_source_row, num_rows, hidden_size, k_total, num_valid_tokens_ptr, parallelism_config,
+            finalize_normalization_mode, stream);
+    }
+    else if (using_hopper)
+    {
+        finalizeMoeRoutingKernelLauncher<T, OutputType, HopperGemmOutputType>(
+            static_cast<HopperGemmOutputType const*>(fc2_result_), final_output, fc2_expert_biases, expert_scales,
+            expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows, hidden_size, k_total,
+            num_valid_tokens_ptr, parallelism_config, finalize_normalization_mode, stream);
+    }
+    else
+    {
+        finalizeMoeRoutingKernelLauncher<T, OutputType>(static_cast<T const*>(fc2_result_), final_output,
+            fc2_expert_biases, expert_scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows,
+            hidden_size, k_total, num_valid_tokens_ptr, parallelism_config, finalize_normalization_mode, stream);
+    }
+
+    sync_check_cuda_error();
+}
+
+template <class T, class WeightType, class OutputType, class Enable>
+void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runExpertGemms(WeightType const* fc1_expert_weights,
+    T const* fc1_expert_biases, ActivationType fc1_activation_type, WeightType const* fc2_expert_weights,
+    QuantParams quant_params, int64_t const* num_valid_tokens_ptr, int64_t const expanded_num_rows,
+    int64_t const expanded_active_expert_rows, int64_t const hidden_size, int64_t const inter_size,
+    int const num_experts_per_node, cudaStream_t stream)
+{
+    auto const* fc1_int_scales = static_cast<T const*>(quant_params.fc1_weight_scales);
+    auto const* fc2_int_scales = static_cast<T const*>(quant_params.fc2_weight_scales);
+    auto const* fc1_fp8_dequant = quant_params.dequant_fc1;
+    auto const* fc2_fp8_quant = quant_params.quant_fc2;
+    auto const* fc2_fp8_dequant = quant_params.dequant_fc2;
+    // A group covering the whole of K is the same as per channel scales
+    int64_t const fc1_group_size = quant_params.group_size > 0 ? quant_params.group_size : hidden_size;
+    int64_t const fc2_group_size = quant_params.group_size > 0 ? quant_params.group_size : inter_size;
+
+    bool const is_gated_activation = isGatedActivation(fc1_activation_type);
+    bool const use_fused_moe = moe_gemm_runner_.isFusedGatedActivation(is_gated_activation, inter_size, hidden_size);
+    size_t const fc1_out_size = ((!use_fused_moe) && is_gated_activation) ? inter_size * 2 : inter_size;
+
     bool const using_hopper = moe_gemm_runner_.isHopperSpecialised();
     HopperGroupedGemmInput hopper_input = hopper_grouped_gemm_input_;
+    HopperGroupedGemmInput hopper_fc2_input = hopper_fc2_grouped_gemm_input_;
     if (using_hopper)
     {
         bool has_different_gemm_output_type = using_hopper && mayHaveDifferentGEMMOutputType();
         auto* gemm_output = (has_different_gemm_output_type || is_gated_activation) ? glu_inter_result_
                                                                                     : static_cast<void*>(fc1_result_);
 
-        hopper_input = computeStridesHopper(total_rows_before_expert_, hopper_input, fc1_out_size, hidden_size,
-            num_experts_per_node, permuted_data_, fc1_expert_weights, fc1_fp8_dequant, nullptr,
-            static_cast<HopperGemmOutputType*>(gemm_output), stream);
+        std::tie(hopper_input, hopper_fc2_input) = computeStridesHopper(total_rows_before_expert_, hopper_input,
+            hopper_fc2_input, fc1_out_size, hidden_size, inter_size, num_experts_per_node, permuted_data_,
+            fc1_expert_weights, fc1_fp8_dequant, static_cast<HopperGemmOutputType*>(gemm_output), fc1_result_,
+            fc2_expert_weights, fc2_fp8_dequant, static_cast<HopperGemmOutputType*>(fc2_result_), stream);
         sync_check_cuda_error();
 
         moe_gemm_runner_.moeGemm(permuted_data_, nullptr, nullptr, nullptr, total_rows_before_expert_, hopper_input,
-            expanded_active_expert_rows, fc1_out_size, hidden_size, num_experts_per_node, false, stream);
+            expanded_active_expert_rows, fc1_out_size, hidden_size, fc1_group_size, num_experts_per_node, false,
+            stream);
 
         sync_check_cuda_error();
 
         doActivation<T>(fc1_result_, static_cast<HopperGemmOutputType const*>(gemm_output), fc2_fp8_quant,
-            fc1_expert_biases, total_rows_before_expert_, num_experts_per_node, inter_size, num_rows * k,
+            fc1_expert_biases, total_rows_before_expert_, num_experts_per_node, inter_size, expanded_num_rows,
             fc1_activation_type, stream);
 
         sync_check_cuda_error();
@@ -1326,7 +2011,7 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
     {
         moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_int_scales, fc1_expert_biases,
             fc1_result_, total_rows_before_expert_, HopperGroupedGemmInput{}, expanded_active_expert_rows, fc1_out_size,
-            hidden_size, num_experts_per_node, fc1_activation_type, use_fused_moe, stream);
+            hidden_size, fc1_group_size, num_experts_per_node, fc1_activation_type, use_fused_moe, stream);
 
         sync_check_cuda_error();
     }
@@ -1338,13 +2023,13 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
         T* gemm_result = (use_fused_moe) ? fc1_result_ : static_cast<T*>(glu_inter_result_);
         moe_gemm_runner_.moeGemmBiasAct(permuted_data_, fc1_expert_weights, fc1_int_scales, fc1_expert_biases,
             gemm_result, total_rows_before_expert_, HopperGroupedGemmInput{}, expanded_active_expert_rows, fc1_out_size,
-            hidden_size, num_experts_per_node, activation_type, use_fused_moe, stream);
+            hidden_size, fc1_group_size, num_experts_per_node, activation_type, use_fused_moe, stream);
 
         sync_check_cuda_error();
         if (!use_fused_moe)
         {
             doGatedActivation<T>(fc1_result_, static_cast<T const*>(glu_inter_result_), num_valid_tokens_ptr,
-                inter_size, num_rows * k, fc1_activation_type, stream);
+                inter_size, expanded_num_rows, fc1_activation_type, stream);
 
             sync_check_cuda_error();
         }
@@ -1352,35 +2037,306 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoe(void const* i
 
     sync_check_cuda_error();
 
-    if (using_hopper)
+    moe_gemm_runner_.moeGemm(fc1_result_, fc2_expert_weights, fc2_int_scales, static_cast<T*>(fc2_result_),
+        total_rows_before_expert_, hopper_fc2_input, expanded_active_expert_rows, hidden_size, inter_size,
+        fc2_group_size, num_experts_per_node, false, stream);
+
+    sync_check_cuda_error();
+}
+
+template <class T, class WeightType, class OutputType, class Enable>
+void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoeWithExpertCache(T const* input_activations,
+    WeightType const* fc1_expert_weights, ActivationType fc1_activation_type, WeightType const* fc2_expert_weights,
+    QuantParams quant_params, int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size,
+    int const num_experts, int const num_experts_per_node, int const k, int64_t const expanded_active_expert_rows,
+    OutputType* final_output, float const* expert_scales, int* expanded_source_row_to_expanded_dest_row,
+    int const* expert_for_source_row, MOEParallelismConfig parallelism_config,
+    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
+{
+    auto const& cache = *expert_cache;
+    int const num_slots = std::min(cache.num_slots, num_experts_per_node);
+    size_t const fc1_out_size = isGatedActivation(fc1_activation_type) ? inter_size * 2 : inter_size;
+    size_t const fc1_expert_bytes = fc1_out_size * hidden_size * sizeof(WeightType);
+    size_t const fc2_expert_bytes = hidden_size * inter_size * sizeof(WeightType);
+
+    // The active experts are only known on the device, so run as many rounds as the worst case needs. Later rounds
+    // with no experts left only cost the routing kernels
+    int64_t const max_active_experts = std::min<int64_t>(num_experts_per_node, k * num_rows);
+    int64_t const num_rounds = (max_active_experts + num_slots - 1) / num_slots;
+
+    // Every round skips the rows of the experts it does not cover
+    int64_t const* num_valid_tokens_ptr = total_rows_before_expert_ + num_slots - 1;
+    bool const using_hopper = moe_gemm_runner_.isHopperSpecialised();
+    for (int64_t round = 0; round < num_rounds; ++round)
     {
-        hopper_input = computeStridesHopper(total_rows_before_expert_, hopper_input, hidden_size, inter_size,
-            num_experts_per_node, fc1_result_, fc2_expert_weights, fc2_fp8_dequant, nullptr,
-            static_cast<HopperGemmOutputType*>(fc2_result_), stream);
+        fetchExpertCacheSlots(expert_for_source_row, k * num_rows, num_experts_per_node, num_experts, round, cache,
+            fc1_expert_weights, fc2_expert_weights, fc1_expert_bytes, fc2_expert_bytes, slot_for_source_row_,
+            slot_fetch_, stream);
+
+        sync_check_cuda_error();
+
+        sortExpertsAndComputeOffsets(
+            slot_for_source_row_, k * num_rows, expanded_active_expert_rows, num_experts, num_slots, stream);
+
+        sync_check_cuda_error();
+
+        expandInputRowsKernelLauncher(input_activations, permuted_data_, permuted_rows_,
+            expanded_source_row_to_expanded_dest_row, num_rows, num_valid_tokens_ptr, hidden_size, k, stream);
+
+        sync_check_cuda_error();
+
+        runExpertGemms(static_cast<WeightType const*>(cache.fc1_slots), nullptr, fc1_activation_type,
+            static_cast<WeightType const*>(cache.fc2_slots), quant_params, num_valid_tokens_ptr, num_rows * k,
+            expanded_active_expert_rows, hidden_size, inter_size, num_slots, stream);
+
+        if (using_hopper)
+        {
+            finalizeMoeRoutingKernelLauncher<T, OutputType, HopperGemmOutputType>(
+                static_cast<HopperGemmOutputType const*>(fc2_result_), final_output, static_cast<T const*>(nullptr),
+                expert_scales, expanded_source_row_to_expanded_dest_row, slot_for_source_row_, num_rows, hidden_size,
+                k, num_valid_tokens_ptr, parallelism_config, normalization_mode, stream, round > 0);
+        }
+        else
+        {
+            finalizeMoeRoutingKernelLauncher<T, OutputType>(static_cast<T const*>(fc2_result_), final_output,
+                static_cast<T const*>(nullptr), expert_scales, expanded_source_row_to_expanded_dest_row,
+                slot_for_source_row_, num_rows, hidden_size, k, num_valid_tokens_ptr, parallelism_config,
+                normalization_mode, stream, round > 0);
+        }
+
         sync_check_cuda_error();
     }
+}
 
-    moe_gemm_runner_.moeGemm(fc1_result_, fc2_expert_weights, fc2_int_scales, static_cast<T*>(fc2_result_),
-        total_rows_before_expert_, hopper_input, expanded_active_expert_rows, hidden_size, inter_size,
-        num_experts_per_node, false, stream);
+template <class T, class WeightType, class OutputType, class Enable>
+void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runFusedAllReduce(OutputType* final_output,
+    T const* fc2_expert_biases, float const* expert_scales, int const* expanded_source_row_to_expanded_dest_row,
+    int const* expert_for_source_row, int64_t const num_rows, int64_t const hidden_size, int const k,
+    int64_t const* num_valid_tokens_ptr, MOEParallelismConfig parallelism_config,
+    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
+{
+    auto params = *fused_all_reduce;
+    params.local_input_buffer_ptr = nullptr;
+    params.local_output_buffer_ptr = final_output;
+    params.elts_total = num_rows * hidden_size;
+    params.fusion_params.hidden_size = hidden_size;
+
+    // Same as finalizeMoeRoutingKernelLauncher
+    auto& moe = params.fusion_params.moe_finalize;
+    moe.permuted_rows = fc2_result_;
+    moe.source_to_permuted_row = expanded_source_row_to_expanded_dest_row;
+    moe.scales = expert_scales;
+    moe.experts = expert_for_source_row;
+    moe.bias = parallelism_config.tp_rank == 0 ? fc2_expert_biases : nullptr;
+    moe.num_valid_rows = num_valid_tokens_ptr;
+    moe.k = k;
+    moe.renormalize = normalization_mode == MOEExpertScaleNormalizationMode::RENORMALIZE;
+
+    auto const type = std::is_same_v<T, float>
+        ? nvinfer1::DataType::kFLOAT
+        : (std::is_same_v<T, half> ? nvinfer1::DataType::kHALF : nvinfer1::DataType::kBF16);
+    customAllReduce(params, type, fused_all_reduce_strategy, fused_all_reduce_config,
+        AllReduceFusionOp::MOE_FINALIZE_RESIDUAL_RMS_NORM, stream);
+}
 
-    sync_check_cuda_error();
+template <class T, class WeightType, class OutputType, class Enable>
+void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::runMoeAllToAll(T const* input_activations,
+    float const* gating_output, WeightType const* fc1_expert_weights, T const* fc1_expert_biases,
+    ActivationType fc1_activation_type, WeightType const* fc2_expert_weights, QuantParams quant_params,
+    int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size, int const num_experts, int const k,
+    char* workspace_ptr, OutputType* final_output, bool const* finished, float* expert_scales,
+    int* expanded_source_row_to_expanded_dest_row, int* expert_for_source_row, MOEParallelismConfig parallelism_config,
+    MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream)
+{
+    using Chunk = MoeAllToAllTransport::Chunk;
+    using ChunkList = std::vector<std::vector<Chunk>>;
 
-    if (using_hopper)
+    TLLM_CHECK_WITH_INFO(all_to_all_transport, "All-to-all expert parallelism requires a transport");
+
+    int const ep_size = parallelism_config.ep_size;
+    int const ep_rank = parallelism_config.ep_rank;
+    int const num_experts_per_node = num_experts / ep_size;
+
+    // Each rank routes and finalizes a contiguous slice of the tokens
+    int64_t const rows_per_rank = (num_rows + ep_size - 1) / ep_size;
+    auto const rowsOfRank = [&](int rank)
     {
-        finalizeMoeRoutingKernelLauncher<T, OutputType, HopperGemmOutputType>(
-            static_cast<HopperGemmOutputType const*>(fc2_result_), final_output, fc2_expert_biases, expert_scales,
-            expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows, hidden_size, k,
-            num_valid_tokens_ptr, parallelism_config, normalization_mode, stream);
+        int64_t const start = std::min(num_rows, rows_per_rank * rank);
+        return Chunk{start, std::min(num_rows, start + rows_per_rank) - start};
+    };
+    Chunk const local = rowsOfRank(ep_rank);
+    int64_t const expanded_local_rows = k * local.num_rows;
+
+    configureWsPtrs(
+        workspace_ptr, num_rows, hidden_size, inter_size, num_experts, num_experts_per_node, k, fc1_activation_type);
+    TLLM_CHECK(all_to_all_rows_ && all_to_all_counts_);
+
+    // The routing outputs are laid out per local row, use this rank's slice of the caller's buffers
+    expert_scales += local.offset * k;
+    expanded_source_row_to_expanded_dest_row += local.offset * k;
+    expert_for_source_row += local.offset * k;
+
+    // Layout of the host and device counts: [send counts per expert, receive counts per (peer, local expert), valid]
+    std::vector<int64_t> counts(2 * num_experts + 1, 0);
+    int64_t* const send_counts = counts.data();
+    int64_t* const recv_counts = counts.data() + num_experts;
+    int64_t& num_valid_rows = counts[2 * num_experts];
+
+    if (local.num_rows > 0)
+    {
+        // Route against every expert, rows end up sorted by expert and therefore by the rank that owns it
+        topkGatingSoftmaxKernelLauncher(gating_output + local.offset * num_experts,
+            finished ? finished + local.offset : nullptr, expert_scales, softmax_out_, expert_for_source_row,
+            source_rows_, local.num_rows, num_experts, k, 0, num_experts, stream);
+
+        sync_check_cuda_error();
+
+        sortExpertsAndComputeOffsets(
+            expert_for_source_row, expanded_local_rows, expanded_local_rows, num_experts, num_experts, stream);
+
+        sync_check_cuda_error();
+
+        // Rows of finished tokens are sorted past the last expert and are never sent
+        expandInputRowsKernelLauncher(input_activations + local.offset * hidden_size, static_cast<T*>(all_to_all_rows_),
+            permuted_rows_, expanded_source_row_to_expanded_dest_row, local.num_rows,
+            total_rows_before_expert_ + num_experts - 1, hidden_size, k, stream);
+
+        sync_check_cuda_error();
+
+        std::vector<int64_t> send_rows_before_expert(num_experts);
+        check_cuda_error(cudaMemcpyAsync(send_rows_before_expert.data(), total_rows_before_expert_,
+            num_experts * sizeof(int64_t), cudaMemcpyDeviceToHost, stream));
+        check_cuda_error(cudaStreamSynchronize(stream));
+        for (int expert = 0; expert < num_experts; ++expert)
+        {
+            send_counts[expert]
+                = send_rows_before_expert[expert] - (expert == 0 ? 0 : send_rows_before_expert[expert - 1]);
+        }
+        num_valid_rows = send_rows_before_expert[num_experts - 1];
     }
-    else
+
+    // Tell every peer how many rows it will receive for each of its experts
+    ChunkList send_count_chunks(ep_size);
+    ChunkList recv_count_chunks(ep_size);
+    for (int peer = 0; peer < ep_size; ++peer)
     {
-        finalizeMoeRoutingKernelLauncher<T, OutputType>(static_cast<T const*>(fc2_result_), final_output,
-            fc2_expert_biases, expert_scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row, num_rows,
-            hidden_size, k, num_valid_tokens_ptr, parallelism_config, normalization_mode, stream);
+        send_count_chunks[peer].push_back(Chunk{peer * num_experts_per_node, num_experts_per_node});
+        recv_count_chunks[peer].push_back(Chunk{peer * num_experts_per_node, num_experts_per_node});
     }
+    check_cuda_error(cudaMemcpyAsync(
+        all_to_all_counts_, counts.data(), counts.size() * sizeof(int64_t), cudaMemcpyHostToDevice, stream));
+    all_to_all_transport->exchange(all_to_all_counts_, send_count_chunks, all_to_all_counts_ + num_experts,
+        recv_count_chunks, sizeof(int64_t), stream);
+    check_cuda_error(cudaMemcpyAsync(recv_counts, all_to_all_counts_ + num_experts, num_experts * sizeof(int64_t),
+        cudaMemcpyDeviceToHost, stream));
+    check_cuda_error(cudaStreamSynchronize(stream));
+
+    // Received rows are grouped by local expert and then by source rank, so each expert is one contiguous GEMM problem
+    ChunkList send_chunks(ep_size);
+    ChunkList recv_chunks(ep_size);
+    std::vector<int64_t> recv_rows_before_expert(num_experts_per_node);
+    int64_t expanded_recv_rows = 0;
+    for (int local_expert = 0; local_expert < num_experts_per_node; ++local_expert)
+    {
+        for (int peer = 0; peer < ep_size; ++peer)
+        {
+            int64_t const rows = recv_counts[peer * num_experts_per_node + local_expert];
+            recv_chunks[peer].push_back(Chunk{expanded_recv_rows, rows});
+            expanded_recv_rows += rows;
+        }
+        recv_rows_before_expert[local_expert] = expanded_recv_rows;
+    }
+    int64_t send_offset = 0;
+    for (int expert = 0; expert < num_experts; ++expert)
+    {
+        send_chunks[expert / num_experts_per_node].push_back(Chunk{send_offset, send_counts[expert]});
+        send_offset += send_counts[expert];
+    }
+    TLLM_CHECK(expanded_recv_rows <= k * num_rows);
+
+    all_to_all_transport->exchange(
+        all_to_all_rows_, send_chunks, permuted_data_, recv_chunks, hidden_size * sizeof(T), stream);
+
+    if (expanded_recv_rows > 0)
+    {
+        check_cuda_error(cudaMemcpyAsync(total_rows_before_expert_, recv_rows_before_expert.data(),
+            num_experts_per_node * sizeof(int64_t), cudaMemcpyHostToDevice, stream));
+        if (expert_load_counts)
+        {
+            accumulateExpertLoad(total_rows_before_expert_, num_experts_per_node, expert_load_counts, stream);
+        }
+        runExpertGemms(fc1_expert_weights, fc1_expert_biases, fc1_activation_type, fc2_expert_weights, quant_params,
+            nullptr, expanded_recv_rows, expanded_recv_rows, hidden_size, inter_size, num_experts_per_node, stream);
+    }
+
+    // Send the expert outputs back to the rank that routed them, into the positions they were sent from
+    bool const using_hopper = moe_gemm_runner_.isHopperSpecialised();
+    size_t const gemm_output_bytes = using_hopper ? sizeof(HopperGemmOutputType) : sizeof(T);
+    all_to_all_transport->exchange(
+        fc2_result_, recv_chunks, all_to_all_rows_, send_chunks, hidden_size * gemm_output_bytes, stream);
+
+    if (local.num_rows > 0)
+    {
+        OutputType* local_output = final_output + local.offset * hidden_size;
+        int64_t const* num_valid_ptr = all_to_all_counts_ + 2 * num_experts;
+        if (using_hopper)
+        {
+            finalizeMoeRoutingKernelLauncher<T, OutputType, HopperGemmOutputType>(
+                static_cast<HopperGemmOutputType const*>(all_to_all_rows_), local_output, nullptr, expert_scales,
+                expanded_source_row_to_expanded_dest_row, expert_for_source_row, local.num_rows, hidden_size, k,
+                num_valid_ptr, parallelism_config, normalization_mode, stream);
+        }
+        else
+        {
+            finalizeMoeRoutingKernelLauncher<T, OutputType>(static_cast<T const*>(all_to_all_rows_), local_output,
+                nullptr, expert_scales, expanded_source_row_to_expanded_dest_row, expert_for_source_row,
+                local.num_rows, hidden_size, k, num_valid_ptr, parallelism_config, normalization_mode, stream);
+        }
+
+        sync_check_cuda_error();
+    }
+
+    // Gather the finalized slices so the output is complete on every rank
+    ChunkList gather_send_chunks(ep_size);
+    ChunkList gather_recv_chunks(ep_size);
+    for (int peer = 0; peer < ep_size; ++peer)
+    {
+        if (peer != ep_rank)
+        {
+            gather_send_chunks[peer].push_back(local);
+            gather_recv_chunks[peer].push_back(rowsOfRank(peer));
+        }
+    }
+    all_to_all_transport->exchange(final_output, gather_send_chunks, final_output, gather_recv_chunks,
+        hidden_size * sizeof(OutputType), stream);
+
+    sync_check_cuda_error();
+}
+template <class T, class WeightType, class OutputType, class Enable>
+void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::sortExpertsAndComputeOffsets(
+    int const* expert_for_source_row, int64_t const num_entries, int64_t const num_active_entries,
+    int const num_experts, int const num_experts_to_count, cudaStream_t stream)
+{
+    // The keys go up to num_experts inclusive, that is the sentinel value used by topk for disabled experts
+    int const num_keys = num_experts + 1;
+    if (num_entries <= SMALL_BATCH_SORT_MAX_ROWS)
+    {
+        size_t const smem_size = (num_keys + num_entries) * sizeof(int);
+        sortAndCountSmallBatchKernel<<<1, SMALL_BATCH_SORT_THREADS_PER_BLOCK, smem_size, stream>>>(
+            expert_for_source_row, source_rows_, permuted_experts_, permuted_rows_, total_rows_before_expert_,
+            num_entries, num_active_entries, num_keys, num_experts_to_count);
+        return;
+    }
+
+    sorter_.updateNumExperts(num_experts);
+    size_t const sorter_ws_size_bytes = pad_to_multiple_of_16(sorter_.getWorkspaceSize(num_entries, num_experts));
+    sorter_.run((void*) sorter_ws_, sorter_ws_size_bytes, expert_for_source_row, permuted_experts_, source_rows_,
+        permuted_rows_, num_entries, stream);
 
     sync_check_cuda_error();
+
+    computeTotalRowsBeforeExpert(
+        permuted_experts_, num_active_entries, num_experts_to_count, total_rows_before_expert_, stream);
 }
 
 template <class T, class WeightType, class OutputType, class Enable>
@@ -1395,29 +2351,37 @@ void CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::computeTotalRowsBefo
 }
 
 template <class T, class WeightType, class OutputType, class Enable>
-HopperGroupedGemmInput CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::computeStridesHopper(
-    int64_t const* total_rows_before_expert, HopperGroupedGemmInput layout_info, int64_t gemm_n, int64_t gemm_k,
-    int const num_experts, T const* in, WeightType const* weights, float const* fp8_dequant, T const* bias,
-    HopperGemmOutputType* output, cudaStream_t stream)
+std::pair<HopperGroupedGemmInput, HopperGroupedGemmInput>
+CutlassMoeFCRunner<T, WeightType, OutputType, Enable>::computeStridesHopper(int64_t const* total_rows_before_expert,
+    HopperGroupedGemmInput fc1_layout_info, HopperGroupedGemmInput fc2_layout_info, int64_t fc1_out_size,
+    int64_t hidden_size, int64_t inter_size, int const num_experts, T const* fc1_in, WeightType const* fc1_weights,
+    float const* fc1_fp8_dequant, HopperGemmOutputType* fc1_output, T const* fc2_in, WeightType const* fc2_weights,
+    float const* fc2_fp8_dequant, HopperGemmOutputType* fc2_output, cudaStream_t stream)
 {
-    if (!bias)
+    // CUTLASS does not support a bias in the grouped GEMM, it is added by the activation and finalize kernels
+    for (auto* layout_info : {&fc1_layout_info, &fc2_layout_info})
     {
-        layout_info.ptr_c = nullptr;
-        layout_info.stride_c = nullptr;
+        layout_info->ptr_c = nullptr;
+        layout_info->stride_c = nullptr;
     }
 
-    if (!fp8_dequant)
+    if (!fc1_fp8_dequant)
+    {
+        fc1_layout_info.alpha_scale_ptr_array = nullptr;
+    }
+    if (!fc2_fp8_dequant)
     {
-        layout_info.alpha_scale_ptr_array = nullptr;
+        fc2_layout_info.alpha_scale_ptr_array = nullptr;
     }
 
     int const threads = std::min(1024, num_experts);
     int const blocks = (num_experts + threads - 1) / threads;
 
-    computeStridesHopperKernel<<<blocks, threads, 0, stream>>>(
-        total_rows_before_expert, layout_info, gemm_n, gemm_k, num_experts, in, weights, fp8_dequant, bias, output);
+    computeStridesHopperKernel<<<blocks, threads, 0, stream>>>(total_rows_before_expert, fc1_layout_info,
+        fc2_layout_info, fc1_out_size, hidden_size, inter_size, num_experts, fc1_in, fc1_weights, fc1_fp8_dequant,
+        fc1_output, fc2_in, fc2_weights, fc2_fp8_dequant, fc2_output);
 
-    return layout_info;
+    return {fc1_layout_info, fc2_layout_info};
 }
 
 // ==================== Helper for getting load balanced routing for profiling ==================================
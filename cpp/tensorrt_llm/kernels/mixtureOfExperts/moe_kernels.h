@@ -19,10 +19,14 @@
 #include "cutlass/gemm/gemm.h"
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_gemm_kernels.h"
 #include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
 #include <cuda_runtime_api.h>
+#include <memory>
 #include <optional>
+#include <utility>
+#include <vector>
 
 namespace tensorrt_llm::kernels
 {
@@ -79,6 +83,9 @@ enum class MOEExpertScaleNormalizationMode : int
  * Regardless of parallelism mode:
  *  * The input routing values must be the complete routing for all tokens/experts (required for softmax)
  *  * An allreduce must be run on the result to combine the results from different nodes if parallelism > 1
+ *
+ * The exception is all-to-all expert parallelism (see MoeAllToAllTransport), where the runner combines the expert
+ * parallel results itself and only the tensor parallel allreduce is still required
  */
 struct MOEParallelismConfig
 {
@@ -120,7 +127,8 @@ struct MOEParallelismConfig
 
 struct QuantParams
 {
-    // Int weight only quantization params
+    // Int weight only quantization params. With per channel scales these are [num_experts, n]. With a group size they
+    // are [num_experts, k / group_size, n], so each group of group_size rows of K has its own scale (AWQ/GPTQ style)
     void const* fc1_weight_scales = nullptr;
     void const* fc2_weight_scales = nullptr;
 
@@ -130,6 +138,9 @@ struct QuantParams
     float const* dequant_fc2 = nullptr;
     float const* quant_final = nullptr;
 
+    // Int weight only group size, 0 for per channel scales
+    int64_t group_size = 0;
+
     static QuantParams FP8(
         float const* dequant_fc1, float const* quant_fc2, float const* dequant_fc2, float const* quant_final = nullptr)
     {
@@ -140,6 +151,66 @@ struct QuantParams
     {
         return QuantParams{fc1_weight_scales, fc2_weight_scales, nullptr, nullptr, nullptr, nullptr};
     }
+
+    static QuantParams GroupwiseInt(void const* fc1_weight_scales, void const* fc2_weight_scales, int64_t group_size)
+    {
+        return QuantParams{fc1_weight_scales, fc2_weight_scales, nullptr, nullptr, nullptr, nullptr, group_size};
+    }
+};
+
+/**
+ * \brief Point-to-point transport used by all-to-all expert parallelism
+ *
+ * With plain expert parallelism every EP rank routes all of the tokens, runs the ones that selected its experts and an
+ * allreduce sums the partial outputs. With all-to-all enabled each EP rank instead routes a contiguous 1/ep_size slice
+ * of the tokens, sends every expanded row only to the rank owning the selected expert, runs the expert GEMMs on the
+ * rows it received and sends the results back so the owning rank can finalize them. The finalized slices are then
+ * exchanged between the EP ranks, so the output is complete on every rank without an allreduce over the EP group.
+ *
+ * Peers are indexed by EP rank. The runner always issues the chunks for a peer in the same order on both ends.
+ */
+class MoeAllToAllTransport
+{
+public:
+    //! A contiguous run of rows, both values are in rows of the buffer being exchanged
+    struct Chunk
+    {
+        int64_t offset;
+        int64_t num_rows;
+    };
+
+    virtual ~MoeAllToAllTransport() = default;
+
+    //! Send send_chunks[peer] of send_buf to every peer and receive recv_chunks[peer] into recv_buf.
+    //! Empty chunks must be skipped, the matching chunk on the other end is always empty too
+    virtual void exchange(void const* send_buf, std::vector<std::vector<Chunk>> const& send_chunks, void* recv_buf,
+        std::vector<std::vector<Chunk>> const& recv_chunks, size_t row_bytes, cudaStream_t stream)
+        = 0;
+};
+
+/**
+ * Device cache of expert weights for serving MoE models whose experts do not fit in GPU memory.
+ *
+ * The weights of all local experts stay in pinned host memory mapped into the device address space, and are passed to
+ * runMoe as usual. Only num_slots experts of FC1 and FC2 weights are resident on the GPU. On every run the router
+ * output decides which experts are needed. Experts that are already resident are reused, the others replace the least
+ * recently used slots and are copied in by the GPU over PCIe, so the cache never needs a host sync. When more experts
+ * are active than there are slots, the layer is run in several rounds of at most num_slots experts.
+ *
+ * All pointers are device memory owned by the caller. slot_expert must be initialized to -1 and slot_last_use and
+ * step to 0 before the first run. Only unquantized weights without biases are supported.
+ */
+struct MoeExpertCache
+{
+    //! num_slots experts worth of FC1 and FC2 weights, laid out like the weights of the first num_slots experts
+    void* fc1_slots = nullptr;
+    void* fc2_slots = nullptr;
+    int num_slots = 0;
+    //! Expert held by each slot, -1 for an empty slot
+    int* slot_expert = nullptr;
+    //! Round in which each slot was last used, and the number of rounds run so far
+    int64_t* slot_last_use = nullptr;
+    int64_t* step = nullptr;
 };
 
 class CutlassMoeFCRunnerInterface
@@ -164,6 +235,51 @@ public:
         = 0;
 
     bool is_profiler = false;
+
+    // All-to-all expert parallelism, see MoeAllToAllTransport. The flag changes the workspace size so it must be set
+    // when building, the transport is only needed when running. Ignored while profiling and when ep_size == 1
+    bool use_all_to_all = false;
+    std::shared_ptr<MoeAllToAllTransport> all_to_all_transport;
+
+    // When set, the number of rows routed to each expert of this rank is added to these num_experts / ep_size device
+    // counters on every run, see runtime::MoeExpertLoadTracker. Not updated while profiling
+    int64_t* expert_load_counts = nullptr;
+
+    // When set, the expert weights passed to runMoe may live in host memory, see MoeExpertCache. Must be set before
+    // querying the workspace size
+    std::shared_ptr<MoeExpertCache> expert_cache;
+
+    // When positive, each expert processes at most ceil(capacity_factor * k * num_rows / num_experts) rows to bound the
+    // cost of a skewed batch. Rows beyond the capacity are dropped, in priority order first choices are kept before
+    // second choices and earlier tokens before later ones. A dropped row adds nothing to the output of its token, so
+    // a token that loses all of its experts only keeps the residual connection around the MoE. Must be set before
+    // querying the workspace size. Not supported with all-to-all expert parallelism or the expert cache
+    float capacity_factor = 0.f;
+    // Offer the dropped rows to the best scoring expert their token did not select that still has room, instead of
+    // dropping them right away
+    bool reroute_overflow = false;
+    // When set with a capacity, the rows beyond the capacity of each of the num_experts / ep_size experts of this rank
+    // are added to the first counters and the rows of these experts that were dropped in the end to the last one. Not
+    // updated while profiling
+    int64_t* expert_overflow_counts = nullptr;
+
+    // Dense experts every token goes through with a scale of one, on top of its top-k experts (DeepSeek/Qwen style).
+    // They run as extra groups of the grouped GEMMs and are summed in the finalize kernel, instead of as a separate
+    // MLP. The weights, biases and scales of the shared experts follow the num_experts / ep_size routed experts of
+    // this rank in the expert tensors, a wider shared MLP is split along the inter size into several shared experts.
+    // expert_scales, expert_for_source_row and expanded_source_row_to_expanded_dest_row hold k + num_shared_experts
+    // entries per row. Only EP rank 0 runs the shared experts. Must be set before querying the workspace size. Not
+    // supported with all-to-all expert parallelism or the expert cache
+    int num_shared_experts = 0;
+
+    // When set, the k-way reduction of the finalize step is fused into the custom all reduce of these params across
+    // the tensor and expert parallel ranks, followed by the residual add and RMS norm of fusion_params. final_output
+    // then receives the normalized output and fusion_params.intermediate_buffer the new residual, instead of the
+    // unreduced MoE output. The one-shot strategy does all of it in a single kernel. Only supported when OutputType is
+    // T. Ignored while profiling. Not supported with all-to-all expert parallelism or the expert cache
+    AllReduceParams const* fused_all_reduce = nullptr;
+    AllReduceStrategyType fused_all_reduce_strategy = AllReduceStrategyType::ONESHOT;
+    AllReduceStrategyConfig fused_all_reduce_config{};
 };
 
 // Assumes inputs activations are row major. Weights need to be preprocessed by th_op/weight_quantize.cc .
@@ -217,15 +333,42 @@ private:
 
     void computeTotalRowsBeforeExpert(int const* sorted_indices, int const total_indices, int const num_experts,
         int64_t* total_rows_before_expert, cudaStream_t stream);
-    HopperGroupedGemmInput computeStridesHopper(int64_t const* total_rows_before_expert,
-        HopperGroupedGemmInput layout_info, int64_t gemm_n, int64_t gemm_k, int const num_experts, T const* in,
-        WeightType const* weights, float const* fp8_dequant, T const* bias, HopperGemmOutputType* output,
-        cudaStream_t stream);
+    void sortExpertsAndComputeOffsets(int const* expert_for_source_row, int64_t const num_entries,
+        int64_t const num_active_entries, int const num_experts, int const num_experts_to_count, cudaStream_t stream);
+    std::pair<HopperGroupedGemmInput, HopperGroupedGemmInput> computeStridesHopper(
+        int64_t const* total_rows_before_expert, HopperGroupedGemmInput fc1_layout_info,
+        HopperGroupedGemmInput fc2_layout_info, int64_t fc1_out_size, int64_t hidden_size, int64_t inter_size,
+        int const num_experts, T const* fc1_in, WeightType const* fc1_weights, float const* fc1_fp8_dequant,
+        HopperGemmOutputType* fc1_output, T const* fc2_in, WeightType const* fc2_weights, float const* fc2_fp8_dequant,
+        HopperGemmOutputType* fc2_output, cudaStream_t stream);
     std::vector<size_t> getWorkspaceBufferSizes(int64_t const num_rows, int64_t const hidden_size,
         int64_t const inter_size, int const num_experts, int const num_experts_per_node, int const k,
         ActivationType activation_type) const;
     void configureWsPtrs(char* ws_ptr, int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size,
         int const num_experts, int const num_experts_per_node, int const k, ActivationType activation_type);
+    void runExpertGemms(WeightType const* fc1_expert_weights, T const* fc1_expert_biases,
+        ActivationType fc1_activation_type, WeightType const* fc2_expert_weights, QuantParams quant_params,
+        int64_t const* num_valid_tokens_ptr, int64_t const expanded_num_rows, int64_t const expanded_active_expert_rows,
+        int64_t const hidden_size, int64_t const inter_size, int const num_experts_per_node, cudaStream_t stream);
+    void runMoeWithExpertCache(T const* input_activations, WeightType const* fc1_expert_weights,
+        ActivationType fc1_activation_type, WeightType const* fc2_expert_weights, QuantParams quant_params,
+        int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size, int const num_experts,
+        int const num_experts_per_node, int const k, int64_t const expanded_active_expert_rows,
+        OutputType* final_output, float const* expert_scales, int* expanded_source_row_to_expanded_dest_row,
+        int const* expert_for_source_row, MOEParallelismConfig parallelism_config,
+        MOEExpertScaleNormalizationMode normalization_mode, cudaStream_t stream);
+    void runFusedAllReduce(OutputType* final_output, T const* fc2_expert_biases, float const* expert_scales,
+        int const* expanded_source_row_to_expanded_dest_row, int const* expert_for_source_row, int64_t const num_rows,
+        int64_t const hidden_size, int const k, int64_t const* num_valid_tokens_ptr,
+        MOEParallelismConfig parallelism_config, MOEExpertScaleNormalizationMode normalization_mode,
+        cudaStream_t stream);
+    void runMoeAllToAll(T const* input_activations, float const* gating_output, WeightType const* fc1_expert_weights,
+        T const* fc1_expert_biases, ActivationType fc1_activation_type, WeightType const* fc2_expert_weights,
+        QuantParams quant_params, int64_t const num_rows, int64_t const hidden_size, int64_t const inter_size,
+        int const num_experts, int const k, char* workspace_ptr, OutputType* final_output, bool const* finished,
+        float* expert_scales, int* expanded_source_row_to_expanded_dest_row, int* expert_for_source_row,
+        MOEParallelismConfig parallelism_config, MOEExpertScaleNormalizationMode normalization_mode,
+        cudaStream_t stream);
 
 private:
     bool mayHaveDifferentGEMMOutputType() const
@@ -251,7 +394,25 @@ private:
     void* fc2_result_{};
     T* fc1_result_{};
 
+    // Only allocated for all-to-all expert parallelism
+    void* all_to_all_rows_{};
+    int64_t* all_to_all_counts_{};
+
+    // Only allocated when an expert cache is set
+    int* slot_for_source_row_{};
+    int* slot_fetch_{};
+
+    // Only allocated with a capacity factor, the reroute buffers only when rerouting the overflow
+    int* expert_fill_{};
+    int* reroute_experts_{};
+    float* reroute_scales_{};
+
+    // Only allocated with shared experts
+    int* routed_experts_{};
+    float* routed_scales_{};
+
     HopperGroupedGemmInput hopper_grouped_gemm_input_;
+    HopperGroupedGemmInput hopper_fc2_grouped_gemm_input_;
 };
 
 void makeLoadBalancedRoutingConfiguration(
@@ -171,5 +171,236 @@ INSTANTIATE_INVOKE_PER_TOKEN_QUANTIZATION(half);
 INSTANTIATE_INVOKE_PER_TOKEN_QUANTIZATION(__nv_bfloat16);
 #endif
 
+namespace
+{
+template <typename T>
+__device__ float groupAbsMax(T const* src, int64_t groupSize)
+{
+    float localMax = 1e-6f;
+    for (int64_t i = threadIdx.x; i < groupSize; i += blockDim.x)
+    {
+        localMax = fmaxf(localMax, fabsf(cuda_cast<float>(src[i])));
+    }
+    return blockAllReduceMax(localMax);
+}
+} // namespace
+
+#ifdef ENABLE_FP8
+template <typename T>
+__global__ void perGroupFp8Quantization(__nv_fp8_e4m3* dst, T const* src, int64_t groupSize, float* scales)
+{
+    T const* srcGroup = src + blockIdx.x * groupSize;
+    __nv_fp8_e4m3* dstGroup = dst + blockIdx.x * groupSize;
+
+    float const groupMax = groupAbsMax(srcGroup, groupSize);
+    if (threadIdx.x == 0)
+    {
+        scales[blockIdx.x] = groupMax / FP8_E4M3_MAX;
+    }
+
+    float const scaleOrigQuant = FP8_E4M3_MAX / groupMax;
+    for (int64_t i = threadIdx.x; i < groupSize; i += blockDim.x)
+    {
+        dstGroup[i] = static_cast<__nv_fp8_e4m3>(cuda_cast<float>(srcGroup[i]) * scaleOrigQuant);
+    }
+}
+
+template <typename T>
+__global__ void perGroupFp8Dequantization(T* dst, __nv_fp8_e4m3 const* src, int64_t groupSize, float const* scales)
+{
+    T* dstGroup = dst + blockIdx.x * groupSize;
+    __nv_fp8_e4m3 const* srcGroup = src + blockIdx.x * groupSize;
+    float const scale = scales[blockIdx.x];
+    for (int64_t i = threadIdx.x; i < groupSize; i += blockDim.x)
+    {
+        dstGroup[i] = cuda_cast<T>(static_cast<float>(srcGroup[i]) * scale);
+    }
+}
+#endif // ENABLE_FP8
+
+template <typename T>
+void invokePerGroupFp8Quantization(
+    void* dst, T const* src, int64_t numGroups, int64_t groupSize, float* scales, cudaStream_t stream)
+{
+#ifdef ENABLE_FP8
+    // each block is responsible for a single group
+    dim3 const block(512);
+    dim3 const grid(numGroups);
+    perGroupFp8Quantization<<<grid, block, 0, stream>>>(
+        reinterpret_cast<__nv_fp8_e4m3*>(dst), src, groupSize, scales);
+#else
+    TLLM_THROW("FP8 quantization requires ENABLE_FP8");
+#endif
+}
+
+template <typename T>
+void invokePerGroupFp8Dequantization(
+    T* dst, void const* src, int64_t numGroups, int64_t groupSize, float const* scales, cudaStream_t stream)
+{
+#ifdef ENABLE_FP8
+    dim3 const block(512);
+    dim3 const grid(numGroups);
+    perGroupFp8Dequantization<<<grid, block, 0, stream>>>(
+        dst, reinterpret_cast<__nv_fp8_e4m3 const*>(src), groupSize, scales);
+#else
+    TLLM_THROW("FP8 dequantization requires ENABLE_FP8");
+#endif
+}
+
+template <typename T>
+__global__ void perGroupInt4Quantization(uint8_t* dst, T const* src, int64_t groupSize, float* scales)
+{
+    T const* srcGroup = src + blockIdx.x * groupSize;
+    uint8_t* dstGroup = dst + blockIdx.x * (groupSize / 2);
+
+    float constexpr kInt4Max = 7.f;
+    float const groupMax = groupAbsMax(srcGroup, groupSize);
+    if (threadIdx.x == 0)
+    {
+        scales[blockIdx.x] = groupMax / kInt4Max;
+    }
+
+    float const scaleOrigQuant = kInt4Max / groupMax;
+    for (int64_t i = threadIdx.x; i < groupSize / 2; i += blockDim.x)
+    {
+        auto const lo = __float2int_rn(fminf(fmaxf(cuda_cast<float>(srcGroup[2 * i]) * scaleOrigQuant, -8.f), 7.f));
+        auto const hi
+            = __float2int_rn(fminf(fmaxf(cuda_cast<float>(srcGroup[2 * i + 1]) * scaleOrigQuant, -8.f), 7.f));
+        dstGroup[i] = static_cast<uint8_t>((lo & 0xF) | ((hi & 0xF) << 4));
+    }
+}
+
+template <typename T>
+__global__ void perGroupInt4Dequantization(T* dst, uint8_t const* src, int64_t groupSize, float const* scales)
+{
+    T* dstGroup = dst + blockIdx.x * groupSize;
+    uint8_t const* srcGroup = src + blockIdx.x * (groupSize / 2);
+    float const scale = scales[blockIdx.x];
+    for (int64_t i = threadIdx.x; i < groupSize / 2; i += blockDim.x)
+    {
+        auto const packed = srcGroup[i];
+        // sign extend the nibbles
+        auto const lo = static_cast<int8_t>(packed << 4) >> 4;
+        auto const hi = static_cast<int8_t>(packed) >> 4;
+        dstGroup[2 * i] = cuda_cast<T>(static_cast<float>(lo) * scale);
+        dstGroup[2 * i + 1] = cuda_cast<T>(static_cast<float>(hi) * scale);
+    }
+}
+
+template <typename T>
+void invokePerGroupInt4Quantization(
+    uint8_t* dst, T const* src, int64_t numGroups, int64_t groupSize, float* scales, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(groupSize % 2 == 0, "[ERROR][invokePerGroupInt4Quantization] groupSize should be even.\n");
+    dim3 const block(512);
+    dim3 const grid(numGroups);
+    perGroupInt4Quantization<<<grid, block, 0, stream>>>(dst, src, groupSize, scales);
+}
+
+template <typename T>
+void invokePerGroupInt4Dequantization(
+    T* dst, uint8_t const* src, int64_t numGroups, int64_t groupSize, float const* scales, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(groupSize % 2 == 0, "[ERROR][invokePerGroupInt4Dequantization] groupSize should be even.\n");
+    dim3 const block(512);
+    dim3 const grid(numGroups);
+    perGroupInt4Dequantization<<<grid, block, 0, stream>>>(dst, src, groupSize, scales);
+}
+
+#define INSTANTIATE_INVOKE_PER_GROUP_QUANTIZATION(T)                                                                   \
+    template void invokePerGroupFp8Quantization(                                                                       \
+        void* dst, const T* src, int64_t numGroups, int64_t groupSize, float* scales, cudaStream_t stream);            \
+    template void invokePerGroupFp8Dequantization(                                                                     \
+        T* dst, void const* src, int64_t numGroups, int64_t groupSize, float const* scales, cudaStream_t stream);      \
+    template void invokePerGroupInt4Quantization(                                                                      \
+        uint8_t* dst, const T* src, int64_t numGroups, int64_t groupSize, float* scales, cudaStream_t stream);         \
+    template void invokePerGroupInt4Dequantization(                                                                    \
+        T* dst, uint8_t const* src, int64_t numGroups, int64_t groupSize, float const* scales, cudaStream_t stream)
+
+INSTANTIATE_INVOKE_PER_GROUP_QUANTIZATION(float);
+INSTANTIATE_INVOKE_PER_GROUP_QUANTIZATION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_INVOKE_PER_GROUP_QUANTIZATION(__nv_bfloat16);
+#endif
+
+// One thread per output byte of a row, walking down the columns of the byte twice, for the max then the values
+template <typename T, int kBits>
+__global__ void perChannelWeightQuantization(int8_t* dst, T* scales, T const* src, int64_t numRows, int64_t numCols)
+{
+    int constexpr kEltsPerByte = 8 / kBits;
+    float constexpr kQuantMax = static_cast<float>((1 << (kBits - 1)) - 1);
+    float constexpr kQuantMin = -static_cast<float>(1 << (kBits - 1));
+    float constexpr kRangeScale = 1.f / static_cast<float>(1 << (kBits - 1));
+
+    int64_t const bytesPerRow = numCols / kEltsPerByte;
+    int64_t const outCol = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (outCol >= bytesPerRow)
+    {
+        return;
+    }
+    src += blockIdx.y * numRows * numCols + outCol * kEltsPerByte;
+    dst += blockIdx.y * numRows * bytesPerRow + outCol;
+    scales += blockIdx.y * numCols + outCol * kEltsPerByte;
+
+    float colScales[kEltsPerByte] = {};
+    for (int64_t row = 0; row < numRows; ++row)
+    {
+#pragma unroll
+        for (int e = 0; e < kEltsPerByte; ++e)
+        {
+            colScales[e] = fmaxf(colScales[e], fabsf(cuda_cast<float>(src[row * numCols + e])));
+        }
+    }
+#pragma unroll
+    for (int e = 0; e < kEltsPerByte; ++e)
+    {
+        colScales[e] *= kRangeScale;
+        scales[e] = cuda_cast<T>(colScales[e]);
+    }
+
+    for (int64_t row = 0; row < numRows; ++row)
+    {
+        int packed = 0;
+#pragma unroll
+        for (int e = 0; e < kEltsPerByte; ++e)
+        {
+            float const weight = cuda_cast<float>(src[row * numCols + e]);
+            float const scaled = colScales[e] != 0.f ? roundf(weight / colScales[e]) : 0.f;
+            auto const quantized = static_cast<int>(fminf(fmaxf(scaled, kQuantMin), kQuantMax));
+            packed |= kBits == 8 ? quantized : (quantized & 0xF) << (kBits * e);
+        }
+        dst[row * bytesPerRow] = static_cast<int8_t>(packed);
+    }
+}
+
+template <typename T>
+void invokePerChannelWeightQuantization(int8_t* dst, T* scales, T const* src, int64_t numMatrices, int64_t numRows,
+    int64_t numCols, int bits, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(bits == 8 || bits == 4, "Only INT8 and INT4 weights are supported.");
+    TLLM_CHECK_WITH_INFO(bits == 8 || numCols % 2 == 0, "INT4 weights need an even number of columns.");
+    dim3 const block(256);
+    dim3 const grid(divUp(numCols * bits / 8, block.x), numMatrices);
+    if (bits == 8)
+    {
+        perChannelWeightQuantization<T, 8><<<grid, block, 0, stream>>>(dst, scales, src, numRows, numCols);
+    }
+    else
+    {
+        perChannelWeightQuantization<T, 4><<<grid, block, 0, stream>>>(dst, scales, src, numRows, numCols);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_INVOKE_PER_CHANNEL_WEIGHT_QUANTIZATION(T)                                                          \
+    template void invokePerChannelWeightQuantization(int8_t* dst, T* scales, T const* src, int64_t numMatrices,        \
+        int64_t numRows, int64_t numCols, int bits, cudaStream_t stream)
+
+INSTANTIATE_INVOKE_PER_CHANNEL_WEIGHT_QUANTIZATION(float);
+INSTANTIATE_INVOKE_PER_CHANNEL_WEIGHT_QUANTIZATION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_INVOKE_PER_CHANNEL_WEIGHT_QUANTIZATION(__nv_bfloat16);
+#endif
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -31,5 +31,36 @@ template <typename T>
 void invokePerTokenQuantization(
     int8_t* dst, T const* src, const int64_t numRows, const int64_t numCols, float* scalePtr, cudaStream_t stream = 0);
 
+//! \brief Quantize `numGroups` contiguous groups of `groupSize` elements to FP8, with one scale per group.
+//! \details scales[g] receives the dequantization scale of group g, e.g. of one KV cache block for offloading.
+template <typename T>
+void invokePerGroupFp8Quantization(void* dst, T const* src, int64_t numGroups, int64_t groupSize, float* scales,
+    cudaStream_t stream = 0);
+
+//! \brief Inverse of invokePerGroupFp8Quantization.
+template <typename T>
+void invokePerGroupFp8Dequantization(T* dst, void const* src, int64_t numGroups, int64_t groupSize,
+    float const* scales, cudaStream_t stream = 0);
+
+//! \brief Quantize `numGroups` contiguous groups of `groupSize` elements to symmetric INT4, two values per byte, with
+//! one scale per group. `groupSize` must be even.
+template <typename T>
+void invokePerGroupInt4Quantization(
+    uint8_t* dst, T const* src, int64_t numGroups, int64_t groupSize, float* scales, cudaStream_t stream = 0);
+
+//! \brief Inverse of invokePerGroupInt4Quantization.
+template <typename T>
+void invokePerGroupInt4Dequantization(T* dst, uint8_t const* src, int64_t numGroups, int64_t groupSize,
+    float const* scales, cudaStream_t stream = 0);
+
+//! \brief Symmetric per-column quantization of `numMatrices` row-major [numRows, numCols] weights to INT8 or INT4, as
+//! the symmetric_quantize of the cutlass preprocessors. The INT4 values are packed two per byte along the columns, the
+//! even column in the low nibble, `numCols` must then be even.
+//! \param dst [numMatrices, numRows, numCols * bits / 8]
+//! \param scales [numMatrices, numCols], the dequantization scales
+template <typename T>
+void invokePerChannelWeightQuantization(int8_t* dst, T* scales, T const* src, int64_t numMatrices, int64_t numRows,
+    int64_t numCols, int bits, cudaStream_t stream = 0);
+
 } // namespace kernels
 } // namespace tensorrt_llm
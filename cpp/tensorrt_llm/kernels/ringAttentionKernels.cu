@@ -0,0 +1,177 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+SizeType32 constexpr ATTENTION_BLOCK_SIZE = 256;
+SizeType32 constexpr WARP_SIZE = 32;
+SizeType32 constexpr QUERIES_PER_BLOCK = ATTENTION_BLOCK_SIZE / WARP_SIZE;
+SizeType32 constexpr DIMS_PER_LANE = RING_ATTENTION_MAX_HEAD_SIZE / WARP_SIZE;
+
+//! Each warp handles one query: lane t computes the score of key t of each tile of WARP_SIZE keys and accumulates the
+//! dimensions t, t + WARP_SIZE, ... of the output. The warps are independent, so the ones whose causal range ends
+//! earlier stop earlier.
+template <typename T>
+__global__ void attendKvShard(RingAttentionParams<T> params)
+{
+    extern __shared__ float sQ[];
+    __shared__ float sProbs[ATTENTION_BLOCK_SIZE];
+
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const warpIdx = tid / WARP_SIZE;
+    auto const lane = tid % WARP_SIZE;
+    auto const headIdx = static_cast<SizeType32>(blockIdx.y);
+    auto const seqIdx = static_cast<SizeType32>(blockIdx.z);
+    auto const headSize = params.headSize;
+    auto const kvHeadIdx = headIdx / (params.numHeads / params.numKvHeads);
+
+    auto const seqBegin = params.seqOffsets[seqIdx];
+    auto const shardLength = params.seqOffsets[seqIdx + 1] - seqBegin;
+    auto const seqLength = params.seqLengths[seqIdx];
+    auto const getNumShardTokens
+        = [&](SizeType32 shardIdx) { return max(0, min(shardLength, seqLength - shardIdx * shardLength)); };
+
+    auto const queryIdx = static_cast<SizeType32>(blockIdx.x) * QUERIES_PER_BLOCK + warpIdx;
+    if (queryIdx >= getNumShardTokens(params.qShardIdx))
+    {
+        return;
+    }
+    auto const queryPos = params.qShardIdx * shardLength + queryIdx;
+    auto const kvPosBegin = params.kvShardIdx * shardLength;
+    auto numKeys = getNumShardTokens(params.kvShardIdx);
+    if (params.causal)
+    {
+        numKeys = max(0, min(numKeys, queryPos - kvPosBegin + 1));
+    }
+
+    auto* sWarpQ = sQ + warpIdx * headSize;
+    auto const row = (seqBegin + queryIdx) * params.numHeads + headIdx;
+    for (auto di = lane; di < headSize; di += WARP_SIZE)
+    {
+        sWarpQ[di] = static_cast<float>(params.q[row * headSize + di]) * params.qkScale;
+    }
+    __syncwarp();
+
+    float acc[DIMS_PER_LANE] = {};
+    float runMax = -INFINITY;
+    float runSum = 0.f;
+    auto* sWarpProbs = sProbs + warpIdx * WARP_SIZE;
+    for (SizeType32 tileBegin = 0; tileBegin < numKeys; tileBegin += WARP_SIZE)
+    {
+        auto const keyIdx = tileBegin + lane;
+        bool const isValid = keyIdx < numKeys;
+        float score = -INFINITY;
+        if (isValid)
+        {
+            auto const* k = params.k + ((seqBegin + keyIdx) * params.numKvHeads + kvHeadIdx) * headSize;
+            score = 0.f;
+            for (SizeType32 di = 0; di < headSize; ++di)
+            {
+                score += sWarpQ[di] * static_cast<float>(k[di]);
+            }
+        }
+
+        auto const newMax = fmaxf(runMax, warpReduceMax(score));
+        auto const prob = isValid ? __expf(score - newMax) : 0.f;
+        auto const correction = runMax == -INFINITY ? 0.f : __expf(runMax - newMax);
+        runSum = runSum * correction + warpReduceSum(prob);
+        runMax = newMax;
+        sWarpProbs[lane] = prob;
+        __syncwarp();
+
+        auto const numTileKeys = min(WARP_SIZE, numKeys - tileBegin);
+#pragma unroll
+        for (SizeType32 i = 0; i < DIMS_PER_LANE; ++i)
+        {
+            auto const di = lane + i * WARP_SIZE;
+            if (di < headSize)
+            {
+                auto value = acc[i] * correction;
+                for (SizeType32 ki = 0; ki < numTileKeys; ++ki)
+                {
+                    auto const* v
+                        = params.v + ((seqBegin + tileBegin + ki) * params.numKvHeads + kvHeadIdx) * headSize;
+                    value += sWarpProbs[ki] * static_cast<float>(v[di]);
+                }
+                acc[i] = value;
+            }
+        }
+        __syncwarp();
+    }
+
+    // Merge with the keys of the previous steps, both outputs are normalized over their own keys.
+    auto const lse = runSum > 0.f ? runMax + __logf(runSum) : -INFINITY;
+    auto const prevLse = params.firstStep ? -INFINITY : params.accLse[row];
+    auto const maxLse = fmaxf(prevLse, lse);
+    auto const prevWeight = maxLse == -INFINITY ? 0.f : __expf(prevLse - maxLse);
+    auto const weight = maxLse == -INFINITY ? 0.f : __expf(lse - maxLse);
+    auto const sumWeights = prevWeight + weight;
+    auto const prevScale = sumWeights > 0.f ? prevWeight / sumWeights : 0.f;
+    auto const scale = sumWeights > 0.f && runSum > 0.f ? weight / (sumWeights * runSum) : 0.f;
+#pragma unroll
+    for (SizeType32 i = 0; i < DIMS_PER_LANE; ++i)
+    {
+        auto const di = lane + i * WARP_SIZE;
+        if (di < headSize)
+        {
+            auto& out = params.accOut[row * headSize + di];
+            out = (params.firstStep ? 0.f : prevScale * out) + scale * acc[i];
+        }
+    }
+    // All lanes read the previous log-sum-exp before it is overwritten.
+    __syncwarp();
+    if (lane == 0)
+    {
+        params.accLse[row] = sumWeights > 0.f ? maxLse + __logf(sumWeights) : -INFINITY;
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeRingAttentionStep(RingAttentionParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+    TLLM_CHECK_WITH_INFO(params.firstStep || !isRingAttentionStepMasked(params),
+        "Masked ring attention steps should be skipped");
+
+    dim3 const grid(divUp(params.maxShardLength, QUERIES_PER_BLOCK), params.numHeads, params.batchSize);
+    auto const smemSize = QUERIES_PER_BLOCK * params.headSize * sizeof(float);
+    attendKvShard<T><<<grid, ATTENTION_BLOCK_SIZE, smemSize, stream>>>(params);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeRingAttentionStep(RingAttentionParams<float> const& params, cudaStream_t stream);
+template void invokeRingAttentionStep(RingAttentionParams<half> const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeRingAttentionStep(RingAttentionParams<__nv_bfloat16> const& params, cudaStream_t stream);
+#endif
+} // namespace kernels
+} // namespace tensorrt_llm
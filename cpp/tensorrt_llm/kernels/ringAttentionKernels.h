@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+//! Largest head size supported by the ring attention kernels.
+static constexpr runtime::SizeType32 RING_ATTENTION_MAX_HEAD_SIZE = 256;
+
+//! \brief One step of context parallel (ring) attention. The tokens of each sequence are split in numShards
+//! contiguous shards of ceil(seqLength / numShards) tokens, the last shards being padded. Every rank holds the queries
+//! of its shard and attends the keys and values of one shard per step, the shards travelling around the ring.
+//! Shards use the same packed layout on all ranks: the tokens of sequence b are [seqOffsets[b], seqOffsets[b + 1]).
+//! The rows of the padding tokens are never written.
+template <typename T>
+struct RingAttentionParams
+{
+    //! input buffer [numTokens, numHeads, headSize], required. Queries of the local shard, after the position
+    //! embedding.
+    T const* q{nullptr};
+    //! input buffers [numTokens, numKvHeads, headSize], required. Keys and values of shard kvShardIdx.
+    T const* k{nullptr};
+    T const* v{nullptr};
+    //! input buffer [batchSize + 1], required. Offsets of the sequences in the packed shards.
+    runtime::SizeType32 const* seqOffsets{nullptr};
+    //! input buffer [batchSize], required. Number of tokens of the whole sequences.
+    runtime::SizeType32 const* seqLengths{nullptr};
+
+    //! input/output buffer [numTokens, numHeads, headSize], required. Output over the keys attended so far, normalized
+    //! over those keys.
+    float* accOut{nullptr};
+    //! input/output buffer [numTokens, numHeads], required. Log-sum-exp of the scores of the keys attended so far.
+    float* accLse{nullptr};
+
+    runtime::SizeType32 batchSize{0};
+    //! Longest shard of a sequence, i.e. the largest seqOffsets[b + 1] - seqOffsets[b].
+    runtime::SizeType32 maxShardLength{0};
+    runtime::SizeType32 numHeads{0};
+    runtime::SizeType32 numKvHeads{0};
+    runtime::SizeType32 headSize{0};
+    runtime::SizeType32 qShardIdx{0};
+    runtime::SizeType32 kvShardIdx{0};
+    //! Whether a query only attends the keys at or before its position.
+    bool causal{true};
+    //! First step of the ring: the accumulators are written instead of merged.
+    bool firstStep{false};
+    //! Scale of the scores, usually 1 / sqrt(headSize).
+    float qkScale{1.f};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0 && maxShardLength > 0);
+        TLLM_CHECK(numKvHeads > 0 && numHeads % numKvHeads == 0);
+        TLLM_CHECK(0 < headSize && headSize <= RING_ATTENTION_MAX_HEAD_SIZE);
+        TLLM_CHECK(q && k && v);
+        TLLM_CHECK(seqOffsets && seqLengths);
+        TLLM_CHECK(accOut && accLse);
+    }
+};
+
+//! \brief Whether the step attends no key at all, i.e. the shard of the keys is after the one of the queries with
+//! causal attention. The accumulators are unchanged and the step can be skipped, except the first one.
+template <typename T>
+[[nodiscard]] bool isRingAttentionStepMasked(RingAttentionParams<T> const& params)
+{
+    return params.causal && params.kvShardIdx > params.qShardIdx;
+}
+
+//! \brief Attends the keys and values of one shard with the queries of the local shard, in tiles with the online
+//! softmax, and merges the result into the accumulators with the log-sum-exp.
+template <typename T>
+void invokeRingAttentionStep(RingAttentionParams<T> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
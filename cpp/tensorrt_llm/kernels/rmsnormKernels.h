@@ -31,5 +31,13 @@ void invokeGeneralRmsNorm(T* out, T const* input, T const* gamma, T const* beta,
     int const hidden_dim, cudaStream_t stream = 0, float const* scale = nullptr, float* dynamic_scale = nullptr,
     int8_t* out_quant = nullptr);
 
+// Adds the residual to the input and normalizes the sum as invokeGeneralRmsNorm, e.g. on the output of a GEMM.
+// residual_out receives the sum and may alias input. With out_quant and dynamic_scale set, only the per-token quantized
+// int8 output and its scales are written, ready for the next int8 GEMM, and out may be nullptr.
+template <typename T>
+void invokeGeneralAddRmsNorm(T* residual_out, T* out, T const* input, T const* residual, T const* gamma,
+    T const* beta, float const eps, int const tokens, int const hidden_dim, cudaStream_t stream = 0,
+    float const* scale = nullptr, float* dynamic_scale = nullptr, int8_t* out_quant = nullptr);
+
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/samplingFilterKernels.h"
+
+#include <cfloat>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+namespace
+{
+// Bisection steps of the typical set bound, the bound is found up to maxDeviation / 2^20
+constexpr SizeType32 kTypicalSearchIterations = 20;
+
+template <int BLOCK_SIZE, typename ReduceOp>
+__device__ float blockReduceBroadcast(float value, ReduceOp op)
+{
+    using BlockReduce = cub::BlockReduce<float, BLOCK_SIZE>;
+    __shared__ typename BlockReduce::TempStorage tempStorage;
+    __shared__ float sResult;
+
+    auto const result = BlockReduce(tempStorage).Reduce(value, op);
+    if (threadIdx.x == 0)
+    {
+        sResult = result;
+    }
+    __syncthreads();
+    auto const broadcast = sResult;
+    __syncthreads();
+    return broadcast;
+}
+
+__device__ __forceinline__ float deviation(float prob, float entropy)
+{
+    return fabsf(-__logf(prob) - entropy);
+}
+} // namespace
+
+template <typename T, int BLOCK_SIZE>
+__global__ void filterProbs(FilterProbsKernelParams<T> params)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const batchSlot = params.batchSlots != nullptr ? params.batchSlots[batchIdx] : batchIdx;
+
+    if (params.finishedInput != nullptr && params.finishedInput[batchSlot].isFinished())
+    {
+        return;
+    }
+
+    auto const minP = params.minPs != nullptr ? params.minPs[batchSlot] : 0.f;
+    auto const typicalP = params.typicalPs != nullptr ? params.typicalPs[batchSlot] : 1.f;
+    auto const eta = params.etas != nullptr ? params.etas[batchSlot] : 0.f;
+    bool const useTypical = typicalP < 1.f;
+    if (minP <= 0.f && !useTypical && eta <= 0.f)
+    {
+        return;
+    }
+
+    auto probs = params.probs + batchIdx * params.vocabSizePadded;
+    auto const vocabSize = params.vocabSize;
+
+    // Max prob and entropy of the distribution
+    float localMax = 0.f;
+    float localEntropy = 0.f;
+    for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+    {
+        auto const prob = static_cast<float>(probs[vi]);
+        localMax = fmaxf(localMax, prob);
+        localEntropy -= prob > 0.f ? prob * __logf(prob) : 0.f;
+    }
+    auto const maxProb = blockReduceBroadcast<BLOCK_SIZE>(localMax, cub::Max());
+    auto const entropy = blockReduceBroadcast<BLOCK_SIZE>(localEntropy, cub::Sum());
+
+    // Min-p and eta both remove tokens below a threshold, which never exceeds maxProb
+    auto threshold = minP * maxProb;
+    if (eta > 0.f)
+    {
+        threshold = fmaxf(threshold, fminf(eta, sqrtf(eta) * __expf(-entropy)));
+    }
+
+    // Typical-p keeps the tokens with deviation <= bound, the mass of the set grows with the bound
+    auto maxDeviation = FLT_MAX;
+    if (useTypical)
+    {
+        float localMaxDeviation = 0.f;
+        for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+        {
+            auto const prob = static_cast<float>(probs[vi]);
+            localMaxDeviation = prob > 0.f ? fmaxf(localMaxDeviation, deviation(prob, entropy)) : localMaxDeviation;
+        }
+        float lo = 0.f;
+        float hi = blockReduceBroadcast<BLOCK_SIZE>(localMaxDeviation, cub::Max());
+        for (SizeType32 it = 0; it < kTypicalSearchIterations; ++it)
+        {
+            auto const mid = 0.5f * (lo + hi);
+            float localMass = 0.f;
+            for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+            {
+                auto const prob = static_cast<float>(probs[vi]);
+                localMass += prob > 0.f && deviation(prob, entropy) <= mid ? prob : 0.f;
+            }
+            auto const mass = blockReduceBroadcast<BLOCK_SIZE>(localMass, cub::Sum());
+            (mass >= typicalP ? hi : lo) = mid;
+        }
+        maxDeviation = hi;
+    }
+
+    auto const isKept = [&](float prob)
+    { return prob > 0.f && prob >= threshold && (!useTypical || deviation(prob, entropy) <= maxDeviation); };
+
+    float localKeptMass = 0.f;
+    for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+    {
+        auto const prob = static_cast<float>(probs[vi]);
+        localKeptMass += isKept(prob) ? prob : 0.f;
+    }
+    auto const keptMass = blockReduceBroadcast<BLOCK_SIZE>(localKeptMass, cub::Sum());
+
+    if (keptMass > 0.f)
+    {
+        auto const invKeptMass = 1.f / keptMass;
+        for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+        {
+            auto const prob = static_cast<float>(probs[vi]);
+            probs[vi] = static_cast<T>(isKept(prob) ? prob * invKeptMass : 0.f);
+        }
+    }
+    else
+    {
+        // No token passes all filters, keep the most probable tokens
+        float localNumMax = 0.f;
+        for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+        {
+            localNumMax += static_cast<float>(probs[vi]) == maxProb ? 1.f : 0.f;
+        }
+        auto const invNumMax = 1.f / blockReduceBroadcast<BLOCK_SIZE>(localNumMax, cub::Sum());
+        for (auto vi = tid; vi < vocabSize; vi += BLOCK_SIZE)
+        {
+            probs[vi] = static_cast<T>(static_cast<float>(probs[vi]) == maxProb ? invNumMax : 0.f);
+        }
+    }
+}
+
+template <typename T>
+void invokeBatchFilterProbs(FilterProbsKernelParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    SizeType32 constexpr BLOCK_SIZE = 256;
+    filterProbs<T, BLOCK_SIZE><<<params.batchSize, BLOCK_SIZE, 0, stream>>>(params);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeBatchFilterProbs(FilterProbsKernelParams<float> const& params, cudaStream_t stream);
+template void invokeBatchFilterProbs(FilterProbsKernelParams<half> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/runtime/common.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+template <typename T>
+struct FilterProbsKernelParams
+{
+    //! input/output buffer [batchSize, vocabSizePadded], required. Probabilities of each token in the vocab.
+    //! Filtered tokens are set to 0 and the others renormalized in place.
+    T* probs{nullptr};
+
+    //! input buffer [maxBatchSize], optional. Min-p per request: tokens with prob < minP * maxProb are removed.
+    //! Disabled for minP <= 0.
+    float const* minPs{nullptr};
+    //! input buffer [maxBatchSize], optional. Typical-p per request: keeps the smallest set of tokens whose
+    //! -log(prob) is closest to the entropy and whose mass is at least typicalP. Disabled for typicalP >= 1.
+    float const* typicalPs{nullptr};
+    //! input buffer [maxBatchSize], optional. Eta per request: tokens with prob < min(eta, sqrt(eta) * exp(-entropy))
+    //! are removed. Disabled for eta <= 0.
+    float const* etas{nullptr};
+
+    //! input buffer[batchSize], optional. Indices of rows of data in memory pool.
+    runtime::SizeType32 const* batchSlots{nullptr};
+    //! input buffer [maxBatchSize], optional. Finished requests are not filtered.
+    FinishedState const* finishedInput{nullptr};
+
+    runtime::SizeType32 batchSize{-1};
+    runtime::SizeType32 maxBatchSize{-1};
+    runtime::SizeType32 vocabSize{-1};
+    runtime::SizeType32 vocabSizePadded{-1};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxBatchSize > 0);
+        TLLM_CHECK(maxBatchSize >= batchSize);
+        TLLM_CHECK(vocabSize > 0);
+        TLLM_CHECK(vocabSizePadded >= vocabSize);
+        TLLM_CHECK(probs);
+        TLLM_CHECK(minPs || typicalPs || etas);
+    }
+};
+
+//! \brief Removes tokens from the distribution of each request with min-p, typical-p
+//! (https://arxiv.org/abs/2202.00666) and eta (https://arxiv.org/abs/2210.15191) sampling, before top-k or top-p
+//! sampling. A token is kept if it passes every filter enabled for its request, each filter is computed on the
+//! input distribution. The most probable tokens are kept if no token passes. Requests without enabled filter are
+//! left untouched, so mixed batches are filtered in one launch.
+//! The typical set is found by bisection of the deviation bound, one pass over the probs per step.
+template <typename T>
+void invokeBatchFilterProbs(FilterProbsKernelParams<T> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
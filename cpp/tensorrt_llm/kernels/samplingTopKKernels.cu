@@ -135,10 +135,10 @@ template <typename T, int BLOCK_SIZE_, int BLOCKS_PER_BEAM_>
 __global__ void topKStage2Sampling(SizeType32 const* __restrict topKTmpIdBuf, T* topKTmpValBuf, TokenIdType** idsPtrs,
     TokenIdType* ids, SizeType32* sequenceLengths, FinishedState const* finishedInput, FinishedState* finishedOutput,
     float* cumLogProbs, float* outputLogProbs, SizeType32 maxTopK, SizeType32 const* topKs, float topP,
-    float const* topPs, curandState_t* curandState, TokenIdType const* endIds, SizeType32 vocabSize,
-    bool const* skipDecode, SizeType32 const* batchSlots, SizeType32 maxBatchSize, bool normalizeLogProbs,
-    bool logitHasProbs, SizeType32 const* tokensPerStep, SizeType32 maxTokensPerStep, SizeType32 maxSeqLen,
-    bool returnAllTopK)
+    float const* topPs, curandState_t* curandState, uint64_t const* randomSeeds, SizeType32 const* randomSteps,
+    TokenIdType const* endIds, SizeType32 vocabSize, bool const* skipDecode, SizeType32 const* batchSlots,
+    SizeType32 maxBatchSize, bool normalizeLogProbs, bool logitHasProbs, SizeType32 const* tokensPerStep,
+    SizeType32 maxTokensPerStep, SizeType32 maxSeqLen, bool returnAllTopK)
 {
     bool const IS_FP16 = std::is_same<T, half>::value;
     T const MAX_T_VAL = (IS_FP16) ? HALF_FLT_MAX : FLT_MAX;
@@ -219,7 +219,17 @@ __global__ void topKStage2Sampling(SizeType32 const* __restrict topKTmpIdBuf, T*
 
     if (tid == 0)
     {
-        auto randNum = static_cast<float>(curand_uniform(curandState + batchSlot) * probThreshold * sSum);
+        auto const curSeqLen = sequenceLengths == nullptr ? 0 : sequenceLengths[batchSlot];
+        // All the tokens are returned without a draw
+        float randNum = 0.f;
+        if (!returnAllTopK)
+        {
+            auto const uniform = curandState != nullptr
+                ? curand_uniform(curandState + batchSlot)
+                : philoxUniform(randomSeeds[batchSlot], randomSteps != nullptr ? randomSteps[batchSlot] : curSeqLen,
+                    tokenIdx);
+            randNum = static_cast<float>(uniform * probThreshold * sSum);
+        }
         auto* outputIdsRequestPtr = idsPtrs == nullptr ? ids + batchSlot * maxSeqLen : idsPtrs[batchSlot];
         for (SizeType32 ki = 0; ki < k; ki++)
         {
@@ -233,7 +243,6 @@ __global__ void topKStage2Sampling(SizeType32 const* __restrict topKTmpIdBuf, T*
                 auto outputId = idx != -1
                     ? topKTmpIdBuf[(batchIdx * maxTokensPerStep + tokenIdx) * stride + idx] % vocabSize
                     : vocabSize - 1;
-                auto const curSeqLen = sequenceLengths == nullptr ? 0 : sequenceLengths[batchSlot];
                 auto const outIdx = returnAllTopK ? tokenIdx * maxTopK + ki : curSeqLen + tokenIdx;
                 outputIdsRequestPtr[outIdx] = outputId;
                 // cum log prob is not supported with returnAllTopK
@@ -298,7 +307,8 @@ __global__ void topKStage2Sampling(SizeType32 const* __restrict topKTmpIdBuf, T*
                 <<<grid, block, K_MAX * sizeof(SizeType32) + K_MAX * sizeof(float), stream>>>(topKTmpIdBuf,            \
                     topKTmpValBuf, params.outputIdsPtrs, params.outputIds, params.sequenceLengths,                     \
                     params.finishedInput, params.finishedOutput, params.cumLogProbs, params.outputLogProbs,            \
-                    params.maxTopK, params.topKs, params.maxTopP, params.topPs, params.curandState, params.endIds,     \
+                    params.maxTopK, params.topKs, params.maxTopP, params.topPs, params.curandState,                    \
+                    params.randomSeeds, params.randomSteps, params.endIds,                                             \
                     params.vocabSizePadded, params.skipDecode, params.batchSlots, params.maxBatchSize,                 \
                     params.normalizeLogProbs, params.logitsHasProbs, params.tokensPerStep, params.maxTokensPerStep,    \
                     params.maxSeqLen, params.returnAllTopK);                                                           \
@@ -328,8 +338,10 @@ void invokeBatchTopKSampling(TopKSamplingKernelParams<T> const& params, cudaStre
     auto topKTmpIdBuf = static_cast<SizeType32*>(alignedPointers[1]);
     auto topKTmpValBuf = static_cast<T*>(alignedPointers[2]);
 
+    // The block sizes decide how the vocab is split between the threads, pin them to the largest configuration to
+    // make the result of a request independent of the largest K of the batch
     SizeType32 logMaxTopK{0};
-    SizeType32 recursor{params.maxTopK - 1};
+    SizeType32 recursor{(params.batchInvariant ? TOP_K_MAX : params.maxTopK) - 1};
     while (recursor >>= 1)
     {
         ++logMaxTopK;
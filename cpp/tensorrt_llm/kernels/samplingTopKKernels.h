@@ -87,8 +87,13 @@ struct TopKSamplingKernelParams
     //! Ignored if nullptr.
     float* outputLogProbs{nullptr};
 
-    //! input buffer [maxBatchSize]. Initialized curand states
+    //! input buffer [maxBatchSize], optional. Initialized curand states. If nullptr, randomSeeds are used.
     curandState_t* curandState{nullptr};
+    //! input buffer [maxBatchSize], optional. Seeds of the stateless random numbers, see philoxUniform.
+    //! Required if curandState is nullptr, unless returnAllTopK is set.
+    uint64_t const* randomSeeds{nullptr};
+    //! input buffer [maxBatchSize], optional. Steps of the stateless random numbers, sequenceLengths if nullptr.
+    runtime::SizeType32 const* randomSteps{nullptr};
     //! input buffer [maxBatchSize]. K for topK sampling per request.
     //! Supported K is in range [1; 1024]. Where K=1 is greedy search.
     //! If nullptr maxTopK is used for all requests.
@@ -113,6 +118,9 @@ struct TopKSamplingKernelParams
     bool logitsHasProbs{false};
     //! flag to return all selectedTopK results
     bool returnAllTopK{false};
+    //! when set to True the kernel configuration does not depend on maxTopK, so that the tokens of a request do not
+    //! depend on the other requests of the batch
+    bool batchInvariant{false};
 
     void checkParams() const
     {
@@ -136,7 +144,7 @@ struct TopKSamplingKernelParams
         }
 
         TLLM_CHECK(workspace);
-        TLLM_CHECK(curandState);
+        TLLM_CHECK(curandState || randomSeeds || returnAllTopK);
 
         TLLM_CHECK(maxTokensPerStep != 1 || returnAllTopK || sequenceLengths);
         TLLM_CHECK(maxTokensPerStep != 1 || returnAllTopK || endIds);
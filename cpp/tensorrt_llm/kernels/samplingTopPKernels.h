@@ -62,9 +62,12 @@ struct TopPSamplingKernelParams
     //! output buffer [maxBatchSize], optional. Log probs is the probability induced by the TopP sampling.
     //! I.e., log_prob = log P(i | i is in vocab).
     float* outputLogProbs{nullptr};
-    //! input buffer [maxBatchSize], required. Curand states properly initialized using
-    //! invokeCurandInitialize per request.
+    //! input buffer [maxBatchSize], optional. Curand states properly initialized using
+    //! invokeCurandInitialize per request. If nullptr, randomSeeds are used.
     curandState_t* curandState{nullptr};
+    //! input buffer [maxBatchSize], optional. Seeds of the stateless random numbers drawn at the sequence length of
+    //! each request, see philoxUniform. Required if curandState is nullptr.
+    uint64_t const* randomSeeds{nullptr};
 
     //! The appropriate block configuration calculated based on the number of multiprocessors, occupancy,
     //! batchSize and vocabSizePadded. Required for AirTopP
@@ -87,7 +90,7 @@ struct TopPSamplingKernelParams
         TLLM_CHECK(outputIds);
         TLLM_CHECK(workspace);
         TLLM_CHECK(sequenceLength);
-        TLLM_CHECK(curandState);
+        TLLM_CHECK(curandState || randomSeeds);
         TLLM_CHECK(topPs);
 
         TLLM_CHECK(((finishedOutput == nullptr) ^ (endIds == nullptr)) == 0);
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <cuda_runtime_api.h>
 
 #include <cooperative_groups/memcpy_async.h>
@@ -67,8 +68,17 @@ __device__ void convertAndStore(__nv_bfloat16* output, float input)
 
 #pragma nv_diag_suppress static_var_with_dynamic_init
 
-template <typename input_t, typename weight_t, int DSTATE = 16, int CHANNELS_PER_BLOCK = 128, int STAGES = 12,
-    int SEQ_UNROLL = 6>
+// A long sequence is scanned in chunks: each chunk from a zero state, then the state before each chunk from the
+// states and decays of the chunks before it, then each chunk again from the state before it.
+enum class ScanPass
+{
+    kFULL,
+    kCHUNK_LOCAL,
+    kCHUNK_FINAL,
+};
+
+template <typename input_t, typename weight_t, ScanPass PASS = ScanPass::kFULL, int DSTATE = 16,
+    int CHANNELS_PER_BLOCK = 128, int STAGES = 12, int SEQ_UNROLL = 6>
 __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBase params)
 {
     input_t* output = reinterpret_cast<input_t*>(params.out_ptr);
@@ -115,6 +125,22 @@ __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBa
         start_token_idx = sample * params.max_seqlen;
         num_tokens = params.last_token_ids_ptr[sample];
     }
+
+    // Chunked passes: the tokens of the chunk of this block
+    float* chunk_states = reinterpret_cast<float*>(params.chunk_states_ptr);
+    size_t const chunk_offset
+        = static_cast<size_t>(sample * params.num_chunks + blockIdx.z) * (DSTATE + 1) * num_channels;
+    bool is_last_chunk = true;
+    if constexpr (PASS != ScanPass::kFULL)
+    {
+        int const token_begin = blockIdx.z * params.chunk_size;
+        // The first chunk of an empty sequence still writes its state
+        if (token_begin >= num_tokens && (PASS == ScanPass::kCHUNK_LOCAL || blockIdx.z > 0))
+            return;
+        is_last_chunk = token_begin + params.chunk_size >= num_tokens;
+        start_token_idx += token_begin;
+        num_tokens = min(num_tokens - token_begin, params.chunk_size);
+    }
     int const seq_loops = (num_tokens + SEQ_UNROLL - 1) / SEQ_UNROLL;
 
     int const input_matrix_row_id = start_token_idx;
@@ -206,11 +232,23 @@ __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBa
         float A_reg[DSTATE];
         for (int i = 0; i < DSTATE; i++)
         {
-            state_reg[i] = 0.f;
+            if constexpr (PASS == ScanPass::kCHUNK_FINAL)
+            {
+                // The state before the chunk, see selective_scan_chunk_state_kernel
+                state_reg[i] = chunk_states[chunk_offset + i * num_channels + channel];
+            }
+            else
+            {
+                state_reg[i] = PASS == ScanPass::kFULL && params.load_initial_state
+                    ? toFloat(state[slot_idx * num_channels * DSTATE + i * num_channels + channel])
+                    : 0.f;
+            }
             A_reg[i] = toFloat(A[i * num_channels + channel]);
         }
         float dt_bias_reg = dt_bias[channel];
         float D_reg = D ? D[channel] : 0.f;
+        // The decay of the chunk is exp(A * dt_sum)
+        float dt_sum = 0.f;
 
         cuda::pipeline pipeline = cuda::make_pipeline(block, &pipeline_state, cuda::pipeline_role::consumer);
         int stage = 0;
@@ -229,6 +267,10 @@ __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBa
                 {
                     dt_b_sp = dt_b <= 20.f ? __logf(1.f + __expf(dt_b)) : dt_b; // softplus
                 }
+                if constexpr (PASS == ScanPass::kCHUNK_LOCAL)
+                {
+                    dt_sum += dt_b_sp;
+                }
                 float my_x = toFloat(sh_x[stage][threadIdx.x]);
                 float Dx = my_x * D_reg;
                 float dtx = dt_b_sp * my_x;
@@ -286,16 +328,19 @@ __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBa
                     }
                 }
 
-                if (z)
+                if constexpr (PASS != ScanPass::kCHUNK_LOCAL)
                 {
-                    float enz = __expf(0.f - my_z);
-                    enz += 1.0;
-                    float sig_z = __fdividef(1.f, enz);
-                    float silu_z = my_z * sig_z;
-                    out *= silu_z;
+                    if (z)
+                    {
+                        float enz = __expf(0.f - my_z);
+                        enz += 1.0;
+                        float sig_z = __fdividef(1.f, enz);
+                        float silu_z = my_z * sig_z;
+                        out *= silu_z;
+                    }
+                    input_t* my_output = &output[input_matrix_row_id * num_channels + token_id * num_channels];
+                    convertAndStore(&my_output[channel], out);
                 }
-                input_t* my_output = &output[input_matrix_row_id * num_channels + token_id * num_channels];
-                convertAndStore(&my_output[channel], out);
 
                 stage++;
                 if (stage >= STAGES)
@@ -303,16 +348,101 @@ __launch_bounds__(256, 1) __global__ void selective_scan_loop_kernel(SSMParamsBa
             }
             pipeline.consumer_release();
         }
-        // Write the new state back out to the cache
-        for (int i = 0; i < DSTATE; i++)
+        if constexpr (PASS == ScanPass::kCHUNK_LOCAL)
+        {
+            for (int i = 0; i < DSTATE; i++)
+            {
+                chunk_states[chunk_offset + i * num_channels + channel] = state_reg[i];
+            }
+            chunk_states[chunk_offset + DSTATE * num_channels + channel] = dt_sum;
+        }
+        else if (is_last_chunk)
         {
-            input_t* my_state = &state[slot_idx * num_channels * DSTATE];
-            int offset = i * num_channels + channel;
-            convertAndStore(&my_state[offset], state_reg[i]);
+            // Write the new state back out to the cache
+            for (int i = 0; i < DSTATE; i++)
+            {
+                input_t* my_state = &state[slot_idx * num_channels * DSTATE];
+                int offset = i * num_channels + channel;
+                convertAndStore(&my_state[offset], state_reg[i]);
+            }
         }
     }
 }
 
+// Replaces the state of each chunk from a zero state by the state before the chunk, scanning the chunks of a sequence
+// in order. One thread per sample, state and channel.
+template <typename input_t, typename weight_t, int DSTATE = 16>
+__global__ void selective_scan_chunk_state_kernel(SSMParamsBase params)
+{
+    input_t const* state = reinterpret_cast<input_t const*>(params.x_ptr);
+    weight_t const* A = reinterpret_cast<weight_t const*>(params.A_ptr);
+    float* chunk_states = reinterpret_cast<float*>(params.chunk_states_ptr);
+    int const num_channels = params.dim;
+
+    int const channel = blockIdx.x * blockDim.x + threadIdx.x;
+    int const i = blockIdx.y;
+    int const sample = blockIdx.z;
+    if (channel >= num_channels)
+        return;
+
+    int const slot_idx = params.slot_mapping_ptr == nullptr ? sample : params.slot_mapping_ptr[sample];
+    int num_tokens;
+    if (params.remove_padding)
+    {
+        int start_token_idx = sample == 0 ? 0 : params.last_token_ids_ptr[sample - 1];
+        num_tokens = params.last_token_ids_ptr[sample] - start_token_idx;
+    }
+    else
+    {
+        num_tokens = params.last_token_ids_ptr[sample];
+    }
+    int const num_chunks = (num_tokens + params.chunk_size - 1) / params.chunk_size;
+
+    float const A_reg = toFloat(A[i * num_channels + channel]);
+    float h = params.load_initial_state ? toFloat(state[slot_idx * num_channels * DSTATE + i * num_channels + channel])
+                                        : 0.f;
+    for (int c = 0; c < num_chunks; c++)
+    {
+        size_t const chunk_offset = static_cast<size_t>(sample * params.num_chunks + c) * (DSTATE + 1) * num_channels;
+        float const local = chunk_states[chunk_offset + i * num_channels + channel];
+        float const dt_sum = chunk_states[chunk_offset + DSTATE * num_channels + channel];
+        chunk_states[chunk_offset + i * num_channels + channel] = h;
+        h = __expf(A_reg * dt_sum) * h + local;
+    }
+}
+
+namespace
+{
+int constexpr kScanChannelsPerBlock = 128;
+// Split until the chunks of the batch fill the SMs this many times, without chunks below kMinChunkSize tokens.
+int constexpr kChunkBlocksPerSM = 2;
+int constexpr kMinChunkSize = 256;
+} // namespace
+
+int getSelectiveScanNumChunks(int batch, int dim, int maxSeqLen)
+{
+    int const channelBlocks = tensorrt_llm::common::divUp(dim, kScanChannelsPerBlock);
+    int const numSMs = tensorrt_llm::common::getMultiProcessorCount();
+    if (batch * channelBlocks >= numSMs)
+    {
+        return 1;
+    }
+    int const targetChunks = tensorrt_llm::common::divUp(kChunkBlocksPerSM * numSMs, batch * channelBlocks);
+    int const maxChunks = tensorrt_llm::common::divUp(maxSeqLen, kMinChunkSize);
+    return std::max(1, std::min(targetChunks, maxChunks));
+}
+
+size_t getSelectiveScanWorkspaceSize(int maxBatch, int dim, int dstate)
+{
+    // Sequences are only split when batch * channelBlocks < numSMs, so batch * numChunks is at most
+    // kChunkBlocksPerSM * numSMs / channelBlocks + batch.
+    int const channelBlocks = tensorrt_llm::common::divUp(dim, kScanChannelsPerBlock);
+    int const numSMs = tensorrt_llm::common::getMultiProcessorCount();
+    size_t const maxSplitBatch = std::min<size_t>(maxBatch, tensorrt_llm::common::divUp(numSMs, channelBlocks));
+    size_t const maxChunks = tensorrt_llm::common::divUp(kChunkBlocksPerSM * numSMs, channelBlocks) + maxSplitBatch;
+    return maxChunks * (dstate + 1) * dim * sizeof(float);
+}
+
 template <typename input_t, typename weight_t>
 void invokeSelectiveScan(SSMParamsBase& params, cudaStream_t stream)
 {
@@ -323,11 +453,21 @@ void invokeSelectiveScan(SSMParamsBase& params, cudaStream_t stream)
     TLLM_CHECK(params.is_variable_C);
     TLLM_CHECK(params.dstate == 16);
 
-    int const threads = 128;
+    int const threads = kScanChannelsPerBlock;
     int const blocks = (channels + threads - 1) / threads;
     dim3 block(threads, 2);
     dim3 grid(blocks, samples);
     TLLM_CHECK((channels % block.x) == 0);
+    if (params.num_chunks > 1)
+    {
+        TLLM_CHECK(params.chunk_states_ptr != nullptr && params.chunk_size > 0);
+        grid.z = params.num_chunks;
+        selective_scan_loop_kernel<input_t, weight_t, ScanPass::kCHUNK_LOCAL><<<grid, block, 0, stream>>>(params);
+        dim3 stateGrid(blocks, params.dstate, samples);
+        selective_scan_chunk_state_kernel<input_t, weight_t><<<stateGrid, threads, 0, stream>>>(params);
+        selective_scan_loop_kernel<input_t, weight_t, ScanPass::kCHUNK_FINAL><<<grid, block, 0, stream>>>(params);
+        return;
+    }
     selective_scan_loop_kernel<input_t, weight_t><<<grid, block, 0, stream>>>(params);
 }
 
@@ -343,7 +483,39 @@ INSTANTIATE_SELECTIVE_SCAN_DATA_TYPE(__nv_bfloat16, float);
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-template <typename input_t, typename weight_t, int DSTATE = 16, int CHANNELS_PER_BLOCK = 128>
+// Loads or stores N consecutive values with one vector access, ptr must be aligned to N values.
+template <typename T, int N>
+struct __align__(sizeof(T) * N) PackedValues
+{
+    T values[N];
+};
+
+template <typename T, int N>
+__device__ void packedLoadToFloat(T const* ptr, float* dst)
+{
+    PackedValues<T, N> const packed = *reinterpret_cast<PackedValues<T, N> const*>(ptr);
+#pragma unroll
+    for (int c = 0; c < N; c++)
+    {
+        dst[c] = toFloat(packed.values[c]);
+    }
+}
+
+template <typename T, int N>
+__device__ void packedStoreFloat(float const* src, T* ptr)
+{
+    PackedValues<T, N> packed;
+#pragma unroll
+    for (int c = 0; c < N; c++)
+    {
+        convertAndStore(&packed.values[c], src[c]);
+    }
+    *reinterpret_cast<PackedValues<T, N>*>(ptr) = packed;
+}
+
+// One token of each sample. Each thread updates CHANNELS_PER_THREAD consecutive channels with vector accesses, one
+// state row at a time, so that the state is read and written once with wide accesses.
+template <typename input_t, typename weight_t, int DSTATE = 16, int CHANNELS_PER_THREAD = 4>
 __launch_bounds__(128, 2) __global__ void selective_scan_update_kernel(SSMParamsBase params)
 {
 
@@ -360,7 +532,7 @@ __launch_bounds__(128, 2) __global__ void selective_scan_update_kernel(SSMParams
     bool dt_softplus = params.delta_softplus;
     int num_channels = params.dim;
 
-    int const channel = blockIdx.x * blockDim.x + threadIdx.x;
+    int const channel = (blockIdx.x * blockDim.x + threadIdx.x) * CHANNELS_PER_THREAD;
     if (channel >= num_channels)
         return;
     int const sample = blockIdx.y;
@@ -372,60 +544,62 @@ __launch_bounds__(128, 2) __global__ void selective_scan_update_kernel(SSMParams
     input_t* my_state = &state[slot_idx * num_channels * DSTATE];
     input_t* my_output = &output[sample * num_channels];
 
-    float rA[DSTATE];
-    float rB[DSTATE];
-    float rC[DSTATE];
-
-    float rState[DSTATE];
+    float my_x[CHANNELS_PER_THREAD], my_dt[CHANNELS_PER_THREAD], my_z[CHANNELS_PER_THREAD];
+    float my_dt_bias[CHANNELS_PER_THREAD], my_D[CHANNELS_PER_THREAD], out[CHANNELS_PER_THREAD];
+    packedLoadToFloat<input_t, CHANNELS_PER_THREAD>(&x[sample * num_channels + channel], my_x);
+    packedLoadToFloat<input_t, CHANNELS_PER_THREAD>(&dt[sample * num_channels + channel], my_dt);
+    if (z)
+        packedLoadToFloat<input_t, CHANNELS_PER_THREAD>(&z[sample * num_channels + channel], my_z);
+    if (dt_bias)
+        packedLoadToFloat<weight_t, CHANNELS_PER_THREAD>(&dt_bias[channel], my_dt_bias);
+    if (D)
+        packedLoadToFloat<weight_t, CHANNELS_PER_THREAD>(&D[channel], my_D);
 
+    float dt_b_sp[CHANNELS_PER_THREAD];
 #pragma unroll
-    for (int i = 0; i < DSTATE; i++)
-    {
-        rA[i] = toFloat(A[i * num_channels + channel]);
-        rB[i] = toFloat(B[sample * bc_cols + b_offset + i]);
-        rC[i] = toFloat(C[sample * bc_cols + c_offset + i]);
-        rState[i] = toFloat(my_state[i * num_channels + channel]);
-    }
-
-    float my_x, my_dt, my_z, my_dt_bias, my_D;
-    my_x = toFloat(x[sample * num_channels + channel]);
-    my_dt = toFloat(dt[sample * num_channels + channel]);
-    my_z = z ? toFloat(z[sample * num_channels + channel]) : 0.f;
-    my_dt_bias = dt_bias ? toFloat(dt_bias[channel]) : 0.f;
-    my_D = D ? toFloat(D[channel]) : 0.f;
-
-    float dt_b = my_dt + my_dt_bias;
-    float dt_b_sp;
-    if (dt_softplus)
+    for (int c = 0; c < CHANNELS_PER_THREAD; c++)
     {
-        // dt_b_sp = dt_b <= 20.f ? logf(1.f + expf(dt_b)) : dt_b; // softplus
-        dt_b_sp = dt_b <= 20.f ? __logf(1.f + __expf(dt_b)) : dt_b; // softplus
+        float dt_b = my_dt[c] + (dt_bias ? my_dt_bias[c] : 0.f);
+        // softplus
+        dt_b_sp[c] = dt_softplus && dt_b <= 20.f ? __logf(1.f + __expf(dt_b)) : dt_b;
+        out[c] = D ? my_D[c] * my_x[c] : 0.f;
     }
 
-    float out = D ? my_D * my_x : 0.f;
-
 #pragma unroll
     for (int i = 0; i < DSTATE; i++)
     {
-        // float dA = expf(rA[i] * dt_b_sp);
-        float dA = __expf(rA[i] * dt_b_sp);
-        float dB = rB[i] * dt_b_sp;
-        float sdA = rState[i] * dA;
-        float dBx = dB * my_x;
-        float newState = sdA + dBx;
-        convertAndStore(&my_state[i * num_channels + channel], newState); // Write the new state back out to the cache
-        out += newState * rC[i];
+        float rB = toFloat(B[sample * bc_cols + b_offset + i]);
+        float rC = toFloat(C[sample * bc_cols + c_offset + i]);
+        float rA[CHANNELS_PER_THREAD];
+        float rState[CHANNELS_PER_THREAD];
+        packedLoadToFloat<weight_t, CHANNELS_PER_THREAD>(&A[i * num_channels + channel], rA);
+        packedLoadToFloat<input_t, CHANNELS_PER_THREAD>(&my_state[i * num_channels + channel], rState);
+#pragma unroll
+        for (int c = 0; c < CHANNELS_PER_THREAD; c++)
+        {
+            float dA = __expf(rA[c] * dt_b_sp[c]);
+            float dB = rB * dt_b_sp[c];
+            float sdA = rState[c] * dA;
+            float dBx = dB * my_x[c];
+            rState[c] = sdA + dBx;
+            out[c] += rState[c] * rC;
+        }
+        // Write the new state back out to the cache
+        packedStoreFloat<input_t, CHANNELS_PER_THREAD>(rState, &my_state[i * num_channels + channel]);
     }
 
     if (z)
     {
-        // float sig_z = 1.0 / (1.0 + exp(0.f - my_z));
-        float sig_z = __fdividef(1.f, (1.f + __expf(0.f - my_z)));
-        float silu_z = my_z * sig_z;
-        out *= silu_z;
+#pragma unroll
+        for (int c = 0; c < CHANNELS_PER_THREAD; c++)
+        {
+            float sig_z = __fdividef(1.f, (1.f + __expf(0.f - my_z[c])));
+            float silu_z = my_z[c] * sig_z;
+            out[c] *= silu_z;
+        }
     }
 
-    convertAndStore(&my_output[channel], out);
+    packedStoreFloat<input_t, CHANNELS_PER_THREAD>(out, &my_output[channel]);
 }
 
 template <typename input_t, typename weight_t>
@@ -434,15 +608,24 @@ void invokeSelectiveScanUpdate(SSMParamsBase& params, cudaStream_t stream)
     int samples = params.batch;
     int channels = params.dim;
 
-    int const threads = 128;
-    int const blocks = (channels + threads - 1) / threads;
-    dim3 block(threads, 1);
-    dim3 grid(blocks, samples);
-
     TLLM_CHECK(params.is_variable_B);
     TLLM_CHECK(params.is_variable_C);
     TLLM_CHECK(params.dstate == 16);
-    selective_scan_update_kernel<input_t, weight_t><<<grid, block, 0, stream>>>(params);
+
+    int const threads = 128;
+    int const channelsPerThread = 4;
+    if (channels % channelsPerThread == 0)
+    {
+        int const blocks = (channels + threads * channelsPerThread - 1) / (threads * channelsPerThread);
+        dim3 grid(blocks, samples);
+        selective_scan_update_kernel<input_t, weight_t, 16, channelsPerThread><<<grid, threads, 0, stream>>>(params);
+    }
+    else
+    {
+        int const blocks = (channels + threads - 1) / threads;
+        dim3 grid(blocks, samples);
+        selective_scan_update_kernel<input_t, weight_t, 16, 1><<<grid, threads, 0, stream>>>(params);
+    }
 }
 
 #define INSTANTIATE_SELECTIVE_SCAN_UPDATE_DATA_TYPE(input_t, weight_t)                                                 \
@@ -60,10 +60,26 @@ struct SSMParamsBase
     void* __restrict__ z_ptr;
     int const* __restrict__ last_token_ids_ptr;
     int const* __restrict__ slot_mapping_ptr;
+    // The context phase starts from the state in the slot instead of zeros. Used to resume from a restored prefix, the
+    // state of new requests must be zero.
+    bool load_initial_state;
+
+    // Context phase only: the sequences are split in num_chunks chunks of chunk_size tokens, scanned in parallel, see
+    // getSelectiveScanNumChunks. chunk_states_ptr is a workspace of getSelectiveScanWorkspaceSize bytes.
+    int num_chunks;
+    int chunk_size;
+    void* __restrict__ chunk_states_ptr;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Number of chunks the context phase splits the sequences of at most maxSeqLen tokens into. Long sequences of a small
+// batch are split so that the scan fills the GPU, 1 when the batch and channels already do.
+int getSelectiveScanNumChunks(int batch, int dim, int maxSeqLen);
+
+// Workspace of the chunked context phase, for any batch up to maxBatch.
+size_t getSelectiveScanWorkspaceSize(int maxBatch, int dim, int dstate);
+
 template <typename input_t, typename weight_t>
 void invokeSelectiveScan(SSMParamsBase& params, cudaStream_t stream);
 
@@ -202,8 +202,8 @@ __global__ void fillContextBuffers(FillContextExplicitDraftTokensParams<T> param
 
     if (threadIdx.x == 0)
     {
-        // Generate new random data for sampling.
-        params.randDataSample[batchSlot] = static_cast<T>(curand_uniform(params.curandState + batchSlot));
+        // Generate new random data for sampling, before the first step.
+        params.randDataSample[batchSlot] = static_cast<T>(philoxUniform(params.randomSeeds[batchSlot], 0, 0));
 
         // Copy temperature.
         params.outputTemperatures[batchSlot] = __frcp_rn(params.inputTemperatures[batchSlot]);
@@ -311,7 +311,8 @@ __global__ void extractExplicitDraftTokens(ExtractExplicitDraftTokensParams<T> p
     {
         // Generate new random data for token verification.
         auto const offset = flat_index2(batchSlot, ti, params.numPaths * (params.maxPathLength - 1));
-        params.randDataVerification[offset] = static_cast<T>(curand_uniform(params.curandState + batchSlot));
+        params.randDataVerification[offset]
+            = static_cast<T>(philoxUniform(params.randomSeeds[batchSlot], curSeqLen, ti + 1));
     }
 
     // When all threads are done.
@@ -334,7 +335,7 @@ __global__ void extractExplicitDraftTokens(ExtractExplicitDraftTokensParams<T> p
         params.outputGenerationLengths[batchSlot] = numNextDraftTokens;
 
         // Generate new random data for sampling.
-        params.randDataSample[batchSlot] = static_cast<T>(curand_uniform(params.curandState + batchSlot));
+        params.randDataSample[batchSlot] = static_cast<T>(philoxUniform(params.randomSeeds[batchSlot], curSeqLen, 0));
 
         // Increase seqLen by accepted len.
         params.sequenceLengths[batchSlot] = curSeqLen + bestPathLength;
@@ -568,4 +569,196 @@ void invokeCopyProbs(PackExplicitDraftTokensParams<T> const& params, cudaStream_
 
 template void invokeCopyProbs(PackExplicitDraftTokensParams<float> const& params, cudaStream_t stream);
 template void invokeCopyProbs(PackExplicitDraftTokensParams<half> const& params, cudaStream_t stream);
+
+namespace
+{
+// Order of the candidates of the dynamic draft tree: higher score first, lower index first within a score.
+__device__ bool isRankedBefore(float lhsScore, SizeType32 lhsIdx, float rhsScore, SizeType32 rhsIdx)
+{
+    return lhsScore > rhsScore || (lhsScore == rhsScore && lhsIdx < rhsIdx);
+}
+
+__global__ void buildDynamicDraftTree(BuildDynamicDraftTreeParams params)
+{
+    auto const bid = static_cast<SizeType32>(blockIdx.x);
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const blockSize = static_cast<SizeType32>(blockDim.x);
+    auto const maxNumCandidates = params.maxNumCandidates;
+    auto const numCandidates = min(params.numCandidates[bid], maxNumCandidates);
+    auto const maxDepth = params.maxPathLength - 1;
+    auto const maxDecodingTokens = params.numPaths * maxDepth + 1;
+    auto const numPackedMasks = divUp(maxDecodingTokens, 32);
+
+    auto const* candidateTokens = params.candidateTokens + bid * maxNumCandidates;
+    auto const* candidateParents = params.candidateParents + bid * maxNumCandidates;
+    auto const* candidateLogProbs = params.candidateLogProbs + bid * maxNumCandidates;
+    auto const goldenToken = params.goldenTokens[bid];
+
+    extern __shared__ char smem[];
+    auto* scores = reinterpret_cast<float*>(smem);
+    // Depth 0 marks candidates that can't be in the tree.
+    auto* depths = reinterpret_cast<SizeType32*>(scores + maxNumCandidates);
+    auto* ranks = depths + maxNumCandidates;
+    auto* leafRanks = ranks + maxNumCandidates;
+    auto* newIndices = leafRanks + maxNumCandidates;
+    auto* isSelected = reinterpret_cast<uint8_t*>(newIndices + maxNumCandidates);
+    auto* isParent = isSelected + maxNumCandidates;
+    auto* isKept = isParent + maxNumCandidates;
+    __shared__ SizeType32 numKept;
+
+    if (tid == 0)
+    {
+        numKept = 0;
+    }
+    // Score and depth of each candidate, from its path to the golden token.
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        float score = 0.f;
+        SizeType32 depth = 0;
+        bool valid = true;
+        for (auto node = ci; node >= 0 && valid;)
+        {
+            score += fminf(candidateLogProbs[node], 0.f);
+            ++depth;
+            auto const parent = candidateParents[node];
+            valid = depth <= maxDepth && parent < node;
+            node = parent;
+        }
+        scores[ci] = score;
+        depths[ci] = valid ? depth : 0;
+        isSelected[ci] = 0;
+        isParent[ci] = 0;
+        isKept[ci] = 0;
+    }
+    __syncthreads();
+
+    // Select the best candidates. Parents are always ranked before their children.
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        if (depths[ci] == 0)
+        {
+            continue;
+        }
+        SizeType32 rank = 0;
+        for (SizeType32 cj = 0; cj < numCandidates; ++cj)
+        {
+            rank += (depths[cj] > 0 && isRankedBefore(scores[cj], cj, scores[ci], ci)) ? 1 : 0;
+        }
+        ranks[ci] = rank;
+        isSelected[ci] = rank < maxDecodingTokens - 1;
+    }
+    __syncthreads();
+
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        if (isSelected[ci] && candidateParents[ci] >= 0)
+        {
+            isParent[candidateParents[ci]] = 1;
+        }
+    }
+    __syncthreads();
+
+    // Keep the best leaves with their ancestors, one path per leaf.
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        leafRanks[ci] = params.numPaths;
+        if (!isSelected[ci] || isParent[ci])
+        {
+            continue;
+        }
+        SizeType32 leafRank = 0;
+        for (SizeType32 cj = 0; cj < numCandidates; ++cj)
+        {
+            leafRank += (isSelected[cj] && !isParent[cj] && ranks[cj] < ranks[ci]) ? 1 : 0;
+        }
+        leafRanks[ci] = leafRank;
+        if (leafRank < params.numPaths)
+        {
+            for (auto node = ci; node >= 0; node = candidateParents[node])
+            {
+                isKept[node] = 1;
+            }
+        }
+    }
+    __syncthreads();
+
+    // Tokens of the tree in rank order behind the golden token.
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        if (!isKept[ci])
+        {
+            continue;
+        }
+        SizeType32 newIdx = 1;
+        for (SizeType32 cj = 0; cj < numCandidates; ++cj)
+        {
+            newIdx += (isKept[cj] && ranks[cj] < ranks[ci]) ? 1 : 0;
+        }
+        newIndices[ci] = newIdx;
+        atomicAdd(&numKept, 1);
+    }
+
+    auto const pathsOffset = bid * params.numPaths * params.maxPathLength;
+    for (auto ti = tid; ti < params.numPaths * params.maxPathLength; ti += blockSize)
+    {
+        auto const isRoot = ti % params.maxPathLength == 0;
+        params.outputDraftTokens[pathsOffset + ti] = isRoot ? goldenToken : -1;
+        params.outputDraftIndices[pathsOffset + ti] = isRoot ? 0 : -1;
+    }
+    __syncthreads();
+
+    auto* flatTokens = params.outputFlatTokens + bid * maxDecodingTokens;
+    auto* positionOffsets = params.outputPositionOffsets + bid * maxDecodingTokens;
+    auto* packedMask = params.outputPackedMask + bid * maxDecodingTokens * numPackedMasks;
+    if (tid == 0)
+    {
+        flatTokens[0] = goldenToken;
+        positionOffsets[0] = 0;
+        packedMask[0] = 1;
+        for (SizeType32 mi = 1; mi < numPackedMasks; ++mi)
+        {
+            packedMask[mi] = 0;
+        }
+        params.outputGenerationLengths[bid] = numKept + 1;
+    }
+    for (auto ci = tid; ci < numCandidates; ci += blockSize)
+    {
+        if (!isKept[ci])
+        {
+            continue;
+        }
+        auto const newIdx = newIndices[ci];
+        flatTokens[newIdx] = candidateTokens[ci];
+        positionOffsets[newIdx] = depths[ci];
+
+        auto* maskRow = packedMask + newIdx * numPackedMasks;
+        maskRow[0] = 1;
+        for (SizeType32 mi = 1; mi < numPackedMasks; ++mi)
+        {
+            maskRow[mi] = 0;
+        }
+        auto const leafRank = leafRanks[ci];
+        for (auto node = ci; node >= 0; node = candidateParents[node])
+        {
+            auto const nodeIdx = newIndices[node];
+            maskRow[nodeIdx / 32] |= static_cast<int32_t>(1u << (nodeIdx % 32));
+            if (leafRank < params.numPaths)
+            {
+                auto const pathOffset = pathsOffset + leafRank * params.maxPathLength + depths[node];
+                params.outputDraftTokens[pathOffset] = candidateTokens[node];
+                params.outputDraftIndices[pathOffset] = nodeIdx;
+            }
+        }
+    }
+}
+} // namespace
+
+void invokeBuildDynamicDraftTree(BuildDynamicDraftTreeParams const& params, cudaStream_t stream)
+{
+    params.checkParams();
+    SizeType32 constexpr BLOCK_SIZE = 256;
+    auto const smemSize = params.maxNumCandidates * (5 * sizeof(SizeType32) + 3 * sizeof(uint8_t));
+    buildDynamicDraftTree<<<params.batchSize, BLOCK_SIZE, smemSize, stream>>>(params);
+    sync_check_cuda_error();
+}
 } // namespace tensorrt_llm::kernels::speculative_decoding
@@ -17,11 +17,11 @@
 #pragma once
 
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
 #include "tensorrt_llm/kernels/speculativeDecoding/common.h"
 #include "tensorrt_llm/runtime/common.h"
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
 
 namespace tensorrt_llm::kernels::speculative_decoding
 {
@@ -35,8 +35,8 @@ struct FillContextExplicitDraftTokensParams
     T* outputTemperatures{nullptr};
     //! [maxBatchSize]
     float const* inputTemperatures{nullptr};
-    //! [maxBatchSize]
-    curandState_t* curandState{nullptr};
+    //! [maxBatchSize], seeds of the stateless random numbers, see philoxUniform
+    uint64_t const* randomSeeds{nullptr};
     //! [forwardBatchSize]
     runtime::SizeType32 const* batchSlots{nullptr};
 
@@ -47,7 +47,7 @@ struct FillContextExplicitDraftTokensParams
         TLLM_CHECK(randDataSample);
         TLLM_CHECK(outputTemperatures);
         TLLM_CHECK(inputTemperatures);
-        TLLM_CHECK(curandState);
+        TLLM_CHECK(randomSeeds);
         TLLM_CHECK(batchSlots);
 
         TLLM_CHECK(batchSize > 0);
@@ -123,8 +123,8 @@ struct ExtractExplicitDraftTokensParams
     T const* nextDraftProbs{nullptr};
     //! [maxBatchSize]
     float const* inputTemperatures{nullptr};
-    //! [maxBatchSize]
-    curandState_t* curandState{nullptr};
+    //! [maxBatchSize], seeds of the stateless random numbers, see philoxUniform
+    uint64_t const* randomSeeds{nullptr};
     runtime::SizeType32 batchSize{0};
     runtime::SizeType32 numPaths{0};
     runtime::SizeType32 maxPathLength{0};
@@ -160,7 +160,7 @@ struct ExtractExplicitDraftTokensParams
         TLLM_CHECK(bestPathIndices);
         TLLM_CHECK(outputBestPathIndices);
 
-        TLLM_CHECK(curandState);
+        TLLM_CHECK(randomSeeds);
         TLLM_CHECK(batchSlots);
         TLLM_CHECK(nextDraftTokens);
         TLLM_CHECK(nextFlatTokens);
@@ -323,6 +323,77 @@ void invokePackExplicitDraftTokens(PackExplicitDraftTokensParams<T> const& param
 template <typename T>
 void invokeCopyProbs(PackExplicitDraftTokensParams<T> const& params, cudaStream_t stream);
 
+//! @brief Maximum number of draft head candidates per request of invokeBuildDynamicDraftTree.
+static constexpr runtime::SizeType32 kMaxDynamicDraftTreeCandidates = 1024;
+
+struct BuildDynamicDraftTreeParams
+{
+    //! [batchSize, maxNumCandidates], tokens proposed by a feature-level draft head. Parents come before their
+    //! children.
+    runtime::TokenIdType const* candidateTokens{nullptr};
+    //! [batchSize, maxNumCandidates], index of the parent candidate, -1 for children of the golden token
+    runtime::SizeType32 const* candidateParents{nullptr};
+    //! [batchSize, maxNumCandidates], log prob of the candidate given its parent under the draft head
+    float const* candidateLogProbs{nullptr};
+    //! [batchSize]
+    runtime::SizeType32 const* numCandidates{nullptr};
+    //! [batchSize], token of the target model the tree grows from
+    runtime::TokenIdType const* goldenTokens{nullptr};
+
+    //! [batchSize, maxDecodingTokens], golden token followed by the draft tokens of the tree
+    runtime::TokenIdType* outputFlatTokens{nullptr};
+    //! [batchSize, numPaths, maxPathLength], paths from the golden token to the leaves, -1 padded
+    runtime::TokenIdType* outputDraftTokens{nullptr};
+    //! [batchSize, numPaths, maxPathLength], indices of the path tokens in outputFlatTokens, -1 padded
+    runtime::SizeType32* outputDraftIndices{nullptr};
+    //! [batchSize, maxDecodingTokens], depth of the tokens in the tree
+    runtime::SizeType32* outputPositionOffsets{nullptr};
+    //! [batchSize, maxDecodingTokens, divUp(maxDecodingTokens, 32)], bit j of row i is set if token j is an ancestor
+    //! of token i or i itself
+    int32_t* outputPackedMask{nullptr};
+    //! [batchSize], number of tokens of the tree including the golden token
+    runtime::SizeType32* outputGenerationLengths{nullptr};
+
+    runtime::SizeType32 batchSize{0};
+    runtime::SizeType32 maxNumCandidates{0};
+    runtime::SizeType32 numPaths{0};
+    runtime::SizeType32 maxPathLength{0};
+
+    [[nodiscard]] runtime::SizeType32 getMaxDecodingTokens() const
+    {
+        return numPaths * (maxPathLength - 1) + 1;
+    }
+
+    void checkParams() const
+    {
+        TLLM_CHECK(candidateTokens);
+        TLLM_CHECK(candidateParents);
+        TLLM_CHECK(candidateLogProbs);
+        TLLM_CHECK(numCandidates);
+        TLLM_CHECK(goldenTokens);
+
+        TLLM_CHECK(outputFlatTokens);
+        TLLM_CHECK(outputDraftTokens);
+        TLLM_CHECK(outputDraftIndices);
+        TLLM_CHECK(outputPositionOffsets);
+        TLLM_CHECK(outputPackedMask);
+        TLLM_CHECK(outputGenerationLengths);
+
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxNumCandidates > 0 && maxNumCandidates <= kMaxDynamicDraftTreeCandidates);
+        TLLM_CHECK(numPaths > 0);
+        TLLM_CHECK(maxPathLength > 1);
+    }
+};
+
+//! @brief Builds the draft tree of feature-level autoregressive draft heads (EAGLE-style) from the confidence of the
+//! draft head, in the format of the explicit draft tokens network outputs. The score of a candidate is the product of
+//! the draft head probabilities along its path. The getMaxDecodingTokens() - 1 best candidates up to depth
+//! maxPathLength - 1 are selected, which always form a tree as a child never scores higher than its parent. If the
+//! tree has more leaves than numPaths, only the numPaths best leaves and their ancestors are kept. Tokens are ordered
+//! by decreasing score, so parents precede their children.
+void invokeBuildDynamicDraftTree(BuildDynamicDraftTreeParams const& params, cudaStream_t stream);
+
 size_t invokeScanGenerationLengths(void* __restrict__ scanTempStorage, size_t scanTempStorageBytes,
     runtime::SizeType32 const* __restrict__ generationLengths,
     runtime::SizeType32* __restrict__ scannedGenerationLengths, runtime::SizeType32 batchSize, cudaStream_t stream);
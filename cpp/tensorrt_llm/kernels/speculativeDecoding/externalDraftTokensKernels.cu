@@ -37,8 +37,9 @@ namespace
 {
 __global__ void acceptDraftTokensByIds(TokenIdType const* draftIds, TokenIdType const* targetIds,
     SizeType32 const* contextLengths, SizeType32 const* numsDraftTokens, SizeType32* sequenceLengths,
-    FinishedState const* finished, FinishedState* finishedFinal, SizeType32* finishedSum, SizeType32 const* batchSlots,
-    SizeType32 batchSize, SizeType32 maxBatchSize, SizeType32 maxSeqLen, SizeType32 maxDraftTokens)
+    FinishedState const* finished, FinishedState* finishedFinal, SizeType32* finishedSum, SizeType32* finishedSlots,
+    SizeType32 const* batchSlots, SizeType32 batchSize, SizeType32 maxBatchSize, SizeType32 maxSeqLen,
+    SizeType32 maxDraftTokens)
 {
     for (auto batchIdx = static_cast<SizeType32>(threadIdx.x); batchIdx < batchSize; batchIdx += blockDim.x)
     {
@@ -71,22 +72,27 @@ __global__ void acceptDraftTokensByIds(TokenIdType const* draftIds, TokenIdType
         {
             finishedSum[batchSlot] = static_cast<int>(finishState.isFinished());
         }
+        // Finished within the accepted tokens, the slot can be released before the host syncs finishedSum
+        if (finishedSlots && finishState.isFinished())
+        {
+            atomicOr(&finishedSlots[batchSlot / 32], static_cast<SizeType32>(1u << (batchSlot % 32)));
+        }
     }
 }
 } // namespace
 
 void invokeAcceptDraftTokensByIds(TokenIdType const* draftIds, TokenIdType const* targetIds,
     SizeType32 const* contextLengths, SizeType32 const* numsDraftTokens, SizeType32* sequenceLengths,
-    FinishedState const* finished, FinishedState* finishedFinal, SizeType32* finishedSum, SizeType32 const* batchSlots,
-    SizeType32 batchSize, SizeType32 maxBatchSize, SizeType32 beamWidth, SizeType32 maxSeqLen,
-    SizeType32 maxDraftTokens, cudaStream_t stream)
+    FinishedState const* finished, FinishedState* finishedFinal, SizeType32* finishedSum, SizeType32* finishedSlots,
+    SizeType32 const* batchSlots, SizeType32 batchSize, SizeType32 maxBatchSize, SizeType32 beamWidth,
+    SizeType32 maxSeqLen, SizeType32 maxDraftTokens, cudaStream_t stream)
 {
     TLLM_CHECK(beamWidth == 1);
     dim3 block(min(1024, batchSize));
     dim3 grid(1);
     acceptDraftTokensByIds<<<grid, block, 0, stream>>>(draftIds, targetIds, contextLengths, numsDraftTokens,
-        sequenceLengths, finished, finishedFinal, finishedSum, batchSlots, batchSize, maxBatchSize, maxSeqLen,
-        maxDraftTokens);
+        sequenceLengths, finished, finishedFinal, finishedSum, finishedSlots, batchSlots, batchSize, maxBatchSize,
+        maxSeqLen, maxDraftTokens);
 }
 
 namespace
@@ -253,4 +259,143 @@ template void acceptDraftTokensByLogits(half* draftLogits, half** targetLogits,
     SizeType32 vocabSize, SizeType32 vocabSizePadded, SizeType32 maxDraftTokens, bool randomThreshold,
     float constantThreshold, cudaStream_t stream);
 
+
+namespace
+{
+//! Block per request. The draft tokens of a position are accepted if the beam search step on the target logits
+//! would select exactly the draft continuations of all beams: the lowest cumulative log prob of the beams extended
+//! with their draft tokens is above the best alternative of every beam.
+template <typename T>
+__global__ void acceptDraftTokensBeamSearchKernel(TokenIdType const* draftIds, SizeType32 const* numsDraftTokens,
+    T const* const* targetLogits, TokenIdType const* endIds, TokenIdType* outputIds, SizeType32* parentIds,
+    float* cumLogProbs, SizeType32* sequenceLengths, SizeType32* acceptedLengths, SizeType32 const* batchSlots,
+    SizeType32 beamWidth, SizeType32 vocabSize, SizeType32 vocabSizePadded, SizeType32 maxDraftTokens,
+    SizeType32 maxSeqLen)
+{
+    extern __shared__ float smem[];
+    float* smemCumLogProbs = smem;
+    float* smemDraftScores = smemCumLogProbs + beamWidth;
+    float* smemOtherScores = smemDraftScores + beamWidth;
+    __shared__ bool smemAccepted;
+
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const batchSlot = batchSlots == nullptr ? batchIdx : batchSlots[batchIdx];
+    auto const numDraftTokens = numsDraftTokens[batchSlot];
+    auto const endId = endIds[batchSlot];
+
+    for (auto beamIdx = static_cast<SizeType32>(threadIdx.x); beamIdx < beamWidth; beamIdx += blockDim.x)
+    {
+        smemCumLogProbs[beamIdx] = cumLogProbs[batchSlot * beamWidth + beamIdx];
+    }
+
+    SizeType32 numAccepted = 0;
+    for (; numAccepted < numDraftTokens; ++numAccepted)
+    {
+        for (SizeType32 beamIdx = 0; beamIdx < beamWidth; ++beamIdx)
+        {
+            auto const draftId = draftIds[(batchSlot * beamWidth + beamIdx) * maxDraftTokens + numAccepted];
+            auto const* logits = targetLogits[batchIdx] + (numAccepted * beamWidth + beamIdx) * vocabSizePadded;
+
+            float localMax = -FLT_MAX;
+            float localOtherMax = -FLT_MAX;
+            for (auto vIdx = static_cast<SizeType32>(threadIdx.x); vIdx < vocabSize; vIdx += blockDim.x)
+            {
+                auto const logit = static_cast<float>(logits[vIdx]);
+                localMax = fmaxf(localMax, logit);
+                localOtherMax = vIdx == draftId ? localOtherMax : fmaxf(localOtherMax, logit);
+            }
+            __syncthreads();
+            auto const maxLogit = blockReduceMax<float>(localMax);
+            __syncthreads();
+            auto const otherMaxLogit = blockReduceMax<float>(localOtherMax);
+
+            float localSum = 0.f;
+            for (auto vIdx = static_cast<SizeType32>(threadIdx.x); vIdx < vocabSize; vIdx += blockDim.x)
+            {
+                localSum += __expf(static_cast<float>(logits[vIdx]) - maxLogit);
+            }
+            __syncthreads();
+            auto const sumExp = blockReduceSum<float>(localSum);
+
+            if (threadIdx.x == 0)
+            {
+                auto const logSumExp = maxLogit + __logf(sumExp);
+                bool const valid = 0 <= draftId && draftId < vocabSize && draftId != endId;
+                auto const draftLogProb = valid ? static_cast<float>(logits[draftId]) - logSumExp : -FLT_MAX;
+                smemDraftScores[beamIdx] = valid ? smemCumLogProbs[beamIdx] + draftLogProb : -FLT_MAX;
+                smemOtherScores[beamIdx] = smemCumLogProbs[beamIdx] + otherMaxLogit - logSumExp;
+            }
+        }
+        __syncthreads();
+
+        if (threadIdx.x == 0)
+        {
+            float minDraftScore = FLT_MAX;
+            float maxOtherScore = -FLT_MAX;
+            for (SizeType32 beamIdx = 0; beamIdx < beamWidth; ++beamIdx)
+            {
+                minDraftScore = fminf(minDraftScore, smemDraftScores[beamIdx]);
+                maxOtherScore = fmaxf(maxOtherScore, smemOtherScores[beamIdx]);
+            }
+            smemAccepted = minDraftScore > -FLT_MAX && maxOtherScore < minDraftScore;
+        }
+        __syncthreads();
+        if (!smemAccepted)
+        {
+            break;
+        }
+
+        // The beams keep their order, each one is its own parent.
+        for (auto beamIdx = static_cast<SizeType32>(threadIdx.x); beamIdx < beamWidth; beamIdx += blockDim.x)
+        {
+            auto const batchBeamIdx = batchSlot * beamWidth + beamIdx;
+            auto const step = sequenceLengths[batchBeamIdx] + numAccepted;
+            outputIds[batchBeamIdx * maxSeqLen + step] = draftIds[batchBeamIdx * maxDraftTokens + numAccepted];
+            parentIds[batchBeamIdx * maxSeqLen + step] = beamIdx;
+            smemCumLogProbs[beamIdx] = smemDraftScores[beamIdx];
+        }
+    }
+    __syncthreads();
+
+    for (auto beamIdx = static_cast<SizeType32>(threadIdx.x); beamIdx < beamWidth; beamIdx += blockDim.x)
+    {
+        auto const batchBeamIdx = batchSlot * beamWidth + beamIdx;
+        cumLogProbs[batchBeamIdx] = smemCumLogProbs[beamIdx];
+        sequenceLengths[batchBeamIdx] += numAccepted;
+    }
+    if (threadIdx.x == 0)
+    {
+        acceptedLengths[batchSlot] = numAccepted;
+    }
+}
+} // namespace
+
+template <typename T>
+void invokeAcceptDraftTokensBeamSearch(TokenIdType const* draftIds, SizeType32 const* numsDraftTokens,
+    T const* const* targetLogits, TokenIdType const* endIds, TokenIdType* outputIds, SizeType32* parentIds,
+    float* cumLogProbs, SizeType32* sequenceLengths, SizeType32* acceptedLengths, SizeType32 const* batchSlots,
+    SizeType32 batchSize, SizeType32 beamWidth, SizeType32 vocabSize, SizeType32 vocabSizePadded,
+    SizeType32 maxDraftTokens, SizeType32 maxSeqLen, cudaStream_t stream)
+{
+    TLLM_CHECK(beamWidth > 0);
+    dim3 block(256);
+    dim3 grid(batchSize);
+    auto const smemBytes = 3 * beamWidth * sizeof(float);
+    acceptDraftTokensBeamSearchKernel<<<grid, block, smemBytes, stream>>>(draftIds, numsDraftTokens, targetLogits,
+        endIds, outputIds, parentIds, cumLogProbs, sequenceLengths, acceptedLengths, batchSlots, beamWidth, vocabSize,
+        vocabSizePadded, maxDraftTokens, maxSeqLen);
+    sync_check_cuda_error();
+}
+
+template void invokeAcceptDraftTokensBeamSearch(TokenIdType const* draftIds, SizeType32 const* numsDraftTokens,
+    float const* const* targetLogits, TokenIdType const* endIds, TokenIdType* outputIds, SizeType32* parentIds,
+    float* cumLogProbs, SizeType32* sequenceLengths, SizeType32* acceptedLengths, SizeType32 const* batchSlots,
+    SizeType32 batchSize, SizeType32 beamWidth, SizeType32 vocabSize, SizeType32 vocabSizePadded,
+    SizeType32 maxDraftTokens, SizeType32 maxSeqLen, cudaStream_t stream);
+template void invokeAcceptDraftTokensBeamSearch(TokenIdType const* draftIds, SizeType32 const* numsDraftTokens,
+    half const* const* targetLogits, TokenIdType const* endIds, TokenIdType* outputIds, SizeType32* parentIds,
+    float* cumLogProbs, SizeType32* sequenceLengths, SizeType32* acceptedLengths, SizeType32 const* batchSlots,
+    SizeType32 batchSize, SizeType32 beamWidth, SizeType32 vocabSize, SizeType32 vocabSizePadded,
+    SizeType32 maxDraftTokens, SizeType32 maxSeqLen, cudaStream_t stream);
+
 } // namespace tensorrt_llm::kernels::speculative_decoding
@@ -41,6 +41,8 @@ namespace tensorrt_llm::kernels::speculative_decoding
 //! \param finished input buffer [maxDraftTokens + 1, batchSize] finished states at each decoding iteration
 //! \param finishedFinal output buffer [batchSize] finished states after accepting/rejecting tokens
 //! \param finishedSum output buffer [1] total number of requests in batch that finished the execution
+//! \param finishedSlots output buffer [divUp(maxBatchSize, 32)], optional. Bit `batchSlot % 32` of word
+//! `batchSlot / 32` is set if the request finished within the accepted tokens, the other bits are unchanged
 //! \param batchSlots input buffer [batchSize], address map from local index
 //! to global index [0, batchSize] -> [0, maxBatchSize]
 //! \param batchSize current batch size
@@ -52,9 +54,9 @@ namespace tensorrt_llm::kernels::speculative_decoding
 void invokeAcceptDraftTokensByIds(runtime::TokenIdType const* draftIds, runtime::TokenIdType const* targetIds,
     runtime::SizeType32 const* contextLengths, runtime::SizeType32 const* numsDraftTokens,
     runtime::SizeType32* sequenceLengths, FinishedState const* finished, FinishedState* finishedFinal,
-    runtime::SizeType32* finishedSum, runtime::SizeType32 const* batchSlots, runtime::SizeType32 batchSize,
-    runtime::SizeType32 maxBatchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 maxSeqLen,
-    runtime::SizeType32 maxDraftTokens, cudaStream_t stream);
+    runtime::SizeType32* finishedSum, runtime::SizeType32* finishedSlots, runtime::SizeType32 const* batchSlots,
+    runtime::SizeType32 batchSize, runtime::SizeType32 maxBatchSize, runtime::SizeType32 beamWidth,
+    runtime::SizeType32 maxSeqLen, runtime::SizeType32 maxDraftTokens, cudaStream_t stream);
 
 //! \brief Performs probabilistic acceptance of draft tokens based on their probability distributions.
 //! Corrects targetLogits for the next to the last accepted token
@@ -94,4 +96,41 @@ void acceptDraftTokensByLogits(T* draftLogits, T** targetLogits, T* draftProbs,
     runtime::SizeType32 beamWidth, runtime::SizeType32 vocabSize, runtime::SizeType32 vocabSizePadded,
     runtime::SizeType32 maxDraftTokens, bool randomThreshold, float constantThreshold, cudaStream_t stream);
 
+//! \brief Accepts draft tokens for beam search. The draft tokens of a position are accepted if the beam search step
+//! on the target logits would extend every beam with its own draft token: the lowest cumulative log prob of the
+//! extended beams is above the cumulative log prob of the best other token of every beam. The accepted steps then
+//! match beam search without speculation, no beam is reordered and draft tokens equal to the end id are never
+//! accepted. The target logits at the position after the last accepted draft token are left to the regular beam search
+//! step, and the KV cache of every beam is rewound by numsDraftTokens - acceptedLengths, e.g. with
+//! updateKVBlockArrayDraftTokenLocationSeparateRewind. With beam width 1 this is greedy acceptance by ids.
+//!
+//! \param draftIds input buffer [maxBatchSize, beamWidth, maxDraftTokens], draft tokens of each beam, e.g. one
+//! draft shared by all beams
+//! \param numsDraftTokens input buffer [maxBatchSize]
+//! \param targetLogits input buffer [batchSize][maxDraftTokens + 1, beamWidth, vocabSizePadded]
+//! \param endIds input buffer [maxBatchSize]
+//! \param outputIds input/output buffer [maxBatchSize, beamWidth, maxSeqLen], accepted tokens are written at the
+//! sequence lengths
+//! \param parentIds output buffer [maxBatchSize, beamWidth, maxSeqLen]
+//! \param cumLogProbs input/output buffer [maxBatchSize, beamWidth]
+//! \param sequenceLengths input/output buffer [maxBatchSize, beamWidth], increased by the accepted lengths
+//! \param acceptedLengths output buffer [maxBatchSize], number of accepted draft tokens, the same for all beams
+//! \param batchSlots input buffer [batchSize], address map from local index to global index [0, batchSize] ->
+//! [0, maxBatchSize]
+//! \param batchSize current batch size
+//! \param beamWidth beam width
+//! \param vocabSize unpadded vocab size
+//! \param vocabSizePadded padded vocab size
+//! \param maxDraftTokens maximum number of draft tokens
+//! \param maxSeqLen maximum sequence length
+//! \param stream stream
+template <typename T>
+void invokeAcceptDraftTokensBeamSearch(runtime::TokenIdType const* draftIds,
+    runtime::SizeType32 const* numsDraftTokens, T const* const* targetLogits, runtime::TokenIdType const* endIds,
+    runtime::TokenIdType* outputIds, runtime::SizeType32* parentIds, float* cumLogProbs,
+    runtime::SizeType32* sequenceLengths, runtime::SizeType32* acceptedLengths, runtime::SizeType32 const* batchSlots,
+    runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 vocabSize,
+    runtime::SizeType32 vocabSizePadded, runtime::SizeType32 maxDraftTokens, runtime::SizeType32 maxSeqLen,
+    cudaStream_t stream);
+
 } // namespace tensorrt_llm::kernels::speculative_decoding
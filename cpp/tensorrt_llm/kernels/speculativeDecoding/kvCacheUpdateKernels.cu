@@ -35,7 +35,7 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
     SizeType32 const* seqAcceptedDraftTokenOffsets, IndexType const* packedAcceptedDraftTokensIndices,
     SizeType32 const* pastKeyValueLengths, SizeType32 rewindDraftTokenCommonCount,
     SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
-    SizeType32 const* batchSlots, SizeType32 eltCountPerHead)
+    SizeType32 const* batchSlots, SizeType32 eltCountPerHead, AcceptedTokensOutputs outputs)
 {
     auto const seqIdx = static_cast<SizeType32>(blockIdx.x);
     auto const headIdx = static_cast<SizeType32>(blockIdx.y);
@@ -43,6 +43,29 @@ __global__ void updateKVCacheDraftTokenLocationBatchedKernel(std::array<KVCacheB
     auto const warpIdx = static_cast<SizeType32>(threadIdx.x / 32);
     auto const warpCount = static_cast<SizeType32>(blockDim.x / 32);
     auto const laneIdx = static_cast<SizeType32>(threadIdx.x & 0x1f);
+    if (outputs.outputIds != nullptr && headIdx == 0 && layerIdx == 0)
+    {
+        // One block per sequence appends the accepted tokens, the rest of the grid only moves the KV cache
+        auto const batchSlot = batchSlots == nullptr ? seqIdx : batchSlots[seqIdx];
+        auto const sequenceLength = outputs.sequenceLengths[batchSlot];
+        auto const numAcceptedTokens = outputs.numAcceptedTokens[batchSlot];
+        for (auto ti = static_cast<SizeType32>(threadIdx.x); ti < numAcceptedTokens;
+             ti += static_cast<SizeType32>(blockDim.x))
+        {
+            auto const srcIdx = batchSlot * outputs.maxAcceptedTokens + ti;
+            auto const dstIdx = batchSlot * outputs.maxSeqLen + sequenceLength + ti;
+            outputs.outputIds[dstIdx] = outputs.acceptedTokenIds[srcIdx];
+            if (outputs.outputLogProbs != nullptr)
+            {
+                outputs.outputLogProbs[dstIdx] = outputs.acceptedLogProbs[srcIdx];
+            }
+        }
+        __syncthreads();
+        if (threadIdx.x == 0)
+        {
+            outputs.sequenceLengths[batchSlot] = sequenceLength + numAcceptedTokens;
+        }
+    }
     auto const seqDraftTokenStart = seqAcceptedDraftTokenOffsets[seqIdx];
     auto const seqDraftTokenEnd = seqAcceptedDraftTokenOffsets[seqIdx + 1];
     auto const seqSlot = seqSlotRemapping == nullptr ? seqIdx : seqSlotRemapping[seqIdx];
@@ -140,7 +163,7 @@ void updateKVCacheDraftTokenLocationBatched(KVCacheBuffer const* kvCacheBuffers,
     SizeType32 const* pastKeyValueLengths, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
     SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
     SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
-    SizeType32 const* batchSlots, cudaStream_t stream)
+    SizeType32 const* batchSlots, AcceptedTokensOutputs const& outputs, cudaStream_t stream)
 {
     // make sure launch buffer is enough
     static_assert(MaxLayerCount * sizeof(KVCacheBuffer) <= 3072);
@@ -163,7 +186,8 @@ void updateKVCacheDraftTokenLocationBatched(KVCacheBuffer const* kvCacheBuffers,
         kvCacheBufferArray[i] = kvCacheBuffers[i];
     }
     void (*pKernelFunc)(std::array<KVCacheBuffer, MaxLayerCount>, SizeType32 const*, IndexType const*,
-        SizeType32 const*, SizeType32, SizeType32 const*, SizeType32 const*, SizeType32 const*, SizeType32)
+        SizeType32 const*, SizeType32, SizeType32 const*, SizeType32 const*, SizeType32 const*, SizeType32,
+        AcceptedTokensOutputs)
         = nullptr;
     switch (alignedBytes)
     {
@@ -196,7 +220,7 @@ void updateKVCacheDraftTokenLocationBatched(KVCacheBuffer const* kvCacheBuffers,
     }
     pKernelFunc<<<grid, block, 0, stream>>>(kvCacheBufferArray, seqAcceptedDraftTokenOffsets,
         packedAcceptedDraftTokensIndices, pastKeyValueLengths, rewindDraftTokenCommonCount,
-        rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, eltCountPerHead);
+        rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, eltCountPerHead, outputs);
     TLLM_CUDA_CHECK(cudaGetLastError());
 }
 
@@ -215,6 +239,7 @@ void updateKVCacheDraftTokenLocationBatched(KVCacheBuffer const* kvCacheBuffers,
  * @param rewindDraftTokenCommonCount : Common count to rewind
  * @param rewindDraftTokenSeparateAdjustments : Separate adjustment to rewind for each sequence, if nullptr, just use
  * rewindDraftTokenCommonCount, else use rewindDraftTokenSeparateAdjustments[i] + rewindDraftTokenCommonCount
+ * @param outputs : Accepted tokens appended to the outputs by the same launch, skipped if outputs.outputIds is nullptr
  * @param stream : CUDA stream to use.
  */
 template <typename KVCacheBuffer>
@@ -223,8 +248,10 @@ void updateKVCacheDraftTokenLocation(KVCacheBuffer const* kvCacheBuffers,
     SizeType32 const* pastKeyValueLengths, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
     SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
     SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
-    SizeType32 const* batchSlots, cudaStream_t stream)
+    SizeType32 const* batchSlots, AcceptedTokensOutputs const& outputs, cudaStream_t stream)
 {
+    TLLM_CHECK_WITH_INFO(outputs.outputIds == nullptr || layerCount > 0,
+        "Accepted tokens are written by the launch of the first layers");
     SizeType32 startLayer = 0;
     static constexpr SizeType32 kMaxLayersPerIter = 32;
     while (startLayer < layerCount)
@@ -233,17 +260,18 @@ void updateKVCacheDraftTokenLocation(KVCacheBuffer const* kvCacheBuffers,
         updateKVCacheDraftTokenLocationBatched<KVCacheBuffer, kMaxLayersPerIter>(kvCacheBuffers + startLayer,
             seqAcceptedDraftTokenOffsets, packedAcceptedDraftTokensIndices, pastKeyValueLengths, microBatchLayerCount,
             seqCount, numKVHeads, sizeInBytesPerKVHead, rewindDraftTokenCommonCount,
-            rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, stream);
+            rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots,
+            startLayer == 0 ? outputs : AcceptedTokensOutputs{}, stream);
         startLayer += microBatchLayerCount;
     }
 }
 
-void updateLinearKVCacheDraftTokenLocation(SizeType32 const* seqAcceptedDraftTokenOffsets,
+void updateLinearKVCacheDraftTokenLocationAndOutputs(SizeType32 const* seqAcceptedDraftTokenOffsets,
     IndexType const* packedAcceptedDraftTokensIndices, SizeType32 const* pastKeyValueLengths,
     int8_t* const* pastKeyValueList, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
     SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
-    SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping, SizeType32 maxKVCacheLen,
-    cudaStream_t stream)
+    SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
+    SizeType32 const* batchSlots, SizeType32 maxKVCacheLen, AcceptedTokensOutputs const& outputs, cudaStream_t stream)
 {
     std::vector<KVLinearBuffer> kvLinearBuffers;
     kvLinearBuffers.reserve(layerCount);
@@ -255,16 +283,30 @@ void updateLinearKVCacheDraftTokenLocation(SizeType32 const* seqAcceptedDraftTok
     }
     updateKVCacheDraftTokenLocation(kvLinearBuffers.data(), seqAcceptedDraftTokenOffsets,
         packedAcceptedDraftTokensIndices, pastKeyValueLengths, layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead,
-        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, nullptr, stream);
+        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, outputs,
+        stream);
 }
 
-void updateKVBlockArrayDraftTokenLocation(SizeType32 const* seqAcceptedDraftTokenOffsets,
+void updateLinearKVCacheDraftTokenLocation(SizeType32 const* seqAcceptedDraftTokenOffsets,
+    IndexType const* packedAcceptedDraftTokensIndices, SizeType32 const* pastKeyValueLengths,
+    int8_t* const* pastKeyValueList, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
+    SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
+    SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping, SizeType32 maxKVCacheLen,
+    cudaStream_t stream)
+{
+    updateLinearKVCacheDraftTokenLocationAndOutputs(seqAcceptedDraftTokenOffsets, packedAcceptedDraftTokensIndices,
+        pastKeyValueLengths, pastKeyValueList, layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead,
+        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, nullptr, maxKVCacheLen,
+        AcceptedTokensOutputs{}, stream);
+}
+
+void updateKVBlockArrayDraftTokenLocationAndOutputs(SizeType32 const* seqAcceptedDraftTokenOffsets,
     IndexType const* packedAcceptedDraftTokensIndices, SizeType32 const* pastKeyValueLengths, void* const* pointerArray,
     KVBlockArray::DataType* offsetArray, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
     SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
     SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
     SizeType32 const* batchSlots, SizeType32 maxKVCacheLen, SizeType32 maxBlocksPerSeq, SizeType32 tokensPerBlock,
-    cudaStream_t stream)
+    AcceptedTokensOutputs const& outputs, cudaStream_t stream)
 {
     std::vector<KVBlockArray> kvBlockArrays;
     kvBlockArrays.reserve(layerCount);
@@ -283,7 +325,22 @@ void updateKVBlockArrayDraftTokenLocation(SizeType32 const* seqAcceptedDraftToke
     }
     updateKVCacheDraftTokenLocation(kvBlockArrays.data(), seqAcceptedDraftTokenOffsets,
         packedAcceptedDraftTokensIndices, pastKeyValueLengths, layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead,
-        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, stream);
+        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, outputs,
+        stream);
+}
+
+void updateKVBlockArrayDraftTokenLocation(SizeType32 const* seqAcceptedDraftTokenOffsets,
+    IndexType const* packedAcceptedDraftTokensIndices, SizeType32 const* pastKeyValueLengths, void* const* pointerArray,
+    KVBlockArray::DataType* offsetArray, SizeType32 layerCount, SizeType32 seqCount, SizeType32 numKVHeads,
+    SizeType32 sizeInBytesPerKVHead, SizeType32 rewindDraftTokenCommonCount,
+    SizeType32 const* rewindDraftTokenSeparateAdjustments, SizeType32 const* seqSlotRemapping,
+    SizeType32 const* batchSlots, SizeType32 maxKVCacheLen, SizeType32 maxBlocksPerSeq, SizeType32 tokensPerBlock,
+    cudaStream_t stream)
+{
+    updateKVBlockArrayDraftTokenLocationAndOutputs(seqAcceptedDraftTokenOffsets, packedAcceptedDraftTokensIndices,
+        pastKeyValueLengths, pointerArray, offsetArray, layerCount, seqCount, numKVHeads, sizeInBytesPerKVHead,
+        rewindDraftTokenCommonCount, rewindDraftTokenSeparateAdjustments, seqSlotRemapping, batchSlots, maxKVCacheLen,
+        maxBlocksPerSeq, tokensPerBlock, AcceptedTokensOutputs{}, stream);
 }
 
 void updateLinearKVCacheDraftTokenLocationCommonRewind(SizeType32 const* seqAcceptedDraftTokenOffsets,
@@ -26,6 +26,30 @@ namespace tensorrt_llm::kernels::speculative_decoding
 
 using IndexType = int;
 
+/*!
+ * Accepted tokens appended to the outputs in the same launch as the KV cache update, which replaces the separate
+ * copies of the accepted ids and log probs and the update of the sequence lengths. All arrays are indexed by the batch
+ * slot of the sequence. Output ids and log probs are written at positions [sequenceLengths[slot], sequenceLengths[slot]
+ * + numAcceptedTokens[slot]), then sequenceLengths[slot] is incremented by numAcceptedTokens[slot].
+ */
+struct AcceptedTokensOutputs
+{
+    //! [maxBatchSize, maxAcceptedTokens], accepted draft tokens followed by the token of the target model
+    runtime::TokenIdType const* acceptedTokenIds{nullptr};
+    //! [maxBatchSize, maxAcceptedTokens], optional
+    float const* acceptedLogProbs{nullptr};
+    //! [maxBatchSize]
+    runtime::SizeType32 const* numAcceptedTokens{nullptr};
+    //! [maxBatchSize, maxSeqLen], outputs are not written if nullptr
+    runtime::TokenIdType* outputIds{nullptr};
+    //! [maxBatchSize, maxSeqLen], optional
+    float* outputLogProbs{nullptr};
+    //! [maxBatchSize], must not alias pastKeyValueLengths
+    runtime::SizeType32* sequenceLengths{nullptr};
+    runtime::SizeType32 maxAcceptedTokens{0};
+    runtime::SizeType32 maxSeqLen{0};
+};
+
 /*!
  * Update Linear KV cache using common rewind count.
  * @param seqAcceptedDraftTokenOffsets : Array of length seqCount + 1, like [0, 3, 5]
@@ -205,4 +229,35 @@ void updateKVBlockArrayDraftTokenLocation(runtime::SizeType32 const* seqAccepted
     runtime::SizeType32 maxKVCacheLen, runtime::SizeType32 maxBlocksPerSeq, runtime::SizeType32 tokensPerBlock,
     cudaStream_t stream);
 
+/*!
+ * Update Linear KV cache like updateLinearKVCacheDraftTokenLocation and append the accepted tokens to the outputs in
+ * the same launch.
+ * @param batchSlots : [seqCount] indices of sequences in the seq slots, indexes rewindDraftTokenSeparateAdjustments and
+ * outputs. Optional, the batch index is used if nullptr.
+ * @param outputs : Accepted tokens appended to the outputs, see AcceptedTokensOutputs.
+ * See updateLinearKVCacheDraftTokenLocation for the other parameters.
+ */
+void updateLinearKVCacheDraftTokenLocationAndOutputs(runtime::SizeType32 const* seqAcceptedDraftTokenOffsets,
+    IndexType const* packedAcceptedDraftTokensIndices, runtime::SizeType32 const* pastKeyValueLengths,
+    KVLinearBuffer::DataType* const* pastKeyValueList, runtime::SizeType32 layerCount, runtime::SizeType32 seqCount,
+    runtime::SizeType32 numKVHeads, runtime::SizeType32 sizeInBytesPerKVHead,
+    runtime::SizeType32 rewindDraftTokenCommonCount, runtime::SizeType32 const* rewindDraftTokenSeparateAdjustments,
+    runtime::SizeType32 const* seqSlotRemapping, runtime::SizeType32 const* batchSlots,
+    runtime::SizeType32 maxKVCacheLen, AcceptedTokensOutputs const& outputs, cudaStream_t stream);
+
+/*!
+ * Update Block KV cache like updateKVBlockArrayDraftTokenLocation and append the accepted tokens to the outputs in
+ * the same launch.
+ * @param outputs : Accepted tokens appended to the outputs, indexed through batchSlots, see AcceptedTokensOutputs.
+ * See updateKVBlockArrayDraftTokenLocation for the other parameters.
+ */
+void updateKVBlockArrayDraftTokenLocationAndOutputs(runtime::SizeType32 const* seqAcceptedDraftTokenOffsets,
+    IndexType const* packedAcceptedDraftTokensIndices, runtime::SizeType32 const* pastKeyValueLengths,
+    void* const* pointerArray, KVBlockArray::DataType* offsetArray, runtime::SizeType32 layerCount,
+    runtime::SizeType32 seqCount, runtime::SizeType32 numKVHeads, runtime::SizeType32 sizeInBytesPerKVHead,
+    runtime::SizeType32 rewindDraftTokenCommonCount, runtime::SizeType32 const* rewindDraftTokenSeparateAdjustments,
+    runtime::SizeType32 const* seqSlotRemapping, runtime::SizeType32 const* batchSlots,
+    runtime::SizeType32 maxKVCacheLen, runtime::SizeType32 maxBlocksPerSeq, runtime::SizeType32 tokensPerBlock,
+    AcceptedTokensOutputs const& outputs, cudaStream_t stream);
+
 } // namespace tensorrt_llm::kernels::speculative_decoding
@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/speculativeDecoding/lookaheadPoolKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::kernels::speculative_decoding
+{
+namespace
+{
+static constexpr SizeType32 kMaxProbes = 16;
+static constexpr SizeType32 kResetBlockSize = 256;
+static constexpr SizeType32 kGuessBlockSize = 128;
+static constexpr SizeType32 kVerifyBlockSize = 128;
+
+//! Returns the bucket of key, or the bucket to insert it into if insert is set, -1 otherwise.
+__device__ SizeType32 findBucket(TokenIdType const* keys, SizeType32 numBuckets, TokenIdType key, bool insert)
+{
+    auto const home = static_cast<SizeType32>((static_cast<uint32_t>(key) * 2654435761u) % numBuckets);
+    auto const numProbes = min(numBuckets, kMaxProbes);
+    for (SizeType32 pi = 0; pi < numProbes; ++pi)
+    {
+        auto const bucket = (home + pi) % numBuckets;
+        auto const bucketKey = keys[bucket];
+        if (bucketKey == key)
+        {
+            return bucket;
+        }
+        if (bucketKey == kLookaheadPoolEmptyKey)
+        {
+            return insert ? bucket : -1;
+        }
+    }
+    // All probed buckets are taken by other keys, evict the home bucket.
+    return insert ? home : -1;
+}
+
+__device__ TokenIdType* getBucketNgrams(LookaheadPoolParams const& params, SizeType32 slot, SizeType32 bucket)
+{
+    return params.ngrams
+        + (static_cast<size_t>(slot) * params.numBuckets + bucket) * params.maxGuessSetSize * params.ngramLength;
+}
+
+//! Inserts one ngram, called by all lanes of a warp. Lane i compares the new ngram with the i-th ngram of the bucket.
+__device__ void insertNgram(LookaheadPoolParams const& params, SizeType32 slot, SizeType32 guessSetSize,
+    TokenIdType key, TokenIdType const* ngram)
+{
+    auto const lane = static_cast<SizeType32>(threadIdx.x);
+    auto const ngramLength = params.ngramLength;
+    auto* keys = params.keys + slot * params.numBuckets;
+    auto* counts = params.counts + slot * params.numBuckets;
+
+    auto const bucket = findBucket(keys, params.numBuckets, key, true);
+    auto* entries = getBucketNgrams(params, slot, bucket);
+    auto const count = keys[bucket] == key ? counts[bucket] : 0;
+
+    bool match = lane < count;
+    for (SizeType32 ti = 0; match && ti < ngramLength; ++ti)
+    {
+        match = entries[lane * ngramLength + ti] == ngram[ti];
+    }
+    auto const matches = __ballot_sync(0xffffffff, match);
+
+    if (lane == 0)
+    {
+        keys[bucket] = key;
+        // Drop the oldest ngram if the bucket is still full without the duplicate.
+        auto numDropped = (count - __popc(matches)) >= guessSetSize ? 1 : 0;
+        SizeType32 size = 0;
+        for (SizeType32 src = 0; src < count; ++src)
+        {
+            if ((matches >> src) & 1u)
+            {
+                continue;
+            }
+            if (numDropped > 0)
+            {
+                --numDropped;
+                continue;
+            }
+            if (size != src)
+            {
+                for (SizeType32 ti = 0; ti < ngramLength; ++ti)
+                {
+                    entries[size * ngramLength + ti] = entries[src * ngramLength + ti];
+                }
+            }
+            ++size;
+        }
+        for (SizeType32 ti = 0; ti < ngramLength; ++ti)
+        {
+            entries[size * ngramLength + ti] = ngram[ti];
+        }
+        counts[bucket] = size + 1;
+    }
+    __syncwarp();
+}
+
+__global__ void resetLookaheadPool(LookaheadPoolParams params)
+{
+    auto const slot = params.batchSlots[blockIdx.x];
+    for (auto bucket = static_cast<SizeType32>(threadIdx.x); bucket < params.numBuckets; bucket += blockDim.x)
+    {
+        params.keys[slot * params.numBuckets + bucket] = kLookaheadPoolEmptyKey;
+        params.counts[slot * params.numBuckets + bucket] = 0;
+    }
+}
+
+__global__ void acceptLookaheadPool(LookaheadPoolParams params, TokenIdType const* prompts,
+    SizeType32 const* promptLengths, SizeType32 maxPromptLength)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const slot = params.batchSlots[batchIdx];
+    auto const guessSetSize = params.guessSetSizes[slot];
+    if (guessSetSize == 0)
+    {
+        return;
+    }
+    auto const* prompt = prompts + batchIdx * maxPromptLength;
+    auto const promptLength = promptLengths[batchIdx];
+    for (SizeType32 ti = 0; ti + params.ngramLength < promptLength; ++ti)
+    {
+        insertNgram(params, slot, guessSetSize, prompt[ti], prompt + ti + 1);
+    }
+}
+
+__global__ void updateLookaheadPool(LookaheadPoolParams params, TokenIdType const* keyTokens,
+    TokenIdType const* ngramTokens, SizeType32 const* numInserts, SizeType32 maxNumInserts)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const slot = params.batchSlots[batchIdx];
+    auto const guessSetSize = params.guessSetSizes[slot];
+    if (guessSetSize == 0)
+    {
+        return;
+    }
+    for (SizeType32 wi = 0; wi < numInserts[batchIdx]; ++wi)
+    {
+        auto const idx = batchIdx * maxNumInserts + wi;
+        insertNgram(params, slot, guessSetSize, keyTokens[idx], ngramTokens + idx * params.ngramLength);
+    }
+}
+
+__global__ void guessLookaheadPool(LookaheadPoolParams params, TokenIdType const* lastTokens,
+    SizeType32 const* guessSizes, TokenIdType* guessTokens, SizeType32* numGuesses)
+{
+    __shared__ SizeType32 smemBucket;
+    __shared__ SizeType32 smemFirst;
+    __shared__ SizeType32 smemNumGuesses;
+
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const slot = params.batchSlots[batchIdx];
+    if (threadIdx.x == 0)
+    {
+        auto const bucket
+            = findBucket(params.keys + slot * params.numBuckets, params.numBuckets, lastTokens[batchIdx], false);
+        auto const count = bucket >= 0 ? params.counts[slot * params.numBuckets + bucket] : 0;
+        auto const n = min(count, max(guessSizes[slot], 0));
+        smemBucket = bucket;
+        smemFirst = count - n;
+        smemNumGuesses = n;
+        numGuesses[slot] = n;
+    }
+    __syncthreads();
+
+    if (smemNumGuesses == 0)
+    {
+        return;
+    }
+    auto const* entries = getBucketNgrams(params, slot, smemBucket) + smemFirst * params.ngramLength;
+    auto* dst = guessTokens + static_cast<size_t>(slot) * params.maxGuessSetSize * params.ngramLength;
+    for (auto ti = static_cast<SizeType32>(threadIdx.x); ti < smemNumGuesses * params.ngramLength; ti += blockDim.x)
+    {
+        dst[ti] = entries[ti];
+    }
+}
+
+__global__ void verifyLookaheadGuesses(LookaheadPoolParams params, TokenIdType const* guessTokens,
+    SizeType32 const* numGuesses, TokenIdType const* goldenTokens, TokenIdType const* newLastTokens,
+    TokenIdType const* endIds, TokenIdType* acceptedTokens, SizeType32* acceptedLengths, SizeType32* bestGuessIds)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (batchIdx >= params.batchSize)
+    {
+        return;
+    }
+    auto const slot = params.batchSlots[batchIdx];
+    auto const ngramLength = params.ngramLength;
+    auto const stride = params.maxGuessSetSize * ngramLength;
+    auto const* guesses = guessTokens + static_cast<size_t>(slot) * stride;
+    auto const* golden = goldenTokens + static_cast<size_t>(batchIdx) * stride;
+    auto const newLastToken = newLastTokens[batchIdx];
+    auto const endId = endIds[slot];
+
+    SizeType32 maxHit = 0;
+    SizeType32 hitIdx = 0;
+    for (SizeType32 gi = 0; gi < numGuesses[slot]; ++gi)
+    {
+        SizeType32 hit = 0;
+        for (SizeType32 ti = 0; ti < ngramLength; ++ti)
+        {
+            auto const idx = gi * ngramLength + ti;
+            auto const expected = ti == 0 ? newLastToken : golden[idx - 1];
+            if (guesses[idx] != expected || guesses[idx] == endId)
+            {
+                break;
+            }
+            ++hit;
+        }
+        if (hit > maxHit)
+        {
+            maxHit = hit;
+            hitIdx = gi;
+        }
+    }
+
+    auto* accepted = acceptedTokens + static_cast<size_t>(slot) * (ngramLength + 1);
+    accepted[0] = newLastToken;
+    for (SizeType32 ti = 0; ti < maxHit; ++ti)
+    {
+        accepted[ti + 1] = golden[hitIdx * ngramLength + ti];
+    }
+    acceptedLengths[slot] = maxHit + 1;
+    bestGuessIds[slot] = hitIdx;
+}
+} // namespace
+
+void invokeResetLookaheadPool(LookaheadPoolParams const& params, cudaStream_t stream)
+{
+    params.checkParams();
+    resetLookaheadPool<<<params.batchSize, kResetBlockSize, 0, stream>>>(params);
+    sync_check_cuda_error();
+}
+
+void invokeAcceptLookaheadPool(LookaheadPoolParams const& params, TokenIdType const* prompts,
+    SizeType32 const* promptLengths, SizeType32 maxPromptLength, cudaStream_t stream)
+{
+    params.checkParams();
+    TLLM_CHECK(prompts);
+    TLLM_CHECK(promptLengths);
+    // One warp per request, the lanes compare the ngrams of a bucket.
+    acceptLookaheadPool<<<params.batchSize, 32, 0, stream>>>(params, prompts, promptLengths, maxPromptLength);
+    sync_check_cuda_error();
+}
+
+void invokeUpdateLookaheadPool(LookaheadPoolParams const& params, TokenIdType const* keyTokens,
+    TokenIdType const* ngramTokens, SizeType32 const* numInserts, SizeType32 maxNumInserts, cudaStream_t stream)
+{
+    params.checkParams();
+    TLLM_CHECK(keyTokens);
+    TLLM_CHECK(ngramTokens);
+    TLLM_CHECK(numInserts);
+    updateLookaheadPool<<<params.batchSize, 32, 0, stream>>>(params, keyTokens, ngramTokens, numInserts, maxNumInserts);
+    sync_check_cuda_error();
+}
+
+void invokeGuessLookaheadPool(LookaheadPoolParams const& params, TokenIdType const* lastTokens,
+    SizeType32 const* guessSizes, TokenIdType* guessTokens, SizeType32* numGuesses, cudaStream_t stream)
+{
+    params.checkParams();
+    TLLM_CHECK(lastTokens);
+    TLLM_CHECK(guessSizes);
+    TLLM_CHECK(guessTokens);
+    TLLM_CHECK(numGuesses);
+    guessLookaheadPool<<<params.batchSize, kGuessBlockSize, 0, stream>>>(
+        params, lastTokens, guessSizes, guessTokens, numGuesses);
+    sync_check_cuda_error();
+}
+
+void invokeVerifyLookaheadGuesses(LookaheadPoolParams const& params, TokenIdType const* guessTokens,
+    SizeType32 const* numGuesses, TokenIdType const* goldenTokens, TokenIdType const* newLastTokens,
+    TokenIdType const* endIds, TokenIdType* acceptedTokens, SizeType32* acceptedLengths, SizeType32* bestGuessIds,
+    cudaStream_t stream)
+{
+    params.checkParams();
+    TLLM_CHECK(guessTokens);
+    TLLM_CHECK(numGuesses);
+    TLLM_CHECK(goldenTokens);
+    TLLM_CHECK(newLastTokens);
+    TLLM_CHECK(endIds);
+    TLLM_CHECK(acceptedTokens);
+    TLLM_CHECK(acceptedLengths);
+    TLLM_CHECK(bestGuessIds);
+    auto const numBlocks = divUp(params.batchSize, kVerifyBlockSize);
+    verifyLookaheadGuesses<<<numBlocks, kVerifyBlockSize, 0, stream>>>(params, guessTokens, numGuesses, goldenTokens,
+        newLastTokens, endIds, acceptedTokens, acceptedLengths, bestGuessIds);
+    sync_check_cuda_error();
+}
+
+} // namespace tensorrt_llm::kernels::speculative_decoding
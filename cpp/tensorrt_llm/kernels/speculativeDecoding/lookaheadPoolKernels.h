@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm::kernels::speculative_decoding
+{
+
+//! \brief Key of the empty buckets of the lookahead n-gram pool.
+static constexpr runtime::TokenIdType kLookaheadPoolEmptyKey = -1;
+
+//! \brief Number of ngrams of a bucket handled by one warp, upper bound of maxGuessSetSize.
+static constexpr runtime::SizeType32 kLookaheadPoolMaxGuessSetSize = 32;
+
+//! \brief Device n-gram pool of lookahead decoding, the GPU counterpart of layers::LookaheadPoolManager.
+//! \details Every slot owns an open-addressing hash table of numBuckets buckets keyed by the first token of the
+//! n-grams. A bucket holds up to guessSetSizes[slot] n-grams of the following ngramLength tokens, oldest first.
+//! Inserting an n-gram already in the bucket moves it to the newest position, inserting into a full bucket drops the
+//! oldest one. When all probed buckets are taken by other keys, the home bucket of the key is evicted.
+struct LookaheadPoolParams
+{
+    //! [maxBatchSize, numBuckets], kLookaheadPoolEmptyKey for empty buckets
+    runtime::TokenIdType* keys{nullptr};
+    //! [maxBatchSize, numBuckets], number of ngrams of each bucket
+    runtime::SizeType32* counts{nullptr};
+    //! [maxBatchSize, numBuckets, maxGuessSetSize, ngramLength]
+    runtime::TokenIdType* ngrams{nullptr};
+    //! [maxBatchSize], maximum number of ngrams per key of each slot, in [0, maxGuessSetSize]
+    runtime::SizeType32 const* guessSetSizes{nullptr};
+    //! [forwardBatchSize]
+    runtime::SizeType32 const* batchSlots{nullptr};
+
+    runtime::SizeType32 batchSize{0};
+    runtime::SizeType32 numBuckets{0};
+    runtime::SizeType32 maxGuessSetSize{0};
+    //! N - 1 for lookahead decoding of level N
+    runtime::SizeType32 ngramLength{0};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(keys);
+        TLLM_CHECK(counts);
+        TLLM_CHECK(ngrams);
+        TLLM_CHECK(guessSetSizes);
+        TLLM_CHECK(batchSlots);
+
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(numBuckets > 0);
+        TLLM_CHECK(maxGuessSetSize > 0 && maxGuessSetSize <= kLookaheadPoolMaxGuessSetSize);
+        TLLM_CHECK(ngramLength > 0);
+    }
+};
+
+//! \brief Empties the pools of the slots, e.g. when new requests are set up.
+void invokeResetLookaheadPool(LookaheadPoolParams const& params, cudaStream_t stream);
+
+//! \brief Inserts the ngrams of the prompts into the pools, like LookaheadPoolManager::accept with level
+//! ngramLength + 1.
+//!
+//! \param prompts input buffer [forwardBatchSize, maxPromptLength]
+//! \param promptLengths input buffer [forwardBatchSize]
+void invokeAcceptLookaheadPool(LookaheadPoolParams const& params, runtime::TokenIdType const* prompts,
+    runtime::SizeType32 const* promptLengths, runtime::SizeType32 maxPromptLength, cudaStream_t stream);
+
+//! \brief Inserts ngrams into the pools in order, like LookaheadPoolManager::update.
+//!
+//! \param keyTokens input buffer [forwardBatchSize, maxNumInserts]
+//! \param ngramTokens input buffer [forwardBatchSize, maxNumInserts, ngramLength]
+//! \param numInserts input buffer [forwardBatchSize], number of ngrams inserted for each request
+void invokeUpdateLookaheadPool(LookaheadPoolParams const& params, runtime::TokenIdType const* keyTokens,
+    runtime::TokenIdType const* ngramTokens, runtime::SizeType32 const* numInserts, runtime::SizeType32 maxNumInserts,
+    cudaStream_t stream);
+
+//! \brief Gathers the newest ngrams following the last token of each request, like LookaheadPoolManager::guess.
+//!
+//! \param lastTokens input buffer [forwardBatchSize]
+//! \param guessSizes input buffer [maxBatchSize], maximum number of guesses of each slot
+//! \param guessTokens output buffer [maxBatchSize, maxGuessSetSize, ngramLength], oldest guess first
+//! \param numGuesses output buffer [maxBatchSize]
+void invokeGuessLookaheadPool(LookaheadPoolParams const& params, runtime::TokenIdType const* lastTokens,
+    runtime::SizeType32 const* guessSizes, runtime::TokenIdType* guessTokens, runtime::SizeType32* numGuesses,
+    cudaStream_t stream);
+
+//! \brief Verifies the guesses against the tokens of the target model, like the verification of LookaheadAlgorithm.
+//! \details Guess i is accepted up to its first token that differs from newLastToken (first position) or from the
+//! golden token of the previous position, or that is the end id. The guess with the longest accepted prefix wins, the
+//! first one on ties.
+//!
+//! \param guessTokens input buffer [maxBatchSize, maxGuessSetSize, ngramLength]
+//! \param numGuesses input buffer [maxBatchSize]
+//! \param goldenTokens input buffer [forwardBatchSize, maxGuessSetSize, ngramLength], target tokens at the guesses
+//! \param newLastTokens input buffer [forwardBatchSize], token sampled after the last accepted token
+//! \param endIds input buffer [maxBatchSize]
+//! \param acceptedTokens output buffer [maxBatchSize, ngramLength + 1], newLastToken followed by the accepted tokens
+//! \param acceptedLengths output buffer [maxBatchSize]
+//! \param bestGuessIds output buffer [maxBatchSize]
+void invokeVerifyLookaheadGuesses(LookaheadPoolParams const& params, runtime::TokenIdType const* guessTokens,
+    runtime::SizeType32 const* numGuesses, runtime::TokenIdType const* goldenTokens,
+    runtime::TokenIdType const* newLastTokens, runtime::TokenIdType const* endIds, runtime::TokenIdType* acceptedTokens,
+    runtime::SizeType32* acceptedLengths, runtime::SizeType32* bestGuessIds, cudaStream_t stream);
+
+} // namespace tensorrt_llm::kernels::speculative_decoding
@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaTypeUtils.cuh"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/speculativeDecoding/treeAttentionKernels.h"
+
+#include <cfloat>
+
+using namespace tensorrt_llm::common;
+
+namespace tensorrt_llm::kernels::speculative_decoding
+{
+namespace
+{
+static constexpr int kWarpSize = 32;
+static constexpr int kNumWarps = 8;
+static constexpr int kRowsPerWarp = kTreeAttentionRowsPerBlock / kNumWarps;
+//! One key per lane
+static constexpr int kKvTileSize = kWarpSize;
+
+static_assert(kRowsPerWarp * kNumWarps == kTreeAttentionRowsPerBlock);
+
+size_t getSmemBytes(int headSize)
+{
+    // Queries, K tile padded against bank conflicts, V tile
+    return sizeof(float)
+        * (kTreeAttentionRowsPerBlock * headSize + kKvTileSize * (headSize + 1) + kKvTileSize * headSize);
+}
+
+//! Block (rowTile, kvHead, request). Lane j of a warp computes the score of key j of the KV tile for each row of the
+//! warp, the lanes split the head dimension of the outputs.
+template <typename T, typename KVCacheBuffer, int DIMS_PER_LANE>
+__global__ void __launch_bounds__(kNumWarps* kWarpSize)
+    treeAttentionKernel(TreeAttentionParams<T, KVCacheBuffer> params)
+{
+    extern __shared__ float smem[];
+
+    auto const headSize = params.headSize;
+    auto const batchIdx = static_cast<int>(blockIdx.z);
+    auto const kvHeadIdx = static_cast<int>(blockIdx.y);
+    auto const headGrpSize = params.numQHeads / params.numKvHeads;
+    auto const qBegin = params.cuQSeqLens[batchIdx];
+    auto const qSeqLen = params.cuQSeqLens[batchIdx + 1] - qBegin;
+    auto const numRows = qSeqLen * headGrpSize;
+    auto const rowBegin = static_cast<int>(blockIdx.x) * kTreeAttentionRowsPerBlock;
+    if (rowBegin >= numRows)
+    {
+        return;
+    }
+    auto const pastKvLength = params.pastKvLengths[batchIdx];
+    auto const kvLength = pastKvLength + qSeqLen;
+    auto const numPackedMasks = (params.maxQSeqLen + 31) / 32;
+
+    float* sQ = smem;
+    float* sK = sQ + kTreeAttentionRowsPerBlock * headSize;
+    float* sV = sK + kKvTileSize * (headSize + 1);
+
+    for (int idx = threadIdx.x; idx < kTreeAttentionRowsPerBlock * headSize; idx += blockDim.x)
+    {
+        auto const row = rowBegin + idx / headSize;
+        auto const dim = idx % headSize;
+        float value = 0.f;
+        if (row < numRows)
+        {
+            auto const qIdx = qBegin + row / headGrpSize;
+            auto const headIdx = kvHeadIdx * headGrpSize + row % headGrpSize;
+            auto const qOffset = (static_cast<size_t>(qIdx) * params.numQHeads + headIdx) * headSize + dim;
+            value = cuda_cast<float>(params.q[qOffset]);
+        }
+        sQ[idx] = value;
+    }
+
+    auto const warpIdx = static_cast<int>(threadIdx.x) / kWarpSize;
+    auto const lane = static_cast<int>(threadIdx.x) % kWarpSize;
+
+    float acc[kRowsPerWarp][DIMS_PER_LANE];
+    float rowMax[kRowsPerWarp];
+    float rowSum[kRowsPerWarp];
+#pragma unroll
+    for (int ri = 0; ri < kRowsPerWarp; ++ri)
+    {
+        rowMax[ri] = -FLT_MAX;
+        rowSum[ri] = 0.f;
+#pragma unroll
+        for (int di = 0; di < DIMS_PER_LANE; ++di)
+        {
+            acc[ri][di] = 0.f;
+        }
+    }
+
+    for (int tileBegin = 0; tileBegin < kvLength; tileBegin += kKvTileSize)
+    {
+        // Every row of the block uses the KV tile, it is loaded once.
+        __syncthreads();
+        for (int idx = threadIdx.x; idx < kKvTileSize * headSize; idx += blockDim.x)
+        {
+            auto const key = idx / headSize;
+            auto const dim = idx % headSize;
+            auto const token = tileBegin + key;
+            float k = 0.f;
+            float v = 0.f;
+            if (token < kvLength)
+            {
+                auto const kvTokenIdx = params.kvCache.getKVTokenIdx(token);
+                auto const localIdx = params.kvCache.getKVLocalIdx(kvTokenIdx, kvHeadIdx, headSize, dim);
+                k = cuda_cast<float>(
+                    reinterpret_cast<T const*>(params.kvCache.getKBlockPtr(batchIdx, kvTokenIdx))[localIdx]);
+                v = cuda_cast<float>(
+                    reinterpret_cast<T const*>(params.kvCache.getVBlockPtr(batchIdx, kvTokenIdx))[localIdx]);
+            }
+            sK[key * (headSize + 1) + dim] = k;
+            sV[key * headSize + dim] = v;
+        }
+        __syncthreads();
+
+        auto const token = tileBegin + lane;
+#pragma unroll
+        for (int ri = 0; ri < kRowsPerWarp; ++ri)
+        {
+            auto const localRow = warpIdx * kRowsPerWarp + ri;
+            auto const row = rowBegin + localRow;
+            if (row >= numRows)
+            {
+                continue;
+            }
+            auto const treeIdx = row / headGrpSize;
+            bool visible = token < pastKvLength;
+            if (!visible && token < kvLength)
+            {
+                auto const key = token - pastKvLength;
+                auto const mask
+                    = params.packedMask[(batchIdx * params.maxQSeqLen + treeIdx) * numPackedMasks + key / 32];
+                visible = (mask >> (key % 32)) & 1;
+            }
+            float score = -FLT_MAX;
+            if (visible)
+            {
+                float dot = 0.f;
+                for (int dim = 0; dim < headSize; ++dim)
+                {
+                    dot += sQ[localRow * headSize + dim] * sK[lane * (headSize + 1) + dim];
+                }
+                score = dot * params.qkScale;
+            }
+
+            auto const newMax = fmaxf(rowMax[ri], warpReduceMax(score));
+            if (newMax == -FLT_MAX)
+            {
+                // Nothing visible yet
+                continue;
+            }
+            auto const alpha = __expf(rowMax[ri] - newMax);
+            auto const prob = visible ? __expf(score - newMax) : 0.f;
+            rowSum[ri] = rowSum[ri] * alpha + warpReduceSum(prob);
+            rowMax[ri] = newMax;
+#pragma unroll
+            for (int di = 0; di < DIMS_PER_LANE; ++di)
+            {
+                acc[ri][di] *= alpha;
+            }
+            for (int key = 0; key < kKvTileSize; ++key)
+            {
+                auto const keyProb = __shfl_sync(0xffffffff, prob, key);
+#pragma unroll
+                for (int di = 0; di < DIMS_PER_LANE; ++di)
+                {
+                    auto const dim = lane + di * kWarpSize;
+                    if (dim < headSize)
+                    {
+                        acc[ri][di] += keyProb * sV[key * headSize + dim];
+                    }
+                }
+            }
+        }
+    }
+
+#pragma unroll
+    for (int ri = 0; ri < kRowsPerWarp; ++ri)
+    {
+        auto const row = rowBegin + warpIdx * kRowsPerWarp + ri;
+        if (row >= numRows)
+        {
+            continue;
+        }
+        auto const qIdx = qBegin + row / headGrpSize;
+        auto const headIdx = kvHeadIdx * headGrpSize + row % headGrpSize;
+        auto* out = params.output + (static_cast<size_t>(qIdx) * params.numQHeads + headIdx) * headSize;
+        auto const invSum = rowSum[ri] > 0.f ? 1.f / rowSum[ri] : 0.f;
+#pragma unroll
+        for (int di = 0; di < DIMS_PER_LANE; ++di)
+        {
+            auto const dim = lane + di * kWarpSize;
+            if (dim < headSize)
+            {
+                out[dim] = cuda_cast<T>(acc[ri][di] * invSum);
+            }
+        }
+    }
+}
+
+template <typename T, typename KVCacheBuffer, int DIMS_PER_LANE>
+void launchTreeAttention(TreeAttentionParams<T, KVCacheBuffer> const& params, cudaStream_t stream)
+{
+    auto const kernel = treeAttentionKernel<T, KVCacheBuffer, DIMS_PER_LANE>;
+    auto const smemBytes = getSmemBytes(params.headSize);
+    if (smemBytes >= (48 << 10))
+    {
+        TLLM_CUDA_CHECK(cudaFuncSetAttribute(kernel, cudaFuncAttributeMaxDynamicSharedMemorySize, smemBytes));
+    }
+    auto const headGrpSize = params.numQHeads / params.numKvHeads;
+    dim3 const grid(divUp(params.maxQSeqLen * headGrpSize, kTreeAttentionRowsPerBlock), params.numKvHeads,
+        params.batchSize);
+    kernel<<<grid, kNumWarps * kWarpSize, smemBytes, stream>>>(params);
+}
+} // namespace
+
+template <typename T, typename KVCacheBuffer>
+void invokeTreeAttention(TreeAttentionParams<T, KVCacheBuffer> const& params, cudaStream_t stream)
+{
+    params.checkParams();
+    switch (divUp(params.headSize, kWarpSize))
+    {
+    case 1:
+        launchTreeAttention<T, KVCacheBuffer, 1>(params, stream);
+        break;
+    case 2:
+        launchTreeAttention<T, KVCacheBuffer, 2>(params, stream);
+        break;
+    case 3:
+        launchTreeAttention<T, KVCacheBuffer, 3>(params, stream);
+        break;
+    case 4:
+        launchTreeAttention<T, KVCacheBuffer, 4>(params, stream);
+        break;
+    case 5:
+        launchTreeAttention<T, KVCacheBuffer, 5>(params, stream);
+        break;
+    case 6:
+        launchTreeAttention<T, KVCacheBuffer, 6>(params, stream);
+        break;
+    case 7:
+        launchTreeAttention<T, KVCacheBuffer, 7>(params, stream);
+        break;
+    case 8:
+        launchTreeAttention<T, KVCacheBuffer, 8>(params, stream);
+        break;
+    default: TLLM_THROW("Head size %d is not supported by the tree attention", params.headSize);
+    }
+    sync_check_cuda_error();
+}
+
+#define INSTANTIATE_TREE_ATTENTION(T)                                                                                  \
+    template void invokeTreeAttention(TreeAttentionParams<T, KVLinearBuffer> const& params, cudaStream_t stream);      \
+    template void invokeTreeAttention(TreeAttentionParams<T, KVBlockArray> const& params, cudaStream_t stream)
+
+INSTANTIATE_TREE_ATTENTION(float);
+INSTANTIATE_TREE_ATTENTION(half);
+#ifdef ENABLE_BF16
+INSTANTIATE_TREE_ATTENTION(__nv_bfloat16);
+#endif
+
+#undef INSTANTIATE_TREE_ATTENTION
+
+} // namespace tensorrt_llm::kernels::speculative_decoding
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm::kernels::speculative_decoding
+{
+
+//! \brief Attention of the tree tokens of speculative decoding over the KV cache, e.g. Medusa or explicit draft
+//! tokens verification.
+//! \details The K and V of the tree tokens are already written to the KV cache after the past tokens of their request,
+//! tree token i attends to all past tokens and to the tree tokens whose bit is set in row i of the packed mask. The
+//! queries of one KV head are processed in tiles of kTreeAttentionRowsPerBlock rows, (tree token, q head of the
+//! group) pairs, and every tile loads each KV tile once for all of its rows. The KV traffic grows with the number of
+//! row tiles instead of the number of tree tokens. Cyclic KV caches are not supported, the past and tree tokens must
+//! fit into the attention window.
+template <typename T, typename KVCacheBuffer>
+struct TreeAttentionParams
+{
+    //! [numTokens, numQHeads, headSize], queries of the tree tokens packed over the requests, positional embedding
+    //! applied
+    T const* q{nullptr};
+    //! [numTokens, numQHeads, headSize]
+    T* output{nullptr};
+    //! KV cache of type T holding the past tokens followed by the tree tokens of each request
+    KVCacheBuffer kvCache;
+    //! [batchSize + 1], exclusive prefix sum of the number of tree tokens of the requests
+    int const* cuQSeqLens{nullptr};
+    //! [batchSize], number of tokens before the tree in the KV cache
+    int const* pastKvLengths{nullptr};
+    //! [batchSize, maxQSeqLen, divUp(maxQSeqLen, 32)], bit k of row i is set if tree token i attends to tree token k
+    int const* packedMask{nullptr};
+
+    int batchSize{0};
+    int maxQSeqLen{0};
+    int numQHeads{0};
+    int numKvHeads{0};
+    int headSize{0};
+    //! Scale of the QK products, usually 1 / (sqrt(headSize) * qScaling)
+    float qkScale{1.f};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(q);
+        TLLM_CHECK(output);
+        TLLM_CHECK(cuQSeqLens);
+        TLLM_CHECK(pastKvLengths);
+        TLLM_CHECK(packedMask);
+
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxQSeqLen > 0);
+        TLLM_CHECK(numKvHeads > 0 && numQHeads % numKvHeads == 0);
+        TLLM_CHECK(headSize > 0 && headSize <= 256);
+    }
+};
+
+//! \brief Rows of queries, (tree token, q head) pairs sharing a KV head, processed by one thread block.
+static constexpr int kTreeAttentionRowsPerBlock = 64;
+
+template <typename T, typename KVCacheBuffer>
+void invokeTreeAttention(TreeAttentionParams<T, KVCacheBuffer> const& params, cudaStream_t stream);
+
+} // namespace tensorrt_llm::kernels::speculative_decoding
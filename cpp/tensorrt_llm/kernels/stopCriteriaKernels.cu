@@ -31,7 +31,7 @@ namespace
 __global__ void stopWordsCriterion(TokenIdType const** outputIds, SizeType32 const** parentIds,
     TokenIdType const** stopWords, FinishedState* finished, SizeType32* sequenceLengths, SizeType32 const* batchSlots,
     SizeType32 const* stopWordsLens, SizeType32* numNewTokens, SizeType32 batchSize, SizeType32 beamWidth,
-    SizeType32 maxSeqLen)
+    SizeType32 maxSeqLen, bool const* skipSlots)
 {
     auto const id = static_cast<SizeType32>(blockIdx.x * blockDim.x + threadIdx.x);
     auto const batchIdx = blockIdx.y / beamWidth;
@@ -40,6 +40,11 @@ __global__ void stopWordsCriterion(TokenIdType const** outputIds, SizeType32 con
     auto const batchBeamIdx = batchSlot * beamWidth + beamIdx;
     auto const newTokens = numNewTokens ? numNewTokens[batchSlot] : 1;
 
+    if (skipSlots != nullptr && skipSlots[batchSlot])
+    {
+        return;
+    }
+
     auto const* baseStopWords = stopWords[batchSlot];
     auto const stopWordsLen = stopWordsLens[batchSlot];
     auto const* baseOffsets = baseStopWords + stopWordsLen;
@@ -115,7 +120,7 @@ __global__ void stopWordsCriterion(TokenIdType const** outputIds, SizeType32 con
 void invokeStopWordsCriterion(TokenIdType const** outputIds, SizeType32 const** parentIds,
     TokenIdType const** stopWords, FinishedState* finished, SizeType32* sequenceLengths, SizeType32 const* batchSlots,
     SizeType32 const* stopWordsLen, SizeType32* numNewTokens, SizeType32 maxStopWordsLen, SizeType32 batchSize,
-    SizeType32 beamWidth, SizeType32 maxSeqLen, cudaStream_t stream)
+    SizeType32 beamWidth, SizeType32 maxSeqLen, bool const* skipSlots, cudaStream_t stream)
 {
     // Check if we have sampled a word from the stopWords list. If so, stop the sequence.
     dim3 block, grid;
@@ -126,7 +131,7 @@ void invokeStopWordsCriterion(TokenIdType const** outputIds, SizeType32 const**
     grid.y = batchSize * beamWidth;
 
     stopWordsCriterion<<<grid, block, 0, stream>>>(outputIds, parentIds, stopWords, finished, sequenceLengths,
-        batchSlots, stopWordsLen, numNewTokens, batchSize, beamWidth, maxSeqLen);
+        batchSlots, stopWordsLen, numNewTokens, batchSize, beamWidth, maxSeqLen, skipSlots);
     sync_check_cuda_error();
 }
 
@@ -195,8 +200,8 @@ void invokeLengthCriterion(FinishedState* finished, SizeType32* finishedSum, Siz
 }
 
 __global__ void explicitEOSCriterion(TokenIdType const** outputIds, TokenIdType const* endIds, FinishedState* finished,
-    SizeType32* sequenceLengths, SizeType32* numNewTokens, SizeType32 const* batchSlots, SizeType32 batchSize,
-    SizeType32 maxTokensPerStep)
+    SizeType32* sequenceLengths, SizeType32* numNewTokens, SizeType32* finishedSlots, SizeType32 const* batchSlots,
+    SizeType32 batchSize, SizeType32 maxTokensPerStep)
 {
     auto const batchIdx = blockIdx.x * blockDim.x + threadIdx.x;
     if (batchIdx >= batchSize)
@@ -227,14 +232,18 @@ __global__ void explicitEOSCriterion(TokenIdType const** outputIds, TokenIdType
             {
                 numNewTokens[batchSlot] = pos - posStart;
             }
+            if (finishedSlots)
+            {
+                atomicOr(&finishedSlots[batchSlot / 32], static_cast<SizeType32>(1u << (batchSlot % 32)));
+            }
             return;
         }
     }
 }
 
 void invokeExplicitEOSCriterion(TokenIdType const** outputIds, TokenIdType const* endIds, FinishedState* finished,
-    SizeType32* sequenceLengths, SizeType32* numNewTokens, SizeType32 const* batchSlots, SizeType32 batchSize,
-    SizeType32 beamWidth, SizeType32 maxTokensPerStep, cudaStream_t stream)
+    SizeType32* sequenceLengths, SizeType32* numNewTokens, SizeType32* finishedSlots, SizeType32 const* batchSlots,
+    SizeType32 batchSize, SizeType32 beamWidth, SizeType32 maxTokensPerStep, cudaStream_t stream)
 {
     TLLM_CHECK_WITH_INFO(beamWidth == 1, "Explicit EOS criterion does not support beam search");
     // Check if we have sampled an end id token. If so, stop the sequence.
@@ -243,8 +252,8 @@ void invokeExplicitEOSCriterion(TokenIdType const** outputIds, TokenIdType const
     dim3 grid;
     grid.x = divUp(batchSize, blockSize);
 
-    explicitEOSCriterion<<<grid, blockSize, 0, stream>>>(
-        outputIds, endIds, finished, sequenceLengths, numNewTokens, batchSlots, batchSize, maxTokensPerStep);
+    explicitEOSCriterion<<<grid, blockSize, 0, stream>>>(outputIds, endIds, finished, sequenceLengths, numNewTokens,
+        finishedSlots, batchSlots, batchSize, maxTokensPerStep);
     sync_check_cuda_error();
 }
 
@@ -46,12 +46,13 @@ namespace kernels
 //! \param batchSize batch size
 //! \param beamWidth beam width
 //! \param maxSeqLen maximum length of the sequence
+//! \param skipSlots input buffer [maxBatchSize], optional. Requests to skip, e.g. checked with invokeStopWordsAutomaton
 //! \param stream stream
 void invokeStopWordsCriterion(runtime::TokenIdType const** outputIds, runtime::SizeType32 const** parentIds,
     runtime::TokenIdType const** stopWords, FinishedState* finished, runtime::SizeType32* sequenceLengths,
     runtime::SizeType32 const* batchSlots, runtime::SizeType32 const* stopWordsLen, runtime::SizeType32* numNewTokens,
     runtime::SizeType32 maxStopWordsLen, runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth,
-    runtime::SizeType32 maxSeqLen, cudaStream_t stream);
+    runtime::SizeType32 maxSeqLen, bool const* skipSlots, cudaStream_t stream);
 
 //! \brief Sets finished states based on the sequenceLimitLength and computes number of finished sequences in the batch.
 //!
@@ -85,6 +86,8 @@ void invokeLengthCriterion(FinishedState* finished, runtime::SizeType32* finishe
 //! Current sequence lengths of the request tokens.
 //! \param numNewTokens input/output buffer [maxBatchSize], optional. Number of tokens per step for each request.
 //! It is assumed that all requests have maxTokensPerStep tokens per step if nullptr.
+//! \param finishedSlots output buffer [divUp(maxBatchSize, 32)], optional. Bit `batchSlot % 32` of word
+//! `batchSlot / 32` is set if the request finished at this step, the other bits are unchanged.
 //! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
 //! \param batchSize batch size
 //! \param beamWidth beam width. beamWidth > 1 is not supported for now.
@@ -92,7 +95,7 @@ void invokeLengthCriterion(FinishedState* finished, runtime::SizeType32* finishe
 //! \param stream stream
 void invokeExplicitEOSCriterion(runtime::TokenIdType const** outputIds, runtime::TokenIdType const* endIds,
     FinishedState* finished, runtime::SizeType32* sequenceLengths, runtime::SizeType32* numNewTokens,
-    runtime::SizeType32 const* batchSlots, runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth,
-    runtime::SizeType32 maxTokensPerStep, cudaStream_t stream);
+    runtime::SizeType32* finishedSlots, runtime::SizeType32 const* batchSlots, runtime::SizeType32 batchSize,
+    runtime::SizeType32 beamWidth, runtime::SizeType32 maxTokensPerStep, cudaStream_t stream);
 } // namespace kernels
 } // namespace tensorrt_llm
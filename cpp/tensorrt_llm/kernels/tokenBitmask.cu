@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/tokenBitmask.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T>
+__global__ void applyTokenBitmask(T* logits, std::uint32_t const* bitmasks, SizeType32 const* batchIndices,
+    SizeType32 vocabSize, SizeType32 vocabSizePadded)
+{
+    auto const maskIdx = blockIdx.y;
+    auto const numWords = (vocabSize + 31) / 32;
+    auto* rowLogits = logits + static_cast<std::size_t>(batchIndices[maskIdx]) * vocabSizePadded;
+    auto const* rowMask = bitmasks + static_cast<std::size_t>(maskIdx) * numWords;
+
+    // The threads of a warp share one mask word
+    for (auto tokenId = static_cast<SizeType32>(blockIdx.x * blockDim.x + threadIdx.x); tokenId < vocabSizePadded;
+         tokenId += blockDim.x * gridDim.x)
+    {
+        bool const allowed = tokenId < vocabSize && ((rowMask[tokenId / 32] >> (tokenId % 32)) & 1u);
+        if (!allowed)
+        {
+            rowLogits[tokenId] = static_cast<T>(-INFINITY);
+        }
+    }
+}
+
+template <typename T>
+void invokeApplyTokenBitmask(T* logits, std::uint32_t const* bitmasks, SizeType32 const* batchIndices,
+    SizeType32 numMasks, SizeType32 vocabSize, SizeType32 vocabSizePadded, cudaStream_t stream)
+{
+    if (numMasks == 0)
+    {
+        return;
+    }
+    dim3 const block{256};
+    // Enough blocks to cover a 256k vocabulary with one token per thread
+    dim3 const grid{std::min(static_cast<std::uint32_t>(ceilDiv(vocabSizePadded, block.x)), 1024u),
+        static_cast<std::uint32_t>(numMasks)};
+    applyTokenBitmask<<<grid, block, 0, stream>>>(logits, bitmasks, batchIndices, vocabSize, vocabSizePadded);
+    sync_check_cuda_error();
+}
+
+template void invokeApplyTokenBitmask(half* logits, std::uint32_t const* bitmasks, SizeType32 const* batchIndices,
+    SizeType32 numMasks, SizeType32 vocabSize, SizeType32 vocabSizePadded, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeApplyTokenBitmask(__nv_bfloat16* logits, std::uint32_t const* bitmasks,
+    SizeType32 const* batchIndices, SizeType32 numMasks, SizeType32 vocabSize, SizeType32 vocabSizePadded,
+    cudaStream_t stream);
+#endif
+template void invokeApplyTokenBitmask(float* logits, std::uint32_t const* bitmasks, SizeType32 const* batchIndices,
+    SizeType32 numMasks, SizeType32 vocabSize, SizeType32 vocabSizePadded, cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+#include <cuda_fp16.h>
+#include <cuda_runtime.h>
+
+#include <cstdint>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+//! \brief Set the logits of the tokens that a bitmask does not allow to -inf.
+//! \param logits [batchSize, vocabSizePadded]
+//! \param bitmasks [numMasks, ceilDiv(vocabSize, 32)], bit `t % 32` of word `t / 32` is set if token `t` is allowed.
+//! Padding tokens beyond vocabSize are never allowed.
+//! \param batchIndices [numMasks], the row of logits each mask applies to
+template <typename T>
+void invokeApplyTokenBitmask(T* logits, std::uint32_t const* bitmasks, runtime::SizeType32 const* batchIndices,
+    runtime::SizeType32 numMasks, runtime::SizeType32 vocabSize, runtime::SizeType32 vocabSizePadded,
+    cudaStream_t stream);
+
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef CUDART_VERSION
+#error CUDART_VERSION Undefined!
+#elif (CUDART_VERSION >= 11050)
+#include <cub/cub.cuh>
+#else
+#include "3rdparty/cub/cub.cuh"
+#endif
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/topLogProbsKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T, int BLOCK_SIZE, int MAX_K>
+__global__ void topLogProbs(TopLogProbsKernelParams<T> params)
+{
+    using TopKReduce = cub::BlockReduce<TopK<float, MAX_K>, BLOCK_SIZE>;
+    using SumReduce = cub::BlockReduce<float, BLOCK_SIZE>;
+    __shared__ union
+    {
+        typename TopKReduce::TempStorage topK;
+        typename SumReduce::TempStorage sum;
+    } tempStorage;
+    __shared__ float sMaxLogit;
+
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const tid = static_cast<SizeType32>(threadIdx.x);
+    auto const batchSlot = params.batchSlots != nullptr ? params.batchSlots[batchIdx] : batchIdx;
+
+    if (params.finishedInput != nullptr && params.finishedInput[batchSlot].isFinished())
+    {
+        return;
+    }
+    auto const numTop = min(params.numTopLogProbs[batchSlot], params.maxNumTopLogProbs);
+    auto const step = params.sequenceLengths[batchSlot];
+    if (numTop <= 0 || step >= params.maxSeqLen)
+    {
+        return;
+    }
+
+    auto const logits = params.logits + batchIdx * params.vocabSizePadded;
+
+    TopK<float, MAX_K> partial;
+    partial.init();
+    for (auto vi = tid; vi < params.vocabSize; vi += BLOCK_SIZE)
+    {
+        partial.insert(static_cast<float>(logits[vi]), vi);
+    }
+    auto const top = TopKReduce(tempStorage.topK).Reduce(partial, reduce_topk_op<float, MAX_K>);
+    if (tid == 0)
+    {
+        sMaxLogit = top.u[0];
+    }
+    __syncthreads();
+    auto const maxLogit = sMaxLogit;
+
+    float localSum = 0.f;
+    for (auto vi = tid; vi < params.vocabSize; vi += BLOCK_SIZE)
+    {
+        localSum += __expf(static_cast<float>(logits[vi]) - maxLogit);
+    }
+    auto const sum = SumReduce(tempStorage.sum).Sum(localSum);
+
+    if (tid == 0)
+    {
+        auto const logSumExp = maxLogit + __logf(sum);
+        auto const offset = (batchSlot * params.maxSeqLen + step) * params.maxNumTopLogProbs;
+        for (SizeType32 ki = 0; ki < numTop; ++ki)
+        {
+            params.topLogProbIds[offset + ki] = top.p[ki];
+            params.topLogProbs[offset + ki] = top.u[ki] - logSumExp;
+        }
+    }
+}
+
+template <typename T>
+void invokeTopLogProbs(TopLogProbsKernelParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+
+    SizeType32 constexpr BLOCK_SIZE = 128;
+    topLogProbs<T, BLOCK_SIZE, TOP_LOG_PROBS_MAX><<<params.batchSize, BLOCK_SIZE, 0, stream>>>(params);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeTopLogProbs(TopLogProbsKernelParams<float> const& params, cudaStream_t stream);
+template void invokeTopLogProbs(TopLogProbsKernelParams<half> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/runtime/common.h"
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+//! Largest number of alternatives returned per generated token.
+static constexpr runtime::SizeType32 TOP_LOG_PROBS_MAX = 20;
+
+template <typename T>
+struct TopLogProbsKernelParams
+{
+    //! input buffer [batchSize, vocabSizePadded], required. Logits of the step, after the penalties.
+    T const* logits{nullptr};
+    //! input buffer [maxBatchSize], required. Number of alternatives per request, in [0, maxNumTopLogProbs].
+    runtime::SizeType32 const* numTopLogProbs{nullptr};
+    //! input buffer [maxBatchSize], required. Position of the generated token of each request.
+    runtime::SizeType32 const* sequenceLengths{nullptr};
+    //! input buffer[batchSize], optional. Indices of rows of data in memory pool.
+    runtime::SizeType32 const* batchSlots{nullptr};
+    //! input buffer [maxBatchSize], optional. Finished requests are skipped.
+    FinishedState const* finishedInput{nullptr};
+
+    //! output buffers [maxBatchSize, maxSeqLen, maxNumTopLogProbs], required. Log probs of the most probable tokens
+    //! and their ids in descending order, written at the position of the generated token.
+    float* topLogProbs{nullptr};
+    runtime::TokenIdType* topLogProbIds{nullptr};
+
+    runtime::SizeType32 batchSize{-1};
+    runtime::SizeType32 maxBatchSize{-1};
+    runtime::SizeType32 maxSeqLen{-1};
+    runtime::SizeType32 vocabSize{-1};
+    runtime::SizeType32 vocabSizePadded{-1};
+    runtime::SizeType32 maxNumTopLogProbs{-1};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxBatchSize > 0);
+        TLLM_CHECK(maxBatchSize >= batchSize);
+        TLLM_CHECK(maxSeqLen > 0);
+        TLLM_CHECK(vocabSize > 0);
+        TLLM_CHECK(vocabSizePadded >= vocabSize);
+        TLLM_CHECK(0 < maxNumTopLogProbs && maxNumTopLogProbs <= TOP_LOG_PROBS_MAX);
+        TLLM_CHECK(logits);
+        TLLM_CHECK(numTopLogProbs);
+        TLLM_CHECK(sequenceLengths);
+        TLLM_CHECK(topLogProbs);
+        TLLM_CHECK(topLogProbIds);
+    }
+};
+
+//! \brief Computes the log probs of the numTopLogProbs most probable tokens of each request from the logits of the
+//! step, so that the alternatives of the generated tokens can be returned without the full logits. One block per
+//! request selects the top tokens and the log-sum-exp of the row in one pass over the logits, ties are ordered by
+//! token id. Requests with numTopLogProbs == 0 are skipped.
+template <typename T>
+void invokeTopLogProbs(TopLogProbsKernelParams<T> const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -177,16 +177,55 @@ INSTANTIATE_ADDQKVBIASIA3_TRANSPOSE(__nv_bfloat16);
 #endif
 #undef INSTANTIATEADDQKVBIASTRANSPOSE
 
+// The bucket of the relative position (ki - qi) in the relative attention bias table of T5, see
+// buildRelativeAttentionBiasKernel.cu. bidirectional=true for the encoder, false for the decoder.
+__device__ inline int relativeAttentionBucket(
+    int relative_position, int num_buckets, int const max_distance, bool const bidirectional)
+{
+    int relative_buckets = 0;
+    if (bidirectional)
+    {
+        num_buckets /= 2;
+        relative_buckets += relative_position > 0 ? num_buckets : 0;
+        relative_position = abs(relative_position);
+    }
+    else
+    {
+        relative_position = relative_position > 0 ? 0 : -relative_position;
+    }
+
+    int max_exact = num_buckets / 2;
+    bool is_small = relative_position < max_exact;
+    int relative_position_if_large = max_exact
+        + (int) (logf(relative_position * 1.0f / max_exact) / logf((float) max_distance / max_exact)
+            * (num_buckets - max_exact));
+    relative_position_if_large = min(relative_position_if_large, num_buckets - 1);
+    return relative_buckets + (is_small ? relative_position : relative_position_if_large);
+}
+
+// The relative attention bias of the positions {relative_position, relative_position + 1} of a head.
+template <typename T2, typename T>
+__device__ inline T2 relativeAttentionBias2(
+    T const* head_bias, int relative_position, int num_buckets, int max_distance, bool bidirectional)
+{
+    float2 f2;
+    f2.x = (float) head_bias[relativeAttentionBucket(relative_position, num_buckets, max_distance, bidirectional)];
+    f2.y = (float) head_bias[relativeAttentionBucket(relative_position + 1, num_buckets, max_distance, bidirectional)];
+    return cuda_cast<T2>(f2);
+}
+
 template <typename T, typename T_IN, int ITEMS_PER_THREAD>
 __global__ void softmax_kernel(T* attn_score, const T_IN* qk, T const* attn_mask, T const* linear_bias_slopes,
     const int64_t batch_size, const int64_t head_num, const int64_t q_length, const int64_t k_length,
     float const qk_scale, float const qk_tanh_scale, float const qk_tanh_inverse_scale, bool const block_sparse_attn,
-    BlockSparseParams const block_sparse_params, int const* q_seq_lengths)
+    BlockSparseParams const block_sparse_params, int const* q_seq_lengths, T const* relative_attention_bias,
+    int const relative_attention_bias_stride, int const max_distance, bool const relative_attention_bidirectional)
 {
     // attn_score, [batch_size, num_heads, q_length, k_length]
     // qk, [batch_size, num_heads, q_length, k_length]
     // attn_mask, [batch_size, q_length, k_length]
     // linear_bias_slopes, [num_heads]
+    // relative_attention_bias, [num_heads, relative_attention_bias_stride]
 
     const int64_t bi = blockIdx.y; // Batch index.
     const int64_t hi = blockIdx.z; // Head index.
@@ -210,6 +249,13 @@ __global__ void softmax_kernel(T* attn_score, const T_IN* qk, T const* attn_mask
             float qk_val = static_cast<float>(qk[qk_offset]);
             float qk_bias = 0.0f;
 
+            if (relative_attention_bias != nullptr)
+            {
+                int const bucket = relativeAttentionBucket(
+                    ki - qi, relative_attention_bias_stride, max_distance, relative_attention_bidirectional);
+                qk_val += static_cast<float>(relative_attention_bias[hi * relative_attention_bias_stride + bucket]);
+            }
+
             if (linear_bias_slopes != nullptr)
             {
                 // We don't handle the upper diagonal (ki > qi) separately, whose values
@@ -275,12 +321,14 @@ template <typename T, int ITEMS_PER_THREAD>
 __global__ void softmax_kernel_h2(T* attn_score, T const* qk_buf, T const* attn_mask, T const* linear_bias_slopes,
     const int64_t batch_size, const int64_t head_num, const int64_t q_length, const int64_t k_length, const T qk_scale,
     float const qk_tanh_scale, float const qk_tanh_inverse_scale, bool const block_sparse_attn,
-    BlockSparseParams const block_sparse_params, int const* q_seq_lengths)
+    BlockSparseParams const block_sparse_params, int const* q_seq_lengths, T const* relative_attention_bias,
+    int const relative_attention_bias_stride, int const max_distance, bool const relative_attention_bidirectional)
 {
     // attn_score, [batch_size, num_heads, q_length, k_length]
     // qk, [batch_size, num_heads, q_length, k_length]
     // attn_mask, [batch_size, q_length, k_length]
     // linear_bias_slopes, [num_heads]
+    // relative_attention_bias, [num_heads, relative_attention_bias_stride]
 
     using T2 = typename TypeConverter<T>::Type;
 
@@ -320,6 +368,13 @@ __global__ void softmax_kernel_h2(T* attn_score, T const* qk_buf, T const* attn_
 
             // The value of QK^T matrix at (qi, ki).
             T2 qk = qk_buf_h2[qk_offset];
+
+            if (relative_attention_bias != nullptr)
+            {
+                qk = hadd2<T2>(qk,
+                    relativeAttentionBias2<T2>(relative_attention_bias + hi * relative_attention_bias_stride,
+                        2 * ki - qi, relative_attention_bias_stride, max_distance, relative_attention_bidirectional));
+            }
             // The bias value to the position (qi, ki) including both mask and positional bias.
             T2 qk_bias = ZERO;
 
@@ -394,12 +449,14 @@ template <typename T, int K_ITEMS_PER_THREAD, int Q_ITEMS_PER_THREAD>
 __global__ void softmax_kernel_h2_v2(T* attn_score, T const* qk_buf, T const* attn_mask, T const* linear_bias_slopes,
     const int64_t batch_size, const int64_t head_num, const int64_t q_length, const int64_t k_length, const T scalar,
     float const qk_tanh_scale, float const qk_tanh_inverse_scale, bool const block_sparse_attn,
-    BlockSparseParams const block_sparse_params, int const* q_seq_lengths)
+    BlockSparseParams const block_sparse_params, int const* q_seq_lengths, T const* relative_attention_bias,
+    int const relative_attention_bias_stride, int const max_distance, bool const relative_attention_bidirectional)
 {
     // attn_score, [batch_size, num_heads, q_length, k_length]
     // qk, [batch_size, num_heads, q_length, k_length]
     // attn_mask, [batch_size, q_length, k_length]
     // linear_bias_slopes, [num_heads]
+    // relative_attention_bias, [num_heads, relative_attention_bias_stride]
 
     using T2 = typename TypeConverter<T>::Type;
 
@@ -472,6 +529,18 @@ __global__ void softmax_kernel_h2_v2(T* attn_score, T const* qk_buf, T const* at
                 qk[j] = qk_buf_h2[qk_offset[j]];
             }
 
+            if (relative_attention_bias != nullptr)
+            {
+                for (int j = 0; j < q_items; j++)
+                {
+                    int64_t qidx = qi + j * gridDim.x;
+                    qk[j] = hadd2<T2>(qk[j],
+                        relativeAttentionBias2<T2>(relative_attention_bias + hi * relative_attention_bias_stride,
+                            2 * ki - qidx, relative_attention_bias_stride, max_distance,
+                            relative_attention_bidirectional));
+                }
+            }
+
             T2 pos_bias[Q_ITEMS_PER_THREAD];
             if (linear_bias_slopes != nullptr)
             {
@@ -601,7 +670,8 @@ __global__ void softmax_kernel_h2_v2(T* attn_score, T const* qk_buf, T const* at
                 (const T_*) param.qk, (const T_*) param.attention_mask, (const T_*) param.linear_bias_slopes,          \
                 param.batch_size, param.num_heads, param.q_length, param.k_length, (const T_) param.qk_scale,          \
                 param.qk_tanh_scale, param.qk_tanh_inverse_scale, param.block_sparse_attn, param.block_sparse_params,  \
-                param.q_seq_lengths);                                                                                  \
+                param.q_seq_lengths, (const T_*) param.relative_attention_bias,                                        \
+                param.relative_attention_bias_stride, param.max_distance, param.relative_attention_bidirectional);     \
         }                                                                                                              \
         else                                                                                                           \
         {                                                                                                              \
@@ -609,7 +679,8 @@ __global__ void softmax_kernel_h2_v2(T* attn_score, T const* qk_buf, T const* at
                 (const T_*) param.qk, (const T_*) param.attention_mask, (const T_*) param.linear_bias_slopes,          \
                 param.batch_size, param.num_heads, param.q_length, param.k_length, (const T_) param.qk_scale,          \
                 param.qk_tanh_scale, param.qk_tanh_inverse_scale, param.block_sparse_attn, param.block_sparse_params,  \
-                param.q_seq_lengths);                                                                                  \
+                param.q_seq_lengths, (const T_*) param.relative_attention_bias,                                        \
+                param.relative_attention_bias_stride, param.max_distance, param.relative_attention_bidirectional);     \
         }                                                                                                              \
     }                                                                                                                  \
     else                                                                                                               \
@@ -617,7 +688,8 @@ __global__ void softmax_kernel_h2_v2(T* attn_score, T const* qk_buf, T const* at
         softmax_kernel<T, T_IN, ITEMS_PER_THREAD><<<grid, block, 0, stream>>>(param.attention_score, param.qk,         \
             param.attention_mask, param.linear_bias_slopes, param.batch_size, param.num_heads, param.q_length,         \
             param.k_length, param.qk_scale, param.qk_tanh_scale, param.qk_tanh_inverse_scale, param.block_sparse_attn, \
-            param.block_sparse_params, param.q_seq_lengths);                                                           \
+            param.block_sparse_params, param.q_seq_lengths, param.relative_attention_bias,                             \
+            param.relative_attention_bias_stride, param.max_distance, param.relative_attention_bidirectional);         \
     }
 
 #define LAUNCH_MASKED_SOFTMAX(ITEMS_PER_THREAD) LAUNCH_MASKED_SOFTMAX_(half, ITEMS_PER_THREAD)
@@ -1746,7 +1818,7 @@ __global__ void addRelativeAttentionBiasUnaligned(T* qk_buf, const BT* relative_
     int const seq_i = blockIdx.x;
     int const batch_id = blockIdx.y / head_num;
     int const head_id = blockIdx.y % head_num;
-    int const rel_attn_table_stride = num_buckets; // num_buckets could be modified below, save it beforehand
+    int const rel_attn_table_stride = num_buckets;
 
     for (int seq_j = threadIdx.x; seq_j < seq_len; seq_j += blockDim.x)
     {
@@ -1757,28 +1829,8 @@ __global__ void addRelativeAttentionBiasUnaligned(T* qk_buf, const BT* relative_
         if (implicit)
         {
             // compute bias value on the fly (see bert_preprocess_kernels.cu::buildRelativeAttentionBias)
-            int relative_buckets = 0;
-            int relative_position = seq_j - seq_i;
-
-            // special logic in T5 relative attention. bidirectional=true for encoder, false for decoder
-            if (bidirectional)
-            {
-                num_buckets /= 2;
-                relative_buckets += relative_position > 0 ? num_buckets : 0;
-                relative_position = abs(relative_position);
-            }
-            else
-            {
-                relative_position = relative_position > 0 ? 0 : -relative_position;
-            }
-
-            int max_exact = num_buckets / 2;
-            bool is_small = relative_position < max_exact;
-            int relative_position_if_large = max_exact
-                + (int) (logf(relative_position * 1.0f / max_exact) / logf((float) max_distance / max_exact)
-                    * (num_buckets - max_exact));
-            relative_position_if_large = min(relative_position_if_large, num_buckets - 1);
-            relative_buckets += is_small ? relative_position : relative_position_if_large;
+            int const relative_buckets
+                = relativeAttentionBucket(seq_j - seq_i, num_buckets, max_distance, bidirectional);
             BT rel_attn_bias = relative_attention_bias[head_id * rel_attn_table_stride + relative_buckets];
             qk_buf[qk_index] = (T) add((T) rel_attn_bias, qk_buf[qk_index]);
         }
@@ -1817,215 +1869,6 @@ INSTANTIATE_ADD_RELATIVE_ATTENTION_BIAS_UNALIGNED(float, __nv_bfloat16);
 #endif
 #undef INSTANTIATE_ADD_RELATIVE_ATTENTION_BIAS_UNALIGNED
 
-template <typename T, typename T_cache, typename KVCacheBuffer>
-__global__ void shiftKCache(KVCacheBuffer kvCacheBuffer, KVLinearBuffer shiftKCacheBuffer, int const sizePerHead,
-    int const timestep, int const beam_width, int const maxKCacheLen, int const sinkTokenLen,
-    float const* kScaleQuantOrig, int const* sequence_lengths, int const* input_lengths, int const rotary_embedding_dim,
-    float rotary_embedding_base, RotaryScalingType const rotary_scale_type, float rotary_embedding_scale,
-    int const rotary_embedding_max_positions, PositionEmbeddingType const position_embedding_type)
-{
-    // We allow only fp32/fp16/bf16 as the data types to apply rotary
-    static_assert(sizeof(T) == 4 || sizeof(T) == 2, "");
-    // Use 8bit cache.
-    static constexpr bool ENABLE_8BITS_CACHE = sizeof(T_cache) == 1;
-    // FP8 KV Cache.
-    [[maybe_unused]] static constexpr bool FP8_K_CACHE = std::is_same<T_cache, __nv_fp8_e4m3>::value;
-    // INT8 KV Cache.
-    static constexpr bool INT8_K_CACHE = std::is_same<T_cache, int8_t>::value;
-
-    extern __shared__ __align__(sizeof(float2)) char smem_[]; // align on largest vector type
-    // Each thread will handle 16 bytes.
-    constexpr int vec_size = 16u / sizeof(T);
-    using Vec_k = typename mmha::packed_type<T, vec_size>::type;
-    using Vec_k_cache = typename mmha::packed_type<T_cache, vec_size>::type;
-    using T_dst = T;
-    int const sizePerHeadDivX = sizePerHead / vec_size;
-
-    // The start token idx for the cyclic part in k cache
-    int const cyclic_k_cache_start_idx
-        = (timestep <= maxKCacheLen) ? sinkTokenLen : sinkTokenLen + timestep - maxKCacheLen;
-    // The token idx
-    int token_idx
-        = (kvCacheBuffer.isSinkToken(blockIdx.x)) ? blockIdx.x : cyclic_k_cache_start_idx + blockIdx.x - sinkTokenLen;
-    // The position idx
-    int const token_pos_idx = blockIdx.x;
-    // Head
-    int const head_idx = blockIdx.y;
-    // The batch beam idx
-    int const batch_beam_idx = blockIdx.z;
-    // The beam idx
-    int const beam_idx = batch_beam_idx % beam_width;
-    // Thread idx
-    int const tidx = threadIdx.x;
-
-    // The actual sequence length excluding the paddings.
-    // minus 1 because it includes the current timestep while tlength denotes the past token length.
-    int const tlength = sequence_lengths[batch_beam_idx] - 1;
-    // The context length
-    int const inlength = input_lengths[batch_beam_idx];
-    // The k cache valid token length
-    int const cache_length = (tlength > maxKCacheLen) ? maxKCacheLen : tlength;
-    // Mask out the tokens exceed the real total length and tokens in the context phase with beam_idx>0
-    bool const valid_seq = token_idx < tlength && !(token_idx < inlength && beam_idx > 0);
-    bool const is_head_size_masked = tidx * vec_size >= sizePerHead;
-
-    // Dequant scales for 8bits k cache
-    [[maybe_unused]] float k_scale_quant_orig = (ENABLE_8BITS_CACHE ? kScaleQuantOrig[0] : 1.0f);
-
-    if (!valid_seq || is_head_size_masked)
-    {
-        return;
-    }
-
-    mmha::update_rotary_base_n_scale(rotary_embedding_base, rotary_embedding_scale, rotary_scale_type,
-        rotary_embedding_dim, rotary_embedding_max_positions, cache_length);
-
-    // Get token index in kv cache
-    auto token_kv_idx = kvCacheBuffer.getKVTokenIdx(token_idx);
-
-    // Read k cache
-    Vec_k k;
-    Vec_k_cache k_cache;
-    T_cache* k_cache_batch = reinterpret_cast<T_cache*>(kvCacheBuffer.getKBlockPtr(batch_beam_idx, token_kv_idx));
-    int inBlockIdx_r = kvCacheBuffer.getKVLocalIdx(token_kv_idx, head_idx, sizePerHead, tidx * vec_size);
-    k_cache = *reinterpret_cast<Vec_k_cache const*>(&k_cache_batch[inBlockIdx_r]);
-    if constexpr (INT8_K_CACHE)
-    {
-        using Packed_Float_t = typename mmha::packed_type<float, vec_size>::type;
-        mmha::convert_from_float(
-            &k, mmha::mul<Packed_Float_t, float>(k_scale_quant_orig, mmha::float_from_int8(k_cache)));
-    }
-#ifdef ENABLE_FP8
-    else if constexpr (FP8_K_CACHE)
-    {
-        mmha::convert_from_8bit_kv_cache<Vec_k_cache, Vec_k, T_cache, float>(&k, k_cache, k_scale_quant_orig);
-    }
-#endif // ENABLE_FP8
-    else
-    {
-        k = k_cache;
-    }
-
-    // Apply position embedding
-    switch (position_embedding_type)
-    {
-    case PositionEmbeddingType::kROPE_GPTJ:
-    {
-        mmha::apply_rotary_embedding(
-            k, tidx, rotary_embedding_dim, rotary_embedding_base, rotary_embedding_scale, 0, nullptr, token_pos_idx);
-        break;
-    }
-    case PositionEmbeddingType::kLONG_ROPE:
-    case PositionEmbeddingType::kROPE_GPT_NEOX:
-    {
-        bool const do_rotary = vec_size * tidx < rotary_embedding_dim;
-
-        T* k_smem = reinterpret_cast<T*>(smem_);
-
-        int const half_rotary_dim = rotary_embedding_dim / 2;
-        int const half_idx = (tidx * vec_size) / half_rotary_dim;
-        int const intra_half_idx = (tidx * vec_size) % half_rotary_dim;
-        int const smem_pitch = half_rotary_dim; // TODO: adjust for bank conflicts?
-
-        if (do_rotary)
-        {
-            *reinterpret_cast<Vec_k*>(k_smem + half_idx * smem_pitch + intra_half_idx) = k;
-        }
-
-        __syncthreads();
-
-        int const transpose_idx = half_idx * (half_rotary_dim / 2) + intra_half_idx / 2;
-        constexpr int tidx_factor = vec_size / 2;
-        if (do_rotary)
-        {
-            mmha::vec_from_smem_transpose(k, k_smem, transpose_idx, smem_pitch);
-            mmha::apply_rotary_embedding(k, transpose_idx / tidx_factor, rotary_embedding_dim, rotary_embedding_base,
-                rotary_embedding_scale, 0, nullptr, token_pos_idx);
-            mmha::write_smem_transpose(k, k_smem, transpose_idx, smem_pitch);
-        }
-
-        __syncthreads();
-
-        if (do_rotary)
-        {
-            k = *reinterpret_cast<Vec_k*>(k_smem + half_idx * smem_pitch + intra_half_idx);
-        }
-        break;
-    }
-    }
-
-    // Write k cache
-    auto token_k_idx = shiftKCacheBuffer.getKVTokenIdx(token_idx);
-    T_dst* kDst = reinterpret_cast<T_dst*>(shiftKCacheBuffer.getKBlockPtr(batch_beam_idx, token_k_idx));
-    int inBlockIdx_w = shiftKCacheBuffer.getKVLocalIdx(token_k_idx, head_idx, sizePerHeadDivX, tidx);
-    reinterpret_cast<Vec_k*>(kDst)[inBlockIdx_w] = k;
-}
-
-template <typename T, typename KVCacheBuffer>
-void invokeShiftKCache(KVCacheBuffer const& kvCacheBuffer, KVLinearBuffer const& shiftKCacheBuffer,
-    const KvCacheDataType cache_type, int const sizePerHead, int const timestep, int const batch_beam,
-    int const kv_head_num, int const beam_width, int const maxKCacheLen, int const sinkTokenLen,
-    float const* kScaleQuantOrig, int const* sequence_lengths, int const* input_lengths, int const rotary_embedding_dim,
-    float rotary_embedding_base, RotaryScalingType const rotary_scale_type, float rotary_embedding_scale,
-    int const rotary_embedding_max_positions, PositionEmbeddingType const position_embedding_type, cudaStream_t stream)
-{
-    // Block handles K tile.
-    int const token_num_in_k = (timestep <= maxKCacheLen) ? timestep : maxKCacheLen;
-    int const vec_size = 16u / sizeof(T);
-    dim3 block((sizePerHead / vec_size + 31) / 32 * 32);
-    dim3 grid(token_num_in_k, kv_head_num, batch_beam);
-    size_t smem_size = (position_embedding_type == PositionEmbeddingType::kROPE_GPT_NEOX
-                || position_embedding_type == PositionEmbeddingType::kLONG_ROPE
-            ? 2 * rotary_embedding_dim * sizeof(T)
-            : 0);
-
-    if (cache_type == KvCacheDataType::INT8)
-    {
-        shiftKCache<T, int8_t, KVCacheBuffer><<<grid, block, smem_size, stream>>>(kvCacheBuffer, shiftKCacheBuffer,
-            sizePerHead, timestep, beam_width, maxKCacheLen, sinkTokenLen, kScaleQuantOrig, sequence_lengths,
-            input_lengths, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type, rotary_embedding_scale,
-            rotary_embedding_max_positions, position_embedding_type);
-    }
-#ifdef ENABLE_FP8
-    else if (cache_type == KvCacheDataType::FP8)
-    {
-        shiftKCache<T, __nv_fp8_e4m3, KVCacheBuffer><<<grid, block, smem_size, stream>>>(kvCacheBuffer,
-            shiftKCacheBuffer, sizePerHead, timestep, beam_width, maxKCacheLen, sinkTokenLen, kScaleQuantOrig,
-            sequence_lengths, input_lengths, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type,
-            rotary_embedding_scale, rotary_embedding_max_positions, position_embedding_type);
-    }
-#endif // ENABLE_FP8
-    else
-    {
-        shiftKCache<T, T, KVCacheBuffer><<<grid, block, smem_size, stream>>>(kvCacheBuffer, shiftKCacheBuffer,
-            sizePerHead, timestep, beam_width, maxKCacheLen, sinkTokenLen, kScaleQuantOrig, sequence_lengths,
-            input_lengths, rotary_embedding_dim, rotary_embedding_base, rotary_scale_type, rotary_embedding_scale,
-            rotary_embedding_max_positions, position_embedding_type);
-    }
-}
-
-#define INSTANTIATE_SHIFT_K_CACHE_CACHE_TYPE(T, KVCacheBuffer)                                                         \
-    template void invokeShiftKCache<T, KVCacheBuffer>(KVCacheBuffer const& kvCacheBuffer,                              \
-        KVLinearBuffer const& shiftKCacheBuffer, const KvCacheDataType cache_type, const int sizePerHead,              \
-        const int timestep, const int batch_beam, const int kv_head_num, const int beam_width, const int maxKCacheLen, \
-        const int sinkTokenLen, const float* kScaleQuantOrig, const int* sequence_lengths, const int* input_lengths,   \
-        const int rotary_embedding_dim, float rotary_embedding_base, RotaryScalingType const rotary_scale_type,        \
-        float rotary_embedding_scale, const int rotary_embedding_max_positions,                                        \
-        PositionEmbeddingType const position_embedding_type, cudaStream_t stream)
-
-#define INSTANTIATE_SHIFT_K_CACHE(T)                                                                                   \
-    INSTANTIATE_SHIFT_K_CACHE_CACHE_TYPE(T, KVBlockArray);                                                             \
-    INSTANTIATE_SHIFT_K_CACHE_CACHE_TYPE(T, KVLinearBuffer);
-
-INSTANTIATE_SHIFT_K_CACHE(float)
-INSTANTIATE_SHIFT_K_CACHE(uint16_t)
-#ifdef ENABLE_BF16
-INSTANTIATE_SHIFT_K_CACHE(__nv_bfloat16);
-#endif
-
-#undef INSTANTIATE_SHIFT_K_CACHE_CACHE_TYPE
-#undef INSTANTIATE_SHIFT_K_CACHE
-
 namespace
 {
 template <typename T, uint32_t size_>
@@ -52,6 +52,12 @@ struct MaskedSoftmaxParam
     // Optional parameters that depend on the type of attention.
     // The slopes of the linear position bias of ALiBi.
     T const* linear_bias_slopes = nullptr; // (head_num,), optional
+    // The table of the implicit relative attention bias of T5, whose bucket is computed from (ki - qi) on the fly
+    // instead of reading a materialized [head_num, q_length, k_length] bias. It is added to QK before qk_scale.
+    T const* relative_attention_bias = nullptr; // (head_num, num_buckets), optional
+    int relative_attention_bias_stride = 0;     // num_buckets
+    int max_distance = 0;
+    bool relative_attention_bidirectional = false;
 };
 
 enum class KvCacheDataType
@@ -95,6 +101,13 @@ struct QKVPreprocessingParams
     // shape is {rotary_embedding_max_positions, rotary_embedding_dim}. eg (2048, 128)
     float2 const* rotary_coef_cache_buffer{nullptr};
     float const* kvScaleOrigQuant{nullptr};
+    // Only used by paged fp8 FMHA with a fp8 kv cache. The dequantization scale of the kv cache is folded into the
+    // quantization of Q (for bmm1), and into fmha_bmm2_scale together with fmha_output_scale (for bmm2).
+    float const* kvScaleQuantOrig{nullptr};
+    // Output scale of the fp8 FMHA, optional.
+    float const* fmha_output_scale{nullptr};
+    // Device scale of bmm2 written by the kernel, of shape {1}.
+    float* fmha_bmm2_scale{nullptr};
     int const* spec_decoding_position_offsets{nullptr};
 
     // Scalars.
@@ -160,6 +173,9 @@ struct QKVPreprocessingParams
                   runtime::ITensor::makeShape({batch_size, rotary_embedding_dim / 2})));
         ss << "rotary_coef_cache_buffer: " << rotary_coef_cache_buffer << std::endl;
         ss << "kvScaleOrigQuant: " << kvScaleOrigQuant << std::endl;
+        ss << "kvScaleQuantOrig: " << kvScaleQuantOrig << std::endl;
+        ss << "fmha_output_scale: " << fmha_output_scale << std::endl;
+        ss << "fmha_bmm2_scale: " << fmha_bmm2_scale << std::endl;
         ss << "spec_decoding_position_offsets: " << spec_decoding_position_offsets << std::endl;
         ss << "batch_size: " << batch_size << std::endl;
         ss << "max_input_seq_len: " << max_input_seq_len << std::endl;
@@ -268,14 +284,6 @@ void invokeAddRelativeAttentionBiasUnaligned(T* qk_buf, const BT* relative_atten
     int const head_num, int const seq_len, int const max_seq_len, cudaStream_t stream, bool implicit = false,
     int num_buckets = 0, int max_distance = 0, bool bidirectional = true);
 
-template <typename T, typename KVCacheBuffer>
-void invokeShiftKCache(KVCacheBuffer const& kvCacheBuffer, KVLinearBuffer const& shiftKCacheBuffer,
-    const KvCacheDataType cache_type, int const sizePerHead, int const timestep, int const batch_beam,
-    int const kv_head_num, int const beam_width, int const maxKCacheLen, int const sinkTokenLen,
-    float const* kScaleQuantOrig, int const* sequence_lengths, int const* input_lengths, int const rotary_embedding_dim,
-    float rotary_embedding_base, RotaryScalingType const rotary_scale_type, float rotary_embedding_scale,
-    int const rotary_embedding_max_positions, PositionEmbeddingType const position_embedding_type, cudaStream_t stream);
-
 // compute src[x] * scale[0] and write into dst[x]
 template <typename Dst, typename Src>
 void invokeConversion(Dst* dst, Src const* src, int64_t size, float const* __restrict__ scale, cudaStream_t stream);
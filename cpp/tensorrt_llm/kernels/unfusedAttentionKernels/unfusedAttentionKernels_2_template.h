@@ -298,6 +298,53 @@ inline __device__ void apply_rotary_embedding_gptj(VecType& q, VecType& k, float
     }
 }
 
+// Paged fp8 FMHA reads the fp8 kv cache without dequantizing it. The dequantization scale of K is folded into the
+// quantization of Q, and the one of V into the bmm2 scale (written once by the first thread of the grid).
+// The scaled Q is computed in float and clamped to the fp8 range: a scale above 1 must neither overflow T nor turn
+// large values into NaN.
+template <typename T, typename TCache, bool STORE_QKV, typename KVCacheBuffer, typename QuantizedVecType,
+    typename VecType>
+inline __device__ void storeFp8FmhaQ(
+    QKVPreprocessingParams<T, KVCacheBuffer> const& params, QuantizedVecType* quantized_q_ptr, VecType const& q)
+{
+    if constexpr (!STORE_QKV && std::is_same_v<TCache, __nv_fp8_e4m3>)
+    {
+        if (params.kvScaleQuantOrig != nullptr)
+        {
+            using VecF = decltype(mmha::convert_to_float(q));
+            constexpr float kFp8Max = mmha::kv_cache_quant_max<__nv_fp8_e4m3>::value;
+            float const qScale = params.kvScaleQuantOrig[0];
+            VecF q_f = mmha::convert_to_float(q);
+            float* q_elts = reinterpret_cast<float*>(&q_f);
+#pragma unroll
+            for (int i = 0; i < mmha::num_elems<VecF>::value; ++i)
+            {
+                q_elts[i] = fminf(fmaxf(q_elts[i] * qScale, -kFp8Max), kFp8Max);
+            }
+            mmha::convert_to_fp8(quantized_q_ptr, q_f);
+            return;
+        }
+    }
+    // use 1.0f scale currently for qkv input of FP8 FMHA.
+    mmha::convert_to_fp8(quantized_q_ptr, q);
+}
+
+template <typename T, typename TCache, bool STORE_QKV, typename KVCacheBuffer>
+inline __device__ void storeFp8FmhaBmm2Scale(QKVPreprocessingParams<T, KVCacheBuffer> const& params)
+{
+    if constexpr (!STORE_QKV && std::is_same_v<TCache, __nv_fp8_e4m3>)
+    {
+        bool const first_thread
+            = blockIdx.x == 0 && blockIdx.y == 0 && blockIdx.z == 0 && threadIdx.x == 0 && threadIdx.y == 0;
+        if (params.fmha_bmm2_scale != nullptr && first_thread)
+        {
+            float const outputScale = params.fmha_output_scale != nullptr ? params.fmha_output_scale[0] : 1.f;
+            float const vScale = params.kvScaleQuantOrig != nullptr ? params.kvScaleQuantOrig[0] : 1.f;
+            *params.fmha_bmm2_scale = outputScale * vScale;
+        }
+    }
+}
+
 template <typename T, typename TCache, int Dh_MAX, bool ADD_BIAS, bool STORE_QKV, typename KVCacheBuffer,
     RotaryPositionEmbeddingType ROTARY_TYPE, bool DYNAMIC_ROTARY_SCALING>
 __global__ void applyBiasRopeUpdateKVCache(QKVPreprocessingParams<T, KVCacheBuffer> params)
@@ -328,6 +375,10 @@ __global__ void applyBiasRopeUpdateKVCache(QKVPreprocessingParams<T, KVCacheBuff
     // There are two kinds of output:
     //  1. Contiguous QKV output.
     //  2. Contiguous Q output + Paged KV output (needed by Paged KV FMHA kernels).
+    if (params.quantized_fp8_output)
+    {
+        storeFp8FmhaBmm2Scale<T, TCache, STORE_QKV>(params);
+    }
 
     // VEC_SIZE is power of 2.
     constexpr int VEC_SIZE = Rotary_vec_t<T, Dh_MAX>::size;
@@ -497,6 +548,24 @@ __global__ void applyBiasRopeUpdateKVCache(QKVPreprocessingParams<T, KVCacheBuff
             // One block will handle single head.
             __syncthreads();
 
+            // Quantization scales of the token when the 8-bit cache stores one scale per token and kv head.
+            // The warp holds the entire head.
+            float k_token_scale_orig_quant = 1.f;
+            float v_token_scale_orig_quant = 1.f;
+            if constexpr (ENABLE_8BITS_CACHE)
+            {
+                if (params.kv_cache_buffer.hasTokenScales())
+                {
+                    float const k_abs_max
+                        = valid_head_dim_idx ? mmha::vec_abs_max(params.position_shift_enabled ? k_wo_pos : k) : 0.f;
+                    float const v_abs_max = valid_head_dim_idx ? mmha::vec_abs_max(v) : 0.f;
+                    k_token_scale_orig_quant
+                        = mmha::kv_cache_token_scale_orig_quant<TCache>(mmha::group_abs_max<32>(k_abs_max));
+                    v_token_scale_orig_quant
+                        = mmha::kv_cache_token_scale_orig_quant<TCache>(mmha::group_abs_max<32>(v_abs_max));
+                }
+            }
+
             if (valid_head_dim_idx)
             {
                 auto kDst = reinterpret_cast<TDst*>(params.kv_cache_buffer.getKBlockPtr(batch_idx, token_kv_idx));
@@ -514,8 +583,7 @@ __global__ void applyBiasRopeUpdateKVCache(QKVPreprocessingParams<T, KVCacheBuff
 
                 if (params.quantized_fp8_output)
                 {
-                    // use 1.0f scale currently for qkv input of FP8 FMHA.
-                    mmha::convert_to_fp8(quantized_q_ptr, q);
+                    storeFp8FmhaQ<T, TCache, STORE_QKV>(params, quantized_q_ptr, q);
                 }
                 else
                 {
@@ -548,13 +616,28 @@ __global__ void applyBiasRopeUpdateKVCache(QKVPreprocessingParams<T, KVCacheBuff
                         if constexpr (ENABLE_8BITS_CACHE)
                         {
                             inBlockIdx = inBlockIdx * VEC_SIZE;
+                            float kScaleOrigQuantF = params.kvScaleOrigQuant[0];
+                            float vScaleOrigQuantF = params.kvScaleOrigQuant[0];
+                            if (params.kv_cache_buffer.hasTokenScales())
+                            {
+                                kScaleOrigQuantF = k_token_scale_orig_quant;
+                                vScaleOrigQuantF = v_token_scale_orig_quant;
+                                if (channelIdx == 0)
+                                {
+                                    *params.kv_cache_buffer.getKScalePtr(batch_idx, token_kv_idx, kv_head_idx)
+                                        = 1.f / kScaleOrigQuantF;
+                                    *params.kv_cache_buffer.getVScalePtr(batch_idx, token_kv_idx, kv_head_idx)
+                                        = 1.f / vScaleOrigQuantF;
+                                }
+                            }
                             // Cast float scale to dst data type.
                             using TScale = typename mmha::kv_cache_scale_type_t<T, TCache>::Type;
-                            TScale scaleOrigQuant;
-                            mmha::convert_from_float(&scaleOrigQuant, params.kvScaleOrigQuant[0]);
+                            TScale kScaleOrigQuant, vScaleOrigQuant;
+                            mmha::convert_from_float(&kScaleOrigQuant, kScaleOrigQuantF);
+                            mmha::convert_from_float(&vScaleOrigQuant, vScaleOrigQuantF);
                             // Store 8bits kv cache.
-                            mmha::store_8bits_kv_cache_vec(kDst, k_to_cache, inBlockIdx, scaleOrigQuant);
-                            mmha::store_8bits_kv_cache_vec(vDst, v, inBlockIdx, scaleOrigQuant);
+                            mmha::store_8bits_kv_cache_vec(kDst, k_to_cache, inBlockIdx, kScaleOrigQuant);
+                            mmha::store_8bits_kv_cache_vec(vDst, v, inBlockIdx, vScaleOrigQuant);
                         }
                         else
                         {
@@ -638,6 +721,10 @@ __global__ void applyBiasRopeUpdateKVCacheV2(QKVPreprocessingParams<T, KVCacheBu
     // There are two kinds of output:
     //  1. Contiguous QKV output.
     //  2. Contiguous Q output + Paged KV output (needed by Paged KV FMHA kernels).
+    if (params.quantized_fp8_output)
+    {
+        storeFp8FmhaBmm2Scale<T, TCache, STORE_QKV>(params);
+    }
 
     // Constants.
     using VecT = typename VecType<T>::Type;
@@ -810,8 +897,7 @@ __global__ void applyBiasRopeUpdateKVCacheV2(QKVPreprocessingParams<T, KVCacheBu
 
             if (params.quantized_fp8_output)
             {
-                // use 1.0f scale currently for qkv input of FP8 FMHA.
-                mmha::convert_to_fp8(quantized_q_ptr, q);
+                storeFp8FmhaQ<T, TCache, STORE_QKV>(params, quantized_q_ptr, q);
             }
             else
             {
@@ -1052,8 +1138,11 @@ void invokeApplyBiasRopeUpdateKVCacheDispatch(QKVPreprocessingParams<T, KVCacheB
     bool const support_rotary_for_v2 = (params.position_embedding_type != PositionEmbeddingType::kROPE_GPT_NEOX
                                            && params.position_embedding_type != PositionEmbeddingType::kLONG_ROPE)
         || params.rotary_embedding_dim % 16 == 0;
+    // Per-token scales need the entire head in one warp, which only the v1 kernel guarantees.
+    bool const has_token_kv_scales = sizeof(TCache) == 1 && params.kv_cache_buffer.hasTokenScales();
 
-    if (long_seq_rotary_support || !has_rotary_cos_sin_cache || has_sink_tokens || !support_rotary_for_v2)
+    if (long_seq_rotary_support || !has_rotary_cos_sin_cache || has_sink_tokens || !support_rotary_for_v2
+        || has_token_kv_scales)
     {
         kernelV1Dispatch<T, TCache, KVCacheBuffer>(params, stream);
         return;
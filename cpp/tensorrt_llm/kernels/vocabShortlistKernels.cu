@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/reduceKernelUtils.cuh"
+#include "tensorrt_llm/kernels/vocabShortlistKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+namespace
+{
+SizeType32 constexpr SHORTLIST_WARPS_PER_BLOCK = 8;
+SizeType32 constexpr MAP_BLOCK_SIZE = 256;
+
+//! One warp per shortlisted token, the lanes stride over the hidden dimension so that the row reads are coalesced.
+//! The hidden state of the request is read by all the warps and stays in cache.
+template <typename T>
+__global__ void shortlistLogits(ShortlistLogitsParams<T> params)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const warpIdx = static_cast<SizeType32>(threadIdx.x) / 32;
+    auto const laneIdx = static_cast<SizeType32>(threadIdx.x) % 32;
+    auto const candidateIdx = static_cast<SizeType32>(blockIdx.y) * SHORTLIST_WARPS_PER_BLOCK + warpIdx;
+    if (candidateIdx >= params.maxShortlistSize)
+    {
+        return;
+    }
+    auto const batchSlot = params.batchSlots != nullptr ? params.batchSlots[batchIdx] : batchIdx;
+    auto* logits = params.logits + batchIdx * params.maxShortlistSize;
+    if (candidateIdx >= params.shortlistSizes[batchSlot])
+    {
+        if (laneIdx == 0)
+        {
+            logits[candidateIdx] = static_cast<T>(-INFINITY);
+        }
+        return;
+    }
+
+    auto const tokenId = params.shortlists[batchSlot * params.maxShortlistSize + candidateIdx];
+    auto const* weights = params.lmHeadWeights + static_cast<std::size_t>(tokenId) * params.hiddenSize;
+    auto const* hidden = params.hiddenStates + static_cast<std::size_t>(batchIdx) * params.hiddenSize;
+    float sum = 0.f;
+    for (auto hi = laneIdx; hi < params.hiddenSize; hi += 32)
+    {
+        sum += static_cast<float>(hidden[hi]) * static_cast<float>(weights[hi]);
+    }
+    sum = warpReduceSum<float>(sum);
+    if (laneIdx == 0)
+    {
+        logits[candidateIdx] = static_cast<T>(sum);
+    }
+}
+
+__global__ void mapShortlistTokens(MapShortlistTokensParams params)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (batchIdx >= params.batchSize)
+    {
+        return;
+    }
+    auto const batchSlot = params.batchSlots != nullptr ? params.batchSlots[batchIdx] : batchIdx;
+    if (params.finishedInput != nullptr && params.finishedInput[batchSlot].isFinished())
+    {
+        return;
+    }
+    auto& token = params.outputIdsPtrs[batchSlot][params.sequenceLengths[batchSlot]];
+    token = params.shortlists[batchSlot * params.maxShortlistSize + token];
+}
+} // namespace
+
+template <typename T>
+void invokeShortlistLogits(ShortlistLogitsParams<T> const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+    dim3 const grid(params.batchSize, divUp(params.maxShortlistSize, SHORTLIST_WARPS_PER_BLOCK));
+    shortlistLogits<T><<<grid, SHORTLIST_WARPS_PER_BLOCK * 32, 0, stream>>>(params);
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void invokeMapShortlistTokens(MapShortlistTokensParams const& params, cudaStream_t stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    params.checkParams();
+    mapShortlistTokens<<<divUp(params.batchSize, MAP_BLOCK_SIZE), MAP_BLOCK_SIZE, 0, stream>>>(params);
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void invokeShortlistLogits(ShortlistLogitsParams<float> const& params, cudaStream_t stream);
+template void invokeShortlistLogits(ShortlistLogitsParams<half> const& params, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeShortlistLogits(ShortlistLogitsParams<__nv_bfloat16> const& params, cudaStream_t stream);
+#endif
+} // namespace kernels
+} // namespace tensorrt_llm
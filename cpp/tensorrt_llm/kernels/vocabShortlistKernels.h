@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime_api.h>
+
+namespace tensorrt_llm
+{
+namespace kernels
+{
+
+template <typename T>
+struct ShortlistLogitsParams
+{
+    //! input buffer [batchSize, hiddenSize], required. Hidden states of the last token of each request, after the
+    //! final norm.
+    T const* hiddenStates{nullptr};
+    //! input buffer [vocabSize, hiddenSize], required. Weights of the LM head.
+    T const* lmHeadWeights{nullptr};
+    //! input buffer [maxBatchSize, maxShortlistSize], required. Token ids of the shortlist of each request.
+    runtime::TokenIdType const* shortlists{nullptr};
+    //! input buffer [maxBatchSize], required. Number of tokens in the shortlist of each request.
+    runtime::SizeType32 const* shortlistSizes{nullptr};
+    //! input buffer [batchSize], optional. Indices of rows of data in memory pool, linear indexing if nullptr.
+    runtime::SizeType32 const* batchSlots{nullptr};
+    //! output buffer [batchSize, maxShortlistSize], required. Logits of the tokens of the shortlist, -inf after its
+    //! size so that the padding is never sampled.
+    T* logits{nullptr};
+
+    runtime::SizeType32 batchSize{0};
+    runtime::SizeType32 maxBatchSize{0};
+    runtime::SizeType32 hiddenSize{0};
+    runtime::SizeType32 maxShortlistSize{0};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxBatchSize >= batchSize);
+        TLLM_CHECK(hiddenSize > 0);
+        TLLM_CHECK(maxShortlistSize > 0);
+        TLLM_CHECK(hiddenStates);
+        TLLM_CHECK(lmHeadWeights);
+        TLLM_CHECK(shortlists);
+        TLLM_CHECK(shortlistSizes);
+        TLLM_CHECK(logits);
+    }
+};
+
+//! \brief Computes the logits of the shortlisted tokens only, a GEMV over the gathered rows of the LM head. The
+//! sampling layers then run over maxShortlistSize columns instead of vocabSizePadded, with the end ids given as
+//! positions in the shortlists, and invokeMapShortlistTokens maps the sampled positions back to token ids.
+template <typename T>
+void invokeShortlistLogits(ShortlistLogitsParams<T> const& params, cudaStream_t stream);
+
+struct MapShortlistTokensParams
+{
+    //! input/output buffer [maxBatchSize][maxSeqLen], required. The token sampled at the position given by
+    //! sequenceLengths is a position in the shortlist, replaced by its token id.
+    runtime::TokenIdType** outputIdsPtrs{nullptr};
+    //! input buffer [maxBatchSize], required. Sequence lengths before the sampling, where it wrote its token.
+    runtime::SizeType32 const* sequenceLengths{nullptr};
+    //! input buffer [maxBatchSize], optional. Requests finished before the sampling, which wrote no token.
+    FinishedState const* finishedInput{nullptr};
+    //! input buffer [maxBatchSize, maxShortlistSize], required.
+    runtime::TokenIdType const* shortlists{nullptr};
+    //! input buffer [batchSize], optional. Indices of rows of data in memory pool, linear indexing if nullptr.
+    runtime::SizeType32 const* batchSlots{nullptr};
+
+    runtime::SizeType32 batchSize{0};
+    runtime::SizeType32 maxShortlistSize{0};
+
+    void checkParams() const
+    {
+        TLLM_CHECK(batchSize > 0);
+        TLLM_CHECK(maxShortlistSize > 0);
+        TLLM_CHECK(outputIdsPtrs);
+        TLLM_CHECK(sequenceLengths);
+        TLLM_CHECK(shortlists);
+    }
+};
+
+//! \brief Replaces the positions in the shortlists sampled at this step by their token ids.
+void invokeMapShortlistTokens(MapShortlistTokensParams const& params, cudaStream_t stream);
+} // namespace kernels
+} // namespace tensorrt_llm
@@ -20,6 +20,7 @@
 #include <cstdint>
 #include <cuda_bf16.h>
 #include <cuda_fp16.h>
+#include <cuda_fp8.h>
 #include <cuda_runtime.h>
 #include <cuda_runtime_api.h>
 #include <iostream>
@@ -37,7 +38,14 @@ enum class KernelType
     FP16Int8PerChannel,
     BF16Int8PerChannel,
     FP16Int4PerChannel,
-    BF16Int4PerChannel
+    BF16Int4PerChannel,
+    // W4A8, fp8 activations with fp16 scales, zeros, bias and outputs
+    FP8Int4Groupwise,
+    // Block scaled fp4 weights, see Nvfp4DetailsW and Mxfp4DetailsW. groupsize must be the block size of the format
+    FP16Nvfp4,
+    BF16Nvfp4,
+    FP16Mxfp4,
+    BF16Mxfp4
 };
 
 template <KernelType KT>
@@ -55,6 +63,11 @@ KERNEL_TYPE_TRAITS_REGISTRY(KernelType::FP16Int8PerChannel, false, false);
 KERNEL_TYPE_TRAITS_REGISTRY(KernelType::BF16Int8PerChannel, false, false);
 KERNEL_TYPE_TRAITS_REGISTRY(KernelType::FP16Int4PerChannel, false, true);
 KERNEL_TYPE_TRAITS_REGISTRY(KernelType::BF16Int4PerChannel, false, true);
+KERNEL_TYPE_TRAITS_REGISTRY(KernelType::FP8Int4Groupwise, true, true);
+KERNEL_TYPE_TRAITS_REGISTRY(KernelType::FP16Nvfp4, true, true);
+KERNEL_TYPE_TRAITS_REGISTRY(KernelType::BF16Nvfp4, true, true);
+KERNEL_TYPE_TRAITS_REGISTRY(KernelType::FP16Mxfp4, true, true);
+KERNEL_TYPE_TRAITS_REGISTRY(KernelType::BF16Mxfp4, true, true);
 #undef KERNEL_TYPE_TRAITS_REGISTRY
 
 struct Params
@@ -75,6 +88,9 @@ struct Params
     int groupsize;
     KernelType type;
     bool apply_alpha_in_advance;
+    // Optional workspace of get_split_k_workspace_size(m, n) bytes. When set, K may be split across CTAs for shapes
+    // that do not fill the GPU otherwise
+    Pointer workspace = nullptr;
 
     Params(ConstPointer _act, ConstPointer _act_scale, ConstPointer _weight, ConstPointer _scales, ConstPointer _zeros,
         ConstPointer _bias, Pointer _out, float _alpha, int _m, int _n, int _k, int _groupsize, KernelType _type,
@@ -96,6 +112,14 @@ struct Params
     {
     }
 };
+
+// Maximum number of K splits, each split writes a [m, n] fp32 partial result
+static constexpr int kMaxSplitK = 8;
+
+inline size_t get_split_k_workspace_size(int m, int n)
+{
+    return sizeof(float) * kMaxSplitK * static_cast<size_t>(m) * static_cast<size_t>(n);
+}
 } // namespace weight_only
 } // namespace kernels
 } // namespace tensorrt_llm
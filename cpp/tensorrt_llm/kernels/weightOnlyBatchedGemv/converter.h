@@ -78,6 +78,40 @@ struct I2FConverter<AType, WElemBits, false>
     }
 };
 
+// E2M1 to fp16/bf16. The sign, exponent and mantissa bits of each nibble are placed at the top of the fp16/bf16
+// encoding, which gives the fp4 value scaled by 2^(1 - exponent bias), including for the fp4 subnormal 0.5, so one
+// multiplication restores it. The lower K index is in the low nibble
+template <typename AType>
+struct F4Converter
+{
+    static_assert(std::is_same_v<AType, half> || std::is_same_v<AType, __nv_bfloat16>);
+    using AType2 = std::conditional_t<std::is_same_v<AType, half>, half2, __nv_bfloat162>;
+    static constexpr int kMantissaShift = std::is_same_v<AType, half> ? 9 : 6;
+    static constexpr uint32_t kRescaleBits = std::is_same_v<AType, half> ? 0x74007400u : 0x7e807e80u; // 2^14, 2^126
+    static constexpr int kConvertCount = 8;
+
+    template <int N>
+    __device__ __forceinline__ static void convert(void* src, void* dst)
+    {
+        static_assert(N % kConvertCount == 0);
+        uint32_t rescale_bits = kRescaleBits;
+        AType2 const rescale = reinterpret_cast<AType2&>(rescale_bits);
+#pragma unroll
+        for (int ii = 0; ii < N / kConvertCount; ++ii)
+        {
+            uint32_t const packed = reinterpret_cast<uint32_t*>(src)[ii];
+#pragma unroll
+            for (int jj = 0; jj < 4; ++jj)
+            {
+                uint32_t const byte = (packed >> (jj * 8)) & 0xffu;
+                uint32_t bits = ((byte & 0x8u) << 12) | ((byte & 0x7u) << kMantissaShift) | ((byte & 0x80u) << 24)
+                    | ((byte & 0x70u) << (kMantissaShift + 12));
+                reinterpret_cast<AType2*>(dst)[ii * 4 + jj] = __hmul2(reinterpret_cast<AType2&>(bits), rescale);
+            }
+        }
+    }
+};
+
 } // namespace weight_only
 } // namespace kernels
 } // namespace tensorrt_llm
@@ -17,6 +17,8 @@
 #pragma once
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/common.h"
 
+#include <type_traits>
+
 namespace tensorrt_llm
 {
 namespace kernels
@@ -37,14 +39,41 @@ struct BF16DetailsA
     static constexpr int kElemBits = 16;
 };
 
+struct FP8DetailsA
+{
+    using Type = __nv_fp8_e4m3;
+    static constexpr int kElemBits = 8;
+};
+
 struct Int8DetailsW
 {
     static constexpr int kElemBits = 8;
+    static constexpr bool kIsFp4 = false;
 };
 
 struct Int4DetailsW
 {
     static constexpr int kElemBits = 4;
+    static constexpr bool kIsFp4 = false;
+};
+
+// E2M1 weights with one fp8 scale per kBlockSize elements along K. NVFP4 uses e4m3 scales and MXFP4 uses power of two
+// scales stored as their ue8m0 exponent. The NVFP4 per tensor scale is passed as alpha with apply_alpha_in_advance,
+// which folds it into the block scales in fp32 and keeps the fp16 products in range
+struct Nvfp4DetailsW
+{
+    using TypeScale = __nv_fp8_e4m3;
+    static constexpr int kElemBits = 4;
+    static constexpr bool kIsFp4 = true;
+    static constexpr int kBlockSize = 16;
+};
+
+struct Mxfp4DetailsW
+{
+    using TypeScale = uint8_t;
+    static constexpr int kElemBits = 4;
+    static constexpr bool kIsFp4 = true;
+    static constexpr int kBlockSize = 32;
 };
 
 template <typename TypeDetailsA, typename TypeDetailsW, int TileSizeK>
@@ -95,8 +124,10 @@ struct ColumnMajorInterleaved
     };
 };
 
+// TypeDetailsAct_ is the storage type of the activations when it is narrower than TypeDetailsA_ (fp8 for w4a8). They
+// are converted to TypeDetailsA_ after loading.
 template <typename TypeDetailsA_, typename TypeDetailsW_, template <typename, typename, int> class LayoutDetails_,
-    bool UseInterleavedConverter, int TileSizeK>
+    bool UseInterleavedConverter, int TileSizeK, typename TypeDetailsAct_ = TypeDetailsA_>
 struct KernelDetails
 {
     using TypeDetailsA = TypeDetailsA_;
@@ -108,6 +139,9 @@ struct KernelDetails
     static constexpr int kStepK = LayoutDetails::kStepK;
     static constexpr int kAccessNumA = kStepK * TypeDetailsA::kElemBits / (sizeof(AccessTypeA) * 8);
     static constexpr int kAccessNumW = kStepK * TypeDetailsW::kElemBits / (sizeof(AccessTypeW) * 8);
+    using TypeDetailsAct = TypeDetailsAct_;
+    using AccessTypeAct = std::conditional_t<kStepK * TypeDetailsAct::kElemBits % 128 == 0, float4, uint2>;
+    static constexpr int kAccessNumAct = kStepK * TypeDetailsAct::kElemBits / (sizeof(AccessTypeAct) * 8);
     static constexpr int kInterleave = LayoutDetails::kInterleave;
     static constexpr int kThreadsPerInterleavedTile = LayoutDetails::kTileSize / kStepK;
     static constexpr int kElemsPerByteW = 8 / TypeDetailsW::kElemBits;
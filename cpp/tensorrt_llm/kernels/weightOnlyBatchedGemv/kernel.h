@@ -15,6 +15,7 @@
  */
 
 #pragma once
+#include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/common.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/converter.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/details.h"
@@ -27,23 +28,25 @@ namespace kernels
 namespace weight_only
 {
 template <typename Details, int CtaM, int CtaN, int Threads, int GroupSize, bool EnableActScale, bool EnableZero,
-    bool EnableBias, bool ApplyAlphaInAdvance, typename TypeA = typename Details::TypeDetailsA::Type>
-__global__ void kernel(TypeA* act, TypeA* act_scale, uint8_t* weight, TypeA* scales, TypeA* zeros, TypeA* bias,
-    TypeA* out, float alpha, int m, int n, int k)
+    bool EnableBias, bool ApplyAlphaInAdvance, bool SplitK = false,
+    typename TypeA = typename Details::TypeDetailsA::Type, typename TypeAct = typename Details::TypeDetailsAct::Type>
+__global__ void kernel(TypeAct* act, TypeA* act_scale, uint8_t* weight, TypeA* scales, TypeA* zeros, TypeA* bias,
+    TypeA* out, float alpha, int m, int n, int k, float* partial_out = nullptr, int iters_per_split = 0)
 {
     // clang-format off
     // ArgType          ArgName          DataType               Shape                           Layout
     //
-    // input            act              fp16/bf16              [m, k]                          RowMajor
+    // input            act              fp16/bf16/fp8          [m, k]                          RowMajor
     // input            act_scale        fp16/bf16              [1, k]                          RowMajor
     // input            weight           int4b/int8b            [k, n]                          ColumnMajor or ColumnMajorInterleaved
-    // input            scales           fp16/bf16              [k / GroupSize, n] or [1, n]    RowMajor
+    // input            scales           fp16/bf16/fp8          [k / GroupSize, n] or [1, n]    RowMajor
     // input            zeros            fp16/bf16              [k / GroupSize, n] or [1, n]    RowMajor
     // input            bias             fp16/bf16              [1, n]                          RowMajor
     // output           out              fp16/bf16              [m, n]                          RowMajor
     // clang-format on
     using AccessTypeA = typename Details::AccessTypeA;
     using AccessTypeW = typename Details::AccessTypeW;
+    using TypeScale = typename ScaleWrapper<Details>::Type;
 
     static constexpr bool Mandatory = true;
     static constexpr int StepK = Details::kStepK;
@@ -64,14 +67,14 @@ __global__ void kernel(TypeA* act, TypeA* act_scale, uint8_t* weight, TypeA* sca
         = (tid * StepK / (Details::kInterleave * Details::LayoutDetails::kTileSize)) * Details::LayoutDetails::kTileSize
         + ((tid * StepK) % Details::LayoutDetails::kTileSize);
 
-    GMemIterator<Mandatory, AccessTypeA, CtaM, Details::kAccessNumA, TypeA> act_iterator(
+    GMemIterator<Mandatory, typename Details::AccessTypeAct, CtaM, Details::kAccessNumAct, TypeAct> act_iterator(
         act, offset_m * origin_k + real_offset_k, CtaK / Details::kInterleave, origin_k);
     GMemIterator<EnableActScale, AccessTypeA, 1, Details::kAccessNumA, TypeA> act_scale_iterator(
         act_scale, real_offset_k, CtaK / Details::kInterleave, 0);
     GMemIterator<Mandatory, AccessTypeW, CtaN, Details::kAccessNumW, uint8_t> weight_iterator(weight,
         (interleaved_offset_n * interleaved_k + tid * StepK) / Details::kElemsPerByteW, CtaK / Details::kElemsPerByteW,
         interleaved_k / Details::kElemsPerByteW);
-    GMemIterator<Mandatory, TypeA, CtaN, 1, TypeA> scales_iterator(scales,
+    GMemIterator<Mandatory, TypeScale, CtaN, 1, TypeScale> scales_iterator(reinterpret_cast<TypeScale*>(scales),
         (GroupSize != 0 ? real_offset_k / GroupSize * n : 0) + real_offset_n,
         (GroupSize != 0 ? CtaK / Details::kInterleave / GroupSize * n : 0), Details::kInterleave);
     GMemIterator<EnableZero, TypeA, CtaN, 1, TypeA> zeros_iterator(zeros,
@@ -87,36 +90,102 @@ __global__ void kernel(TypeA* act, TypeA* act_scale, uint8_t* weight, TypeA* sca
     TypeA tile_acc[CtaM * CtaN];
     fill<CtaM * CtaN>(tile_acc, static_cast<TypeA>(0.f));
 
-    for (int idx_k = tid * StepK, iter = 0; idx_k < interleaved_k; idx_k += CtaK, ++iter)
+    // With SplitK, blockIdx.z handles the iterations [iter_begin, iter_end) along K
+    int iter_begin = 0, iter_end = interleaved_k;
+    if constexpr (SplitK)
+    {
+        iter_begin = blockIdx.z * iters_per_split;
+        iter_end = iter_begin + iters_per_split;
+    }
+    for (int idx_k = tid * StepK + iter_begin * CtaK, iter = iter_begin; idx_k < interleaved_k && iter < iter_end;
+         idx_k += CtaK, ++iter)
     {
         TypeA vec_act_scale[StepK];
         TypeA vec_scale[CtaN], vec_zero[CtaN];
+        TypeScale vec_scale_stored[CtaN];
         TypeA tile_a[StepK], tile_w[StepK], tile_w_pack2[CtaN * StepK];
         uint8_t tile_w_quantized[StepK / Details::kElemsPerByteW];
 #pragma unroll
         for (int i = 0; i < CtaN; ++i)
         {
-            scales_iterator.load(vec_scale + i, iter, i);
+            scales_iterator.load(vec_scale_stored + i, iter, i);
             zeros_iterator.load(vec_zero + i, iter, i);
         }
+        ScaleWrapper<Details>::template convert<CtaN, ApplyAlphaInAdvance>(vec_scale, vec_scale_stored, alpha);
         act_scale_iterator.load(vec_act_scale, iter);
 #pragma unroll
         for (int i = 0; i < CtaN; ++i)
         {
             weight_iterator.load(tile_w_quantized, iter, i);
-            dequantize<Details, 1, StepK, EnableZero, ApplyAlphaInAdvance>(
+            dequantize<Details, 1, StepK, EnableZero, ApplyAlphaInAdvance && !ScaleWrapper<Details>::kAppliesAlpha>(
                 tile_w, tile_w_quantized, vec_scale + i, vec_zero + i, alpha);
             pack_to_vec2<Details, StepK>(tile_w_pack2, tile_w, i);
         }
 #pragma unroll
         for (int i = 0; i < CtaM; ++i)
         {
-            act_iterator.load(tile_a, iter, i);
+            load_act<Details, StepK>(tile_a, act_iterator, iter, i);
             apply_scale<Details, 1, StepK, EnableActScale>(tile_a, vec_act_scale);
             mma<Details, 1, CtaN, StepK>(tile_acc + i * CtaN, tile_w_pack2, tile_a);
         }
     }
-    epilogue<Details, CtaM, CtaN, Threads, EnableBias, ApplyAlphaInAdvance>(out, n, tile_acc, bias, alpha);
+    if constexpr (SplitK)
+    {
+        partial_out += (static_cast<int64_t>(blockIdx.z) * m + offset_m) * n + tile_id_n * CtaN * Details::kInterleave;
+        epilogue_split_k<Details, CtaM, CtaN, Threads>(partial_out, n, tile_acc);
+    }
+    else
+    {
+        epilogue<Details, CtaM, CtaN, Threads, EnableBias, ApplyAlphaInAdvance>(out, n, tile_acc, bias, alpha);
+    }
+}
+
+template <typename TypeA, bool EnableBias, bool ApplyAlphaInAdvance>
+__global__ void split_k_reduce_kernel(
+    float const* partial_out, TypeA const* bias, TypeA* out, float alpha, int m, int n, int split_k)
+{
+    int64_t const idx = static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    int64_t const size = static_cast<int64_t>(m) * n;
+    if (idx >= size)
+    {
+        return;
+    }
+    float val = 0.f;
+    for (int split = 0; split < split_k; ++split)
+    {
+        val += partial_out[split * size + idx];
+    }
+    if constexpr (!ApplyAlphaInAdvance)
+    {
+        val *= alpha;
+    }
+    if constexpr (EnableBias)
+    {
+        val += static_cast<float>(bias[idx % n]);
+    }
+    out[idx] = static_cast<TypeA>(val);
+}
+
+// Number of K splits so that there are enough CTAs to saturate the DRAM bandwidth, 1 if the grid is large enough
+template <typename Details, int Threads>
+int select_split_k(Params const& params, int num_ctas)
+{
+    static constexpr int kCtasPerSm = 4;
+    static constexpr int kMinItersPerSplit = 4;
+    if (params.workspace == nullptr)
+    {
+        return 1;
+    }
+    int const cta_k = Details::kStepK * Threads;
+    int const num_iters = (params.k * Details::kInterleave + cta_k - 1) / cta_k;
+    int const target_ctas = kCtasPerSm * tensorrt_llm::common::getMultiProcessorCount();
+    int split_k = 1;
+    while (split_k * 2 <= kMaxSplitK && num_ctas * split_k < target_ctas
+        && num_iters / (split_k * 2) >= kMinItersPerSplit)
+    {
+        split_k *= 2;
+    }
+    return split_k;
 }
 
 template <typename Details, int CtaM, int CtaN, int Threads, int GroupSize, bool EnableActScale, bool EnableZero,
@@ -124,15 +193,44 @@ template <typename Details, int CtaM, int CtaN, int Threads, int GroupSize, bool
 void exec_kernel(Params& params, cudaStream_t s)
 {
     using T = typename Details::TypeDetailsA::Type;
+    using TAct = typename Details::TypeDetailsAct::Type;
     if (params.m % CtaM || params.n % (CtaN * Details::kInterleave))
     {
         throw std::runtime_error("launch failed");
     }
     dim3 grid(params.m / CtaM, params.n / (CtaN * Details::kInterleave));
     dim3 block(Threads);
+    int const split_k = select_split_k<Details, Threads>(params, grid.x * grid.y);
+    if (split_k > 1)
+    {
+        int const cta_k = Details::kStepK * Threads;
+        int const num_iters = (params.k * Details::kInterleave + cta_k - 1) / cta_k;
+        grid.z = split_k;
+        // clang-format off
+        kernel<Details, CtaM, CtaN, Threads, GroupSize, EnableActScale, EnableZero, EnableBias, ApplyAlphaInAdvance, true><<<grid, block, 0, s>>>(
+            reinterpret_cast<TAct*>(params.act),
+            reinterpret_cast<T*>(params.act_scale),
+            reinterpret_cast<uint8_t*>(params.weight),
+            reinterpret_cast<T*>(params.scales),
+            reinterpret_cast<T*>(params.zeros),
+            reinterpret_cast<T*>(params.bias),
+            reinterpret_cast<T*>(params.out),
+            params.alpha,
+            params.m, params.n, params.k,
+            reinterpret_cast<float*>(params.workspace),
+            (num_iters + split_k - 1) / split_k
+        );
+        // clang-format on
+        int const reduce_threads = 256;
+        int const reduce_blocks = (params.m * params.n + reduce_threads - 1) / reduce_threads;
+        split_k_reduce_kernel<T, EnableBias, ApplyAlphaInAdvance><<<reduce_blocks, reduce_threads, 0, s>>>(
+            reinterpret_cast<float const*>(params.workspace), reinterpret_cast<T const*>(params.bias),
+            reinterpret_cast<T*>(params.out), params.alpha, params.m, params.n, split_k);
+        return;
+    }
     // clang-format off
     kernel<Details, CtaM, CtaN, Threads, GroupSize, EnableActScale, EnableZero, EnableBias, ApplyAlphaInAdvance><<<grid, block, 0, s>>>(
-        reinterpret_cast<T*>(params.act),
+        reinterpret_cast<TAct*>(params.act),
         reinterpret_cast<T*>(params.act_scale),
         reinterpret_cast<uint8_t*>(params.weight),
         reinterpret_cast<T*>(params.scales),
@@ -123,7 +123,14 @@ void check_pointer(Params& params, cudaStream_t s)
 template <bool isGroupwise, typename Details>
 void select_gs(Params& params, cudaStream_t s)
 {
-    if constexpr (isGroupwise)
+    if constexpr (Details::TypeDetailsW::kIsFp4)
+    {
+        if (params.groupsize == Details::TypeDetailsW::kBlockSize)
+        {
+            check_pointer<Details, Details::TypeDetailsW::kBlockSize>(params, s);
+        }
+    }
+    else if constexpr (isGroupwise)
     {
         if (params.groupsize == 64)
         {
@@ -146,6 +153,10 @@ void select_gs(Params& params, cudaStream_t s)
 #define INSTANTIATE_WEIGHT_ONLY_CUDA_DISPATCHERS(KType, A, B, Layout, ConverterInterleave, KTile)                      \
     template void select_gs<kernel_type_traits<KType>::isGroupwise,                                                    \
         KernelDetails<A, B, Layout, ConverterInterleave, KTile>>(Params & params, cudaStream_t s);
+
+#define INSTANTIATE_WEIGHT_ONLY_CUDA_DISPATCHERS_FP8_ACT(KType, A, B, Layout, ConverterInterleave, KTile)              \
+    template void select_gs<kernel_type_traits<KType>::isGroupwise,                                                    \
+        KernelDetails<A, B, Layout, ConverterInterleave, KTile, FP8DetailsA>>(Params & params, cudaStream_t s);
 } // namespace weight_only
 } // namespace kernels
 } // namespace tensorrt_llm
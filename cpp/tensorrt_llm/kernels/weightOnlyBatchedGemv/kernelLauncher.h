@@ -44,6 +44,13 @@ inline void kernel_launcher(int arch, Params& params, cudaStream_t s)
             params, s);                                                                                                \
         return;                                                                                                        \
     }
+#define EXEC_FP8_ACT(KType, A, B, Layout, ConverterInterleave, KTile)                                                  \
+    if (params.type == KType)                                                                                          \
+    {                                                                                                                  \
+        select_gs<kernel_type_traits<KType>::isGroupwise,                                                              \
+            KernelDetails<A, B, Layout, ConverterInterleave, KTile, FP8DetailsA>>(params, s);                          \
+        return;                                                                                                        \
+    }
     if (arch >= 70 && arch < 75)
     {
         EXEC(KernelType::FP16Int8PerChannel, FP16DetailsA, Int8DetailsW, ColumnMajor, true);
@@ -60,6 +67,7 @@ inline void kernel_launcher(int arch, Params& params, cudaStream_t s)
         if (arch >= 89)
         {
             EXEC_W4A8(KernelType::FP16Int4Groupwise, FP16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true);
+            EXEC_FP8_ACT(KernelType::FP8Int4Groupwise, FP16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true, 128);
         }
         EXEC(KernelType::FP16Int4Groupwise, FP16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true);
         EXEC(KernelType::BF16Int4Groupwise, BF16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true);
@@ -67,6 +75,10 @@ inline void kernel_launcher(int arch, Params& params, cudaStream_t s)
         EXEC(KernelType::BF16Int8PerChannel, BF16DetailsA, Int8DetailsW, ColumnMajorInterleaved, true);
         EXEC(KernelType::FP16Int4PerChannel, FP16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true);
         EXEC(KernelType::BF16Int4PerChannel, BF16DetailsA, Int4DetailsW, ColumnMajorInterleaved, true);
+        EXEC(KernelType::FP16Nvfp4, FP16DetailsA, Nvfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::BF16Nvfp4, BF16DetailsA, Nvfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::FP16Mxfp4, FP16DetailsA, Mxfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::BF16Mxfp4, BF16DetailsA, Mxfp4DetailsW, ColumnMajor, false);
     }
     else if (arch >= 90)
     {
@@ -76,8 +88,15 @@ inline void kernel_launcher(int arch, Params& params, cudaStream_t s)
         EXEC(KernelType::BF16Int8PerChannel, BF16DetailsA, Int8DetailsW, ColumnMajor, false);
         EXEC(KernelType::FP16Int4PerChannel, FP16DetailsA, Int4DetailsW, ColumnMajor, false);
         EXEC(KernelType::BF16Int4PerChannel, BF16DetailsA, Int4DetailsW, ColumnMajor, false);
+        EXEC_FP8_ACT(KernelType::FP8Int4Groupwise, FP16DetailsA, Int4DetailsW, ColumnMajor, false, 64);
+        EXEC(KernelType::FP16Nvfp4, FP16DetailsA, Nvfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::BF16Nvfp4, BF16DetailsA, Nvfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::FP16Mxfp4, FP16DetailsA, Mxfp4DetailsW, ColumnMajor, false);
+        EXEC(KernelType::BF16Mxfp4, BF16DetailsA, Mxfp4DetailsW, ColumnMajor, false);
     }
 #undef EXEC
+#undef EXEC_W4A8
+#undef EXEC_FP8_ACT
 }
 
 inline bool is_supported(int arch, KernelType kernel_type)
@@ -104,6 +123,14 @@ inline bool is_supported(int arch, KernelType kernel_type)
         SUPPORT(KernelType::BF16Int8PerChannel);
         SUPPORT(KernelType::FP16Int4PerChannel);
         SUPPORT(KernelType::BF16Int4PerChannel);
+        SUPPORT(KernelType::FP16Nvfp4);
+        SUPPORT(KernelType::BF16Nvfp4);
+        SUPPORT(KernelType::FP16Mxfp4);
+        SUPPORT(KernelType::BF16Mxfp4);
+        if (arch >= 89)
+        {
+            SUPPORT(KernelType::FP8Int4Groupwise);
+        }
     }
     else if (arch >= 90)
     {
@@ -113,6 +140,11 @@ inline bool is_supported(int arch, KernelType kernel_type)
         SUPPORT(KernelType::BF16Int8PerChannel);
         SUPPORT(KernelType::FP16Int4PerChannel);
         SUPPORT(KernelType::BF16Int4PerChannel);
+        SUPPORT(KernelType::FP8Int4Groupwise);
+        SUPPORT(KernelType::FP16Nvfp4);
+        SUPPORT(KernelType::BF16Nvfp4);
+        SUPPORT(KernelType::FP16Mxfp4);
+        SUPPORT(KernelType::BF16Mxfp4);
     }
     return false;
 #undef SUPPORT
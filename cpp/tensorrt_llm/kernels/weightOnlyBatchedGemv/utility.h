@@ -30,7 +30,59 @@ struct ConverterWrapper
     using TypeDetailsA = typename Details::TypeDetailsA;
     using TypeDetailsW = typename Details::TypeDetailsW;
     static constexpr bool kUseInterleavedConverter = Details::kUseInterleavedConverter;
-    using Converter = I2FConverter<typename TypeDetailsA::Type, TypeDetailsW::kElemBits, kUseInterleavedConverter>;
+    using Converter = std::conditional_t<TypeDetailsW::kIsFp4, F4Converter<typename TypeDetailsA::Type>,
+        I2FConverter<typename TypeDetailsA::Type, TypeDetailsW::kElemBits, kUseInterleavedConverter>>;
+};
+
+// Storage type of the weight scales and their conversion to the activation type. Only fp4 weights have fp8 scales,
+// they are multiplied by alpha in fp32 when it is applied in advance since the NVFP4 per tensor scale is far from 1
+template <typename Details, bool IsFp4 = Details::TypeDetailsW::kIsFp4>
+struct ScaleWrapper
+{
+    using Type = typename Details::TypeDetailsA::Type;
+    static constexpr bool kAppliesAlpha = false;
+
+    template <int N, bool ApplyAlphaInAdvance>
+    __device__ __forceinline__ static void convert(void* dst, void* src, float alpha)
+    {
+#pragma unroll
+        for (int i = 0; i < N; ++i)
+        {
+            reinterpret_cast<Type*>(dst)[i] = reinterpret_cast<Type*>(src)[i];
+        }
+    }
+};
+
+template <typename Details>
+struct ScaleWrapper<Details, true>
+{
+    using Type = typename Details::TypeDetailsW::TypeScale;
+    static constexpr bool kAppliesAlpha = true;
+
+    template <int N, bool ApplyAlphaInAdvance>
+    __device__ __forceinline__ static void convert(void* dst, void* src, float alpha)
+    {
+        using TypeA = typename Details::TypeDetailsA::Type;
+#pragma unroll
+        for (int i = 0; i < N; ++i)
+        {
+            float scale;
+            if constexpr (std::is_same_v<Type, uint8_t>)
+            {
+                // ue8m0, 2^(e - 127)
+                scale = __uint_as_float(static_cast<uint32_t>(reinterpret_cast<Type*>(src)[i]) << 23);
+            }
+            else
+            {
+                scale = static_cast<float>(reinterpret_cast<Type*>(src)[i]);
+            }
+            if constexpr (ApplyAlphaInAdvance)
+            {
+                scale *= alpha;
+            }
+            reinterpret_cast<TypeA*>(dst)[i] = static_cast<TypeA>(scale);
+        }
+    }
 };
 
 template <typename DetailsA>
@@ -119,6 +171,27 @@ __device__ __forceinline__ void apply_scale(void* act, void* act_scale)
     }
 }
 
+template <typename Details, int K, typename Iterator>
+__device__ __forceinline__ void load_act(void* act, Iterator& iterator, int iter, int ii)
+{
+    using Type = typename Details::TypeDetailsA::Type;
+    using TypeAct = typename Details::TypeDetailsAct::Type;
+    if constexpr (std::is_same_v<Type, TypeAct>)
+    {
+        iterator.load(act, iter, ii);
+    }
+    else
+    {
+        alignas(16) TypeAct tile_act[K];
+        iterator.load(tile_act, iter, ii);
+#pragma unroll
+        for (int k = 0; k < K; ++k)
+        {
+            reinterpret_cast<Type*>(act)[k] = static_cast<Type>(static_cast<float>(tile_act[k]));
+        }
+    }
+}
+
 template <typename Details, int N, int K, bool EnableZero, bool ApplyAlphaInAdvance>
 __device__ __forceinline__ void dequantize(void* w, void* quantized_w, void* scales, void* zeros, float alpha)
 {
@@ -214,8 +287,9 @@ __device__ __forceinline__ T warp_reduce_sum(T& val)
     return val;
 }
 
-template <typename Details, int CtaM, int CtaN, int Threads, bool EnableBias, bool ApplyAlphaInAdvance>
-__device__ __forceinline__ void epilogue(void* out, int stride, void* tile_acc, void* bias, float alpha)
+// Reduces the tile accumulators of all threads and calls store(m, n, val) for every element of the CTA tile
+template <typename Details, int CtaM, int CtaN, int Threads, typename Store>
+__device__ __forceinline__ void reduce_tile(void* tile_acc, Store store)
 {
     using Type = typename MathWrapper<typename Details::TypeDetailsA>::Type;
     static constexpr int Interleave = Details::kInterleave;
@@ -247,27 +321,46 @@ __device__ __forceinline__ void epilogue(void* out, int stride, void* tile_acc,
     for (int ii = tid; ii < CtaM * CtaN * Interleave; ii += Threads)
     {
         int m = ii / (CtaN * Interleave), n = ii % (CtaN * Interleave);
-        float val = 0.f, v_bias = 0.f;
-        if constexpr (EnableBias)
-        {
-            v_bias = static_cast<float>(reinterpret_cast<Type*>(bias)[n]);
-        }
+        float val = 0.f;
 #pragma unroll
         for (int jj = 0; jj < WarpNum; ++jj)
         {
             val += shmem[jj * CtaM * CtaN * Interleave + ii];
         }
-        if constexpr (ApplyAlphaInAdvance)
-        {
-            reinterpret_cast<Type*>(out)[m * stride + n] = static_cast<Type>(val + v_bias);
-        }
-        else
-        {
-            reinterpret_cast<Type*>(out)[m * stride + n] = static_cast<Type>(alpha * val + v_bias);
-        }
+        store(m, n, val);
     }
 }
 
+template <typename Details, int CtaM, int CtaN, int Threads, bool EnableBias, bool ApplyAlphaInAdvance>
+__device__ __forceinline__ void epilogue(void* out, int stride, void* tile_acc, void* bias, float alpha)
+{
+    using Type = typename MathWrapper<typename Details::TypeDetailsA>::Type;
+    reduce_tile<Details, CtaM, CtaN, Threads>(tile_acc,
+        [=](int m, int n, float val)
+        {
+            float v_bias = 0.f;
+            if constexpr (EnableBias)
+            {
+                v_bias = static_cast<float>(reinterpret_cast<Type*>(bias)[n]);
+            }
+            if constexpr (ApplyAlphaInAdvance)
+            {
+                reinterpret_cast<Type*>(out)[m * stride + n] = static_cast<Type>(val + v_bias);
+            }
+            else
+            {
+                reinterpret_cast<Type*>(out)[m * stride + n] = static_cast<Type>(alpha * val + v_bias);
+            }
+        });
+}
+
+// Writes the fp32 partial sums of one K split, alpha and bias are applied when the splits are reduced
+template <typename Details, int CtaM, int CtaN, int Threads>
+__device__ __forceinline__ void epilogue_split_k(float* out, int stride, void* tile_acc)
+{
+    reduce_tile<Details, CtaM, CtaN, Threads>(tile_acc, [=](int m, int n, float val) { out[m * stride + n] = val; });
+}
+
 template <int N, typename T>
 __device__ __forceinline__ void fill(void* tile, T v)
 {
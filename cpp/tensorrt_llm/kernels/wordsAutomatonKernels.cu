@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/wordsAutomatonKernels.h"
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::kernels
+{
+
+namespace
+{
+using Layout = WordsAutomatonLayout;
+
+__device__ SizeType32 automatonNext(SizeType32 const* automaton, SizeType32 state, TokenIdType token)
+{
+    auto const* edgeOffsets = automaton + automaton[Layout::kEdgeOffsetsBegin];
+    auto const* edgeTokens = automaton + automaton[Layout::kEdgeTokensBegin];
+    auto const* edgeTargets = automaton + automaton[Layout::kEdgeTargetsBegin];
+    auto const* fail = automaton + automaton[Layout::kFailBegin];
+    while (true)
+    {
+        // Binary search of the token in the sorted edges of the state
+        auto lo = edgeOffsets[state];
+        auto const end = edgeOffsets[state + 1];
+        auto hi = end;
+        while (lo < hi)
+        {
+            auto const mid = (lo + hi) / 2;
+            if (edgeTokens[mid] < token)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        if (lo < end && edgeTokens[lo] == token)
+        {
+            return edgeTargets[lo];
+        }
+        if (state == Layout::kRootState)
+        {
+            return Layout::kRootState;
+        }
+        state = fail[state];
+    }
+}
+
+//! \brief Restart from the root when the tokens read so far are not a prefix of the first `end` tokens, e.g. for a
+//! new request. The state only depends on the last `height` tokens, older tokens are not read again.
+__device__ void seekAutomaton(
+    SizeType32 const* automaton, SizeType32& state, SizeType32& numRead, SizeType32 end, SizeType32 sequenceLength)
+{
+    auto const restart = max(0, end - automaton[Layout::kHeight]);
+    if (numRead < restart || numRead > min(end, sequenceLength))
+    {
+        state = Layout::kRootState;
+        numRead = restart;
+    }
+}
+
+__global__ void stopWordsAutomaton(TokenIdType const** outputIds, SizeType32 const* const* automata,
+    SizeType32* progress, FinishedState* finished, SizeType32* sequenceLengths, SizeType32 const* batchSlots,
+    SizeType32* numNewTokens, SizeType32 batchSize)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x * blockDim.x + threadIdx.x);
+    if (batchIdx >= batchSize)
+    {
+        return;
+    }
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    auto const* automaton = automata[batchSlot];
+    if (automaton == nullptr)
+    {
+        return;
+    }
+
+    auto const* match = automaton + automaton[Layout::kMatchBegin];
+    auto const* ids = outputIds[batchSlot];
+    auto const newTokens = numNewTokens ? numNewTokens[batchSlot] : 1;
+    auto const sequenceLength = sequenceLengths[batchSlot];
+    // Need to minus newTokens because the sequenceLengths is already updated in this point
+    auto const firstNewToken = sequenceLength - newTokens;
+
+    auto state = progress[batchSlot * 2];
+    auto numRead = progress[batchSlot * 2 + 1];
+    seekAutomaton(automaton, state, numRead, firstNewToken, sequenceLength);
+    while (numRead < sequenceLength)
+    {
+        state = automatonNext(automaton, state, ids[numRead]);
+        ++numRead;
+        if (numRead > firstNewToken && match[state])
+        {
+            finished[batchSlot].setFinishedStopWords();
+            // When more than 1 token is predicted per step, stop at the first match with a stop word
+            if (newTokens > 1)
+            {
+                // Update num of new tokens and seq lengths up to stopped word (including).
+                numNewTokens[batchSlot] = numRead - firstNewToken;
+                sequenceLengths[batchSlot] = numRead;
+            }
+            break;
+        }
+    }
+    progress[batchSlot * 2] = state;
+    progress[batchSlot * 2 + 1] = numRead;
+}
+
+template <typename T>
+__global__ void banWordsAutomaton(T* logits, TokenIdType const** outputIds, SizeType32 const* const* automata,
+    SizeType32* progress, SizeType32 const* batchSlots, SizeType32 const* sequenceLengths, SizeType32 vocabSizePadded)
+{
+    auto const batchIdx = static_cast<SizeType32>(blockIdx.x);
+    auto const batchSlot = batchSlots != nullptr ? batchSlots[batchIdx] : batchIdx;
+    auto const* automaton = automata[batchSlot];
+    if (automaton == nullptr)
+    {
+        return;
+    }
+
+    __shared__ SizeType32 sharedState;
+    if (threadIdx.x == 0)
+    {
+        auto const* ids = outputIds[batchSlot];
+        auto const sequenceLength = sequenceLengths[batchSlot];
+        auto state = progress[batchSlot * 2];
+        auto numRead = progress[batchSlot * 2 + 1];
+        seekAutomaton(automaton, state, numRead, sequenceLength, sequenceLength);
+        for (; numRead < sequenceLength; ++numRead)
+        {
+            state = automatonNext(automaton, state, ids[numRead]);
+        }
+        progress[batchSlot * 2] = state;
+        progress[batchSlot * 2 + 1] = numRead;
+        sharedState = state;
+    }
+    __syncthreads();
+
+    auto const* banOffsets = automaton + automaton[Layout::kBanOffsetsBegin];
+    auto const* banTokens = automaton + automaton[Layout::kBanTokensBegin];
+    auto const* banLink = automaton + automaton[Layout::kBanLinkBegin];
+    auto* batchLogits = logits + batchIdx * vocabSizePadded;
+    auto const state = sharedState;
+    // Tokens completing a word from the state or from one of its suffixes
+    for (auto link = banOffsets[state] < banOffsets[state + 1] ? state : banLink[state]; link != Layout::kNoState;
+         link = banLink[link])
+    {
+        for (auto idx = banOffsets[link] + static_cast<SizeType32>(threadIdx.x); idx < banOffsets[link + 1];
+             idx += static_cast<SizeType32>(blockDim.x))
+        {
+            auto const bannedToken = banTokens[idx];
+            if (bannedToken < vocabSizePadded)
+            {
+                batchLogits[bannedToken] = static_cast<T>(-INFINITY);
+            }
+        }
+    }
+}
+} // namespace
+
+void invokeStopWordsAutomaton(TokenIdType const** outputIds, SizeType32 const* const* automata, SizeType32* progress,
+    FinishedState* finished, SizeType32* sequenceLengths, SizeType32 const* batchSlots, SizeType32* numNewTokens,
+    SizeType32 batchSize, cudaStream_t stream)
+{
+    SizeType32 constexpr blockSize{128};
+    dim3 const grid{static_cast<unsigned int>((batchSize + blockSize - 1) / blockSize)};
+    stopWordsAutomaton<<<grid, blockSize, 0, stream>>>(
+        outputIds, automata, progress, finished, sequenceLengths, batchSlots, numNewTokens, batchSize);
+    sync_check_cuda_error();
+}
+
+template <typename T>
+void invokeBanWordsAutomaton(T* logits, TokenIdType const** outputIds, SizeType32 const* const* automata,
+    SizeType32* progress, SizeType32 const* batchSlots, SizeType32 const* sequenceLengths, SizeType32 batchSize,
+    SizeType32 vocabSizePadded, cudaStream_t stream)
+{
+    SizeType32 constexpr blockSize{128};
+    banWordsAutomaton<<<batchSize, blockSize, 0, stream>>>(
+        logits, outputIds, automata, progress, batchSlots, sequenceLengths, vocabSizePadded);
+    sync_check_cuda_error();
+}
+
+template void invokeBanWordsAutomaton(float* logits, TokenIdType const** outputIds, SizeType32 const* const* automata,
+    SizeType32* progress, SizeType32 const* batchSlots, SizeType32 const* sequenceLengths, SizeType32 batchSize,
+    SizeType32 vocabSizePadded, cudaStream_t stream);
+template void invokeBanWordsAutomaton(half* logits, TokenIdType const** outputIds, SizeType32 const* const* automata,
+    SizeType32* progress, SizeType32 const* batchSlots, SizeType32 const* sequenceLengths, SizeType32 batchSize,
+    SizeType32 vocabSizePadded, cudaStream_t stream);
+#ifdef ENABLE_BF16
+template void invokeBanWordsAutomaton(__nv_bfloat16* logits, TokenIdType const** outputIds,
+    SizeType32 const* const* automata, SizeType32* progress, SizeType32 const* batchSlots,
+    SizeType32 const* sequenceLengths, SizeType32 batchSize, SizeType32 vocabSizePadded, cudaStream_t stream);
+#endif
+
+} // namespace tensorrt_llm::kernels
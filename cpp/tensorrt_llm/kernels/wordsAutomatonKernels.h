@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/wordsAutomatonLayout.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime.h>
+
+namespace tensorrt_llm::kernels
+{
+
+//! \brief Advances the stop words automata with the new tokens of the requests and sets the finished state to
+//! FinishedState::FINISHED_STOP_WORDS when a stop word ends at one of the new tokens. Supports beamWidth 1 only.
+//! Tokens between the last call and the new tokens are read as well, at most the height of the automaton of them.
+//!
+//! \param outputIds input buffer [maxBatchSize][maxSeqLen]. Contains pointers to rows with output tokens per request
+//! \param automata input buffer [maxBatchSize]. Device pointers to the automata in the WordsAutomatonLayout,
+//! requests without automaton are skipped
+//! \param progress input/output buffer [maxBatchSize, 2]. State in the automaton and number of tokens read so far
+//! \param finished input/output buffer [maxBatchSize]. Finished states
+//! \param sequenceLengths input/output buffer [maxBatchSize]. Current sequence lengths of the request tokens.
+//! When numNewTokens is not nullptr, it is updated to the end of the first stop word found.
+//! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
+//! \param numNewTokens input/output buffer [maxBatchSize], optional, number of tokens predicted per step.
+//! If nullptr, 1 is used.
+//! \param batchSize batch size
+//! \param stream stream
+void invokeStopWordsAutomaton(runtime::TokenIdType const** outputIds, runtime::SizeType32 const* const* automata,
+    runtime::SizeType32* progress, FinishedState* finished, runtime::SizeType32* sequenceLengths,
+    runtime::SizeType32 const* batchSlots, runtime::SizeType32* numNewTokens, runtime::SizeType32 batchSize,
+    cudaStream_t stream);
+
+//! \brief Advances the bad words automata with the tokens of the requests and sets the logits of the tokens
+//! completing a bad word to -INF. Supports beamWidth 1 only.
+//!
+//! \param logits input/output buffer [batchSize, vocabSizePadded]
+//! \param outputIds input buffer [maxBatchSize][maxSeqLen]. Contains pointers to rows with output tokens per request
+//! \param automata input buffer [maxBatchSize]. Device pointers to the automata in the WordsAutomatonLayout,
+//! requests without automaton are skipped
+//! \param progress input/output buffer [maxBatchSize, 2]. State in the automaton and number of tokens read so far
+//! \param batchSlots input buffer[batchSize], optional. Indices of rows of data in memory pool
+//! \param sequenceLengths input buffer [maxBatchSize]. Current sequence lengths of the request tokens
+//! \param batchSize batch size
+//! \param vocabSizePadded padded vocab size
+//! \param stream stream
+template <typename T>
+void invokeBanWordsAutomaton(T* logits, runtime::TokenIdType const** outputIds,
+    runtime::SizeType32 const* const* automata, runtime::SizeType32* progress, runtime::SizeType32 const* batchSlots,
+    runtime::SizeType32 const* sequenceLengths, runtime::SizeType32 batchSize, runtime::SizeType32 vocabSizePadded,
+    cudaStream_t stream);
+
+} // namespace tensorrt_llm::kernels
@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+namespace tensorrt_llm::kernels
+{
+
+//! \brief Flat int32 layout of an Aho-Corasick automaton over token ids, built by layers::WordsAutomaton.
+//! The buffer starts with kHeaderSize values, the entries k*Begin are the offsets of the sections in the buffer:
+//! edgeOffsets [numStates + 1]  goto edges of a state are [edgeOffsets[s], edgeOffsets[s + 1])
+//! edgeTokens  [numEdges]       tokens of the edges, sorted per state
+//! edgeTargets [numEdges]       target states of the edges
+//! fail        [numStates]      failure link, longest proper suffix of the state which is a state, fail[0] = 0
+//! match       [numStates]      1 if a word is a suffix of the state, 0 otherwise
+//! banOffsets  [numStates + 1]  tokens completing a word from the state are [banOffsets[s], banOffsets[s + 1])
+//! banTokens   [numBans]        tokens completing a word, sorted per state
+//! banLink     [numStates]      closest proper suffix of the state with tokens completing a word, -1 if none
+//! State 0 is the root, i.e. the empty prefix.
+struct WordsAutomatonLayout
+{
+    static constexpr runtime::SizeType32 kNumStates = 0;
+    //! Length of the longest word, the state only depends on that many last tokens.
+    static constexpr runtime::SizeType32 kHeight = 1;
+    static constexpr runtime::SizeType32 kEdgeOffsetsBegin = 2;
+    static constexpr runtime::SizeType32 kEdgeTokensBegin = 3;
+    static constexpr runtime::SizeType32 kEdgeTargetsBegin = 4;
+    static constexpr runtime::SizeType32 kFailBegin = 5;
+    static constexpr runtime::SizeType32 kMatchBegin = 6;
+    static constexpr runtime::SizeType32 kBanOffsetsBegin = 7;
+    static constexpr runtime::SizeType32 kBanTokensBegin = 8;
+    static constexpr runtime::SizeType32 kBanLinkBegin = 9;
+    static constexpr runtime::SizeType32 kHeaderSize = 10;
+
+    static constexpr runtime::SizeType32 kRootState = 0;
+    static constexpr runtime::SizeType32 kNoState = -1;
+};
+
+} // namespace tensorrt_llm::kernels
@@ -16,8 +16,10 @@
  */
 
 #include "tensorrt_llm/layers/banWordsLayer.h"
+#include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/kernels/banBadWords.h"
 #include "tensorrt_llm/kernels/banRepeatNgram.h"
+#include "tensorrt_llm/kernels/wordsAutomatonKernels.h"
 #include "tensorrt_llm/layers/defaultDecodingParams.h"
 #include "tensorrt_llm/layers/layerUtils.h"
 
@@ -58,6 +60,10 @@ void BanWordsLayer<T>::initialize()
     allocateBuffer();
 
     mNoRepeatNgramSize.resize(mDecoderDomain.getBatchSize());
+    if (mDecodingMode.isUseBanTokens())
+    {
+        mBadWordsAutomata = std::make_unique<DeviceWordsAutomata>(mDecoderDomain.getBatchSize(), mAllocator);
+    }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -71,6 +77,11 @@ void BanWordsLayer<T>::allocateBuffer()
     {
         mNoRepeatNgramSizeDevice
             = mAllocator->reMalloc(mNoRepeatNgramSizeDevice, sizeof(SizeType32) * mDecoderDomain.getBatchSize(), false);
+        mNgramNumIndexedDevice
+            = mAllocator->reMalloc(mNgramNumIndexedDevice, sizeof(SizeType32) * mDecoderDomain.getBatchSize(), false);
+        // -1 rebuilds the Ngram sets
+        TLLM_CUDA_CHECK(cudaMemsetAsync(
+            mNgramNumIndexedDevice, 0xFF, sizeof(SizeType32) * mDecoderDomain.getBatchSize(), mStream));
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -84,6 +95,11 @@ void BanWordsLayer<T>::freeBuffer()
     if (mDecodingMode.isUseNoRepeatNgramSize())
     {
         mAllocator->free((void**) (&mNoRepeatNgramSizeDevice));
+        mAllocator->free((void**) (&mNgramNumIndexedDevice));
+        if (mNgramTablesDevice != nullptr)
+        {
+            mAllocator->free((void**) (&mNgramTablesDevice));
+        }
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -110,6 +126,23 @@ void BanWordsLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeTyp
             mNoRepeatNgramSize, mNoRepeatNgramSizeDevice, batchSlotsHost,
             std::make_pair(0.f, std::numeric_limits<float>::max()), "no_repeat_ngram_size");
     }
+    if (mDecodingMode.isUseNoRepeatNgramSize())
+    {
+        // New requests rebuild the Ngram sets of their slots
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            TLLM_CUDA_CHECK(
+                cudaMemsetAsync(mNgramNumIndexedDevice + batchSlotsHost[bi], 0xFF, sizeof(SizeType32), mStream));
+        }
+    }
+    if (mBadWordsAutomata)
+    {
+        auto const& automata = banWordsParams->badWordsAutomata;
+        TLLM_CHECK_WITH_INFO(beamWidth == 1
+                || std::all_of(automata.begin(), automata.end(), [](auto const& automaton) { return !automaton; }),
+            "Bad words automata require beam width 1");
+        mBadWordsAutomata->setup(automata, batchSize, batchSlotsHost, mStream);
+    }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -135,12 +168,44 @@ void BanWordsLayer<T>::banRepeatNGrams(Tensor& logits, std::shared_ptr<BaseDecod
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+template <typename T>
+void BanWordsLayer<T>::banRepeatNGramsHashed(Tensor& logits, std::shared_ptr<BaseDecodingOutputs> const& outputs,
+    std::shared_ptr<DecodingInputs> const& inputs, SizeType32 const* batchSlots, DecoderDomain const& decoderDomain,
+    SizeType32 maxSeqLen)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const tableCapacity = getBanRepeatNgramTableCapacity(maxSeqLen);
+    if (tableCapacity != mNgramTableCapacity)
+    {
+        mNgramTablesDevice = mAllocator->reMalloc(mNgramTablesDevice,
+            sizeof(std::uint64_t) * tableCapacity * mDecoderDomain.getBatchSize(), false);
+        mNgramTableCapacity = tableCapacity;
+        TLLM_CUDA_CHECK(cudaMemsetAsync(
+            mNgramNumIndexedDevice, 0xFF, sizeof(SizeType32) * mDecoderDomain.getBatchSize(), mStream));
+    }
+    invokeBanRepeatNgramHashed(logits.template getPtr<T>(), outputs->outputIdsPtr.template getPtr<TokenIdType const*>(),
+        reinterpret_cast<FinishedState*>(
+            inputs->finished.value_or(Tensor{}).template getPtr<FinishedState::UnderlyingType>()),
+        batchSlots, outputs->sequenceLength->template getPtr<SizeType32>(), decoderDomain.getBatchSize(),
+        mNoRepeatNgramSizeDevice, decoderDomain.getVocabSizePadded(), mNgramTablesDevice, mNgramNumIndexedDevice,
+        mNgramTableCapacity, mStream);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
 template <typename T>
 void BanWordsLayer<T>::banBadWords(Tensor& logits, std::shared_ptr<BaseDecodingOutputs> const& outputs,
     std::shared_ptr<DecodingInputs> const& inputs, SizeType32 const* batchSlots, DecoderDomain const& decoderDomain,
-    SizeType32 maxSeqLen, cudaStream_t stream)
+    SizeType32 maxSeqLen, DeviceWordsAutomata const* badWordsAutomata, cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    bool const useAutomata = badWordsAutomata != nullptr && badWordsAutomata->hasAutomata();
+    if (useAutomata)
+    {
+        invokeBanWordsAutomaton(logits.template getPtr<T>(),
+            outputs->outputIdsPtr.template getPtr<TokenIdType const*>(), badWordsAutomata->getAutomataDevice(),
+            badWordsAutomata->getProgressDevice(), batchSlots, outputs->sequenceLength->template getPtr<SizeType32>(),
+            decoderDomain.getBatchSize(), decoderDomain.getVocabSizePadded(), stream);
+    }
     auto const maxBadWordsLength = inputs->banWordsInputs->maxBadWordsLen;
     if (maxBadWordsLength)
     {
@@ -151,7 +216,8 @@ void BanWordsLayer<T>::banBadWords(Tensor& logits, std::shared_ptr<BaseDecodingO
             decoderDomain.getBeamWidth() > 1 ? outputs->parentIdsPtr.template getPtr<SizeType32 const*>() : nullptr,
             batchSlots, decoderDomain.getBatchSize(), decoderDomain.getBeamWidth(), badWordsPtr, badWordsLens,
             maxBadWordsLength, decoderDomain.getVocabSizePadded(),
-            outputs->sequenceLength->template getPtr<SizeType32>(), maxSeqLen, stream);
+            outputs->sequenceLength->template getPtr<SizeType32>(), maxSeqLen,
+            useAutomata ? badWordsAutomata->getHasAutomatonDevice() : nullptr, stream);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -171,9 +237,17 @@ void BanWordsLayer<T>::forwardAsync(
     auto const maxSeqLen = outputs->outputIds.shape[outputs->outputIds.shape.size() - 1];
     auto batchSlots = inputs->batchSlots ? inputs->batchSlots->template getPtr<SizeType32 const>() : nullptr;
 
-    banRepeatNGrams(inputs->logits.value(), outputs, inputs, batchSlots, mNoRepeatNgramSizeDevice, localDecoderDomain,
-        maxSeqLen, mUseNoRepeatNgramSize, mStream);
-    banBadWords(inputs->logits.value(), outputs, inputs, batchSlots, localDecoderDomain, maxSeqLen, mStream);
+    if (mUseNoRepeatNgramSize && localDecoderDomain.getBeamWidth() == 1)
+    {
+        banRepeatNGramsHashed(inputs->logits.value(), outputs, inputs, batchSlots, localDecoderDomain, maxSeqLen);
+    }
+    else
+    {
+        banRepeatNGrams(inputs->logits.value(), outputs, inputs, batchSlots, mNoRepeatNgramSizeDevice,
+            localDecoderDomain, maxSeqLen, mUseNoRepeatNgramSize, mStream);
+    }
+    banBadWords(inputs->logits.value(), outputs, inputs, batchSlots, localDecoderDomain, maxSeqLen,
+        mBadWordsAutomata.get(), mStream);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -21,6 +21,7 @@
 #include "tensorrt_llm/executor/types.h"
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
+#include "tensorrt_llm/layers/wordsAutomaton.h"
 
 #include <curand_kernel.h>
 
@@ -30,7 +31,9 @@ namespace tensorrt_llm::layers
 //! \brief Layer to ban specific words from being sampled.
 //! Supports banning bad words and repeating N grams.
 //! Set badWordsPtr, maxBadWordsLen and badWordsLengths to ban bad words.
+//! Or set badWordsAutomata in setup params to ban bad words with one transition per token, see WordsAutomaton.
 //! Set noRepeatNgramSize in input params to ban repeat Ngrams.
+//! With beam width 1, the Ngrams of each request are kept in a hash set on the GPU, updated with the new tokens.
 //! Layer modifies logits in-place.
 template <typename T>
 class BanWordsLayer : public BaseLayer
@@ -48,17 +51,27 @@ public:
     void forwardAsync(std::shared_ptr<BaseDecodingOutputs> const& outputs,
         std::shared_ptr<BaseDecodingInputs> const& inputs) override;
 
+    //! \brief Whether bad words of a request are banned with its automaton.
+    [[nodiscard]] bool hasBadWordsAutomata() const
+    {
+        return mBadWordsAutomata && mBadWordsAutomata->hasAutomata();
+    }
+
 private:
     void initialize();
     void allocateBuffer();
     void freeBuffer();
     static void banBadWords(tc::Tensor& logits, std::shared_ptr<BaseDecodingOutputs> const& outputs,
         std::shared_ptr<DecodingInputs> const& inputs, runtime::SizeType32 const* batchSlots,
-        DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, cudaStream_t stream);
+        DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, DeviceWordsAutomata const* badWordsAutomata,
+        cudaStream_t stream);
     static void banRepeatNGrams(tc::Tensor& logits, std::shared_ptr<BaseDecodingOutputs> const& outputs,
         std::shared_ptr<DecodingInputs> const& inputs, runtime::SizeType32 const* batchSlots,
         runtime::SizeType32 const* noRepeatNgramSizeDevice, DecoderDomain const& decoderDomain,
         runtime::SizeType32 maxSeqLen, bool useNoRepeatNgramSize, cudaStream_t stream);
+    void banRepeatNGramsHashed(tc::Tensor& logits, std::shared_ptr<BaseDecodingOutputs> const& outputs,
+        std::shared_ptr<DecodingInputs> const& inputs, runtime::SizeType32 const* batchSlots,
+        DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen);
 
 private:
     using BaseLayer::mWorkspaceSize;
@@ -72,6 +85,12 @@ private:
     runtime::SizeType32* mNoRepeatNgramSizeDevice{nullptr};
     std::vector<SizeType32> mNoRepeatNgramSize;
     bool mUseNoRepeatNgramSize{false};
+    //! Hash sets of the Ngrams of each slot, allocated for the maximum sequence length of the first forward
+    std::uint64_t* mNgramTablesDevice{nullptr};            // [maxBatchSize, mNgramTableCapacity]
+    runtime::SizeType32* mNgramNumIndexedDevice{nullptr}; // [maxBatchSize]
+    runtime::SizeType32 mNgramTableCapacity{0};
+
+    std::unique_ptr<DeviceWordsAutomata> mBadWordsAutomata;
 };
 
 } // namespace tensorrt_llm::layers
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/constrainedDecodingLayer.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/tokenBitmask.h"
+#include "tensorrt_llm/layers/layerUtils.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::kernels;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::layers
+{
+
+template <typename T>
+ConstrainedDecodingLayer<T>::ConstrainedDecodingLayer(executor::DecodingMode const& mode,
+    DecoderDomain const& decoderDomain, cudaStream_t stream, std::shared_ptr<IAllocator> allocator)
+    : BaseLayer(decoderDomain, stream, std::move(allocator))
+    , mNumWords{static_cast<SizeType32>(ceilDiv(decoderDomain.getVocabSize(), TokenAutomaton::kBitsPerWord))}
+    , mWorkerPool{1, getDevice()}
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto const maxBatchSize = mDecoderDomain.getBatchSize();
+    mAutomata.resize(maxBatchSize);
+    mStates.resize(maxBatchSize, TokenAutomaton::getInitialState());
+    mMasks.resize(maxBatchSize);
+    allocateBuffer();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+ConstrainedDecodingLayer<T>::~ConstrainedDecodingLayer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    try
+    {
+        waitForAdvance();
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_EXCEPTION(e);
+    }
+    freeBuffer();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::allocateBuffer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto const maxBatchSize = mDecoderDomain.getBatchSize();
+    mNewTokensHost = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), TRTDataType<TokenIdType>::value);
+    mBitmasksHost = BufferManager::pinned(ITensor::makeShape({maxBatchSize, mNumWords}), nvinfer1::DataType::kINT32);
+    mBatchIndicesHost = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+    mBitmasksDevice = mAllocator->reMalloc(mBitmasksDevice, sizeof(std::uint32_t) * maxBatchSize * mNumWords, false);
+    mBatchIndicesDevice = mAllocator->reMalloc(mBatchIndicesDevice, sizeof(SizeType32) * maxBatchSize, false);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::freeBuffer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    mAllocator->free((void**) (&mBitmasksDevice));
+    mAllocator->free((void**) (&mBatchIndicesDevice));
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::waitForAdvance()
+{
+    if (mAdvance.valid())
+    {
+        mAdvance.get();
+    }
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 const* batchSlots,
+    std::shared_ptr<BaseSetupParams> const& baseSetupParams)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto setupParams = std::dynamic_pointer_cast<DynamicDecodeSetupParams>(baseSetupParams);
+    auto const& constrainedParams = setupParams->constrainedDecodingParams;
+    if (constrainedParams)
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<SizeType32>(constrainedParams->automata.size()) == batchSize,
+            "Expected %d automata for constrained decoding, got %zu", batchSize, constrainedParams->automata.size());
+    }
+    waitForAdvance();
+
+    std::vector<SizeType32> constrainedSlots;
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = batchSlots != nullptr ? batchSlots[bi] : bi;
+        auto automaton = constrainedParams ? constrainedParams->automata[bi] : nullptr;
+        TLLM_CHECK_WITH_INFO(automaton == nullptr || beamWidth == 1, "Constrained decoding requires beam width 1");
+        mAutomata[slot] = std::move(automaton);
+        mStates[slot] = TokenAutomaton::getInitialState();
+        mMasks[slot] = nullptr;
+        if (mAutomata[slot])
+        {
+            constrainedSlots.push_back(slot);
+        }
+    }
+    if (!constrainedSlots.empty())
+    {
+        // Masks of the first step, computed while the context phase runs
+        mAdvance = mWorkerPool.enqueue(
+            [this, constrainedSlots = std::move(constrainedSlots)]()
+            {
+                for (auto const slot : constrainedSlots)
+                {
+                    mMasks[slot] = mAutomata[slot]->getMask(mStates[slot]);
+                }
+            });
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::forwardAsync(
+    std::shared_ptr<BaseDecodingOutputs> const& baseOutputs, std::shared_ptr<BaseDecodingInputs> const& baseInputs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto inputs = std::dynamic_pointer_cast<DecodingInputs>(baseInputs);
+    auto const localDecoderDomain = getLocalDecoderDomain(inputs, mDecoderDomain);
+    auto const batchSize = localDecoderDomain.getBatchSize();
+    auto const* batchSlots = inputs->batchSlots ? inputs->batchSlots->template getPtr<SizeType32 const>() : nullptr;
+
+    waitForAdvance();
+    if (mHasBitmasksCopy)
+    {
+        // The host buffers are rewritten below
+        mBitmasksCopied.synchronize();
+        mHasBitmasksCopy = false;
+    }
+
+    auto* bitmasks = bufferCast<std::int32_t>(*mBitmasksHost);
+    auto* batchIndices = bufferCast<SizeType32>(*mBatchIndicesHost);
+    SizeType32 numMasks{0};
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = batchSlots != nullptr ? batchSlots[bi] : bi;
+        auto const& automaton = mAutomata[slot];
+        if (!automaton || mStates[slot] == ByteDfa::kDeadState)
+        {
+            continue;
+        }
+        TLLM_CHECK_WITH_INFO(localDecoderDomain.getBeamWidth() == 1, "Constrained decoding requires beam width 1");
+        if (!mMasks[slot])
+        {
+            mMasks[slot] = automaton->getMask(mStates[slot]);
+        }
+        auto const& mask = *mMasks[slot];
+        auto* row = bitmasks + static_cast<std::size_t>(numMasks) * mNumWords;
+        // Tokens beyond the vocabulary of the grammar are not allowed
+        auto const numWords = std::min(static_cast<SizeType32>(mask.size()), mNumWords);
+        std::memcpy(row, mask.data(), numWords * sizeof(std::uint32_t));
+        std::fill(row + numWords, row + mNumWords, 0);
+        batchIndices[numMasks++] = bi;
+    }
+    if (numMasks == 0)
+    {
+        return;
+    }
+
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(mBitmasksDevice, bitmasks,
+        sizeof(std::uint32_t) * numMasks * mNumWords, cudaMemcpyHostToDevice, mStream));
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(
+        mBatchIndicesDevice, batchIndices, sizeof(SizeType32) * numMasks, cudaMemcpyHostToDevice, mStream));
+    TLLM_CUDA_CHECK(cudaEventRecord(mBitmasksCopied.get(), mStream));
+    mHasBitmasksCopy = true;
+
+    invokeApplyTokenBitmask(inputs->logits->template getPtr<T>(), mBitmasksDevice, mBatchIndicesDevice, numMasks,
+        mDecoderDomain.getVocabSize(), mDecoderDomain.getVocabSizePadded(), mStream);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void ConstrainedDecodingLayer<T>::advanceAsync(
+    std::shared_ptr<BaseDecodingOutputs> const& outputs, SizeType32 const* batchSlots, SizeType32 batchSize)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    std::vector<SizeType32> constrainedSlots;
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = batchSlots != nullptr ? batchSlots[bi] : bi;
+        if (mAutomata[slot] && mStates[slot] != ByteDfa::kDeadState)
+        {
+            constrainedSlots.push_back(slot);
+        }
+    }
+    if (constrainedSlots.empty())
+    {
+        return;
+    }
+
+    // newTokens is [maxBatchSize, beamWidth] and constrained requests have beam width 1
+    TLLM_CHECK(outputs->newTokens.shape.size() < 2 || outputs->newTokens.shape[1] == 1);
+    waitForAdvance();
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(mNewTokensHost->data(), outputs->newTokens.template getPtr<TokenIdType const>(),
+        mNewTokensHost->getSizeInBytes(), cudaMemcpyDeviceToHost, mStream));
+    TLLM_CUDA_CHECK(cudaEventRecord(mNewTokensCopied.get(), mStream));
+
+    mAdvance = mWorkerPool.enqueue(
+        [this, constrainedSlots = std::move(constrainedSlots)]()
+        {
+            mNewTokensCopied.synchronize();
+            auto const* newTokens = bufferCast<TokenIdType>(*mNewTokensHost);
+            for (auto const slot : constrainedSlots)
+            {
+                auto const& automaton = mAutomata[slot];
+                auto const state = automaton->advance(mStates[slot], newTokens[slot]);
+                if (state == ByteDfa::kDeadState)
+                {
+                    TLLM_LOG_WARNING("Token %d is not allowed by the grammar of batch slot %d, the request is not "
+                                     "constrained anymore", newTokens[slot], slot);
+                }
+                mStates[slot] = state;
+                mMasks[slot] = state == ByteDfa::kDeadState ? nullptr : automaton->getMask(state);
+            }
+        });
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template class ConstrainedDecodingLayer<float>;
+template class ConstrainedDecodingLayer<half>;
+
+} // namespace tensorrt_llm::layers
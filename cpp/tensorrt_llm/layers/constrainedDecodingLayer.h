@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/layers/baseLayer.h"
+#include "tensorrt_llm/layers/decodingParams.h"
+#include "tensorrt_llm/layers/tokenAutomaton.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/workerPool.h"
+
+#include <future>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::layers
+{
+
+//! \brief Layer restricting the sampled tokens of requests to their grammar, e.g. a regex, see TokenAutomaton.
+//! \details Requests set their automaton in ConstrainedDecodingSetupParams, other requests are not constrained. The
+//! params are filled by the caller of DynamicDecodeLayer, neither GptDecoder nor the batch manager sets them.
+//! After the tokens of a step are sampled, advanceAsync copies them to the host and a worker thread advances the
+//! automata and prepares the bitmasks of the next step, in parallel with the next forward pass. forwardAsync waits
+//! for the worker and applies the bitmasks to the logits on the GPU. Beam search is not supported.
+//! Layer modifies logits in-place.
+template <typename T>
+class ConstrainedDecodingLayer : public BaseLayer
+{
+public:
+    ConstrainedDecodingLayer(executor::DecodingMode const& mode, DecoderDomain const& decoderDomain,
+        cudaStream_t stream, std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
+
+    ~ConstrainedDecodingLayer() override;
+
+    void setup(runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 const* batchSlots,
+        std::shared_ptr<BaseSetupParams> const& baseSetupParams) override;
+
+    //! \brief Modifies 'inputs->logits' in-place with -INF for the tokens the grammars do not allow
+    void forwardAsync(std::shared_ptr<BaseDecodingOutputs> const& outputs,
+        std::shared_ptr<BaseDecodingInputs> const& inputs) override;
+
+    //! \brief Advance the automata with the tokens in 'outputs->newTokens', once they are sampled.
+    //! \param batchSlots Host accessible, nullptr for the identity.
+    void advanceAsync(std::shared_ptr<BaseDecodingOutputs> const& outputs, runtime::SizeType32 const* batchSlots,
+        runtime::SizeType32 batchSize);
+
+private:
+    void allocateBuffer();
+    void freeBuffer();
+    void waitForAdvance();
+
+private:
+    using BaseLayer::mStream;
+    using BaseLayer::mAllocator;
+    using BaseLayer::mDecoderDomain;
+
+    runtime::SizeType32 mNumWords;
+
+    std::vector<std::shared_ptr<TokenAutomaton const>> mAutomata;       // [maxBatchSize]
+    std::vector<TokenAutomaton::StateType> mStates;                     // [maxBatchSize]
+    std::vector<std::shared_ptr<TokenAutomaton::Bitmask const>> mMasks; // [maxBatchSize], of the next step
+
+    runtime::ITensor::SharedPtr mNewTokensHost;    // [maxBatchSize], pinned
+    runtime::ITensor::SharedPtr mBitmasksHost;     // [maxBatchSize, mNumWords], pinned
+    runtime::ITensor::SharedPtr mBatchIndicesHost; // [maxBatchSize], pinned
+    std::uint32_t* mBitmasksDevice{nullptr};
+    runtime::SizeType32* mBatchIndicesDevice{nullptr};
+
+    runtime::CudaEvent mNewTokensCopied;
+    runtime::CudaEvent mBitmasksCopied;
+    bool mHasBitmasksCopy{false};
+
+    runtime::WorkerPool mWorkerPool;
+    std::future<void> mAdvance;
+};
+
+} // namespace tensorrt_llm::layers
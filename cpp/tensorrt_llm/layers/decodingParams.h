@@ -33,6 +33,9 @@ namespace tc = tensorrt_llm::common;
 namespace tensorrt_llm::layers
 {
 
+class TokenAutomaton;
+class WordsAutomaton;
+
 //!
 //! \brief In a DecodingLayer's life cycle, it is constructed once;
 //! `setup` repeatedly, but once per request; `forward*` repeatedly, many times per request.
@@ -131,6 +134,16 @@ class BanWordsSetupParams : public BaseSetupParams
 {
 public:
     std::optional<std::vector<runtime::SizeType32>> noRepeatNgramSize; // [1] or [setupBatchSize] on cpu
+    // Automaton of the bad words of each request, nullptr to ban the bad words of the decoding inputs
+    std::vector<std::shared_ptr<WordsAutomaton const>> badWordsAutomata; // [setupBatchSize] on cpu, or empty
+};
+
+// Stop criteria layer
+class StopCriteriaSetupParams : public BaseSetupParams
+{
+public:
+    // Automaton of the stop words of each request, nullptr to check the stop words of the decoding inputs
+    std::vector<std::shared_ptr<WordsAutomaton const>> stopWordsAutomata; // [setupBatchSize] on cpu, or empty
 };
 
 class DecodingSetupParams : public BaseSetupParams
@@ -141,6 +154,8 @@ public:
     std::optional<std::vector<uint64_t>> randomSeed; // [1] or [setupBatchSize] on cpu
     std::optional<std::vector<bool>> outputLogProbs; // [setupBatchSize]
     std::optional<std::vector<bool>> cumLogProbs;    // [setupBatchSize]
+    // Number of alternatives returned with their log probs per generated token, 0 to disable
+    std::optional<std::vector<runtime::SizeType32>> numTopLogProbs; // [1] or [setupBatchSize] on cpu
 };
 
 class SamplingSetupParams : public DecodingSetupParams
@@ -155,6 +170,11 @@ public:
     std::optional<std::vector<float>> topPMin;                     // [setupBatchSize], must between [0, 1]
     std::optional<std::vector<runtime::TokenIdType>> topPResetIds; // [setupBatchSize]
     std::optional<bool> normalizeLogProbs;
+
+    // samplingLayer, probs filters applied before topK and topP
+    std::optional<std::vector<float>> minP;     // [1] or [setupBatchSize] on cpu, must between [0, 1]
+    std::optional<std::vector<float>> typicalP; // [1] or [setupBatchSize] on cpu, must between (0, 1]
+    std::optional<std::vector<float>> eta;      // [1] or [setupBatchSize] on cpu, must between [0, 1]
 };
 
 class BeamSearchSetupParams : public DecodingSetupParams
@@ -184,6 +204,14 @@ public:
     tc::Tensor temperatures;     // [maxBatchSize], on gpu
 };
 
+// Set by callers of DynamicDecodeLayer with grammars, GptDecoder does not pass any yet
+class ConstrainedDecodingSetupParams : public BaseSetupParams
+{
+public:
+    // Automaton of the grammar of each request, nullptr for unconstrained requests
+    std::vector<std::shared_ptr<TokenAutomaton const>> automata; // [setupBatchSize] on cpu
+};
+
 class DynamicDecodeSetupParams : public BaseSetupParams
 {
 public:
@@ -192,6 +220,10 @@ public:
     std::shared_ptr<BanWordsSetupParams> banWordsParams;
 
     std::shared_ptr<DecodingSetupParams> decodingParams;
+
+    std::shared_ptr<ConstrainedDecodingSetupParams> constrainedDecodingParams;
+
+    std::shared_ptr<StopCriteriaSetupParams> stopCriteriaParams;
 };
 
 class LookaheadSetupParams : public DecodingSetupParams
@@ -313,8 +345,8 @@ public:
     }
 
     //! optional parameters
-    //! [localBatchSize]
-    curandState_t* curandStates{};
+    //! [maxBatchSize], seeds of the stateless random numbers, see kernels::philoxUniform
+    uint64_t const* randomSeeds{};
     //! Pointer to the workspace for sampling computation
     void* samplingWorkspace{};
     //! Flag to mark that logits tensor contains probabilities
@@ -443,8 +475,15 @@ public:
     std::optional<tc::Tensor> numNewTokens;
     //! [1] in pinned host memory
     std::optional<tc::Tensor> finishedSum;
+    //! [divUp(maxBatchSize, 32)], bitmap of the slots finished at this step, on gpu, optional
+    std::optional<tc::Tensor> finishedSlots;
     //! [maxSeqLen, maxBatchSize, maxBeamWidth], must be float*
     std::optional<tc::Tensor> outputLogProbsTiled;
+    //! [maxBatchSize, maxSeqLen, maxNumTopLogProbs], must be float*, optional.
+    //! Log probs of the most probable tokens of each generated token
+    std::optional<tc::Tensor> topLogProbs;
+    //! [maxBatchSize, maxSeqLen, maxNumTopLogProbs], ids of the tokens of topLogProbs
+    std::optional<tc::Tensor> topLogProbIds;
 };
 
 class BeamSearchOutputs : public BaseDecodingOutputs
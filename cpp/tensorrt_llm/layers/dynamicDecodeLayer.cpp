@@ -103,6 +103,14 @@ void DynamicDecodeLayer<T>::initializeLayers()
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
     mLayers = createLayers<T>(mDecodingMode, mDecoderDomain, mStream, mAllocator);
+    mConstrainedDecodingLayer = nullptr;
+    for (auto& layer : mLayers)
+    {
+        if (auto* constrainedDecodingLayer = dynamic_cast<ConstrainedDecodingLayer<T>*>(layer.get()))
+        {
+            mConstrainedDecodingLayer = constrainedDecodingLayer;
+        }
+    }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -200,6 +208,12 @@ void DynamicDecodeLayer<T>::forwardAsync(
         mDecoderDomain.getBatchSize(), localDecoderDomain.getBeamWidth(), maxSeqLen,
         mDecoderDomain.getMaxDecodingTokens(), mCyclicStep, mOutputLogProbs, mStream);
 
+    if (mConstrainedDecodingLayer != nullptr)
+    {
+        // Overlaps the automata updates with the next forward pass
+        mConstrainedDecodingLayer->advanceAsync(baseOutputs, batchSlotsHost, localDecoderDomain.getBatchSize());
+    }
+
     mCyclicStep += 1;
 
     sync_check_cuda_error();
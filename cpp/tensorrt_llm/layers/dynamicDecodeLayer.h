@@ -26,6 +26,9 @@ namespace tc = tensorrt_llm::common;
 namespace tensorrt_llm::layers
 {
 
+template <typename T>
+class ConstrainedDecodingLayer;
+
 template <typename T>
 class DynamicDecodeLayer : public BaseLayer
 {
@@ -74,6 +77,8 @@ private:
     using Base::mDecoderDomain;
 
     std::vector<std::unique_ptr<BaseLayer>> mLayers;
+    // Advanced after each step, owned by mLayers
+    ConstrainedDecodingLayer<T>* mConstrainedDecodingLayer{nullptr};
 
     executor::DecodingMode mDecodingMode;
 
@@ -24,6 +24,7 @@
 #include "tensorrt_llm/layers/layerUtils.h"
 
 #include <algorithm>
+#include <limits>
 
 using namespace tensorrt_llm::common;
 using namespace tensorrt_llm::kernels;
@@ -63,6 +64,7 @@ void ExplicitDraftTokensLayer<T>::allocateBuffer()
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
     mTemperature.resize(mDecoderDomain.getBatchSize());
+    mRandomSeeds.resize(mDecoderDomain.getBatchSize());
 
     mScanWorkspaceSizeInBytes = invokeScanGenerationLengths(
         nullptr, mScanWorkspaceSizeInBytes, nullptr, nullptr, mDecoderDomain.getBatchSize(), mStream);
@@ -71,21 +73,20 @@ void ExplicitDraftTokensLayer<T>::allocateBuffer()
 
     mWorkspaceSizeInBytes = std::max(mScanWorkspaceSizeInBytes, mReduceWorkspaceSizeInBytes);
 
-    std::array<size_t, 8> deviceBufferSizes
-        = {sizeof(curandState_t) * mDecoderDomain.getBatchSize(), sizeof(uint64_t) * mDecoderDomain.getBatchSize(),
-            mWorkspaceSizeInBytes, sizeof(SizeType32) * mDecoderDomain.getBatchSize(), sizeof(SizeType32),
+    std::array<size_t, 7> deviceBufferSizes
+        = {sizeof(uint64_t) * mDecoderDomain.getBatchSize(), mWorkspaceSizeInBytes,
+            sizeof(SizeType32) * mDecoderDomain.getBatchSize(), sizeof(SizeType32),
             sizeof(float) * mDecoderDomain.getBatchSize(), sizeof(SizeType32) * mDecoderDomain.getBatchSize(),
             sizeof(SizeType32) * mDecoderDomain.getBatchSize()
                 * mDecoderDomain.getSpeculativeDecodingModule()->getMaxNumPaths()
                 * mDecoderDomain.getSpeculativeDecodingModule()->getMaxPathLen()};
-    mCurandStatesDevice = mAllocator->reMalloc(mCurandStatesDevice, deviceBufferSizes[0], false);
-    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[1], false);
-    mWorkspaceDevice = mAllocator->reMalloc(mWorkspaceDevice, deviceBufferSizes[2], false);
-    mGenerationLengthInclusiveSum = mAllocator->reMalloc(mGenerationLengthInclusiveSum, deviceBufferSizes[3], false);
-    mMaxGenerationLength = mAllocator->reMalloc(mMaxGenerationLength, deviceBufferSizes[4], false);
-    mTemperatureDevice = mAllocator->reMalloc(mTemperatureDevice, deviceBufferSizes[5], false);
-    mBestPathIndicesSlots = mAllocator->reMalloc(mBestPathIndicesSlots, deviceBufferSizes[6], false);
-    mLastDraftIndicesSlots = mAllocator->reMalloc(mLastDraftIndicesSlots, deviceBufferSizes[7], false);
+    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[0], false);
+    mWorkspaceDevice = mAllocator->reMalloc(mWorkspaceDevice, deviceBufferSizes[1], false);
+    mGenerationLengthInclusiveSum = mAllocator->reMalloc(mGenerationLengthInclusiveSum, deviceBufferSizes[2], false);
+    mMaxGenerationLength = mAllocator->reMalloc(mMaxGenerationLength, deviceBufferSizes[3], false);
+    mTemperatureDevice = mAllocator->reMalloc(mTemperatureDevice, deviceBufferSizes[4], false);
+    mBestPathIndicesSlots = mAllocator->reMalloc(mBestPathIndicesSlots, deviceBufferSizes[5], false);
+    mLastDraftIndicesSlots = mAllocator->reMalloc(mLastDraftIndicesSlots, deviceBufferSizes[6], false);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -95,7 +96,6 @@ void ExplicitDraftTokensLayer<T>::freeBuffer()
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    mAllocator->free((void**) (&mCurandStatesDevice));
     mAllocator->free((void**) (&mRandomSeedsDevice));
     mAllocator->free((void**) (&mWorkspaceDevice));
     mAllocator->free((void**) (&mGenerationLengthInclusiveSum));
@@ -115,30 +115,13 @@ void ExplicitDraftTokensLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWid
 
     auto setupParams = std::dynamic_pointer_cast<ExplicitDraftTokensSetupParams>(baseSetupParams);
 
-    if (setupParams->randomSeed)
-    {
-        if (setupParams->randomSeed->size() == 1)
-        {
-            invokeCurandInitialize(
-                mCurandStatesDevice, batchSlots, batchSize, setupParams->randomSeed->front(), mStream);
-            sync_check_cuda_error();
-        }
-        else
-        {
-            TLLM_CHECK_WITH_INFO(setupParams->randomSeed->size() == batchSize, "Random seed vector size mismatch.");
-            cudaAutoCpy(mRandomSeedsDevice, setupParams->randomSeed->data(), batchSize, mStream);
-            invokeCurandBatchInitialize(mCurandStatesDevice, batchSlots, batchSize, mRandomSeedsDevice, mStream);
-            sync_check_cuda_error();
-        }
-    }
-    else
-    {
-        // Initialize curand states using the default seed 0.
-        invokeCurandInitialize(mCurandStatesDevice, batchSlots, batchSize, DefaultDecodingParams::getSeed(), mStream);
-    }
+    FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
+
+    // The random numbers are stateless, keyed by the seed of the request and its step, only the seeds are set up.
+    fillBuffers(setupParams->randomSeed, DefaultDecodingParams::getSeed(), mRandomSeeds, mRandomSeedsDevice, batchSlots,
+        std::make_pair(-1.f, std::numeric_limits<float>::max()), "random seed");
 
     // Setup penalties.
-    FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
 
     fillBuffers(setupParams->temperature, DefaultDecodingParams::getTemperature(), mTemperature, mTemperatureDevice,
         batchSlots, getLimitsPenalty(DecodingPenaltyType::Temperature), "temperature penalty");
@@ -158,7 +141,7 @@ void ExplicitDraftTokensLayer<T>::fillContextBuffers(
     params.randDataSample = setupParams.randomDataSample.template getPtr<T>();
     params.outputTemperatures = setupParams.temperatures.template getPtr<T>();
     params.inputTemperatures = mTemperatureDevice;
-    params.curandState = mCurandStatesDevice;
+    params.randomSeeds = mRandomSeedsDevice;
     params.batchSlots = batchSlots;
     params.batchSize = batchSize;
 
@@ -258,7 +241,7 @@ void ExplicitDraftTokensLayer<T>::splitInputDataToBatchSlots(
     params.generationLengthInclusiveSum = mGenerationLengthInclusiveSum;
     params.lastDraftIndices = inputs.lastDraftIndices.template getPtr<SizeType32 const>();
     params.inputTemperatures = mTemperatureDevice;
-    params.curandState = mCurandStatesDevice;
+    params.randomSeeds = mRandomSeedsDevice;
     params.batchSize = batchSize;
     params.numPaths = mDecoderDomain.getSpeculativeDecodingModule()->getMaxNumPaths();
     params.maxPathLength = mDecoderDomain.getSpeculativeDecodingModule()->getMaxPathLen();
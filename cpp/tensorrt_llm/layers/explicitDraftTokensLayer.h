@@ -20,7 +20,7 @@
 #include "tensorrt_llm/layers/decodingParams.h"
 #include "tensorrt_llm/runtime/common.h"
 
-#include <curand_kernel.h>
+#include <vector>
 
 namespace tensorrt_llm::layers
 {
@@ -73,7 +73,6 @@ private:
     size_t mReduceWorkspaceSizeInBytes{0};
 
     uint64_t* mRandomSeedsDevice{nullptr};
-    curandState_t* mCurandStatesDevice{nullptr};
     void* mWorkspaceDevice{nullptr};
     SizeType32* mGenerationLengthInclusiveSum{nullptr};
     SizeType32* mMaxGenerationLength{nullptr};
@@ -82,6 +81,7 @@ private:
     SizeType32* mLastDraftIndicesSlots{nullptr};
 
     std::vector<float> mTemperature;
+    std::vector<uint64_t> mRandomSeeds;
 };
 
 } // namespace tensorrt_llm::layers
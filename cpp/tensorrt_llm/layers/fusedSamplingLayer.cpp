@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/fusedSamplingLayer.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/fusedSamplingKernels.h"
+#include "tensorrt_llm/layers/defaultDecodingParams.h"
+#include "tensorrt_llm/layers/layerUtils.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::kernels;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::layers
+{
+
+template <typename T>
+FusedSamplingLayer<T>::FusedSamplingLayer(executor::DecodingMode const& mode, DecoderDomain const& decoderDomain,
+    cudaStream_t stream, std::shared_ptr<IAllocator> allocator)
+    : BaseLayer(decoderDomain, stream, std::move(allocator))
+    , mDecodingMode(mode)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    TLLM_CHECK_WITH_INFO(mDecodingMode.isTopK(), "FusedSamplingLayer requires TopK mode");
+    TLLM_CHECK_WITH_INFO(
+        mDecoderDomain.getMaxDecodingTokens() == 1, "FusedSamplingLayer supports one decoding token per step");
+
+    mPenaltyLayer = std::make_unique<PenaltyLayer<T>>(mDecodingMode, decoderDomain, mStream, mAllocator);
+    if (mDecodingMode.isUseBanWords())
+    {
+        mBanWordsLayer = std::make_unique<BanWordsLayer<T>>(mDecodingMode, decoderDomain, mStream, mAllocator);
+    }
+    mDecodingLayer = std::make_unique<DecodingLayer<T>>(mDecodingMode, decoderDomain, mStream, mAllocator);
+
+    mRuntimeTopK.resize(mDecoderDomain.getBatchSize(), 0);
+    mRuntimeTopP.resize(mDecoderDomain.getBatchSize(), DefaultDecodingParams::getTopP());
+    allocateBuffer();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+FusedSamplingLayer<T>::~FusedSamplingLayer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    freeBuffer();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::allocateBuffer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto const batchSize = mDecoderDomain.getBatchSize();
+    mWorkspaceSize = getFusedSamplingWorkspaceSize(batchSize, FUSED_SAMPLING_TOP_K_MAX, mDecoderDomain.getVocabSize());
+
+    std::array<size_t, 5> deviceBufferSizes;
+    deviceBufferSizes[0] = sizeof(SizeType32) * batchSize;
+    deviceBufferSizes[1] = sizeof(float) * batchSize;
+    deviceBufferSizes[2] = sizeof(curandState_t) * batchSize;
+    deviceBufferSizes[3] = sizeof(uint64_t) * batchSize;
+    deviceBufferSizes[4] = mWorkspaceSize;
+
+    mRuntimeTopKDevice = mAllocator->reMalloc(mRuntimeTopKDevice, deviceBufferSizes[0], false);
+    mRuntimeTopPDevice = mAllocator->reMalloc(mRuntimeTopPDevice, deviceBufferSizes[1], false);
+    mCurandStatesDevice = mAllocator->reMalloc(mCurandStatesDevice, deviceBufferSizes[2], false);
+    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[3], false);
+    mSamplingWorkspaceDevice = mAllocator->reMalloc(mSamplingWorkspaceDevice, deviceBufferSizes[4], false);
+
+    mAllocatedSize = std::accumulate(deviceBufferSizes.begin(), deviceBufferSizes.end(), size_t{0});
+    TLLM_LOG_DEBUG("FusedSamplingLayer allocated %lu bytes on GPU", mAllocatedSize);
+    mAllocatedSize += mPenaltyLayer->getAllocatedSize() + mDecodingLayer->getAllocatedSize();
+    if (mBanWordsLayer)
+    {
+        mAllocatedSize += mBanWordsLayer->getAllocatedSize();
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::freeBuffer()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    mAllocator->free((void**) (&mRuntimeTopKDevice));
+    mAllocator->free((void**) (&mRuntimeTopPDevice));
+    mAllocator->free((void**) (&mCurandStatesDevice));
+    mAllocator->free((void**) (&mRandomSeedsDevice));
+    mAllocator->free((void**) (&mSamplingWorkspaceDevice));
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 const* batchSlots,
+    std::shared_ptr<BaseSetupParams> const& baseSetupParams)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    mPenaltyLayer->setup(batchSize, beamWidth, batchSlots, baseSetupParams);
+    if (mBanWordsLayer)
+    {
+        mBanWordsLayer->setup(batchSize, beamWidth, batchSlots, baseSetupParams);
+    }
+    mDecodingLayer->setup(batchSize, beamWidth, batchSlots, baseSetupParams);
+
+    auto setupParams = std::dynamic_pointer_cast<DynamicDecodeSetupParams>(baseSetupParams);
+    auto samplingParams = std::dynamic_pointer_cast<SamplingSetupParams>(setupParams->decodingParams);
+    TLLM_CHECK_WITH_INFO(samplingParams, "decodingParams for setup of FusedSamplingLayer are not SamplingSetupParams");
+
+    // FIXME(nkorobov): monotonically growing, as in BanWordsLayer
+    mUseNoRepeatNgramSize |= mDecodingMode.isUseNoRepeatNgramSize() && setupParams->banWordsParams
+        && setupParams->banWordsParams->noRepeatNgramSize.has_value();
+    mNormalizeLogProbs = samplingParams->normalizeLogProbs.value_or(false);
+    // The probs filters and the alternatives with their log probs are computed by SamplingLayer only
+    mUseProbsFilter |= samplingParams->minP.has_value() || samplingParams->typicalP.has_value()
+        || samplingParams->eta.has_value() || samplingParams->numTopLogProbs.has_value();
+
+    // Same arguments as TopKSamplingLayer, K = 0 is left to TopPSamplingLayer
+    auto const& runtimeTopK = samplingParams->runtimeTopK;
+    auto const& runtimeTopP = samplingParams->runtimeTopP;
+    if (runtimeTopK && runtimeTopK->size() > 1)
+    {
+        TLLM_CHECK_WITH_INFO(runtimeTopK->size() == static_cast<size_t>(batchSize),
+            "runtimeTopK.size() (%lu) == batchSize (%d) is not satisfied!", runtimeTopK->size(), batchSize);
+    }
+    if (runtimeTopP && runtimeTopP->size() > 1)
+    {
+        TLLM_CHECK_WITH_INFO(runtimeTopP->size() == static_cast<size_t>(batchSize),
+            "runtimeTopP.size() (%lu) == batchSize (%d) is not satisfied!", runtimeTopP->size(), batchSize);
+    }
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const batchSlot = batchSlots != nullptr ? batchSlots[bi] : bi;
+        auto k = !runtimeTopK ? DefaultDecodingParams::getTopK()
+                              : runtimeTopK->at(runtimeTopK->size() > 1 ? bi : 0);
+        auto p = !runtimeTopP || runtimeTopP->empty() ? DefaultDecodingParams::getTopP()
+                                                      : runtimeTopP->at(runtimeTopP->size() > 1 ? bi : 0);
+        k = std::clamp(k, 0, static_cast<SizeType32>(TOP_K_MAX));
+        p = std::clamp(p, 0.f, 1.f);
+        if (k == 0 && p == 0.0f)
+        {
+            k = 1;
+        }
+        if (k > 0 && p == 0.0f)
+        {
+            p = 1.0f;
+        }
+        mRuntimeTopK[batchSlot] = k;
+        mRuntimeTopP[batchSlot] = p;
+    }
+    cudaAutoCpy(mRuntimeTopKDevice, mRuntimeTopK.data(), mDecoderDomain.getBatchSize(), mStream);
+    cudaAutoCpy(mRuntimeTopPDevice, mRuntimeTopP.data(), mDecoderDomain.getBatchSize(), mStream);
+
+    // Same seeds as SamplingLayer, the random states of the two paths are separate
+    if (samplingParams->randomSeed && samplingParams->randomSeed->size() > 1)
+    {
+        TLLM_CHECK_WITH_INFO(samplingParams->randomSeed->size() == static_cast<size_t>(batchSize),
+            "Random seed vector size mismatch.");
+        cudaAutoCpy(mRandomSeedsDevice, samplingParams->randomSeed->data(), batchSize, mStream);
+        invokeCurandBatchInitialize(mCurandStatesDevice, batchSlots, batchSize, mRandomSeedsDevice, mStream);
+    }
+    else
+    {
+        auto const randomSeed = samplingParams->randomSeed ? samplingParams->randomSeed->front() : 0;
+        invokeCurandInitialize(mCurandStatesDevice, batchSlots, batchSize, randomSeed, mStream);
+    }
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+bool FusedSamplingLayer<T>::canFuse(
+    std::shared_ptr<DecodingInputs> const& inputs, SizeType32 const* batchSlotsHost, SizeType32 batchSize) const
+{
+    if (mUseNoRepeatNgramSize || mUseProbsFilter
+        || (inputs->banWordsInputs && inputs->banWordsInputs->maxBadWordsLen > 0)
+        || (mBanWordsLayer && mBanWordsLayer->hasBadWordsAutomata()))
+    {
+        return false;
+    }
+    return std::all_of(batchSlotsHost, batchSlotsHost + batchSize,
+        [this](SizeType32 batchSlot)
+        { return 0 < mRuntimeTopK[batchSlot] && mRuntimeTopK[batchSlot] <= FUSED_SAMPLING_TOP_K_MAX; });
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::forwardAsync(
+    std::shared_ptr<BaseDecodingOutputs> const& outputs, std::shared_ptr<BaseDecodingInputs> const& baseInputs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto inputs = std::dynamic_pointer_cast<DecodingInputs>(baseInputs);
+    auto const localDecoderDomain = getLocalDecoderDomain(inputs, mDecoderDomain);
+    auto const batchSize = localDecoderDomain.getBatchSize();
+
+    std::vector<SizeType32> batchSlotsVec(batchSize);
+    std::iota(batchSlotsVec.begin(), batchSlotsVec.end(), 0);
+    auto batchSlotsHost
+        = inputs->batchSlots ? inputs->batchSlots->template getPtr<SizeType32 const>() : batchSlotsVec.data();
+
+    if (localDecoderDomain.getBeamWidth() == 1 && canFuse(inputs, batchSlotsHost, batchSize))
+    {
+        forwardFused(outputs, baseInputs, batchSlotsHost);
+    }
+    else
+    {
+        mPenaltyLayer->forwardAsync(outputs, baseInputs);
+        if (mBanWordsLayer)
+        {
+            mBanWordsLayer->forwardAsync(outputs, baseInputs);
+        }
+        mDecodingLayer->forwardAsync(outputs, baseInputs);
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::forwardFused(std::shared_ptr<BaseDecodingOutputs> const& outputs,
+    std::shared_ptr<BaseDecodingInputs> const& baseInputs, SizeType32 const* batchSlotsHost)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto inputs = std::dynamic_pointer_cast<DecodingInputs>(baseInputs);
+
+    // Also prepares the logits pointers and the occurrence counts of the penalties
+    auto const penaltyParams = mPenaltyLayer->preparePenaltyParams(outputs, baseInputs);
+
+    SizeType32 maxTopK{0};
+    for (SizeType32 bi = 0; bi < penaltyParams.batchSize; ++bi)
+    {
+        maxTopK = std::max(maxTopK, mRuntimeTopK[batchSlotsHost[bi]]);
+    }
+
+    FusedSamplingKernelParams<T> params;
+    params.logitsPtrs = penaltyParams.inputLogits;
+    params.biases = penaltyParams.biases;
+    params.penaltyWorkspace = penaltyParams.penaltyWorkspace;
+    params.temperatures = penaltyParams.temperatures;
+    params.repetitionPenalties = penaltyParams.repetitionPenalties;
+    params.presencePenalties = penaltyParams.presencePenalties;
+    params.frequencyPenalties = penaltyParams.frequencyPenalties;
+    params.minLengths = penaltyParams.minLengths;
+    params.inputLengths = penaltyParams.inputLengths;
+    params.outputIdsPtrs = outputs->outputIdsPtr.template getPtr<TokenIdType*>();
+    params.workspace = mSamplingWorkspaceDevice;
+    params.endIds = penaltyParams.endIds;
+    params.sequenceLengths = outputs->sequenceLength->template getPtr<SizeType32>();
+    params.batchSlots = penaltyParams.batchSlots;
+    params.finishedInput = (inputs->finished)
+        ? reinterpret_cast<FinishedState*>(inputs->finished->template getPtr<FinishedState::UnderlyingType>())
+        : nullptr;
+    params.finishedOutput = (outputs->finished)
+        ? reinterpret_cast<FinishedState*>(outputs->finished->template getPtr<FinishedState::UnderlyingType>())
+        : nullptr;
+    params.cumLogProbs = (outputs->cumLogProbs) ? outputs->cumLogProbs->template getPtr<float>() : nullptr;
+    params.outputLogProbs
+        = (outputs->outputLogProbsTiled) ? outputs->outputLogProbsTiled->template getPtr<float>() : nullptr;
+    params.curandState = mCurandStatesDevice;
+    params.topKs = mRuntimeTopKDevice;
+    params.topPs = mRuntimeTopPDevice;
+    params.maxTopK = maxTopK;
+    params.batchSize = penaltyParams.batchSize;
+    params.maxBatchSize = mDecoderDomain.getBatchSize();
+    params.vocabSize = mDecoderDomain.getVocabSize();
+    params.vocabSizePadded = mDecoderDomain.getVocabSizePadded();
+    params.maxSeqLen = penaltyParams.maxSeqLen;
+    params.normalizeLogProbs = mNormalizeLogProbs;
+
+    invokeFusedPenaltyTopKSampling(params, mStream);
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template <typename T>
+void FusedSamplingLayer<T>::forwardSync(
+    std::shared_ptr<BaseDecodingOutputs> const& outputs, std::shared_ptr<BaseDecodingInputs> const& inputs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    mDecodingLayer->forwardSync(outputs, inputs);
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template class FusedSamplingLayer<float>;
+template class FusedSamplingLayer<half>;
+
+} // namespace tensorrt_llm::layers
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/layers/banWordsLayer.h"
+#include "tensorrt_llm/layers/baseLayer.h"
+#include "tensorrt_llm/layers/decodingLayer.h"
+#include "tensorrt_llm/layers/decodingParams.h"
+#include "tensorrt_llm/layers/penaltyLayer.h"
+
+#include <curand_kernel.h>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::layers
+{
+
+//! \brief Layer replacing PenaltyLayer, BanWordsLayer and DecodingLayer for top-k sampling.
+//! When every request of a step samples with 1 <= K <= FUSED_SAMPLING_TOP_K_MAX, bans no words and filters no
+//! probs, the penalties are applied and the token is sampled by invokeFusedPenaltyTopKSampling in a single pass
+//! over the logits.
+//! Other steps run the penalty, ban words and decoding layers. Both paths share the occurrence counts of the
+//! penalties, but use separate random states.
+template <typename T>
+class FusedSamplingLayer : public BaseLayer
+{
+public:
+    FusedSamplingLayer(executor::DecodingMode const& mode, DecoderDomain const& decoderDomain, cudaStream_t stream,
+        std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
+
+    ~FusedSamplingLayer() override;
+
+    void setup(runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 const* batchSlots,
+        std::shared_ptr<BaseSetupParams> const& setupParams) override;
+
+    void forwardAsync(std::shared_ptr<BaseDecodingOutputs> const& outputs,
+        std::shared_ptr<BaseDecodingInputs> const& inputs) override;
+
+    void forwardSync(std::shared_ptr<BaseDecodingOutputs> const& outputs,
+        std::shared_ptr<BaseDecodingInputs> const& inputs) override;
+
+private:
+    void allocateBuffer();
+    void freeBuffer();
+
+    //! \brief Whether the fused kernel supports all requests of this step.
+    [[nodiscard]] bool canFuse(std::shared_ptr<DecodingInputs> const& inputs,
+        runtime::SizeType32 const* batchSlotsHost, runtime::SizeType32 batchSize) const;
+
+    void forwardFused(std::shared_ptr<BaseDecodingOutputs> const& outputs,
+        std::shared_ptr<BaseDecodingInputs> const& inputs, runtime::SizeType32 const* batchSlotsHost);
+
+private:
+    using BaseLayer::mWorkspaceSize;
+    using BaseLayer::mAllocatedSize;
+
+    using BaseLayer::mStream;
+    using BaseLayer::mAllocator;
+
+    using BaseLayer::mDecoderDomain;
+
+    executor::DecodingMode mDecodingMode;
+
+    std::unique_ptr<PenaltyLayer<T>> mPenaltyLayer;
+    std::unique_ptr<BanWordsLayer<T>> mBanWordsLayer;
+    std::unique_ptr<DecodingLayer<T>> mDecodingLayer;
+
+    runtime::SizeType32* mRuntimeTopKDevice{nullptr};
+    float* mRuntimeTopPDevice{nullptr};
+    curandState_t* mCurandStatesDevice{nullptr};
+    uint64_t* mRandomSeedsDevice{nullptr};
+    void* mSamplingWorkspaceDevice{nullptr};
+
+    std::vector<runtime::SizeType32> mRuntimeTopK; // [maxBatchSize], K of each request after setup
+    std::vector<float> mRuntimeTopP;               // [maxBatchSize], P of each request after setup
+
+    bool mUseNoRepeatNgramSize{false};
+    bool mUseProbsFilter{false};
+    bool mNormalizeLogProbs{false};
+};
+
+} // namespace tensorrt_llm::layers
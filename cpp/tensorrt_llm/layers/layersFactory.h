@@ -18,7 +18,9 @@
 
 #include "tensorrt_llm/layers/banWordsLayer.h"
 #include "tensorrt_llm/layers/baseLayer.h"
+#include "tensorrt_llm/layers/constrainedDecodingLayer.h"
 #include "tensorrt_llm/layers/decodingLayer.h"
+#include "tensorrt_llm/layers/fusedSamplingLayer.h"
 #include "tensorrt_llm/layers/penaltyLayer.h"
 #include "tensorrt_llm/layers/stopCriteriaLayer.h"
 #include <memory>
@@ -30,13 +32,31 @@ enum DecodingLayers_t
 {
     PENALTY_LAYER,
     BAN_WORDS_LAYER,
+    CONSTRAINED_DECODING_LAYER,
     DECODING_LAYER,
+    FUSED_SAMPLING_LAYER,
     STOP_CRITERIA_LAYER
 };
 
 static std::vector<DecodingLayers_t> createDecodingLayerTypes(executor::DecodingMode const& mode)
 {
     std::vector<DecodingLayers_t> types = {};
+    if (mode.isUseFusedSampling())
+    {
+        // Penalties, ban words and sampling are run by the fused layer
+        TLLM_CHECK_WITH_INFO(mode.isTopK(), "Fused sampling is only supported for TopK decoding");
+        TLLM_CHECK_WITH_INFO(
+            !mode.isUseConstrainedDecoding(), "Fused sampling can't be combined with constrained decoding");
+        // Whether a step is fused depends on all requests of the batch
+        TLLM_CHECK_WITH_INFO(
+            !mode.isUseBatchInvariant(), "Fused sampling can't be combined with batch invariant sampling");
+        types.push_back(DecodingLayers_t::FUSED_SAMPLING_LAYER);
+        if (mode.isUseStopCriteria())
+        {
+            types.push_back(DecodingLayers_t::STOP_CRITERIA_LAYER);
+        }
+        return types;
+    }
     if (mode.isUsePenalty())
     {
         types.push_back(DecodingLayers_t::PENALTY_LAYER);
@@ -45,6 +65,10 @@ static std::vector<DecodingLayers_t> createDecodingLayerTypes(executor::Decoding
     {
         types.push_back(DecodingLayers_t::BAN_WORDS_LAYER);
     }
+    if (mode.isUseConstrainedDecoding())
+    {
+        types.push_back(DecodingLayers_t::CONSTRAINED_DECODING_LAYER);
+    }
     types.push_back(DecodingLayers_t::DECODING_LAYER);
     if (mode.isUseStopCriteria())
     {
@@ -63,7 +87,9 @@ static std::vector<std::unique_ptr<BaseLayer>> createLayers(executor::DecodingMo
     // Only when draft tokens and predicted and decoded by the engine, we can skip penalty layer.
     if (!mode.isExplicitDraftTokens())
     {
-        TLLM_CHECK_WITH_INFO(layerTypes.size() && layerTypes[0] == DecodingLayers_t::PENALTY_LAYER,
+        TLLM_CHECK_WITH_INFO(layerTypes.size()
+                && (layerTypes[0] == DecodingLayers_t::PENALTY_LAYER
+                    || layerTypes[0] == DecodingLayers_t::FUSED_SAMPLING_LAYER),
             "Penalty layer is required to be the first layer for any decoder configuration");
     }
     for (auto&& type : layerTypes)
@@ -79,10 +105,18 @@ static std::vector<std::unique_ptr<BaseLayer>> createLayers(executor::DecodingMo
             layer = std::make_unique<BanWordsLayer<T>>(mode, decodingDomain, stream, allocator);
             break;
 
+        case DecodingLayers_t::CONSTRAINED_DECODING_LAYER:
+            layer = std::make_unique<ConstrainedDecodingLayer<T>>(mode, decodingDomain, stream, allocator);
+            break;
+
         case DecodingLayers_t::DECODING_LAYER:
             layer = std::make_unique<DecodingLayer<T>>(mode, decodingDomain, stream, allocator);
             break;
 
+        case DecodingLayers_t::FUSED_SAMPLING_LAYER:
+            layer = std::make_unique<FusedSamplingLayer<T>>(mode, decodingDomain, stream, allocator);
+            break;
+
         case DecodingLayers_t::STOP_CRITERIA_LAYER:
             layer = std::make_unique<StopCriteriaLayer<T>>(mode, decodingDomain, stream, allocator);
             break;
@@ -64,6 +64,20 @@ void LookaheadAlgorithm::setup(TensorConstPtr const& prompt, SizeType32 w, SizeT
     std::copy(std::prev(promptRange.end(), mN - 1), promptRange.end(), goldRange.begin());
     mGuessTokens = ITensor::slice(mGuessTokensMax, 0, 0);
     mFilling = (mN - 1) > 0 ? 1 : 0;
+
+    // Skip the prefilling phase when the prompt is long enough: the window is filled with a span of the prompt, every
+    // line being the previous one shifted by a token as in the maintenance phase, so that the first generation step
+    // already produces n-grams instead of the (N-2)th one.
+    auto const spanLen = mW + mN - 2;
+    if (mN > 2 && static_cast<SizeType32>(promptRange.size()) >= spanLen)
+    {
+        auto const start = rand() % (static_cast<SizeType32>(promptRange.size()) - spanLen + 1);
+        for (SizeType32 i = 0; i < mW; i++)
+        {
+            std::copy_n(promptRange.begin() + start + i, mN - 1, pastRange.begin() + i * (mN - 1));
+        }
+        mFilling = mN - 1;
+    }
     PRINT_TOKENS(prompt);
     PRINT_TOKENS(mPrefills);
     PRINT_TOKENS(mPastTokens);
@@ -283,6 +297,7 @@ void LookaheadAlgorithm::verify(TensorPtr const& accepted, TensorPtr const& acce
 }
 
 //! lookahead Jacobi matrix has prefilling phase and maintenance phase.
+//! The prefilling phase is skipped when the prompt has at least W+N-2 tokens, see setup.
 //! W=5, N=5.
 //! *prefilling phase*
 //! mFilling = 1->2, Tokens initialized from prompt. To fill the second line.
@@ -55,6 +55,8 @@ public:
     }
 
     //! @brief setup per request, fill internal states from @param prompt.
+    //! The lookahead window is filled from the prompt when it has at least w+n-2 tokens, so that the first
+    //! generation step already produces n-grams.
     void setup(TensorConstPtr const& prompt, runtime::SizeType32 w, runtime::SizeType32 n, runtime::SizeType32 g);
 
     //! @brief accept the new generated tokens.
@@ -21,10 +21,12 @@
 #include "tensorrt_llm/kernels/samplingTopKKernels.h"
 #include "tensorrt_llm/kernels/speculativeDecoding/medusaDecodingKernels.h"
 #include "tensorrt_llm/layers/defaultDecodingParams.h"
+#include "tensorrt_llm/layers/layerUtils.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
 #include <algorithm>
+#include <limits>
 
 using namespace tensorrt_llm::common;
 using namespace tensorrt_llm::kernels;
@@ -78,34 +80,30 @@ void MedusaDecodingLayer<T>::allocateBuffer()
         ITensor::makeShape({static_cast<SizeType32>(mDecoderDomain.getBatchSize()), maxDraftPathLen}),
         runtime::TRTDataType<TokenIdType*>::value);
     mCummulativeTopK.resize(mDecoderDomain.getBatchSize() * maxDraftPathLen);
-
-    std::array<size_t, 11> deviceBufferSizes;
-    deviceBufferSizes[0] = mDecoderDomain.getBatchSize() * sizeof(curandState_t);
-    deviceBufferSizes[1] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(SizeType32);
-    deviceBufferSizes[2] = mWorkspaceSize;
-    deviceBufferSizes[3] = mDecoderDomain.getBatchSize() * sizeof(SizeType32);
-    deviceBufferSizes[4] = mDecoderDomain.getBatchSize() * mDecoderDomain.getMaxDecodingTokens() * sizeof(TokenIdType);
-    deviceBufferSizes[5] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(uint64_t);
-    deviceBufferSizes[6] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(T*);
-    deviceBufferSizes[7] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(curandState_t);
-    deviceBufferSizes[8] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(SizeType32);
-    deviceBufferSizes[9] = mDecoderDomain.getBatchSize() * mDecoderDomain.getMaxDecodingTokens() * sizeof(TokenIdType);
-    deviceBufferSizes[10] = mDecoderDomain.getBatchSize() * sizeof(SizeType32);
-
-    mCurandStatesDevice = mAllocator->reMalloc(mCurandStatesDevice, deviceBufferSizes[0], false);
-    mSetupWorkspaceDevice = mAllocator->reMalloc(mSetupWorkspaceDevice, deviceBufferSizes[1], false);
-    mSamplingWorkspaceDevice = mAllocator->reMalloc(mSamplingWorkspaceDevice, deviceBufferSizes[2], false);
-    mRuntimeTopKDevice = mAllocator->reMalloc(mRuntimeTopKDevice, deviceBufferSizes[3], false);
-    mTargetTokensDevice = mAllocator->reMalloc(mTargetTokensDevice, deviceBufferSizes[4], false);
-    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[5], false);
+    mRandomSeeds.resize(mDecoderDomain.getBatchSize(), DefaultDecodingParams::getSeed());
+
+    std::array<size_t, 9> deviceBufferSizes;
+    deviceBufferSizes[0] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(SizeType32);
+    deviceBufferSizes[1] = mWorkspaceSize;
+    deviceBufferSizes[2] = mDecoderDomain.getBatchSize() * sizeof(SizeType32);
+    deviceBufferSizes[3] = mDecoderDomain.getBatchSize() * mDecoderDomain.getMaxDecodingTokens() * sizeof(TokenIdType);
+    deviceBufferSizes[4] = mDecoderDomain.getBatchSize() * sizeof(uint64_t);
+    deviceBufferSizes[5] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(T*);
+    deviceBufferSizes[6] = mDecoderDomain.getBatchSize() * maxDraftPathLen * sizeof(SizeType32);
+    deviceBufferSizes[7] = mDecoderDomain.getBatchSize() * mDecoderDomain.getMaxDecodingTokens() * sizeof(TokenIdType);
+    deviceBufferSizes[8] = mDecoderDomain.getBatchSize() * sizeof(SizeType32);
+
+    mSetupWorkspaceDevice = mAllocator->reMalloc(mSetupWorkspaceDevice, deviceBufferSizes[0], false);
+    mSamplingWorkspaceDevice = mAllocator->reMalloc(mSamplingWorkspaceDevice, deviceBufferSizes[1], false);
+    mRuntimeTopKDevice = mAllocator->reMalloc(mRuntimeTopKDevice, deviceBufferSizes[2], false);
+    mTargetTokensDevice = mAllocator->reMalloc(mTargetTokensDevice, deviceBufferSizes[3], false);
+    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[4], false);
     mMedusaSelectedLogitsPtrsDevice
-        = mAllocator->reMalloc(mMedusaSelectedLogitsPtrsDevice, deviceBufferSizes[6], false);
-    mCurandStatesMedusaLogitsDevice
-        = mAllocator->reMalloc(mCurandStatesMedusaLogitsDevice, deviceBufferSizes[7], false);
+        = mAllocator->reMalloc(mMedusaSelectedLogitsPtrsDevice, deviceBufferSizes[5], false);
     mRuntimeTopKPerRequestPerMedusaHeadDevice
-        = mAllocator->reMalloc(mRuntimeTopKPerRequestPerMedusaHeadDevice, deviceBufferSizes[8], false);
-    mNewDraftTokensDevice = mAllocator->reMalloc(mNewDraftTokensDevice, deviceBufferSizes[9], false);
-    mBestPathIdsDevice = mAllocator->reMalloc(mBestPathIdsDevice, deviceBufferSizes[10], false);
+        = mAllocator->reMalloc(mRuntimeTopKPerRequestPerMedusaHeadDevice, deviceBufferSizes[6], false);
+    mNewDraftTokensDevice = mAllocator->reMalloc(mNewDraftTokensDevice, deviceBufferSizes[7], false);
+    mBestPathIdsDevice = mAllocator->reMalloc(mBestPathIdsDevice, deviceBufferSizes[8], false);
 
     mTiledBatchSlotsSetup = BufferManager::pinnedPool(
         ITensor::makeShape({static_cast<SizeType32>(mDecoderDomain.getBatchSize() * maxDraftPathLen)}),
@@ -125,14 +123,12 @@ void MedusaDecodingLayer<T>::freeBuffer()
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    mAllocator->free((void**) (&mCurandStatesDevice));
     mAllocator->free((void**) (&mSetupWorkspaceDevice));
     mAllocator->free((void**) (&mSamplingWorkspaceDevice));
     mAllocator->free((void**) (&mRuntimeTopKDevice));
     mAllocator->free((void**) (&mTargetTokensDevice));
     mAllocator->free((void**) (&mRandomSeedsDevice));
     mAllocator->free((void**) (&mMedusaSelectedLogitsPtrsDevice));
-    mAllocator->free((void**) (&mCurandStatesMedusaLogitsDevice));
     mAllocator->free((void**) (&mRuntimeTopKPerRequestPerMedusaHeadDevice));
     mAllocator->free((void**) (&mNewDraftTokensDevice));
     mAllocator->free((void**) (&mBestPathIdsDevice));
@@ -148,59 +144,16 @@ void MedusaDecodingLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, S
 
     auto setupParams = std::dynamic_pointer_cast<MedusaSetupParams>(baseSetupParams);
 
-    // Prepare random seed
-    auto initCurandStates = [this](std::optional<std::vector<uint64_t>> const& randomSeed, SizeType32 batchSize,
-                                SizeType32 const* batchSlots, curandState_t* statesDevice)
+    // The random numbers are stateless, keyed by the seed of the request and its step, only the seeds are set up.
+    // The draft tokens of the Medusa heads are their top K, they draw no random number.
     {
-        if (randomSeed)
-        {
-            if (randomSeed->size() == 1)
-            {
-                invokeCurandInitialize(statesDevice, batchSlots, batchSize, randomSeed->front(), this->mStream);
-                sync_check_cuda_error();
-            }
-            else
-            {
-                TLLM_CHECK_WITH_INFO(randomSeed->size() == batchSize, "Random seed vector size mismatch.");
-                cudaAutoCpy(this->mRandomSeedsDevice, randomSeed->data(), batchSize, this->mStream);
-                invokeCurandBatchInitialize(
-                    statesDevice, batchSlots, batchSize, this->mRandomSeedsDevice, this->mStream);
-                sync_check_cuda_error();
-            }
-        }
-        else
-        {
-            // Initialize curand states using the default seed 0.
-            invokeCurandInitialize(
-                statesDevice, batchSlots, batchSize, DefaultDecodingParams::getSeed(), this->mStream);
-        }
-    };
-
-    initCurandStates(setupParams->randomSeed, batchSize, batchSlots, mCurandStatesDevice);
+        FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
+        fillBuffers(setupParams->randomSeed, DefaultDecodingParams::getSeed(), mRandomSeeds, mRandomSeedsDevice,
+            batchSlots, std::make_pair(-1.f, std::numeric_limits<float>::max()), "random seed");
+    }
 
     auto const maxDraftPathLen = mDecoderDomain.getSpeculativeDecodingModule()->getMaxDraftPathLen();
     auto const batchSizeMaxNumHeads = batchSize * maxDraftPathLen;
-    auto randomSeed = setupParams->randomSeed.value_or(std::vector<uint64_t>(batchSize, uint64_t{0}));
-    std::vector<uint64_t> tiledRandomSeed(batchSizeMaxNumHeads);
-    if (randomSeed.size() > 1)
-    {
-        for (SizeType32 bi = 0; bi < batchSize; ++bi)
-        {
-            for (SizeType32 hi = 0; hi < maxDraftPathLen; ++hi)
-            {
-                tiledRandomSeed[bi * maxDraftPathLen + hi] = randomSeed[bi];
-            }
-        }
-    }
-    auto tiledBatchSlots = bufferCast<SizeType32>(*mTiledBatchSlotsSetup);
-    for (SizeType32 bi = 0; bi < batchSize; ++bi)
-    {
-        for (SizeType32 hi = 0; hi < maxDraftPathLen; ++hi)
-        {
-            tiledBatchSlots[bi * maxDraftPathLen + hi] = batchSlots[bi] + hi;
-        }
-    }
-    initCurandStates({tiledRandomSeed}, batchSizeMaxNumHeads, tiledBatchSlots, mCurandStatesMedusaLogitsDevice);
 
     // Prepare runtime top K
     auto prepareRuntimeTopK = [this](std::vector<SizeType32> const& runtimeTopK, SizeType32 batchSize,
@@ -313,7 +266,8 @@ void MedusaDecodingLayer<T>::samplePrimeHeadTokens(
     params.maxTopK = mRuntimeMaxTopK;
     params.topKs = mRuntimeTopKDevice;
     params.batchSlots = batchSlots;
-    params.curandState = mCurandStatesDevice;
+    params.randomSeeds = mRandomSeedsDevice;
+    params.randomSteps = sequenceLengths;
     params.batchSize = batchSize;
     params.maxBatchSize = mDecoderDomain.getBatchSize();
     params.tokensPerStep = tokensPerStepDevice;
@@ -433,7 +387,6 @@ void MedusaDecodingLayer<T>::sampleNewDraftTokens(
     params.maxTopK = mRuntimeMaxTopKPerRequestPerMedusaHead;
     params.topKs = mRuntimeTopKPerRequestPerMedusaHeadDevice;
     params.batchSlots = tiledBatchSlots;
-    params.curandState = mCurandStatesMedusaLogitsDevice;
     params.batchSize = batchSizeHeadNums;
     params.maxBatchSize = maxBatchSizeHeadNums;
     params.maxTokensPerStep = 1;
@@ -17,13 +17,13 @@
 
 #pragma once
 
-#include <curand_kernel.h>
-
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 
+#include <vector>
+
 namespace tensorrt_llm::layers
 {
 
@@ -66,14 +66,12 @@ private:
     runtime::SizeType32 mRuntimeMaxTopK{0};
     runtime::SizeType32 mRuntimeMaxTopKPerRequestPerMedusaHead{0};
 
-    curandState_t* mCurandStatesDevice{nullptr};
     void* mSetupWorkspaceDevice{nullptr};
     void* mSamplingWorkspaceDevice{nullptr};
     runtime::SizeType32* mRuntimeTopKDevice{nullptr};
     runtime::TokenIdType* mTargetTokensDevice{nullptr};
     uint64_t* mRandomSeedsDevice{nullptr};
     T** mMedusaSelectedLogitsPtrsDevice{nullptr};
-    curandState_t* mCurandStatesMedusaLogitsDevice{nullptr};
     runtime::SizeType32* mRuntimeTopKPerRequestPerMedusaHeadDevice{nullptr};
     runtime::TokenIdType* mNewDraftTokensDevice{nullptr};
     runtime::SizeType32* mBestPathIdsDevice{nullptr};
@@ -84,6 +82,7 @@ private:
     runtime::ITensor::UniquePtr mMedusaInputLogitsPtrs;
 
     std::vector<runtime::SizeType32> mCummulativeTopK;
+    std::vector<uint64_t> mRandomSeeds; // [maxBatchSize]
 };
 
 } // namespace tensorrt_llm::layers
@@ -258,7 +258,7 @@ void PenaltyLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeType
 }
 
 template <typename T>
-void PenaltyLayer<T>::forwardAsync(
+InvokeBatchApplyPenaltyParams<T> PenaltyLayer<T>::preparePenaltyParams(
     std::shared_ptr<BaseDecodingOutputs> const& baseOutputs, std::shared_ptr<BaseDecodingInputs> const& baseInputs)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
@@ -352,11 +352,26 @@ void PenaltyLayer<T>::forwardAsync(
     penaltyParams.maxTokensPerStep = mDecoderDomain.getMaxDecodingTokens();
     penaltyParams.tokensPerStep = tokensPerStep;
     penaltyParams.stream = mStream;
-    invokeBatchApplyPenalty(penaltyParams);
-    sync_check_cuda_error();
 
     mCyclicStep += 1;
 
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return penaltyParams;
+}
+
+template <typename T>
+void PenaltyLayer<T>::forwardAsync(
+    std::shared_ptr<BaseDecodingOutputs> const& baseOutputs, std::shared_ptr<BaseDecodingInputs> const& baseInputs)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    auto params = std::dynamic_pointer_cast<DecodingInputs>(baseInputs);
+    auto const localDecoderDomain = getLocalDecoderDomain(params, mDecoderDomain);
+
+    auto const penaltyParams = preparePenaltyParams(baseOutputs, baseInputs);
+    invokeBatchApplyPenalty(penaltyParams);
+    sync_check_cuda_error();
+
     params->logits = Tensor(MEMORY_GPU, std::is_same_v<T, float> ? DataType::TYPE_FP32 : DataType::TYPE_FP16,
         {static_cast<size_t>(localDecoderDomain.getBatchSize()),
             static_cast<size_t>(mDecoderDomain.getMaxDecodingTokens()),
@@ -20,6 +20,7 @@
 #include <curand_kernel.h>
 
 #include "tensorrt_llm/executor/types.h"
+#include "tensorrt_llm/kernels/penaltyKernels.h"
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
 #include "tensorrt_llm/runtime/iTensor.h"
@@ -49,6 +50,11 @@ public:
     void forwardAsync(std::shared_ptr<BaseDecodingOutputs> const& outputs,
         std::shared_ptr<BaseDecodingInputs> const& inputs) override;
 
+    //! \brief Prepares the launch of the penalty kernel for this step without launching it, e.g. for
+    //! FusedSamplingLayer, which applies the penalties while sampling.
+    kernels::InvokeBatchApplyPenaltyParams<T> preparePenaltyParams(
+        std::shared_ptr<BaseDecodingOutputs> const& outputs, std::shared_ptr<BaseDecodingInputs> const& inputs);
+
     T* getRuntimeLogitsDevice()
     {
         return mRuntimeLogitsDevice;
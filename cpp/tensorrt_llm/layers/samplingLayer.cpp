@@ -19,10 +19,15 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/samplingFilterKernels.h"
+#include "tensorrt_llm/kernels/topLogProbsKernels.h"
+#include "tensorrt_llm/layers/defaultDecodingParams.h"
+#include "tensorrt_llm/layers/layerUtils.h"
 #include "tensorrt_llm/layers/topKSamplingLayer.h"
 #include "tensorrt_llm/layers/topPSamplingLayer.h"
 
 #include <algorithm>
+#include <limits>
 
 using namespace tensorrt_llm::common;
 using namespace tensorrt_llm::kernels;
@@ -40,15 +45,17 @@ SamplingLayer<T>::SamplingLayer(executor::DecodingMode const& mode, DecoderDomai
 
     TLLM_CHECK_WITH_INFO(!mDecodingMode.isBeamSearch(), "SamplingLayer does not support Beam search mode");
     TLLM_CHECK_WITH_INFO(mDecodingMode.isTopKorTopP(), "SamplingLayer requires TopK nor TopP mode");
+    auto const isBatchInvariant = mDecodingMode.isUseBatchInvariant();
     if (mDecodingMode.isTopK())
     {
-        mSamplingLayers.emplace_back(std::make_unique<TopKSamplingLayer<T>>(decoderDomain, mStream, mAllocator));
+        mSamplingLayers.emplace_back(
+            std::make_unique<TopKSamplingLayer<T>>(decoderDomain, mStream, mAllocator, isBatchInvariant));
     }
 
     if (mDecodingMode.isTopP())
     {
-        mSamplingLayers.emplace_back(
-            std::make_unique<TopPSamplingLayer<T>>(decoderDomain, mStream, mAllocator, /* deterministic */ true));
+        mSamplingLayers.emplace_back(std::make_unique<TopPSamplingLayer<T>>(decoderDomain, mStream, mAllocator,
+            /* deterministic */ true, /* airTopP */ true, isBatchInvariant));
     }
 
     allocateBuffer(decoderDomain.getBatchSize());
@@ -67,16 +74,22 @@ void SamplingLayer<T>::allocateBuffer(SizeType32 batchSize)
         mWorkspaceSize = std::max(mWorkspaceSize, layer->getWorkspaceSize());
     }
 
-    std::array<size_t, 4> deviceBufferSizes;
-    deviceBufferSizes[0] = sizeof(curandState_t) * batchSize;
-    deviceBufferSizes[1] = sizeof(uint64_t) * batchSize;
-    deviceBufferSizes[2] = sizeof(bool) * batchSize;
-    deviceBufferSizes[3] = mWorkspaceSize;
-
-    mCurandStatesDevice = mAllocator->reMalloc(mCurandStatesDevice, deviceBufferSizes[0], false);
-    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[1], false);
-    mSkipDecodeDevice = mAllocator->reMalloc(mSkipDecodeDevice, deviceBufferSizes[2], false);
-    mSamplingWorkspaceDevice = mAllocator->reMalloc(mSamplingWorkspaceDevice, deviceBufferSizes[3], false);
+    std::array<size_t, 7> deviceBufferSizes;
+    deviceBufferSizes[0] = sizeof(uint64_t) * batchSize;
+    deviceBufferSizes[1] = sizeof(bool) * batchSize;
+    deviceBufferSizes[2] = mWorkspaceSize;
+    deviceBufferSizes[3] = sizeof(float) * batchSize;
+    deviceBufferSizes[4] = sizeof(float) * batchSize;
+    deviceBufferSizes[5] = sizeof(float) * batchSize;
+    deviceBufferSizes[6] = sizeof(SizeType32) * batchSize;
+
+    mRandomSeedsDevice = mAllocator->reMalloc(mRandomSeedsDevice, deviceBufferSizes[0], false);
+    mSkipDecodeDevice = mAllocator->reMalloc(mSkipDecodeDevice, deviceBufferSizes[1], false);
+    mSamplingWorkspaceDevice = mAllocator->reMalloc(mSamplingWorkspaceDevice, deviceBufferSizes[2], false);
+    mMinPDevice = mAllocator->reMalloc(mMinPDevice, deviceBufferSizes[3], false);
+    mTypicalPDevice = mAllocator->reMalloc(mTypicalPDevice, deviceBufferSizes[4], false);
+    mEtaDevice = mAllocator->reMalloc(mEtaDevice, deviceBufferSizes[5], false);
+    mNumTopLogProbsDevice = mAllocator->reMalloc(mNumTopLogProbsDevice, deviceBufferSizes[6], false);
 
     auto const bytesAllocated = std::accumulate(deviceBufferSizes.begin(), deviceBufferSizes.end(), size_t{0});
     TLLM_LOG_DEBUG("SamplingLayer allocated %d bytes on GPU", bytesAllocated);
@@ -90,6 +103,11 @@ void SamplingLayer<T>::allocateBuffer(SizeType32 batchSize)
     // host buffers.
     mSkipDecodeHost = (bool*) std::realloc(mSkipDecodeHost, sizeof(bool) * batchSize);
     TLLM_CHECK(mSkipDecodeHost != nullptr);
+    mRandomSeeds.resize(batchSize, DefaultDecodingParams::getSeed());
+    mMinP.resize(batchSize, DefaultDecodingParams::getMinP());
+    mTypicalP.resize(batchSize, DefaultDecodingParams::getTypicalP());
+    mEta.resize(batchSize, DefaultDecodingParams::getEta());
+    mNumTopLogProbs.resize(batchSize, 0);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -99,10 +117,13 @@ void SamplingLayer<T>::freeBuffer()
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    mAllocator->free((void**) (&mCurandStatesDevice));
     mAllocator->free((void**) (&mRandomSeedsDevice));
     mAllocator->free((void**) (&mSkipDecodeDevice));
     mAllocator->free((void**) (&mSamplingWorkspaceDevice));
+    mAllocator->free((void**) (&mMinPDevice));
+    mAllocator->free((void**) (&mTypicalPDevice));
+    mAllocator->free((void**) (&mEtaDevice));
+    mAllocator->free((void**) (&mNumTopLogProbsDevice));
     std::free(mSkipDecodeHost);
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -116,31 +137,12 @@ void SamplingLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeTyp
 
     auto setupParams = std::dynamic_pointer_cast<SamplingSetupParams>(baseSetupParams);
 
-    // If runtime argument has single random seed, using this random seed to
-    // initialize the random table of all sentences. If the argument has
-    // [batchSize] random seeds, initializing the random table by different
-    // random seeds respectively. If no random seed, initialize the random table
-    // of all sentences by 0 directly.
-    if (setupParams->randomSeed)
-    {
-        if (setupParams->randomSeed->size() == 1)
-        {
-            invokeCurandInitialize(
-                mCurandStatesDevice, batchSlots, batchSize, setupParams->randomSeed->front(), mStream);
-            sync_check_cuda_error();
-        }
-        else
-        {
-            TLLM_CHECK_WITH_INFO(setupParams->randomSeed->size() == batchSize, "Random seed vector size mismatch.");
-            cudaAutoCpy(mRandomSeedsDevice, setupParams->randomSeed->data(), batchSize, mStream);
-            invokeCurandBatchInitialize(mCurandStatesDevice, batchSlots, batchSize, mRandomSeedsDevice, mStream);
-            sync_check_cuda_error();
-        }
-    }
-    else
+    // The random numbers are stateless, keyed by the seed of the request and its step, only the seeds are set up.
+    // A single seed is used for all the requests, the default seed if there is none.
     {
-        // Initialize curand states using the default seed 0.
-        invokeCurandInitialize(mCurandStatesDevice, batchSlots, batchSize, 0, mStream);
+        FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
+        fillBuffers(setupParams->randomSeed, DefaultDecodingParams::getSeed(), mRandomSeeds, mRandomSeedsDevice,
+            batchSlots, std::make_pair(-1.f, std::numeric_limits<float>::max()), "random seed");
     }
 
     if (setupParams->outputLogProbs)
@@ -157,6 +159,30 @@ void SamplingLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeTyp
             [this](bool cumLogProbs) { return this->mCumLogProbs | cumLogProbs; });
     }
 
+    // FIXME(nkorobov): monotonically growing, the filters of new requests are reset to the defaults once enabled
+    mUseProbsFilter
+        |= setupParams->minP.has_value() || setupParams->typicalP.has_value() || setupParams->eta.has_value();
+    if (mUseProbsFilter)
+    {
+        FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
+        auto constexpr fltEpsilon = std::numeric_limits<float>::epsilon();
+        fillBuffers(setupParams->minP, DefaultDecodingParams::getMinP(), mMinP, mMinPDevice, batchSlots,
+            std::make_pair(-fltEpsilon, 1.f), "min p");
+        fillBuffers(setupParams->typicalP, DefaultDecodingParams::getTypicalP(), mTypicalP, mTypicalPDevice,
+            batchSlots, std::make_pair(0.f, 1.f), "typical p");
+        fillBuffers(setupParams->eta, DefaultDecodingParams::getEta(), mEta, mEtaDevice, batchSlots,
+            std::make_pair(-fltEpsilon, 1.f), "eta");
+    }
+
+    // FIXME(nkorobov): monotonically growing, the alternatives of new requests are reset to 0 once enabled
+    mOutputTopLogProbs |= setupParams->numTopLogProbs.has_value();
+    if (mOutputTopLogProbs)
+    {
+        FillBuffers const fillBuffers{batchSize, mDecoderDomain.getBatchSize(), mStream};
+        fillBuffers(setupParams->numTopLogProbs, SizeType32{0}, mNumTopLogProbs, mNumTopLogProbsDevice, batchSlots,
+            std::make_pair(-1.f, static_cast<float>(TOP_LOG_PROBS_MAX)), "num top log probs");
+    }
+
     for (auto&& layer : mSamplingLayers)
     {
         layer->setup(batchSize, beamWidth, batchSlots, setupParams);
@@ -185,10 +211,33 @@ void SamplingLayer<T>::forwardAsync(
 
     auto const skipTopP = !mDecodingMode.isTopP();
 
-    // Compute probabilities either for TopP or if cumLogProbs or outputLogProbs are specified
-    bool const skipSoftMax = skipTopP && !mOutputLogProbs && !mCumLogProbs;
+    // Compute probabilities either for TopP, for the filters or if cumLogProbs or outputLogProbs are specified.
+    // TopK samples from logits or probabilities with different rounding, batch invariant mode always computes them
+    bool const skipSoftMax = skipTopP && !mUseProbsFilter && !mOutputLogProbs && !mCumLogProbs
+        && !mDecodingMode.isUseBatchInvariant();
+
+    // Alternatives are computed from the logits before they are turned into probabilities
+    if (mOutputTopLogProbs && outputs->topLogProbs && outputs->topLogProbIds && outputs->sequenceLength)
+    {
+        TopLogProbsKernelParams<T> topLogProbsParams;
+        topLogProbsParams.logits = logits;
+        topLogProbsParams.numTopLogProbs = mNumTopLogProbsDevice;
+        topLogProbsParams.sequenceLengths = outputs->sequenceLength->template getPtr<SizeType32 const>();
+        topLogProbsParams.batchSlots = batchSlots;
+        topLogProbsParams.finishedInput = finishedInput;
+        topLogProbsParams.topLogProbs = outputs->topLogProbs->template getPtr<float>();
+        topLogProbsParams.topLogProbIds = outputs->topLogProbIds->template getPtr<TokenIdType>();
+        topLogProbsParams.batchSize = batchSize;
+        topLogProbsParams.maxBatchSize = mDecoderDomain.getBatchSize();
+        topLogProbsParams.maxSeqLen = outputs->topLogProbs->shape[1];
+        topLogProbsParams.vocabSize = mDecoderDomain.getVocabSize();
+        topLogProbsParams.vocabSizePadded = mDecoderDomain.getVocabSizePadded();
+        topLogProbsParams.maxNumTopLogProbs = outputs->topLogProbs->shape[2];
+        invokeTopLogProbs(topLogProbsParams, mStream);
+        sync_check_cuda_error();
+    }
 
-    inputs->curandStates = mCurandStatesDevice;
+    inputs->randomSeeds = mRandomSeedsDevice;
     inputs->samplingWorkspace = mSamplingWorkspaceDevice;
     inputs->probsComputed = !skipSoftMax;
     if (!skipSoftMax)
@@ -199,6 +248,23 @@ void SamplingLayer<T>::forwardAsync(
         sync_check_cuda_error();
     }
 
+    if (mUseProbsFilter)
+    {
+        FilterProbsKernelParams<T> filterParams;
+        filterParams.probs = logits;
+        filterParams.minPs = mMinPDevice;
+        filterParams.typicalPs = mTypicalPDevice;
+        filterParams.etas = mEtaDevice;
+        filterParams.batchSlots = batchSlots;
+        filterParams.finishedInput = finishedInput;
+        filterParams.batchSize = batchSize;
+        filterParams.maxBatchSize = mDecoderDomain.getBatchSize();
+        filterParams.vocabSize = mDecoderDomain.getVocabSize();
+        filterParams.vocabSizePadded = mDecoderDomain.getVocabSizePadded();
+        invokeBatchFilterProbs(filterParams, mStream);
+        sync_check_cuda_error();
+    }
+
     for (auto&& layer : mSamplingLayers)
     {
         layer->forwardAsync(outputs, baseInputs);
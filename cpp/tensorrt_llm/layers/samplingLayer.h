@@ -22,13 +22,14 @@
 #include "tensorrt_llm/layers/decodingParams.h"
 #include "tensorrt_llm/runtime/common.h"
 
-#include <curand_kernel.h>
+#include <vector>
 
 namespace tensorrt_llm::layers
 {
 
 //! \brief Top class for sampling layers.
-//! It sets up and executes TopKSamplingLayer and TopPSamplingLayer samplings
+//! It sets up and executes TopKSamplingLayer and TopPSamplingLayer samplings.
+//! Min-p, typical-p and eta filter the probabilities of the requests that set them before sampling.
 template <typename T>
 class SamplingLayer : public BaseLayer
 {
@@ -58,8 +59,8 @@ private:
     executor::DecodingMode mDecodingMode;
 
     void* mSamplingWorkspaceDevice{nullptr};
-    curandState_t* mCurandStatesDevice{nullptr};
     uint64_t* mRandomSeedsDevice{nullptr};
+    std::vector<uint64_t> mRandomSeeds; // [maxBatchSize]
 
     bool* mSkipDecodeDevice{nullptr};
 
@@ -69,6 +70,20 @@ private:
     bool mOutputLogProbs{false};
     bool mCumLogProbs{false};
 
+    float* mMinPDevice{nullptr};
+    float* mTypicalPDevice{nullptr};
+    float* mEtaDevice{nullptr};
+
+    std::vector<float> mMinP;     // [maxBatchSize]
+    std::vector<float> mTypicalP; // [maxBatchSize]
+    std::vector<float> mEta;      // [maxBatchSize]
+
+    bool mUseProbsFilter{false};
+
+    runtime::SizeType32* mNumTopLogProbsDevice{nullptr};
+    std::vector<runtime::SizeType32> mNumTopLogProbs; // [maxBatchSize]
+    bool mOutputTopLogProbs{false};
+
     std::vector<std::unique_ptr<BaseLayer>> mSamplingLayers;
 
 private:
@@ -18,6 +18,7 @@
 #include "tensorrt_llm/layers/stopCriteriaLayer.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/kernels/stopCriteriaKernels.h"
+#include "tensorrt_llm/kernels/wordsAutomatonKernels.h"
 #include "tensorrt_llm/layers/layerUtils.h"
 
 using namespace tensorrt_llm::common;
@@ -34,14 +35,31 @@ StopCriteriaLayer<T>::StopCriteriaLayer(executor::DecodingMode const& mode, Deco
     , mDecodingMode(mode)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mDecodingMode.isUseStopWords())
+    {
+        mStopWordsAutomata = std::make_unique<DeviceWordsAutomata>(decoderDomain.getBatchSize(), mAllocator);
+    }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
 template <typename T>
 void StopCriteriaLayer<T>::setup(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 const* batchSlots,
-    std::shared_ptr<BaseSetupParams> const& setupParams)
+    std::shared_ptr<BaseSetupParams> const& baseSetupParams)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mStopWordsAutomata)
+    {
+        auto setupParams = std::dynamic_pointer_cast<DynamicDecodeSetupParams>(baseSetupParams);
+        std::vector<std::shared_ptr<WordsAutomaton const>> automata;
+        if (setupParams && setupParams->stopCriteriaParams)
+        {
+            automata = setupParams->stopCriteriaParams->stopWordsAutomata;
+        }
+        TLLM_CHECK_WITH_INFO(beamWidth == 1
+                || std::all_of(automata.begin(), automata.end(), [](auto const& automaton) { return !automaton; }),
+            "Stop words automata require beam width 1");
+        mStopWordsAutomata->setup(automata, batchSize, batchSlots, mStream);
+    }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -62,7 +80,8 @@ void StopCriteriaLayer<T>::forwardAsync(
 
     if (mDecodingMode.isUseStopWords())
     {
-        checkStopWordsStopCriteria(outputs, inputs, batchSlots, localDecoderDomain, maxSeqLen, mStream);
+        checkStopWordsStopCriteria(
+            outputs, inputs, batchSlots, localDecoderDomain, maxSeqLen, mStopWordsAutomata.get(), mStream);
     }
     if (mDecodingMode.isUseExplicitEosStop())
     {
@@ -79,20 +98,30 @@ void StopCriteriaLayer<T>::forwardAsync(
 template <typename T>
 void StopCriteriaLayer<T>::checkStopWordsStopCriteria(std::shared_ptr<BaseDecodingOutputs>& outputs,
     std::shared_ptr<DecodingInputs> const& inputs, SizeType32 const* batchSlots, DecoderDomain const& decoderDomain,
-    SizeType32 maxSeqLen, cudaStream_t stream)
+    SizeType32 maxSeqLen, DeviceWordsAutomata const* stopWordsAutomata, cudaStream_t stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto numNewTokens = outputs->numNewTokens ? outputs->numNewTokens->template getPtr<SizeType32>() : nullptr;
+    bool const useAutomata = stopWordsAutomata != nullptr && stopWordsAutomata->hasAutomata();
+    if (useAutomata)
+    {
+        invokeStopWordsAutomaton(outputs->outputIdsPtr.template getPtr<TokenIdType const*>(),
+            stopWordsAutomata->getAutomataDevice(), stopWordsAutomata->getProgressDevice(),
+            reinterpret_cast<FinishedState*>(outputs->finished->template getPtr<FinishedState::UnderlyingType>()),
+            outputs->sequenceLength->template getPtr<SizeType32>(), batchSlots, numNewTokens,
+            decoderDomain.getBatchSize(), stream);
+    }
     auto const maxStopWordsLength = inputs->stopCriteriaInputs->maxStopWordsLen;
     if (maxStopWordsLength)
     {
-        auto numNewTokens = outputs->numNewTokens ? outputs->numNewTokens->template getPtr<SizeType32>() : nullptr;
         invokeStopWordsCriterion(outputs->outputIdsPtr.template getPtr<TokenIdType const*>(),
             outputs->parentIdsPtr.template getPtr<SizeType32 const*>(),
             inputs->stopCriteriaInputs->stopWordsPtr->template getPtr<TokenIdType const*>(),
             reinterpret_cast<FinishedState*>(outputs->finished->template getPtr<FinishedState::UnderlyingType>()),
             outputs->sequenceLength->template getPtr<SizeType32>(), batchSlots,
             inputs->stopCriteriaInputs->stopWordsLengths->template getPtr<SizeType32 const>(), numNewTokens,
-            maxStopWordsLength, decoderDomain.getBatchSize(), decoderDomain.getBeamWidth(), maxSeqLen, stream);
+            maxStopWordsLength, decoderDomain.getBatchSize(), decoderDomain.getBeamWidth(), maxSeqLen,
+            useAutomata ? stopWordsAutomata->getHasAutomatonDevice() : nullptr, stream);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
@@ -130,8 +159,9 @@ void StopCriteriaLayer<T>::checkEosToken(std::shared_ptr<BaseDecodingOutputs>& o
     invokeExplicitEOSCriterion(outputs->outputIdsPtr.template getPtr<TokenIdType const*>(),
         inputs->endIds.template getPtr<TokenIdType const>(),
         reinterpret_cast<FinishedState*>(outputs->finished->template getPtr<FinishedState::UnderlyingType>()),
-        outputs->sequenceLength->template getPtr<SizeType32>(), numNewTokens, batchSlots, decoderDomain.getBatchSize(),
-        decoderDomain.getBeamWidth(), decoderDomain.getMaxDecodingTokens(), stream);
+        outputs->sequenceLength->template getPtr<SizeType32>(), numNewTokens,
+        outputs->finishedSlots ? outputs->finishedSlots->template getPtr<SizeType32>() : nullptr, batchSlots,
+        decoderDomain.getBatchSize(), decoderDomain.getBeamWidth(), decoderDomain.getMaxDecodingTokens(), stream);
     sync_check_cuda_error();
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
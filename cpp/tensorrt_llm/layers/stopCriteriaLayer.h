@@ -20,6 +20,7 @@
 #include "tensorrt_llm/executor/types.h"
 #include "tensorrt_llm/layers/baseLayer.h"
 #include "tensorrt_llm/layers/decodingParams.h"
+#include "tensorrt_llm/layers/wordsAutomaton.h"
 
 #include <curand_kernel.h>
 
@@ -27,13 +28,13 @@ namespace tensorrt_llm::layers
 {
 
 //! \brief Layer to process stop criteria. Supports:
-//! 1. Stop words criteria
+//! 1. Stop words criteria, from the decoding inputs or with the stopWordsAutomata of the setup params
 //! 2. Maximum length criteria
 template <typename T>
 class StopCriteriaLayer : public BaseLayer
 {
 public:
-    StopCriteriaLayer(executor::DecodingMode const& mode, DecoderDomain const& /* decoderDomain */, cudaStream_t stream,
+    StopCriteriaLayer(executor::DecodingMode const& mode, DecoderDomain const& decoderDomain, cudaStream_t stream,
         std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
 
     ~StopCriteriaLayer() override = default;
@@ -50,7 +51,8 @@ private:
         DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, cudaStream_t stream);
     static void checkStopWordsStopCriteria(std::shared_ptr<BaseDecodingOutputs>& outputs,
         std::shared_ptr<DecodingInputs> const& inputs, runtime::SizeType32 const* batchSlots,
-        DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, cudaStream_t stream);
+        DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, DeviceWordsAutomata const* stopWordsAutomata,
+        cudaStream_t stream);
     static void checkEosToken(std::shared_ptr<BaseDecodingOutputs>& outputs,
         std::shared_ptr<DecodingInputs> const& inputs, runtime::SizeType32 const* batchSlots,
         DecoderDomain const& decoderDomain, runtime::SizeType32 maxSeqLen, cudaStream_t stream);
@@ -65,6 +67,8 @@ private:
     using BaseLayer::mDecoderDomain;
 
     executor::DecodingMode mDecodingMode;
+
+    std::unique_ptr<DeviceWordsAutomata> mStopWordsAutomata;
 };
 
 } // namespace tensorrt_llm::layers
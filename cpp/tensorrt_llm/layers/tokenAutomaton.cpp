@@ -0,0 +1,683 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/tokenAutomaton.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cctype>
+#include <map>
+
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::layers
+{
+
+namespace
+{
+using ByteSet = std::bitset<256>;
+
+struct RegexNode
+{
+    enum class Kind
+    {
+        kEMPTY,
+        kBYTES,
+        kCONCAT,
+        kALTERNATE,
+        kREPEAT,
+    };
+
+    Kind kind{Kind::kEMPTY};
+    ByteSet bytes{};
+    std::vector<RegexNode> children{};
+    SizeType32 minRepeat{0};
+    // -1 for unbounded
+    SizeType32 maxRepeat{0};
+};
+
+class RegexParser
+{
+public:
+    explicit RegexParser(std::string_view pattern)
+        : mPattern{pattern}
+    {
+    }
+
+    RegexNode parse()
+    {
+        auto node = parseAlternation();
+        TLLM_CHECK_WITH_INFO(atEnd(), "Unexpected '%c' at position %zu of regex", peek(), mPos);
+        return node;
+    }
+
+private:
+    [[nodiscard]] bool atEnd() const
+    {
+        return mPos >= mPattern.size();
+    }
+
+    [[nodiscard]] char peek() const
+    {
+        return atEnd() ? '\0' : mPattern[mPos];
+    }
+
+    char take()
+    {
+        TLLM_CHECK_WITH_INFO(!atEnd(), "Unexpected end of regex");
+        return mPattern[mPos++];
+    }
+
+    RegexNode parseAlternation()
+    {
+        RegexNode first = parseConcat();
+        if (peek() != '|')
+        {
+            return first;
+        }
+        RegexNode node{RegexNode::Kind::kALTERNATE};
+        node.children.push_back(std::move(first));
+        while (peek() == '|')
+        {
+            take();
+            node.children.push_back(parseConcat());
+        }
+        return node;
+    }
+
+    RegexNode parseConcat()
+    {
+        RegexNode node{RegexNode::Kind::kCONCAT};
+        while (!atEnd() && peek() != '|' && peek() != ')')
+        {
+            node.children.push_back(parseRepeat());
+        }
+        if (node.children.empty())
+        {
+            return RegexNode{RegexNode::Kind::kEMPTY};
+        }
+        if (node.children.size() == 1)
+        {
+            return std::move(node.children.front());
+        }
+        return node;
+    }
+
+    RegexNode parseRepeat()
+    {
+        auto node = parseAtom();
+        while (peek() == '*' || peek() == '+' || peek() == '?' || peek() == '{')
+        {
+            RegexNode repeat{RegexNode::Kind::kREPEAT};
+            switch (take())
+            {
+            case '*': repeat.maxRepeat = -1; break;
+            case '+':
+                repeat.minRepeat = 1;
+                repeat.maxRepeat = -1;
+                break;
+            case '?': repeat.maxRepeat = 1; break;
+            default:
+                repeat.minRepeat = parseNumber();
+                repeat.maxRepeat = repeat.minRepeat;
+                if (peek() == ',')
+                {
+                    take();
+                    repeat.maxRepeat = peek() == '}' ? -1 : parseNumber();
+                }
+                TLLM_CHECK_WITH_INFO(take() == '}', "Expected '}' at position %zu of regex", mPos - 1);
+                TLLM_CHECK_WITH_INFO(repeat.maxRepeat == -1 || repeat.minRepeat <= repeat.maxRepeat,
+                    "Invalid repetition {%d,%d} in regex", repeat.minRepeat, repeat.maxRepeat);
+                break;
+            }
+            repeat.children.push_back(std::move(node));
+            node = std::move(repeat);
+        }
+        return node;
+    }
+
+    SizeType32 parseNumber()
+    {
+        SizeType32 value{0};
+        TLLM_CHECK_WITH_INFO(
+            std::isdigit(static_cast<unsigned char>(peek())), "Expected a number at position %zu of regex", mPos);
+        while (std::isdigit(static_cast<unsigned char>(peek())))
+        {
+            value = value * 10 + (take() - '0');
+            TLLM_CHECK_WITH_INFO(
+                value <= ByteDfa::kMaxRepeat, "Repetition count exceeds %d in regex", ByteDfa::kMaxRepeat);
+        }
+        return value;
+    }
+
+    RegexNode parseAtom()
+    {
+        RegexNode node{RegexNode::Kind::kBYTES};
+        auto const c = take();
+        switch (c)
+        {
+        case '(':
+            if (mPattern.substr(mPos, 2) == "?:")
+            {
+                mPos += 2;
+            }
+            node = parseAlternation();
+            TLLM_CHECK_WITH_INFO(take() == ')', "Expected ')' at position %zu of regex", mPos - 1);
+            return node;
+        case '[': node.bytes = parseClass(); return node;
+        case '.': node.bytes.set().reset('\n'); return node;
+        case '\\': node.bytes = parseEscape(); return node;
+        case ')':
+        case '*':
+        case '+':
+        case '?':
+        case '{': TLLM_THROW("Unexpected '%c' at position %zu of regex", c, mPos - 1);
+        default: node.bytes.set(static_cast<unsigned char>(c)); return node;
+        }
+    }
+
+    ByteSet parseEscape()
+    {
+        ByteSet bytes;
+        auto const c = take();
+        auto const setRange = [&bytes](unsigned char first, unsigned char last)
+        {
+            for (auto b = first; b <= last; ++b)
+            {
+                bytes.set(b);
+            }
+        };
+        switch (c)
+        {
+        case 'd':
+        case 'D': setRange('0', '9'); break;
+        case 'w':
+        case 'W':
+            setRange('a', 'z');
+            setRange('A', 'Z');
+            setRange('0', '9');
+            bytes.set('_');
+            break;
+        case 's':
+        case 'S':
+            for (auto const b : {' ', '\t', '\n', '\r', '\f', '\v'})
+            {
+                bytes.set(static_cast<unsigned char>(b));
+            }
+            break;
+        case 'n': bytes.set('\n'); break;
+        case 't': bytes.set('\t'); break;
+        case 'r': bytes.set('\r'); break;
+        case 'f': bytes.set('\f'); break;
+        case 'v': bytes.set('\v'); break;
+        default:
+            TLLM_CHECK_WITH_INFO(!std::isalnum(static_cast<unsigned char>(c)), "Unsupported escape '\\%c' in regex", c);
+            bytes.set(static_cast<unsigned char>(c));
+            break;
+        }
+        if (c == 'D' || c == 'W' || c == 'S')
+        {
+            bytes.flip();
+        }
+        return bytes;
+    }
+
+    ByteSet parseClass()
+    {
+        ByteSet bytes;
+        bool const negate = peek() == '^';
+        if (negate)
+        {
+            take();
+        }
+        bool first = true;
+        while (first || peek() != ']')
+        {
+            first = false;
+            auto const c = take();
+            if (c == '\\')
+            {
+                bytes |= parseEscape();
+                continue;
+            }
+            auto last = c;
+            if (peek() == '-' && mPos + 1 < mPattern.size() && mPattern[mPos + 1] != ']')
+            {
+                take();
+                last = take();
+                TLLM_CHECK_WITH_INFO(static_cast<unsigned char>(c) <= static_cast<unsigned char>(last),
+                    "Invalid range %c-%c in regex", c, last);
+            }
+            for (auto b = static_cast<unsigned>(static_cast<unsigned char>(c));
+                 b <= static_cast<unsigned char>(last); ++b)
+            {
+                bytes.set(b);
+            }
+        }
+        take();
+        return negate ? ~bytes : bytes;
+    }
+
+    std::string_view mPattern;
+    std::size_t mPos{0};
+};
+
+//! Thompson construction, every fragment has a single end state without outgoing edges.
+class NfaBuilder
+{
+public:
+    struct State
+    {
+        ByteSet bytes{};
+        std::int32_t next{-1};
+        std::vector<std::int32_t> epsilon{};
+    };
+
+    struct Fragment
+    {
+        std::int32_t start;
+        std::int32_t end;
+    };
+
+    Fragment build(RegexNode const& node)
+    {
+        switch (node.kind)
+        {
+        case RegexNode::Kind::kEMPTY:
+        {
+            auto const state = addState();
+            return {state, state};
+        }
+        case RegexNode::Kind::kBYTES:
+        {
+            auto const start = addState();
+            auto const end = addState();
+            mStates[start].bytes = node.bytes;
+            mStates[start].next = end;
+            return {start, end};
+        }
+        case RegexNode::Kind::kCONCAT:
+        {
+            auto fragment = build(node.children.front());
+            for (std::size_t i = 1; i < node.children.size(); ++i)
+            {
+                fragment = concat(fragment, build(node.children[i]));
+            }
+            return fragment;
+        }
+        case RegexNode::Kind::kALTERNATE:
+        {
+            auto const start = addState();
+            auto const end = addState();
+            for (auto const& child : node.children)
+            {
+                auto const fragment = build(child);
+                mStates[start].epsilon.push_back(fragment.start);
+                mStates[fragment.end].epsilon.push_back(end);
+            }
+            return {start, end};
+        }
+        case RegexNode::Kind::kREPEAT:
+        {
+            auto const& child = node.children.front();
+            auto const start = addState();
+            Fragment fragment{start, start};
+            for (SizeType32 i = 0; i < node.minRepeat; ++i)
+            {
+                fragment = concat(fragment, build(child));
+            }
+            if (node.maxRepeat < 0)
+            {
+                auto const loop = addState();
+                auto const body = build(child);
+                mStates[loop].epsilon.push_back(body.start);
+                mStates[body.end].epsilon.push_back(loop);
+                return concat(fragment, {loop, loop});
+            }
+            for (SizeType32 i = node.minRepeat; i < node.maxRepeat; ++i)
+            {
+                auto const optionalStart = addState();
+                auto const optionalEnd = addState();
+                auto const body = build(child);
+                mStates[optionalStart].epsilon.push_back(body.start);
+                mStates[optionalStart].epsilon.push_back(optionalEnd);
+                mStates[body.end].epsilon.push_back(optionalEnd);
+                fragment = concat(fragment, {optionalStart, optionalEnd});
+            }
+            return fragment;
+        }
+        }
+        TLLM_THROW("Unknown regex node");
+    }
+
+    [[nodiscard]] std::vector<State> const& getStates() const
+    {
+        return mStates;
+    }
+
+private:
+    // NFA states are cheap, the limit only bounds the memory of pathological repetitions
+    static constexpr std::size_t kMaxNfaStates = 1 << 20;
+
+    std::int32_t addState()
+    {
+        TLLM_CHECK_WITH_INFO(mStates.size() < kMaxNfaStates, "Regex is too large");
+        mStates.emplace_back();
+        return static_cast<std::int32_t>(mStates.size() - 1);
+    }
+
+    Fragment concat(Fragment first, Fragment second)
+    {
+        mStates[first.end].epsilon.push_back(second.start);
+        return {first.start, second.end};
+    }
+
+    std::vector<State> mStates;
+};
+
+std::vector<std::int32_t> epsilonClosure(std::vector<NfaBuilder::State> const& states, std::vector<std::int32_t> set)
+{
+    std::vector<bool> visited(states.size(), false);
+    std::vector<std::int32_t> stack{set};
+    set.clear();
+    while (!stack.empty())
+    {
+        auto const state = stack.back();
+        stack.pop_back();
+        if (visited[state])
+        {
+            continue;
+        }
+        visited[state] = true;
+        set.push_back(state);
+        for (auto const next : states[state].epsilon)
+        {
+            stack.push_back(next);
+        }
+    }
+    std::sort(set.begin(), set.end());
+    return set;
+}
+} // namespace
+
+ByteDfa ByteDfa::compileRegex(std::string_view pattern)
+{
+    auto const root = RegexParser{pattern}.parse();
+    NfaBuilder builder;
+    auto const fragment = builder.build(root);
+    auto const& nfa = builder.getStates();
+
+    // Subset construction
+    std::map<std::vector<std::int32_t>, StateType> ids;
+    std::vector<std::vector<std::int32_t>> sets;
+    std::vector<StateType> transitions;
+    std::vector<bool> accepting;
+    auto const getId = [&](std::vector<std::int32_t> set)
+    {
+        auto const [iter, inserted] = ids.try_emplace(std::move(set), static_cast<StateType>(sets.size()));
+        if (inserted)
+        {
+            TLLM_CHECK_WITH_INFO(sets.size() < static_cast<std::size_t>(kMaxStates),
+                "Regex needs more than %d automaton states", kMaxStates);
+            sets.push_back(iter->first);
+            accepting.push_back(std::binary_search(iter->first.begin(), iter->first.end(), fragment.end));
+            transitions.resize(transitions.size() + kNumBytes, kDeadState);
+        }
+        return iter->second;
+    };
+    getId(epsilonClosure(nfa, {fragment.start}));
+    for (std::size_t state = 0; state < sets.size(); ++state)
+    {
+        for (std::size_t byte = 0; byte < kNumBytes; ++byte)
+        {
+            std::vector<std::int32_t> next;
+            for (auto const nfaState : sets[state])
+            {
+                if (nfa[nfaState].bytes.test(byte))
+                {
+                    next.push_back(nfa[nfaState].next);
+                }
+            }
+            if (!next.empty())
+            {
+                auto const nextId = getId(epsilonClosure(nfa, std::move(next)));
+                transitions[state * kNumBytes + byte] = nextId;
+            }
+        }
+    }
+
+    // Remove the states from which no accepting state can be reached
+    auto const numStates = sets.size();
+    std::vector<std::vector<StateType>> predecessors(numStates);
+    for (std::size_t state = 0; state < numStates; ++state)
+    {
+        for (std::size_t byte = 0; byte < kNumBytes; ++byte)
+        {
+            auto const next = transitions[state * kNumBytes + byte];
+            if (next != kDeadState)
+            {
+                predecessors[next].push_back(static_cast<StateType>(state));
+            }
+        }
+    }
+    std::vector<bool> live(numStates, false);
+    std::vector<StateType> stack;
+    for (std::size_t state = 0; state < numStates; ++state)
+    {
+        if (accepting[state])
+        {
+            live[state] = true;
+            stack.push_back(static_cast<StateType>(state));
+        }
+    }
+    while (!stack.empty())
+    {
+        auto const state = stack.back();
+        stack.pop_back();
+        for (auto const predecessor : predecessors[state])
+        {
+            if (!live[predecessor])
+            {
+                live[predecessor] = true;
+                stack.push_back(predecessor);
+            }
+        }
+    }
+    TLLM_CHECK_WITH_INFO(live[getInitialState()], "Regex matches nothing");
+    for (auto& next : transitions)
+    {
+        if (next != kDeadState && !live[next])
+        {
+            next = kDeadState;
+        }
+    }
+    return ByteDfa{std::move(transitions), std::move(accepting)};
+}
+
+TokenVocabulary::TokenVocabulary(std::vector<std::string> tokens, std::vector<TokenIdType> endIds)
+    : mTokens{std::move(tokens)}
+    , mEndIds{std::move(endIds)}
+    , mTrie(1)
+{
+    for (auto const endId : mEndIds)
+    {
+        TLLM_CHECK_WITH_INFO(0 <= endId && endId < getVocabSize(), "End id %d is out of the vocabulary", endId);
+    }
+    for (TokenIdType tokenId = 0; tokenId < getVocabSize(); ++tokenId)
+    {
+        auto const& token = mTokens[tokenId];
+        if (token.empty())
+        {
+            continue;
+        }
+        std::int32_t node{0};
+        for (auto const c : token)
+        {
+            auto const byte = static_cast<std::uint8_t>(c);
+            auto& children = mTrie[node].children;
+            auto iter = std::find_if(
+                children.begin(), children.end(), [byte](auto const& child) { return child.first == byte; });
+            if (iter == children.end())
+            {
+                auto const child = static_cast<std::int32_t>(mTrie.size());
+                children.emplace_back(byte, child);
+                mTrie.emplace_back();
+                node = child;
+            }
+            else
+            {
+                node = iter->second;
+            }
+        }
+        mTrie[node].tokens.push_back(tokenId);
+    }
+}
+
+bool TokenVocabulary::isEndId(TokenIdType tokenId) const
+{
+    return std::find(mEndIds.begin(), mEndIds.end(), tokenId) != mEndIds.end();
+}
+
+TokenAutomaton::TokenAutomaton(ByteDfa dfa, std::shared_ptr<TokenVocabulary const> vocabulary)
+    : mDfa{std::move(dfa)}
+    , mVocabulary{std::move(vocabulary)}
+{
+    TLLM_CHECK(mVocabulary);
+}
+
+TokenAutomaton::StateType TokenAutomaton::advance(StateType state, TokenIdType tokenId) const
+{
+    if (state == ByteDfa::kDeadState)
+    {
+        return ByteDfa::kDeadState;
+    }
+    if (mVocabulary->isEndId(tokenId))
+    {
+        return mDfa.isAccepting(state) ? state : ByteDfa::kDeadState;
+    }
+    auto const& token = mVocabulary->getToken(tokenId);
+    if (token.empty())
+    {
+        return ByteDfa::kDeadState;
+    }
+    for (auto const c : token)
+    {
+        state = mDfa.next(state, static_cast<std::uint8_t>(c));
+        if (state == ByteDfa::kDeadState)
+        {
+            break;
+        }
+    }
+    return state;
+}
+
+std::shared_ptr<TokenAutomaton::Bitmask const> TokenAutomaton::getMask(StateType state) const
+{
+    TLLM_CHECK_WITH_INFO(0 <= state && state < mDfa.getNumStates(), "Invalid automaton state %d", state);
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const iter = mMasks.find(state);
+        if (iter != mMasks.end())
+        {
+            return iter->second;
+        }
+    }
+    // Computed without the lock, concurrent requests for the same state compute identical masks
+    auto mask = std::make_shared<Bitmask const>(computeMask(state));
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mMasks.try_emplace(state, std::move(mask)).first->second;
+}
+
+TokenAutomaton::Bitmask TokenAutomaton::computeMask(StateType state) const
+{
+    Bitmask mask(getNumWords(), 0);
+    auto const allow = [&mask](TokenIdType tokenId)
+    { mask[tokenId / kBitsPerWord] |= BitmaskType{1} << (tokenId % kBitsPerWord); };
+    if (mDfa.isAccepting(state))
+    {
+        for (auto const endId : mVocabulary->getEndIds())
+        {
+            allow(endId);
+        }
+    }
+    auto const& trie = mVocabulary->mTrie;
+    std::vector<std::pair<std::int32_t, StateType>> stack{{0, state}};
+    while (!stack.empty())
+    {
+        auto const [node, nodeState] = stack.back();
+        stack.pop_back();
+        for (auto const& [byte, child] : trie[node].children)
+        {
+            auto const childState = mDfa.next(nodeState, byte);
+            if (childState == ByteDfa::kDeadState)
+            {
+                continue;
+            }
+            for (auto const tokenId : trie[child].tokens)
+            {
+                allow(tokenId);
+            }
+            stack.emplace_back(child, childState);
+        }
+    }
+    return mask;
+}
+
+TokenAutomatonCache::TokenAutomatonCache(std::shared_ptr<TokenVocabulary const> vocabulary, SizeType32 capacity)
+    : mVocabulary{std::move(vocabulary)}
+    , mCapacity{capacity}
+{
+    TLLM_CHECK(mVocabulary);
+    TLLM_CHECK(mCapacity > 0);
+}
+
+std::shared_ptr<TokenAutomaton const> TokenAutomatonCache::getRegex(std::string const& pattern)
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const iter = mIndex.find(pattern);
+        if (iter != mIndex.end())
+        {
+            mEntries.splice(mEntries.begin(), mEntries, iter->second);
+            return iter->second->second;
+        }
+    }
+    // Compiled without the lock, other grammars are served meanwhile
+    auto automaton = std::make_shared<TokenAutomaton const>(ByteDfa::compileRegex(pattern), mVocabulary);
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const iter = mIndex.find(pattern);
+    if (iter != mIndex.end())
+    {
+        return iter->second->second;
+    }
+    mEntries.emplace_front(pattern, std::move(automaton));
+    mIndex.emplace(pattern, mEntries.begin());
+    if (static_cast<SizeType32>(mEntries.size()) > mCapacity)
+    {
+        mIndex.erase(mEntries.back().first);
+        mEntries.pop_back();
+    }
+    return mEntries.front().second;
+}
+
+TokenAutomatonCache::SizeType32 TokenAutomatonCache::getNumEntries() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<SizeType32>(mEntries.size());
+}
+
+} // namespace tensorrt_llm::layers
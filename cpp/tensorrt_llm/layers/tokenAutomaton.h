@@ -0,0 +1,201 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::layers
+{
+
+//! @brief Deterministic automaton over bytes, compiled from a regular expression.
+//! @details Supports literals, `.`, escapes (`\d`, `\w`, `\s`, their negations and escaped metacharacters), bracket
+//! classes with ranges and negation, groups, `|` and the quantifiers `*`, `+`, `?`, `{m}`, `{m,}` and `{m,n}`. The
+//! whole output must match the expression. Characters outside ASCII are matched as their UTF-8 bytes. States from
+//! which no match can be completed are removed, every transition either leads to kDeadState or can still match.
+class ByteDfa
+{
+public:
+    using StateType = std::int32_t;
+
+    static constexpr StateType kDeadState = -1;
+    static constexpr StateType kMaxStates = 1 << 16;
+    static constexpr runtime::SizeType32 kMaxRepeat = 1024;
+
+    //! @brief Throws if the expression is invalid, matches nothing or needs more than kMaxStates states.
+    static ByteDfa compileRegex(std::string_view pattern);
+
+    [[nodiscard]] static StateType constexpr getInitialState()
+    {
+        return 0;
+    }
+
+    [[nodiscard]] StateType next(StateType state, std::uint8_t byte) const
+    {
+        return mTransitions[static_cast<std::size_t>(state) * kNumBytes + byte];
+    }
+
+    [[nodiscard]] bool isAccepting(StateType state) const
+    {
+        return mAccepting[state];
+    }
+
+    [[nodiscard]] StateType getNumStates() const
+    {
+        return static_cast<StateType>(mAccepting.size());
+    }
+
+private:
+    static constexpr std::size_t kNumBytes = 256;
+
+    ByteDfa(std::vector<StateType> transitions, std::vector<bool> accepting)
+        : mTransitions{std::move(transitions)}
+        , mAccepting{std::move(accepting)}
+    {
+    }
+
+    std::vector<StateType> mTransitions; // [numStates, kNumBytes]
+    std::vector<bool> mAccepting;        // [numStates]
+};
+
+//! @brief Bytes of the tokens of a tokenizer, in a trie shared by the automata of all grammars.
+class TokenVocabulary
+{
+public:
+    using TokenIdType = runtime::TokenIdType;
+    using SizeType32 = runtime::SizeType32;
+
+    //! @param tokens Bytes of every token, indexed by token id. Special tokens are empty and never allowed.
+    //! @param endIds Tokens allowed once the output matches, e.g. EOS.
+    TokenVocabulary(std::vector<std::string> tokens, std::vector<TokenIdType> endIds);
+
+    [[nodiscard]] SizeType32 getVocabSize() const
+    {
+        return static_cast<SizeType32>(mTokens.size());
+    }
+
+    [[nodiscard]] std::string const& getToken(TokenIdType tokenId) const
+    {
+        return mTokens.at(tokenId);
+    }
+
+    [[nodiscard]] std::vector<TokenIdType> const& getEndIds() const
+    {
+        return mEndIds;
+    }
+
+    [[nodiscard]] bool isEndId(TokenIdType tokenId) const;
+
+private:
+    friend class TokenAutomaton;
+
+    struct TrieNode
+    {
+        std::vector<std::pair<std::uint8_t, std::int32_t>> children;
+        std::vector<TokenIdType> tokens;
+    };
+
+    std::vector<std::string> mTokens;
+    std::vector<TokenIdType> mEndIds;
+    std::vector<TrieNode> mTrie;
+};
+
+//! @brief Token level view of a ByteDfa: the tokens allowed in every state, as packed bitmasks.
+//! @details Bit `i % 32` of word `i / 32` is set if token `i` is allowed. The mask of a state is computed on its first
+//! use by walking the vocabulary trie, and cached. Thread safe, requests with the same grammar share one automaton.
+class TokenAutomaton
+{
+public:
+    using StateType = ByteDfa::StateType;
+    using TokenIdType = runtime::TokenIdType;
+    using SizeType32 = runtime::SizeType32;
+    using BitmaskType = std::uint32_t;
+    using Bitmask = std::vector<BitmaskType>;
+
+    static constexpr SizeType32 kBitsPerWord = 32;
+
+    TokenAutomaton(ByteDfa dfa, std::shared_ptr<TokenVocabulary const> vocabulary);
+
+    [[nodiscard]] static StateType constexpr getInitialState()
+    {
+        return ByteDfa::getInitialState();
+    }
+
+    //! @brief State after `tokenId`, kDeadState if the token is not allowed. End ids keep the state.
+    [[nodiscard]] StateType advance(StateType state, TokenIdType tokenId) const;
+
+    //! @brief Tokens allowed in `state`, [getNumWords()].
+    [[nodiscard]] std::shared_ptr<Bitmask const> getMask(StateType state) const;
+
+    [[nodiscard]] bool isAccepting(StateType state) const
+    {
+        return mDfa.isAccepting(state);
+    }
+
+    [[nodiscard]] SizeType32 getNumWords() const
+    {
+        return (mVocabulary->getVocabSize() + kBitsPerWord - 1) / kBitsPerWord;
+    }
+
+    [[nodiscard]] TokenVocabulary const& getVocabulary() const
+    {
+        return *mVocabulary;
+    }
+
+private:
+    [[nodiscard]] Bitmask computeMask(StateType state) const;
+
+    ByteDfa mDfa;
+    std::shared_ptr<TokenVocabulary const> mVocabulary;
+    mutable std::mutex mMutex;
+    mutable std::unordered_map<StateType, std::shared_ptr<Bitmask const>> mMasks;
+};
+
+//! @brief Compiled automata by grammar, so that grammars are compiled once. Least recently used entries are evicted
+//! beyond `capacity`, automata still in use by requests stay alive.
+class TokenAutomatonCache
+{
+public:
+    using SizeType32 = runtime::SizeType32;
+
+    TokenAutomatonCache(std::shared_ptr<TokenVocabulary const> vocabulary, SizeType32 capacity = 64);
+
+    //! @brief Automaton of a regular expression, see ByteDfa::compileRegex.
+    std::shared_ptr<TokenAutomaton const> getRegex(std::string const& pattern);
+
+    [[nodiscard]] SizeType32 getNumEntries() const;
+
+private:
+    using Entry = std::pair<std::string, std::shared_ptr<TokenAutomaton const>>;
+
+    std::shared_ptr<TokenVocabulary const> mVocabulary;
+    SizeType32 mCapacity;
+    mutable std::mutex mMutex;
+    std::list<Entry> mEntries;
+    std::unordered_map<std::string, std::list<Entry>::iterator> mIndex;
+};
+
+} // namespace tensorrt_llm::layers
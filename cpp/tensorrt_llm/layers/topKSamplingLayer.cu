@@ -68,9 +68,10 @@ __global__ void setupTopKRuntimeArgs(SizeType32 batchSize, SizeType32 topK, Size
 }
 
 template <typename T>
-TopKSamplingLayer<T>::TopKSamplingLayer(
-    DecoderDomain const& decoderDomain, cudaStream_t stream, std::shared_ptr<IAllocator> allocator)
+TopKSamplingLayer<T>::TopKSamplingLayer(DecoderDomain const& decoderDomain, cudaStream_t stream,
+    std::shared_ptr<IAllocator> allocator, bool isBatchInvariant)
     : BaseLayer(decoderDomain, stream, std::move(allocator))
+    , mIsBatchInvariant(isBatchInvariant)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
@@ -225,7 +226,7 @@ void TopKSamplingLayer<T>::forwardAsync(
     auto logits = inputs->logits->template getPtr<T>();
     auto endIds = inputs->endIds.template getPtr<TokenIdType const>();
     auto batchSlots = inputs->batchSlots ? inputs->batchSlots->template getPtr<SizeType32 const>() : nullptr;
-    auto curandStatesDevice = inputs->curandStates;
+    auto randomSeedsDevice = inputs->randomSeeds;
     auto samplingWorkspaceDevice = inputs->samplingWorkspace;
     auto const probsComputed = inputs->probsComputed;
 
@@ -238,7 +239,7 @@ void TopKSamplingLayer<T>::forwardAsync(
         return;
     }
 
-    TLLM_CHECK_WITH_INFO(curandStatesDevice, "No curand states provided");
+    TLLM_CHECK_WITH_INFO(randomSeedsDevice, "No random seeds provided");
     TLLM_CHECK_WITH_INFO(samplingWorkspaceDevice, "No sampling workspace provided");
 
     FinishedState* finishedInput = (inputs->finished)
@@ -269,13 +270,14 @@ void TopKSamplingLayer<T>::forwardAsync(
     params.skipDecode = mSkipDecodeDevice;
     params.cumLogProbs = cumLogProbs;
     params.outputLogProbs = outputLogProbs;
-    params.curandState = curandStatesDevice;
+    params.randomSeeds = randomSeedsDevice;
     params.batchSize = batchSize;
     params.maxBatchSize = mDecoderDomain.getBatchSize();
     params.maxTokensPerStep = 1;
     params.vocabSizePadded = mDecoderDomain.getVocabSizePadded();
     params.normalizeLogProbs = mNormalizeLogProbs;
     params.logitsHasProbs = probsComputed;
+    params.batchInvariant = mIsBatchInvariant;
 
     invokeBatchTopKSampling(params, mStream);
     sync_check_cuda_error();
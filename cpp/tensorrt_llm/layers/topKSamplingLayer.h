@@ -26,6 +26,7 @@ namespace tensorrt_llm::layers
 //! \brief Layer to randomly sample tokens from TopK logits.
 //! When both TopK and TopP are specified, layer jointly samples using TopK and TopP.
 //! When no TopK param is specified, sampling is skipped for particular request.
+//! With isBatchInvariant the sampled tokens of a request do not depend on the other requests of the batch.
 template <typename T>
 class TopKSamplingLayer : public BaseLayer
 {
@@ -33,7 +34,7 @@ class TopKSamplingLayer : public BaseLayer
 
 public:
     TopKSamplingLayer(DecoderDomain const& decoderDomain, cudaStream_t stream,
-        std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
+        std::shared_ptr<tensorrt_llm::common::IAllocator> allocator, bool isBatchInvariant = false);
     ~TopKSamplingLayer();
 
     void setup(runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 const* batchSlots,
@@ -48,6 +49,7 @@ public:
 
 protected:
     bool mNormalizeLogProbs{true};
+    bool mIsBatchInvariant{false};
     runtime::SizeType32 mRuntimeMaxTopK{0};
     runtime::SizeType32* mRuntimeTopKDevice{nullptr};
     float* mRuntimeTopPDevice{nullptr};
@@ -65,13 +65,16 @@ static __global__ void setTopPRuntimeArgs(SizeType32 batchSize, SizeType32 topK,
 
 template <typename T>
 TopPSamplingLayer<T>::TopPSamplingLayer(DecoderDomain const& decoderDomain, cudaStream_t stream,
-    std::shared_ptr<IAllocator> allocator, bool isDeterministic, bool isAirTopP)
+    std::shared_ptr<IAllocator> allocator, bool isDeterministic, bool isAirTopP, bool isBatchInvariant)
     : BaseLayer(decoderDomain, stream, std::move(allocator))
     , mIsDeterministic(isDeterministic)
     , mIsAirTopP(isAirTopP)
+    , mIsBatchInvariant(isBatchInvariant)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
+    TLLM_CHECK_WITH_INFO(!mIsBatchInvariant || mIsDeterministic, "Batch invariant TopP sampling must be deterministic");
+
     int deviceId;
     tc::check_cuda_error(cudaGetDevice(&deviceId)); // Get the correct device id
     tc::check_cuda_error(cudaGetDeviceProperties(&mDeviceProp, deviceId));
@@ -282,8 +285,10 @@ void TopPSamplingLayer<T>::setup(SizeType32 const batchSize, SizeType32 const be
             check_cuda_error(cudaGetDeviceProperties(&prop, deviceId));
             smCnt = prop.multiProcessorCount;
         }
-        mAirTopPBlockNum
-            = calcAirTopPBlockNum<T>(batchSize, (int) mDecoderDomain.getVocabSizePadded(), smCnt, mIsDeterministic);
+        // The number of blocks per request decides how the vocab is split, it must not depend on the batch size
+        auto const blockNumBatchSize = mIsBatchInvariant ? mDecoderDomain.getBatchSize() : batchSize;
+        mAirTopPBlockNum = calcAirTopPBlockNum<T>(
+            blockNumBatchSize, (int) mDecoderDomain.getVocabSizePadded(), smCnt, mIsDeterministic);
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -312,10 +317,10 @@ void TopPSamplingLayer<T>::forwardAsync(
     auto probs = inputs->logits->template getPtr<T>();
     auto endIds = inputs->endIds.template getPtr<TokenIdType const>();
     auto batchSlots = inputs->batchSlots ? inputs->batchSlots->template getPtr<SizeType32 const>() : nullptr;
-    auto curandStatesDevice = inputs->curandStates;
+    auto randomSeedsDevice = inputs->randomSeeds;
     auto samplingWorkspaceDevice = inputs->samplingWorkspace;
 
-    TLLM_CHECK_WITH_INFO(curandStatesDevice, "No curand states provided");
+    TLLM_CHECK_WITH_INFO(randomSeedsDevice, "No random seeds provided");
     TLLM_CHECK_WITH_INFO(samplingWorkspaceDevice, "No sampling workspace provided");
 
     FinishedState* finishedInput = (inputs->finished)
@@ -343,7 +348,7 @@ void TopPSamplingLayer<T>::forwardAsync(
     params.skipDecode = mSkipDecodeDevice;
     params.cumLogProbs = cumLogProbs;
     params.outputLogProbs = outputLogProbs;
-    params.curandState = curandStatesDevice;
+    params.randomSeeds = randomSeedsDevice;
     params.batchSize = batchSize;
     params.maxBatchSize = mDecoderDomain.getBatchSize();
     params.vocabSizePadded = mDecoderDomain.getVocabSizePadded();
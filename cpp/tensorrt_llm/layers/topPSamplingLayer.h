@@ -25,6 +25,7 @@ namespace tensorrt_llm::layers
 
 //! \brief Layer to randomly sample tokens from TopP logits.
 //! Layer expects probs precomputed in "logits" tensor
+//! With isBatchInvariant the sampled tokens of a request do not depend on the other requests of the batch.
 template <typename T>
 class TopPSamplingLayer : public BaseLayer
 {
@@ -33,7 +34,7 @@ class TopPSamplingLayer : public BaseLayer
 public:
     TopPSamplingLayer(DecoderDomain const& decoderDomain, cudaStream_t stream,
         std::shared_ptr<tensorrt_llm::common::IAllocator> allocator, bool isDeterministic = true,
-        bool isAirTopP = true);
+        bool isAirTopP = true, bool isBatchInvariant = false);
     ~TopPSamplingLayer();
 
     void setup(runtime::SizeType32 batchSize, runtime::SizeType32 beamWidth, runtime::SizeType32 const* batchSlots,
@@ -63,6 +64,7 @@ protected:
     cudaDeviceProp mDeviceProp;
     bool mIsDeterministic{true};
     bool mIsAirTopP{false};
+    bool mIsBatchInvariant{false};
 
     using Base::mWorkspaceSize;
     using Base::mAllocatedSize;
@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/wordsAutomaton.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <queue>
+
+using namespace tensorrt_llm::common;
+using namespace tensorrt_llm::runtime;
+
+namespace tensorrt_llm::layers
+{
+
+WordsAutomaton::WordsAutomaton(std::vector<std::vector<TokenIdType>> const& words)
+{
+    // Trie of the words, children are ordered by token
+    std::vector<std::map<TokenIdType, StateType>> children(1);
+    std::vector<bool> terminal(1, false);
+    SizeType32 height{0};
+    for (auto const& word : words)
+    {
+        TLLM_CHECK_WITH_INFO(!word.empty(), "Words of an automaton must not be empty");
+        StateType state = Layout::kRootState;
+        for (auto const token : word)
+        {
+            TLLM_CHECK_WITH_INFO(token >= 0, "Invalid token id %d in a word", token);
+            auto const [it, inserted] = children[state].try_emplace(token, static_cast<StateType>(children.size()));
+            if (inserted)
+            {
+                TLLM_CHECK_WITH_INFO(children.size() < static_cast<std::size_t>(std::numeric_limits<StateType>::max()),
+                    "Too many states in the words automaton");
+                children.emplace_back();
+                terminal.push_back(false);
+            }
+            state = it->second;
+        }
+        terminal[state] = true;
+        height = std::max(height, static_cast<SizeType32>(word.size()));
+    }
+
+    auto const numStates = static_cast<StateType>(children.size());
+    std::vector<StateType> fail(numStates, Layout::kRootState);
+    std::vector<SizeType32> match(numStates, 0);
+    std::vector<StateType> banLink(numStates, Layout::kNoState);
+    auto const hasBans = [&](StateType state)
+    {
+        return std::any_of(children[state].begin(), children[state].end(),
+            [&](auto const& child) { return terminal[child.second]; });
+    };
+
+    auto const gotoOrFail = [&](StateType state, TokenIdType token)
+    {
+        while (true)
+        {
+            auto const it = children[state].find(token);
+            if (it != children[state].end())
+            {
+                return it->second;
+            }
+            if (state == Layout::kRootState)
+            {
+                return Layout::kRootState;
+            }
+            state = fail[state];
+        }
+    };
+
+    // Breadth first, the links of a state point to shallower states
+    std::queue<StateType> queue;
+    queue.push(Layout::kRootState);
+    while (!queue.empty())
+    {
+        auto const state = queue.front();
+        queue.pop();
+        for (auto const& [token, child] : children[state])
+        {
+            fail[child] = state == Layout::kRootState ? Layout::kRootState : gotoOrFail(fail[state], token);
+            match[child] = terminal[child] || match[fail[child]] != 0 ? 1 : 0;
+            banLink[child] = hasBans(fail[child]) ? fail[child] : banLink[fail[child]];
+            queue.push(child);
+        }
+    }
+
+    SizeType32 numEdges{0};
+    SizeType32 numBans{0};
+    for (StateType state = 0; state < numStates; ++state)
+    {
+        numEdges += static_cast<SizeType32>(children[state].size());
+        numBans += static_cast<SizeType32>(std::count_if(children[state].begin(), children[state].end(),
+            [&](auto const& child) { return terminal[child.second]; }));
+    }
+
+    mData.assign(Layout::kHeaderSize, 0);
+    mData[Layout::kNumStates] = numStates;
+    mData[Layout::kHeight] = height;
+    SizeType32 size{Layout::kHeaderSize};
+    for (auto const& [header, sectionSize] : {std::pair{Layout::kEdgeOffsetsBegin, numStates + 1},
+             std::pair{Layout::kEdgeTokensBegin, numEdges}, std::pair{Layout::kEdgeTargetsBegin, numEdges},
+             std::pair{Layout::kFailBegin, numStates}, std::pair{Layout::kMatchBegin, numStates},
+             std::pair{Layout::kBanOffsetsBegin, numStates + 1}, std::pair{Layout::kBanTokensBegin, numBans},
+             std::pair{Layout::kBanLinkBegin, numStates}})
+    {
+        mData[header] = size;
+        size += sectionSize;
+    }
+    mData.resize(size, 0);
+    auto const sectionBegin = [this](SizeType32 header) { return mData.begin() + mData[header]; };
+    auto edgeOffsets = sectionBegin(Layout::kEdgeOffsetsBegin);
+    auto edgeTokens = sectionBegin(Layout::kEdgeTokensBegin);
+    auto edgeTargets = sectionBegin(Layout::kEdgeTargetsBegin);
+    std::copy(fail.begin(), fail.end(), sectionBegin(Layout::kFailBegin));
+    std::copy(match.begin(), match.end(), sectionBegin(Layout::kMatchBegin));
+    auto banOffsets = sectionBegin(Layout::kBanOffsetsBegin);
+    auto banTokens = sectionBegin(Layout::kBanTokensBegin);
+    std::copy(banLink.begin(), banLink.end(), sectionBegin(Layout::kBanLinkBegin));
+
+    SizeType32 edgeIdx{0};
+    SizeType32 banIdx{0};
+    for (StateType state = 0; state < numStates; ++state)
+    {
+        edgeOffsets[state] = edgeIdx;
+        banOffsets[state] = banIdx;
+        for (auto const& [token, child] : children[state])
+        {
+            edgeTokens[edgeIdx] = token;
+            edgeTargets[edgeIdx] = child;
+            ++edgeIdx;
+            if (terminal[child])
+            {
+                banTokens[banIdx++] = token;
+            }
+        }
+    }
+    edgeOffsets[numStates] = edgeIdx;
+    banOffsets[numStates] = banIdx;
+}
+
+std::shared_ptr<WordsAutomaton const> WordsAutomaton::fromWordsList(TokenIdType const* wordsList, SizeType32 wordsLen)
+{
+    auto const* offsets = wordsList + wordsLen;
+    std::vector<std::vector<TokenIdType>> words;
+    SizeType32 begin{0};
+    for (SizeType32 wi = 0; wi < wordsLen && offsets[wi] >= 0; ++wi)
+    {
+        TLLM_CHECK_WITH_INFO(begin <= offsets[wi] && offsets[wi] <= wordsLen, "Invalid offset %d of word %d",
+            offsets[wi], wi);
+        if (offsets[wi] > begin)
+        {
+            words.emplace_back(wordsList + begin, wordsList + offsets[wi]);
+        }
+        begin = offsets[wi];
+    }
+    return std::make_shared<WordsAutomaton const>(words);
+}
+
+WordsAutomaton::StateType WordsAutomaton::next(StateType state, TokenIdType token) const
+{
+    auto const* edgeOffsets = mData.data() + section(Layout::kEdgeOffsetsBegin);
+    auto const* edgeTokens = mData.data() + section(Layout::kEdgeTokensBegin);
+    auto const* edgeTargets = mData.data() + section(Layout::kEdgeTargetsBegin);
+    auto const* fail = mData.data() + section(Layout::kFailBegin);
+    while (true)
+    {
+        auto const* begin = edgeTokens + edgeOffsets[state];
+        auto const* end = edgeTokens + edgeOffsets[state + 1];
+        auto const* it = std::lower_bound(begin, end, token);
+        if (it != end && *it == token)
+        {
+            return edgeTargets[it - edgeTokens];
+        }
+        if (state == Layout::kRootState)
+        {
+            return Layout::kRootState;
+        }
+        state = fail[state];
+    }
+}
+
+std::vector<TokenIdType> WordsAutomaton::getBannedTokens(StateType state) const
+{
+    auto const* banOffsets = mData.data() + section(Layout::kBanOffsetsBegin);
+    auto const* banTokens = mData.data() + section(Layout::kBanTokensBegin);
+    auto const* banLink = mData.data() + section(Layout::kBanLinkBegin);
+    std::vector<TokenIdType> banned;
+    for (auto link = banOffsets[state] < banOffsets[state + 1] ? state : banLink[state]; link != Layout::kNoState;
+         link = banLink[link])
+    {
+        banned.insert(banned.end(), banTokens + banOffsets[link], banTokens + banOffsets[link + 1]);
+    }
+    std::sort(banned.begin(), banned.end());
+    banned.erase(std::unique(banned.begin(), banned.end()), banned.end());
+    return banned;
+}
+
+DeviceWordsAutomata::DeviceWordsAutomata(SizeType32 maxBatchSize, std::shared_ptr<IAllocator> allocator)
+    : mMaxBatchSize{maxBatchSize}
+    , mAllocator{std::move(allocator)}
+    , mAutomata(maxBatchSize)
+    , mAutomataDevice(maxBatchSize, nullptr)
+    , mAutomataPtrsHost(maxBatchSize, nullptr)
+    , mHasAutomatonHost{std::make_unique<bool[]>(maxBatchSize)}
+{
+    mAutomataPtrsDevice = mAllocator->reMalloc(mAutomataPtrsDevice, sizeof(SizeType32 const*) * maxBatchSize, true);
+    mHasAutomatonDevice = mAllocator->reMalloc(mHasAutomatonDevice, sizeof(bool) * maxBatchSize, true);
+    mProgressDevice = mAllocator->reMalloc(mProgressDevice, sizeof(SizeType32) * 2 * maxBatchSize, true);
+}
+
+DeviceWordsAutomata::~DeviceWordsAutomata()
+{
+    for (auto& automaton : mAutomataDevice)
+    {
+        if (automaton != nullptr)
+        {
+            mAllocator->free(&automaton);
+        }
+    }
+    mAllocator->free(&mAutomataPtrsDevice);
+    mAllocator->free(&mHasAutomatonDevice);
+    mAllocator->free(&mProgressDevice);
+}
+
+void DeviceWordsAutomata::setup(std::vector<std::shared_ptr<WordsAutomaton const>> const& automata,
+    SizeType32 batchSize, SizeType32 const* batchSlots, cudaStream_t stream)
+{
+    TLLM_CHECK_WITH_INFO(automata.empty() || static_cast<SizeType32>(automata.size()) == batchSize,
+        "Expected %d words automata, got %zu", batchSize, automata.size());
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = batchSlots != nullptr ? batchSlots[bi] : bi;
+        auto automaton = automata.empty() ? nullptr : automata[bi];
+        mNumAutomata += (automaton != nullptr) - (mAutomata[slot] != nullptr);
+        if (automaton != nullptr && automaton != mAutomata[slot])
+        {
+            auto const& data = automaton->getData();
+            mAutomataDevice[slot]
+                = mAllocator->reMalloc(mAutomataDevice[slot], sizeof(SizeType32) * data.size(), false);
+            TLLM_CUDA_CHECK(cudaMemcpyAsync(mAutomataDevice[slot], data.data(), sizeof(SizeType32) * data.size(),
+                cudaMemcpyHostToDevice, stream));
+        }
+        mAutomata[slot] = std::move(automaton);
+        mAutomataPtrsHost[slot] = mAutomata[slot] != nullptr ? mAutomataDevice[slot] : nullptr;
+        mHasAutomatonHost[slot] = mAutomata[slot] != nullptr;
+        TLLM_CUDA_CHECK(cudaMemsetAsync(mProgressDevice + 2 * slot, 0, sizeof(SizeType32) * 2, stream));
+    }
+    cudaAutoCpy(mAutomataPtrsDevice, mAutomataPtrsHost.data(), mMaxBatchSize, stream);
+    cudaAutoCpy(mHasAutomatonDevice, mHasAutomatonHost.get(), mMaxBatchSize, stream);
+}
+
+} // namespace tensorrt_llm::layers
@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/allocator.h"
+#include "tensorrt_llm/kernels/wordsAutomatonLayout.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cuda_runtime.h>
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::layers
+{
+
+//! \brief Aho-Corasick automaton over the token ids of a list of words, e.g. the stop words or bad words of a request.
+//! \details The state after reading a sequence is its longest suffix which is a prefix of a word. Reading a token
+//! follows the failure links until a goto edge is found, which is amortized one transition per token, independently of
+//! the number of words. The automaton is stored in the flat layout of kernels::WordsAutomatonLayout, which is copied to
+//! the device as is. Automata are immutable and can be shared by requests with the same words.
+class WordsAutomaton
+{
+public:
+    using StateType = runtime::SizeType32;
+    using Layout = kernels::WordsAutomatonLayout;
+
+    //! \brief Throws if a word is empty or contains a negative token id.
+    explicit WordsAutomaton(std::vector<std::vector<runtime::TokenIdType>> const& words);
+
+    //! \brief Build the automaton of words in the format of the decoder inputs.
+    //! \param wordsList [2, wordsLen], the token ids of the words followed by the exclusive ends of the words in the
+    //! first row, padded with -1.
+    static std::shared_ptr<WordsAutomaton const> fromWordsList(
+        runtime::TokenIdType const* wordsList, runtime::SizeType32 wordsLen);
+
+    [[nodiscard]] static StateType constexpr getInitialState()
+    {
+        return Layout::kRootState;
+    }
+
+    [[nodiscard]] StateType next(StateType state, runtime::TokenIdType token) const;
+
+    //! \brief Whether a word is a suffix of the sequence read to reach the state.
+    [[nodiscard]] bool isMatch(StateType state) const
+    {
+        return mData[section(Layout::kMatchBegin) + state] != 0;
+    }
+
+    //! \brief Tokens completing a word when read from the state, sorted.
+    [[nodiscard]] std::vector<runtime::TokenIdType> getBannedTokens(StateType state) const;
+
+    [[nodiscard]] StateType getNumStates() const
+    {
+        return mData[Layout::kNumStates];
+    }
+
+    //! \brief Length of the longest word.
+    [[nodiscard]] runtime::SizeType32 getHeight() const
+    {
+        return mData[Layout::kHeight];
+    }
+
+    [[nodiscard]] std::vector<runtime::SizeType32> const& getData() const
+    {
+        return mData;
+    }
+
+private:
+    [[nodiscard]] runtime::SizeType32 section(runtime::SizeType32 begin) const
+    {
+        return mData[begin];
+    }
+
+    std::vector<runtime::SizeType32> mData;
+};
+
+//! \brief Device copies of the automata of the slots of a layer, and the progress of each slot in its automaton.
+//! \details The progress of a slot is its state and the number of tokens of its sequence read so far, [state, length].
+//! Both are reset when the automaton of the slot is set. Beam search is not supported.
+class DeviceWordsAutomata
+{
+public:
+    DeviceWordsAutomata(runtime::SizeType32 maxBatchSize, std::shared_ptr<tensorrt_llm::common::IAllocator> allocator);
+
+    ~DeviceWordsAutomata();
+
+    //! \brief Set the automata of the slots of a setup, nullptr or an empty vector to remove them.
+    //! \param batchSlots Host accessible, nullptr for the identity.
+    void setup(std::vector<std::shared_ptr<WordsAutomaton const>> const& automata, runtime::SizeType32 batchSize,
+        runtime::SizeType32 const* batchSlots, cudaStream_t stream);
+
+    //! \brief Whether any slot has an automaton.
+    [[nodiscard]] bool hasAutomata() const
+    {
+        return mNumAutomata > 0;
+    }
+
+    //! \brief [maxBatchSize], device pointers to the automaton of each slot, nullptr if none.
+    [[nodiscard]] runtime::SizeType32 const* const* getAutomataDevice() const
+    {
+        return mAutomataPtrsDevice;
+    }
+
+    //! \brief [maxBatchSize, 2], progress of each slot in its automaton.
+    [[nodiscard]] runtime::SizeType32* getProgressDevice() const
+    {
+        return mProgressDevice;
+    }
+
+    //! \brief [maxBatchSize], whether the slot has an automaton.
+    [[nodiscard]] bool const* getHasAutomatonDevice() const
+    {
+        return mHasAutomatonDevice;
+    }
+
+private:
+    runtime::SizeType32 mMaxBatchSize;
+    std::shared_ptr<tensorrt_llm::common::IAllocator> mAllocator;
+
+    std::vector<std::shared_ptr<WordsAutomaton const>> mAutomata; // [maxBatchSize]
+    std::vector<runtime::SizeType32*> mAutomataDevice;            // [maxBatchSize]
+    std::vector<runtime::SizeType32 const*> mAutomataPtrsHost;   // [maxBatchSize]
+    std::unique_ptr<bool[]> mHasAutomatonHost;                    // [maxBatchSize]
+    runtime::SizeType32 mNumAutomata{0};
+
+    runtime::SizeType32 const** mAutomataPtrsDevice{nullptr};
+    bool* mHasAutomatonDevice{nullptr};
+    runtime::SizeType32* mProgressDevice{nullptr};
+};
+
+} // namespace tensorrt_llm::layers
@@ -331,17 +331,15 @@ int BertAttentionPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc
                 request_batch_size * mNumHeads,  // global batch size
                 CUDA_R_32F);
 
-            // add relative position bias
-            if (mRelativeAttention)
+            // add relative position bias, the implicit one is added by the softmax kernel
+            if (mRelativeAttention && mMaxDistance == 0)
             {
                 // add rel pos bias
                 // QK is (batch_size, local_head_num, q_length, k_length), rel pos bias is (1, local_head_num,
                 // max_output_len + 1, max_output_len + 1). broadcast along 1st dim. max_seq_len is already
-                // max_output_len + 1. In implicit mode, relative_attention_bias is rel attn table
-                // [num_heads, num_buckets], with necessary params (max_distance, num_buckets) passed at the end
+                // max_output_len + 1.
                 invokeAddRelativeAttentionBiasUnaligned(qk_buf_float_, relative_attn_table, request_batch_size,
-                    mNumHeads, attention_seq_len_1, attention_seq_len_2, stream, mMaxDistance > 0,
-                    inputDesc[3].dims.d[1], mMaxDistance, true /* bidirectional */);
+                    mNumHeads, attention_seq_len_1, attention_seq_len_2, stream);
             }
 
             MaskedSoftmaxParam<T, float> param;
@@ -354,6 +352,14 @@ int BertAttentionPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc
             param.num_heads = mNumHeads;
             param.qk_scale = qk_scale_softmax;
             param.linear_bias_slopes = const_cast<T*>(linear_bias_slopes); // (head_num,), optional
+            if (mRelativeAttention && mMaxDistance > 0)
+            {
+                // In implicit mode, relative_attn_table is the rel attn table [num_heads, num_buckets]
+                param.relative_attention_bias = relative_attn_table;
+                param.relative_attention_bias_stride = inputDesc[3].dims.d[1];
+                param.max_distance = mMaxDistance;
+                param.relative_attention_bidirectional = true;
+            }
             invokeMaskedSoftmax(param, stream);
         }
         else
@@ -364,17 +370,15 @@ int BertAttentionPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc
                 attention_seq_len_2 * attention_seq_len_1, request_batch_size * mNumHeads, qk_scale_gemm,
                 0.0f); // alpha, beta
 
-            // add relative position bias
-            if (mRelativeAttention)
+            // add relative position bias, the implicit one is added by the softmax kernel
+            if (mRelativeAttention && mMaxDistance == 0)
             {
                 // add rel pos bias
                 // QK is (batch_size, local_head_num, q_length, k_length), rel pos bias is (1, local_head_num,
                 // max_output_len + 1, max_output_len + 1). broadcast along 1st dim. max_seq_len is already
-                // max_output_len + 1. In implicit mode, relative_attention_bias is rel attn table
-                // [num_heads, num_buckets], with necessary params (max_distance, num_buckets) passed at the end
+                // max_output_len + 1.
                 invokeAddRelativeAttentionBiasUnaligned(qk_buf_, relative_attn_table, request_batch_size, mNumHeads,
-                    attention_seq_len_1, attention_seq_len_2, stream, mMaxDistance > 0, inputDesc[3].dims.d[1],
-                    mMaxDistance, true /* bidirectional */);
+                    attention_seq_len_1, attention_seq_len_2, stream);
             }
 
             MaskedSoftmaxParam<T, T> param;
@@ -387,6 +391,14 @@ int BertAttentionPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc
             param.num_heads = mNumHeads;
             param.qk_scale = qk_scale_softmax;
             param.linear_bias_slopes = const_cast<T*>(linear_bias_slopes); // (head_num,), optional
+            if (mRelativeAttention && mMaxDistance > 0)
+            {
+                // In implicit mode, relative_attn_table is the rel attn table [num_heads, num_buckets]
+                param.relative_attention_bias = relative_attn_table;
+                param.relative_attention_bias_stride = inputDesc[3].dims.d[1];
+                param.max_distance = mMaxDistance;
+                param.relative_attention_bidirectional = true;
+            }
             invokeMaskedSoftmax(param, stream);
         }
 
@@ -0,0 +1,124 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <cstddef>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// The tactics of the Ms of a GEMM profiled by GemmPluginProfiler split between the ranks of a session. All the ranks
+// deal the same pending Ms round-robin, which spreads the large Ms, and each rank profiles its share. A rank has the
+// same number of slots for its selections as every other rank, so that all the selections are exchanged with a single
+// allgather of bytes, and its unused slots hold kNoM.
+template <typename Config>
+class DistributedTacticSelection
+{
+public:
+    static constexpr int kNoM{-1};
+
+    struct Selection
+    {
+        int m;
+        std::optional<Config> config;
+    };
+
+    static_assert(std::is_trivially_copyable_v<Selection>, "The selected tactics are exchanged as bytes");
+
+    DistributedTacticSelection(std::vector<int> pendingMs, int worldSize, int rank)
+        : mPendingMs(std::move(pendingMs))
+        , mWorldSize(static_cast<std::size_t>(worldSize))
+        , mRank(static_cast<std::size_t>(rank))
+    {
+        TLLM_CHECK_WITH_INFO(worldSize > 0 && rank >= 0 && rank < worldSize, "Invalid rank %d of %d", rank, worldSize);
+        auto const slotsPerRank = (mPendingMs.size() + mWorldSize - 1) / mWorldSize;
+        mLocalSelections.assign(slotsPerRank, Selection{kNoM, std::nullopt});
+        mGatheredSelections.assign(slotsPerRank * mWorldSize, Selection{kNoM, std::nullopt});
+    }
+
+    std::size_t getSlotsPerRank() const
+    {
+        return mLocalSelections.size();
+    }
+
+    // The Ms this rank profiles, in the order of its slots
+    std::vector<int> getLocalMs() const
+    {
+        std::vector<int> ms;
+        for (auto idx = mRank; idx < mPendingMs.size(); idx += mWorldSize)
+        {
+            ms.push_back(mPendingMs[idx]);
+        }
+        return ms;
+    }
+
+    // Stores the tactic profiled for one of the Ms of this rank, none if no tactic runs the GEMM
+    void select(int m, std::optional<Config> const& config)
+    {
+        for (std::size_t slot = 0; slot < mLocalSelections.size(); ++slot)
+        {
+            auto const idx = slot * mWorldSize + mRank;
+            if (idx < mPendingMs.size() && mPendingMs[idx] == m)
+            {
+                mLocalSelections[slot] = Selection{m, config};
+                return;
+            }
+        }
+        TLLM_THROW("M %d is not profiled by rank %zu", m, mRank);
+    }
+
+    // The slots of this rank, sent by the allgather
+    std::vector<Selection> const& getLocalSelections() const
+    {
+        return mLocalSelections;
+    }
+
+    // The slots of all the ranks in rank order, received by the allgather
+    std::vector<Selection>& getGatheredSelections()
+    {
+        return mGatheredSelections;
+    }
+
+    // The gathered selections, without the unused slots
+    std::vector<Selection> getSelections() const
+    {
+        std::vector<Selection> selections;
+        for (auto const& selection : mGatheredSelections)
+        {
+            if (selection.m != kNoM)
+            {
+                selections.push_back(selection);
+            }
+        }
+        return selections;
+    }
+
+private:
+    std::vector<int> mPendingMs;
+    std::size_t mWorldSize;
+    std::size_t mRank;
+    std::vector<Selection> mLocalSelections;
+    std::vector<Selection> mGatheredSelections;
+};
+
+} // namespace tensorrt_llm::plugins
@@ -17,14 +17,59 @@
 
 #include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
 #include "tensorrt_llm/common/cublasMMWrapper.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/fpA_intB_gemm/fpA_intB_gemm.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/fused_gated_gemm/fused_gated_gemm.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/int8_gemm/int8_gemm.h"
+#include "tensorrt_llm/plugins/common/tacticCache.h"
 #include "tensorrt_llm/plugins/mixtureOfExperts/mixtureOfExpertsPlugin.h"
 
+#include <NvInferVersion.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <typeinfo>
+
 namespace tensorrt_llm::plugins
 {
 
+namespace
+{
+// Tactics depend on the GPU SKU, the driver and the libraries
+std::string getTacticCacheDeviceKey()
+{
+    int device{0};
+    common::check_cuda_error(cudaGetDevice(&device));
+    cudaDeviceProp prop{};
+    common::check_cuda_error(cudaGetDeviceProperties(&prop, device));
+    int driverVersion{0};
+    common::check_cuda_error(cudaDriverGetVersion(&driverVersion));
+    std::ostringstream key;
+    key << prop.name << ";sm=" << prop.major << prop.minor << ";smCount=" << prop.multiProcessorCount
+        << ";driver=" << driverVersion << ";cuda=" << CUDART_VERSION << ";trt=" << NV_TENSORRT_MAJOR << "."
+        << NV_TENSORRT_MINOR << "." << NV_TENSORRT_PATCH;
+    return key.str();
+}
+
+// set TLLM_GEMM_TACTIC_CACHE=<path> to persist the selected tactics across processes
+TacticCache* getTacticCache()
+{
+    static std::unique_ptr<TacticCache> const cache = []() -> std::unique_ptr<TacticCache>
+    {
+        auto const* path = std::getenv("TLLM_GEMM_TACTIC_CACHE");
+        if (path == nullptr || *path == '\0')
+        {
+            return nullptr;
+        }
+        TLLM_LOG_INFO("Using GEMM tactic cache %s", path);
+        return std::make_unique<TacticCache>(path, getTacticCacheDeviceKey());
+    }();
+    return cache.get();
+}
+} // namespace
+
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
 GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::GemmPluginProfiler()
 {
@@ -39,12 +84,40 @@ GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::GemmPluginPro
             "SKIP_GEMM_PLUGIN_PROFILINGS is set. Skipping GEMM plugin profilings. It could result in runtime error "
             "if default tactic is not defined.");
     }
+
+    // set TLLM_GEMM_ONLINE_TUNING=1 to tune the tactics of the M between the profiled ones on the live shapes
+    auto const onlineTuningEnv = std::getenv("TLLM_GEMM_ONLINE_TUNING");
+    mOnlineTuning = (onlineTuningEnv != NULL && std::stoi(onlineTuningEnv));
+
+    // set TLLM_GEMM_DISTRIBUTED_PROFILING=1 to split the profiling of the Ms between the ranks of the session. Every
+    // rank must then profile the same GEMMs in the same order, as the ranks of a tensor parallel engine build do.
+    auto const distributedProfilingEnv = std::getenv("TLLM_GEMM_DISTRIBUTED_PROFILING");
+    mDistributedProfiling = (distributedProfilingEnv != NULL && std::stoi(distributedProfilingEnv));
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::~GemmPluginProfiler()
+{
+    saveTacticCache();
+    std::lock_guard<std::mutex> lock(mOnlineMutex);
+    for (auto& [gemmId, buckets] : mOnlineBuckets)
+    {
+        for (auto& [bucketM, bucket] : buckets)
+        {
+            for (auto const& sample : bucket.pending)
+            {
+                cudaEventDestroy(sample.start);
+                cudaEventDestroy(sample.stop);
+            }
+        }
+    }
 }
 
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
 void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::serialize(
     char*& buffer, GemmIdType const& gemmId) const
 {
+    saveTacticCache();
     auto mProfileMap = mMNKProfileMap->getMProfileMap(gemmId);
 
     // Save number of profiles for given GEMM ID
@@ -138,10 +211,22 @@ void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::profileT
     auto mProfileMap = mMNKProfileMap->getMProfileMap(gemmId);
     bool isAllocated{false};
 
-    auto profileTactics = [&mProfileMap, &isAllocated, this](int m, int n, int k)
+    auto* tacticCache = getTacticCache();
+    bool isProfiled{false};
+
+    auto profileTactics = [&mProfileMap, &isAllocated, &isProfiled, tacticCache, &gemmId, this](int m, int n, int k)
     {
         if (mProfileMap->count(m) == 0)
         {
+            auto const cacheKey = tacticCache != nullptr ? getTacticCacheKey(m, gemmId) : std::string{};
+            if (tacticCache != nullptr)
+            {
+                if (auto const cached = tacticCache->findValue<std::optional<Config>>(cacheKey))
+                {
+                    mProfileMap->insert({m, cached.value()});
+                    return;
+                }
+            }
             if (!isAllocated)
             {
                 // Allocate tmp data to run GEMMs
@@ -151,19 +236,61 @@ void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::profileT
             initTmpData(m, n, k, mWorkspaceTmp, mTmpWorkspaceSizeInBytes, mStream);
             const auto tactics = this->getTactics(m, n, k);
             // Profile different tactics for particular m and insert best config to the map
-            mProfileMap->insert({m, this->profileTacticsForProblem(m, n, k, tactics)});
+            auto const bestConfig = this->profileTacticsForProblem(m, n, k, tactics);
+            mProfileMap->insert({m, bestConfig});
+            if (tacticCache != nullptr)
+            {
+                tacticCache->insertValue(cacheKey, bestConfig);
+                isProfiled = true;
+            }
         }
     };
 
     common::check_cuda_error(cudaStreamCreate(&mStream));
 
+    std::vector<int> ms;
     int const startMinMRounded = nextPowerOfTwo(dims.minM);
     for (int m = startMinMRounded; m < maxM; m *= 2)
     {
-        profileTactics(m, dims.n, dims.k);
+        ms.push_back(m);
     }
+    ms.push_back(maxM);
 
-    profileTactics(maxM, dims.n, dims.k);
+    auto const& comm = COMM_SESSION;
+    if (!mDistributedProfiling || comm.getSize() == 1)
+    {
+        for (auto const m : ms)
+        {
+            profileTactics(m, dims.n, dims.k);
+        }
+    }
+    else
+    {
+        // The map is the same on all the ranks, so are the Ms left to profile
+        std::vector<int> pendingMs;
+        std::copy_if(ms.begin(), ms.end(), std::back_inserter(pendingMs),
+            [&mProfileMap](int m) { return mProfileMap->count(m) == 0; });
+        DistributedTacticSelection<Config> selection{std::move(pendingMs), comm.getSize(), comm.getRank()};
+        for (auto const m : selection.getLocalMs())
+        {
+            profileTactics(m, dims.n, dims.k);
+            selection.select(m, mProfileMap->at(m));
+        }
+        if (selection.getSlotsPerRank() > 0)
+        {
+            using Selection = typename DistributedTacticSelection<Config>::Selection;
+            comm.allgather(selection.getLocalSelections().data(), selection.getGatheredSelections().data(),
+                static_cast<int>(selection.getSlotsPerRank() * sizeof(Selection)), mpi::MpiType::kBYTE);
+            for (auto const& [m, config] : selection.getSelections())
+            {
+                if (mProfileMap->insert({m, config}).second && tacticCache != nullptr)
+                {
+                    tacticCache->insertValue(getTacticCacheKey(m, gemmId), config);
+                    isProfiled = true;
+                }
+            }
+        }
+    }
 
     if (isAllocated)
     {
@@ -171,6 +298,29 @@ void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::profileT
         freeTmpData();
     }
     common::check_cuda_error(cudaStreamDestroy(mStream));
+
+    if (isProfiled)
+    {
+        try
+        {
+            tacticCache->save();
+        }
+        catch (std::exception const& e)
+        {
+            TLLM_LOG_WARNING("Cannot save the GEMM tactic cache: %s", e.what());
+        }
+    }
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+std::string GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::getTacticCacheKey(
+    int m, GemmIdType const& gemmId) const
+{
+    // The dynamic type tells profilers sharing the same template arguments apart
+    std::ostringstream key;
+    key << typeid(*this).name() << "|" << getTacticCacheTag() << "|" << gemmId << "|type=" << static_cast<int>(mType)
+        << "|m=" << m;
+    return key.str();
 }
 
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
@@ -189,6 +339,181 @@ std::optional<Config> GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHa
     return mMNKProfileMap->getMProfileMap(gemmId)->at(mRounded);
 }
 
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+int GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::getOnlineBucketM(int m) const
+{
+    return OnlineTacticStats::getBucketM(m, getMaxProfileM());
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::saveTacticCache() const
+{
+    auto* tacticCache = getTacticCache();
+    if (tacticCache == nullptr || !mTacticCacheDirty.exchange(false))
+    {
+        return;
+    }
+    try
+    {
+        tacticCache->save();
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_WARNING("Cannot save the GEMM tactic cache: %s", e.what());
+    }
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+typename GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::OnlineBucket&
+GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::getOnlineBucket(
+    int bucketM, GemmIdType const& gemmId)
+{
+    auto& buckets = mOnlineBuckets[gemmId];
+    auto const iter = buckets.find(bucketM);
+    if (iter != buckets.end())
+    {
+        return iter->second;
+    }
+
+    auto& bucket = buckets[bucketM];
+    {
+        reader_lock lock(mMNKProfileMap->mutex);
+        auto const mProfileMap = mMNKProfileMap->getMProfileMap(gemmId);
+        if (auto const profiled = mProfileMap->find(bucketM); profiled != mProfileMap->end())
+        {
+            // Profiled when building the engine
+            bucket.best = profiled->second;
+            bucket.converged = true;
+            return bucket;
+        }
+        for (auto const& [m, config] : *mProfileMap)
+        {
+            bool const isNew = config.has_value()
+                && std::none_of(bucket.candidates.begin(), bucket.candidates.end(),
+                    [&config](Config const& candidate)
+                    { return std::memcmp(&candidate, &config.value(), sizeof(Config)) == 0; });
+            if (isNew && mDims.isInitialized() && checkTactic(bucketM, mDims.n, mDims.k, config.value()))
+            {
+                bucket.candidates.push_back(config.value());
+            }
+        }
+    }
+    bucket.best = getBestConfig(bucketM, gemmId);
+    if (bucket.candidates.size() < 2)
+    {
+        bucket.converged = true;
+        return bucket;
+    }
+    if (auto* tacticCache = getTacticCache())
+    {
+        if (auto const cached = tacticCache->findValue<std::optional<Config>>(
+                getTacticCacheKey(bucketM, gemmId) + "|online"))
+        {
+            bucket.best = cached.value();
+            bucket.converged = true;
+            return bucket;
+        }
+    }
+    bucket.stats = OnlineTacticStats{bucket.candidates.size()};
+    return bucket;
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::collectOnlineSamples(OnlineBucket& bucket)
+{
+    while (!bucket.pending.empty())
+    {
+        auto const& sample = bucket.pending.front();
+        auto const status = cudaEventQuery(sample.stop);
+        if (status == cudaErrorNotReady)
+        {
+            break;
+        }
+        float elapsed{0.f};
+        if (status == cudaSuccess && cudaEventElapsedTime(&elapsed, sample.start, sample.stop) == cudaSuccess)
+        {
+            bucket.stats.addSample(sample.candidate, elapsed);
+        }
+        else
+        {
+            cudaGetLastError(); // Reset the last cudaError to cudaSuccess.
+        }
+        cudaEventDestroy(sample.start);
+        cudaEventDestroy(sample.stop);
+        bucket.pending.pop_front();
+    }
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+typename GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::OnlineSample
+GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::beginOnlineSample(
+    int m, GemmIdType const& gemmId, cudaStream_t stream)
+{
+    // Samples of a bucket in flight on the stream
+    constexpr int maxPending = 4;
+    constexpr int samplesPerTactic = 8;
+
+    std::lock_guard<std::mutex> lock(mOnlineMutex);
+    int const bucketM = getOnlineBucketM(m);
+    auto& bucket = getOnlineBucket(bucketM, gemmId);
+    if (bucket.converged)
+    {
+        return {bucket.best};
+    }
+
+    collectOnlineSamples(bucket);
+    if (bucket.stats.isConverged(samplesPerTactic))
+    {
+        auto const best = bucket.stats.getBest();
+        bucket.best = bucket.candidates[best];
+        bucket.converged = true;
+        std::ostringstream msg;
+        msg << "Online tuning of GEMM " << gemmId << " for m=" << bucketM << " selected tactic " << best << " of "
+            << bucket.candidates.size();
+        TLLM_LOG_DEBUG(msg.str());
+        if (auto* tacticCache = getTacticCache())
+        {
+            // Saved by saveTacticCache, writing the file here would stall the inference stream
+            tacticCache->insertValue(getTacticCacheKey(bucketM, gemmId) + "|online", bucket.best);
+            mTacticCacheDirty = true;
+        }
+        return {bucket.best};
+    }
+
+    // Events cannot time the replay of a graph, the tactics of captured GEMMs are not sampled
+    cudaStreamCaptureStatus captureStatus{cudaStreamCaptureStatusNone};
+    common::check_cuda_error(cudaStreamIsCapturing(stream, &captureStatus));
+    if (captureStatus != cudaStreamCaptureStatusNone || static_cast<int>(bucket.pending.size()) >= maxPending)
+    {
+        return {bucket.best};
+    }
+
+    std::vector<int> numInFlight(bucket.candidates.size(), 0);
+    for (auto const& sample : bucket.pending)
+    {
+        ++numInFlight[sample.candidate];
+    }
+    auto const candidate = static_cast<int>(bucket.stats.getNextCandidate(numInFlight));
+    OnlineSample sample{bucket.candidates[candidate], bucketM, candidate};
+    common::check_cuda_error(cudaEventCreate(&sample.start));
+    common::check_cuda_error(cudaEventCreate(&sample.stop));
+    common::check_cuda_error(cudaEventRecord(sample.start, stream));
+    return sample;
+}
+
+template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
+void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::endOnlineSample(
+    OnlineSample const& sample, GemmIdType const& gemmId, cudaStream_t stream)
+{
+    if (sample.stop == nullptr)
+    {
+        return;
+    }
+    common::check_cuda_error(cudaEventRecord(sample.stop, stream));
+    std::lock_guard<std::mutex> lock(mOnlineMutex);
+    mOnlineBuckets[gemmId][sample.bucketM].pending.push_back(sample);
+}
+
 template <typename Config, typename RunnerPtr, typename GemmIdType, typename GemmIdHashType>
 void GemmPluginProfiler<Config, RunnerPtr, GemmIdType, GemmIdHashType>::allocateTmpData()
 {
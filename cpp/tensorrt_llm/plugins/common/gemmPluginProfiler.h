@@ -16,18 +16,23 @@
  */
 #pragma once
 
+#include "distributedTacticSelection.h"
+#include "onlineTacticStats.h"
 #include "pluginUtils.h"
 #include "tensorrt_llm/common/logger.h"
 
 #include <cuda_runtime.h>
 
+#include <atomic>
 #include <cstdlib>
+#include <deque>
 #include <iostream>
 #include <memory>
 #include <mutex>
 #include <optional>
 #include <shared_mutex>
 #include <sstream>
+#include <string>
 #include <unordered_map>
 #include <vector>
 
@@ -176,10 +181,10 @@ public:
     using MProfileMap = std::unordered_map<int, std::optional<Config>>;
     using MProfileMapPtr = std::shared_ptr<MProfileMap>;
 
+    // requires shared ownership to read from *this, the profilers of an engine build share the map
+    using reader_lock = std::shared_lock<std::shared_timed_mutex>;
     // requires exclusive ownership to write to *this
-    using reader_lock = std::unique_lock<std::shared_timed_mutex>;
-    // requires shared ownership to read from other
-    using writer_lock = std::shared_lock<std::shared_timed_mutex>;
+    using writer_lock = std::unique_lock<std::shared_timed_mutex>;
 
     // Struct of continuing map if GEMMs to the best profiles for different Ms
     struct MNKProfileMap
@@ -217,6 +222,8 @@ public:
 
     GemmPluginProfiler();
 
+    virtual ~GemmPluginProfiler();
+
     void serialize(char*& buffer, GemmIdType const& gemmId) const;
 
     void deserialize(char const*& data, GemmDims& dims, GemmIdType const& gemmId);
@@ -242,6 +249,21 @@ public:
 
     std::optional<Config> getBestConfig(int m, GemmIdType const& gemmId) const;
 
+    // Calls gemm(std::optional<Config> const&) with the tactic to run on stream for m. With TLLM_GEMM_ONLINE_TUNING=1
+    // the M between the profiled powers of two are tuned on the live shapes, see beginOnlineSample.
+    template <typename Gemm>
+    void runBestConfig(int m, GemmIdType const& gemmId, cudaStream_t stream, Gemm&& gemm)
+    {
+        if (!mOnlineTuning || mSkip)
+        {
+            gemm(getBestConfig(m, gemmId));
+            return;
+        }
+        auto const sample = beginOnlineSample(m, gemmId, stream);
+        gemm(sample.config);
+        endOnlineSample(sample, gemmId, stream);
+    }
+
     virtual int getMaxProfileM() const;
 
 protected:
@@ -258,7 +280,48 @@ protected:
 
     virtual void initTmpData(int m, int n, int k, char* workspace, size_t size, cudaStream_t stream);
 
+    // State of the profiler that changes the selected tactics beyond the GEMM ID, part of the tactic cache key
+    virtual std::string getTacticCacheTag() const
+    {
+        return {};
+    }
+
 private:
+    // A tactic timed on the inference stream, the latency is read back without synchronization on later calls
+    struct OnlineSample
+    {
+        std::optional<Config> config;
+        int bucketM{-1};
+        int candidate{-1};
+        cudaEvent_t start{nullptr};
+        cudaEvent_t stop{nullptr};
+    };
+
+    // Online tuning state of an M bucket between two profiled Ms
+    struct OnlineBucket
+    {
+        // Distinct tactics profiled for the other Ms of the GEMM
+        std::vector<Config> candidates;
+        OnlineTacticStats stats;
+        std::deque<OnlineSample> pending;
+        std::optional<Config> best;
+        bool converged{false};
+    };
+
+    OnlineSample beginOnlineSample(int m, GemmIdType const& gemmId, cudaStream_t stream);
+
+    void endOnlineSample(OnlineSample const& sample, GemmIdType const& gemmId, cudaStream_t stream);
+
+    OnlineBucket& getOnlineBucket(int bucketM, GemmIdType const& gemmId);
+
+    void collectOnlineSamples(OnlineBucket& bucket);
+
+    int getOnlineBucketM(int m) const;
+
+    // Writes the tactics selected online to TLLM_GEMM_TACTIC_CACHE, if any were selected since the last save. Called
+    // when the plugin is serialized or destroyed rather than on the inference path.
+    void saveTacticCache() const;
+
     void allocateTmpData();
 
     void freeTmpData();
@@ -267,6 +330,8 @@ private:
 
     float profileTacticForProblem(int m, int n, int k, Config const& tactic);
 
+    std::string getTacticCacheKey(int m, GemmIdType const& gemmId) const;
+
     int nextPowerOfTwo(int v) const
     {
         --v;
@@ -295,6 +360,17 @@ private:
     GemmDims mDims{};
 
     bool mSkip{false};
+
+    bool mOnlineTuning{false};
+
+    bool mDistributedProfiling{false};
+
+    std::mutex mOnlineMutex;
+
+    // Whether tactics were selected online since the tactic cache was last saved
+    mutable std::atomic<bool> mTacticCacheDirty{false};
+
+    std::unordered_map<GemmIdType, std::unordered_map<int, OnlineBucket>, GemmIdHashType> mOnlineBuckets;
 };
 
 template <typename GemmPluginProfilerType>
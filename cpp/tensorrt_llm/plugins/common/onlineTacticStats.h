@@ -0,0 +1,118 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// Latencies of the candidate tactics of an M bucket tuned online by GemmPluginProfiler. The candidates are sampled in
+// turn and the bucket converges once every candidate has enough samples. Samples complete out of order, so candidates
+// may end up with different numbers of samples and are compared by their mean latency.
+class OnlineTacticStats
+{
+public:
+    explicit OnlineTacticStats(std::size_t numCandidates = 0)
+        : mTotalTimes(numCandidates, 0.f)
+        , mNumSamples(numCandidates, 0)
+    {
+    }
+
+    // Four buckets per power of two up to maxM, e.g. 40 falls into (32, 48]. All M from maxM share one bucket.
+    static int getBucketM(int m, int maxM)
+    {
+        if (m >= maxM)
+        {
+            return maxM;
+        }
+        int power = 1;
+        while (power < m)
+        {
+            power *= 2;
+        }
+        int const step = std::max(power / 4, 1);
+        return (m + step - 1) / step * step;
+    }
+
+    std::size_t size() const
+    {
+        return mNumSamples.size();
+    }
+
+    void addSample(std::size_t candidate, float elapsedMs)
+    {
+        mTotalTimes.at(candidate) += elapsedMs;
+        ++mNumSamples.at(candidate);
+    }
+
+    int getNumSamples(std::size_t candidate) const
+    {
+        return mNumSamples.at(candidate);
+    }
+
+    // The candidate to sample next, the one with the fewest samples counting those in flight, numInFlight[candidate]
+    std::size_t getNextCandidate(std::vector<int> const& numInFlight) const
+    {
+        TLLM_CHECK(numInFlight.size() == size() && size() > 0);
+        std::size_t next = 0;
+        for (std::size_t ii = 1; ii < size(); ++ii)
+        {
+            if (mNumSamples[ii] + numInFlight[ii] < mNumSamples[next] + numInFlight[next])
+            {
+                next = ii;
+            }
+        }
+        return next;
+    }
+
+    bool isConverged(int samplesPerCandidate) const
+    {
+        return !mNumSamples.empty() && *std::min_element(mNumSamples.begin(), mNumSamples.end()) >= samplesPerCandidate;
+    }
+
+    // The candidate with the lowest mean latency, the first one on ties
+    std::size_t getBest() const
+    {
+        TLLM_CHECK(size() > 0);
+        std::size_t best = 0;
+        for (std::size_t ii = 1; ii < size(); ++ii)
+        {
+            if (getMean(ii) < getMean(best))
+            {
+                best = ii;
+            }
+        }
+        return best;
+    }
+
+    float getMean(std::size_t candidate) const
+    {
+        auto const numSamples = mNumSamples.at(candidate);
+        return numSamples > 0 ? mTotalTimes[candidate] / static_cast<float>(numSamples) : 0.f;
+    }
+
+private:
+    std::vector<float> mTotalTimes;
+    std::vector<int> mNumSamples;
+};
+
+} // namespace tensorrt_llm::plugins
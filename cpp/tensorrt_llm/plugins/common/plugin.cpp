@@ -16,15 +16,19 @@
  */
 #include "tensorrt_llm/plugins/common/plugin.h"
 
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/dataType.h"
 #include "tensorrt_llm/common/mpiUtils.h"
 
 #include "checkMacrosPlugin.h"
 #include "cuda.h"
+#include <algorithm>
 #include <cstdint>
 #include <cuda_bf16.h>
 #include <cuda_fp16.h>
 #include <cuda_fp8.h>
 #include <functional>
+#include <iterator>
 #include <mutex>
 
 #ifdef _MSC_VER
@@ -83,7 +87,8 @@ std::shared_ptr<ncclComm_t> getComm(std::set<int> const& group)
 
     ncclUniqueId id = getUniqueId(group);
     auto const rank = COMM_SESSION.getRank();
-    auto const groupRank = rank % group.size();
+    // The groups of the hierarchical allreduce are strided, so the rank in the group is its position in the set
+    auto const groupRank = static_cast<int>(std::distance(group.begin(), group.find(rank)));
     std::shared_ptr<ncclComm_t> ncclComm(new ncclComm_t,
         [](ncclComm_t* comm)
         {
@@ -94,6 +99,61 @@ std::shared_ptr<ncclComm_t> getComm(std::set<int> const& group)
     commMap[group] = ncclComm;
     return ncclComm;
 }
+
+void tensorrt_llm::plugins::hierarchicalAllReduce(void const* input, void* output, size_t size,
+    nvinfer1::DataType type, size_t chunkBytes, ncclComm_t nodeComm, ncclComm_t crossNodeComm, ncclComm_t comm,
+    cudaStream_t stream, cudaStream_t crossNodeStream, cudaEvent_t reduceScattered, cudaEvent_t crossNodeReduced)
+{
+    auto const ncclType = (*getDtypeMap())[type];
+    auto const sizePerElem = tensorrt_llm::common::getDTypeSize(type);
+    int localSizeInt, localRankInt;
+    NCCLCHECK(ncclCommCount(nodeComm, &localSizeInt));
+    NCCLCHECK(ncclCommUserRank(nodeComm, &localRankInt));
+    auto const localSize = static_cast<size_t>(localSizeInt);
+    auto const localRank = static_cast<size_t>(localRankInt);
+    auto const* in = static_cast<char const*>(input);
+    auto* out = static_cast<char*>(output);
+
+    // The reduce-scatter needs a multiple of the node size, the few remaining elements go through a plain allreduce
+    auto const bodySize = size - size % localSize;
+    auto const chunkSize = std::max(localSize, chunkBytes / sizePerElem / localSize * localSize);
+    auto const numChunks = tensorrt_llm::common::ceilDiv(bodySize, chunkSize);
+    auto const shardSize = [&](size_t chunk) { return std::min(chunkSize, bodySize - chunk * chunkSize) / localSize; };
+    auto const shardPtr
+        = [&](size_t chunk) { return out + (chunk * chunkSize + localRank * shardSize(chunk)) * sizePerElem; };
+
+    // Each rank reduces its shard of a chunk within the node, allreduces the shard with the ranks of the same local
+    // rank on the other nodes and gathers the shards back within the node. The inter-node allreduce of chunk i runs on
+    // the side stream while the main stream gathers chunk i - 1 and reduce-scatters chunk i + 1.
+    for (size_t step = 0; step <= numChunks; ++step)
+    {
+        if (step < numChunks)
+        {
+            NCCLCHECK(ncclReduceScatter(in + step * chunkSize * sizePerElem, shardPtr(step), shardSize(step),
+                ncclType, ncclSum, nodeComm, stream));
+            TLLM_CUDA_CHECK(cudaEventRecord(reduceScattered, stream));
+        }
+        if (step > 0)
+        {
+            TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, crossNodeReduced));
+            NCCLCHECK(ncclAllGather(shardPtr(step - 1), out + (step - 1) * chunkSize * sizePerElem,
+                shardSize(step - 1), ncclType, nodeComm, stream));
+        }
+        if (step < numChunks)
+        {
+            TLLM_CUDA_CHECK(cudaStreamWaitEvent(crossNodeStream, reduceScattered));
+            NCCLCHECK(ncclAllReduce(
+                shardPtr(step), shardPtr(step), shardSize(step), ncclType, ncclSum, crossNodeComm, crossNodeStream));
+            TLLM_CUDA_CHECK(cudaEventRecord(crossNodeReduced, crossNodeStream));
+        }
+    }
+
+    if (bodySize < size)
+    {
+        NCCLCHECK(ncclAllReduce(in + bodySize * sizePerElem, out + bodySize * sizePerElem, size - bodySize, ncclType,
+            ncclSum, comm, stream));
+    }
+}
 #endif // ENABLE_MULTI_DEVICE
 
 void* tensorrt_llm::plugins::getCommSessionHandle()
@@ -173,6 +173,16 @@ std::unordered_map<nvinfer1::DataType, ncclDataType_t>* getDtypeMap();
 
 std::shared_ptr<ncclComm_t> getComm(std::set<int> const& group);
 
+namespace tensorrt_llm::plugins
+{
+//! Allreduce of `size` elements over the ranks of nodeComm and crossNodeComm. Each chunk of chunkBytes is
+//! reduce-scattered within the node, the shards are allreduced across nodes on crossNodeStream and gathered back
+//! within the node. The elements past a multiple of the node size are allreduced over comm, the whole group.
+void hierarchicalAllReduce(void const* input, void* output, size_t size, nvinfer1::DataType type, size_t chunkBytes,
+    ncclComm_t nodeComm, ncclComm_t crossNodeComm, ncclComm_t comm, cudaStream_t stream, cudaStream_t crossNodeStream,
+    cudaEvent_t reduceScattered, cudaEvent_t crossNodeReduced);
+} // namespace tensorrt_llm::plugins
+
 #endif // ENABLE_MULTI_DEVICE
 
 //! To save GPU memory, all the plugins share the same cublas and cublasLt handle globally.
@@ -0,0 +1,207 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2023 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// Persistent cache of the tactics selected by the GEMM plugin profilers.
+// The file starts with a version and a device key, e.g. GPU SKU and driver version. A file written for another
+// version or device is ignored and overwritten on save, so that every process on one device picks identical tactics.
+class TacticCache
+{
+public:
+    static constexpr std::uint32_t kVersion = 1;
+
+    TacticCache(std::filesystem::path path, std::string deviceKey)
+        : mPath{std::move(path)}
+        , mDeviceKey{std::move(deviceKey)}
+    {
+        load();
+    }
+
+    std::optional<std::vector<std::uint8_t>> find(std::string const& key) const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const iter = mEntries.find(key);
+        if (iter == mEntries.end())
+        {
+            return std::nullopt;
+        }
+        return iter->second;
+    }
+
+    // Values are stored as their bytes, like the tactics serialized into the engine, T must be trivially copyable.
+    template <typename T>
+    std::optional<T> findValue(std::string const& key) const
+    {
+        auto const bytes = find(key);
+        if (!bytes.has_value() || bytes->size() != sizeof(T))
+        {
+            return std::nullopt;
+        }
+        T value;
+        std::memcpy(&value, bytes->data(), sizeof(T));
+        return value;
+    }
+
+    void insert(std::string const& key, std::vector<std::uint8_t> value)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mEntries.insert_or_assign(key, std::move(value));
+        mDirty = true;
+    }
+
+    template <typename T>
+    void insertValue(std::string const& key, T const& value)
+    {
+        auto const* bytes = reinterpret_cast<std::uint8_t const*>(&value);
+        insert(key, std::vector<std::uint8_t>(bytes, bytes + sizeof(T)));
+    }
+
+    // Write the cache if it changed. The file is replaced atomically, readers never see a partial file.
+    void save()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mDirty)
+        {
+            return;
+        }
+        auto tmpPath = mPath;
+        tmpPath += ".tmp" + std::to_string(reinterpret_cast<std::uintptr_t>(this));
+        {
+            std::ofstream file{tmpPath, std::ios::binary};
+            TLLM_CHECK_WITH_INFO(file.good(), "Error opening tactic cache %s", tmpPath.string().c_str());
+            file.write(kMagic.data(), kMagic.size());
+            writeValue(file, kVersion);
+            writeString(file, mDeviceKey);
+            writeValue(file, static_cast<std::uint64_t>(mEntries.size()));
+            for (auto const& [key, value] : mEntries)
+            {
+                writeString(file, key);
+                writeValue(file, static_cast<std::uint32_t>(value.size()));
+                file.write(reinterpret_cast<char const*>(value.data()), static_cast<std::streamsize>(value.size()));
+            }
+            TLLM_CHECK_WITH_INFO(file.good(), "Error writing tactic cache %s", tmpPath.string().c_str());
+        }
+        std::filesystem::rename(tmpPath, mPath);
+        mDirty = false;
+    }
+
+    std::size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mEntries.size();
+    }
+
+private:
+    static constexpr std::array<char, 8> kMagic{'T', 'L', 'L', 'M', 'T', 'A', 'C', 0};
+    // Keys and tactics are small, a larger size means the file is corrupted
+    static constexpr std::uint32_t kMaxEntrySize = 1 << 16;
+
+    void load()
+    {
+        std::ifstream file{mPath, std::ios::binary};
+        if (!file.good())
+        {
+            return;
+        }
+        std::array<char, kMagic.size()> magic{};
+        file.read(magic.data(), magic.size());
+        std::uint32_t version{0};
+        std::string deviceKey;
+        if (!file.good() || magic != kMagic || !readValue(file, version) || version != kVersion
+            || !readString(file, deviceKey) || deviceKey != mDeviceKey)
+        {
+            TLLM_LOG_WARNING("Ignoring tactic cache %s written by another version or for another device",
+                mPath.string().c_str());
+            return;
+        }
+        std::uint64_t numEntries{0};
+        decltype(mEntries) entries;
+        bool ok = readValue(file, numEntries);
+        for (std::uint64_t i = 0; ok && i < numEntries; ++i)
+        {
+            std::string key;
+            std::uint32_t valueSize{0};
+            ok = readString(file, key) && readValue(file, valueSize) && valueSize <= kMaxEntrySize;
+            std::vector<std::uint8_t> value(ok ? valueSize : 0);
+            ok = ok && file.read(reinterpret_cast<char*>(value.data()), valueSize).good();
+            if (ok)
+            {
+                entries.insert_or_assign(std::move(key), std::move(value));
+            }
+        }
+        if (!ok)
+        {
+            TLLM_LOG_WARNING("Ignoring truncated tactic cache %s", mPath.string().c_str());
+            return;
+        }
+        mEntries = std::move(entries);
+    }
+
+    template <typename T>
+    static void writeValue(std::ofstream& file, T const& value)
+    {
+        file.write(reinterpret_cast<char const*>(&value), sizeof(T));
+    }
+
+    static void writeString(std::ofstream& file, std::string const& value)
+    {
+        writeValue(file, static_cast<std::uint32_t>(value.size()));
+        file.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    template <typename T>
+    static bool readValue(std::ifstream& file, T& value)
+    {
+        return file.read(reinterpret_cast<char*>(&value), sizeof(T)).good();
+    }
+
+    static bool readString(std::ifstream& file, std::string& value)
+    {
+        std::uint32_t size{0};
+        if (!readValue(file, size) || size > kMaxEntrySize)
+        {
+            return false;
+        }
+        value.resize(size);
+        return file.read(value.data(), size).good();
+    }
+
+    std::filesystem::path const mPath;
+    std::string const mDeviceKey;
+    mutable std::mutex mMutex;
+    std::unordered_map<std::string, std::vector<std::uint8_t>> mEntries;
+    bool mDirty{false};
+};
+
+} // namespace tensorrt_llm::plugins
@@ -0,0 +1,163 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2023 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/plugins/common/weightStreamer.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <map>
+#include <memory>
+
+namespace tensorrt_llm::plugins
+{
+
+WeightStreamer::ScopedWeights::ScopedWeights(
+    void const* weights, nvinfer1::PluginTensorDesc const& desc, cudaStream_t stream)
+    : mWeights{weights}
+    , mStaged{weights}
+    , mStream{stream}
+{
+    if (!common::getEnvPluginWeightStreaming())
+    {
+        return;
+    }
+    auto& streamer = WeightStreamer::getInstance();
+    if (!streamer.isHostMemory(weights))
+    {
+        return;
+    }
+    std::size_t size = common::getDTypeSize(desc.type);
+    for (int i = 0; i < desc.dims.nbDims; ++i)
+    {
+        size *= desc.dims.d[i];
+    }
+    mStaged = streamer.acquire(weights, size, stream);
+    mStreamer = &streamer;
+}
+
+WeightStreamer::ScopedWeights::~ScopedWeights()
+{
+    if (mStreamer != nullptr)
+    {
+        mStreamer->release(mWeights, mStream);
+    }
+}
+
+WeightStreamer& WeightStreamer::getInstance()
+{
+    static std::mutex mutex;
+    static std::map<int, std::unique_ptr<WeightStreamer>> streamers;
+    auto const device = common::getDevice();
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& streamer = streamers[device];
+    if (!streamer)
+    {
+        streamer.reset(new WeightStreamer());
+    }
+    return *streamer;
+}
+
+WeightStreamer::WeightStreamer()
+{
+    TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mCopyStream, cudaStreamNonBlocking));
+    for (auto& buffer : mBuffers)
+    {
+        TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&buffer.copied, cudaEventDisableTiming));
+        TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&buffer.consumed, cudaEventDisableTiming));
+    }
+}
+
+WeightStreamer::~WeightStreamer()
+{
+    TLLM_CUDA_CHECK_FREE_RESOURCE(cudaStreamSynchronize(mCopyStream));
+    for (auto& buffer : mBuffers)
+    {
+        TLLM_CUDA_CHECK_FREE_RESOURCE(cudaEventSynchronize(buffer.consumed));
+        TLLM_CUDA_CHECK_FREE_RESOURCE(cudaFree(buffer.data));
+        TLLM_CUDA_CHECK_FREE_RESOURCE(cudaEventDestroy(buffer.copied));
+        TLLM_CUDA_CHECK_FREE_RESOURCE(cudaEventDestroy(buffer.consumed));
+    }
+    TLLM_CUDA_CHECK_FREE_RESOURCE(cudaStreamDestroy(mCopyStream));
+}
+
+bool WeightStreamer::isHostMemory(void const* ptr)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto it = mHostMemory.find(ptr);
+    if (it == mHostMemory.end())
+    {
+        cudaPointerAttributes attributes{};
+        TLLM_CUDA_CHECK(cudaPointerGetAttributes(&attributes, ptr));
+        it = mHostMemory.emplace(ptr, attributes.type == cudaMemoryTypeHost).first;
+    }
+    return it->second;
+}
+
+void WeightStreamer::stage(WeightStreamingSchedule::Staging const& staging)
+{
+    auto& buffer = mBuffers[staging.buffer];
+    auto const& weights = mSchedule.getLayer(staging.layer);
+    if (buffer.capacity < weights.size)
+    {
+        // Only while the layers are learnt, wait for the users of the old buffer
+        TLLM_CUDA_CHECK(cudaEventSynchronize(buffer.consumed));
+        TLLM_CUDA_CHECK(cudaStreamSynchronize(mCopyStream));
+        TLLM_CUDA_CHECK(cudaFree(buffer.data));
+        TLLM_CUDA_CHECK(cudaMalloc(&buffer.data, weights.size));
+        buffer.capacity = weights.size;
+    }
+    // The previous weights of the buffer may still be read by the compute stream
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(mCopyStream, buffer.consumed));
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(buffer.data, weights.weights, weights.size, cudaMemcpyHostToDevice, mCopyStream));
+    TLLM_CUDA_CHECK(cudaEventRecord(buffer.copied, mCopyStream));
+}
+
+void const* WeightStreamer::acquire(void const* weights, std::size_t size, cudaStream_t stream)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const numLayers = mSchedule.getNumLayers();
+    // Prefetched by the previous GEMM, otherwise staged now, in the buffer not used by the previous GEMM
+    auto const acquired = mSchedule.acquire(weights, size);
+    if (mSchedule.getNumLayers() > numLayers)
+    {
+        TLLM_LOG_DEBUG("Streaming %zu B of weights at %p as layer %d", size, weights, acquired.layer);
+    }
+    if (acquired.staging)
+    {
+        stage(*acquired.staging);
+    }
+    auto& buffer = mBuffers[acquired.buffer];
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, buffer.copied));
+    return buffer.data;
+}
+
+void WeightStreamer::release(void const* weights, cudaStream_t stream)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Prefetch the weights of the next GEMM while this one runs
+    auto const prefetch = mSchedule.release(weights);
+    TLLM_CUDA_CHECK(cudaEventRecord(mBuffers[mSchedule.getCurrentBuffer()].consumed, stream));
+    if (prefetch)
+    {
+        stage(*prefetch);
+    }
+}
+
+} // namespace tensorrt_llm::plugins
@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2023 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/plugins/common/weightStreamingSchedule.h"
+
+#include <NvInferRuntime.h>
+#include <cuda_runtime_api.h>
+
+#include <array>
+#include <cstddef>
+#include <mutex>
+#include <unordered_map>
+
+namespace tensorrt_llm::plugins
+{
+
+// Stages the weights of GEMM plugins that reside in host memory, e.g. pinned buffers bound to weight inputs of the
+// engine, into one of two device staging buffers before the GEMM runs, and prefetches the weights of the next GEMM
+// into the other buffer on a copy stream while it runs. The order of the GEMMs is learnt from the first pass over the
+// layers, the last GEMM prefetches the weights of the first one for the next step, see WeightStreamingSchedule.
+// Weights in device memory are used in place. Enabled with TRTLLM_PLUGIN_WEIGHT_STREAMING, there is one streamer per
+// device.
+class WeightStreamer
+{
+public:
+    // The weights of one GEMM, usable by kernels enqueued on `stream` during the lifetime of the object.
+    class ScopedWeights
+    {
+    public:
+        ScopedWeights(void const* weights, nvinfer1::PluginTensorDesc const& desc, cudaStream_t stream);
+
+        ~ScopedWeights();
+
+        ScopedWeights(ScopedWeights const&) = delete;
+        ScopedWeights& operator=(ScopedWeights const&) = delete;
+
+        void const* get() const
+        {
+            return mStaged;
+        }
+
+    private:
+        WeightStreamer* mStreamer{nullptr};
+        void const* mWeights;
+        void const* mStaged;
+        cudaStream_t mStream;
+    };
+
+    static WeightStreamer& getInstance();
+
+    ~WeightStreamer();
+
+    WeightStreamer(WeightStreamer const&) = delete;
+    WeightStreamer& operator=(WeightStreamer const&) = delete;
+
+    // Device copy of `weights` for kernels enqueued on `stream`, or `weights` itself if they are in device memory.
+    void const* acquire(void const* weights, std::size_t size, cudaStream_t stream);
+
+    // The kernels using the weights are enqueued on `stream`, the buffer may be reused once they complete.
+    void release(void const* weights, cudaStream_t stream);
+
+    bool isHostMemory(void const* ptr);
+
+private:
+    struct StagingBuffer
+    {
+        void* data{nullptr};
+        std::size_t capacity{0};
+        // Recorded on the copy stream after the weights are copied
+        cudaEvent_t copied{nullptr};
+        // Recorded on the compute stream after the last kernel using the weights
+        cudaEvent_t consumed{nullptr};
+    };
+
+    WeightStreamer();
+
+    void stage(WeightStreamingSchedule::Staging const& staging);
+
+    std::mutex mMutex;
+    cudaStream_t mCopyStream{nullptr};
+    std::array<StagingBuffer, WeightStreamingSchedule::kNumBuffers> mBuffers;
+    WeightStreamingSchedule mSchedule;
+    std::unordered_map<void const*, bool> mHostMemory;
+};
+
+} // namespace tensorrt_llm::plugins
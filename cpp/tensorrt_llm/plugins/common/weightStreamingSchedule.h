@@ -0,0 +1,131 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// Which of the two staging buffers of WeightStreamer holds the weights of which GEMM, without the copies themselves.
+// The GEMMs alternate between the buffers, and while a GEMM runs the weights of the next GEMM in the order learnt from
+// the first pass are prefetched into the other buffer. The last GEMM prefetches the first one for the next step.
+class WeightStreamingSchedule
+{
+public:
+    static constexpr int kNoLayer{-1};
+    static constexpr std::size_t kNumBuffers{2};
+
+    struct Layer
+    {
+        void const* weights;
+        std::size_t size;
+    };
+
+    // Weights of `layer` to copy into staging buffer `buffer`
+    struct Staging
+    {
+        std::size_t buffer;
+        int layer;
+    };
+
+    // The buffer of the weights of the GEMM about to run, `staging` is set if they weren't prefetched
+    struct Acquired
+    {
+        std::size_t buffer;
+        int layer;
+        std::optional<Staging> staging;
+    };
+
+    // Takes the buffer not used by the previous GEMM for `weights`, new weights become the next layer
+    Acquired acquire(void const* weights, std::size_t size)
+    {
+        auto const layer = getLayer(weights, size);
+        mCurrentBuffer ^= 1;
+        Acquired acquired{mCurrentBuffer, layer, std::nullopt};
+        if (mBufferLayers[mCurrentBuffer] != layer)
+        {
+            mBufferLayers[mCurrentBuffer] = layer;
+            acquired.staging = Staging{mCurrentBuffer, layer};
+        }
+        return acquired;
+    }
+
+    // The GEMM of `weights`, acquired last, is enqueued. Returns the prefetch of the next layer into the other buffer,
+    // none if there is a single layer or the next layer is already there.
+    std::optional<Staging> release(void const* weights)
+    {
+        auto const layer = mBufferLayers[mCurrentBuffer];
+        TLLM_CHECK_WITH_INFO(layer != kNoLayer && mLayers[layer].weights == weights,
+            "The weights at %p are not the weights staged last", weights);
+        auto const next = (layer + 1) % static_cast<int>(mLayers.size());
+        auto const nextBuffer = mCurrentBuffer ^ 1;
+        if (next == layer || mBufferLayers[nextBuffer] == next)
+        {
+            return std::nullopt;
+        }
+        mBufferLayers[nextBuffer] = next;
+        return Staging{nextBuffer, next};
+    }
+
+    Layer const& getLayer(int layer) const
+    {
+        return mLayers.at(layer);
+    }
+
+    int getNumLayers() const
+    {
+        return static_cast<int>(mLayers.size());
+    }
+
+    // Buffer of the GEMM acquired last
+    std::size_t getCurrentBuffer() const
+    {
+        return mCurrentBuffer;
+    }
+
+    // Layer whose weights are or are being copied into `buffer`
+    int getBufferLayer(std::size_t buffer) const
+    {
+        return mBufferLayers.at(buffer);
+    }
+
+private:
+    int getLayer(void const* weights, std::size_t size)
+    {
+        auto const [it, inserted] = mLayerIndices.try_emplace(weights, static_cast<int>(mLayers.size()));
+        if (inserted)
+        {
+            mLayers.push_back({weights, size});
+        }
+        return it->second;
+    }
+
+    std::array<int, kNumBuffers> mBufferLayers{kNoLayer, kNoLayer};
+    // The first GEMM takes buffer 0
+    std::size_t mCurrentBuffer{1};
+    std::vector<Layer> mLayers;
+    std::unordered_map<void const*, int> mLayerIndices;
+};
+
+} // namespace tensorrt_llm::plugins
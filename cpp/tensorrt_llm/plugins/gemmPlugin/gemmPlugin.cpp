@@ -21,6 +21,7 @@
 #include "plugin.h"
 #include "pluginUtils.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/fp8Gemm.h"
+#include "tensorrt_llm/plugins/common/weightStreamer.h"
 #include "tensorrt_llm/runtime/utils/debugUtils.h"
 
 #include <NvInferRuntime.h>
@@ -34,6 +35,7 @@ using tensorrt_llm::plugins::GemmPluginCreator;
 using tensorrt_llm::plugins::GemmPlugin;
 using tensorrt_llm::plugins::CublasLtGemmPluginProfiler;
 using tensorrt_llm::plugins::CublasGemmWrapperPtr;
+using tensorrt_llm::plugins::WeightStreamer;
 using tensorrt_llm::plugins::read;
 using tensorrt_llm::plugins::write;
 
@@ -377,29 +379,28 @@ int GemmPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
             "Found NaN in " + activationStr);
     }
 
+    WeightStreamer::ScopedWeights const weights{inputs[1], inputDesc[1], stream};
     bool cudaKernelFinished = false;
     // TODO: sub tensor matmul is not supported in fp8 gemm cuda kernel
     if (M <= 4 && N <= 128000 && mUseFp8 && noPadDim && cudaKernelSupportType)
     {
         tensorrt_llm::common::QuantMode quantMode = tensorrt_llm::common::QuantMode::fromQuantAlgo("FP8");
-        tensorrt_llm::kernels::fp8_gemm::Params params(reinterpret_cast<void const*>(inputs[0]),
-            reinterpret_cast<void const*>(inputs[1]), mAlpha, reinterpret_cast<void*>(outputs[0]), M, N, K, quantMode,
-            nvinfer1::DataType::kFP8, mOutputType);
+        tensorrt_llm::kernels::fp8_gemm::Params params(reinterpret_cast<void const*>(inputs[0]), weights.get(), mAlpha,
+            reinterpret_cast<void*>(outputs[0]), M, N, K, quantMode, nvinfer1::DataType::kFP8, mOutputType);
         cudaKernelFinished = tensorrt_llm::kernels::fp8_gemm::fp8GemmDispatcher(params, stream);
     }
     else if (M <= 6 && N <= 128000 && !mUseFp8 && noPadDim && cudaKernelSupportType)
     {
         tensorrt_llm::common::QuantMode quantMode;
-        tensorrt_llm::kernels::fp8_gemm::Params params(reinterpret_cast<void const*>(inputs[0]),
-            reinterpret_cast<void const*>(inputs[1]), mAlpha, reinterpret_cast<void*>(outputs[0]), M, N, K, quantMode,
-            mType, mOutputType);
+        tensorrt_llm::kernels::fp8_gemm::Params params(reinterpret_cast<void const*>(inputs[0]), weights.get(), mAlpha,
+            reinterpret_cast<void*>(outputs[0]), M, N, K, quantMode, mType, mOutputType);
         cudaKernelFinished = tensorrt_llm::kernels::fp8_gemm::fp8GemmDispatcher(params, stream);
     }
 
     if (!cudaKernelFinished)
     {
         auto bestTactic = mPluginProfiler->getBestConfig(M, mGemmId);
-        runGemm(M, N, K, mTransA, mTransB, mPadLda, mPadLdb, mType, mCublasWrapper, inputs[0], inputs[1], mAlpha,
+        runGemm(M, N, K, mTransA, mTransB, mPadLda, mPadLdb, mType, mCublasWrapper, inputs[0], weights.get(), mAlpha,
             outputs[0], bestTactic, workspace, stream);
     }
 
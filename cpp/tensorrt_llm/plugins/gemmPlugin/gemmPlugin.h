@@ -62,6 +62,11 @@ protected:
 
     std::vector<Config> getTactics(int m, int n, int k) const override;
 
+    std::string getTacticCacheTag() const override
+    {
+        return "padLd=" + std::to_string(mPadLda) + ";" + std::to_string(mPadLdb);
+    }
+
 private:
     bool mTransA;
     bool mTransB;
@@ -106,12 +106,14 @@ std::vector<GemmSwigluPluginProfiler::Config> GemmSwigluPluginProfiler::getTacti
 }
 
 GemmSwigluPlugin::GemmSwigluPlugin(QuantMode quantMode, nvinfer1::DataType type, bool hasBias, float scale_d0,
-    float scale_d1, float scale_output, GemmSwigluPlugin::PluginProfilerPtr const& pluginProfiler)
+    float scale_d1, float scale_output, GemmSwigluPlugin::PluginProfilerPtr const& pluginProfiler,
+    GatedActivationType activation)
     : mQuantMode(quantMode)
     , mHasBias(hasBias)
     , mScaleD0(scale_d0)
     , mScaleD1(scale_d1)
     , mScaleOutput(scale_output)
+    , mActivation(activation)
     , mPluginProfiler(pluginProfiler)
 {
     init(type);
@@ -131,6 +133,7 @@ GemmSwigluPlugin::GemmSwigluPlugin(
     read(d, mScaleD0);
     read(d, mScaleD1);
     read(d, mScaleOutput);
+    read(d, mActivation);
     read(d, mDims);
 
     mQuantMode = QuantMode(quantMode);
@@ -147,7 +150,7 @@ void GemmSwigluPlugin::init(nvinfer1::DataType type)
     mType = type;
     if (mType == nvinfer1::DataType::kFP8)
     {
-        mGemmRunner = std::make_shared<CutlassFusedGatedGemmRunner<__nv_fp8_e4m3>>();
+        mGemmRunner = std::make_shared<CutlassFusedGatedGemmRunner<__nv_fp8_e4m3>>(mActivation);
     }
     else
     {
@@ -262,10 +265,13 @@ int GemmSwigluPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinf
     int const k = inputDesc[0].dims.d[inputDesc[0].dims.nbDims - 1];
     size_t const wsSize = mGemmRunner->getWorkspaceSize(m, n, k);
 
-    auto const bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
-    TLLM_CHECK_WITH_INFO(bestTactic, "No valid GEMM tactic");
-    mGemmRunner->gemm(outputs[0], inputs[0], inputs[1], inputs[2], mQuantMode, m, n, k, mScaleD0, mScaleD1,
-        mScaleOutput, *bestTactic, reinterpret_cast<char*>(workspace), wsSize, stream);
+    mPluginProfiler->runBestConfig(m, mGemmId, stream,
+        [&](auto const& bestTactic)
+        {
+            TLLM_CHECK_WITH_INFO(bestTactic, "No valid GEMM tactic");
+            mGemmRunner->gemm(outputs[0], inputs[0], inputs[1], inputs[2], mQuantMode, m, n, k, mScaleD0, mScaleD1,
+                mScaleOutput, *bestTactic, reinterpret_cast<char*>(workspace), wsSize, stream);
+        });
 
     return 0;
 }
@@ -309,6 +315,7 @@ size_t GemmSwigluPlugin::getSerializationSize() const noexcept
         sizeof(nvinfer1::DataType) +                    // dtype
         sizeof(bool) +                                  // hasBias
         sizeof(float) * 3 +                             // scales
+        sizeof(GatedActivationType) +                   // activation
         sizeof(mDims) +                                 // Dimensions
         mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
 }
@@ -322,6 +329,7 @@ void GemmSwigluPlugin::serialize(void* buffer) const noexcept
     write(d, mScaleD0);
     write(d, mScaleD1);
     write(d, mScaleOutput);
+    write(d, mActivation);
     write(d, mDims);
 
     mPluginProfiler->serialize(d, mGemmId);
@@ -350,6 +358,7 @@ GemmSwigluPluginCreator::GemmSwigluPluginCreator()
     mPluginAttributes.emplace_back(PluginField("scale_d0", nullptr, PluginFieldType::kFLOAT32, 1.0));
     mPluginAttributes.emplace_back(PluginField("scale_d1", nullptr, PluginFieldType::kFLOAT32, 1.0));
     mPluginAttributes.emplace_back(PluginField("scale_output", nullptr, PluginFieldType::kFLOAT32, 1.0));
+    mPluginAttributes.emplace_back(PluginField("activation", nullptr, PluginFieldType::kINT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -372,12 +381,14 @@ PluginFieldCollection const* GemmSwigluPluginCreator::getFieldNames() noexcept
 IPluginV2* GemmSwigluPluginCreator::createPlugin(char const* name, PluginFieldCollection const* fc) noexcept
 {
     PluginField const* fields = fc->fields;
-    TLLM_CHECK(fc->nbFields == 5);
+    // The activation is optional, SwiGLU by default
+    TLLM_CHECK(fc->nbFields == 5 || fc->nbFields == 6);
     nvinfer1::DataType type;
     bool hasBias;
     float scale_d0;
     float scale_d1;
     float scale_output;
+    auto activation = GatedActivationType::kSilu;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -407,6 +418,14 @@ IPluginV2* GemmSwigluPluginCreator::createPlugin(char const* name, PluginFieldCo
             TLLM_CHECK(fields[i].type == PluginFieldType::kFLOAT32);
             scale_output = static_cast<float>(*(static_cast<float const*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "activation"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            activation = static_cast<GatedActivationType>(*(static_cast<int32_t const*>(fields[i].data)));
+            TLLM_CHECK_WITH_INFO(activation >= GatedActivationType::kSilu
+                    && activation <= GatedActivationType::kSquaredRelu,
+                "Unsupported gated activation %d", static_cast<int>(activation));
+        }
     }
     try
     {
@@ -414,7 +433,8 @@ IPluginV2* GemmSwigluPluginCreator::createPlugin(char const* name, PluginFieldCo
         // Create plugin profiler with shared tactics map
         auto pluginProfiler = mGemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false);
         QuantMode quantMode = QuantMode::fromDescription();
-        auto* obj = new GemmSwigluPlugin(quantMode, type, hasBias, scale_d0, scale_d1, scale_output, pluginProfiler);
+        auto* obj = new GemmSwigluPlugin(
+            quantMode, type, hasBias, scale_d0, scale_d1, scale_output, pluginProfiler, activation);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
@@ -53,6 +53,11 @@ protected:
 
     void initTmpData(int m, int n, int k, char* workspace, size_t size, cudaStream_t stream) override;
 
+    std::string getTacticCacheTag() const override
+    {
+        return "quantMode=" + std::to_string(mQuantMode.value());
+    }
+
 private:
     size_t getBytePerElement(nvinfer1::DataType type);
 
@@ -67,7 +72,9 @@ public:
     GemmSwigluPlugin() = delete;
 
     GemmSwigluPlugin(tensorrt_llm::common::QuantMode quantMode, nvinfer1::DataType type, bool hasBias, float scale_d0,
-        float scale_d1, float scale_output, PluginProfilerPtr const& pluginProfiler);
+        float scale_d1, float scale_output, PluginProfilerPtr const& pluginProfiler,
+        tensorrt_llm::kernels::cutlass_kernels::GatedActivationType activation
+        = tensorrt_llm::kernels::cutlass_kernels::GatedActivationType::kSilu);
 
     GemmSwigluPlugin(void const* data, size_t length, PluginProfilerPtr const& profiler);
 
@@ -123,6 +130,7 @@ private:
     float mScaleD0;
     float mScaleD1;
     float mScaleOutput;
+    tensorrt_llm::kernels::cutlass_kernels::GatedActivationType mActivation;
 };
 
 class GemmSwigluPluginCreator : public BaseCreator
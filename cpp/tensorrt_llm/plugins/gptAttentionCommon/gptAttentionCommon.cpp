@@ -98,6 +98,7 @@ struct FusedQKVMaskedAttentionDispatchParams
     bool multi_block_mode;
     int max_seq_len_tile;
     int min_seq_len_tile;
+    int64_t total_kv_length;
     T* partial_out;
     float* partial_sum;
     float* partial_max;
@@ -107,7 +108,6 @@ struct FusedQKVMaskedAttentionDispatchParams
     tc::QuantMode kv_cache_quant_mode;
     int multi_processor_count;
     KVCacheBuffer kv_block_array;
-    KVLinearBuffer shift_k_cache_buffer;
     bool cross_attention = false;
     int const* memory_length_per_sample = nullptr;
     int max_distance = 0;
@@ -248,6 +248,20 @@ bool GPTAttentionPluginCommon::convertMMHAParamsToXQAParams(tensorrt_llm::kernel
     return true;
 }
 
+#define INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(T, KVCacheBuffer)                                                \
+    template bool GPTAttentionPluginCommon::convertMMHAParamsToXQAParams<T, KVCacheBuffer>(                            \
+        tensorrt_llm::kernels::XQAParams& xqaParams,                                                                   \
+        EnqueueGenerationParams<T, KVCacheBuffer> const& generationsParams, bool forConfigurePlugin);
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(float, KVLinearBuffer)
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(half, KVLinearBuffer)
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(float, KVBlockArray)
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(half, KVBlockArray)
+#ifdef ENABLE_BF16
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(__nv_bfloat16, KVLinearBuffer)
+INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS(__nv_bfloat16, KVBlockArray)
+#endif
+#undef INSTANTIATE_CONVERT_MMHA_PARAMS_TO_XQA_PARAMS
+
 template <typename T_MMHA, typename T, typename KVCacheBuffer, bool CROSS_ATTENTION>
 void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS_ATTENTION>& params,
     FusedQKVMaskedAttentionDispatchParams<T, KVCacheBuffer> const& input_params, cudaStream_t stream)
@@ -352,6 +366,7 @@ void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS
     {
         params.min_seq_len_tile = input_params.min_seq_len_tile;
         params.max_seq_len_tile = input_params.max_seq_len_tile;
+        params.total_kv_length = input_params.total_kv_length;
 
         params.partial_out = reinterpret_cast<DataType*>(input_params.partial_out);
         params.partial_sum = input_params.partial_sum;
@@ -366,7 +381,7 @@ void fusedQKV_masked_attention_dispatch(Multihead_attention_params<T_MMHA, CROSS
     params.memory_length_per_sample = input_params.memory_length_per_sample;
     sync_check_cuda_error();
 
-    masked_multihead_attention(params, input_params.kv_block_array, input_params.shift_k_cache_buffer, stream);
+    masked_multihead_attention(params, input_params.kv_block_array, stream);
 }
 
 #define INSTANTIATE_MMHA_DISPATCH(T_MMHA, T)                                                                           \
@@ -614,8 +629,9 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForContext(nvinfer1::DataType t
         : 0;
     size_t const padding_offset_size = mEnableContextFMHA ? 0 : sizeof(int) * max_num_tokens;
     size_t const fmha_scheduler_counter = mEnableContextFMHA ? sizeof(uint32_t) : 0;
+    size_t const fmha_bmm2_scale_size = mFP8ContextFMHA && mEnableContextFMHA ? sizeof(float) : 0;
 
-    int const NUM_BUFFERS = 14;
+    int const NUM_BUFFERS = 15;
     size_t workspaces[NUM_BUFFERS];
     workspaces[0] = CUBLAS_WORKSPACE_SIZE;
     workspaces[1] = attention_mask_size;
@@ -631,6 +647,7 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForContext(nvinfer1::DataType t
     workspaces[11] = fp8_qkv_buffer_size;
     workspaces[12] = padding_offset_size;
     workspaces[13] = fmha_scheduler_counter;
+    workspaces[14] = fmha_bmm2_scale_size;
     context_workspace_size = tc::calculateTotalWorkspaceSize(workspaces, NUM_BUFFERS);
 
     return context_workspace_size;
@@ -654,16 +671,12 @@ size_t GPTAttentionPluginCommon::getWorkspaceSizeForGeneration(
     size_t const partial_out_size = size * batch_beam * mNumHeads * mHeadSize * maxSeqLenTile;
     size_t const partial_sum_size = sizeof(float) * batch_beam * mNumHeads * maxSeqLenTile;
     size_t const partial_max_size = sizeof(float) * batch_beam * mNumHeads * maxSeqLenTile;
-    size_t const shift_k_cache_size = (!mPosShiftEnabled || isCrossAttention())
-        ? 0
-        : size * batch_beam * mNumHeads * mHeadSize * max_attention_window;
 
-    int const NUM_BUFFERS = 4;
+    int const NUM_BUFFERS = 3;
     size_t workspaces[NUM_BUFFERS];
     workspaces[0] = partial_out_size;
     workspaces[1] = partial_sum_size;
     workspaces[2] = partial_max_size;
-    workspaces[3] = shift_k_cache_size;
     generation_workspace_size = tc::calculateTotalWorkspaceSize(workspaces, NUM_BUFFERS);
 
     size_t mqa_workspace_size = 0;
@@ -716,6 +729,11 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
         kv_cache_buffer = KVBlockArray(params.batch_size, params.max_blocks_per_sequence, mTokensPerBlock, sizePerToken,
             params.cyclic_attention_window_size, params.sink_token_length, params.host_primary_pool_pointer,
             params.host_secondary_pool_pointer, params.block_offsets);
+        if (mKVCacheQuantMode.hasKvCacheQuant() && params.host_primary_scale_pool_pointer != nullptr)
+        {
+            kv_cache_buffer.setTokenScalePools(
+                params.host_primary_scale_pool_pointer, params.host_secondary_scale_pool_pointer, num_kv_heads);
+        }
         hostKvCacheBlockOffsets = params.host_block_offsets;
     }
     else if constexpr (std::is_same_v<KVCacheBuffer, KVLinearBuffer>)
@@ -791,6 +809,7 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
         ? 0
         : sizeof(int) * params.batch_size * (isCrossAttention() ? params.cross_qkv_length : params.input_seq_length);
     size_t const fmha_scheduler_counter = mEnableContextFMHA ? sizeof(uint32_t) : 0;
+    size_t const fmha_bmm2_scale_size = mFP8ContextFMHA && mEnableContextFMHA ? sizeof(float) : 0;
 
     bool const is_qk_buf_float_ = true;
 
@@ -816,6 +835,8 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
         : reinterpret_cast<int*>(nextWorkspacePtr(workspace_byte_ptr, offset, padding_offset_size));
     uint32_t* fmha_tile_counter_ptr
         = reinterpret_cast<uint32_t*>(nextWorkspacePtr(workspace_byte_ptr, offset, fmha_scheduler_counter));
+    float* fmha_bmm2_scale_ptr
+        = reinterpret_cast<float*>(nextWorkspacePtr(workspace_byte_ptr, offset, fmha_bmm2_scale_size));
 
     // build attention_mask, cu_seqlens, and padding_offset tensors
     // Note: self attn and cross attn should use different params
@@ -902,11 +923,22 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
         bool const enablePagedKVContextFMHA = mPagedKVCache && mPagedContextFMHA;
         TLLM_CHECK_WITH_INFO(!(mKVCacheQuantMode.hasInt8KvCache() && enablePagedKVContextFMHA),
             "Paged Context FMHA doesn't work with int8 kv cache currently.");
+        TLLM_CHECK_WITH_INFO(!(params.host_primary_scale_pool_pointer != nullptr && enablePagedKVContextFMHA),
+            "Paged Context FMHA doesn't work with per-token kv cache scales currently.");
         TLLM_CHECK_WITH_INFO(
             !(mKVCacheQuantMode.hasFp8KvCache() && !mKVCacheQuantMode.hasFp8Qdq() && enablePagedKVContextFMHA),
             "FP8 Paged Context FMHA only works with fp8 quantization workflow currently.");
-        TLLM_CHECK_WITH_INFO(!(params.sink_token_length > 0 && enablePagedKVContextFMHA),
-            "Cannot support StreamingLLM now when enabling paged KV context FMHA.");
+        // The paged KV FMHA kernels read the tokens of each sequence contiguously from its blocks. Sink tokens keep
+        // that layout as long as they fill whole blocks (no bubble) and no token has been evicted from the window,
+        // which covers the chunks of the prefill and the reused blocks that fit in the attention window.
+        bool const sinkTokensInPagedLayout = !enablePagedKVContextFMHA || params.sink_token_length == 0
+            || (params.sink_token_length % mTokensPerBlock == 0
+                && params.max_past_kv_len <= params.cyclic_attention_window_size);
+        TLLM_CHECK_WITH_INFO(sinkTokensInPagedLayout,
+            "Paged KV context FMHA only supports StreamingLLM when the sink tokens fill whole blocks and the context "
+            "fits in the attention window.");
+        bool const fmhaReadsFp8KvCache
+            = mFP8ContextFMHA && enablePagedKVContextFMHA && mKVCacheQuantMode.hasFp8KvCache();
 
         QKVPreprocessingParams<T, KVCacheBuffer> preprocessingParams;
 
@@ -921,6 +953,14 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
         preprocessingParams.rotary_embedding_inv_freq = rotary_inv_freq_buf;
         preprocessingParams.rotary_coef_cache_buffer = params.rotary_cos_sin;
         preprocessingParams.kvScaleOrigQuant = params.kv_scale_orig_quant;
+        // Paged fp8 FMHA reads the fp8 kv cache as is, so the preprocessing folds its dequantization scale into Q and
+        // into the bmm2 scale.
+        if (fmhaReadsFp8KvCache)
+        {
+            preprocessingParams.kvScaleQuantOrig = params.kv_scale_quant_orig;
+            preprocessingParams.fmha_output_scale = params.attention_output_orig_quant;
+            preprocessingParams.fmha_bmm2_scale = fmha_bmm2_scale_ptr;
+        }
         preprocessingParams.spec_decoding_position_offsets = nullptr;
 
         // Scalars
@@ -991,8 +1031,8 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
             params.max_blocks_per_sequence, mTokensPerBlock, attention_window_size, params.num_tokens, isALiBi(),
             isAliBiWithScale(), mTpSize, mTpRank);
         mFMHARunner->run(fmha_input_tensor, hostKvCacheBlockOffsets, reinterpret_cast<KVBlockArray&>(kv_cache_buffer),
-            cu_q_seqlens, cu_kv_seqlens, fmha_tile_counter_ptr, params.attention_output_orig_quant, params.context_buf,
-            stream);
+            cu_q_seqlens, cu_kv_seqlens, fmha_tile_counter_ptr,
+            fmhaReadsFp8KvCache ? fmha_bmm2_scale_ptr : params.attention_output_orig_quant, params.context_buf, stream);
 
         sync_check_cuda_error();
     }
@@ -1124,18 +1164,16 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
 
         if (is_qk_buf_float_ == true)
         {
-            // add relative position bias
-            if (isRelativePosition())
+            // add relative position bias, the implicit one is added by the softmax kernel
+            if (isRelativePosition() && max_distance == 0)
             {
                 // Add relative_attention_bias
                 // QK is (batch_size, local_head_num, q_length, k_length), relative_attention_bias is (1,
                 // local_head_num, max_output_len + 1, max_output_len + 1). broadcast along 1st dim. max_seq_len is
-                // already max_output_len + 1. In implicit mode, relative_attention_bias is relative_attention_table
-                // [num_heads, num_buckets], with necessary params (max_distance, num_buckets) passed at the end
+                // already max_output_len + 1.
                 invokeAddRelativeAttentionBiasUnaligned(qk_buf_float_, relative_attention_bias, params.batch_size,
                     mNumHeads, attention_seq_len_1,
-                    isCrossAttention() ? params.cross_qkv_length : params.cyclic_attention_window_size, stream,
-                    max_distance > 0, relative_attention_bias_stride, max_distance, false /* bidirectional */);
+                    isCrossAttention() ? params.cross_qkv_length : params.cyclic_attention_window_size, stream);
             }
 
             MaskedSoftmaxParam<T, float> param;
@@ -1153,22 +1191,28 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
             param.block_sparse_attn = mMaskType == AttentionMaskType::BLOCKSPARSE;
             param.block_sparse_params = mBlockSparseParams;
             param.q_seq_lengths = params.q_seq_lengths;
+            if (isRelativePosition() && max_distance > 0)
+            {
+                // In implicit mode, relative_attention_bias is relative_attention_table [num_heads, num_buckets]
+                param.relative_attention_bias = relative_attention_bias;
+                param.relative_attention_bias_stride = relative_attention_bias_stride;
+                param.max_distance = max_distance;
+                param.relative_attention_bidirectional = false;
+            }
             invokeMaskedSoftmax(param, stream);
         }
         else
         {
-            // add relative position bias
-            if (isRelativePosition())
+            // add relative position bias, the implicit one is added by the softmax kernel
+            if (isRelativePosition() && max_distance == 0)
             {
                 // Add relative_attention_bias
                 // QK is (batch_size, local_head_num, q_length, k_length), relative_attention_bias is (1,
                 // local_head_num, max_output_len + 1, max_output_len + 1). broadcast along 1st dim. max_seq_len is
-                // already max_output_len + 1. In implicit mode, relative_attention_bias is relative_attention_table
-                // [num_heads, num_buckets], with necessary params (max_distance, num_buckets) passed at the end
+                // already max_output_len + 1.
                 invokeAddRelativeAttentionBiasUnaligned(qk_buf_, relative_attention_bias, params.batch_size, mNumHeads,
                     attention_seq_len_1,
-                    isCrossAttention() ? params.cross_qkv_length : params.cyclic_attention_window_size, stream,
-                    max_distance > 0, relative_attention_bias_stride, max_distance, false /* bidirectional */);
+                    isCrossAttention() ? params.cross_qkv_length : params.cyclic_attention_window_size, stream);
             }
 
             MaskedSoftmaxParam<T, T> param;
@@ -1186,6 +1230,14 @@ int GPTAttentionPluginCommon::enqueueContext(EnqueueContextParams<T, KVCacheBuff
             param.block_sparse_attn = mMaskType == AttentionMaskType::BLOCKSPARSE;
             param.block_sparse_params = mBlockSparseParams;
             param.q_seq_lengths = params.q_seq_lengths;
+            if (isRelativePosition() && max_distance > 0)
+            {
+                // In implicit mode, relative_attention_bias is relative_attention_table [num_heads, num_buckets]
+                param.relative_attention_bias = relative_attention_bias;
+                param.relative_attention_bias_stride = relative_attention_bias_stride;
+                param.max_distance = max_distance;
+                param.relative_attention_bidirectional = false;
+            }
             invokeMaskedSoftmax(param, stream);
         }
 
@@ -1327,6 +1379,11 @@ int GPTAttentionPluginCommon::enqueueGeneration(
             kv_cache_buffer = KVBlockArray(batch_beam, params.max_blocks_per_sequence, mTokensPerBlock, sizePerToken,
                 params.cyclic_attention_window_size, params.sink_token_length, params.host_primary_pool_pointer,
                 params.host_secondary_pool_pointer, reinterpret_cast<BufferDataType*>(params.block_offsets));
+            if (mKVCacheQuantMode.hasKvCacheQuant() && params.host_primary_scale_pool_pointer != nullptr)
+            {
+                kv_cache_buffer.setTokenScalePools(
+                    params.host_primary_scale_pool_pointer, params.host_secondary_scale_pool_pointer, num_kv_heads);
+            }
         }
         else if constexpr (std::is_same_v<KVCacheBuffer, KVLinearBuffer>)
         {
@@ -1347,8 +1404,10 @@ int GPTAttentionPluginCommon::enqueueGeneration(
         // NOTE: input_seq_length = num_medusa_tokens + 1 (new generated one from the original LM head)
         // self attn
         XQAParams xqaParams{};
+        // The XQA kernels read the kv cache with one scale per layer.
+        bool const hasTokenKvScales = kv_cache_buffer.hasTokenScales();
         if (tensorrt_llm::kernels::XQADispatchHelper<T, KVCacheBuffer>::CanSupport && mDecoderXQARunner.get() != nullptr
-            && this->template convertMMHAParamsToXQAParams<T, KVCacheBuffer>(
+            && !hasTokenKvScales && this->template convertMMHAParamsToXQAParams<T, KVCacheBuffer>(
                 xqaParams, params, /*forConfigurePlugin=*/false)
             && mDecoderXQARunner->shouldUse(xqaParams, /*forConfigurePlugin=*/false))
         {
@@ -1376,11 +1435,26 @@ int GPTAttentionPluginCommon::enqueueGeneration(
             "MultiBlockMode may have different accuracy compared to non-MultiBlockMode.");
     }
 
+    // Sum of the kv lengths of the batch, the multi-block split is balanced on it rather than on the longest sequence.
+    int64_t total_kv_length = 0;
+    if (!mCrossAttention && params.host_past_key_value_lengths != nullptr)
+    {
+        for (int32_t ri = 0; ri < params.num_requests; ++ri)
+        {
+            total_kv_length
+                += std::min(params.host_past_key_value_lengths[ri], params.cyclic_attention_window_size) + 1;
+        }
+        total_kv_length *= params.beam_width;
+    }
+
     int8_t* workspace_byte_ptr = reinterpret_cast<int8_t*>(params.workspace);
     size_t offset = 0;
     // estimate min block count to satisfy shared memory requirement to run kernel.
     // Runtime check to see the actual number of blocks per sequence we need.
-    int32_t const max_num_seq_len_tiles = std::max(getMaxNumSeqLenTile(batch_beam), estimated_min_multi_block_count);
+    // The workspace reserves getMaxNumSeqLenTile() tiles for each sequence, which lets the long sequences of a skewed
+    // batch be split further than the batch size alone allows when the lengths are known.
+    int32_t const max_num_seq_len_tiles = std::max(
+        getMaxNumSeqLenTile(total_kv_length > 0 ? 1 : batch_beam), estimated_min_multi_block_count);
     int32_t const min_num_seq_len_tiles = std::max(1, estimated_min_multi_block_count);
     bool const enable_multi_block
         = (mMultiBlockMode && max_num_seq_len_tiles > 1) || estimated_min_multi_block_count > 1;
@@ -1390,33 +1464,11 @@ int GPTAttentionPluginCommon::enqueueGeneration(
         = enable_multi_block ? sizeof(float) * batch_beam * mNumHeads * max_num_seq_len_tiles : 0;
     size_t const partial_max_size
         = enable_multi_block ? sizeof(float) * batch_beam * mNumHeads * max_num_seq_len_tiles : 0;
-    size_t const shift_k_cache_size = (!mPosShiftEnabled || isCrossAttention())
-        ? 0
-        : sizeof(T) * batch_beam * mNumHeads * mHeadSize * params.max_attention_window;
 
     // Workspace pointer shift
     T* partial_out = reinterpret_cast<T*>(nextWorkspacePtr(workspace_byte_ptr, offset, partial_out_size));
     float* partial_sum = reinterpret_cast<float*>(nextWorkspacePtr(workspace_byte_ptr, offset, partial_sum_size));
     float* partial_max = reinterpret_cast<float*>(nextWorkspacePtr(workspace_byte_ptr, offset, partial_max_size));
-    T* shift_k_cache = reinterpret_cast<T*>(nextWorkspacePtr(workspace_byte_ptr, offset, shift_k_cache_size));
-
-    // Apply position embedding to the keys in the K cache
-    KVLinearBuffer shift_k_cache_buffer;
-    if (mPosShiftEnabled && !isCrossAttention())
-    {
-        shift_k_cache_buffer
-            = KVLinearBuffer(batch_beam, params.max_attention_window, sizePerToken, params.cyclic_attention_window_size,
-                params.sink_token_length, true, reinterpret_cast<int8_t*>(shift_k_cache));
-        sync_check_cuda_error();
-        // KV cache type
-        KvCacheDataType const kv_cache_type = KvCacheDataType::BASE;
-        using DataType = typename SATypeConverter<T>::Type;
-        invokeShiftKCache<DataType, KVCacheBuffer>(kv_cache_buffer, shift_k_cache_buffer, kv_cache_type, getHeadSize(),
-            step - 1, batch_beam, mNumKVHeads, params.beam_width, params.cyclic_attention_window_size,
-            params.sink_token_length, params.kv_scale_quant_orig, params.sequence_lengths, params.context_lengths,
-            mRotaryEmbeddingDim, mRotaryEmbeddingBase, mRotaryEmbeddingScaleType, mRotaryEmbeddingScale,
-            mRotaryEmbeddingMaxPositions, mPositionEmbeddingType, stream);
-    }
 
     FusedQKVMaskedAttentionDispatchParams<T, KVCacheBuffer> dispatch_params;
     memset(&dispatch_params, 0, sizeof(dispatch_params));
@@ -1457,6 +1509,7 @@ int GPTAttentionPluginCommon::enqueueGeneration(
     dispatch_params.multi_block_mode = enable_multi_block;
     dispatch_params.max_seq_len_tile = max_num_seq_len_tiles;
     dispatch_params.min_seq_len_tile = min_num_seq_len_tiles;
+    dispatch_params.total_kv_length = total_kv_length;
     dispatch_params.partial_out = partial_out;
     dispatch_params.partial_sum = partial_sum;
     dispatch_params.partial_max = partial_max;
@@ -1465,7 +1518,6 @@ int GPTAttentionPluginCommon::enqueueGeneration(
     dispatch_params.kv_scale_orig_quant = params.kv_scale_orig_quant;
     dispatch_params.kv_scale_quant_orig = params.kv_scale_quant_orig;
     dispatch_params.kv_block_array = kv_cache_buffer;
-    dispatch_params.shift_k_cache_buffer = shift_k_cache_buffer;
     dispatch_params.multi_processor_count = mMultiProcessorCount;
     dispatch_params.rotary_embedding_base = mRotaryEmbeddingBase;
     dispatch_params.rotary_embedding_scale_type = mRotaryEmbeddingScaleType;
@@ -129,6 +129,9 @@ protected:
         int32_t cross_qkv_length = 0;
         int32_t const* encoder_input_lengths = nullptr;
         int32_t num_encoder_tokens = 0;
+        // optional when the 8bits paged kv cache stores one scale per token and kv head
+        float* host_primary_scale_pool_pointer = nullptr;
+        float* host_secondary_scale_pool_pointer = nullptr;
 
         std::string enqueueContextParamsToString() const
         {
@@ -172,6 +175,8 @@ protected:
             ss << "cross_qkv_length: " << cross_qkv_length << std::endl;
             ss << "encoder_input_lengths: " << encoder_input_lengths << std::endl;
             ss << "num_encoder_tokens: " << num_encoder_tokens << std::endl;
+            ss << "host_primary_scale_pool_pointer: " << host_primary_scale_pool_pointer << std::endl;
+            ss << "host_secondary_scale_pool_pointer: " << host_secondary_scale_pool_pointer << std::endl;
             return ss.str();
         }
     };
@@ -225,6 +230,9 @@ protected:
         int32_t const* spec_decoding_position_offsets = nullptr;
         int32_t const* spec_decoding_generation_lengths = nullptr;
         int32_t total_num_input_tokens;
+        // optional when the 8bits paged kv cache stores one scale per token and kv head
+        float* host_primary_scale_pool_pointer = nullptr;
+        float* host_secondary_scale_pool_pointer = nullptr;
     };
 
     template <typename T, typename KVCacheBuffer>
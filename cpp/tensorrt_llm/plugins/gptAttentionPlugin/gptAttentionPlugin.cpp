@@ -25,6 +25,7 @@
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/rangeProfiler.h"
 #include "tensorrt_llm/runtime/utils/debugUtils.h"
 #include <algorithm>
 #include <cstdint>
@@ -357,7 +358,12 @@ void GPTAttentionPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc const
 size_t GPTAttentionPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
     nvinfer1::PluginTensorDesc const* outputs, int nbOutputs) const noexcept
 {
-    int const max_context_length = mMaxContextLength;
+    // The context workspace is sized for the bounds of the optimization profile: a packed sequence can't be longer
+    // than the tokens of the batch and a padded one than the padded length. For generation profiles and profiles of
+    // fewer tokens than the build time max context length, it is much smaller than the size for mMaxContextLength.
+    auto const& qkvDims = inputs[getIdx(IdxEntry::QKV_TENSOR)].dims;
+    int const max_context_length
+        = std::min(mMaxContextLength, static_cast<int>(mRemovePadding ? qkvDims.d[0] : qkvDims.d[1]));
     int const cross_qkv_length = isCrossAttention() ? inputs[getIdx(IdxEntry::CROSS_QKV_LENGTH)].dims.d[0] : 0;
     int const max_num_seq = inputs[getIdx(IdxEntry::CONTEXT_LENGTHS)].dims.d[0];
     auto const type = inputs[getIdx(IdxEntry::QKV_TENSOR)].type;
@@ -816,6 +822,7 @@ int GPTAttentionPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     {
         return 0;
     }
+    TLLM_PROFILE_GPU_RANGE(kPLUGIN, "GPTAttentionPlugin::enqueue", stream);
     if (mType == nvinfer1::DataType::kHALF)
     {
 #ifdef ENABLE_FP8
@@ -18,6 +18,8 @@
 #include <cstdio>
 
 #include "lookupPlugin.h"
+#include "tensorrt_llm/common/customAllReduceUtils.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include "tensorrt_llm/kernels/lookupKernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
 
@@ -32,9 +34,15 @@ static char const* LOOKUP_PLUGIN_NAME{"Lookup"};
 PluginFieldCollection LookupPluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> LookupPluginCreator::mPluginAttributes;
 
-LookupPlugin::LookupPlugin(nvinfer1::DataType type, int rank)
+LookupPlugin::LookupPlugin(nvinfer1::DataType type, int rank, int tp_size, bool use_prompt_tuning, int vocab_size,
+    bool fuse_all_reduce, int all_reduce_counter)
     : mType(type)
     , mRank(rank)
+    , mTpSize(tp_size)
+    , mUsePromptTuning(use_prompt_tuning)
+    , mVocabSize(vocab_size)
+    , mFuseAllReduce(fuse_all_reduce)
+    , mAllReduceCounter(all_reduce_counter)
 {
     mArch = tensorrt_llm::common::getSMVersion();
 }
@@ -46,6 +54,11 @@ LookupPlugin::LookupPlugin(void const* data, size_t length)
     char const *d = reinterpret_cast<char const*>(data), *a = d;
     read(d, mType);
     read(d, mRank);
+    read(d, mTpSize);
+    read(d, mUsePromptTuning);
+    read(d, mVocabSize);
+    read(d, mFuseAllReduce);
+    read(d, mAllReduceCounter);
     TLLM_CHECK_WITH_INFO(d == a + length,
         "Expected length (%d) != real length (%d). This is often "
         "caused by using different TensorRT-LLM version to build "
@@ -67,7 +80,7 @@ nvinfer1::DimsExprs LookupPlugin::getOutputDimensions(
 {
     try
     {
-        TLLM_CHECK(nbInputs == 2 || nbInputs == 3);
+        TLLM_CHECK(nbInputs == 2 + getNbExtraInputs() || nbInputs == 3 + getNbExtraInputs());
         TLLM_CHECK(outputIndex == 0);
         DimsExprs ret;
         int const nbDimsInput = inputs[0].nbDims;
@@ -93,32 +106,48 @@ bool LookupPlugin::supportsFormatCombination(
     int pos, nvinfer1::PluginTensorDesc const* inOut, int nbInputs, int nbOutputs) noexcept
 {
     bool res = false;
-    if (nbInputs == 2)
+    if (inOut[pos].format != TensorFormat::kLINEAR)
     {
-        switch (pos)
+        return false;
+    }
+    if (pos == 0)
+    {
+        res = inOut[pos].type == DataType::kINT32;
+    }
+    else if (pos == 1)
+    {
+        if (hasPerTokenScales(nbInputs))
+        {
+            TLLM_CHECK_WITH_INFO(mArch == 90, "int8 weight only lookupPlugin is only supported in SM 90 now.");
+            res = inOut[pos].type == DataType::kINT8 || inOut[pos].type == mType;
+        }
+        else
         {
-        case 0: res = ((inOut[0].type == DataType::kINT32) && (inOut[0].format == TensorFormat::kLINEAR)); break;
-        case 1: res = ((inOut[1].type == mType) && (inOut[1].format == TensorFormat::kLINEAR)); break;
-        case 2: res = ((inOut[2].type == mType) && (inOut[2].format == TensorFormat::kLINEAR)); break;
-        default: // should NOT be here!
-            res = false;
+            res = inOut[pos].type == mType;
         }
     }
+    else if (pos == nbInputs)
+    {
+        // output
+        res = inOut[pos].type == mType;
+    }
+    else if (pos < getAllReduceWorkspaceIndex(nbInputs))
+    {
+        // per token scales
+        res = inOut[pos].type == mType;
+    }
+    else if (mFuseAllReduce && pos == getAllReduceWorkspaceIndex(nbInputs))
+    {
+        res = inOut[pos].type == DataType::kINT64;
+    }
+    else if (pos == getPromptTableIndex(nbInputs))
+    {
+        res = inOut[pos].type == mType;
+    }
     else
     {
-        TLLM_CHECK_WITH_INFO(mArch == 90, "int8 weight only lookupPlugin is only supported in SM 90 now.");
-        switch (pos)
-        {
-        case 0: res = ((inOut[0].type == DataType::kINT32) && (inOut[0].format == TensorFormat::kLINEAR)); break;
-        case 1:
-            res = ((inOut[1].type == DataType::kINT8 || inOut[1].type == mType)
-                && (inOut[1].format == TensorFormat::kLINEAR));
-            break;
-        case 2: res = ((inOut[2].type == mType) && (inOut[2].format == TensorFormat::kLINEAR)); break;
-        case 3: res = ((inOut[3].type == mType) && (inOut[3].format == TensorFormat::kLINEAR)); break;
-        default: // should NOT be here!
-            res = false;
-        }
+        // tasks and task vocab size
+        res = inOut[pos].type == DataType::kINT32;
     }
     return res;
 }
@@ -157,29 +186,86 @@ int LookupPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1:
 
     int offset = mRank * localVocabSize;
 
-    if (mNbInputs == 3)
+    // prompt tuning
+    //     prompt_table [numTasks * taskVocabSize, hidden]
+    //     tasks [tokenNum]
+    //     task_vocab_size [1]
+    void const* promptTable = nullptr;
+    int const* tasks = nullptr;
+    int const* taskVocabSize = nullptr;
+    if (mUsePromptTuning)
+    {
+        int const promptTableIndex = getPromptTableIndex(mNbInputs);
+        promptTable = inputs[promptTableIndex];
+        tasks = reinterpret_cast<int const*>(inputs[promptTableIndex + 1]);
+        taskVocabSize = reinterpret_cast<int const*>(inputs[promptTableIndex + 2]);
+    }
+
+    if (mFuseAllReduce)
+    {
+        // all_reduce_workspace, as for the AllReduce plugin
+        TLLM_CHECK_WITH_INFO(!hasPerTokenScales(mNbInputs), "The fused all reduce does not support int8 weights.");
+        if (isBuilding())
+        {
+            return 0;
+        }
+        auto const messageElts = static_cast<size_t>(tokenNum) * hidden;
+        auto const messageSize = messageElts * getDTypeSize(mType);
+        auto const maxSize = tensorrt_llm::utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(mTpSize);
+        TLLM_CHECK_WITH_INFO(
+            messageSize <= maxSize, "Embedding of %zu bytes does not fit the all reduce workspace", messageSize);
+        // The strategies the AllReduce plugin picks for these sizes
+        auto strategy = messageSize < 1000 * 1000 ? AllReduceStrategyType::ONESHOT : AllReduceStrategyType::TWOSHOT;
+        if (!configurationSupported(strategy, messageElts, mTpSize, mType))
+        {
+            strategy = AllReduceStrategyType::ONESHOT;
+        }
+        TLLM_CHECK_WITH_INFO(configurationSupported(strategy, messageElts, mTpSize, mType),
+            "The fused all reduce does not support the embedding shape");
+
+        auto const* workspace = static_cast<int32_t const*>(inputs[getAllReduceWorkspaceIndex(mNbInputs)]);
+        auto params = AllReduceParams::deserialize(workspace, mTpSize, mRank, mAllReduceCounter);
+        params.local_output_buffer_ptr = outputs[0];
+        params.elts_total = messageElts;
+        params.fusion_params.hidden_size = hidden;
+        auto& lookup = params.fusion_params.embedding_lookup;
+        lookup.input_ids = input;
+        lookup.weight = inputs[1];
+        lookup.vocab_start = offset;
+        lookup.local_vocab_size = localVocabSize;
+        lookup.prompt_table = promptTable;
+        lookup.tasks = tasks;
+        lookup.task_vocab_size = taskVocabSize;
+        lookup.vocab_size = mVocabSize;
+        customAllReduce(
+            params, mType, strategy, AllReduceStrategyConfig(0), AllReduceFusionOp::EMBEDDING_LOOKUP, stream);
+        return 0;
+    }
+
+    if (hasPerTokenScales(mNbInputs))
     {
         int8_t const* weight = reinterpret_cast<int8_t const*>(inputs[1]);
         if (mType == DataType::kHALF)
         {
             half const* per_token_scales = reinterpret_cast<half const*>(inputs[2]);
             half* output = reinterpret_cast<half*>(outputs[0]);
-            invokeLookUp<half, int8_t, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, per_token_scales, stream);
+            invokeLookUp<half, int8_t, int>(output, input, weight, tokenNum, offset, localVocabSize, hidden,
+                per_token_scales, stream, static_cast<half const*>(promptTable), tasks, taskVocabSize, mVocabSize);
         }
         else if (mType == DataType::kFLOAT)
         {
             float const* per_token_scales = reinterpret_cast<float const*>(inputs[2]);
             float* output = reinterpret_cast<float*>(outputs[0]);
-            invokeLookUp<float, int8_t, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, per_token_scales, stream);
+            invokeLookUp<float, int8_t, int>(output, input, weight, tokenNum, offset, localVocabSize, hidden,
+                per_token_scales, stream, static_cast<float const*>(promptTable), tasks, taskVocabSize, mVocabSize);
         }
         else if (mType == DataType::kBF16)
         {
             __nv_bfloat16 const* per_token_scales = reinterpret_cast<__nv_bfloat16 const*>(inputs[2]);
             __nv_bfloat16* output = reinterpret_cast<__nv_bfloat16*>(outputs[0]);
-            invokeLookUp<__nv_bfloat16, int8_t, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, per_token_scales, stream);
+            invokeLookUp<__nv_bfloat16, int8_t, int>(output, input, weight, tokenNum, offset, localVocabSize, hidden,
+                per_token_scales, stream, static_cast<__nv_bfloat16 const*>(promptTable), tasks, taskVocabSize,
+                mVocabSize);
         }
     }
     else
@@ -188,22 +274,23 @@ int LookupPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1:
         {
             half const* weight = reinterpret_cast<half const*>(inputs[1]);
             half* output = reinterpret_cast<half*>(outputs[0]);
-            invokeLookUp<half, half, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, nullptr, stream);
+            invokeLookUp<half, half, int>(output, input, weight, tokenNum, offset, localVocabSize, hidden, nullptr,
+                stream, static_cast<half const*>(promptTable), tasks, taskVocabSize, mVocabSize);
         }
         else if (mType == DataType::kFLOAT)
         {
             float const* weight = reinterpret_cast<float const*>(inputs[1]);
             float* output = reinterpret_cast<float*>(outputs[0]);
-            invokeLookUp<float, float, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, nullptr, stream);
+            invokeLookUp<float, float, int>(output, input, weight, tokenNum, offset, localVocabSize, hidden, nullptr,
+                stream, static_cast<float const*>(promptTable), tasks, taskVocabSize, mVocabSize);
         }
         else if (mType == DataType::kBF16)
         {
             __nv_bfloat16 const* weight = reinterpret_cast<__nv_bfloat16 const*>(inputs[1]);
             __nv_bfloat16* output = reinterpret_cast<__nv_bfloat16*>(outputs[0]);
-            invokeLookUp<__nv_bfloat16, __nv_bfloat16, int>(
-                output, input, weight, tokenNum, offset, localVocabSize, hidden, nullptr, stream);
+            invokeLookUp<__nv_bfloat16, __nv_bfloat16, int>(output, input, weight, tokenNum, offset, localVocabSize,
+                hidden, nullptr, stream, static_cast<__nv_bfloat16 const*>(promptTable), tasks, taskVocabSize,
+                mVocabSize);
         }
     }
     sync_check_cuda_error();
@@ -248,7 +335,8 @@ void LookupPlugin::destroy() noexcept
 
 size_t LookupPlugin::getSerializationSize() const noexcept
 {
-    return sizeof(mType) + sizeof(mRank);
+    return sizeof(mType) + sizeof(mRank) + sizeof(mTpSize) + sizeof(mUsePromptTuning) + sizeof(mVocabSize)
+        + sizeof(mFuseAllReduce) + sizeof(mAllReduceCounter);
 }
 
 void LookupPlugin::serialize(void* buffer) const noexcept
@@ -256,6 +344,11 @@ void LookupPlugin::serialize(void* buffer) const noexcept
     char *d = static_cast<char*>(buffer), *a = d;
     write(d, mType);
     write(d, mRank);
+    write(d, mTpSize);
+    write(d, mUsePromptTuning);
+    write(d, mVocabSize);
+    write(d, mFuseAllReduce);
+    write(d, mAllReduceCounter);
 
     assert(d == a + getSerializationSize());
 }
@@ -270,6 +363,11 @@ LookupPluginCreator::LookupPluginCreator()
     mPluginAttributes.clear();
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("rank", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("tp_size", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("use_prompt_tuning", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("vocab_size", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("fuse_all_reduce", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(PluginField("all_reduce_counter", nullptr, PluginFieldType::kINT32, 0));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -294,6 +392,11 @@ IPluginV2* LookupPluginCreator::createPlugin(char const* name, PluginFieldCollec
     PluginField const* fields = fc->fields;
     nvinfer1::DataType type;
     int rank;
+    int tpSize = 1;
+    int usePromptTuning = 0;
+    int vocabSize = 0;
+    int fuseAllReduce = 0;
+    int allReduceCounter = 0;
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -308,10 +411,36 @@ IPluginV2* LookupPluginCreator::createPlugin(char const* name, PluginFieldCollec
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             rank = static_cast<int>(*(static_cast<int const*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "tp_size"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            tpSize = *static_cast<int const*>(fields[i].data);
+        }
+        else if (!strcmp(attrName, "use_prompt_tuning"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            usePromptTuning = *static_cast<int const*>(fields[i].data);
+        }
+        else if (!strcmp(attrName, "vocab_size"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            vocabSize = *static_cast<int const*>(fields[i].data);
+        }
+        else if (!strcmp(attrName, "fuse_all_reduce"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            fuseAllReduce = *static_cast<int const*>(fields[i].data);
+        }
+        else if (!strcmp(attrName, "all_reduce_counter"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            allReduceCounter = *static_cast<int const*>(fields[i].data);
+        }
     }
     try
     {
-        auto* obj = new LookupPlugin(type, rank);
+        auto* obj = new LookupPlugin(
+            type, rank, tpSize, usePromptTuning != 0, vocabSize, fuseAllReduce != 0, allReduceCounter);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
@@ -30,7 +30,8 @@ class LookupPlugin : public BasePlugin
 public:
     LookupPlugin() = delete;
 
-    LookupPlugin(nvinfer1::DataType type, int rank);
+    LookupPlugin(nvinfer1::DataType type, int rank, int tp_size = 1, bool use_prompt_tuning = false,
+        int vocab_size = 0, bool fuse_all_reduce = false, int all_reduce_counter = 0);
 
     LookupPlugin(void const* data, size_t length);
 
@@ -64,10 +65,40 @@ public:
     void destroy() noexcept override;
 
 private:
+    // Inputs: input ids, weight, [per token scales], [all reduce workspace], [prompt table, tasks, task vocab size]
+    int getNbExtraInputs() const
+    {
+        return mFuseAllReduce + 3 * mUsePromptTuning;
+    }
+
+    bool hasPerTokenScales(int nbInputs) const
+    {
+        return nbInputs - getNbExtraInputs() == 3;
+    }
+
+    int getAllReduceWorkspaceIndex(int nbInputs) const
+    {
+        return nbInputs - getNbExtraInputs();
+    }
+
+    int getPromptTableIndex(int nbInputs) const
+    {
+        return getAllReduceWorkspaceIndex(nbInputs) + mFuseAllReduce;
+    }
+
     const std::string mLayerName;
 
     nvinfer1::DataType mType;
     int mRank;
+    int mTpSize;
+    // Ids at or above mVocabSize are virtual tokens looked up in the prompt table of their task
+    int mUsePromptTuning;
+    int mVocabSize;
+    // Gather the embeddings straight into the custom all reduce buffer and sum the vocab shards across the TP ranks.
+    // The output is the reduced embedding, the graph must not add the allreduce. The counter plays the role of the
+    // AllReduce plugin counter
+    int mFuseAllReduce;
+    int mAllReduceCounter;
     int mNbInputs = 0;
     int mArch;
 };
@@ -22,6 +22,8 @@
 #include "tensorrt_llm/common/cublasMMWrapper.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/kernels/groupGemm.h"
+#include "tensorrt_llm/kernels/loraGroupGemmParams.h"
+#include "tensorrt_llm/kernels/loraSegmentedGemv.h"
 #include "tensorrt_llm/kernels/splitkGroupGemm.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
@@ -277,6 +279,15 @@ int64_t getGroupedGemmParamsWorkSpaceSize(int64_t nbReq)
     return std::max(tk::getSplitkGroupedGemmParamsWorkSpaceSize(nbReq), tk::getGroupedGemmParamsWorkSpaceSize(nbReq));
 }
 
+// weights_ptrs and outputs (int64), then ranks, num_tokens and out_hidden_sizes (int32), see LoraGroupGemmRequests
+int64_t getLoraRequestsWorkSpaceSize(int64_t nbReq, int64_t maxLoraModuleNum)
+{
+    return divUp((nbReq * maxLoraModuleNum * 2 + maxLoraModuleNum) * sizeof(int64_t)
+                   + (nbReq * maxLoraModuleNum + nbReq + maxLoraModuleNum) * sizeof(int32_t),
+               16)
+        * 16;
+}
+
 int64_t getSplitkGroupedGemmWorkSpaceSize(
     int64_t nbReq, int64_t maxContextLength, int64_t maxLoraModuleNum, int64_t maxLowRank, int64_t splitKSlices)
 {
@@ -300,7 +311,8 @@ size_t LoraPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, in
 
     return (size_t) getGemmWorkSpaceSize(nbReq, mMaxContextLength, mNumLoraModules, mMaxLowRank, mSplitKSlices)
         + getLowRankWorkSpaceSize(nbReq, mMaxContextLength, mNumLoraModules, mMaxLowRank, typeSize)
-        + getGroupedGemmParamsWorkSpaceSize(nbReq * mNumLoraModules);
+        + getGroupedGemmParamsWorkSpaceSize(nbReq * mNumLoraModules) * 2
+        + getLoraRequestsWorkSpaceSize(nbReq, mNumLoraModules);
 }
 
 void runCublasGemmEx(int const M, int const N, int const K, bool const transA, bool const transB, void const* act,
@@ -338,6 +350,59 @@ bool isEnableLora(int batchSize, int numLoraModules, void const* const* loraRank
     return false;
 }
 
+tk::LoraGroupGemmRequests LoraPlugin::copyLoraRequests(nvinfer1::PluginTensorDesc const* inputDesc,
+    nvinfer1::PluginTensorDesc const* outputDesc, void const* const* inputs, void* const* outputs, void* workspace,
+    cudaStream_t stream)
+{
+    auto const batch_size = inputDesc[getLoraRanksIdx()].dims.d[0];
+    auto const host_context_lengths
+        = mRemoveInputPadding ? static_cast<int32_t const*>(inputs[getHostContextLengthsIdx()]) : nullptr;
+    RequestType const* reqTypes = static_cast<RequestType const*>(inputs[getHostRequestTypesIdx()]);
+    int const nbDimsA = inputDesc[0].dims.nbDims;
+
+    auto const num_problems = batch_size * mNumLoraModules;
+    auto const requestsSize = getLoraRequestsWorkSpaceSize(batch_size, mNumLoraModules);
+    mHostLoraRequests.resize(divUp(requestsSize, sizeof(int64_t)));
+    auto* weights_ptrs = mHostLoraRequests.data();
+    auto* output_ptrs = weights_ptrs + num_problems * 2;
+    auto* ranks = reinterpret_cast<int32_t*>(output_ptrs + mNumLoraModules);
+    auto* num_tokens = ranks + num_problems;
+    auto* out_hidden_sizes = num_tokens + batch_size;
+    for (int loraModuleIdx = 0; loraModuleIdx < mNumLoraModules; loraModuleIdx++)
+    {
+        auto const lora_ranks = static_cast<int32_t const*>(inputs[getLoraRanksIdx() + loraModuleIdx]);
+        auto const lora_weights_ptr = static_cast<int64_t const*>(inputs[getLoraWeightsPtrsIdx() + loraModuleIdx]);
+        for (int batchIdx = 0; batchIdx < batch_size; batchIdx++)
+        {
+            auto const N = lora_ranks[batchIdx];
+            TLLM_CHECK_WITH_INFO(N <= mMaxLowRank,
+                fmtstr("Invalid low_rank (%d). low_rank must be smaller than mMaxLowRank (%d)", N, mMaxLowRank));
+        }
+        std::copy_n(lora_ranks, batch_size, ranks + loraModuleIdx * batch_size);
+        std::copy_n(lora_weights_ptr, batch_size * 2, weights_ptrs + loraModuleIdx * batch_size * 2);
+        output_ptrs[loraModuleIdx] = reinterpret_cast<int64_t>(outputs[loraModuleIdx]);
+        out_hidden_sizes[loraModuleIdx] = outputDesc[loraModuleIdx].dims.d[nbDimsA - 1];
+    }
+    for (int batchIdx = 0; batchIdx < batch_size; batchIdx++)
+    {
+        num_tokens[batchIdx] = (reqTypes[batchIdx] != RequestType::kCONTEXT)
+            ? 1
+            : (mRemoveInputPadding ? host_context_lengths[batchIdx] : inputDesc[0].dims.d[1]);
+    }
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(workspace, mHostLoraRequests.data(), requestsSize, cudaMemcpyHostToDevice, stream));
+
+    auto const toDevice = [&](void const* hostPtr)
+    {
+        return static_cast<char*>(workspace)
+            + (static_cast<char const*>(hostPtr) - reinterpret_cast<char const*>(mHostLoraRequests.data()));
+    };
+    return tk::LoraGroupGemmRequests{reinterpret_cast<int32_t const*>(toDevice(ranks)),
+        reinterpret_cast<int64_t const*>(toDevice(weights_ptrs)),
+        reinterpret_cast<int32_t const*>(toDevice(num_tokens)),
+        reinterpret_cast<int64_t const*>(toDevice(output_ptrs)),
+        reinterpret_cast<int32_t const*>(toDevice(out_hidden_sizes))};
+}
+
 int LoraPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::PluginTensorDesc const* outputDesc,
     void const* const* inputs, void* const* outputs, void* workspace, cudaStream_t stream) noexcept
 {
@@ -364,10 +429,13 @@ int LoraPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
     int64_t GemmWorkSpaceSize
         = getGemmWorkSpaceSize(batch_size, mMaxContextLength, mNumLoraModules, mMaxLowRank, mSplitKSlices);
     int64_t groupGemmParamsWorkSpaceSize = getGroupedGemmParamsWorkSpaceSize(batch_size * mNumLoraModules);
-    void* gemmWorkSpace = workspace; // [gemmWorkSpace, lowrankWorkSpace, groupGemmParamsWorkSpace]
+    // [gemmWorkSpace, lowrankWorkSpace, groupGemmParamsWorkSpace, groupGemmParamsWorkSpace2, loraRequestsWorkSpace]
+    void* gemmWorkSpace = workspace;
     void* lowRankWorkSpace = static_cast<char*>(gemmWorkSpace) + GemmWorkSpaceSize;
     void* groupGemmParamsWorkSpace = static_cast<char*>(lowRankWorkSpace)
         + getLowRankWorkSpaceSize(batch_size, mMaxContextLength, mNumLoraModules, mMaxLowRank, typeSize);
+    void* groupGemmParamsWorkSpace2 = static_cast<char*>(groupGemmParamsWorkSpace) + groupGemmParamsWorkSpaceSize;
+    void* loraRequestsWorkSpace = static_cast<char*>(groupGemmParamsWorkSpace2) + groupGemmParamsWorkSpaceSize;
 
     bool isWithLora = isEnableLora(batch_size, mNumLoraModules, &inputs[getLoraRanksIdx()]);
 
@@ -389,6 +457,13 @@ int LoraPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
 
     char* useUnifiedGemmChar = std::getenv("LORA_USE_UNIFIED_GEMM");
     bool useUnifiedGemm = (useUnifiedGemmChar == nullptr || std::string(useUnifiedGemmChar) != "OFF");
+    char* useDeviceGemmParamsChar = std::getenv("LORA_USE_DEVICE_GEMM_PARAMS");
+    bool const useDeviceGemmParams
+        = (useDeviceGemmParamsChar != nullptr && std::string(useDeviceGemmParamsChar) == "ON");
+    // Decode steps with many adapters run as per request GEMVs instead of grouped GEMMs of one row each
+    char* useSegmentedGemvChar = std::getenv("LORA_USE_SEGMENTED_GEMV");
+    bool const useSegmentedGemv = (useSegmentedGemvChar == nullptr || std::string(useSegmentedGemvChar) != "OFF")
+        && std::all_of(reqTypes, reqTypes + batch_size, [](auto reqType) { return reqType != RequestType::kCONTEXT; });
     for (int batchIdx = 0; batchIdx < batch_size; batchIdx++)
     {
         for (int loraModuleIdx = 0; loraModuleIdx < mNumLoraModules; loraModuleIdx++)
@@ -446,6 +521,30 @@ int LoraPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
             }
         }
     }
+    else if (useSegmentedGemv)
+    {
+        auto const requests = copyLoraRequests(inputDesc, outputDesc, inputs, outputs, loraRequestsWorkSpace, stream);
+        auto const K = mTransA ? inputDesc[0].dims.d[0] : inputDesc[0].dims.d[nbDimsA - 1]; // input hidden size
+        tk::loraSegmentedGemv(requests, batch_size, mNumLoraModules, inputs[0], K,
+            *std::max_element(mOutHiddenSizes.begin(), mOutHiddenSizes.end()), lowRankWorkSpace, mMaxContextLength,
+            mMaxLowRank, mWeightIndex, mType, stream);
+    }
+    else if (useDeviceGemmParams)
+    {
+        // Only the request table is copied, the grouped GEMM problems are built on the device.
+        // The in GEMM runs without split-K here since the problem sizes are not known on the host.
+        auto const num_problems = batch_size * mNumLoraModules;
+        auto const requests = copyLoraRequests(inputDesc, outputDesc, inputs, outputs, loraRequestsWorkSpace, stream);
+        auto const K = mTransA ? inputDesc[0].dims.d[0] : inputDesc[0].dims.d[nbDimsA - 1]; // input hidden size
+        tk::setupLoraGroupGemmParams(requests, batch_size, mNumLoraModules, inputs[0], K, lowRankWorkSpace,
+            mMaxContextLength, mMaxLowRank, mWeightIndex, mType, groupGemmParamsWorkSpace, groupGemmParamsWorkSpace2,
+            stream);
+        tk::groupedGemm(num_problems, groupGemmParamsWorkSpace, gemmWorkSpace, GemmWorkSpaceSize, true, mType, stream);
+        sync_check_cuda_error();
+        tk::groupedGemm(
+            num_problems, groupGemmParamsWorkSpace2, gemmWorkSpace, GemmWorkSpaceSize, false, mType, stream);
+        sync_check_cuda_error();
+    }
     else
     {
         std::vector<cutlass::gemm::GemmCoord> problem_sizes;
@@ -17,6 +17,7 @@
 #ifndef TRT_LORA_PLUGIN_H
 #define TRT_LORA_PLUGIN_H
 #include "tensorrt_llm/common/cublasMMWrapper.h"
+#include "tensorrt_llm/kernels/loraGroupGemmParams.h"
 #include "tensorrt_llm/plugins/common/gemmPluginProfiler.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
 #include "tensorrt_llm/plugins/gemmPlugin/gemmPlugin.h"
@@ -77,6 +78,10 @@ private:
     void init();
     void configGemm();
     void setGemmConfig();
+    // Copies the per request LoRA table of the inputs to workspace and returns its device view
+    kernels::LoraGroupGemmRequests copyLoraRequests(nvinfer1::PluginTensorDesc const* inputDesc,
+        nvinfer1::PluginTensorDesc const* outputDesc, void const* const* inputs, void* const* outputs, void* workspace,
+        cudaStream_t stream);
 
     using IndexType = std::int32_t;
 
@@ -126,6 +131,8 @@ private:
     int mNumLoraModules;
     int mWeightIndex;
     int const mSplitKSlices = 16;
+    // Host staging of the request table for copyLoraRequests
+    std::vector<int64_t> mHostLoraRequests;
 
     // @fixme: seems this is shared across multiple clones.
     // If we deep copy the wrapper inside clone(), then we may avoid the mutex inside the wrapper?
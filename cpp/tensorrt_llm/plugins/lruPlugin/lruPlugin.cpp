@@ -17,6 +17,7 @@
 
 #include "lruPlugin.h"
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
 
 using namespace nvinfer1;
 using namespace tensorrt_llm::kernels;
@@ -208,6 +209,8 @@ int lruPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1
 
     if (reqTypes[0] == RequestType::kCONTEXT)
     {
+        // Resume from the state restored in the slot, see runtime::RnnStatePool
+        lru_params.load_initial_state = mPagedState && tensorrt_llm::common::getEnvEnableRnnStateReuse();
         invokeRGLRU<T>(lru_params, stream);
     }
     else if (reqTypes[0] == RequestType::kGENERATION)
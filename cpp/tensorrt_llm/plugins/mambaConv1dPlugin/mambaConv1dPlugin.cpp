@@ -17,6 +17,7 @@
 
 #include "mambaConv1dPlugin.h"
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include <algorithm>
 
 using namespace nvinfer1;
@@ -109,7 +110,13 @@ void MambaConv1dPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc const*
 size_t MambaConv1dPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
     nvinfer1::PluginTensorDesc const* outputs, int nbOutputs) const noexcept
 {
-    return 0;
+    if (!mPagedState || !tensorrt_llm::common::getEnvEnableRnnStateReuse())
+    {
+        return 0;
+    }
+    // The conv state of the slots, gathered before the context phase updates them in place
+    auto const batchSize = inputs[getHostRequestTypesIdx()].dims.d[0];
+    return batchSize * (mDConv - 1) * mDim * typeSize(mType);
 }
 
 void MambaConv1dPlugin::setMambaConv1dParams(tensorrt_llm::kernels::MambaConv1dParamsBase& params, const size_t batch,
@@ -185,6 +192,14 @@ int MambaConv1dPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc,
 
     if (reqTypes[0] == RequestType::kCONTEXT)
     {
+        if (mPagedState && tensorrt_llm::common::getEnvEnableRnnStateReuse())
+        {
+            // Resume from the state restored in the slot, see runtime::RnnStatePool. The kernel reads the previous
+            // state by sample while it updates the slots, so it reads a copy.
+            invokeMambaConv1dGatherState<T>(mambaConv1dParams, workspace, stream);
+            mambaConv1dParams.state_in_ptr = workspace;
+            mambaConv1dParams.load_initial_state = true;
+        }
         invokeMambaConv1dContext<T>(mambaConv1dParams, stream);
     }
     else if (reqTypes[0] == RequestType::kGENERATION)
@@ -16,8 +16,15 @@
  */
 #include "tensorrt_llm/plugins/mixtureOfExperts/mixtureOfExpertsPlugin.h"
 #include "tensorrt_llm/common/cudaBf16Wrapper.h"
+#include "tensorrt_llm/common/customAllReduceUtils.h"
 #include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/common/quantization.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
 #include <numeric>
 
 using namespace nvinfer1;
@@ -36,11 +43,59 @@ static char const* MIXTURE_OF_EXPERTS_PLUGIN_NAME{"MixtureOfExperts"};
 nvinfer1::PluginFieldCollection MixtureOfExpertsPluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> MixtureOfExpertsPluginCreator::mPluginAttributes;
 
+#if ENABLE_MULTI_DEVICE
+namespace
+{
+// Issues every chunk as an NCCL send/recv pair inside a single group, peers are ranks of the EP communicator
+class NcclMoeAllToAllTransport : public MoeAllToAllTransport
+{
+public:
+    explicit NcclMoeAllToAllTransport(std::shared_ptr<ncclComm_t> comm)
+        : mComm(std::move(comm))
+    {
+    }
+
+    void exchange(void const* send_buf, std::vector<std::vector<Chunk>> const& send_chunks, void* recv_buf,
+        std::vector<std::vector<Chunk>> const& recv_chunks, size_t row_bytes, cudaStream_t stream) override
+    {
+        auto const* send_ptr = static_cast<char const*>(send_buf);
+        auto* recv_ptr = static_cast<char*>(recv_buf);
+        NCCLCHECK(ncclGroupStart());
+        for (int peer = 0; peer < static_cast<int>(send_chunks.size()); ++peer)
+        {
+            for (auto const& chunk : send_chunks[peer])
+            {
+                if (chunk.num_rows > 0)
+                {
+                    NCCLCHECK(ncclSend(send_ptr + chunk.offset * row_bytes, chunk.num_rows * row_bytes, ncclUint8,
+                        peer, *mComm, stream));
+                }
+            }
+            for (auto const& chunk : recv_chunks[peer])
+            {
+                if (chunk.num_rows > 0)
+                {
+                    NCCLCHECK(ncclRecv(recv_ptr + chunk.offset * row_bytes, chunk.num_rows * row_bytes, ncclUint8,
+                        peer, *mComm, stream));
+                }
+            }
+        }
+        NCCLCHECK(ncclGroupEnd());
+    }
+
+private:
+    std::shared_ptr<ncclComm_t> mComm;
+};
+} // namespace
+#endif // ENABLE_MULTI_DEVICE
+
 MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(int number_of_experts, int top_k, int expert_hidden_size,
     int expert_inter_size, tensorrt_llm::ActivationType activation_type, nvinfer1::DataType type,
-    nvinfer1::DataType weight_type, nvinfer1::DataType output_type, QuantMode quant_mode, bool use_finished,
-    bool use_bias, int tp_size, int tp_rank, int ep_size, int ep_rank,
-    MOEExpertScaleNormalizationMode normalization_mode, MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr)
+    nvinfer1::DataType weight_type, nvinfer1::DataType output_type, QuantMode quant_mode, int group_size,
+    bool use_finished, bool use_bias, int tp_size, int tp_rank, int ep_size, int ep_rank, bool use_all_to_all,
+    std::set<int> ep_group, float capacity_factor, bool reroute_overflow, int num_shared_experts, bool fuse_all_reduce,
+    int all_reduce_counter, float norm_eps, MOEExpertScaleNormalizationMode normalization_mode,
+    MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr)
     : mNumExperts(number_of_experts)
     , mK(top_k)
     , mExpertHiddenSize(expert_hidden_size)
@@ -50,10 +105,19 @@ MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(int number_of_experts, int top_k,
     , mWeightType(weight_type)
     , mOutputType(output_type)
     , mQuantMode(quant_mode)
+    , mGroupSize(group_size)
     , mUseFinished(use_finished)
     , mUseBias(use_bias)
     , mParallelismConfig(MOEParallelismConfig{tp_size, tp_rank, ep_size, ep_rank})
     , mNormalizationMode(normalization_mode)
+    , mUseAllToAll(use_all_to_all)
+    , mEPGroup(std::move(ep_group))
+    , mCapacityFactor(capacity_factor)
+    , mRerouteOverflow(reroute_overflow)
+    , mNumSharedExperts(num_shared_experts)
+    , mFuseAllReduce(fuse_all_reduce)
+    , mAllReduceCounter(all_reduce_counter)
+    , mNormEps(norm_eps)
     , mPluginProfiler(std::move(plugin_profiler_ptr))
 {
     init();
@@ -70,13 +134,25 @@ tensorrt_llm::plugins::MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(MixtureOfE
     , mWeightType(other.mWeightType)
     , mOutputType(other.mOutputType)
     , mQuantMode(other.mQuantMode)
+    , mGroupSize(other.mGroupSize)
     , mUseFinished(other.mUseFinished)
     , mUseBias(other.mUseBias)
     , mParallelismConfig(other.mParallelismConfig)
     , mNormalizationMode(other.mNormalizationMode)
+    , mUseAllToAll(other.mUseAllToAll)
+    , mEPGroup(other.mEPGroup)
+    , mCapacityFactor(other.mCapacityFactor)
+    , mRerouteOverflow(other.mRerouteOverflow)
+    , mNumSharedExperts(other.mNumSharedExperts)
+    , mFuseAllReduce(other.mFuseAllReduce)
+    , mAllReduceCounter(other.mAllReduceCounter)
+    , mNormEps(other.mNormEps)
     , mDims(other.mDims)
     , mGemmId(other.mGemmId)
     , mPluginProfiler(other.mPluginProfiler)
+    , mAllToAllTransport(other.mAllToAllTransport)
+    , mExpertLoad(other.mExpertLoad)
+    , mRoutingDumpLayer(other.mRoutingDumpLayer)
     , mLayerName(other.mLayerName)
     , mNamespace(other.mNamespace)
 {
@@ -87,8 +163,11 @@ size_t MixtureOfExpertsPlugin::getSerializationSize() const noexcept
 {
     return sizeof(mNumExperts) + sizeof(mK) + sizeof(mExpertHiddenSize) + sizeof(mExpertInterSize)
         + sizeof(mActivationType) + sizeof(mType) + sizeof(mWeightType) + sizeof(mOutputType)
-        + sizeof(QuantMode::BaseType) + sizeof(mUseFinished) + sizeof(mUseBias) + sizeof(mParallelismConfig)
-        + sizeof(mNormalizationMode) + sizeof(mDims) + mPluginProfiler->getSerializationSize(mGemmId);
+        + sizeof(QuantMode::BaseType) + sizeof(mGroupSize) + sizeof(mUseFinished) + sizeof(mUseBias)
+        + sizeof(mParallelismConfig) + sizeof(mNormalizationMode) + sizeof(mUseAllToAll) + sizeof(int)
+        + sizeof(int) * mEPGroup.size() + sizeof(mCapacityFactor) + sizeof(mRerouteOverflow)
+        + sizeof(mNumSharedExperts) + sizeof(mFuseAllReduce) + sizeof(mAllReduceCounter) + sizeof(mNormEps)
+        + sizeof(mDims) + mPluginProfiler->getSerializationSize(mGemmId);
 }
 
 MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(
@@ -108,10 +187,26 @@ MixtureOfExpertsPlugin::MixtureOfExpertsPlugin(
     QuantMode::BaseType quant_mode;
     read(d, quant_mode);
     mQuantMode = QuantMode{quant_mode};
+    read(d, mGroupSize);
     read(d, mUseFinished);
     read(d, mUseBias);
     read(d, mParallelismConfig);
     read(d, mNormalizationMode);
+    read(d, mUseAllToAll);
+    int ep_group_size = 0;
+    read(d, ep_group_size);
+    for (int i = 0; i < ep_group_size; ++i)
+    {
+        int group_item = 0;
+        read(d, group_item);
+        mEPGroup.insert(group_item);
+    }
+    read(d, mCapacityFactor);
+    read(d, mRerouteOverflow);
+    read(d, mNumSharedExperts);
+    read(d, mFuseAllReduce);
+    read(d, mAllReduceCounter);
+    read(d, mNormEps);
     read(d, mDims);
 
     init();
@@ -137,10 +232,23 @@ void MixtureOfExpertsPlugin::serialize(void* buffer) const noexcept
     write(d, mWeightType);
     write(d, mOutputType);
     write(d, mQuantMode.value());
+    write(d, mGroupSize);
     write(d, mUseFinished);
     write(d, mUseBias);
     write(d, mParallelismConfig);
     write(d, mNormalizationMode);
+    write(d, mUseAllToAll);
+    write(d, static_cast<int>(mEPGroup.size()));
+    for (int group_item : mEPGroup)
+    {
+        write(d, group_item);
+    }
+    write(d, mCapacityFactor);
+    write(d, mRerouteOverflow);
+    write(d, mNumSharedExperts);
+    write(d, mFuseAllReduce);
+    write(d, mAllReduceCounter);
+    write(d, mNormEps);
     write(d, mDims);
 
     mPluginProfiler->serialize(d, mGemmId);
@@ -152,6 +260,8 @@ void MixtureOfExpertsPlugin::init()
 {
     TLLM_CHECK_WITH_INFO(
         mType == DataType::kFP8 || mOutputType == mType, "MOE plugin only supports a different output type for FP8");
+    TLLM_CHECK_WITH_INFO(mGroupSize == 0 || hasExpertIntQuantScales(),
+        "MOE plugin only supports groupwise scales for weight only quantization");
 
     if (mType == DataType::kHALF && mWeightType == DataType::kHALF)
     {
@@ -217,8 +327,58 @@ void MixtureOfExpertsPlugin::init()
             static_cast<int>(mType), static_cast<int>(mWeightType));
     }
 
+    if (mUseAllToAll)
+    {
+#if !ENABLE_MULTI_DEVICE
+        TLLM_THROW("All-to-all expert parallelism requires a multi-device build");
+#endif
+        TLLM_CHECK_WITH_INFO(!mUseBias, "Bias is not supported with all-to-all expert parallelism");
+        TLLM_CHECK_WITH_INFO(static_cast<int>(mEPGroup.size()) == mParallelismConfig.ep_size,
+            "All-to-all expert parallelism needs the %d ranks of the EP group, got %d", mParallelismConfig.ep_size,
+            static_cast<int>(mEPGroup.size()));
+    }
+    mMOERunner->use_all_to_all = mUseAllToAll;
+    mMOERunner->all_to_all_transport = mAllToAllTransport;
+
+    TLLM_CHECK_WITH_INFO(mCapacityFactor >= 0.f, "Expert capacity factor must not be negative");
+    TLLM_CHECK_WITH_INFO(mCapacityFactor == 0.f || !mUseAllToAll,
+        "Expert capacity is not supported with all-to-all expert parallelism");
+    mMOERunner->capacity_factor = mCapacityFactor;
+    mMOERunner->reroute_overflow = mRerouteOverflow;
+
+    TLLM_CHECK_WITH_INFO(mNumSharedExperts >= 0, "Number of shared experts must not be negative");
+    TLLM_CHECK_WITH_INFO(mNumSharedExperts == 0 || !mUseAllToAll,
+        "Shared experts are not supported with all-to-all expert parallelism");
+    mMOERunner->num_shared_experts = mNumSharedExperts;
+
+    if (mFuseAllReduce)
+    {
+        TLLM_CHECK_WITH_INFO(mOutputType == mType, "The fused all reduce requires the output in the activation type");
+        TLLM_CHECK_WITH_INFO(!mUseAllToAll, "The fused all reduce is not supported with all-to-all expert parallelism");
+    }
+
+    // Copies of the plugin share the counters of the layer they were cloned from
+    if (!mExpertLoad && tensorrt_llm::common::getEnvEnableMoeLoadStats())
+    {
+        auto const experts_per_node = mNumExperts / mParallelismConfig.ep_size;
+        mExpertLoad = tensorrt_llm::runtime::MoeExpertLoadTracker::getInstance().addLayer(
+            mParallelismConfig.ep_rank * experts_per_node, experts_per_node);
+    }
+    mMOERunner->expert_load_counts
+        = mExpertLoad ? tensorrt_llm::runtime::bufferCast<int64_t>(*mExpertLoad->counts) : nullptr;
+    mMOERunner->expert_overflow_counts = mExpertLoad && mCapacityFactor > 0.f
+        ? tensorrt_llm::runtime::bufferCast<int64_t>(*mExpertLoad->overflow)
+        : nullptr;
+
+    // Layers are numbered in construction order, which is the order of the layers in the engine
+    if (mRoutingDumpLayer < 0 && tensorrt_llm::common::getEnvMoeRoutingDumpDir())
+    {
+        static std::atomic<int> num_dumped_layers{0};
+        mRoutingDumpLayer = num_dumped_layers++;
+    }
+
     mGemmId = GemmIDMoe{mNumExperts, mK, mParallelismConfig, mExpertHiddenSize, mExpertInterSize, mActivationType,
-        mType, mWeightType, mQuantMode};
+        mType, mWeightType, mQuantMode, mGroupSize};
 }
 
 // IPluginV2DynamicExt Methods
@@ -232,7 +392,7 @@ nvinfer1::IPluginV2DynamicExt* MixtureOfExpertsPlugin::clone() const noexcept
 nvinfer1::DimsExprs MixtureOfExpertsPlugin::getOutputDimensions(
     int outputIndex, nvinfer1::DimsExprs const* inputs, int nbInputs, nvinfer1::IExprBuilder& exprBuilder) noexcept
 {
-    assert(outputIndex == getOutputTensorIndex());
+    assert(outputIndex == getOutputTensorIndex() || (hasFusedAllReduce() && outputIndex == getResidualOutputIndex()));
     return inputs[getInputTensorIndex()];
 }
 
@@ -260,6 +420,10 @@ bool MixtureOfExpertsPlugin::supportsFormatCombination(
     {
         return (inOut[pos].type == DataType::kFLOAT);
     }
+    else if (hasFusedAllReduce() && pos == getAllReduceWorkspaceIndex())
+    {
+        return (inOut[pos].type == DataType::kINT64);
+    }
     else if (pos == nbInputs + getOutputTensorIndex())
     {
         return inOut[pos].type == mOutputType;
@@ -308,7 +472,7 @@ void MixtureOfExpertsPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc c
         mDims = {minM, maxM, maxN, maxK};
     }
     mGemmId = GemmIDMoe{mNumExperts, mK, mParallelismConfig, mExpertHiddenSize, mExpertInterSize, mActivationType,
-        mType, mWeightType, mQuantMode};
+        mType, mWeightType, mQuantMode, mGroupSize};
 }
 
 auto MixtureOfExpertsPlugin::setupWorkspace(void* base_ptr, int64_t num_tokens) const -> WorkspaceInfo
@@ -318,14 +482,17 @@ auto MixtureOfExpertsPlugin::setupWorkspace(void* base_ptr, int64_t num_tokens)
     size_t moe_workspace_size = mMOERunner->getWorkspaceSize(
         num_tokens, mExpertHiddenSize, mExpertInterSize, mNumExperts, mK, mActivationType, mParallelismConfig);
 
+    // Every token also goes to the shared experts
+    int64_t const experts_per_token = mK + mNumSharedExperts;
+
     // Output of post-softmax routing probabilities
-    size_t scale_probabilities_size = num_tokens * mNumExperts * sizeof(float);
+    size_t scale_probabilities_size = num_tokens * std::max<int64_t>(mNumExperts, experts_per_token) * sizeof(float);
 
     // Permutation map
-    size_t src_to_dest_map_size = mK * num_tokens * sizeof(int);
+    size_t src_to_dest_map_size = experts_per_token * num_tokens * sizeof(int);
 
     // Selected expert map
-    size_t selected_expert_size = mK * num_tokens * sizeof(int);
+    size_t selected_expert_size = experts_per_token * num_tokens * sizeof(int);
 
     std::vector<size_t> workspaces{
         moe_workspace_size,
@@ -382,7 +549,8 @@ QuantParams tensorrt_llm::plugins::MixtureOfExpertsPlugin::getQuantParams(
     if (hasExpertIntQuantScales())
     {
         TLLM_CHECK(scale_1 && scale_2);
-        return QuantParams::Int(scale_1, scale_2);
+        return mGroupSize > 0 ? QuantParams::GroupwiseInt(scale_1, scale_2, mGroupSize)
+                              : QuantParams::Int(scale_1, scale_2);
     }
     else if (hasExpertFp8QuantScales())
     {
@@ -398,6 +566,11 @@ int MixtureOfExpertsPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     nvinfer1::PluginTensorDesc const* outputDesc, void const* const* inputs, void* const* outputs, void* workspace_ptr,
     cudaStream_t stream) noexcept
 {
+    if (hasFusedAllReduce() && isBuilding())
+    {
+        return 0;
+    }
+
     int64_t const num_tokens = getNumTokens(inputDesc);
     int64_t const num_not_finished = num_tokens; // TODO Take this as an input
 
@@ -406,7 +579,7 @@ int MixtureOfExpertsPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     auto w1_desc = inputDesc[getExpertWeights1Index()];
     auto w2_desc = inputDesc[getExpertWeights2Index()];
     TLLM_CHECK(w1_desc.dims.nbDims == 3);
-    size_t experts_per_node = mNumExperts / mParallelismConfig.ep_size;
+    size_t experts_per_node = mNumExperts / mParallelismConfig.ep_size + mNumSharedExperts;
     TLLM_CHECK(w1_desc.dims.d[0] == experts_per_node);
     TLLM_CHECK(w2_desc.dims.nbDims == 3);
     TLLM_CHECK(w2_desc.dims.d[0] == experts_per_node);
@@ -441,6 +614,29 @@ int MixtureOfExpertsPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
             hasExpertFp8FinalQuantScales() ? inputs[getExpertFP8QuantFinalIndex()] : nullptr);
     }
 
+    AllReduceParams all_reduce_params;
+    if (hasFusedAllReduce())
+    {
+        auto const group_size = mParallelismConfig.tp_size * mParallelismConfig.ep_size;
+        auto const message_elts = num_tokens * mExpertHiddenSize;
+        auto const message_size = message_elts * tensorrt_llm::common::getDTypeSize(mType);
+        auto const max_size = tensorrt_llm::utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(group_size);
+        TLLM_CHECK_WITH_INFO(
+            message_size <= max_size, "MoE output of %zu bytes does not fit the all reduce workspace", message_size);
+        TLLM_CHECK_WITH_INFO(configurationSupported(AllReduceStrategyType::ONESHOT, message_elts, group_size, mType),
+            "The fused all reduce does not support the MoE output shape");
+        all_reduce_params = AllReduceParams::deserialize(
+            static_cast<int32_t const*>(inputs[getAllReduceWorkspaceIndex()]), group_size,
+            COMM_SESSION.getRank() % group_size, mAllReduceCounter);
+        all_reduce_params.fusion_params.residual_buffer = inputs[getResidualIndex()];
+        all_reduce_params.fusion_params.weight_buffer = inputs[getNormWeightIndex()];
+        all_reduce_params.fusion_params.eps = mNormEps;
+        all_reduce_params.fusion_params.intermediate_buffer = outputs[getResidualOutputIndex()];
+        mMOERunner->fused_all_reduce = &all_reduce_params;
+        // The strategy the AllReduce plugin picks for decode sized messages, finalize and norm run in its kernel
+        mMOERunner->fused_all_reduce_strategy = AllReduceStrategyType::ONESHOT;
+    }
+
     mMOERunner->setTactic(mPluginProfiler->getBestConfig(num_tokens, mGemmId));
     mMOERunner->runMoe(inputs[getInputTensorIndex()], static_cast<float const*>(inputs[getRoutingTensorIndex()]),
         inputs[getExpertWeights1Index()], hasBias() ? inputs[getExpertBias1Index()] : nullptr, mActivationType,
@@ -451,15 +647,47 @@ int MixtureOfExpertsPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
         hasFinishedTensor() ? static_cast<bool const*>(inputs[getFinishedTensorIndex()]) : nullptr, num_not_finished,
         workspace.scale_probs, static_cast<int*>(workspace.src_to_dest_map),
         static_cast<int*>(workspace.selected_experts), mParallelismConfig, mNormalizationMode, stream);
+    mMOERunner->fused_all_reduce = nullptr;
+
+    if (mRoutingDumpLayer >= 0)
+    {
+        dumpRouting(static_cast<float const*>(inputs[getRoutingTensorIndex()]), num_tokens, stream);
+    }
 
     return 0;
 }
 
+void MixtureOfExpertsPlugin::dumpRouting(float const* router_logits, int64_t num_tokens, cudaStream_t stream) const
+{
+    cudaStreamCaptureStatus capture_status;
+    TLLM_CUDA_CHECK(cudaStreamIsCapturing(stream, &capture_status));
+    if (capture_status != cudaStreamCaptureStatusNone)
+    {
+        TLLM_LOG_WARNING("Router logits are not dumped while capturing a CUDA graph");
+        return;
+    }
+
+    std::vector<float> logits(num_tokens * mNumExperts);
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(
+        logits.data(), router_logits, logits.size() * sizeof(float), cudaMemcpyDeviceToHost, stream));
+    TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+
+    // Raw float32 rows of num_experts logits, appended for every enqueue. This is the format of "routing_trace" in
+    // the MoE micro benchmark
+    auto const path = std::filesystem::path{*tensorrt_llm::common::getEnvMoeRoutingDumpDir()}
+        / ("moe_routing_layer" + std::to_string(mRoutingDumpLayer) + "_tp" + std::to_string(mParallelismConfig.tp_rank)
+            + "_ep" + std::to_string(mParallelismConfig.ep_rank) + ".bin");
+    std::ofstream file{path, std::ios::binary | std::ios::app};
+    TLLM_CHECK_WITH_INFO(file.good(), "Error opening MoE routing dump %s", path.string().c_str());
+    file.write(
+        reinterpret_cast<char const*>(logits.data()), static_cast<std::streamsize>(logits.size() * sizeof(float)));
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType MixtureOfExpertsPlugin::getOutputDataType(
     int index, nvinfer1::DataType const* inputTypes, int nbInputs) const noexcept
 {
-    TLLM_CHECK(index == getOutputTensorIndex());
+    TLLM_CHECK(index == getOutputTensorIndex() || (hasFusedAllReduce() && index == getResidualOutputIndex()));
     TLLM_CHECK(inputTypes[getInputTensorIndex()] == mType);
     return mOutputType;
 }
@@ -478,6 +706,13 @@ char const* MixtureOfExpertsPlugin::getPluginVersion() const noexcept
 int MixtureOfExpertsPlugin::initialize() noexcept
 {
     mPluginProfiler->profileTactics(this, mType, mDims, mGemmId);
+#if ENABLE_MULTI_DEVICE
+    if (mUseAllToAll && mParallelismConfig.ep_size > 1 && !isBuilding() && !mAllToAllTransport)
+    {
+        mAllToAllTransport = std::make_shared<NcclMoeAllToAllTransport>(getComm(mEPGroup));
+        mMOERunner->all_to_all_transport = mAllToAllTransport;
+    }
+#endif
     return 0;
 }
 
@@ -533,6 +768,7 @@ MixtureOfExpertsPluginCreator::MixtureOfExpertsPluginCreator()
         nvinfer1::PluginField("weight_type_id", nullptr, PluginFieldType::kINT32, static_cast<int>(DataType::kHALF)));
     mPluginAttributes.emplace_back(
         nvinfer1::PluginField("quant_mode", nullptr, PluginFieldType::kINT32, static_cast<int>(DataType::kHALF)));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("group_size", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(nvinfer1::PluginField("use_finished", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(nvinfer1::PluginField("use_bias", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(nvinfer1::PluginField("tp_size", nullptr, PluginFieldType::kINT32, 1));
@@ -541,6 +777,14 @@ MixtureOfExpertsPluginCreator::MixtureOfExpertsPluginCreator()
     mPluginAttributes.emplace_back(nvinfer1::PluginField("ep_rank", nullptr, PluginFieldType::kINT32, 0));
     mPluginAttributes.emplace_back(nvinfer1::PluginField("normalization_mode", nullptr, PluginFieldType::kINT32,
         static_cast<int>(MOEExpertScaleNormalizationMode::NONE)));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("use_all_to_all", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("ep_group", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("capacity_factor", nullptr, PluginFieldType::kFLOAT32, 1));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("reroute_overflow", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("num_shared_experts", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("fuse_all_reduce", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("all_reduce_counter", nullptr, PluginFieldType::kINT32, 0));
+    mPluginAttributes.emplace_back(nvinfer1::PluginField("norm_eps", nullptr, PluginFieldType::kFLOAT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -558,6 +802,7 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
     int mWeightType{};
     int mOutputType{INT_MAX};
     int mQuantMode{};
+    int mGroupSize{0};
     int mUseFinished{0};
     int mUseBias{0};
     int mTPSize{};
@@ -565,6 +810,14 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
     int mEPSize{};
     int mEPRank{};
     int mNormalizationMode{};
+    int mUseAllToAll{0};
+    std::set<int> mEPGroup;
+    float mCapacityFactor{0.f};
+    int mRerouteOverflow{0};
+    int mNumSharedExperts{0};
+    int mFuseAllReduce{0};
+    int mAllReduceCounter{0};
+    float mNormEps{1e-6f};
 
     // Read configurations from each fields
     struct MapPair
@@ -591,13 +844,38 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
         MapPair{"normalization_mode", std::ref(mNormalizationMode)},
 
         // Optional
+        MapPair{"group_size", std::ref(mGroupSize), true},
         MapPair{"use_finished", std::ref(mUseFinished), true},
         MapPair{"use_bias", std::ref(mUseBias), true},
         MapPair{"output_type_id", std::ref(mOutputType), true},
+        MapPair{"use_all_to_all", std::ref(mUseAllToAll), true},
+        MapPair{"reroute_overflow", std::ref(mRerouteOverflow), true},
+        MapPair{"num_shared_experts", std::ref(mNumSharedExperts), true},
+        MapPair{"fuse_all_reduce", std::ref(mFuseAllReduce), true},
+        MapPair{"all_reduce_counter", std::ref(mAllReduceCounter), true},
     };
     for (int i = 0; i < fc->nbFields; ++i)
     {
         char const* attrName = fields[i].name;
+        if (!strcmp(attrName, "ep_group"))
+        {
+            TLLM_CHECK(fields[i].type == nvinfer1::PluginFieldType::kINT32);
+            auto const* r = static_cast<int const*>(fields[i].data);
+            for (int j = 0; j < fields[i].length; ++j)
+            {
+                mEPGroup.insert(r[j]);
+            }
+        }
+        if (!strcmp(attrName, "capacity_factor"))
+        {
+            TLLM_CHECK(fields[i].type == nvinfer1::PluginFieldType::kFLOAT32);
+            mCapacityFactor = *static_cast<float const*>(fields[i].data);
+        }
+        if (!strcmp(attrName, "norm_eps"))
+        {
+            TLLM_CHECK(fields[i].type == nvinfer1::PluginFieldType::kFLOAT32);
+            mNormEps = *static_cast<float const*>(fields[i].data);
+        }
         for (auto& item : input_map)
         {
             if (!strcmp(item.key, attrName))
@@ -629,7 +907,9 @@ IPluginV2* MixtureOfExpertsPluginCreator::createPlugin(
             mNumExperts, mK, mExpertHiddenSize, mExpertInterSize,
             static_cast<tensorrt_llm::ActivationType>(mActivationType), static_cast<nvinfer1::DataType>(mType),
             static_cast<nvinfer1::DataType>(mWeightType), static_cast<nvinfer1::DataType>(mOutputType),
-            QuantMode(mQuantMode), mUseFinished != 0, mUseBias != 0, mTPSize, mTPRank, mEPSize, mEPRank,
+            QuantMode(mQuantMode), mGroupSize, mUseFinished != 0, mUseBias != 0, mTPSize, mTPRank, mEPSize, mEPRank,
+            mUseAllToAll != 0, mEPGroup, mCapacityFactor, mRerouteOverflow != 0, mNumSharedExperts,
+            mFuseAllReduce != 0, mAllReduceCounter, mNormEps,
             static_cast<MOEExpertScaleNormalizationMode>(mNormalizationMode), pluginProfiler);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
@@ -685,6 +965,8 @@ std::vector<size_t> MixtureOfExpertsGemmProfiler::getProfilerWorkspaces(int maxM
     size_t hidden_size = plugin.mExpertHiddenSize;
     size_t inter_size = plugin.mExpertInterSize;
     size_t num_experts = plugin.mNumExperts;
+    // The weights of the shared experts follow the routed experts
+    size_t num_weight_experts = num_experts + plugin.mNumSharedExperts;
 
     size_t fc1_out_size = inter_size;
     if (isGatedActivation(plugin.mActivationType))
@@ -695,21 +977,28 @@ std::vector<size_t> MixtureOfExpertsGemmProfiler::getProfilerWorkspaces(int maxM
     size_t input_size = hidden_size * num_tokens * dtype_bytes;
     size_t routing_weights = num_experts * num_tokens * sizeof(float);
 
-    size_t weights_1 = hidden_size * fc1_out_size * num_experts * weight_bytes;
+    size_t weights_1 = hidden_size * fc1_out_size * num_weight_experts * weight_bytes;
+
+    // Groupwise scales hold one row per group along K
+    size_t fc1_scale_rows = plugin.mGroupSize > 0 ? hidden_size / plugin.mGroupSize : 1;
+    size_t fc2_scale_rows = plugin.mGroupSize > 0 ? inter_size / plugin.mGroupSize : 1;
 
-    size_t quant_1 = plugin.hasExpertIntQuantScales() ? fc1_out_size * num_experts * dtype_bytes : 0;
-    quant_1 = plugin.hasExpertFp8QuantScales() ? num_experts * sizeof(float) : quant_1;
+    size_t quant_1 = plugin.hasExpertIntQuantScales()
+        ? fc1_scale_rows * fc1_out_size * num_weight_experts * dtype_bytes
+        : 0;
+    quant_1 = plugin.hasExpertFp8QuantScales() ? num_weight_experts * sizeof(float) : quant_1;
 
-    size_t bias_1 = plugin.hasBias() ? fc1_out_size * num_experts * dtype_bytes : 0;
+    size_t bias_1 = plugin.hasBias() ? fc1_out_size * num_weight_experts * dtype_bytes : 0;
 
-    size_t weights_2 = hidden_size * inter_size * num_experts * weight_bytes;
+    size_t weights_2 = hidden_size * inter_size * num_weight_experts * weight_bytes;
 
-    size_t quant_2 = plugin.hasExpertIntQuantScales() ? hidden_size * num_experts * dtype_bytes : 0;
+    size_t quant_2
+        = plugin.hasExpertIntQuantScales() ? fc2_scale_rows * hidden_size * num_weight_experts * dtype_bytes : 0;
     quant_2 = plugin.hasExpertFp8QuantScales() ? sizeof(float) : quant_2;
 
-    size_t bias_2 = plugin.hasBias() ? hidden_size * num_experts * dtype_bytes : 0;
+    size_t bias_2 = plugin.hasBias() ? hidden_size * num_weight_experts * dtype_bytes : 0;
 
-    size_t quant_3 = plugin.hasExpertFp8QuantScales() ? num_experts * sizeof(float) : 0;
+    size_t quant_3 = plugin.hasExpertFp8QuantScales() ? num_weight_experts * sizeof(float) : 0;
     size_t quant_4 = plugin.hasExpertFp8FinalQuantScales() ? sizeof(float) : 0;
 
     size_t output = hidden_size * num_tokens * output_bytes;
@@ -21,6 +21,7 @@
 #include "tensorrt_llm/common/quantization.h"
 #include "tensorrt_llm/kernels/mixtureOfExperts/moe_kernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/runtime/moeLoadBalancer.h"
 #include <cassert>
 #include <set>
 #include <string>
@@ -43,21 +44,22 @@ struct GemmIDMoe
     nvinfer1::DataType dtype{};
     nvinfer1::DataType wdtype{};
     tensorrt_llm::common::QuantMode quant_mode;
+    int group_size{};
 
     bool operator==(GemmIDMoe const& id) const
     {
         return id.num_experts == num_experts && id.moe_k == moe_k && id.parallelism_config == parallelism_config
             && id.hidden == hidden && id.inter == inter && id.actfn == actfn && id.dtype == dtype && id.wdtype == wdtype
-            && id.quant_mode == quant_mode;
+            && id.quant_mode == quant_mode && id.group_size == group_size;
     }
 
     friend std::ostream& operator<<(std::ostream& out, GemmIDMoe const& id)
     {
         out << "experts, k, parallelism_config, hidden, inter, actfn, dtype, weight "
-               "type, parallelism mode="
+               "type, parallelism mode, group size="
             << id.num_experts << "," << id.moe_k << "," << id.parallelism_config << "," << id.hidden << "," << id.inter
             << "," << static_cast<int>(id.actfn) << "," << static_cast<int>(id.dtype) << ","
-            << static_cast<int>(id.wdtype) << "," << id.quant_mode.value();
+            << static_cast<int>(id.wdtype) << "," << id.quant_mode.value() << "," << id.group_size;
         return out;
     }
 };
@@ -79,6 +81,7 @@ struct GemmIDMoeHash
         hash ^= std::hash<int>{}(static_cast<int>(id.dtype));
         hash ^= std::hash<int>{}(static_cast<int>(id.wdtype));
         hash ^= std::hash<int>{}(static_cast<int>(id.quant_mode.value()));
+        hash ^= std::hash<int>{}(id.group_size);
         return hash;
     }
 };
@@ -92,13 +95,16 @@ public:
     MixtureOfExpertsPlugin() = delete;
     MixtureOfExpertsPlugin(int number_of_experts, int top_k, int expert_hidden_size, int expert_inter_size,
         tensorrt_llm::ActivationType activation_type, nvinfer1::DataType type, nvinfer1::DataType weight_type,
-        nvinfer1::DataType output_type, tensorrt_llm::common::QuantMode quant_mode, bool use_finished, bool use_bias,
-        int tp_size, int tp_rank, int ep_size, int ep_rank, MOEExpertScaleNormalizationMode normalization_mode,
+        nvinfer1::DataType output_type, tensorrt_llm::common::QuantMode quant_mode, int group_size, bool use_finished,
+        bool use_bias, int tp_size, int tp_rank, int ep_size, int ep_rank, bool use_all_to_all, std::set<int> ep_group,
+        float capacity_factor, bool reroute_overflow, int num_shared_experts, bool fuse_all_reduce,
+        int all_reduce_counter, float norm_eps, MOEExpertScaleNormalizationMode normalization_mode,
         MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr);
     MixtureOfExpertsPlugin(void const* data, size_t length, MixtureOfExpertsPluginProfilerPtr plugin_profiler_ptr);
     MixtureOfExpertsPlugin(MixtureOfExpertsPlugin const&);
 
     void init();
+    void dumpRouting(float const* router_logits, int64_t num_tokens, cudaStream_t stream) const;
 
     ~MixtureOfExpertsPlugin() override = default;
 
@@ -125,7 +131,7 @@ public:
 
     int getNbOutputs() const noexcept override
     {
-        return 1;
+        return 1 + hasFusedAllReduce();
     }
 
     int initialize() noexcept override;
@@ -148,10 +154,27 @@ private:
     nvinfer1::DataType mWeightType{};
     nvinfer1::DataType mOutputType{};
     tensorrt_llm::common::QuantMode mQuantMode;
+    // Group size of the int weight scales along K, 0 for per channel scales
+    int mGroupSize{};
     bool mUseFinished{};
     bool mUseBias{};
     MOEParallelismConfig mParallelismConfig{};
     MOEExpertScaleNormalizationMode mNormalizationMode{};
+    // Dispatch tokens to the ranks owning their experts instead of combining the results with an allreduce. The output
+    // is then complete over the EP group, the graph must not add the EP allreduce
+    bool mUseAllToAll{};
+    std::set<int> mEPGroup{};
+    // Rows beyond the capacity of an expert are rerouted or dropped, see CutlassMoeFCRunnerInterface::capacity_factor
+    float mCapacityFactor{};
+    bool mRerouteOverflow{};
+    // Shared experts follow the routed experts in the weight tensors, see CutlassMoeFCRunnerInterface
+    int mNumSharedExperts{};
+    // Reduce the expert outputs with the custom all reduce across the TP and EP ranks, then add the residual and apply
+    // the RMS norm of the next layer. The outputs are the normalized hidden states and the new residual, the graph
+    // must not add the allreduce. The counter plays the role of the AllReduce plugin counter
+    bool mFuseAllReduce{};
+    int mAllReduceCounter{};
+    float mNormEps{};
 
     GemmDims mDims{};
 
@@ -160,6 +183,11 @@ private:
 
     MixtureOfExpertsPluginProfilerPtr mPluginProfiler;
 
+    std::shared_ptr<kernels::MoeAllToAllTransport> mAllToAllTransport;
+    std::shared_ptr<tensorrt_llm::runtime::MoeExpertLoadTracker::Layer> mExpertLoad;
+    // Index of the layer in the router logits dumps, -1 when TRTLLM_MOE_ROUTING_DUMP_DIR is not set
+    int mRoutingDumpLayer{-1};
+
     const std::string mLayerName{};
     std::string mNamespace{};
 
@@ -229,6 +257,11 @@ private:
         return hasExpertFp8QuantScales() && mOutputType == nvinfer1::DataType::kFP8;
     }
 
+    bool hasFusedAllReduce() const
+    {
+        return mFuseAllReduce;
+    }
+
     IndexType getExpertBias1Index() const
     {
         return getExpertWeights2Index() + hasBias();
@@ -274,9 +307,24 @@ private:
         return getExpertFP8Dequant2Index() + hasExpertFp8FinalQuantScales();
     }
 
+    IndexType getAllReduceWorkspaceIndex() const
+    {
+        return getExpertFP8QuantFinalIndex() + hasFusedAllReduce();
+    }
+
+    IndexType getResidualIndex() const
+    {
+        return getAllReduceWorkspaceIndex() + hasFusedAllReduce();
+    }
+
+    IndexType getNormWeightIndex() const
+    {
+        return getResidualIndex() + hasFusedAllReduce();
+    }
+
     IndexType getNbInputs() const
     {
-        return getExpertFP8QuantFinalIndex() + 1;
+        return getNormWeightIndex() + 1;
     }
 
     // Outputs
@@ -285,6 +333,11 @@ private:
         return 0;
     }
 
+    constexpr static IndexType getResidualOutputIndex()
+    {
+        return getOutputTensorIndex() + 1;
+    }
+
     /**
      * Get the index of the expert shape tuple that represents the inner dimension
      */
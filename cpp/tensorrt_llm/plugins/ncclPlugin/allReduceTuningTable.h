@@ -0,0 +1,171 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// Fastest allreduce candidate of each message size bucket, measured by the AUTO strategy tuning of AllreducePlugin and
+// persisted per GPU, group size, link type and dtype. The buckets are given by their upper bound in bytes, doubling
+// from 1 KB up to the largest message, and a message takes the candidate of the first bucket that holds it.
+class AllReduceTuningTable
+{
+public:
+    AllReduceTuningTable(std::vector<std::size_t> sizes, std::vector<int32_t> candidates)
+        : mSizes(std::move(sizes))
+        , mCandidates(std::move(candidates))
+    {
+        TLLM_CHECK(mSizes.size() == mCandidates.size());
+    }
+
+    // Upper bounds of the tuned message sizes, doubling from 1 KB up to maxMessageBytes
+    static std::vector<std::size_t> getMessageSizes(std::size_t maxMessageBytes)
+    {
+        TLLM_CHECK(maxMessageBytes > 0);
+        std::vector<std::size_t> sizes;
+        for (std::size_t size = 1024; size < maxMessageBytes; size *= 2)
+        {
+            sizes.push_back(size);
+        }
+        sizes.push_back(maxMessageBytes);
+        return sizes;
+    }
+
+    // File of the table in cacheDir, the characters of the GPU name that don't belong in a file name are replaced
+    static std::filesystem::path getCachePath(
+        std::string const& cacheDir, std::string gpuName, int worldSize, bool isNVLINK, int dtype)
+    {
+        std::replace_if(
+            gpuName.begin(), gpuName.end(), [](char c) { return !std::isalnum(static_cast<unsigned char>(c)); }, '_');
+        return std::filesystem::path(cacheDir)
+            / ("allreduce_" + gpuName + "_tp" + std::to_string(worldSize) + (isNVLINK ? "_nvlink" : "_pcie") + "_dtype"
+                + std::to_string(dtype) + ".txt");
+    }
+
+    // Index of the fastest candidate of each size, from the times of the candidates of each size in a row
+    static std::vector<int32_t> getFastest(std::vector<float> const& times, std::size_t numCandidates)
+    {
+        TLLM_CHECK(numCandidates > 0 && times.size() % numCandidates == 0);
+        std::vector<int32_t> fastest(times.size() / numCandidates);
+        for (std::size_t i = 0; i < fastest.size(); ++i)
+        {
+            auto const first = times.begin() + i * numCandidates;
+            fastest[i] = static_cast<int32_t>(std::min_element(first, first + numCandidates) - first);
+        }
+        return fastest;
+    }
+
+    // The table stored at path, if it has exactly the buckets `sizes` and valid candidates. One line per bucket: its
+    // upper bound in bytes and the index of its fastest candidate.
+    static std::optional<AllReduceTuningTable> load(
+        std::filesystem::path const& path, std::vector<std::size_t> const& sizes, std::size_t numCandidates)
+    {
+        std::ifstream file(path);
+        if (!file.good())
+        {
+            return std::nullopt;
+        }
+        std::vector<int32_t> candidates;
+        std::size_t size;
+        int32_t candidate;
+        while (file >> size >> candidate)
+        {
+            if (candidates.size() == sizes.size() || size != sizes[candidates.size()] || candidate < 0
+                || candidate >= static_cast<int32_t>(numCandidates))
+            {
+                return std::nullopt;
+            }
+            candidates.push_back(candidate);
+        }
+        if (!file.eof() || candidates.size() != sizes.size())
+        {
+            return std::nullopt;
+        }
+        return AllReduceTuningTable{sizes, std::move(candidates)};
+    }
+
+    // Writes the table to path through a temporary file, so that concurrent readers never see a partial table.
+    // \returns false if the table can't be written
+    bool save(std::filesystem::path const& path) const noexcept
+    {
+        try
+        {
+            std::filesystem::create_directories(path.parent_path());
+            auto tmpPath = path;
+            tmpPath += ".tmp." + std::to_string(std::random_device{}());
+            {
+                std::ofstream file(tmpPath, std::ios::trunc);
+                for (std::size_t i = 0; i < mSizes.size(); ++i)
+                {
+                    file << mSizes[i] << " " << mCandidates[i] << "\n";
+                }
+                if (!file.good())
+                {
+                    std::filesystem::remove(tmpPath);
+                    return false;
+                }
+            }
+            std::filesystem::rename(tmpPath, path);
+            return true;
+        }
+        catch (std::exception const&)
+        {
+            return false;
+        }
+    }
+
+    // Candidate of the first bucket that holds a message of messageBytes, none if it is larger than all buckets
+    std::optional<int32_t> find(std::size_t messageBytes) const
+    {
+        auto const it = std::lower_bound(mSizes.begin(), mSizes.end(), messageBytes);
+        if (it == mSizes.end())
+        {
+            return std::nullopt;
+        }
+        return mCandidates[it - mSizes.begin()];
+    }
+
+    std::vector<std::size_t> const& getSizes() const
+    {
+        return mSizes;
+    }
+
+    std::vector<int32_t> const& getCandidates() const
+    {
+        return mCandidates;
+    }
+
+private:
+    std::vector<std::size_t> mSizes;
+    std::vector<int32_t> mCandidates;
+};
+
+} // namespace tensorrt_llm::plugins
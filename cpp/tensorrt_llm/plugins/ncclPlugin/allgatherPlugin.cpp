@@ -16,6 +16,8 @@
  */
 #include "allgatherPlugin.h"
 
+#include "tensorrt_llm/runtime/commTimingTracker.h"
+
 #include <nccl.h>
 
 using namespace nvinfer1;
@@ -101,6 +103,8 @@ int AllgatherPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfe
     }
 
     TLLM_CHECK_WITH_INFO(mNcclComm.get() != nullptr, "mNcclComm should be initialized before used");
+    runtime::CommTimingTracker::ScopedTiming const timing{
+        runtime::CommTimingTracker::OpType::kALLGATHER, size * typeSize(inputDesc[0].type) * mGroup.size(), stream};
     NCCLCHECK(ncclAllGather(inputs[0], outputs[0], size, (*getDtypeMap())[inputDesc[0].type], *mNcclComm, stream));
 
     return 0;
@@ -16,11 +16,20 @@
  */
 #include "allreducePlugin.h"
 
+#include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/customAllReduceUtils.h"
 #include "tensorrt_llm/common/dataType.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/common/tensor.h"
 #include "tensorrt_llm/kernels/customAllReduceKernels.h"
+#include "tensorrt_llm/runtime/commTimingTracker.h"
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <iterator>
+#include <limits>
+#include <mutex>
 #include <nccl.h>
 #include <unordered_set>
 
@@ -36,6 +45,41 @@ static char const* ALLREDUCE_PLUGIN_NAME{"AllReduce"};
 PluginFieldCollection AllreducePluginCreator::mFC{};
 std::vector<nvinfer1::PluginField> AllreducePluginCreator::mPluginAttributes;
 
+namespace
+{
+
+struct AllReduceCandidate
+{
+    AllReduceStrategyType strategy;
+    AllReduceStrategyConfig config;
+};
+
+// Implementations measured by the AUTO strategy tuning
+constexpr std::array<AllReduceCandidate, 7> kTuningCandidates{{
+    {AllReduceStrategyType::NCCL, static_cast<AllReduceStrategyConfig>(0)},
+    {AllReduceStrategyType::ONESHOT, static_cast<AllReduceStrategyConfig>(0)},
+    {AllReduceStrategyType::ONESHOT, AllReduceStrategyConfig::USE_MEMCPY},
+    {AllReduceStrategyType::ONESHOT, AllReduceStrategyConfig::PUSH_MODE},
+    {AllReduceStrategyType::TWOSHOT, static_cast<AllReduceStrategyConfig>(0)},
+    {AllReduceStrategyType::TWOSHOT, AllReduceStrategyConfig::USE_MEMCPY},
+    {AllReduceStrategyType::TWOSHOT, AllReduceStrategyConfig::PUSH_MODE},
+}};
+
+// Barrier flags of the tuning runs, far from the layer counters so the flags left in the workspace never match
+constexpr uint32_t kTuningBarrierFlag = 1U << 30;
+
+std::filesystem::path getTuningCachePath(
+    std::string const& cacheDir, int worldSize, bool isNVLINK, nvinfer1::DataType type)
+{
+    int device;
+    TLLM_CUDA_CHECK(cudaGetDevice(&device));
+    cudaDeviceProp prop;
+    TLLM_CUDA_CHECK(cudaGetDeviceProperties(&prop, device));
+    return AllReduceTuningTable::getCachePath(cacheDir, prop.name, worldSize, isNVLINK, static_cast<int>(type));
+}
+
+} // namespace
+
 AllreducePlugin::AllreducePlugin(std::set<int> group, nvinfer1::DataType type, AllReduceStrategyType strategy,
     AllReduceStrategyConfig config, AllReduceFusionOp op, int32_t counter, float eps, int8_t affine, int8_t bias)
     : mGroup(std::move(group))
@@ -137,6 +181,12 @@ bool AllreducePlugin::supportsFormatCombination(
 void AllreducePlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc const* in, int nbInputs,
     nvinfer1::DynamicPluginTensorDesc const* out, int nbOutputs) noexcept
 {
+    size_t maxMessageSize = 1;
+    for (int i = 0; i < in[0].max.nbDims; ++i)
+    {
+        maxMessageSize *= in[0].max.d[i];
+    }
+    mMaxMessageBytes = maxMessageSize * common::getDTypeSize(mType);
 }
 
 size_t AllreducePlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
@@ -146,10 +196,23 @@ size_t AllreducePlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* input
 }
 
 AllReduceStrategyType AllreducePlugin::selectImplementation(
-    size_t messageSize, int worldSize, nvinfer1::DataType type) noexcept
+    size_t messageSize, int worldSize, nvinfer1::DataType type, AllReduceStrategyConfig& config) noexcept
 {
     bool const isAuto = (mStrategy == AllReduceStrategyType::AUTO);
 
+    if (mNodeGroupSize > 0)
+    {
+        // Small messages are latency bound, a single NCCL allreduce beats the three hierarchical steps
+        bool const useHierarchical = !isAuto || messageSize * common::getDTypeSize(type) >= 1 * 1000 * 1000;
+        return useHierarchical ? AllReduceStrategyType::HIERARCHICAL : AllReduceStrategyType::NCCL;
+    }
+
+    if (mStrategy == AllReduceStrategyType::HIERARCHICAL)
+    {
+        TLLM_LOG_WARNING("Since TP group does not span several nodes evenly, fallback to AllReduceStrategy: NCCL");
+        return AllReduceStrategyType::NCCL;
+    }
+
     if (!mIsP2PSupported)
     {
         if (!isAuto)
@@ -159,6 +222,25 @@ AllReduceStrategyType AllreducePlugin::selectImplementation(
         return AllReduceStrategyType::NCCL;
     }
 
+    if (isAuto && mTunedCandidates)
+    {
+        if (auto const tuned = mTunedCandidates->find(messageSize * common::getDTypeSize(type)))
+        {
+            auto const& candidate = kTuningCandidates[*tuned];
+            if (candidate.strategy == AllReduceStrategyType::NCCL
+                || !kernels::configurationSupported(candidate.strategy, messageSize, worldSize, type))
+            {
+                return AllReduceStrategyType::NCCL;
+            }
+            // The configs were only measured on the plain allreduce kernels
+            if (mOp == AllReduceFusionOp::NONE)
+            {
+                config = candidate.config;
+            }
+            return candidate.strategy;
+        }
+    }
+
     if (isAuto && !mIsNVLINKSupported)
     {
         return AllReduceStrategyType::NCCL;
@@ -226,6 +308,156 @@ AllReduceStrategyType AllreducePlugin::selectImplementation(
     return strat;
 }
 
+void AllreducePlugin::tuneImplementation(void const* workspace, cudaStream_t stream) noexcept
+{
+    static std::mutex mutex;
+    static std::map<std::tuple<std::set<int>, nvinfer1::DataType>, std::shared_ptr<AllReduceTuningTable const>> cache;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto const key = std::make_tuple(mGroup, mType);
+    if (auto const it = cache.find(key); it != cache.end())
+    {
+        mTunedCandidates = it->second;
+        return;
+    }
+
+    auto const worldSize = static_cast<int>(mGroup.size());
+    auto const tpRank = COMM_SESSION.getRank() % worldSize;
+    auto const maxWorkspaceSize = utils::customAllReduceUtils::getMaxRequiredWorkspaceSize(worldSize);
+    auto const sizes = AllReduceTuningTable::getMessageSizes(
+        mMaxMessageBytes > 0 ? std::min(mMaxMessageBytes, maxWorkspaceSize) : maxWorkspaceSize);
+    auto const numSizes = sizes.size();
+    auto const numCandidates = kTuningCandidates.size();
+    auto const sizePerElem = common::getDTypeSize(mType);
+    auto const path
+        = getTuningCachePath(*common::getEnvAllReduceTuningCacheDir(), worldSize, mIsNVLINKSupported, mType);
+
+    // All the ranks must take the same implementation for each message, so the first rank decides whether its cache
+    // is used and either sends its table to the others or the group measures the candidates together.
+    std::vector<int32_t> candidates(numSizes + 1, 0);
+    if (tpRank == 0)
+    {
+        if (auto const loaded = AllReduceTuningTable::load(path, sizes, kTuningCandidates.size()))
+        {
+            candidates[0] = 1;
+            std::copy(loaded->getCandidates().begin(), loaded->getCandidates().end(), candidates.begin() + 1);
+        }
+    }
+    int32_t* deviceCandidates;
+    TLLM_CUDA_CHECK(cudaMalloc(&deviceCandidates, candidates.size() * sizeof(int32_t)));
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(deviceCandidates, candidates.data(), candidates.size() * sizeof(int32_t),
+        cudaMemcpyHostToDevice, stream));
+    NCCLCHECK(ncclBroadcast(deviceCandidates, deviceCandidates, candidates.size(), ncclInt32, 0, *mNcclComm, stream));
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(candidates.data(), deviceCandidates, candidates.size() * sizeof(int32_t),
+        cudaMemcpyDeviceToHost, stream));
+    TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+    TLLM_CUDA_CHECK(cudaFree(deviceCandidates));
+
+    if (candidates[0] == 0)
+    {
+        void* input;
+        void* output;
+        TLLM_CUDA_CHECK(cudaMalloc(&input, sizes.back()));
+        TLLM_CUDA_CHECK(cudaMalloc(&output, sizes.back()));
+        TLLM_CUDA_CHECK(cudaMemsetAsync(input, 0, sizes.back(), stream));
+        cudaEvent_t start;
+        cudaEvent_t stop;
+        TLLM_CUDA_CHECK(cudaEventCreate(&start));
+        TLLM_CUDA_CHECK(cudaEventCreate(&stop));
+
+        constexpr int kWarmupRuns = 3;
+        constexpr int kTimedRuns = 10;
+        auto barrierFlag = kTuningBarrierFlag;
+        std::vector<float> times(numSizes * numCandidates, std::numeric_limits<float>::max());
+        for (size_t i = 0; i < numSizes; ++i)
+        {
+            // Round down to the alignment of the two-shot kernel, 16 bytes per thread on each rank
+            auto const alignment = 16 * static_cast<size_t>(worldSize);
+            auto const messageSize = std::max(sizes[i] / alignment, size_t{1}) * alignment / sizePerElem;
+            for (size_t c = 0; c < numCandidates; ++c)
+            {
+                auto const& candidate = kTuningCandidates[c];
+                bool const isNccl = candidate.strategy == AllReduceStrategyType::NCCL;
+                if (!isNccl && !kernels::configurationSupported(candidate.strategy, messageSize, worldSize, mType))
+                {
+                    continue;
+                }
+                auto const run = [&]()
+                {
+                    if (isNccl)
+                    {
+                        NCCLCHECK(ncclAllReduce(
+                            input, output, messageSize, (*getDtypeMap())[mType], ncclSum, *mNcclComm, stream));
+                        return;
+                    }
+                    auto params = tensorrt_llm::kernels::AllReduceParams::deserialize(
+                        reinterpret_cast<int32_t const*>(workspace), worldSize, tpRank, barrierFlag++);
+                    params.local_output_buffer_ptr = output;
+                    params.local_input_buffer_ptr = input;
+                    params.elts_total = messageSize;
+                    tensorrt_llm::kernels::customAllReduce(
+                        params, mType, candidate.strategy, candidate.config, AllReduceFusionOp::NONE, stream);
+                };
+                for (int r = 0; r < kWarmupRuns; ++r)
+                {
+                    run();
+                }
+                TLLM_CUDA_CHECK(cudaEventRecord(start, stream));
+                for (int r = 0; r < kTimedRuns; ++r)
+                {
+                    run();
+                }
+                TLLM_CUDA_CHECK(cudaEventRecord(stop, stream));
+                TLLM_CUDA_CHECK(cudaEventSynchronize(stop));
+                float elapsed;
+                TLLM_CUDA_CHECK(cudaEventElapsedTime(&elapsed, start, stop));
+                times[i * numCandidates + c] = elapsed / kTimedRuns;
+            }
+        }
+
+        // The slowest rank bounds the allreduce, and taking the same maximum on all ranks keeps their choices equal
+        float* deviceTimes;
+        TLLM_CUDA_CHECK(cudaMalloc(&deviceTimes, times.size() * sizeof(float)));
+        TLLM_CUDA_CHECK(
+            cudaMemcpyAsync(deviceTimes, times.data(), times.size() * sizeof(float), cudaMemcpyHostToDevice, stream));
+        NCCLCHECK(ncclAllReduce(deviceTimes, deviceTimes, times.size(), ncclFloat32, ncclMax, *mNcclComm, stream));
+        TLLM_CUDA_CHECK(
+            cudaMemcpyAsync(times.data(), deviceTimes, times.size() * sizeof(float), cudaMemcpyDeviceToHost, stream));
+        TLLM_CUDA_CHECK(cudaStreamSynchronize(stream));
+
+        auto const fastest = AllReduceTuningTable::getFastest(times, numCandidates);
+        std::copy(fastest.begin(), fastest.end(), candidates.begin() + 1);
+        if (tpRank == 0 && !AllReduceTuningTable(sizes, fastest).save(path))
+        {
+            TLLM_LOG_WARNING("Failed to save the allreduce tuning cache %s", path.c_str());
+        }
+
+        TLLM_CUDA_CHECK(cudaFree(deviceTimes));
+        TLLM_CUDA_CHECK(cudaEventDestroy(start));
+        TLLM_CUDA_CHECK(cudaEventDestroy(stop));
+        TLLM_CUDA_CHECK(cudaFree(input));
+        TLLM_CUDA_CHECK(cudaFree(output));
+    }
+
+    auto tuned = std::make_shared<AllReduceTuningTable const>(
+        sizes, std::vector<int32_t>(candidates.begin() + 1, candidates.end()));
+    for (size_t i = 0; i < numSizes; ++i)
+    {
+        auto const& candidate = kTuningCandidates[candidates[i + 1]];
+        TLLM_LOG_DEBUG("AllReducePlugin tuned strategy for messages up to %zu bytes: %d, config %d", sizes[i],
+            static_cast<int>(candidate.strategy), static_cast<int>(candidate.config));
+    }
+    cache[key] = tuned;
+    mTunedCandidates = std::move(tuned);
+}
+
+void AllreducePlugin::hierarchicalAllReduce(void const* input, void* output, size_t size, cudaStream_t stream) noexcept
+{
+    auto const& streams = *mHierarchicalStreams;
+    tensorrt_llm::plugins::hierarchicalAllReduce(input, output, size, mType,
+        static_cast<size_t>(common::getEnvAllReduceHierarchicalChunkSize()), *mNodeComm, *mCrossNodeComm, *mNcclComm,
+        stream, streams.crossNodeStream, streams.reduceScattered, streams.crossNodeReduced);
+}
+
 int AllreducePlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::PluginTensorDesc const* outputDesc,
     void const* const* inputs, void* const* outputs, void* workspace, cudaStream_t stream) noexcept
 {
@@ -241,6 +473,7 @@ int AllreducePlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfe
     auto const sizePerElem = common::getDTypeSize(mType);
 
     kernels::AllReduceStrategyType runtimeStrategy;
+    auto config = mConfig;
 
     if (mStrategy == AllReduceStrategyType::NCCL)
     {
@@ -248,36 +481,52 @@ int AllreducePlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfe
     }
     else
     {
-        runtimeStrategy = selectImplementation(size, mGroup.size(), mType);
+        if (mStrategy == AllReduceStrategyType::AUTO && mIsP2PSupported && !mTunedCandidates
+            && isCustomAllReduceSupported(mGroup.size()) && common::getEnvAllReduceTuningCacheDir())
+        {
+            // The tuning synchronizes the stream, it is left to the first enqueue outside of CUDA graph capture
+            cudaStreamCaptureStatus captureStatus;
+            TLLM_CUDA_CHECK(cudaStreamIsCapturing(stream, &captureStatus));
+            if (captureStatus == cudaStreamCaptureStatusNone)
+            {
+                tuneImplementation(inputs[1], stream);
+            }
+        }
+        runtimeStrategy = selectImplementation(size, mGroup.size(), mType, config);
     }
 
     // Log runtime strategy
     auto const rank = COMM_SESSION.getRank();
+    char const* strategyName = "";
     switch (runtimeStrategy)
     {
-    case AllReduceStrategyType::NCCL:
-    {
-        TLLM_LOG_DEBUG("AllReducePlugin strategy for rank %d layer %d: NCCL", rank, mCounter);
-        break;
-    }
-    case AllReduceStrategyType::ONESHOT:
-    {
-        TLLM_LOG_DEBUG("AllReducePlugin strategy for rank %d layer %d: ONESHOT", rank, mCounter);
-        break;
-    }
-    case AllReduceStrategyType::TWOSHOT:
-    {
-        TLLM_LOG_DEBUG("AllReducePlugin strategy for rank %d layer %d: TWOSHOT", rank, mCounter);
-        break;
-    }
+    case AllReduceStrategyType::NCCL: strategyName = "NCCL"; break;
+    case AllReduceStrategyType::ONESHOT: strategyName = "ONESHOT"; break;
+    case AllReduceStrategyType::TWOSHOT: strategyName = "TWOSHOT"; break;
+    case AllReduceStrategyType::HIERARCHICAL: strategyName = "HIERARCHICAL"; break;
     default: break;
     }
+    TLLM_LOG_DEBUG("AllReducePlugin strategy for rank %d layer %d: %s", rank, mCounter, strategyName);
 
-    if (runtimeStrategy == AllReduceStrategyType::NCCL)
+    runtime::CommTimingTracker::ScopedTiming const timing{
+        runtime::CommTimingTracker::OpType::kALLREDUCE, size * sizePerElem, stream, strategyName};
+
+    if (runtimeStrategy == AllReduceStrategyType::NCCL || runtimeStrategy == AllReduceStrategyType::HIERARCHICAL)
     {
+        auto const allReduce = [&](void const* input, void* output)
+        {
+            if (runtimeStrategy == AllReduceStrategyType::HIERARCHICAL)
+            {
+                hierarchicalAllReduce(input, output, size, stream);
+            }
+            else
+            {
+                NCCLCHECK(ncclAllReduce(input, output, size, (*getDtypeMap())[mType], ncclSum, *mNcclComm, stream));
+            }
+        };
         if (mOp == AllReduceFusionOp::RESIDUAL_RMS_NORM)
         {
-            NCCLCHECK(ncclAllReduce(inputs[0], outputs[1], size, (*getDtypeMap())[mType], ncclSum, *mNcclComm, stream));
+            allReduce(inputs[0], outputs[1]);
             tensorrt_llm::kernels::AllReduceParams params;
             int fusion_ptr_idx = 0;
             if (mStrategy == AllReduceStrategyType::NCCL)
@@ -300,7 +549,7 @@ int AllreducePlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfe
         }
         else
         {
-            NCCLCHECK(ncclAllReduce(inputs[0], outputs[0], size, (*getDtypeMap())[mType], ncclSum, *mNcclComm, stream));
+            allReduce(inputs[0], outputs[0]);
         }
     }
     else
@@ -324,7 +573,7 @@ int AllreducePlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfe
             params.fusion_params.eps = mEps;
             params.fusion_params.intermediate_buffer = outputs[1];
         }
-        tensorrt_llm::kernels::customAllReduce(params, mType, runtimeStrategy, mConfig, mOp, stream);
+        tensorrt_llm::kernels::customAllReduce(params, mType, runtimeStrategy, config, mOp, stream);
     }
 
     return 0;
@@ -383,7 +632,8 @@ public:
     }
 };
 
-std::set<int> getLocalGroup(std::set<int> const& group)
+// Returns the device ids of the ranks of the group on this node and their global ranks in nodeGroup.
+std::set<int> getLocalGroup(std::set<int> const& group, std::set<int>& nodeGroup)
 {
     auto const myRank = COMM_SESSION.getRank();
     auto const myLocalRank = LOCAL_COMM_SESSION.getRank();
@@ -443,35 +693,109 @@ std::set<int> getLocalGroup(std::set<int> const& group)
         if (group.find(rank) != group.end())
         {
             localGroup.insert(localRanks[i]);
+            nodeGroup.insert(rank);
         }
     }
     return localGroup;
 }
 
+// Whether the ranks of the group on each node form consecutive blocks of the same size, agreed on by all ranks so
+// that they all create the node and cross-node communicators or none of them does.
+bool isUniformNodeLayout(std::set<int> const& group, std::set<int> const& nodeGroup)
+{
+    auto const rank = COMM_SESSION.getRank();
+    auto const nodeSize = static_cast<int>(nodeGroup.size());
+    auto const first = static_cast<int>(std::distance(group.begin(), group.find(*nodeGroup.begin())));
+    bool const isUniform = nodeSize > 1 && static_cast<int>(group.size()) % nodeSize == 0 && first % nodeSize == 0
+        && std::equal(nodeGroup.begin(), nodeGroup.end(), std::next(group.begin(), first));
+    int agreedNodeSize = isUniform ? nodeSize : 0;
+    if (rank == *group.begin())
+    {
+        for (auto it = std::next(std::begin(group), 1); it != group.end(); ++it)
+        {
+            int otherNodeSize;
+            COMM_SESSION.recvValue(otherNodeSize, *it, 0);
+            agreedNodeSize = otherNodeSize == agreedNodeSize ? agreedNodeSize : 0;
+        }
+        for (auto it = std::next(std::begin(group), 1); it != group.end(); ++it)
+        {
+            COMM_SESSION.sendValue(agreedNodeSize, *it, 0);
+        }
+    }
+    else
+    {
+        COMM_SESSION.sendValue(agreedNodeSize, *group.begin(), 0);
+        COMM_SESSION.recvValue(agreedNodeSize, *group.begin(), 0);
+    }
+    return agreedNodeSize > 0;
+}
+
 void AllreducePlugin::initGroupTopology() noexcept
 {
-    static std::map<std::set<int>, std::tuple<bool, bool>> cache;
+    static std::map<std::set<int>, std::tuple<bool, bool, int>> cache;
     if (cache.find(mGroup) != cache.end())
     {
-        auto [isNVLINKSupported, isP2PSupported] = cache[mGroup];
+        auto [isNVLINKSupported, isP2PSupported, nodeGroupSize] = cache[mGroup];
         mIsNVLINKSupported = isNVLINKSupported;
         mIsP2PSupported = isP2PSupported;
+        mNodeGroupSize = nodeGroupSize;
         return;
     }
     setGroupTopology();
-    cache[mGroup] = {mIsNVLINKSupported, mIsP2PSupported};
+    cache[mGroup] = {mIsNVLINKSupported, mIsP2PSupported, mNodeGroupSize};
+}
+
+void AllreducePlugin::initHierarchicalComms() noexcept
+{
+    auto const groupRank = static_cast<int>(std::distance(mGroup.begin(), mGroup.find(COMM_SESSION.getRank())));
+    std::set<int> nodeGroup;
+    std::set<int> crossNodeGroup;
+    int i = 0;
+    for (auto it = mGroup.begin(); it != mGroup.end(); ++it, ++i)
+    {
+        if (i / mNodeGroupSize == groupRank / mNodeGroupSize)
+        {
+            nodeGroup.insert(*it);
+        }
+        if (i % mNodeGroupSize == groupRank % mNodeGroupSize)
+        {
+            crossNodeGroup.insert(*it);
+        }
+    }
+    mNodeComm = getComm(nodeGroup);
+    mCrossNodeComm = getComm(crossNodeGroup);
+
+    mHierarchicalStreams = std::shared_ptr<HierarchicalStreams>(new HierarchicalStreams,
+        [](HierarchicalStreams* streams)
+        {
+            cudaEventDestroy(streams->crossNodeReduced);
+            cudaEventDestroy(streams->reduceScattered);
+            cudaStreamDestroy(streams->crossNodeStream);
+            delete streams;
+        });
+    TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mHierarchicalStreams->crossNodeStream, cudaStreamNonBlocking));
+    TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mHierarchicalStreams->reduceScattered, cudaEventDisableTiming));
+    TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mHierarchicalStreams->crossNodeReduced, cudaEventDisableTiming));
 }
 
 void AllreducePlugin::setGroupTopology() noexcept
 {
     auto const rank = COMM_SESSION.getRank();
     TLLM_LOG_INFO("Detecting local TP group for rank %d", rank);
-    std::set<int> localGroup = getLocalGroup(mGroup);
+    std::set<int> nodeGroup;
+    std::set<int> localGroup = getLocalGroup(mGroup, nodeGroup);
+    mNodeGroupSize = 0;
     if (mGroup.size() != localGroup.size())
     {
         mIsP2PSupported = false;
         mIsNVLINKSupported = false;
         TLLM_LOG_INFO("Found inter-node TP group for rank %d", rank);
+        if (isUniformNodeLayout(mGroup, nodeGroup))
+        {
+            mNodeGroupSize = static_cast<int>(nodeGroup.size());
+            TLLM_LOG_INFO("TP group spans %d nodes of %d ranks, hierarchical allreduce is available for rank %d",
+                static_cast<int>(mGroup.size()) / mNodeGroupSize, mNodeGroupSize, rank);
+        }
         return;
     }
     TLLM_LOG_INFO("TP group is intra-node for rank %d", rank);
@@ -583,6 +907,10 @@ int AllreducePlugin::initialize() noexcept
     {
         initGroupTopology();
     }
+    if (mNodeGroupSize > 0)
+    {
+        initHierarchicalComms();
+    }
 
     return 0;
 }
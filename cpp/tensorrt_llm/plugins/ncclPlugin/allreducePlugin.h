@@ -19,6 +19,7 @@
 #include "tensorrt_llm/common/tensor.h"
 #include "tensorrt_llm/kernels/customAllReduceKernels.h"
 #include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/plugins/ncclPlugin/allReduceTuningTable.h"
 
 #include <cassert>
 #include <memory>
@@ -71,8 +72,20 @@ private:
     bool isCustomAllReduceSupported(int ranks_per_node) const noexcept;
     void initGroupTopology() noexcept;
     void setGroupTopology() noexcept;
-    kernels::AllReduceStrategyType selectImplementation(
-        size_t messageSize, int worldSize, nvinfer1::DataType type) noexcept;
+    kernels::AllReduceStrategyType selectImplementation(size_t messageSize, int worldSize, nvinfer1::DataType type,
+        kernels::AllReduceStrategyConfig& config) noexcept;
+    void tuneImplementation(void const* workspace, cudaStream_t stream) noexcept;
+    void initHierarchicalComms() noexcept;
+    void hierarchicalAllReduce(void const* input, void* output, size_t size, cudaStream_t stream) noexcept;
+
+    // Side stream running the inter-node allreduce of one chunk while the main stream runs the intra-node
+    // reduce-scatter and allgather of its neighbours.
+    struct HierarchicalStreams
+    {
+        cudaStream_t crossNodeStream;
+        cudaEvent_t reduceScattered;
+        cudaEvent_t crossNodeReduced;
+    };
 
 private:
     std::string const mLayerName;
@@ -86,6 +99,17 @@ private:
     float mEps;
     int32_t mCounter;
     std::shared_ptr<ncclComm_t> mNcclComm;
+    // Number of ranks of the group on each node when the group spans several nodes with the same number of ranks
+    // each, 0 otherwise.
+    int mNodeGroupSize{0};
+    std::shared_ptr<ncclComm_t> mNodeComm;
+    std::shared_ptr<ncclComm_t> mCrossNodeComm;
+    std::shared_ptr<HierarchicalStreams> mHierarchicalStreams;
+    // Largest message of this plugin, bounds the message sizes tuned for the AUTO strategy.
+    size_t mMaxMessageBytes{0};
+    // Fastest implementation of each message size, measured on the group at its first enqueue when
+    // TRTLLM_ALLREDUCE_TUNING_CACHE_DIR is set.
+    std::shared_ptr<AllReduceTuningTable const> mTunedCandidates;
     int8_t mAffine;
     int8_t mBias;
 };
@@ -0,0 +1,422 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION &
+ * AFFILIATES. All rights reserved. SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "gemmCommOverlapPlugin.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/dataType.h"
+
+#include <algorithm>
+#include <cassert>
+#include <nccl.h>
+
+using namespace nvinfer1;
+using tensorrt_llm::common::CublasMMWrapper;
+using tensorrt_llm::plugins::GemmCommOp;
+using tensorrt_llm::plugins::GemmCommOverlapPluginCreator;
+using tensorrt_llm::plugins::GemmCommOverlapPlugin;
+
+static char const* GEMM_COMM_OVERLAP_PLUGIN_VERSION{"1"};
+static char const* GEMM_COMM_OVERLAP_PLUGIN_NAME{"GemmCommOverlap"};
+PluginFieldCollection GemmCommOverlapPluginCreator::mFC{};
+std::vector<PluginField> GemmCommOverlapPluginCreator::mPluginAttributes;
+
+GemmCommOverlapPlugin::GemmCommOverlapPlugin(
+    std::set<int> group, nvinfer1::DataType type, GemmCommOp commOp, int transB, int numChunks)
+    : mGroup(std::move(group))
+    , mType(type)
+    , mCommOp(commOp)
+    , mTransB(transB)
+    , mNumChunks(numChunks)
+{
+    init();
+}
+
+// Parameterized constructor
+GemmCommOverlapPlugin::GemmCommOverlapPlugin(void const* data, size_t length)
+{
+    char const *d = reinterpret_cast<char const*>(data), *a = d;
+    read(d, mType);
+    read(d, mCommOp);
+    read(d, mTransB);
+    read(d, mNumChunks);
+    mGroup.clear();
+    int groupItem = 0;
+    while (d != a + length)
+    {
+        read(d, groupItem);
+        mGroup.insert(groupItem);
+    }
+    TLLM_CHECK_WITH_INFO(d == a + length,
+        "Expected length (%d) != real length (%d). This is often "
+        "caused by using different TensorRT-LLM version to build "
+        "engine and run engine.",
+        (int) length, (int) (d - a));
+    init();
+}
+
+void GemmCommOverlapPlugin::init()
+{
+    TLLM_CHECK_WITH_INFO(mNumChunks > 0, "GemmCommOverlap needs at least one chunk.");
+    mCublasWrapper = std::make_shared<CublasMMWrapper>(getCublasHandle(), getCublasLtHandle(), nullptr, nullptr);
+}
+
+void GemmCommOverlapPlugin::setGemmConfig()
+{
+    if (mType == nvinfer1::DataType::kHALF)
+    {
+        mCublasWrapper->setFP16GemmConfig();
+    }
+    else if (mType == nvinfer1::DataType::kFLOAT)
+    {
+        mCublasWrapper->setFP32GemmConfig();
+    }
+#ifdef ENABLE_BF16
+    else if (mType == nvinfer1::DataType::kBF16)
+    {
+        mCublasWrapper->setBF16GemmConfig();
+    }
+#endif
+}
+
+// IPluginV2DynamicExt Methods
+nvinfer1::IPluginV2DynamicExt* GemmCommOverlapPlugin::clone() const noexcept
+{
+    auto* plugin = new GemmCommOverlapPlugin(*this);
+    plugin->setPluginNamespace(mNamespace.c_str());
+    return plugin;
+}
+
+nvinfer1::DimsExprs GemmCommOverlapPlugin::getOutputDimensions(
+    int outputIndex, nvinfer1::DimsExprs const* inputs, int nbInputs, nvinfer1::IExprBuilder& exprBuilder) noexcept
+{
+    // inputs
+    //     act [..., K], rows split evenly over the ranks for REDUCE_SCATTER, the rows of this rank for ALL_GATHER
+    //     weight [N, K] (mTransB = True) or [K, N]
+    // outputs
+    //     mat [..., N], the rows of this rank for REDUCE_SCATTER, all the rows for ALL_GATHER
+    auto output = inputs[0];
+    output.d[output.nbDims - 1] = mTransB ? inputs[1].d[0] : inputs[1].d[1];
+    auto const op = mCommOp == GemmCommOp::REDUCE_SCATTER ? DimensionOperation::kFLOOR_DIV : DimensionOperation::kPROD;
+    output.d[0] = exprBuilder.operation(op, *output.d[0], *exprBuilder.constant(mGroup.size()));
+    return output;
+}
+
+bool GemmCommOverlapPlugin::supportsFormatCombination(
+    int pos, nvinfer1::PluginTensorDesc const* inOut, int nbInputs, int nbOutputs) noexcept
+{
+    return (inOut[pos].type == mType) && (inOut[pos].format == TensorFormat::kLINEAR);
+}
+
+void GemmCommOverlapPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc const* in, int nbInputs,
+    nvinfer1::DynamicPluginTensorDesc const* out, int nbOutputs) noexcept
+{
+}
+
+size_t GemmCommOverlapPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
+    nvinfer1::PluginTensorDesc const* outputs, int nbOutputs) const noexcept
+{
+    // Partial products of all the rows for REDUCE_SCATTER, gathered activation for ALL_GATHER
+    size_t numElems = 1;
+    for (int i = 0; i < outputs[0].dims.nbDims - 1; ++i)
+    {
+        numElems *= outputs[0].dims.d[i];
+    }
+    if (mCommOp == GemmCommOp::REDUCE_SCATTER)
+    {
+        numElems *= mGroup.size() * outputs[0].dims.d[outputs[0].dims.nbDims - 1];
+    }
+    else
+    {
+        numElems *= inputs[0].dims.d[inputs[0].dims.nbDims - 1];
+    }
+    return numElems * common::getDTypeSize(mType);
+}
+
+void GemmCommOverlapPlugin::runBatchedGemm(void const* act, int64_t actStride, void const* weight, void* output,
+    int64_t outputStride, int rows, int n, int k, cudaStream_t stream)
+{
+    // Row major output = act * weight^T is column major output^T = weight * act^T for cuBLAS, shared by the batch
+    auto const transa = mTransB ? CUBLAS_OP_T : CUBLAS_OP_N;
+    auto const lda = mTransB ? k : n;
+    mCublasWrapper->setStream(stream);
+    mCublasWrapper->stridedBatchedGemm(transa, CUBLAS_OP_N, n, rows, k, weight, lda, 0, act, k, actStride, output, n,
+        outputStride, static_cast<int>(mGroup.size()));
+}
+
+int GemmCommOverlapPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
+    nvinfer1::PluginTensorDesc const* outputDesc, void const* const* inputs, void* const* outputs, void* workspace,
+    cudaStream_t stream) noexcept
+{
+    if (isBuilding())
+    {
+        return 0;
+    }
+    TLLM_CHECK_WITH_INFO(mNcclComm.get() != nullptr, "mNcclComm should be initialized before used");
+
+    auto const nbDimsA = inputDesc[0].dims.nbDims;
+    int64_t shardRows = 1;
+    for (int i = 0; i < outputDesc[0].dims.nbDims - 1; ++i)
+    {
+        shardRows *= outputDesc[0].dims.d[i];
+    }
+    auto const tpSize = static_cast<int64_t>(mGroup.size());
+    if (mCommOp == GemmCommOp::ALL_GATHER)
+    {
+        shardRows /= tpSize;
+    }
+    auto const k = static_cast<int>(inputDesc[0].dims.d[nbDimsA - 1]);
+    auto const n = static_cast<int>(mTransB ? inputDesc[1].dims.d[0] : inputDesc[1].dims.d[1]);
+    if (shardRows == 0)
+    {
+        return 0;
+    }
+
+    auto const ncclType = (*getDtypeMap())[mType];
+    auto const sizePerElem = common::getDTypeSize(mType);
+    auto const chunkRows = common::ceilDiv(shardRows, static_cast<int64_t>(mNumChunks));
+    auto const numChunks = common::ceilDiv(shardRows, chunkRows);
+    auto const rowsOf = [&](int64_t chunk) { return std::min(chunkRows, shardRows - chunk * chunkRows); };
+    auto const& streams = *mStreams;
+    auto* staging = static_cast<char*>(workspace);
+
+    setGemmConfig();
+    TLLM_CUDA_CHECK(cudaEventRecord(streams.computed, stream));
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(streams.commStream, streams.computed));
+
+    if (mCommOp == GemmCommOp::REDUCE_SCATTER)
+    {
+        // The partial products of chunk j are staged as [tpSize, rows, N] so that the reduce-scatter hands the rows
+        // of chunk j in the shard of rank r to rank r
+        auto const* act = static_cast<char const*>(inputs[0]);
+        auto* out = static_cast<char*>(outputs[0]);
+        for (int64_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            auto const row = chunk * chunkRows;
+            auto const rows = rowsOf(chunk);
+            auto* chunkStaging = staging + tpSize * row * n * sizePerElem;
+            runBatchedGemm(act + row * k * sizePerElem, shardRows * k, inputs[1], chunkStaging, rows * n,
+                static_cast<int>(rows), n, k, stream);
+            TLLM_CUDA_CHECK(cudaEventRecord(streams.computed, stream));
+            TLLM_CUDA_CHECK(cudaStreamWaitEvent(streams.commStream, streams.computed));
+            NCCLCHECK(ncclReduceScatter(chunkStaging, out + row * n * sizePerElem, rows * n, ncclType, ncclSum,
+                *mNcclComm, streams.commStream));
+        }
+    }
+    else
+    {
+        // Chunk j of every rank is gathered as [tpSize, rows, K] and multiplied into the rows of chunk j in the
+        // shard of each rank
+        auto const* act = static_cast<char const*>(inputs[0]);
+        auto* out = static_cast<char*>(outputs[0]);
+        for (int64_t chunk = 0; chunk < numChunks; ++chunk)
+        {
+            auto const row = chunk * chunkRows;
+            auto const rows = rowsOf(chunk);
+            auto* chunkStaging = staging + tpSize * row * k * sizePerElem;
+            NCCLCHECK(ncclAllGather(
+                act + row * k * sizePerElem, chunkStaging, rows * k, ncclType, *mNcclComm, streams.commStream));
+            TLLM_CUDA_CHECK(cudaEventRecord(streams.communicated, streams.commStream));
+            TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, streams.communicated));
+            runBatchedGemm(chunkStaging, rows * k, inputs[1], out + row * n * sizePerElem, shardRows * n,
+                static_cast<int>(rows), n, k, stream);
+        }
+    }
+
+    TLLM_CUDA_CHECK(cudaEventRecord(streams.communicated, streams.commStream));
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, streams.communicated));
+
+    return 0;
+}
+
+// IPluginV2Ext Methods
+nvinfer1::DataType GemmCommOverlapPlugin::getOutputDataType(
+    int index, nvinfer1::DataType const* inputTypes, int nbInputs) const noexcept
+{
+    assert(index == 0);
+    return inputTypes[0];
+}
+
+// IPluginV2 Methods
+
+char const* GemmCommOverlapPlugin::getPluginType() const noexcept
+{
+    return GEMM_COMM_OVERLAP_PLUGIN_NAME;
+}
+
+char const* GemmCommOverlapPlugin::getPluginVersion() const noexcept
+{
+    return GEMM_COMM_OVERLAP_PLUGIN_VERSION;
+}
+
+int GemmCommOverlapPlugin::getNbOutputs() const noexcept
+{
+    return 1;
+}
+
+int GemmCommOverlapPlugin::initialize() noexcept
+{
+    if (isBuilding())
+    {
+        return 0;
+    }
+    mNcclComm = getComm(mGroup);
+
+    mStreams = std::shared_ptr<OverlapStreams>(new OverlapStreams,
+        [](OverlapStreams* streams)
+        {
+            cudaEventDestroy(streams->communicated);
+            cudaEventDestroy(streams->computed);
+            cudaStreamDestroy(streams->commStream);
+            delete streams;
+        });
+    TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mStreams->commStream, cudaStreamNonBlocking));
+    TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mStreams->computed, cudaEventDisableTiming));
+    TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mStreams->communicated, cudaEventDisableTiming));
+    return 0;
+}
+
+void GemmCommOverlapPlugin::terminate() noexcept {}
+
+size_t GemmCommOverlapPlugin::getSerializationSize() const noexcept
+{
+    return sizeof(int) * mGroup.size() + sizeof(mType) + sizeof(mCommOp) + sizeof(mTransB) + sizeof(mNumChunks);
+}
+
+void GemmCommOverlapPlugin::serialize(void* buffer) const noexcept
+{
+    char *d = static_cast<char*>(buffer), *a = d;
+    write(d, mType);
+    write(d, mCommOp);
+    write(d, mTransB);
+    write(d, mNumChunks);
+    for (auto it = mGroup.begin(); it != mGroup.end(); ++it)
+    {
+        write(d, *it);
+    }
+    assert(d == a + getSerializationSize());
+}
+
+void GemmCommOverlapPlugin::destroy() noexcept
+{
+    // This gets called when the network containing plugin is destroyed
+    delete this;
+}
+
+///////////////
+
+GemmCommOverlapPluginCreator::GemmCommOverlapPluginCreator()
+{
+    // Fill PluginFieldCollection with PluginField arguments metadata
+    mPluginAttributes.clear();
+    mPluginAttributes.emplace_back(PluginField("group", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("comm_op", nullptr, PluginFieldType::kINT8, 1));
+    mPluginAttributes.emplace_back(PluginField("transb", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("num_chunks", nullptr, PluginFieldType::kINT32, 1));
+    mFC.nbFields = mPluginAttributes.size();
+    mFC.fields = mPluginAttributes.data();
+}
+
+char const* GemmCommOverlapPluginCreator::getPluginName() const noexcept
+{
+    return GEMM_COMM_OVERLAP_PLUGIN_NAME;
+}
+
+char const* GemmCommOverlapPluginCreator::getPluginVersion() const noexcept
+{
+    return GEMM_COMM_OVERLAP_PLUGIN_VERSION;
+}
+
+PluginFieldCollection const* GemmCommOverlapPluginCreator::getFieldNames() noexcept
+{
+    return &mFC;
+}
+
+IPluginV2* GemmCommOverlapPluginCreator::createPlugin(char const* name, PluginFieldCollection const* fc) noexcept
+{
+    PluginField const* fields = fc->fields;
+    std::set<int> group;
+    nvinfer1::DataType type;
+    GemmCommOp commOp;
+    int transB{1};
+    int numChunks{4};
+    // Read configurations from each fields
+    for (int i = 0; i < fc->nbFields; ++i)
+    {
+        char const* attrName = fields[i].name;
+        if (!strcmp(attrName, "group"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            auto const* r = static_cast<int const*>(fields[i].data);
+            for (int j = 0; j < fields[i].length; ++j)
+            {
+                group.insert(*r);
+                ++r;
+            }
+        }
+        else if (!strcmp(attrName, "type_id"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            type = static_cast<nvinfer1::DataType>(*(static_cast<nvinfer1::DataType const*>(fields[i].data)));
+        }
+        else if (!strcmp(attrName, "comm_op"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT8);
+            commOp = static_cast<GemmCommOp>(*static_cast<int8_t const*>(fields[i].data));
+        }
+        else if (!strcmp(attrName, "transb"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            transB = *static_cast<int const*>(fields[i].data);
+        }
+        else if (!strcmp(attrName, "num_chunks"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            numChunks = *static_cast<int const*>(fields[i].data);
+        }
+    }
+
+    try
+    {
+        auto* obj = new GemmCommOverlapPlugin(group, type, commOp, transB, numChunks);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (std::exception const& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
+
+IPluginV2* GemmCommOverlapPluginCreator::deserializePlugin(
+    char const* name, void const* serialData, size_t serialLength) noexcept
+{
+    // This object will be deleted when the network is destroyed, which will
+    // call GemmCommOverlapPlugin::destroy()
+    try
+    {
+        auto* obj = new GemmCommOverlapPlugin(serialData, serialLength);
+        obj->setPluginNamespace(mNamespace.c_str());
+        return obj;
+    }
+    catch (std::exception const& e)
+    {
+        caughtError(e);
+    }
+    return nullptr;
+}
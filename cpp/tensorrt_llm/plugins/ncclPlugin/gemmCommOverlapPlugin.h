@@ -0,0 +1,126 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/cublasMMWrapper.h"
+#include "tensorrt_llm/plugins/common/plugin.h"
+
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::plugins
+{
+
+// Collective fused with the GEMM of a tensor parallel linear layer.
+enum class GemmCommOp : int8_t
+{
+    // Row linear: the partial products of all ranks are reduce-scattered along the rows, as GEMM + ReduceScatter.
+    REDUCE_SCATTER = 0,
+    // Column linear: the row shards of the activation are all-gathered before the GEMM, as AllGather + GEMM.
+    ALL_GATHER = 1,
+};
+
+// GEMM of a tensor parallel linear layer overlapped with its collective. The rows of each rank's shard are split
+// in chunks, the collective of one chunk runs on a side stream while the GEMM of the next chunk runs on the main
+// stream. The GEMM of a chunk covers that chunk in the shard of every rank with a single strided batched GEMM, so
+// the outputs match the unfused layers exactly.
+class GemmCommOverlapPlugin : public BasePlugin
+{
+public:
+    GemmCommOverlapPlugin(std::set<int> group, nvinfer1::DataType type, GemmCommOp commOp, int transB, int numChunks);
+
+    GemmCommOverlapPlugin(void const* data, size_t length);
+
+    ~GemmCommOverlapPlugin() override = default;
+
+    // IPluginV2DynamicExt Methods
+    nvinfer1::IPluginV2DynamicExt* clone() const noexcept override;
+    nvinfer1::DimsExprs getOutputDimensions(int outputIndex, nvinfer1::DimsExprs const* inputs, int nbInputs,
+        nvinfer1::IExprBuilder& exprBuilder) noexcept override;
+    bool supportsFormatCombination(
+        int pos, nvinfer1::PluginTensorDesc const* inOut, int nbInputs, int nbOutputs) noexcept override;
+    void configurePlugin(nvinfer1::DynamicPluginTensorDesc const* in, int nbInputs,
+        nvinfer1::DynamicPluginTensorDesc const* out, int nbOutputs) noexcept override;
+    size_t getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
+        nvinfer1::PluginTensorDesc const* outputs, int nbOutputs) const noexcept override;
+    int enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::PluginTensorDesc const* outputDesc,
+        void const* const* inputs, void* const* outputs, void* workspace, cudaStream_t stream) noexcept override;
+
+    // IPluginV2Ext Methods
+    nvinfer1::DataType getOutputDataType(
+        int index, nvinfer1::DataType const* inputTypes, int nbInputs) const noexcept override;
+
+    // IPluginV2 Methods
+    char const* getPluginType() const noexcept override;
+    char const* getPluginVersion() const noexcept override;
+    int getNbOutputs() const noexcept override;
+    int initialize() noexcept override;
+    void terminate() noexcept override;
+    size_t getSerializationSize() const noexcept override;
+    void serialize(void* buffer) const noexcept override;
+    void destroy() noexcept override;
+
+private:
+    void init();
+    void setGemmConfig();
+    // GEMM of rows rows of the shard of every rank, batched over the ranks.
+    void runBatchedGemm(void const* act, int64_t actStride, void const* weight, void* output, int64_t outputStride,
+        int rows, int n, int k, cudaStream_t stream);
+
+    struct OverlapStreams
+    {
+        cudaStream_t commStream;
+        cudaEvent_t computed;
+        cudaEvent_t communicated;
+    };
+
+private:
+    const std::string mLayerName;
+    std::set<int> mGroup;
+    nvinfer1::DataType mType;
+    GemmCommOp mCommOp;
+    int mTransB;
+    int mNumChunks;
+    std::shared_ptr<ncclComm_t> mNcclComm;
+    std::shared_ptr<OverlapStreams> mStreams;
+    std::shared_ptr<common::CublasMMWrapper> mCublasWrapper;
+};
+
+class GemmCommOverlapPluginCreator : public BaseCreator
+{
+public:
+    GemmCommOverlapPluginCreator();
+
+    char const* getPluginName() const noexcept override;
+
+    char const* getPluginVersion() const noexcept override;
+
+    nvinfer1::PluginFieldCollection const* getFieldNames() noexcept override;
+
+    nvinfer1::IPluginV2* createPlugin(char const* name, nvinfer1::PluginFieldCollection const* fc) noexcept override;
+
+    nvinfer1::IPluginV2* deserializePlugin(
+        char const* name, void const* serialData, size_t serialLength) noexcept override;
+
+private:
+    static nvinfer1::PluginFieldCollection mFC;
+    static std::vector<nvinfer1::PluginField> mPluginAttributes;
+};
+
+} // namespace tensorrt_llm::plugins
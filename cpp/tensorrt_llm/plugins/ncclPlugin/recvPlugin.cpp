@@ -17,6 +17,7 @@
 #include "recvPlugin.h"
 
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/commTimingTracker.h"
 
 #include <nccl.h>
 
@@ -91,6 +92,8 @@ int RecvPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
     {
         size *= inputDesc[0].dims.d[i];
     }
+    runtime::CommTimingTracker::ScopedTiming const timing{
+        runtime::CommTimingTracker::OpType::kRECV, size * typeSize(inputDesc[0].type), stream};
     NCCLCHECK(ncclRecv(outputs[0], size, (*getDtypeMap())[inputDesc[0].type], 0, mComm, stream));
 
     return 0;
@@ -16,6 +16,8 @@
  */
 #include "reduceScatterPlugin.h"
 
+#include "tensorrt_llm/runtime/commTimingTracker.h"
+
 #include <cassert>
 #include <nccl.h>
 
@@ -102,6 +104,8 @@ int ReduceScatterPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     }
 
     TLLM_CHECK_WITH_INFO(mNcclComm.get() != nullptr, "mNcclComm should be initialized before used");
+    runtime::CommTimingTracker::ScopedTiming const timing{runtime::CommTimingTracker::OpType::kREDUCE_SCATTER,
+        size * typeSize(inputDesc[0].type) * mGroup.size(), stream};
     NCCLCHECK(ncclReduceScatter(
         inputs[0], outputs[0], size, (*getDtypeMap())[inputDesc[0].type], ncclSum, *mNcclComm, stream));
 
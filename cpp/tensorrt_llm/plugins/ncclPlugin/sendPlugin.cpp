@@ -16,7 +16,9 @@
  */
 #include "sendPlugin.h"
 
+#include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/runtime/commTimingTracker.h"
 
 #include <cassert>
 #include <nccl.h>
@@ -72,6 +74,12 @@ bool SendPlugin::supportsFormatCombination(
 void SendPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc const* in, int nbInputs,
     nvinfer1::DynamicPluginTensorDesc const* out, int nbOutputs) noexcept
 {
+    size_t maxElems = 1;
+    for (int i = 0; i < in[0].max.nbDims; ++i)
+    {
+        maxElems *= in[0].max.d[i];
+    }
+    mMaxBytes = maxElems * typeSize(mType);
 }
 
 size_t SendPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
@@ -93,7 +101,26 @@ int SendPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc, nvinfer1::P
         size *= inputDesc[0].dims.d[i];
     }
 
-    NCCLCHECK(ncclSend(inputs[0], size, (*getDtypeMap())[inputDesc[0].type], 1, mComm, stream));
+    auto const ncclType = (*getDtypeMap())[inputDesc[0].type];
+
+    // A send issued on the side stream would leave it unjoined at the end of a CUDA graph capture
+    cudaStreamCaptureStatus captureStatus;
+    TLLM_CUDA_CHECK(cudaStreamIsCapturing(stream, &captureStatus));
+    if (captureStatus != cudaStreamCaptureStatusNone)
+    {
+        NCCLCHECK(ncclSend(inputs[0], size, ncclType, 1, mComm, stream));
+        return 0;
+    }
+
+    size_t const bytes = size * typeSize(inputDesc[0].type);
+    mStaging->setMinBufferBytes(mMaxBytes);
+    mStaging->stage(inputs[0], bytes, stream,
+        [&](void const* buffer, cudaStream_t commStream)
+        {
+            runtime::CommTimingTracker::ScopedTiming const timing{
+                runtime::CommTimingTracker::OpType::kSEND, bytes, commStream};
+            NCCLCHECK(ncclSend(buffer, size, ncclType, 1, mComm, commStream));
+        });
     return 0;
 }
 
@@ -133,6 +160,8 @@ int SendPlugin::initialize() noexcept
     ncclGetUniqueId(&id);
     COMM_SESSION.sendValue(id, mTgtRank, 0);
     NCCLCHECK(ncclCommInitRank(&mComm, 2, id, 0));
+
+    mStaging = std::make_shared<SendStagingRing>();
     return 0;
 }
 
@@ -142,6 +171,8 @@ void SendPlugin::terminate() noexcept
     {
         return;
     }
+    // The communicator must outlive the sends still in flight
+    mStaging->synchronize();
     NCCLCHECK(ncclCommDestroy(mComm));
 }
 
@@ -17,12 +17,17 @@
 #pragma once
 
 #include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/plugins/ncclPlugin/sendStagingRing.h"
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace tensorrt_llm::plugins
 {
 
+// Sends the activations to the next pipeline stage. The input is copied into one of two staging buffers and sent from
+// a dedicated communication stream, so the stage can start its next micro batch while the activations are in flight.
+// The main stream only waits for the send that used the same staging buffer two micro batches before.
 class SendPlugin : public BasePlugin
 {
 public:
@@ -63,6 +68,8 @@ private:
     ncclComm_t mComm; // TODO: Remove this
     int mTgtRank;
     nvinfer1::DataType mType;
+    size_t mMaxBytes{0};
+    std::shared_ptr<SendStagingRing> mStaging;
 };
 
 class SendPluginCreator : public BaseCreator
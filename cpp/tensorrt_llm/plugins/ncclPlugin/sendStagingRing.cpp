@@ -0,0 +1,82 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "sendStagingRing.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+
+#include <algorithm>
+
+using tensorrt_llm::plugins::SendStagingRing;
+
+SendStagingRing::SendStagingRing()
+{
+    TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&mCommStream, cudaStreamNonBlocking));
+    for (std::size_t i = 0; i < kNumBuffers; ++i)
+    {
+        TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mCopied[i], cudaEventDisableTiming));
+        TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&mSent[i], cudaEventDisableTiming));
+    }
+}
+
+SendStagingRing::~SendStagingRing()
+{
+    cudaStreamSynchronize(mCommStream);
+    for (std::size_t i = 0; i < kNumBuffers; ++i)
+    {
+        cudaFree(mBuffers[i]);
+        cudaEventDestroy(mCopied[i]);
+        cudaEventDestroy(mSent[i]);
+    }
+    cudaStreamDestroy(mCommStream);
+}
+
+std::size_t SendStagingRing::stage(void const* input, std::size_t bytes, cudaStream_t stream, Send const& send)
+{
+    reserve(bytes);
+    auto const buffer = mNext;
+    mNext = (mNext + 1) % kNumBuffers;
+
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(stream, mSent[buffer]));
+    TLLM_CUDA_CHECK(cudaMemcpyAsync(mBuffers[buffer], input, bytes, cudaMemcpyDeviceToDevice, stream));
+    TLLM_CUDA_CHECK(cudaEventRecord(mCopied[buffer], stream));
+    TLLM_CUDA_CHECK(cudaStreamWaitEvent(mCommStream, mCopied[buffer]));
+    send(mBuffers[buffer], mCommStream);
+    TLLM_CUDA_CHECK(cudaEventRecord(mSent[buffer], mCommStream));
+    return buffer;
+}
+
+void SendStagingRing::synchronize() const
+{
+    TLLM_CUDA_CHECK(cudaStreamSynchronize(mCommStream));
+}
+
+void SendStagingRing::reserve(std::size_t bytes)
+{
+    if (bytes <= mBufferBytes)
+    {
+        return;
+    }
+    synchronize();
+    auto const bufferBytes = std::max(bytes, mMinBufferBytes);
+    for (auto& buffer : mBuffers)
+    {
+        TLLM_CUDA_CHECK(cudaFree(buffer));
+        buffer = nullptr;
+        TLLM_CUDA_CHECK(cudaMalloc(&buffer, bufferBytes));
+    }
+    mBufferBytes = bufferBytes;
+}
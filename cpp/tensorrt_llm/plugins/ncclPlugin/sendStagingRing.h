@@ -0,0 +1,88 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 1993-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <array>
+#include <cstddef>
+#include <functional>
+
+namespace tensorrt_llm::plugins
+{
+
+// The two staging buffers of SendPlugin and the stream the sends run on. Each message is copied into the next buffer
+// on the stream of its producer and sent from the communication stream once copied, so the producer only waits for
+// the send that used the same buffer two messages before and may overwrite its input right away.
+class SendStagingRing
+{
+public:
+    static constexpr std::size_t kNumBuffers{2};
+
+    // Enqueues the send of the staged message in `buffer` on `commStream`
+    using Send = std::function<void(void const* buffer, cudaStream_t commStream)>;
+
+    // The buffers are allocated by the first message
+    SendStagingRing();
+
+    ~SendStagingRing();
+
+    SendStagingRing(SendStagingRing const&) = delete;
+    SendStagingRing& operator=(SendStagingRing const&) = delete;
+
+    // Copies the `bytes` at `input` into the next buffer on `stream` and enqueues `send` once copied.
+    // \returns the buffer the message was staged in
+    std::size_t stage(void const* input, std::size_t bytes, cudaStream_t stream, Send const& send);
+
+    // Size to allocate the buffers with when they grow, e.g. the largest message of the engine
+    void setMinBufferBytes(std::size_t bytes)
+    {
+        mMinBufferBytes = bytes;
+    }
+
+    // Waits for the sends in flight
+    void synchronize() const;
+
+    cudaStream_t getCommStream() const
+    {
+        return mCommStream;
+    }
+
+    void const* getBuffer(std::size_t buffer) const
+    {
+        return mBuffers.at(buffer);
+    }
+
+    std::size_t getBufferBytes() const
+    {
+        return mBufferBytes;
+    }
+
+private:
+    // Grows the buffers to hold bytes, once the sends still using them are done
+    void reserve(std::size_t bytes);
+
+    cudaStream_t mCommStream{};
+    std::array<void*, kNumBuffers> mBuffers{};
+    std::array<cudaEvent_t, kNumBuffers> mCopied{};
+    std::array<cudaEvent_t, kNumBuffers> mSent{};
+    std::size_t mMinBufferBytes{0};
+    std::size_t mBufferBytes{0};
+    std::size_t mNext{0};
+};
+
+} // namespace tensorrt_llm::plugins
@@ -17,6 +17,7 @@
 
 #include "selectiveScanPlugin.h"
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
 
 using namespace nvinfer1;
 using namespace tensorrt_llm::kernels;
@@ -117,7 +118,9 @@ void SelectiveScanPlugin::configurePlugin(nvinfer1::DynamicPluginTensorDesc cons
 size_t SelectiveScanPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
     nvinfer1::PluginTensorDesc const* outputs, int nbOutputs) const noexcept
 {
-    return 0;
+    // States of the chunks of long context sequences
+    auto const batchSize = inputs[getHostRequestTypesIdx()].dims.d[0];
+    return getSelectiveScanWorkspaceSize(batchSize, mDim, mDState);
 }
 
 void SelectiveScanPlugin::setSSMParams(SSMParamsBase& params, const size_t batch, const size_t dim,
@@ -202,6 +205,13 @@ int SelectiveScanPlugin::enqueueImpl(nvinfer1::PluginTensorDesc const* inputDesc
 
     if (reqTypes[0] == RequestType::kCONTEXT)
     {
+        // Resume from the state restored in the slot, see runtime::RnnStatePool
+        ssm_params.load_initial_state = mPagedState && tensorrt_llm::common::getEnvEnableRnnStateReuse();
+        // Without padding, the number of tokens bounds the length of each sequence
+        int const maxSeqLenBound = mRemovePadding ? inputDesc[getInputTensorIdx()].dims.d[0] : max_seq_len;
+        ssm_params.num_chunks = getSelectiveScanNumChunks(batch_size, mDim, maxSeqLenBound);
+        ssm_params.chunk_size = tensorrt_llm::common::divUp(maxSeqLenBound, ssm_params.num_chunks);
+        ssm_params.chunk_states_ptr = workspace;
         invokeSelectiveScan<T, float>(ssm_params, stream);
     }
     else if (reqTypes[0] == RequestType::kGENERATION)
@@ -15,6 +15,7 @@
  * limitations under the License.
  */
 #include "smoothQuantGemmPlugin.h"
+#include "tensorrt_llm/kernels/rmsnormKernels.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/int8SQ.h"
 #include <numeric>
 
@@ -70,9 +71,11 @@ std::vector<SmoothQuantGemmPluginProfiler::Config> SmoothQuantGemmPluginProfiler
     return mRunner->getConfigs();
 }
 
-SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(
-    QuantMode quantMode, nvinfer1::DataType type, SmoothQuantGemmPlugin::PluginProfilerPtr const& pluginProfiler)
+SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(QuantMode quantMode, nvinfer1::DataType type, bool fuseRmsNorm, float eps,
+    SmoothQuantGemmPlugin::PluginProfilerPtr const& pluginProfiler)
     : mQuantMode(quantMode)
+    , mFuseRmsNorm(fuseRmsNorm)
+    , mEps(eps)
     , mPluginProfiler(pluginProfiler)
 {
     init(type);
@@ -90,6 +93,8 @@ SmoothQuantGemmPlugin::SmoothQuantGemmPlugin(
     read(d, quantMode);
     read(d, type);
     read(d, mDims);
+    read(d, mFuseRmsNorm);
+    read(d, mEps);
 
     mQuantMode = QuantMode(quantMode);
 
@@ -126,6 +131,8 @@ void SmoothQuantGemmPlugin::init(nvinfer1::DataType type)
     }
 #endif
 
+    TLLM_CHECK_WITH_INFO(!mFuseRmsNorm || mType != nvinfer1::DataType::kINT32, "RMSNorm fusion needs a float output");
+
     mPluginProfiler->setQuantMode(mQuantMode);
 
     mGemmId = GemmIdCore(mDims.n, mDims.k, mType);
@@ -143,8 +150,8 @@ nvinfer1::DimsExprs SmoothQuantGemmPlugin::getOutputDimensions(
 {
     try
     {
-        TLLM_CHECK(nbInputs == 4);
-        TLLM_CHECK(outputIndex == 0);
+        TLLM_CHECK(nbInputs == (mFuseRmsNorm ? 6 : 4));
+        TLLM_CHECK(outputIndex < getNbOutputs());
         int const nbDimsA = inputs[0].nbDims;
         TLLM_CHECK(nbDimsA >= 2);
         DimsExprs ret;
@@ -153,7 +160,8 @@ nvinfer1::DimsExprs SmoothQuantGemmPlugin::getOutputDimensions(
         {
             ret.d[ii] = inputs[0].d[ii];
         }
-        ret.d[nbDimsA - 1] = inputs[1].d[0];
+        // The per-token scales of the quantized output are [M(*), 1]
+        ret.d[nbDimsA - 1] = outputIndex == 2 ? exprBuilder.constant(1) : inputs[1].d[0];
         return ret;
     }
     catch (std::exception const& e)
@@ -181,8 +189,21 @@ bool SmoothQuantGemmPlugin::supportsFormatCombination(
         // scales tokens
         return inOut[pos].type == nvinfer1::DataType::kFLOAT && inOut[pos].format == TensorFormat::kLINEAR;
     case 4:
-        // out
+        // out, or residual with fused RMSNorm
         return inOut[pos].type == mType && inOut[pos].format == TensorFormat::kLINEAR;
+    case 5:
+        // RMSNorm weight
+    case 6:
+        // residual out
+        return mFuseRmsNorm && inOut[pos].type == mType && inOut[pos].format == TensorFormat::kLINEAR;
+    case 7:
+        // quantized out
+        return mFuseRmsNorm && inOut[pos].type == nvinfer1::DataType::kINT8
+            && inOut[pos].format == TensorFormat::kLINEAR;
+    case 8:
+        // per-token scales of quantized out
+        return mFuseRmsNorm && inOut[pos].type == nvinfer1::DataType::kFLOAT
+            && inOut[pos].format == TensorFormat::kLINEAR;
     default:
         // Never should be here
         assert(false);
@@ -228,8 +249,12 @@ int SmoothQuantGemmPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     //     mat2           [N, K]
     //     scale_tokens   [M, 1] if has_per_token_scaling else [1, 1]
     //     scale_channels [1, N] if has_per_channel_scaling else [1, 1]
+    //     residual       [M(*), N] if fuse_rmsnorm
+    //     gamma          [N] if fuse_rmsnorm
     // outputs
-    //     mat [M(*), N]
+    //     mat [M(*), N], residual + mat if fuse_rmsnorm
+    //     quantized rmsnorm(residual + mat) [M(*), N] if fuse_rmsnorm
+    //     per-token scales of the quantized output [M(*), 1] if fuse_rmsnorm
     int64_t m64 = 1;
     for (int ii = 0; ii < inputDesc[0].dims.nbDims - 1; ++ii)
     {
@@ -265,22 +290,62 @@ int SmoothQuantGemmPlugin::enqueue(nvinfer1::PluginTensorDesc const* inputDesc,
     }
     else
     {
-        auto const& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
-        TLLM_CHECK_WITH_INFO(bestTactic, "No valid SQ GEMM tactic");
-        m_sqGemmRunner->gemm(reinterpret_cast<int8_t const*>(inputs[0]), reinterpret_cast<int8_t const*>(inputs[1]),
-            mQuantMode, reinterpret_cast<float const*>(inputs[3]), reinterpret_cast<float const*>(inputs[2]),
-            reinterpret_cast<void*>(outputs[0]), m, n, k, *bestTactic, reinterpret_cast<char*>(workspace), wsSize,
-            stream);
+        mPluginProfiler->runBestConfig(m, mGemmId, stream,
+            [&](auto const& bestTactic)
+            {
+                TLLM_CHECK_WITH_INFO(bestTactic, "No valid SQ GEMM tactic");
+                m_sqGemmRunner->gemm(reinterpret_cast<int8_t const*>(inputs[0]),
+                    reinterpret_cast<int8_t const*>(inputs[1]), mQuantMode, reinterpret_cast<float const*>(inputs[3]),
+                    reinterpret_cast<float const*>(inputs[2]), reinterpret_cast<void*>(outputs[0]), m, n, k,
+                    *bestTactic, reinterpret_cast<char*>(workspace), wsSize, stream);
+            });
+    }
+
+    if (mFuseRmsNorm)
+    {
+        // The residual is added in place, the GEMM output is still in L2 for the small M of generation
+        if (mType == nvinfer1::DataType::kHALF)
+        {
+            invokeRmsNormQuant<half>(inputs, outputs, m, n, stream);
+        }
+        else if (mType == nvinfer1::DataType::kFLOAT)
+        {
+            invokeRmsNormQuant<float>(inputs, outputs, m, n, stream);
+        }
+#ifdef ENABLE_BF16
+        else if (mType == nvinfer1::DataType::kBF16)
+        {
+            invokeRmsNormQuant<__nv_bfloat16>(inputs, outputs, m, n, stream);
+        }
+#endif
     }
 
     return 0;
 }
 
+template <typename T>
+void SmoothQuantGemmPlugin::invokeRmsNormQuant(
+    void const* const* inputs, void* const* outputs, int m, int n, cudaStream_t stream) const
+{
+    auto* residualOut = reinterpret_cast<T*>(outputs[0]);
+    tensorrt_llm::kernels::invokeGeneralAddRmsNorm<T>(residualOut, nullptr, residualOut,
+        reinterpret_cast<T const*>(inputs[4]), reinterpret_cast<T const*>(inputs[5]), nullptr, mEps, m, n, stream,
+        nullptr, reinterpret_cast<float*>(outputs[2]), reinterpret_cast<int8_t*>(outputs[1]));
+}
+
 // IPluginV2Ext Methods
 nvinfer1::DataType SmoothQuantGemmPlugin::getOutputDataType(
     int index, nvinfer1::DataType const* inputTypes, int nbInputs) const noexcept
 {
-    TLLM_CHECK(index == 0);
+    TLLM_CHECK(index < getNbOutputs());
+    if (index == 1)
+    {
+        return nvinfer1::DataType::kINT8;
+    }
+    if (index == 2)
+    {
+        return nvinfer1::DataType::kFLOAT;
+    }
     return mType;
 }
 
@@ -298,7 +363,7 @@ char const* SmoothQuantGemmPlugin::getPluginVersion() const noexcept
 
 int SmoothQuantGemmPlugin::getNbOutputs() const noexcept
 {
-    return 1;
+    return mFuseRmsNorm ? 3 : 1;
 }
 
 int SmoothQuantGemmPlugin::initialize() noexcept
@@ -314,6 +379,8 @@ size_t SmoothQuantGemmPlugin::getSerializationSize() const noexcept
     return sizeof(unsigned int) +                       // QuantMode
         sizeof(nvinfer1::DataType) +                    // dtype
         sizeof(mDims) +                                 // Dimensions
+        sizeof(mFuseRmsNorm) +                          // fuseRmsNorm
+        sizeof(mEps) +                                  // eps
         mPluginProfiler->getSerializationSize(mGemmId); // selected tactics container size
 }
 
@@ -323,6 +390,8 @@ void SmoothQuantGemmPlugin::serialize(void* buffer) const noexcept
     write(d, mQuantMode.value());
     write(d, mType);
     write(d, mDims);
+    write(d, mFuseRmsNorm);
+    write(d, mEps);
 
     mPluginProfiler->serialize(d, mGemmId);
     assert(d == a + getSerializationSize());
@@ -348,6 +417,8 @@ SmoothQuantGemmPluginCreator::SmoothQuantGemmPluginCreator()
     mPluginAttributes.emplace_back(PluginField("has_per_channel_scaling", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("has_per_token_scaling", nullptr, PluginFieldType::kINT32, 1));
     mPluginAttributes.emplace_back(PluginField("type_id", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("fuse_rmsnorm", nullptr, PluginFieldType::kINT32, 1));
+    mPluginAttributes.emplace_back(PluginField("eps", nullptr, PluginFieldType::kFLOAT32, 1));
     mFC.nbFields = mPluginAttributes.size();
     mFC.fields = mPluginAttributes.data();
 }
@@ -372,6 +443,8 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(char const* name, PluginFi
     PluginField const* fields = fc->fields;
     bool perTokenScaling, perChannelScaling;
     nvinfer1::DataType type;
+    bool fuseRmsNorm{false};
+    float eps{1e-6f};
     // Read configurations from each fields
     for (int i = 0; i < fc->nbFields; ++i)
     {
@@ -391,6 +464,16 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(char const* name, PluginFi
             TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
             type = static_cast<nvinfer1::DataType>(*(static_cast<nvinfer1::DataType const*>(fields[i].data)));
         }
+        else if (!strcmp(attrName, "fuse_rmsnorm"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kINT32);
+            fuseRmsNorm = static_cast<bool>(*(static_cast<int const*>(fields[i].data)));
+        }
+        else if (!strcmp(attrName, "eps"))
+        {
+            TLLM_CHECK(fields[i].type == PluginFieldType::kFLOAT32);
+            eps = *(static_cast<float const*>(fields[i].data));
+        }
     }
     try
     {
@@ -398,7 +481,7 @@ IPluginV2* SmoothQuantGemmPluginCreator::createPlugin(char const* name, PluginFi
         // Create plugin profiler with shared tactics map
         auto pluginProfiler = gemmPluginProfileManager.createGemmPluginProfiler(/* inference */ false);
         QuantMode quantMode = QuantMode::fromDescription(true, true, perTokenScaling, perChannelScaling);
-        auto* obj = new SmoothQuantGemmPlugin(quantMode, type, pluginProfiler);
+        auto* obj = new SmoothQuantGemmPlugin(quantMode, type, fuseRmsNorm, eps, pluginProfiler);
         obj->setPluginNamespace(mNamespace.c_str());
         return obj;
     }
@@ -50,6 +50,11 @@ protected:
 
     std::vector<Config> getTactics(int m, int n, int k) const override;
 
+    std::string getTacticCacheTag() const override
+    {
+        return "quantMode=" + std::to_string(mQuantMode.value());
+    }
+
 private:
     tensorrt_llm::common::QuantMode mQuantMode;
 };
@@ -61,8 +66,10 @@ public:
 
     SmoothQuantGemmPlugin() = delete;
 
-    SmoothQuantGemmPlugin(
-        tensorrt_llm::common::QuantMode quantMode, nvinfer1::DataType type, PluginProfilerPtr const& pluginProfiler);
+    // With fuseRmsNorm, the GEMM output is added to a residual and normalized with RMSNorm, then quantized per token
+    // for the next int8 GEMM
+    SmoothQuantGemmPlugin(tensorrt_llm::common::QuantMode quantMode, nvinfer1::DataType type, bool fuseRmsNorm,
+        float eps, PluginProfilerPtr const& pluginProfiler);
 
     SmoothQuantGemmPlugin(void const* data, size_t length, PluginProfilerPtr const& pluginProfiler);
 
@@ -100,6 +107,9 @@ private:
 
     void configGemm();
 
+    template <typename T>
+    void invokeRmsNormQuant(void const* const* inputs, void* const* outputs, int m, int n, cudaStream_t stream) const;
+
 private:
     const std::string mLayerName;
 
@@ -107,6 +117,9 @@ private:
     tensorrt_llm::common::QuantMode mQuantMode;
     size_t m_workspaceMaxSize;
 
+    bool mFuseRmsNorm{false};
+    float mEps{0.f};
+
     GemmDims mDims{};
     GemmIdCore mGemmId{};
 
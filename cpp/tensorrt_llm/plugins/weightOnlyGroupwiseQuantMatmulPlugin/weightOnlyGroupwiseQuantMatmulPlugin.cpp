@@ -15,7 +15,9 @@
  * limitations under the License.
  */
 #include "weightOnlyGroupwiseQuantMatmulPlugin.h"
+#include "tensorrt_llm/plugins/common/weightStreamer.h"
 
+#include <algorithm>
 #include <numeric>
 
 using namespace nvinfer1;
@@ -24,6 +26,7 @@ using namespace tensorrt_llm::kernels::cutlass_kernels;
 using tensorrt_llm::plugins::WeightOnlyGroupwiseQuantMatmulPluginCreator;
 using tensorrt_llm::plugins::WeightOnlyGroupwiseQuantMatmulPlugin;
 using tensorrt_llm::plugins::WeightOnlyGroupwiseQuantGemmPluginProfiler;
+using tensorrt_llm::plugins::WeightStreamer;
 
 // Flags for indicating whether the corresponding inputs are applied in mQuantAlgo
 // mQuantAlgo = pre_quant_scale * PRE_QUANT_SCALE + zero * ZERO + bias * BIAS
@@ -185,9 +188,11 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::init(nvinfer1::DataType type, int qua
                         cutlass::uint4b_t, cutlass::WeightOnlyQuantOp::FINEGRAINED_SCALE_ONLY>>();
             }
         }
-        mCudaKernelEnabled = tensorrt_llm::kernels::weight_only::is_supported(
-            mArch, tensorrt_llm::kernels::weight_only::KernelType::FP16Int4Groupwise);
-        mCudaKernelType = tensorrt_llm::kernels::weight_only::KernelType::FP16Int4Groupwise;
+        // W4A8 with smoothed activations reads the same fp8 activations as the CUTLASS kernel
+        mCudaKernelType = (quant_algo & FP8_ALPHA) && (quant_algo & PRE_QUANT_SCALE)
+            ? tensorrt_llm::kernels::weight_only::KernelType::FP8Int4Groupwise
+            : tensorrt_llm::kernels::weight_only::KernelType::FP16Int4Groupwise;
+        mCudaKernelEnabled = tensorrt_llm::kernels::weight_only::is_supported(mArch, mCudaKernelType);
     }
 #if defined(ENABLE_BF16)
     else if (mType == nvinfer1::DataType::kBF16)
@@ -335,6 +340,15 @@ void WeightOnlyGroupwiseQuantMatmulPlugin::configurePlugin(nvinfer1::DynamicPlug
     size_t smoothedActSize = static_cast<size_t>(maxM) * static_cast<size_t>(maxK)
         * (in[0].desc.type == nvinfer1::DataType::kFLOAT ? sizeof(float) : sizeof(half));
     m_workspaceMaxSize = smoothedActSize + m_weightOnlyGroupwiseGemmRunner->getWorkspaceSize(maxM, maxN, maxK);
+    if (mCudaKernelEnabled)
+    {
+        // Split-K partial results of the CUDA kernel, after the fp8 activations for w4a8
+        size_t const workspaces[] = {smoothedActSize,
+            tensorrt_llm::kernels::weight_only::get_split_k_workspace_size(
+                std::min(static_cast<int>(maxM), SMALL_M_FAST_PATH - 1), maxN)};
+        m_workspaceMaxSize
+            = std::max(m_workspaceMaxSize, tensorrt_llm::common::calculateTotalWorkspaceSize(workspaces, 2));
+    }
 }
 
 size_t WeightOnlyGroupwiseQuantMatmulPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
@@ -379,7 +393,9 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(nvinfer1::PluginTensorDesc con
         cudaMemcpy(&alpha, const_cast<void*>(inputs[mAlphaInputIdx]), sizeof(float), cudaMemcpyDeviceToHost);
     }
 
-    if (use_pre_quant_scale && !use_cuda_kernel)
+    bool const use_fp8_act_cuda_kernel
+        = use_cuda_kernel && mCudaKernelType == tensorrt_llm::kernels::weight_only::KernelType::FP8Int4Groupwise;
+    if (use_pre_quant_scale && (!use_cuda_kernel || use_fp8_act_cuda_kernel))
     {
         // Apply pre-quant per channel scale on activations
         act_ptr = reinterpret_cast<half const*>(workspace);
@@ -426,6 +442,7 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(nvinfer1::PluginTensorDesc con
 
     // Quantized weights are packed in FP16 format (INT4*4 -> FP16)
     int real_n = n * FP16_INT4_RATIO;
+    WeightStreamer::ScopedWeights const weights{inputs[mWeightInputIdx], inputDesc[mWeightInputIdx], stream};
     if (use_cuda_kernel)
     {
         void const* pre_quant_scale_ptr = nullptr;
@@ -433,7 +450,15 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(nvinfer1::PluginTensorDesc con
             pre_quant_scale_ptr = inputs[mPreQuantScaleInputIdx];
         void const* cuda_kernel_act_ptr = inputs[0];
         void const* cuda_kernel_act_scale_ptr = pre_quant_scale_ptr;
-        void const* cuda_kernel_weight_ptr = inputs[mWeightInputIdx];
+        size_t cuda_kernel_act_size = 0;
+        if (use_fp8_act_cuda_kernel)
+        {
+            // The pre-quant scale is already applied to the fp8 activations
+            cuda_kernel_act_ptr = workspace;
+            cuda_kernel_act_scale_ptr = nullptr;
+            cuda_kernel_act_size = static_cast<size_t>(m) * k * sizeof(__nv_fp8_e4m3);
+        }
+        void const* cuda_kernel_weight_ptr = weights.get();
         void const* cuda_kernel_scales_ptr = inputs[mScalesInputIdx];
         void const* cuda_kernel_zeros_ptr = zeros_ptr;
         void const* cuda_kernel_bias_ptr = biases_ptr;
@@ -442,24 +467,27 @@ int WeightOnlyGroupwiseQuantMatmulPlugin::enqueue(nvinfer1::PluginTensorDesc con
             cuda_kernel_weight_ptr, cuda_kernel_scales_ptr, cuda_kernel_zeros_ptr, cuda_kernel_bias_ptr,
             cuda_kernel_out_ptr, alpha, m, real_n, k, mGroupSize, mCudaKernelType,
             static_cast<bool>(mQuantAlgo & FP8_ALPHA)};
+        params.workspace
+            = tensorrt_llm::common::nextWorkspacePtr(static_cast<int8_t*>(workspace), cuda_kernel_act_size);
         tensorrt_llm::kernels::weight_only::kernel_launcher(mArch, params, stream);
     }
     else
     {
         int const ws_bytes = m_weightOnlyGroupwiseGemmRunner->getWorkspaceSize(m, n, k);
 
-        int32_t* weight_ptr = const_cast<int32_t*>(reinterpret_cast<int32_t const*>(inputs[mWeightInputIdx]));
-
-        auto const& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
-        TLLM_CHECK_WITH_INFO(bestTactic,
-            "No valid weight only groupwise GEMM tactic(It is usually caused by the failure to execute all "
-            "candidate "
-            "configurations of the CUTLASS kernel, please pay attention to the warning information when building "
-            "the "
-            "engine.)");
-        m_weightOnlyGroupwiseGemmRunner->gemm(act_ptr, weight_ptr, inputs[mScalesInputIdx], zeros_ptr, biases_ptr,
-            alpha, outputs[0], m, real_n, k, mGroupSize, *bestTactic,
-            reinterpret_cast<char*>(workspace) + m * k * sizeof(half), ws_bytes, stream);
+        int32_t* weight_ptr = const_cast<int32_t*>(reinterpret_cast<int32_t const*>(weights.get()));
+
+        mPluginProfiler->runBestConfig(m, mGemmId, stream,
+            [&](auto const& bestTactic)
+            {
+                TLLM_CHECK_WITH_INFO(bestTactic,
+                    "No valid weight only groupwise GEMM tactic(It is usually caused by the failure to execute all "
+                    "candidate configurations of the CUTLASS kernel, please pay attention to the warning information "
+                    "when building the engine.)");
+                m_weightOnlyGroupwiseGemmRunner->gemm(act_ptr, weight_ptr, inputs[mScalesInputIdx], zeros_ptr,
+                    biases_ptr, alpha, outputs[0], m, real_n, k, mGroupSize, *bestTactic,
+                    reinterpret_cast<char*>(workspace) + m * k * sizeof(half), ws_bytes, stream);
+            });
     }
     return 0;
 }
@@ -67,6 +67,11 @@ protected:
 
     std::vector<Config> getTactics(int m, int n, int k) const override;
 
+    std::string getTacticCacheTag() const override
+    {
+        return "quantAlgo=" + std::to_string(mQuantAlgo) + ",groupSize=" + std::to_string(mGroupSize);
+    }
+
 private:
     int mQuantAlgo;
     int mGroupSize;
@@ -15,7 +15,9 @@
  * limitations under the License.
  */
 #include "weightOnlyQuantMatmulPlugin.h"
+#include "tensorrt_llm/plugins/common/weightStreamer.h"
 
+#include <algorithm>
 #include <numeric>
 
 using namespace nvinfer1;
@@ -24,6 +26,7 @@ using namespace tensorrt_llm::kernels::cutlass_kernels;
 using tensorrt_llm::plugins::WeightOnlyQuantMatmulPluginCreator;
 using tensorrt_llm::plugins::WeightOnlyQuantMatmulPlugin;
 using tensorrt_llm::plugins::WeightOnlyQuantGemmPluginProfiler;
+using tensorrt_llm::plugins::WeightStreamer;
 using tensorrt_llm::plugins::read;
 using tensorrt_llm::plugins::write;
 
@@ -272,6 +275,13 @@ void WeightOnlyQuantMatmulPlugin::configurePlugin(nvinfer1::DynamicPluginTensorD
     mGemmId = {N, K, mType};
 
     m_workspaceMaxSize = m_weightOnlyGemmRunner->getWorkspaceSize(maxM, maxN, maxK);
+    if (mCudaKernelEnabled)
+    {
+        // Split-K partial results of the CUDA kernel
+        auto const splitKWorkspaceSize = tensorrt_llm::kernels::weight_only::get_split_k_workspace_size(
+            std::min(static_cast<int>(maxM), SMALL_M_FAST_PATH - 1), maxN);
+        m_workspaceMaxSize = std::max(m_workspaceMaxSize, splitKWorkspaceSize);
+    }
 }
 
 size_t WeightOnlyQuantMatmulPlugin::getWorkspaceSize(nvinfer1::PluginTensorDesc const* inputs, int nbInputs,
@@ -308,28 +318,32 @@ int WeightOnlyQuantMatmulPlugin::enqueue(nvinfer1::PluginTensorDesc const* input
     TLLM_CHECK_WITH_INFO(mType == nvinfer1::DataType::kHALF, "No valid weightOnlyQuantMatmul configuration");
 #endif
     int real_n = mWeightTypeId == WeightTypeId::INT4 ? n * INT8_INT4_RATIO : n;
+    WeightStreamer::ScopedWeights const weights{inputs[1], inputDesc[1], stream};
     if (use_cuda_kernel)
     {
         void const* cuda_kernel_act_ptr = inputs[0];
-        void const* cuda_kernel_weight_ptr = inputs[1];
+        void const* cuda_kernel_weight_ptr = weights.get();
         void const* cuda_kernel_scales_ptr = inputs[2];
         void* cuda_kernel_out_ptr = outputs[0];
         tensorrt_llm::kernels::weight_only::Params params(cuda_kernel_act_ptr, nullptr, cuda_kernel_weight_ptr,
             cuda_kernel_scales_ptr, nullptr, nullptr, cuda_kernel_out_ptr, 1.f, m, real_n, k, 0, mCudaKernelType);
+        params.workspace = workspace;
         tensorrt_llm::kernels::weight_only::kernel_launcher(mArch, params, stream);
     }
     else
     {
         int const ws_size = m_weightOnlyGemmRunner->getWorkspaceSize(m, real_n, k);
 
-        auto const& bestTactic = mPluginProfiler->getBestConfig(m, mGemmId);
-        TLLM_CHECK_WITH_INFO(bestTactic,
-            "No valid weight only per-channel GEMM tactic(It is usually caused by the failure to execute all candidate "
-            "configurations of the CUTLASS kernel, please pay attention to the warning information when building the "
-            "engine.)");
-
-        m_weightOnlyGemmRunner->gemm(inputs[0], inputs[1], inputs[2], outputs[0], m, real_n, k, *bestTactic,
-            reinterpret_cast<char*>(workspace), ws_size, stream);
+        mPluginProfiler->runBestConfig(m, mGemmId, stream,
+            [&](auto const& bestTactic)
+            {
+                TLLM_CHECK_WITH_INFO(bestTactic,
+                    "No valid weight only per-channel GEMM tactic(It is usually caused by the failure to execute all "
+                    "candidate configurations of the CUTLASS kernel, please pay attention to the warning information "
+                    "when building the engine.)");
+                m_weightOnlyGemmRunner->gemm(inputs[0], weights.get(), inputs[2], outputs[0], m, real_n, k,
+                    *bestTactic, reinterpret_cast<char*>(workspace), ws_size, stream);
+            });
     }
 
     return 0;
@@ -73,6 +73,11 @@ protected:
 
     std::vector<Config> getTactics(int m, int n, int k) const override;
 
+    std::string getTacticCacheTag() const override
+    {
+        return "weightTypeId=" + std::to_string(static_cast<int>(mWeightTypeId));
+    }
+
 private:
     WeightTypeId mWeightTypeId;
 };
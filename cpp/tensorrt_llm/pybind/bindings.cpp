@@ -38,6 +38,7 @@
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/gptJsonConfig.h"
 #include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
 #include "tensorrt_llm/runtime/samplingConfig.h"
 
 namespace py = pybind11;
@@ -406,6 +407,14 @@ PYBIND11_MODULE(TRTLLM_PYBIND_MODULE, m)
         .def_property_readonly("pinned", &tr::MemoryCounters::getPinned)
         .def_property_readonly("uvm", &tr::MemoryCounters::getUVM);
 
+    py::class_<tr::MemoryTimeline>(m, "MemoryTimeline")
+        .def_static("instance", &tr::MemoryTimeline::getInstance, py::return_value_policy::reference)
+        .def_static("enabled", &tr::MemoryTimeline::isEnabled)
+        .def_property_readonly("num_dropped", &tr::MemoryTimeline::getNumDropped)
+        .def("dump", &tr::MemoryTimeline::dump, py::arg("path"))
+        .def("write_csv", &tr::MemoryTimeline::writeCsv, py::arg("path"))
+        .def("clear", &tr::MemoryTimeline::clear);
+
     py::class_<tensorrt_llm::mpi::MpiComm>(m, "MpiComm")
         .def_static("rank",
             []()
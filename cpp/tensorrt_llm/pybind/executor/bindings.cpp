@@ -17,6 +17,7 @@
 
 #include <pybind11/cast.h>
 #include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -28,6 +29,7 @@
 #include "tensorCaster.h"
 
 #include "tensorrt_llm/executor/executor.h"
+#include "tensorrt_llm/executor/metrics.h"
 #include "tensorrt_llm/executor/tensor.h"
 #include "tensorrt_llm/executor/types.h"
 
@@ -39,6 +41,30 @@ using FloatType = tle::FloatType;
 using VecTokens = tle::VecTokens;
 using IdType = tle::IdType;
 
+namespace
+{
+
+// Expose the elements of `vec` through the buffer protocol, without converting them to Python objects. The array is
+// a read-only view that keeps `owner` alive, `vec` must not be reallocated while the array is in use.
+template <typename T>
+py::array_t<T> toArrayView(std::vector<T> const& vec, py::handle owner)
+{
+    py::array_t<T> array({vec.size()}, {sizeof(T)}, vec.data(), owner);
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+// Move `vec` into an array that owns it.
+template <typename T>
+py::array_t<T> toArray(std::vector<T>&& vec)
+{
+    auto* owned = new std::vector<T>(std::move(vec));
+    py::capsule capsule(owned, [](void* ptr) { delete static_cast<std::vector<T>*>(ptr); });
+    return py::array_t<T>({owned->size()}, {sizeof(T)}, owned->data(), capsule);
+}
+
+} // namespace
+
 namespace tensorrt_llm::pybind::executor
 {
 
@@ -78,6 +104,13 @@ void InitBindings(pybind11::module_& m)
         .value("EQUAL_PROGRESS", tle::ContextChunkingPolicy::kEQUAL_PROGRESS)
         .value("FIRST_COME_FIRST_SERVED", tle::ContextChunkingPolicy::kFIRST_COME_FIRST_SERVED);
 
+    py::enum_<tle::FinishReason>(m, "FinishReason")
+        .value("NOT_FINISHED", tle::FinishReason::kNOT_FINISHED)
+        .value("END_ID", tle::FinishReason::kEND_ID)
+        .value("STOP_WORDS", tle::FinishReason::kSTOP_WORDS)
+        .value("LENGTH", tle::FinishReason::kLENGTH)
+        .value("CANCELLED", tle::FinishReason::kCANCELLED);
+
     py::enum_<tle::CommunicationType>(m, "CommunicationType").value("MPI", tle::CommunicationType::kMPI);
 
     py::enum_<tle::CommunicationMode>(m, "CommunicationMode")
@@ -112,6 +145,39 @@ void InitBindings(pybind11::module_& m)
         .def_readwrite("micro_batch_id", &tle::InflightBatchingStats::microBatchId)
         .def_readwrite("avg_num_decoded_tokens_per_iter", &tle::InflightBatchingStats::avgNumDecodedTokensPerIter);
 
+    py::class_<tle::MoeLoadStats>(m, "MoeLoadStats")
+        .def(py::init<>())
+        .def_readwrite("first_expert", &tle::MoeLoadStats::firstExpert)
+        .def_readwrite("expert_token_counts", &tle::MoeLoadStats::expertTokenCounts);
+
+    py::class_<tle::CommOpStats>(m, "CommOpStats")
+        .def(py::init<>())
+        .def_readwrite("op", &tle::CommOpStats::op)
+        .def_readwrite("strategy", &tle::CommOpStats::strategy)
+        .def_readwrite("num_calls", &tle::CommOpStats::numCalls)
+        .def_readwrite("time_ms", &tle::CommOpStats::timeMs)
+        .def_readwrite("bytes", &tle::CommOpStats::bytes);
+
+    py::class_<tle::CommStats>(m, "CommStats")
+        .def(py::init<>())
+        .def_readwrite("total_time_ms", &tle::CommStats::totalTimeMs)
+        .def_readwrite("total_bytes", &tle::CommStats::totalBytes)
+        .def_readwrite("ops", &tle::CommStats::ops);
+
+    py::class_<tle::MemoryTagStats>(m, "MemoryTagStats")
+        .def(py::init<>())
+        .def_readwrite("tag", &tle::MemoryTagStats::tag)
+        .def_readwrite("memory_type", &tle::MemoryTagStats::memoryType)
+        .def_readwrite("current_bytes", &tle::MemoryTagStats::currentBytes)
+        .def_readwrite("peak_bytes", &tle::MemoryTagStats::peakBytes)
+        .def_readwrite("num_allocations", &tle::MemoryTagStats::numAllocations)
+        .def_readwrite("num_frees", &tle::MemoryTagStats::numFrees);
+
+    py::class_<tle::MemoryTimelineStats>(m, "MemoryTimelineStats")
+        .def(py::init<>())
+        .def_readwrite("tags", &tle::MemoryTimelineStats::tags)
+        .def_readwrite("untracked_gpu_bytes", &tle::MemoryTimelineStats::untrackedGpuBytes);
+
     py::class_<tle::IterationStats>(m, "IterationStats")
         .def(py::init<>())
         .def_readwrite("timestamp", &tle::IterationStats::timestamp)
@@ -126,10 +192,18 @@ void InitBindings(pybind11::module_& m)
         .def_readwrite("kv_cache_stats", &tle::IterationStats::kvCacheStats)
         .def_readwrite("static_batching_stats", &tle::IterationStats::staticBatchingStats)
         .def_readwrite("inflight_batching_stats", &tle::IterationStats::inflightBatchingStats)
+        .def_readwrite("moe_load_stats", &tle::IterationStats::moeLoadStats)
+        .def_readwrite("comm_stats", &tle::IterationStats::commStats)
+        .def_readwrite("memory_timeline_stats", &tle::IterationStats::memoryTimelineStats)
         .def("to_json_str",
             [](tle::IterationStats const& iterationStats)
             { return tle::JsonSerialization::toJsonStr(iterationStats); });
 
+    py::class_<tle::IterationStatsMetrics>(m, "IterationStatsMetrics")
+        .def(py::init<std::string const&>(), py::arg("prefix") = "trtllm_")
+        .def("observe", &tle::IterationStatsMetrics::observe, py::arg("stats"))
+        .def("render_open_metrics", &tle::IterationStatsMetrics::renderOpenMetrics);
+
     py::enum_<tle::RequestStage>(m, "RequestStage")
         .value("QUEUED", tle::RequestStage::kQUEUED)
         .value("ENCODER_IN_PROGRESS", tle::RequestStage::kENCODER_IN_PROGRESS)
@@ -238,6 +312,8 @@ void InitBindings(pybind11::module_& m)
             py::arg("logits_post_processor_name") = py::none(), py::arg("encoder_input_token_ids") = py::none(),
             py::arg("return_all_generated_tokens") = false)
         .def_property_readonly("input_token_ids", &tle::Request::getInputTokenIds)
+        .def_property_readonly("input_token_ids_array",
+            [](tle::Request const& self) { return toArray(self.getInputTokenIds()); })
         .def_property_readonly("max_new_tokens", &tle::Request::getMaxNewTokens)
         .def_property("streaming", &tle::Request::getStreaming, &tle::Request::setStreaming)
         .def_property("sampling_config", &tle::Request::getSamplingConfig, &tle::Request::setSamplingConfig)
@@ -268,7 +344,17 @@ void InitBindings(pybind11::module_& m)
         .def_readwrite("log_probs", &tle::Result::logProbs)
         .def_readwrite("context_logits", &tle::Result::contextLogits)
         .def_readwrite("generation_logits", &tle::Result::generationLogits)
-        .def_readwrite("encoder_output", &tle::Result::encoderOutput);
+        .def_readwrite("encoder_output", &tle::Result::encoderOutput)
+        .def_property_readonly("output_token_ids_array",
+            [](py::object const& self)
+            {
+                py::list beams;
+                for (auto const& beamTokens : self.cast<tle::Result const&>().outputTokenIds)
+                {
+                    beams.append(toArrayView(beamTokens, self));
+                }
+                return beams;
+            });
 
     py::class_<tle::Response>(m, "Response")
         .def(py::init<IdType, std::string>(), py::arg("request_id"), py::arg("error_msg"))
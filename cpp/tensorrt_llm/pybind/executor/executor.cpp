@@ -21,6 +21,7 @@
 #include "tensorrt_llm/pybind/utils/pathCaster.h"
 
 #include <pybind11/chrono.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
@@ -83,6 +84,34 @@ void Executor::shutdown()
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+std::vector<tle::IdType> Executor::enqueueRequestsFromBuffer(
+    py::array_t<tle::TokenIdType, py::array::c_style | py::array::forcecast> const& inputTokenIds,
+    py::array_t<int64_t, py::array::c_style | py::array::forcecast> const& offsets, tle::SizeType32 maxNewTokens,
+    bool streaming, tle::SamplingConfig const& samplingConfig, tle::OutputConfig const& outputConfig,
+    std::optional<tle::SizeType32> const& endId, std::optional<tle::SizeType32> const& padId)
+{
+    TLLM_CHECK_WITH_INFO(inputTokenIds.ndim() == 1 && offsets.ndim() == 1, "Expected 1D input_token_ids and offsets");
+    TLLM_CHECK_WITH_INFO(offsets.size() > 0, "offsets must hold the end of the last request");
+    auto const numRequests = static_cast<std::size_t>(offsets.size() - 1);
+    auto const numTokens = static_cast<int64_t>(inputTokenIds.size());
+    // The arrays are kept alive by the arguments, their buffers are read without the GIL.
+    auto const* tokens = inputTokenIds.data();
+    auto const* tokenOffsets = offsets.data();
+
+    py::gil_scoped_release release;
+    std::vector<tle::Request> requests;
+    requests.reserve(numRequests);
+    for (std::size_t i = 0; i < numRequests; ++i)
+    {
+        auto const begin = tokenOffsets[i];
+        auto const end = tokenOffsets[i + 1];
+        TLLM_CHECK_WITH_INFO(0 <= begin && begin <= end && end <= numTokens, "Invalid offsets of request %lu", i);
+        requests.emplace_back(tle::VecTokens(tokens + begin, tokens + end), maxNewTokens, streaming, samplingConfig,
+            outputConfig, endId, padId);
+    }
+    return mExecutor->enqueueRequests(std::move(requests));
+}
+
 void Executor::initBindings(py::module_& m)
 {
     py::class_<Executor>(m, "Executor")
@@ -103,6 +132,11 @@ void Executor::initBindings(py::module_& m)
         .def("__exit__", &Executor::exit)
         .def("enqueue_request", &Executor::enqueueRequest, py::arg("request"))
         .def("enqueue_requests", &Executor::enqueueRequests, py::arg("requests"))
+        .def("enqueue_requests_from_buffer", &Executor::enqueueRequestsFromBuffer, py::arg("input_token_ids"),
+            py::arg("offsets"), py::arg("max_new_tokens"), py::arg("streaming") = false,
+            py::arg_v("sampling_config", tle::SamplingConfig(), "SamplingConfig()"),
+            py::arg_v("output_config", tle::OutputConfig(), "OutputConfig()"), py::arg("end_id") = py::none(),
+            py::arg("pad_id") = py::none())
         .def("await_responses",
             py::overload_cast<std::optional<std::chrono::milliseconds> const&>(&Executor::awaitResponses),
             py::arg("timeout") = py::none())
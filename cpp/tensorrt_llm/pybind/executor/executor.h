@@ -18,6 +18,7 @@
 #pragma once
 #include "tensorrt_llm/executor/executor.h"
 #include "tensorrt_llm/executor/types.h"
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
 namespace tle = tensorrt_llm::executor;
@@ -48,14 +49,27 @@ public:
 
     [[nodiscard]] tle::IdType enqueueRequest(tle::Request request)
     {
+        // The arguments are converted already, the executor may wait for its queue lock.
+        pybind11::gil_scoped_release release;
         return mExecutor->enqueueRequest(std::move(request));
     }
 
     [[nodiscard]] std::vector<tle::IdType> enqueueRequests(std::vector<tle::Request> requests)
     {
+        pybind11::gil_scoped_release release;
         return mExecutor->enqueueRequests(std::move(requests));
     }
 
+    //! \brief Enqueue one request per row of a ragged batch of input tokens, without a Python object per token.
+    //! \param inputTokenIds The tokens of all the requests, concatenated.
+    //! \param offsets The tokens of request i are [offsets[i], offsets[i + 1]) in inputTokenIds.
+    [[nodiscard]] std::vector<tle::IdType> enqueueRequestsFromBuffer(
+        pybind11::array_t<tle::TokenIdType, pybind11::array::c_style | pybind11::array::forcecast> const& inputTokenIds,
+        pybind11::array_t<int64_t, pybind11::array::c_style | pybind11::array::forcecast> const& offsets,
+        tle::SizeType32 maxNewTokens, bool streaming, tle::SamplingConfig const& samplingConfig,
+        tle::OutputConfig const& outputConfig, std::optional<tle::SizeType32> const& endId,
+        std::optional<tle::SizeType32> const& padId);
+
     [[nodiscard]] std::vector<tle::Response> awaitResponses(
         std::optional<std::chrono::milliseconds> const& timeout = std::nullopt)
     {
@@ -35,24 +35,49 @@ struct type_caster<tensorrt_llm::executor::Tensor>
 public:
     PYBIND11_TYPE_CASTER(tensorrt_llm::executor::Tensor, _("torch.Tensor"));
 
-    // Convert PyObject(torch.Tensor) -> tensorrt_llm::executor::Tensor
+    // Convert PyObject(torch.Tensor or any object implementing __dlpack__) -> tensorrt_llm::executor::Tensor
     bool load(handle src, bool)
     {
         PyObject* obj = src.ptr();
         if (THPVariable_Check(obj))
         {
-            at::Tensor const& t = THPVariable_Unpack(obj);
-            value = tensorrt_llm::executor::detail::ofITensor(tensorrt_llm::runtime::TorchView::of(t));
+            value = ofTorch(THPVariable_Unpack(obj));
+            return true;
+        }
+        if (hasattr(src, "__dlpack__"))
+        {
+            // Zero-copy, the producer orders its pending work before the current torch stream of the device
+            auto const tensor = module_::import("torch.utils.dlpack").attr("from_dlpack")(src);
+            value = ofTorch(THPVariable_Unpack(tensor.ptr()));
             return true;
         }
         return false;
     }
 
-    // Convert tensorrt_llm::executor::Tensor -> PyObject(torch.Tensor)
+    // Convert tensorrt_llm::executor::Tensor -> PyObject(torch.Tensor), zero-copy, it implements __dlpack__
     static handle cast(tensorrt_llm::executor::Tensor const& src, return_value_policy /* policy */, handle /* parent */)
     {
         return THPVariable_Wrap(tensorrt_llm::runtime::Torch::tensor(tensorrt_llm::executor::detail::toITensor(src)));
     }
+
+private:
+    static tensorrt_llm::executor::Tensor ofTorch(at::Tensor const& src)
+    {
+        // Only strided views are copied, TorchView requires contiguous memory
+        auto tensor = src.is_contiguous() ? src : src.contiguous();
+        if (tensor.is_cuda())
+        {
+            // The executor reads the tensor on its own streams, so wait for the work pending on the current torch
+            // stream of the device, instead of the whole device.
+            auto const stream = at::cuda::getCurrentCUDAStream(tensor.get_device());
+            if (!stream.query())
+            {
+                gil_scoped_release release;
+                stream.synchronize();
+            }
+        }
+        return tensorrt_llm::executor::detail::ofITensor(tensorrt_llm::runtime::TorchView::of(std::move(tensor)));
+    }
 };
 
 } // namespace detail
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/runtime/allocationAudit.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <atomic>
+#include <sstream>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+struct AtomicCounts
+{
+    std::atomic<std::uint64_t> numHostAllocations{0};
+    std::atomic<std::uint64_t> numDeviceAllocations{0};
+};
+
+std::atomic<bool> enabled{false};
+std::array<AtomicCounts, MemoryTimeline::kNumTags> counts{};
+
+AtomicCounts& getCounts()
+{
+    return counts[static_cast<std::size_t>(MemoryTimeline::getCurrentTag())];
+}
+} // namespace
+
+void AllocationAudit::setEnabled(bool value) noexcept
+{
+    enabled.store(value, std::memory_order_relaxed);
+}
+
+bool AllocationAudit::isEnabled() noexcept
+{
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void AllocationAudit::recordHostAllocation() noexcept
+{
+    if (isEnabled())
+    {
+        getCounts().numHostAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void AllocationAudit::recordAllocation(MemoryType memoryType) noexcept
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    if (memoryType == MemoryType::kCPU)
+    {
+        getCounts().numHostAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    else
+    {
+        getCounts().numDeviceAllocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+AllocationAudit::TagCounts AllocationAudit::takeCounts() noexcept
+{
+    TagCounts taken;
+    for (std::size_t i = 0; i < taken.size(); ++i)
+    {
+        taken[i].numHostAllocations = counts[i].numHostAllocations.exchange(0, std::memory_order_relaxed);
+        taken[i].numDeviceAllocations = counts[i].numDeviceAllocations.exchange(0, std::memory_order_relaxed);
+    }
+    return taken;
+}
+
+std::string AllocationAudit::toString(TagCounts const& tagCounts)
+{
+    std::ostringstream os;
+    for (std::size_t i = 0; i < tagCounts.size(); ++i)
+    {
+        auto const& tagCount = tagCounts[i];
+        if (tagCount.numHostAllocations == 0 && tagCount.numDeviceAllocations == 0)
+        {
+            continue;
+        }
+        if (os.tellp() > 0)
+        {
+            os << ", ";
+        }
+        os << MemoryTimeline::getTagName(static_cast<Tag>(i)) << ": " << tagCount.numHostAllocations << " host, "
+           << tagCount.numDeviceAllocations << " device";
+    }
+    return os.str();
+}
+
+void AllocationAudit::checkNoAllocations(char const* where)
+{
+    auto const allocations = toString(takeCounts());
+    TLLM_CHECK_WITH_INFO(allocations.empty(), "%s allocated (%s)", where, allocations.c_str());
+}
+
+} // namespace tensorrt_llm::runtime
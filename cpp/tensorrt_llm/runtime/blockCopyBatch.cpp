@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/blockCopyBatch.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+namespace tensorrt_llm::runtime
+{
+
+BlockCopyBatch::BlockCopyBatch(std::size_t blockSizeInBytes, SizeType32 maxNumCopies, CudaStreamPtr copyStream)
+    : mBlockSizeInBytes{blockSizeInBytes}
+    , mMaxNumCopies{maxNumCopies}
+    , mStream{std::move(copyStream)}
+    , mCurrentBuffer{0}
+    , mNumQueued{0}
+    , mNumCopied{0}
+{
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(mStream), "Undefined CUDA stream");
+    TLLM_CHECK(mBlockSizeInBytes > 0);
+    TLLM_CHECK(mMaxNumCopies > 0);
+    for (SizeType32 i = 0; i < kNumBuffers; ++i)
+    {
+        mSrcPointers[i] = BufferManager::pinned(mMaxNumCopies, TRTDataType<void*>::value);
+        mDstPointers[i] = BufferManager::pinned(mMaxNumCopies, TRTDataType<void*>::value);
+    }
+}
+
+void BlockCopyBatch::add(void const* src, void* dst)
+{
+    if (mNumQueued == mMaxNumCopies)
+    {
+        flush();
+    }
+    if (mNumQueued == 0 && mBufferDone[mCurrentBuffer])
+    {
+        // The pointer arrays are about to be overwritten, make sure the kernel that read them finished.
+        mBufferDone[mCurrentBuffer]->synchronize();
+    }
+    bufferCast<void*>(*mSrcPointers[mCurrentBuffer])[mNumQueued] = const_cast<void*>(src);
+    bufferCast<void*>(*mDstPointers[mCurrentBuffer])[mNumQueued] = dst;
+    ++mNumQueued;
+}
+
+BlockCopyBatch::EventPtr BlockCopyBatch::flush()
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mNumQueued == 0)
+    {
+        return nullptr;
+    }
+    auto const srcPointers = IBuffer::slice(mSrcPointers[mCurrentBuffer], 0, mNumQueued);
+    auto const dstPointers = IBuffer::slice(mDstPointers[mCurrentBuffer], 0, mNumQueued);
+    kernels::invokeCopyBlocks(*srcPointers, *dstPointers, mBlockSizeInBytes, *mStream);
+
+    auto event = std::make_shared<CudaEvent>();
+    mStream->record(*event);
+    mBufferDone[mCurrentBuffer] = event;
+    mNumCopied += mNumQueued;
+    TLLM_LOG_DEBUG("Issued %d block copies", mNumQueued);
+
+    mCurrentBuffer = (mCurrentBuffer + 1) % kNumBuffers;
+    mNumQueued = 0;
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return event;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -51,6 +51,16 @@ BufferManager::ITensorPtr BufferManager::gpu(nvinfer1::Dims dims, nvinfer1::Data
     return std::make_unique<DeviceTensor>(dims, type, CudaAllocatorAsync{mStream});
 }
 
+BufferManager::IBufferPtr BufferManager::gpuCached(std::size_t size, nvinfer1::DataType type) const
+{
+    return std::make_unique<CachingDeviceBuffer>(size, type, CudaCachingAllocator{mStream});
+}
+
+BufferManager::ITensorPtr BufferManager::gpuCached(nvinfer1::Dims dims, nvinfer1::DataType type) const
+{
+    return std::make_unique<CachingDeviceTensor>(dims, type, CudaCachingAllocator{mStream});
+}
+
 BufferManager::IBufferPtr BufferManager::gpuSync(std::size_t size, nvinfer1::DataType type)
 {
     return std::make_unique<StaticDeviceBuffer>(size, type, CudaAllocator{});
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/blockPool.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 
 #include <string>
@@ -91,6 +92,17 @@ public:
 
     ~BufferView() override = default;
 
+    // Views are created and destroyed many times per step, their memory is recycled per thread
+    static void* operator new(std::size_t size)
+    {
+        return common::ThreadLocalBlockPool<sizeof(BufferView)>::allocate(size);
+    }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept
+    {
+        common::ThreadLocalBlockPool<sizeof(BufferView)>::deallocate(ptr, size);
+    }
+
 private:
     IBuffer::SharedPtr mBuffer;
     std::size_t mOffset, mSize;
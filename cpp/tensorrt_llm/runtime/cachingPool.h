@@ -0,0 +1,266 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace detail
+{
+//! \brief Size classes of the caching pool: kMinSize, then kNumSubClasses classes per power of two, i.e. at most
+//! 1 / kNumSubClasses of a block is padding.
+class SizeClasses
+{
+public:
+    static constexpr std::size_t kMinSize{512};
+    static constexpr std::size_t kNumSubClasses{4};
+    static constexpr std::size_t kNumClasses{160};
+
+    //! \brief Smallest class holding `size` bytes.
+    static std::size_t getIndex(std::size_t size)
+    {
+        if (size <= kMinSize)
+        {
+            return 0;
+        }
+        // size is in (2^exponent, 2^(exponent + 1)], split into kNumSubClasses steps of 2^exponent / kNumSubClasses.
+        auto const exponent = floorLog2(size - 1);
+        auto const step = (std::size_t{1} << exponent) / kNumSubClasses;
+        auto const subClass = (size - 1 - (std::size_t{1} << exponent)) / step;
+        auto const index = (exponent - kMinExponent) * kNumSubClasses + subClass + 1;
+        TLLM_CHECK_WITH_INFO(index < kNumClasses, "Allocation of %zu B is too large for the caching pool", size);
+        return index;
+    }
+
+    //! \brief Bytes of a block of class `index`.
+    static std::size_t getSize(std::size_t index)
+    {
+        if (index == 0)
+        {
+            return kMinSize;
+        }
+        auto const exponent = (index - 1) / kNumSubClasses + kMinExponent;
+        auto const subClass = (index - 1) % kNumSubClasses;
+        auto const step = (std::size_t{1} << exponent) / kNumSubClasses;
+        return (std::size_t{1} << exponent) + (subClass + 1) * step;
+    }
+
+private:
+    static constexpr std::size_t kMinExponent{9};
+    static_assert(std::size_t{1} << kMinExponent == kMinSize);
+
+    static std::size_t floorLog2(std::size_t value)
+    {
+        std::size_t exponent{0};
+        while (value >>= 1)
+        {
+            ++exponent;
+        }
+        return exponent;
+    }
+};
+} // namespace detail
+
+//! \brief Statistics of a CachingPool, in bytes unless noted otherwise.
+struct CachingPoolStats
+{
+    //! Memory allocated from the upstream allocator.
+    std::size_t reserved{0};
+    //! Blocks handed out, including padding.
+    std::size_t used{0};
+    //! Bytes requested for the blocks handed out, used - requested is padding.
+    std::size_t requested{0};
+    //! Free blocks kept for reuse.
+    std::size_t cached{0};
+    //! Number of allocations, and how many were served from the cache or from the cache of another stream.
+    std::uint64_t numAllocations{0};
+    std::uint64_t numCacheHits{0};
+    std::uint64_t numCrossStreamHits{0};
+};
+
+//! \brief Caching allocator with power-of-two size classes and free lists per stream, allocation and release are O(1).
+//! \details A freed block is kept in the free list of its class and of the stream that used it. It is reused by the
+//! same stream without synchronization, because work on a stream runs in order. If the free list of the stream is
+//! empty, a block freed by another stream is used, after the allocating stream waits for the work submitted so far to
+//! the other stream. Memory returns to the upstream allocator only in emptyCache(), which also runs when the upstream
+//! allocator fails.
+//! \tparam TAllocator Upstream allocator with allocate(size) and deallocate(ptr, size).
+//! \tparam TStreamSync Provides StreamType and waitForStream(waiting, other), making `waiting` wait for the work
+//! submitted to `other`.
+template <typename TAllocator, typename TStreamSync>
+class CachingPool
+{
+public:
+    using PointerType = typename TAllocator::PointerType;
+    using StreamType = typename TStreamSync::StreamType;
+
+    explicit CachingPool(TAllocator allocator = TAllocator{})
+        : mAllocator{std::move(allocator)}
+    {
+    }
+
+    ~CachingPool()
+    {
+        emptyCache();
+    }
+
+    CachingPool(CachingPool const&) = delete;
+    CachingPool& operator=(CachingPool const&) = delete;
+
+    PointerType allocate(std::size_t size, StreamType stream)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const classIndex = detail::SizeClasses::getIndex(size);
+        auto const blockSize = detail::SizeClasses::getSize(classIndex);
+        ++mStats.numAllocations;
+
+        auto ptr = takeCached(classIndex, stream);
+        if (ptr == nullptr)
+        {
+            ptr = allocateUpstream(blockSize);
+        }
+        else
+        {
+            ++mStats.numCacheHits;
+            mStats.cached -= blockSize;
+        }
+        mAllocated.emplace(ptr, Allocation{classIndex, size, stream});
+        mStats.used += blockSize;
+        mStats.requested += size;
+        return ptr;
+    }
+
+    void deallocate(PointerType ptr)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        auto const it = mAllocated.find(ptr);
+        TLLM_CHECK_WITH_INFO(it != mAllocated.end(), "CachingPool: pointer %p was not allocated by this pool", ptr);
+        auto const [classIndex, size, stream] = it->second;
+        mAllocated.erase(it);
+        auto const blockSize = detail::SizeClasses::getSize(classIndex);
+        mStats.used -= blockSize;
+        mStats.requested -= size;
+        mStats.cached += blockSize;
+        mFreeLists[stream][classIndex].push_back(ptr);
+    }
+
+    //! \brief Return all free blocks to the upstream allocator.
+    void emptyCache()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        emptyCacheLocked();
+    }
+
+    [[nodiscard]] CachingPoolStats getStats() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStats;
+    }
+
+private:
+    struct Allocation
+    {
+        std::size_t classIndex;
+        std::size_t size;
+        StreamType stream;
+    };
+
+    using FreeLists = std::array<std::vector<PointerType>, detail::SizeClasses::kNumClasses>;
+
+    PointerType takeCached(std::size_t classIndex, StreamType stream)
+    {
+        if (auto const own = mFreeLists.find(stream); own != mFreeLists.end() && !own->second[classIndex].empty())
+        {
+            auto& freeList = own->second[classIndex];
+            auto const ptr = freeList.back();
+            freeList.pop_back();
+            return ptr;
+        }
+        for (auto& [otherStream, freeLists] : mFreeLists)
+        {
+            auto& freeList = freeLists[classIndex];
+            if (otherStream != stream && !freeList.empty())
+            {
+                TStreamSync::waitForStream(stream, otherStream);
+                auto const ptr = freeList.back();
+                freeList.pop_back();
+                ++mStats.numCrossStreamHits;
+                return ptr;
+            }
+        }
+        return nullptr;
+    }
+
+    PointerType allocateUpstream(std::size_t blockSize)
+    {
+        try
+        {
+            auto ptr = mAllocator.allocate(blockSize);
+            mStats.reserved += blockSize;
+            return ptr;
+        }
+        catch (std::exception const&)
+        {
+            if (mStats.cached == 0)
+            {
+                throw;
+            }
+        }
+        // Out of memory, retry without the cached blocks.
+        emptyCacheLocked();
+        auto ptr = mAllocator.allocate(blockSize);
+        mStats.reserved += blockSize;
+        return ptr;
+    }
+
+    void emptyCacheLocked()
+    {
+        for (auto& [stream, freeLists] : mFreeLists)
+        {
+            for (std::size_t classIndex = 0; classIndex < freeLists.size(); ++classIndex)
+            {
+                auto const blockSize = detail::SizeClasses::getSize(classIndex);
+                for (auto const ptr : freeLists[classIndex])
+                {
+                    mAllocator.deallocate(ptr, blockSize);
+                    mStats.reserved -= blockSize;
+                    mStats.cached -= blockSize;
+                }
+            }
+        }
+        mFreeLists.clear();
+    }
+
+    TAllocator mAllocator;
+    mutable std::mutex mMutex;
+    std::unordered_map<PointerType, Allocation> mAllocated;
+    std::unordered_map<StreamType, FreeLists> mFreeLists;
+    CachingPoolStats mStats;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/commTimingTracker.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
+
+#include <map>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+CommTimingTracker::ScopedTiming::ScopedTiming(OpType op, std::size_t bytes, cudaStream_t stream, char const* strategy)
+    : mOp{op}
+    , mBytes{bytes}
+    , mStream{stream}
+    , mStrategy{strategy}
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+    cudaStreamCaptureStatus captureStatus;
+    TLLM_CUDA_CHECK(cudaStreamIsCapturing(stream, &captureStatus));
+    if (captureStatus != cudaStreamCaptureStatusNone)
+    {
+        return;
+    }
+    mStart = getInstance().acquireEvent();
+    TLLM_CUDA_CHECK(cudaEventRecord(mStart, mStream));
+}
+
+CommTimingTracker::ScopedTiming::~ScopedTiming()
+{
+    if (mStart == nullptr)
+    {
+        return;
+    }
+    auto& tracker = getInstance();
+    auto* end = tracker.acquireEvent();
+    TLLM_CUDA_CHECK(cudaEventRecord(end, mStream));
+    tracker.addRecord(Record{mOp, mStrategy, mBytes, mStart, end});
+}
+
+CommTimingTracker& CommTimingTracker::getInstance()
+{
+    static CommTimingTracker mInstance;
+    return mInstance;
+}
+
+bool CommTimingTracker::isEnabled()
+{
+    return common::getEnvEnableCommTimingStats();
+}
+
+char const* CommTimingTracker::getOpName(OpType op)
+{
+    switch (op)
+    {
+    case OpType::kALLREDUCE: return "allreduce";
+    case OpType::kALLGATHER: return "allgather";
+    case OpType::kREDUCE_SCATTER: return "reduce_scatter";
+    case OpType::kSEND: return "send";
+    case OpType::kRECV: return "recv";
+    }
+    return "unknown";
+}
+
+cudaEvent_t CommTimingTracker::acquireEvent()
+{
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (!mFreeEvents.empty())
+        {
+            auto* event = mFreeEvents.back();
+            mFreeEvents.pop_back();
+            return event;
+        }
+    }
+    cudaEvent_t event;
+    TLLM_CUDA_CHECK(cudaEventCreate(&event));
+    return event;
+}
+
+void CommTimingTracker::addRecord(Record record)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRecords.emplace_back(std::move(record));
+}
+
+std::vector<CommTimingTracker::OpStats> CommTimingTracker::takeStats()
+{
+    std::vector<Record> records;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        records.swap(mRecords);
+    }
+
+    std::map<std::pair<OpType, std::string>, OpStats> opStats;
+    for (auto const& record : records)
+    {
+        TLLM_CUDA_CHECK(cudaEventSynchronize(record.end));
+        float timeMs{0.f};
+        TLLM_CUDA_CHECK(cudaEventElapsedTime(&timeMs, record.start, record.end));
+        auto& stats
+            = opStats.try_emplace({record.op, record.strategy}, OpStats{record.op, record.strategy}).first->second;
+        ++stats.numCalls;
+        stats.timeMs += timeMs;
+        stats.bytes += record.bytes;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto const& record : records)
+        {
+            mFreeEvents.push_back(record.start);
+            mFreeEvents.push_back(record.end);
+        }
+    }
+
+    std::vector<OpStats> stats;
+    stats.reserve(opStats.size());
+    for (auto& [key, value] : opStats)
+    {
+        stats.emplace_back(std::move(value));
+    }
+    return stats;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/deviceTopology.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <string>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace tensorrt_llm::runtime;
+namespace fs = std::filesystem;
+
+namespace
+{
+
+struct DeviceLocation
+{
+    // Components of the sysfs path of the device below /sys/devices, from the PCIe root complex to the device
+    std::vector<std::string> pciPath;
+    int numaNode{-1};
+};
+
+DeviceLocation readDeviceLocation(int device)
+{
+    DeviceLocation location;
+#if defined(__linux__)
+    char busId[32];
+    if (cudaDeviceGetPCIBusId(busId, sizeof(busId), device) != cudaSuccess)
+    {
+        cudaGetLastError();
+        return location;
+    }
+    std::string name{busId};
+    std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return std::tolower(c); });
+    auto const devicePath = fs::path{"/sys/bus/pci/devices"} / name;
+
+    std::error_code ec;
+    auto const canonicalPath = fs::canonical(devicePath, ec);
+    if (!ec)
+    {
+        auto const devicesRoot = fs::path{"/sys/devices"};
+        for (auto const& component : canonicalPath.lexically_relative(devicesRoot))
+        {
+            location.pciPath.push_back(component.string());
+        }
+    }
+    std::ifstream numaFile{devicePath / "numa_node"};
+    if (!(numaFile >> location.numaNode))
+    {
+        location.numaNode = -1;
+    }
+#endif
+    return location;
+}
+
+DeviceLocation const& getDeviceLocation(int device)
+{
+    static std::mutex mutex;
+    static std::map<int, DeviceLocation> locations;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = locations.find(device);
+    if (it == locations.end())
+    {
+        it = locations.emplace(device, readDeviceLocation(device)).first;
+    }
+    return it->second;
+}
+
+bool isNvlinkPeer(int deviceA, int deviceB)
+{
+    // Only NVLink provides native atomics between peers, PCIe peer to peer access does not.
+    int accessSupported{0};
+    int nativeAtomics{0};
+    if (cudaDeviceGetP2PAttribute(&accessSupported, cudaDevP2PAttrAccessSupported, deviceA, deviceB) != cudaSuccess
+        || cudaDeviceGetP2PAttribute(&nativeAtomics, cudaDevP2PAttrNativeAtomicSupported, deviceA, deviceB)
+            != cudaSuccess)
+    {
+        cudaGetLastError();
+        return false;
+    }
+    return accessSupported != 0 && nativeAtomics != 0;
+}
+
+} // namespace
+
+int DeviceTopology::getNumaNode(int device)
+{
+    return getDeviceLocation(device).numaNode;
+}
+
+DeviceTopology::LinkType DeviceTopology::getLinkType(int deviceA, int deviceB)
+{
+    if (deviceA == deviceB || isNvlinkPeer(deviceA, deviceB))
+    {
+        return LinkType::kNVLINK;
+    }
+    auto const& locationA = getDeviceLocation(deviceA);
+    auto const& locationB = getDeviceLocation(deviceB);
+    auto const& pathA = locationA.pciPath;
+    auto const& pathB = locationB.pciPath;
+    auto const commonDepth
+        = std::mismatch(pathA.begin(), pathA.end(), pathB.begin(), pathB.end()).first - pathA.begin();
+    // Root complex, root port and upstream port of a switch
+    if (commonDepth >= 3)
+    {
+        return LinkType::kPCIE_SWITCH;
+    }
+    if (commonDepth >= 1 || (locationA.numaNode >= 0 && locationA.numaNode == locationB.numaNode))
+    {
+        return LinkType::kPCIE_HOST_BRIDGE;
+    }
+    return LinkType::kSYSTEM;
+}
+
+std::vector<std::vector<SizeType32>> DeviceTopology::getNvlinkIslands(std::vector<SizeType32> const& devices)
+{
+    auto sortedDevices = devices;
+    std::sort(sortedDevices.begin(), sortedDevices.end());
+    auto const numDevices = sortedDevices.size();
+
+    // Union find over the NVLink peers
+    std::vector<std::size_t> parents(numDevices);
+    std::iota(parents.begin(), parents.end(), 0);
+    auto const findRoot = [&parents](std::size_t idx)
+    {
+        while (parents[idx] != idx)
+        {
+            idx = parents[idx] = parents[parents[idx]];
+        }
+        return idx;
+    };
+    for (std::size_t i = 0; i < numDevices; ++i)
+    {
+        for (std::size_t j = i + 1; j < numDevices; ++j)
+        {
+            if (isNvlinkPeer(sortedDevices[i], sortedDevices[j]))
+            {
+                parents[findRoot(j)] = findRoot(i);
+            }
+        }
+    }
+
+    std::vector<std::vector<SizeType32>> islands;
+    std::map<std::size_t, std::size_t> rootToIsland;
+    for (std::size_t i = 0; i < numDevices; ++i)
+    {
+        auto const [it, inserted] = rootToIsland.emplace(findRoot(i), islands.size());
+        if (inserted)
+        {
+            islands.emplace_back();
+        }
+        islands[it->second].push_back(sortedDevices[i]);
+    }
+    return islands;
+}
+
+std::vector<SizeType32> DeviceTopology::placeGroups(
+    std::vector<std::vector<SizeType32>> const& islands, SizeType32 groupSize)
+{
+    TLLM_CHECK(groupSize > 0);
+    std::vector<SizeType32> placed;
+    std::vector<SizeType32> leftovers;
+    for (auto const& island : islands)
+    {
+        auto const numGrouped = static_cast<SizeType32>(island.size()) / groupSize * groupSize;
+        placed.insert(placed.end(), island.begin(), island.begin() + numGrouped);
+        leftovers.insert(leftovers.end(), island.begin() + numGrouped, island.end());
+    }
+    std::sort(leftovers.begin(), leftovers.end());
+    placed.insert(placed.end(), leftovers.begin(), leftovers.end());
+    return placed;
+}
+
+DeviceTopology::ScopedNumaPreference::ScopedNumaPreference(int device)
+{
+#if defined(__linux__)
+    auto const numaNode = getNumaNode(device);
+    if (numaNode < 0 || numaNode >= kMaxNumaNodes)
+    {
+        return;
+    }
+    if (syscall(SYS_get_mempolicy, &mPrevMode, mPrevNodes.data(), kMaxNumaNodes, nullptr, 0) != 0)
+    {
+        TLLM_LOG_DEBUG("Failed to read the NUMA memory policy, allocations are not NUMA local");
+        return;
+    }
+    int constexpr kMpolPreferred = 1;
+    std::array<unsigned long, kMaxNumaNodes / kBitsPerWord> nodes{};
+    nodes[numaNode / kBitsPerWord] = 1UL << (numaNode % kBitsPerWord);
+    // The kernel reads maxnode - 1 bits of the mask.
+    mActive = syscall(SYS_set_mempolicy, kMpolPreferred, nodes.data(), kMaxNumaNodes + 1) == 0;
+#endif
+}
+
+DeviceTopology::ScopedNumaPreference::ScopedNumaPreference()
+    : ScopedNumaPreference(
+        []()
+        {
+            int device{0};
+            TLLM_CUDA_CHECK(cudaGetDevice(&device));
+            return device;
+        }())
+{
+}
+
+DeviceTopology::ScopedNumaPreference::~ScopedNumaPreference()
+{
+#if defined(__linux__)
+    if (mActive)
+    {
+        syscall(SYS_set_mempolicy, mPrevMode, mPrevNodes.data(), kMaxNumaNodes + 1);
+    }
+#endif
+}
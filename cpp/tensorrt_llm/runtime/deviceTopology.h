@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/common.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Topology of the GPUs of this node: NVLink islands, PCIe switches and NUMA nodes. It is read from the CUDA
+//! runtime and from sysfs, so it is only known on Linux.
+class DeviceTopology
+{
+public:
+    //! Closest connection between two devices, from the fastest to the slowest.
+    enum class LinkType : std::int8_t
+    {
+        kNVLINK = 0,
+        //! Below the same PCIe switch.
+        kPCIE_SWITCH = 1,
+        //! Through the host bridge of one CPU socket.
+        kPCIE_HOST_BRIDGE = 2,
+        //! Across CPU sockets, or unknown.
+        kSYSTEM = 3,
+    };
+
+    //! \brief NUMA node the device is attached to, -1 if unknown.
+    [[nodiscard]] static int getNumaNode(int device);
+
+    [[nodiscard]] static LinkType getLinkType(int deviceA, int deviceB);
+
+    //! \brief Splits the devices in sets connected by NVLink, directly or through other devices of the set. Each island
+    //! is sorted and the islands are ordered by their first device.
+    [[nodiscard]] static std::vector<std::vector<SizeType32>> getNvlinkIslands(std::vector<SizeType32> const& devices);
+
+    //! \brief Orders the devices so that each run of groupSize consecutive devices is within one island when the
+    //! islands allow it. The whole groups of each island come first, in the order of the islands, followed by the
+    //! devices left over. A single sorted island keeps its order.
+    [[nodiscard]] static std::vector<SizeType32> placeGroups(
+        std::vector<std::vector<SizeType32>> const& islands, SizeType32 groupSize);
+
+    //! \brief Prefers the NUMA node of a device for the host memory allocated by the calling thread, until destroyed.
+    //! Pinned memory is placed when it is locked, so allocations made in the scope stay local to the device. Does
+    //! nothing when the NUMA node is unknown.
+    class ScopedNumaPreference
+    {
+    public:
+        explicit ScopedNumaPreference(int device);
+
+        //! \brief Prefers the NUMA node of the current CUDA device.
+        ScopedNumaPreference();
+
+        ~ScopedNumaPreference();
+
+        ScopedNumaPreference(ScopedNumaPreference const&) = delete;
+        ScopedNumaPreference& operator=(ScopedNumaPreference const&) = delete;
+
+    private:
+        static constexpr int kMaxNumaNodes = 1024;
+        static constexpr int kBitsPerWord = 8 * sizeof(unsigned long);
+
+        bool mActive{false};
+        int mPrevMode{0};
+        std::array<unsigned long, kMaxNumaNodes / kBitsPerWord> mPrevNodes{};
+    };
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Tracks which rows of a host table changed since it was last uploaded, so that only those are copied.
+//! \details Keeps a shadow copy of the uploaded table. All rows are dirty after the destination or the shape of the
+//! table changed, or after invalidate().
+class DirtyRowTracker
+{
+public:
+    //! \brief Run of consecutive dirty rows.
+    struct Segment
+    {
+        SizeType32 firstRow;
+        SizeType32 numRows;
+
+        bool operator==(Segment const& other) const
+        {
+            return firstRow == other.firstRow && numRows == other.numRows;
+        }
+    };
+
+    //! \brief Compare the table with the last uploaded contents and remember the new contents.
+    //! \param destination Identity of the uploaded copy, e.g. its address.
+    //! \return Runs of dirty rows, in row order.
+    std::vector<Segment> update(
+        void const* table, SizeType32 numRows, std::size_t rowSizeInBytes, void const* destination)
+    {
+        TLLM_CHECK(numRows >= 0);
+        auto const* rows = static_cast<std::uint8_t const*>(table);
+        auto const tableSize = static_cast<std::size_t>(numRows) * rowSizeInBytes;
+        std::vector<Segment> segments;
+        mNumDirtyRows = 0;
+        if (destination != mDestination || rowSizeInBytes != mRowSizeInBytes || tableSize != mShadow.size())
+        {
+            mDestination = destination;
+            mRowSizeInBytes = rowSizeInBytes;
+            mShadow.assign(rows, rows + tableSize);
+            if (numRows > 0)
+            {
+                segments.push_back(Segment{0, numRows});
+            }
+            mNumDirtyRows = numRows;
+            return segments;
+        }
+        for (SizeType32 row = 0; row < numRows; ++row)
+        {
+            auto const offset = static_cast<std::size_t>(row) * rowSizeInBytes;
+            if (std::memcmp(mShadow.data() + offset, rows + offset, rowSizeInBytes) == 0)
+            {
+                continue;
+            }
+            std::memcpy(mShadow.data() + offset, rows + offset, rowSizeInBytes);
+            if (!segments.empty() && segments.back().firstRow + segments.back().numRows == row)
+            {
+                ++segments.back().numRows;
+            }
+            else
+            {
+                segments.push_back(Segment{row, 1});
+            }
+            ++mNumDirtyRows;
+        }
+        return segments;
+    }
+
+    //! \brief Mark all rows dirty, e.g. after the destination was written by someone else.
+    void invalidate()
+    {
+        mDestination = nullptr;
+        mShadow.clear();
+    }
+
+    //! \brief Number of dirty rows found by the last update.
+    [[nodiscard]] SizeType32 getNumDirtyRows() const
+    {
+        return mNumDirtyRows;
+    }
+
+private:
+    void const* mDestination{nullptr};
+    std::size_t mRowSizeInBytes{0};
+    std::vector<std::uint8_t> mShadow;
+    SizeType32 mNumDirtyRows{0};
+};
+
+} // namespace tensorrt_llm::runtime
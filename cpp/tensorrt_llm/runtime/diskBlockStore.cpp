@@ -0,0 +1,305 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/diskBlockStore.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/workerPool.h"
+
+#include <cerrno>
+#include <cstring>
+#include <numeric>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tensorrt_llm::runtime
+{
+
+DiskBlockStore::DiskBlockStore(std::filesystem::path path, std::size_t blockSize, SizeType32 numBlocks,
+    SizeType32 numStagingBuffers, SizeType32 numWorkers)
+    : mPath{std::move(path)}
+    , mBlockSize{blockSize}
+    , mNumBlocks{numBlocks}
+    , mFd{-1}
+    , mPendingIo(numBlocks)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK(mBlockSize > 0);
+    TLLM_CHECK(mNumBlocks > 0);
+    TLLM_CHECK(numStagingBuffers > 0);
+#if defined(_WIN32)
+    TLLM_THROW("DiskBlockStore is not supported on Windows");
+#else
+    mFd = ::open(mPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    TLLM_CHECK_WITH_INFO(mFd >= 0, "Failed to open %s: %s", mPath.string().c_str(), std::strerror(errno));
+    auto const fileSize = static_cast<off_t>(mBlockSize) * mNumBlocks;
+    if (::ftruncate(mFd, fileSize) != 0)
+    {
+        ::close(mFd);
+        TLLM_THROW("Failed to reserve %ld bytes in %s: %s", static_cast<long>(fileSize), mPath.string().c_str(),
+            std::strerror(errno));
+    }
+#endif
+
+    // Slots are handed out from the back, start with slot 0.
+    mFreeSlots.resize(mNumBlocks);
+    std::iota(mFreeSlots.rbegin(), mFreeSlots.rend(), 0);
+
+    for (SizeType32 i = 0; i < numStagingBuffers; ++i)
+    {
+        mFreeStagingBuffers.emplace_back(BufferManager::pinned(mBlockSize));
+    }
+    mWorkerPool = std::make_unique<WorkerPool>(numWorkers, common::getDevice());
+    TLLM_LOG_INFO("Created disk block store %s with %d blocks of %lu bytes", mPath.string().c_str(), mNumBlocks,
+        mBlockSize);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+DiskBlockStore::~DiskBlockStore()
+{
+    try
+    {
+        sync();
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_EXCEPTION(e);
+    }
+    mWorkerPool.reset();
+#if !defined(_WIN32)
+    if (mFd >= 0)
+    {
+        ::close(mFd);
+    }
+#endif
+    std::error_code ec;
+    std::filesystem::remove(mPath, ec);
+}
+
+std::optional<DiskBlockStore::SlotIdType> DiskBlockStore::storeAsync(IBuffer const& src)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(src.getSizeInBytes() == mBlockSize, "Block size mismatch: %lu != %lu", src.getSizeInBytes(),
+        mBlockSize);
+    SlotIdType slot;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mFreeSlots.empty())
+        {
+            return std::nullopt;
+        }
+        slot = mFreeSlots.back();
+        mFreeSlots.pop_back();
+    }
+
+    auto staging = acquireStagingBuffer();
+    if (src.getMemoryType() == MemoryType::kGPU)
+    {
+        TLLM_CUDA_CHECK(cudaMemcpy(staging->data(), src.data(), mBlockSize, cudaMemcpyDeviceToHost));
+    }
+    else
+    {
+        std::memcpy(staging->data(), src.data(), mBlockSize);
+    }
+
+    auto write = mWorkerPool->enqueue(
+        [this, slot, staging]()
+        {
+            // Return the staging buffer even if the write fails.
+            try
+            {
+                writeBlock(slot, *staging);
+            }
+            catch (...)
+            {
+                releaseStagingBuffer(staging);
+                throw;
+            }
+            releaseStagingBuffer(staging);
+        });
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPendingIo[slot] = write.share();
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return slot;
+}
+
+std::shared_future<void> DiskBlockStore::loadAsync(SlotIdType slot, IBuffer& dst)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK(0 <= slot && slot < mNumBlocks);
+    TLLM_CHECK_WITH_INFO(dst.getSizeInBytes() == mBlockSize, "Block size mismatch: %lu != %lu", dst.getSizeInBytes(),
+        mBlockSize);
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        pending = mPendingIo[slot];
+    }
+    // Stage device reads with a buffer acquired here, a worker must never wait for a staging buffer.
+    auto staging = dst.getMemoryType() == MemoryType::kGPU ? acquireStagingBuffer() : nullptr;
+    auto* const dstData = dst.data();
+    auto read = mWorkerPool->enqueue(
+        [this, slot, dstData, pending, staging]()
+        {
+            try
+            {
+                if (pending.valid())
+                {
+                    pending.get();
+                }
+                if (staging)
+                {
+                    readBlock(slot, staging->data());
+                    TLLM_CUDA_CHECK(cudaMemcpy(dstData, staging->data(), mBlockSize, cudaMemcpyHostToDevice));
+                }
+                else
+                {
+                    readBlock(slot, dstData);
+                }
+            }
+            catch (...)
+            {
+                if (staging)
+                {
+                    releaseStagingBuffer(staging);
+                }
+                throw;
+            }
+            if (staging)
+            {
+                releaseStagingBuffer(staging);
+            }
+        });
+    auto shared = read.share();
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mPendingIo[slot] = shared;
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return shared;
+}
+
+void DiskBlockStore::release(SlotIdType slot)
+{
+    TLLM_CHECK(0 <= slot && slot < mNumBlocks);
+    std::shared_future<void> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        pending = std::exchange(mPendingIo[slot], {});
+    }
+    if (pending.valid())
+    {
+        pending.wait();
+    }
+    std::lock_guard<std::mutex> lock(mMutex);
+    mFreeSlots.push_back(slot);
+}
+
+void DiskBlockStore::sync()
+{
+    std::vector<std::shared_future<void>> pending;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto const& io : mPendingIo)
+        {
+            if (io.valid())
+            {
+                pending.push_back(io);
+            }
+        }
+    }
+    for (auto const& io : pending)
+    {
+        io.get();
+    }
+}
+
+SizeType32 DiskBlockStore::getNumFreeBlocks() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<SizeType32>(mFreeSlots.size());
+}
+
+IBuffer::SharedPtr DiskBlockStore::acquireStagingBuffer()
+{
+    std::unique_lock<std::mutex> lock(mStagingMutex);
+    mStagingCv.wait(lock, [this]() { return !mFreeStagingBuffers.empty(); });
+    auto buffer = std::move(mFreeStagingBuffers.back());
+    mFreeStagingBuffers.pop_back();
+    return buffer;
+}
+
+void DiskBlockStore::releaseStagingBuffer(IBuffer::SharedPtr buffer)
+{
+    {
+        std::lock_guard<std::mutex> lock(mStagingMutex);
+        mFreeStagingBuffers.push_back(std::move(buffer));
+    }
+    mStagingCv.notify_one();
+}
+
+void DiskBlockStore::writeBlock(SlotIdType slot, IBuffer const& src) const
+{
+#if !defined(_WIN32)
+    auto const* data = static_cast<char const*>(src.data());
+    auto offset = static_cast<off_t>(slot) * mBlockSize;
+    std::size_t remaining = mBlockSize;
+    while (remaining > 0)
+    {
+        auto const written = ::pwrite(mFd, data, remaining, offset);
+        if (written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        TLLM_CHECK_WITH_INFO(written > 0, "Failed to write block %d to %s: %s", slot, mPath.string().c_str(),
+            std::strerror(errno));
+        data += written;
+        offset += written;
+        remaining -= written;
+    }
+#endif
+}
+
+void DiskBlockStore::readBlock(SlotIdType slot, void* dst) const
+{
+#if !defined(_WIN32)
+    auto* data = static_cast<char*>(dst);
+    auto offset = static_cast<off_t>(slot) * mBlockSize;
+    std::size_t remaining = mBlockSize;
+    while (remaining > 0)
+    {
+        auto const read = ::pread(mFd, data, remaining, offset);
+        if (read < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        TLLM_CHECK_WITH_INFO(read > 0, "Failed to read block %d from %s: %s", slot, mPath.string().c_str(),
+            std::strerror(errno));
+        data += read;
+        offset += read;
+        remaining -= read;
+    }
+#endif
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/workerPool.h"
+
+#include <array>
+#include <functional>
+#include <future>
+#include <optional>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Prepares the inputs of the next iteration on a worker thread while the current iteration executes.
+//! \details Inputs are prepared into one of two staging slots, e.g. pinned host buffers for position ids, sequence
+//! lengths and KV cache block offsets plus the event of their copy on a side stream. While the caller uses the current
+//! slot, the worker fills the other one. At most one preparation is in flight and it never touches the current slot.
+//! Before refilling a slot, the preparation must wait for the device to finish reading it, e.g. by synchronizing the
+//! event recorded after the previous copy of the slot.
+//! \tparam StagingT Staging buffers of one iteration.
+template <typename StagingT>
+class DoubleBufferedPrep
+{
+public:
+    using PrepareFn = std::function<void(StagingT& staging)>;
+
+    //! \param device Device the worker thread uses, e.g. common::getDevice(), -1 to leave it unset.
+    DoubleBufferedPrep(StagingT first, StagingT second, int device = -1)
+        : mSlots{std::move(first), std::move(second)}
+        , mWorker{1, device}
+    {
+    }
+
+    ~DoubleBufferedPrep()
+    {
+        // The worker pool drops queued tasks on shutdown, wait for the preparation that is in flight.
+        if (mPending.valid())
+        {
+            mPending.wait();
+        }
+    }
+
+    DoubleBufferedPrep(DoubleBufferedPrep const&) = delete;
+    DoubleBufferedPrep& operator=(DoubleBufferedPrep const&) = delete;
+
+    //! \brief Start preparing the next iteration into the slot that is not current.
+    void prepareAsync(PrepareFn prepare)
+    {
+        TLLM_CHECK_WITH_INFO(!mPending.valid(), "The inputs of the next iteration are already being prepared.");
+        auto& slot = mSlots[nextSlotIndex()];
+        mPending = mWorker.enqueue([prepare = std::move(prepare), &slot]() { prepare(slot); });
+    }
+
+    //! \brief Wait until the next iteration is prepared and make its slot current. Rethrows errors of the preparation.
+    StagingT& acquire()
+    {
+        TLLM_CHECK_WITH_INFO(mPending.valid(), "No inputs are being prepared.");
+        auto pending = std::move(mPending);
+        pending.get();
+        mCurrent = nextSlotIndex();
+        return mSlots[mCurrent.value()];
+    }
+
+    //! \brief Prepare the next iteration on the calling thread, e.g. for the first iteration.
+    StagingT& prepareSync(PrepareFn const& prepare)
+    {
+        TLLM_CHECK_WITH_INFO(!mPending.valid(), "The inputs of the next iteration are already being prepared.");
+        auto const slotIndex = nextSlotIndex();
+        prepare(mSlots[slotIndex]);
+        mCurrent = slotIndex;
+        return mSlots[slotIndex];
+    }
+
+    //! \brief Slot of the current iteration, nullptr before the first acquire.
+    [[nodiscard]] StagingT* getCurrent()
+    {
+        return mCurrent ? &mSlots[mCurrent.value()] : nullptr;
+    }
+
+    [[nodiscard]] bool isPreparing() const
+    {
+        return mPending.valid();
+    }
+
+private:
+    [[nodiscard]] std::size_t nextSlotIndex() const
+    {
+        return mCurrent.value_or(1) ^ 1U;
+    }
+
+    std::array<StagingT, 2> mSlots;
+    std::optional<std::size_t> mCurrent;
+    std::future<void> mPending;
+    WorkerPool mWorker;
+};
+
+} // namespace tensorrt_llm::runtime
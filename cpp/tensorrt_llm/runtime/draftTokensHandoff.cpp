@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/draftTokensHandoff.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+using namespace tensorrt_llm::runtime;
+
+DraftTokensHandoff::DraftTokensHandoff(SizeType32 maxBatchSize, SizeType32 maxDraftTokens, SizeType32 vocabSizePadded,
+    nvinfer1::DataType logitsType, BufferManager const& manager)
+    : mMaxDraftTokens{maxDraftTokens}
+    , mVocabSizePadded{vocabSizePadded}
+    , mSequenceLengths(maxBatchSize, 0)
+    , mNumDraftTokens(maxBatchSize, 0)
+{
+    TLLM_CHECK(maxBatchSize > 0 && mMaxDraftTokens > 0 && mVocabSizePadded > 0);
+    mDraftLogits = manager.gpu(ITensor::makeShape({maxBatchSize, mMaxDraftTokens, mVocabSizePadded}), logitsType);
+}
+
+void DraftTokensHandoff::beginRound(SizeType32 batchSlot, SizeType32 sequenceLength)
+{
+    TLLM_CHECK(sequenceLength > 0);
+    mSequenceLengths.at(batchSlot) = sequenceLength;
+    mNumDraftTokens.at(batchSlot) = 0;
+}
+
+void DraftTokensHandoff::addDraftLogits(SizeType32 batchSlot, ITensor const& logits, BufferManager const& manager)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto& numDraftTokens = mNumDraftTokens.at(batchSlot);
+    TLLM_CHECK_WITH_INFO(numDraftTokens < mMaxDraftTokens, "Draft round of slot %d exceeds %d draft tokens", batchSlot,
+        mMaxDraftTokens);
+    TLLM_CHECK(logits.getDataType() == mDraftLogits->getDataType());
+    TLLM_CHECK_WITH_INFO(static_cast<SizeType32>(logits.getSize()) == mVocabSizePadded,
+        "Draft logits must hold one step of one beam");
+
+    ITensor::SharedPtr slotLogits = ITensor::slice(mDraftLogits, batchSlot, 1);
+    slotLogits->squeeze(0);
+    manager.copy(logits, *ITensor::slice(slotLogits, numDraftTokens, 1));
+    ++numDraftTokens;
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+void DraftTokensHandoff::fillTargetRequest(decoder_batch::Request& request, SizeType32 batchSlot,
+    ITensor::SharedPtr const& draftOutputIds, bool withLogits) const
+{
+    auto const numDraftTokens = mNumDraftTokens.at(batchSlot);
+    auto const sequenceLength = mSequenceLengths.at(batchSlot);
+    TLLM_CHECK(numDraftTokens > 0);
+    TLLM_CHECK(draftOutputIds->getDataType() == TRTDataType<TokenIdType>::value);
+    auto const& shape = draftOutputIds->getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 2, "Draft output ids must be [maxBeamWidth, maxSequenceLength]");
+    TLLM_CHECK(sequenceLength + numDraftTokens <= shape.d[1]);
+
+    // The draft tokens follow the draft sequence in the first beam
+    request.draftTokens = IBuffer::slice(draftOutputIds, sequenceLength, numDraftTokens);
+    request.generatedTokensPerEngineStep = numDraftTokens + 1;
+    if (withLogits)
+    {
+        ITensor::SharedPtr slotLogits = ITensor::slice(mDraftLogits, batchSlot, 1);
+        slotLogits->squeeze(0);
+        request.draftLogits = ITensor::slice(slotLogits, 0, numDraftTokens);
+    }
+    else
+    {
+        request.draftLogits = std::nullopt;
+    }
+}
+
+SizeType32 DraftTokensHandoff::getNumRewindTokens(SizeType32 batchSlot, SizeType32 numAcceptedTokens) const
+{
+    auto const numDraftTokens = mNumDraftTokens.at(batchSlot);
+    TLLM_CHECK(0 <= numAcceptedTokens && numAcceptedTokens <= numDraftTokens);
+    return numDraftTokens - numAcceptedTokens;
+}
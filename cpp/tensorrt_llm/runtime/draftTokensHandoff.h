@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/request.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Hands the draft tokens and logits of an in-process draft model over to the target decoder on the device.
+//! \details A draft round generates up to maxDraftTokens tokens for a request with a draft decoder, one token per draft
+//! step. The logits of the draft steps are collected in a device buffer. The draft tokens are read in place from the
+//! output ids of the draft decoder, so the target request gets device views of both and no host round trip is needed.
+//! The copies of the target decoder must be ordered after the draft steps, e.g. by running both on one stream.
+//! After the target step the draft sequence is rewound by the draft tokens that were not accepted.
+class DraftTokensHandoff
+{
+public:
+    DraftTokensHandoff(SizeType32 maxBatchSize, SizeType32 maxDraftTokens, SizeType32 vocabSizePadded,
+        nvinfer1::DataType logitsType, BufferManager const& manager);
+
+    //! \brief Start a draft round for the request in `batchSlot`, whose draft sequence has `sequenceLength` tokens.
+    void beginRound(SizeType32 batchSlot, SizeType32 sequenceLength);
+
+    //! \brief Record the logits [1, vocabSizePadded] or [1, 1, vocabSizePadded] of the next draft step, on gpu.
+    void addDraftLogits(SizeType32 batchSlot, ITensor const& logits, BufferManager const& manager);
+
+    //! \brief Number of draft tokens generated in the round of `batchSlot`.
+    [[nodiscard]] SizeType32 getNumDraftTokens(SizeType32 batchSlot) const
+    {
+        return mNumDraftTokens.at(batchSlot);
+    }
+
+    //! \brief Set the draft tokens, logits and tokens per engine step of the target request.
+    //! \param draftOutputIds [maxBeamWidth, maxSequenceLength], output ids of the request in the draft decoder, e.g.
+    //! GptDecoderBatch::getOutputIds(batchSlot), on gpu.
+    //! \param withLogits Accept by logits instead of by ids.
+    void fillTargetRequest(decoder_batch::Request& request, SizeType32 batchSlot,
+        ITensor::SharedPtr const& draftOutputIds, bool withLogits) const;
+
+    //! \brief Draft tokens to drop from the draft sequence and its KV cache after `numAcceptedTokens` were accepted.
+    [[nodiscard]] SizeType32 getNumRewindTokens(SizeType32 batchSlot, SizeType32 numAcceptedTokens) const;
+
+private:
+    SizeType32 mMaxDraftTokens;
+    SizeType32 mVocabSizePadded;
+    //! [maxBatchSize, maxDraftTokens, vocabSizePadded], logits of the draft steps, on gpu
+    ITensor::SharedPtr mDraftLogits;
+    std::vector<SizeType32> mSequenceLengths;
+    std::vector<SizeType32> mNumDraftTokens;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/encoderSession.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+#include "tensorrt_llm/runtime/tllmRuntime.h"
+
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Graph of one execution of a context, captured once since the context is bound to fixed buffers.
+class EncoderSession::CudaGraph
+{
+public:
+    CudaGraph(TllmRuntime const& runtime, SizeType32 contextIndex)
+    {
+        auto const& stream = runtime.getStream();
+        cudaGraph_t graph;
+        TLLM_CUDA_CHECK(cudaStreamBeginCapture(stream.get(), cudaStreamCaptureModeThreadLocal));
+        runtime.executeContext(contextIndex);
+        TLLM_CUDA_CHECK(cudaStreamEndCapture(stream.get(), &graph));
+        TLLM_CUDA_CHECK(cudaGraphInstantiate(&mInstance, graph, nullptr, nullptr, 0));
+        TLLM_CUDA_CHECK(cudaGraphDestroy(graph));
+        TLLM_CUDA_CHECK(cudaGraphUpload(mInstance, stream.get()));
+    }
+
+    ~CudaGraph()
+    {
+        try
+        {
+            TLLM_CUDA_CHECK(cudaGraphExecDestroy(mInstance));
+        }
+        catch (std::exception& e)
+        {
+            TLLM_LOG_EXCEPTION(e);
+        }
+    }
+
+    CudaGraph(CudaGraph const&) = delete;
+    CudaGraph& operator=(CudaGraph const&) = delete;
+
+    void launch(CudaStream const& stream) const
+    {
+        TLLM_CUDA_CHECK(cudaGraphLaunch(mInstance, stream.get()));
+    }
+
+private:
+    cudaGraphExec_t mInstance{nullptr};
+};
+
+std::vector<EncoderSession::Bucket> EncoderSession::makeBuckets(Config const& config)
+{
+    TLLM_CHECK(config.maxBatchSize > 0);
+    TLLM_CHECK(0 < config.minNumTokens && config.minNumTokens <= config.maxNumTokens);
+    auto const powersOfTwo = [](SizeType32 minValue, SizeType32 maxValue)
+    {
+        std::vector<SizeType32> values;
+        for (auto value = static_cast<std::int64_t>(minValue); value < maxValue; value *= 2)
+        {
+            values.push_back(static_cast<SizeType32>(value));
+        }
+        values.push_back(maxValue);
+        return values;
+    };
+
+    std::vector<Bucket> buckets;
+    for (auto const numTokens : powersOfTwo(config.minNumTokens, config.maxNumTokens))
+    {
+        for (auto const batchSize : powersOfTwo(1, config.maxBatchSize))
+        {
+            // Every sequence has at least one token.
+            if (batchSize <= numTokens)
+            {
+                buckets.push_back(Bucket{batchSize, numTokens});
+            }
+        }
+    }
+    return buckets;
+}
+
+std::optional<std::size_t> EncoderSession::selectBucket(
+    std::vector<Bucket> const& buckets, SizeType32 batchSize, SizeType32 numTokens)
+{
+    auto const it = std::find_if(buckets.begin(), buckets.end(),
+        [&](Bucket const& bucket)
+        {
+            // The padding sequences take one token each.
+            return batchSize <= bucket.batchSize && numTokens + (bucket.batchSize - batchSize) <= bucket.numTokens;
+        });
+    if (batchSize <= 0 || it == buckets.end())
+    {
+        return std::nullopt;
+    }
+    return static_cast<std::size_t>(std::distance(buckets.begin(), it));
+}
+
+EncoderSession::EncoderSession(Config const& config, RawEngine const& rawEngine, nvinfer1::ILogger& logger)
+    : mConfig{config}
+    , mBuckets{makeBuckets(config)}
+    , mRuntime{std::make_shared<TllmRuntime>(rawEngine, &logger)}
+{
+    auto const& engine = mRuntime->getEngine();
+    auto const& manager = mRuntime->getBufferManager();
+    auto const maxNumTokens = mConfig.maxNumTokens;
+    auto const maxBatchSize = mConfig.maxBatchSize;
+    auto constexpr intType = TRTDataType<SizeType32>::value;
+
+    auto const outputShape = engine.getTensorShape(mConfig.outputName.c_str());
+    TLLM_CHECK_WITH_INFO(outputShape.nbDims == 2,
+        "Expected output '%s' of shape [num_tokens, hidden_size], build the engine with removed input padding",
+        mConfig.outputName.c_str());
+    auto const hiddenSize = outputShape.d[1];
+    mOutput = manager.gpu(
+        ITensor::makeShape({maxNumTokens, hiddenSize}), engine.getTensorDataType(mConfig.outputName.c_str()));
+
+    mInputIds = manager.gpu(ITensor::makeShape({maxNumTokens}), intType);
+    mPositionIds = manager.gpu(ITensor::makeShape({maxNumTokens}), intType);
+    mTokenTypeIds = manager.gpu(ITensor::makeShape({maxNumTokens}), intType);
+    manager.setZero(*mTokenTypeIds);
+    mInputLengths = manager.gpu(ITensor::makeShape({maxBatchSize}), intType);
+    mInputOffsets = manager.gpu(ITensor::makeShape({maxBatchSize + 1}), intType);
+    mInputIdsHost = BufferManager::pinned(ITensor::makeShape({maxNumTokens}), intType);
+    mPositionIdsHost = BufferManager::pinned(ITensor::makeShape({maxNumTokens}), intType);
+    mInputLengthsHost = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), intType);
+    mInputOffsetsHost = BufferManager::pinned(ITensor::makeShape({maxBatchSize + 1}), intType);
+
+    for (auto const& bucket : mBuckets)
+    {
+        auto const contextIndex = mRuntime->getNbContexts();
+        mRuntime->addContext(0);
+        TllmRuntime::TensorMap inputs;
+        inputs.insert_or_assign("input_ids", ITensor::slice(mInputIds, 0, bucket.numTokens));
+        inputs.insert_or_assign("position_ids", ITensor::slice(mPositionIds, 0, bucket.numTokens));
+        inputs.insert_or_assign("token_type_ids", ITensor::slice(mTokenTypeIds, 0, bucket.numTokens));
+        inputs.insert_or_assign("input_lengths", ITensor::slice(mInputLengths, 0, bucket.batchSize));
+        // Only the shape of max_input_length is used, a sequence is never longer than the bucket.
+        inputs.insert_or_assign("max_input_length", ITensor::slice(mInputIds, 0, bucket.numTokens));
+        // Bind only the inputs the engine declares.
+        TllmRuntime::TensorMap engineInputs;
+        for (std::int32_t i = 0; i < engine.getNbIOTensors(); ++i)
+        {
+            auto const* name = engine.getIOTensorName(i);
+            auto const it = inputs.find(name);
+            if (engine.getTensorIOMode(name) == nvinfer1::TensorIOMode::kINPUT && it != inputs.end())
+            {
+                engineInputs.insert_or_assign(name, it->second);
+            }
+        }
+        mRuntime->setInputTensors(contextIndex, engineInputs);
+        TllmRuntime::TensorMap outputs;
+        outputs.insert_or_assign(mConfig.outputName, ITensor::slice(mOutput, 0, bucket.numTokens));
+        mRuntime->setOutputTensors(contextIndex, outputs);
+    }
+    TLLM_LOG_INFO("Encoder session with %zu buckets of up to %d sequences and %d tokens", mBuckets.size(),
+        maxBatchSize, maxNumTokens);
+
+    if (mConfig.cudaGraphMode)
+    {
+        captureGraphs();
+    }
+}
+
+EncoderSession::~EncoderSession() = default;
+
+BufferManager const& EncoderSession::getBufferManager() const
+{
+    return mRuntime->getBufferManager();
+}
+
+void EncoderSession::captureGraphs()
+{
+    auto& manager = mRuntime->getBufferManager();
+    // Inputs of one token per sequence are valid for every bucket.
+    manager.setZero(*mInputIds);
+    manager.setZero(*mPositionIds);
+    kernels::invokeFill(*mInputLengths, SizeType32{1}, mRuntime->getStream());
+
+    mGraphs.reserve(mBuckets.size());
+    for (std::size_t bi = 0; bi < mBuckets.size(); ++bi)
+    {
+        auto const contextIndex = static_cast<SizeType32>(bi);
+        // Plugins allocate lazily on their first run, which must not happen during capture.
+        TLLM_CHECK_WITH_INFO(mRuntime->executeContext(contextIndex), "Executing the encoder engine failed");
+        mRuntime->getStream().synchronize();
+        mGraphs.push_back(std::make_unique<CudaGraph>(*mRuntime, contextIndex));
+    }
+    mRuntime->getStream().synchronize();
+}
+
+EncoderSession::TensorPtr EncoderSession::encode(std::vector<VecTokens> const& inputs)
+{
+    auto const batchSize = static_cast<SizeType32>(inputs.size());
+    auto numTokens = SizeType32{0};
+    for (auto const& input : inputs)
+    {
+        TLLM_CHECK_WITH_INFO(!input.empty(), "Encoder inputs must not be empty");
+        numTokens += static_cast<SizeType32>(input.size());
+    }
+    auto const bucketIndex = selectBucket(mBuckets, batchSize, numTokens);
+    TLLM_CHECK_WITH_INFO(bucketIndex.has_value(),
+        "A batch of %d sequences with %d tokens exceeds the largest bucket of %d sequences and %d tokens, split it",
+        batchSize, numTokens, mConfig.maxBatchSize, mConfig.maxNumTokens);
+    auto const& bucket = mBuckets[*bucketIndex];
+
+    // The staging buffers are still read by the copies of the previous batch until the event.
+    mInputsCopied.synchronize();
+    auto* inputIds = bufferCast<TokenIdType>(*mInputIdsHost);
+    auto* positionIds = bufferCast<SizeType32>(*mPositionIdsHost);
+    auto* inputLengths = bufferCast<SizeType32>(*mInputLengthsHost);
+    auto* inputOffsets = bufferCast<SizeType32>(*mInputOffsetsHost);
+    SizeType32 offset{0};
+    inputOffsets[0] = 0;
+    for (SizeType32 bi = 0; bi < bucket.batchSize; ++bi)
+    {
+        auto const length = bi < batchSize ? static_cast<SizeType32>(inputs[bi].size()) : 1;
+        if (bi < batchSize)
+        {
+            std::copy(inputs[bi].begin(), inputs[bi].end(), inputIds + offset);
+        }
+        else
+        {
+            inputIds[offset] = 0;
+        }
+        std::iota(positionIds + offset, positionIds + offset + length, 0);
+        inputLengths[bi] = length;
+        offset += length;
+        inputOffsets[bi + 1] = offset;
+    }
+    std::fill(inputIds + offset, inputIds + bucket.numTokens, 0);
+    std::fill(positionIds + offset, positionIds + bucket.numTokens, 0);
+
+    auto const& manager = mRuntime->getBufferManager();
+    auto const& stream = mRuntime->getStream();
+    manager.copy(*ITensor::slice(mInputIdsHost, 0, bucket.numTokens), *ITensor::slice(mInputIds, 0, bucket.numTokens));
+    manager.copy(
+        *ITensor::slice(mPositionIdsHost, 0, bucket.numTokens), *ITensor::slice(mPositionIds, 0, bucket.numTokens));
+    manager.copy(
+        *ITensor::slice(mInputLengthsHost, 0, bucket.batchSize), *ITensor::slice(mInputLengths, 0, bucket.batchSize));
+    manager.copy(
+        *ITensor::slice(mInputOffsetsHost, 0, batchSize + 1), *ITensor::slice(mInputOffsets, 0, batchSize + 1));
+    stream.record(mInputsCopied);
+
+    auto const contextIndex = static_cast<SizeType32>(*bucketIndex);
+    if (mConfig.cudaGraphMode)
+    {
+        mGraphs[*bucketIndex]->launch(stream);
+    }
+    else
+    {
+        TLLM_CHECK_WITH_INFO(mRuntime->executeContext(contextIndex), "Executing the encoder engine failed");
+    }
+    sync_check_cuda_error();
+
+    auto tokenRows = ITensor::slice(mOutput, 0, numTokens);
+    if (mConfig.poolingMode == PoolingMode::kNONE)
+    {
+        return tokenRows;
+    }
+    auto pooled = manager.gpu(ITensor::makeShape({batchSize, mOutput->getShape().d[1]}), mOutput->getDataType());
+    kernels::poolPackedHiddenStates(*pooled, *tokenRows, *ITensor::slice(mInputOffsets, 0, batchSize + 1),
+        mConfig.poolingMode == PoolingMode::kMEAN, stream);
+    return pooled;
+}
+
+} // namespace tensorrt_llm::runtime
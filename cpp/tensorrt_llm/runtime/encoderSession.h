@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/rawEngine.h"
+
+#include <NvInferRuntime.h>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+class TllmRuntime;
+
+//! \brief Runs encoder-only engines built with removed input padding, e.g. BERT, for embedding and classification.
+//! \details A batch is packed without padding and rounded up to a bucket of batch size and number of tokens. Every
+//! bucket has its own execution context, bound once to shared buffers of the largest bucket, and, in CUDA graph mode,
+//! a graph captured at construction, so encoding a batch is a host-to-device copy, a graph launch and the pooling.
+//! The batch is padded with sequences of one token. The tokens left in the bucket belong to no sequence, they only go
+//! through the per-token layers. The engine needs a profile that covers the largest bucket.
+class EncoderSession
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using VecTokens = std::vector<TokenIdType>;
+
+    enum class PoolingMode : std::int8_t
+    {
+        //! Return the rows of all tokens
+        kNONE = 0,
+        //! First token of each sequence
+        kCLS = 1,
+        kMEAN = 2,
+    };
+
+    struct Config
+    {
+        //! Batch size buckets are powers of two up to maxBatchSize
+        SizeType32 maxBatchSize{128};
+        //! Token buckets are powers of two from minNumTokens up to maxNumTokens
+        SizeType32 minNumTokens{256};
+        SizeType32 maxNumTokens{16384};
+        PoolingMode poolingMode{PoolingMode::kCLS};
+        bool cudaGraphMode{true};
+        //! Output of the engine with the hidden states or logits of every token
+        std::string outputName{"hidden_states"};
+    };
+
+    struct Bucket
+    {
+        SizeType32 batchSize;
+        SizeType32 numTokens;
+    };
+
+    EncoderSession(Config const& config, RawEngine const& rawEngine, nvinfer1::ILogger& logger);
+
+    ~EncoderSession();
+
+    //! \brief Encode a batch of sequences.
+    //! \return The pooled rows [batchSize, hiddenSize] on the GPU, or with PoolingMode::kNONE the rows of the packed
+    //! tokens [numTokens, hiddenSize], which are overwritten by the next call. The result is ready when the stream of
+    //! the buffer manager is.
+    [[nodiscard]] TensorPtr encode(std::vector<VecTokens> const& inputs);
+
+    //! \brief Index of the first bucket that fits a batch, the buckets are ordered by number of tokens first.
+    [[nodiscard]] static std::optional<std::size_t> selectBucket(
+        std::vector<Bucket> const& buckets, SizeType32 batchSize, SizeType32 numTokens);
+
+    [[nodiscard]] static std::vector<Bucket> makeBuckets(Config const& config);
+
+    [[nodiscard]] std::vector<Bucket> const& getBuckets() const
+    {
+        return mBuckets;
+    }
+
+    [[nodiscard]] BufferManager const& getBufferManager() const;
+
+private:
+    class CudaGraph;
+
+    void captureGraphs();
+
+    Config const mConfig;
+    std::vector<Bucket> const mBuckets;
+    std::shared_ptr<TllmRuntime> mRuntime;
+    std::vector<std::unique_ptr<CudaGraph>> mGraphs;
+
+    // Shared by all buckets, sized for the largest bucket
+    TensorPtr mInputIds;
+    TensorPtr mPositionIds;
+    TensorPtr mTokenTypeIds;
+    TensorPtr mInputLengths;
+    TensorPtr mInputOffsets;
+    TensorPtr mOutput;
+
+    // Pinned staging of the inputs, reused once the copies of the previous batch are done
+    TensorPtr mInputIdsHost;
+    TensorPtr mPositionIdsHost;
+    TensorPtr mInputLengthsHost;
+    TensorPtr mInputOffsetsHost;
+    CudaEvent mInputsCopied;
+};
+
+} // namespace tensorrt_llm::runtime
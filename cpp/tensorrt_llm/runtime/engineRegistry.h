@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Hash identifying a serialized engine, 64-bit FNV-1a over 8-byte words and the size.
+inline std::uint64_t hashEngine(void const* data, std::size_t size)
+{
+    constexpr std::uint64_t kPrime = 0x100000001b3ULL;
+    std::uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+    auto const* bytes = static_cast<unsigned char const*>(data);
+    std::size_t offset = 0;
+    for (; offset + sizeof(std::uint64_t) <= size; offset += sizeof(std::uint64_t))
+    {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + offset, sizeof(word));
+        hash = (hash ^ word) * kPrime;
+    }
+    for (; offset < size; ++offset)
+    {
+        hash = (hash ^ bytes[offset]) * kPrime;
+    }
+    return hash;
+}
+
+//! \brief Process-wide cache of deserialized engines, so that runtimes of the same engine share its weights and only
+//! own their execution contexts and activation memory.
+//! \details Entries are weak, an engine is destroyed with the last runtime using it.
+template <typename EngineT>
+class BasicEngineRegistry
+{
+public:
+    using EnginePtr = std::shared_ptr<EngineT>;
+    using Factory = std::function<EnginePtr()>;
+
+    //! \brief The engine of `key`, deserialized with `factory` if no runtime holds it.
+    //! \details Deserialization happens under the lock, so concurrent calls for the same key deserialize once.
+    EnginePtr getOrCreate(std::uint64_t key, Factory const& factory)
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        auto& entry = mEngines[key];
+        if (auto engine = entry.lock())
+        {
+            return engine;
+        }
+        auto engine = factory();
+        TLLM_CHECK_WITH_INFO(engine != nullptr, "Failed to deserialize cuda engine.");
+        entry = engine;
+        return engine;
+    }
+
+    //! \brief Number of engines currently alive.
+    [[nodiscard]] std::size_t getNumEngines() const
+    {
+        std::lock_guard<std::mutex> lock{mMutex};
+        std::size_t numEngines{0};
+        for (auto const& [key, engine] : mEngines)
+        {
+            numEngines += engine.expired() ? 0 : 1;
+        }
+        return numEngines;
+    }
+
+private:
+    mutable std::mutex mMutex;
+    std::unordered_map<std::uint64_t, std::weak_ptr<EngineT>> mEngines;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/runtime/fusionBarrierReport.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/stringUtils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <nlohmann/json.hpp>
+#include <numeric>
+#include <sstream>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+using Json = nlohmann::json;
+
+std::string toLower(std::string value)
+{
+    std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return std::tolower(c); });
+    return value;
+}
+
+bool contains(std::string const& value, char const* part)
+{
+    return value.find(part) != std::string::npos;
+}
+
+//! \brief Size of an element of a tensor from its format description, e.g. "Row major linear FP16 format".
+double getElementSize(std::string const& format)
+{
+    auto const lower = toLower(format);
+    if (contains(lower, "fp4") || contains(lower, "int4"))
+    {
+        return 0.5;
+    }
+    if (contains(lower, "fp8") || contains(lower, "int8") || contains(lower, "bool") || contains(lower, "uint8"))
+    {
+        return 1.;
+    }
+    if (contains(lower, "fp16") || contains(lower, "half") || contains(lower, "bf16"))
+    {
+        return 2.;
+    }
+    if (contains(lower, "int64"))
+    {
+        return 8.;
+    }
+    return 4.;
+}
+
+double getBytesPerToken(Json const& tensors)
+{
+    if (!tensors.is_array())
+    {
+        return 0.;
+    }
+    double bytes = 0.;
+    for (auto const& tensor : tensors)
+    {
+        if (!tensor.is_object() || !tensor.contains("Dimensions"))
+        {
+            continue;
+        }
+        double elements = 1.;
+        for (auto const& dim : tensor.at("Dimensions"))
+        {
+            // The dynamic dimensions, the tokens, count as one
+            if (dim.is_number_integer() && dim.get<std::int64_t>() > 0)
+            {
+                elements *= static_cast<double>(dim.get<std::int64_t>());
+            }
+        }
+        bytes += elements * getElementSize(tensor.value("Format/Datatype", std::string{}));
+    }
+    return bytes;
+}
+
+bool isPlugin(std::string const& name, std::string const& layerType)
+{
+    return contains(toLower(layerType), "plugin") || (layerType.empty() && contains(toLower(name), "plugin"));
+}
+} // namespace
+
+FusionBarrierReport::FusionBarrierReport(std::string const& engineInformation)
+{
+    auto const info = Json::parse(engineInformation, nullptr, false);
+    TLLM_CHECK_WITH_INFO(!info.is_discarded() && info.contains("Layers"), "Invalid engine information");
+
+    for (auto const& layer : info.at("Layers"))
+    {
+        ++mNbLayers;
+        FusionBarrier barrier;
+        if (layer.is_string())
+        {
+            // Names only, without the detailed profiling verbosity
+            barrier.name = layer.get<std::string>();
+        }
+        else
+        {
+            mDetailed = true;
+            barrier.name = layer.value("Name", std::string{});
+            barrier.layerType = layer.value("LayerType", std::string{});
+            barrier.inputBytesPerToken = getBytesPerToken(layer.value("Inputs", Json::array()));
+            barrier.outputBytesPerToken = getBytesPerToken(layer.value("Outputs", Json::array()));
+        }
+        if (!isPlugin(barrier.name, barrier.layerType))
+        {
+            continue;
+        }
+        barrier.isNoOp = contains(toLower(barrier.name), "identity");
+        mBarriers.emplace_back(std::move(barrier));
+    }
+
+    std::stable_sort(mBarriers.begin(), mBarriers.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.getBytesPerToken() > rhs.getBytesPerToken(); });
+}
+
+double FusionBarrierReport::getTotalBytesPerToken() const
+{
+    return std::accumulate(mBarriers.begin(), mBarriers.end(), 0.,
+        [](double total, auto const& barrier) { return total + barrier.getBytesPerToken(); });
+}
+
+std::string FusionBarrierReport::report(std::size_t numListed) const
+{
+    auto const numNoOps = std::count_if(mBarriers.begin(), mBarriers.end(), [](auto const& b) { return b.isNoOp; });
+    std::ostringstream os;
+    os << common::fmtstr("=== Fusion barriers: %zu plugin layers of %d layers, %ld no-op ===\n", mBarriers.size(),
+        mNbLayers, static_cast<long>(numNoOps));
+    if (!mDetailed)
+    {
+        os << "Shapes unknown, build the engine with the detailed profiling verbosity for the traffic per token.\n";
+    }
+    else
+    {
+        os << common::fmtstr("Activation traffic at the plugin boundaries: %.1f KiB per token\n",
+            getTotalBytesPerToken() / 1024.);
+    }
+    os << common::fmtstr("%12s %12s %5s  %s\n", "in B/token", "out B/token", "no-op", "layer");
+    for (std::size_t i = 0; i < mBarriers.size(); ++i)
+    {
+        auto const& barrier = mBarriers[i];
+        if (i < numListed || barrier.isNoOp)
+        {
+            os << common::fmtstr("%12.0f %12.0f %5s  %s\n", barrier.inputBytesPerToken, barrier.outputBytesPerToken,
+                barrier.isNoOp ? "yes" : "", barrier.name.c_str());
+        }
+    }
+    return os.str();
+}
+
+} // namespace tensorrt_llm::runtime
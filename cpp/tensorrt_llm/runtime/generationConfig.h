@@ -19,6 +19,8 @@
 #include "tensorrt_llm/runtime/common.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 
+#include <vector>
+
 namespace tensorrt_llm::runtime
 {
 
@@ -47,6 +49,17 @@ public:
     SizeType32 sinkTokenLength{};
     SizeType32 maxSeqLength{};
     SizeType32 inputLengthSum{}; // Initialized only if inputPacked is set to true in fromInput.
+    // Attention window of each layer, repeated over the layers. Empty if all layers use maxAttentionWindow.
+    std::vector<SizeType32> maxAttentionWindowVec{};
+
+    //! \brief Attention window of an attention layer.
+    //! \param attentionLayerIdx Index of the layer among the attention layers of the model.
+    [[nodiscard]] SizeType32 getMaxAttentionWindow(SizeType32 attentionLayerIdx) const
+    {
+        return maxAttentionWindowVec.empty()
+            ? maxAttentionWindow
+            : maxAttentionWindowVec[attentionLayerIdx % static_cast<SizeType32>(maxAttentionWindowVec.size())];
+    }
 
     static GenerationConfig fromInput(ITensor const& inputIds, ITensor& inputLengths, bool inputPacked,
         SizeType32 beamWidth, SizeType32 maxAttentionWindow, SizeType32 sinkTokenLength, SizeType32 maxSequenceLength);
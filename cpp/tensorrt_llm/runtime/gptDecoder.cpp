@@ -642,6 +642,15 @@ template class GptDecoder<half>;
 void IGptDecoder::acceptDraftTokensByIds(ITensor const& targetTokenIds, ITensor const& draftTokenIds,
     ITensor const& contextLengths, ITensor const& numDraftTokens, ITensor& sequenceLengths, ITensor const& finishedVec,
     ITensor& finishedFinal, ITensor& finishedSum, ITensor const& batchSlots, BufferManager::CudaStreamPtr const& stream)
+{
+    acceptDraftTokensByIds(targetTokenIds, draftTokenIds, contextLengths, numDraftTokens, sequenceLengths,
+        finishedVec, finishedFinal, finishedSum, nullptr, batchSlots, stream);
+}
+
+void IGptDecoder::acceptDraftTokensByIds(ITensor const& targetTokenIds, ITensor const& draftTokenIds,
+    ITensor const& contextLengths, ITensor const& numDraftTokens, ITensor& sequenceLengths, ITensor const& finishedVec,
+    ITensor& finishedFinal, ITensor& finishedSum, ITensor* finishedSlots, ITensor const& batchSlots,
+    BufferManager::CudaStreamPtr const& stream)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
@@ -684,8 +693,9 @@ void IGptDecoder::acceptDraftTokensByIds(ITensor const& targetTokenIds, ITensor
             bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(finishedVec)),
         reinterpret_cast<tensorrt_llm::kernels::FinishedState*>(
             bufferCast<tensorrt_llm::kernels::FinishedState::UnderlyingType>(finishedFinal)),
-        bufferCast<int>(finishedSum), bufferCast<SizeType32>(batchSlots), batchSize, maxBatchSize, beamWidth,
-        maxSeqLength, maxDraftTokens, stream->get());
+        bufferCast<int>(finishedSum), finishedSlots ? bufferCast<SizeType32>(*finishedSlots) : nullptr,
+        bufferCast<SizeType32>(batchSlots), batchSize, maxBatchSize, beamWidth, maxSeqLength, maxDraftTokens,
+        stream->get());
 
     sync_check_cuda_error();
 
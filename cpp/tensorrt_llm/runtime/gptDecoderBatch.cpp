@@ -19,6 +19,8 @@
 #include "tensorrt_llm/kernels/decodingCommon.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+#include "tensorrt_llm/runtime/rangeProfiler.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
 
 #include <algorithm>
@@ -84,6 +86,7 @@ GptDecoderBatch::GptDecoderBatch(std::size_t vocabSize, std::size_t vocabSizePad
     , mSpeculativeDecodingMode{speculativeDecodingMode}
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    MemoryTimeline::ScopedTag const memoryTag{MemoryTimeline::Tag::kDECODER};
     auto constexpr nvTokenIdType = TRTDataType<TokenIdType>::value;
     auto constexpr nvSizeType = TRTDataType<SizeType32>::value;
     auto constexpr nvFloatType = TRTDataType<float>::value;
@@ -198,10 +201,12 @@ void GptDecoderBatch::setup(executor::DecodingMode const& mode, SizeType32 maxBa
     SizeType32 maxTokensPerEngineStep, bool fusedDecoder, nvinfer1::DataType dtype, ModelConfig const& modelConfig)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    MemoryTimeline::ScopedTag const memoryTag{MemoryTimeline::Tag::kDECODER};
     TLLM_CHECK(maxBatchSize > 0);
     TLLM_CHECK(maxBeamWidth > 0);
     TLLM_CHECK(maxTokensPerEngineStep > 0);
     TLLM_CHECK(maxSequenceLength > 0);
+    TLLM_CHECK_WITH_INFO(fusedDecoder, "GptDecoderBatch only supports the fused decoder");
     mActualBatchSize = maxBatchSize;
     mMaxSequenceLength = maxSequenceLength;
     mMaxAttentionWindow = maxAttentionWindow;
@@ -242,13 +247,10 @@ void GptDecoderBatch::setup(executor::DecodingMode const& mode, SizeType32 maxBa
     mFinishedSteps->reshape(maxTokensPerStepXmaxBatchSizeXmaxBeamWidth);
     mBufferManager.setZero(*mFinishedSteps);
 
-    if (mFusedDecoder)
-    {
-        mBatchSlotsSetup->reshape(ITensor::makeShape({maxBatchSize}));
-        mBatchSlotsDecoder->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
-        mBatchSlotsAcceptTokens->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
-        mBatchSlotsAcceptLogits->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
-    }
+    mBatchSlotsSetup->reshape(ITensor::makeShape({maxBatchSize}));
+    mBatchSlotsDecoder->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
+    mBatchSlotsAcceptTokens->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
+    mBatchSlotsAcceptLogits->reshape(ITensor::makeShape({maxTokensPerEngineStep, maxBatchSize}));
 
     if (mSpeculativeDecodingMode.isDraftTokensExternal())
     {
@@ -307,19 +309,13 @@ void GptDecoderBatch::setup(executor::DecodingMode const& mode, SizeType32 maxBa
         mMaxDecodingDecoderTokens = 1;
     }
 
-    auto const numOfDecoders = mFusedDecoder ? 1 : maxBatchSize;
-    auto const maxBatchSizePerDecoder = mFusedDecoder ? maxBatchSize : 1;
-    auto const device = mStream->getDevice();
-    mStreams.resize(numOfDecoders);
-    mDecoders.resize(numOfDecoders);
-    for (SizeType32 i = 0; i < numOfDecoders; ++i)
-    {
-        mStreams[i] = std::make_shared<CudaStream>();
-        TLLM_CHECK(mStreams[i]->getDevice() == device);
-
-        mDecoders[i] = IGptDecoder::create(mode, dtype, maxBatchSizePerDecoder, maxBeamWidth, mVocabSize,
-            mVocabSizePadded, mMaxSequenceLength, mStreams[i], speculativeDecodingModulePtr);
-    }
+    // A single decoder handles all slots
+    auto stream = std::make_shared<CudaStream>();
+    TLLM_CHECK(stream->getDevice() == mStream->getDevice());
+    mDecoders.clear();
+    mDecoders.emplace_back(IGptDecoder::create(mode, dtype, maxBatchSize, maxBeamWidth, mVocabSize, mVocabSizePadded,
+        mMaxSequenceLength, stream, speculativeDecodingModulePtr));
+    mStreams.assign(1, std::move(stream));
 
     mNbSteps.clear();
     mNbSteps.resize(maxBatchSize, 0);
@@ -339,6 +335,7 @@ void GptDecoderBatch::setup(executor::DecodingMode const& mode, SizeType32 maxBa
         mDecodingInputs[i].reset();
         mDecodingOutputs[i].reset();
     }
+
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -392,8 +389,8 @@ void GptDecoderBatch::setupSpeculativeDecoding(ModelConfig const& modelConfig)
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
-void GptDecoderBatch::newRequest(
-    SizeType32 batchSlot, decoder_batch::Request const& request, SamplingConfig const& samplingConfig)
+void GptDecoderBatch::newRequest(SizeType32 batchSlot, decoder_batch::Request const& request,
+    SamplingConfig const& samplingConfig, kernels::NewRequestSetup& setup)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
     TLLM_CHECK(batchSlot >= 0);
@@ -421,8 +418,7 @@ void GptDecoderBatch::newRequest(
 
     auto constexpr localBatchSize = 1;
 
-    auto const decoderIdx = mFusedDecoder ? 0 : batchSlot;
-    auto const& stream = mStreams.at(decoderIdx);
+    auto const& stream = mStreams.at(0);
     BufferManager manager{stream};
 
     // input
@@ -430,7 +426,6 @@ void GptDecoderBatch::newRequest(
     auto& dInput = mDecodingInputs.at(batchSlot);
 
     TensorPtr endIdTensorPtr{ITensor::slice(constPointerCast(dJointInput.endIds), batchSlot, localBatchSize)};
-    kernels::invokeFill(*endIdTensorPtr, endId, *stream);
     dInput = std::make_unique<DecodingInput>(
         inputLength, mMaxAttentionWindow, mSinkTokenLength, localBatchSize, dJointInput.logits, endIdTensorPtr);
 
@@ -447,15 +442,10 @@ void GptDecoderBatch::newRequest(
         manager.copy(*request.embeddingBias, *embeddingBiasSlice);
         dInput->embeddingBias = embeddingBiasSlice;
     }
-    else
-    {
-        manager.setZero(*embeddingBiasSlice);
-    }
 
-    auto setupWords = [fusedDecoder = mFusedDecoder](SharedConstPtr& inputWordsList, TensorPtr const& requestWordsList,
-                          SharedConstPtr& jointWordsPtrs, SharedConstPtr& jointWordsLens, SharedConstPtr& wordsPtrs,
-                          SharedConstPtr& wordsLens, SizeType32& inputMaxStopWordsLen, SizeType32& maxWordsLen,
-                          SizeType32 localBatchSize, SizeType32 batchSlot)
+    auto setupWords = [](SharedConstPtr& inputWordsList, TensorPtr const& requestWordsList,
+                          SharedConstPtr& jointWordsPtrs, SharedConstPtr& jointWordsLens, SizeType32& maxWordsLen,
+                          SizeType32 batchSlot)
     {
         if (requestWordsList)
         {
@@ -465,12 +455,6 @@ void GptDecoderBatch::newRequest(
             bufferCast<SizeType32>(*constPointerCast(jointWordsLens))[batchSlot] = wordsLen;
             // FIXME(nkorobov): this is monotonically growing size
             maxWordsLen = std::max(static_cast<SizeType32>(wordsLen), maxWordsLen);
-            if (!fusedDecoder)
-            {
-                wordsPtrs = ITensor::slice(jointWordsPtrs, batchSlot, localBatchSize);
-                wordsLens = ITensor::slice(jointWordsLens, batchSlot, localBatchSize);
-                inputMaxStopWordsLen = wordsLen;
-            }
             // NOTE(nkorobov): dInput-><name>WordsList is not used in gptDecoder, but required to keep <name>WordsList's
             // memory allocated
             inputWordsList = requestWordsList;
@@ -478,25 +462,21 @@ void GptDecoderBatch::newRequest(
         else
         {
             bufferCast<SizeType32>(*constPointerCast(jointWordsLens))[batchSlot] = 0;
-            inputMaxStopWordsLen = 0;
         }
     };
 
     setupWords(dInput->stopWordsList, request.stopWordsList, dJointInput.stopWordsPtrs, dJointInput.stopWordsLens,
-        dInput->stopWordsPtrs, dInput->stopWordsLens, dInput->maxStopWordsLen, mMaxStopWordsLen, localBatchSize,
-        batchSlot);
+        mMaxStopWordsLen, batchSlot);
     dJointInput.maxStopWordsLen = mMaxStopWordsLen;
 
     setupWords(dInput->badWordsList, request.badWordsList, dJointInput.badWordsPtrs, dJointInput.badWordsLens,
-        dInput->badWordsPtrs, dInput->badWordsLens, dInput->maxBadWordsLen, mMaxBadWordsLen, localBatchSize, batchSlot);
+        mMaxBadWordsLen, batchSlot);
     dJointInput.maxBadWordsLen = mMaxBadWordsLen;
 
     TensorPtr sequenceLimitLength{
         ITensor::slice(constPointerCast(dJointInput.sequenceLimitLength), batchSlot, localBatchSize)};
-    kernels::invokeFill(*sequenceLimitLength, inputLength + maxNewTokens, *stream);
-    dInput->sequenceLimitLength = std::move(sequenceLimitLength);
     TensorPtr inputLengths{ITensor::slice(constPointerCast(dJointInput.lengths), batchSlot, localBatchSize)};
-    kernels::invokeFill(*inputLengths, inputLength, *stream);
+    dInput->sequenceLimitLength = std::move(sequenceLimitLength);
     dInput->lengths = inputLengths;
 
     // output
@@ -509,7 +489,6 @@ void GptDecoderBatch::newRequest(
     dOutput = std::make_unique<DecodingOutput>(outputIds);
 
     dOutput->finishedSum = ITensor::slice(dJointOutput.finishedSum, batchSlot, localBatchSize);
-    manager.setZero(*dOutput->finishedSum);
 
     dOutput->newTokensVec.resize(mMaxDecodingEngineTokens);
     for (SizeType32 ti = 0; ti < mMaxDecodingEngineTokens; ++ti)
@@ -517,40 +496,28 @@ void GptDecoderBatch::newRequest(
         TensorPtr newTokensStepView = ITensor::slice(dJointOutput.newTokensSteps, ti, 1);
         newTokensStepView->squeeze(0);
         dOutput->newTokensVec[ti] = ITensor::slice(newTokensStepView, batchSlot, localBatchSize);
-        manager.setZero(*dOutput->newTokensVec[ti]);
-    }
-
-    // FIXME(nkorobov): we call setZero mMaxDecodingEngineTokens times for only 1 element
-    for (SizeType32 ti = 0; ti < mMaxDecodingEngineTokens; ++ti)
-    {
-        TensorPtr finishedStepsView = ITensor::slice(mFinishedSteps, ti, 1);
-        finishedStepsView->squeeze(0);
-        TensorPtr finishedSteps = ITensor::slice(finishedStepsView, batchSlot, localBatchSize);
-        manager.setZero(*finishedSteps);
     }
 
     // cumLogProb is mandatory for beamWidth > 1
     dOutput->cumLogProbs = nullptr;
-    if ((samplingConfig.cumLogProbs.has_value() && samplingConfig.cumLogProbs->at(0)) || beamWidth > 1)
+    auto const hasCumLogProbs
+        = (samplingConfig.cumLogProbs.has_value() && samplingConfig.cumLogProbs->at(0)) || beamWidth > 1;
+    if (hasCumLogProbs)
     {
         dOutput->cumLogProbs = ITensor::slice(dJointOutput.cumLogProbs, batchSlot, localBatchSize);
-        manager.setZero(*dOutput->cumLogProbs);
     }
 
     dOutput->logProbs = nullptr;
-    if (samplingConfig.outputLogProbs.has_value() && samplingConfig.outputLogProbs->at(0))
+    auto const hasLogProbs = samplingConfig.outputLogProbs.has_value() && samplingConfig.outputLogProbs->at(0);
+    if (hasLogProbs)
     {
         dOutput->logProbs = ITensor::slice(dJointOutput.logProbs, batchSlot, localBatchSize);
-        manager.setZero(*dOutput->logProbs);
     }
 
     if (beamWidth > 1)
     {
-        kernels::invokeFill(
-            *IBuffer::slice(dOutput->cumLogProbs, 1, beamWidth - 1), DecodingOutput::kNegativeInfinity, *stream);
         dOutput->parentIds = ITensor::slice(dJointOutput.parentIds, batchSlot, localBatchSize);
         dOutput->parentIds->reshape(outputIdsShape);
-        manager.setZero(*dOutput->parentIds);
         dOutput->beamHypotheses = dJointOutput.beamHypotheses.slice(batchSlot, localBatchSize);
         dOutput->beamHypotheses.init(manager, endId);
     }
@@ -563,22 +530,17 @@ void GptDecoderBatch::newRequest(
     }
 
     // remaining
-    if (!mFusedDecoder)
-    {
-        mDecoders[decoderIdx]->setup(samplingConfig, localBatchSize);
-    }
     mBeamWidths[batchSlot] = beamWidth;
     mNbSteps[batchSlot] = 0;
     mFinished[batchSlot] = false;
     mMaxNewTokens[batchSlot] = maxNewTokens;
     mNumDecodingEngineTokens[batchSlot] = numDecodingEngineTokens;
 
-    // copy the request ids into outputIds
-    auto const requestIdsShape = requestIds->getShape();
-    auto inputIdsView = ITensor::view(requestIds, ITensor::makeShape({localBatchSize, requestIdsShape.d[0]}));
-    auto outputIdsView = ITensor::view(outputIds, ITensor::makeShape({beamWidth, mMaxSequenceLength}));
-    kernels::invokeFill(*outputIdsView, endId, *stream);
-    kernels::tileTensor(*outputIdsView, *inputIdsView, beamWidth, *stream);
+    // The slot is initialized, including the copy of the request ids into outputIds, for all new requests at once by
+    // invokeInitNewRequests
+    setup = kernels::NewRequestSetup{bufferCast<TokenIdType>(*requestIds),
+        static_cast<SizeType32>(requestIds->getShape().d[0]), batchSlot, beamWidth, inputLength,
+        inputLength + maxNewTokens, endId, !request.embeddingBias, hasCumLogProbs, hasLogProbs};
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -633,7 +595,6 @@ void GptDecoderBatch::newRequestDraftTokensExternal(
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    TLLM_CHECK_WITH_INFO(mFusedDecoder, "Speculative decoding requires fused decoder");
     auto constexpr decoderIdx = 0;
     auto const& stream = mStreams.at(decoderIdx);
     BufferManager manager{stream};
@@ -678,7 +639,6 @@ void GptDecoderBatch::newRequestMedusa(SizeType32 batchIdx, decoder_batch::Reque
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    TLLM_CHECK_WITH_INFO(mFusedDecoder, "Medusa requires fused decoder");
     auto constexpr decoderIdx = 0;
     auto const& stream = mStreams.at(decoderIdx);
     BufferManager manager{stream};
@@ -715,7 +675,6 @@ void GptDecoderBatch::newRequestLookahead(SizeType32 batchIdx, decoder_batch::Re
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    TLLM_CHECK_WITH_INFO(mFusedDecoder, "Lookahead decoding requires fused decoder");
     // TODO(nkorobov) add lookahead layer
     TLLM_LOG_WARNING("Lookahead decoding is not supported yet.");
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -725,7 +684,6 @@ void GptDecoderBatch::newRequestExplicitDraftTokens(SizeType32 batchIdx, decoder
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    TLLM_CHECK_WITH_INFO(mFusedDecoder, "Explicit draft tokens decoding requires fused decoder");
     TLLM_CHECK(mJointDecodingOutput->explicitDraftTokensBuffers);
 
     auto constexpr localBatchSize = 1;
@@ -773,36 +731,45 @@ void GptDecoderBatch::newRequests(std::vector<SizeType32> const& seqSlots,
 
     auto batchSlotsPtr = bufferCast<SizeType32>(*mBatchSlotsSetup);
     SizeType32 const localBatchSize = seqSlots.size();
+    std::vector<kernels::NewRequestSetup> setups(localBatchSize);
     for (SizeType32 bi = 0; bi < localBatchSize; ++bi)
     {
-        newRequest(seqSlots[bi], requests[bi], samplingConfigs[bi]);
-        if (mFusedDecoder)
-        {
-            batchSlotsPtr[bi] = seqSlots[bi];
-        }
+        newRequest(seqSlots[bi], requests[bi], samplingConfigs[bi], setups[bi]);
     }
-    if (mFusedDecoder)
-    {
-        TensorPtr batchSlotsView = ITensor::slice(mBatchSlotsSetup, 0, localBatchSize);
-        auto fusedSamplingConfig = SamplingConfig(samplingConfigs);
-        mDecoders[0]->setup(
-            fusedSamplingConfig, localBatchSize, bufferCast<SizeType32>(*batchSlotsView), {*mJointDecodingOutput});
 
-        auto const& stream = mStreams.at(0);
-        CudaEvent event{};
-        stream->record(event);
-        mStream->wait(event);
-    }
-    else
+    // Upload the setups of all new requests at once and initialize their slots in one launch
+    auto const& setupStream = mStreams.at(0);
+    BufferManager const setupManager{setupStream};
+    auto setupsDevice = setupManager.gpu(setups.size() * sizeof(kernels::NewRequestSetup));
+    setupManager.copy(setups.data(), *setupsDevice, MemoryType::kCPU);
+    auto& dJointInput = *mJointDecodingInput;
+    auto& dJointOutput = *mJointDecodingOutput;
+    auto const& jointOutputIdsShape = dJointOutput.ids->getShape();
+    kernels::NewRequestsBuffers const buffers{bufferCast<TokenIdType>(*dJointOutput.ids),
+        bufferCast<TokenIdType>(*dJointOutput.parentIds),
+        bufferCast<TokenIdType>(*constPointerCast(dJointInput.endIds)),
+        bufferCast<SizeType32>(*constPointerCast(dJointInput.lengths)),
+        bufferCast<SizeType32>(*constPointerCast(dJointInput.sequenceLimitLength)),
+        bufferCast<SizeType32>(*dJointOutput.finishedSum), bufferCast<TokenIdType>(*dJointOutput.newTokensSteps),
+        bufferCast<tk::FinishedState::UnderlyingType>(*mFinishedSteps),
+        bufferCast<float>(*dJointOutput.cumLogProbs), bufferCast<float>(*dJointOutput.logProbs),
+        bufferCast<float>(*constPointerCast(dJointInput.embeddingBias)),
+        static_cast<SizeType32>(jointOutputIdsShape.d[0]), static_cast<SizeType32>(jointOutputIdsShape.d[1]),
+        mMaxSequenceLength, mMaxDecodingEngineTokens, static_cast<SizeType32>(mVocabSizePadded)};
+    kernels::invokeInitNewRequests(buffers, *setupsDevice, localBatchSize, *setupStream);
+
+    for (SizeType32 bi = 0; bi < localBatchSize; ++bi)
     {
-        for (SizeType32 bi = 0; bi < localBatchSize; ++bi)
-        {
-            auto const& stream = mStreams.at(bi);
-            CudaEvent event{};
-            stream->record(event);
-            mStream->wait(event);
-        }
+        batchSlotsPtr[bi] = seqSlots[bi];
     }
+    TensorPtr batchSlotsView = ITensor::slice(mBatchSlotsSetup, 0, localBatchSize);
+    auto fusedSamplingConfig = SamplingConfig(samplingConfigs);
+    mDecoders[0]->setup(
+        fusedSamplingConfig, localBatchSize, bufferCast<SizeType32>(*batchSlotsView), {*mJointDecodingOutput});
+
+    CudaEvent event{};
+    setupStream->record(event);
+    mStream->wait(event);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -814,15 +781,7 @@ void GptDecoderBatch::forwardDispatch(
 
     for (SizeType32 si = 0; si < maxDecodingEngineTokens; si += mMaxDecodingDecoderTokens)
     {
-        if (!mFusedDecoder)
-        {
-            TLLM_CHECK_WITH_INFO(forwardType == ForwardType::kASYNC, "Unfused decoder supports only async forward");
-            forwardUnfusedDecoder(si, output, input, forwardType);
-        }
-        else
-        {
-            forwardFusedDecoder(si, output, input, forwardType);
-        }
+        forwardFusedDecoder(si, output, input, forwardType);
     }
 }
 
@@ -830,6 +789,7 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
     decoder_batch::Output& output, decoder_batch::Input const& input)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_PROFILE_GPU_RANGE(kDECODER, "GptDecoderBatch::forwardAsync", mStream->get());
 
     forwardDispatch(output, input, ForwardType::kASYNC);
 
@@ -839,107 +799,6 @@ GptDecoderBatch::TokenPtr GptDecoderBatch::forwardAsync(
     return std::make_unique<decoder_batch::Token>(std::move(eventStop), input.active);
 }
 
-void GptDecoderBatch::forwardUnfusedDecoder(
-    SizeType32 step, decoder_batch::Output& output, decoder_batch::Input const& input, ForwardType forwardType)
-{
-    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
-
-    auto eventStart = CudaEvent{};
-    mStream->record(eventStart);
-
-    auto& allTargetLogits = input.logits;
-    auto const& jointOutputIdsShape = mJointDecodingOutput->ids->getShape();
-    auto const maxBeamWidth = jointOutputIdsShape.d[1];
-
-    auto& srcCacheIndirection = input.cacheIndirection;
-    auto& tgtCacheIndirection = output.cacheIndirection;
-    TLLM_CHECK_WITH_INFO((srcCacheIndirection && tgtCacheIndirection) || (!srcCacheIndirection && !tgtCacheIndirection),
-        "Specify both srcCacheIndirection and tgtCacheIndirection or neither.");
-    TLLM_CHECK(!srcCacheIndirection || srcCacheIndirection->getDataType() == TRTDataType<SizeType32>::value);
-    TLLM_CHECK(!tgtCacheIndirection || tgtCacheIndirection->getDataType() == TRTDataType<SizeType32>::value);
-
-    TLLM_CHECK(static_cast<SizeType32>(output.sequenceLengths->getSize()) == mActualBatchSize * maxBeamWidth);
-    // TODO should remove this reshape and set shape to [batch_size, beam_width] outside
-    TensorPtr sequenceLengths
-        = ITensor::view(output.sequenceLengths, ITensor::makeShape({mActualBatchSize, maxBeamWidth}));
-    TLLM_CHECK(sequenceLengths);
-
-    bool const async = forwardType == ForwardType::kASYNC;
-
-    auto constexpr singleRequest = 1;
-
-    for (SizeType32 bi = 0; bi < mActualBatchSize; ++bi)
-    {
-        if (mFinished[bi] || !input.active.at(bi) || step >= mNumDecodingEngineTokens[bi])
-        {
-            continue;
-        }
-
-        auto const& stream = mStreams.at(bi);
-        if (async)
-        {
-            stream->wait(eventStart);
-        }
-
-        auto& targetLogits = allTargetLogits[bi];
-        auto& dInput = *mDecodingInputs[bi];
-        auto& dOutput = *mDecodingOutputs[bi];
-        auto& decoder = *mDecoders[bi];
-
-        TensorPtr finishedStepsInput = ITensor::slice(mFinishedSteps, step, 1);
-        TensorPtr finishedStepsOutput
-            = ITensor::slice(mFinishedSteps, std::min(step + 1, mNumDecodingEngineTokens[bi] - 1), 1);
-        finishedStepsInput->squeeze(0);
-        finishedStepsOutput->squeeze(0);
-
-        if (srcCacheIndirection && tgtCacheIndirection)
-        {
-            auto srcView = std::shared_ptr(ITensor::slice(srcCacheIndirection, bi, singleRequest));
-            auto tgtView = std::shared_ptr(ITensor::slice(tgtCacheIndirection, bi, singleRequest));
-            dInput.cacheIndirection = ITensor::view(
-                srcView, ITensor::makeShape({singleRequest, mBeamWidths[bi], srcView->getShape().d[2]}));
-            dOutput.cacheIndirection = ITensor::view(
-                tgtView, ITensor::makeShape({singleRequest, mBeamWidths[bi], tgtView->getShape().d[2]}));
-        }
-
-        auto sequenceLengthsView = std::shared_ptr(ITensor::slice(sequenceLengths, bi, singleRequest));
-        dOutput.lengths = ITensor::view(sequenceLengthsView, ITensor::makeShape({singleRequest, mBeamWidths[bi]}));
-
-        {
-            dInput.logits = ITensor::slice(targetLogits, step, singleRequest);
-            dOutput.newTokens = ITensor::view(dOutput.newTokensVec[step]);
-            dInput.finished = ITensor::slice(finishedStepsInput, bi, singleRequest);
-            dOutput.finished = ITensor::slice(finishedStepsOutput, bi, singleRequest);
-
-            if (async)
-            {
-                decoder.forwardAsync(dOutput, dInput);
-            }
-            else
-            {
-                decoder.forwardSync(dOutput, dInput);
-            }
-
-            mNbSteps[bi] += 1;
-            mFinished[bi] = mNbSteps[bi] >= mMaxNewTokens[bi];
-            dInput.step += 1;
-        }
-
-        if (async)
-        {
-            if (step == mNumDecodingEngineTokens[bi] - 1)
-            {
-                auto const& stream = mStreams.at(bi);
-                CudaEvent event{};
-                stream->record(event);
-                mStream->wait(event);
-            }
-        }
-    }
-
-    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
-}
-
 void GptDecoderBatch::forwardFusedDecoder(
     SizeType32 step, decoder_batch::Output& output, decoder_batch::Input const& input, ForwardType forwardType)
 {
@@ -997,23 +856,19 @@ void GptDecoderBatch::forwardFusedDecoder(
             continue;
         }
 
-        if (mFusedDecoder)
+        if (!mAcceptByLogits[bi] && mMaxDecodingDecoderTokens == 1 && mNumDecodingEngineTokens[bi] > 1
+            && step == mNumDecodingEngineTokens[bi] - 1)
         {
-            if (!mAcceptByLogits[bi] && mMaxDecodingDecoderTokens == 1 && mNumDecodingEngineTokens[bi] > 1
-                && step == mNumDecodingEngineTokens[bi] - 1)
-            {
-                batchSlotsAcceptTokensPtr[step * mActualBatchSize + localBatchAcceptTokensIdx] = bi;
-                localBatchAcceptTokensIdx++;
-            }
-            else if (mAcceptByLogits[bi] && mMaxDecodingDecoderTokens == 1 && mNumDecodingEngineTokens[bi] > 1
-                && step == 0)
-            {
-                batchSlotsAcceptLogitsPtr[step * mActualBatchSize + localBatchAcceptLogitsIdx] = bi;
-                localBatchAcceptLogitsIdx++;
-            }
-            batchSlotsDecoderPtr[step * mActualBatchSize + localBatchDecoderIdx] = bi;
-            localBatchDecoderIdx++;
+            batchSlotsAcceptTokensPtr[step * mActualBatchSize + localBatchAcceptTokensIdx] = bi;
+            localBatchAcceptTokensIdx++;
+        }
+        else if (mAcceptByLogits[bi] && mMaxDecodingDecoderTokens == 1 && mNumDecodingEngineTokens[bi] > 1 && step == 0)
+        {
+            batchSlotsAcceptLogitsPtr[step * mActualBatchSize + localBatchAcceptLogitsIdx] = bi;
+            localBatchAcceptLogitsIdx++;
         }
+        batchSlotsDecoderPtr[step * mActualBatchSize + localBatchDecoderIdx] = bi;
+        localBatchDecoderIdx++;
     }
 
     auto const maxDecodingEngineTokens
@@ -1193,35 +1048,31 @@ CudaEvent GptDecoderBatch::postProcessRequest(
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
-    auto& stream = mFusedDecoder ? mStream : mStreams[batchSlot];
+    auto& stream = mStream;
     auto manager = BufferManager{stream};
-    auto& decoder = mFusedDecoder ? *mDecoders[0] : *mDecoders[batchSlot];
+    auto& decoder = *mDecoders[0];
 
     auto& dInput = *mDecodingInputs[batchSlot];
     auto& dOutput = *mDecodingOutputs[batchSlot];
+    auto& dJointOutput = *mJointDecodingOutput;
 
-    if (mFusedDecoder)
+    auto slice = [&batchSlot](auto& a, auto& b)
     {
-        auto& dJointOutput = *mJointDecodingOutput;
-
-        auto slice = [&batchSlot](auto& a, auto& b)
+        if (b && b->getShape().d[0] > 0)
         {
-            if (b && b->getShape().d[0] > 0)
-            {
-                a = ITensor::slice(b, batchSlot, 1);
-            }
-        };
+            a = ITensor::slice(b, batchSlot, 1);
+        }
+    };
 
-        slice(dOutput.cacheIndirection, dJointOutput.cacheIndirection);
-        slice(dOutput.lengths, dJointOutput.lengths);
-        slice(dOutput.finished, dJointOutput.finished);
-        slice(dOutput.logProbs, dJointOutput.logProbs);
+    slice(dOutput.cacheIndirection, dJointOutput.cacheIndirection);
+    slice(dOutput.lengths, dJointOutput.lengths);
+    slice(dOutput.finished, dJointOutput.finished);
+    slice(dOutput.logProbs, dJointOutput.logProbs);
 
-        dOutput.newTokens = ITensor::view(dJointOutput.newTokens);
-        TLLM_CHECK(dOutput.newTokens->getShape().d[0] == 1);
-        dOutput.newTokens->squeeze(0);
-        dOutput.newTokens = ITensor::slice(dOutput.newTokens, batchSlot, 1);
-    }
+    dOutput.newTokens = ITensor::view(dJointOutput.newTokens);
+    TLLM_CHECK(dOutput.newTokens->getShape().d[0] == 1);
+    dOutput.newTokens->squeeze(0);
+    dOutput.newTokens = ITensor::slice(dOutput.newTokens, batchSlot, 1);
 
     // TODO can we do this inplace?
     auto& outputIds = dOutput.ids;
@@ -1260,6 +1111,9 @@ void GptDecoderBatch::newBatch(
     auto inputLengthsHost = mBufferManager.copyFrom(*inputLengths, MemoryType::kCPU);
     auto inputLengthsPtr = bufferCast<SizeType32>(*inputLengthsHost);
     auto inputOffset = 0;
+    std::vector<SizeType32> seqSlots;
+    std::vector<decoder_batch::Request> requests;
+    std::vector<SamplingConfig> samplingConfigs;
     for (auto batchIdx = 0; batchIdx < mActualBatchSize; ++batchIdx)
     {
         mNumDecodingEngineTokens[batchIdx] = 1;
@@ -1307,8 +1161,11 @@ void GptDecoderBatch::newBatch(
         auto requestSamplingConfig = extractSamplingConfig(samplingConfig, batchIdx);
         requestSamplingConfig.cumLogProbs = {{outputs.cumLogProbs != nullptr}};
         requestSamplingConfig.outputLogProbs = {{outputs.logProbs != nullptr}};
-        newRequest(batchIdx, request, requestSamplingConfig);
+        seqSlots.push_back(batchIdx);
+        requests.push_back(std::move(request));
+        samplingConfigs.push_back(std::move(requestSamplingConfig));
     }
+    newRequests(seqSlots, requests, samplingConfigs);
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
@@ -1336,7 +1193,7 @@ void GptDecoderBatch::forwardAsync(decoder::Output& output, decoder::Input const
     batchOutput.sequenceLengths = output.sequenceLengths;
 
     mForwardToken = forwardAsync(batchOutput, batchInput);
-    mBufferManager.setZero(*mFinishedSum);
+    // reduce overwrites mFinishedSum on the stream, a host memset would race with the previous step
     kernels::reduce(*mFinishedSum, *ITensor::slice(mJointDecodingOutput->finishedSum, 0, mActualBatchSize), *mStream);
     mStream->record(mForwardEvent);
 
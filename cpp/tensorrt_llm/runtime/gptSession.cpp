@@ -26,6 +26,7 @@
 #include "tensorrt_llm/common/stringUtils.h"
 #include "tensorrt_llm/runtime/gptDecoderBatch.h"
 #include "tensorrt_llm/runtime/ipcUtils.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
 #include "tensorrt_llm/runtime/ncclCommunicator.h"
 #include "tensorrt_llm/runtime/runtimeBuffers.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
@@ -38,6 +39,7 @@
 #include <cstdlib> // std::getenv
 #include <cuda_profiler_api.h>
 #include <memory>
+#include <numeric>
 #include <sstream>
 #include <string>
 #include <unordered_set>
@@ -79,8 +81,12 @@ GptSession::GptSession(Config const& sessionConfig, ModelConfig const& modelConf
     , mWorldConfig{worldConfig}
     , mDevice{utils::initDevice(worldConfig)}
     , mLogger{logger ? std::move(logger) : std::make_shared<TllmLogger>()}
-    , mRuntime{std::make_shared<TllmRuntime>(rawEngine, mLogger.get(), sessionConfig.gpuWeightsPercent)}
+    , mRuntime{sessionConfig.shareEngine
+              ? TllmRuntime::createWithSharedEngine(rawEngine, mLogger.get())
+              : std::make_shared<TllmRuntime>(rawEngine, mLogger.get(), sessionConfig.gpuWeightsPercent)}
 {
+    TLLM_CHECK_WITH_INFO(!sessionConfig.shareEngine || sessionConfig.gpuWeightsPercent >= 1.0f,
+        "Engines with weight streaming can't be shared.");
     TLLM_LOG_WARNING(
         "GptSession is deprecated and will be removed in a future release."
         " Please use the executor API instead (cpp/include/tensorrt_llm/executor).");
@@ -181,7 +187,7 @@ void GptSession::createDecoders(SizeType32 batchSize, SizeType32 beamWidth, Size
         }
         constexpr SizeType32 maxTokensPerStep = 1;
         mDecoders.back()->setup(decodingMode, batchSize, beamWidth, maxAttentionWindow, sinkTokenLength,
-            maxSequenceLength, maxTokensPerStep, /* fusedDecoder*/ false, logitsType, mModelConfig);
+            maxSequenceLength, maxTokensPerStep, /* fusedDecoder*/ true, logitsType, mModelConfig);
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -219,7 +225,10 @@ void GptSession::createKvCacheManager(SizeType32 maxBatchSize, SizeType32 maxBea
         buffers->transformerBuffers->reshapeKvTensors(maxBatchSize, maxBeamWidth, maxBlocksPerSeq, *mRuntime);
     }
 
-    mKvCacheManager->allocatePools(kvDtype, kvCacheConfig.useUvm);
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kKV_CACHE};
+        mKvCacheManager->allocatePools(kvDtype, kvCacheConfig.useUvm);
+    }
 
     for (auto& buffers : mBuffers)
     {
@@ -244,8 +253,10 @@ void GptSession::createCustomAllReduceWorkspace(
 }
 
 GptSession::MicroBatchConfig::MicroBatchConfig(SizeType32 maxBatchSize, SizeType32 pipelineParallelism,
-    std::optional<SizeType32> genMicroBatchSize, std::optional<SizeType32> ctxMicroBatchSize)
+    std::optional<SizeType32> genMicroBatchSize, std::optional<SizeType32> ctxMicroBatchSize,
+    SizeType32 genMicroBatchesPerStage)
 {
+    TLLM_CHECK(genMicroBatchesPerStage > 0);
     if (genMicroBatchSize || ctxMicroBatchSize)
     {
         genBatchSize = genMicroBatchSize.value_or(maxBatchSize);
@@ -258,7 +269,7 @@ GptSession::MicroBatchConfig::MicroBatchConfig(SizeType32 maxBatchSize, SizeType
     }
     else
     {
-        numCtxBatches = numGenBatches = pipelineParallelism;
+        numCtxBatches = numGenBatches = pipelineParallelism * genMicroBatchesPerStage;
         ctxBatchSize = genBatchSize = tc::ceilDiv(maxBatchSize, numGenBatches);
     }
 }
@@ -268,6 +279,8 @@ void GptSession::setup(Config const& sessionConfig)
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
     mCudaGraphMode = sessionConfig.cudaGraphMode;
+    mFinishedSync = FinishedSyncPolicy{sessionConfig.finishedSyncInterval};
+    mSortMicroBatchesByInputLength = sessionConfig.sortMicroBatchesByInputLength;
 
     auto const maxBatchSize = sessionConfig.maxBatchSize;
     auto const maxBeamWidth = sessionConfig.maxBeamWidth;
@@ -279,15 +292,28 @@ void GptSession::setup(Config const& sessionConfig)
             "The value of maxAttentionWindow cannot exceed maxSequenceLength. "
             "Therefore, it has been adjusted to match the value of maxSequenceLength.");
     }
-    auto const maxAttentionWindow = sessionConfig.kvCacheConfig.maxAttentionWindow.has_value()
+    auto maxAttentionWindow = sessionConfig.kvCacheConfig.maxAttentionWindow.has_value()
         ? std::min(sessionConfig.kvCacheConfig.maxAttentionWindow.value(), maxSequenceLength)
         : maxSequenceLength;
+    std::vector<SizeType32> maxAttentionWindowVec;
+    if (sessionConfig.maxAttentionWindowVec.has_value())
+    {
+        TLLM_CHECK_WITH_INFO(!sessionConfig.maxAttentionWindowVec->empty(),
+            "maxAttentionWindowVec must contain at least one window");
+        for (auto const window : sessionConfig.maxAttentionWindowVec.value())
+        {
+            TLLM_CHECK_WITH_INFO(window > 0, "Attention windows must be positive");
+            maxAttentionWindowVec.push_back(std::min(window, maxSequenceLength));
+        }
+        // The KV cache is sized for the largest window, smaller windows reuse their blocks cyclically.
+        maxAttentionWindow = *std::max_element(maxAttentionWindowVec.begin(), maxAttentionWindowVec.end());
+    }
     auto const sinkTokenLength = sessionConfig.kvCacheConfig.sinkTokenLength.has_value()
         ? sessionConfig.kvCacheConfig.sinkTokenLength.value()
         : 0;
 
     mMicroBatchConfig = MicroBatchConfig(maxBatchSize, mWorldConfig.getPipelineParallelism(),
-        sessionConfig.genMicroBatchSize, sessionConfig.ctxMicroBatchSize);
+        sessionConfig.genMicroBatchSize, sessionConfig.ctxMicroBatchSize, sessionConfig.genMicroBatchesPerStage);
 
     if (sessionConfig.cudaGraphMode)
     {
@@ -305,6 +331,7 @@ void GptSession::setup(Config const& sessionConfig)
     // TODO refactor batch manager to remove dependency on maxSequenceLength.
     mDecoderMaxSequenceLength = maxSequenceLength;
     mDecoderMaxAttentionWindow = maxAttentionWindow;
+    mDecoderMaxAttentionWindowVec = maxAttentionWindowVec;
     mDecoderSinkTokenLength = sinkTokenLength;
 
     if (mWorldConfig.isLastPipelineParallelRank())
@@ -326,6 +353,15 @@ void GptSession::setup(Config const& sessionConfig)
         }
     }
 
+    mDecoderStepEvents.clear();
+    if (mFinishedSync.isPolling() && mWorldConfig.isLastPipelineParallelRank())
+    {
+        for (SizeType32 i = 0; i < mMicroBatchConfig.numGenBatches; ++i)
+        {
+            mDecoderStepEvents.emplace_back();
+        }
+    }
+
     if (mWorldConfig.isTensorParallel() && mModelConfig.useCustomAllReduce())
     {
         createCustomAllReduceWorkspace(mMicroBatchConfig.genBatchSize, maxBeamWidth, maxSequenceLength);
@@ -336,6 +372,7 @@ void GptSession::setup(Config const& sessionConfig)
         // we don't know maxInputLength yet and ignore it for pre-allocation
         buffers->generationConfig = GenerationConfig{
             mMicroBatchConfig.genBatchSize, maxBeamWidth, 0, maxAttentionWindow, sinkTokenLength, maxSequenceLength};
+        buffers->generationConfig.maxAttentionWindowVec = maxAttentionWindowVec;
         buffers->reshape(mModelConfig, mWorldConfig);
     }
 
@@ -562,6 +599,143 @@ std::vector<GenerationOutput> splitOutputs(
     return outputBatches;
 }
 
+//! Order of the requests by decreasing input length, ties in input order.
+std::vector<SizeType32> sortByInputLength(ITensor const& inputLengthsHost)
+{
+    auto const lengths = BufferRange<SizeType32 const>(inputLengthsHost);
+    std::vector<SizeType32> order(lengths.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(
+        order.begin(), order.end(), [&lengths](auto lhs, auto rhs) { return lengths[lhs] > lengths[rhs]; });
+    return order;
+}
+
+//! Rows order[i] of tensor as rows i of a new tensor.
+ITensor::SharedPtr gatherRows(
+    ITensor::SharedPtr const& tensor, std::vector<SizeType32> const& order, BufferManager const& manager)
+{
+    ITensor::SharedPtr gathered = manager.allocate(tensor->getMemoryType(), tensor->getShape(), tensor->getDataType());
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        manager.copy(*ITensor::slice(tensor, order[i], 1), *ITensor::slice(gathered, i, 1));
+    }
+    return gathered;
+}
+
+//! Rows i of sorted back to rows order[i] of tensor.
+void scatterRows(ITensor::SharedPtr const& tensor, ITensor::SharedPtr const& sorted,
+    std::vector<SizeType32> const& order, BufferManager const& manager)
+{
+    for (std::size_t i = 0; i < order.size(); ++i)
+    {
+        manager.copy(*ITensor::slice(sorted, i, 1), *ITensor::slice(tensor, order[i], 1));
+    }
+}
+
+//! Splits the requests taken in the given order into micro batches, each with its own input ids: packed, or padded to
+//! the longest input of the micro batch instead of the longest input of the batch.
+std::vector<GenerationInput> splitSortedInputs(GenerationInput const& inputs, std::vector<SizeType32> const& order,
+    ITensor const& inputLengthsHost, SizeType32 microBatchSize, BufferManager& manager,
+    std::optional<SizeType32> maxNumTokens)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const lengths = BufferRange<SizeType32 const>(inputLengthsHost);
+    auto const numRequests = static_cast<SizeType32>(order.size());
+
+    ITensor::SharedPtr inputIdsView = ITensor::view(inputs.ids);
+    std::vector<SizeType32> tokenOffsets(numRequests + 1, 0);
+    if (inputs.packed)
+    {
+        if (inputIdsView->getShape().nbDims == 2)
+        { // For users still pass inputs.ids with shape [1, num_tokens], do squeeze for them.
+            inputIdsView->squeeze(0);
+        }
+        TLLM_CHECK(inputIdsView->getShape().nbDims == 1);
+        std::partial_sum(lengths.begin(), lengths.end(), tokenOffsets.begin() + 1);
+    }
+    auto const maxInputLength = inputs.packed ? 0 : static_cast<SizeType32>(inputIdsView->getShape().d[1]);
+
+    auto sortedLengthsHost = manager.cpu(ITensor::makeShape({numRequests}), nvinfer1::DataType::kINT32);
+    auto sortedLengthsRange = BufferRange<SizeType32>(*sortedLengthsHost);
+    std::transform(order.begin(), order.end(), sortedLengthsRange.begin(), [&lengths](auto bi) { return lengths[bi]; });
+    ITensor::SharedPtr sortedLengths = manager.copyFrom(*sortedLengthsHost, MemoryType::kGPU);
+
+    auto const gatherIfSet = [&order, &manager](ITensor::SharedPtr const& tensor)
+    { return tensor ? gatherRows(tensor, order, manager) : tensor; };
+    // A two-dimensional list of bad words is shared by all the requests
+    auto const badWordsList = inputs.badWordsList && inputs.badWordsList->getShape().nbDims == 3
+        ? gatherRows(inputs.badWordsList, order, manager)
+        : inputs.badWordsList;
+    auto const stopWordsList = gatherIfSet(inputs.stopWordsList);
+    auto const tasks = gatherIfSet(inputs.promptTuningParams.tasks);
+
+    std::vector<GenerationInput> inputBatches;
+    for (auto offset = 0; offset < numRequests; offset += microBatchSize)
+    {
+        auto const batchSize = std::min(microBatchSize, numRequests - offset);
+        auto const batchLengths = sortedLengthsRange.begin() + offset;
+        ITensor::SharedPtr batchIds;
+        if (inputs.packed)
+        {
+            auto const numTokens = std::accumulate(batchLengths, batchLengths + batchSize, 0);
+            if (maxNumTokens)
+                TLLM_CHECK_WITH_INFO(numTokens <= maxNumTokens.value(),
+                    "Micro-batch %d with %d token exceeds max_num_tokens=%d, consider to use larger value when "
+                    "building engine",
+                    offset / microBatchSize, numTokens, maxNumTokens.value());
+            batchIds = manager.gpu(ITensor::makeShape({numTokens}), inputs.ids->getDataType());
+            SizeType32 tokensBegin = 0;
+            for (auto bi = 0; bi < batchSize; ++bi)
+            {
+                auto const requestIdx = order[offset + bi];
+                auto const length = lengths[requestIdx];
+                manager.copy(*ITensor::slice(inputIdsView, tokenOffsets[requestIdx], length),
+                    *ITensor::slice(batchIds, tokensBegin, length));
+                tokensBegin += length;
+            }
+        }
+        else
+        {
+            auto const batchMaxLength = *std::max_element(batchLengths, batchLengths + batchSize);
+            batchIds = manager.gpu(ITensor::makeShape({batchSize, batchMaxLength}), inputs.ids->getDataType());
+            kernels::invokeFill(*batchIds, inputs.padId, manager.getStream());
+            for (auto bi = 0; bi < batchSize; ++bi)
+            {
+                auto const requestIdx = order[offset + bi];
+                auto const length = lengths[requestIdx];
+                ITensor::SharedPtr const inputRow
+                    = ITensor::view(ITensor::slice(inputIdsView, requestIdx, 1), ITensor::makeShape({maxInputLength}));
+                ITensor::SharedPtr const batchRow
+                    = ITensor::view(ITensor::slice(batchIds, bi, 1), ITensor::makeShape({batchMaxLength}));
+                manager.copy(*ITensor::slice(inputRow, 0, length), *ITensor::slice(batchRow, 0, length));
+            }
+        }
+
+        auto& batch = inputBatches.emplace_back(inputs.endId, inputs.padId, std::move(batchIds),
+            ITensor::slice(sortedLengths, offset, batchSize), inputs.packed);
+        batch.embeddingBias = inputs.embeddingBias;
+        batch.maxNewTokens = inputs.maxNewTokens;
+        batch.promptTuningParams.embeddingTable = inputs.promptTuningParams.embeddingTable;
+        batch.promptTuningParams.vocabSize = inputs.promptTuningParams.vocabSize;
+        if (badWordsList)
+        {
+            batch.badWordsList = badWordsList->getShape().nbDims == 2 ? badWordsList
+                                                                      : ITensor::slice(badWordsList, offset, batchSize);
+        }
+        if (stopWordsList)
+        {
+            batch.stopWordsList = ITensor::slice(stopWordsList, offset, batchSize);
+        }
+        if (tasks)
+        {
+            batch.promptTuningParams.tasks = ITensor::slice(tasks, offset, batchSize);
+        }
+    }
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return inputBatches;
+}
+
 void updateOutputIds(ITensor::SharedPtr const& outputIds, ITensor::SharedPtr const& newTokens, SizeType32 decoderStep,
     CudaStream const& stream)
 { // assemble outputIds of all micro batches
@@ -656,9 +830,48 @@ void GptSession::generate(GenerationOutput& outputs, GenerationInput const& inpu
         }
     }
 
+    // The context logits of a micro batch depend on its input lengths and the callback sees the outputs as they are
+    // generated, so that only the other outputs can be reordered.
+    auto const sortMicroBatches = mSortMicroBatchesByInputLength && batchSize > mMicroBatchConfig.genBatchSize
+        && !mModelConfig.computeContextLogits() && !outputs.onTokenGenerated;
+
     // callbacks
     auto const onTokenGenerated = createOnTokenGeneratedCallback(outputs);
-    if (batchSize <= mMicroBatchConfig.genBatchSize)
+    if (sortMicroBatches)
+    {
+        auto const inputLengthsHost = manager.copyFrom(*inputLengths, MemoryType::kCPU);
+        auto const order = sortByInputLength(*inputLengthsHost);
+        auto const microBatchesInputs = splitSortedInputs(
+            inputs, order, *inputLengthsHost, mMicroBatchConfig.genBatchSize, manager, mModelConfig.getMaxNumTokens());
+
+        auto const emptyLike = [&manager](ITensor::SharedPtr const& tensor) -> ITensor::SharedPtr
+        {
+            if (!tensor)
+            {
+                return nullptr;
+            }
+            return manager.allocate(tensor->getMemoryType(), tensor->getShape(), tensor->getDataType());
+        };
+        GenerationOutput sortedOutputs{emptyLike(outputs.ids), emptyLike(outputs.lengths)};
+        sortedOutputs.cumLogProbs = emptyLike(outputs.cumLogProbs);
+        sortedOutputs.logProbs = emptyLike(outputs.logProbs);
+        sortedOutputs.generationLogits = emptyLike(outputs.generationLogits);
+        auto microBatchesOutputs = splitOutputs(sortedOutputs, mMicroBatchConfig.genBatchSize, mWorldConfig);
+        generateBatched(microBatchesOutputs, microBatchesInputs, samplingConfig, onTokenGenerated, generationProfiler);
+
+        scatterRows(outputs.ids, sortedOutputs.ids, order, manager);
+        scatterRows(outputs.lengths, sortedOutputs.lengths, order, manager);
+        for (auto const& [output, sortedOutput] : {std::make_pair(outputs.cumLogProbs, sortedOutputs.cumLogProbs),
+                 std::make_pair(outputs.logProbs, sortedOutputs.logProbs),
+                 std::make_pair(outputs.generationLogits, sortedOutputs.generationLogits)})
+        {
+            if (output && mWorldConfig.isLastPipelineParallelRank())
+            {
+                scatterRows(output, sortedOutput, order, manager);
+            }
+        }
+    }
+    else if (batchSize <= mMicroBatchConfig.genBatchSize)
     {
         std::vector<GenerationInput> microBatchesInputs{inputs};
         std::vector<GenerationOutput> microBatchesOutputs{outputs};
@@ -713,6 +926,7 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         auto& buffers = *mBuffers.at(microBatchId);
         buffers.initFromInput(*microBatchInputs.ids, microBatchInputs.lengths, microBatchInputs.packed, beamWidth,
             mDecoderMaxAttentionWindow, mDecoderSinkTokenLength, mDecoderMaxSequenceLength, manager);
+        buffers.generationConfig.maxAttentionWindowVec = mDecoderMaxAttentionWindowVec;
         buffers.reshape(mModelConfig, mWorldConfig);
         buffers.reset(manager);
     }
@@ -784,6 +998,8 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         manager.getStream().record(generationProfiler->getStart());
     }
 
+    mBubbleTracker.reset();
+    auto const loopStart = PipelineBubbleTracker::Clock::now();
     while (numBatchesFinished < numMicroBatches)
     {
         ++step;
@@ -800,6 +1016,13 @@ void GptSession::generateBatched(std::vector<GenerationOutput>& microBatchesOutp
         if (profileStep)
             cudaProfilerStop();
     }
+    mBubbleTracker.addLoop(PipelineBubbleTracker::Clock::now() - loopStart);
+    if (mWorldConfig.isPipelineParallel())
+    {
+        TLLM_LOG_DEBUG("Pipeline bubble of rank %d: %.1f%% of %.1f ms with %d micro batches",
+            mWorldConfig.getPipelineParallelRank(), 100.0 * mBubbleTracker.getBubbleFraction(),
+            mBubbleTracker.getLoop().count(), numMicroBatches);
+    }
 
     if (generationProfiler)
     {
@@ -932,6 +1155,7 @@ void GptSession::executeContextStep(std::vector<GenerationInput> const& generati
     }
     if (mRuntime->hasLayerProfiler(contextId))
     {
+        mRuntime->setProfilerIteration(step);
         mRuntime->reportToProfiler(contextId);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -990,7 +1214,13 @@ SizeType32 GptSession::executeGenerationStep(SizeType32 step, std::vector<Genera
         }
 
         // check decoder result of previous iteration
-        if (shouldStopSync(generationConfig.batchSize, generationConfig.beamWidth, generationBatchId))
+        auto const blocking = mFinishedSync.isBlocking(step, generationConfig.maxInputLength,
+            generationConfig.maxSeqLength, mModelConfig.computeGenerationLogits());
+        auto const waitStart = PipelineBubbleTracker::Clock::now();
+        auto const shouldStop
+            = shouldStopSync(generationConfig.batchSize, generationConfig.beamWidth, generationBatchId, blocking);
+        mBubbleTracker.addWait(PipelineBubbleTracker::Clock::now() - waitStart);
+        if (shouldStop)
         {
             mLogger->log(nvinfer1::ILogger::Severity::kVERBOSE,
                 tc::fmtstr("GPT decoding finished for step %d and microBatchId %d", step, generationBatchId).c_str());
@@ -999,9 +1229,10 @@ SizeType32 GptSession::executeGenerationStep(SizeType32 step, std::vector<Genera
             continue;
         }
 
-        // report profile data
+        // report profile data, of the previous execution of the context
         if (mRuntime->hasLayerProfiler(contextId))
         {
+            mRuntime->setProfilerIteration(step - 1);
             mRuntime->reportToProfiler(contextId);
         }
 
@@ -1072,6 +1303,7 @@ void GptSession::decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchI
             auto& cacheIndirection = *buffers.cacheIndirectionDecoderOutput;
             auto& sequenceLengths = *buffers.sequenceLengths;
             auto const beamWidth = cacheIndirection.getShape().d[1];
+            NcclCommunicator::groupStart();
             for (auto peerIdx = 0; peerIdx < mWorldConfig.getPipelineParallelism() - 1; ++peerIdx)
             {
                 mPipelineComm->send(*decoder.getNbFinished(), pipelineGroup[peerIdx], *mCommStream);
@@ -1082,6 +1314,7 @@ void GptSession::decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchI
                 mPipelineComm->send(sequenceLengths, pipelineGroup[peerIdx], *mCommStream);
             }
             mPipelineComm->send(*decoder.getNewTokens(), pipelineGroup.front(), *mCommStream);
+            NcclCommunicator::groupEnd();
         }
     }
     else // pipeline parallel mode
@@ -1090,6 +1323,7 @@ void GptSession::decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchI
         mCommStream->wait(mCommEvent.get());
         auto const pipelineGroup = mWorldConfig.getPipelineParallelGroup();
         auto const peer = pipelineGroup.back();
+        NcclCommunicator::groupStart();
         mPipelineComm->receive(*buffers.nbFinished, peer, *mCommStream);
 
         auto& cacheIndirection = *buffers.cacheIndirectionDecoderOutput;
@@ -1103,6 +1337,10 @@ void GptSession::decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchI
         if (mWorldConfig.isFirstPipelineParallelRank())
         { // receive newTokens from last rank on a separate stream
             mPipelineComm->receive(*newTokens, peer, *mCommStream);
+        }
+        NcclCommunicator::groupEnd();
+        if (mWorldConfig.isFirstPipelineParallelRank())
+        {
             updateOutputIds(outputIds, newTokens, decoderStep, *mCommStream);
         }
         mCommStream->record(mReceivedEvents.at(microBatchId).get());
@@ -1114,14 +1352,33 @@ void GptSession::decoderStepAsync(SizeType32 decoderStep, SizeType32 microBatchI
         stream.record(mReceivedEvents.at(microBatchId).get());
     }
 
+    if (!mDecoderStepEvents.empty())
+    {
+        stream.record(mDecoderStepEvents.at(microBatchId).get());
+    }
+
     sync_check_cuda_error();
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
-bool GptSession::shouldStopSync(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 microBatchId)
+bool GptSession::shouldStopSync(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 microBatchId, bool blocking)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
 
+    if (!blocking)
+    {
+        auto const& event = mWorldConfig.isLastPipelineParallelRank() ? mDecoderStepEvents.at(microBatchId)
+                                                                       : mReceivedEvents.at(microBatchId);
+        auto const status = cudaEventQuery(event.get());
+        if (status == cudaErrorNotReady)
+        {
+            // the results of the step are not available yet, keep going
+            TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+            return false;
+        }
+        TLLM_CUDA_CHECK(status);
+    }
+
     SizeType32 nbFinished = 0;
 
     if (mWorldConfig.isLastPipelineParallelRank())
@@ -1223,10 +1480,27 @@ void GptSession::finalize(SizeType32 microBatchId)
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+void GptSession::refitWeights(StringPtrMap<ITensor> const& weights)
+{
+    TLLM_CHECK(mRuntime);
+    mRuntime->refitWeights(weights);
+}
+
 void GptSession::setLayerProfiler()
+{
+    setLayerProfiler(false);
+}
+
+void GptSession::setLayerProfiler(bool recordTimeline)
 {
     TLLM_CHECK(mRuntime);
-    mRuntime->setLayerProfiler();
+    mRuntime->setLayerProfiler(recordTimeline);
+}
+
+void GptSession::writeLayerTimeline(std::filesystem::path const& path) const
+{
+    TLLM_CHECK(mRuntime);
+    mRuntime->writeLayerTimeline(path);
 }
 
 std::string GptSession::getLayerProfileInfo() const
@@ -1235,6 +1509,12 @@ std::string GptSession::getLayerProfileInfo() const
     return mRuntime->getLayerProfileInfo();
 }
 
+std::vector<std::pair<std::string, float>> GptSession::getLayerTimes() const
+{
+    TLLM_CHECK(mRuntime);
+    return mRuntime->getLayerTimes();
+}
+
 void GptSession::CudaGraphExecutor::create(cudaGraph_t const& graph)
 {
     TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
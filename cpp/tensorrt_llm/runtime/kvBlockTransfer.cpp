@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/kvBlockTransfer.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+
+namespace tensorrt_llm::runtime
+{
+
+KvBlockTransfer::KvBlockTransfer(std::shared_ptr<NcclCommunicator> comm, std::size_t blockSizeInBytes,
+    SizeType32 maxBlocksPerMessage, CudaStreamPtr stream)
+    : mComm{std::move(comm)}
+    , mBlockSizeInBytes{blockSizeInBytes}
+    , mMaxBlocksPerMessage{maxBlocksPerMessage}
+    , mStream{stream}
+    , mCopies{blockSizeInBytes, maxBlocksPerMessage, stream}
+{
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(mComm), "Undefined NCCL communicator");
+    BufferManager manager{mStream};
+    mStaging = manager.gpu(mBlockSizeInBytes * mMaxBlocksPerMessage, nvinfer1::DataType::kUINT8);
+}
+
+KvBlockTransfer::EventPtr KvBlockTransfer::send(std::vector<void*> const& blockPointers, int peer)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const numBlocks = static_cast<SizeType32>(blockPointers.size());
+    auto* staging = static_cast<std::uint8_t*>(mStaging->data());
+    for (SizeType32 first = 0; first < numBlocks; first += mMaxBlocksPerMessage)
+    {
+        auto const numChunkBlocks = std::min(mMaxBlocksPerMessage, numBlocks - first);
+        for (SizeType32 i = 0; i < numChunkBlocks; ++i)
+        {
+            mCopies.add(blockPointers[first + i], staging + i * mBlockSizeInBytes);
+        }
+        mCopies.flush();
+        // Copies and communication share the stream, the next gather waits for the send.
+        auto const chunk = IBuffer::slice(mStaging, 0, numChunkBlocks * mBlockSizeInBytes);
+        mComm->send(*chunk, peer, *mStream);
+    }
+    auto event = std::make_shared<CudaEvent>();
+    mStream->record(*event);
+    TLLM_LOG_DEBUG("Sent %d KV cache blocks to rank %d", numBlocks, peer);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return event;
+}
+
+KvBlockTransfer::EventPtr KvBlockTransfer::receive(std::vector<void*> const& blockPointers, int peer)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const numBlocks = static_cast<SizeType32>(blockPointers.size());
+    auto const* staging = static_cast<std::uint8_t const*>(mStaging->data());
+    for (SizeType32 first = 0; first < numBlocks; first += mMaxBlocksPerMessage)
+    {
+        auto const numChunkBlocks = std::min(mMaxBlocksPerMessage, numBlocks - first);
+        auto chunk = IBuffer::slice(mStaging, 0, numChunkBlocks * mBlockSizeInBytes);
+        mComm->receive(*chunk, peer, *mStream);
+        for (SizeType32 i = 0; i < numChunkBlocks; ++i)
+        {
+            mCopies.add(staging + i * mBlockSizeInBytes, blockPointers[first + i]);
+        }
+        mCopies.flush();
+    }
+    auto event = std::make_shared<CudaEvent>();
+    mStream->record(*event);
+    TLLM_LOG_DEBUG("Received %d KV cache blocks from rank %d", numBlocks, peer);
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return event;
+}
+
+} // namespace tensorrt_llm::runtime
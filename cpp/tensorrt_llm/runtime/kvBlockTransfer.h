@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/blockCopyBatch.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+#include "tensorrt_llm/runtime/ncclCommunicator.h"
+
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Moves KV cache blocks between instances, e.g. from a context-phase executor to a generation-phase one.
+//! \details Blocks are gathered into a contiguous staging buffer with one batched copy kernel and sent with a single
+//! NCCL message per chunk. NCCL picks the transport: CUDA IPC / NVLink within a node and RDMA across nodes. The
+//! receiver scatters the chunk into its own blocks, so the two sides do not need matching block ids or pool layouts,
+//! only the same block size and the same number of blocks.
+class KvBlockTransfer
+{
+public:
+    using CudaStreamPtr = std::shared_ptr<CudaStream>;
+    using EventPtr = BlockCopyBatch::EventPtr;
+
+    //! \param comm Communicator containing both instances.
+    //! \param blockSizeInBytes Size of one block, K and V of all layers.
+    //! \param maxBlocksPerMessage Number of blocks staged and sent at once.
+    //! \param stream Stream the copies and the communication are issued on.
+    KvBlockTransfer(std::shared_ptr<NcclCommunicator> comm, std::size_t blockSizeInBytes,
+        SizeType32 maxBlocksPerMessage, CudaStreamPtr stream);
+
+    //! \brief Send the blocks at `blockPointers`, in order, to `peer`.
+    //! \return Event recorded after the last message was sent.
+    EventPtr send(std::vector<void*> const& blockPointers, int peer);
+
+    //! \brief Receive blocks from `peer`, in order, into `blockPointers`.
+    //! \return Event recorded after the last block was written.
+    EventPtr receive(std::vector<void*> const& blockPointers, int peer);
+
+private:
+    std::shared_ptr<NcclCommunicator> mComm;
+    std::size_t mBlockSizeInBytes;
+    SizeType32 mMaxBlocksPerMessage;
+    CudaStreamPtr mStream;
+    BlockCopyBatch mCopies;
+    IBuffer::SharedPtr mStaging;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -15,6 +15,8 @@
  */
 
 #include "tensorrt_llm/runtime/layerProfiler.h"
+#include "tensorrt_llm/common/logger.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <numeric>
@@ -42,6 +44,76 @@ void LayerProfiler::reportLayerTime(char const* layerName, float timeMs) noexcep
 
     mIterator->timeMs.push_back(timeMs);
     ++mIterator;
+
+    if (mTimelineEnabled)
+    {
+        auto const durationUs = static_cast<double>(timeMs) * 1000.0;
+        if (mTimeline.getNumEvents() < mMaxTimelineEvents)
+        {
+            mTimeline.addEvent(layerName, "layer", 0, mContextId, mNextStartUs, durationUs,
+                {{"iteration", static_cast<std::int64_t>(mIterationId)}});
+        }
+        else
+        {
+            ++mNumDroppedEvents;
+        }
+        mNextStartUs += durationUs;
+        if (static_cast<std::size_t>(mContextId) >= mContextEndUs.size())
+        {
+            mContextEndUs.resize(mContextId + 1, 0.0);
+        }
+        mContextEndUs[mContextId] = mNextStartUs;
+    }
+}
+
+void LayerProfiler::enableTimeline(std::size_t maxEvents)
+{
+    mTimelineEnabled = true;
+    mMaxTimelineEvents = maxEvents;
+    mNumDroppedEvents = 0;
+    mTimeline.clear();
+    mContextEndUs.clear();
+    mTimelineStart = std::chrono::steady_clock::now();
+}
+
+void LayerProfiler::beginReport(SizeType32 contextId) noexcept
+{
+    mContextId = contextId;
+    if (mTimelineEnabled)
+    {
+        if (static_cast<std::size_t>(contextId) >= mContextEndUs.size())
+        {
+            for (auto id = static_cast<SizeType32>(mContextEndUs.size()); id <= contextId; ++id)
+            {
+                mTimeline.setThreadName(0, id, "context " + std::to_string(id));
+            }
+            mContextEndUs.resize(contextId + 1, 0.0);
+        }
+        auto const nowUs
+            = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - mTimelineStart).count();
+        // Reports of a context must not overlap, even if they come faster than the layers ran.
+        mNextStartUs = std::max(nowUs, mContextEndUs[contextId]);
+    }
+}
+
+void LayerProfiler::warnDroppedEvents() const
+{
+    if (mNumDroppedEvents > 0)
+    {
+        TLLM_LOG_WARNING("Layer timeline is full, dropped %zu layer events", mNumDroppedEvents);
+    }
+}
+
+std::string LayerProfiler::getChromeTrace() const
+{
+    warnDroppedEvents();
+    return mTimeline.toJson();
+}
+
+void LayerProfiler::writeChromeTrace(std::filesystem::path const& path) const
+{
+    warnDroppedEvents();
+    mTimeline.write(path);
 }
 
 float LayerProfiler::getTotalTime() const noexcept
@@ -51,6 +123,22 @@ float LayerProfiler::getTotalTime() const noexcept
     return std::accumulate(mLayers.begin(), mLayers.end(), 0.0F, plusLayerTime);
 }
 
+std::vector<std::pair<std::string, float>> LayerProfiler::getLayerTimes() const
+{
+    std::vector<std::pair<std::string, float>> layerTimes;
+    std::unordered_map<std::string, std::size_t> layerIndices;
+    for (auto const& p : mLayers)
+    {
+        auto const [it, inserted] = layerIndices.try_emplace(p.name, layerTimes.size());
+        if (inserted)
+        {
+            layerTimes.emplace_back(p.name, 0.F);
+        }
+        layerTimes[it->second].second += std::accumulate(p.timeMs.begin(), p.timeMs.end(), 0.F);
+    }
+    return layerTimes;
+}
+
 std::string LayerProfiler::getLayerProfile() noexcept
 {
     std::string const nameHdr("   Layer");
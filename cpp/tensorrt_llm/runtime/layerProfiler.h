@@ -16,7 +16,13 @@
 
 #pragma once
 
+#include "tensorrt_llm/common/chromeTrace.h"
 #include "tensorrt_llm/runtime/common.h"
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include <NvInfer.h>
@@ -37,11 +43,47 @@ public:
 
     std::string getLayerProfile() noexcept;
 
+    //! \brief Total time of every layer since the last getLayerProfile, in the order the layers are reported.
+    [[nodiscard]] std::vector<std::pair<std::string, float>> getLayerTimes() const;
+
+    static constexpr std::size_t kDefaultMaxTimelineEvents{std::size_t{1} << 20};
+
+    //! \brief Also record the layer times of every report as a timeline, with at most `maxEvents` layer events.
+    void enableTimeline(std::size_t maxEvents = kDefaultMaxTimelineEvents);
+
+    //! \brief Set the iteration of the reports that follow.
+    void setIteration(std::uint64_t iterationId) noexcept
+    {
+        mIterationId = iterationId;
+    }
+
+    //! \brief Set the execution context of the layer times reported next.
+    //! \details The layers of a report are laid out back to back from the time of the report, TensorRT only reports
+    //! their durations.
+    void beginReport(SizeType32 contextId) noexcept;
+
+    //! \brief The timeline in Chrome trace format, one track per execution context.
+    [[nodiscard]] std::string getChromeTrace() const;
+
+    void writeChromeTrace(std::filesystem::path const& path) const;
+
 private:
     [[nodiscard]] float getTotalTime() const noexcept;
 
+    void warnDroppedEvents() const;
+
     std::vector<LayerProfile> mLayers;
     std::vector<LayerProfile>::iterator mIterator{mLayers.begin()};
     int32_t mUpdatesCount{0};
+
+    bool mTimelineEnabled{false};
+    std::size_t mMaxTimelineEvents{kDefaultMaxTimelineEvents};
+    std::size_t mNumDroppedEvents{0};
+    common::ChromeTrace mTimeline;
+    std::chrono::steady_clock::time_point mTimelineStart;
+    std::uint64_t mIterationId{0};
+    SizeType32 mContextId{0};
+    double mNextStartUs{0};
+    std::vector<double> mContextEndUs;
 };
 } // namespace tensorrt_llm::runtime
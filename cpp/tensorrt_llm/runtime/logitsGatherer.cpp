@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/logitsGatherer.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+LogitsGatherer::LogitsGatherer(BufferManager const& manager)
+    : mManager{manager}
+{
+}
+
+ITensor::SharedPtr LogitsGatherer::gather(
+    ITensor const& logits, std::vector<SizeType32> const& rows, MemoryType memoryType) const
+{
+    checkRows(logits, rows);
+    auto const& shape = logits.getShape();
+    auto const vocabSizePadded = static_cast<SizeType32>(shape.d[shape.nbDims - 1]);
+
+    auto const numGathered = static_cast<SizeType32>(rows.size());
+    TensorPtr gathered = mManager.gpu(ITensor::makeShape({numGathered, vocabSizePadded}), logits.getDataType());
+    if (numGathered > 0)
+    {
+        std::vector<SizeType32> srcOffsets(rows.size());
+        std::vector<SizeType32> dstOffsets(rows.size());
+        for (std::size_t i = 0; i < rows.size(); ++i)
+        {
+            srcOffsets[i] = rows[i] * vocabSizePadded;
+            dstOffsets[i] = static_cast<SizeType32>(i) * vocabSizePadded;
+        }
+        std::vector<SizeType32> const sizes(rows.size(), vocabSizePadded);
+        auto const srcOffsetsDevice = mManager.copyFrom(srcOffsets, MemoryType::kGPU);
+        auto const dstOffsetsDevice = mManager.copyFrom(dstOffsets, MemoryType::kGPU);
+        auto const sizesDevice = mManager.copyFrom(sizes, MemoryType::kGPU);
+        kernels::invokeCopyBatch(logits, *gathered, *srcOffsetsDevice, *dstOffsetsDevice, *sizesDevice,
+            static_cast<std::size_t>(vocabSizePadded), mManager.getStream());
+    }
+    if (memoryType == MemoryType::kGPU)
+    {
+        return gathered;
+    }
+    return mManager.copyFrom(*gathered, memoryType);
+}
+
+ITensor::SharedPtr LogitsGatherer::gatherLogProbs(ITensor const& logits, std::vector<SizeType32> const& rows,
+    std::vector<TokenIdType> const& tokenIds, SizeType32 vocabSize, MemoryType memoryType) const
+{
+    checkRows(logits, rows);
+    TLLM_CHECK_WITH_INFO(tokenIds.size() == rows.size(), "Expected one token per row");
+    for (auto const tokenId : tokenIds)
+    {
+        TLLM_CHECK_WITH_INFO(tokenId >= 0 && tokenId < vocabSize, "Token %d is out of the vocabulary", tokenId);
+    }
+
+    TensorPtr logProbs
+        = mManager.gpu(ITensor::makeShape({static_cast<SizeType32>(rows.size())}), nvinfer1::DataType::kFLOAT);
+    if (!rows.empty())
+    {
+        auto const rowsDevice = mManager.copyFrom(rows, ITensor::makeShape({static_cast<SizeType32>(rows.size())}),
+            MemoryType::kGPU);
+        auto const tokenIdsDevice = mManager.copyFrom(
+            tokenIds, ITensor::makeShape({static_cast<SizeType32>(tokenIds.size())}), MemoryType::kGPU);
+        kernels::gatherTokenLogProbs(*logProbs, logits, *rowsDevice, *tokenIdsDevice, vocabSize, mManager.getStream());
+    }
+    if (memoryType == MemoryType::kGPU)
+    {
+        return logProbs;
+    }
+    return mManager.copyFrom(*logProbs, memoryType);
+}
+
+void LogitsGatherer::checkRows(ITensor const& logits, std::vector<SizeType32> const& rows)
+{
+    auto const& shape = logits.getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims >= 2, "Logits must have a vocabulary dimension");
+    // The offsets of the rows are 32 bit
+    TLLM_CHECK_WITH_INFO(logits.getSize() <= static_cast<std::size_t>(std::numeric_limits<SizeType32>::max()),
+        "Logits of %zu elements are too large to gather", logits.getSize());
+    auto const numRows = static_cast<std::size_t>(logits.getSize() / shape.d[shape.nbDims - 1]);
+    for (auto const row : rows)
+    {
+        TLLM_CHECK_WITH_INFO(row >= 0 && static_cast<std::size_t>(row) < numRows,
+            "Row %d is out of the %zu rows of the logits", row, numRows);
+    }
+}
+
+std::vector<SizeType32> LogitsGatherer::getContextRows(ITensor const& contextLogits,
+    std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, std::vector<SizeType32> const& positions)
+{
+    TLLM_CHECK(batchIdx >= 0 && static_cast<std::size_t>(batchIdx) < inputLengths.size());
+    auto const& shape = contextLogits.getShape();
+    auto const packed = shape.nbDims == 2;
+    auto const firstRow = packed
+        ? std::accumulate(inputLengths.begin(), inputLengths.begin() + batchIdx, SizeType32{0})
+        : batchIdx * static_cast<SizeType32>(shape.d[1]);
+    auto const inputLength = inputLengths[batchIdx];
+
+    std::vector<SizeType32> rows;
+    rows.reserve(positions.size());
+    for (auto const position : positions)
+    {
+        TLLM_CHECK_WITH_INFO(position >= 0 && position < inputLength,
+            "Position %d is out of the prompt of length %d", position, inputLength);
+        rows.push_back(firstRow + position);
+    }
+    return rows;
+}
+
+std::vector<SizeType32> LogitsGatherer::getLastContextRows(ITensor const& contextLogits,
+    std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, SizeType32 numPositions)
+{
+    TLLM_CHECK(batchIdx >= 0 && static_cast<std::size_t>(batchIdx) < inputLengths.size());
+    auto const inputLength = inputLengths[batchIdx];
+    auto const begin = std::max(inputLength - numPositions, SizeType32{0});
+    std::vector<SizeType32> positions(inputLength - begin);
+    std::iota(positions.begin(), positions.end(), begin);
+    return getContextRows(contextLogits, inputLengths, batchIdx, positions);
+}
+
+std::vector<SizeType32> LogitsGatherer::getScoringRows(ITensor const& contextLogits,
+    std::vector<SizeType32> const& inputLengths, SizeType32 batchIdx, SizeType32 begin)
+{
+    TLLM_CHECK(batchIdx >= 0 && static_cast<std::size_t>(batchIdx) < inputLengths.size());
+    auto const inputLength = inputLengths[batchIdx];
+    TLLM_CHECK_WITH_INFO(begin > 0 && begin <= inputLength, "The first scored token must follow a prompt token");
+    std::vector<SizeType32> positions(inputLength - begin);
+    std::iota(positions.begin(), positions.end(), begin - 1);
+    return getContextRows(contextLogits, inputLengths, batchIdx, positions);
+}
+
+std::vector<SizeType32> LogitsGatherer::getGenerationRows(
+    ITensor const& generationLogits, SizeType32 batchIdx, SizeType32 beam, std::vector<SizeType32> const& steps)
+{
+    auto const& shape = generationLogits.getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 4, "Generation logits must be [batchSize, beamWidth, maxOutputLength, vocab]");
+    auto const beamWidth = static_cast<SizeType32>(shape.d[1]);
+    auto const maxOutputLength = static_cast<SizeType32>(shape.d[2]);
+    TLLM_CHECK(batchIdx >= 0 && batchIdx < shape.d[0]);
+    TLLM_CHECK(beam >= 0 && beam < beamWidth);
+    auto const firstRow = (batchIdx * beamWidth + beam) * maxOutputLength;
+
+    std::vector<SizeType32> rows;
+    rows.reserve(steps.size());
+    for (auto const step : steps)
+    {
+        TLLM_CHECK_WITH_INFO(
+            step >= 0 && step < maxOutputLength, "Step %d is out of the %d generated steps", step, maxOutputLength);
+        rows.push_back(firstRow + step);
+    }
+    return rows;
+}
+
+} // namespace tensorrt_llm::runtime
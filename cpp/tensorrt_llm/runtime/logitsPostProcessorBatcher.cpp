@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/logitsPostProcessorBatcher.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+
+namespace tensorrt_llm::runtime
+{
+
+LogitsPostProcessorBatcher::LogitsPostProcessorBatcher(SizeType32 maxNumSlots, Callback callback)
+    : mMaxNumSlots{maxNumSlots}
+    , mCallback{std::move(callback)}
+{
+    TLLM_CHECK(mMaxNumSlots > 0);
+    TLLM_CHECK_WITH_INFO(static_cast<bool>(mCallback), "Undefined logits post-processor");
+    mFreeSlots.reserve(mMaxNumSlots);
+    for (auto slot = mMaxNumSlots - 1; slot >= 0; --slot)
+    {
+        mFreeSlots.push_back(slot);
+    }
+}
+
+executor::LogitsPostProcessorBatched LogitsPostProcessorBatcher::getLogitsPostProcessorBatched()
+{
+    return [this](std::vector<RequestIdType> const& requestIds, std::vector<executor::Tensor>& logits,
+               BeamTokensRefs const& beamTokens, executor::StreamPtr const& stream)
+    { (*this)(requestIds, logits, beamTokens, stream); };
+}
+
+void LogitsPostProcessorBatcher::operator()(std::vector<RequestIdType> const& requestIds,
+    std::vector<executor::Tensor>& logits, BeamTokensRefs const& beamTokens, executor::StreamPtr const& stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(requestIds.size() == logits.size() && requestIds.size() == beamTokens.size(),
+        "Expected one logits tensor and one set of beam tokens per request");
+    if (requestIds.empty())
+    {
+        return;
+    }
+    auto const slots = acquireSlots(requestIds);
+
+    auto const numRequests = static_cast<SizeType32>(requestIds.size());
+    auto const& first = executor::detail::toITensor(logits.front());
+    auto const& rowShape = first->getShape();
+    TLLM_CHECK_WITH_INFO(rowShape.nbDims >= 1, "Logits must have a vocabulary dimension");
+    auto const vocabSizePadded = rowShape.d[rowShape.nbDims - 1];
+    auto const rowSize = first->getSize();
+    auto const dataType = first->getDataType();
+    auto const rowSizeInBytes = first->getSizeInBytes();
+    auto const shape
+        = ITensor::makeShape({numRequests, static_cast<SizeType32>(rowSize / vocabSizePadded), vocabSizePadded});
+
+    std::vector<void*> rows(numRequests);
+    auto contiguous = true;
+    for (SizeType32 i = 0; i < numRequests; ++i)
+    {
+        auto const& row = executor::detail::toITensor(logits[i]);
+        TLLM_CHECK_WITH_INFO(row->getMemoryType() == MemoryType::kGPU, "Logits must be on the device");
+        TLLM_CHECK_WITH_INFO(row->getDataType() == dataType && row->getSize() == rowSize,
+            "Logits of all requests must have the same type and shape");
+        rows[i] = row->data();
+        contiguous = contiguous && rows[i] == static_cast<std::uint8_t*>(rows.front()) + i * rowSizeInBytes;
+    }
+
+    if (contiguous)
+    {
+        auto batchLogits = ITensor::wrap(rows.front(), dataType, shape);
+        mCallback(requestIds, slots, *batchLogits, beamTokens, *stream);
+    }
+    else
+    {
+        BufferManager const manager{stream};
+        if (!mScratch || mScratch->getDataType() != dataType)
+        {
+            mScratch = manager.gpu(shape, dataType);
+        }
+        else
+        {
+            // Reallocates only if the batch is larger than any before
+            mScratch->reshape(shape);
+        }
+        auto& batchLogits = mScratch;
+
+        // The rows of the requests, then the rows of the scratch buffer
+        rows.resize(2 * numRequests);
+        for (SizeType32 i = 0; i < numRequests; ++i)
+        {
+            rows[numRequests + i] = static_cast<std::uint8_t*>(batchLogits->data()) + i * rowSizeInBytes;
+        }
+        auto const pointers = manager.copyFrom(rows, MemoryType::kGPU);
+        auto const requestRows = IBuffer::slice(pointers, 0, numRequests);
+        auto const scratchRows = IBuffer::slice(pointers, numRequests, numRequests);
+
+        kernels::invokeCopyBlocks(*requestRows, *scratchRows, rowSizeInBytes, *stream);
+        mCallback(requestIds, slots, *batchLogits, beamTokens, *stream);
+        kernels::invokeCopyBlocks(*scratchRows, *requestRows, rowSizeInBytes, *stream);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        ++mStats.numCalls;
+        ++(contiguous ? mStats.numViews : mStats.numGathers);
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+std::vector<SizeType32> LogitsPostProcessorBatcher::acquireSlots(std::vector<RequestIdType> const& requestIds)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const numNew = std::count_if(requestIds.begin(), requestIds.end(),
+        [this](RequestIdType requestId) { return mSlots.find(requestId) == mSlots.end(); });
+    TLLM_CHECK_WITH_INFO(static_cast<std::size_t>(numNew) <= mFreeSlots.size(),
+        "No free slot for %ld new requests, %d of %d slots are used. Release the slots of finished requests.", numNew,
+        static_cast<SizeType32>(mSlots.size()), mMaxNumSlots);
+    std::vector<SizeType32> slots;
+    slots.reserve(requestIds.size());
+    for (auto const requestId : requestIds)
+    {
+        auto it = mSlots.find(requestId);
+        if (it == mSlots.end())
+        {
+            it = mSlots.emplace(requestId, mFreeSlots.back()).first;
+            mFreeSlots.pop_back();
+        }
+        slots.push_back(it->second);
+    }
+    return slots;
+}
+
+void LogitsPostProcessorBatcher::release(RequestIdType requestId)
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const it = mSlots.find(requestId);
+    if (it == mSlots.end())
+    {
+        return;
+    }
+    // Keep the lowest free slot last, so that the used slots stay dense
+    auto const pos = std::upper_bound(mFreeSlots.begin(), mFreeSlots.end(), it->second, std::greater<>());
+    mFreeSlots.insert(pos, it->second);
+    mSlots.erase(it);
+}
+
+SizeType32 LogitsPostProcessorBatcher::getSlot(RequestIdType requestId) const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    auto const it = mSlots.find(requestId);
+    return it == mSlots.end() ? -1 : it->second;
+}
+
+SizeType32 LogitsPostProcessorBatcher::getNumUsedSlots() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return static_cast<SizeType32>(mSlots.size());
+}
+
+LogitsPostProcessorBatcher::Stats LogitsPostProcessorBatcher::getStats() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mStats;
+}
+
+} // namespace tensorrt_llm::runtime
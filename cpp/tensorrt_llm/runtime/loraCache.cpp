@@ -24,9 +24,14 @@
 #include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/runtime/loraUtils.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <tuple>
@@ -60,6 +65,7 @@ void LoraCachePageManager::initialize(BufferManager const& bufferManager)
     TLLM_LOG_DEBUG("%s start", __PRETTY_FUNCTION__);
 
     TLLM_LOG_DEBUG("pageConfig: " + to_string(mConfig));
+    MemoryTimeline::ScopedTag const memoryTag{MemoryTimeline::Tag::kLORA};
 
     std::size_t pageIdx = 0;
     while (pageIdx < static_cast<size_t>(mConfig.getTotalNumPages()))
@@ -146,6 +152,16 @@ ITensor::SharedPtr LoraCachePageManager::mutablePagePtr(std::size_t pageIdx)
 }
 
 void LoraCache::put(TaskIdType taskId, TensorPtr sourceWeights, TensorPtr sourceConfig, bool load)
+{
+    putTask(taskId, std::move(sourceWeights), std::move(sourceConfig), load, false);
+}
+
+void LoraCache::prefetch(TaskIdType taskId, TensorPtr sourceWeights, TensorPtr sourceConfig)
+{
+    putTask(taskId, std::move(sourceWeights), std::move(sourceConfig), true, true);
+}
+
+void LoraCache::putTask(TaskIdType taskId, TensorPtr sourceWeights, TensorPtr sourceConfig, bool load, bool prefetch)
 {
     TLLM_LOG_DEBUG("%s start", __PRETTY_FUNCTION__);
 
@@ -154,15 +170,19 @@ void LoraCache::put(TaskIdType taskId, TensorPtr sourceWeights, TensorPtr source
         std::lock_guard<std::mutex> cacheLock(mCacheMutex);
         if (kVALUE_STATUS_MISSING != getStatus(taskId))
         {
-            bumpTaskInProgress(taskId);
+            if (!prefetch)
+            {
+                bumpTaskInProgress(taskId);
+            }
             return std::nullopt;
         }
 
+        // A prefetched task is done once loaded, unless it is put meanwhile which resets done
         mInProgressTasks.push_front(taskId);
         TaskValuePtr cacheV = std::make_shared<TaskValue>(std::vector<std::size_t>{}, TaskLayerModuleConfigListPtr(),
-            mInProgressTasks.begin(), true, false, false, true);
-        mCacheMap.try_emplace(taskId, std::move(cacheV));
-        return mCacheMap.at(taskId);
+            mInProgressTasks.begin(), true, false, prefetch, true);
+        insertTask(taskId, cacheV);
+        return cacheV;
     }();
     if (!taskValuePtr)
     {
@@ -190,7 +210,7 @@ void LoraCache::put(TaskIdType taskId, TensorPtr sourceWeights, TensorPtr source
     {
         std::lock_guard<std::mutex> lk(mCacheMutex);
         mInProgressTasks.erase(taskValue->it);
-        mCacheMap.erase(taskId);
+        eraseTask(taskId);
         throw e;
     }
 
@@ -233,7 +253,7 @@ void LoraCache::loadWeights(TaskIdType taskId, TensorPtr sourceWeights, TensorPt
             return std::nullopt;
         }
 
-        auto taskValue = mCacheMap.at(taskId);
+        auto taskValue = findTask(taskId);
         if (taskValue->loadInProgress)
         {
             return std::nullopt;
@@ -313,7 +333,7 @@ std::vector<std::size_t> LoraCache::claimPagesWithEvict(SizeType32 numPages)
     {
         auto const taskId = *it;
         taskIdsToEvict.push_back(taskId);
-        auto const& taskValue = *(mCacheMap.at(taskId));
+        auto const& taskValue = *(findTask(taskId));
         pageIdsToEvict.insert(pageIdsToEvict.end(), taskValue.pageIds.begin(), taskValue.pageIds.end());
         neededPages -= taskValue.pageIds.size();
     }
@@ -328,7 +348,7 @@ std::vector<std::size_t> LoraCache::claimPagesWithEvict(SizeType32 numPages)
 
         TLLM_LOG_DEBUG("evicting taskId" + std::to_string(taskIdsToEvict.at(i)));
         mDoneTasks.pop_back();
-        mCacheMap.erase(taskIdsToEvict.at(i));
+        eraseTask(taskIdsToEvict.at(i));
     }
     mCachePageManager->releasePages(pageIdsToEvict);
     auto pageIds = mCachePageManager->claimPages(numPages);
@@ -342,11 +362,12 @@ void LoraCache::markTaskDone(TaskIdType taskId)
     TLLM_LOG_DEBUG("%s start", __PRETTY_FUNCTION__);
     TLLM_LOG_DEBUG("markTaskDone " + std::to_string(taskId));
     std::lock_guard<std::mutex> lock(mCacheMutex);
-    if (mCacheMap.find(taskId) == mCacheMap.end())
+    auto const taskValuePtr = findTask(taskId);
+    if (!taskValuePtr)
     {
         return;
     }
-    auto& taskValue = *(mCacheMap.at(taskId));
+    auto& taskValue = *taskValuePtr;
     bool inProgress = taskValue.inProgress;
     bool loaded = taskValue.loaded;
     if (inProgress)
@@ -371,7 +392,7 @@ void LoraCache::markAllDone()
     {
         nit = std::next(it);
         auto taskId = *it;
-        auto& taskValue = *(mCacheMap.at(*it));
+        auto& taskValue = *(findTask(*it));
         bool inProgress = taskValue.inProgress;
         bool loaded = taskValue.loaded;
         if (inProgress && loaded)
@@ -395,7 +416,7 @@ std::shared_ptr<std::vector<LoraCache::TaskLayerModuleConfig>> LoraCache::get(Ta
     }
 
     bumpTaskInProgress(taskId);
-    return mCacheMap.at(taskId)->configs;
+    return findTask(taskId)->configs;
 }
 
 void LoraCache::bump(TaskIdType taskId)
@@ -406,10 +427,10 @@ void LoraCache::bump(TaskIdType taskId)
 
 void LoraCache::bumpTaskInProgress(TaskIdType taskId)
 {
-    auto it = mCacheMap.find(taskId);
-    if (it != mCacheMap.end())
+    auto const taskValuePtr = findTask(taskId);
+    if (taskValuePtr)
     {
-        auto& taskValue = *(it->second);
+        auto& taskValue = *taskValuePtr;
         if (taskValue.inProgress)
         {
             mInProgressTasks.erase(taskValue.it);
@@ -427,10 +448,10 @@ void LoraCache::bumpTaskInProgress(TaskIdType taskId)
 
 LoraCache::ValueStatus LoraCache::getStatus(TaskIdType taskId) const
 {
-    auto it = mCacheMap.find(taskId);
-    if (it != mCacheMap.end())
+    auto const taskValue = getTaskMap().find(taskId);
+    if (taskValue)
     {
-        return it->second->loaded ? kVALUE_STATUS_LOADED : kVALUE_STATUS_PROCESSING;
+        return taskValue->loaded ? kVALUE_STATUS_LOADED : kVALUE_STATUS_PROCESSING;
     }
     return kVALUE_STATUS_MISSING;
 }
@@ -443,7 +464,7 @@ SizeType32 LoraCache::determineNumPages(TaskIdType taskId) const
         throw std::runtime_error("task " + std::to_string(taskId) + " not found in cache call put first");
     }
 
-    return mCacheMap.at(taskId)->pageIds.size();
+    return findTask(taskId)->pageIds.size();
 }
 
 SizeType32 LoraCache::determineNumPages(TensorPtr loraConfig) const
@@ -486,6 +507,11 @@ LoraCache::LoraCache(LoraCachePageManagerConfig const& pageManagerConfig, ModelC
     , mModelConfig(modelConfig)
     , mWorldConfig(worldConfig)
 {
+    {
+        std::unique_lock<std::shared_mutex> lock(getTaskMapsMutex());
+        getTaskMaps<TaskMap>()[this] = std::make_shared<TaskMap>();
+    }
+
     mCachePageManager = std::make_unique<LoraCachePageManager>(mPageManagerConfig, bufferManager);
 
     auto modules = modelConfig.getLoraModules();
@@ -514,12 +540,9 @@ void LoraCache::splitTransposeCpuInner(ITensor& output, ITensor const& input, Si
 
     for (SizeType32 adapterIdx = 0; adapterIdx < adapterSize; ++adapterIdx)
     {
-        for (SizeType32 hiddenIdx = 0; hiddenIdx < splitHiddenSize; ++hiddenIdx)
-        {
-            auto outputIdx = common::flat_index2(adapterIdx, hiddenIdx, splitHiddenSize);
-            auto inputIdx = common::flat_index2(adapterIdx, hiddenIdx + tpRank * splitHiddenSize, hiddenSize);
-            outputPtr[outputIdx] = inputPtr[inputIdx];
-        }
+        auto const outputIdx = common::flat_index2(adapterIdx, 0, splitHiddenSize);
+        auto const inputIdx = common::flat_index2(adapterIdx, tpRank * splitHiddenSize, hiddenSize);
+        std::copy_n(inputPtr + inputIdx, splitHiddenSize, outputPtr + outputIdx);
     }
 }
 
@@ -545,6 +568,29 @@ void LoraCache::splitTransposeCpu(ITensor& output, ITensor const& input, SizeTyp
     TLLM_LOG_DEBUG("%s stop", __PRETTY_FUNCTION__);
 }
 
+void LoraCache::splitTranspose(
+    ITensor& output, ITensor const& input, SizeType32 tpSize, SizeType32 tpRank, BufferManager const& manager)
+{
+    TLLM_LOG_DEBUG("%s start", __PRETTY_FUNCTION__);
+
+    if (input.getMemoryType() != MemoryType::kGPU && output.getMemoryType() != MemoryType::kGPU)
+    {
+        splitTransposeCpu(output, input, tpSize, tpRank);
+    }
+    else if (output.getSizeInBytes() > 0)
+    {
+        // One strided copy of the split columns of all rows
+        auto const adapterSize = static_cast<std::size_t>(input.getShape().d[0]);
+        auto const rowBytes = input.getSizeInBytes() / adapterSize;
+        auto const splitRowBytes = rowBytes / tpSize;
+        auto const* src = static_cast<std::uint8_t const*>(input.data()) + tpRank * splitRowBytes;
+        TLLM_CUDA_CHECK(cudaMemcpy2DAsync(output.data(), splitRowBytes, src, rowBytes, splitRowBytes, adapterSize,
+            cudaMemcpyDefault, manager.getStream().get()));
+    }
+
+    TLLM_LOG_DEBUG("%s stop", __PRETTY_FUNCTION__);
+}
+
 std::vector<LoraCache::TaskLayerModuleConfig> LoraCache::copyToPages(TensorPtr sourceWeights, TensorPtr sourceConfig,
     ModelConfig const& modelConfig, WorldConfig const& worldConfig,
     std::unordered_map<SizeType32, LoraModule> moduleIdToModule, BufferManager const& manager,
@@ -663,7 +709,7 @@ std::vector<LoraCache::TaskLayerModuleConfig> LoraCache::copyToPages(TensorPtr s
             }
             else
             {
-                splitTransposeCpu(*targetWeightsIn, *weightsIn, tpSize, tpRank);
+                splitTranspose(*targetWeightsIn, *weightsIn, tpSize, tpRank, manager);
             }
 
             if (!splitOut)
@@ -751,7 +797,7 @@ void LoraCache::copyTask(TaskIdType taskId, LoraCache& deviceCache, bool markDon
         {
             throw std::runtime_error("can't move a missing task" + std::to_string(taskId));
         }
-        auto taskValue = mCacheMap.at(taskId);
+        auto taskValue = findTask(taskId);
         // mark task unloaded so we can evict the task while the copy in in progress
         taskValue->loaded = false;
         bumpTaskInProgress(taskId);
@@ -777,8 +823,8 @@ void LoraCache::copyTask(TaskIdType taskId, LoraCache& deviceCache, bool markDon
         deviceCache.mInProgressTasks.push_front(taskId);
         auto cacheV = std::make_shared<TaskValue>(std::vector<std::size_t>{}, TaskLayerModuleConfigListPtr(),
             deviceCache.mInProgressTasks.begin(), true, false, markDone, true);
-        deviceCache.mCacheMap.try_emplace(taskId, std::move(cacheV));
-        auto otherTaskValue = deviceCache.mCacheMap.at(taskId);
+        deviceCache.insertTask(taskId, cacheV);
+        auto otherTaskValue = cacheV;
         // TODO (grclark) return shared_ptr
         return otherTaskValue;
     }();
@@ -798,7 +844,7 @@ void LoraCache::copyTask(TaskIdType taskId, LoraCache& deviceCache, bool markDon
         {
             std::lock_guard<std::mutex> lk(deviceCache.mCacheMutex);
             deviceCache.mInProgressTasks.erase(otherTaskValue->it);
-            deviceCache.mCacheMap.erase(taskId);
+            deviceCache.eraseTask(taskId);
             taskValue->loaded = true;
             throw std::runtime_error("Couldn't claim pages during copyTask -- " + std::string(e.what()));
         }
@@ -879,6 +925,95 @@ bool LoraCache::fits(TensorPtr config) const
     return neededPages < availablePages;
 }
 
+class LoraCache::TaskMap
+{
+public:
+    //! \brief The task, or nullptr if it is not in the cache
+    [[nodiscard]] TaskValuePtr find(TaskIdType taskId) const
+    {
+        auto const& shard = getShard(taskId);
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        auto const it = shard.tasks.find(taskId);
+        return it != shard.tasks.end() ? it->second.lock() : nullptr;
+    }
+
+    void insert(TaskIdType taskId, TaskValuePtr const& taskValue)
+    {
+        auto& shard = getShard(taskId);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.tasks.insert_or_assign(taskId, taskValue);
+    }
+
+    void erase(TaskIdType taskId)
+    {
+        auto& shard = getShard(taskId);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.tasks.erase(taskId);
+    }
+
+private:
+    static constexpr std::size_t kNUM_SHARDS = 16;
+
+    // mCacheMap owns the tasks. The index does not, so the tasks of a cache destroyed by code that does not know the
+    // index are freed with it.
+    struct Shard
+    {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<TaskIdType, std::weak_ptr<TaskValue>> tasks;
+    };
+
+    [[nodiscard]] Shard& getShard(TaskIdType taskId) const
+    {
+        return mShards[taskId % kNUM_SHARDS];
+    }
+
+    mutable std::array<Shard, kNUM_SHARDS> mShards;
+};
+
+namespace
+{
+// The index of each LoraCache. An instance registers a new index when it is constructed, which also replaces the
+// index of a destroyed instance that had the same address.
+std::shared_mutex& getTaskMapsMutex()
+{
+    static std::shared_mutex mutex;
+    return mutex;
+}
+
+template <typename TaskMap>
+std::unordered_map<void const*, std::shared_ptr<TaskMap>>& getTaskMaps()
+{
+    static std::unordered_map<void const*, std::shared_ptr<TaskMap>> taskMaps;
+    return taskMaps;
+}
+} // namespace
+
+LoraCache::TaskMap& LoraCache::getTaskMap() const
+{
+    std::shared_lock<std::shared_mutex> lock(getTaskMapsMutex());
+    return *getTaskMaps<TaskMap>().at(this);
+}
+
+void LoraCache::insertTask(TaskIdType taskId, TaskValuePtr const& taskValue)
+{
+    if (mCacheMap.try_emplace(taskId, taskValue).second)
+    {
+        getTaskMap().insert(taskId, taskValue);
+    }
+}
+
+void LoraCache::eraseTask(TaskIdType taskId)
+{
+    getTaskMap().erase(taskId);
+    mCacheMap.erase(taskId);
+}
+
+LoraCache::TaskValuePtr LoraCache::findTask(TaskIdType taskId) const
+{
+    auto const it = mCacheMap.find(taskId);
+    return it != mCacheMap.end() ? it->second : nullptr;
+}
+
 std::string to_string(LoraCache::TaskLayerModuleConfig const& v)
 {
     std::stringstream sstream;
@@ -907,12 +1042,7 @@ bool LoraCache::TaskLayerModuleConfig::operator==(LoraCache::TaskLayerModuleConf
 
 bool LoraCache::isDone(TaskIdType taskId) const
 {
-    std::lock_guard<std::mutex> lk(mCacheMutex);
-    if (mCacheMap.count(taskId))
-    {
-        auto const taskValue = mCacheMap.at(taskId);
-        return !taskValue->inProgress;
-    }
-    return false;
+    auto const taskValue = getTaskMap().find(taskId);
+    return taskValue && !taskValue->inProgress;
 }
 } // namespace tensorrt_llm::runtime
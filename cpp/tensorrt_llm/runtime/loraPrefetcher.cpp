@@ -0,0 +1,142 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/loraPrefetcher.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/utils/numpyUtils.h"
+
+#include <chrono>
+#include <exception>
+#include <iterator>
+#include <string>
+#include <tuple>
+
+namespace tensorrt_llm::runtime
+{
+
+LoraPrefetcher::LoraPrefetcher(
+    LoraCache& hostCache, std::filesystem::path adapterDir, std::shared_ptr<WorkStealingPool> workerPool)
+    : mHostCache{hostCache}
+    , mAdapterDir{std::move(adapterDir)}
+    , mWorkerPool{std::move(workerPool)}
+{
+    TLLM_CHECK(mWorkerPool);
+}
+
+LoraPrefetcher::~LoraPrefetcher()
+{
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    for (auto const& [taskId, future] : mPending)
+    {
+        future.wait();
+    }
+}
+
+bool LoraPrefetcher::prefetch(TaskIdType taskId, TensorPtr weights, TensorPtr config)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    if (mHostCache.has(taskId))
+    {
+        return true;
+    }
+    if ((!weights || !config) && !isOnDisk(taskId))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mPendingMutex);
+    for (auto it = mPending.begin(); it != mPending.end();)
+    {
+        auto const finished = it->second.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+        it = finished ? mPending.erase(it) : std::next(it);
+    }
+    if (mPending.find(taskId) == mPending.end())
+    {
+        auto future = mWorkerPool->enqueue([this, taskId, weights = std::move(weights), config = std::move(config)]()
+            { load(taskId, weights, config); },
+            TaskPriority::kLOW);
+        mPending.emplace(taskId, future.share());
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return true;
+}
+
+bool LoraPrefetcher::isReady(TaskIdType taskId) const
+{
+    return mHostCache.isLoaded(taskId);
+}
+
+void LoraPrefetcher::wait(TaskIdType taskId)
+{
+    std::shared_future<void> future;
+    {
+        std::lock_guard<std::mutex> lock(mPendingMutex);
+        auto const it = mPending.find(taskId);
+        if (it == mPending.end())
+        {
+            return;
+        }
+        future = it->second;
+    }
+    future.wait();
+}
+
+bool LoraPrefetcher::isOnDisk(TaskIdType taskId) const
+{
+    if (mAdapterDir.empty())
+    {
+        return false;
+    }
+    auto const path = getAdapterPath(taskId);
+    return std::filesystem::exists(path / kWeightsFileName) && std::filesystem::exists(path / kConfigFileName);
+}
+
+std::pair<LoraPrefetcher::TensorPtr, LoraPrefetcher::TensorPtr> LoraPrefetcher::mapAdapter(TaskIdType taskId) const
+{
+    auto const path = getAdapterPath(taskId);
+    return {utils::mapNpy((path / kWeightsFileName).string()), utils::mapNpy((path / kConfigFileName).string())};
+}
+
+void LoraPrefetcher::load(TaskIdType taskId, TensorPtr weights, TensorPtr config)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    try
+    {
+        if (!weights || !config)
+        {
+            std::tie(weights, config) = mapAdapter(taskId);
+        }
+        mHostCache.prefetch(taskId, weights, config);
+    }
+    catch (LoraExpectedException const& e)
+    {
+        TLLM_LOG_DEBUG("Not prefetching LoRA task %lu: %s", taskId, e.what());
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_WARNING("Prefetching LoRA task %lu failed: %s", taskId, e.what());
+    }
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+std::filesystem::path LoraPrefetcher::getAdapterPath(TaskIdType taskId) const
+{
+    return mAdapterDir / std::to_string(taskId);
+}
+
+} // namespace tensorrt_llm::runtime
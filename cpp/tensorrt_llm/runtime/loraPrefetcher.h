@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/loraCache.h"
+#include "tensorrt_llm/runtime/workStealingPool.h"
+
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Loads the LoRA adapters of queued requests into a host LoraCache in the background.
+//! \details Adapters are taken from the request tensors or from an adapter directory, the slowest tier, which holds a
+//! subdirectory per task id with model.lora_weights.npy and model.lora_config.npy. The files are memory mapped, so
+//! the weights are only copied once, into the cache pages. Prefetched adapters stay evictable in LRU order until a
+//! scheduled request puts them. Prefetching is best effort, e.g. it is skipped when the cache is full of tasks in
+//! progress, in which case the adapter is loaded when the request is added as before. A scheduler can use isReady to
+//! prefer requests whose adapters are resident over stalling the batch on a copy.
+class LoraPrefetcher
+{
+public:
+    using TaskIdType = LoraCache::TaskIdType;
+    using TensorPtr = ITensor::SharedPtr;
+
+    static constexpr char const* kWeightsFileName = "model.lora_weights.npy";
+    static constexpr char const* kConfigFileName = "model.lora_config.npy";
+
+    //! \param hostCache Cache the adapters are loaded to, must outlive the prefetcher.
+    //! \param adapterDir Directory of the adapters on disk, empty if adapters are only given as tensors.
+    //! \param workerPool Pool running the loads with low priority.
+    LoraPrefetcher(
+        LoraCache& hostCache, std::filesystem::path adapterDir, std::shared_ptr<WorkStealingPool> workerPool);
+
+    //! \brief Waits for the pending loads.
+    ~LoraPrefetcher();
+
+    LoraPrefetcher(LoraPrefetcher const&) = delete;
+    LoraPrefetcher& operator=(LoraPrefetcher const&) = delete;
+
+    //! \brief Starts loading an adapter and returns immediately.
+    //! \param weights, config The adapter tensors of the request, or null to read the adapter from disk.
+    //! \returns false if the adapter is neither given nor on disk.
+    bool prefetch(TaskIdType taskId, TensorPtr weights = nullptr, TensorPtr config = nullptr);
+
+    //! \returns true if the adapter weights are in the host cache.
+    [[nodiscard]] bool isReady(TaskIdType taskId) const;
+
+    //! \brief Waits for a pending load of the adapter, if any.
+    void wait(TaskIdType taskId);
+
+    //! \returns true if the adapter directory holds the adapter.
+    [[nodiscard]] bool isOnDisk(TaskIdType taskId) const;
+
+    //! \returns The memory mapped weights and config of an adapter in the adapter directory.
+    [[nodiscard]] std::pair<TensorPtr, TensorPtr> mapAdapter(TaskIdType taskId) const;
+
+private:
+    void load(TaskIdType taskId, TensorPtr weights, TensorPtr config);
+
+    [[nodiscard]] std::filesystem::path getAdapterPath(TaskIdType taskId) const;
+
+    LoraCache& mHostCache;
+    std::filesystem::path const mAdapterDir;
+    std::shared_ptr<WorkStealingPool> mWorkerPool;
+
+    std::mutex mPendingMutex;
+    std::unordered_map<TaskIdType, std::shared_future<void>> mPending;
+};
+
+} // namespace tensorrt_llm::runtime
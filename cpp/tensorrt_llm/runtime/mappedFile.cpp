@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/mappedFile.h"
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace tensorrt_llm::runtime
+{
+
+MappedFile::MappedFile(std::filesystem::path const& path, SizeType32 numPrefetchThreads, std::size_t chunkSize)
+    : mPath{path}
+    , mFd{-1}
+    , mData{nullptr}
+    , mSize{0}
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK(numPrefetchThreads >= 0);
+    TLLM_CHECK(chunkSize > 0);
+#if defined(_WIN32)
+    TLLM_THROW("MappedFile is not supported on Windows");
+#else
+    mFd = ::open(mPath.c_str(), O_RDONLY | O_CLOEXEC);
+    TLLM_CHECK_WITH_INFO(mFd >= 0, "Error opening file %s: %s", mPath.string().c_str(), std::strerror(errno));
+    struct stat st;
+    if (::fstat(mFd, &st) != 0)
+    {
+        ::close(mFd);
+        TLLM_THROW("Error reading the size of %s: %s", mPath.string().c_str(), std::strerror(errno));
+    }
+    mSize = static_cast<std::size_t>(st.st_size);
+    TLLM_CHECK_WITH_INFO(mSize > 0, "File %s is empty", mPath.string().c_str());
+    mData = ::mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFd, 0);
+    if (mData == MAP_FAILED)
+    {
+        ::close(mFd);
+        TLLM_THROW("Error mapping %s: %s", mPath.string().c_str(), std::strerror(errno));
+    }
+    ::madvise(mData, mSize, MADV_SEQUENTIAL);
+
+    if (numPrefetchThreads > 0)
+    {
+        auto const start = std::chrono::steady_clock::now();
+        prefetch(numPrefetchThreads, chunkSize);
+        auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        TLLM_LOG_INFO("Prefetched %.2f GiB of %s in %.2f s with %d threads", static_cast<double>(mSize) / (1 << 30),
+            mPath.string().c_str(), seconds, numPrefetchThreads);
+    }
+#endif
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+MappedFile::~MappedFile()
+{
+#if !defined(_WIN32)
+    if (mData != nullptr)
+    {
+        ::munmap(mData, mSize);
+    }
+    if (mFd >= 0)
+    {
+        ::close(mFd);
+    }
+#endif
+}
+
+void MappedFile::prefetch(SizeType32 numThreads, std::size_t chunkSize) const
+{
+#if !defined(_WIN32)
+    // Chunk reads through the file descriptor fill the page cache, which backs the mapping.
+    auto const numChunks = (mSize + chunkSize - 1) / chunkSize;
+    std::atomic<std::size_t> nextChunk{0};
+    auto const readChunks = [this, chunkSize, numChunks, &nextChunk]()
+    {
+        constexpr std::size_t kReadSize = std::size_t{4} << 20;
+        std::vector<char> scratch(std::min(kReadSize, chunkSize));
+        for (auto chunk = nextChunk++; chunk < numChunks; chunk = nextChunk++)
+        {
+            auto offset = chunk * chunkSize;
+            auto const end = std::min(offset + chunkSize, mSize);
+            while (offset < end)
+            {
+                auto const numRead
+                    = ::pread(mFd, scratch.data(), std::min(scratch.size(), end - offset), static_cast<off_t>(offset));
+                if (numRead <= 0)
+                {
+                    if (numRead < 0 && errno == EINTR)
+                    {
+                        continue;
+                    }
+                    // The mapping still pages in on access, the prefetch is only an optimization.
+                    TLLM_LOG_WARNING("Prefetch of %s stopped: %s", mPath.string().c_str(), std::strerror(errno));
+                    return;
+                }
+                offset += static_cast<std::size_t>(numRead);
+            }
+        }
+    };
+    auto const numWorkers = std::min(static_cast<std::size_t>(numThreads), numChunks);
+    std::vector<std::thread> threads;
+    threads.reserve(numWorkers);
+    for (std::size_t i = 0; i < numWorkers; ++i)
+    {
+        threads.emplace_back(readChunks);
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+#endif
+}
+
+} // namespace tensorrt_llm::runtime
@@ -57,8 +57,10 @@ std::string MemoryCounters::bytesToString(DiffType bytes, int precision)
 
 std::string MemoryCounters::toString() const
 {
-    return tensorrt_llm::common::fmtstr("[MemUsage] GPU %s, CPU %s, Pinned %s", bytesToString(this->getGpu()).c_str(),
-        bytesToString(this->getCpu()).c_str(), bytesToString(this->getPinned()).c_str());
+    return tensorrt_llm::common::fmtstr("[MemUsage] GPU %s (cached %s, padding %s), CPU %s, Pinned %s",
+        bytesToString(this->getGpu()).c_str(), bytesToString(this->getGpuCached()).c_str(),
+        bytesToString(this->getGpuPadding()).c_str(), bytesToString(this->getCpu()).c_str(),
+        bytesToString(this->getPinned()).c_str());
 }
 
 void MemoryCounters::allocate(MemoryType memoryType, MemoryCounters::SizeType32 size)
@@ -0,0 +1,151 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryPlanner.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+double toMiB(std::size_t bytes)
+{
+    return static_cast<double>(bytes) / (1 << 20);
+}
+} // namespace
+
+std::string MemoryPlan::report() const
+{
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(1);
+    os << "weights " << toMiB(weightsBytes) << " MiB\n"
+       << "activations " << toMiB(activationBytes) << " MiB\n"
+       << "logits " << toMiB(logitsBytes) << " MiB\n"
+       << "reserved " << toMiB(reservedBytes) << " MiB\n"
+       << "kv_cache " << toMiB(kvCacheBytes) << " MiB (" << numKvBlocks << " blocks of " << kvBytesPerBlock
+       << " bytes)\n"
+       << "lora_cache " << toMiB(loraCacheBytes) << " MiB\n"
+       << "blocks_per_sequence " << blocksPerSequence << "\n"
+       << "max_batch_size " << maxBatchSize << (limitedByEngine ? " (engine limit)" : " (kv cache limit)") << "\n"
+       << "max_num_tokens " << maxNumTokens << "\n";
+    return os.str();
+}
+
+MemoryPlanner::MemoryPlanner(ModelConfig const& modelConfig, WorldConfig const& worldConfig)
+    : mModelConfig{modelConfig}
+    , mWorldConfig{worldConfig}
+{
+}
+
+std::size_t MemoryPlanner::getKvBytesPerBlock(nvinfer1::DataType kvCacheType, SizeType32 tokensPerBlock) const
+{
+    // Same volume as KVCacheManager::calculateCacheSizePerToken
+    auto const numLayers = mModelConfig.getNbAttentionLayers(mWorldConfig.getPipelineParallelism());
+    auto const elementsPerToken = static_cast<std::size_t>(numLayers) * 2 * mModelConfig.getNbKvHeads()
+        * mModelConfig.getSizePerHead();
+    return elementsPerToken * tokensPerBlock * BufferDataType(kvCacheType).getSize();
+}
+
+SizeType32 MemoryPlanner::getBlocksPerSequence(TrafficShape const& traffic, SizeType32 tokensPerBlock) const
+{
+    TLLM_CHECK_WITH_INFO(tokensPerBlock > 0, "Tokens per block must be positive");
+    auto const sequenceLength = std::min(traffic.inputLength + traffic.outputLength, mModelConfig.getMaxSequenceLen());
+    auto const sharedBlocks = std::min(traffic.inputLength, sequenceLength) / tokensPerBlock;
+    auto const beamBlocks = common::ceilDiv(sequenceLength, tokensPerBlock) - sharedBlocks;
+    return sharedBlocks + traffic.beamWidth * beamBlocks;
+}
+
+std::size_t MemoryPlanner::getLogitsBytes() const
+{
+    auto const vocabSizePadded = static_cast<std::size_t>(mModelConfig.getVocabSizePadded(mWorldConfig.getSize()));
+    auto const logitsSize = BufferDataType(mModelConfig.getLogitsDtype()).getSize();
+    auto const maxBatchSize = static_cast<std::size_t>(mModelConfig.getMaxBatchSize());
+    auto numRows = maxBatchSize * mModelConfig.getMaxBeamWidth() * mModelConfig.getMaxDecodingTokens();
+    if (mModelConfig.computeContextLogits())
+    {
+        auto const maxNumTokens = mModelConfig.getMaxNumTokens().value_or(
+            static_cast<SizeType32>(maxBatchSize * mModelConfig.getMaxInputLen()));
+        numRows = std::max<std::size_t>(numRows, maxNumTokens);
+    }
+    return numRows * vocabSizePadded * logitsSize;
+}
+
+std::size_t MemoryPlanner::getLoraBytes(SizeType32 numModuleLayers, SizeType32 adapterSize) const
+{
+    // A page row holds the rank row of the widest module, see PeftCacheManager::getPageManagerConfig
+    SizeType32 pageWidth = 0;
+    for (auto const& module : mModelConfig.getLoraModules())
+    {
+        pageWidth = std::max(pageWidth, module.localInOutSize(1, mWorldConfig.getTensorParallelism()));
+    }
+    return static_cast<std::size_t>(numModuleLayers) * adapterSize * pageWidth
+        * BufferDataType(mModelConfig.getDataType()).getSize();
+}
+
+MemoryPlan MemoryPlanner::plan(
+    EngineMemory const& engine, MemoryPlannerConfig const& config, TrafficShape const& traffic) const
+{
+    TLLM_CHECK_WITH_INFO(config.freeGpuMemoryFraction > 0.f && config.freeGpuMemoryFraction <= 1.f,
+        "freeGpuMemoryFraction must be in (0, 1]");
+    TLLM_CHECK_WITH_INFO(traffic.inputLength > 0 && traffic.outputLength > 0 && traffic.beamWidth > 0,
+        "The traffic shape needs positive lengths and beam width");
+
+    MemoryPlan plan{};
+    plan.weightsBytes = engine.weightsBytes;
+    plan.activationBytes = engine.activationBytes;
+    plan.logitsBytes = getLogitsBytes();
+    plan.reservedBytes = config.reservedBytes;
+
+    auto const used = plan.weightsBytes + plan.activationBytes + plan.logitsBytes + plan.reservedBytes;
+    TLLM_CHECK_WITH_INFO(used < config.gpuMemoryBytes,
+        "The engine needs %.1f MiB but the GPU only has %.1f MiB", toMiB(used), toMiB(config.gpuMemoryBytes));
+    auto const freeBytes = config.gpuMemoryBytes - used;
+
+    plan.kvBytesPerBlock = getKvBytesPerBlock(config.kvCacheType, config.tokensPerBlock);
+    plan.numKvBlocks = static_cast<SizeType32>(
+        static_cast<double>(freeBytes) * config.freeGpuMemoryFraction / static_cast<double>(plan.kvBytesPerBlock));
+    plan.kvCacheBytes = plan.kvBytesPerBlock * plan.numKvBlocks;
+
+    if (config.numDeviceLoraModuleLayer > 0)
+    {
+        plan.loraCacheBytes = getLoraBytes(config.numDeviceLoraModuleLayer, config.optimalLoraAdapterSize);
+    }
+    else
+    {
+        auto const leftBytes = static_cast<double>(freeBytes - plan.kvCacheBytes);
+        plan.loraCacheBytes = static_cast<std::size_t>(leftBytes * config.loraDeviceCachePercent);
+    }
+    TLLM_CHECK_WITH_INFO(plan.kvCacheBytes + plan.loraCacheBytes <= freeBytes,
+        "The LoRA cache of %.1f MiB does not fit next to the KV cache", toMiB(plan.loraCacheBytes));
+
+    plan.blocksPerSequence = getBlocksPerSequence(traffic, config.tokensPerBlock);
+    auto const kvBatchSize = plan.numKvBlocks / plan.blocksPerSequence;
+    plan.limitedByEngine = kvBatchSize >= mModelConfig.getMaxBatchSize();
+    plan.maxBatchSize = std::min(kvBatchSize, mModelConfig.getMaxBatchSize());
+    plan.maxNumTokens = plan.numKvBlocks * config.tokensPerBlock;
+    return plan;
+}
+
+} // namespace tensorrt_llm::runtime
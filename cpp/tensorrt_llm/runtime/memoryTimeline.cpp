@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+thread_local MemoryTimeline::Tag currentTag{MemoryTimeline::Tag::kUNTAGGED};
+} // namespace
+
+MemoryTimeline::ScopedTag::ScopedTag(Tag tag)
+    : mPrevious{currentTag}
+{
+    currentTag = tag;
+}
+
+MemoryTimeline::ScopedTag::~ScopedTag()
+{
+    currentTag = mPrevious;
+}
+
+MemoryTimeline::MemoryTimeline(std::size_t capacity)
+    : mEpoch{Clock::now()}
+    , mCapacity{capacity}
+{
+    TLLM_CHECK_WITH_INFO(mCapacity > 0, "The memory timeline needs room for at least one event");
+    clear();
+}
+
+MemoryTimeline& MemoryTimeline::getInstance()
+{
+    static MemoryTimeline mInstance{static_cast<std::size_t>(common::getEnvMemoryTimelineCapacity())};
+    return mInstance;
+}
+
+bool MemoryTimeline::isEnabled()
+{
+    return common::getEnvEnableMemoryTimeline();
+}
+
+MemoryTimeline::Tag MemoryTimeline::getCurrentTag()
+{
+    return currentTag;
+}
+
+char const* MemoryTimeline::getTagName(Tag tag)
+{
+    switch (tag)
+    {
+    case Tag::kUNTAGGED: return "untagged";
+    case Tag::kKV_CACHE: return "kv_cache";
+    case Tag::kDECODER: return "decoder";
+    case Tag::kLORA: return "lora";
+    case Tag::kWORKSPACE: return "workspace";
+    case Tag::kRUNTIME: return "runtime";
+    case Tag::kSCHEDULER: return "scheduler";
+    case Tag::kSERIALIZATION: return "serialization";
+    }
+    return "unknown";
+}
+
+char const* MemoryTimeline::getMemoryTypeName(MemoryType memoryType)
+{
+    switch (memoryType)
+    {
+    case MemoryType::kGPU: return MemoryTypeString<MemoryType::kGPU>::value;
+    case MemoryType::kCPU: return MemoryTypeString<MemoryType::kCPU>::value;
+    case MemoryType::kPINNED: return MemoryTypeString<MemoryType::kPINNED>::value;
+    case MemoryType::kUVM: return MemoryTypeString<MemoryType::kUVM>::value;
+    }
+    return "unknown";
+}
+
+std::size_t MemoryTimeline::getUntrackedGpuBytes()
+{
+    std::size_t freeBytes{0};
+    std::size_t totalBytes{0};
+    TLLM_CUDA_CHECK(cudaMemGetInfo(&freeBytes, &totalBytes));
+    auto const used = totalBytes - freeBytes;
+    auto const tracked = MemoryCounters::getInstance().getGpu();
+    return used > tracked ? used - tracked : 0;
+}
+
+void MemoryTimeline::recordAllocation(
+    MemoryType memoryType, void const* address, std::size_t size, cudaStream_t stream)
+{
+    record(memoryType, currentTag, address, static_cast<std::int64_t>(size), stream);
+}
+
+void MemoryTimeline::recordFree(MemoryType memoryType, void const* address, std::size_t size, cudaStream_t stream)
+{
+    // The tag is taken from the allocation in record
+    record(memoryType, Tag::kUNTAGGED, address, -static_cast<std::int64_t>(size), stream);
+}
+
+void MemoryTimeline::record(MemoryType memoryType, Tag tag, void const* address, std::int64_t size, cudaStream_t stream)
+{
+    auto const timeNs = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - mEpoch).count();
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (size >= 0)
+    {
+        mLiveTags[address] = tag;
+    }
+    else if (auto const it = mLiveTags.find(address); it != mLiveTags.end())
+    {
+        tag = it->second;
+        mLiveTags.erase(it);
+    }
+
+    auto& stats = getStats(memoryType, tag);
+    if (size >= 0)
+    {
+        stats.currentBytes += static_cast<std::size_t>(size);
+        stats.peakBytes = std::max(stats.peakBytes, stats.currentBytes);
+        ++stats.numAllocations;
+    }
+    else
+    {
+        // Memory allocated before the timeline was cleared is not in the totals
+        stats.currentBytes -= std::min(stats.currentBytes, static_cast<std::size_t>(-size));
+        ++stats.numFrees;
+    }
+
+    Event event{timeNs, address, size, stream, memoryType, tag, stats.currentBytes};
+    if (mEvents.size() < mCapacity)
+    {
+        mEvents.push_back(event);
+    }
+    else
+    {
+        mEvents[mNumRecorded % mCapacity] = event;
+    }
+    ++mNumRecorded;
+}
+
+std::vector<MemoryTimeline::TagStats> MemoryTimeline::takeStats()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    std::vector<TagStats> result;
+    for (auto& stats : mStats)
+    {
+        if (stats.peakBytes == 0 && stats.numFrees == 0)
+        {
+            continue;
+        }
+        result.push_back(stats);
+        stats.peakBytes = stats.currentBytes;
+        stats.numAllocations = 0;
+        stats.numFrees = 0;
+    }
+    return result;
+}
+
+std::vector<MemoryTimeline::Event> MemoryTimeline::getEvents() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (mNumRecorded <= mCapacity)
+    {
+        return mEvents;
+    }
+    auto const oldest = static_cast<std::ptrdiff_t>(mNumRecorded % mCapacity);
+    std::vector<Event> events(mEvents.begin() + oldest, mEvents.end());
+    events.insert(events.end(), mEvents.begin(), mEvents.begin() + oldest);
+    return events;
+}
+
+std::uint64_t MemoryTimeline::getNumDropped() const
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mNumRecorded > mCapacity ? mNumRecorded - mCapacity : 0;
+}
+
+common::ChromeTrace MemoryTimeline::toChromeTrace() const
+{
+    common::ChromeTrace trace;
+    for (auto const& event : getEvents())
+    {
+        auto const pid = static_cast<std::int64_t>(event.memoryType);
+        trace.addCounter(std::string{getMemoryTypeName(event.memoryType)} + " " + getTagName(event.tag), pid,
+            static_cast<double>(event.timeNs) / 1000.0, {{"bytes", static_cast<std::int64_t>(event.tagBytes)}});
+    }
+    return trace;
+}
+
+void MemoryTimeline::dump(std::filesystem::path const& path) const
+{
+    toChromeTrace().write(path);
+}
+
+void MemoryTimeline::writeCsv(std::filesystem::path const& path) const
+{
+    std::ofstream file{path};
+    TLLM_CHECK_WITH_INFO(file.good(), "Error opening memory timeline file %s", path.string().c_str());
+    file << "time_us,memory_type,tag,stream,address,size,tag_bytes\n";
+    for (auto const& event : getEvents())
+    {
+        file << static_cast<double>(event.timeNs) / 1000.0 << "," << getMemoryTypeName(event.memoryType) << ","
+             << getTagName(event.tag) << "," << reinterpret_cast<std::uintptr_t>(event.stream) << ","
+             << event.address << "," << event.size << "," << event.tagBytes << "\n";
+    }
+    TLLM_CHECK_WITH_INFO(file.good(), "Error writing memory timeline file %s", path.string().c_str());
+}
+
+void MemoryTimeline::clear()
+{
+    std::lock_guard<std::mutex> lock(mMutex);
+    mEvents.clear();
+    mNumRecorded = 0;
+    mLiveTags.clear();
+    for (std::size_t i = 0; i < mStats.size(); ++i)
+    {
+        mStats[i] = TagStats{static_cast<Tag>(i % kNumTags), static_cast<MemoryType>(i / kNumTags)};
+    }
+}
+
+} // namespace tensorrt_llm::runtime
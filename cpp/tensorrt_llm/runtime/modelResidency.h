@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/common.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Decides which of several engines sharing a GPU keep their weights on the GPU.
+//! \details Every model always occupies its minimum weight streaming budget, resident models occupy all of their
+//! weights. Weights of models that are not resident stay in pinned host memory and are streamed, see
+//! TllmRuntime::setGpuWeightsPercent. Models are made resident on demand, paging out the least recently used resident
+//! models that are not in use. The caller applies the plans, e.g. with gpuWeightsPercent 1 for page-in and 0 for
+//! page-out.
+class ModelResidencyManager
+{
+public:
+    using ModelIdType = std::uint64_t;
+
+    struct Plan
+    {
+        //! Whether the weights of the acquired model must be paged in.
+        bool pageIn{false};
+        //! Models whose weights must be paged out first.
+        std::vector<ModelIdType> pageOut;
+    };
+
+    //! \param gpuBudgetBytes GPU memory available for the weights of all models.
+    explicit ModelResidencyManager(std::int64_t gpuBudgetBytes)
+        : mGpuBudgetBytes{gpuBudgetBytes}
+        , mUsedBytes{0}
+    {
+    }
+
+    //! \brief Register a model, not resident.
+    //! \param residentBytes GPU memory of all weights, TllmRuntime::getStreamableWeightsSize plus the rest.
+    //! \param minBytes GPU memory of the weights while streaming.
+    void addModel(ModelIdType modelId, std::int64_t residentBytes, std::int64_t minBytes)
+    {
+        TLLM_CHECK(0 <= minBytes && minBytes <= residentBytes);
+        TLLM_CHECK_WITH_INFO(mUsedBytes + minBytes <= mGpuBudgetBytes, "Model %lu does not fit into the budget",
+            static_cast<unsigned long>(modelId));
+        auto const [it, inserted] = mModels.try_emplace(modelId, Model{residentBytes, minBytes});
+        TLLM_CHECK_WITH_INFO(inserted, "Model %lu added twice", static_cast<unsigned long>(modelId));
+        mUsedBytes += minBytes;
+    }
+
+    //! \brief Make a model resident for a batch and pin it until release().
+    //! \return The plan to apply, or std::nullopt if the models in use leave no room, the model can run streamed then.
+    [[nodiscard]] std::optional<Plan> acquire(ModelIdType modelId)
+    {
+        auto& model = mModels.at(modelId);
+        Plan plan;
+        if (!model.resident)
+        {
+            auto const extraBytes = model.residentBytes - model.minBytes;
+            auto freeBytes = mGpuBudgetBytes - mUsedBytes;
+            for (auto it = mLru.begin(); it != mLru.end() && freeBytes < extraBytes; ++it)
+            {
+                auto const& victim = mModels.at(*it);
+                if (victim.numUsers == 0)
+                {
+                    plan.pageOut.push_back(*it);
+                    freeBytes += victim.residentBytes - victim.minBytes;
+                }
+            }
+            if (freeBytes < extraBytes)
+            {
+                return std::nullopt;
+            }
+            for (auto const victimId : plan.pageOut)
+            {
+                pageOut(victimId);
+            }
+            model.resident = true;
+            model.lruPos = mLru.insert(mLru.end(), modelId);
+            mUsedBytes += extraBytes;
+            plan.pageIn = true;
+        }
+        else
+        {
+            mLru.splice(mLru.end(), mLru, model.lruPos);
+        }
+        ++model.numUsers;
+        model.lastUse = ++mNumAcquires;
+        return plan;
+    }
+
+    void release(ModelIdType modelId)
+    {
+        auto& model = mModels.at(modelId);
+        TLLM_CHECK_WITH_INFO(
+            model.numUsers > 0, "Model %lu released without acquire", static_cast<unsigned long>(modelId));
+        --model.numUsers;
+    }
+
+    [[nodiscard]] bool isResident(ModelIdType modelId) const
+    {
+        return mModels.at(modelId).resident;
+    }
+
+    //! \brief Order models with pending requests for scheduling: resident models first, most recently used first, then
+    //! the others in the given order. Serving resident models first avoids paging.
+    [[nodiscard]] std::vector<ModelIdType> orderByResidency(std::vector<ModelIdType> models) const
+    {
+        std::stable_sort(models.begin(), models.end(),
+            [this](ModelIdType lhs, ModelIdType rhs)
+            {
+                auto const& left = mModels.at(lhs);
+                auto const& right = mModels.at(rhs);
+                if (left.resident != right.resident)
+                {
+                    return left.resident;
+                }
+                return left.resident && left.lastUse > right.lastUse;
+            });
+        return models;
+    }
+
+    [[nodiscard]] std::int64_t getUsedBytes() const noexcept
+    {
+        return mUsedBytes;
+    }
+
+private:
+    struct Model
+    {
+        Model(std::int64_t residentBytes, std::int64_t minBytes)
+            : residentBytes{residentBytes}
+            , minBytes{minBytes}
+        {
+        }
+
+        std::int64_t residentBytes;
+        std::int64_t minBytes;
+        bool resident{false};
+        SizeType32 numUsers{0};
+        std::uint64_t lastUse{0};
+        std::list<ModelIdType>::iterator lruPos{};
+    };
+
+    void pageOut(ModelIdType modelId)
+    {
+        auto& model = mModels.at(modelId);
+        mLru.erase(model.lruPos);
+        model.resident = false;
+        mUsedBytes -= model.residentBytes - model.minBytes;
+    }
+
+    std::int64_t mGpuBudgetBytes;
+    std::int64_t mUsedBytes;
+    std::uint64_t mNumAcquires{0};
+    std::unordered_map<ModelIdType, Model> mModels;
+    // Resident models, least recently used first
+    std::list<ModelIdType> mLru;
+};
+
+} // namespace tensorrt_llm::runtime
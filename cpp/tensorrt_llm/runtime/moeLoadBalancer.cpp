@@ -0,0 +1,206 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/moeLoadBalancer.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace tensorrt_llm::runtime
+{
+
+MoeExpertLoadTracker& MoeExpertLoadTracker::getInstance()
+{
+    static MoeExpertLoadTracker mInstance;
+    return mInstance;
+}
+
+std::shared_ptr<MoeExpertLoadTracker::Layer> MoeExpertLoadTracker::addLayer(
+    SizeType32 firstExpert, SizeType32 numExperts)
+{
+    TLLM_CHECK(firstExpert >= 0 && numExperts > 0);
+    auto counts = BufferManager::gpuSync(numExperts, nvinfer1::DataType::kINT64);
+    TLLM_CUDA_CHECK(cudaMemset(counts->data(), 0, counts->getSizeInBytes()));
+    auto overflow = BufferManager::gpuSync(numExperts + 1, nvinfer1::DataType::kINT64);
+    TLLM_CUDA_CHECK(cudaMemset(overflow->data(), 0, overflow->getSizeInBytes()));
+    auto layer = std::make_shared<Layer>(Layer{firstExpert, numExperts, std::move(counts), std::move(overflow)});
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    // Drop the layers of destroyed engines so the list does not grow across engine reloads
+    mLayers.erase(std::remove_if(mLayers.begin(), mLayers.end(), [](auto const& entry) { return entry.expired(); }),
+        mLayers.end());
+    mLayers.emplace_back(layer);
+    return layer;
+}
+
+std::vector<MoeExpertLoadTracker::LayerStats> MoeExpertLoadTracker::takeStats(CudaStream const& stream)
+{
+    std::vector<LayerStats> stats;
+    std::vector<std::shared_ptr<Layer>> layers;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        for (auto const& entry : mLayers)
+        {
+            if (auto layer = entry.lock())
+            {
+                layers.emplace_back(std::move(layer));
+            }
+        }
+    }
+
+    std::vector<std::vector<std::int64_t>> overflow(layers.size());
+    stats.reserve(layers.size());
+    for (std::size_t i = 0; i < layers.size(); ++i)
+    {
+        auto const& layer = layers[i];
+        auto& layerStats = stats.emplace_back(LayerStats{layer->firstExpert, {}, {}, 0});
+        layerStats.expertTokenCounts.resize(layer->numExperts);
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(layerStats.expertTokenCounts.data(), layer->counts->data(),
+            layer->counts->getSizeInBytes(), cudaMemcpyDeviceToHost, stream.get()));
+        TLLM_CUDA_CHECK(cudaMemsetAsync(layer->counts->data(), 0, layer->counts->getSizeInBytes(), stream.get()));
+        overflow[i].resize(layer->numExperts + 1);
+        TLLM_CUDA_CHECK(cudaMemcpyAsync(overflow[i].data(), layer->overflow->data(),
+            layer->overflow->getSizeInBytes(), cudaMemcpyDeviceToHost, stream.get()));
+        TLLM_CUDA_CHECK(cudaMemsetAsync(layer->overflow->data(), 0, layer->overflow->getSizeInBytes(), stream.get()));
+    }
+    stream.synchronize();
+
+    for (std::size_t i = 0; i < layers.size(); ++i)
+    {
+        stats[i].droppedRows = overflow[i].back();
+        overflow[i].pop_back();
+        stats[i].expertOverflowCounts = std::move(overflow[i]);
+    }
+    return stats;
+}
+
+ExpertReplicationPlanner::ExpertReplicationPlanner(
+    SizeType32 numExperts, SizeType32 epSize, SizeType32 maxReplicasPerRank, double decay)
+    : mNumExperts{numExperts}
+    , mEpSize{epSize}
+    , mMaxReplicasPerRank{maxReplicasPerRank}
+    , mDecay{decay}
+    , mExpertLoads(numExperts, 0.0)
+{
+    TLLM_CHECK(epSize > 0 && numExperts > 0 && numExperts % epSize == 0);
+    TLLM_CHECK(maxReplicasPerRank >= 0);
+    TLLM_CHECK(0.0 <= decay && decay < 1.0);
+}
+
+void ExpertReplicationPlanner::addCounts(std::vector<std::int64_t> const& expertTokenCounts)
+{
+    TLLM_CHECK(static_cast<SizeType32>(expertTokenCounts.size()) == mNumExperts);
+    for (SizeType32 expert = 0; expert < mNumExperts; ++expert)
+    {
+        auto const count = static_cast<double>(expertTokenCounts[expert]);
+        mExpertLoads[expert] = mHasCounts ? mDecay * mExpertLoads[expert] + (1.0 - mDecay) * count : count;
+    }
+    mHasCounts = true;
+}
+
+ExpertReplicationPlan ExpertReplicationPlanner::plan() const
+{
+    auto const expertsPerRank = mNumExperts / mEpSize;
+
+    ExpertReplicationPlan plan;
+    plan.expertRanks.resize(mNumExperts);
+    for (SizeType32 expert = 0; expert < mNumExperts; ++expert)
+    {
+        plan.expertRanks[expert].push_back(expert / expertsPerRank);
+    }
+
+    auto const servedBy = [&plan](SizeType32 expert, SizeType32 rank)
+    {
+        auto const& ranks = plan.expertRanks[expert];
+        return std::find(ranks.begin(), ranks.end(), rank) != ranks.end();
+    };
+    auto const computeRankLoads = [&]()
+    {
+        std::vector<double> loads(mEpSize, 0.0);
+        for (SizeType32 expert = 0; expert < mNumExperts; ++expert)
+        {
+            auto const& ranks = plan.expertRanks[expert];
+            auto const share = mExpertLoads[expert] / static_cast<double>(ranks.size());
+            for (auto const rank : ranks)
+            {
+                loads[rank] += share;
+            }
+        }
+        return loads;
+    };
+
+    std::vector<SizeType32> freeSlots(mEpSize, mMaxReplicasPerRank);
+    auto rankLoads = computeRankLoads();
+    while (true)
+    {
+        auto const hotRank
+            = static_cast<SizeType32>(std::max_element(rankLoads.begin(), rankLoads.end()) - rankLoads.begin());
+
+        // The expert that sends the most tokens to each of its ranks among those served by the hot rank
+        SizeType32 hotExpert{-1};
+        double hotShare{0.0};
+        for (SizeType32 expert = 0; expert < mNumExperts; ++expert)
+        {
+            auto const share = mExpertLoads[expert] / static_cast<double>(plan.expertRanks[expert].size());
+            if (servedBy(expert, hotRank) && share > hotShare)
+            {
+                hotExpert = expert;
+                hotShare = share;
+            }
+        }
+        if (hotExpert < 0)
+        {
+            break;
+        }
+
+        SizeType32 target{-1};
+        for (SizeType32 rank = 0; rank < mEpSize; ++rank)
+        {
+            bool const canHost = freeSlots[rank] > 0 && !servedBy(hotExpert, rank);
+            if (canHost && (target < 0 || rankLoads[rank] < rankLoads[target]))
+            {
+                target = rank;
+            }
+        }
+        if (target < 0)
+        {
+            break;
+        }
+
+        plan.expertRanks[hotExpert].push_back(target);
+        auto newRankLoads = computeRankLoads();
+        // Stop once the replica would just move the hot spot to the target rank
+        if (newRankLoads[target] >= rankLoads[hotRank])
+        {
+            plan.expertRanks[hotExpert].pop_back();
+            break;
+        }
+        --freeSlots[target];
+        rankLoads = std::move(newRankLoads);
+    }
+
+    auto const meanLoad = std::accumulate(rankLoads.begin(), rankLoads.end(), 0.0) / mEpSize;
+    auto const maxLoad = *std::max_element(rankLoads.begin(), rankLoads.end());
+    plan.imbalance = meanLoad > 0.0 ? maxLoad / meanLoad : 1.0;
+    plan.rankLoads = std::move(rankLoads);
+    return plan;
+}
+
+} // namespace tensorrt_llm::runtime
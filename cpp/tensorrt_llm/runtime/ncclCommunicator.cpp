@@ -69,6 +69,24 @@ void NcclCommunicator::receive(
 #endif // ENABLE_MULTI_DEVICE
 }
 
+void NcclCommunicator::groupStart()
+{
+#if ENABLE_MULTI_DEVICE
+    TLLM_NCCL_CHECK(ncclGroupStart());
+#else
+    TLLM_THROW("Multi device support is disabled.");
+#endif // ENABLE_MULTI_DEVICE
+}
+
+void NcclCommunicator::groupEnd()
+{
+#if ENABLE_MULTI_DEVICE
+    TLLM_NCCL_CHECK(ncclGroupEnd());
+#else
+    TLLM_THROW("Multi device support is disabled.");
+#endif // ENABLE_MULTI_DEVICE
+}
+
 ncclComm_t NcclCommunicator::createComm(int worldSize, int rank, mpi::MpiComm const& mpiComm)
 {
 #if ENABLE_MULTI_DEVICE
@@ -55,6 +55,12 @@ public:
         receive(buf.data(), buf.getSize(), buf.getDataType(), peer, stream);
     }
 
+    //! \brief Aggregates the operations issued until groupEnd, so that point to point operations to several peers
+    //! progress concurrently instead of one after the other.
+    static void groupStart();
+
+    static void groupEnd();
+
 private:
     void send(
         void const* sendbuff, size_t count, nvinfer1::DataType dataType, int peer, CudaStream const& stream) const;
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ngramDraftCache.h"
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace tensorrt_llm::runtime
+{
+
+NgramDraftCache::NgramDraftCache(Config const& config)
+    : mConfig{config}
+{
+    TLLM_CHECK(mConfig.minNgramLength > 0);
+    TLLM_CHECK(mConfig.minNgramLength <= mConfig.maxNgramLength);
+}
+
+std::uint64_t NgramDraftCache::hashNgram(TokenIdType const* tokens, SizeType32 length)
+{
+    // FNV-1a over the tokens, seeded with the length so that n-grams of different lengths don't collide
+    std::uint64_t hash = 14695981039346656037ULL ^ static_cast<std::uint64_t>(length);
+    for (SizeType32 ti = 0; ti < length; ++ti)
+    {
+        hash ^= static_cast<std::uint32_t>(tokens[ti]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+void NgramDraftCache::indexPosition(SequenceIdType sequenceId, VecTokens const& tokens, SizeType32 position)
+{
+    auto const maxLength = std::min(mConfig.maxNgramLength, position);
+    for (SizeType32 length = mConfig.minNgramLength; length <= maxLength; ++length)
+    {
+        mIndex[hashNgram(tokens.data() + position - length, length)] = Location{sequenceId, position - 1};
+    }
+}
+
+void NgramDraftCache::eraseSequence(SequenceIdType sequenceId)
+{
+    auto const it = mSequences.find(sequenceId);
+    auto const& tokens = it->second;
+    auto const numTokens = static_cast<SizeType32>(tokens.size());
+    for (SizeType32 position = 1; position < numTokens; ++position)
+    {
+        auto const maxLength = std::min(mConfig.maxNgramLength, position);
+        for (SizeType32 length = mConfig.minNgramLength; length <= maxLength; ++length)
+        {
+            auto const entry = mIndex.find(hashNgram(tokens.data() + position - length, length));
+            if (entry != mIndex.end() && entry->second.sequenceId == sequenceId && entry->second.end == position - 1)
+            {
+                mIndex.erase(entry);
+            }
+        }
+    }
+    mNumTokens -= tokens.size();
+    mSequences.erase(it);
+}
+
+void NgramDraftCache::evict(SequenceIdType keepId)
+{
+    while (mNumTokens > mConfig.maxNumTokens && mSequences.size() > 1)
+    {
+        auto const sequenceId = mOrder.front();
+        mOrder.pop_front();
+        if (sequenceId == keepId)
+        {
+            mOrder.push_back(sequenceId);
+        }
+        else if (mSequences.count(sequenceId) > 0)
+        {
+            eraseSequence(sequenceId);
+        }
+    }
+}
+
+NgramDraftCache::SequenceIdType NgramDraftCache::addSequence(VecTokens const& tokens)
+{
+    std::unique_lock lock(mMutex);
+    auto const sequenceId = mNextSequenceId++;
+    auto const& stored = mSequences.emplace(sequenceId, tokens).first->second;
+    for (SizeType32 position = 1; position < static_cast<SizeType32>(stored.size()); ++position)
+    {
+        indexPosition(sequenceId, stored, position);
+    }
+    mNumTokens += stored.size();
+    mOrder.push_back(sequenceId);
+    evict(sequenceId);
+    return sequenceId;
+}
+
+void NgramDraftCache::appendTokens(SequenceIdType sequenceId, VecTokens const& tokens)
+{
+    std::unique_lock lock(mMutex);
+    auto const it = mSequences.find(sequenceId);
+    if (it == mSequences.end())
+    {
+        return;
+    }
+    auto& stored = it->second;
+    auto const begin = std::max(static_cast<SizeType32>(stored.size()), 1);
+    stored.insert(stored.end(), tokens.begin(), tokens.end());
+    for (SizeType32 position = begin; position < static_cast<SizeType32>(stored.size()); ++position)
+    {
+        indexPosition(sequenceId, stored, position);
+    }
+    mNumTokens += tokens.size();
+    evict(sequenceId);
+}
+
+void NgramDraftCache::removeSequence(SequenceIdType sequenceId)
+{
+    std::unique_lock lock(mMutex);
+    if (mSequences.count(sequenceId) > 0)
+    {
+        eraseSequence(sequenceId);
+    }
+}
+
+NgramDraftCache::VecTokens NgramDraftCache::propose(VecTokens const& context, SizeType32 maxDraftLength) const
+{
+    std::shared_lock lock(mMutex);
+    auto const contextLength = static_cast<SizeType32>(context.size());
+    for (auto length = std::min(mConfig.maxNgramLength, contextLength); length >= mConfig.minNgramLength; --length)
+    {
+        auto const* suffix = context.data() + contextLength - length;
+        auto const entry = mIndex.find(hashNgram(suffix, length));
+        if (entry == mIndex.end())
+        {
+            continue;
+        }
+        auto const& [sequenceId, end] = entry->second;
+        auto const& tokens = mSequences.at(sequenceId);
+        if (end + 1 < length || !std::equal(suffix, suffix + length, tokens.begin() + end - length + 1))
+        {
+            continue;
+        }
+        auto const draftEnd = std::min(static_cast<SizeType32>(tokens.size()), end + 1 + std::max(maxDraftLength, 0));
+        return VecTokens(tokens.begin() + end + 1, tokens.begin() + draftEnd);
+    }
+    return {};
+}
+
+std::size_t NgramDraftCache::getNumTokens() const
+{
+    std::shared_lock lock(mMutex);
+    return mNumTokens;
+}
+
+std::size_t NgramDraftCache::getNumSequences() const
+{
+    std::shared_lock lock(mMutex);
+    return mSequences.size();
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/promptEmbeddingCache.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <algorithm>
+
+namespace tensorrt_llm::runtime
+{
+
+PromptEmbeddingCache::PromptEmbeddingCache(SizeType32 maxRows, SizeType32 rowsPerPage, SizeType32 hiddenSize,
+    nvinfer1::DataType dataType, SizeType32 vocabSize, BufferManager const& manager)
+    : mMaxRows{maxRows}
+    , mRowsPerPage{rowsPerPage}
+    , mVocabSize{vocabSize}
+    , mManager{manager}
+{
+    TLLM_CHECK(mRowsPerPage > 0);
+    TLLM_CHECK_WITH_INFO(mMaxRows > 0 && mMaxRows % mRowsPerPage == 0,
+        "The prompt embedding cache needs whole pages of %d rows, got %d rows", mRowsPerPage, mMaxRows);
+    mTable = mManager.gpu(ITensor::makeShape({mMaxRows, hiddenSize}), dataType);
+    for (SizeType32 page = 0; page < mMaxRows / mRowsPerPage; ++page)
+    {
+        mFreePages.push_back(page);
+    }
+}
+
+PromptEmbeddingCache::HashType PromptEmbeddingCache::hashContent(void const* data, std::size_t sizeInBytes)
+{
+    // FNV-1a
+    auto const* bytes = static_cast<std::uint8_t const*>(data);
+    HashType hash{0xcbf29ce484222325ULL};
+    for (std::size_t i = 0; i < sizeInBytes; ++i)
+    {
+        hash = (hash ^ bytes[i]) * 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+std::optional<PromptEmbeddingCache::VecTokens> PromptEmbeddingCache::acquire(
+    HashType contentHash, ITensor::SharedConstPtr const& embeddings)
+{
+    if (auto tokenIds = acquire(contentHash))
+    {
+        return tokenIds;
+    }
+    ++mStats.numMisses;
+
+    auto const& shape = embeddings->getShape();
+    TLLM_CHECK_WITH_INFO(shape.nbDims == 2 && shape.d[1] == mTable->getShape().d[1],
+        "Expected embeddings of shape [numRows, %ld], got %s", static_cast<long>(mTable->getShape().d[1]),
+        ITensor::toString(shape).c_str());
+    TLLM_CHECK(embeddings->getDataType() == mTable->getDataType());
+    auto const numRows = static_cast<SizeType32>(shape.d[0]);
+    TLLM_CHECK(numRows > 0);
+    auto const numPages = (numRows + mRowsPerPage - 1) / mRowsPerPage;
+    if (!makeRoom(numPages))
+    {
+        TLLM_LOG_DEBUG("No room for %d prompt embedding rows, the cached entries are in use", numRows);
+        return std::nullopt;
+    }
+
+    Entry entry{{}, numRows};
+    for (SizeType32 pi = 0; pi < numPages; ++pi)
+    {
+        auto const page = mFreePages.front();
+        mFreePages.pop_front();
+        entry.pages.push_back(page);
+        auto const rowBegin = pi * mRowsPerPage;
+        auto const pageRows = std::min(mRowsPerPage, numRows - rowBegin);
+        mManager.copy(*ITensor::slice(ITensor::SharedConstPtr{embeddings}, rowBegin, pageRows),
+            *ITensor::slice(mTable, page * mRowsPerPage, pageRows));
+    }
+    auto& inserted = mEntries.emplace(contentHash, std::move(entry)).first->second;
+    return addRef(inserted);
+}
+
+std::optional<PromptEmbeddingCache::VecTokens> PromptEmbeddingCache::acquire(HashType contentHash)
+{
+    auto const it = mEntries.find(contentHash);
+    if (it == mEntries.end())
+    {
+        return std::nullopt;
+    }
+    ++mStats.numHits;
+    return addRef(it->second);
+}
+
+void PromptEmbeddingCache::release(HashType contentHash)
+{
+    auto& entry = mEntries.at(contentHash);
+    TLLM_CHECK_WITH_INFO(entry.numRefs > 0, "Prompt embedding entry released more often than acquired");
+    if (--entry.numRefs == 0)
+    {
+        entry.lruIt = mLru.insert(mLru.end(), contentHash);
+    }
+}
+
+PromptEmbeddingCache::Stats PromptEmbeddingCache::getStats() const
+{
+    auto stats = mStats;
+    stats.numEntries = static_cast<SizeType32>(mEntries.size());
+    stats.numFreePages = static_cast<SizeType32>(mFreePages.size());
+    return stats;
+}
+
+PromptEmbeddingCache::VecTokens PromptEmbeddingCache::addRef(Entry& entry)
+{
+    if (entry.numRefs++ == 0 && entry.lruIt)
+    {
+        mLru.erase(*entry.lruIt);
+        entry.lruIt.reset();
+    }
+    return getTokenIds(entry);
+}
+
+PromptEmbeddingCache::VecTokens PromptEmbeddingCache::getTokenIds(Entry const& entry) const
+{
+    VecTokens tokenIds;
+    tokenIds.reserve(entry.numRows);
+    for (SizeType32 ri = 0; ri < entry.numRows; ++ri)
+    {
+        auto const page = entry.pages[ri / mRowsPerPage];
+        tokenIds.push_back(mVocabSize + page * mRowsPerPage + ri % mRowsPerPage);
+    }
+    return tokenIds;
+}
+
+bool PromptEmbeddingCache::makeRoom(SizeType32 numPages)
+{
+    while (static_cast<SizeType32>(mFreePages.size()) < numPages)
+    {
+        if (mLru.empty())
+        {
+            return false;
+        }
+        auto const it = mEntries.find(mLru.front());
+        mLru.pop_front();
+        // Pages freed last are given out last.
+        mFreePages.insert(mFreePages.end(), it->second.pages.begin(), it->second.pages.end());
+        mEntries.erase(it);
+        ++mStats.numEvictions;
+    }
+    return true;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Device-resident prompt embedding table shared by all requests, e.g. for the image embeddings of
+//! vision-language models. Embeddings are registered once by the hash of their content and referenced by handle.
+//! \details The table is used as the embedding table of PromptTuningParams for every request, with task 0 and a task
+//! vocab size of getMaxRows(), so no per-request table is uploaded or concatenated. A request puts the prompt token ids
+//! of its entries into its input ids where the embeddings go. The ids of an entry only depend on the rows it occupies,
+//! so requests sharing an entry have the same input ids and reuse each other's KV cache blocks too.
+//! Rows are allocated in pages. Entries that no request holds are evicted least recently used first, and their pages
+//! are given out again as late as possible. KV cache blocks holding the ids of an evicted entry must not be reused
+//! after its pages were given to other content, Stats::numEvictions tells when that may have happened.
+class PromptEmbeddingCache
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using VecTokens = std::vector<TokenIdType>;
+    using HashType = std::uint64_t;
+
+    struct Stats
+    {
+        SizeType32 numEntries{0};
+        SizeType32 numFreePages{0};
+        SizeType32 numHits{0};
+        SizeType32 numMisses{0};
+        SizeType32 numEvictions{0};
+    };
+
+    //! \param vocabSize Vocab size of the model, the prompt token ids start after it.
+    PromptEmbeddingCache(SizeType32 maxRows, SizeType32 rowsPerPage, SizeType32 hiddenSize,
+        nvinfer1::DataType dataType, SizeType32 vocabSize, BufferManager const& manager);
+
+    //! \brief Hash of the content of host embeddings, e.g. to key the output of a vision encoder by the pixels instead.
+    [[nodiscard]] static HashType hashContent(void const* data, std::size_t sizeInBytes);
+
+    //! \brief Take a reference to the entry of a content hash, registering the embeddings if it is not cached.
+    //! \param embeddings [numRows, hiddenSize] in any memory type, only read on a miss.
+    //! \return The prompt token ids of the entry, std::nullopt if all rows are held by requests.
+    [[nodiscard]] std::optional<VecTokens> acquire(HashType contentHash, ITensor::SharedConstPtr const& embeddings);
+
+    //! \brief Take a reference to a cached entry without the embeddings, std::nullopt if it is not cached.
+    [[nodiscard]] std::optional<VecTokens> acquire(HashType contentHash);
+
+    //! \brief Drop a reference taken by acquire, e.g. when the request finishes its context phase.
+    void release(HashType contentHash);
+
+    //! \brief The table [maxRows, hiddenSize] for PromptTuningParams::embeddingTable.
+    [[nodiscard]] TensorPtr const& getTable() const
+    {
+        return mTable;
+    }
+
+    [[nodiscard]] SizeType32 getMaxRows() const
+    {
+        return mMaxRows;
+    }
+
+    [[nodiscard]] Stats getStats() const;
+
+private:
+    struct Entry
+    {
+        std::vector<SizeType32> pages;
+        SizeType32 numRows;
+        SizeType32 numRefs{0};
+        // Position in mLru while numRefs is 0
+        std::optional<std::list<HashType>::iterator> lruIt;
+    };
+
+    VecTokens getTokenIds(Entry const& entry) const;
+
+    //! \brief Take a reference, removing an unreferenced entry from the LRU list.
+    VecTokens addRef(Entry& entry);
+
+    //! \brief Evict entries until numPages pages are free, false if not enough entries are unreferenced.
+    bool makeRoom(SizeType32 numPages);
+
+    SizeType32 const mMaxRows;
+    SizeType32 const mRowsPerPage;
+    SizeType32 const mVocabSize;
+    BufferManager const& mManager;
+    TensorPtr mTable;
+    std::unordered_map<HashType, Entry> mEntries;
+    // Unreferenced entries, least recently used first
+    std::list<HashType> mLru;
+    // Free pages, the first ones were freed first
+    std::deque<SizeType32> mFreePages;
+    Stats mStats;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,357 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/rangeProfiler.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <unistd.h>
+
+#include <map>
+#include <utility>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+// GPU ranges of a thread are shown on their own track next to the thread
+auto constexpr kGpuTrackOffset = 1 << 20;
+
+struct ThreadState
+{
+    // Depth of the open ranges of the thread, the sampling is decided at depth 0
+    std::int32_t depth{0};
+    bool sampled{false};
+    std::uint32_t numOutermost{0};
+};
+
+thread_local ThreadState threadState;
+
+nvtx3::color getColor(RangeProfiler::Category category)
+{
+    switch (category)
+    {
+    case RangeProfiler::Category::kSCHEDULER: return nvtx3::color{0xff00ff00};
+    case RangeProfiler::Category::kDECODER: return nvtx3::color{0xff0000ff};
+    case RangeProfiler::Category::kPLUGIN: return nvtx3::color{0xffff00ff};
+    case RangeProfiler::Category::kRUNTIME: return nvtx3::color{0xffffff00};
+    }
+    return nvtx3::color{0xffffffff};
+}
+} // namespace
+
+RangeProfiler::ScopedRange::ScopedRange(RangeId id, cudaStream_t stream)
+    : mId{id}
+    , mStream{stream}
+{
+    auto& profiler = getInstance();
+    auto const& range = profiler.getRange(id);
+    nvtx3::event_attributes const attributes{getColor(range.category), nvtx3::message{range.name.c_str()}};
+    nvtxRangePushEx(attributes.get());
+
+    if (threadState.depth++ == 0)
+    {
+        auto const period = common::getEnvRangeProfilerSamplePeriod();
+        threadState.sampled = period > 0 && threadState.numOutermost++ % static_cast<std::uint32_t>(period) == 0;
+    }
+    mSampled = threadState.sampled;
+    if (!mSampled)
+    {
+        return;
+    }
+    if (mStream != nullptr)
+    {
+        cudaStreamCaptureStatus captureStatus;
+        TLLM_CUDA_CHECK(cudaStreamIsCapturing(mStream, &captureStatus));
+        if (captureStatus == cudaStreamCaptureStatusNone)
+        {
+            mGpuStart = profiler.acquireEvent();
+            TLLM_CUDA_CHECK(cudaEventRecord(mGpuStart, mStream));
+        }
+    }
+    mStart = Clock::now();
+}
+
+RangeProfiler::ScopedRange::~ScopedRange()
+{
+    --threadState.depth;
+    nvtxRangePop();
+    if (!mSampled)
+    {
+        return;
+    }
+    auto const end = Clock::now();
+    auto& profiler = getInstance();
+    Record record{mId, profiler.toNs(mStart), profiler.toNs(end)};
+    if (mGpuStart != nullptr)
+    {
+        record.gpuStart = mGpuStart;
+        record.gpuEnd = profiler.acquireEvent();
+        TLLM_CUDA_CHECK(cudaEventRecord(record.gpuEnd, mStream));
+        TLLM_CUDA_CHECK(cudaGetDevice(&record.device));
+    }
+    profiler.addRecord(record);
+}
+
+RangeProfiler::RangeProfiler()
+    : mEpoch{Clock::now()}
+    , mCapacity{static_cast<std::size_t>(common::getEnvRangeProfilerCapacity())}
+{
+}
+
+RangeProfiler& RangeProfiler::getInstance()
+{
+    static RangeProfiler mInstance;
+    return mInstance;
+}
+
+RangeProfiler::RangeId RangeProfiler::registerRange(Category category, char const* name)
+{
+    auto& profiler = getInstance();
+    std::lock_guard<std::mutex> lock(profiler.mRangesMutex);
+    auto const id = profiler.mNumRanges.load(std::memory_order_relaxed);
+    TLLM_CHECK_WITH_INFO(id < kMaxRanges, "Too many profiled ranges, at most %u", kMaxRanges);
+    profiler.mRanges[id] = RangeInfo{category, name};
+    profiler.mNumRanges.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+char const* RangeProfiler::getCategoryName(Category category)
+{
+    switch (category)
+    {
+    case Category::kSCHEDULER: return "scheduler";
+    case Category::kDECODER: return "decoder";
+    case Category::kPLUGIN: return "plugin";
+    case Category::kRUNTIME: return "runtime";
+    }
+    return "unknown";
+}
+
+bool RangeProfiler::isEnabled()
+{
+    return common::getEnvRangeProfilerSamplePeriod() > 0;
+}
+
+RangeProfiler::ThreadRing& RangeProfiler::getThreadRing()
+{
+    thread_local ThreadRing* threadRing = nullptr;
+    if (threadRing == nullptr)
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        auto ring = std::make_shared<ThreadRing>();
+        ring->tid = static_cast<std::int64_t>(mThreadRings.size());
+        ring->records.reserve(mCapacity);
+        // The profiler outlives the threads, their rings are kept for the dumps
+        threadRing = mThreadRings.emplace_back(std::move(ring)).get();
+    }
+    return *threadRing;
+}
+
+void RangeProfiler::addRecord(Record record)
+{
+    auto& ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(ring.mutex);
+    if (ring.records.size() < mCapacity)
+    {
+        ring.records.push_back(record);
+    }
+    else
+    {
+        auto& slot = ring.records[ring.numRecorded % mCapacity];
+        releaseEvents(slot);
+        slot = record;
+    }
+    ++ring.numRecorded;
+}
+
+cudaEvent_t RangeProfiler::acquireEvent()
+{
+    {
+        std::lock_guard<std::mutex> lock(mEventsMutex);
+        if (!mFreeEvents.empty())
+        {
+            auto* event = mFreeEvents.back();
+            mFreeEvents.pop_back();
+            return event;
+        }
+    }
+    cudaEvent_t event;
+    TLLM_CUDA_CHECK(cudaEventCreate(&event));
+    return event;
+}
+
+void RangeProfiler::releaseEvents(Record& record)
+{
+    if (record.gpuStart == nullptr)
+    {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mEventsMutex);
+    mFreeEvents.push_back(record.gpuStart);
+    mFreeEvents.push_back(record.gpuEnd);
+    record.gpuStart = nullptr;
+    record.gpuEnd = nullptr;
+}
+
+common::ChromeTrace RangeProfiler::dump()
+{
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        rings = mThreadRings;
+    }
+
+    // The GPU ranges are placed on the CPU timeline relative to an event recorded on each device now: the event
+    // completes on an idle stream, so its CPU time once synchronized is close to its GPU time.
+    std::map<int, std::pair<cudaEvent_t, std::int64_t>> references;
+    auto const getReference = [this, &references](int device)
+    {
+        auto it = references.find(device);
+        if (it == references.end())
+        {
+            int currentDevice;
+            TLLM_CUDA_CHECK(cudaGetDevice(&currentDevice));
+            TLLM_CUDA_CHECK(cudaSetDevice(device));
+            cudaStream_t stream;
+            TLLM_CUDA_CHECK(cudaStreamCreateWithFlags(&stream, cudaStreamNonBlocking));
+            auto* event = acquireEvent();
+            TLLM_CUDA_CHECK(cudaEventRecord(event, stream));
+            TLLM_CUDA_CHECK(cudaEventSynchronize(event));
+            auto const timeNs = toNs(Clock::now());
+            TLLM_CUDA_CHECK(cudaStreamDestroy(stream));
+            TLLM_CUDA_CHECK(cudaSetDevice(currentDevice));
+            it = references.emplace(device, std::make_pair(event, timeNs)).first;
+        }
+        return it->second;
+    };
+
+    common::ChromeTrace trace;
+    auto const pid = static_cast<std::int64_t>(getpid());
+    auto const numRanges = mNumRanges.load(std::memory_order_acquire);
+    for (auto const& ring : rings)
+    {
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        if (ring->records.empty())
+        {
+            continue;
+        }
+        trace.setThreadName(pid, ring->tid, "thread " + std::to_string(ring->tid));
+        bool hasGpuRanges = false;
+        auto const numRecords = ring->records.size();
+        // Oldest first, the next slot to overwrite once the ring is full
+        auto const first = ring->numRecorded > numRecords ? ring->numRecorded % numRecords : 0;
+        for (std::size_t i = 0; i < numRecords; ++i)
+        {
+            auto const& record = ring->records[(first + i) % numRecords];
+            TLLM_CHECK(record.id < numRanges);
+            auto const& range = getRange(record.id);
+            auto const* category = getCategoryName(range.category);
+            trace.addEvent(range.name, category, pid, ring->tid, record.startNs / 1e3,
+                (record.endNs - record.startNs) / 1e3);
+            if (record.gpuEnd == nullptr)
+            {
+                continue;
+            }
+            auto const status = cudaEventQuery(record.gpuEnd);
+            if (status == cudaErrorNotReady)
+            {
+                continue;
+            }
+            TLLM_CUDA_CHECK(status);
+            auto const [reference, referenceNs] = getReference(record.device);
+            float startToReferenceMs{0.f};
+            float durationMs{0.f};
+            TLLM_CUDA_CHECK(cudaEventElapsedTime(&startToReferenceMs, record.gpuStart, reference));
+            TLLM_CUDA_CHECK(cudaEventElapsedTime(&durationMs, record.gpuStart, record.gpuEnd));
+            trace.addEvent(range.name, category, pid, kGpuTrackOffset + ring->tid,
+                (referenceNs - startToReferenceMs * 1e6) / 1e3, durationMs * 1e3, {{"device", record.device}});
+            hasGpuRanges = true;
+        }
+        if (hasGpuRanges)
+        {
+            trace.setThreadName(pid, kGpuTrackOffset + ring->tid, "thread " + std::to_string(ring->tid) + " GPU");
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mEventsMutex);
+        for (auto const& [device, reference] : references)
+        {
+            mFreeEvents.push_back(reference.first);
+        }
+    }
+    return trace;
+}
+
+void RangeProfiler::dump(std::filesystem::path const& path)
+{
+    auto const trace = dump();
+    trace.write(path);
+    TLLM_LOG_INFO("Dumped %zu profiled ranges to %s", trace.getNumEvents(), path.string().c_str());
+}
+
+std::optional<std::filesystem::path> RangeProfiler::dumpOnSloViolation(
+    double latencyMs, double sloMs, std::filesystem::path const& dir, std::chrono::seconds minInterval)
+{
+    if (latencyMs <= sloMs || !isEnabled())
+    {
+        return std::nullopt;
+    }
+    std::filesystem::path path;
+    {
+        std::lock_guard<std::mutex> lock(mSloDumpMutex);
+        auto const now = Clock::now();
+        if (mLastSloDump && now - mLastSloDump.value() < minInterval)
+        {
+            return std::nullopt;
+        }
+        mLastSloDump = now;
+        path = dir
+            / ("trtllm_ranges_" + std::to_string(getpid()) + "_" + std::to_string(mNumSloDumps++) + ".json");
+    }
+    TLLM_LOG_WARNING("Latency of %.3f ms exceeds the objective of %.3f ms, dumping the profiled ranges", latencyMs,
+        sloMs);
+    std::filesystem::create_directories(dir);
+    dump(path);
+    return path;
+}
+
+void RangeProfiler::clear()
+{
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        std::lock_guard<std::mutex> lock(mThreadsMutex);
+        rings = mThreadRings;
+    }
+    for (auto const& ring : rings)
+    {
+        std::lock_guard<std::mutex> lock(ring->mutex);
+        for (auto& record : ring->records)
+        {
+            releaseEvents(record);
+        }
+        ring->records.clear();
+        ring->numRecorded = 0;
+    }
+}
+
+} // namespace tensorrt_llm::runtime
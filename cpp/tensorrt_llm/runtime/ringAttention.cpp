@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ringAttention.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/common/memoryUtils.h"
+
+using namespace tensorrt_llm::runtime;
+namespace tk = tensorrt_llm::kernels;
+namespace tc = tensorrt_llm::common;
+
+RingAttention::RingAttention(SizeType32 maxNumTokens, SizeType32 numHeads, SizeType32 numKvHeads,
+    SizeType32 headSize, nvinfer1::DataType dataType, SizeType32 numShards, SizeType32 shardRank,
+    std::shared_ptr<NcclCommunicator> comm, BufferManager const& manager)
+    : mMaxNumTokens{maxNumTokens}
+    , mNumHeads{numHeads}
+    , mNumKvHeads{numKvHeads}
+    , mHeadSize{headSize}
+    , mDataType{dataType}
+    , mNumShards{numShards}
+    , mShardRank{shardRank}
+    , mComm{std::move(comm)}
+{
+    TLLM_CHECK(mMaxNumTokens > 0);
+    TLLM_CHECK_WITH_INFO(0 <= mShardRank && mShardRank < mNumShards, "Shard %d of %d", mShardRank, mNumShards);
+    TLLM_CHECK_WITH_INFO(mNumShards == 1 || mComm, "Ring attention requires a communicator");
+
+    if (mNumShards > 1)
+    {
+        auto const kvSize = 2 * static_cast<std::size_t>(mMaxNumTokens) * mNumKvHeads * mHeadSize;
+        for (auto& buffer : mKvBuffers)
+        {
+            buffer = manager.gpu(kvSize, mDataType);
+        }
+    }
+    auto const numRows = static_cast<std::size_t>(mMaxNumTokens) * mNumHeads;
+    mAccOut = manager.gpu(numRows * mHeadSize, nvinfer1::DataType::kFLOAT);
+    mAccLse = manager.gpu(numRows, nvinfer1::DataType::kFLOAT);
+}
+
+std::vector<SizeType32> RingAttention::getShardOffsets(std::vector<SizeType32> const& seqLengths, SizeType32 numShards)
+{
+    std::vector<SizeType32> offsets{0};
+    offsets.reserve(seqLengths.size() + 1);
+    for (auto const seqLength : seqLengths)
+    {
+        offsets.push_back(offsets.back() + tc::ceilDiv(seqLength, numShards));
+    }
+    return offsets;
+}
+
+template <typename T>
+void RingAttention::forward(tk::RingAttentionParams<T> params, SizeType32 numTokens, T* out, CudaStream const& stream)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+
+    TLLM_CHECK_WITH_INFO(numTokens <= mMaxNumTokens, "%d tokens exceed the %d tokens of the ring attention buffers",
+        numTokens, mMaxNumTokens);
+    TLLM_CHECK(params.numHeads == mNumHeads && params.numKvHeads == mNumKvHeads && params.headSize == mHeadSize);
+
+    params.qShardIdx = mShardRank;
+    params.accOut = bufferCast<float>(*mAccOut);
+    params.accLse = bufferCast<float>(*mAccLse);
+
+    auto const kvSize = static_cast<std::size_t>(numTokens) * mNumKvHeads * mHeadSize;
+    auto const nextRank = (mShardRank + 1) % mNumShards;
+    auto const prevRank = (mShardRank + mNumShards - 1) % mNumShards;
+    if (mNumShards > 1)
+    {
+        stream.record(mInputReady);
+        mCommStream.wait(mInputReady);
+    }
+
+    // The shard attended at step s is received at step s - 1 into buffer (s - 1) % 2 and forwarded at step s.
+    for (SizeType32 step = 0; step < mNumShards; ++step)
+    {
+        auto const attendedIdx = (step + 1) % 2;
+        auto const receivedIdx = step % 2;
+        T const* k = params.k;
+        T const* v = params.v;
+        if (step > 0)
+        {
+            k = bufferCast<T>(*mKvBuffers[attendedIdx]);
+            v = k + kvSize;
+        }
+
+        if (step + 1 < mNumShards)
+        {
+            // The buffer received into was attended at the previous step, if that step did not attend the local shard.
+            if (step > 1)
+            {
+                mCommStream.wait(mAttended[receivedIdx]);
+            }
+            auto const sentK = IBuffer::wrap(const_cast<T*>(k), kvSize);
+            auto const sentV = IBuffer::wrap(const_cast<T*>(v), kvSize);
+            auto receivedK = IBuffer::slice(mKvBuffers[receivedIdx], 0, kvSize);
+            auto receivedV = IBuffer::slice(mKvBuffers[receivedIdx], kvSize, kvSize);
+            NcclCommunicator::groupStart();
+            mComm->send(*sentK, nextRank, mCommStream);
+            mComm->send(*sentV, nextRank, mCommStream);
+            mComm->receive(*receivedK, prevRank, mCommStream);
+            mComm->receive(*receivedV, prevRank, mCommStream);
+            NcclCommunicator::groupEnd();
+            mCommStream.record(mReceived[receivedIdx]);
+        }
+
+        if (step > 0)
+        {
+            stream.wait(mReceived[attendedIdx]);
+        }
+        params.k = k;
+        params.v = v;
+        params.kvShardIdx = (mShardRank + mNumShards - step) % mNumShards;
+        params.firstStep = step == 0;
+        if (params.firstStep || !tk::isRingAttentionStepMasked(params))
+        {
+            tk::invokeRingAttentionStep(params, stream.get());
+            sync_check_cuda_error();
+        }
+        if (step > 0)
+        {
+            stream.record(mAttended[attendedIdx]);
+        }
+    }
+
+    if (mNumShards > 1)
+    {
+        // The local keys and values must not be overwritten before they are sent.
+        mCommStream.record(mSent);
+        stream.wait(mSent);
+    }
+
+    auto const outSize = static_cast<std::size_t>(numTokens) * mNumHeads * mHeadSize;
+    tc::invokeCudaD2DcpyConvert(out, params.accOut, outSize, stream.get());
+    sync_check_cuda_error();
+
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
+template void RingAttention::forward(
+    tk::RingAttentionParams<float> params, SizeType32 numTokens, float* out, CudaStream const& stream);
+template void RingAttention::forward(
+    tk::RingAttentionParams<half> params, SizeType32 numTokens, half* out, CudaStream const& stream);
+#ifdef ENABLE_BF16
+template void RingAttention::forward(
+    tk::RingAttentionParams<__nv_bfloat16> params, SizeType32 numTokens, __nv_bfloat16* out, CudaStream const& stream);
+#endif
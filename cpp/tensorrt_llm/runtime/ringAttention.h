@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+#include "tensorrt_llm/runtime/ncclCommunicator.h"
+
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Context parallel attention for long prompts (ring attention). The tokens of the sequences are split in
+//! contiguous shards over the ranks of the group, each rank computes the attention of the queries of its shard. The
+//! keys and values of the shards travel around the ring on a communication stream: while a rank attends the shard it
+//! received at the previous step, it forwards that shard to the next rank and receives the following one into a
+//! second buffer. The partial outputs are merged with their log-sum-exp in fp32.
+//! \details With causal attention the shards after the local one are masked, their attention is skipped but they are
+//! still forwarded. The keys and values of the local shard stay where they are, e.g. in the KV cache of the rank.
+class RingAttention
+{
+public:
+    //! \param maxNumTokens Largest number of tokens of the local shard of a batch, padding included.
+    //! \param comm Communicator over the ranks sharing the sequences, ordered by shard.
+    RingAttention(SizeType32 maxNumTokens, SizeType32 numHeads, SizeType32 numKvHeads, SizeType32 headSize,
+        nvinfer1::DataType dataType, SizeType32 numShards, SizeType32 shardRank,
+        std::shared_ptr<NcclCommunicator> comm, BufferManager const& manager);
+
+    //! \brief Offsets of the sequences in the packed shards, the same for all ranks. Each sequence has
+    //! ceil(seqLength / numShards) tokens per shard, the last shards are padded.
+    [[nodiscard]] static std::vector<SizeType32> getShardOffsets(
+        std::vector<SizeType32> const& seqLengths, SizeType32 numShards);
+
+    //! \brief Attention of the queries of the local shard over the whole sequences.
+    //! \param params Parameters of invokeRingAttentionStep, q, k and v are the local shard. The shard indices, the
+    //! accumulators and the first step are set here.
+    //! \param numTokens Number of tokens of the local shard, padding included.
+    //! \param out output buffer [numTokens, numHeads, headSize].
+    template <typename T>
+    void forward(kernels::RingAttentionParams<T> params, SizeType32 numTokens, T* out, CudaStream const& stream);
+
+private:
+    SizeType32 mMaxNumTokens;
+    SizeType32 mNumHeads;
+    SizeType32 mNumKvHeads;
+    SizeType32 mHeadSize;
+    nvinfer1::DataType mDataType;
+    SizeType32 mNumShards;
+    SizeType32 mShardRank;
+    std::shared_ptr<NcclCommunicator> mComm;
+    CudaStream mCommStream;
+    // Keys and values of the shards received from the previous rank, [2, maxNumTokens, numKvHeads, headSize] each
+    std::array<IBuffer::SharedPtr, 2> mKvBuffers;
+    // Attention of the shard in the buffer done, it can be overwritten
+    std::array<CudaEvent, 2> mAttended;
+    std::array<CudaEvent, 2> mReceived;
+    CudaEvent mInputReady;
+    CudaEvent mSent;
+    // [maxNumTokens, numHeads, headSize] and [maxNumTokens, numHeads], fp32 output and log-sum-exp so far
+    IBuffer::SharedPtr mAccOut;
+    IBuffer::SharedPtr mAccLse;
+};
+
+} // namespace tensorrt_llm::runtime
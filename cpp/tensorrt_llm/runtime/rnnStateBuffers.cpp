@@ -15,6 +15,7 @@
  */
 
 #include "tensorrt_llm/runtime/rnnStateBuffers.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/runtime/runtimeBuffers.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
 
@@ -217,6 +218,11 @@ void RnnStateBuffers::prepareContextStep(RuntimeBuffers* runtimeBuffers, BufferM
     std::fill_n(RequestTypesPtr, batchSize, 0);
 
     manager.setZero(*convStates);
+    if (tc::getEnvEnableRnnStateReuse())
+    {
+        // The context phase starts from the state in the slot, see RnnStatePool
+        manager.setZero(*rnnStates);
+    }
     if (slotMappingDevice != nullptr)
     {
         manager.copy(*slotMappingHost, *slotMappingDevice);
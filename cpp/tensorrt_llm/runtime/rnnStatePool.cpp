@@ -0,0 +1,275 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/rnnStatePool.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/logger.h"
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+constexpr SizeType32 kNoParent{-1};
+
+ITensor::SharedPtr allocatePool(
+    ITensor const& state, SizeType32 numLayers, SizeType32 capacity, BufferManager const& manager, bool onGpu)
+{
+    auto shape = state.getShape();
+    shape.d[0] = static_cast<ITensor::DimType64>(capacity) * numLayers;
+    return onGpu ? ITensor::SharedPtr{manager.gpu(shape, state.getDataType())}
+                 : ITensor::SharedPtr{BufferManager::pinned(shape, state.getDataType())};
+}
+} // namespace
+
+RnnStatePool::RnnStatePool(RnnStateBuffers const& buffers, Config const& config, BufferManager const& manager)
+    : mConfig{config}
+    , mManager{manager}
+    , mNumLayers{static_cast<SizeType32>(buffers.rnnState.size())}
+{
+    TLLM_CHECK(mConfig.tokensPerBlock > 0);
+    TLLM_CHECK_WITH_INFO(mConfig.maxGpuCheckpoints > 0, "The RNN state pool needs at least one GPU checkpoint");
+    TLLM_CHECK(mConfig.maxHostCheckpoints >= 0);
+    TLLM_CHECK_WITH_INFO(mNumLayers > 0, "The RNN state buffers have no layer");
+    TLLM_CHECK(buffers.convState.size() == buffers.rnnState.size());
+
+    auto const initPool = [&](Pool& pool, SizeType32 capacity, bool onGpu)
+    {
+        if (capacity == 0)
+        {
+            return;
+        }
+        pool.rnnStates = allocatePool(*buffers.rnnState.front(), mNumLayers, capacity, mManager, onGpu);
+        pool.convStates = allocatePool(*buffers.convState.front(), mNumLayers, capacity, mManager, onGpu);
+        for (SizeType32 index = capacity - 1; index >= 0; --index)
+        {
+            pool.freeIndices.push_back(index);
+        }
+    };
+    initPool(mGpuPool, mConfig.maxGpuCheckpoints, true);
+    initPool(mHostPool, mConfig.maxHostCheckpoints, false);
+}
+
+RnnStatePool::NodeId RnnStatePool::getRoot(std::uint64_t salt)
+{
+    auto it = mRoots.find(salt);
+    if (it != mRoots.end())
+    {
+        return it->second;
+    }
+    auto const id = mNextNodeId++;
+    mNodes.emplace(id, Node{kNoParent});
+    mRoots.emplace(salt, id);
+    return id;
+}
+
+RnnStatePool::Pool& RnnStatePool::getPool(Tier tier)
+{
+    TLLM_CHECK(tier != Tier::kNONE);
+    return tier == Tier::kGPU ? mGpuPool : mHostPool;
+}
+
+void RnnStatePool::checkpoint(VecTokens const& tokens, SizeType32 numTokens, SizeType32 slot,
+    RnnStateBuffers const& buffers, std::uint64_t salt)
+{
+    TLLM_CHECK_WITH_INFO(numTokens > 0 && numTokens % mConfig.tokensPerBlock == 0,
+        "Checkpoints are taken at whole blocks of %d tokens, not after %d tokens", mConfig.tokensPerBlock, numTokens);
+    TLLM_CHECK(static_cast<std::size_t>(numTokens) <= tokens.size());
+
+    auto nodeId = getRoot(salt);
+    for (SizeType32 start = 0; start < numTokens; start += mConfig.tokensPerBlock)
+    {
+        VecTokens blockTokens(tokens.begin() + start, tokens.begin() + start + mConfig.tokensPerBlock);
+        auto& node = mNodes.at(nodeId);
+        auto it = node.children.find(blockTokens);
+        if (it == node.children.end())
+        {
+            auto const childId = mNextNodeId++;
+            it = node.children.emplace(blockTokens, childId).first;
+            mNodes.emplace(childId, Node{nodeId, std::move(blockTokens)});
+        }
+        nodeId = it->second;
+    }
+
+    if (mNodes.at(nodeId).tier != Tier::kNONE)
+    {
+        // The state of a prefix does not depend on the request it was computed for.
+        touch(nodeId);
+        return;
+    }
+    auto const index = acquireIndex(Tier::kGPU);
+    copyState(buffers, slot, mGpuPool, index, false);
+    auto& node = mNodes.at(nodeId);
+    node.tier = Tier::kGPU;
+    node.index = index;
+    node.lruIt = mGpuPool.lru.insert(mGpuPool.lru.end(), nodeId);
+    ++mStats.numGpuCheckpoints;
+}
+
+SizeType32 RnnStatePool::restore(
+    VecTokens const& tokens, SizeType32 slot, RnnStateBuffers const& buffers, std::uint64_t salt)
+{
+    auto const root = mRoots.find(salt);
+    auto const maxBlocks = tokens.empty() ? 0 : static_cast<SizeType32>(tokens.size() - 1) / mConfig.tokensPerBlock;
+
+    std::optional<NodeId> bestId;
+    SizeType32 bestBlocks{0};
+    auto nodeId = root != mRoots.end() ? root->second : kNoParent;
+    for (SizeType32 bi = 0; bi < maxBlocks && nodeId != kNoParent; ++bi)
+    {
+        auto const& node = mNodes.at(nodeId);
+        auto const begin = tokens.begin() + bi * mConfig.tokensPerBlock;
+        auto it = node.children.find(VecTokens(begin, begin + mConfig.tokensPerBlock));
+        if (it == node.children.end())
+        {
+            break;
+        }
+        nodeId = it->second;
+        if (mNodes.at(nodeId).tier != Tier::kNONE)
+        {
+            bestId = nodeId;
+            bestBlocks = bi + 1;
+        }
+    }
+
+    if (!bestId)
+    {
+        ++mStats.numMisses;
+        return 0;
+    }
+    auto const& best = mNodes.at(*bestId);
+    copyState(buffers, slot, getPool(best.tier), best.index, true);
+    touch(*bestId);
+
+    auto const numTokens = bestBlocks * mConfig.tokensPerBlock;
+    ++mStats.numHits;
+    mStats.numRestoredTokens += numTokens;
+    TLLM_LOG_DEBUG("Restored the RNN state of %d prompt tokens into slot %d", numTokens, slot);
+    return numTokens;
+}
+
+SizeType32 RnnStatePool::acquireIndex(Tier tier)
+{
+    auto& pool = getPool(tier);
+    if (!pool.freeIndices.empty())
+    {
+        auto const index = pool.freeIndices.back();
+        pool.freeIndices.pop_back();
+        return index;
+    }
+    TLLM_CHECK(!pool.lru.empty());
+    auto const victimId = pool.lru.front();
+    auto& victim = mNodes.at(victimId);
+
+    if (tier == Tier::kGPU && mConfig.maxHostCheckpoints > 0)
+    {
+        // Offload to the host pool. The copies are ordered on the stream of the manager, so the GPU checkpoint can be
+        // overwritten right away.
+        auto const hostIndex = acquireIndex(Tier::kHOST);
+        copyCheckpoint(mGpuPool, victim.index, mHostPool, hostIndex);
+        auto const index = victim.index;
+        mGpuPool.lru.erase(victim.lruIt);
+        victim.tier = Tier::kHOST;
+        victim.index = hostIndex;
+        victim.lruIt = mHostPool.lru.insert(mHostPool.lru.end(), victimId);
+        --mStats.numGpuCheckpoints;
+        ++mStats.numHostCheckpoints;
+        return index;
+    }
+
+    dropCheckpoint(victimId);
+    auto const index = pool.freeIndices.back();
+    pool.freeIndices.pop_back();
+    return index;
+}
+
+void RnnStatePool::dropCheckpoint(NodeId nodeId)
+{
+    auto& node = mNodes.at(nodeId);
+    auto& pool = getPool(node.tier);
+    pool.lru.erase(node.lruIt);
+    pool.freeIndices.push_back(node.index);
+    if (node.tier == Tier::kGPU)
+    {
+        --mStats.numGpuCheckpoints;
+    }
+    else
+    {
+        --mStats.numHostCheckpoints;
+    }
+    node.tier = Tier::kNONE;
+    prune(nodeId);
+}
+
+void RnnStatePool::prune(NodeId nodeId)
+{
+    while (true)
+    {
+        auto const& node = mNodes.at(nodeId);
+        if (node.parent == kNoParent || node.tier != Tier::kNONE || !node.children.empty())
+        {
+            return;
+        }
+        auto const parentId = node.parent;
+        mNodes.at(parentId).children.erase(node.blockTokens);
+        mNodes.erase(nodeId);
+        nodeId = parentId;
+    }
+}
+
+void RnnStatePool::touch(NodeId nodeId)
+{
+    auto& node = mNodes.at(nodeId);
+    auto& pool = getPool(node.tier);
+    pool.lru.splice(pool.lru.end(), pool.lru, node.lruIt);
+}
+
+void RnnStatePool::copyState(
+    RnnStateBuffers const& buffers, SizeType32 slot, Pool& pool, SizeType32 index, bool toSlot) const
+{
+    auto const copy = [&](TensorPtr const& states, TensorPtr const& pooled, SizeType32 layer)
+    {
+        auto slotState = ITensor::slice(states, slot, 1);
+        auto checkpointState = ITensor::slice(pooled, index * mNumLayers + layer, 1);
+        if (toSlot)
+        {
+            mManager.copy(*checkpointState, *slotState);
+        }
+        else
+        {
+            mManager.copy(*slotState, *checkpointState);
+        }
+    };
+    for (SizeType32 layer = 0; layer < mNumLayers; ++layer)
+    {
+        copy(buffers.rnnState[layer], pool.rnnStates, layer);
+        copy(buffers.convState[layer], pool.convStates, layer);
+    }
+}
+
+void RnnStatePool::copyCheckpoint(Pool& src, SizeType32 srcIndex, Pool& dst, SizeType32 dstIndex) const
+{
+    // The layers of a checkpoint are contiguous.
+    auto srcRnn = ITensor::slice(src.rnnStates, srcIndex * mNumLayers, mNumLayers);
+    auto dstRnn = ITensor::slice(dst.rnnStates, dstIndex * mNumLayers, mNumLayers);
+    mManager.copy(*srcRnn, *dstRnn);
+    auto srcConv = ITensor::slice(src.convStates, srcIndex * mNumLayers, mNumLayers);
+    auto dstConv = ITensor::slice(dst.convStates, dstIndex * mNumLayers, mNumLayers);
+    mManager.copy(*srcConv, *dstConv);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/rnnStateBuffers.h"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Checkpoints of the recurrent and conv states of all local layers, keyed by the prompt prefix they were
+//! computed from, so that a request sharing a prefix resumes its context phase after it.
+//! \details Unlike the KV cache, the state of a recurrent layer summarizes the whole prefix, so it can only be reused
+//! at the positions where it was checkpointed. The caller checkpoints the slot of a request at whole blocks of
+//! tokensPerBlock tokens, e.g. after each chunk of its context phase, and restores the longest checkpointed prefix
+//! into the slot of a new request before its context phase. The plugins start from the state in the slot when
+//! TRTLLM_ENABLE_RNN_STATE_REUSE=1, which requires paged state.
+//! Checkpoints live in a GPU pool. The least recently used ones move to a pinned host pool when it is full, and are
+//! restored from there without returning to the GPU pool. The least recently used host checkpoints are dropped.
+class RnnStatePool
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using VecTokens = std::vector<TokenIdType>;
+
+    struct Config
+    {
+        //! Granularity of the checkpoints
+        SizeType32 tokensPerBlock{64};
+        SizeType32 maxGpuCheckpoints{64};
+        SizeType32 maxHostCheckpoints{256};
+    };
+
+    struct Stats
+    {
+        SizeType32 numGpuCheckpoints{0};
+        SizeType32 numHostCheckpoints{0};
+        //! Restores that found a checkpoint, and the prompt tokens they skipped
+        SizeType32 numHits{0};
+        SizeType32 numMisses{0};
+        std::int64_t numRestoredTokens{0};
+    };
+
+    //! \param buffers The state buffers the checkpoints are taken from and restored into. Only their per-layer
+    //! tensors are used, indexed by slot.
+    RnnStatePool(RnnStateBuffers const& buffers, Config const& config, BufferManager const& manager);
+
+    //! \brief Save the state of a slot after the first numTokens tokens of a prompt, a multiple of tokensPerBlock.
+    //! \param salt Distinguishes prompts whose states differ for the same tokens, e.g. the LoRA task id.
+    void checkpoint(VecTokens const& tokens, SizeType32 numTokens, SizeType32 slot, RnnStateBuffers const& buffers,
+        std::uint64_t salt = 0);
+
+    //! \brief Restore the checkpoint of the longest prefix of a prompt into a slot. The last token of the prompt is
+    //! never covered, the context phase needs it to produce the first logits.
+    //! \return The number of prompt tokens the slot state covers, 0 if no checkpoint was found.
+    [[nodiscard]] SizeType32 restore(
+        VecTokens const& tokens, SizeType32 slot, RnnStateBuffers const& buffers, std::uint64_t salt = 0);
+
+    [[nodiscard]] Stats const& getStats() const
+    {
+        return mStats;
+    }
+
+private:
+    using NodeId = SizeType32;
+
+    enum class Tier : std::int8_t
+    {
+        kNONE = 0,
+        kGPU = 1,
+        kHOST = 2,
+    };
+
+    struct Node
+    {
+        NodeId parent;
+        VecTokens blockTokens;
+        std::map<VecTokens, NodeId> children;
+        Tier tier{Tier::kNONE};
+        SizeType32 index{0};
+        std::list<NodeId>::iterator lruIt;
+    };
+
+    //! \brief Pool of checkpoints in one memory type, one per index.
+    struct Pool
+    {
+        TensorPtr rnnStates;  // [capacity * layer_count, state_size, rnn_hidden_size]
+        TensorPtr convStates; // [capacity * layer_count, conv_kernel - 1, rnn_hidden_size]
+        std::vector<SizeType32> freeIndices;
+        // Checkpoints of the pool, least recently used first
+        std::list<NodeId> lru;
+    };
+
+    NodeId getRoot(std::uint64_t salt);
+
+    Pool& getPool(Tier tier);
+
+    //! \brief Take a free index of a pool, moving or dropping its least recently used checkpoint if it is full.
+    SizeType32 acquireIndex(Tier tier);
+
+    void dropCheckpoint(NodeId node);
+
+    //! \brief Copy between a slot of the state buffers and a checkpoint, in either direction.
+    void copyState(RnnStateBuffers const& buffers, SizeType32 slot, Pool& pool, SizeType32 index, bool toSlot) const;
+
+    void copyCheckpoint(Pool& src, SizeType32 srcIndex, Pool& dst, SizeType32 dstIndex) const;
+
+    void touch(NodeId node);
+
+    //! \brief Remove a node and its ancestors that no longer have a checkpoint or children.
+    void prune(NodeId node);
+
+    Config const mConfig;
+    BufferManager const& mManager;
+    SizeType32 mNumLayers;
+    Pool mGpuPool;
+    Pool mHostPool;
+    std::map<NodeId, Node> mNodes;
+    std::map<std::uint64_t, NodeId> mRoots;
+    NodeId mNextNodeId{0};
+    Stats mStats;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/rooflineModel.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/runtime/iBuffer.h"
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+bool contains(std::string const& value, char const* part)
+{
+    return value.find(part) != std::string::npos;
+}
+} // namespace
+
+GpuPeaks GpuPeaks::fromDevice(int device)
+{
+    auto const getAttribute = [device](cudaDeviceAttr attribute)
+    {
+        int value;
+        TLLM_CUDA_CHECK(cudaDeviceGetAttribute(&value, attribute, device));
+        return static_cast<double>(value);
+    };
+    auto const numSms = getAttribute(cudaDevAttrMultiProcessorCount);
+    auto const clockKhz = getAttribute(cudaDevAttrClockRate);
+    auto const memoryClockKhz = getAttribute(cudaDevAttrMemoryClockRate);
+    auto const busWidthBits = getAttribute(cudaDevAttrGlobalMemoryBusWidth);
+    auto const major = getAttribute(cudaDevAttrComputeCapabilityMajor);
+    auto const minor = getAttribute(cudaDevAttrComputeCapabilityMinor);
+
+    // Dense 16-bit tensor core FLOP per clock per SM
+    auto flopsPerClock = 1024.;
+    if (major >= 9)
+    {
+        flopsPerClock = 4096.;
+    }
+    else if (major == 8 && minor == 0)
+    {
+        flopsPerClock = 2048.;
+    }
+    // Double data rate
+    return GpuPeaks{numSms * clockKhz * 1e3 * flopsPerClock, 2. * memoryClockKhz * 1e3 * busWidthBits / 8.};
+}
+
+RooflineModel::RooflineModel(ModelConfig const& modelConfig, WorldConfig const& worldConfig, GpuPeaks const& peaks)
+    : mModelConfig{modelConfig}
+    , mTensorParallelism{worldConfig.getTensorParallelism()}
+    , mPeaks{peaks}
+    , mActivationBytes{static_cast<double>(BufferDataType(modelConfig.getDataType()).getSize())}
+    , mKvBytes{static_cast<double>(BufferDataType(modelConfig.getKvDataType()).getSize())}
+{
+    TLLM_CHECK_WITH_INFO(peaks.flopsPerSec > 0 && peaks.bytesPerSec > 0, "GPU peaks must be positive");
+    auto const quantMode = modelConfig.getQuantMode();
+    if (quantMode.hasInt4Weights() || quantMode.hasFp4Weights())
+    {
+        mWeightBytes = 0.5;
+    }
+    else if (quantMode.hasInt8Weights() || quantMode.hasFp8Qdq())
+    {
+        mWeightBytes = 1.;
+    }
+    else
+    {
+        mWeightBytes = mActivationBytes;
+    }
+    auto const has8BitActivations = quantMode.hasFp8Qdq() || quantMode.hasActivations();
+    mGemmFlopsPerSec = has8BitActivations ? 2. * peaks.flopsPerSec : peaks.flopsPerSec;
+}
+
+RooflineModel::Kind RooflineModel::classify(std::string const& layerName)
+{
+    if (contains(layerName, "lm_head"))
+    {
+        return Kind::kLM_HEAD_GEMM;
+    }
+    if (contains(layerName, "attention/qkv"))
+    {
+        return Kind::kQKV_GEMM;
+    }
+    if (contains(layerName, "attention/dense"))
+    {
+        return Kind::kATTENTION_DENSE_GEMM;
+    }
+    if (contains(layerName, "mlp/fc") || contains(layerName, "mlp/gate"))
+    {
+        return Kind::kMLP_FC_GEMM;
+    }
+    if (contains(layerName, "mlp/proj"))
+    {
+        return Kind::kMLP_PROJ_GEMM;
+    }
+    if (contains(layerName, "GPTAttention"))
+    {
+        return Kind::kATTENTION;
+    }
+    if (contains(layerName, "layernorm") || contains(layerName, "rmsnorm") || contains(layerName, "ln_f"))
+    {
+        return Kind::kNORM;
+    }
+    return Kind::kOTHER;
+}
+
+char const* RooflineModel::getKindName(Kind kind)
+{
+    switch (kind)
+    {
+    case Kind::kQKV_GEMM: return "qkv_gemm";
+    case Kind::kATTENTION: return "attention";
+    case Kind::kATTENTION_DENSE_GEMM: return "attention_dense_gemm";
+    case Kind::kMLP_FC_GEMM: return "mlp_fc_gemm";
+    case Kind::kMLP_PROJ_GEMM: return "mlp_proj_gemm";
+    case Kind::kLM_HEAD_GEMM: return "lm_head_gemm";
+    case Kind::kNORM: return "norm";
+    case Kind::kOTHER: return "other";
+    }
+    return "unknown";
+}
+
+std::pair<double, double> RooflineModel::estimateGemm(double k, double n, double numTokens, double numForwards) const
+{
+    auto const flops = 2. * numTokens * k * n;
+    auto const bytes = numForwards * k * n * mWeightBytes + numTokens * (k + n) * mActivationBytes;
+    return {flops, bytes};
+}
+
+std::pair<double, double> RooflineModel::estimate(Kind kind, RooflineWorkload const& workload) const
+{
+    auto const batchSize = static_cast<double>(workload.batchSize);
+    auto const inputLength = static_cast<double>(workload.inputLength);
+    auto const numGenerationSteps = static_cast<double>(std::max(workload.outputLength - 1, 0));
+    auto const generationBatchSize = batchSize * workload.beamWidth;
+    auto const numForwards = 1. + numGenerationSteps;
+    auto const numTokens = batchSize * inputLength + numGenerationSteps * generationBatchSize;
+
+    auto const hiddenSize = static_cast<double>(mModelConfig.getHiddenSize()) * mTensorParallelism;
+    auto const sizePerHead = static_cast<double>(mModelConfig.getSizePerHead());
+    auto const numHeads = static_cast<double>(mModelConfig.getNbHeads());
+    auto const numKvHeads = static_cast<double>(mModelConfig.getNbKvHeads());
+    auto const mlpHiddenSize = static_cast<double>(mModelConfig.getMlpHiddenSize());
+
+    switch (kind)
+    {
+    case Kind::kQKV_GEMM:
+        return estimateGemm(hiddenSize, (numHeads + 2. * numKvHeads) * sizePerHead, numTokens, numForwards);
+    case Kind::kATTENTION_DENSE_GEMM:
+        return estimateGemm(numHeads * sizePerHead, hiddenSize, numTokens, numForwards);
+    case Kind::kMLP_FC_GEMM: return estimateGemm(hiddenSize, mlpHiddenSize, numTokens, numForwards);
+    case Kind::kMLP_PROJ_GEMM: return estimateGemm(mlpHiddenSize, hiddenSize, numTokens, numForwards);
+    case Kind::kLM_HEAD_GEMM:
+    {
+        // Logits of the last context token only
+        auto const vocabSize = static_cast<double>(mModelConfig.getVocabSizePadded(mTensorParallelism))
+            / mTensorParallelism;
+        return estimateGemm(hiddenSize, vocabSize, batchSize + numGenerationSteps * generationBatchSize, numForwards);
+    }
+    case Kind::kATTENTION:
+    {
+        // Context: causal QK^T and PV, reading Q, K, V, writing the output and the KV cache
+        auto flops = 2. * batchSize * inputLength * inputLength * numHeads * sizePerHead;
+        auto bytes = batchSize * inputLength * sizePerHead
+            * ((2. * numHeads + 2. * numKvHeads) * mActivationBytes + 2. * numKvHeads * mKvBytes);
+        // Generation: every step reads the KV cache of its sequence up to the step
+        auto const sumKvLengths
+            = numGenerationSteps * inputLength + numGenerationSteps * (numGenerationSteps + 1.) / 2.;
+        flops += 4. * generationBatchSize * sumKvLengths * numHeads * sizePerHead;
+        bytes += generationBatchSize * sumKvLengths * 2. * numKvHeads * sizePerHead * mKvBytes;
+        return {flops, bytes};
+    }
+    case Kind::kNORM:
+        // Elementwise, read and write
+        return {5. * numTokens * hiddenSize, 2. * numTokens * hiddenSize * mActivationBytes};
+    case Kind::kOTHER: break;
+    }
+    return {0., 0.};
+}
+
+std::vector<LayerEfficiency> RooflineModel::analyze(std::vector<std::pair<std::string, float>> const& layerTimesMs,
+    RooflineWorkload const& workload, SizeType32 numRuns) const
+{
+    std::vector<LayerEfficiency> layers;
+    layers.reserve(layerTimesMs.size());
+    for (auto const& [name, timeMs] : layerTimesMs)
+    {
+        LayerEfficiency layer{name, classify(name), timeMs};
+        auto const [flops, bytes] = estimate(layer.kind, workload);
+        layer.flops = flops * numRuns;
+        layer.bytes = bytes * numRuns;
+        auto const flopsPerSec = layer.kind == Kind::kATTENTION || layer.kind == Kind::kNORM ? mPeaks.flopsPerSec
+                                                                                             : mGemmFlopsPerSec;
+        layer.rooflineTimeMs
+            = static_cast<float>(std::max(layer.flops / flopsPerSec, layer.bytes / mPeaks.bytesPerSec) * 1e3);
+        layers.emplace_back(std::move(layer));
+    }
+    std::stable_sort(layers.begin(), layers.end(),
+        [](auto const& lhs, auto const& rhs) { return lhs.getLostTimeMs() > rhs.getLostTimeMs(); });
+    return layers;
+}
+
+std::string RooflineModel::report(std::vector<LayerEfficiency> const& layers, std::size_t numFlagged) const
+{
+    auto const ridgeIntensity = mGemmFlopsPerSec / mPeaks.bytesPerSec;
+    std::ostringstream os;
+    os << common::fmtstr("=== Roofline: peak %.1f TFLOP/s (GEMMs %.1f), %.1f GB/s, ridge at %.1f FLOP/B ===\n",
+        mPeaks.flopsPerSec * 1e-12, mGemmFlopsPerSec * 1e-12, mPeaks.bytesPerSec * 1e-9, ridgeIntensity);
+    os << "  time(ms)  roof(ms)  lost(ms)   TFLOP/s      GB/s    FLOP/B   eff(%)  kind                  layer\n";
+
+    struct KindTotals
+    {
+        double timeMs{0};
+        double rooflineTimeMs{0};
+        double memoryBoundTimeMs{0};
+    };
+
+    std::map<Kind, KindTotals> totals;
+    double totalTimeMs{0};
+    for (std::size_t i = 0; i < layers.size(); ++i)
+    {
+        auto const& layer = layers[i];
+        totalTimeMs += layer.timeMs;
+        auto& kindTotals = totals[layer.kind];
+        kindTotals.timeMs += layer.timeMs;
+        kindTotals.rooflineTimeMs += layer.rooflineTimeMs;
+        auto const memoryBound = layer.getArithmeticIntensity() < ridgeIntensity;
+        if (memoryBound)
+        {
+            kindTotals.memoryBoundTimeMs += layer.timeMs;
+        }
+        os << (i < numFlagged && layer.getLostTimeMs() > 0.f ? "*" : " ")
+           << common::fmtstr("%9.3f %9.3f %9.3f %9.2f %9.1f %9.1f %8.1f  %-22s", layer.timeMs, layer.rooflineTimeMs,
+                  layer.getLostTimeMs(), layer.getAchievedFlopsPerSec() * 1e-12,
+                  layer.getAchievedBytesPerSec() * 1e-9, layer.getArithmeticIntensity(), layer.getEfficiency() * 100.,
+                  getKindName(layer.kind))
+           << layer.name << (layer.flops > 0. ? (memoryBound ? " [memory bound]" : " [compute bound]") : "") << "\n";
+    }
+
+    os << "\n=== Per kind ===\n  time(ms)  share(%)   eff(%)  memory bound(%)  kind\n";
+    for (auto const& [kind, kindTotals] : totals)
+    {
+        os << common::fmtstr(" %9.3f %9.1f %8.1f %16.1f  ", kindTotals.timeMs,
+            totalTimeMs > 0. ? kindTotals.timeMs / totalTimeMs * 100. : 0.,
+            kindTotals.timeMs > 0. ? kindTotals.rooflineTimeMs / kindTotals.timeMs * 100. : 0.,
+            kindTotals.timeMs > 0. ? kindTotals.memoryBoundTimeMs / kindTotals.timeMs * 100. : 0.)
+           << getKindName(kind) << "\n";
+    }
+    os << "\nMemory bound GEMMs gain from weight quantization and larger batches, compute bound GEMMs far from the "
+          "roof from other tactics or FP8, and norms and other layers from fusion.\n";
+    return os.str();
+}
+
+} // namespace tensorrt_llm::runtime
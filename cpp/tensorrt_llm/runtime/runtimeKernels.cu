@@ -19,8 +19,10 @@
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/common/reduceKernelUtils.cuh"
 #include "tensorrt_llm/kernels/speculativeDecoding/kvCacheUpdateKernels.h"
+#include "tensorrt_llm/runtime/decodingOutput.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
 
+#include <cfloat>
 #include <cub/cub.cuh>
 #include <cuda_fp16.h>
 #include <cuda_runtime.h>
@@ -178,6 +180,249 @@ void invokeCopyBatch(IBuffer const& srcBuffer, IBuffer& dstBuffer, IBuffer const
         srcDataPtr, dstDataPtr, srcOffsetsPtr, dstOffsetsPtr, sizesPtr, static_cast<int32_t>(dataTypeSize));
 }
 
+namespace
+{
+template <typename VecT>
+__global__ void copyBlocks(void const* const* srcPointers, void* const* dstPointers, std::size_t blockSize)
+{
+    auto const* src = reinterpret_cast<VecT const*>(srcPointers[blockIdx.y]);
+    auto* dst = reinterpret_cast<VecT*>(dstPointers[blockIdx.y]);
+    auto const tidx = static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    auto const stride = static_cast<std::size_t>(blockDim.x) * gridDim.x;
+
+    for (auto idx = tidx; idx < blockSize; idx += stride)
+    {
+        dst[idx] = src[idx];
+    }
+}
+
+template <typename VecT>
+void launchCopyBlocks(void const* const* srcPointers, void* const* dstPointers, std::size_t blockSizeInBytes,
+    std::uint32_t numBlocks, CudaStream const& stream)
+{
+    auto const blockSize = blockSizeInBytes / sizeof(VecT);
+    dim3 const threads{256};
+    // Cap the CTAs per copy, the y dimension already spreads the copies over the SMs
+    std::size_t const gridx{std::min(tc::ceilDiv(blockSize, threads.x), std::size_t{64})};
+    dim3 const grid{static_cast<std::uint32_t>(gridx), numBlocks};
+    copyBlocks<VecT><<<grid, threads, 0, stream.get()>>>(srcPointers, dstPointers, blockSize);
+}
+} // namespace
+
+void invokeCopyBlocks(
+    IBuffer const& srcPointers, IBuffer const& dstPointers, std::size_t blockSizeInBytes, CudaStream const& stream)
+{
+    TLLM_CHECK_WITH_INFO(srcPointers.getSize() == dstPointers.getSize(), "Number of sources and destinations differ");
+    auto const numBlocks = srcPointers.getSize();
+    if (numBlocks == 0)
+    {
+        return;
+    }
+    TLLM_CHECK(numBlocks <= std::numeric_limits<std::uint16_t>::max());
+    auto const* srcPtrs = bufferCast<void*>(srcPointers);
+    auto const* dstPtrs = bufferCast<void*>(dstPointers);
+    auto const numBlocks32 = static_cast<std::uint32_t>(numBlocks);
+
+    // Pools are allocated with at least 256 byte alignment, the vector width only depends on the block size.
+    if (blockSizeInBytes % sizeof(uint4) == 0)
+    {
+        launchCopyBlocks<uint4>(srcPtrs, dstPtrs, blockSizeInBytes, numBlocks32, stream);
+    }
+    else if (blockSizeInBytes % sizeof(uint2) == 0)
+    {
+        launchCopyBlocks<uint2>(srcPtrs, dstPtrs, blockSizeInBytes, numBlocks32, stream);
+    }
+    else if (blockSizeInBytes % sizeof(uint32_t) == 0)
+    {
+        launchCopyBlocks<uint32_t>(srcPtrs, dstPtrs, blockSizeInBytes, numBlocks32, stream);
+    }
+    else
+    {
+        launchCopyBlocks<uint8_t>(srcPtrs, dstPtrs, blockSizeInBytes, numBlocks32, stream);
+    }
+}
+
+namespace
+{
+__global__ void initNewRequests(NewRequestsBuffers const buffers, NewRequestSetup const* setups)
+{
+    auto const& setup = setups[blockIdx.y];
+    auto const tidx = static_cast<std::size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    auto const stride = static_cast<std::size_t>(blockDim.x) * gridDim.x;
+
+    auto const batchSlot = static_cast<std::size_t>(setup.batchSlot);
+    auto const maxBeamWidth = static_cast<std::size_t>(buffers.maxBeamWidth);
+    auto const maxSequenceLength = static_cast<std::size_t>(buffers.maxSequenceLength);
+    auto const beamsOffset = batchSlot * maxBeamWidth;
+    auto const sequencesOffset = beamsOffset * maxSequenceLength;
+
+    // The input ids of every beam, padded with the end id
+    auto const outputSize = static_cast<std::size_t>(setup.beamWidth) * maxSequenceLength;
+    for (auto idx = tidx; idx < outputSize; idx += stride)
+    {
+        auto const column = idx % maxSequenceLength;
+        buffers.outputIds[sequencesOffset + idx]
+            = column < static_cast<std::size_t>(setup.numInputIds) ? setup.inputIds[column] : setup.endId;
+        if (setup.beamWidth > 1)
+        {
+            buffers.parentIds[sequencesOffset + idx] = 0;
+        }
+    }
+
+    if (setup.zeroLogProbs)
+    {
+        for (auto idx = tidx; idx < maxBeamWidth * maxSequenceLength; idx += stride)
+        {
+            buffers.logProbs[sequencesOffset + idx] = 0.f;
+        }
+    }
+
+    if (setup.zeroEmbeddingBias)
+    {
+        auto const vocabSizePadded = static_cast<std::size_t>(buffers.vocabSizePadded);
+        for (auto idx = tidx; idx < vocabSizePadded; idx += stride)
+        {
+            buffers.embeddingBias[batchSlot * vocabSizePadded + idx] = 0.f;
+        }
+    }
+
+    for (auto idx = tidx; idx < maxBeamWidth; idx += stride)
+    {
+        buffers.endIds[beamsOffset + idx] = setup.endId;
+        buffers.lengths[beamsOffset + idx] = setup.inputLength;
+        if (setup.zeroCumLogProbs)
+        {
+            // Only the first beam is live at the start of beam search
+            auto const isDeadBeam = idx > 0 && idx < static_cast<std::size_t>(setup.beamWidth);
+            buffers.cumLogProbs[beamsOffset + idx] = isDeadBeam ? DecodingOutput::kNegativeInfinity : 0.f;
+        }
+    }
+
+    auto const maxBatchSize = static_cast<std::size_t>(buffers.maxBatchSize);
+    for (auto idx = tidx; idx < static_cast<std::size_t>(buffers.maxTokensPerStep) * maxBeamWidth; idx += stride)
+    {
+        auto const step = idx / maxBeamWidth;
+        auto const beam = idx % maxBeamWidth;
+        auto const stepIdx = (step * maxBatchSize + batchSlot) * maxBeamWidth + beam;
+        buffers.newTokensSteps[stepIdx] = 0;
+        buffers.finishedSteps[stepIdx] = 0;
+    }
+
+    if (tidx == 0)
+    {
+        buffers.sequenceLimitLength[batchSlot] = setup.sequenceLimitLength;
+        buffers.finishedSum[batchSlot] = 0;
+    }
+}
+} // namespace
+
+void invokeInitNewRequests(
+    NewRequestsBuffers const& buffers, IBuffer const& setups, SizeType32 numRequests, CudaStream const& stream)
+{
+    if (numRequests == 0)
+    {
+        return;
+    }
+    TLLM_CHECK(setups.getSizeInBytes() >= numRequests * sizeof(NewRequestSetup));
+    TLLM_CHECK(numRequests <= std::numeric_limits<std::uint16_t>::max());
+
+    dim3 const blockSize{256};
+    // Enough CTAs for the largest row of a request, the y dimension spreads the requests over the SMs
+    auto const maxRowSize = std::max(static_cast<std::size_t>(buffers.maxBeamWidth) * buffers.maxSequenceLength,
+        static_cast<std::size_t>(buffers.vocabSizePadded));
+    std::size_t const gridx{std::min(tc::ceilDiv(maxRowSize, blockSize.x), std::size_t{64})};
+    dim3 const gridSize{static_cast<std::uint32_t>(gridx), static_cast<std::uint32_t>(numRequests)};
+
+    auto const* setupsPtr = reinterpret_cast<NewRequestSetup const*>(setups.data());
+    initNewRequests<<<gridSize, blockSize, 0, stream.get()>>>(buffers, setupsPtr);
+}
+
+namespace
+{
+__global__ void publishTokens(TokenIdType* ringTokens, float* ringLogProbs, SizeType32 volatile* counters,
+    TokenIdType const* outputIds, float const* logProbs, SizeType32 const* sequenceLengths, SizeType32 maxBeamWidth,
+    SizeType32 maxSequenceLength, SizeType32 capacity)
+{
+    auto const slot = static_cast<std::size_t>(blockIdx.x);
+    auto const published = counters[slot * 2];
+    __shared__ SizeType32 length;
+    if (threadIdx.x == 0)
+    {
+        SizeType32 maxLength = 0;
+        for (SizeType32 beam = 0; beam < maxBeamWidth; ++beam)
+        {
+            maxLength = max(maxLength, sequenceLengths[slot * maxBeamWidth + beam]);
+        }
+        length = maxLength;
+    }
+    __syncthreads();
+    if (length <= published)
+    {
+        return;
+    }
+
+    // Announce the positions that are about to be overwritten before overwriting them
+    if (threadIdx.x == 0)
+    {
+        counters[slot * 2 + 1] = length;
+        __threadfence_system();
+    }
+    __syncthreads();
+
+    // Only the last capacity positions fit into the ring
+    auto const begin = max(published, length - capacity);
+    auto const size = static_cast<std::size_t>(length - begin) * maxBeamWidth;
+    for (auto idx = static_cast<std::size_t>(threadIdx.x); idx < size; idx += blockDim.x)
+    {
+        auto const position = begin + static_cast<SizeType32>(idx / maxBeamWidth);
+        auto const beam = idx % maxBeamWidth;
+        auto const srcIdx = (slot * maxBeamWidth + beam) * maxSequenceLength + position;
+        auto const dstIdx = (slot * capacity + position % capacity) * maxBeamWidth + beam;
+        ringTokens[dstIdx] = outputIds[srcIdx];
+        if (ringLogProbs != nullptr)
+        {
+            ringLogProbs[dstIdx] = logProbs[srcIdx];
+        }
+    }
+
+    // The positions must be visible to the host before the counter
+    __threadfence_system();
+    __syncthreads();
+    if (threadIdx.x == 0)
+    {
+        counters[slot * 2] = length;
+    }
+}
+} // namespace
+
+void invokePublishTokens(ITensor& ringTokens, ITensor* ringLogProbs, ITensor& counters, ITensor const& outputIds,
+    ITensor const* logProbs, ITensor const& sequenceLengths, SizeType32 batchSize, CudaStream const& stream)
+{
+    if (batchSize == 0)
+    {
+        return;
+    }
+    auto const& ringShape = ringTokens.getShape();
+    auto const& outputIdsShape = outputIds.getShape();
+    TLLM_CHECK(ringShape.nbDims == 3 && outputIdsShape.nbDims == 3);
+    TLLM_CHECK(ringShape.d[2] == outputIdsShape.d[1]);
+    TLLM_CHECK(batchSize <= ringShape.d[0] && batchSize <= outputIdsShape.d[0]);
+    TLLM_CHECK(static_cast<SizeType32>(sequenceLengths.getSize()) >= batchSize * outputIdsShape.d[1]);
+    TLLM_CHECK(counters.getSize() == static_cast<std::size_t>(ringShape.d[0]) * 2);
+    TLLM_CHECK_WITH_INFO(ringLogProbs == nullptr || logProbs != nullptr, "Log probs to publish are missing");
+
+    auto const maxBeamWidth = static_cast<SizeType32>(outputIdsShape.d[1]);
+    auto const maxSequenceLength = static_cast<SizeType32>(outputIdsShape.d[2]);
+    auto const capacity = static_cast<SizeType32>(ringShape.d[1]);
+
+    dim3 const blockSize{128};
+    dim3 const gridSize{static_cast<std::uint32_t>(batchSize)};
+    publishTokens<<<gridSize, blockSize, 0, stream.get()>>>(bufferCast<TokenIdType>(ringTokens),
+        ringLogProbs ? bufferCast<float>(*ringLogProbs) : nullptr, bufferCast<SizeType32>(counters),
+        bufferCast<TokenIdType>(outputIds), logProbs ? bufferCast<float>(*logProbs) : nullptr,
+        bufferCast<SizeType32>(sequenceLengths), maxBeamWidth, maxSequenceLength, capacity);
+}
+
 namespace
 {
 template <typename T>
@@ -1218,6 +1463,142 @@ void mergeLogitsFragments(BufferManager const& bufferManager, ITensor& output, s
     }
 }
 
+namespace
+{
+// Grid of (batchSize, hiddenSize / blockDim.x) blocks, each thread pools one channel of a sequence.
+template <typename T>
+__global__ void poolPackedHiddenStates(
+    T* output, T const* input, SizeType32 const* inputOffsets, SizeType32 hiddenSize, bool mean)
+{
+    auto const seqIdx = blockIdx.x;
+    auto const channel = static_cast<SizeType32>(blockIdx.y * blockDim.x + threadIdx.x);
+    if (channel >= hiddenSize)
+    {
+        return;
+    }
+    auto const begin = inputOffsets[seqIdx];
+    auto const end = mean ? inputOffsets[seqIdx + 1] : begin + 1;
+    float sum = 0.f;
+    for (auto token = begin; token < end; ++token)
+    {
+        sum += static_cast<float>(input[static_cast<std::size_t>(token) * hiddenSize + channel]);
+    }
+    output[static_cast<std::size_t>(seqIdx) * hiddenSize + channel]
+        = static_cast<T>(sum / static_cast<float>(end - begin));
+}
+
+template <typename T>
+void invokePoolPackedHiddenStates(
+    ITensor& output, ITensor const& input, ITensor const& inputOffsets, bool mean, CudaStream const& stream)
+{
+    auto const batchSize = static_cast<std::uint32_t>(output.getShape().d[0]);
+    auto const hiddenSize = static_cast<SizeType32>(output.getShape().d[1]);
+    TLLM_CHECK_WITH_INFO(input.getShape().d[1] == hiddenSize, "Invalid input shape: dim[1]");
+    TLLM_CHECK_WITH_INFO(inputOffsets.getSize() == batchSize + 1, "Invalid input offsets size");
+
+    dim3 const blockSize{256, 1};
+    auto const numChannelBlocks = tc::ceilDiv(hiddenSize, static_cast<SizeType32>(blockSize.x));
+    dim3 const gridSize{batchSize, static_cast<std::uint32_t>(numChannelBlocks)};
+    poolPackedHiddenStates<<<gridSize, blockSize, 0, stream.get()>>>(
+        bufferCast<T>(output), bufferCast<T>(input), bufferCast<SizeType32>(inputOffsets), hiddenSize, mean);
+}
+} // namespace
+
+void poolPackedHiddenStates(
+    ITensor& output, ITensor const& input, ITensor const& inputOffsets, bool mean, CudaStream const& stream)
+{
+    switch (input.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT:
+        invokePoolPackedHiddenStates<float>(output, input, inputOffsets, mean, stream);
+        break;
+    case nvinfer1::DataType::kHALF:
+        invokePoolPackedHiddenStates<half>(output, input, inputOffsets, mean, stream);
+        break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        invokePoolPackedHiddenStates<__nv_bfloat16>(output, input, inputOffsets, mean, stream);
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_CHECK_WITH_INFO(false, "data type not supported");
+    }
+}
+
+namespace
+{
+// One block per row, log_softmax(logits[rows[i]])[tokenIds[i]] over the first vocabSize entries.
+template <typename T>
+__global__ void gatherTokenLogProbs(float* output, T const* logits, SizeType32 const* rows,
+    TokenIdType const* tokenIds, SizeType32 vocabSize, SizeType32 vocabSizePadded)
+{
+    __shared__ float sMaxVal;
+
+    auto const* rowLogits = logits + static_cast<std::size_t>(rows[blockIdx.x]) * vocabSizePadded;
+    float maxVal = -FLT_MAX;
+    for (auto tid = static_cast<SizeType32>(threadIdx.x); tid < vocabSize; tid += blockDim.x)
+    {
+        maxVal = max(maxVal, static_cast<float>(rowLogits[tid]));
+    }
+    maxVal = tc::blockReduceMax<float>(maxVal);
+    if (threadIdx.x == 0)
+    {
+        sMaxVal = maxVal;
+    }
+    __syncthreads();
+
+    float sumVal = 0.f;
+    for (auto tid = static_cast<SizeType32>(threadIdx.x); tid < vocabSize; tid += blockDim.x)
+    {
+        sumVal += __expf(static_cast<float>(rowLogits[tid]) - sMaxVal);
+    }
+    sumVal = tc::blockReduceSum<float>(sumVal);
+    if (threadIdx.x == 0)
+    {
+        output[blockIdx.x] = static_cast<float>(rowLogits[tokenIds[blockIdx.x]]) - sMaxVal - __logf(sumVal);
+    }
+}
+
+template <typename T>
+void invokeGatherTokenLogProbs(ITensor& output, ITensor const& logits, ITensor const& rows, ITensor const& tokenIds,
+    SizeType32 vocabSize, CudaStream const& stream)
+{
+    auto const& shape = logits.getShape();
+    auto const vocabSizePadded = static_cast<SizeType32>(shape.d[shape.nbDims - 1]);
+    TLLM_CHECK_WITH_INFO(vocabSize <= vocabSizePadded, "Invalid vocab size");
+    auto const numRows = static_cast<std::uint32_t>(rows.getSize());
+    TLLM_CHECK_WITH_INFO(tokenIds.getSize() == numRows, "Invalid token ids size");
+    TLLM_CHECK_WITH_INFO(output.getSize() == numRows, "Invalid output size");
+    if (numRows == 0)
+    {
+        return;
+    }
+
+    dim3 const blockSize{static_cast<std::uint32_t>(std::min(tc::roundUp(vocabSize, 32), 1024))};
+    gatherTokenLogProbs<<<numRows, blockSize, 0, stream.get()>>>(bufferCast<float>(output), bufferCast<T>(logits),
+        bufferCast<SizeType32>(rows), bufferCast<TokenIdType>(tokenIds), vocabSize, vocabSizePadded);
+}
+} // namespace
+
+void gatherTokenLogProbs(ITensor& output, ITensor const& logits, ITensor const& rows, ITensor const& tokenIds,
+    SizeType32 vocabSize, CudaStream const& stream)
+{
+    switch (logits.getDataType())
+    {
+    case nvinfer1::DataType::kFLOAT:
+        invokeGatherTokenLogProbs<float>(output, logits, rows, tokenIds, vocabSize, stream);
+        break;
+    case nvinfer1::DataType::kHALF:
+        invokeGatherTokenLogProbs<half>(output, logits, rows, tokenIds, vocabSize, stream);
+        break;
+#ifdef ENABLE_BF16
+    case nvinfer1::DataType::kBF16:
+        invokeGatherTokenLogProbs<__nv_bfloat16>(output, logits, rows, tokenIds, vocabSize, stream);
+        break;
+#endif // ENABLE_BF16
+    default: TLLM_CHECK_WITH_INFO(false, "data type not supported");
+    }
+}
+
 void invokeUpdateKVBlockArrayDraftTokenLocation(ITensor const& seqAcceptedDraftTokenOffsets,
     ITensor const& packedAcceptedDraftTokensIndices, ITensor const& pastKeyValueLengths, void* const* pointerArray,
     ::tensorrt_llm::kernels::KVCacheIndex const* offsetArray, SizeType32 layerCount, SizeType32 seqCount,
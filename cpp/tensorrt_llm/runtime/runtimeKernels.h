@@ -37,6 +37,67 @@ void invokeFillBatch(
 void invokeCopyBatch(IBuffer const& srcBuffer, IBuffer& dstBuffer, IBuffer const& srcOffsets, IBuffer const& dstOffsets,
     IBuffer const& sizes, std::size_t maxStride, CudaStream const& stream);
 
+//! \brief Copy blocks of `blockSizeInBytes` from srcPointers[i] to dstPointers[i] in a single launch.
+//! \details The pointer buffers hold `void*` and must be device accessible, as must the blocks, e.g. device or pinned
+//! host memory. Blocks must not overlap.
+void invokeCopyBlocks(
+    IBuffer const& srcPointers, IBuffer const& dstPointers, std::size_t blockSizeInBytes, CudaStream const& stream);
+
+//! \brief Setup of one new request of the decoder, see invokeInitNewRequests.
+struct NewRequestSetup
+{
+    //! [numInputIds], device accessible
+    TokenIdType const* inputIds;
+    SizeType32 numInputIds;
+    SizeType32 batchSlot;
+    SizeType32 beamWidth;
+    SizeType32 inputLength;
+    SizeType32 sequenceLimitLength;
+    TokenIdType endId;
+    bool zeroEmbeddingBias;
+    bool zeroCumLogProbs;
+    bool zeroLogProbs;
+};
+
+//! \brief Joint buffers of the decoder initialized by invokeInitNewRequests, all device accessible.
+struct NewRequestsBuffers
+{
+    TokenIdType* outputIds;           // [maxBatchSize, maxBeamWidth, maxSequenceLength]
+    TokenIdType* parentIds;           // [maxBatchSize, maxBeamWidth, maxSequenceLength]
+    TokenIdType* endIds;              // [maxBatchSize, maxBeamWidth]
+    SizeType32* lengths;              // [maxBatchSize, maxBeamWidth]
+    SizeType32* sequenceLimitLength;  // [maxBatchSize]
+    SizeType32* finishedSum;          // [maxBatchSize]
+    TokenIdType* newTokensSteps;      // [maxTokensPerStep, maxBatchSize, maxBeamWidth]
+    std::uint8_t* finishedSteps;      // [maxTokensPerStep, maxBatchSize, maxBeamWidth], FinishedState
+    float* cumLogProbs;               // [maxBatchSize, maxBeamWidth]
+    float* logProbs;                  // [maxBatchSize, maxBeamWidth, maxSequenceLength]
+    float* embeddingBias;             // [maxBatchSize, vocabSizePadded]
+    SizeType32 maxBatchSize;
+    SizeType32 maxBeamWidth;
+    SizeType32 maxSequenceLength;
+    SizeType32 maxTokensPerStep;
+    SizeType32 vocabSizePadded;
+};
+
+//! \brief Initialize the slots of `numRequests` new requests in a single launch: output ids from the input ids padded
+//! with the end id, parent ids, end ids, lengths, sequence limits, new tokens, finished states and sums, and the
+//! optional log probs and embedding bias.
+//! \param setups `numRequests` NewRequestSetup, device accessible
+void invokeInitNewRequests(
+    NewRequestsBuffers const& buffers, IBuffer const& setups, SizeType32 numRequests, CudaStream const& stream);
+
+//! \brief Copy the positions of the first `batchSize` slots from their published length to their sequence length into
+//! the ring of `capacity` positions per slot, then advance the counters, see TokenRing.
+//! \param ringTokens [maxBatchSize, capacity, maxBeamWidth], device accessible
+//! \param ringLogProbs [maxBatchSize, capacity, maxBeamWidth], device accessible, optional
+//! \param counters [maxBatchSize, 2], the published lengths and the lengths being written, device accessible
+//! \param outputIds [maxBatchSize, maxBeamWidth, maxSequenceLength]
+//! \param logProbs [maxBatchSize, maxBeamWidth, maxSequenceLength], optional, must be set if ringLogProbs is
+//! \param sequenceLengths [batchSize, maxBeamWidth]
+void invokePublishTokens(ITensor& ringTokens, ITensor* ringLogProbs, ITensor& counters, ITensor const& outputIds,
+    ITensor const* logProbs, ITensor const& sequenceLengths, SizeType32 batchSize, CudaStream const& stream);
+
 template <typename T>
 void invokeAdd(IBuffer& buffer, T value, CudaStream const& stream);
 
@@ -95,6 +156,23 @@ void mergeLogitsFragments(BufferManager const& bufferManager, ITensor& output, s
     ITensor& cachePointerDevice, ITensor& cachePointerHost, SizeType32 firstBatchSlotIdx,
     SizeType32 const microBatchSize, SizeType32 const beamWidth, CudaStream const& stream, int stepOffset);
 
+//! \brief Pool the rows of sequences packed without padding into one row per sequence.
+//! \param output [batchSize, hiddenSize]
+//! \param input [numTokens, hiddenSize]
+//! \param inputOffsets [batchSize + 1], the offsets of the sequences in input
+//! \param mean Average the rows of a sequence, take its first row, e.g. the CLS token, otherwise.
+void poolPackedHiddenStates(
+    ITensor& output, ITensor const& input, ITensor const& inputOffsets, bool mean, CudaStream const& stream);
+
+//! \brief Log-probability of one token per row of the logits, the log-softmax is computed over the row on device.
+//! \param output [numRows], float
+//! \param logits [..., vocabSizePadded], viewed as rows of vocabSizePadded
+//! \param rows [numRows], the rows of the logits
+//! \param tokenIds [numRows], the token of each row
+//! \param vocabSize the entries after vocabSize are padding and excluded from the softmax
+void gatherTokenLogProbs(ITensor& output, ITensor const& logits, ITensor const& rows, ITensor const& tokenIds,
+    SizeType32 vocabSize, CudaStream const& stream);
+
 void invokeUpdateKVBlockArrayDraftTokenLocation(ITensor const& seqAcceptedDraftTokenOffsets,
     ITensor const& packedAcceptedDraftTokensIndices, ITensor const& pastKeyValueLengths, void* const* pointerArray,
     ::tensorrt_llm::kernels::KVCacheIndex const* offsetArray, SizeType32 layerCount, SizeType32 seqCount,
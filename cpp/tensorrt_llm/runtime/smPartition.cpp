@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/smPartition.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+
+#include <array>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+
+void checkDriver(CUresult result, char const* call)
+{
+    if (result != CUDA_SUCCESS)
+    {
+        char const* name = nullptr;
+        tc::CUDADriverWrapper::getInstance()->cuGetErrorName(result, &name);
+        TLLM_THROW("%s failed: %s", call, name != nullptr ? name : "unknown error");
+    }
+}
+
+} // namespace
+
+SmPartition::SmPartition(SizeType32 numReservedSms)
+{
+    TLLM_CHECK(numReservedSms > 0);
+    // Lower numbers are higher priorities
+    int lowestPriority{0};
+    int highestPriority{0};
+    TLLM_CUDA_CHECK(cudaDeviceGetStreamPriorityRange(&lowestPriority, &highestPriority));
+
+    if (!createGreenContexts(numReservedSms, highestPriority, lowestPriority))
+    {
+        TLLM_LOG_WARNING("Green contexts are not supported by the driver, the SMs are not partitioned");
+        mReservedStream = std::make_shared<CudaStream>(cudaStreamNonBlocking, highestPriority);
+        mRemainingStream = std::make_shared<CudaStream>(cudaStreamNonBlocking, lowestPriority);
+        mNumReservedSms = tc::getMultiProcessorCount();
+        mNumRemainingSms = mNumReservedSms;
+    }
+    TLLM_LOG_INFO("SM partition: %d reserved SMs, %d remaining SMs", mNumReservedSms, mNumRemainingSms);
+}
+
+SmPartition::~SmPartition()
+{
+    mReservedStream.reset();
+    mRemainingStream.reset();
+#if CUDA_VERSION >= 12050
+    auto const& driver = tc::CUDADriverWrapper::getInstance();
+    for (auto* greenContext : mGreenContexts)
+    {
+        auto const result = driver->cuGreenCtxDestroy(static_cast<CUgreenCtx>(greenContext));
+        if (result != CUDA_SUCCESS)
+        {
+            TLLM_LOG_WARNING("cuGreenCtxDestroy failed with %d", static_cast<int>(result));
+        }
+    }
+#endif
+}
+
+bool SmPartition::createGreenContexts([[maybe_unused]] SizeType32 numReservedSms, [[maybe_unused]] int highestPriority,
+    [[maybe_unused]] int lowestPriority)
+{
+#if CUDA_VERSION >= 12050
+    auto const& driver = tc::CUDADriverWrapper::getInstance();
+    if (!driver->hasGreenContexts())
+    {
+        return false;
+    }
+    auto const device = tc::getDevice();
+
+    CUdevResource deviceSms{};
+    checkDriver(
+        driver->cuDeviceGetDevResource(device, &deviceSms, CU_DEV_RESOURCE_TYPE_SM), "cuDeviceGetDevResource");
+    TLLM_CHECK_WITH_INFO(static_cast<unsigned int>(numReservedSms) < deviceSms.sm.smCount,
+        "Cannot reserve %d of the %u SMs of the device", numReservedSms, deviceSms.sm.smCount);
+    std::array<CUdevResource, 2> partitions{};
+    unsigned int numGroups{1};
+    checkDriver(driver->cuDevSmResourceSplitByCount(&partitions[0], &numGroups, &deviceSms, &partitions[1], 0,
+                    static_cast<unsigned int>(numReservedSms)),
+        "cuDevSmResourceSplitByCount");
+    TLLM_CHECK(numGroups == 1);
+
+    std::array<BufferManager::CudaStreamPtr, 2> streams;
+    std::array<int, 2> const priorities{highestPriority, lowestPriority};
+    try
+    {
+        for (std::size_t i = 0; i < partitions.size(); ++i)
+        {
+            CUdevResourceDesc desc{};
+            checkDriver(driver->cuDevResourceGenerateDesc(&desc, &partitions[i], 1), "cuDevResourceGenerateDesc");
+            CUgreenCtx greenContext{};
+            checkDriver(driver->cuGreenCtxCreate(&greenContext, desc, device, CU_GREEN_CTX_DEFAULT_STREAM),
+                "cuGreenCtxCreate");
+            mGreenContexts.push_back(greenContext);
+            CUstream stream{};
+            checkDriver(driver->cuGreenCtxStreamCreate(&stream, greenContext, CU_STREAM_NON_BLOCKING, priorities[i]),
+                "cuGreenCtxStreamCreate");
+            streams[i] = std::make_shared<CudaStream>(static_cast<cudaStream_t>(stream), device);
+        }
+    }
+    catch (...)
+    {
+        streams = {};
+        for (auto* greenContext : mGreenContexts)
+        {
+            driver->cuGreenCtxDestroy(static_cast<CUgreenCtx>(greenContext));
+        }
+        mGreenContexts.clear();
+        throw;
+    }
+
+    mReservedStream = std::move(streams[0]);
+    mRemainingStream = std::move(streams[1]);
+    mNumReservedSms = static_cast<SizeType32>(partitions[0].sm.smCount);
+    mNumRemainingSms = static_cast<SizeType32>(partitions[1].sm.smCount);
+    return true;
+#else
+    return false;
+#endif
+}
+
+} // namespace tensorrt_llm::runtime
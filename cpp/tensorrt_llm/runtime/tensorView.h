@@ -74,6 +74,16 @@ public:
         mDims.nbDims = 0;
     }
 
+    static void* operator new(std::size_t size)
+    {
+        return common::ThreadLocalBlockPool<sizeof(TensorView)>::allocate(size);
+    }
+
+    static void operator delete(void* ptr, std::size_t size) noexcept
+    {
+        common::ThreadLocalBlockPool<sizeof(TensorView)>::deallocate(ptr, size);
+    }
+
 private:
     static std::size_t sizeDim0(ITensor const& tensor)
     {
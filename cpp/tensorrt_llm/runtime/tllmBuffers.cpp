@@ -16,9 +16,89 @@
 
 #include "tensorrt_llm/runtime/tllmBuffers.h"
 
+#include <mutex>
+#include <unordered_map>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
 namespace tensorrt_llm::runtime
 {
 
+namespace
+{
+// Sizes of the mappings of allocateHugePages
+std::mutex hugePagesMutex;
+std::unordered_map<void*, std::size_t> hugePagesMappings;
+} // namespace
+
+PinnedAllocator::PointerType PinnedAllocator::allocateHugePages(
+    [[maybe_unused]] std::size_t n, [[maybe_unused]] std::size_t hugePageSize)
+{
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    if (hugePageSize == 0 || n < hugePageSize)
+    {
+        return nullptr;
+    }
+    auto const size = common::ceilDiv(n, hugePageSize) * hugePageSize;
+    int pageSizeLog2{0};
+    while ((std::size_t{1} << pageSizeLog2) < hugePageSize)
+    {
+        ++pageSizeLog2;
+    }
+    // The pages are faulted in by the kernel, under the NUMA policy of the caller
+    auto* ptr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE | (pageSizeLog2 << MAP_HUGE_SHIFT), -1, 0);
+    if (ptr == MAP_FAILED)
+    {
+        static std::once_flag warned;
+        std::call_once(warned,
+            [hugePageSize]()
+            {
+                TLLM_LOG_WARNING("Failed to map %zu MB huge pages for pinned memory, check /proc/sys/vm/nr_hugepages. "
+                                 "Falling back to cudaHostAlloc.",
+                    hugePageSize >> 20);
+            });
+        return nullptr;
+    }
+    auto const status = ::cudaHostRegister(ptr, size, cudaHostRegisterDefault);
+    if (status != cudaSuccess)
+    {
+        ::munmap(ptr, size);
+        TLLM_CUDA_CHECK(status);
+    }
+    TLLM_LOG_DEBUG("Registered %zu B of %zu MB huge pages at %p", size, hugePageSize >> 20, ptr);
+    std::lock_guard<std::mutex> lock(hugePagesMutex);
+    hugePagesMappings.emplace(ptr, size);
+    return ptr;
+#else
+    return nullptr;
+#endif
+}
+
+bool PinnedAllocator::deallocateHugePages([[maybe_unused]] PointerType ptr)
+{
+#if defined(__linux__) && defined(MAP_HUGETLB)
+    std::size_t size{0};
+    {
+        std::lock_guard<std::mutex> lock(hugePagesMutex);
+        auto const it = hugePagesMappings.find(ptr);
+        if (it == hugePagesMappings.end())
+        {
+            return false;
+        }
+        size = it->second;
+        hugePagesMappings.erase(it);
+    }
+    TLLM_CUDA_CHECK_FREE_RESOURCE(::cudaHostUnregister(ptr));
+    ::munmap(ptr, size);
+    return true;
+#else
+    return false;
+#endif
+}
+
 template <typename TAllocator>
 typename PoolAllocator<TAllocator>::PoolType& PoolAllocator<TAllocator>::getPool()
 {
@@ -28,4 +108,17 @@ typename PoolAllocator<TAllocator>::PoolType& PoolAllocator<TAllocator>::getPool
 
 // explicit instantiations
 template class PoolAllocator<PinnedAllocator>;
+
+CudaCachingAllocator::PoolType& CudaCachingAllocator::getPool(int device)
+{
+    static std::mutex mutex;
+    static std::unordered_map<int, std::unique_ptr<PoolType>> pools;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& pool = pools[device];
+    if (!pool)
+    {
+        pool = std::make_unique<PoolType>();
+    }
+    return *pool;
+}
 } // namespace tensorrt_llm::runtime
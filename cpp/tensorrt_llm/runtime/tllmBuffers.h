@@ -18,11 +18,16 @@
 
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/allocationAudit.h"
+#include "tensorrt_llm/runtime/cachingPool.h"
 #include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/deviceTopology.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/memoryCounters.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
 
 #include <NvInferRuntime.h>
 #include <cuda_runtime_api.h>
@@ -32,13 +37,30 @@
 #include <list>
 #include <memory>
 #include <mutex>
+#include <optional>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace tensorrt_llm::runtime
 {
 
+namespace detail
+{
+//! \brief Whether an allocator allocates on a stream, returned by its getCudaStream.
+template <typename TAllocator, typename = void>
+struct HasCudaStream : std::false_type
+{
+};
+
+template <typename TAllocator>
+struct HasCudaStream<TAllocator, std::void_t<decltype(std::declval<TAllocator const&>().getCudaStream())>>
+    : std::true_type
+{
+};
+} // namespace detail
+
 // CRTP base class
 template <typename TDerived, MemoryType memoryType, bool count = true>
 class BaseAllocator
@@ -53,7 +75,14 @@ public:
         PointerType ptr{};
         static_cast<TDerived*>(this)->allocateImpl(&ptr, n);
         if constexpr (count)
+        {
             MemoryCounters::getInstance().allocate<memoryType>(n);
+            AllocationAudit::recordAllocation(memoryType);
+            if (MemoryTimeline::isEnabled())
+            {
+                MemoryTimeline::getInstance().recordAllocation(memoryType, ptr, n, getStream());
+            }
+        }
         return ptr;
     }
 
@@ -61,6 +90,14 @@ public:
     {
         if (ptr)
         {
+            // Recorded before the free, so that the address is not reused before
+            if constexpr (count)
+            {
+                if (MemoryTimeline::isEnabled())
+                {
+                    MemoryTimeline::getInstance().recordFree(memoryType, ptr, n, getStream());
+                }
+            }
             static_cast<TDerived*>(this)->deallocateImpl(ptr, n);
             if constexpr (count)
                 MemoryCounters::getInstance().deallocate<memoryType>(n);
@@ -71,6 +108,19 @@ public:
     {
         return memoryType;
     }
+
+private:
+    [[nodiscard]] cudaStream_t getStream() const
+    {
+        if constexpr (detail::HasCudaStream<TDerived>::value)
+        {
+            return static_cast<TDerived const*>(this)->getCudaStream()->get();
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
 };
 
 class CudaAllocator : public BaseAllocator<CudaAllocator, MemoryType::kGPU>
@@ -156,16 +206,38 @@ public:
     using Base = BaseAllocator<PinnedAllocator, MemoryType::kPINNED>;
     PinnedAllocator() noexcept = default;
 
+    //! \brief Map `n` bytes, rounded up to whole huge pages of `hugePageSize` bytes, and register them with CUDA.
+    //! Locking a few huge pages is much faster than locking the base pages of cudaHostAlloc, which dominates the
+    //! startup with large host KV cache and LoRA cache pools. Allocations use TRTLLM_PINNED_HUGE_PAGE_SIZE_MB.
+    //! \return nullptr if `hugePageSize` is 0, `n` is smaller than a huge page or not enough huge pages are available.
+    static PointerType allocateHugePages(std::size_t n, std::size_t hugePageSize);
+
+    //! \return false if `ptr` was not allocated by allocateHugePages.
+    static bool deallocateHugePages(PointerType ptr);
+
 protected:
     void allocateImpl(PointerType* ptr, std::size_t n) // NOLINT(readability-convert-member-functions-to-static)
     {
-        TLLM_CUDA_CHECK(::cudaHostAlloc(ptr, n, cudaHostAllocDefault));
+        // The pages are placed when they are locked, on the NUMA node of the current device
+        std::optional<DeviceTopology::ScopedNumaPreference> numaPreference;
+        if (!common::getEnvDisableNumaLocalPinnedMemory())
+        {
+            numaPreference.emplace();
+        }
+        *ptr = allocateHugePages(n, common::getEnvPinnedHugePageSize());
+        if (*ptr == nullptr)
+        {
+            TLLM_CUDA_CHECK(::cudaHostAlloc(ptr, n, cudaHostAllocDefault));
+        }
     }
 
     void deallocateImpl( // NOLINT(readability-convert-member-functions-to-static)
         PointerType ptr, [[maybe_unused]] std::size_t n)
     {
-        TLLM_CUDA_CHECK_FREE_RESOURCE(::cudaFreeHost(ptr));
+        if (!deallocateHugePages(ptr))
+        {
+            TLLM_CUDA_CHECK_FREE_RESOURCE(::cudaFreeHost(ptr));
+        }
     }
 };
 
@@ -490,6 +562,73 @@ protected:
 
 using PinnedPoolAllocator = PoolAllocator<PinnedAllocator>;
 
+//! \brief Makes a stream wait for the work submitted so far to another stream.
+struct CudaStreamSync
+{
+    using StreamType = cudaStream_t;
+
+    static void waitForStream(cudaStream_t waiting, cudaStream_t other)
+    {
+        cudaEvent_t event;
+        TLLM_CUDA_CHECK(::cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+        TLLM_CUDA_CHECK(::cudaEventRecord(event, other));
+        TLLM_CUDA_CHECK(::cudaStreamWaitEvent(waiting, event, 0));
+        // Destroying a recorded event is fine, the wait still completes.
+        TLLM_CUDA_CHECK(::cudaEventDestroy(event));
+    }
+};
+
+//! \brief Allocates device memory for a stream from the caching pool of the device of the stream.
+//! \details Avoids a cudaMallocAsync and cudaFreeAsync per buffer for buffers that are reallocated every iteration.
+//! Free blocks are kept per stream handle and a new stream may get the handle of a destroyed one, so synchronize a
+//! stream before destroying it while blocks it freed may still be in use by its pending work.
+class CudaCachingAllocator : public BaseAllocator<CudaCachingAllocator, MemoryType::kGPU, false>
+{
+    friend class BaseAllocator<CudaCachingAllocator, MemoryType::kGPU, false>;
+
+public:
+    using CudaStreamPtr = std::shared_ptr<CudaStream>;
+    // The upstream allocator counts the reserved memory in MemoryCounters.
+    using PoolType = CachingPool<CudaAllocator, CudaStreamSync>;
+
+    explicit CudaCachingAllocator(CudaStreamPtr stream)
+        : mCudaStream(std::move(stream))
+    {
+        TLLM_CHECK_WITH_INFO(static_cast<bool>(mCudaStream), "Undefined CUDA stream");
+    }
+
+    [[nodiscard]] CudaStreamPtr getCudaStream() const
+    {
+        return mCudaStream;
+    }
+
+    static PoolType& getPool(int device);
+
+protected:
+    void allocateImpl(PointerType* ptr, std::size_t n)
+    {
+        auto& pool = getPool(mCudaStream->getDevice());
+        *ptr = pool.allocate(n, mCudaStream->get());
+        updateCounters(pool);
+    }
+
+    void deallocateImpl(PointerType ptr, [[maybe_unused]] std::size_t n)
+    {
+        auto& pool = getPool(mCudaStream->getDevice());
+        pool.deallocate(ptr);
+        updateCounters(pool);
+    }
+
+private:
+    static void updateCounters(PoolType const& pool)
+    {
+        auto const stats = pool.getStats();
+        MemoryCounters::getInstance().setGpuCacheStats(stats.cached, stats.used - stats.requested);
+    }
+
+    CudaStreamPtr mCudaStream;
+};
+
 // Adopted from https://github.com/NVIDIA/TensorRT/blob/release/8.6/samples/common/buffers.h
 
 //!
@@ -662,6 +801,7 @@ private:
 
 using DeviceBuffer = GenericBuffer<CudaAllocatorAsync>;
 using StaticDeviceBuffer = GenericBuffer<CudaAllocator>;
+using CachingDeviceBuffer = GenericBuffer<CudaCachingAllocator>;
 using HostBuffer = GenericBuffer<HostAllocator>;
 using PinnedBuffer = GenericBuffer<PinnedAllocator>;
 using PinnedPoolBuffer = GenericBuffer<PinnedPoolAllocator>;
@@ -752,6 +892,7 @@ private:
 
 using DeviceTensor = GenericTensor<CudaAllocatorAsync>;
 using StaticDeviceTensor = GenericTensor<CudaAllocator>;
+using CachingDeviceTensor = GenericTensor<CudaCachingAllocator>;
 using HostTensor = GenericTensor<HostAllocator>;
 using PinnedTensor = GenericTensor<PinnedAllocator>;
 using PinnedPoolTensor = GenericTensor<PinnedPoolAllocator>;
@@ -15,12 +15,24 @@
  */
 #include "tllmRuntime.h"
 #include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/nvtxUtils.h"
+#include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/runtime/cudaEvent.h"
+#include "tensorrt_llm/runtime/engineRegistry.h"
+#include "tensorrt_llm/runtime/fusionBarrierReport.h"
+#include "tensorrt_llm/runtime/mappedFile.h"
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+#include "tensorrt_llm/runtime/rangeProfiler.h"
 #include "tllmLogger.h"
 
+#include <algorithm>
 #include <limits>
+#include <mutex>
+#include <optional>
 #include <type_traits>
+#include <unordered_map>
 
 using namespace tensorrt_llm::runtime;
 
@@ -99,40 +111,207 @@ void setWeightStreaming(nvinfer1::ICudaEngine& engine, float const gpuWeightsPer
         engine.setWeightStreamingBudget(budget);
     }
 }
-} // namespace
 
-TllmRuntime::TllmRuntime(
-    RawEngine const& rawEngine, nvinfer1::ILogger* logger, float gpuWeightsPercent, bool useShapeInference)
-    : mStream(std::make_shared<CudaStream>())
-    , mBufferManager{mStream, true} // Ensure to trim the memory pool on destruction.
-    , mRuntime{nvinfer1::createInferRuntime(logger ? *logger : defaultLogger)}
-    , mUseShapeInference{useShapeInference}
+nvinfer1::ICudaEngine* deserializeEngine(nvinfer1::IRuntime& runtime, RawEngine const& rawEngine)
 {
     switch (rawEngine.getType())
     {
     case RawEngine::Type::FilePath:
     {
+#if defined(_WIN32)
         auto reader = StreamReader(rawEngine.getPath());
-        mEngine.reset(mRuntime->deserializeCudaEngine(reader));
-        break;
+        return runtime.deserializeCudaEngine(reader);
+#else
+        // The mapping is only needed during deserialization, the engine owns its weights afterwards.
+        MappedFile const engineFile{rawEngine.getPath()};
+        return runtime.deserializeCudaEngine(engineFile.data(), engineFile.size());
+#endif
+    }
+    case RawEngine::Type::AddressWithSize:
+        return runtime.deserializeCudaEngine(rawEngine.getAddress(), rawEngine.getSize());
+    case RawEngine::Type::HostMemory:
+        return runtime.deserializeCudaEngine(rawEngine.getHostMemory()->data(), rawEngine.getHostMemory()->size());
+    default: TLLM_THROW("Unsupported raw engine type.");
     }
+}
+
+BasicEngineRegistry<nvinfer1::ICudaEngine>& getEngineRegistry()
+{
+    static BasicEngineRegistry<nvinfer1::ICudaEngine> registry;
+    return registry;
+}
+
+//! \brief Engine of the registry with the same serialized content as `rawEngine`, deserialized if no runtime holds it.
+std::shared_ptr<nvinfer1::ICudaEngine> getSharedEngine(RawEngine const& rawEngine)
+{
+    std::unique_ptr<MappedFile> engineFile;
+    void const* data{nullptr};
+    std::size_t size{0};
+    switch (rawEngine.getType())
+    {
+    case RawEngine::Type::FilePath:
+        engineFile = std::make_unique<MappedFile>(rawEngine.getPath());
+        data = engineFile->data();
+        size = engineFile->size();
+        break;
     case RawEngine::Type::AddressWithSize:
-        mEngine.reset(mRuntime->deserializeCudaEngine(rawEngine.getAddress(), rawEngine.getSize()));
+        data = rawEngine.getAddress();
+        size = rawEngine.getSize();
         break;
     case RawEngine::Type::HostMemory:
-        mEngine.reset(
-            mRuntime->deserializeCudaEngine(rawEngine.getHostMemory()->data(), rawEngine.getHostMemory()->size()));
+        data = rawEngine.getHostMemory()->data();
+        size = rawEngine.getHostMemory()->size();
         break;
     default: TLLM_THROW("Unsupported raw engine type.");
     }
 
+    return getEngineRegistry().getOrCreate(hashEngine(data, size),
+        [data, size]()
+        {
+            // The engine may outlive the runtime that requested it, so it gets its own IRuntime, which must outlive
+            // the engine, and the default logger.
+            struct SharedEngine
+            {
+                std::unique_ptr<nvinfer1::IRuntime> runtime;
+                std::unique_ptr<nvinfer1::ICudaEngine> engine;
+            };
+
+            auto shared = std::make_shared<SharedEngine>();
+            shared->runtime.reset(nvinfer1::createInferRuntime(defaultLogger));
+            shared->engine.reset(shared->runtime->deserializeCudaEngine(data, size));
+            auto* engine = shared->engine.get();
+            return engine != nullptr ? std::shared_ptr<nvinfer1::ICudaEngine>{std::move(shared), engine} : nullptr;
+        });
+}
+
+//! State of a runtime that is not a member of TllmRuntime, whose layout the prebuilt libraries are built with.
+struct RuntimeExtension
+{
+    //! Reference of the runtime to its shared engine, mEngine does not own a shared engine.
+    std::shared_ptr<nvinfer1::ICudaEngine> sharedEngine;
+    //! Stream and activation memory of the contexts by index, nullptr for those executed on the stream of the runtime.
+    std::vector<BufferManager::CudaStreamPtr> contextStreams;
+    std::vector<BufferManager::IBufferPtr> contextBuffers;
+};
+
+std::mutex gRuntimeExtensionsMutex;
+std::unordered_map<TllmRuntime const*, RuntimeExtension> gRuntimeExtensions;
+
+//! The extension of a runtime, created on first use. Elements of the map don't move, so the reference stays valid
+//! until the extension is taken.
+RuntimeExtension& getExtension(TllmRuntime const* runtime)
+{
+    std::lock_guard<std::mutex> lock{gRuntimeExtensionsMutex};
+    return gRuntimeExtensions[runtime];
+}
+
+RuntimeExtension* findExtension(TllmRuntime const* runtime)
+{
+    std::lock_guard<std::mutex> lock{gRuntimeExtensionsMutex};
+    auto const it = gRuntimeExtensions.find(runtime);
+    return it != gRuntimeExtensions.end() ? &it->second : nullptr;
+}
+
+std::optional<RuntimeExtension> takeExtension(TllmRuntime const* runtime)
+{
+    std::lock_guard<std::mutex> lock{gRuntimeExtensionsMutex};
+    auto node = gRuntimeExtensions.extract(runtime);
+    return node.empty() ? std::nullopt : std::make_optional(std::move(node.mapped()));
+}
+
+bool hasSharedEngine(TllmRuntime const* runtime)
+{
+    auto const* extension = findExtension(runtime);
+    return extension != nullptr && extension->sharedEngine != nullptr;
+}
+} // namespace
+
+TllmRuntime::TllmRuntime(
+    RawEngine const& rawEngine, nvinfer1::ILogger* logger, float gpuWeightsPercent, bool useShapeInference)
+    : mStream(std::make_shared<CudaStream>())
+    , mBufferManager{mStream, true} // Ensure to trim the memory pool on destruction.
+    , mRuntime{nvinfer1::createInferRuntime(logger ? *logger : defaultLogger)}
+    , mUseShapeInference{useShapeInference}
+{
+    // A runtime destroyed by the inline destructor of the prebuilt libraries at this address may have left its
+    // extension behind.
+    takeExtension(this);
+    mEngine.reset(deserializeEngine(*mRuntime, rawEngine));
+    initializeEngine(gpuWeightsPercent);
+}
+
+TllmRuntime::TllmRuntime(
+    RawEngine const& rawEngine, nvinfer1::ILogger* logger, bool useShapeInference, SharedEngineTag /* tag */)
+    : mStream(std::make_shared<CudaStream>())
+    , mBufferManager{mStream, true} // Ensure to trim the memory pool on destruction.
+    , mRuntime{nvinfer1::createInferRuntime(logger ? *logger : defaultLogger)}
+    , mUseShapeInference{useShapeInference}
+{
+    takeExtension(this);
+    auto sharedEngine = getSharedEngine(rawEngine);
+    mEngine.reset(sharedEngine.get());
+    getExtension(this).sharedEngine = std::move(sharedEngine);
+    try
+    {
+        initializeEngine(1.0f);
+    }
+    catch (...)
+    {
+        mEngineInspector.reset();
+        mEngine.release();
+        takeExtension(this);
+        throw;
+    }
+}
+
+std::shared_ptr<TllmRuntime> TllmRuntime::createWithSharedEngine(
+    RawEngine const& rawEngine, nvinfer1::ILogger* logger, bool useShapeInference)
+{
+    return std::shared_ptr<TllmRuntime>{new TllmRuntime{rawEngine, logger, useShapeInference, SharedEngineTag{}}};
+}
+
+TllmRuntime::~TllmRuntime()
+{
+    auto const extension = takeExtension(this);
+    if (!extension)
+    {
+        return;
+    }
+    for (auto const& contextStream : extension->contextStreams)
+    {
+        if (contextStream)
+        {
+            contextStream->synchronize();
+        }
+    }
+    // The contexts go before their memory and, with the inspector, before the reference of this runtime to a shared
+    // engine.
+    clearContexts();
+    if (extension->sharedEngine)
+    {
+        mEngineInspector.reset();
+        mEngine.release();
+    }
+}
+
+void TllmRuntime::initializeEngine(float gpuWeightsPercent)
+{
     TLLM_CHECK_WITH_INFO(mEngine != nullptr, "Failed to deserialize cuda engine.");
     mEngineInspector.reset(mEngine->createEngineInspector());
+    if (tensorrt_llm::common::getEnvReportFusionBarriers())
+    {
+        FusionBarrierReport const report{
+            mEngineInspector->getEngineInformation(nvinfer1::LayerInformationFormat::kJSON)};
+        TLLM_LOG_INFO("%s", report.report().c_str());
+    }
 
     setWeightStreaming(getEngine(), gpuWeightsPercent);
 
     auto const devMemorySize = mEngine->getDeviceMemorySize();
-    mEngineBuffer = mBufferManager.gpu(devMemorySize);
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kWORKSPACE};
+        mEngineBuffer = mBufferManager.gpu(devMemorySize);
+    }
 
     // Print context memory size for CI/CD to track.
     TLLM_LOG_INFO("[MemUsageChange] Allocated %.2f MiB for execution context memory.",
@@ -173,13 +352,181 @@ void TllmRuntime::clearContexts()
         context.reset();
     }
     mContexts.clear();
+    if (auto* extension = findExtension(this))
+    {
+        extension->contextStreams.clear();
+        extension->contextBuffers.clear();
+    }
+}
+
+void TllmRuntime::setGpuWeightsPercent(float gpuWeightsPercent)
+{
+    TLLM_CHECK_WITH_INFO(0.f <= gpuWeightsPercent && gpuWeightsPercent <= 1.f,
+        "gpuWeightsPercent must be in [0, 1], got %f", gpuWeightsPercent);
+    TLLM_CHECK_WITH_INFO(
+        mContexts.empty(), "The weight streaming budget can only be changed without execution contexts.");
+    TLLM_CHECK_WITH_INFO(!hasSharedEngine(this), "The weight streaming budget of a shared engine can't be changed.");
+    TLLM_CHECK_WITH_INFO(getStreamableWeightsSize() > 0, "The engine was built without weight streaming.");
+    if (gpuWeightsPercent < 1)
+    {
+        setWeightStreaming(getEngine(), gpuWeightsPercent);
+    }
+    else
+    {
+        // All streamable weights on the GPU.
+        mEngine->setWeightStreamingBudget(getStreamableWeightsSize());
+    }
+}
+
+float TllmRuntime::getGpuWeightsPercent() const
+{
+    auto const max = mEngine->getStreamableWeightsSize();
+    auto const budget = mEngine->getWeightStreamingBudget();
+    if (max <= 0 || budget < 0 || budget >= max)
+    {
+        return 1.0f;
+    }
+    auto const min = mEngine->getMinimumWeightStreamingBudget();
+    return max > min ? static_cast<float>(budget - min) / static_cast<float>(max - min) : 1.0f;
+}
+
+std::int64_t TllmRuntime::getStreamableWeightsSize() const
+{
+    return mEngine->getStreamableWeightsSize();
+}
+
+void TllmRuntime::refitWeights(TensorMap const& weights)
+{
+    NVTX3_FUNC_RANGE();
+    TLLM_CHECK_WITH_INFO(!hasSharedEngine(this), "The weights of a shared engine can't be refitted.");
+    TLLM_CHECK_WITH_INFO(mEngine->isRefittable(), "The engine was built without refit support.");
+    std::unique_ptr<nvinfer1::IRefitter> refitter{nvinfer1::createInferRefitter(*mEngine, *mRuntime->getLogger())};
+    TLLM_CHECK_WITH_INFO(refitter != nullptr, "Failed to create a refitter for the engine.");
+
+    for (auto const& [name, tensor] : weights)
+    {
+        TLLM_CHECK_WITH_INFO(tensor != nullptr, "Weights %s are null.", name.c_str());
+        nvinfer1::Weights const values{
+            tensor->getDataType(), tensor->data(), static_cast<std::int64_t>(tensor->getSize())};
+        auto const location = tensor->getMemoryType() == MemoryType::kGPU ? nvinfer1::TensorLocation::kDEVICE
+                                                                          : nvinfer1::TensorLocation::kHOST;
+        TLLM_CHECK_WITH_INFO(refitter->setNamedWeights(name.c_str(), values, location),
+            "Failed to set weights %s, check their name, type and size.", name.c_str());
+    }
+
+    auto const nbMissing = refitter->getMissingWeights(0, nullptr);
+    if (nbMissing > 0)
+    {
+        std::vector<char const*> missing(nbMissing);
+        refitter->getMissingWeights(nbMissing, missing.data());
+        std::string names;
+        for (auto const* missingName : missing)
+        {
+            names += names.empty() ? missingName : std::string(", ") + missingName;
+        }
+        TLLM_THROW("The refit needs the weights %s too.", names.c_str());
+    }
+
+    TLLM_CHECK_WITH_INFO(refitter->refitCudaEngineAsync(mStream->get()), "Failed to refit the engine.");
+    // The refitter reads the weights asynchronously, the caller may release them after the return.
+    mStream->synchronize();
+    TLLM_LOG_INFO("Refitted %zu weights of the engine.", weights.size());
+}
+
+std::vector<std::string> TllmRuntime::getRefittableWeightNames() const
+{
+    if (!mEngine->isRefittable())
+    {
+        return {};
+    }
+    std::unique_ptr<nvinfer1::IRefitter> refitter{nvinfer1::createInferRefitter(*mEngine, *mRuntime->getLogger())};
+    TLLM_CHECK_WITH_INFO(refitter != nullptr, "Failed to create a refitter for the engine.");
+    auto const nbWeights = refitter->getAllWeights(0, nullptr);
+    std::vector<char const*> names(std::max(nbWeights, 0));
+    refitter->getAllWeights(nbWeights, names.data());
+    return {names.begin(), names.end()};
 }
 
 bool TllmRuntime::executeContext(SizeType32 contextIndex) const
 {
     NVTX3_FUNC_RANGE();
+    TLLM_PROFILE_GPU_RANGE(kRUNTIME, "TllmRuntime::executeContext", mStream->get());
     auto& context = getContext(contextIndex);
-    return context.enqueueV3(mStream->get());
+    auto const& contextStream = getContextStream(contextIndex);
+    if (&contextStream == mStream.get())
+    {
+        return context.enqueueV3(mStream->get());
+    }
+    CudaEvent const inputsReady;
+    mStream->record(inputsReady);
+    contextStream.wait(inputsReady);
+    return context.enqueueV3(contextStream.get());
+}
+
+void TllmRuntime::setContextStream(SizeType32 contextIndex, BufferManager::CudaStreamPtr stream)
+{
+    auto& context = getContext(contextIndex);
+    if (stream == mStream)
+    {
+        stream.reset();
+    }
+    // The previous executions of the context must be complete before its memory changes.
+    getContextStream(contextIndex).synchronize();
+    auto& extension = getExtension(this);
+    if (extension.contextStreams.size() < mContexts.size())
+    {
+        extension.contextStreams.resize(mContexts.size());
+        extension.contextBuffers.resize(mContexts.size());
+    }
+    if (stream)
+    {
+        TLLM_CHECK_WITH_INFO(stream->getDevice() == mStream->getDevice(), "The stream is on another device.");
+        auto& buffer = extension.contextBuffers.at(contextIndex);
+        if (!buffer)
+        {
+            MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kWORKSPACE};
+            buffer = mBufferManager.gpu(mEngine->getDeviceMemorySize());
+            TLLM_LOG_INFO("[MemUsageChange] Allocated %.2f MiB for the execution context memory of context %d.",
+                static_cast<double>(buffer->getSizeInBytes()) / 1048576.0, contextIndex);
+        }
+        context.setDeviceMemory(buffer->data());
+    }
+    else
+    {
+        context.setDeviceMemory(mEngineBuffer->data());
+        extension.contextBuffers.at(contextIndex).reset();
+    }
+    extension.contextStreams.at(contextIndex) = std::move(stream);
+}
+
+CudaStream const& TllmRuntime::getContextStream(SizeType32 contextIndex) const
+{
+    TLLM_CHECK(0 <= contextIndex && contextIndex < getNbContexts());
+    auto const* extension = findExtension(this);
+    if (extension == nullptr || static_cast<std::size_t>(contextIndex) >= extension->contextStreams.size()
+        || !extension->contextStreams[contextIndex])
+    {
+        return *mStream;
+    }
+    return *extension->contextStreams[contextIndex];
+}
+
+void TllmRuntime::joinContextStreams() const
+{
+    auto const* extension = findExtension(this);
+    if (extension == nullptr)
+    {
+        return;
+    }
+    for (auto const& contextStream : extension->contextStreams)
+    {
+        if (contextStream)
+        {
+            CudaEvent const executed;
+            contextStream->record(executed);
+            mStream->wait(executed);
+        }
+    }
 }
 
 void TllmRuntime::setInputTensors(SizeType32 contextIndex, TensorMap const& tensorMap)
@@ -312,8 +659,17 @@ bool TllmRuntime::hasLayerProfiler(SizeType32 contextId) const
 }
 
 void TllmRuntime::setLayerProfiler()
+{
+    setLayerProfiler(false);
+}
+
+void TllmRuntime::setLayerProfiler(bool recordTimeline)
 {
     mLayerProfiler.reset(new LayerProfiler);
+    if (recordTimeline)
+    {
+        mLayerProfiler->enableTimeline();
+    }
     for (auto& context : mContexts)
     {
         context->setProfiler(mLayerProfiler.get());
@@ -327,7 +683,33 @@ std::string TllmRuntime::getLayerProfileInfo() const
     return mLayerProfiler->getLayerProfile();
 }
 
+std::vector<std::pair<std::string, float>> TllmRuntime::getLayerTimes() const
+{
+    TLLM_CHECK(mLayerProfiler);
+    return mLayerProfiler->getLayerTimes();
+}
+
+void TllmRuntime::setProfilerIteration(std::uint64_t iterationId)
+{
+    if (mLayerProfiler)
+    {
+        mLayerProfiler->setIteration(iterationId);
+        ::nvtx3::mark(tensorrt_llm::common::fmtstr(
+            "TllmRuntime iteration %lu", static_cast<unsigned long>(iterationId)));
+    }
+}
+
 void TllmRuntime::reportToProfiler(SizeType32 contextId)
 {
+    if (mLayerProfiler)
+    {
+        mLayerProfiler->beginReport(contextId);
+    }
     mContexts[contextId]->reportToProfiler();
 }
+
+void TllmRuntime::writeLayerTimeline(std::filesystem::path const& path) const
+{
+    TLLM_CHECK(mLayerProfiler);
+    mLayerProfiler->writeChromeTrace(path);
+}
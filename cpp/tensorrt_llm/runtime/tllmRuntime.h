@@ -23,7 +23,9 @@
 #include <NvInferRuntime.h>
 
 #include <cstdint>
+#include <filesystem>
 #include <memory>
+#include <string>
 #include <vector>
 
 namespace tensorrt_llm::runtime
@@ -36,6 +38,14 @@ public:
     explicit TllmRuntime(RawEngine const& rawEngine, nvinfer1::ILogger* logger, float gpuWeightsPercent = 1.0f,
         bool useShapeInference = true);
 
+    //! \brief Create a runtime that shares its engine, i.e. the weights, with the other runtimes of the process created
+    //! this way from the same serialized engine. Each runtime keeps its own execution contexts and activation memory.
+    //! The weights of a shared engine can't be streamed or refitted.
+    [[nodiscard]] static std::shared_ptr<TllmRuntime> createWithSharedEngine(
+        RawEngine const& rawEngine, nvinfer1::ILogger* logger, bool useShapeInference = true);
+
+    ~TllmRuntime();
+
     SizeType32 getNbContexts() const
     {
         return static_cast<SizeType32>(mContexts.size());
@@ -71,12 +81,48 @@ public:
 
     void clearContexts();
 
+    //! \brief Change the share of the streamable weights kept on the GPU, e.g. to page the weights of an idle model
+    //! out to host memory and back in. Only possible without execution contexts.
+    void setGpuWeightsPercent(float gpuWeightsPercent);
+
+    //! \brief Share of the streamable weights kept on the GPU, derived from the weight streaming budget of the engine.
+    [[nodiscard]] float getGpuWeightsPercent() const;
+
+    //! \brief Size of the weights that can be streamed from host memory, 0 if the engine was built without weight
+    //! streaming.
+    [[nodiscard]] std::int64_t getStreamableWeightsSize() const;
+
+    //! \brief Replace weights of the engine in place, e.g. with a fine-tuned version, without a rebuild. The execution
+    //! contexts and all the buffers, like the KV cache, are kept. The refit is ordered after the executions enqueued on
+    //! the stream of the runtime and is complete when the function returns, so the weights can be released then.
+    //! \param weights New values by the name of the weights in the engine, on gpu or in host memory. Weights that
+    //! TensorRT fused with one of them must be given too. The engine must be built refittable and not be shared.
+    void refitWeights(TensorMap const& weights);
+
+    //! \brief Names of the weights that refitWeights can replace, empty if the engine is not refittable.
+    [[nodiscard]] std::vector<std::string> getRefittableWeightNames() const;
+
     void setInputTensors(SizeType32 contextIndex, TensorMap const& tensorMap);
 
     void setOutputTensors(SizeType32 contextIndex, TensorMap& tensorMap);
 
+    //! \brief Enqueue the execution of a context on its stream, see setContextStream. A context with its own stream
+    //! waits for the work enqueued on the stream of the runtime before, e.g. the preparation of its inputs, and the
+    //! stream of the runtime waits for it at joinContextStreams.
     bool executeContext(SizeType32 contextIndex) const;
 
+    //! \brief Execute a context on its own stream, with its own activation memory, so that it can run concurrently
+    //! with the other contexts, e.g. the context phase and the generation phase on the two streams of an SmPartition.
+    //! \param stream the stream of the context, nullptr or the stream of the runtime to execute it on the latter again
+    void setContextStream(SizeType32 contextIndex, BufferManager::CudaStreamPtr stream);
+
+    //! \return the stream executeContext enqueues the context on
+    [[nodiscard]] CudaStream const& getContextStream(SizeType32 contextIndex) const;
+
+    //! \brief Order the work enqueued on the stream of the runtime after the executions of the contexts with their own
+    //! stream, e.g. before reading their outputs.
+    void joinContextStreams() const;
+
     CudaStream const& getStream() const;
 
     BufferManager::CudaStreamPtr getStreamPtr()
@@ -115,11 +161,29 @@ public:
     }
 
     void setLayerProfiler();
+    //! \param recordTimeline Also record a per-iteration timeline of the layers, see writeLayerTimeline.
+    void setLayerProfiler(bool recordTimeline);
     bool hasLayerProfiler(SizeType32 contextId) const;
     std::string getLayerProfileInfo() const;
+    //! \brief Total time of every layer since the last getLayerProfileInfo.
+    std::vector<std::pair<std::string, float>> getLayerTimes() const;
+    //! \brief Iteration the following reports belong to, e.g. the executor iteration, also marked in NVTX. Ignored
+    //! without a layer profiler.
+    void setProfilerIteration(std::uint64_t iterationId);
     void reportToProfiler(SizeType32 contextId);
+    //! \brief Write the layer timeline in Chrome trace format, for chrome://tracing or Perfetto.
+    void writeLayerTimeline(std::filesystem::path const& path) const;
 
 private:
+    struct SharedEngineTag
+    {
+    };
+
+    TllmRuntime(RawEngine const& rawEngine, nvinfer1::ILogger* logger, bool useShapeInference, SharedEngineTag);
+
+    //! \brief Set up the engine inspector, the weight streaming budget and the activation memory of mEngine.
+    void initializeEngine(float gpuWeightsPercent);
+
     BufferManager::CudaStreamPtr mStream;
     BufferManager mBufferManager;
     std::unique_ptr<nvinfer1::IRuntime> mRuntime;
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/tokenRing.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/runtimeKernels.h"
+
+#include <atomic>
+#include <cstring>
+
+namespace tensorrt_llm::runtime
+{
+
+TokenRing::TokenRing(SizeType32 maxBatchSize, SizeType32 maxBeamWidth, SizeType32 capacity)
+    : mMaxBeamWidth{maxBeamWidth}
+    , mCapacity{capacity}
+{
+    TLLM_CHECK(maxBatchSize > 0);
+    TLLM_CHECK(mMaxBeamWidth > 0);
+    TLLM_CHECK_WITH_INFO(mCapacity > 0, "The token ring needs room for at least one position");
+    auto const ringShape = ITensor::makeShape({maxBatchSize, mCapacity, mMaxBeamWidth});
+    mTokens = BufferManager::pinned(ringShape, TRTDataType<TokenIdType>::value);
+    mLogProbs = BufferManager::pinned(ringShape, TRTDataType<float>::value);
+    mCounters = BufferManager::pinned(ITensor::makeShape({maxBatchSize, 2}), TRTDataType<SizeType32>::value);
+    std::memset(mCounters->data(), 0, mCounters->getSizeInBytes());
+}
+
+void TokenRing::publish(ITensor const& outputIds, ITensor const* logProbs, ITensor const& sequenceLengths,
+    SizeType32 batchSize, CudaStream const& stream)
+{
+    kernels::invokePublishTokens(*mTokens, logProbs ? mLogProbs.get() : nullptr, *mCounters, outputIds, logProbs,
+        sequenceLengths, batchSize, stream);
+}
+
+void TokenRing::resetSlot(SizeType32 slot, SizeType32 length, CudaStream const& stream)
+{
+    auto counters = ITensor::slice(mCounters, slot, 1);
+    kernels::invokeFill(*counters, length, stream);
+}
+
+SizeType32 TokenRing::getPublishedLength(SizeType32 slot) const
+{
+    auto const length = static_cast<SizeType32 const volatile*>(bufferCast<SizeType32>(*mCounters))[slot * 2];
+    // The positions below the counter were written before it
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return length;
+}
+
+SizeType32 TokenRing::getWrittenLength(SizeType32 slot) const
+{
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return static_cast<SizeType32 const volatile*>(bufferCast<SizeType32>(*mCounters))[slot * 2 + 1];
+}
+
+bool TokenRing::read(SizeType32 slot, SizeType32 beam, SizeType32 begin, SizeType32 end,
+    std::vector<TokenIdType>& tokens, std::vector<float>* logProbs) const
+{
+    TLLM_CHECK(beam < mMaxBeamWidth);
+    TLLM_CHECK(begin <= end);
+    auto const published = getPublishedLength(slot);
+    if (end > published || published - begin > mCapacity)
+    {
+        return false;
+    }
+
+    auto const numTokens = static_cast<std::size_t>(end - begin);
+    auto const tokensBegin = tokens.size();
+    tokens.resize(tokensBegin + numTokens);
+    std::vector<float> readLogProbs(logProbs ? numTokens : 0);
+    auto const* ringTokens = bufferCast<TokenIdType>(*mTokens);
+    auto const* ringLogProbs = bufferCast<float>(*mLogProbs);
+    for (SizeType32 position = begin; position < end; ++position)
+    {
+        auto const idx = (static_cast<std::size_t>(slot) * mCapacity + position % mCapacity) * mMaxBeamWidth + beam;
+        tokens[tokensBegin + position - begin] = ringTokens[idx];
+        if (logProbs)
+        {
+            readLogProbs[position - begin] = ringLogProbs[idx];
+        }
+    }
+
+    // The GPU may have overwritten the positions while they were read
+    if (getWrittenLength(slot) - begin > mCapacity)
+    {
+        tokens.resize(tokensBegin);
+        return false;
+    }
+    if (logProbs)
+    {
+        logProbs->insert(logProbs->end(), readLogProbs.begin(), readLogProbs.end());
+    }
+    return true;
+}
+
+} // namespace tensorrt_llm::runtime
@@ -20,7 +20,9 @@
 #include "tensorrt_llm/runtime/runtimeBuffers.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
 #include "tensorrt_llm/runtime/utils/sessionUtils.h"
+#include <algorithm>
 #include <cstdlib> // std::getenv
+#include <cstring>
 
 using namespace tensorrt_llm::runtime;
 namespace tc = tensorrt_llm::common;
@@ -156,6 +158,7 @@ void TransformerBuffers::reshapeKvTensors(
 
     kvCacheBlockOffsetsDevice->reshape(cacheBlockOffsetsShape);
     manager.setZero(*kvCacheBlockOffsetsDevice);
+    mBlockOffsetsTracker.invalidate();
 }
 
 void TransformerBuffers::setKvPoolPointers(KvCacheManager const* kvCacheManager)
@@ -287,7 +290,12 @@ void TransformerBuffers::prepareContextStep(RuntimeBuffers* runtimeBuffers, Tens
         std::fill_n(RequestTypesPtr, batchSize, 0);
 
         auto maxAttentionWindowsPtr = bufferCast<SizeType32>(*maxAttentionWindows);
-        std::fill_n(maxAttentionWindowsPtr, localNbLayers, generationConfig.maxAttentionWindow);
+        auto const firstAttentionLayerIdx = modelConfig.countLowerRankLayers(ModelConfig::LayerType::kATTENTION,
+            worldConfig.getPipelineParallelism(), worldConfig.getPipelineParallelRank());
+        for (SizeType32 i = 0; i < localNbLayers; ++i)
+        {
+            maxAttentionWindowsPtr[i] = generationConfig.getMaxAttentionWindow(firstAttentionLayerIdx + i);
+        }
 
         bufferCast<SizeType32>(*sinkTokenLengths)[0] = generationConfig.sinkTokenLength;
 
@@ -384,7 +392,7 @@ void TransformerBuffers::prepareContextStep(RuntimeBuffers* runtimeBuffers, Tens
         auto constexpr contextBeamWidth = 1;
         kvCacheManager->getBlockOffsetsOfBatch(
             *kvCacheBlockOffsetsHost, firstBatchSlotIdx, batchSize, contextBeamWidth);
-        manager.copy(*kvCacheBlockOffsetsHost, *kvCacheBlockOffsetsDevice);
+        copyBlockOffsetsToDevice(manager);
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -527,6 +535,8 @@ void TransformerBuffers::postContextStep(RuntimeBuffers* runtimeBuffers,
         cacheBlockOffsetsShape.d[0] = batchSize * beamWidth;
         kvCacheBlockOffsetsHost->reshape(cacheBlockOffsetsShape);
         kvCacheBlockOffsetsDevice->reshape(cacheBlockOffsetsShape);
+        // The context steps wrote the device table through their own slices
+        mBlockOffsetsTracker.invalidate();
     }
 
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
@@ -646,11 +656,78 @@ void TransformerBuffers::prepareNextStep(RuntimeBuffers* runtimeBuffers, SizeTyp
             kvCacheManager->addToken(batchIdx);
         }
         kvCacheManager->getBlockOffsetsOfBatch(*kvCacheBlockOffsetsHost, firstBatchSlotIdx, batchSize, beamWidth);
-        manager.copy(*kvCacheBlockOffsetsHost, *kvCacheBlockOffsetsDevice);
+        copyBlockOffsetsToDevice(manager);
     }
     TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
 }
 
+void TransformerBuffers::copyBlockOffsetsToDevice(BufferManager& manager)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    auto const& host = *kvCacheBlockOffsetsHost;
+    auto& device = *kvCacheBlockOffsetsDevice;
+    auto const numRows = host.getShape().nbDims > 0 ? static_cast<SizeType32>(host.getShape().d[0]) : 0;
+    if (numRows == 0)
+    {
+        return;
+    }
+    auto const rowSize = host.getSize() / numRows;
+    auto const rowSizeInBytes = host.getSizeInBytes() / numRows;
+    auto const segments = mBlockOffsetsTracker.update(host.data(), numRows, rowSizeInBytes, device.data());
+    auto const numDirtyRows = mBlockOffsetsTracker.getNumDirtyRows();
+    if (segments.empty())
+    {
+        return;
+    }
+    if (numDirtyRows > kMaxDirtyRowFraction * numRows)
+    {
+        manager.copy(host, device);
+        return;
+    }
+
+    auto const numSegments = segments.size();
+    if (!mBlockOffsetsStagingHost)
+    {
+        mBlockOffsetsStagingHost = manager.emptyBuffer(MemoryType::kCPU, host.getDataType());
+        mBlockOffsetsStagingDevice = manager.emptyBuffer(MemoryType::kGPU, host.getDataType());
+        mBlockOffsetsCopyHost = manager.emptyBuffer(MemoryType::kCPU, nvinfer1::DataType::kINT32);
+        mBlockOffsetsCopyDevice = manager.emptyBuffer(MemoryType::kGPU, nvinfer1::DataType::kINT32);
+    }
+    mBlockOffsetsStagingHost->resize(numDirtyRows * rowSize);
+    mBlockOffsetsStagingDevice->resize(numDirtyRows * rowSize);
+    mBlockOffsetsCopyHost->resize(3 * numSegments);
+    mBlockOffsetsCopyDevice->resize(3 * numSegments);
+
+    // Pack the dirty rows, the copy kernel scatters them to their rows in the device table
+    auto* staging = static_cast<std::uint8_t*>(mBlockOffsetsStagingHost->data());
+    auto const* rows = static_cast<std::uint8_t const*>(host.data());
+    auto* srcOffsets = bufferCast<std::int32_t>(*mBlockOffsetsCopyHost);
+    auto* dstOffsets = srcOffsets + numSegments;
+    auto* sizes = dstOffsets + numSegments;
+    SizeType32 stagedRows{0};
+    std::size_t maxSegmentSize{0};
+    for (std::size_t i = 0; i < numSegments; ++i)
+    {
+        auto const& segment = segments[i];
+        std::memcpy(staging + stagedRows * rowSizeInBytes, rows + segment.firstRow * rowSizeInBytes,
+            segment.numRows * rowSizeInBytes);
+        srcOffsets[i] = static_cast<std::int32_t>(stagedRows * rowSize);
+        dstOffsets[i] = static_cast<std::int32_t>(segment.firstRow * rowSize);
+        sizes[i] = static_cast<std::int32_t>(segment.numRows * rowSize);
+        maxSegmentSize = std::max(maxSegmentSize, segment.numRows * rowSize);
+        stagedRows += segment.numRows;
+    }
+    manager.copy(*mBlockOffsetsStagingHost, *mBlockOffsetsStagingDevice);
+    manager.copy(*mBlockOffsetsCopyHost, *mBlockOffsetsCopyDevice);
+
+    auto const srcOffsetsDevice = IBuffer::slice(mBlockOffsetsCopyDevice, 0, numSegments);
+    auto const dstOffsetsDevice = IBuffer::slice(mBlockOffsetsCopyDevice, numSegments, numSegments);
+    auto const sizesDevice = IBuffer::slice(mBlockOffsetsCopyDevice, 2 * numSegments, numSegments);
+    kernels::invokeCopyBatch(*mBlockOffsetsStagingDevice, device, *srcOffsetsDevice, *dstOffsetsDevice, *sizesDevice,
+        maxSegmentSize, manager.getStream());
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+}
+
 void TransformerBuffers::getRuntimeBuffers(RuntimeBuffers const* runtimeBuffers, TensorMap& inputBuffers,
     TensorMap& outputBuffers, SizeType32 const step, TensorPtr const& inputIds, ModelConfig const& modelConfig,
     WorldConfig const& worldConfig) const
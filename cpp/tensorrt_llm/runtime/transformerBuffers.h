@@ -18,6 +18,7 @@
 
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/dirtyRowTracker.h"
 #include "tensorrt_llm/runtime/generationConfig.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/modelConfig.h"
@@ -81,6 +82,9 @@ protected:
     void tile(RuntimeBuffers* runtimeBuffers, BufferManager& manager, ModelConfig const& modelConfig,
         WorldConfig const& worldConfig);
 
+    //! \brief Copy the rows of kvCacheBlockOffsetsHost that changed since the last copy to kvCacheBlockOffsetsDevice.
+    void copyBlockOffsetsToDevice(BufferManager& manager);
+
 public:
     // engine
     TensorPtr pastKeyValueLengths; // with attention plugin, host tensor
@@ -94,6 +98,16 @@ public:
     TensorPtr kvCacheBlockPoolPointers;
     TensorPtr kvCacheBlockOffsetsHost;         // [batchSize * beamWidth, 2, maxBlocksPerSeq * 2]
     TensorPtr kvCacheBlockOffsetsDevice;       // [batchSize * beamWidth, 2, maxBlocksPerSeq * 2]
+
+private:
+    // Rows are copied with a single copy once more than this fraction of them changed
+    static constexpr double kMaxDirtyRowFraction = 0.5;
+
+    DirtyRowTracker mBlockOffsetsTracker;
+    IBuffer::SharedPtr mBlockOffsetsStagingHost;   // dirty rows
+    IBuffer::SharedPtr mBlockOffsetsStagingDevice; // dirty rows
+    IBuffer::SharedPtr mBlockOffsetsCopyHost;      // [3, numSegments], source offsets, destination offsets, sizes
+    IBuffer::SharedPtr mBlockOffsetsCopyDevice;    // [3, numSegments]
 };
 
 } // namespace tensorrt_llm::runtime
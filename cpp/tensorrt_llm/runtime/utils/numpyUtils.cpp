@@ -21,8 +21,11 @@
 #include "tensorrt_llm/common/stringUtils.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/iTensor.h"
+#include "tensorrt_llm/runtime/mappedFile.h"
 #include <NvInferRuntime.h>
 
+#include <memory>
+
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -180,6 +183,57 @@ int parseNpyHeader(FILE*& f_ptr, uint32_t header_len, nvinfer1::DataType& type,
     return tensor;
 }
 
+namespace
+{
+struct MappedNpy
+{
+    explicit MappedNpy(std::string const& npyFile)
+        : file{npyFile, 0}
+    {
+    }
+
+    MappedFile file;
+    ITensor::UniquePtr tensor;
+};
+} // namespace
+
+[[nodiscard]] ITensor::SharedPtr mapNpy(std::string const& npyFile)
+{
+    FILE* f_ptr = fopen(npyFile.c_str(), "rb");
+    if (f_ptr == nullptr)
+    {
+        throw std::runtime_error("Could not open file " + npyFile);
+    }
+    uint32_t header_len, start_data;
+    nvinfer1::DataType type;
+    std::vector<size_t> shape;
+    try
+    {
+        utils::parseNpyIntro(f_ptr, header_len, start_data);
+        utils::parseNpyHeader(f_ptr, header_len, type, shape);
+    }
+    catch (...)
+    {
+        fclose(f_ptr);
+        throw;
+    }
+    fclose(f_ptr);
+
+    nvinfer1::Dims dims;
+    dims.nbDims = shape.size();
+    std::copy(shape.begin(), shape.end(), dims.d);
+
+    // The pages are read on first access, e.g. while the weights are copied to a cache
+    auto mapped = std::make_shared<MappedNpy>(npyFile);
+    auto const volume = static_cast<std::size_t>(ITensor::volume(dims));
+    TLLM_CHECK_WITH_INFO(start_data + volume * BufferDataType(type).getSize() <= mapped->file.size(),
+        "numpy file %s is truncated", npyFile.c_str());
+    auto* data = static_cast<std::uint8_t*>(const_cast<void*>(mapped->file.data())) + start_data;
+    mapped->tensor = ITensor::wrap(data, type, dims);
+    auto* tensor = mapped->tensor.get();
+    return ITensor::SharedPtr{std::move(mapped), tensor};
+}
+
 void saveNpy(BufferManager& manager, ITensor const& tensor, std::string const& filename)
 {
     // Save tensor to NPY 1.0 format (see https://numpy.org/neps/nep-0001-npy-format.html)
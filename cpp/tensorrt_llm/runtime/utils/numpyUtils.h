@@ -27,6 +27,10 @@ namespace tensorrt_llm::runtime::utils
 //! \brief Create new tensor from numpy file.
 [[nodiscard]] ITensor::UniquePtr loadNpy(BufferManager& manager, std::string const& npyFile, const MemoryType where);
 
+//! \brief Create a host tensor backed by a read-only memory mapping of a numpy file, without copying the data.
+//! The mapping is released with the last reference to the tensor, which must not be written to.
+[[nodiscard]] ITensor::SharedPtr mapNpy(std::string const& npyFile);
+
 //! \brief Save tensor to numpy file.
 void saveNpy(BufferManager& manager, ITensor const& tensor, std::string const& filename);
 
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/virtualMemoryPool.h"
+
+#include "tensorrt_llm/common/assert.h"
+#include "tensorrt_llm/common/cudaDriverWrapper.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <algorithm>
+
+namespace tc = tensorrt_llm::common;
+
+namespace tensorrt_llm::runtime
+{
+
+namespace
+{
+
+void checkDriver(CUresult result, char const* call)
+{
+    if (result != CUDA_SUCCESS)
+    {
+        char const* name = nullptr;
+        tc::CUDADriverWrapper::getInstance()->cuGetErrorName(result, &name);
+        TLLM_THROW("%s failed: %s", call, name != nullptr ? name : "unknown error");
+    }
+}
+
+CUmemAllocationProp makeAllocationProp(int device)
+{
+    CUmemAllocationProp prop{};
+    prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+    prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+    prop.location.id = device;
+    return prop;
+}
+
+} // namespace
+
+VirtualMemoryPool::VirtualMemoryPool(ITensor::Shape const& blockShape, nvinfer1::DataType dataType,
+    SizeType32 maxNumBlocks, std::size_t minChunkSizeInBytes)
+    : mBlockShape{blockShape}
+    , mDataType{dataType}
+    , mMaxNumBlocks{maxNumBlocks}
+    , mBlockSizeInBytes{ITensor::volumeNonNegative(blockShape) * BufferDataType(dataType).getSize()}
+    , mDevice{tc::getDevice()}
+    , mChunkSizeInBytes{0}
+    , mReservedBytes{0}
+    , mBase{0}
+    , mNumBlocks{0}
+{
+    TLLM_CHECK(mMaxNumBlocks > 0);
+    TLLM_CHECK_WITH_INFO(mBlockSizeInBytes > 0, "Blocks must not be empty");
+    auto const& driver = tc::CUDADriverWrapper::getInstance();
+
+    auto const prop = makeAllocationProp(mDevice);
+    std::size_t granularity{0};
+    checkDriver(driver->cuMemGetAllocationGranularity(&granularity, &prop, CU_MEM_ALLOC_GRANULARITY_RECOMMENDED),
+        "cuMemGetAllocationGranularity");
+    mChunkSizeInBytes = tc::divUp(std::max(minChunkSizeInBytes, granularity), granularity) * granularity;
+
+    auto const maxSizeInBytes = static_cast<std::size_t>(mMaxNumBlocks) * mBlockSizeInBytes;
+    mReservedBytes = tc::divUp(maxSizeInBytes, mChunkSizeInBytes) * mChunkSizeInBytes;
+    CUdeviceptr base{0};
+    checkDriver(driver->cuMemAddressReserve(&base, mReservedBytes, granularity, 0, 0), "cuMemAddressReserve");
+    mBase = base;
+    TLLM_LOG_DEBUG("Reserved %zu bytes for %d blocks of %zu bytes, in chunks of %zu bytes", mReservedBytes,
+        mMaxNumBlocks, mBlockSizeInBytes, mChunkSizeInBytes);
+}
+
+VirtualMemoryPool::~VirtualMemoryPool()
+{
+    try
+    {
+        while (!mChunks.empty())
+        {
+            unmapChunk();
+        }
+        checkDriver(tc::CUDADriverWrapper::getInstance()->cuMemAddressFree(mBase, mReservedBytes), "cuMemAddressFree");
+    }
+    catch (std::exception const& e)
+    {
+        TLLM_LOG_EXCEPTION(e);
+    }
+}
+
+SizeType32 VirtualMemoryPool::resize(SizeType32 numBlocks)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    TLLM_CHECK_WITH_INFO(0 <= numBlocks && numBlocks <= mMaxNumBlocks, "Cannot resize the pool of %d blocks to %d",
+        mMaxNumBlocks, numBlocks);
+    auto const sizeInBytes = static_cast<std::size_t>(numBlocks) * mBlockSizeInBytes;
+    auto const numChunks = tc::divUp(sizeInBytes, mChunkSizeInBytes);
+    while (mChunks.size() > numChunks)
+    {
+        unmapChunk();
+    }
+    while (mChunks.size() < numChunks && mapChunk())
+    {
+    }
+    mNumBlocks = static_cast<SizeType32>(
+        std::min(getMappedBytes() / mBlockSizeInBytes, static_cast<std::size_t>(mMaxNumBlocks)));
+    TLLM_LOG_DEBUG("Pool resized to %d blocks, %zu bytes mapped", mNumBlocks, getMappedBytes());
+    TLLM_LOG_TRACE("%s stop", __PRETTY_FUNCTION__);
+    return mNumBlocks;
+}
+
+ITensor::SharedPtr VirtualMemoryPool::getTensor() const
+{
+    auto shape = ITensor::makeShape({mNumBlocks});
+    for (SizeType32 i = 0; i < mBlockShape.nbDims; ++i)
+    {
+        shape.d[shape.nbDims++] = mBlockShape.d[i];
+    }
+    return ITensor::wrap(data(), mDataType, shape);
+}
+
+bool VirtualMemoryPool::mapChunk()
+{
+    auto const& driver = tc::CUDADriverWrapper::getInstance();
+    auto const prop = makeAllocationProp(mDevice);
+    CUmemGenericAllocationHandle handle{};
+    auto const result = driver->cuMemCreate(&handle, mChunkSizeInBytes, &prop, 0);
+    if (result == CUDA_ERROR_OUT_OF_MEMORY)
+    {
+        TLLM_LOG_WARNING("Out of device memory, the pool is limited to %zu bytes", getMappedBytes());
+        return false;
+    }
+    checkDriver(result, "cuMemCreate");
+
+    auto const address = mBase + mChunks.size() * mChunkSizeInBytes;
+    try
+    {
+        checkDriver(driver->cuMemMap(address, mChunkSizeInBytes, 0, handle, 0), "cuMemMap");
+        CUmemAccessDesc access{};
+        access.location = prop.location;
+        access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+        checkDriver(driver->cuMemSetAccess(address, mChunkSizeInBytes, &access, 1), "cuMemSetAccess");
+    }
+    catch (...)
+    {
+        driver->cuMemUnmap(address, mChunkSizeInBytes);
+        driver->cuMemRelease(handle);
+        throw;
+    }
+    mChunks.push_back(handle);
+    MemoryCounters::getInstance().allocate(MemoryType::kGPU, mChunkSizeInBytes);
+    return true;
+}
+
+void VirtualMemoryPool::unmapChunk()
+{
+    auto const& driver = tc::CUDADriverWrapper::getInstance();
+    auto const address = mBase + (mChunks.size() - 1) * mChunkSizeInBytes;
+    auto const handle = mChunks.back();
+    mChunks.pop_back();
+    MemoryCounters::getInstance().deallocate(MemoryType::kGPU, mChunkSizeInBytes);
+    checkDriver(driver->cuMemUnmap(address, mChunkSizeInBytes), "cuMemUnmap");
+    checkDriver(driver->cuMemRelease(handle), "cuMemRelease");
+}
+
+} // namespace tensorrt_llm::runtime
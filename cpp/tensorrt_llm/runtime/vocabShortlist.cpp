@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/vocabShortlist.h"
+
+#include "tensorrt_llm/common/assert.h"
+
+#include <algorithm>
+
+namespace tensorrt_llm::runtime
+{
+
+VocabShortlist::VocabShortlist(
+    SizeType32 maxBatchSize, SizeType32 maxShortlistSize, SizeType32 vocabSize, BufferManager const& manager)
+    : mMaxBatchSize{maxBatchSize}
+    , mMaxShortlistSize{maxShortlistSize}
+    , mVocabSize{vocabSize}
+    , mManager{manager}
+{
+    TLLM_CHECK(mMaxBatchSize > 0);
+    TLLM_CHECK_WITH_INFO(0 < mMaxShortlistSize && mMaxShortlistSize <= mVocabSize,
+        "The max shortlist size %d must be within the vocabulary size %d", mMaxShortlistSize, mVocabSize);
+
+    auto const shortlistsShape = ITensor::makeShape({mMaxBatchSize, mMaxShortlistSize});
+    auto const sizesShape = ITensor::makeShape({mMaxBatchSize});
+    auto constexpr tokenType = TRTDataType<TokenIdType>::value;
+    auto constexpr sizeType = TRTDataType<SizeType32>::value;
+    mShortlistsHost = BufferManager::pinned(shortlistsShape, tokenType);
+    mShortlistSizesHost = BufferManager::pinned(sizesShape, sizeType);
+    mShortlistsDevice = mManager.gpu(shortlistsShape, tokenType);
+    mShortlistSizesDevice = mManager.gpu(sizesShape, sizeType);
+    std::fill_n(bufferCast<TokenIdType>(*mShortlistsHost), mShortlistsHost->getSize(), 0);
+    std::fill_n(bufferCast<SizeType32>(*mShortlistSizesHost), mShortlistSizesHost->getSize(), 0);
+    mManager.copy(*mShortlistsHost, *mShortlistsDevice);
+    mManager.copy(*mShortlistSizesHost, *mShortlistSizesDevice);
+}
+
+void VocabShortlist::setShortlist(SizeType32 slot, VecTokens tokenIds)
+{
+    TLLM_CHECK(0 <= slot && slot < mMaxBatchSize);
+    std::sort(tokenIds.begin(), tokenIds.end());
+    tokenIds.erase(std::unique(tokenIds.begin(), tokenIds.end()), tokenIds.end());
+    auto const size = static_cast<SizeType32>(tokenIds.size());
+    TLLM_CHECK_WITH_INFO(0 < size && size <= mMaxShortlistSize, "The shortlist has %d tokens, expected 1 to %d", size,
+        mMaxShortlistSize);
+    TLLM_CHECK_WITH_INFO(tokenIds.front() >= 0 && tokenIds.back() < mVocabSize,
+        "The shortlist has tokens out of the vocabulary of size %d", mVocabSize);
+
+    auto shortlistHost = ITensor::slice(mShortlistsHost, slot, 1);
+    auto* shortlist = bufferCast<TokenIdType>(*shortlistHost);
+    std::copy(tokenIds.begin(), tokenIds.end(), shortlist);
+    // The padding is never sampled, its logits are -inf, but must stay a valid position for the mapping
+    std::fill(shortlist + size, shortlist + mMaxShortlistSize, tokenIds.front());
+    bufferCast<SizeType32>(*mShortlistSizesHost)[slot] = size;
+
+    auto shortlistDevice = ITensor::slice(mShortlistsDevice, slot, 1);
+    mManager.copy(*shortlistHost, *shortlistDevice);
+    auto sizeHost = ITensor::slice(mShortlistSizesHost, slot, 1);
+    auto sizeDevice = ITensor::slice(mShortlistSizesDevice, slot, 1);
+    mManager.copy(*sizeHost, *sizeDevice);
+}
+
+SizeType32 VocabShortlist::getPosition(SizeType32 slot, TokenIdType tokenId) const
+{
+    auto const size = getShortlistSize(slot);
+    auto const* shortlist
+        = bufferCast<TokenIdType>(*mShortlistsHost) + static_cast<std::size_t>(slot) * mMaxShortlistSize;
+    auto const* it = std::lower_bound(shortlist, shortlist + size, tokenId);
+    return it != shortlist + size && *it == tokenId ? static_cast<SizeType32>(it - shortlist) : -1;
+}
+
+SizeType32 VocabShortlist::getShortlistSize(SizeType32 slot) const
+{
+    TLLM_CHECK(0 <= slot && slot < mMaxBatchSize);
+    return bufferCast<SizeType32>(*mShortlistSizesHost)[slot];
+}
+
+} // namespace tensorrt_llm::runtime
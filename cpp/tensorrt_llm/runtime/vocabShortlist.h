@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/iTensor.h"
+
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Vocabulary shortlists of the requests, the candidate tokens their LM head and sampling are restricted to,
+//! e.g. the tokens of a domain or of a LoRA task.
+//! \details With a shortlist the logits are computed for its tokens only by kernels::invokeShortlistLogits, a GEMV
+//! over the gathered rows of the LM head instead of the full GEMM, and the sampling layers run over
+//! getMaxShortlistSize() columns instead of the padded vocabulary. The end id of a request is passed to the sampling
+//! as its position in the shortlist, see getPosition, and the sampled positions are mapped back to token ids by
+//! kernels::invokeMapShortlistTokens. Requests sharing a shortlist, e.g. those of a LoRA task, each set it in their
+//! slot.
+class VocabShortlist
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+    using VecTokens = std::vector<TokenIdType>;
+
+    VocabShortlist(SizeType32 maxBatchSize, SizeType32 maxShortlistSize, SizeType32 vocabSize,
+        BufferManager const& manager);
+
+    //! \brief Set the shortlist of a slot, before the first generation step of its request. The tokens are sorted and
+    //! deduplicated, they must contain the end id of the request.
+    void setShortlist(SizeType32 slot, VecTokens tokenIds);
+
+    //! \brief Position of a token in the shortlist of a slot, -1 if it is not in the shortlist.
+    [[nodiscard]] SizeType32 getPosition(SizeType32 slot, TokenIdType tokenId) const;
+
+    [[nodiscard]] SizeType32 getShortlistSize(SizeType32 slot) const;
+
+    [[nodiscard]] SizeType32 getMaxShortlistSize() const
+    {
+        return mMaxShortlistSize;
+    }
+
+    //! \brief [maxBatchSize, maxShortlistSize] on GPU, token ids of the shortlists.
+    [[nodiscard]] TensorPtr const& getShortlists() const
+    {
+        return mShortlistsDevice;
+    }
+
+    //! \brief [maxBatchSize] on GPU, number of tokens of the shortlists.
+    [[nodiscard]] TensorPtr const& getShortlistSizes() const
+    {
+        return mShortlistSizesDevice;
+    }
+
+private:
+    SizeType32 mMaxBatchSize;
+    SizeType32 mMaxShortlistSize;
+    SizeType32 mVocabSize;
+    BufferManager const& mManager;
+    // Pinned copies of the shortlists, the source of the uploads and of the position lookups
+    TensorPtr mShortlistsHost;
+    TensorPtr mShortlistSizesHost;
+    TensorPtr mShortlistsDevice;
+    TensorPtr mShortlistSizesDevice;
+};
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,402 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/logger.h"
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+//! \brief Priority of a task of the WorkStealingPool, e.g. kHIGH for work the current iteration waits for and kLOW for
+//! background prefetching.
+enum class TaskPriority
+{
+    kHIGH = 0,
+    kLOW = 1,
+};
+
+namespace detail
+{
+//! \brief Move-only type-erased task. Callables up to kInlineSize bytes are stored inline, without allocation.
+class WorkerTask
+{
+public:
+    static constexpr std::size_t kInlineSize = 64;
+
+    WorkerTask() noexcept = default;
+
+    template <typename Function, typename = std::enable_if_t<!std::is_same_v<std::decay_t<Function>, WorkerTask>>>
+    explicit WorkerTask(Function&& function)
+    {
+        using Fn = std::decay_t<Function>;
+        if constexpr (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<Fn>)
+        {
+            new (mStorage) Fn(std::forward<Function>(function));
+            mOps = &kInlineOps<Fn>;
+        }
+        else
+        {
+            new (mStorage) Fn*(new Fn(std::forward<Function>(function)));
+            mOps = &kHeapOps<Fn>;
+        }
+    }
+
+    WorkerTask(WorkerTask&& other) noexcept
+    {
+        moveFrom(other);
+    }
+
+    WorkerTask& operator=(WorkerTask&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset();
+            moveFrom(other);
+        }
+        return *this;
+    }
+
+    WorkerTask(WorkerTask const&) = delete;
+    WorkerTask& operator=(WorkerTask const&) = delete;
+
+    ~WorkerTask()
+    {
+        reset();
+    }
+
+    void operator()()
+    {
+        mOps->invoke(mStorage);
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return mOps != nullptr;
+    }
+
+private:
+    struct Ops
+    {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src) noexcept;
+        void (*destroy)(void* storage) noexcept;
+    };
+
+    template <typename Fn>
+    static constexpr Ops kInlineOps{[](void* storage) { (*static_cast<Fn*>(storage))(); },
+        [](void* dst, void* src) noexcept
+        {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        },
+        [](void* storage) noexcept { static_cast<Fn*>(storage)->~Fn(); }};
+
+    template <typename Fn>
+    static constexpr Ops kHeapOps{[](void* storage) { (**static_cast<Fn**>(storage))(); },
+        [](void* dst, void* src) noexcept { new (dst) Fn*(*static_cast<Fn**>(src)); },
+        [](void* storage) noexcept { delete *static_cast<Fn**>(storage); }};
+
+    void moveFrom(WorkerTask& other) noexcept
+    {
+        if (other.mOps != nullptr)
+        {
+            other.mOps->move(mStorage, &other.mStorage);
+            mOps = std::exchange(other.mOps, nullptr);
+        }
+    }
+
+    void reset() noexcept
+    {
+        if (mOps != nullptr)
+        {
+            mOps->destroy(mStorage);
+            mOps = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) unsigned char mStorage[kInlineSize];
+    Ops const* mOps{nullptr};
+};
+} // namespace detail
+
+//! \brief Thread pool with a task queue per worker and work stealing, an alternative to WorkerPool for many small
+//! tasks or tasks of different priorities.
+//! \details Tasks enqueued from a worker go to its own queue, other tasks are distributed round-robin. Idle workers
+//! steal from the other queues. Tasks of priority kHIGH run before tasks of priority kLOW in any queue. Like with
+//! WorkerPool, the destructor only waits for the running tasks. Queued tasks are dropped and their futures report
+//! std::future_errc::broken_promise. Enqueueing during shutdown throws.
+class WorkStealingPool
+{
+public:
+    explicit WorkStealingPool(std::size_t numWorkers = 1, int device = -1)
+        : mNumWorkers(numWorkers)
+        , mShutdown(false)
+        , mDevice(device)
+    {
+        initThreads();
+    }
+
+    ~WorkStealingPool()
+    {
+        shutdown();
+    }
+
+    WorkStealingPool(WorkStealingPool const&) = delete;
+    WorkStealingPool& operator=(WorkStealingPool const&) = delete;
+
+    template <typename Function, typename Return = std::invoke_result_t<std::decay_t<Function>>>
+    std::future<Return> enqueue(Function&& task, TaskPriority priority = TaskPriority::kHIGH)
+    {
+        auto [wrapped, future] = wrap<Return>(std::forward<Function>(task));
+        push(pickQueue(), priority, std::move(wrapped));
+        notify(1);
+        return std::move(future);
+    }
+
+    //! \brief Enqueue several tasks at once, distributed over the workers and waking them with one notification.
+    template <typename Function, typename Return = std::invoke_result_t<std::decay_t<Function>>>
+    std::vector<std::future<Return>> enqueueBulk(
+        std::vector<Function> tasks, TaskPriority priority = TaskPriority::kHIGH)
+    {
+        std::vector<std::future<Return>> futures;
+        futures.reserve(tasks.size());
+        for (auto& task : tasks)
+        {
+            auto [wrapped, future] = wrap<Return>(std::move(task));
+            push(pickQueue(), priority, std::move(wrapped));
+            futures.push_back(std::move(future));
+        }
+        notify(tasks.size());
+        return futures;
+    }
+
+    [[nodiscard]] std::size_t getNumWorkers() const noexcept
+    {
+        return mNumWorkers;
+    }
+
+private:
+    using Task = detail::WorkerTask;
+    static constexpr size_t kMaxNumWorkers = 128;
+    static constexpr std::size_t kNumPriorities = 2;
+
+    struct WorkerQueue
+    {
+        std::mutex mutex;
+        std::array<std::deque<Task>, kNumPriorities> tasks;
+    };
+
+    std::size_t mNumWorkers;
+    std::vector<std::unique_ptr<WorkerQueue>> mQueues;
+    std::vector<std::thread> mThreads;
+    std::atomic<std::size_t> mNextQueue{0};
+
+    // Number of tasks in all queues, workers sleep while it is zero.
+    std::atomic<std::size_t> mNumPending{0};
+    std::mutex mSleepMutex;
+    std::condition_variable mSleepCv;
+
+    std::atomic<bool> mShutdown = false;
+
+    int mDevice{-1};
+
+    //! \brief Pool and queue index of the worker running on the current thread.
+    static inline thread_local WorkStealingPool const* sCurrentPool{nullptr};
+    static inline thread_local std::size_t sCurrentWorker{0};
+
+    template <typename Return, typename Function>
+    static std::pair<Task, std::future<Return>> wrap(Function&& function)
+    {
+        std::promise<Return> promise;
+        auto future = promise.get_future();
+        Task task{[function = std::forward<Function>(function), promise = std::move(promise)]() mutable
+            {
+                try
+                {
+                    if constexpr (std::is_void_v<Return>)
+                    {
+                        function();
+                        promise.set_value();
+                    }
+                    else
+                    {
+                        promise.set_value(function());
+                    }
+                }
+                catch (...)
+                {
+                    promise.set_exception(std::current_exception());
+                }
+            }};
+        return {std::move(task), std::move(future)};
+    }
+
+    std::size_t pickQueue()
+    {
+        if (sCurrentPool == this)
+        {
+            return sCurrentWorker;
+        }
+        return mNextQueue.fetch_add(1, std::memory_order_relaxed) % mNumWorkers;
+    }
+
+    void push(std::size_t queueIndex, TaskPriority priority, Task&& task)
+    {
+        auto& queue = *mQueues[queueIndex];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        // Checked under the queue mutex, so that shutdown drops every task it does not reject.
+        if (mShutdown)
+        {
+            throw std::runtime_error("WorkStealingPool is shutdown cannot enqueue new tasks");
+        }
+        queue.tasks[static_cast<std::size_t>(priority)].push_back(std::move(task));
+        mNumPending.fetch_add(1);
+    }
+
+    void notify(std::size_t numTasks)
+    {
+        {
+            // Pairs with the predicate check of sleeping workers, so that no wake-up is lost.
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+        }
+        if (numTasks == 1)
+        {
+            mSleepCv.notify_one();
+        }
+        else if (numTasks > 1)
+        {
+            mSleepCv.notify_all();
+        }
+    }
+
+    //! \brief Pop the next task of `self`: own queue first, then steal, higher priorities first.
+    Task tryPop(std::size_t self)
+    {
+        for (std::size_t priority = 0; priority < kNumPriorities; ++priority)
+        {
+            for (std::size_t offset = 0; offset < mNumWorkers; ++offset)
+            {
+                auto const index = (self + offset) % mNumWorkers;
+                auto& queue = *mQueues[index];
+                std::lock_guard<std::mutex> lock(queue.mutex);
+                auto& tasks = queue.tasks[priority];
+                if (tasks.empty())
+                {
+                    continue;
+                }
+                // The owner takes the oldest task, thieves the newest.
+                auto task = std::move(index == self ? tasks.front() : tasks.back());
+                index == self ? tasks.pop_front() : tasks.pop_back();
+                mNumPending.fetch_sub(1);
+                return task;
+            }
+        }
+        return Task{};
+    }
+
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            if (mShutdown)
+            {
+                return;
+            }
+            mShutdown = true;
+        }
+        mSleepCv.notify_all();
+        for (auto& thread : mThreads)
+        {
+            thread.join();
+        }
+        // Drop the tasks that did not start, outside of the queue mutexes as their destructors may run any code.
+        for (auto& queue : mQueues)
+        {
+            std::array<std::deque<Task>, kNumPriorities> dropped;
+            {
+                std::lock_guard<std::mutex> lock(queue->mutex);
+                std::swap(dropped, queue->tasks);
+            }
+            mNumPending.fetch_sub(dropped[0].size() + dropped[1].size());
+        }
+    }
+
+    void initThreads()
+    {
+        if (mNumWorkers > kMaxNumWorkers)
+        {
+            throw std::runtime_error(
+                "numWorker > maxNumWorkers " + std::to_string(mNumWorkers) + " > " + std::to_string(kMaxNumWorkers));
+        }
+        if (mNumWorkers == 0)
+        {
+            throw std::runtime_error("WorkStealingPool needs at least one worker");
+        }
+        for (std::size_t i = 0; i < mNumWorkers; ++i)
+        {
+            mQueues.push_back(std::make_unique<WorkerQueue>());
+        }
+        mThreads.reserve(mNumWorkers);
+        for (std::size_t i = 0; i < mNumWorkers; ++i)
+        {
+            mThreads.emplace_back(&WorkStealingPool::doWork, this, i);
+        }
+    }
+
+    void doWork(std::size_t self)
+    {
+        if (mDevice >= 0)
+        {
+            TLLM_CUDA_CHECK(cudaSetDevice(mDevice));
+        }
+        else
+        {
+            TLLM_LOG_WARNING("WorkStealingPool did not set cuda device");
+        }
+        sCurrentPool = this;
+        sCurrentWorker = self;
+        while (!mShutdown)
+        {
+            if (auto task = tryPop(self))
+            {
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(mSleepMutex);
+            mSleepCv.wait(lock, [this]() { return mNumPending > 0 || mShutdown; });
+        }
+        sCurrentPool = nullptr;
+    }
+};
+} // namespace tensorrt_llm::runtime
@@ -18,9 +18,11 @@
 
 #include "tensorrt_llm/common/assert.h"
 #include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/envUtils.h"
 #include "tensorrt_llm/common/logger.h"
 #include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/common/stringUtils.h"
+#include "tensorrt_llm/runtime/deviceTopology.h"
 
 #include <algorithm>
 #include <numeric>
@@ -128,7 +130,26 @@ WorldConfig WorldConfig::mpi(SizeType32 gpusPerNode, std::optional<SizeType32> t
         gpusPerNode = 1;
     }
 
-    return WorldConfig{tp, pp, mpiRank, gpusPerNode, deviceIds};
+    // Tensor parallel ranks are consecutive, place each group of them on devices of one NVLink island. Every rank of
+    // the node reads the same topology and computes the same placement.
+    auto placedDeviceIds = deviceIds;
+    auto const groupSize = std::min(tp, gpusPerNode);
+    if (!placedDeviceIds.has_value() && groupSize > 1 && deviceCount >= gpusPerNode
+        && !tc::getEnvDisableTopologyAwarePlacement())
+    {
+        std::vector<SizeType32> devices(gpusPerNode);
+        std::iota(devices.begin(), devices.end(), 0);
+        auto const islands = DeviceTopology::getNvlinkIslands(devices);
+        auto placed = DeviceTopology::placeGroups(islands, groupSize);
+        if (placed != devices)
+        {
+            TLLM_LOG_INFO("Placing TP groups of %d ranks within %zu NVLink islands, devices: %s", groupSize,
+                islands.size(), tc::arr2str(placed.data(), placed.size()).c_str());
+            placedDeviceIds = std::move(placed);
+        }
+    }
+
+    return WorldConfig{tp, pp, mpiRank, gpusPerNode, placedDeviceIds};
 #else
     return WorldConfig();
 #endif
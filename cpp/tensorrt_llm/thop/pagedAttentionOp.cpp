@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/thop/pagedAttentionOp.h"
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+namespace torch_ext
+{
+
+namespace
+{
+
+template <typename T>
+void runPagedMaskedAttention(th::Tensor& output, th::Tensor const& qkv, th::Tensor const& sequenceLengths,
+    th::Tensor const& contextLengths, th::optional<th::Tensor> const& cacheIndirection, tk::KVBlockArray const& kvCache,
+    int64_t maxPastKVLength, int64_t beamWidth, int64_t numHeads, int64_t numKVHeads, int64_t headSize,
+    double qScaling, int64_t rotaryEmbeddingDim, double rotaryEmbeddingBase, int64_t positionEmbeddingType,
+    bool multiBlockMode, cudaStream_t stream)
+{
+    auto const batchBeam = static_cast<int>(qkv.size(0));
+    auto const hiddenUnits = static_cast<int>(numHeads * headSize);
+    auto const hiddenUnitsKV = static_cast<int>(numKVHeads * headSize);
+
+    tk::Masked_multihead_attention_params<T> params{};
+    params.out = output.data_ptr();
+    params.q = reinterpret_cast<T const*>(qkv.data_ptr());
+    params.k = params.q + hiddenUnits;
+    params.v = params.k + hiddenUnitsKV;
+    params.stride = hiddenUnits + 2 * hiddenUnitsKV;
+
+    params.cache_indir = cacheIndirection.has_value() ? cacheIndirection.value().data_ptr<int32_t>() : nullptr;
+    params.batch_size = batchBeam / static_cast<int>(beamWidth);
+    params.beam_width = static_cast<int>(beamWidth);
+    params.max_attention_window_size = kvCache.mMaxAttentionWindow;
+    params.cyclic_attention_window_size = kvCache.mMaxAttentionWindow;
+    params.sink_token_length = kvCache.mSinkTokens;
+    params.length_per_sample = sequenceLengths.data_ptr<int32_t>();
+    params.input_lengths = contextLengths.data_ptr<int32_t>();
+    params.timestep = static_cast<int>(maxPastKVLength);
+    params.num_heads = static_cast<int>(numHeads);
+    params.num_kv_heads = static_cast<int>(numKVHeads);
+    params.hidden_size_per_head = static_cast<int>(headSize);
+    params.position_embedding_type = static_cast<tk::PositionEmbeddingType>(positionEmbeddingType);
+    params.rotary_embedding_dim = static_cast<int>(rotaryEmbeddingDim);
+    params.rotary_embedding_base = static_cast<float>(rotaryEmbeddingBase);
+    params.rotary_embedding_scale_type = tk::RotaryScalingType::kNONE;
+    params.rotary_embedding_scale = 1.0f;
+    params.inv_sqrt_dh = 1.F / (sqrtf(static_cast<float>(headSize)) * static_cast<float>(qScaling));
+    params.multi_processor_count = tc::getMultiProcessorCount();
+
+    // The multi-block buffers come from the caching allocator of torch on the current stream, so they are reused
+    // across the calls without a synchronization.
+    auto const maxTimesteps = std::min(params.timestep, params.cyclic_attention_window_size);
+    auto const minNumSeqLenTiles
+        = tk::estimate_min_multi_block_count<T>(maxTimesteps, tc::getMaxSharedMemoryPerBlockOptin() - 2048);
+    auto const numSeqLenTiles = static_cast<int>(tc::divUp(params.multi_processor_count, batchBeam * params.num_heads));
+    auto const maxNumSeqLenTiles = std::max(multiBlockMode ? numSeqLenTiles : 0, minNumSeqLenTiles);
+    th::Tensor partialOut;
+    th::Tensor partialSumMax;
+    th::Tensor blockCounter;
+    if ((multiBlockMode && maxNumSeqLenTiles > 1) || minNumSeqLenTiles > 1)
+    {
+        auto const opts = th::TensorOptions().device(qkv.device());
+        partialOut = th::empty({maxNumSeqLenTiles, batchBeam, hiddenUnits}, opts.dtype(qkv.scalar_type()));
+        partialSumMax = th::empty({2, maxNumSeqLenTiles, batchBeam, numHeads}, opts.dtype(th::kFloat32));
+        blockCounter = th::zeros({batchBeam, numHeads}, opts.dtype(th::kInt32));
+
+        params.multi_block_mode = true;
+        params.min_seq_len_tile = std::max(1, minNumSeqLenTiles);
+        params.max_seq_len_tile = maxNumSeqLenTiles;
+        params.partial_out = reinterpret_cast<T*>(partialOut.data_ptr());
+        params.partial_sum = partialSumMax.data_ptr<float>();
+        params.partial_max = params.partial_sum + partialSumMax.numel() / 2;
+        params.block_counter = blockCounter.data_ptr<int32_t>();
+    }
+
+    tk::masked_multihead_attention(params, kvCache, stream);
+}
+
+} // namespace
+
+th::Tensor pagedMaskedAttention(th::Tensor qkv, th::Tensor sequenceLengths, th::Tensor contextLengths,
+    th::Tensor kvCacheBlockOffsets, th::Tensor hostKVCachePoolPointers,
+    th::optional<th::Tensor> cacheIndirection, int64_t layerIdx, int64_t maxPastKVLength, int64_t beamWidth,
+    int64_t numHeads, int64_t numKVHeads, int64_t headSize, int64_t tokensPerBlock, int64_t maxAttentionWindow,
+    int64_t sinkTokenLength, double qScaling, int64_t rotaryEmbeddingDim, double rotaryEmbeddingBase,
+    int64_t positionEmbeddingType, bool multiBlockMode)
+{
+    // qkv:                        [batch_beam, (num_heads + 2 * num_kv_heads) * head_size], on gpu
+    // sequence_lengths:           [batch_beam], int32, past kv length + 1, on gpu
+    // context_lengths:            [batch_beam], int32, on gpu
+    // kv_cache_block_offsets:     [batch_beam, 2, max_blocks_per_seq], int32, on gpu
+    // host_kv_cache_pool_pointers: [2], int64, primary and secondary pool, on cpu
+    // cache_indirection:          [batch, beam, max_attention_window], int32, on gpu, optional
+    CHECK_TH_CUDA(qkv);
+    CHECK_CONTIGUOUS(qkv);
+    CHECK_INPUT(sequenceLengths, th::kInt32);
+    CHECK_INPUT(contextLengths, th::kInt32);
+    CHECK_INPUT(kvCacheBlockOffsets, th::kInt32);
+    CHECK_CPU_INPUT(hostKVCachePoolPointers, th::kInt64);
+    CHECK_OPTIONAL_INPUT(cacheIndirection, th::kInt32);
+
+    TLLM_CHECK_WITH_INFO(qkv.dim() == 2, "qkv should be a 2D tensor.");
+    auto const batchBeam = qkv.size(0);
+    TLLM_CHECK_WITH_INFO(qkv.size(1) == (numHeads + 2 * numKVHeads) * headSize,
+        "qkv should have (num_heads + 2 * num_kv_heads) * head_size columns.");
+    TLLM_CHECK_WITH_INFO(beamWidth > 0 && batchBeam % beamWidth == 0, "batch_beam should be a multiple of beam_width.");
+    TLLM_CHECK_WITH_INFO(beamWidth == 1 || cacheIndirection.has_value(), "beam search needs the cache_indirection.");
+    TLLM_CHECK_WITH_INFO(sequenceLengths.numel() == batchBeam && contextLengths.numel() == batchBeam,
+        "sequence_lengths and context_lengths should have batch_beam elements.");
+    TLLM_CHECK_WITH_INFO(kvCacheBlockOffsets.dim() == 3 && kvCacheBlockOffsets.size(0) == batchBeam
+            && kvCacheBlockOffsets.size(1) == 2,
+        "kv_cache_block_offsets should be of shape [batch_beam, 2, max_blocks_per_seq].");
+    TLLM_CHECK_WITH_INFO(hostKVCachePoolPointers.numel() == 2, "host_kv_cache_pool_pointers should have 2 elements.");
+    TLLM_CHECK_WITH_INFO(tk::mmha_supported(static_cast<int>(headSize)), "Head size %ld is not supported by MMHA.",
+        headSize);
+    auto const embeddingType = static_cast<tk::PositionEmbeddingType>(positionEmbeddingType);
+    TLLM_CHECK_WITH_INFO(embeddingType == tk::PositionEmbeddingType::kLEARNED_ABSOLUTE
+            || embeddingType == tk::PositionEmbeddingType::kROPE_GPTJ
+            || embeddingType == tk::PositionEmbeddingType::kROPE_GPT_NEOX,
+        "Only the learned absolute and the rotary position embeddings are supported.");
+
+    auto stream = at::cuda::getCurrentCUDAStream().stream();
+
+    // Same layout as the pools of the KV cache manager, the K and V blocks of all the layers are interleaved.
+    auto const bytesPerToken = static_cast<int32_t>(numKVHeads * headSize * qkv.element_size());
+    auto const layerOffset = layerIdx * 2 * tokensPerBlock * bytesPerToken;
+    auto const* poolPointers = hostKVCachePoolPointers.data_ptr<int64_t>();
+    auto* primaryPool = reinterpret_cast<int8_t*>(poolPointers[0]) + layerOffset;
+    auto* secondaryPool = poolPointers[1] != 0 ? reinterpret_cast<int8_t*>(poolPointers[1]) + layerOffset : nullptr;
+    tk::KVBlockArray const kvCache(static_cast<int32_t>(batchBeam), static_cast<int32_t>(kvCacheBlockOffsets.size(2)),
+        static_cast<int32_t>(tokensPerBlock), bytesPerToken, static_cast<int32_t>(maxAttentionWindow),
+        static_cast<int32_t>(sinkTokenLength), primaryPool, secondaryPool,
+        reinterpret_cast<tk::KVBlockArray::DataType*>(kvCacheBlockOffsets.data_ptr<int32_t>()));
+
+    // Allocated by torch on the current stream, the kernel writes the attention output in place.
+    auto output = th::empty({batchBeam, numHeads * headSize}, qkv.options());
+
+    switch (qkv.scalar_type())
+    {
+    case at::ScalarType::Float:
+        runPagedMaskedAttention<float>(output, qkv, sequenceLengths, contextLengths, cacheIndirection, kvCache,
+            maxPastKVLength, beamWidth, numHeads, numKVHeads, headSize, qScaling, rotaryEmbeddingDim,
+            rotaryEmbeddingBase, positionEmbeddingType, multiBlockMode, stream);
+        break;
+    case at::ScalarType::Half:
+        runPagedMaskedAttention<uint16_t>(output, qkv, sequenceLengths, contextLengths, cacheIndirection, kvCache,
+            maxPastKVLength, beamWidth, numHeads, numKVHeads, headSize, qScaling, rotaryEmbeddingDim,
+            rotaryEmbeddingBase, positionEmbeddingType, multiBlockMode, stream);
+        break;
+#ifdef ENABLE_BF16
+    case at::ScalarType::BFloat16:
+        runPagedMaskedAttention<__nv_bfloat16>(output, qkv, sequenceLengths, contextLengths, cacheIndirection,
+            kvCache, maxPastKVLength, beamWidth, numHeads, numKVHeads, headSize, qScaling, rotaryEmbeddingDim,
+            rotaryEmbeddingBase, positionEmbeddingType, multiBlockMode, stream);
+        break;
+#endif
+    default: throw std::runtime_error("Unimplemented scalar type");
+    }
+
+    sync_check_cuda_error();
+    return output;
+}
+
+} // namespace torch_ext
+
+static auto paged_masked_attention
+    = torch::RegisterOperators("tensorrt_llm::paged_masked_attention", &torch_ext::pagedMaskedAttention);
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#pragma once
+
+#include "tensorrt_llm/thop/thUtils.h"
+
+namespace th = torch;
+
+namespace torch_ext
+{
+
+// Generation-phase masked multi-head attention over the paged KV cache, registered as
+// tensorrt_llm::paged_masked_attention. Appends the K and V of the new token to the cache and returns the attention
+// output [batch_beam, num_heads * head_size].
+th::Tensor pagedMaskedAttention(th::Tensor qkv, th::Tensor sequenceLengths, th::Tensor contextLengths,
+    th::Tensor kvCacheBlockOffsets, th::Tensor hostKVCachePoolPointers, th::optional<th::Tensor> cacheIndirection,
+    int64_t layerIdx, int64_t maxPastKVLength, int64_t beamWidth, int64_t numHeads, int64_t numKVHeads,
+    int64_t headSize, int64_t tokensPerBlock, int64_t maxAttentionWindow, int64_t sinkTokenLength, double qScaling,
+    int64_t rotaryEmbeddingDim, double rotaryEmbeddingBase, int64_t positionEmbeddingType, bool multiBlockMode);
+
+} // namespace torch_ext
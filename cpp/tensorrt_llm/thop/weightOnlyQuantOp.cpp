@@ -16,6 +16,7 @@
 
 #include "tensorrt_llm/common/cudaBf16Wrapper.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+#include "tensorrt_llm/kernels/quantization.h"
 #include "tensorrt_llm/thop/thUtils.h"
 
 #if defined(TORCH_VERSION_MAJOR)                                                                                       \
@@ -27,6 +28,7 @@ namespace torch_ext
 {
 using torch::Tensor;
 using namespace tensorrt_llm::kernels::cutlass_kernels;
+using tensorrt_llm::kernels::invokePerChannelWeightQuantization;
 
 void check_quant_type_allowed(torch::ScalarType quant_type)
 {
@@ -138,7 +140,7 @@ Tensor preprocess_weights_for_mixed_gemm(
     const size_t num_rows = row_major_quantized_weight.size(-2);
     const size_t num_cols = (8 / bits_in_quant_type) * row_major_quantized_weight.size(-1);
 
-    Tensor processed_tensor = torch::zeros_like(row_major_quantized_weight);
+    Tensor processed_tensor = torch::empty_like(row_major_quantized_weight);
     int8_t* input_byte_ptr = get_ptr<int8_t>(row_major_quantized_weight);
     int8_t* output_byte_ptr = get_ptr<int8_t>(processed_tensor);
 
@@ -150,10 +152,67 @@ Tensor preprocess_weights_for_mixed_gemm(
     return processed_tensor;
 }
 
+// Quantizes the weight on its GPU, only the unprocessed quantized weight is copied back to preprocess its layout.
+std::vector<Tensor> symmetric_quantize_on_gpu(
+    Tensor weight, QuantType ft_quant_type, bool return_unprocessed_quantized_tensor)
+{
+    const size_t num_experts = weight.dim() == 2 ? 1 : weight.size(0);
+    const size_t num_rows = weight.size(-2);
+    const size_t num_cols = weight.size(-1);
+    int const bits_in_type = get_weight_quant_bits(ft_quant_type);
+
+    auto quantized_weight_shape = weight.sizes().vec();
+    quantized_weight_shape.back() = num_cols * bits_in_type / 8;
+    auto scale_shape = weight.sizes().vec();
+    scale_shape.erase(scale_shape.end() - 2);
+
+    auto const options = torch::TensorOptions().device(weight.device()).requires_grad(false);
+    Tensor quantized_weight = torch::empty(quantized_weight_shape, options.dtype(torch::kInt8));
+    Tensor scales = torch::empty(scale_shape, options.dtype(weight.dtype()));
+
+    auto stream = at::cuda::getCurrentCUDAStream(weight.get_device()).stream();
+    int8_t* quantized_weight_ptr = get_ptr<int8_t>(quantized_weight);
+    if (weight.scalar_type() == at::ScalarType::Float)
+    {
+        invokePerChannelWeightQuantization(quantized_weight_ptr, get_ptr<float>(scales), get_ptr<float const>(weight),
+            num_experts, num_rows, num_cols, bits_in_type, stream);
+    }
+    else if (weight.scalar_type() == at::ScalarType::Half)
+    {
+        invokePerChannelWeightQuantization(quantized_weight_ptr, get_ptr<half>(scales), get_ptr<half const>(weight),
+            num_experts, num_rows, num_cols, bits_in_type, stream);
+    }
+#ifdef ENABLE_BF16
+    else if (weight.scalar_type() == at::ScalarType::BFloat16)
+    {
+        invokePerChannelWeightQuantization(quantized_weight_ptr, get_ptr<__nv_bfloat16>(scales),
+            get_ptr<__nv_bfloat16 const>(weight), num_experts, num_rows, num_cols, bits_in_type, stream);
+    }
+#endif
+    else
+    {
+        TORCH_CHECK(false, "Invalid datatype. Weight must be BF16/FP16");
+    }
+
+    Tensor unprocessed_quantized_weight = quantized_weight.cpu();
+    Tensor processed_quantized_weight = torch::empty_like(unprocessed_quantized_weight);
+    // TODO(dastokes) This should be removed if Grouped GEMM is updated to not need interleaved input
+    bool force_interleave = weight.dim() == 3;
+    preprocess_weights_for_mixed_gemm(get_ptr<int8_t>(processed_quantized_weight),
+        get_ptr<int8_t>(unprocessed_quantized_weight), {num_experts, num_rows, num_cols}, ft_quant_type,
+        force_interleave);
+
+    if (return_unprocessed_quantized_tensor)
+    {
+        return std::vector<Tensor>{unprocessed_quantized_weight, processed_quantized_weight, scales.cpu()};
+    }
+
+    return std::vector<Tensor>{processed_quantized_weight, scales.cpu()};
+}
+
 std::vector<Tensor> symmetric_quantize_helper(
     Tensor weight, torch::ScalarType quant_type, bool return_unprocessed_quantized_tensor)
 {
-    CHECK_CPU(weight);
     CHECK_CONTIGUOUS(weight);
     TORCH_CHECK(weight.numel() != 0, "weight should not be empty tensor");
     TORCH_CHECK(weight.dim() == 2 || weight.dim() == 3, "Invalid dim. The dim of weight should be 2 or 3");
@@ -164,6 +223,12 @@ std::vector<Tensor> symmetric_quantize_helper(
     check_quant_type_allowed(quant_type);
     QuantType ft_quant_type = get_ft_quant_type(quant_type);
 
+    if (weight.is_cuda())
+    {
+        return symmetric_quantize_on_gpu(weight, ft_quant_type, return_unprocessed_quantized_tensor);
+    }
+    CHECK_CPU(weight);
+
     const size_t num_experts = weight.dim() == 2 ? 1 : weight.size(0);
     const size_t num_rows = weight.size(-2);
     const size_t num_cols = weight.size(-1);
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/adaptiveChunking.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+TEST(AdaptiveChunkSizerTest, BudgetFollowsLatency)
+{
+    // 5 ms + 0.05 ms per context token + 0.1 ms per generation request.
+    AdaptiveChunkSizer sizer{40.0, 8192, 64};
+    // (40 - 5 - 10 * 0.1) / 0.05 = 680 tokens, rounded down to the chunk unit.
+    EXPECT_EQ(sizer.getContextTokenBudget(10), 640);
+
+    // Iterations get twice as expensive per token, the budget shrinks.
+    for (int i = 0; i < 200; ++i)
+    {
+        for (SizeType32 numTokens : {0, 256, 512, 1024})
+        {
+            for (SizeType32 numRequests : {0, 16, 64})
+            {
+                sizer.update(numTokens, numRequests, 5.0 + 0.1 * numTokens + 0.1 * numRequests);
+            }
+        }
+    }
+    EXPECT_NEAR(sizer.getCostModel().getMsPerContextToken(), 0.1, 1e-3);
+    EXPECT_EQ(sizer.getContextTokenBudget(10), 320);
+}
+
+TEST(AdaptiveChunkSizerTest, BudgetBounds)
+{
+    AdaptiveChunkSizer sizer{10.0, 1024, 64, IterationCostModel{20.0}};
+    // The generation requests alone exceed the latency budget, still schedule one chunk unit.
+    EXPECT_EQ(sizer.getContextTokenBudget(10), 64);
+    // Never exceed maxNumTokens.
+    AdaptiveChunkSizer fast{1000.0, 1024, 64, IterationCostModel{0.0, 0.001}};
+    EXPECT_EQ(fast.getContextTokenBudget(24), 1000 / 64 * 64);
+    EXPECT_EQ(fast.getContextTokenBudget(1000), 24);
+}
+
+TEST(AdaptiveChunkSizerTest, ComputeChunkSizes)
+{
+    AdaptiveChunkSizer sizer{40.0, 8192, 64};
+    // Budget of 640 tokens with 10 generation requests. Partial chunks are rounded down to the chunk unit, which
+    // leaves room for the last context to finish.
+    auto const chunkSizes = sizer.computeChunkSizes({100, 300, 500, 10, 10}, 10);
+    EXPECT_EQ(chunkSizes, (std::vector<SizeType32>{100, 300, 192, 10, 10}));
+    EXPECT_EQ(sizer.computeChunkSizes({640, 10}, 10), (std::vector<SizeType32>{640, 0}));
+}
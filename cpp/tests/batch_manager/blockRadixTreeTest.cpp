@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/blockRadixTree.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <numeric>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+
+namespace
+{
+using VecTokens = std::vector<tensorrt_llm::runtime::TokenIdType>;
+
+VecTokens makeTokens(int begin, int end)
+{
+    VecTokens tokens(end - begin);
+    std::iota(tokens.begin(), tokens.end(), begin);
+    return tokens;
+}
+
+PrefixHashState makeState(VecTokens const& tokens, int tokensPerBlock)
+{
+    PrefixHashState state{tokensPerBlock};
+    state.extend(tokens);
+    return state;
+}
+} // namespace
+
+TEST(PrefixHashStateTest, IncrementalMatchesFull)
+{
+    auto constexpr tokensPerBlock = 4;
+    auto const tokens = makeTokens(0, 10);
+
+    PrefixHashState incremental{tokensPerBlock};
+    auto prefix = makeTokens(0, 3);
+    incremental.extend(prefix);
+    incremental.extend(tokens);
+    auto const full = makeState(tokens, tokensPerBlock);
+
+    EXPECT_EQ(incremental.getNumTokens(), 10);
+    EXPECT_EQ(incremental.getNumFullBlocks(), 2);
+    EXPECT_EQ(incremental.getHash(), full.getHash());
+    EXPECT_EQ(incremental.getBlockHash(1), full.getBlockHash(1));
+
+    incremental.removeTokens(tokens, 3);
+    EXPECT_EQ(incremental.getNumTokens(), 7);
+    EXPECT_EQ(incremental.getNumFullBlocks(), 1);
+    EXPECT_EQ(incremental.getHash(), makeState(makeTokens(0, 7), tokensPerBlock).getHash());
+}
+
+TEST(PrefixHashStateTest, ChainedThroughPrefix)
+{
+    auto constexpr tokensPerBlock = 2;
+    // Same second block, different first block
+    auto const a = makeState(VecTokens{1, 2, 3, 4}, tokensPerBlock);
+    auto const b = makeState(VecTokens{5, 6, 3, 4}, tokensPerBlock);
+    EXPECT_NE(a.getBlockHash(1), b.getBlockHash(1));
+}
+
+TEST(BlockRadixTreeTest, FullAndPartialMatch)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+
+    auto const stored = makeTokens(0, 10);
+    EXPECT_EQ(tree.insert(stored, {0, 1, 2}), 3);
+    EXPECT_EQ(tree.size(), 3);
+    // Inserting the same prefix again does not add blocks
+    EXPECT_EQ(tree.insert(makeTokens(0, 8), {7, 8}), 0);
+
+    // Full match of two blocks, then the partial third block matches 2 tokens
+    auto query = makeTokens(0, 10);
+    query[9] = 100;
+    auto const result = tree.match(query, makeState(query, tokensPerBlock));
+    EXPECT_EQ(result.blocks, (std::vector<int>{0, 1}));
+    ASSERT_TRUE(result.partialBlock.has_value());
+    EXPECT_EQ(result.partialBlock.value(), 2);
+    EXPECT_EQ(result.numPartialTokens, 1);
+    EXPECT_EQ(result.numMatchedTokens, 9);
+
+    // Divergence inside the second block
+    auto query2 = makeTokens(0, 12);
+    query2[6] = 100;
+    auto const result2 = tree.match(query2, makeState(query2, tokensPerBlock));
+    EXPECT_EQ(result2.blocks, (std::vector<int>{0}));
+    EXPECT_EQ(result2.numPartialTokens, 2);
+    EXPECT_EQ(result2.numMatchedTokens, 6);
+
+    // maxTokens caps the match
+    auto const result3 = tree.match(stored, makeState(stored, tokensPerBlock), 5);
+    EXPECT_EQ(result3.blocks.size(), 1);
+    EXPECT_EQ(result3.numMatchedTokens, 5);
+
+    auto const& stats = tree.getStats();
+    EXPECT_EQ(stats.numLookups, 3);
+    EXPECT_EQ(stats.numHits, 3);
+    EXPECT_EQ(stats.numFullBlockHits, 4);
+    EXPECT_EQ(stats.numPartialBlockHits, 3);
+    EXPECT_EQ(stats.maxHitDepth, 3);
+}
+
+TEST(BlockRadixTreeTest, Miss)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+    tree.insert(makeTokens(0, 8), {0, 1});
+
+    auto const query = makeTokens(50, 58);
+    auto const result = tree.match(query, makeState(query, tokensPerBlock));
+    EXPECT_TRUE(result.blocks.empty());
+    EXPECT_FALSE(result.partialBlock.has_value());
+    EXPECT_EQ(result.numMatchedTokens, 0);
+    EXPECT_EQ(tree.getStats().numHits, 0);
+}
+
+TEST(BlockRadixTreeTest, EraseLeaf)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+    auto const tokens = makeTokens(0, 8);
+    tree.insert(tokens, {0, 1});
+    auto const state = makeState(tokens, tokensPerBlock);
+
+    // Inner block cannot be erased while it has children
+    EXPECT_FALSE(tree.eraseLeaf(state.getBlockHash(0)));
+    EXPECT_TRUE(tree.eraseLeaf(state.getBlockHash(1)));
+    EXPECT_FALSE(tree.contains(state.getBlockHash(1)));
+    EXPECT_TRUE(tree.eraseLeaf(state.getBlockHash(0)));
+    EXPECT_EQ(tree.size(), 0);
+    EXPECT_FALSE(tree.eraseLeaf(PrefixHashState::kRootHash));
+}
+
+TEST(BlockRadixTreeTest, EraseSubtree)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+    auto const tokens = makeTokens(0, 12);
+    tree.insert(tokens, {0, 1, 2});
+    auto branch = makeTokens(0, 4);
+    branch.insert(branch.end(), {9, 9, 9, 9});
+    tree.insert(branch, {0, 3});
+    auto const state = makeState(tokens, tokensPerBlock);
+
+    auto erased = tree.eraseSubtree(state.getBlockHash(1));
+    std::sort(erased.begin(), erased.end());
+    EXPECT_EQ(erased, (std::vector<int>{1, 2}));
+    EXPECT_EQ(tree.size(), 2);
+    EXPECT_TRUE(tree.contains(state.getBlockHash(0)));
+    EXPECT_TRUE(tree.contains(makeState(branch, tokensPerBlock).getBlockHash(1)));
+    EXPECT_TRUE(tree.eraseSubtree(state.getBlockHash(1)).empty());
+    EXPECT_EQ(tree.eraseSubtree(state.getBlockHash(0)).size(), 2);
+    EXPECT_EQ(tree.size(), 0);
+}
+
+TEST(BlockRadixTreeTest, FullBlocksCompareTokens)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+    auto const tokens = makeTokens(0, 8);
+    tree.insert(tokens, {0, 1});
+
+    // A state whose hashes point at cached blocks of other tokens, as after a hash collision, matches nothing.
+    auto other = tokens;
+    other[5] = 42;
+    auto const result = tree.match(other, makeState(tokens, tokensPerBlock));
+    EXPECT_EQ(result.blocks, (std::vector<int>{0}));
+    EXPECT_EQ(result.numMatchedTokens, 5);
+    EXPECT_EQ(result.partialBlock.value(), 1);
+}
+
+TEST(BlockRadixTreeTest, SeedsSeparateSequences)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<int> tree{tokensPerBlock};
+    auto const tokens = makeTokens(0, 6);
+    auto const loraSeed = PrefixHashState::makeSeed(7, std::nullopt);
+    EXPECT_EQ(PrefixHashState::makeSeed(std::nullopt, std::nullopt), PrefixHashState::kRootHash);
+    EXPECT_NE(loraSeed, PrefixHashState::makeSeed(std::nullopt, 7));
+    EXPECT_NE(loraSeed, PrefixHashState::makeSeed(7, 7));
+
+    EXPECT_EQ(tree.insert(tokens, {0, 1}, loraSeed), 2);
+    // The same tokens without the adapter are new blocks
+    EXPECT_EQ(tree.insert(tokens, {2, 3}), 2);
+
+    PrefixHashState loraState{tokensPerBlock, loraSeed};
+    loraState.extend(tokens);
+    auto const loraMatch = tree.match(tokens, loraState);
+    EXPECT_EQ(loraMatch.blocks, (std::vector<int>{0}));
+    EXPECT_EQ(loraMatch.partialBlock.value(), 1);
+
+    // No partial match across seeds either
+    auto const otherSeed = PrefixHashState::makeSeed(8, std::nullopt);
+    PrefixHashState otherState{tokensPerBlock, otherSeed};
+    auto const shortTokens = makeTokens(0, 3);
+    otherState.extend(shortTokens);
+    auto const otherMatch = tree.match(shortTokens, otherState);
+    EXPECT_EQ(otherMatch.numMatchedTokens, 0);
+
+    // Blocks below the first one keep its seed
+    auto const child = tree.insertChild(loraState.getBlockHash(0), VecTokens{4, 5, 6, 7}, 4);
+    ASSERT_TRUE(child.has_value());
+    auto const longTokens = makeTokens(0, 8);
+    PrefixHashState longState{tokensPerBlock, loraSeed};
+    longState.extend(longTokens);
+    EXPECT_EQ(child.value(), longState.getBlockHash(1));
+}
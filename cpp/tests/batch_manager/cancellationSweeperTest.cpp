@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/cancellationSweeper.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace tensorrt_llm::batch_manager;
+using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+namespace
+{
+
+//! The parts of LlmRequest used by the sweeper.
+struct FakeRequest
+{
+    explicit FakeRequest(std::uint64_t requestId, std::optional<SizeType32> seqSlot = std::nullopt)
+        : mRequestId{requestId}
+        , mSeqSlot{seqSlot}
+    {
+    }
+
+    std::uint64_t mRequestId;
+    std::optional<SizeType32> mSeqSlot;
+    LlmRequestState_t mState{REQUEST_STATE_GENERATION_IN_PROGRESS};
+};
+
+struct FakeKvCacheManager
+{
+    void removeSequence(SizeType32 seqSlot, std::shared_ptr<FakeRequest> const& request)
+    {
+        removed.emplace_back(seqSlot, request != nullptr);
+    }
+
+    // Slot and whether the blocks were stored for reuse
+    std::vector<std::pair<SizeType32, bool>> removed;
+};
+
+struct FakePeftCacheManager
+{
+    void markRequestDone(std::shared_ptr<FakeRequest> const& request)
+    {
+        done.push_back(request->mRequestId);
+    }
+
+    std::vector<std::uint64_t> done;
+};
+
+using Sweeper = BasicCancellationSweeper<FakeRequest, FakeKvCacheManager, FakePeftCacheManager>;
+
+} // namespace
+
+TEST(CancellationSweeperTest, ReleasesCancelledRequestsInOnePass)
+{
+    Sweeper sweeper;
+    Sweeper::RequestList active{std::make_shared<FakeRequest>(1, 0), std::make_shared<FakeRequest>(2, 1),
+        std::make_shared<FakeRequest>(3, 2)};
+    Sweeper::RequestList waiting{std::make_shared<FakeRequest>(4), std::make_shared<FakeRequest>(5)};
+    auto const second = *std::next(active.begin());
+    FakeKvCacheManager kvCacheManager;
+    FakePeftCacheManager peftCacheManager;
+
+    // Nothing to sweep
+    EXPECT_FALSE(sweeper.hasPending());
+    EXPECT_TRUE(sweeper.sweep(active, waiting, &kvCacheManager, &peftCacheManager).requests.empty());
+
+    // Cancelled from other threads, e.g. on client disconnects
+    std::thread first{[&sweeper]() { sweeper.cancel(3); }};
+    std::thread other{[&sweeper]() { sweeper.cancel(5); }};
+    first.join();
+    other.join();
+    sweeper.cancel(1);
+    sweeper.cancel(42);
+    EXPECT_TRUE(sweeper.hasPending());
+
+    auto const result = sweeper.sweep(active, waiting, &kvCacheManager, &peftCacheManager);
+    EXPECT_FALSE(sweeper.hasPending());
+    ASSERT_EQ(result.requests.size(), 3U);
+    EXPECT_EQ(result.requests[0]->mRequestId, 1U);
+    EXPECT_EQ(result.requests[1]->mRequestId, 3U);
+    EXPECT_EQ(result.requests[2]->mRequestId, 5U);
+    for (auto const& request : result.requests)
+    {
+        EXPECT_EQ(request->mState, REQUEST_STATE_GENERATION_COMPLETE);
+        EXPECT_FALSE(request->mSeqSlot.has_value());
+    }
+    EXPECT_EQ(result.seqSlots, (std::vector<SizeType32>{0, 2}));
+    EXPECT_EQ(kvCacheManager.removed, (std::vector<std::pair<SizeType32, bool>>{{0, false}, {2, false}}));
+    EXPECT_EQ(peftCacheManager.done, (std::vector<std::uint64_t>{1, 3}));
+
+    ASSERT_EQ(active.size(), 1U);
+    EXPECT_EQ(active.front(), second);
+    ASSERT_EQ(waiting.size(), 1U);
+    EXPECT_EQ(waiting.front()->mRequestId, 4U);
+
+    auto const& stats = sweeper.getStats();
+    EXPECT_EQ(stats.numSweeps, 1U);
+    EXPECT_EQ(stats.numCancelled, 3U);
+    EXPECT_EQ(stats.numUnknown, 1U);
+}
+
+TEST(CancellationSweeperTest, StoresBlocksForReuseOnRequest)
+{
+    Sweeper sweeper{Sweeper::Config{true}};
+    Sweeper::RequestList active{std::make_shared<FakeRequest>(1, 3)};
+    Sweeper::RequestList waiting;
+    FakeKvCacheManager kvCacheManager;
+
+    sweeper.cancel(1);
+    // Without PEFT
+    auto const result = sweeper.sweep(active, waiting, &kvCacheManager, nullptr);
+    EXPECT_EQ(result.seqSlots, (std::vector<SizeType32>{3}));
+    EXPECT_EQ(kvCacheManager.removed, (std::vector<std::pair<SizeType32, bool>>{{3, true}}));
+    EXPECT_TRUE(active.empty());
+}
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/encoderBatchScheduler.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <numeric>
+
+using namespace tensorrt_llm::batch_manager;
+using tensorrt_llm::runtime::SizeType32;
+
+namespace
+{
+//! The parts of LlmRequest used by the scheduler.
+struct FakeRequest
+{
+    using VecTokens = std::vector<tensorrt_llm::runtime::TokenIdType>;
+
+    FakeRequest(std::uint64_t requestId, SizeType32 encoderLen)
+        : mRequestId{requestId}
+        , encoderTokens{std::make_shared<VecTokens>(encoderLen)}
+    {
+        std::iota(encoderTokens.value()->begin(), encoderTokens.value()->end(), 0);
+    }
+
+    [[nodiscard]] bool isEncoderInitState() const
+    {
+        return mState == REQUEST_STATE_ENCODER_INIT;
+    }
+
+    [[nodiscard]] std::optional<std::shared_ptr<VecTokens>> const& getEncoderTokens() const
+    {
+        return encoderTokens;
+    }
+
+    [[nodiscard]] SizeType32 getEncoderLen() const
+    {
+        return static_cast<SizeType32>(encoderTokens.value()->size());
+    }
+
+    std::uint64_t mRequestId;
+    std::optional<std::shared_ptr<VecTokens>> encoderTokens;
+    LlmRequestState_t mState{REQUEST_STATE_ENCODER_INIT};
+};
+
+using Scheduler = BasicEncoderBatchScheduler<FakeRequest>;
+using RequestPtr = Scheduler::RequestPtr;
+} // namespace
+
+TEST(EncoderBatchSchedulerTest, PacksWithoutPadding)
+{
+    Scheduler scheduler{Scheduler::Config{100, 8}};
+    std::vector<RequestPtr> requests{std::make_shared<FakeRequest>(0, 60), std::make_shared<FakeRequest>(1, 50),
+        std::make_shared<FakeRequest>(2, 30)};
+    requests[1]->mState = REQUEST_STATE_GENERATION_IN_PROGRESS;
+    requests.push_back(std::make_shared<FakeRequest>(3, 10));
+
+    // Request 1 is not in the encoder phase, request 2 fills the step after request 0.
+    auto batch = scheduler.schedule(requests);
+    ASSERT_TRUE(batch.has_value());
+    ASSERT_EQ(batch->slices.size(), 3);
+    EXPECT_EQ(batch->inputLengths, (std::vector<SizeType32>{60, 30, 10}));
+    EXPECT_EQ(batch->inputIds.size(), 100);
+    EXPECT_EQ(batch->inputIds[60], 0);
+
+    auto const encoded = scheduler.finish(*batch);
+    EXPECT_EQ(encoded.size(), 3);
+    EXPECT_EQ(scheduler.getStats().numTokens, 100);
+    EXPECT_EQ(scheduler.getStats().numPaddedTokens, 180);
+}
+
+TEST(EncoderBatchSchedulerTest, EncodesInChunks)
+{
+    Scheduler scheduler{Scheduler::Config{64, 8, 32}};
+    std::vector<RequestPtr> requests{std::make_shared<FakeRequest>(0, 80)};
+
+    SizeType32 numSteps{0};
+    std::vector<RequestPtr> encoded;
+    while (encoded.empty())
+    {
+        auto batch = scheduler.schedule(requests);
+        ASSERT_TRUE(batch.has_value());
+        ASSERT_EQ(batch->slices.size(), 1);
+        EXPECT_EQ(batch->slices.front().begin, numSteps * 32);
+        EXPECT_EQ(batch->inputIds.front(), numSteps * 32);
+        encoded = scheduler.finish(*batch);
+        ++numSteps;
+    }
+    EXPECT_EQ(numSteps, 3);
+}
+
+TEST(EncoderBatchSchedulerTest, DefersSmallSteps)
+{
+    Scheduler::Config config{1024, 8};
+    config.minNumTokens = 100;
+    config.maxWaitIterations = 2;
+    Scheduler scheduler{config};
+    std::vector<RequestPtr> requests{std::make_shared<FakeRequest>(0, 20)};
+
+    EXPECT_FALSE(scheduler.schedule(requests).has_value());
+    EXPECT_FALSE(scheduler.schedule(requests).has_value());
+    // Waited long enough
+    EXPECT_TRUE(scheduler.schedule(requests).has_value());
+
+    requests.push_back(std::make_shared<FakeRequest>(1, 100));
+    EXPECT_TRUE(scheduler.schedule(requests).has_value());
+}
@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/encoderOutputCache.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <optional>
+
+using namespace tensorrt_llm::batch_manager;
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+using VecTokens = std::vector<TokenIdType>;
+
+//! The parts of LlmRequest used by the cache.
+struct FakeRequest
+{
+    FakeRequest(VecTokens encoderTokens, std::optional<std::uint64_t> loraTaskId = std::nullopt)
+        : encoderTokens{std::make_shared<VecTokens>(std::move(encoderTokens))}
+        , loraTaskId{loraTaskId}
+    {
+    }
+
+    [[nodiscard]] bool isEncoderInitState() const
+    {
+        return mState == REQUEST_STATE_ENCODER_INIT;
+    }
+
+    [[nodiscard]] std::optional<std::shared_ptr<VecTokens>> const& getEncoderTokens() const
+    {
+        return encoderTokens;
+    }
+
+    [[nodiscard]] std::optional<std::uint64_t> getLoraTaskId() const
+    {
+        return loraTaskId;
+    }
+
+    [[nodiscard]] ITensor::SharedPtr const& getEncoderOutput() const
+    {
+        return encoderOutput;
+    }
+
+    [[nodiscard]] ITensor::SharedPtr const& getEncoderHiddenStates() const
+    {
+        return encoderHiddenStates;
+    }
+
+    void setEncoderOutput(ITensor::SharedPtr tensor)
+    {
+        encoderOutput = std::move(tensor);
+    }
+
+    void setEncoderHiddenStates(ITensor::SharedPtr tensor)
+    {
+        encoderHiddenStates = std::move(tensor);
+    }
+
+    std::optional<std::shared_ptr<VecTokens>> encoderTokens;
+    std::optional<std::uint64_t> loraTaskId;
+    ITensor::SharedPtr encoderOutput;
+    ITensor::SharedPtr encoderHiddenStates;
+    LlmRequestState_t mState{REQUEST_STATE_ENCODER_INIT};
+};
+
+using Cache = BasicEncoderOutputCache<FakeRequest>;
+
+//! Encoder output of 1 KiB
+ITensor::SharedPtr makeOutput()
+{
+    return BufferManager::cpu(ITensor::makeShape({4, 64}), nvinfer1::DataType::kFLOAT);
+}
+} // namespace
+
+TEST(EncoderOutputCacheTest, ReusesOutputOfSameInput)
+{
+    Cache cache{1 << 20};
+    FakeRequest first{{1, 2, 3}};
+    EXPECT_FALSE(cache.lookup(first));
+    first.encoderOutput = makeOutput();
+    first.mState = REQUEST_STATE_CONTEXT_INIT;
+    cache.store(first);
+
+    FakeRequest second{{1, 2, 3}};
+    EXPECT_TRUE(cache.lookup(second));
+    EXPECT_EQ(second.encoderOutput, first.encoderOutput);
+    EXPECT_EQ(second.mState, REQUEST_STATE_CONTEXT_INIT);
+
+    // Other tokens or another LoRA task need the encoder
+    FakeRequest otherTokens{{1, 2, 4}};
+    EXPECT_FALSE(cache.lookup(otherTokens));
+    EXPECT_EQ(otherTokens.mState, REQUEST_STATE_ENCODER_INIT);
+    FakeRequest otherLora{{1, 2, 3}, 7};
+    EXPECT_FALSE(cache.lookup(otherLora));
+
+    auto const stats = cache.getStats();
+    EXPECT_EQ(stats.numHits, 1);
+    EXPECT_EQ(stats.numMisses, 3);
+    EXPECT_EQ(stats.numEntries, 1);
+    EXPECT_EQ(stats.numBytes, first.encoderOutput->getSizeInBytes());
+}
+
+TEST(EncoderOutputCacheTest, DropsLeastRecentlyUsed)
+{
+    // Room for two outputs
+    Cache cache{2 * makeOutput()->getSizeInBytes()};
+    for (TokenIdType token = 0; token < 2; ++token)
+    {
+        FakeRequest request{{token}};
+        request.encoderOutput = makeOutput();
+        cache.store(request);
+    }
+    FakeRequest reuse{{0}};
+    EXPECT_TRUE(cache.lookup(reuse));
+
+    FakeRequest third{{2}};
+    third.encoderOutput = makeOutput();
+    cache.store(third);
+
+    FakeRequest dropped{{1}};
+    EXPECT_FALSE(cache.lookup(dropped));
+    FakeRequest kept{{0}};
+    EXPECT_TRUE(cache.lookup(kept));
+    EXPECT_EQ(cache.getStats().numEntries, 2);
+
+    // Larger than the whole cache, keeps the cached outputs
+    FakeRequest oversized{{3}};
+    oversized.encoderOutput = BufferManager::cpu(ITensor::makeShape({16, 64}), nvinfer1::DataType::kFLOAT);
+    cache.store(oversized);
+    EXPECT_FALSE(cache.lookup(oversized));
+    EXPECT_EQ(cache.getStats().numEntries, 2);
+}
@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/evictionPolicy.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+using namespace std::chrono_literals;
+
+namespace
+{
+BlockEvictionInfo makeInfo(BaseEvictionPolicy::PriorityType priority,
+    std::optional<std::chrono::milliseconds> ttl = std::nullopt, BaseEvictionPolicy::SizeType32 prefixDepth = 0)
+{
+    return BlockEvictionInfo{KvCacheRetention{priority, ttl}, prefixDepth};
+}
+} // namespace
+
+TEST(EvictionPolicyTest, Lru)
+{
+    LruEvictionPolicy policy{3};
+    auto const now = BaseEvictionPolicy::Clock::now();
+    policy.release(2, makeInfo(1.0f), now);
+    policy.release(0, makeInfo(0.0f), now);
+    policy.release(1, makeInfo(0.5f), now);
+    EXPECT_EQ(policy.getNumFree(), 3);
+    EXPECT_TRUE(policy.claim(0));
+    EXPECT_EQ(policy.evict(now), 2);
+    EXPECT_EQ(policy.evict(now), 1);
+    EXPECT_FALSE(policy.evict(now).has_value());
+}
+
+TEST(EvictionPolicyTest, Priority)
+{
+    PriorityEvictionPolicy policy{4};
+    auto const now = BaseEvictionPolicy::Clock::now();
+    // System prompt block with high priority, released first
+    policy.release(0, makeInfo(0.9f), now);
+    policy.release(1, makeInfo(KvCacheRetention::kDefaultPriority), now);
+    policy.release(2, makeInfo(KvCacheRetention::kDefaultPriority), now);
+    policy.release(3, makeInfo(0.1f), now);
+    EXPECT_EQ(policy.evict(now), 3);
+    EXPECT_EQ(policy.evict(now), 1);
+    EXPECT_FALSE(policy.claim(1));
+    EXPECT_TRUE(policy.claim(2));
+    EXPECT_EQ(policy.getNumFree(), 1);
+    EXPECT_EQ(policy.evict(now), 0);
+    EXPECT_EQ(policy.getNumFree(), 0);
+    policy.release(0, makeInfo(0.9f), now);
+    EXPECT_THROW(policy.release(0, makeInfo(0.9f), now), std::exception);
+}
+
+TEST(EvictionPolicyTest, PriorityTtl)
+{
+    PriorityEvictionPolicy policy{3};
+    auto const now = BaseEvictionPolicy::Clock::now();
+    policy.release(0, makeInfo(0.9f, 10ms), now);
+    policy.release(1, makeInfo(0.5f), now);
+    policy.release(2, makeInfo(0.9f, 10ms), now);
+    // Block 2 is reused before it expires and released again without TTL
+    EXPECT_TRUE(policy.claim(2));
+    policy.release(2, makeInfo(0.9f), now);
+
+    EXPECT_EQ(policy.evict(now), 1);
+    policy.release(1, makeInfo(0.5f), now);
+    // After the TTL block 0 drops below block 1, block 2 keeps its priority
+    EXPECT_EQ(policy.evict(now + 20ms), 0);
+    EXPECT_EQ(policy.evict(now + 20ms), 1);
+    EXPECT_EQ(policy.evict(now + 20ms), 2);
+}
+
+TEST(EvictionPolicyTest, CostAware)
+{
+    CostAwareEvictionPolicy policy{4};
+    EXPECT_DOUBLE_EQ(CostAwareEvictionPolicy::computeCost(3, 0.0f), 4.0);
+    EXPECT_DOUBLE_EQ(CostAwareEvictionPolicy::computeCost(0, 0.01f), 2.0);
+    EXPECT_DOUBLE_EQ(CostAwareEvictionPolicy::computeCost(1, 1.0f), 202.0);
+
+    auto const now = BaseEvictionPolicy::Clock::now();
+    policy.release(0, makeInfo(0.0f, std::nullopt, 7), now);
+    policy.release(1, makeInfo(0.0f, std::nullopt, 0), now);
+    policy.release(2, makeInfo(0.03f, std::nullopt, 0), now);
+    policy.release(3, makeInfo(1.0f, 5ms, 0), now);
+    EXPECT_EQ(policy.getNumFree(), 4);
+    // Costs are 8, 1, 4 and 101
+    EXPECT_EQ(policy.evict(now), 1);
+    EXPECT_EQ(policy.evict(now), 2);
+    // Block 3 expired and costs 1 now
+    EXPECT_EQ(policy.evict(now + 10ms), 3);
+    EXPECT_EQ(policy.evict(now + 10ms), 0);
+    EXPECT_FALSE(policy.evict(now + 10ms).has_value());
+}
+
+TEST(EvictionPolicyTest, Pinning)
+{
+    PinningEvictionPolicy policy{std::make_unique<LruEvictionPolicy>(4)};
+    auto const now = BaseEvictionPolicy::Clock::now();
+    policy.release(0, makeInfo(0.0f), now);
+    policy.release(1, makeInfo(0.0f), now);
+    policy.release(2, makeInfo(0.0f), now);
+
+    // Free block 0 and block 3 in use are pinned, twice for block 0
+    policy.pin(0, makeInfo(0.0f));
+    policy.pin(0, makeInfo(0.0f));
+    policy.pin(3, makeInfo(0.0f));
+    EXPECT_EQ(policy.getNumPinned(), 2);
+    EXPECT_EQ(policy.getNumFree(), 2);
+    policy.release(3, makeInfo(0.0f), now);
+    EXPECT_EQ(policy.evict(now), 1);
+    EXPECT_EQ(policy.evict(now), 2);
+    EXPECT_FALSE(policy.evict(now).has_value());
+
+    policy.unpin(0, now);
+    EXPECT_TRUE(policy.isPinned(0));
+    policy.unpin(0, now);
+    policy.unpin(3, now);
+    EXPECT_EQ(policy.getNumPinned(), 0);
+    EXPECT_EQ(policy.evict(now), 0);
+    EXPECT_EQ(policy.evict(now), 3);
+
+    // A pinned block reused by its request is not released when unpinned
+    policy.release(1, makeInfo(0.0f), now);
+    policy.pin(1, makeInfo(0.0f));
+    EXPECT_TRUE(policy.claim(1));
+    policy.unpin(1, now);
+    EXPECT_FALSE(policy.evict(now).has_value());
+}
+
+TEST(EvictionPolicyTest, PriorityLevels)
+{
+    EXPECT_EQ(KvCacheRetention::toLevel(KvCacheRetention::kMinPriority), 0);
+    EXPECT_EQ(KvCacheRetention::toLevel(KvCacheRetention::kMaxPriority), KvCacheRetention::kNumPriorityLevels);
+    EXPECT_EQ(KvCacheRetention::toLevel(0.354f), 35);
+    EXPECT_EQ(KvCacheRetention::toLevel(-1.0f), 0);
+    EXPECT_EQ(KvCacheRetention::toLevel(2.0f), KvCacheRetention::kNumPriorityLevels);
+}
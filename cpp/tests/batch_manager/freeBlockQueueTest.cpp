@@ -0,0 +1,111 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/freeBlockQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+
+TEST(FreeBlockQueueTest, ClaimOrder)
+{
+    FreeBlockQueue queue{4};
+    EXPECT_EQ(queue.getNumFree(), 4);
+    for (FreeBlockQueue::IdType id = 0; id < 4; ++id)
+    {
+        EXPECT_EQ(queue.claimFront(), id);
+    }
+    EXPECT_FALSE(queue.claimFront().has_value());
+    EXPECT_EQ(queue.getNumFree(), 0);
+
+    // Back releases are claimed in release order, front releases before them, most recent first.
+    queue.release(2);
+    queue.release(0);
+    queue.release(1, true);
+    queue.release(3, true);
+    EXPECT_EQ(queue.getNumFree(), 4);
+    EXPECT_EQ(queue.claimFront(), 3);
+    EXPECT_EQ(queue.claimFront(), 1);
+    EXPECT_EQ(queue.claimFront(), 2);
+    EXPECT_EQ(queue.claimFront(), 0);
+}
+
+TEST(FreeBlockQueueTest, ClaimSpecific)
+{
+    FreeBlockQueue queue{5};
+    EXPECT_TRUE(queue.claim(2));
+    EXPECT_FALSE(queue.claim(2));
+    EXPECT_FALSE(queue.isFree(2));
+    EXPECT_TRUE(queue.claim(0));
+    EXPECT_TRUE(queue.claim(4));
+    EXPECT_EQ(queue.findFirst([](auto id) { return id > 1; }), 3);
+    EXPECT_EQ(queue.claimFront(), 1);
+    EXPECT_EQ(queue.claimFront(), 3);
+    EXPECT_FALSE(queue.claimFront().has_value());
+
+    // A pending release can be claimed directly
+    queue.release(4);
+    EXPECT_TRUE(queue.isFree(4));
+    EXPECT_TRUE(queue.claim(4));
+    EXPECT_EQ(queue.getNumFree(), 0);
+}
+
+TEST(FreeBlockQueueTest, ConcurrentRelease)
+{
+    auto constexpr numThreads = 4;
+    auto constexpr blocksPerThread = 1000;
+    auto constexpr numBlocks = numThreads * blocksPerThread;
+    FreeBlockQueue queue{numBlocks, false};
+    EXPECT_EQ(queue.getNumFree(), 0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t)
+    {
+        threads.emplace_back(
+            [&queue, t]()
+            {
+                for (int i = 0; i < blocksPerThread; ++i)
+                {
+                    queue.release(t * blocksPerThread + i, i % 2 == 0);
+                }
+            });
+    }
+
+    // Claim concurrently with the releases
+    std::vector<FreeBlockQueue::IdType> claimed;
+    while (static_cast<int>(claimed.size()) < numBlocks)
+    {
+        if (auto id = queue.claimFront())
+        {
+            claimed.push_back(*id);
+        }
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+
+    std::sort(claimed.begin(), claimed.end());
+    for (int i = 0; i < numBlocks; ++i)
+    {
+        ASSERT_EQ(claimed[i], i);
+    }
+    EXPECT_EQ(queue.getNumFree(), 0);
+    EXPECT_FALSE(queue.claimFront().has_value());
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/batch_manager/kvBlockPrefetcher.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <set>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+
+namespace
+{
+using VecTokens = KvBlockPrefetcher::VecTokens;
+
+VecTokens makeTokens(int begin, int end)
+{
+    VecTokens tokens(end - begin);
+    std::iota(tokens.begin(), tokens.end(), begin);
+    return tokens;
+}
+} // namespace
+
+TEST(KvBlockPrefetcherTest, PinsAndOnboardsMatchedBlocks)
+{
+    auto constexpr tokensPerBlock = 4;
+    BlockRadixTree<KvBlockPrefetcher::IdType> tree{tokensPerBlock};
+    tree.insert(makeTokens(0, 12), {0, 1, 2});
+
+    PinningEvictionPolicy policy{std::make_unique<LruEvictionPolicy>(8)};
+    auto const now = KvBlockPrefetcher::Clock::now();
+    for (int blockId = 0; blockId < 8; ++blockId)
+    {
+        policy.release(blockId, BlockEvictionInfo{}, now);
+    }
+
+    // Block 1 was offloaded to the secondary pool
+    std::set<KvBlockPrefetcher::IdType> const secondary{1};
+    std::vector<KvBlockPrefetcher::IdType> onboarded;
+    KvBlockPrefetcher prefetcher{
+        policy, 4, [&](auto blockId) { return secondary.count(blockId) > 0; },
+        [&](auto blockId) { onboarded.push_back(blockId); }};
+
+    // Two full blocks and the partial third one, the last token is left to the context phase
+    EXPECT_EQ(prefetcher.prefetch(1, tree, makeTokens(0, 11)), 3);
+    EXPECT_EQ(onboarded, (std::vector<KvBlockPrefetcher::IdType>{1}));
+    EXPECT_TRUE(policy.isPinned(2));
+    EXPECT_EQ(policy.getNumFree(), 5);
+    EXPECT_EQ(tree.getStats().numLookups, 0);
+
+    // Onboarded once, and only up to the pin budget
+    EXPECT_EQ(prefetcher.prefetch(2, tree, makeTokens(0, 12)), 1);
+    EXPECT_EQ(onboarded.size(), 1u);
+    EXPECT_EQ(prefetcher.prefetch(3, tree, makeTokens(0, 12)), 0);
+    EXPECT_EQ(prefetcher.getNumPinnedBlocks(), 4);
+
+    prefetcher.release(1, now);
+    EXPECT_TRUE(policy.isPinned(0));
+    EXPECT_FALSE(policy.isPinned(2));
+    prefetcher.release(2, now);
+    EXPECT_EQ(policy.getNumPinned(), 0);
+    EXPECT_EQ(policy.getNumFree(), 8);
+
+    auto const& stats = prefetcher.getStats();
+    EXPECT_EQ(stats.numPrefetchedRequests, 2);
+    EXPECT_EQ(stats.numPinnedBlocks, 4);
+    EXPECT_EQ(stats.numOnboardedBlocks, 1);
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+namespace tc = tensorrt_llm::common;
+namespace tr = tensorrt_llm::runtime;
+using SizeType32 = tr::SizeType32;
+
+class KvCacheCopyOnWriteTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        auto stream = std::make_shared<tr::CudaStream>();
+        mBlockManager = std::make_unique<BlockManager>(
+            kNumLayers, kNumKvHeads, kSizePerHead, kTokensPerBlock, kBlocksInPrimaryPool, 0, stream, true);
+        mBlockManager->allocatePools(nvinfer1::DataType::kHALF, false);
+    }
+
+    static constexpr SizeType32 kNumLayers{2};
+    static constexpr SizeType32 kNumKvHeads{2};
+    static constexpr SizeType32 kSizePerHead{16};
+    static constexpr SizeType32 kTokensPerBlock{4};
+    static constexpr SizeType32 kBlocksInPrimaryPool{5};
+
+    std::unique_ptr<BlockManager> mBlockManager;
+};
+
+TEST_F(KvCacheCopyOnWriteTest, CopiesSharedBlocksOnly)
+{
+    // Two blocks, the second one partially filled.
+    GenerationRequest src{0, 6, 1};
+    mBlockManager->addSequence(src, 2, -1);
+    GenerationRequest dst{1, 6, 1};
+    mBlockManager->forkSequence(src, dst);
+    EXPECT_EQ(dst.getCacheBlockIds().at(0), src.getCacheBlockIds().at(0));
+    EXPECT_EQ(mBlockManager->getNumFreeBlocks(), kBlocksInPrimaryPool - 2);
+
+    auto const srcBlockIds = src.getCacheBlockIds().at(0);
+    EXPECT_TRUE(mBlockManager->copyOnWrite(dst, 0, 1));
+    EXPECT_EQ(mBlockManager->getNumFreeBlocks(), kBlocksInPrimaryPool - 3);
+    EXPECT_EQ(src.getCacheBlockIds().at(0), srcBlockIds);
+    EXPECT_EQ(dst.getCacheBlockIds().at(0).at(0), srcBlockIds.at(0));
+    EXPECT_NE(dst.getCacheBlockIds().at(0).at(1), srcBlockIds.at(1));
+
+    // Both blocks are private now.
+    EXPECT_FALSE(mBlockManager->copyOnWrite(dst, 0, 1));
+    EXPECT_FALSE(mBlockManager->copyOnWrite(src, 0, 1));
+    EXPECT_EQ(mBlockManager->getNumFreeBlocks(), kBlocksInPrimaryPool - 3);
+
+    mBlockManager->releaseBlocks(dst);
+    mBlockManager->releaseBlocks(src);
+    EXPECT_EQ(mBlockManager->getNumFreeBlocks(), kBlocksInPrimaryPool);
+}
+
+TEST_F(KvCacheCopyOnWriteTest, ThrowsWithoutFreeBlock)
+{
+    GenerationRequest src{0, 6, 1};
+    mBlockManager->addSequence(src, 2, -1);
+    GenerationRequest dst{1, 6, 1};
+    mBlockManager->forkSequence(src, dst);
+    // Take the remaining blocks.
+    GenerationRequest other{2, 12, 1};
+    mBlockManager->addSequence(other, kBlocksInPrimaryPool - 2, -1);
+    ASSERT_EQ(mBlockManager->getNumFreeBlocks(), 0);
+
+    auto const dstBlockIds = dst.getCacheBlockIds().at(0);
+    EXPECT_THROW(mBlockManager->copyOnWrite(dst, 0, 1), tc::TllmException);
+    EXPECT_EQ(dst.getCacheBlockIds().at(0), dstBlockIds);
+
+    // Once a block is released, the copy succeeds.
+    mBlockManager->releaseBlocks(other);
+    EXPECT_TRUE(mBlockManager->copyOnWrite(dst, 0, 1));
+    mBlockManager->releaseBlocks(dst);
+    mBlockManager->releaseBlocks(src);
+    EXPECT_EQ(mBlockManager->getNumFreeBlocks(), kBlocksInPrimaryPool);
+}
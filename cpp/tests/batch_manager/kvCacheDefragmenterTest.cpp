@@ -0,0 +1,107 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/batch_manager/kvCacheDefragmenter.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using namespace tensorrt_llm::batch_manager;
+using SizeType32 = tensorrt_llm::runtime::SizeType32;
+
+namespace
+{
+
+//! A pool where block i is at memory pool index i, with the given sequences and everything else free.
+KvPoolLayout makeLayout(SizeType32 poolSize, std::vector<std::vector<SizeType32>> sequences)
+{
+    KvPoolLayout layout;
+    layout.blockIds.resize(poolSize);
+    std::iota(layout.blockIds.begin(), layout.blockIds.end(), 100);
+    layout.isFree.assign(poolSize, true);
+    for (auto const& sequence : sequences)
+    {
+        for (auto const poolIdx : sequence)
+        {
+            layout.isFree[poolIdx] = false;
+        }
+    }
+    layout.sequences = std::move(sequences);
+    return layout;
+}
+
+} // namespace
+
+TEST(KvCacheDefragmenterTest, MeasuresScatterAndFreeExtents)
+{
+    // Free: 2, 5-6, 9-11
+    auto const layout = makeLayout(12, {{0, 1}, {3, 7, 4}, {8}});
+    auto const fragmentation = KvCacheDefragmenter::measure(layout);
+    EXPECT_EQ(fragmentation.numSequences, 3);
+    EXPECT_EQ(fragmentation.numSequenceBlocks, 6);
+    EXPECT_EQ(fragmentation.numSequenceRuns, 5);
+    EXPECT_EQ(fragmentation.numFreeBlocks, 6);
+    EXPECT_EQ(fragmentation.numFreeExtents, 3);
+    EXPECT_EQ(fragmentation.largestFreeExtent, 3);
+    EXPECT_FLOAT_EQ(fragmentation.getSequenceScatter(), 2.f / 3.f);
+    EXPECT_FLOAT_EQ(fragmentation.getFreeFragmentation(), 0.5f);
+}
+
+TEST(KvCacheDefragmenterTest, MovesScatteredSequencesToTheBestFit)
+{
+    // Free: 1, 4-6, 9-15
+    auto const layout = makeLayout(16, {{0, 2, 8}, {3, 7}});
+    KvCacheDefragmenter const defragmenter{KvCacheDefragmenter::Config{}};
+    auto const moves = defragmenter.plan(layout);
+
+    // The first sequence has two breaks and goes to 4-6, the second one to 9-10
+    ASSERT_EQ(moves.size(), 5);
+    std::vector<std::pair<SizeType32, SizeType32>> const expected{
+        {100, 104}, {102, 105}, {108, 106}, {103, 109}, {107, 110}};
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(moves[i].blockId, expected[i].first) << "move " << i;
+        EXPECT_EQ(moves[i].freeBlockId, expected[i].second) << "move " << i;
+    }
+}
+
+TEST(KvCacheDefragmenterTest, RespectsTheBudgetAndSharedBlocks)
+{
+    // Sequences 0 and 1 share block 4, sequence 2 is contiguous, sequence 3 does not fit the budget of 3
+    auto const layout = makeLayout(32, {{0, 4}, {4, 6}, {8, 9}, {10, 12, 14, 16}, {18, 20}});
+    KvCacheDefragmenter::Config config;
+    config.maxMovesPerRound = 3;
+    KvCacheDefragmenter const defragmenter{config};
+    auto const moves = defragmenter.plan(layout);
+
+    ASSERT_EQ(moves.size(), 2);
+    EXPECT_EQ(moves[0].blockId, 118);
+    EXPECT_EQ(moves[1].blockId, 120);
+    // Smallest free extent of at least two blocks: 1-3, before 21-31
+    EXPECT_EQ(moves[0].freeBlockId, 101);
+    EXPECT_EQ(moves[1].freeBlockId, 102);
+}
+
+TEST(KvCacheDefragmenterTest, LeavesContiguousPoolsAlone)
+{
+    auto const layout = makeLayout(8, {{0, 1, 2}, {3, 4}});
+    KvCacheDefragmenter const defragmenter{KvCacheDefragmenter::Config{}};
+    EXPECT_TRUE(defragmenter.plan(layout).empty());
+    EXPECT_FLOAT_EQ(KvCacheDefragmenter::measure(layout).getSequenceScatter(), 0.f);
+    EXPECT_FLOAT_EQ(KvCacheDefragmenter::measure(layout).getFreeFragmentation(), 0.f);
+}
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvCacheReuseIndex.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+
+namespace
+{
+using VecTokens = KvCacheReuseIndex::VecTokens;
+
+VecTokens makeTokens(int begin, int end)
+{
+    VecTokens tokens(end - begin);
+    std::iota(tokens.begin(), tokens.end(), begin);
+    return tokens;
+}
+} // namespace
+
+TEST(KvCacheReuseIndexTest, StoreAndMatch)
+{
+    KvCacheReuseIndex index{4};
+    index.store(makeTokens(0, 10), {7, 3, 5}, PrefixHashState::kRootHash);
+    EXPECT_EQ(index.size(), 3);
+    EXPECT_TRUE(index.contains(5));
+
+    auto const result = index.match(makeTokens(0, 12));
+    EXPECT_EQ(result.blocks, (std::vector<KvCacheReuseIndex::IdType>{7, 3}));
+    EXPECT_EQ(result.partialBlock.value(), 5);
+    EXPECT_EQ(result.numMatchedTokens, 10);
+    EXPECT_EQ(index.getStats().numLookups, 1);
+    EXPECT_EQ(index.getStats().maxHitDepth, 3);
+
+    // Another seed, e.g. another LoRA task, reuses nothing.
+    auto const other = index.match(makeTokens(0, 12), PrefixHashState::makeSeed(1, std::nullopt));
+    EXPECT_EQ(other.numMatchedTokens, 0);
+}
+
+TEST(KvCacheReuseIndexTest, InvalidateRemovesDescendants)
+{
+    KvCacheReuseIndex index{4};
+    index.store(makeTokens(0, 12), {0, 1, 2}, PrefixHashState::kRootHash);
+    auto branch = makeTokens(0, 4);
+    branch.insert(branch.end(), {9, 9, 9, 9});
+    index.store(branch, {0, 4}, PrefixHashState::kRootHash);
+    EXPECT_EQ(index.size(), 4);
+
+    // Block 1 was reallocated to other content, block 2 can't be reached without it.
+    index.invalidate({1, 8});
+    EXPECT_EQ(index.size(), 2);
+    EXPECT_FALSE(index.contains(1));
+    EXPECT_FALSE(index.contains(2));
+    EXPECT_TRUE(index.contains(4));
+    EXPECT_EQ(index.match(makeTokens(0, 12)).blocks, (std::vector<KvCacheReuseIndex::IdType>{0}));
+    EXPECT_EQ(index.match(branch).blocks, (std::vector<KvCacheReuseIndex::IdType>{0, 4}));
+
+    index.invalidate({0});
+    EXPECT_EQ(index.size(), 0);
+    EXPECT_FALSE(index.contains(4));
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/batch_manager/kvCacheSnapshot.h"
+
+#include <gtest/gtest.h>
+
+#include <unistd.h>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+using VecTokens = std::vector<tensorrt_llm::runtime::TokenIdType>;
+
+namespace
+{
+constexpr std::uint64_t kBlockSize = 16;
+constexpr std::uint64_t kFingerprint = 42;
+
+class KvCacheSnapshotTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mPath = std::filesystem::temp_directory_path() / ("kvCacheSnapshotTest_" + std::to_string(::getpid()));
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(mPath);
+    }
+
+    //! Block contents are the block id repeated.
+    static void readBlock(int const& blockId, void* dst)
+    {
+        std::memset(dst, blockId, kBlockSize);
+    }
+
+    std::filesystem::path mPath;
+};
+} // namespace
+
+TEST_F(KvCacheSnapshotTest, SaveAndRestore)
+{
+    BlockRadixTree<int> tree{2};
+    tree.insert(VecTokens{1, 2, 3, 4, 5}, {10, 11, 12});
+    tree.insert(VecTokens{1, 2, 6, 7}, {10, 13});
+    EXPECT_EQ(saveKvCacheSnapshot<int>(mPath, tree, kFingerprint, kBlockSize, &readBlock), 4);
+
+    BlockRadixTree<int> restored{2};
+    std::vector<int> contents;
+    auto const numRestored = loadKvCacheSnapshot<int>(mPath, restored, kFingerprint, kBlockSize,
+        [&contents](void const* data) -> std::optional<int>
+        {
+            contents.push_back(*static_cast<char const*>(data));
+            return 100 + static_cast<int>(contents.size());
+        });
+    EXPECT_EQ(numRestored, 4);
+    // Parents first.
+    EXPECT_EQ(contents.front(), 10);
+
+    VecTokens const tokens{1, 2, 3, 4, 5};
+    PrefixHashState state{2};
+    state.extend(tokens);
+    auto const match = restored.match(tokens, state);
+    EXPECT_EQ(match.numMatchedTokens, 5);
+    ASSERT_EQ(match.blocks.size(), 2);
+    EXPECT_EQ(contents[match.blocks[1] - 101], 11);
+    EXPECT_EQ(contents[match.partialBlock.value() - 101], 12);
+}
+
+TEST_F(KvCacheSnapshotTest, KeepsSeeds)
+{
+    auto const seed = PrefixHashState::makeSeed(3, std::nullopt);
+    BlockRadixTree<int> tree{2};
+    tree.insert(VecTokens{1, 2, 3, 4}, {10, 11}, seed);
+    tree.insert(VecTokens{1, 2}, {12});
+    EXPECT_EQ(saveKvCacheSnapshot<int>(mPath, tree, kFingerprint, kBlockSize, &readBlock), 3);
+
+    BlockRadixTree<int> restored{2};
+    int nextValue{0};
+    EXPECT_EQ(loadKvCacheSnapshot<int>(mPath, restored, kFingerprint, kBlockSize,
+                  [&nextValue](void const*) -> std::optional<int> { return nextValue++; }),
+        3);
+
+    VecTokens const tokens{1, 2, 3, 4};
+    PrefixHashState state{2, seed};
+    state.extend(tokens);
+    EXPECT_EQ(restored.match(tokens, state).blocks.size(), 2);
+    PrefixHashState unseeded{2};
+    unseeded.extend(tokens);
+    EXPECT_EQ(restored.match(tokens, unseeded).blocks.size(), 1);
+}
+
+TEST_F(KvCacheSnapshotTest, PoolRunsOut)
+{
+    BlockRadixTree<int> tree{2};
+    tree.insert(VecTokens{1, 2, 3, 4}, {1, 2});
+    tree.insert(VecTokens{5, 6}, {3});
+    saveKvCacheSnapshot<int>(mPath, tree, kFingerprint, kBlockSize, &readBlock);
+
+    // Only two blocks are free: both first blocks are restored, the child of the first is not.
+    BlockRadixTree<int> restored{2};
+    int numFree = 2;
+    auto const numRestored = loadKvCacheSnapshot<int>(mPath, restored, kFingerprint, kBlockSize,
+        [&numFree](void const* data) -> std::optional<int>
+        {
+            if (numFree == 0)
+            {
+                return std::nullopt;
+            }
+            --numFree;
+            return *static_cast<char const*>(data);
+        });
+    EXPECT_EQ(numRestored, 2);
+    EXPECT_EQ(restored.size(), 2);
+}
+
+TEST_F(KvCacheSnapshotTest, OtherEngine)
+{
+    BlockRadixTree<int> tree{2};
+    tree.insert(VecTokens{1, 2}, {1});
+    saveKvCacheSnapshot<int>(mPath, tree, kFingerprint, kBlockSize, &readBlock);
+
+    auto const restoreBlock = [](void const*) -> std::optional<int> { return 0; };
+    BlockRadixTree<int> restored{2};
+    EXPECT_EQ(loadKvCacheSnapshot<int>(mPath, restored, kFingerprint + 1, kBlockSize, restoreBlock), 0);
+    EXPECT_EQ(loadKvCacheSnapshot<int>(mPath, restored, kFingerprint, kBlockSize * 2, restoreBlock), 0);
+    BlockRadixTree<int> otherBlockSize{4};
+    EXPECT_EQ(loadKvCacheSnapshot<int>(mPath, otherBlockSize, kFingerprint, kBlockSize, restoreBlock), 0);
+    auto const missingPath = mPath.string() + ".missing";
+    EXPECT_EQ(loadKvCacheSnapshot<int>(missingPath, restored, kFingerprint, kBlockSize, restoreBlock), 0);
+    EXPECT_EQ(restored.size(), 0);
+}
@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvCacheTelemetry.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+
+TEST(KvCacheTelemetryTest, Log2Histogram)
+{
+    EXPECT_EQ(Log2Histogram::bucketIndex(0, 8), 0);
+    EXPECT_EQ(Log2Histogram::bucketIndex(1, 8), 1);
+    EXPECT_EQ(Log2Histogram::bucketIndex(2, 8), 2);
+    EXPECT_EQ(Log2Histogram::bucketIndex(3, 8), 2);
+    EXPECT_EQ(Log2Histogram::bucketIndex(4, 8), 3);
+    EXPECT_EQ(Log2Histogram::bucketIndex(1000, 8), 7);
+
+    Log2Histogram histogram{4};
+    histogram.add(0);
+    histogram.add(5, 2);
+    histogram.add(1 << 20);
+    EXPECT_EQ(histogram.getCounts(), (std::vector<Log2Histogram::SizeType32>{1, 0, 0, 3}));
+    histogram.reset();
+    EXPECT_EQ(histogram.getCounts(), (std::vector<Log2Histogram::SizeType32>{0, 0, 0, 0}));
+}
+
+TEST(KvCacheTelemetryTest, PerIterationStats)
+{
+    using Blocks = std::vector<std::vector<KvCacheTelemetry::IdType>>;
+    using Counts = std::vector<KvCacheTelemetry::SizeType32>;
+
+    KvCacheTelemetry telemetry{4, 4};
+    // Slot 0 reused 5 of its 6 tokens, slot 1 did not reuse any.
+    telemetry.addSequence(0, 6, 5, Blocks{{0, 1}});
+    telemetry.addSequence(1, 3, 0, Blocks{{2}});
+    auto stats = telemetry.takeStats();
+    EXPECT_EQ(stats.reuseDepthHistogram, (Counts{1, 0, 1, 0}));
+    EXPECT_EQ(stats.blockLifetimeHistogram, (Counts{0, 0, 0, 0}));
+    ASSERT_EQ(stats.sequences.size(), 2U);
+    EXPECT_EQ(stats.sequences[0].seqSlotIdx, 0);
+    EXPECT_EQ(stats.sequences[0].numAllocatedTokenSlots, 8);
+    EXPECT_EQ(stats.sequences[0].numUnusedTokenSlots, 2);
+    EXPECT_FLOAT_EQ(stats.sequences[0].fragmentation, 2.f / 8.f);
+    EXPECT_EQ(stats.sequences[1].numUnusedTokenSlots, 1);
+    EXPECT_FLOAT_EQ(stats.sequences[1].fragmentation, 1.f / 4.f);
+    EXPECT_EQ(stats.numUnusedTokenSlots, 3);
+    EXPECT_FLOAT_EQ(stats.fragmentation, 3.f / 12.f);
+
+    // The same sequences again, slot 0 grows by a block. Nothing is released and no sequence is new.
+    telemetry.addSequence(0, 9, 5, Blocks{{0, 1, 3}});
+    telemetry.addSequence(1, 4, 0, Blocks{{2}});
+    stats = telemetry.takeStats();
+    EXPECT_EQ(stats.reuseDepthHistogram, (Counts{0, 0, 0, 0}));
+    EXPECT_EQ(stats.blockLifetimeHistogram, (Counts{0, 0, 0, 0}));
+    EXPECT_FLOAT_EQ(stats.sequences[1].fragmentation, 0.f);
+
+    // Slot 1 finished and was taken by a new sequence, slot 0 finished. Blocks 0 and 1 lived 2 iterations, blocks 2
+    // and 3 lived 2 and 1 iterations.
+    telemetry.addSequence(1, 2, 0, Blocks{{4}});
+    stats = telemetry.takeStats();
+    EXPECT_EQ(stats.reuseDepthHistogram, (Counts{1, 0, 0, 0}));
+    EXPECT_EQ(stats.blockLifetimeHistogram, (Counts{0, 1, 3, 0}));
+    ASSERT_EQ(stats.sequences.size(), 1U);
+    EXPECT_EQ(stats.sequences[0].seqSlotIdx, 1);
+
+    stats = telemetry.takeStats();
+    EXPECT_EQ(stats.blockLifetimeHistogram, (Counts{0, 1, 0, 0}));
+    EXPECT_TRUE(stats.sequences.empty());
+    EXPECT_FLOAT_EQ(stats.fragmentation, 0.f);
+    EXPECT_EQ(telemetry.getIteration(), 4U);
+}
+
+TEST(KvCacheTelemetryTest, ToJsonStr)
+{
+    KvCacheTelemetry telemetry{4, 2};
+    telemetry.addSequence(3, 2, 0, {{7}});
+    auto const json = toJsonStr(telemetry.takeStats());
+    EXPECT_EQ(json,
+        R"({"blockLifetimeHistogram":[0,0],"fragmentation":0.5,"numUnusedTokenSlots":2,"reuseDepthHistogram":[1,0],)"
+        R"("sequences":[{"fragmentation":0.5,"numAllocatedTokenSlots":4,"numUnusedTokenSlots":2,"seqSlotIdx":3}]})");
+}
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvCacheManager.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+#include "tensorrt_llm/runtime/kvBlockTransfer.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+using namespace tensorrt_llm::batch_manager::kv_cache_manager;
+namespace tc = tensorrt_llm::common;
+namespace tr = tensorrt_llm::runtime;
+using SizeType32 = tr::SizeType32;
+
+class KvCacheTransferTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<tr::CudaStream>();
+    }
+
+    //! \brief A KV cache manager with its pools allocated, `numBlocks` blocks in primary memory.
+    std::unique_ptr<KVCacheManager> createManager(SizeType32 numBlocks) const
+    {
+        auto manager = std::make_unique<KVCacheManager>(kNumLayers, kNumKvHeads, kSizePerHead, kTokensPerBlock,
+            numBlocks, 0, kMaxNumSequences, 1, kMaxAttentionWindow, 0, false, mStream);
+        manager->allocatePools(nvinfer1::DataType::kHALF);
+        return manager;
+    }
+
+    //! \brief Writes the bytes `first`, `first + 1`, ... into the blocks at `blockPointers`, one after the other.
+    void fillBlocks(std::vector<void*> const& blockPointers, std::uint8_t first) const
+    {
+        std::vector<std::uint8_t> host(kBlockSizeInBytes);
+        for (auto* ptr : blockPointers)
+        {
+            std::iota(host.begin(), host.end(), first);
+            TLLM_CUDA_CHECK(cudaMemcpy(ptr, host.data(), kBlockSizeInBytes, cudaMemcpyHostToDevice));
+            first += 17;
+        }
+    }
+
+    //! \brief Checks that the blocks at `blockPointers` hold what fillBlocks wrote with `first`.
+    void expectBlocks(std::vector<void*> const& blockPointers, std::uint8_t first) const
+    {
+        std::vector<std::uint8_t> expected(kBlockSizeInBytes);
+        std::vector<std::uint8_t> host(kBlockSizeInBytes);
+        for (std::size_t bi = 0; bi < blockPointers.size(); ++bi)
+        {
+            std::iota(expected.begin(), expected.end(), first);
+            TLLM_CUDA_CHECK(cudaMemcpy(host.data(), blockPointers[bi], kBlockSizeInBytes, cudaMemcpyDeviceToHost));
+            EXPECT_EQ(host, expected) << "block " << bi;
+            first += 17;
+        }
+    }
+
+    static constexpr SizeType32 kNumLayers{2};
+    static constexpr SizeType32 kNumKvHeads{2};
+    static constexpr SizeType32 kSizePerHead{16};
+    static constexpr SizeType32 kTokensPerBlock{4};
+    static constexpr SizeType32 kMaxNumSequences{4};
+    static constexpr SizeType32 kMaxAttentionWindow{64};
+    // K and V of all layers, in half
+    static constexpr std::size_t kBlockSizeInBytes{2 * kNumLayers * kNumKvHeads * kSizePerHead * kTokensPerBlock * 2};
+
+    std::shared_ptr<tr::CudaStream> mStream;
+};
+
+TEST_F(KvCacheTransferTest, ImportedSequenceHasItsOwnBlocks)
+{
+    auto src = createManager(8);
+    src->addSequence(0, 10, 1);
+    auto const exported = src->exportSequence(0);
+    EXPECT_EQ(exported.numTokens, 10);
+    EXPECT_EQ(exported.beamWidth, 1);
+    ASSERT_EQ(exported.cacheBlockIds.size(), 1);
+    EXPECT_EQ(exported.cacheBlockIds.at(0).size(), 3);
+
+    // Another sequence holds the first blocks of the importing instance, the block ids differ.
+    auto dst = createManager(16);
+    dst->addSequence(0, 20, 1);
+    dst->importSequence(1, exported);
+    EXPECT_EQ(dst->getUsedNumBlocks(), 5 + 3);
+
+    auto const srcPointers = src->getSequenceBlockPointers(0);
+    auto const dstPointers = dst->getSequenceBlockPointers(1);
+    ASSERT_EQ(srcPointers.size(), 3);
+    ASSERT_EQ(dstPointers.size(), 3);
+    fillBlocks(srcPointers, 1);
+    for (std::size_t bi = 0; bi < srcPointers.size(); ++bi)
+    {
+        TLLM_CUDA_CHECK(cudaMemcpy(dstPointers[bi], srcPointers[bi], kBlockSizeInBytes, cudaMemcpyDeviceToDevice));
+    }
+    expectBlocks(dstPointers, 1);
+
+    dst->removeSequence(1);
+    dst->removeSequence(0);
+    src->removeSequence(0);
+    EXPECT_EQ(dst->getUsedNumBlocks(), 0);
+}
+
+TEST_F(KvCacheTransferTest, ImportChecksTheNumberOfBlocks)
+{
+    auto dst = createManager(8);
+    SequenceKvCacheExport const exported{10, 1, {{0, 1}}};
+    EXPECT_THROW(dst->importSequence(0, exported), tc::TllmException);
+}
+
+#if ENABLE_MULTI_DEVICE
+TEST_F(KvCacheTransferTest, TransferBetweenRanks)
+{
+    auto& comm = COMM_SESSION;
+    if (comm.getSize() != 2 || tc::getDeviceCount() < 2)
+    {
+        GTEST_SKIP() << "Requires 2 ranks on 2 GPUs";
+    }
+    auto const rank = comm.getRank();
+    TLLM_CUDA_CHECK(cudaSetDevice(rank));
+    mStream = std::make_shared<tr::CudaStream>();
+
+    auto ncclComm = std::make_shared<tr::NcclCommunicator>(comm.getSize(), rank);
+    // 5 blocks in chunks of 2, the last message is a partial one.
+    tr::KvBlockTransfer transfer{ncclComm, kBlockSizeInBytes, 2, mStream};
+    auto constexpr numTokens = 5 * kTokensPerBlock;
+    auto manager = createManager(8 + 2 * rank);
+
+    SequenceKvCacheExport exported{numTokens, 1, {}};
+    std::vector<SizeType32> blockIds;
+    if (rank == 0)
+    {
+        manager->addSequence(0, numTokens, 1);
+        exported = manager->exportSequence(0);
+        blockIds = exported.cacheBlockIds.at(0);
+        fillBlocks(manager->getSequenceBlockPointers(0), 3);
+    }
+    comm.bcast(blockIds, 0);
+    exported.cacheBlockIds = {blockIds};
+
+    if (rank == 0)
+    {
+        transfer.send(manager->getSequenceBlockPointers(0), 1)->synchronize();
+    }
+    else
+    {
+        // Blocks 0 and 1 are taken, the received blocks land elsewhere in the pool.
+        manager->addSequence(1, 2 * kTokensPerBlock, 1);
+        manager->importSequence(0, exported);
+        auto const pointers = manager->getSequenceBlockPointers(0);
+        transfer.receive(pointers, 0)->synchronize();
+        expectBlocks(pointers, 3);
+    }
+}
+#endif // ENABLE_MULTI_DEVICE
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvPoolResizePolicy.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+
+namespace
+{
+
+std::size_t constexpr kTotalBytes{1000 * 1000};
+std::size_t constexpr kBlockSize{1000};
+
+KvPoolResizePolicy::Config makeConfig()
+{
+    KvPoolResizePolicy::Config config;
+    config.minNumBlocks = 10;
+    config.maxNumBlocks = 800;
+    config.maxStepBlocks = 50;
+    config.growPatience = 2;
+    return config;
+}
+
+} // namespace
+
+TEST(KvPoolResizePolicyTest, KeepsThePoolWithinTheBand)
+{
+    KvPoolResizePolicy policy{kBlockSize, makeConfig()};
+    // 12% free, between 5% and 15%
+    EXPECT_EQ(policy.decide(120 * kBlockSize, kTotalBytes, 400, 100), 400);
+    EXPECT_EQ(policy.decide(120 * kBlockSize, kTotalBytes, 400, 100), 400);
+}
+
+TEST(KvPoolResizePolicyTest, GrowsAfterPatienceBySteps)
+{
+    KvPoolResizePolicy policy{kBlockSize, makeConfig()};
+    // 30% free, 200 blocks above the 10% target
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 400, 0), 400);
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 400, 0), 450);
+
+    // A decision within the band resets the patience
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 450, 0), 450);
+    EXPECT_EQ(policy.decide(120 * kBlockSize, kTotalBytes, 450, 0), 450);
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 450, 0), 450);
+    EXPECT_EQ(policy.decide(160 * kBlockSize, kTotalBytes, 450, 0), 500);
+
+    // Bounded by the maximum
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 780, 0), 780);
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 780, 0), 800);
+    EXPECT_EQ(policy.decide(300 * kBlockSize, kTotalBytes, 800, 0), 800);
+}
+
+TEST(KvPoolResizePolicyTest, ShrinksOnlyByTheFreeTailBlocks)
+{
+    KvPoolResizePolicy policy{kBlockSize, makeConfig()};
+    // 2% free, 80 blocks below the 10% target, shrinks at once
+    EXPECT_EQ(policy.decide(20 * kBlockSize, kTotalBytes, 400, 100), 350);
+    EXPECT_EQ(policy.decide(20 * kBlockSize, kTotalBytes, 400, 30), 370);
+    // Bounded by the minimum
+    EXPECT_EQ(policy.decide(0, kTotalBytes, 30, 30), 10);
+
+    // A partial block counts, 51.001 blocks below the target
+    auto config = makeConfig();
+    config.maxStepBlocks = 100;
+    KvPoolResizePolicy unboundedPolicy{kBlockSize, config};
+    EXPECT_EQ(unboundedPolicy.decide(49 * kBlockSize - 1, kTotalBytes, 400, 100), 348);
+}
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/kvTokenEvictionPolicy.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+using SizeType32 = KvTokenEvictionPolicy::SizeType32;
+
+namespace
+{
+
+KvTokenEvictionPolicy::Config makeConfig()
+{
+    KvTokenEvictionPolicy::Config config;
+    config.tokenBudget = 8;
+    config.numSinkTokens = 2;
+    config.numRecentTokens = 3;
+    config.tokensPerBlock = 4;
+    return config;
+}
+
+} // namespace
+
+TEST(KvTokenEvictionPolicyTest, CompactsOnceABlockOverTheBudget)
+{
+    KvTokenEvictionPolicy policy{makeConfig()};
+    EXPECT_FALSE(policy.needsCompaction(8));
+    EXPECT_FALSE(policy.needsCompaction(11));
+    EXPECT_TRUE(policy.needsCompaction(12));
+    EXPECT_EQ(policy.getNumReleasedBlocks(12), 1);
+    EXPECT_EQ(policy.getNumReleasedBlocks(13), 2);
+
+    auto config = makeConfig();
+    config.numRecentTokens = 7;
+    EXPECT_THROW(KvTokenEvictionPolicy{config}, std::exception);
+}
+
+TEST(KvTokenEvictionPolicyTest, KeepsSinksRecentAndMostImportantTokens)
+{
+    KvTokenEvictionPolicy policy{makeConfig()};
+    SizeType32 constexpr kStride{16};
+    SizeType32 constexpr kNumTokens{12};
+    // Tokens [2, 9) compete for 3 places, each head group prefers different ones
+    std::vector<float> importance(2 * kStride, 0.f);
+    importance[6] = 3.f;
+    importance[3] = 2.f;
+    importance[8] = 1.f;
+    importance[kStride + 2] = 1.f;
+    importance[kStride + 4] = 1.f;
+    importance[kStride + 7] = 1.f;
+    // Ignored, a sink and a recent token
+    importance[kStride + 0] = 5.f;
+    importance[kStride + 10] = 5.f;
+
+    auto const kept = policy.selectTokens(importance.data(), kStride, 2, kNumTokens);
+    EXPECT_EQ(kept, (std::vector<SizeType32>{0, 1, 3, 6, 8, 9, 10, 11, 0, 1, 2, 4, 7, 9, 10, 11}));
+}
+
+TEST(KvTokenEvictionPolicyTest, BreaksTiesWithTheEarlierTokens)
+{
+    KvTokenEvictionPolicy policy{makeConfig()};
+    std::vector<float> const importance(20, 1.f);
+    auto const kept = policy.selectTokens(importance.data(), 20, 1, 20);
+    EXPECT_EQ(kept, (std::vector<SizeType32>{0, 1, 2, 3, 4, 17, 18, 19}));
+}
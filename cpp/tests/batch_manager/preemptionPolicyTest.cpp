@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/preemptionPolicy.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+
+TEST(PreemptionPolicyTest, SortByPriority)
+{
+    std::vector<PreemptionCandidate> queue{
+        {1, 0.5f, 0, 1, 1}, {2, 0.9f, 1, 1, 1}, {3, 0.5f, 2, 1, 1}, {4, 0.1f, 3, 1, 1}, {5, 0.9f, 4, 1, 1}};
+    sortByPriority(queue);
+    std::vector<PreemptionCandidate::RequestIdType> order;
+    for (auto const& candidate : queue)
+    {
+        order.push_back(candidate.requestId);
+    }
+    EXPECT_EQ(order, (std::vector<PreemptionCandidate::RequestIdType>{2, 5, 1, 3, 4}));
+}
+
+TEST(PreemptionPolicyTest, SelectLowestPriorityMostRecentFirst)
+{
+    std::vector<PreemptionCandidate> running{
+        {1, 0.2f, 0, 4, 64}, {2, 0.2f, 1, 2, 32}, {3, 0.5f, 2, 8, 128}, {4, 0.9f, 3, 8, 128}};
+    EXPECT_EQ(selectRequestsToPreempt(running, 2, 0.9f), (std::vector<PreemptionCandidate::RequestIdType>{2}));
+    EXPECT_EQ(selectRequestsToPreempt(running, 5, 0.9f), (std::vector<PreemptionCandidate::RequestIdType>{2, 1}));
+    EXPECT_EQ(selectRequestsToPreempt(running, 10, 0.9f), (std::vector<PreemptionCandidate::RequestIdType>{2, 1, 3}));
+    // Requests of equal or higher priority are never preempted.
+    EXPECT_TRUE(selectRequestsToPreempt(running, 20, 0.9f).empty());
+    EXPECT_TRUE(selectRequestsToPreempt(running, 1, 0.2f).empty());
+    EXPECT_TRUE(selectRequestsToPreempt(running, 0, 0.9f).empty());
+}
+
+TEST(PreemptionPolicyTest, ChoosePreemptionMode)
+{
+    PreemptionCandidate const candidate{1, 0.1f, 0, 4, 256};
+    // 2 * 4 blocks * 1000 bytes / 1000 bytes/ms = 8 ms of transfers against 256 * 0.1 ms of recompute.
+    EXPECT_EQ(choosePreemptionMode(candidate, 4, 1000., 1000., 0.1), PreemptionMode::kSWAP);
+    EXPECT_EQ(choosePreemptionMode(candidate, 4, 1000., 1000., 0.01), PreemptionMode::kRECOMPUTE);
+    EXPECT_EQ(choosePreemptionMode(candidate, 3, 1000., 1000., 0.1), PreemptionMode::kRECOMPUTE);
+}
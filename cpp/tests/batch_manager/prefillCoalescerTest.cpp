@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/batch_manager/prefillCoalescer.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using namespace tensorrt_llm::batch_manager;
+
+namespace
+{
+using VecTokens = PrefillCoalescer::VecTokens;
+
+//! The shared prefix 0, 1, ... of `numShared` tokens, then a suffix starting at `suffixBegin`.
+VecTokens makeTokens(int numShared, int suffixBegin, int suffixLength)
+{
+    VecTokens tokens(numShared + suffixLength);
+    std::iota(tokens.begin(), tokens.begin() + numShared, 0);
+    std::iota(tokens.begin() + numShared, tokens.end(), suffixBegin);
+    return tokens;
+}
+} // namespace
+
+TEST(PrefillCoalescerTest, FollowersWaitForTheLeader)
+{
+    PrefillCoalescer coalescer{4};
+    EXPECT_FALSE(coalescer.add(1, makeTokens(12, 100, 3)).has_value());
+    EXPECT_EQ(coalescer.add(2, makeTokens(12, 200, 3)), 1);
+    EXPECT_EQ(coalescer.add(3, makeTokens(12, 300, 3)), 1);
+    // Less than a block in common
+    EXPECT_FALSE(coalescer.add(4, makeTokens(3, 400, 10)).has_value());
+
+    EXPECT_TRUE(coalescer.isReady(1));
+    EXPECT_FALSE(coalescer.isReady(2));
+    EXPECT_TRUE(coalescer.isReady(4));
+
+    // A chunk of the leader stored, not the whole shared prefix yet
+    coalescer.onBlocksStored(1, 8);
+    EXPECT_FALSE(coalescer.isReady(2));
+    coalescer.onBlocksStored(1, 15);
+    EXPECT_TRUE(coalescer.isReady(2));
+    EXPECT_TRUE(coalescer.isReady(3));
+
+    auto const& stats = coalescer.getStats();
+    EXPECT_EQ(stats.numCoalesced, 2);
+    EXPECT_EQ(stats.numSharedTokens, 24);
+}
+
+TEST(PrefillCoalescerTest, FollowsTheLongestPrefix)
+{
+    PrefillCoalescer coalescer{4};
+    coalescer.add(1, makeTokens(4, 100, 9));
+    // Shares one block with 1, owns the blocks after it
+    EXPECT_EQ(coalescer.add(2, makeTokens(12, 200, 1)), 1);
+    // Shares three blocks with 2
+    EXPECT_EQ(coalescer.add(3, makeTokens(12, 300, 1)), 2);
+
+    // Other seeds, e.g. another LoRA adapter, are not coalesced
+    auto const seed = PrefillCoalescer::PrefixHashState::makeSeed(5, std::nullopt);
+    EXPECT_FALSE(coalescer.add(4, makeTokens(12, 400, 1), seed).has_value());
+}
+
+TEST(PrefillCoalescerTest, RemovedLeaderHandsOver)
+{
+    PrefillCoalescer coalescer{4};
+    coalescer.add(1, makeTokens(8, 100, 1));
+    coalescer.add(2, makeTokens(8, 200, 1));
+    coalescer.add(3, makeTokens(8, 300, 1));
+
+    // Preempted before it stored the blocks, the first follower takes over
+    coalescer.remove(1);
+    EXPECT_FALSE(coalescer.getLeader(2).has_value());
+    EXPECT_TRUE(coalescer.isReady(2));
+    EXPECT_EQ(coalescer.getLeader(3), 2);
+    EXPECT_FALSE(coalescer.isReady(3));
+    EXPECT_EQ(coalescer.getStats().numCoalesced, 1);
+
+    // Stored, the follower reuses the blocks
+    coalescer.onBlocksStored(2, 9);
+    coalescer.remove(2);
+    EXPECT_TRUE(coalescer.isReady(3));
+    EXPECT_EQ(coalescer.getStats().numCoalesced, 1);
+    coalescer.remove(3);
+    EXPECT_EQ(coalescer.getNumRequests(), 0);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/requestTimeline.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+using Event = RequestTimelineRecorder::Event;
+using std::chrono::microseconds;
+
+TEST(RequestTimelineTest, Breakdown)
+{
+    auto const start = RequestTimelineRecorder::Clock::now();
+    auto const at = [start](int us) { return start + microseconds(us); };
+
+    RequestTimelineRecorder recorder{start};
+    recorder.onWait(Event::kLORA_LOAD_WAIT, microseconds(40), at(50));
+    recorder.onScheduled(at(100));
+    recorder.onContextChunk(64, at(150));
+    recorder.onPaused(at(160));
+    // Already paused
+    recorder.onPaused(at(170));
+    recorder.onWait(Event::kKV_ONBOARD_WAIT, microseconds(30), at(250));
+    recorder.onScheduled(at(260));
+    recorder.onScheduled(at(270));
+    recorder.onContextChunk(36, at(300));
+    recorder.onResponse(false, at(310));
+    recorder.onResponse(false, at(320));
+    recorder.onResponse(true, at(400));
+
+    auto const timeline = recorder.getTimeline();
+    std::vector<Event> events;
+    for (auto const& event : timeline.events)
+    {
+        events.push_back(event.event);
+    }
+    EXPECT_EQ(events,
+        (std::vector<Event>{Event::kENQUEUED, Event::kLORA_LOAD_WAIT, Event::kFIRST_SCHEDULED, Event::kCONTEXT_CHUNK,
+            Event::kPAUSED, Event::kKV_ONBOARD_WAIT, Event::kRESUMED, Event::kCONTEXT_CHUNK, Event::kFIRST_TOKEN,
+            Event::kFINISHED}));
+    EXPECT_EQ(timeline.events.at(3).numTokens, 64);
+    EXPECT_EQ(timeline.events.at(3).time, microseconds(150));
+    EXPECT_EQ(timeline.events.at(5).waitTime, microseconds(30));
+
+    EXPECT_EQ(timeline.queueTime, microseconds(100));
+    EXPECT_EQ(timeline.contextTime, microseconds(210));
+    EXPECT_EQ(timeline.generationTime, microseconds(90));
+    EXPECT_EQ(timeline.pausedTime, microseconds(100));
+    EXPECT_EQ(timeline.kvOnboardWaitTime, microseconds(30));
+    EXPECT_EQ(timeline.loraLoadWaitTime, microseconds(40));
+}
+
+TEST(RequestTimelineTest, UnfinishedPhases)
+{
+    auto const start = RequestTimelineRecorder::Clock::now();
+    RequestTimelineRecorder recorder{start};
+    auto timeline = recorder.getTimeline();
+    EXPECT_EQ(timeline.events.size(), 1);
+    EXPECT_EQ(timeline.queueTime, microseconds(0));
+
+    recorder.onScheduled(start + microseconds(10));
+    timeline = recorder.getTimeline();
+    EXPECT_EQ(timeline.queueTime, microseconds(10));
+    EXPECT_EQ(timeline.contextTime, microseconds(0));
+    EXPECT_EQ(timeline.generationTime, microseconds(0));
+
+    EXPECT_THROW(recorder.onWait(Event::kPAUSED, microseconds(1)), tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/batch_manager/sloScheduler.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::batch_manager;
+using namespace std::chrono_literals;
+
+TEST(SloSchedulerTest, CostModelFit)
+{
+    IterationCostModel model{0.0, 0.0, 0.0, 1.0};
+    // latency = 3 + 0.02 * contextTokens + 0.5 * generationRequests
+    for (int i = 0; i < 200; ++i)
+    {
+        auto const numContextTokens = (i * 37) % 2048;
+        auto const numGenerationRequests = (i * 7) % 64;
+        auto const iterLatencyMs = 3.0 + 0.02 * numContextTokens + 0.5 * numGenerationRequests;
+        model.update(numContextTokens, numGenerationRequests, iterLatencyMs);
+    }
+    EXPECT_NEAR(model.getOverheadMs(), 3.0, 1e-3);
+    EXPECT_NEAR(model.getMsPerContextToken(), 0.02, 1e-5);
+    EXPECT_NEAR(model.getMsPerGenerationRequest(), 0.5, 1e-4);
+    EXPECT_NEAR(model.estimate(1000, 10), 28.0, 1e-2);
+    // 3 + 5 + 0.02 * x <= 28
+    EXPECT_NEAR(model.maxContextTokens(10, 28.0), 1000, 1);
+    EXPECT_EQ(model.maxContextTokens(10, 5.0), 0);
+}
+
+TEST(SloSchedulerTest, LeastLaxityFirst)
+{
+    SloAwareScheduler scheduler{4096, 16, 64, 64};
+    auto const now = SloCandidate::Clock::now();
+    std::vector<SloCandidate> candidates{
+        // Batch job, arrived first
+        {0, now - 1s, RequestSlo{}, false, 2048, 0},
+        // Interactive request with a loose deadline
+        {1, now, RequestSlo{2000ms, std::nullopt}, false, 1024, 0},
+        // Interactive request with a tight deadline
+        {2, now, RequestSlo{200ms, std::nullopt}, false, 1024, 0},
+        // Deadline already missed
+        {3, now - 1s, RequestSlo{100ms, std::nullopt}, false, 512, 0},
+    };
+    auto const schedule = scheduler.schedule(candidates, 1000, now);
+    ASSERT_EQ(schedule.contextChunks.size(), 3);
+    EXPECT_EQ(schedule.contextChunks[0], std::make_pair(std::uint64_t{2}, 1024));
+    EXPECT_EQ(schedule.contextChunks[1], std::make_pair(std::uint64_t{1}, 1024));
+    EXPECT_EQ(schedule.contextChunks[2], std::make_pair(std::uint64_t{0}, 2048));
+    EXPECT_TRUE(schedule.generationRequests.empty());
+    EXPECT_TRUE(schedule.pausedRequests.empty());
+}
+
+TEST(SloSchedulerTest, TpotTargetBoundsContext)
+{
+    SloAwareScheduler scheduler{8192, 16, 64, 64};
+    // 5ms + 0.05ms per context token + 0.1ms per generation request
+    auto const now = SloCandidate::Clock::now();
+    std::vector<SloCandidate> candidates{
+        {0, now, RequestSlo{std::nullopt, 30.0}, true, 0, 1},
+        {1, now, RequestSlo{std::nullopt, 50.0}, true, 0, 0},
+        {2, now, RequestSlo{}, true, 0, 9},
+        {3, now, RequestSlo{}, false, 4096, 0},
+    };
+    // Not enough blocks for the TPOT-less generation request
+    auto const schedule = scheduler.schedule(candidates, 9, now);
+    EXPECT_EQ(schedule.generationRequests, (std::vector<std::uint64_t>{0, 1}));
+    EXPECT_EQ(schedule.pausedRequests, (std::vector<std::uint64_t>{2}));
+    // (30 - 5 - 0.2) / 0.05 = 496 tokens, rounded down to the chunk unit
+    ASSERT_EQ(schedule.contextChunks.size(), 1);
+    EXPECT_EQ(schedule.contextChunks[0], std::make_pair(std::uint64_t{3}, 448));
+}
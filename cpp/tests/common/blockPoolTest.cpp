@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "tensorrt_llm/common/blockPool.h"
+
+using namespace tensorrt_llm::common;
+
+namespace
+{
+using TestPool = ThreadLocalBlockPool<48, 2>;
+} // namespace
+
+TEST(ThreadLocalBlockPool, ReusesFreedBlocks)
+{
+    TestPool::release();
+    auto* first = TestPool::allocate(48);
+    auto* second = TestPool::allocate(48);
+    auto* third = TestPool::allocate(48);
+    TestPool::deallocate(first, 48);
+    TestPool::deallocate(second, 48);
+    // Beyond the maximum number of free blocks
+    TestPool::deallocate(third, 48);
+    EXPECT_EQ(TestPool::getNumFree(), 2);
+
+    // Last freed, first reused
+    EXPECT_EQ(TestPool::allocate(48), second);
+    EXPECT_EQ(TestPool::getNumFree(), 1);
+
+    // Other sizes bypass the pool
+    auto* other = TestPool::allocate(16);
+    TestPool::deallocate(other, 16);
+    EXPECT_EQ(TestPool::getNumFree(), 1);
+
+    // Blocks freed by another thread are kept by that thread
+    std::thread thread{[second]() { TestPool::deallocate(second, 48); }};
+    thread.join();
+    EXPECT_EQ(TestPool::getNumFree(), 1);
+
+    TestPool::release();
+    EXPECT_EQ(TestPool::getNumFree(), 0);
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/common/chromeTrace.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+using tensorrt_llm::common::ChromeTrace;
+
+TEST(ChromeTrace, Escape)
+{
+    EXPECT_EQ(ChromeTrace::escape("plain"), "plain");
+    EXPECT_EQ(ChromeTrace::escape("a\"b\\c\n"), "a\\\"b\\\\c\\n");
+    EXPECT_EQ(ChromeTrace::escape(std::string(1, '\x01')), "\\u0001");
+}
+
+TEST(ChromeTrace, ToJson)
+{
+    ChromeTrace trace;
+    EXPECT_EQ(trace.toJson(), "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n]}\n");
+
+    trace.setThreadName(0, 1, "context 1");
+    trace.addEvent("layer \"0\"", "layer", 0, 1, 10.0, 2.5, {{"iteration", 7}});
+    EXPECT_EQ(trace.getNumEvents(), 1);
+    EXPECT_EQ(trace.toJson(),
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":1,\"args\":{\"name\":\"context 1\"}},\n"
+        "{\"name\":\"layer \\\"0\\\"\",\"cat\":\"layer\",\"ph\":\"X\",\"pid\":0,\"tid\":1,\"ts\":10.000,\"dur\":2.500,"
+        "\"args\":{\"iteration\":7}}\n"
+        "]}\n");
+
+    trace.clear();
+    EXPECT_EQ(trace.getNumEvents(), 0);
+}
+
+TEST(ChromeTrace, Counter)
+{
+    ChromeTrace trace;
+    trace.addCounter("GPU kv_cache", 0, 1.5, {{"bytes", 4096}});
+    EXPECT_EQ(trace.getNumEvents(), 1);
+    EXPECT_EQ(trace.toJson(),
+        "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n"
+        "{\"name\":\"GPU kv_cache\",\"ph\":\"C\",\"pid\":0,\"ts\":1.500,\"args\":{\"bytes\":4096}}\n"
+        "]}\n");
+}
+
+TEST(ChromeTrace, Write)
+{
+    ChromeTrace trace;
+    trace.addEvent("layer", "layer", 0, 0, 0.0, 1.0);
+    auto const path = std::filesystem::temp_directory_path() / "chromeTraceTest.json";
+    trace.write(path);
+    std::ifstream file{path};
+    std::string const contents{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(contents, trace.toJson());
+    std::filesystem::remove(path);
+
+    EXPECT_THROW(trace.write(path / "missing" / "trace.json"), tensorrt_llm::common::TllmException);
+}
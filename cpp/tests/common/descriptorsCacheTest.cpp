@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cublasMMWrapper.h"
+#include "tensorrt_llm/common/descriptorsCache.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+
+//! Stands in for cublasLtMatmulAlgo_t, an opaque array of words compared bytewise
+struct FakeAlgo
+{
+    std::array<std::uint64_t, 8> data;
+};
+
+// The cache of CublasMMWrapper with fake descriptors: each created descriptor gets a new id, and the test records the
+// ids that are destroyed. The key is the shape (m, n, k) of the GEMM.
+class DescriptorsCacheTest : public ::testing::Test
+{
+protected:
+    using Key = std::tuple<int, int, int>;
+    using Cache = tc::DescriptorsCache<Key, int, FakeAlgo>;
+
+    static constexpr std::size_t kCapacity{tc::CublasMMWrapper::kMaxCachedDescriptors};
+
+    Cache::Entry& get(Key const& key)
+    {
+        return mCache.get(key, [this]() { return mNumCreated++; });
+    }
+
+    //! \brief Checks `algo` with `entry`, the check itself returns `valid` and is counted.
+    bool check(Cache::Entry& entry, FakeAlgo const& algo, bool valid = true)
+    {
+        return Cache::checkAlgo(entry, algo,
+            [this, valid](FakeAlgo const&)
+            {
+                ++mNumChecks;
+                return valid;
+            });
+    }
+
+    static FakeAlgo makeAlgo(std::uint64_t id)
+    {
+        FakeAlgo algo{};
+        algo.data[0] = id;
+        return algo;
+    }
+
+    int mNumCreated{0};
+    int mNumChecks{0};
+    std::vector<int> mDestroyed;
+    Cache mCache{kCapacity, [this](int const& descriptors) { mDestroyed.push_back(descriptors); }};
+};
+
+} // namespace
+
+TEST_F(DescriptorsCacheTest, Hit)
+{
+    auto& entry = get({16, 32, 64});
+    EXPECT_EQ(entry.descriptors, 0);
+    EXPECT_EQ(mNumCreated, 1);
+
+    // The same shape is the same entry, its descriptors aren't created again
+    auto& hit = get({16, 32, 64});
+    EXPECT_EQ(&hit, &entry);
+    EXPECT_EQ(hit.descriptors, 0);
+    EXPECT_EQ(mNumCreated, 1);
+
+    // Another shape is another entry
+    auto& other = get({16, 32, 128});
+    EXPECT_NE(&other, &entry);
+    EXPECT_EQ(other.descriptors, 1);
+    EXPECT_EQ(mCache.size(), 2);
+    EXPECT_TRUE(mDestroyed.empty());
+}
+
+TEST_F(DescriptorsCacheTest, EvictsLeastRecentlyUsed)
+{
+    for (int m = 0; m < static_cast<int>(kCapacity); ++m)
+    {
+        get({m, 1, 1});
+    }
+    EXPECT_EQ(mCache.size(), kCapacity);
+    EXPECT_TRUE(mDestroyed.empty());
+
+    // Touching the oldest shape makes the second one the least recently used
+    get({0, 1, 1});
+    get({-1, 1, 1});
+    EXPECT_EQ(mCache.size(), kCapacity);
+    ASSERT_EQ(mDestroyed, std::vector<int>{1});
+    EXPECT_TRUE(mCache.contains({0, 1, 1}));
+    EXPECT_FALSE(mCache.contains({1, 1, 1}));
+
+    // The evicted shape is created again and evicts the next one
+    auto& recreated = get({1, 1, 1});
+    EXPECT_EQ(recreated.descriptors, static_cast<int>(kCapacity) + 1);
+    EXPECT_EQ(mDestroyed, (std::vector<int>{1, 2}));
+    EXPECT_EQ(mCache.size(), kCapacity);
+}
+
+TEST_F(DescriptorsCacheTest, DestroysAllEntries)
+{
+    std::vector<int> destroyed;
+    std::optional<Cache> cache;
+    cache.emplace(kCapacity, [&destroyed](int const& descriptors) { destroyed.push_back(descriptors); });
+    cache->get({1, 1, 1}, []() { return 10; });
+    cache->get({2, 1, 1}, []() { return 20; });
+    EXPECT_TRUE(destroyed.empty());
+    cache.reset();
+    EXPECT_EQ(destroyed, (std::vector<int>{20, 10}));
+}
+
+TEST_F(DescriptorsCacheTest, CachedAlgoCheck)
+{
+    auto const algoA = makeAlgo(1);
+    auto const algoB = makeAlgo(2);
+
+    // The same algo on the same shape is checked once, also when it is not usable
+    auto& entry = get({16, 32, 64});
+    EXPECT_FALSE(check(entry, algoA, false));
+    EXPECT_FALSE(check(entry, algoA, true));
+    EXPECT_EQ(mNumChecks, 1);
+
+    // Another algo on the same shape is checked again, and replaces the checked algo
+    EXPECT_TRUE(check(entry, algoB, true));
+    EXPECT_EQ(mNumChecks, 2);
+    EXPECT_TRUE(check(get({16, 32, 64}), algoB, false));
+    EXPECT_EQ(mNumChecks, 2);
+    EXPECT_TRUE(check(entry, algoA, true));
+    EXPECT_EQ(mNumChecks, 3);
+
+    // The checked algo belongs to the shape
+    EXPECT_TRUE(check(get({16, 32, 128}), algoA, true));
+    EXPECT_EQ(mNumChecks, 4);
+}
+
+TEST_F(DescriptorsCacheTest, EvictionForgetsCheckedAlgo)
+{
+    auto const algo = makeAlgo(1);
+    EXPECT_TRUE(check(get({0, 1, 1}), algo));
+    EXPECT_EQ(mNumChecks, 1);
+
+    for (int m = 1; m <= static_cast<int>(kCapacity); ++m)
+    {
+        get({m, 1, 1});
+    }
+    ASSERT_FALSE(mCache.contains({0, 1, 1}));
+
+    // The new descriptors of the shape are checked again
+    auto& recreated = get({0, 1, 1});
+    EXPECT_FALSE(recreated.checkedAlgo.has_value());
+    EXPECT_TRUE(check(recreated, algo));
+    EXPECT_EQ(mNumChecks, 2);
+}
@@ -16,6 +16,7 @@
 
 #include <gtest/gtest.h>
 
+#include "tensorrt_llm/common/mpiCoalescedBroadcast.h"
 #include "tensorrt_llm/common/mpiUtils.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 
@@ -304,3 +305,39 @@ TEST(MPIUtils, VectorBcastOverflow)
         }
     }
 }
+
+TEST(MPIUtils, CoalescedBroadcast)
+{
+    auto& comm = mpi::MpiComm::world();
+    auto constexpr root = 0;
+    auto constexpr inlineCapacity = 256;
+    mpi::MpiCoalescedBroadcast broadcast{comm, root, inlineCapacity};
+
+    // Batches below the inline capacity, empty and above it, more than two to reuse the buffers of the root.
+    std::vector<std::vector<mpi::MpiCoalescedBroadcast::Message>> batches;
+    batches.push_back({{'a'}, {'b', 'c'}, {}});
+    batches.emplace_back();
+    batches.push_back({std::vector<char>(1000, 'd'), {'e'}, std::vector<char>(300, 'f')});
+    batches.push_back({std::vector<char>(inlineCapacity, 'g')});
+
+    if (broadcast.isRoot())
+    {
+        for (auto const& batch : batches)
+        {
+            for (auto const& message : batch)
+            {
+                broadcast.add(message);
+            }
+            broadcast.post();
+        }
+    }
+    else
+    {
+        broadcast.postReceive();
+        for (auto const& batch : batches)
+        {
+            auto const messages = broadcast.receive();
+            EXPECT_EQ(messages, batch);
+        }
+    }
+}
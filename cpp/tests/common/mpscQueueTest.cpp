@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#if defined(__linux__)
+#include <poll.h>
+#endif
+
+#include "tensorrt_llm/common/mpscQueue.h"
+
+using namespace tensorrt_llm::common;
+
+TEST(MpscRing, PushPop)
+{
+    MpscRing<int> ring{3};
+    EXPECT_EQ(ring.capacity(), 4);
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_TRUE(ring.tryPush(int{i}));
+    }
+    EXPECT_FALSE(ring.tryPush(4));
+    EXPECT_EQ(ring.tryPop(), 0);
+    EXPECT_TRUE(ring.tryPush(4));
+    for (int i = 1; i < 5; ++i)
+    {
+        EXPECT_EQ(ring.tryPop(), i);
+    }
+    EXPECT_FALSE(ring.tryPop().has_value());
+}
+
+TEST(MpscRing, ConcurrentProducers)
+{
+    constexpr int kNumProducers = 4;
+    constexpr int kNumValues = 10000;
+    MpscRing<int> ring{64};
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kNumProducers; ++p)
+    {
+        producers.emplace_back(
+            [&ring, p]()
+            {
+                for (int i = 0; i < kNumValues; ++i)
+                {
+                    while (!ring.tryPush(p * kNumValues + i))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+    }
+    // Values of every producer arrive in push order.
+    std::vector<int> next(kNumProducers, 0);
+    for (int numPopped = 0; numPopped < kNumProducers * kNumValues;)
+    {
+        if (auto value = ring.tryPop())
+        {
+            auto const producer = value.value() / kNumValues;
+            EXPECT_EQ(value.value() % kNumValues, next[producer]++);
+            ++numPopped;
+        }
+    }
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+    EXPECT_FALSE(ring.tryPop().has_value());
+}
+
+#if defined(__linux__)
+TEST(NotifyingMpscQueue, FdSignalsPendingValues)
+{
+    NotifyingMpscQueue<std::vector<int>> queue{8};
+    auto const isReadable = [&queue]()
+    {
+        pollfd fd{queue.getFd(), POLLIN, 0};
+        return ::poll(&fd, 1, 0) == 1;
+    };
+
+    EXPECT_FALSE(isReadable());
+    EXPECT_TRUE(queue.tryPush({1, 2}));
+    EXPECT_TRUE(queue.tryPush({3}));
+    EXPECT_TRUE(isReadable());
+
+    auto const values = queue.popAll();
+    EXPECT_EQ(values, (std::vector<std::vector<int>>{{1, 2}, {3}}));
+    EXPECT_FALSE(isReadable());
+    EXPECT_TRUE(queue.popAll().empty());
+
+    EXPECT_TRUE(queue.tryPush({4}));
+    EXPECT_TRUE(isReadable());
+    EXPECT_EQ(queue.popAll().size(), 1);
+}
+#endif
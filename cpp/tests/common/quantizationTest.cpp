@@ -35,6 +35,8 @@ TEST(Quantization, Constructor)
     static_assert(QuantMode::int8KvCache().hasInt8KvCache());
     static_assert(QuantMode::fp8KvCache().hasFp8KvCache());
     static_assert(QuantMode::fp8Qdq().hasFp8Qdq());
+    static_assert(QuantMode::nvfp4Weights().hasNvfp4Weights());
+    static_assert(QuantMode::mxfp4Weights().hasMxfp4Weights());
 }
 
 TEST(Quantization, PlusMinus)
@@ -51,3 +53,19 @@ TEST(Quantization, PlusMinus)
     EXPECT_FALSE(quantMode.hasPerChannelScaling());
     EXPECT_EQ(quantMode, QuantMode::none());
 }
+
+TEST(Quantization, Fp4Weights)
+{
+    auto const nvfp4 = QuantMode::fromQuantAlgo("W4A16_NVFP4");
+    EXPECT_TRUE(nvfp4.hasNvfp4Weights());
+    EXPECT_FALSE(nvfp4.hasMxfp4Weights());
+    EXPECT_FALSE(nvfp4.hasInt4Weights());
+    EXPECT_FALSE(nvfp4.hasInt8Weights());
+    EXPECT_FALSE(nvfp4.hasActivations());
+
+    auto const mxfp4 = QuantMode::fromQuantAlgo("W4A16_MXFP4", "FP8");
+    EXPECT_TRUE(mxfp4.hasMxfp4Weights());
+    EXPECT_TRUE(mxfp4.hasFp4Weights());
+    EXPECT_TRUE(mxfp4.hasFp8KvCache());
+    EXPECT_FALSE(mxfp4.hasInt8Weights());
+}
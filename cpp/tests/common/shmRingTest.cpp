@@ -0,0 +1,118 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include <istream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+#include "tensorrt_llm/common/shmRing.h"
+#include "tensorrt_llm/common/spanStreamBuf.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+using namespace tensorrt_llm::common;
+
+namespace
+{
+std::string uniqueName(char const* test)
+{
+    return std::string{"/trtllm_"} + test + "_" + std::to_string(::getpid());
+}
+
+std::string toString(ShmRing::Message const& message)
+{
+    return std::string{message.data, message.size};
+}
+} // namespace
+
+TEST(ShmRing, WriteInPlace)
+{
+    auto producer = ShmRing::create(uniqueName("write"), 60);
+    auto consumer = ShmRing::open(uniqueName("write"));
+    EXPECT_EQ(consumer.getCapacity(), 64);
+    EXPECT_FALSE(consumer.tryPeek().has_value());
+
+    EXPECT_TRUE(producer.tryWrite(5, [](std::ostream& os) { os << "hello"; }));
+    EXPECT_TRUE(producer.tryWrite(3, [](std::ostream& os) { os << "abc"; }));
+    auto message = consumer.tryPeek();
+    ASSERT_TRUE(message.has_value());
+    // Deserialize from the ring without copies.
+    SpanStreamBuf buffer{message->data, message->size};
+    std::istream is{&buffer};
+    std::string word;
+    is >> word;
+    EXPECT_EQ(word, "hello");
+    consumer.release();
+    EXPECT_EQ(toString(consumer.tryPeek().value()), "abc");
+    consumer.release();
+    EXPECT_FALSE(consumer.tryPeek().has_value());
+
+    // Writing more than reserved fails the message.
+    EXPECT_THROW(producer.tryWrite(2, [](std::ostream& os) { os << "abc"; }), TllmException);
+}
+
+TEST(ShmRing, FullAndWrapAround)
+{
+    auto producer = ShmRing::create(uniqueName("wrap"), 64);
+    auto consumer = ShmRing::open(uniqueName("wrap"));
+    std::string const payload(16, 'x');
+    auto const write = [&producer](std::string const& message)
+    { return producer.tryWrite(message.size(), [&message](std::ostream& os) { os << message; }); };
+
+    // Messages take 8 + 16 bytes, two fit.
+    EXPECT_TRUE(write(payload));
+    EXPECT_TRUE(write(payload));
+    EXPECT_FALSE(write(payload));
+    EXPECT_EQ(toString(consumer.tryPeek().value()), payload);
+    consumer.release();
+    // The third message does not fit before the end and starts at the beginning of the ring.
+    EXPECT_TRUE(write(std::string(16, 'y')));
+    EXPECT_EQ(toString(consumer.tryPeek().value()), payload);
+    consumer.release();
+    EXPECT_EQ(toString(consumer.tryPeek().value()), std::string(16, 'y'));
+    consumer.release();
+}
+
+TEST(ShmRing, ConcurrentProducerConsumer)
+{
+    constexpr int kNumMessages = 10000;
+    auto producer = ShmRing::create(uniqueName("concurrent"), 256);
+    auto consumer = ShmRing::open(uniqueName("concurrent"));
+    std::thread thread(
+        [&producer]()
+        {
+            for (int i = 0; i < kNumMessages; ++i)
+            {
+                auto const message = std::to_string(i);
+                while (!producer.tryWrite(message.size(), [&message](std::ostream& os) { os << message; }))
+                {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    for (int i = 0; i < kNumMessages;)
+    {
+        if (auto message = consumer.tryPeek())
+        {
+            EXPECT_EQ(toString(message.value()), std::to_string(i));
+            consumer.release();
+            ++i;
+        }
+    }
+    thread.join();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/batchJob.h"
+
+#include <algorithm>
+#include <map>
+#include <numeric>
+
+using namespace tensorrt_llm::executor;
+
+namespace
+{
+// Finishes the requests in the order they were enqueued, a few per call of awaitResponses. Requests with an empty
+// prompt fail.
+struct FakeExecutor
+{
+    std::vector<IdType> enqueueRequests(std::vector<Request> const& requests)
+    {
+        std::vector<IdType> ids;
+        for (auto const& request : requests)
+        {
+            EXPECT_FALSE(request.getStreaming());
+            mPrompts.push_back(request.getInputTokenIds());
+            mQueue.push_back(mNextId);
+            ids.push_back(mNextId++);
+        }
+        mMaxInFlight = std::max(mMaxInFlight, mQueue.size());
+        return ids;
+    }
+
+    std::vector<Response> awaitResponses(std::optional<std::chrono::milliseconds> const& /* timeout */)
+    {
+        std::vector<Response> responses;
+        for (std::size_t i = 0; i < mResponsesPerCall && !mQueue.empty(); ++i)
+        {
+            auto const id = mQueue.front();
+            mQueue.erase(mQueue.begin());
+            if (mPrompts[id].empty())
+            {
+                responses.emplace_back(id, "empty prompt");
+                continue;
+            }
+            // A partial result first, it is not passed to the sink
+            responses.emplace_back(id, Result{false, {{1}}});
+            responses.emplace_back(id, Result{true, {{1, 2}}});
+        }
+        return responses;
+    }
+
+    IdType mNextId{0};
+    std::vector<IdType> mQueue;
+    std::vector<VecTokens> mPrompts;
+    std::size_t mResponsesPerCall{2};
+    std::size_t mMaxInFlight{0};
+};
+
+using Job = BasicBatchJob<FakeExecutor>;
+
+Request makeRequest(SizeType32 numTokens, TokenIdType firstToken, SizeType32 maxNewTokens = 8)
+{
+    VecTokens tokens(numTokens);
+    std::iota(tokens.begin(), tokens.end(), firstToken);
+    return Request{std::move(tokens), maxNewTokens};
+}
+
+Job::Config makeConfig()
+{
+    Job::Config config;
+    config.tokensPerBlock = 4;
+    config.windowSize = 16;
+    config.maxInFlightRequests = 3;
+    return config;
+}
+
+Job::Source makeSource(std::vector<Request> requests)
+{
+    return [requests = std::move(requests), next = std::size_t{0}]() mutable -> std::optional<Request>
+    {
+        if (next == requests.size())
+        {
+            return std::nullopt;
+        }
+        return requests[next++];
+    };
+}
+} // namespace
+
+TEST(BatchJobTest, GroupsSharedPrefixes)
+{
+    Job job{std::make_shared<FakeExecutor>(), makeConfig()};
+    // 0 and 2 share two blocks, 1 and 3 share one block, 4 is shorter than a block
+    std::vector<Request> requests{makeRequest(10, 0), Request{VecTokens{100, 101, 102, 103, 7, 7, 7, 7}, 8},
+        makeRequest(9, 0), makeRequest(6, 100), makeRequest(3, 0)};
+
+    auto const order = job.plan(requests);
+    EXPECT_EQ(order, (std::vector<std::size_t>{2, 0, 1, 3, 4}));
+    EXPECT_EQ(job.countSharedBlocks(requests[0].getInputTokenIds(), requests[2].getInputTokenIds()), 2);
+}
+
+TEST(BatchJobTest, OrdersGroupsByOutputLengthBin)
+{
+    Job job{std::make_shared<FakeExecutor>(), makeConfig()};
+    // The group of prompt 0 has a mean of 10 new tokens, the one of prompt 100 a mean of 300
+    std::vector<Request> requests{makeRequest(4, 0, 4), makeRequest(4, 100, 100), makeRequest(4, 0, 16),
+        makeRequest(4, 100, 500), makeRequest(4, 200, 64)};
+
+    auto const order = job.plan(requests);
+    EXPECT_EQ(order, (std::vector<std::size_t>{1, 3, 4, 0, 2}));
+}
+
+TEST(BatchJobTest, RunsAllRequestsWithinTheInFlightLimit)
+{
+    auto executor = std::make_shared<FakeExecutor>();
+    auto config = makeConfig();
+    config.windowSize = 4;
+    Job job{executor, config};
+
+    std::vector<Request> requests;
+    for (SizeType32 i = 0; i < 10; ++i)
+    {
+        // Two prefixes, interleaved in the source
+        requests.push_back(makeRequest(8 + i, i % 2 == 0 ? 0 : 100));
+    }
+    requests.push_back(Request{VecTokens{}, 8});
+
+    std::map<std::size_t, Response> responses;
+    auto const stats = job.run(makeSource(requests),
+        [&responses](std::size_t index, Response const& response)
+        {
+            EXPECT_EQ(responses.count(index), 0U);
+            responses.emplace(index, response);
+        });
+
+    EXPECT_EQ(stats.numRequests, requests.size());
+    EXPECT_EQ(stats.numErrors, 1U);
+    ASSERT_EQ(responses.size(), requests.size());
+    EXPECT_TRUE(responses.at(10).hasError());
+    for (std::size_t i = 0; i < 10; ++i)
+    {
+        ASSERT_FALSE(responses.at(i).hasError());
+        EXPECT_TRUE(responses.at(i).getResult().isFinal);
+    }
+    EXPECT_LE(executor->mMaxInFlight, 3U);
+
+    // The requests of a window are enqueued by prefix, all but one request per prefix and window share 2 blocks
+    EXPECT_EQ(executor->mPrompts.front(), requests[0].getInputTokenIds());
+    EXPECT_EQ(stats.numPrefixGroups, 7U);
+    EXPECT_GE(stats.numSharedBlocks, 10U);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include <gtest/gtest.h>
+
+#include <string>
+
+#include "tensorrt_llm/executor/batchSerialization.h"
+
+namespace tle = tensorrt_llm::executor;
+using tensorrt_llm::common::TllmException;
+
+namespace
+{
+struct Item
+{
+    std::string text;
+};
+} // namespace
+
+template <>
+struct tle::SerializationTraits<Item>
+{
+    [[nodiscard]] static std::size_t serializedSize(Item const& item)
+    {
+        return item.text.size() + 1;
+    }
+
+    static void serialize(Item const& item, std::ostream& os)
+    {
+        os << item.text << '\n';
+    }
+
+    [[nodiscard]] static Item deserialize(std::istream& is)
+    {
+        Item item;
+        std::getline(is, item.text);
+        return item;
+    }
+};
+
+TEST(BatchSerializationTest, PackUnpack)
+{
+    std::vector<Item> const items{{"first"}, {""}, {"third item"}};
+    auto const buffer = tle::BatchSerialization::pack(items);
+    EXPECT_EQ(buffer.size(), tle::BatchSerialization::packedSize(items));
+    EXPECT_EQ(buffer.size(), 5 * sizeof(std::uint64_t) + 6 + 1 + 11);
+
+    ASSERT_EQ(tle::BatchSerialization::getNumItems(buffer.data(), buffer.size()), 3);
+    EXPECT_EQ(tle::BatchSerialization::unpackItem<Item>(buffer.data(), buffer.size(), 2).text, "third item");
+    auto const unpacked = tle::BatchSerialization::unpack<Item>(buffer.data(), buffer.size());
+    ASSERT_EQ(unpacked.size(), items.size());
+    for (std::size_t i = 0; i < items.size(); ++i)
+    {
+        EXPECT_EQ(unpacked[i].text, items[i].text);
+    }
+}
+
+TEST(BatchSerializationTest, CallerProvidedBuffer)
+{
+    std::vector<Item> const items{{"a"}, {"bc"}};
+    std::vector<char> arena(64, 0);
+    auto const size = tle::BatchSerialization::pack(items, arena.data(), arena.size());
+    EXPECT_EQ(size, tle::BatchSerialization::packedSize(items));
+    EXPECT_EQ(tle::BatchSerialization::unpack<Item>(arena.data(), size)[1].text, "bc");
+
+    EXPECT_THROW(tle::BatchSerialization::pack(items, arena.data(), size - 1), TllmException);
+    // Two offsets do not fit into 8 bytes.
+    EXPECT_THROW(static_cast<void>(tle::BatchSerialization::getNumItems(arena.data(), 8)), TllmException);
+}
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/dataParallelRouter.h"
+
+#include <deque>
+#include <numeric>
+#include <utility>
+
+using namespace tensorrt_llm::executor;
+
+namespace
+{
+struct FakeExecutor
+{
+    IdType enqueueRequest(Request const& /* request */)
+    {
+        return mNextId++;
+    }
+
+    std::deque<IterationStats> getLatestIterationStats()
+    {
+        return std::exchange(mStats, {});
+    }
+
+    IdType mNextId{0};
+    std::deque<IterationStats> mStats;
+};
+
+using Router = BasicDataParallelRouter<FakeExecutor>;
+
+Request makeRequest(SizeType32 numTokens, TokenIdType firstToken = 0)
+{
+    VecTokens tokens(numTokens);
+    std::iota(tokens.begin(), tokens.end(), firstToken);
+    return Request{std::move(tokens), 8};
+}
+
+IterationStats makeStats(SizeType32 numRequests, std::optional<SizeType32> freeNumBlocks = std::nullopt)
+{
+    IterationStats stats{};
+    stats.numActiveRequests = numRequests;
+    if (freeNumBlocks)
+    {
+        KvCacheStats kvCacheStats{};
+        kvCacheStats.freeNumBlocks = *freeNumBlocks;
+        stats.kvCacheStats = kvCacheStats;
+    }
+    return stats;
+}
+
+Router::Config makeConfig()
+{
+    Router::Config config;
+    config.tokensPerBlock = 4;
+    config.maxLoadImbalance = 2;
+    return config;
+}
+} // namespace
+
+TEST(DataParallelRouterTest, BalancesRequestsWithoutSharedPrefixes)
+{
+    Router router{makeConfig()};
+    auto const r0 = router.addReplica(std::make_shared<FakeExecutor>());
+    auto const r1 = router.addReplica(std::make_shared<FakeExecutor>());
+
+    EXPECT_EQ(router.route(makeRequest(8, 0)), r0);
+    EXPECT_EQ(router.route(makeRequest(8, 100)), r1);
+    EXPECT_EQ(router.route(makeRequest(8, 200)), r0);
+
+    // Stats replace the requests routed since the previous ones.
+    router.updateLoad(r0, makeStats(5));
+    router.updateLoad(r1, makeStats(1));
+    EXPECT_EQ(router.route(makeRequest(8, 300)), r1);
+}
+
+TEST(DataParallelRouterTest, SharedPrefixGoesToSameReplica)
+{
+    Router router{makeConfig()};
+    auto const r0 = router.addReplica(std::make_shared<FakeExecutor>());
+    auto const r1 = router.addReplica(std::make_shared<FakeExecutor>());
+
+    EXPECT_EQ(router.route(makeRequest(4, 100)), r0);
+    EXPECT_EQ(router.route(makeRequest(12, 0)), r1);
+    // Shares the first two blocks with the previous request.
+    EXPECT_EQ(router.route(makeRequest(10, 0)), r1);
+    // Also when r1 has more requests, within maxLoadImbalance.
+    EXPECT_EQ(router.route(makeRequest(8, 0)), r1);
+    // A partial block is not a prefix.
+    EXPECT_EQ(router.route(makeRequest(3, 0)), r0);
+}
+
+TEST(DataParallelRouterTest, AffinityYieldsToLoadAndFreeBlocks)
+{
+    Router router{makeConfig()};
+    auto const r0 = router.addReplica(std::make_shared<FakeExecutor>());
+    auto const r1 = router.addReplica(std::make_shared<FakeExecutor>());
+
+    EXPECT_EQ(router.route(makeRequest(8)), r0);
+    router.updateLoad(r0, makeStats(3));
+    router.updateLoad(r1, makeStats(0));
+    EXPECT_EQ(router.route(makeRequest(8)), r1);
+
+    // The prefix is on r1 now, but r1 has no free blocks for the rest of the prompt.
+    router.updateLoad(r0, makeStats(0, 100));
+    router.updateLoad(r1, makeStats(0, 1));
+    EXPECT_EQ(router.route(makeRequest(16)), r0);
+}
+
+TEST(DataParallelRouterTest, ScalesOutAndIn)
+{
+    Router router{makeConfig()};
+    auto const r0 = router.addReplica(std::make_shared<FakeExecutor>());
+    EXPECT_EQ(router.route(makeRequest(8)), r0);
+
+    auto const r1 = router.addReplica(std::make_shared<FakeExecutor>());
+    EXPECT_EQ(router.getNumReplicas(), 2);
+    EXPECT_EQ(router.route(makeRequest(8, 100)), r1);
+
+    router.removeReplica(r0);
+    EXPECT_EQ(router.route(makeRequest(8)), r1);
+    EXPECT_THROW(router.removeReplica(r0), tensorrt_llm::common::TllmException);
+}
+
+TEST(DataParallelRouterTest, EnqueuesInRoutedReplica)
+{
+    Router router{makeConfig()};
+    auto executor = std::make_shared<FakeExecutor>();
+    auto const r0 = router.addReplica(executor);
+
+    executor->mStats.push_back(makeStats(7));
+    router.refreshLoads();
+    EXPECT_TRUE(executor->mStats.empty());
+
+    auto const id = router.enqueueRequest(makeRequest(8));
+    EXPECT_EQ(id.replica, r0);
+    EXPECT_EQ(id.requestId, 0);
+    EXPECT_EQ(executor->mNextId, 1);
+    EXPECT_EQ(router.getExecutor(r0), executor);
+}
+
+TEST(DataParallelRouterTest, RoutesByKvPrecisionTier)
+{
+    Router router{makeConfig()};
+    auto const full = router.addReplica(std::make_shared<FakeExecutor>());
+    // Without a quantized replica, quantized requests fall back to full precision.
+    EXPECT_EQ(router.route(makeRequest(8, 100), KvPrecisionTier::kQUANTIZED), full);
+
+    auto const quantized = router.addReplica(std::make_shared<FakeExecutor>(), KvPrecisionTier::kQUANTIZED);
+    router.updateLoad(full, makeStats(10));
+    router.updateLoad(quantized, makeStats(0));
+    // Full precision requests stay on full precision replicas, however loaded.
+    EXPECT_EQ(router.route(makeRequest(8)), full);
+    EXPECT_EQ(router.route(makeRequest(8, 200), KvPrecisionTier::kQUANTIZED), quantized);
+    // The prefix of a tier is not matched by the other tier.
+    EXPECT_EQ(router.route(makeRequest(8), KvPrecisionTier::kQUANTIZED), quantized);
+
+    router.removeReplica(full);
+    EXPECT_THROW((void) router.route(makeRequest(8)), tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/executorStartup.h"
+
+#include <future>
+#include <stdexcept>
+
+using namespace tensorrt_llm::executor;
+
+namespace
+{
+// Finishes every request at the first call of awaitResponses, after the gate opens. Requests with a prompt of 3
+// tokens fail.
+struct FakeExecutor
+{
+    std::vector<IdType> enqueueRequests(std::vector<Request> const& requests)
+    {
+        std::vector<IdType> ids;
+        for (auto const& request : requests)
+        {
+            mPrompts.push_back(request.getInputTokenIds());
+            ids.push_back(mNextId++);
+        }
+        return ids;
+    }
+
+    std::vector<std::vector<Response>> awaitResponses(std::vector<IdType> const& requestIds,
+        std::optional<std::chrono::milliseconds> const& /* timeout */ = std::nullopt)
+    {
+        mGate.wait();
+        std::vector<std::vector<Response>> responses;
+        for (auto const id : requestIds)
+        {
+            if (mPrompts.at(id).size() == 3)
+            {
+                responses.push_back({Response{id, "failed"}});
+            }
+            else
+            {
+                responses.push_back({Response{id, Result{true, {{1}}}}});
+            }
+        }
+        return responses;
+    }
+
+    IdType mNextId{0};
+    std::vector<VecTokens> mPrompts;
+    std::shared_future<void> mGate;
+};
+
+using Startup = BasicExecutorStartup<FakeExecutor>;
+
+std::shared_ptr<FakeExecutor> makeExecutor(std::shared_future<void> gate)
+{
+    auto executor = std::make_shared<FakeExecutor>();
+    executor->mGate = std::move(gate);
+    return executor;
+}
+} // namespace
+
+TEST(ExecutorStartupTest, WarmsUpEveryBucketBeforeServing)
+{
+    std::promise<void> gate;
+    auto executor = makeExecutor(gate.get_future().share());
+    Startup::Config config;
+    config.buckets = {{2, 8}, {4, 3}, {1, 16}};
+    config.maxTokenId = 50;
+    Startup startup{[executor]() { return executor; }, config};
+
+    EXPECT_FALSE(startup.waitUntilServing(std::chrono::milliseconds{20}));
+    EXPECT_FALSE(startup.isServing());
+    EXPECT_THROW((void) startup.getExecutor(), tensorrt_llm::common::TllmException);
+
+    gate.set_value();
+    ASSERT_TRUE(startup.waitUntilServing());
+    EXPECT_EQ(startup.getPhase(), StartupPhase::kREADY);
+    EXPECT_EQ(startup.getExecutor(), executor);
+
+    auto const stats = startup.getStats();
+    EXPECT_EQ(stats.numWarmedBuckets, 3);
+    EXPECT_EQ(stats.numFailedRequests, 4);
+    ASSERT_EQ(executor->mPrompts.size(), 7u);
+    EXPECT_EQ(executor->mPrompts.at(6).size(), 16u);
+    // The prompts differ, all tokens are in [1, maxTokenId]
+    EXPECT_NE(executor->mPrompts.at(0).front(), executor->mPrompts.at(1).front());
+    for (auto const& prompt : executor->mPrompts)
+    {
+        for (auto const token : prompt)
+        {
+            EXPECT_TRUE(token >= 1 && token <= config.maxTokenId);
+        }
+    }
+}
+
+TEST(ExecutorStartupTest, ServesWhileWarmingWhenAllowed)
+{
+    std::promise<void> gate;
+    auto executor = makeExecutor(gate.get_future().share());
+    Startup::Config config;
+    config.buckets = {{1, 8}};
+    config.serveWhileWarming = true;
+    Startup startup{[executor]() { return executor; }, config};
+
+    ASSERT_TRUE(startup.waitUntilServing());
+    EXPECT_EQ(startup.getPhase(), StartupPhase::kWARMING_UP);
+    EXPECT_EQ(startup.getExecutor(), executor);
+    gate.set_value();
+}
+
+TEST(ExecutorStartupTest, ReportsFailedCreation)
+{
+    Startup startup{[]() -> std::shared_ptr<FakeExecutor> { throw std::runtime_error("no engine"); }, {}};
+
+    EXPECT_FALSE(startup.waitUntilServing());
+    EXPECT_EQ(startup.getPhase(), StartupPhase::kFAILED);
+    EXPECT_EQ(startup.getError(), "no engine");
+}
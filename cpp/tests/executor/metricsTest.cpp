@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/metrics.h"
+
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::executor;
+
+TEST(MetricsTest, HistogramBuckets)
+{
+    MetricsHistogram histogram{2, 10};
+    EXPECT_EQ(histogram.getNumBuckets(), 36);
+    for (std::uint64_t value = 0; value < (1 << 10); ++value)
+    {
+        auto const index = histogram.bucketIndex(value);
+        EXPECT_LE(value, histogram.bucketUpperBound(index)) << value;
+        if (index > 0)
+        {
+            EXPECT_GT(value, histogram.bucketUpperBound(index - 1)) << value;
+        }
+    }
+    EXPECT_EQ(histogram.bucketIndex(1 << 20), histogram.getNumBuckets() - 1);
+}
+
+TEST(MetricsTest, HistogramQuantiles)
+{
+    MetricsHistogram histogram;
+    EXPECT_EQ(histogram.getQuantile(0.5), 0);
+    for (std::uint64_t value = 1; value <= 1000; ++value)
+    {
+        histogram.record(value);
+    }
+    EXPECT_EQ(histogram.getCount(), 1000);
+    EXPECT_EQ(histogram.getSum(), 500500);
+    // Within 1/16 above the exact quantile
+    auto const p50 = histogram.getQuantile(0.5);
+    EXPECT_GE(p50, 500);
+    EXPECT_LE(p50, 500 + 500 / 16);
+    auto const p99 = histogram.getQuantile(0.99);
+    EXPECT_GE(p99, 990);
+    EXPECT_LE(p99, 990 + 990 / 16);
+}
+
+TEST(MetricsTest, ConcurrentUpdates)
+{
+    MetricsRegistry registry;
+    auto& counter = registry.addCounter("requests", "Requests");
+    auto& histogram = registry.addHistogram("latency", "Latency");
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back(
+            [&]()
+            {
+                for (int i = 0; i < 10000; ++i)
+                {
+                    counter.add();
+                    histogram.record(i);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(counter.get(), 40000);
+    EXPECT_EQ(histogram.getCount(), 40000);
+    EXPECT_THROW(registry.addGauge("requests", "Duplicate"), tensorrt_llm::common::TllmException);
+}
+
+TEST(MetricsTest, OpenMetricsText)
+{
+    IterationStatsMetrics metrics{"test_"};
+    IterationStats stats{};
+    stats.iterLatencyMS = 0.005;
+    stats.numActiveRequests = 3;
+    stats.numQueuedRequests = 2;
+    InflightBatchingStats ifb{};
+    ifb.numScheduledRequests = 3;
+    ifb.numCtxTokens = 100;
+    ifb.numGenRequests = 2;
+    ifb.avgNumDecodedTokensPerIter = 1.f;
+    stats.inflightBatchingStats = ifb;
+    KvCacheStats kv{};
+    kv.maxNumBlocks = 8;
+    kv.usedNumBlocks = 2;
+    stats.kvCacheStats = kv;
+    metrics.observe(stats);
+    metrics.observe(stats);
+
+    auto const text = metrics.renderOpenMetrics();
+    EXPECT_NE(text.find("# TYPE test_iterations counter\n"), std::string::npos);
+    EXPECT_NE(text.find("test_iterations_total 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_context_tokens_total 200\n"), std::string::npos);
+    EXPECT_NE(text.find("test_generation_tokens_total 4\n"), std::string::npos);
+    EXPECT_NE(text.find("test_kv_cache_utilization 0.25\n"), std::string::npos);
+    EXPECT_NE(text.find("test_active_requests 3\n"), std::string::npos);
+    // 5 us latencies, in the bucket up to 7
+    EXPECT_NE(text.find("test_iteration_latency_microseconds_bucket{le=\"3\"} 0\n"), std::string::npos);
+    EXPECT_NE(text.find("test_iteration_latency_microseconds_bucket{le=\"7\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_iteration_latency_microseconds_bucket{le=\"+Inf\"} 2\n"), std::string::npos);
+    EXPECT_NE(text.find("test_iteration_latency_microseconds_sum 10\n"), std::string::npos);
+    EXPECT_NE(text.find("test_tokens_per_iteration_count 2\n"), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 6), "# EOF\n");
+}
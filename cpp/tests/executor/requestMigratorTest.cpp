@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/requestMigrator.h"
+
+#include <map>
+#include <sstream>
+
+using namespace tensorrt_llm::executor;
+
+namespace
+{
+// Generates one token per request and call of awaitResponses, the token at position p of the sequence is 1000 + p,
+// so that a resumed request continues with the tokens the paused one would have generated.
+struct FakeExecutor
+{
+    struct Sequence
+    {
+        Request request;
+        VecTokens tokens;
+        SizeType32 numGenerated{0};
+        bool cancelled{false};
+    };
+
+    IdType enqueueRequest(Request const& request)
+    {
+        mSequences.emplace(mNextId, Sequence{request, request.getInputTokenIds()});
+        return mNextId++;
+    }
+
+    std::vector<Response> awaitResponses(std::optional<std::chrono::milliseconds> const& /* timeout */)
+    {
+        generate();
+        return std::exchange(mPending, {});
+    }
+
+    std::vector<Response> awaitResponses(IdType requestId)
+    {
+        if (auto it = mSequences.find(requestId); it != mSequences.end() && it->second.cancelled)
+        {
+            respond(requestId, it->second, {}, true);
+            mSequences.erase(it);
+        }
+        std::vector<Response> responses;
+        for (auto it = mPending.begin(); it != mPending.end();)
+        {
+            if (it->getRequestId() == requestId)
+            {
+                responses.push_back(*it);
+                it = mPending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+        return responses;
+    }
+
+    void cancelRequest(IdType requestId)
+    {
+        if (auto it = mSequences.find(requestId); it != mSequences.end())
+        {
+            it->second.cancelled = true;
+        }
+    }
+
+    // Generate one token per request, the responses are returned by the next call of awaitResponses
+    void generate()
+    {
+        for (auto it = mSequences.begin(); it != mSequences.end();)
+        {
+            auto& sequence = it->second;
+            auto const token = static_cast<TokenIdType>(1000 + sequence.tokens.size());
+            sequence.tokens.push_back(token);
+            auto const isFinal = ++sequence.numGenerated == sequence.request.getMaxNewTokens();
+            respond(it->first, sequence, {token}, isFinal);
+            it = isFinal ? mSequences.erase(it) : std::next(it);
+        }
+    }
+
+    void respond(IdType requestId, Sequence const& sequence, VecTokens newTokens, bool isFinal)
+    {
+        auto const& request = sequence.request;
+        if (request.getStreaming() && !request.getReturnAllGeneratedTokens())
+        {
+            mPending.emplace_back(requestId, Result{isFinal, {std::move(newTokens)}});
+        }
+        else if (isFinal || request.getStreaming())
+        {
+            auto const promptLength = request.getOutputConfig().excludeInputFromOutput
+                ? static_cast<std::ptrdiff_t>(request.getInputTokenIds().size())
+                : 0;
+            mPending.emplace_back(
+                requestId, Result{isFinal, {{sequence.tokens.begin() + promptLength, sequence.tokens.end()}}});
+        }
+    }
+
+    IdType mNextId{0};
+    std::map<IdType, Sequence> mSequences;
+    std::vector<Response> mPending;
+};
+
+using Migrator = BasicRequestMigrator<FakeExecutor>;
+
+VecTokens collectTokens(Migrator& migrator, IdType requestId, VecTokens tokens, bool fullOutput)
+{
+    auto done = false;
+    while (!done)
+    {
+        for (auto const& response : migrator.awaitResponses())
+        {
+            EXPECT_EQ(response.getRequestId(), requestId);
+            auto const result = response.getResult();
+            auto const& newTokens = result.outputTokenIds.front();
+            if (fullOutput)
+            {
+                tokens = newTokens;
+            }
+            else
+            {
+                tokens.insert(tokens.end(), newTokens.begin(), newTokens.end());
+            }
+            done = result.isFinal;
+        }
+    }
+    return tokens;
+}
+} // namespace
+
+TEST(RequestMigratorTest, ResumesStreamingRequestOnAnotherExecutor)
+{
+    auto source = std::make_shared<FakeExecutor>();
+    auto target = std::make_shared<FakeExecutor>();
+    Migrator sourceMigrator{source};
+    Migrator targetMigrator{target};
+
+    auto const requestId = sourceMigrator.enqueueRequest(Request{VecTokens{1, 2, 3}, 6, true});
+    VecTokens tokens;
+    for (int i = 0; i < 2; ++i)
+    {
+        for (auto const& response : sourceMigrator.awaitResponses())
+        {
+            auto const newTokens = response.getResult().outputTokenIds.front();
+            tokens.insert(tokens.end(), newTokens.begin(), newTokens.end());
+        }
+    }
+    EXPECT_EQ(tokens, (VecTokens{1003, 1004}));
+
+    auto paused = sourceMigrator.pause(requestId);
+    EXPECT_FALSE(paused.finished);
+    ASSERT_EQ(paused.responses.size(), 1U);
+    EXPECT_FALSE(paused.responses.front().getResult().isFinal);
+    EXPECT_EQ(paused.state.generatedTokens, (VecTokens{1003, 1004}));
+    EXPECT_TRUE(sourceMigrator.getRequestIds().empty());
+
+    auto const resumedId = targetMigrator.resume(paused.state);
+    auto const& resumed = target->mSequences.at(resumedId).request;
+    EXPECT_EQ(resumed.getInputTokenIds(), (VecTokens{1, 2, 3, 1003, 1004}));
+    EXPECT_EQ(resumed.getMaxNewTokens(), 4);
+    EXPECT_TRUE(resumed.getSamplingConfig().getRandomSeed().has_value());
+
+    tokens = collectTokens(targetMigrator, resumedId, tokens, false);
+    EXPECT_EQ(tokens, (VecTokens{1003, 1004, 1005, 1006, 1007, 1008}));
+    EXPECT_TRUE(targetMigrator.getRequestIds().empty());
+}
+
+TEST(RequestMigratorTest, RebasesFullOutputs)
+{
+    for (auto const excludeInput : {false, true})
+    {
+        auto source = std::make_shared<FakeExecutor>();
+        auto target = std::make_shared<FakeExecutor>();
+        Migrator sourceMigrator{source};
+        Migrator targetMigrator{target};
+
+        OutputConfig outputConfig{false, false, false, excludeInput};
+        auto const requestId
+            = sourceMigrator.enqueueRequest(Request{VecTokens{1, 2}, 4, false, SamplingConfig{}, outputConfig});
+        // No response before the final one
+        EXPECT_TRUE(sourceMigrator.awaitResponses().empty());
+
+        auto paused = sourceMigrator.pause(requestId);
+        EXPECT_FALSE(paused.finished);
+        EXPECT_EQ(paused.state.generatedTokens, (VecTokens{1002}));
+
+        // The client sees the output of the whole generation
+        auto const resumedId = targetMigrator.resume(paused.state);
+        auto const tokens = collectTokens(targetMigrator, resumedId, {}, true);
+        auto const expected
+            = excludeInput ? VecTokens{1002, 1003, 1004, 1005} : VecTokens{1, 2, 1002, 1003, 1004, 1005};
+        EXPECT_EQ(tokens, expected);
+    }
+}
+
+TEST(RequestMigratorTest, DetectsFinishedRequests)
+{
+    auto executor = std::make_shared<FakeExecutor>();
+    Migrator migrator{executor};
+
+    auto const requestId = migrator.enqueueRequest(Request{VecTokens{1, 2, 3}, 2, true});
+    EXPECT_EQ(migrator.awaitResponses().size(), 1U);
+    // The request generates its last token before the cancellation
+    executor->generate();
+
+    auto paused = migrator.pause(requestId);
+    EXPECT_TRUE(paused.finished);
+    ASSERT_EQ(paused.responses.size(), 1U);
+    EXPECT_TRUE(paused.responses.front().getResult().isFinal);
+    EXPECT_EQ(paused.state.generatedTokens, (VecTokens{1003, 1004}));
+    EXPECT_THROW((void) paused.state.makeResumeRequest(), std::exception);
+}
+
+TEST(RequestMigratorTest, RejectsBeamSearch)
+{
+    Migrator migrator{std::make_shared<FakeExecutor>()};
+    EXPECT_THROW(
+        (void) migrator.enqueueRequest(Request{VecTokens{1, 2, 3}, 2, false, SamplingConfig{2}}), std::exception);
+}
+
+TEST(RequestMigratorTest, SerializesState)
+{
+    RequestMigrationState state{Request{VecTokens{1, 2, 3}, 8}, VecTokens{1003, 1004}};
+    std::stringstream stream;
+    state.serialize(stream);
+    auto const deserialized = RequestMigrationState::deserialize(stream);
+    EXPECT_EQ(deserialized.request.getInputTokenIds(), state.request.getInputTokenIds());
+    EXPECT_EQ(deserialized.request.getMaxNewTokens(), 8);
+    EXPECT_EQ(deserialized.generatedTokens, state.generatedTokens);
+
+    std::stringstream truncated{stream.str().substr(0, 4)};
+    EXPECT_THROW((void) RequestMigrationState::deserialize(truncated), std::exception);
+}
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/executor/responseDelta.h"
+
+using namespace tensorrt_llm::executor;
+
+namespace
+{
+Result makeResult(BeamTokens tokens, bool isFinal = false)
+{
+    Result result;
+    result.isFinal = isFinal;
+    result.outputTokenIds = std::move(tokens);
+    return result;
+}
+} // namespace
+
+TEST(ResultDeltaTest, StreamingNewTokens)
+{
+    ResultDeltaEncoder encoder{false};
+    ResultDeltaDecoder decoder;
+
+    encoder.add(1, makeResult({{10, 11}}));
+    encoder.add(2, makeResult({{20}}));
+    auto deltas = ResultDeltaDecoder::decode(encoder.flush());
+    ASSERT_EQ(deltas.size(), 2);
+    EXPECT_EQ(decoder.apply(deltas[0]), (BeamTokens{{10, 11}}));
+    EXPECT_EQ(decoder.apply(deltas[1]), (BeamTokens{{20}}));
+
+    encoder.add(1, makeResult({{12}}, true), {FinishReason::kEND_ID});
+    deltas = ResultDeltaDecoder::decode(encoder.flush());
+    ASSERT_EQ(deltas.size(), 1);
+    EXPECT_TRUE(deltas[0].isFinal);
+    EXPECT_EQ(deltas[0].beams[0], (BeamDelta{2, {12}, std::nullopt, FinishReason::kEND_ID}));
+    EXPECT_EQ(decoder.apply(deltas[0]), (BeamTokens{{10, 11, 12}}));
+    EXPECT_EQ(encoder.getNumTrackedRequests(), 1);
+}
+
+TEST(ResultDeltaTest, AllGeneratedTokensWithBeamSearch)
+{
+    ResultDeltaEncoder encoder{true};
+    ResultDeltaDecoder decoder;
+
+    encoder.add(1, makeResult({{1, 2, 3}, {1, 4, 5}}));
+    auto deltas = ResultDeltaDecoder::decode(encoder.flush());
+    EXPECT_EQ(decoder.apply(deltas[0]), (BeamTokens{{1, 2, 3}, {1, 4, 5}}));
+
+    // Beam 1 was replaced by a continuation of beam 0, only the diverging suffix is sent.
+    auto result = makeResult({{1, 2, 3, 6}, {1, 2, 3, 7}});
+    result.logProbs = std::vector<VecLogProbs>{{-0.1f, -0.2f, -0.3f, -0.4f}, {-0.1f, -0.2f, -0.3f, -0.5f}};
+    encoder.add(1, result);
+    auto const buffer = encoder.flush();
+    deltas = ResultDeltaDecoder::decode(buffer);
+    ASSERT_EQ(deltas[0].beams.size(), 2);
+    EXPECT_EQ(deltas[0].beams[0], (BeamDelta{3, {6}, VecLogProbs{-0.4f}, FinishReason::kNOT_FINISHED}));
+    EXPECT_EQ(deltas[0].beams[1],
+        (BeamDelta{1, {2, 3, 7}, VecLogProbs{-0.2f, -0.3f, -0.5f}, FinishReason::kNOT_FINISHED}));
+    EXPECT_EQ(decoder.apply(deltas[0]), (BeamTokens{{1, 2, 3, 6}, {1, 2, 3, 7}}));
+}
+
+TEST(ResultDeltaTest, Errors)
+{
+    ResultDeltaEncoder encoder{false};
+    encoder.add(1, makeResult({{1}}));
+    encoder.addError(1, "cancelled");
+    auto buffer = encoder.flush();
+    auto const deltas = ResultDeltaDecoder::decode(buffer);
+    ASSERT_EQ(deltas.size(), 2);
+    EXPECT_TRUE(deltas[1].isFinal);
+    EXPECT_EQ(deltas[1].errorMsg, "cancelled");
+    EXPECT_EQ(encoder.getNumTrackedRequests(), 0);
+
+    buffer.pop_back();
+    EXPECT_THROW(ResultDeltaDecoder::decode(buffer), tensorrt_llm::common::TllmException);
+}
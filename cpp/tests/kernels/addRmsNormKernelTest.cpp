@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/rmsnormKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::kernels;
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+auto constexpr kTokens = 4;
+auto constexpr kHidden = 1024;
+auto constexpr kEps = 1e-6f;
+
+ITensor::SharedPtr randomTensor(std::mt19937& gen, float range)
+{
+    auto tensor = BufferManager::pinned(ITensor::makeShape({kTokens, kHidden}), nvinfer1::DataType::kFLOAT);
+    std::uniform_real_distribution<float> dist(-range, range);
+    auto* data = bufferCast<float>(*tensor);
+    std::generate(data, data + tensor->getSize(), [&]() { return dist(gen); });
+    return tensor;
+}
+} // namespace
+
+TEST(AddRmsNormKernelTest, InPlaceResidualAndPerTokenQuant)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager(stream);
+
+    std::mt19937 gen(42);
+    auto input = randomTensor(gen, 4.f);
+    auto residual = randomTensor(gen, 1.f);
+    auto gamma = BufferManager::pinned(ITensor::makeShape({kHidden}), nvinfer1::DataType::kFLOAT);
+    std::uniform_real_distribution<float> gammaDist(0.5f, 1.5f);
+    std::generate(bufferCast<float>(*gamma), bufferCast<float>(*gamma) + kHidden, [&]() { return gammaDist(gen); });
+
+    // The GEMM output is overwritten with the residual sum, like in the SmoothQuant GEMM plugin
+    auto inOut = manager.copyFrom(*input, MemoryType::kGPU);
+    auto residualDevice = manager.copyFrom(*residual, MemoryType::kGPU);
+    auto gammaDevice = manager.copyFrom(*gamma, MemoryType::kGPU);
+    auto quantized = manager.gpu(ITensor::makeShape({kTokens, kHidden}), nvinfer1::DataType::kINT8);
+    auto scales = manager.gpu(ITensor::makeShape({kTokens, 1}), nvinfer1::DataType::kFLOAT);
+
+    invokeGeneralAddRmsNorm<float>(bufferCast<float>(*inOut), nullptr, bufferCast<float>(*inOut),
+        bufferCast<float>(*residualDevice), bufferCast<float>(*gammaDevice), nullptr, kEps, kTokens, kHidden,
+        stream->get(), nullptr, bufferCast<float>(*scales), bufferCast<std::int8_t>(*quantized));
+
+    auto sumHost = manager.copyFrom(*inOut, MemoryType::kCPU);
+    auto quantizedHost = manager.copyFrom(*quantized, MemoryType::kCPU);
+    auto scalesHost = manager.copyFrom(*scales, MemoryType::kCPU);
+    stream->synchronize();
+
+    auto const* in = bufferCast<float>(*input);
+    auto const* res = bufferCast<float>(*residual);
+    auto const* g = bufferCast<float>(*gamma);
+    auto const* sum = bufferCast<float>(*sumHost);
+    auto const* q = bufferCast<std::int8_t>(*quantizedHost);
+    auto const* scale = bufferCast<float>(*scalesHost);
+    for (SizeType32 t = 0; t < kTokens; ++t)
+    {
+        std::vector<float> normed(kHidden);
+        float squares = 0.f;
+        for (SizeType32 i = 0; i < kHidden; ++i)
+        {
+            auto const idx = t * kHidden + i;
+            EXPECT_FLOAT_EQ(sum[idx], in[idx] + res[idx]);
+            squares += sum[idx] * sum[idx];
+        }
+        auto const invRms = 1.f / std::sqrt(squares / kHidden + kEps);
+        float amax = 0.f;
+        for (SizeType32 i = 0; i < kHidden; ++i)
+        {
+            normed[i] = sum[t * kHidden + i] * invRms * g[i];
+            amax = std::max(amax, std::abs(normed[i]));
+        }
+        EXPECT_NEAR(scale[t], amax / 127.f, 1e-3f * amax / 127.f);
+        for (SizeType32 i = 0; i < kHidden; ++i)
+        {
+            // One quantization step for the rounding
+            EXPECT_NEAR(q[t * kHidden + i] * scale[t], normed[i], 1.01f * scale[t]) << "token " << t << " index " << i;
+        }
+    }
+}
@@ -161,8 +161,38 @@ public:
         }
     }
 
+    void invokeBanRepeatNgram(SizeType32 batchSize, SizeType32 maxStep)
+    {
+        tk::invokeBanRepeatNgram(bufferCast<float>(*mLogits),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mOutputIdsPtr)),
+            reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinished)),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mParentIdsPtr)), bufferCast<int32_t>(*mBatchSlots),
+            bufferCast<int32_t>(*mSequenceLengths), batchSize, mBeamWidth, mMaxSeqLen,
+            bufferCast<int32_t>(*mNGramSizes), mVocabSizePadded, maxStep, mStream->get());
+    }
+
+    void initNgramTables(SizeType32 maxBatchSize)
+    {
+        mNgramTableCapacity = tk::getBanRepeatNgramTableCapacity(mMaxSeqLen);
+        mNgramTables = mBufferManager->gpu(
+            ITensor::makeShape({maxBatchSize, mNgramTableCapacity}), nvinfer1::DataType::kINT64);
+        mNgramNumIndexed = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+        trk::invokeFill(*mNgramNumIndexed, int32_t{-1}, *mStream);
+    }
+
+    void invokeBanRepeatNgramHashed(SizeType32 batchSize)
+    {
+        tk::invokeBanRepeatNgramHashed(bufferCast<float>(*mLogits),
+            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mOutputIdsPtr)),
+            reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinished)),
+            bufferCast<int32_t>(*mBatchSlots), bufferCast<int32_t>(*mSequenceLengths), batchSize,
+            bufferCast<int32_t>(*mNGramSizes), mVocabSizePadded,
+            reinterpret_cast<std::uint64_t*>(bufferCast<int64_t>(*mNgramTables)),
+            bufferCast<int32_t>(*mNgramNumIndexed), mNgramTableCapacity, mStream->get());
+    }
+
     void runBanRepeatNGramTest(std::vector<std::vector<SizeType32>> const& outputIds,
-        std::vector<SizeType32> const& nGramSizes, std::vector<SizeType32> const& expectedLastId)
+        std::vector<SizeType32> const& nGramSizes, std::vector<SizeType32> const& expectedLastId, bool hashed = false)
     {
         auto const batchSize = expectedLastId.size();
         int32_t maxStep = 0;
@@ -172,12 +202,15 @@ public:
         }
         initData(outputIds, nGramSizes);
 
-        tk::invokeBanRepeatNgram(bufferCast<float>(*mLogits),
-            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mOutputIdsPtr)),
-            reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinished)),
-            reinterpret_cast<int32_t const**>(bufferCast<int64_t>(*mParentIdsPtr)), bufferCast<int32_t>(*mBatchSlots),
-            bufferCast<int32_t>(*mSequenceLengths), batchSize, mBeamWidth, mMaxSeqLen,
-            bufferCast<int32_t>(*mNGramSizes), mVocabSizePadded, maxStep, mStream->get());
+        if (hashed)
+        {
+            initNgramTables(2 * batchSize);
+            invokeBanRepeatNgramHashed(batchSize);
+        }
+        else
+        {
+            invokeBanRepeatNgram(batchSize, maxStep);
+        }
 
         mStream->synchronize();
 
@@ -200,6 +233,10 @@ protected:
     TensorPtr mNGramSizes;
     TensorPtr mBatchSlots;
 
+    TensorPtr mNgramTables;
+    TensorPtr mNgramNumIndexed;
+    SizeType32 mNgramTableCapacity{0};
+
     static constexpr SizeType32 mMaxSeqLen{16};
     static constexpr SizeType32 mVocabSizePadded{32};
     // TODO(nkorobov): add beam width
@@ -232,4 +269,60 @@ TEST_F(BanRepeatNgramKernelsTest, noRepeatNGramsBS2BW1Test)
     }
 }
 
+TEST_F(BanRepeatNgramKernelsTest, noRepeatNGramsHashedTest)
+{
+    std::vector<std::vector<std::vector<SizeType32>>> outputIds
+        = {{{1, 2, 3, 6, 2, 3}, {1, 3, 3, 4, 5, 6, 2, 3}}, {{1, 2, 3, 2, 3}, {1, 2, 3, 4, 5, 6, 2, 3}}};
+    std::vector<std::vector<SizeType32>> nGramSizes = {{2, 2}, {3, 2}};
+    // Positive value shows expected id of the last token. Negative value shows not-expected id of the last token
+    std::vector<std::vector<SizeType32>> expectedOutputIds = {{-3, 3}, {3, -3}};
+    for (SizeType32 ti = 0; ti < nGramSizes.size(); ++ti)
+    {
+        this->runBanRepeatNGramTest(outputIds[ti], nGramSizes[ti], expectedOutputIds[ti], true);
+    }
+}
+
+TEST_F(BanRepeatNgramKernelsTest, noRepeatNGramsHashedIncrementalTest)
+{
+    // Sequences growing by one or several accepted tokens per step must ban the same tokens as the full scan
+    SizeType32 constexpr batchSize{3};
+    std::mt19937 gen(7);
+    std::uniform_int_distribution<SizeType32> tokenDist(0, 3);
+    std::vector<std::vector<SizeType32>> outputIds(batchSize, std::vector<SizeType32>(mMaxSeqLen));
+    for (auto& ids : outputIds)
+    {
+        std::generate(ids.begin(), ids.end(), [&]() { return tokenDist(gen); });
+    }
+    std::vector<SizeType32> const nGramSizes{2, 3, 1};
+    initData(outputIds, nGramSizes);
+    initNgramTables(2 * batchSize);
+
+    auto batchSlotsPtr = bufferCast<int32_t>(*mBatchSlots);
+    auto sequenceLengthsPtr = bufferCast<SizeType32>(*mSequenceLengths);
+    auto logitsPtr = bufferCast<float>(*mLogits);
+    std::vector<SizeType32> const acceptedTokens{1, 1, 3, 2, 1, 4};
+    SizeType32 sequenceLength{2};
+    for (auto const numAccepted : acceptedTokens)
+    {
+        sequenceLength = std::min(sequenceLength + numAccepted, mMaxSeqLen);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            sequenceLengthsPtr[batchSlotsPtr[bi]] = sequenceLength;
+        }
+
+        trk::invokeFill(*mLogits, 0.f, *mStream);
+        invokeBanRepeatNgram(batchSize, sequenceLength);
+        mStream->synchronize();
+        std::vector<float> const expectedLogits(logitsPtr, logitsPtr + batchSize * mVocabSizePadded);
+
+        trk::invokeFill(*mLogits, 0.f, *mStream);
+        invokeBanRepeatNgramHashed(batchSize);
+        mStream->synchronize();
+        for (SizeType32 idx = 0; idx < batchSize * mVocabSizePadded; ++idx)
+        {
+            EXPECT_EQ(logitsPtr[idx], expectedLogits[idx]) << "sequenceLength: " << sequenceLength << " idx: " << idx;
+        }
+    }
+}
+
 } // end of namespace
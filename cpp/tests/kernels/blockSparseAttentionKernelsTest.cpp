@@ -0,0 +1,281 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/blockSparseAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <set>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class BlockSparseAttentionKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    void init(std::vector<SizeType32> const& seqLengths)
+    {
+        mNumSeqs = static_cast<SizeType32>(seqLengths.size());
+        mSeqLengths = seqLengths;
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+
+        // Block bi of sequence si is K block si * maxBlocksPerSeq + bi, its V block follows all the K blocks.
+        auto const numBlocks = mNumSeqs * mMaxBlocksPerSeq;
+        mBlockOffsets
+            = BufferManager::pinned(ITensor::makeShape({mNumSeqs, 2, mMaxBlocksPerSeq}), nvinfer1::DataType::kINT32);
+        auto* offsets = bufferCast<std::int32_t>(*mBlockOffsets);
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 bi = 0; bi < mMaxBlocksPerSeq; ++bi)
+            {
+                offsets[(si * 2) * mMaxBlocksPerSeq + bi] = si * mMaxBlocksPerSeq + bi;
+                offsets[(si * 2 + 1) * mMaxBlocksPerSeq + bi] = numBlocks + si * mMaxBlocksPerSeq + bi;
+            }
+        }
+        auto const blockSize = mNumKvHeads * mTokensPerBlock * mHeadSize;
+        mPool = BufferManager::pinned(ITensor::makeShape({2 * numBlocks, blockSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*mPool), mPool->getSize(), [&]() { return dist(gen); });
+        auto const bytesPerToken = mNumKvHeads * mHeadSize * static_cast<SizeType32>(sizeof(float));
+        mKvCache = tk::KVBlockArray(mNumSeqs, mMaxBlocksPerSeq, mTokensPerBlock, bytesPerToken,
+            mMaxBlocksPerSeq * mTokensPerBlock, 0, bufferCast<float>(*mPool), nullptr,
+            reinterpret_cast<tk::KVCacheIndex*>(offsets));
+
+        auto const qSize = mNumSeqs * mNumHeads * mHeadSize;
+        mQ = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+        mOut = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*mQ), qSize, [&]() { return dist(gen); });
+        mSeqLengthsBuffer = BufferManager::pinned(ITensor::makeShape({mNumSeqs}), nvinfer1::DataType::kINT32);
+        std::copy(mSeqLengths.begin(), mSeqLengths.end(), bufferCast<SizeType32>(*mSeqLengthsBuffer));
+        mSummaries = BufferManager::pinned(
+            ITensor::makeShape({mNumSeqs, mMaxBlocksPerSeq, mNumKvHeads, mHeadSize}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*mSummaries), mSummaries->getSize(), 0.f);
+    }
+
+    //! Makes the keys of the block follow the query of the first head of the KV head group.
+    void makeHotBlock(SizeType32 seqIdx, SizeType32 kvHeadIdx, SizeType32 blockIdx)
+    {
+        auto const headIdx = kvHeadIdx * (mNumHeads / mNumKvHeads);
+        auto const* q = bufferCast<float>(*mQ) + (seqIdx * mNumHeads + headIdx) * mHeadSize;
+        for (SizeType32 ti = blockIdx * mTokensPerBlock; ti < (blockIdx + 1) * mTokensPerBlock; ++ti)
+        {
+            for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+            {
+                kv(true, seqIdx, kvHeadIdx, ti, ci) = 3.f * q[ci];
+            }
+        }
+    }
+
+    [[nodiscard]] float& kv(bool isK, SizeType32 seqIdx, SizeType32 kvHeadIdx, SizeType32 tokenIdx,
+        SizeType32 channelIdx) const
+    {
+        auto* block = reinterpret_cast<float*>(
+            isK ? mKvCache.getKBlockPtr(seqIdx, tokenIdx) : mKvCache.getVBlockPtr(seqIdx, tokenIdx));
+        return block[mKvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, mHeadSize, channelIdx)];
+    }
+
+    [[nodiscard]] tk::BlockSparseAttentionParams<float> makeParams(SizeType32 topK) const
+    {
+        tk::BlockSparseAttentionParams<float> params;
+        params.q = bufferCast<float>(*mQ);
+        params.seqLengths = bufferCast<SizeType32>(*mSeqLengthsBuffer);
+        params.kvCache = mKvCache;
+        params.blockKeySummaries = bufferCast<float>(*mSummaries);
+        params.out = bufferCast<float>(*mOut);
+        params.numSeqs = mNumSeqs;
+        params.numHeads = mNumHeads;
+        params.numKvHeads = mNumKvHeads;
+        params.headSize = mHeadSize;
+        params.qkScale = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+        params.numSinkBlocks = 1;
+        params.numRecentBlocks = 2;
+        params.topK = topK;
+        return params;
+    }
+
+    [[nodiscard]] float const* getSummary(SizeType32 seqIdx, SizeType32 blockIdx, SizeType32 kvHeadIdx) const
+    {
+        return bufferCast<float>(*mSummaries) + ((seqIdx * mMaxBlocksPerSeq + blockIdx) * mNumKvHeads + kvHeadIdx)
+            * mHeadSize;
+    }
+
+    void checkSummary(SizeType32 seqIdx, SizeType32 blockIdx) const
+    {
+        for (SizeType32 hi = 0; hi < mNumKvHeads; ++hi)
+        {
+            for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+            {
+                float ref{0.f};
+                for (SizeType32 ti = blockIdx * mTokensPerBlock; ti < (blockIdx + 1) * mTokensPerBlock; ++ti)
+                {
+                    ref += kv(true, seqIdx, hi, ti, ci);
+                }
+                EXPECT_NEAR(getSummary(seqIdx, blockIdx, hi)[ci], ref / mTokensPerBlock, 1e-5f)
+                    << "seq " << seqIdx << " block " << blockIdx << " head " << hi << " channel " << ci;
+            }
+        }
+    }
+
+    //! Runs the block-sparse attention and compares with the attention over the tokens of attendedBlocks[si][hi].
+    void runAndCompare(SizeType32 topK, std::vector<std::vector<std::set<SizeType32>>> const& attendedBlocks)
+    {
+        auto params = makeParams(topK);
+        auto const maxSelected = params.getMaxSelectedBlocks();
+        auto selectedBlocks = BufferManager::pinned(
+            ITensor::makeShape({mNumSeqs, mNumKvHeads, maxSelected}), nvinfer1::DataType::kINT32);
+        auto numSelectedBlocks
+            = BufferManager::pinned(ITensor::makeShape({mNumSeqs, mNumKvHeads}), nvinfer1::DataType::kINT32);
+        params.selectedBlocks = bufferCast<SizeType32>(*selectedBlocks);
+        params.numSelectedBlocks = bufferCast<SizeType32>(*numSelectedBlocks);
+
+        tk::invokeUpdateBlockKeySummaries(params, false, mStream->get());
+        tk::invokeBlockSparseAttention(params, mStream->get());
+        mStream->synchronize();
+
+        auto const* qPtr = bufferCast<float>(*mQ);
+        auto const* outPtr = bufferCast<float>(*mOut);
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 hi = 0; hi < mNumKvHeads; ++hi)
+            {
+                auto const row = si * mNumKvHeads + hi;
+                auto const* selected = params.selectedBlocks + row * maxSelected;
+                std::set<SizeType32> const selectedSet(selected, selected + params.numSelectedBlocks[row]);
+                EXPECT_EQ(selectedSet, attendedBlocks[si][hi]) << "seq " << si << " head " << hi;
+            }
+            for (SizeType32 hi = 0; hi < mNumHeads; ++hi)
+            {
+                auto const kvHeadIdx = hi / (mNumHeads / mNumKvHeads);
+                auto const* qRow = qPtr + (si * mNumHeads + hi) * mHeadSize;
+                std::vector<SizeType32> tokens;
+                for (auto const bi : attendedBlocks[si][kvHeadIdx])
+                {
+                    for (auto ti = bi * mTokensPerBlock; ti < std::min((bi + 1) * mTokensPerBlock, mSeqLengths[si]);
+                         ++ti)
+                    {
+                        tokens.push_back(ti);
+                    }
+                }
+                std::vector<float> scores;
+                for (auto const ti : tokens)
+                {
+                    float score{0.f};
+                    for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                    {
+                        score += qRow[ci] * kv(true, si, kvHeadIdx, ti, ci);
+                    }
+                    scores.push_back(score * params.qkScale);
+                }
+                auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                float sum{0.f};
+                for (auto& score : scores)
+                {
+                    score = std::exp(score - maxScore);
+                    sum += score;
+                }
+                for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                {
+                    float ref{0.f};
+                    for (size_t ki = 0; ki < tokens.size(); ++ki)
+                    {
+                        ref += scores[ki] / sum * kv(false, si, kvHeadIdx, tokens[ki], ci);
+                    }
+                    EXPECT_NEAR(outPtr[(si * mNumHeads + hi) * mHeadSize + ci], ref, 1e-4f)
+                        << "seq " << si << " head " << hi << " channel " << ci;
+                }
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    TensorPtr mBlockOffsets;
+    TensorPtr mPool;
+    TensorPtr mQ;
+    TensorPtr mOut;
+    TensorPtr mSeqLengthsBuffer;
+    TensorPtr mSummaries;
+    tk::KVBlockArray mKvCache;
+    std::vector<SizeType32> mSeqLengths;
+    SizeType32 mNumSeqs{0};
+
+    SizeType32 const mMaxBlocksPerSeq{12};
+    SizeType32 const mTokensPerBlock{4};
+    SizeType32 const mNumHeads{4};
+    SizeType32 const mNumKvHeads{2};
+    SizeType32 const mHeadSize{16};
+};
+
+TEST_F(BlockSparseAttentionKernelsTest, SummarizesFullBlocks)
+{
+    init({14, 8});
+    auto params = makeParams(0);
+    tk::invokeUpdateBlockKeySummaries(params, false, mStream->get());
+    mStream->synchronize();
+    for (SizeType32 bi = 0; bi < 3; ++bi)
+    {
+        checkSummary(0, bi);
+    }
+    checkSummary(1, 0);
+    checkSummary(1, 1);
+    // The partial block is not summarized.
+    EXPECT_EQ(getSummary(0, 3, 0)[0], 0.f);
+
+    // Only the block completed by the generated token is updated.
+    kv(true, 1, 0, 0, 0) += 1.f;
+    kv(true, 1, 0, 7, 0) += 1.f;
+    auto const staleSummary = getSummary(1, 0, 0)[0];
+    tk::invokeUpdateBlockKeySummaries(params, true, mStream->get());
+    mStream->synchronize();
+    EXPECT_EQ(getSummary(1, 0, 0)[0], staleSummary);
+    checkSummary(1, 1);
+}
+
+TEST_F(BlockSparseAttentionKernelsTest, AttendsSinkTopKAndRecentBlocks)
+{
+    // Sequence 0 has 10 blocks, the last one partial. Sequence 1 is short enough for the full attention.
+    init({38, 17});
+    makeHotBlock(0, 0, 3);
+    makeHotBlock(0, 0, 6);
+    makeHotBlock(0, 1, 5);
+    makeHotBlock(0, 1, 2);
+    runAndCompare(2, {{{0, 3, 6, 8, 9}, {0, 2, 5, 8, 9}}, {{0, 1, 2, 3, 4}, {0, 1, 2, 3, 4}}});
+}
+
+TEST_F(BlockSparseAttentionKernelsTest, AttendsSinkAndRecentBlocksWithoutTopK)
+{
+    init({3, 20});
+    runAndCompare(0, {{{0}, {0}}, {{0, 3, 4}, {0, 3, 4}}});
+}
+
+} // namespace
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/cascadeAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class CascadeAttentionKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! Allocates the K and V blocks of each sequence, blocks missing from kBlocks[si] are new blocks.
+    void initKvCache(std::vector<std::vector<SizeType32>> const& kBlocks, std::vector<SizeType32> const& seqLengths)
+    {
+        mNumSeqs = static_cast<SizeType32>(seqLengths.size());
+        mSeqLengths = seqLengths;
+        mBlockOffsets
+            = BufferManager::pinned(ITensor::makeShape({mNumSeqs, 2, mMaxBlocksPerSeq}), nvinfer1::DataType::kINT32);
+        auto* offsets = bufferCast<std::int32_t>(*mBlockOffsets);
+        SizeType32 numBlocks{0};
+        for (auto const& seqBlocks : kBlocks)
+        {
+            for (auto const block : seqBlocks)
+            {
+                numBlocks = std::max(numBlocks, block + 1);
+            }
+        }
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 bi = 0; bi < mMaxBlocksPerSeq; ++bi)
+            {
+                auto const kBlock = bi < static_cast<SizeType32>(kBlocks[si].size()) ? kBlocks[si][bi] : numBlocks++;
+                offsets[(si * 2) * mMaxBlocksPerSeq + bi] = kBlock;
+            }
+        }
+        // The V block of each K block follows all the K blocks.
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 bi = 0; bi < mMaxBlocksPerSeq; ++bi)
+            {
+                offsets[(si * 2 + 1) * mMaxBlocksPerSeq + bi] = offsets[(si * 2) * mMaxBlocksPerSeq + bi] + numBlocks;
+            }
+        }
+
+        auto const blockSize = mNumKvHeads * mTokensPerBlock * mHeadSize;
+        mPool = BufferManager::pinned(ITensor::makeShape({2 * numBlocks, blockSize}), nvinfer1::DataType::kFLOAT);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::generate_n(bufferCast<float>(*mPool), mPool->getSize(), [&]() { return dist(gen); });
+
+        auto const bytesPerToken = mNumKvHeads * mHeadSize * static_cast<SizeType32>(sizeof(float));
+        mKvCache = tk::KVBlockArray(mNumSeqs, mMaxBlocksPerSeq, mTokensPerBlock, bytesPerToken,
+            mMaxBlocksPerSeq * mTokensPerBlock, 0, bufferCast<float>(*mPool), nullptr,
+            reinterpret_cast<tk::KVCacheIndex*>(offsets));
+    }
+
+    [[nodiscard]] float readKv(bool isK, SizeType32 seqIdx, SizeType32 kvHeadIdx, SizeType32 tokenIdx,
+        SizeType32 channelIdx) const
+    {
+        auto const* block = reinterpret_cast<float const*>(
+            isK ? mKvCache.getKBlockPtr(seqIdx, tokenIdx) : mKvCache.getVBlockPtr(seqIdx, tokenIdx));
+        return block[mKvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, mHeadSize, channelIdx)];
+    }
+
+    [[nodiscard]] tk::SharedPrefixGroups buildGroups(SizeType32 minPrefixBlocks) const
+    {
+        return tk::buildSharedPrefixGroups(reinterpret_cast<tk::KVCacheIndex const*>(
+                                               bufferCast<std::int32_t>(*mBlockOffsets)),
+            mSeqLengths.data(), mNumSeqs, mMaxBlocksPerSeq, mTokensPerBlock, minPrefixBlocks);
+    }
+
+    static TensorPtr toBuffer(std::vector<SizeType32> const& values)
+    {
+        auto buffer = BufferManager::pinned(
+            ITensor::makeShape({std::max(static_cast<SizeType32>(values.size()), 1)}), nvinfer1::DataType::kINT32);
+        std::copy(values.begin(), values.end(), bufferCast<SizeType32>(*buffer));
+        return buffer;
+    }
+
+    void runAndCompare(tk::SharedPrefixGroups const& groups)
+    {
+        auto const qSize = mNumSeqs * mNumHeads * mHeadSize;
+        auto q = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+        auto out = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+        auto partialOut = BufferManager::pinned(ITensor::makeShape({2 * qSize}), nvinfer1::DataType::kFLOAT);
+        auto partialLse
+            = BufferManager::pinned(ITensor::makeShape({2 * mNumSeqs * mNumHeads}), nvinfer1::DataType::kFLOAT);
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::generate_n(bufferCast<float>(*q), qSize, [&]() { return dist(gen); });
+
+        auto seqLengths = toBuffer(mSeqLengths);
+        auto groupOffsets = toBuffer(groups.groupOffsets);
+        auto groupSeqIndices = toBuffer(groups.groupSeqIndices);
+        auto groupPrefixLengths = toBuffer(groups.groupPrefixLengths);
+        auto seqPrefixLengths = toBuffer(groups.seqPrefixLengths);
+
+        tk::CascadeAttentionParams<float> params;
+        params.q = bufferCast<float>(*q);
+        params.seqLengths = bufferCast<SizeType32>(*seqLengths);
+        params.groupOffsets = bufferCast<SizeType32>(*groupOffsets);
+        params.groupSeqIndices = bufferCast<SizeType32>(*groupSeqIndices);
+        params.groupPrefixLengths = bufferCast<SizeType32>(*groupPrefixLengths);
+        params.seqPrefixLengths = bufferCast<SizeType32>(*seqPrefixLengths);
+        params.kvCache = mKvCache;
+        params.partialOut = bufferCast<float>(*partialOut);
+        params.partialLse = bufferCast<float>(*partialLse);
+        params.out = bufferCast<float>(*out);
+        params.numSeqs = mNumSeqs;
+        params.numGroups = groups.getNumGroups();
+        for (SizeType32 gi = 0; gi < groups.getNumGroups(); ++gi)
+        {
+            params.maxGroupSize = std::max(params.maxGroupSize, groups.groupOffsets[gi + 1] - groups.groupOffsets[gi]);
+        }
+        params.numHeads = mNumHeads;
+        params.numKvHeads = mNumKvHeads;
+        params.headSize = mHeadSize;
+        params.qkScale = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+
+        tk::invokeCascadeAttention(params, mStream->get());
+        mStream->synchronize();
+
+        auto const* qPtr = bufferCast<float>(*q);
+        auto const* outPtr = bufferCast<float>(*out);
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 hi = 0; hi < mNumHeads; ++hi)
+            {
+                auto const kvHeadIdx = hi / (mNumHeads / mNumKvHeads);
+                auto const* qRow = qPtr + (si * mNumHeads + hi) * mHeadSize;
+                std::vector<float> scores(mSeqLengths[si]);
+                for (SizeType32 ti = 0; ti < mSeqLengths[si]; ++ti)
+                {
+                    float score{0.f};
+                    for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                    {
+                        score += qRow[ci] * readKv(true, si, kvHeadIdx, ti, ci);
+                    }
+                    scores[ti] = score * params.qkScale;
+                }
+                auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                float sum{0.f};
+                for (auto& score : scores)
+                {
+                    score = std::exp(score - maxScore);
+                    sum += score;
+                }
+                for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                {
+                    float ref{0.f};
+                    for (SizeType32 ti = 0; ti < mSeqLengths[si]; ++ti)
+                    {
+                        ref += scores[ti] / sum * readKv(false, si, kvHeadIdx, ti, ci);
+                    }
+                    EXPECT_NEAR(outPtr[(si * mNumHeads + hi) * mHeadSize + ci], ref, 1e-4f)
+                        << "seq " << si << " head " << hi << " channel " << ci;
+                }
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    TensorPtr mBlockOffsets;
+    TensorPtr mPool;
+    tk::KVBlockArray mKvCache;
+    std::vector<SizeType32> mSeqLengths;
+    SizeType32 mNumSeqs{0};
+
+    SizeType32 const mMaxBlocksPerSeq{8};
+    SizeType32 const mTokensPerBlock{4};
+    SizeType32 const mNumHeads{4};
+    SizeType32 const mNumKvHeads{2};
+    SizeType32 const mHeadSize{16};
+};
+
+TEST_F(CascadeAttentionKernelsTest, GroupsSequencesSharingPrefixBlocks)
+{
+    // Sequences 0, 1 and 3 share blocks 0 and 1, sequences 0 and 3 also share block 2. Sequence 4 shares block 0 but
+    // has no full block before its generated token, sequence 2 shares nothing.
+    initKvCache({{0, 1, 2}, {0, 1}, {}, {0, 1, 2}, {0}}, {13, 12, 20, 30, 4});
+    auto const groups = buildGroups(1);
+
+    ASSERT_EQ(groups.getNumGroups(), 1);
+    EXPECT_EQ(groups.groupOffsets, (std::vector<SizeType32>{0, 3}));
+    EXPECT_EQ(groups.groupSeqIndices, (std::vector<SizeType32>{0, 1, 3}));
+    EXPECT_EQ(groups.groupPrefixLengths, (std::vector<SizeType32>{2 * mTokensPerBlock}));
+    EXPECT_EQ(groups.seqPrefixLengths, (std::vector<SizeType32>{8, 8, 0, 8, 0}));
+
+    auto const longGroups = buildGroups(3);
+    ASSERT_EQ(longGroups.getNumGroups(), 1);
+    EXPECT_EQ(longGroups.groupSeqIndices, (std::vector<SizeType32>{0, 3}));
+    EXPECT_EQ(longGroups.seqPrefixLengths, (std::vector<SizeType32>{12, 0, 0, 12, 0}));
+}
+
+TEST_F(CascadeAttentionKernelsTest, MatchesAttentionOverFullSequence)
+{
+    // Two groups and a sequence without shared prefix, one group has more queries than a prefix block handles.
+    std::vector<std::vector<SizeType32>> kBlocks;
+    std::vector<SizeType32> seqLengths;
+    for (SizeType32 si = 0; si < 11; ++si)
+    {
+        kBlocks.push_back({0, 1, 2});
+        seqLengths.push_back(13 + si);
+    }
+    kBlocks.push_back({3});
+    seqLengths.push_back(9);
+    kBlocks.push_back({3});
+    seqLengths.push_back(6);
+    kBlocks.push_back({});
+    seqLengths.push_back(17);
+    initKvCache(kBlocks, seqLengths);
+
+    auto const groups = buildGroups(1);
+    ASSERT_EQ(groups.getNumGroups(), 2);
+    runAndCompare(groups);
+}
+
+TEST_F(CascadeAttentionKernelsTest, MatchesAttentionWithoutGroups)
+{
+    initKvCache({{0, 1}, {0, 1}, {}}, {10, 1, 23});
+    runAndCompare(tk::SharedPrefixGroups{{0}, {}, {}, {0, 0, 0}});
+}
+
+} // namespace
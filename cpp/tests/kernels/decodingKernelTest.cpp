@@ -21,6 +21,7 @@
 
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/kernels/decodingCommon.h"
+#include "tensorrt_llm/kernels/decodingKernels.h"
 #include "tensorrt_llm/kernels/speculativeDecoding/externalDraftTokensKernels.h"
 #include "tensorrt_llm/kernels/speculativeDecoding/medusaDecodingKernels.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
@@ -736,8 +737,8 @@ public:
             bufferCast<SizeType32>(*mNumsDraftTokens), bufferCast<SizeType32>(*mSequenceLengths),
             reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinishedSteps)),
             reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinishedFinal)),
-            bufferCast<SizeType32>(*mFinishedSum), bufferCast<SizeType32>(*mBatchSlots), mBatchSize, mMaxBatchSize,
-            mBeamWidth, mMaxSeqLen, mMaxDraftTokens, mStream->get());
+            bufferCast<SizeType32>(*mFinishedSum), /* finishedSlots */ nullptr, bufferCast<SizeType32>(*mBatchSlots),
+            mBatchSize, mMaxBatchSize, mBeamWidth, mMaxSeqLen, mMaxDraftTokens, mStream->get());
     }
 
     void callAcceptByLogits()
@@ -1094,3 +1095,261 @@ TYPED_TEST(DecodingKernelsTest, DISABLED_acceptDraftTokensByIdsWithPathsKernelLa
                       .setAcceptMode(AcceptKernelMode::BY_IDS_WITH_PATH));
 }
 } // end of namespace
+
+class InsertUnfinishedPathTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+    }
+
+    void runTest(SizeType32 batchSize, SizeType32 beamWidth, SizeType32 maxSeqLen, SizeType32 seed)
+    {
+        auto const batchBeam = batchSize * beamWidth;
+        auto makeInt = [](std::initializer_list<SizeType32> dims)
+        { return BufferManager::pinned(ITensor::makeShape(dims), nvinfer1::DataType::kINT32); };
+        auto makeFloat = [](std::initializer_list<SizeType32> dims)
+        { return BufferManager::pinned(ITensor::makeShape(dims), nvinfer1::DataType::kFLOAT); };
+
+        auto outputIds = makeInt({batchSize, beamWidth, maxSeqLen});
+        auto parentIds = makeInt({batchSize, beamWidth, maxSeqLen});
+        auto logProbsTiled = makeFloat({maxSeqLen, batchSize, beamWidth});
+        auto sequenceLengths = makeInt({batchSize, beamWidth});
+        auto inputLengths = makeInt({batchSize, beamWidth});
+        auto cumLogProbs = makeFloat({batchSize, beamWidth});
+        auto lengthPenalties = makeFloat({batchSize});
+        auto outputIdsCBA = makeInt({batchSize, beamWidth * 2, maxSeqLen});
+        auto logProbsCBA = makeFloat({batchSize, beamWidth * 2, maxSeqLen});
+        auto sequenceLengthsCBA = makeInt({batchSize, beamWidth * 2});
+        auto cumLogProbsCBA = makeFloat({batchSize, beamWidth * 2});
+        auto normedScoresCBA = makeFloat({batchSize, beamWidth * 2});
+        auto numBeamsCBA = makeInt({batchSize});
+        auto batchDones = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kBOOL);
+
+        auto outputIdsPtr = bufferCast<SizeType32>(*outputIds);
+        auto parentIdsPtr = bufferCast<SizeType32>(*parentIds);
+        auto logProbsTiledPtr = bufferCast<float>(*logProbsTiled);
+        auto sequenceLengthsPtr = bufferCast<SizeType32>(*sequenceLengths);
+        auto numBeamsCBAPtr = bufferCast<SizeType32>(*numBeamsCBA);
+        auto batchDonesPtr = bufferCast<bool>(*batchDones);
+
+        std::mt19937 generator(seed);
+        std::uniform_int_distribution<SizeType32> beamDistr(0, beamWidth - 1);
+        std::uniform_int_distribution<SizeType32> lengthDistr(1, maxSeqLen);
+        std::uniform_int_distribution<SizeType32> numCBADistr(0, beamWidth);
+        std::uniform_real_distribution<float> logProbDistr(-10.f, 0.f);
+        for (SizeType32 i = 0; i < batchBeam * maxSeqLen; ++i)
+        {
+            outputIdsPtr[i] = i;
+            parentIdsPtr[i] = beamDistr(generator);
+            logProbsTiledPtr[i] = logProbDistr(generator);
+        }
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            // All beams of a request have the same length in the work tree
+            auto const length = lengthDistr(generator);
+            for (SizeType32 bm = 0; bm < beamWidth; ++bm)
+            {
+                sequenceLengthsPtr[bi * beamWidth + bm] = length;
+                bufferCast<SizeType32>(*inputLengths)[bi * beamWidth + bm] = 1;
+                bufferCast<float>(*cumLogProbs)[bi * beamWidth + bm] = logProbDistr(generator);
+            }
+            bufferCast<float>(*lengthPenalties)[bi] = 1.f;
+            numBeamsCBAPtr[bi] = numCBADistr(generator);
+            batchDonesPtr[bi] = bi == batchSize - 1 && batchSize > 1;
+        }
+        std::vector<SizeType32> const numBeamsCBARef(numBeamsCBAPtr, numBeamsCBAPtr + batchSize);
+        trk::invokeFill(*outputIdsCBA, int32_t{-1}, *mStream);
+
+        tk::BeamHypotheses bh;
+        bh.nMaxBatchSize = batchSize;
+        bh.nBatchSize = batchSize;
+        bh.nBeamWidth = beamWidth;
+        bh.nMaxSeqLen = maxSeqLen;
+        bh.lengthPenalties = bufferCast<float>(*lengthPenalties);
+        bh.inputLengths = bufferCast<SizeType32>(*inputLengths);
+        bh.logProbsTiled = logProbsTiledPtr;
+        bh.sequenceLengths = sequenceLengthsPtr;
+        bh.cumLogProbs = bufferCast<float>(*cumLogProbs);
+        bh.outputIdsCBA = bufferCast<SizeType32>(*outputIdsCBA);
+        bh.logProbsCBA = bufferCast<float>(*logProbsCBA);
+        bh.sequenceLengthsCBA = bufferCast<SizeType32>(*sequenceLengthsCBA);
+        bh.cumLogProbsCBA = bufferCast<float>(*cumLogProbsCBA);
+        bh.normedScoresCBA = bufferCast<float>(*normedScoresCBA);
+        bh.numBeamsCBA = numBeamsCBAPtr;
+        bh.batchDones = batchDonesPtr;
+        bh.outputIdsUnfinish = outputIdsPtr;
+        bh.parentIdsUnfinish = parentIdsPtr;
+
+        tk::invokeInsertUnfinishedPath(bh, mStream->get());
+        mStream->synchronize();
+
+        auto const outputIdsCBAPtr = bufferCast<SizeType32>(*outputIdsCBA);
+        auto const logProbsCBAPtr = bufferCast<float>(*logProbsCBA);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            if (batchDonesPtr[bi])
+            {
+                EXPECT_EQ(numBeamsCBAPtr[bi], numBeamsCBARef[bi]);
+                continue;
+            }
+            EXPECT_EQ(numBeamsCBAPtr[bi], numBeamsCBARef[bi] + beamWidth);
+            for (SizeType32 bm = 0; bm < beamWidth; ++bm)
+            {
+                auto const dstBeam = bi * beamWidth * 2 + numBeamsCBARef[bi] + bm;
+                auto const step = sequenceLengthsPtr[bi * beamWidth + bm] - 1;
+                EXPECT_EQ(bufferCast<SizeType32>(*sequenceLengthsCBA)[dstBeam], step + 1);
+                // Reference backtrack
+                SizeType32 beam = bm;
+                for (SizeType32 j = step; j >= 0; --j)
+                {
+                    auto const index = (bi * beamWidth + beam) * maxSeqLen + j;
+                    EXPECT_EQ(outputIdsCBAPtr[dstBeam * maxSeqLen + j], outputIdsPtr[index])
+                        << "bi: " << bi << " bm: " << bm << " step: " << j;
+                    EXPECT_EQ(logProbsCBAPtr[dstBeam * maxSeqLen + j],
+                        logProbsTiledPtr[j * batchBeam + bi * beamWidth + beam]);
+                    beam = parentIdsPtr[index];
+                }
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(InsertUnfinishedPathTest, ShortSequences)
+{
+    this->runTest(4, 4, 16, 0);
+}
+
+TEST_F(InsertUnfinishedPathTest, LongSequences)
+{
+    this->runTest(3, 16, 2048, 1);
+}
+
+TEST_F(InsertUnfinishedPathTest, LargeBeam)
+{
+    this->runTest(2, 64, 517, 2);
+}
+
+class AcceptDraftTokensBeamSearchTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        mStream = std::make_shared<tensorrt_llm::runtime::CudaStream>();
+    }
+
+protected:
+    std::shared_ptr<tensorrt_llm::runtime::CudaStream> mStream;
+};
+
+TEST_F(AcceptDraftTokensBeamSearchTest, AcceptsWhileBeamSearchFollowsDrafts)
+{
+    SizeType32 constexpr batchSize{3};
+    SizeType32 constexpr maxBatchSize{2 * batchSize};
+    SizeType32 constexpr beamWidth{3};
+    SizeType32 constexpr vocabSize{16};
+    SizeType32 constexpr vocabSizePadded{20};
+    SizeType32 constexpr maxDraftTokens{4};
+    SizeType32 constexpr maxSeqLen{32};
+    SizeType32 constexpr sequenceLength{5};
+    TokenIdType constexpr endId{0};
+
+    auto makeInt = [](std::initializer_list<SizeType32> dims)
+    { return BufferManager::pinned(ITensor::makeShape(dims), nvinfer1::DataType::kINT32); };
+    auto draftIds = makeInt({maxBatchSize, beamWidth, maxDraftTokens});
+    auto numsDraftTokens = makeInt({maxBatchSize});
+    auto endIds = makeInt({maxBatchSize});
+    auto outputIds = makeInt({maxBatchSize, beamWidth, maxSeqLen});
+    auto parentIds = makeInt({maxBatchSize, beamWidth, maxSeqLen});
+    auto sequenceLengths = makeInt({maxBatchSize, beamWidth});
+    auto acceptedLengths = makeInt({maxBatchSize});
+    auto batchSlots = makeInt({batchSize});
+    auto cumLogProbs = BufferManager::pinned(ITensor::makeShape({maxBatchSize, beamWidth}), nvinfer1::DataType::kFLOAT);
+    auto targetLogits = BufferManager::pinned(
+        ITensor::makeShape({batchSize, maxDraftTokens + 1, beamWidth, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+    auto targetLogitsPtrs = BufferManager::pinned(ITensor::makeShape({batchSize}), TRTDataType<void*>::value);
+
+    auto draftIdsPtr = bufferCast<TokenIdType>(*draftIds);
+    auto logitsPtr = bufferCast<float>(*targetLogits);
+    auto cumLogProbsPtr = bufferCast<float>(*cumLogProbs);
+    auto outputIdsPtr = bufferCast<TokenIdType>(*outputIds);
+    auto sequenceLengthsPtr = bufferCast<SizeType32>(*sequenceLengths);
+    std::fill_n(logitsPtr, targetLogits->getSize(), 0.f);
+    std::fill_n(outputIdsPtr, outputIds->getSize(), -1);
+    std::fill_n(bufferCast<SizeType32>(*parentIds), parentIds->getSize(), -1);
+    std::fill_n(bufferCast<TokenIdType>(*endIds), maxBatchSize, endId);
+    std::fill_n(bufferCast<SizeType32>(*numsDraftTokens), maxBatchSize, maxDraftTokens);
+
+    auto logit = [&](SizeType32 bi, SizeType32 ti, SizeType32 bm, TokenIdType token) -> float&
+    { return logitsPtr[((bi * (maxDraftTokens + 1) + ti) * beamWidth + bm) * vocabSizePadded + token]; };
+    auto draftId = [](SizeType32 bm, SizeType32 ti) { return static_cast<TokenIdType>(1 + (bm + ti) % 15); };
+
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = 2 * bi;
+        bufferCast<SizeType32>(*batchSlots)[bi] = slot;
+        reinterpret_cast<float**>(bufferCast<int64_t>(*targetLogitsPtrs))[bi]
+            = logitsPtr + bi * (maxDraftTokens + 1) * beamWidth * vocabSizePadded;
+        for (SizeType32 bm = 0; bm < beamWidth; ++bm)
+        {
+            cumLogProbsPtr[slot * beamWidth + bm] = -static_cast<float>(bm);
+            sequenceLengthsPtr[slot * beamWidth + bm] = sequenceLength;
+            for (SizeType32 ti = 0; ti < maxDraftTokens; ++ti)
+            {
+                draftIdsPtr[(slot * beamWidth + bm) * maxDraftTokens + ti] = draftId(bm, ti);
+                // The draft token of every beam is the clear favorite of the target model
+                logit(bi, ti, bm, draftId(bm, ti)) = 10.f;
+            }
+        }
+    }
+    // Request 1: at the third draft token, the target model prefers another token for beam 1
+    logit(1, 2, 1, 0) = 12.f;
+    // Request 2: every draft token is the favorite of its beam, but the second best token of beam 0 beats the
+    // extension of beam 2, so beam search would drop beam 2
+    logit(2, 0, 0, draftId(1, 0)) = 9.f;
+
+    tksp::invokeAcceptDraftTokensBeamSearch(draftIdsPtr, bufferCast<SizeType32>(*numsDraftTokens),
+        reinterpret_cast<float const* const*>(bufferCast<int64_t>(*targetLogitsPtrs)),
+        bufferCast<TokenIdType>(*endIds), outputIdsPtr, bufferCast<SizeType32>(*parentIds), cumLogProbsPtr,
+        sequenceLengthsPtr, bufferCast<SizeType32>(*acceptedLengths), bufferCast<SizeType32>(*batchSlots), batchSize,
+        beamWidth, vocabSize, vocabSizePadded, maxDraftTokens, maxSeqLen, mStream->get());
+    mStream->synchronize();
+
+    std::vector<SizeType32> const expectedAccepted{4, 2, 0};
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const slot = 2 * bi;
+        auto const numAccepted = expectedAccepted[bi];
+        EXPECT_EQ(bufferCast<SizeType32>(*acceptedLengths)[slot], numAccepted) << "bi " << bi;
+        for (SizeType32 bm = 0; bm < beamWidth; ++bm)
+        {
+            auto const batchBeamIdx = slot * beamWidth + bm;
+            EXPECT_EQ(sequenceLengthsPtr[batchBeamIdx], sequenceLength + numAccepted);
+            float expectedCumLogProb = -static_cast<float>(bm);
+            for (SizeType32 ti = 0; ti < maxDraftTokens; ++ti)
+            {
+                auto const outIdx = batchBeamIdx * maxSeqLen + sequenceLength + ti;
+                if (ti < numAccepted)
+                {
+                    EXPECT_EQ(outputIdsPtr[outIdx], draftId(bm, ti));
+                    EXPECT_EQ(bufferCast<SizeType32>(*parentIds)[outIdx], bm);
+                    double sumExp = 0.0;
+                    for (TokenIdType token = 0; token < vocabSize; ++token)
+                    {
+                        sumExp += std::exp(static_cast<double>(logit(bi, ti, bm, token)));
+                    }
+                    expectedCumLogProb += logit(bi, ti, bm, draftId(bm, ti)) - static_cast<float>(std::log(sumExp));
+                }
+                else
+                {
+                    EXPECT_EQ(outputIdsPtr[outIdx], -1);
+                }
+            }
+            EXPECT_NEAR(cumLogProbsPtr[batchBeamIdx], expectedCumLogProb, 1e-4f);
+        }
+    }
+}
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
+#include "tensorrt_llm/kernels/lookupKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <exception>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The ranks of the custom all reduce run on the same device, each on its own stream and thread, with plain device
+// buffers standing in for the IPC buffers. Each rank holds a shard of the vocab. The embedding lookup fused into the
+// one-shot and two-shot all reduce must give the result of the unfused path of the lookup plugin: invokeLookUp into
+// an output tensor, then the custom all reduce of that tensor. Each token has a single nonzero row, so both are exact
+// and must match the rows of the full table and of the prompt table on the host.
+class EmbeddingAllReduceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "No CUDA device";
+        }
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        mTable.resize(kVocabSize * kHidden);
+        std::generate(mTable.begin(), mTable.end(), [&]() { return half(dist(gen)); });
+        mPromptTable = BufferManager::pinned(ITensor::makeShape({kNumTasks * kTaskVocabSize, kHidden}),
+            nvinfer1::DataType::kHALF);
+        std::generate_n(bufferCast<half>(*mPromptTable), mPromptTable->getSize(), [&]() { return half(dist(gen)); });
+
+        auto const numTokens = static_cast<SizeType32>(mIds.size());
+        mInputIds = BufferManager::pinned(ITensor::makeShape({numTokens}), nvinfer1::DataType::kINT32);
+        std::copy(mIds.begin(), mIds.end(), bufferCast<std::int32_t>(*mInputIds));
+        mTaskIds = BufferManager::pinned(ITensor::makeShape({numTokens}), nvinfer1::DataType::kINT32);
+        std::copy(mTasks.begin(), mTasks.end(), bufferCast<std::int32_t>(*mTaskIds));
+        mTaskVocabSize = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        *bufferCast<std::int32_t>(*mTaskVocabSize) = kTaskVocabSize;
+    }
+
+    //! \brief Looks up the tokens in `numRanks` vocab shards and all reduces them, fused or with the unfused path.
+    std::vector<std::vector<half>> runLookup(
+        int numRanks, tk::AllReduceStrategyType strategy, bool usePromptTable, bool fused)
+    {
+        auto const numTokens = static_cast<SizeType32>(mIds.size());
+        auto const size = static_cast<std::size_t>(numTokens) * kHidden;
+        auto const localVocabSize = kVocabSize / numRanks;
+        // The flags are sized like those of IpcMemory and start at zero, below the barrier flag
+        auto const numFlags = static_cast<SizeType32>((tk::MAX_ALL_REDUCE_BLOCKS + 1) * numRanks * 2);
+
+        std::vector<std::shared_ptr<CudaStream>> streams;
+        std::vector<std::unique_ptr<BufferManager>> managers;
+        std::vector<IBuffer::SharedPtr> shards, lookups, outputs, commBuffers, barriersIn, barriersOut;
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            streams.push_back(std::make_shared<CudaStream>());
+            managers.push_back(std::make_unique<BufferManager>(streams.back()));
+            auto& manager = *managers.back();
+            auto const shardBegin = mTable.begin() + rank * localVocabSize * kHidden;
+            std::vector<half> const shard(shardBegin, shardBegin + localVocabSize * kHidden);
+            shards.push_back(manager.copyFrom(shard, MemoryType::kGPU));
+            lookups.push_back(manager.gpu(size, nvinfer1::DataType::kHALF));
+            outputs.push_back(manager.gpu(size, nvinfer1::DataType::kHALF));
+            commBuffers.push_back(manager.gpu(size, nvinfer1::DataType::kHALF));
+            barriersIn.push_back(manager.gpu(numFlags, nvinfer1::DataType::kINT32));
+            barriersOut.push_back(manager.gpu(numFlags, nvinfer1::DataType::kINT32));
+            manager.setZero(*barriersIn.back());
+            manager.setZero(*barriersOut.back());
+            streams.back()->synchronize();
+        }
+
+        auto const* promptTable = usePromptTable ? bufferCast<half>(*mPromptTable) : nullptr;
+        std::vector<tk::AllReduceParams> params(numRanks);
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            auto& p = params[rank];
+            p.elts_total = size;
+            p.ranks_per_node = numRanks;
+            p.local_rank = rank;
+            p.barrier_flag = 1;
+            for (int peer = 0; peer < numRanks; ++peer)
+            {
+                p.peer_comm_buffer_ptrs[peer] = commBuffers[peer]->data();
+                p.peer_barrier_ptrs_in[peer] = static_cast<uint32_t*>(barriersIn[peer]->data());
+                p.peer_barrier_ptrs_out[peer] = static_cast<uint32_t*>(barriersOut[peer]->data());
+            }
+            p.local_input_buffer_ptr = lookups[rank]->data();
+            p.local_output_buffer_ptr = outputs[rank]->data();
+            p.fusion_params.hidden_size = kHidden;
+            auto& lookup = p.fusion_params.embedding_lookup;
+            lookup.input_ids = bufferCast<std::int32_t>(*mInputIds);
+            lookup.weight = shards[rank]->data();
+            lookup.vocab_start = rank * localVocabSize;
+            lookup.local_vocab_size = localVocabSize;
+            lookup.prompt_table = promptTable;
+            lookup.tasks = bufferCast<std::int32_t>(*mTaskIds);
+            lookup.task_vocab_size = bufferCast<std::int32_t>(*mTaskVocabSize);
+            lookup.vocab_size = kVocabSize;
+        }
+
+        // The all reduce kernels of the ranks wait for each other, they must be in flight at the same time
+        std::vector<std::exception_ptr> errors(numRanks);
+        std::vector<std::thread> threads;
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            threads.emplace_back(
+                [&, rank]()
+                {
+                    try
+                    {
+                        auto const stream = streams[rank]->get();
+                        if (fused)
+                        {
+                            tk::customAllReduce(params[rank], nvinfer1::DataType::kHALF, strategy,
+                                tk::AllReduceStrategyConfig(0), tk::AllReduceFusionOp::EMBEDDING_LOOKUP, stream);
+                        }
+                        else
+                        {
+                            auto const& lookup = params[rank].fusion_params.embedding_lookup;
+                            tk::invokeLookUp<half, half, int>(bufferCast<half>(*lookups[rank]), lookup.input_ids,
+                                bufferCast<half>(*shards[rank]), numTokens, lookup.vocab_start, localVocabSize,
+                                kHidden, nullptr, stream, promptTable, lookup.tasks, lookup.task_vocab_size,
+                                kVocabSize);
+                            tk::customAllReduce(params[rank], nvinfer1::DataType::kHALF, strategy,
+                                tk::AllReduceStrategyConfig(0), tk::AllReduceFusionOp::NONE, stream);
+                        }
+                        streams[rank]->synchronize();
+                    }
+                    catch (...)
+                    {
+                        errors[rank] = std::current_exception();
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (auto const& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::vector<std::vector<half>> results(numRanks, std::vector<half>(size));
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            managers[rank]->copy(*outputs[rank], results[rank].data());
+            streams[rank]->synchronize();
+        }
+        return results;
+    }
+
+    //! \brief The embedding of each token on the host, the virtual tokens from the prompt table if `usePromptTable`.
+    std::vector<float> referenceLookup(bool usePromptTable) const
+    {
+        std::vector<float> expected(mIds.size() * kHidden, 0.f);
+        for (std::size_t token = 0; token < mIds.size(); ++token)
+        {
+            auto const id = mIds[token];
+            for (SizeType32 h = 0; h < kHidden; ++h)
+            {
+                auto& value = expected[token * kHidden + h];
+                if (id < kVocabSize)
+                {
+                    value = static_cast<float>(mTable[id * kHidden + h]);
+                }
+                else if (usePromptTable)
+                {
+                    auto const row = mTasks[token] * kTaskVocabSize + id - kVocabSize;
+                    value = static_cast<float>(bufferCast<half>(*mPromptTable)[row * kHidden + h]);
+                }
+            }
+        }
+        return expected;
+    }
+
+    static void expectEqual(std::vector<half> const& actual, std::vector<float> const& expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(static_cast<float>(actual[i]), expected[i]) << "index " << i;
+        }
+    }
+
+    static constexpr SizeType32 kHidden{256};
+    static constexpr SizeType32 kVocabSize{40};
+    static constexpr SizeType32 kNumTasks{2};
+    static constexpr SizeType32 kTaskVocabSize{3};
+
+    // Tokens of every shard and virtual tokens of both tasks
+    std::vector<std::int32_t> mIds{0, 39, 12, 40, 42, 5, 41, 21};
+    std::vector<std::int32_t> mTasks{0, 0, 0, 1, 0, 1, 1, 0};
+    std::vector<half> mTable;
+    ITensor::SharedPtr mPromptTable;
+    ITensor::SharedPtr mInputIds;
+    ITensor::SharedPtr mTaskIds;
+    ITensor::SharedPtr mTaskVocabSize;
+};
+
+} // namespace
+
+TEST_F(EmbeddingAllReduceTest, FusedMatchesUnfused)
+{
+    for (int numRanks : {2, 4})
+    {
+        for (auto strategy : {tk::AllReduceStrategyType::ONESHOT, tk::AllReduceStrategyType::TWOSHOT})
+        {
+            for (bool usePromptTable : {false, true})
+            {
+                SCOPED_TRACE(testing::Message() << "ranks " << numRanks << " strategy " << static_cast<int>(strategy)
+                                                << " prompt table " << usePromptTable);
+                auto const expected = referenceLookup(usePromptTable);
+                auto const unfused = runLookup(numRanks, strategy, usePromptTable, false);
+                auto const fused = runLookup(numRanks, strategy, usePromptTable, true);
+                for (int rank = 0; rank < numRanks; ++rank)
+                {
+                    SCOPED_TRACE(rank);
+                    expectEqual(unfused[rank], expected);
+                    expectEqual(fused[rank], expected);
+                }
+            }
+        }
+    }
+}
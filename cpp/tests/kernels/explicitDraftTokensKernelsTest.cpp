@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/speculativeDecoding/explicitDraftTokensKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tksd = tensorrt_llm::kernels::speculative_decoding;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+struct DraftCandidate
+{
+    TokenIdType token;
+    SizeType32 parent;
+    float prob;
+};
+
+class DynamicDraftTreeTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    void buildTree(std::vector<DraftCandidate> const& candidates, SizeType32 numPaths, SizeType32 maxPathLength)
+    {
+        auto const numCandidates = static_cast<SizeType32>(candidates.size());
+        mParams = tksd::BuildDynamicDraftTreeParams{};
+        mParams.batchSize = 1;
+        mParams.maxNumCandidates = numCandidates;
+        mParams.numPaths = numPaths;
+        mParams.maxPathLength = maxPathLength;
+        auto const maxDecodingTokens = mParams.getMaxDecodingTokens();
+        mNumPackedMasks = static_cast<SizeType32>(tc::divUp(maxDecodingTokens, 32));
+
+        mCandidateTokens = BufferManager::pinned(ITensor::makeShape({numCandidates}), nvinfer1::DataType::kINT32);
+        mCandidateParents = BufferManager::pinned(ITensor::makeShape({numCandidates}), nvinfer1::DataType::kINT32);
+        mCandidateLogProbs = BufferManager::pinned(ITensor::makeShape({numCandidates}), nvinfer1::DataType::kFLOAT);
+        mNumCandidates = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        mGoldenTokens = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        for (SizeType32 ci = 0; ci < numCandidates; ++ci)
+        {
+            bufferCast<TokenIdType>(*mCandidateTokens)[ci] = candidates[ci].token;
+            bufferCast<SizeType32>(*mCandidateParents)[ci] = candidates[ci].parent;
+            bufferCast<float>(*mCandidateLogProbs)[ci] = std::log(candidates[ci].prob);
+        }
+        bufferCast<SizeType32>(*mNumCandidates)[0] = numCandidates;
+        bufferCast<TokenIdType>(*mGoldenTokens)[0] = mGoldenToken;
+
+        mFlatTokens = BufferManager::pinned(ITensor::makeShape({maxDecodingTokens}), nvinfer1::DataType::kINT32);
+        mDraftTokens = BufferManager::pinned(ITensor::makeShape({numPaths, maxPathLength}), nvinfer1::DataType::kINT32);
+        mDraftIndices
+            = BufferManager::pinned(ITensor::makeShape({numPaths, maxPathLength}), nvinfer1::DataType::kINT32);
+        mPositionOffsets = BufferManager::pinned(ITensor::makeShape({maxDecodingTokens}), nvinfer1::DataType::kINT32);
+        mPackedMask = BufferManager::pinned(
+            ITensor::makeShape({maxDecodingTokens, mNumPackedMasks}), nvinfer1::DataType::kINT32);
+        mGenerationLengths = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+
+        mParams.candidateTokens = bufferCast<TokenIdType>(*mCandidateTokens);
+        mParams.candidateParents = bufferCast<SizeType32>(*mCandidateParents);
+        mParams.candidateLogProbs = bufferCast<float>(*mCandidateLogProbs);
+        mParams.numCandidates = bufferCast<SizeType32>(*mNumCandidates);
+        mParams.goldenTokens = bufferCast<TokenIdType>(*mGoldenTokens);
+        mParams.outputFlatTokens = bufferCast<TokenIdType>(*mFlatTokens);
+        mParams.outputDraftTokens = bufferCast<TokenIdType>(*mDraftTokens);
+        mParams.outputDraftIndices = bufferCast<SizeType32>(*mDraftIndices);
+        mParams.outputPositionOffsets = bufferCast<SizeType32>(*mPositionOffsets);
+        mParams.outputPackedMask = bufferCast<std::int32_t>(*mPackedMask);
+        mParams.outputGenerationLengths = bufferCast<SizeType32>(*mGenerationLengths);
+
+        tksd::invokeBuildDynamicDraftTree(mParams, mStream->get());
+        mStream->synchronize();
+    }
+
+    [[nodiscard]] std::vector<TokenIdType> getFlatTokens() const
+    {
+        auto const* ptr = bufferCast<TokenIdType>(*mFlatTokens);
+        return {ptr, ptr + getGenerationLength()};
+    }
+
+    [[nodiscard]] std::vector<SizeType32> getPositionOffsets() const
+    {
+        auto const* ptr = bufferCast<SizeType32>(*mPositionOffsets);
+        return {ptr, ptr + getGenerationLength()};
+    }
+
+    [[nodiscard]] SizeType32 getGenerationLength() const
+    {
+        return bufferCast<SizeType32>(*mGenerationLengths)[0];
+    }
+
+    [[nodiscard]] std::vector<TokenIdType> getPathTokens(SizeType32 pathIdx) const
+    {
+        auto const* ptr = bufferCast<TokenIdType>(*mDraftTokens) + pathIdx * mParams.maxPathLength;
+        return {ptr, ptr + mParams.maxPathLength};
+    }
+
+    [[nodiscard]] std::vector<SizeType32> getPathIndices(SizeType32 pathIdx) const
+    {
+        auto const* ptr = bufferCast<SizeType32>(*mDraftIndices) + pathIdx * mParams.maxPathLength;
+        return {ptr, ptr + mParams.maxPathLength};
+    }
+
+    //! Tokens attended by token `tokenIdx` of the tree
+    [[nodiscard]] std::vector<SizeType32> getMaskRow(SizeType32 tokenIdx) const
+    {
+        auto const* row = bufferCast<std::int32_t>(*mPackedMask) + tokenIdx * mNumPackedMasks;
+        std::vector<SizeType32> attended;
+        for (SizeType32 ti = 0; ti < mParams.getMaxDecodingTokens(); ++ti)
+        {
+            if ((static_cast<std::uint32_t>(row[ti / 32]) >> (ti % 32)) & 1u)
+            {
+                attended.push_back(ti);
+            }
+        }
+        return attended;
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    tksd::BuildDynamicDraftTreeParams mParams;
+    SizeType32 mNumPackedMasks{0};
+    TokenIdType const mGoldenToken{7};
+
+    TensorPtr mCandidateTokens;
+    TensorPtr mCandidateParents;
+    TensorPtr mCandidateLogProbs;
+    TensorPtr mNumCandidates;
+    TensorPtr mGoldenTokens;
+    TensorPtr mFlatTokens;
+    TensorPtr mDraftTokens;
+    TensorPtr mDraftIndices;
+    TensorPtr mPositionOffsets;
+    TensorPtr mPackedMask;
+    TensorPtr mGenerationLengths;
+};
+
+// Candidates of the draft head: c0 and c1 grow from the golden token, c6 is beyond depth 3
+std::vector<DraftCandidate> const kCandidates{
+    {10, -1, 0.6F}, {11, -1, 0.3F}, {12, 0, 0.9F}, {13, 0, 0.05F}, {14, 2, 0.8F}, {15, 1, 0.5F}, {16, 4, 0.9F}};
+
+TEST_F(DynamicDraftTreeTest, TreeOrderedByScore)
+{
+    buildTree(kCandidates, 3, 4);
+
+    EXPECT_EQ(getGenerationLength(), 7);
+    EXPECT_EQ(getFlatTokens(), (std::vector<TokenIdType>{7, 10, 12, 14, 11, 15, 13}));
+    EXPECT_EQ(getPositionOffsets(), (std::vector<SizeType32>{0, 1, 2, 3, 1, 2, 2}));
+
+    EXPECT_EQ(getPathTokens(0), (std::vector<TokenIdType>{7, 10, 12, 14}));
+    EXPECT_EQ(getPathIndices(0), (std::vector<SizeType32>{0, 1, 2, 3}));
+    EXPECT_EQ(getPathTokens(1), (std::vector<TokenIdType>{7, 11, 15, -1}));
+    EXPECT_EQ(getPathIndices(1), (std::vector<SizeType32>{0, 4, 5, -1}));
+    EXPECT_EQ(getPathTokens(2), (std::vector<TokenIdType>{7, 10, 13, -1}));
+    EXPECT_EQ(getPathIndices(2), (std::vector<SizeType32>{0, 1, 6, -1}));
+
+    std::vector<std::vector<SizeType32>> const expectedMask{
+        {0}, {0, 1}, {0, 1, 2}, {0, 1, 2, 3}, {0, 4}, {0, 4, 5}, {0, 1, 6}};
+    for (SizeType32 ti = 0; ti < getGenerationLength(); ++ti)
+    {
+        EXPECT_EQ(getMaskRow(ti), expectedMask[ti]) << "token " << ti;
+    }
+}
+
+TEST_F(DynamicDraftTreeTest, BudgetLimitsTokens)
+{
+    // 4 draft tokens up to depth 2: the 4 best candidates c0, c2, c1, c5
+    buildTree(kCandidates, 2, 3);
+
+    EXPECT_EQ(getGenerationLength(), 5);
+    EXPECT_EQ(getFlatTokens(), (std::vector<TokenIdType>{7, 10, 12, 11, 15}));
+    EXPECT_EQ(getPositionOffsets(), (std::vector<SizeType32>{0, 1, 2, 1, 2}));
+    EXPECT_EQ(getPathTokens(0), (std::vector<TokenIdType>{7, 10, 12}));
+    EXPECT_EQ(getPathIndices(0), (std::vector<SizeType32>{0, 1, 2}));
+    EXPECT_EQ(getPathTokens(1), (std::vector<TokenIdType>{7, 11, 15}));
+    EXPECT_EQ(getPathIndices(1), (std::vector<SizeType32>{0, 3, 4}));
+}
+
+TEST_F(DynamicDraftTreeTest, LeavesBeyondPathsAreDropped)
+{
+    // 4 leaves selected for 2 paths, only the 2 best leaves are kept
+    std::vector<DraftCandidate> const candidates{
+        {10, -1, 0.4F}, {11, -1, 0.3F}, {12, -1, 0.2F}, {13, -1, 0.1F}, {14, 0, 0.1F}};
+    buildTree(candidates, 2, 3);
+
+    EXPECT_EQ(getGenerationLength(), 3);
+    EXPECT_EQ(getFlatTokens(), (std::vector<TokenIdType>{7, 10, 11}));
+    EXPECT_EQ(getPathTokens(0), (std::vector<TokenIdType>{7, 10, -1}));
+    EXPECT_EQ(getPathIndices(0), (std::vector<SizeType32>{0, 1, -1}));
+    EXPECT_EQ(getPathTokens(1), (std::vector<TokenIdType>{7, 11, -1}));
+    EXPECT_EQ(getPathIndices(1), (std::vector<SizeType32>{0, 2, -1}));
+    EXPECT_EQ(getMaskRow(2), (std::vector<SizeType32>{0, 2}));
+}
+
+} // namespace
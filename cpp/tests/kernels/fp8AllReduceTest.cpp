@@ -0,0 +1,254 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/customAllReduceKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <random>
+#include <thread>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The ranks of the one-shot custom all reduce run on the same device, each on its own stream and thread, with plain
+// device buffers standing in for the IPC buffers. The uncompressed one-shot kernel is the reference: it must match the
+// sum of the inputs on the host, and the FP8 compressed kernel must match it within the error of quantizing each rank
+// to E4M3 with one scale per 128 elements. All ranks must produce the same compressed result.
+class Fp8AllReduceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+#ifndef ENABLE_FP8
+        GTEST_SKIP() << "The FP8 compressed all reduce requires ENABLE_FP8";
+#else
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "No CUDA device";
+        }
+#endif
+    }
+
+    //! \brief Inputs of `size` elements for each of `numRanks` ranks, with a magnitude varying per scale block.
+    static std::vector<std::vector<half>> makeInputs(int numRanks, std::size_t size)
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::vector<std::vector<half>> inputs(numRanks, std::vector<half>(size));
+        for (auto& input : inputs)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                input[i] = half(dist(gen) * std::ldexp(1.f, static_cast<int>(i / kScaleBlock % 5) - 2));
+            }
+        }
+        return inputs;
+    }
+
+    //! \brief Runs the one-shot all reduce of `inputs` with `config`, returns the output of each rank.
+    std::vector<std::vector<float>> runAllReduce(
+        std::vector<std::vector<half>> const& inputs, tk::AllReduceStrategyConfig config)
+    {
+        auto const numRanks = static_cast<int>(inputs.size());
+        auto const size = inputs.front().size();
+        // The flags are sized like those of IpcMemory and start at zero, below the barrier flag
+        auto const numFlags = static_cast<SizeType32>((tk::MAX_ALL_REDUCE_BLOCKS + 1) * numRanks * 2);
+
+        std::vector<std::shared_ptr<CudaStream>> streams;
+        std::vector<std::unique_ptr<BufferManager>> managers;
+        std::vector<IBuffer::SharedPtr> inputBuffers, outputBuffers, commBuffers, barriersIn, barriersOut;
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            streams.push_back(std::make_shared<CudaStream>());
+            managers.push_back(std::make_unique<BufferManager>(streams.back()));
+            auto& manager = *managers.back();
+            inputBuffers.push_back(manager.copyFrom(inputs[rank], MemoryType::kGPU));
+            outputBuffers.push_back(manager.gpu(size, nvinfer1::DataType::kHALF));
+            commBuffers.push_back(manager.gpu(size, nvinfer1::DataType::kHALF));
+            barriersIn.push_back(manager.gpu(numFlags, nvinfer1::DataType::kINT32));
+            barriersOut.push_back(manager.gpu(numFlags, nvinfer1::DataType::kINT32));
+            manager.setZero(*barriersIn.back());
+            manager.setZero(*barriersOut.back());
+            streams.back()->synchronize();
+        }
+
+        std::vector<tk::AllReduceParams> params(numRanks);
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            auto& p = params[rank];
+            p.elts_total = size;
+            p.ranks_per_node = numRanks;
+            p.local_rank = rank;
+            p.barrier_flag = 1;
+            for (int peer = 0; peer < numRanks; ++peer)
+            {
+                p.peer_comm_buffer_ptrs[peer] = commBuffers[peer]->data();
+                p.peer_barrier_ptrs_in[peer] = static_cast<uint32_t*>(barriersIn[peer]->data());
+                p.peer_barrier_ptrs_out[peer] = static_cast<uint32_t*>(barriersOut[peer]->data());
+            }
+            p.local_input_buffer_ptr = inputBuffers[rank]->data();
+            p.local_output_buffer_ptr = outputBuffers[rank]->data();
+        }
+
+        // The one-shot kernels of the ranks wait for each other, they must be in flight at the same time
+        std::vector<std::exception_ptr> errors(numRanks);
+        std::vector<std::thread> threads;
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            threads.emplace_back(
+                [&, rank]()
+                {
+                    try
+                    {
+                        tk::customAllReduce(params[rank], nvinfer1::DataType::kHALF, tk::AllReduceStrategyType::ONESHOT,
+                            config, tk::AllReduceFusionOp::NONE, streams[rank]->get());
+                        streams[rank]->synchronize();
+                    }
+                    catch (...)
+                    {
+                        errors[rank] = std::current_exception();
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (auto const& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+
+        std::vector<std::vector<float>> outputs;
+        for (int rank = 0; rank < numRanks; ++rank)
+        {
+            std::vector<half> output(size);
+            managers[rank]->copy(*outputBuffers[rank], output.data());
+            streams[rank]->synchronize();
+            outputs.emplace_back(output.begin(), output.end());
+        }
+        return outputs;
+    }
+
+    //! \brief The sum of the inputs in fp32 on the host.
+    static std::vector<float> referenceSum(std::vector<std::vector<half>> const& inputs)
+    {
+        std::vector<float> sum(inputs.front().size(), 0.f);
+        for (auto const& input : inputs)
+        {
+            for (std::size_t i = 0; i < sum.size(); ++i)
+            {
+                sum[i] += static_cast<float>(input[i]);
+            }
+        }
+        return sum;
+    }
+
+    //! \brief Bound of the error of quantizing each rank to E4M3 with one scale per block of `inputs`.
+    static std::vector<float> quantizationTolerance(std::vector<std::vector<half>> const& inputs)
+    {
+        auto const size = inputs.front().size();
+        std::vector<float> tolerance(size, 0.f);
+        for (auto const& input : inputs)
+        {
+            for (std::size_t block = 0; block < size; block += kScaleBlock)
+            {
+                float amax = 0.f;
+                for (std::size_t i = block; i < block + kScaleBlock; ++i)
+                {
+                    amax = std::max(amax, std::abs(static_cast<float>(input[i])));
+                }
+                float const scale = amax / 448.f;
+                for (std::size_t i = block; i < block + kScaleBlock; ++i)
+                {
+                    // Half an ulp of the 3 bit mantissa, or of the smallest subnormal 2^-9
+                    tolerance[i] += std::abs(static_cast<float>(input[i])) / 16.f + scale / 512.f;
+                }
+            }
+        }
+        return tolerance;
+    }
+
+    static void expectNear(std::vector<float> const& actual, std::vector<float> const& expected, float relTol)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i)
+        {
+            ASSERT_NEAR(actual[i], expected[i], relTol * std::max(1.f, std::abs(expected[i]))) << "index " << i;
+        }
+    }
+
+    static constexpr std::size_t kScaleBlock{128};
+};
+
+} // namespace
+
+TEST_F(Fp8AllReduceTest, CompressedMatchesOneShot)
+{
+    for (int numRanks : {2, 4})
+    {
+        // A single block, several blocks, and several blocks with several iterations each
+        for (std::size_t size : {kScaleBlock * 8, kScaleBlock * 96, kScaleBlock * 512})
+        {
+            SCOPED_TRACE(testing::Message() << "ranks " << numRanks << " size " << size);
+            auto const inputs = makeInputs(numRanks, size);
+            auto const expected = referenceSum(inputs);
+            auto const reference = runAllReduce(inputs, static_cast<tk::AllReduceStrategyConfig>(0));
+            auto const compressed = runAllReduce(inputs, tk::AllReduceStrategyConfig::FP8_COMPRESSION);
+            auto const tolerance = quantizationTolerance(inputs);
+
+            bool quantized = false;
+            for (int rank = 0; rank < numRanks; ++rank)
+            {
+                expectNear(reference[rank], expected, 1e-3f);
+                ASSERT_EQ(compressed[rank], compressed.front()) << "rank " << rank;
+                for (std::size_t i = 0; i < size; ++i)
+                {
+                    // The output is rounded to half after the sum
+                    auto const bound = tolerance[i] + std::abs(reference[rank][i]) / 1024.f + 1e-6f;
+                    ASSERT_NEAR(compressed[rank][i], reference[rank][i], bound) << "rank " << rank << " index " << i;
+                    quantized |= compressed[rank][i] != reference[rank][i];
+                }
+            }
+            // The inputs do not all fit E4M3, the compressed path must have been taken
+            EXPECT_TRUE(quantized);
+        }
+    }
+}
+
+TEST_F(Fp8AllReduceTest, PartialScaleBlockIsNotCompressed)
+{
+    // A multiple of the 16 bytes the one-shot kernel takes, but not of the scale block
+    auto const inputs = makeInputs(2, kScaleBlock * 8 + 8);
+    auto const reference = runAllReduce(inputs, static_cast<tk::AllReduceStrategyConfig>(0));
+    auto const compressed = runAllReduce(inputs, tk::AllReduceStrategyConfig::FP8_COMPRESSION);
+    EXPECT_EQ(compressed, reference);
+}
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#ifdef ENABLE_FP8
+#include <cuda_fp8.h>
+#endif
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+#ifdef ENABLE_FP8
+
+// Compares the Q that QKV preprocessing quantizes for paged fp8 FMHA to the Q of the unfused path, which keeps Q in T
+// and dequantizes the fp8 kv cache instead: the fp8 Q has to be the unfused Q times the dequantization scale of the
+// cache, saturated to the fp8 range.
+class Fp8FmhaQuantizeQTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! \brief Runs QKV preprocessing on a copy of `qkv`, writing Q to `q` in T, or in fp8 if `quantizedFp8Output`.
+    void runPreprocessing(ITensor const& qkv, IBuffer& q, bool quantizedFp8Output)
+    {
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto qkvCopy = BufferManager::pinned(qkv.getShape(), nvinfer1::DataType::kFLOAT);
+        std::copy_n(bufferCast<float>(qkv), qkv.getSize(), bufferCast<float>(*qkvCopy));
+        auto kvCache = BufferManager::pinned(
+            ITensor::makeShape({2, mSeqLength, tokenSize}), nvinfer1::DataType::kFP8);
+        auto seqLengths = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*seqLengths)[0] = mSeqLength;
+        auto cuSeqLengths = BufferManager::pinned(ITensor::makeShape({2}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*cuSeqLengths)[0] = 0;
+        bufferCast<int>(*cuSeqLengths)[1] = mSeqLength;
+        auto scales = BufferManager::pinned(ITensor::makeShape({4}), nvinfer1::DataType::kFLOAT);
+        auto* scalesPtr = bufferCast<float>(*scales);
+        scalesPtr[0] = 1.f / mKvScaleQuantOrig;
+        scalesPtr[1] = mKvScaleQuantOrig;
+        scalesPtr[2] = mOutputScale;
+        scalesPtr[3] = 0.f;
+
+        tk::QKVPreprocessingParams<float, tk::KVLinearBuffer> params;
+        params.QKV = bufferCast<float>(*qkvCopy);
+        params.Q = static_cast<float*>(q.data());
+        params.kv_cache_buffer = tk::KVLinearBuffer(1, mSeqLength, tokenSize * static_cast<int>(sizeof(int8_t)),
+            mSeqLength, 0, false, reinterpret_cast<int8_t*>(kvCache->data()));
+        params.seq_lens = bufferCast<int>(*seqLengths);
+        params.cache_seq_lens = bufferCast<int>(*seqLengths);
+        params.cu_seq_lens = bufferCast<int>(*cuSeqLengths);
+        params.kvScaleOrigQuant = scalesPtr;
+        params.kvScaleQuantOrig = scalesPtr + 1;
+        params.fmha_output_scale = scalesPtr + 2;
+        params.fmha_bmm2_scale = scalesPtr + 3;
+        params.batch_size = 1;
+        params.max_input_seq_len = mSeqLength;
+        params.max_kv_seq_len = mSeqLength;
+        params.cyclic_kv_cache_len = mSeqLength;
+        params.token_num = mSeqLength;
+        params.head_num = mNumHeads;
+        params.kv_head_num = mNumKvHeads;
+        params.qheads_per_kv_head = mNumHeads / mNumKvHeads;
+        params.size_per_head = mHeadSize;
+        params.position_embedding_type = tk::PositionEmbeddingType::kLEARNED_ABSOLUTE;
+        params.cache_type = tk::KvCacheDataType::FP8;
+        params.enable_paged_kv_fmha = true;
+        params.quantized_fp8_output = quantizedFp8Output;
+        params.multi_processor_count = tc::getMultiProcessorCount();
+
+        tk::invokeQKVPreprocessing(params, mStream->get());
+        mStream->synchronize();
+        mBmm2Scale = scalesPtr[3];
+    }
+
+    void runTest()
+    {
+        auto const qSize = mSeqLength * mNumHeads * mHeadSize;
+        auto const qkvSize = mSeqLength * (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-mMaxValue, mMaxValue);
+        auto qkv = BufferManager::pinned(ITensor::makeShape({qkvSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*qkv), qkvSize, [&]() { return dist(gen); });
+
+        auto reference = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+        runPreprocessing(*qkv, *reference, false);
+        auto quantized = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFP8);
+        runPreprocessing(*qkv, *quantized, true);
+
+        EXPECT_FLOAT_EQ(mBmm2Scale, mOutputScale * mKvScaleQuantOrig);
+
+        constexpr float kFp8Max = 448.f;
+        auto const* qRef = bufferCast<float>(*reference);
+        auto const* qFp8 = static_cast<__nv_fp8_e4m3 const*>(quantized->data());
+        for (int i = 0; i < qSize; ++i)
+        {
+            auto const out = static_cast<float>(qFp8[i]);
+            auto const expected = std::clamp(qRef[i] * mKvScaleQuantOrig, -kFp8Max, kFp8Max);
+            ASSERT_TRUE(std::isfinite(out)) << "index " << i;
+            // The e4m3 mantissa has 3 bits.
+            EXPECT_NEAR(out, expected, std::abs(expected) / 16.f + 1e-2f) << "index " << i;
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+
+    int mSeqLength{13};
+    int mNumHeads{4};
+    int mNumKvHeads{2};
+    int mHeadSize{64};
+    float mMaxValue{4.f};
+    float mKvScaleQuantOrig{0.5f};
+    float mOutputScale{2.f};
+    float mBmm2Scale{0.f};
+};
+
+TEST_F(Fp8FmhaQuantizeQTest, ScaleBelowOne)
+{
+    runTest();
+}
+
+TEST_F(Fp8FmhaQuantizeQTest, ScaleAboveOneSaturates)
+{
+    // Most scaled values exceed the fp8 range.
+    mMaxValue = 300.f;
+    mKvScaleQuantOrig = 8.f;
+    runTest();
+}
+
+#endif // ENABLE_FP8
+
+} // namespace
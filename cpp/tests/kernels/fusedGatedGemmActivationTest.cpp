@@ -0,0 +1,170 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/fused_gated_gemm/fused_gated_gemm.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#ifdef ENABLE_FP8
+#include <cuda_fp8.h>
+#endif
+
+namespace tc = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::cutlass_extensions;
+namespace tcutlass = tensorrt_llm::kernels::cutlass_kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+#ifdef ENABLE_FP8
+
+// The fused gated GEMM computes scale_output * (scale_d0 * x W_up^T) * act(scale_d1 * x W_gate^T) in fp8, where the
+// weight is [2 * n, k] with the up rows first. For each gate activation it must match the unfused path on the host: the
+// GEMM of the fp8 inputs in fp32, then the activation and the product, within the rounding of the fp8 output. Both the
+// pingpong (64 rows) and the cooperative (128 rows) kernels are covered.
+class FusedGatedGemmActivationTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || tc::getSMVersion() != 90)
+        {
+            GTEST_SKIP() << "The fused gated GEMM requires SM90";
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> inputDist(-1.f, 1.f);
+        std::uniform_real_distribution<float> weightDist(-0.25f, 0.25f);
+        mInput.resize(kM * kK);
+        std::generate(mInput.begin(), mInput.end(), [&]() { return __nv_fp8_e4m3(inputDist(gen)); });
+        mWeight.resize(2 * kN * kK);
+        std::generate(mWeight.begin(), mWeight.end(), [&]() { return __nv_fp8_e4m3(weightDist(gen)); });
+    }
+
+    //! \brief Runs the fused gated GEMM with `activation` and `config`, returns the [m, n] output as floats.
+    std::vector<float> runGemm(tcutlass::GatedActivationType activation, tkc::CutlassGemmConfig const& config)
+    {
+        tcutlass::CutlassFusedGatedGemmRunner<__nv_fp8_e4m3> runner(activation);
+        auto input = mManager->copyFrom(mInput, MemoryType::kGPU);
+        auto weight = mManager->copyFrom(mWeight, MemoryType::kGPU);
+        auto output = mManager->gpu(kM * kN, nvinfer1::DataType::kFP8);
+        auto const workspaceBytes = runner.getWorkspaceSize(kM, 2 * kN, kK);
+        auto workspace = mManager->gpu(std::max<std::size_t>(workspaceBytes, 1), nvinfer1::DataType::kINT8);
+
+        runner.gemm(output->data(), input->data(), weight->data(), nullptr, tc::QuantMode{}, kM, 2 * kN, kK, kScaleD0,
+            kScaleD1, kScaleOutput, config, static_cast<char*>(workspace->data()), workspaceBytes, mStream->get());
+
+        std::vector<__nv_fp8_e4m3> result(kM * kN);
+        mManager->copy(*output, result.data());
+        mStream->synchronize();
+        std::vector<float> values(result.size());
+        std::transform(result.begin(), result.end(), values.begin(),
+            [](__nv_fp8_e4m3 v) { return static_cast<float>(v); });
+        return values;
+    }
+
+    //! \brief The activation of the gate on the host, with the tanh approximation for GELU like GELU_taylor.
+    static float activate(tcutlass::GatedActivationType activation, float x)
+    {
+        switch (activation)
+        {
+        case tcutlass::GatedActivationType::kSilu: return x / (1.f + std::exp(-x));
+        case tcutlass::GatedActivationType::kGelu:
+            return 0.5f * x * (1.f + std::tanh(0.7978845608f * (x + 0.044715f * x * x * x)));
+        case tcutlass::GatedActivationType::kRelu: return std::max(x, 0.f);
+        case tcutlass::GatedActivationType::kSquaredRelu: return std::max(x, 0.f) * std::max(x, 0.f);
+        }
+        return x;
+    }
+
+    //! \brief The unfused GEMM and gating on the host in fp32, [m, n].
+    std::vector<float> referenceGemm(tcutlass::GatedActivationType activation) const
+    {
+        std::vector<float> expected(kM * kN);
+        for (int m = 0; m < kM; ++m)
+        {
+            for (int n = 0; n < kN; ++n)
+            {
+                float up = 0.f;
+                float gate = 0.f;
+                for (int k = 0; k < kK; ++k)
+                {
+                    auto const x = static_cast<float>(mInput[m * kK + k]);
+                    up += x * static_cast<float>(mWeight[n * kK + k]);
+                    gate += x * static_cast<float>(mWeight[(kN + n) * kK + k]);
+                }
+                expected[m * kN + n] = kScaleOutput * (kScaleD0 * up) * activate(activation, kScaleD1 * gate);
+            }
+        }
+        return expected;
+    }
+
+    static constexpr int kM{48};
+    static constexpr int kN{256};
+    static constexpr int kK{512};
+    static constexpr float kScaleD0{1.f};
+    static constexpr float kScaleD1{0.5f};
+    static constexpr float kScaleOutput{0.5f};
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::vector<__nv_fp8_e4m3> mInput;
+    std::vector<__nv_fp8_e4m3> mWeight;
+};
+
+#endif // ENABLE_FP8
+
+} // namespace
+
+#ifdef ENABLE_FP8
+
+TEST_F(FusedGatedGemmActivationTest, MatchesUnfused)
+{
+    for (auto const activation : {tcutlass::GatedActivationType::kSilu, tcutlass::GatedActivationType::kGelu,
+             tcutlass::GatedActivationType::kRelu, tcutlass::GatedActivationType::kSquaredRelu})
+    {
+        SCOPED_TRACE(static_cast<int>(activation));
+        auto const expected = referenceGemm(activation);
+        for (auto const tile :
+            {tkc::CutlassTileConfigSM90::CtaShape64x16x128B, tkc::CutlassTileConfigSM90::CtaShape128x32x128B})
+        {
+            SCOPED_TRACE(static_cast<int>(tile));
+            tkc::CutlassGemmConfig const config(tile, tkc::MainloopScheduleType::AUTO, tkc::EpilogueScheduleType::AUTO,
+                tkc::ClusterShape::ClusterShape_1x1x1);
+            auto const output = runGemm(activation, config);
+            ASSERT_EQ(output.size(), expected.size());
+            for (std::size_t i = 0; i < output.size(); ++i)
+            {
+                // Half an ulp of the 3 bit mantissa of the output, and the order of the fp32 accumulation
+                auto const bound = std::abs(expected[i]) / 16.f + 1e-2f;
+                ASSERT_NEAR(output[i], expected[i], bound) << "index " << i;
+            }
+        }
+    }
+}
+
+#endif // ENABLE_FP8
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/fusedNormKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::kernels;
+namespace tc = tensorrt_llm::common;
+
+namespace
+{
+auto constexpr kTokens = 5;
+auto constexpr kEps = 1e-5f;
+
+ITensor::SharedPtr randomTensor(std::mt19937& gen, ITensor::Shape const& shape, float low, float high)
+{
+    auto tensor = BufferManager::pinned(shape, nvinfer1::DataType::kFLOAT);
+    std::uniform_real_distribution<float> dist(low, high);
+    auto* data = bufferCast<float>(*tensor);
+    std::generate(data, data + tensor->getSize(), [&]() { return dist(gen); });
+    return tensor;
+}
+
+//! LayerNorm of input + residual with per-tensor int8 quantization, checked against a host reference.
+void testAddLayerNorm(SizeType32 hidden)
+{
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager(stream);
+
+    std::mt19937 gen(hidden);
+    auto const rowsShape = ITensor::makeShape({kTokens, hidden});
+    auto input = randomTensor(gen, rowsShape, -4.f, 4.f);
+    auto residual = randomTensor(gen, rowsShape, -1.f, 1.f);
+    auto gamma = randomTensor(gen, ITensor::makeShape({hidden}), 0.5f, 1.5f);
+    auto beta = randomTensor(gen, ITensor::makeShape({hidden}), -0.5f, 0.5f);
+    auto scale = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kFLOAT);
+    // Normalized values stay within about +-8
+    *bufferCast<float>(*scale) = 127.f / 8.f;
+
+    auto inputDevice = manager.copyFrom(*input, MemoryType::kGPU);
+    auto residualDevice = manager.copyFrom(*residual, MemoryType::kGPU);
+    auto gammaDevice = manager.copyFrom(*gamma, MemoryType::kGPU);
+    auto betaDevice = manager.copyFrom(*beta, MemoryType::kGPU);
+    auto scaleDevice = manager.copyFrom(*scale, MemoryType::kGPU);
+    auto sumDevice = manager.gpu(rowsShape, nvinfer1::DataType::kFLOAT);
+    auto outDevice = manager.gpu(rowsShape, nvinfer1::DataType::kFLOAT);
+    auto quantizedDevice = manager.gpu(rowsShape, nvinfer1::DataType::kINT8);
+
+    FusedNormParams<float, std::int8_t> params;
+    params.norm_type = NormType::LAYERNORM;
+    params.eps = kEps;
+    params.tokens = kTokens;
+    params.hidden_dim = hidden;
+    params.input = bufferCast<float>(*inputDevice);
+    params.residual = bufferCast<float>(*residualDevice);
+    params.residual_out = bufferCast<float>(*sumDevice);
+    params.gamma = bufferCast<float>(*gammaDevice);
+    params.beta = bufferCast<float>(*betaDevice);
+    params.out = bufferCast<float>(*outDevice);
+    params.out_quant = bufferCast<std::int8_t>(*quantizedDevice);
+    params.scale_orig_quant_per_tensor = bufferCast<float>(*scaleDevice);
+    invokeFusedAddNorm(params, stream->get());
+
+    auto sumHost = manager.copyFrom(*sumDevice, MemoryType::kCPU);
+    auto outHost = manager.copyFrom(*outDevice, MemoryType::kCPU);
+    auto quantizedHost = manager.copyFrom(*quantizedDevice, MemoryType::kCPU);
+    stream->synchronize();
+
+    auto const* in = bufferCast<float>(*input);
+    auto const* res = bufferCast<float>(*residual);
+    auto const* g = bufferCast<float>(*gamma);
+    auto const* b = bufferCast<float>(*beta);
+    auto const s = *bufferCast<float>(*scale);
+    auto const* sum = bufferCast<float>(*sumHost);
+    auto const* out = bufferCast<float>(*outHost);
+    auto const* q = bufferCast<std::int8_t>(*quantizedHost);
+    for (SizeType32 t = 0; t < kTokens; ++t)
+    {
+        double mean = 0.;
+        for (SizeType32 i = 0; i < hidden; ++i)
+        {
+            auto const idx = t * hidden + i;
+            EXPECT_FLOAT_EQ(sum[idx], in[idx] + res[idx]);
+            mean += sum[idx];
+        }
+        mean /= hidden;
+        double variance = 0.;
+        for (SizeType32 i = 0; i < hidden; ++i)
+        {
+            auto const diff = sum[t * hidden + i] - mean;
+            variance += diff * diff;
+        }
+        auto const invStd = 1. / std::sqrt(variance / hidden + kEps);
+        for (SizeType32 i = 0; i < hidden; ++i)
+        {
+            auto const idx = t * hidden + i;
+            auto const normed = static_cast<float>((sum[idx] - mean) * invStd * g[i] + b[i]);
+            EXPECT_NEAR(out[idx], normed, 1e-4f) << "token " << t << " index " << i;
+            // One quantization step for the rounding
+            EXPECT_NEAR(q[idx] / s, normed, 1.01f / s) << "token " << t << " index " << i;
+        }
+    }
+}
+} // namespace
+
+TEST(FusedNormKernelTest, AddLayerNormWarpPerRow)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    testAddLayerNorm(256);
+}
+
+TEST(FusedNormKernelTest, AddLayerNormUnalignedHidden)
+{
+    if (tc::getDeviceCount() == 0)
+    {
+        GTEST_SKIP();
+    }
+    // Not a multiple of the 128-bit vector, one CTA per row with scalar accesses
+    testAddLayerNorm(1030);
+}
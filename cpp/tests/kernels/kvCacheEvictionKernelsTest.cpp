@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/kvCacheEvictionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class KvCacheEvictionKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! Gives each sequence its own blocks, filled with random values.
+    void initKvCache(std::vector<SizeType32> const& seqLengths)
+    {
+        mNumSeqs = static_cast<SizeType32>(seqLengths.size());
+        mSeqLengths = seqLengths;
+        mBlockOffsets
+            = BufferManager::pinned(ITensor::makeShape({mNumSeqs, 2, mMaxBlocksPerSeq}), nvinfer1::DataType::kINT32);
+        auto* offsets = bufferCast<std::int32_t>(*mBlockOffsets);
+        auto const numBlocks = mNumSeqs * mMaxBlocksPerSeq;
+        for (SizeType32 si = 0; si < mNumSeqs; ++si)
+        {
+            for (SizeType32 bi = 0; bi < mMaxBlocksPerSeq; ++bi)
+            {
+                offsets[(si * 2) * mMaxBlocksPerSeq + bi] = si * mMaxBlocksPerSeq + bi;
+                offsets[(si * 2 + 1) * mMaxBlocksPerSeq + bi] = numBlocks + si * mMaxBlocksPerSeq + bi;
+            }
+        }
+
+        auto const blockSize = mNumKvHeads * mTokensPerBlock * mHeadSize;
+        mPool = BufferManager::pinned(ITensor::makeShape({2 * numBlocks, blockSize}), nvinfer1::DataType::kFLOAT);
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::generate_n(bufferCast<float>(*mPool), mPool->getSize(), [&]() { return dist(gen); });
+
+        auto const bytesPerToken = mNumKvHeads * mHeadSize * static_cast<SizeType32>(sizeof(float));
+        mKvCache = tk::KVBlockArray(mNumSeqs, mMaxBlocksPerSeq, mTokensPerBlock, bytesPerToken,
+            mMaxBlocksPerSeq * mTokensPerBlock, 0, bufferCast<float>(*mPool), nullptr,
+            reinterpret_cast<tk::KVCacheIndex*>(offsets));
+    }
+
+    [[nodiscard]] float readKv(bool isK, SizeType32 seqIdx, SizeType32 kvHeadIdx, SizeType32 tokenIdx,
+        SizeType32 channelIdx) const
+    {
+        auto const* block = reinterpret_cast<float const*>(
+            isK ? mKvCache.getKBlockPtr(seqIdx, tokenIdx) : mKvCache.getVBlockPtr(seqIdx, tokenIdx));
+        return block[mKvCache.getKVLocalIdx(tokenIdx, kvHeadIdx, mHeadSize, channelIdx)];
+    }
+
+    static TensorPtr toBuffer(std::vector<SizeType32> const& values)
+    {
+        auto buffer = BufferManager::pinned(
+            ITensor::makeShape({static_cast<SizeType32>(values.size())}), nvinfer1::DataType::kINT32);
+        std::copy(values.begin(), values.end(), bufferCast<SizeType32>(*buffer));
+        return buffer;
+    }
+
+    [[nodiscard]] TensorPtr makeImportance() const
+    {
+        auto importance = BufferManager::pinned(
+            ITensor::makeShape({mNumSeqs, mNumKvHeads, mMaxSeqLength}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*importance), importance->getSize(), 0.f);
+        return importance;
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    TensorPtr mBlockOffsets;
+    TensorPtr mPool;
+    tk::KVBlockArray mKvCache;
+    std::vector<SizeType32> mSeqLengths;
+    SizeType32 mNumSeqs{0};
+
+    SizeType32 const mMaxBlocksPerSeq{6};
+    SizeType32 const mTokensPerBlock{4};
+    SizeType32 const mMaxSeqLength{24};
+    SizeType32 const mNumHeads{4};
+    SizeType32 const mNumKvHeads{2};
+    SizeType32 const mHeadSize{16};
+};
+
+TEST_F(KvCacheEvictionKernelsTest, AccumulatesAttentionProbabilities)
+{
+    initKvCache({13, 5});
+    SizeType32 constexpr numQueries{3};
+    auto const qSize = mNumSeqs * numQueries * mNumHeads * mHeadSize;
+    auto q = BufferManager::pinned(ITensor::makeShape({qSize}), nvinfer1::DataType::kFLOAT);
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    std::generate_n(bufferCast<float>(*q), qSize, [&]() { return dist(gen); });
+    auto seqLengths = toBuffer(mSeqLengths);
+    auto importance = makeImportance();
+
+    tk::KvTokenImportanceParams<float> params;
+    params.q = bufferCast<float>(*q);
+    params.seqLengths = bufferCast<SizeType32>(*seqLengths);
+    params.kvCache = mKvCache;
+    params.importance = bufferCast<float>(*importance);
+    params.numSeqs = mNumSeqs;
+    params.numQueries = numQueries;
+    params.numHeads = mNumHeads;
+    params.numKvHeads = mNumKvHeads;
+    params.headSize = mHeadSize;
+    params.maxSeqLength = mMaxSeqLength;
+    params.qkScale = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+    // Twice, the probabilities accumulate
+    tk::invokeAccumulateKvTokenImportance(params, mStream->get());
+    tk::invokeAccumulateKvTokenImportance(params, mStream->get());
+    mStream->synchronize();
+
+    auto const* qPtr = bufferCast<float>(*q);
+    auto const* importancePtr = bufferCast<float>(*importance);
+    for (SizeType32 si = 0; si < mNumSeqs; ++si)
+    {
+        std::vector<float> ref(mNumKvHeads * mMaxSeqLength, 0.f);
+        for (SizeType32 qi = 0; qi < numQueries; ++qi)
+        {
+            auto const queryPos = mSeqLengths[si] - numQueries + qi;
+            for (SizeType32 hi = 0; hi < mNumHeads; ++hi)
+            {
+                auto const kvHeadIdx = hi / (mNumHeads / mNumKvHeads);
+                auto const* qRow = qPtr + ((si * numQueries + qi) * mNumHeads + hi) * mHeadSize;
+                std::vector<float> scores(queryPos + 1);
+                for (SizeType32 ti = 0; ti <= queryPos; ++ti)
+                {
+                    float score{0.f};
+                    for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                    {
+                        score += qRow[ci] * readKv(true, si, kvHeadIdx, ti, ci);
+                    }
+                    scores[ti] = score * params.qkScale;
+                }
+                auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                float sum{0.f};
+                for (auto& score : scores)
+                {
+                    score = std::exp(score - maxScore);
+                    sum += score;
+                }
+                for (SizeType32 ti = 0; ti <= queryPos; ++ti)
+                {
+                    ref[kvHeadIdx * mMaxSeqLength + ti] += 2.f * scores[ti] / sum;
+                }
+            }
+        }
+        for (SizeType32 hi = 0; hi < mNumKvHeads; ++hi)
+        {
+            for (SizeType32 ti = 0; ti < mMaxSeqLength; ++ti)
+            {
+                auto const value = importancePtr[(si * mNumKvHeads + hi) * mMaxSeqLength + ti];
+                EXPECT_NEAR(value, ref[hi * mMaxSeqLength + ti], 1e-4f)
+                    << "seq " << si << " head group " << hi << " token " << ti;
+            }
+        }
+    }
+}
+
+TEST_F(KvCacheEvictionKernelsTest, CompactsKeptTokensOfEachHeadGroup)
+{
+    initKvCache({20, 9});
+    SizeType32 constexpr maxKeptTokens{8};
+    // Sequence 0 keeps 8 tokens, different ones per head group, sequence 1 keeps 6 with its first tokens in place
+    std::vector<SizeType32> const kept{0, 1, 5, 6, 11, 17, 18, 19, 0, 2, 3, 9, 13, 17, 18, 19, 0, 1, 2, 4, 7, 8, 0, 0,
+        0, 1, 3, 6, 7, 8, 0, 0};
+    std::vector<SizeType32> const numKept{8, 6};
+    auto keptTokens = toBuffer(kept);
+    auto numKeptTokens = toBuffer(numKept);
+    auto seqLengths = toBuffer(mSeqLengths);
+    auto importance = makeImportance();
+    auto* importancePtr = bufferCast<float>(*importance);
+    for (SizeType32 idx = 0; idx < static_cast<SizeType32>(importance->getSize()); ++idx)
+    {
+        importancePtr[idx] = static_cast<float>(idx);
+    }
+
+    std::vector<float> const poolBefore(
+        bufferCast<float>(*mPool), bufferCast<float>(*mPool) + static_cast<std::ptrdiff_t>(mPool->getSize()));
+    auto const readBefore = [&](bool isK, SizeType32 si, SizeType32 hi, SizeType32 ti, SizeType32 ci)
+    {
+        auto const* block = static_cast<float const*>(
+            isK ? mKvCache.getKBlockPtr(si, ti) : mKvCache.getVBlockPtr(si, ti));
+        auto const offset = block - bufferCast<float>(*mPool);
+        return poolBefore[offset + mKvCache.getKVLocalIdx(ti, hi, mHeadSize, ci)];
+    };
+
+    tk::KvCacheCompactionParams params;
+    params.kvCache = mKvCache;
+    params.keptTokens = bufferCast<SizeType32>(*keptTokens);
+    params.numKeptTokens = bufferCast<SizeType32>(*numKeptTokens);
+    params.seqLengths = bufferCast<SizeType32>(*seqLengths);
+    params.importance = importancePtr;
+    params.numSeqs = mNumSeqs;
+    params.numKvHeads = mNumKvHeads;
+    params.maxKeptTokens = maxKeptTokens;
+    params.maxSeqLength = mMaxSeqLength;
+    params.bytesPerHead = mHeadSize * static_cast<SizeType32>(sizeof(float));
+    tk::invokeCompactKvCache(params, mStream->get());
+    mStream->synchronize();
+
+    for (SizeType32 si = 0; si < mNumSeqs; ++si)
+    {
+        for (SizeType32 hi = 0; hi < mNumKvHeads; ++hi)
+        {
+            auto const row = si * mNumKvHeads + hi;
+            for (SizeType32 ki = 0; ki < numKept[si]; ++ki)
+            {
+                auto const srcIdx = kept[row * maxKeptTokens + ki];
+                for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                {
+                    EXPECT_EQ(readKv(true, si, hi, ki, ci), readBefore(true, si, hi, srcIdx, ci));
+                    EXPECT_EQ(readKv(false, si, hi, ki, ci), readBefore(false, si, hi, srcIdx, ci));
+                }
+                EXPECT_EQ(importancePtr[row * mMaxSeqLength + ki], static_cast<float>(row * mMaxSeqLength + srcIdx));
+            }
+            for (SizeType32 ti = numKept[si]; ti < mSeqLengths[si]; ++ti)
+            {
+                EXPECT_EQ(importancePtr[row * mMaxSeqLength + ti], 0.f);
+            }
+        }
+    }
+}
+
+} // namespace
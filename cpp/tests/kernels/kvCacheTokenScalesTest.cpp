@@ -0,0 +1,322 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Checks the 8-bit paged KV cache with one scale per token and kv head: QKV preprocessing has to write the scale
+// amax / 127 of each head with the quantized head, and MMHA on such a cache has to match MMHA on a float cache holding
+// the dequantized values.
+class KvCacheTokenScalesTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+
+        auto const batchSize = static_cast<int>(mPastLengths.size());
+        auto const numBlocks = batchSize * 2 * mMaxBlocksPerSeq;
+        mBlockOffsets
+            = BufferManager::pinned(ITensor::makeShape({batchSize, 2, mMaxBlocksPerSeq}), nvinfer1::DataType::kINT32);
+        auto* offsets = bufferCast<std::int32_t>(*mBlockOffsets);
+        for (int bi = 0; bi < numBlocks; ++bi)
+        {
+            // Sequences do not use their blocks in pool order.
+            offsets[bi] = numBlocks - 1 - bi;
+        }
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        mInt8Pool = BufferManager::pinned(
+            ITensor::makeShape({numBlocks, mTokensPerBlock * tokenSize}), nvinfer1::DataType::kINT8);
+        mScalePool = BufferManager::pinned(
+            ITensor::makeShape({numBlocks, mNumKvHeads * mTokensPerBlock}), nvinfer1::DataType::kFLOAT);
+        mFloatPool = BufferManager::pinned(
+            ITensor::makeShape({numBlocks, mTokensPerBlock * tokenSize}), nvinfer1::DataType::kFLOAT);
+        // The layer scales are ignored with token scales.
+        mLayerScales = BufferManager::pinned(ITensor::makeShape({2}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*mLayerScales), 2, 1.f);
+    }
+
+    //! \brief The int8 paged cache with token scales, or the float paged cache on the same blocks.
+    tk::KVBlockArray createCache(bool int8Cache) const
+    {
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto const batchSize = static_cast<int>(mPastLengths.size());
+        auto* offsets = reinterpret_cast<tk::KVCacheIndex*>(bufferCast<std::int32_t>(*mBlockOffsets));
+        if (!int8Cache)
+        {
+            return tk::KVBlockArray(batchSize, mMaxBlocksPerSeq, mTokensPerBlock,
+                tokenSize * static_cast<int>(sizeof(float)), mAttentionWindow, 0, bufferCast<float>(*mFloatPool),
+                nullptr, offsets);
+        }
+        tk::KVBlockArray cache(batchSize, mMaxBlocksPerSeq, mTokensPerBlock, tokenSize, mAttentionWindow, 0,
+            bufferCast<std::int8_t>(*mInt8Pool), nullptr, offsets);
+        cache.setTokenScalePools(bufferCast<float>(*mScalePool), nullptr, mNumKvHeads);
+        return cache;
+    }
+
+    //! \brief Fills the past tokens of the int8 cache with random heads of very different magnitudes, and the float
+    //! cache with their dequantized values.
+    void fillPastTokens()
+    {
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::uniform_real_distribution<float> magnitudeDist(-3.f, 1.5f);
+        auto const int8Cache = createCache(true);
+        auto const floatCache = createCache(false);
+        std::vector<float> head(mHeadSize);
+        for (int si = 0; si < static_cast<int>(mPastLengths.size()); ++si)
+        {
+            for (int ti = 0; ti < mPastLengths[si]; ++ti)
+            {
+                for (auto const kvIdx : {tk::KVIdxType::K_IDX, tk::KVIdxType::V_IDX})
+                {
+                    auto* q = static_cast<std::int8_t*>(int8Cache.getBlockPtr(si, ti, kvIdx));
+                    auto* f = static_cast<float*>(floatCache.getBlockPtr(si, ti, kvIdx));
+                    for (int hi = 0; hi < mNumKvHeads; ++hi)
+                    {
+                        auto const magnitude = std::exp(magnitudeDist(gen));
+                        std::generate(head.begin(), head.end(), [&]() { return magnitude * dist(gen); });
+                        auto const absMax = std::abs(*std::max_element(head.begin(), head.end(),
+                            [](float lhs, float rhs) { return std::abs(lhs) < std::abs(rhs); }));
+                        auto const scale = absMax / 127.f;
+                        *int8Cache.getScalePtr(si, ti, kvIdx, hi) = scale;
+                        for (int c = 0; c < mHeadSize; ++c)
+                        {
+                            auto const idx = int8Cache.getKVLocalIdx(ti, hi, mHeadSize, c);
+                            q[idx] = static_cast<std::int8_t>(std::round(head[c] / scale));
+                            f[idx] = q[idx] * scale;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    //! \brief Runs one generation step of MMHA on the int8 or on the float cache.
+    void runMmha(TensorPtr const& qkv, TensorPtr const& output, bool int8Cache)
+    {
+        auto const batchSize = static_cast<int>(mPastLengths.size());
+        auto const qkvSize = (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+        auto seqLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto inputLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        for (int bi = 0; bi < batchSize; ++bi)
+        {
+            bufferCast<int>(*seqLengths)[bi] = mPastLengths[bi] + 1;
+            bufferCast<int>(*inputLengths)[bi] = mPastLengths[bi];
+        }
+
+        tk::Masked_multihead_attention_params<float> params;
+        params.out = bufferCast<float>(*output);
+        params.q = bufferCast<float>(*qkv);
+        params.k = params.q + mNumHeads * mHeadSize;
+        params.v = params.k + mNumKvHeads * mHeadSize;
+        params.stride = qkvSize;
+        params.batch_size = batchSize;
+        params.beam_width = 1;
+        params.max_attention_window_size = mAttentionWindow;
+        params.cyclic_attention_window_size = mAttentionWindow;
+        params.length_per_sample = bufferCast<int>(*seqLengths);
+        params.input_lengths = bufferCast<int>(*inputLengths);
+        params.timestep = *std::max_element(mPastLengths.begin(), mPastLengths.end());
+        params.num_heads = mNumHeads;
+        params.num_kv_heads = mNumKvHeads;
+        params.hidden_size_per_head = mHeadSize;
+        params.position_embedding_type = tk::PositionEmbeddingType::kLEARNED_ABSOLUTE;
+        params.inv_sqrt_dh = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+        params.multi_processor_count = tc::getMultiProcessorCount();
+        if (int8Cache)
+        {
+            params.int8_kv_cache = true;
+            params.kv_scale_orig_quant = bufferCast<float>(*mLayerScales);
+            params.kv_scale_quant_orig = bufferCast<float>(*mLayerScales) + 1;
+        }
+
+        tk::masked_multihead_attention(params, createCache(int8Cache), mStream->get());
+        mStream->synchronize();
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    TensorPtr mBlockOffsets;
+    TensorPtr mInt8Pool;
+    TensorPtr mScalePool;
+    TensorPtr mFloatPool;
+    TensorPtr mLayerScales;
+
+    std::vector<int> mPastLengths{13, 30, 1};
+    int mNumHeads{4};
+    int mNumKvHeads{2};
+    int mHeadSize{64};
+    int mTokensPerBlock{8};
+    int mMaxBlocksPerSeq{4};
+    int mAttentionWindow{32};
+};
+
+TEST_F(KvCacheTokenScalesTest, PreprocessingWritesTokenScales)
+{
+    auto const seqLength = mPastLengths[1];
+    auto const tokenSize = mNumKvHeads * mHeadSize;
+    auto const qSize = mNumHeads * mHeadSize;
+    auto const qkvSize = qSize + 2 * tokenSize;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    auto qkv = BufferManager::pinned(ITensor::makeShape({seqLength, qkvSize}), nvinfer1::DataType::kFLOAT);
+    auto* qkvPtr = bufferCast<float>(*qkv);
+    for (int ti = 0; ti < seqLength; ++ti)
+    {
+        // Heads of very different magnitudes from token to token.
+        auto const magnitude = std::exp(static_cast<float>(ti % 7) - 3.f);
+        std::generate_n(qkvPtr + ti * qkvSize, qkvSize, [&]() { return magnitude * dist(gen); });
+    }
+    auto input = BufferManager::pinned(qkv->getShape(), nvinfer1::DataType::kFLOAT);
+    std::copy_n(qkvPtr, qkv->getSize(), bufferCast<float>(*input));
+    auto q = BufferManager::pinned(ITensor::makeShape({seqLength, qSize}), nvinfer1::DataType::kFLOAT);
+    auto seqLengths = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+    bufferCast<int>(*seqLengths)[0] = seqLength;
+    auto cuSeqLengths = BufferManager::pinned(ITensor::makeShape({2}), nvinfer1::DataType::kINT32);
+    bufferCast<int>(*cuSeqLengths)[0] = 0;
+    bufferCast<int>(*cuSeqLengths)[1] = seqLength;
+
+    // The first sequence of the cache.
+    auto const cache = createCache(true);
+    tk::QKVPreprocessingParams<float, tk::KVBlockArray> params;
+    params.QKV = qkvPtr;
+    params.Q = bufferCast<float>(*q);
+    params.kv_cache_buffer = cache;
+    params.seq_lens = bufferCast<int>(*seqLengths);
+    params.cache_seq_lens = bufferCast<int>(*seqLengths);
+    params.cu_seq_lens = bufferCast<int>(*cuSeqLengths);
+    params.kvScaleOrigQuant = bufferCast<float>(*mLayerScales);
+    params.batch_size = 1;
+    params.max_input_seq_len = seqLength;
+    params.max_kv_seq_len = seqLength;
+    params.cyclic_kv_cache_len = mAttentionWindow;
+    params.token_num = seqLength;
+    params.head_num = mNumHeads;
+    params.kv_head_num = mNumKvHeads;
+    params.qheads_per_kv_head = mNumHeads / mNumKvHeads;
+    params.size_per_head = mHeadSize;
+    params.position_embedding_type = tk::PositionEmbeddingType::kLEARNED_ABSOLUTE;
+    params.cache_type = tk::KvCacheDataType::INT8;
+    params.multi_processor_count = tc::getMultiProcessorCount();
+
+    tk::invokeQKVPreprocessing(params, mStream->get());
+    mStream->synchronize();
+
+    auto const* in = bufferCast<float>(*input);
+    for (int ti = 0; ti < seqLength; ++ti)
+    {
+        for (auto const kvIdx : {tk::KVIdxType::K_IDX, tk::KVIdxType::V_IDX})
+        {
+            auto const* block = static_cast<std::int8_t const*>(cache.getBlockPtr(0, ti, kvIdx));
+            auto const* tokenIn = in + ti * qkvSize + qSize + static_cast<int>(kvIdx) * tokenSize;
+            for (int hi = 0; hi < mNumKvHeads; ++hi)
+            {
+                auto const* headIn = tokenIn + hi * mHeadSize;
+                float absMax = 0.f;
+                for (int c = 0; c < mHeadSize; ++c)
+                {
+                    absMax = std::max(absMax, std::abs(headIn[c]));
+                }
+                auto const scale = *cache.getScalePtr(0, ti, kvIdx, hi);
+                EXPECT_NEAR(scale, absMax / 127.f, 1e-5f * absMax) << "token " << ti << ", head " << hi;
+                for (int c = 0; c < mHeadSize; ++c)
+                {
+                    auto const dequantized = block[cache.getKVLocalIdx(ti, hi, mHeadSize, c)] * scale;
+                    // Half a quantization step
+                    EXPECT_NEAR(dequantized, headIn[c], 0.51f * scale)
+                        << "token " << ti << ", head " << hi << ", channel " << c;
+                }
+            }
+        }
+    }
+}
+
+TEST_F(KvCacheTokenScalesTest, MmhaMatchesDequantizedCache)
+{
+    fillPastTokens();
+
+    auto const batchSize = static_cast<int>(mPastLengths.size());
+    auto const qkvSize = (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+    auto const outSize = batchSize * mNumHeads * mHeadSize;
+    std::mt19937 gen(43);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    auto qkv = BufferManager::pinned(ITensor::makeShape({batchSize, qkvSize}), nvinfer1::DataType::kFLOAT);
+    std::generate_n(bufferCast<float>(*qkv), qkv->getSize(), [&]() { return dist(gen); });
+
+    auto reference = BufferManager::pinned(ITensor::makeShape({outSize}), nvinfer1::DataType::kFLOAT);
+    runMmha(qkv, reference, false);
+    auto output = BufferManager::pinned(ITensor::makeShape({outSize}), nvinfer1::DataType::kFLOAT);
+    runMmha(qkv, output, true);
+
+    // Only the current token is quantized by the kernel, the past tokens are the same in both caches.
+    auto const* ref = bufferCast<float>(*reference);
+    auto const* out = bufferCast<float>(*output);
+    for (int i = 0; i < outSize; ++i)
+    {
+        ASSERT_TRUE(std::isfinite(out[i])) << "index " << i;
+        EXPECT_NEAR(out[i], ref[i], 2e-2f) << "sequence " << i / (mNumHeads * mHeadSize) << ", index " << i;
+    }
+
+    // The kernel writes the scales of the current token.
+    auto const cache = createCache(true);
+    auto const* in = bufferCast<float>(*qkv);
+    for (int si = 0; si < batchSize; ++si)
+    {
+        for (auto const kvIdx : {tk::KVIdxType::K_IDX, tk::KVIdxType::V_IDX})
+        {
+            for (int hi = 0; hi < mNumKvHeads; ++hi)
+            {
+                auto const headIdx = mNumHeads + static_cast<int>(kvIdx) * mNumKvHeads + hi;
+                auto const* headIn = in + si * qkvSize + headIdx * mHeadSize;
+                float absMax = 0.f;
+                for (int c = 0; c < mHeadSize; ++c)
+                {
+                    absMax = std::max(absMax, std::abs(headIn[c]));
+                }
+                EXPECT_NEAR(*cache.getScalePtr(si, mPastLengths[si], kvIdx, hi), absMax / 127.f, 1e-5f * absMax)
+                    << "sequence " << si << ", head " << hi;
+            }
+        }
+    }
+}
+
+} // namespace
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/speculativeDecoding/kvCacheUpdateKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+namespace tksd = tensorrt_llm::kernels::speculative_decoding;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class KVCacheUpdateKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    // Unique value of each element of the KV cache
+    static std::int32_t kvValue(SizeType32 layerIdx, SizeType32 seqIdx, SizeType32 kvIdx, SizeType32 headIdx,
+        SizeType32 tokenIdx, SizeType32 channelIdx)
+    {
+        return ((((layerIdx * 8 + seqIdx) * 2 + kvIdx) * 8 + headIdx) * 64 + tokenIdx) * 64 + channelIdx;
+    }
+
+    [[nodiscard]] tk::KVLinearBuffer makeLinearBuffer(SizeType32 layerIdx) const
+    {
+        auto const sizePerToken = mNumKVHeads * mHeadSize * static_cast<SizeType32>(sizeof(std::int32_t));
+        return tk::KVLinearBuffer(mSeqCount, mMaxKVCacheLen, sizePerToken, mMaxKVCacheLen, 0, false,
+            reinterpret_cast<tk::KVLinearBuffer::DataType*>(bufferCast<std::int32_t>(*mKvCaches.at(layerIdx))));
+    }
+
+    [[nodiscard]] std::int32_t readKv(SizeType32 layerIdx, SizeType32 seqIdx, SizeType32 kvIdx, SizeType32 headIdx,
+        SizeType32 tokenIdx, SizeType32 channelIdx) const
+    {
+        auto const buffer = makeLinearBuffer(layerIdx);
+        auto const* ptr = reinterpret_cast<std::int32_t const*>(
+            kvIdx == 0 ? buffer.getKBlockPtr(seqIdx, tokenIdx) : buffer.getVBlockPtr(seqIdx, tokenIdx));
+        return ptr[buffer.getKVLocalIdx(tokenIdx, headIdx, mHeadSize, channelIdx)];
+    }
+
+    void writeKv(SizeType32 layerIdx, SizeType32 seqIdx, SizeType32 kvIdx, SizeType32 headIdx, SizeType32 tokenIdx,
+        SizeType32 channelIdx, std::int32_t value)
+    {
+        auto const buffer = makeLinearBuffer(layerIdx);
+        auto* ptr = reinterpret_cast<std::int32_t*>(
+            kvIdx == 0 ? buffer.getKBlockPtr(seqIdx, tokenIdx) : buffer.getVBlockPtr(seqIdx, tokenIdx));
+        ptr[buffer.getKVLocalIdx(tokenIdx, headIdx, mHeadSize, channelIdx)] = value;
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    std::vector<TensorPtr> mKvCaches;
+
+    SizeType32 const mLayerCount{2};
+    SizeType32 const mSeqCount{3};
+    SizeType32 const mNumKVHeads{2};
+    SizeType32 const mHeadSize{8};
+    SizeType32 const mMaxKVCacheLen{16};
+    SizeType32 const mMaxDraftTokens{4};
+    SizeType32 const mMaxSeqLen{16};
+};
+
+TEST_F(KVCacheUpdateKernelsTest, LinearCacheAndOutputsInOneLaunch)
+{
+    // KV cache lengths include the draft tokens of the step, all rewound by mMaxDraftTokens
+    std::vector<SizeType32> const pastKeyValueLengths{10, 12, 9};
+    std::vector<std::vector<tksd::IndexType>> const acceptedIndices{{1, 3}, {}, {0, 1, 2}};
+    std::vector<SizeType32> const batchSlots{1, 2, 0};
+    std::vector<SizeType32> const initialSequenceLengths{5, 7, 3};
+
+    auto const sizePerSeq = 2 * mNumKVHeads * mMaxKVCacheLen * mHeadSize;
+    std::vector<std::int8_t*> pastKeyValueList;
+    for (SizeType32 li = 0; li < mLayerCount; ++li)
+    {
+        mKvCaches.push_back(
+            BufferManager::pinned(ITensor::makeShape({mSeqCount, sizePerSeq}), nvinfer1::DataType::kINT32));
+        pastKeyValueList.push_back(reinterpret_cast<std::int8_t*>(bufferCast<std::int32_t>(*mKvCaches.back())));
+        for (SizeType32 si = 0; si < mSeqCount; ++si)
+        {
+            for (SizeType32 kv = 0; kv < 2; ++kv)
+            {
+                for (SizeType32 hi = 0; hi < mNumKVHeads; ++hi)
+                {
+                    for (SizeType32 ti = 0; ti < mMaxKVCacheLen; ++ti)
+                    {
+                        for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                        {
+                            writeKv(li, si, kv, hi, ti, ci, kvValue(li, si, kv, hi, ti, ci));
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    auto offsets = BufferManager::pinned(ITensor::makeShape({mSeqCount + 1}), nvinfer1::DataType::kINT32);
+    auto indices = BufferManager::pinned(ITensor::makeShape({mSeqCount * mMaxDraftTokens}), nvinfer1::DataType::kINT32);
+    auto pastLengths = BufferManager::pinned(ITensor::makeShape({mSeqCount}), nvinfer1::DataType::kINT32);
+    auto slots = BufferManager::pinned(ITensor::makeShape({mSeqCount}), nvinfer1::DataType::kINT32);
+    auto offsetsPtr = bufferCast<SizeType32>(*offsets);
+    auto indicesPtr = bufferCast<tksd::IndexType>(*indices);
+    offsetsPtr[0] = 0;
+    for (SizeType32 si = 0; si < mSeqCount; ++si)
+    {
+        std::copy(acceptedIndices[si].begin(), acceptedIndices[si].end(), indicesPtr + offsetsPtr[si]);
+        offsetsPtr[si + 1] = offsetsPtr[si] + static_cast<SizeType32>(acceptedIndices[si].size());
+        bufferCast<SizeType32>(*pastLengths)[si] = pastKeyValueLengths[si];
+        bufferCast<SizeType32>(*slots)[si] = batchSlots[si];
+    }
+
+    // One more output token than accepted draft tokens, the token of the target model
+    auto const maxAcceptedTokens = mMaxDraftTokens + 1;
+    auto acceptedIds
+        = BufferManager::pinned(ITensor::makeShape({mSeqCount, maxAcceptedTokens}), nvinfer1::DataType::kINT32);
+    auto acceptedLogProbs
+        = BufferManager::pinned(ITensor::makeShape({mSeqCount, maxAcceptedTokens}), nvinfer1::DataType::kFLOAT);
+    auto numAccepted = BufferManager::pinned(ITensor::makeShape({mSeqCount}), nvinfer1::DataType::kINT32);
+    auto outputIds = BufferManager::pinned(ITensor::makeShape({mSeqCount, mMaxSeqLen}), nvinfer1::DataType::kINT32);
+    auto outputLogProbs
+        = BufferManager::pinned(ITensor::makeShape({mSeqCount, mMaxSeqLen}), nvinfer1::DataType::kFLOAT);
+    auto sequenceLengths = BufferManager::pinned(ITensor::makeShape({mSeqCount}), nvinfer1::DataType::kINT32);
+    std::fill_n(bufferCast<TokenIdType>(*outputIds), mSeqCount * mMaxSeqLen, -1);
+    std::fill_n(bufferCast<float>(*outputLogProbs), mSeqCount * mMaxSeqLen, 0.F);
+    for (SizeType32 si = 0; si < mSeqCount; ++si)
+    {
+        auto const slot = batchSlots[si];
+        bufferCast<SizeType32>(*numAccepted)[slot] = static_cast<SizeType32>(acceptedIndices[si].size()) + 1;
+        bufferCast<SizeType32>(*sequenceLengths)[slot] = initialSequenceLengths[si];
+        for (SizeType32 ti = 0; ti < maxAcceptedTokens; ++ti)
+        {
+            bufferCast<TokenIdType>(*acceptedIds)[slot * maxAcceptedTokens + ti] = 100 * (si + 1) + ti;
+            bufferCast<float>(*acceptedLogProbs)[slot * maxAcceptedTokens + ti] = -0.5F * ti - si;
+        }
+    }
+
+    tksd::AcceptedTokensOutputs outputs;
+    outputs.acceptedTokenIds = bufferCast<TokenIdType>(*acceptedIds);
+    outputs.acceptedLogProbs = bufferCast<float>(*acceptedLogProbs);
+    outputs.numAcceptedTokens = bufferCast<SizeType32>(*numAccepted);
+    outputs.outputIds = bufferCast<TokenIdType>(*outputIds);
+    outputs.outputLogProbs = bufferCast<float>(*outputLogProbs);
+    outputs.sequenceLengths = bufferCast<SizeType32>(*sequenceLengths);
+    outputs.maxAcceptedTokens = maxAcceptedTokens;
+    outputs.maxSeqLen = mMaxSeqLen;
+
+    auto const sizeInBytesPerKVHead = mHeadSize * static_cast<SizeType32>(sizeof(std::int32_t));
+    tksd::updateLinearKVCacheDraftTokenLocationAndOutputs(offsetsPtr, indicesPtr, bufferCast<SizeType32>(*pastLengths),
+        pastKeyValueList.data(), mLayerCount, mSeqCount, mNumKVHeads, sizeInBytesPerKVHead, mMaxDraftTokens, nullptr,
+        nullptr, bufferCast<SizeType32>(*slots), mMaxKVCacheLen, outputs, mStream->get());
+    mStream->synchronize();
+
+    for (SizeType32 si = 0; si < mSeqCount; ++si)
+    {
+        auto const tokenStart = pastKeyValueLengths[si] - mMaxDraftTokens;
+        for (SizeType32 li = 0; li < mLayerCount; ++li)
+        {
+            for (SizeType32 kv = 0; kv < 2; ++kv)
+            {
+                for (SizeType32 hi = 0; hi < mNumKVHeads; ++hi)
+                {
+                    for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                    {
+                        // Tokens before the draft tokens are untouched
+                        for (SizeType32 ti = 0; ti < tokenStart; ++ti)
+                        {
+                            EXPECT_EQ(readKv(li, si, kv, hi, ti, ci), kvValue(li, si, kv, hi, ti, ci));
+                        }
+                        // Accepted draft tokens are compacted behind them
+                        for (std::size_t ai = 0; ai < acceptedIndices[si].size(); ++ai)
+                        {
+                            auto const srcToken = tokenStart + acceptedIndices[si][ai];
+                            EXPECT_EQ(readKv(li, si, kv, hi, tokenStart + static_cast<SizeType32>(ai), ci),
+                                kvValue(li, si, kv, hi, srcToken, ci))
+                                << "layer " << li << " seq " << si << " accepted " << ai;
+                        }
+                    }
+                }
+            }
+        }
+
+        auto const slot = batchSlots[si];
+        auto const numTokens = static_cast<SizeType32>(acceptedIndices[si].size()) + 1;
+        EXPECT_EQ(bufferCast<SizeType32>(*sequenceLengths)[slot], initialSequenceLengths[si] + numTokens);
+        for (SizeType32 pi = 0; pi < mMaxSeqLen; ++pi)
+        {
+            auto const ti = pi - initialSequenceLengths[si];
+            auto const written = ti >= 0 && ti < numTokens;
+            auto const outIdx = slot * mMaxSeqLen + pi;
+            EXPECT_EQ(bufferCast<TokenIdType>(*outputIds)[outIdx], written ? 100 * (si + 1) + ti : -1);
+            EXPECT_FLOAT_EQ(bufferCast<float>(*outputLogProbs)[outIdx], written ? -0.5F * ti - si : 0.F);
+        }
+    }
+}
+
+} // namespace
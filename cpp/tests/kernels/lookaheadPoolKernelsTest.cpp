@@ -0,0 +1,339 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/speculativeDecoding/lookaheadPoolKernels.h"
+#include "tensorrt_llm/layers/lookaheadPoolManager.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <random>
+
+namespace tksd = tensorrt_llm::kernels::speculative_decoding;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class LookaheadPoolKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mBufferManager = std::make_shared<BufferManager>(mStream);
+    }
+
+    void initPool(SizeType32 batchSize, SizeType32 numBuckets, std::vector<SizeType32> const& guessSetSizes)
+    {
+        auto const maxBatchSize = 2 * batchSize;
+        mKeys = BufferManager::pinned(ITensor::makeShape({maxBatchSize, numBuckets}), nvinfer1::DataType::kINT32);
+        mCounts = BufferManager::pinned(ITensor::makeShape({maxBatchSize, numBuckets}), nvinfer1::DataType::kINT32);
+        mNgrams = BufferManager::pinned(
+            ITensor::makeShape({maxBatchSize, numBuckets, mMaxGuessSetSize, mNgramLength}), nvinfer1::DataType::kINT32);
+        mGuessSetSizes = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+        mBatchSlots = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+
+        auto guessSetSizesPtr = bufferCast<SizeType32>(*mGuessSetSizes);
+        auto batchSlotsPtr = bufferCast<SizeType32>(*mBatchSlots);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            batchSlotsPtr[bi] = 2 * bi;
+            guessSetSizesPtr[2 * bi] = guessSetSizes[bi];
+        }
+
+        mParams.keys = bufferCast<TokenIdType>(*mKeys);
+        mParams.counts = bufferCast<SizeType32>(*mCounts);
+        mParams.ngrams = bufferCast<TokenIdType>(*mNgrams);
+        mParams.guessSetSizes = guessSetSizesPtr;
+        mParams.batchSlots = batchSlotsPtr;
+        mParams.batchSize = batchSize;
+        mParams.numBuckets = numBuckets;
+        mParams.maxGuessSetSize = mMaxGuessSetSize;
+        mParams.ngramLength = mNgramLength;
+
+        tksd::invokeResetLookaheadPool(mParams, mStream->get());
+    }
+
+    void accept(std::vector<std::vector<TokenIdType>> const& prompts)
+    {
+        SizeType32 const batchSize = prompts.size();
+        SizeType32 maxPromptLength = 0;
+        for (auto const& prompt : prompts)
+        {
+            maxPromptLength = std::max(maxPromptLength, static_cast<SizeType32>(prompt.size()));
+        }
+        auto promptsBuf
+            = BufferManager::pinned(ITensor::makeShape({batchSize, maxPromptLength}), nvinfer1::DataType::kINT32);
+        auto promptLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            std::copy(prompts[bi].begin(), prompts[bi].end(),
+                bufferCast<TokenIdType>(*promptsBuf) + bi * maxPromptLength);
+            bufferCast<SizeType32>(*promptLengths)[bi] = prompts[bi].size();
+        }
+        tksd::invokeAcceptLookaheadPool(mParams, bufferCast<TokenIdType>(*promptsBuf),
+            bufferCast<SizeType32>(*promptLengths), maxPromptLength, mStream->get());
+        mStream->synchronize();
+    }
+
+    //! keys [batchSize][numInserts], ngrams [batchSize][numInserts * ngramLength]
+    void update(std::vector<std::vector<TokenIdType>> const& keys, std::vector<std::vector<TokenIdType>> const& ngrams)
+    {
+        SizeType32 const batchSize = keys.size();
+        SizeType32 maxNumInserts = 0;
+        for (auto const& k : keys)
+        {
+            maxNumInserts = std::max(maxNumInserts, static_cast<SizeType32>(k.size()));
+        }
+        maxNumInserts = std::max(maxNumInserts, 1);
+        auto keysBuf
+            = BufferManager::pinned(ITensor::makeShape({batchSize, maxNumInserts}), nvinfer1::DataType::kINT32);
+        auto ngramsBuf = BufferManager::pinned(
+            ITensor::makeShape({batchSize, maxNumInserts, mNgramLength}), nvinfer1::DataType::kINT32);
+        auto numInserts = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            std::copy(keys[bi].begin(), keys[bi].end(), bufferCast<TokenIdType>(*keysBuf) + bi * maxNumInserts);
+            std::copy(ngrams[bi].begin(), ngrams[bi].end(),
+                bufferCast<TokenIdType>(*ngramsBuf) + bi * maxNumInserts * mNgramLength);
+            bufferCast<SizeType32>(*numInserts)[bi] = keys[bi].size();
+        }
+        tksd::invokeUpdateLookaheadPool(mParams, bufferCast<TokenIdType>(*keysBuf),
+            bufferCast<TokenIdType>(*ngramsBuf), bufferCast<SizeType32>(*numInserts), maxNumInserts, mStream->get());
+        mStream->synchronize();
+    }
+
+    //! Returns the guesses of each request, oldest first.
+    std::vector<std::vector<std::vector<TokenIdType>>> guess(
+        std::vector<TokenIdType> const& lastTokens, SizeType32 guessSize)
+    {
+        SizeType32 const batchSize = lastTokens.size();
+        auto const maxBatchSize = 2 * batchSize;
+        auto lastTokensBuf = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto guessSizes = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+        mGuessTokens = BufferManager::pinned(
+            ITensor::makeShape({maxBatchSize, mMaxGuessSetSize, mNgramLength}), nvinfer1::DataType::kINT32);
+        mNumGuesses = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+        std::copy(lastTokens.begin(), lastTokens.end(), bufferCast<TokenIdType>(*lastTokensBuf));
+        std::fill_n(bufferCast<SizeType32>(*guessSizes), maxBatchSize, guessSize);
+
+        tksd::invokeGuessLookaheadPool(mParams, bufferCast<TokenIdType>(*lastTokensBuf),
+            bufferCast<SizeType32>(*guessSizes), bufferCast<TokenIdType>(*mGuessTokens),
+            bufferCast<SizeType32>(*mNumGuesses), mStream->get());
+        mStream->synchronize();
+
+        std::vector<std::vector<std::vector<TokenIdType>>> result(batchSize);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            auto const slot = 2 * bi;
+            auto const* tokens = bufferCast<TokenIdType>(*mGuessTokens) + slot * mMaxGuessSetSize * mNgramLength;
+            for (SizeType32 gi = 0; gi < bufferCast<SizeType32>(*mNumGuesses)[slot]; ++gi)
+            {
+                result[bi].emplace_back(tokens + gi * mNgramLength, tokens + (gi + 1) * mNgramLength);
+            }
+        }
+        return result;
+    }
+
+protected:
+    SizeType32 const mMaxGuessSetSize{8};
+    SizeType32 const mNgramLength{3};
+
+    std::shared_ptr<CudaStream> mStream;
+    std::shared_ptr<BufferManager> mBufferManager;
+
+    TensorPtr mKeys;
+    TensorPtr mCounts;
+    TensorPtr mNgrams;
+    TensorPtr mGuessSetSizes;
+    TensorPtr mBatchSlots;
+    TensorPtr mGuessTokens;
+    TensorPtr mNumGuesses;
+
+    tksd::LookaheadPoolParams mParams;
+};
+
+std::vector<std::vector<TokenIdType>> toVectors(std::list<ITensor::SharedConstPtr> const& ngrams)
+{
+    std::vector<std::vector<TokenIdType>> result;
+    for (auto const& ngram : ngrams)
+    {
+        BufferRange<TokenIdType const> range(*ngram);
+        result.emplace_back(range.begin(), range.end());
+    }
+    return result;
+}
+
+TEST_F(LookaheadPoolKernelsTest, MatchesPoolManager)
+{
+    SizeType32 constexpr batchSize{3};
+    SizeType32 constexpr vocabSize{12};
+    SizeType32 constexpr window{5};
+    SizeType32 constexpr numRounds{20};
+    std::vector<SizeType32> const guessSetSizes{8, 3, 0};
+    // Enough buckets for all keys, nothing is evicted.
+    initPool(batchSize, 64, guessSetSizes);
+
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<TokenIdType> tokenDist(0, vocabSize - 1);
+
+    std::vector<tensorrt_llm::layers::LookaheadPoolManager> managers;
+    std::vector<std::vector<TokenIdType>> prompts(batchSize);
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        managers.emplace_back(mMaxGuessSetSize);
+        managers[bi].setup(guessSetSizes[bi]);
+        prompts[bi].resize(30 + 7 * bi);
+        std::generate(prompts[bi].begin(), prompts[bi].end(), [&]() { return tokenDist(gen); });
+        auto prompt = BufferManager::cpu(ITensor::makeShape({static_cast<SizeType32>(prompts[bi].size())}),
+            nvinfer1::DataType::kINT32);
+        std::copy(prompts[bi].begin(), prompts[bi].end(), bufferCast<TokenIdType>(*prompt));
+        managers[bi].accept(prompt, mNgramLength + 1);
+    }
+    accept(prompts);
+
+    for (SizeType32 ri = 0; ri < numRounds; ++ri)
+    {
+        std::vector<std::vector<TokenIdType>> keys(batchSize);
+        std::vector<std::vector<TokenIdType>> ngrams(batchSize);
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            auto const numInserts = (ri + bi) % (window + 1);
+            keys[bi].resize(numInserts);
+            ngrams[bi].resize(numInserts * mNgramLength);
+            std::generate(keys[bi].begin(), keys[bi].end(), [&]() { return tokenDist(gen); });
+            std::generate(ngrams[bi].begin(), ngrams[bi].end(), [&]() { return tokenDist(gen) % 3; });
+            if (numInserts == 0)
+            {
+                continue;
+            }
+            auto keyTensor = BufferManager::cpu(ITensor::makeShape({numInserts}), nvinfer1::DataType::kINT32);
+            auto ngramTensor
+                = BufferManager::cpu(ITensor::makeShape({numInserts, mNgramLength}), nvinfer1::DataType::kINT32);
+            std::copy(keys[bi].begin(), keys[bi].end(), bufferCast<TokenIdType>(*keyTensor));
+            std::copy(ngrams[bi].begin(), ngrams[bi].end(), bufferCast<TokenIdType>(*ngramTensor));
+            managers[bi].update(keyTensor, ngramTensor);
+        }
+        update(keys, ngrams);
+    }
+
+    for (TokenIdType key = 0; key < vocabSize; ++key)
+    {
+        for (SizeType32 guessSize : {1, 3, 8})
+        {
+            auto const guesses = guess(std::vector<TokenIdType>(batchSize, key), guessSize);
+            for (SizeType32 bi = 0; bi < batchSize; ++bi)
+            {
+                EXPECT_EQ(guesses[bi], toVectors(managers[bi].guess(key, guessSize)))
+                    << "bi " << bi << " key " << key << " guessSize " << guessSize;
+            }
+        }
+    }
+}
+
+TEST_F(LookaheadPoolKernelsTest, EvictsWhenFull)
+{
+    SizeType32 constexpr batchSize{1};
+    SizeType32 constexpr numBuckets{4};
+    initPool(batchSize, numBuckets, {2});
+
+    SizeType32 constexpr numKeys{16};
+    std::vector<std::vector<TokenIdType>> keys(1);
+    std::vector<std::vector<TokenIdType>> ngrams(1);
+    for (TokenIdType key = 0; key < numKeys; ++key)
+    {
+        keys[0].push_back(key);
+        for (SizeType32 ti = 0; ti < mNgramLength; ++ti)
+        {
+            ngrams[0].push_back(100 + key * mNgramLength + ti);
+        }
+    }
+    update(keys, ngrams);
+
+    // At most numBuckets keys survive, the last inserted key always does.
+    SizeType32 numFound = 0;
+    for (TokenIdType key = 0; key < numKeys; ++key)
+    {
+        auto const guesses = guess({key}, 2);
+        if (!guesses[0].empty())
+        {
+            ASSERT_EQ(guesses[0].size(), 1);
+            EXPECT_EQ(guesses[0][0][0], 100 + key * mNgramLength);
+            ++numFound;
+        }
+    }
+    EXPECT_LE(numFound, numBuckets);
+    EXPECT_EQ(guess({numKeys - 1}, 2)[0].size(), 1);
+}
+
+TEST_F(LookaheadPoolKernelsTest, VerifyPicksLongestGuess)
+{
+    SizeType32 constexpr batchSize{2};
+    initPool(batchSize, 16, {4, 4});
+
+    // Request 0 follows token 1 with [2, 9, 9], [2, 3, 9], [2, 3, 4]; request 1 only has [7, 8, 9].
+    update({{1, 1, 1}, {5}}, {{2, 9, 9, 2, 3, 9, 2, 3, 4}, {7, 8, 9}});
+    auto const guesses = guess({1, 5}, 4);
+    ASSERT_EQ(guesses[0].size(), 3);
+    ASSERT_EQ(guesses[1].size(), 1);
+
+    auto const maxBatchSize = 2 * batchSize;
+    auto golden = BufferManager::pinned(
+        ITensor::makeShape({batchSize, mMaxGuessSetSize, mNgramLength}), nvinfer1::DataType::kINT32);
+    auto newLastTokens = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    auto endIds = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+    auto accepted
+        = BufferManager::pinned(ITensor::makeShape({maxBatchSize, mNgramLength + 1}), nvinfer1::DataType::kINT32);
+    auto acceptedLengths = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+    auto bestGuessIds = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvinfer1::DataType::kINT32);
+
+    // The target model continues request 0 with 2, 3, 5, 6 and request 1 with 6, ...
+    auto goldenPtr = bufferCast<TokenIdType>(*golden);
+    std::fill_n(goldenPtr, batchSize * mMaxGuessSetSize * mNgramLength, 0);
+    for (SizeType32 gi = 0; gi < 3; ++gi)
+    {
+        goldenPtr[gi * mNgramLength + 0] = 3;
+        goldenPtr[gi * mNgramLength + 1] = 5;
+        goldenPtr[gi * mNgramLength + 2] = 6;
+    }
+    bufferCast<TokenIdType>(*newLastTokens)[0] = 2;
+    bufferCast<TokenIdType>(*newLastTokens)[1] = 6;
+    std::fill_n(bufferCast<TokenIdType>(*endIds), maxBatchSize, 9);
+
+    tksd::invokeVerifyLookaheadGuesses(mParams, bufferCast<TokenIdType>(*mGuessTokens),
+        bufferCast<SizeType32>(*mNumGuesses), goldenPtr, bufferCast<TokenIdType>(*newLastTokens),
+        bufferCast<TokenIdType>(*endIds), bufferCast<TokenIdType>(*accepted), bufferCast<SizeType32>(*acceptedLengths),
+        bufferCast<SizeType32>(*bestGuessIds), mStream->get());
+    mStream->synchronize();
+
+    // [2, 3, 9] and [2, 3, 4] both match two tokens, the first one wins.
+    EXPECT_EQ(bufferCast<SizeType32>(*acceptedLengths)[0], 3);
+    EXPECT_EQ(bufferCast<SizeType32>(*bestGuessIds)[0], 1);
+    auto const* accepted0 = bufferCast<TokenIdType>(*accepted);
+    EXPECT_EQ(accepted0[0], 2);
+    EXPECT_EQ(accepted0[1], 3);
+    EXPECT_EQ(accepted0[2], 5);
+
+    EXPECT_EQ(bufferCast<SizeType32>(*acceptedLengths)[2], 1);
+    EXPECT_EQ(bufferCast<TokenIdType>(*accepted)[2 * (mNgramLength + 1)], 6);
+}
+
+} // namespace
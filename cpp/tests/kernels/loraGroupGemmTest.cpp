@@ -0,0 +1,399 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/groupGemm.h"
+#include "tensorrt_llm/kernels/loraGroupGemmParams.h"
+#include "tensorrt_llm/kernels/loraSegmentedGemv.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Two LoRA modules over four requests. In the first module the first two requests share their weights and the third
+// request has no LoRA. The problems setupLoraGroupGemmParams writes on the device must match the per problem host
+// vectors the LoRA plugin builds, and the grouped GEMMs over both must give the same outputs as a GEMM on the host.
+// The segmented GEMV over the same request table must match the grouped GEMMs.
+class LoraGroupGemmTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || tc::getSMVersion() < 80)
+        {
+            GTEST_SKIP() << "LoRA grouped GEMM requires SM80+";
+        }
+        mStream = std::make_shared<CudaStream>();
+
+        auto const numTokens = std::accumulate(mNumTokens.begin(), mNumTokens.end(), 0);
+        mMaxContextLength = *std::max_element(mNumTokens.begin(), mNumTokens.end());
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        mInput = BufferManager::pinned(ITensor::makeShape({numTokens, mHiddenSize}), nvinfer1::DataType::kHALF);
+        std::generate_n(bufferCast<half>(*mInput), mInput->getSize(), [&]() { return half(dist(gen)); });
+
+        // One pair of weights per request, the first request of the first module lends its pair to the second one
+        mWeightsPtrs
+            = BufferManager::pinned(ITensor::makeShape({kNumModules, kBatchSize, 2}), nvinfer1::DataType::kINT64);
+        auto* weightsPtrs = bufferCast<std::int64_t>(*mWeightsPtrs);
+        for (SizeType32 m = 0; m < kNumModules; ++m)
+        {
+            for (SizeType32 r = 0; r < kBatchSize; ++r)
+            {
+                auto const rank = mRanks[m * kBatchSize + r];
+                auto inWeights
+                    = BufferManager::pinned(ITensor::makeShape({rank, mHiddenSize}), nvinfer1::DataType::kHALF);
+                auto outWeights
+                    = BufferManager::pinned(ITensor::makeShape({mOutHiddenSizes[m], rank}), nvinfer1::DataType::kHALF);
+                std::generate_n(bufferCast<half>(*inWeights), inWeights->getSize(), [&]() { return half(dist(gen)); });
+                std::generate_n(
+                    bufferCast<half>(*outWeights), outWeights->getSize(), [&]() { return half(dist(gen)); });
+                weightsPtrs[(m * kBatchSize + r) * 2] = reinterpret_cast<std::int64_t>(inWeights->data());
+                weightsPtrs[(m * kBatchSize + r) * 2 + 1] = reinterpret_cast<std::int64_t>(outWeights->data());
+                mWeights.push_back(std::move(inWeights));
+                mWeights.push_back(std::move(outWeights));
+            }
+        }
+        weightsPtrs[2] = weightsPtrs[0];
+        weightsPtrs[3] = weightsPtrs[1];
+
+        mLowRankSize = kBatchSize * mMaxContextLength * kMaxLowRank;
+        mParamsSize = tk::getGroupedGemmParamsWorkSpaceSize(kNumModules * kBatchSize);
+        mGemmWorkspace = BufferManager::pinned(ITensor::makeShape({kGemmWorkspaceSize}), nvinfer1::DataType::kINT8);
+
+        // The request table is read on the device
+        auto const toPinned = [](std::vector<SizeType32> const& values)
+        {
+            auto buffer = BufferManager::pinned(
+                ITensor::makeShape({static_cast<SizeType32>(values.size())}), nvinfer1::DataType::kINT32);
+            std::copy(values.begin(), values.end(), bufferCast<SizeType32>(*buffer));
+            return buffer;
+        };
+        mRanksBuffer = toPinned(mRanks);
+        mNumTokensBuffer = toPinned(mNumTokens);
+        mOutHiddenSizesBuffer = toPinned(mOutHiddenSizes);
+        mOutputPtrs = BufferManager::pinned(ITensor::makeShape({kNumModules}), nvinfer1::DataType::kINT64);
+    }
+
+    //! \brief Output buffers of the modules and the low rank buffer, all zero.
+    void allocOutputs(std::vector<ITensor::SharedPtr>& outputs, ITensor::SharedPtr& lowRank) const
+    {
+        auto const numTokens = static_cast<SizeType32>(mInput->getShape().d[0]);
+        outputs.clear();
+        for (SizeType32 m = 0; m < kNumModules; ++m)
+        {
+            outputs.push_back(
+                BufferManager::pinned(ITensor::makeShape({numTokens, mOutHiddenSizes[m]}), nvinfer1::DataType::kHALF));
+            std::fill_n(bufferCast<half>(*outputs.back()), outputs.back()->getSize(), half(0.f));
+        }
+        lowRank = BufferManager::pinned(ITensor::makeShape({kNumModules * mLowRankSize}), nvinfer1::DataType::kHALF);
+        std::fill_n(bufferCast<half>(*lowRank), lowRank->getSize(), half(0.f));
+    }
+
+    //! \brief The in and out problems the LoRA plugin builds on the host, runs of requests sharing weights merged.
+    //! Each problem is keyed by module * batch_size + its first request.
+    struct HostProblems
+    {
+        std::vector<SizeType32> index;
+        std::vector<cutlass::gemm::GemmCoord> sizes, sizes2;
+        std::vector<void*> ptrA, ptrB, ptrC, ptrA2, ptrB2, ptrC2;
+    };
+
+    HostProblems buildHostProblems(std::vector<ITensor::SharedPtr> const& outputs, ITensor& lowRank) const
+    {
+        HostProblems problems;
+        auto const* weightsPtrs = bufferCast<std::int64_t>(*mWeightsPtrs);
+        auto* input = static_cast<char*>(mInput->data());
+        auto* lowRankBase = static_cast<char*>(lowRank.data());
+        std::int64_t const K = mHiddenSize;
+        std::int64_t const typeSize = sizeof(half);
+        for (SizeType32 m = 0; m < kNumModules; ++m)
+        {
+            auto const* ranks = mRanks.data() + m * kBatchSize;
+            auto const* ptrs = weightsPtrs + m * kBatchSize * 2;
+            std::int64_t const N2 = mOutHiddenSizes[m];
+            SizeType32 r = 0;
+            std::int64_t handled = 0;
+            while (r < kBatchSize)
+            {
+                SizeType32 count = 0;
+                std::int64_t M = 0;
+                while (r + count < kBatchSize && ranks[r] == ranks[r + count] && ptrs[r * 2] == ptrs[(r + count) * 2]
+                    && ptrs[r * 2 + 1] == ptrs[(r + count) * 2 + 1])
+                {
+                    M += mNumTokens[r + count];
+                    ++count;
+                }
+                std::int64_t const N = ranks[r];
+                if (N > 0)
+                {
+                    auto* low = lowRankBase + (m * mLowRankSize + handled * kMaxLowRank) * typeSize;
+                    auto* out = static_cast<char*>(outputs[m]->data()) + handled * N2 * typeSize;
+                    problems.index.push_back(m * kBatchSize + r);
+                    problems.sizes.emplace_back(M, N, K);
+                    problems.ptrA.push_back(input + handled * K * typeSize);
+                    problems.ptrB.push_back(reinterpret_cast<void*>(ptrs[r * 2]));
+                    problems.ptrC.push_back(low);
+                    problems.sizes2.emplace_back(M, N2, N);
+                    problems.ptrA2.push_back(low);
+                    problems.ptrB2.push_back(reinterpret_cast<void*>(ptrs[r * 2 + 1]));
+                    problems.ptrC2.push_back(out);
+                }
+                handled += M;
+                r += count;
+            }
+        }
+        return problems;
+    }
+
+    //! \brief The request table of the fixture, in device accessible memory, writing to `outputs`.
+    tk::LoraGroupGemmRequests makeRequests(std::vector<ITensor::SharedPtr> const& outputs) const
+    {
+        auto* outputPtrs = bufferCast<std::int64_t>(*mOutputPtrs);
+        for (SizeType32 m = 0; m < kNumModules; ++m)
+        {
+            outputPtrs[m] = reinterpret_cast<std::int64_t>(outputs[m]->data());
+        }
+        return tk::LoraGroupGemmRequests{bufferCast<SizeType32>(*mRanksBuffer), bufferCast<std::int64_t>(*mWeightsPtrs),
+            bufferCast<SizeType32>(*mNumTokensBuffer), outputPtrs, bufferCast<SizeType32>(*mOutHiddenSizesBuffer)};
+    }
+
+    //! \brief Runs the grouped GEMMs over the problems written by setupLoraGroupGemmParams.
+    void runDevice(std::vector<ITensor::SharedPtr> const& outputs, ITensor& lowRank, ITensor& inParams,
+        ITensor& outParams) const
+    {
+        tk::setupLoraGroupGemmParams(makeRequests(outputs), kBatchSize, kNumModules, mInput->data(), mHiddenSize,
+            lowRank.data(), mMaxContextLength, kMaxLowRank, 0, nvinfer1::DataType::kHALF, inParams.data(),
+            outParams.data(), mStream->get());
+        auto const problemCount = kNumModules * kBatchSize;
+        tk::groupedGemm(problemCount, inParams.data(), mGemmWorkspace->data(), kGemmWorkspaceSize, true,
+            nvinfer1::DataType::kHALF, mStream->get());
+        tk::groupedGemm(problemCount, outParams.data(), mGemmWorkspace->data(), kGemmWorkspaceSize, false,
+            nvinfer1::DataType::kHALF, mStream->get());
+        mStream->synchronize();
+    }
+
+    //! \brief Runs the grouped GEMMs over the host problem vectors, as the LoRA plugin does.
+    void runHost(HostProblems const& problems, ITensor& params) const
+    {
+        tk::groupedGemm(problems.sizes, problems.ptrA, problems.ptrB, problems.ptrC, problems.ptrC, params.data(),
+            mParamsSize, mGemmWorkspace->data(), kGemmWorkspaceSize, true, nvinfer1::DataType::kHALF, mStream->get());
+        tk::groupedGemm(problems.sizes2, problems.ptrA2, problems.ptrB2, problems.ptrC2, problems.ptrC2, params.data(),
+            mParamsSize, mGemmWorkspace->data(), kGemmWorkspaceSize, false, nvinfer1::DataType::kHALF, mStream->get());
+        mStream->synchronize();
+    }
+
+    //! \brief The LoRA of module `m` on the host, the low rank results rounded to half as on the device.
+    std::vector<float> referenceLora(SizeType32 m) const
+    {
+        auto const* input = bufferCast<half>(*mInput);
+        auto const* weightsPtrs = bufferCast<std::int64_t>(*mWeightsPtrs);
+        auto const N2 = mOutHiddenSizes[m];
+        std::vector<float> output;
+        SizeType32 token = 0;
+        for (SizeType32 r = 0; r < kBatchSize; ++r)
+        {
+            auto const N = mRanks[m * kBatchSize + r];
+            auto const* inWeights = reinterpret_cast<half const*>(weightsPtrs[(m * kBatchSize + r) * 2]);
+            auto const* outWeights = reinterpret_cast<half const*>(weightsPtrs[(m * kBatchSize + r) * 2 + 1]);
+            for (SizeType32 t = 0; t < mNumTokens[r]; ++t, ++token)
+            {
+                std::vector<float> low(N);
+                for (SizeType32 n = 0; n < N; ++n)
+                {
+                    float acc = 0.f;
+                    for (SizeType32 k = 0; k < mHiddenSize; ++k)
+                    {
+                        acc += float(input[token * mHiddenSize + k]) * float(inWeights[n * mHiddenSize + k]);
+                    }
+                    low[n] = float(half(acc));
+                }
+                for (SizeType32 j = 0; j < N2; ++j)
+                {
+                    float acc = 0.f;
+                    for (SizeType32 n = 0; n < N; ++n)
+                    {
+                        acc += low[n] * float(outWeights[j * N + n]);
+                    }
+                    output.push_back(acc);
+                }
+            }
+        }
+        return output;
+    }
+
+    static void expectNear(ITensor const& actual, std::vector<float> const& expected, float relTol)
+    {
+        ASSERT_EQ(actual.getSize(), expected.size());
+        auto const* out = bufferCast<half>(actual);
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_NEAR(float(out[i]), expected[i], relTol * std::max(1.f, std::abs(expected[i]))) << "index " << i;
+        }
+    }
+
+protected:
+    static constexpr SizeType32 kNumModules{2};
+    static constexpr SizeType32 kBatchSize{4};
+    static constexpr SizeType32 kMaxLowRank{16};
+    static constexpr SizeType32 kGemmWorkspaceSize{4 * 1024 * 1024};
+
+    std::shared_ptr<CudaStream> mStream;
+
+    SizeType32 mHiddenSize{64};
+    std::vector<SizeType32> mNumTokens{3, 1, 5, 2};
+    // [num_modules, batch_size]
+    std::vector<SizeType32> mRanks{8, 8, 0, 16, 8, 16, 16, 8};
+    std::vector<SizeType32> mOutHiddenSizes{64, 32};
+    SizeType32 mMaxContextLength{0};
+    std::int64_t mLowRankSize{0};
+    std::int64_t mParamsSize{0};
+
+    ITensor::SharedPtr mInput;
+    ITensor::SharedPtr mWeightsPtrs;
+    ITensor::SharedPtr mRanksBuffer;
+    ITensor::SharedPtr mNumTokensBuffer;
+    ITensor::SharedPtr mOutHiddenSizesBuffer;
+    ITensor::SharedPtr mOutputPtrs;
+    ITensor::SharedPtr mGemmWorkspace;
+    std::vector<ITensor::SharedPtr> mWeights;
+};
+
+TEST_F(LoraGroupGemmTest, DeviceParamsMatchHostProblems)
+{
+    std::vector<ITensor::SharedPtr> outputs;
+    ITensor::SharedPtr lowRank;
+    allocOutputs(outputs, lowRank);
+    auto const problems = buildHostProblems(outputs, *lowRank);
+
+    auto const problemCount = kNumModules * kBatchSize;
+    auto inParams = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    auto outParams = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    runDevice(outputs, *lowRank, *inParams, *outParams);
+
+    auto const in = tk::getGroupedGemmParams(inParams->data(), problemCount);
+    auto const out = tk::getGroupedGemmParams(outParams->data(), problemCount);
+    std::size_t next = 0;
+    for (SizeType32 i = 0; i < problemCount; ++i)
+    {
+        SCOPED_TRACE(i);
+        if (next == problems.index.size() || problems.index[next] != i)
+        {
+            // Merged into the problem of a previous request or without LoRA
+            EXPECT_EQ(in.problem_sizes[i].m(), 0);
+            EXPECT_EQ(out.problem_sizes[i].m(), 0);
+            continue;
+        }
+        auto const& size = problems.sizes[next];
+        auto const& size2 = problems.sizes2[next];
+        EXPECT_EQ(in.problem_sizes[i], size);
+        EXPECT_EQ(in.ptrA[i], problems.ptrA[next]);
+        EXPECT_EQ(in.ptrB[i], problems.ptrB[next]);
+        EXPECT_EQ(in.ptrC[i], problems.ptrC[next]);
+        EXPECT_EQ(in.ptrD[i], problems.ptrC[next]);
+        EXPECT_EQ(in.lda[i], size.k());
+        EXPECT_EQ(in.ldb[i], size.k());
+        EXPECT_EQ(in.ldc[i], size.n());
+        EXPECT_EQ(in.ldd[i], size.n());
+        EXPECT_EQ(out.problem_sizes[i], size2);
+        EXPECT_EQ(out.ptrA[i], problems.ptrA2[next]);
+        EXPECT_EQ(out.ptrB[i], problems.ptrB2[next]);
+        EXPECT_EQ(out.ptrC[i], problems.ptrC2[next]);
+        EXPECT_EQ(out.ptrD[i], problems.ptrC2[next]);
+        EXPECT_EQ(out.lda[i], size2.k());
+        EXPECT_EQ(out.ldb[i], size2.k());
+        EXPECT_EQ(out.ldc[i], size2.n());
+        EXPECT_EQ(out.ldd[i], size2.n());
+        ++next;
+    }
+    EXPECT_EQ(next, problems.index.size());
+}
+
+TEST_F(LoraGroupGemmTest, DeviceParamsMatchHostPath)
+{
+    std::vector<ITensor::SharedPtr> hostOutputs;
+    ITensor::SharedPtr hostLowRank;
+    allocOutputs(hostOutputs, hostLowRank);
+    auto hostParams = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    runHost(buildHostProblems(hostOutputs, *hostLowRank), *hostParams);
+
+    std::vector<ITensor::SharedPtr> outputs;
+    ITensor::SharedPtr lowRank;
+    allocOutputs(outputs, lowRank);
+    auto inParams = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    auto outParams = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    runDevice(outputs, *lowRank, *inParams, *outParams);
+
+    for (SizeType32 m = 0; m < kNumModules; ++m)
+    {
+        SCOPED_TRACE(m);
+        auto const expected = referenceLora(m);
+        expectNear(*hostOutputs[m], expected, 2e-2f);
+        // Same kernels over the same problems, only the problem scheduling differs
+        auto const* hostOut = bufferCast<half>(*hostOutputs[m]);
+        auto const* out = bufferCast<half>(*outputs[m]);
+        for (std::size_t i = 0; i < outputs[m]->getSize(); ++i)
+        {
+            ASSERT_EQ(float(out[i]), float(hostOut[i])) << "index " << i;
+        }
+    }
+}
+
+TEST_F(LoraGroupGemmTest, SegmentedGemvMatchesGroupedGemm)
+{
+    std::vector<ITensor::SharedPtr> gemmOutputs;
+    ITensor::SharedPtr gemmLowRank;
+    allocOutputs(gemmOutputs, gemmLowRank);
+    auto params = BufferManager::pinned(ITensor::makeShape({mParamsSize}), nvinfer1::DataType::kINT8);
+    runHost(buildHostProblems(gemmOutputs, *gemmLowRank), *params);
+
+    // The rows of the request without LoRA must be zeroed, not left as they are
+    std::vector<ITensor::SharedPtr> outputs;
+    ITensor::SharedPtr lowRank;
+    allocOutputs(outputs, lowRank);
+    for (auto const& output : outputs)
+    {
+        std::fill_n(bufferCast<half>(*output), output->getSize(), half(7.f));
+    }
+    tk::loraSegmentedGemv(makeRequests(outputs), kBatchSize, kNumModules, mInput->data(), mHiddenSize,
+        *std::max_element(mOutHiddenSizes.begin(), mOutHiddenSizes.end()), lowRank->data(), mMaxContextLength,
+        kMaxLowRank, 0, nvinfer1::DataType::kHALF, mStream->get());
+    mStream->synchronize();
+
+    for (SizeType32 m = 0; m < kNumModules; ++m)
+    {
+        SCOPED_TRACE(m);
+        auto const* gemmOut = bufferCast<half>(*gemmOutputs[m]);
+        std::vector<float> const expected(gemmOut, gemmOut + gemmOutputs[m]->getSize());
+        expectNear(*outputs[m], expected, 2e-2f);
+    }
+}
+
+} // namespace
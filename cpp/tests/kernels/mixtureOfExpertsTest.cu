@@ -4,8 +4,14 @@
 #include "tensorrt_llm/runtime/cudaStream.h"
 
 #include <algorithm>
+#include <condition_variable>
+#include <exception>
 #include <gtest/gtest.h>
+#include <limits>
+#include <mutex>
 #include <numeric>
+#include <random>
+#include <thread>
 
 #include "tensorrt_llm/kernels/mixtureOfExperts/moe_kernels.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
@@ -84,6 +90,88 @@ using SafeFP8 = __nv_fp8_e4m3;
 using SafeFP8 = void;
 #endif
 
+// All-to-all transport between EP ranks run by threads of this process on the same device. Every exchange is a
+// rendezvous: the ranks publish their send buffers, copy the chunks they receive from the peers and wait for each other
+// before the send buffers can be reused.
+class InProcessAllToAllTransport : public MoeAllToAllTransport
+{
+public:
+    struct Group
+    {
+        struct Post
+        {
+            void const* send_buf;
+            std::vector<std::vector<Chunk>> const* send_chunks;
+        };
+
+        explicit Group(int size)
+            : size{size}
+            , posts(size)
+        {
+        }
+
+        void barrier()
+        {
+            std::unique_lock lock{mutex};
+            auto const generation = barrier_generation;
+            if (++barrier_count == size)
+            {
+                barrier_count = 0;
+                ++barrier_generation;
+                cv.notify_all();
+                return;
+            }
+            cv.wait(lock, [&] { return generation != barrier_generation; });
+        }
+
+        int const size;
+        std::vector<Post> posts;
+        std::mutex mutex;
+        std::condition_variable cv;
+        int barrier_count{0};
+        int barrier_generation{0};
+    };
+
+    InProcessAllToAllTransport(std::shared_ptr<Group> group, int rank)
+        : mGroup{std::move(group)}
+        , mRank{rank}
+    {
+    }
+
+    void exchange(void const* send_buf, std::vector<std::vector<Chunk>> const& send_chunks, void* recv_buf,
+        std::vector<std::vector<Chunk>> const& recv_chunks, size_t row_bytes, cudaStream_t stream) override
+    {
+        check_cuda_error(cudaStreamSynchronize(stream));
+        mGroup->posts[mRank] = {send_buf, &send_chunks};
+        mGroup->barrier();
+        for (int peer = 0; peer < mGroup->size; ++peer)
+        {
+            auto const& post = mGroup->posts[peer];
+            auto const& peer_chunks = post.send_chunks->at(mRank);
+            EXPECT_EQ(peer_chunks.size(), recv_chunks[peer].size()) << "rank " << mRank << ", peer " << peer;
+            for (size_t i = 0; i < std::min(peer_chunks.size(), recv_chunks[peer].size()); ++i)
+            {
+                auto const& src = peer_chunks[i];
+                auto const& dst = recv_chunks[peer][i];
+                EXPECT_EQ(src.num_rows, dst.num_rows) << "rank " << mRank << ", peer " << peer << ", chunk " << i;
+                if (dst.num_rows == 0)
+                {
+                    continue;
+                }
+                check_cuda_error(cudaMemcpyAsync(static_cast<char*>(recv_buf) + dst.offset * row_bytes,
+                    static_cast<char const*>(post.send_buf) + src.offset * row_bytes, dst.num_rows * row_bytes,
+                    cudaMemcpyDeviceToDevice, stream));
+            }
+        }
+        check_cuda_error(cudaStreamSynchronize(stream));
+        mGroup->barrier();
+    }
+
+private:
+    std::shared_ptr<Group> mGroup;
+    int mRank;
+};
+
 template <class TypeTuple_>
 class MixtureOfExpertsTest : public ::testing::Test
 {
@@ -615,6 +703,12 @@ protected:
             ep_scale_3 = mExpertFP8Scale3 + experts_per_node * parallelism_config.ep_rank;
         }
 
+        // The EP slices are contiguous, so ranks that run at the same time do not share the scratch buffer
+        if (parallelism_config.tp_size == 1)
+        {
+            return std::tuple{weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, ep_scale_1, ep_scale_2, ep_scale_3};
+        }
+
         // Slice weights for TP
         void* scale_1 = ep_scale_1;
         void* scale_2 = ep_scale_2;
@@ -665,44 +759,49 @@ protected:
         return std::tuple{weight_1, weight_2, bias_1, bias2_ptr, scale_1, scale_2, scale_3};
     }
 
-    void runMoEPermute(MOEParallelismConfig parallelism_config)
+    tensorrt_llm::cutlass_extensions::CutlassGemmConfig getTactic()
     {
-        // Clear the buffers to blank so we can assume zero if not written
-        resetOutBuffers();
-
-        auto const [weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, scale1_ptr, scale2_ptr, scale3_ptr]
-            = getWeights(parallelism_config);
-
-        auto stream = mStream->get();
-        auto tactic = mSelectedConfig;
-        if (!tactic)
+        if (mSelectedConfig)
         {
-            int sm = getSMVersion();
-            bool is_sm90 = sm >= 90 && !INT_QUANT;
-            auto tactics = mMoERunner.getTactics();
-            auto it = std::find_if(tactics.begin(), tactics.end(), [is_sm90](auto& c) { return c.is_sm90 == is_sm90; });
-            if (it == tactics.end())
-            {
-                // Fall back to any tactic
-                std::cout << "WARNING: Could not find config for sm version " << sm << std::endl;
-                tactic = tactics[0];
-            }
-            else
-            {
-                tactic = *it;
-            }
+            return *mSelectedConfig;
+        }
+        int sm = getSMVersion();
+        bool is_sm90 = sm >= 90 && !INT_QUANT;
+        auto tactics = mMoERunner.getTactics();
+        auto it = std::find_if(tactics.begin(), tactics.end(), [is_sm90](auto& c) { return c.is_sm90 == is_sm90; });
+        if (it == tactics.end())
+        {
+            // Fall back to any tactic
+            std::cout << "WARNING: Could not find config for sm version " << sm << std::endl;
+            return tactics[0];
         }
+        return *it;
+    }
 
-        QuantParams quant_params;
+    QuantParams getQuantParams(void const* scale1_ptr, void const* scale2_ptr, void const* scale3_ptr)
+    {
         if constexpr (INT_QUANT)
         {
-            quant_params = QuantParams::Int(scale1_ptr, scale2_ptr);
+            return QuantParams::Int(scale1_ptr, scale2_ptr);
         }
         else
         {
-            quant_params = QuantParams::FP8(static_cast<float const*>(scale1_ptr),
-                static_cast<float const*>(scale2_ptr), static_cast<float const*>(scale3_ptr));
+            return QuantParams::FP8(static_cast<float const*>(scale1_ptr), static_cast<float const*>(scale2_ptr),
+                static_cast<float const*>(scale3_ptr));
         }
+    }
+
+    void runMoEPermute(MOEParallelismConfig parallelism_config)
+    {
+        // Clear the buffers to blank so we can assume zero if not written
+        resetOutBuffers();
+
+        auto const [weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, scale1_ptr, scale2_ptr, scale3_ptr]
+            = getWeights(parallelism_config);
+
+        auto stream = mStream->get();
+        auto const tactic = getTactic();
+        auto const quant_params = getQuantParams(scale1_ptr, scale2_ptr, scale3_ptr);
 
         mMoERunner.setTactic(tactic);
         mMoERunner.runMoe(mInputTensor, mInputProbabilities, weight1_ptr, bias1_ptr, mActType, weight2_ptr, bias2_ptr,
@@ -713,6 +812,40 @@ protected:
         check_cuda_error(cudaStreamSynchronize(stream));
     }
 
+    //! \brief Calls fn(rank) for each rank on its own thread, for ranks that communicate while they run.
+    template <class Fn>
+    void runRanksConcurrently(int num_ranks, Fn&& fn)
+    {
+        std::vector<std::exception_ptr> errors(num_ranks);
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_ranks; i++)
+        {
+            threads.emplace_back(
+                [&, i]()
+                {
+                    try
+                    {
+                        fn(i);
+                    }
+                    catch (...)
+                    {
+                        errors[i] = std::current_exception();
+                    }
+                });
+        }
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+        for (auto const& error : errors)
+        {
+            if (error)
+            {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+
     template <class T>
     std::vector<T> getDataFromDevice(T const* in, size_t length)
     {
@@ -962,9 +1095,21 @@ protected:
 
     void BasicPermuteTest(int k = 1, int64_t hidden_size = DEFAULT_HIDDEN_SIZE);
 
+    void RoutingSortTest(int64_t num_tokens, int k);
+
+    void ExpertCacheTest(int k, int num_slots);
+
+    void ExpertCapacityTest(bool reroute_overflow);
+
     std::vector<int> calcPermuteMapExpertParallel(std::vector<int> const& expected_experts);
     void ExpertParallelTest(int k = 1);
 
+    void ExpertParallelAllToAllTest(int k = 1);
+
+    void SharedExpertsTest(int k, int num_shared);
+
+    void FusedAllReduceTest(int k = 1);
+
     void TensorParallelTest(int k = 1);
 
     void MixedParallelTest(int k = 1);
@@ -1107,6 +1252,193 @@ TYPED_TEST(MixtureOfExpertsTest, PermuteSwiglu)
     this->BasicPermuteTest(3);
 }
 
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::RoutingSortTest(int64_t num_tokens, int k)
+{
+    if constexpr (FP8)
+    {
+        // TODO Remove this when bias + FP8 is supported
+        mUseBias = false;
+    }
+
+    int64_t const hidden_size = DEFAULT_HIDDEN_SIZE;
+    int64_t const num_experts = 8;
+
+    std::vector<DataType> hidden_states(hidden_size * num_tokens);
+    auto raw_unquant_input = populateTokens(hidden_states);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    std::vector<float> probs(num_experts * num_tokens);
+    std::generate(probs.begin(), probs.end(), [&]() { return dist(gen); });
+
+    runMoEPermute({hidden_states}, {probs}, hidden_size, num_experts, k);
+
+    auto selected_expert = getDataFromDevice(mSelectedExpert, num_tokens * k);
+    compareSoftmax(selected_expert, probs);
+
+    // The routing sort is a stable sort of the (token, k) pairs by expert, the map is indexed by k then token
+    std::vector<int> sorted(num_tokens * k);
+    std::iota(sorted.begin(), sorted.end(), 0);
+    std::stable_sort(sorted.begin(), sorted.end(),
+        [&](int a, int b) { return selected_expert[a] < selected_expert[b]; });
+    std::vector<int> permute_map(num_tokens * k);
+    for (int64_t dest = 0; dest < num_tokens * k; dest++)
+    {
+        int const token_id = sorted[dest] / k;
+        int const k_idx = sorted[dest] % k;
+        permute_map[k_idx * num_tokens + token_id] = dest;
+    }
+    auto proj_map = getDataFromDevice(mSourceToExpandedMap, num_tokens * k);
+    ASSERT_EQ(permute_map, proj_map);
+
+    compareFinal(selected_expert, probs, raw_unquant_input);
+}
+
+// Up to 1024 expanded rows are sorted by a single block kernel, larger batches by the radix sort
+TYPED_TEST(MixtureOfExpertsTest, RoutingSortSmallBatch)
+{
+    this->RoutingSortTest(300, 2);
+    this->RoutingSortTest(512, 2);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, RoutingSortLargeBatch)
+{
+    this->RoutingSortTest(1100, 1);
+    this->RoutingSortTest(513, 2);
+}
+
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::ExpertCacheTest(int k, int num_slots)
+{
+    int64_t const hidden_size = DEFAULT_HIDDEN_SIZE;
+    int64_t const num_experts = 4;
+    int64_t const num_tokens = 3;
+    size_t const gated_multiplier = tensorrt_llm::isGatedActivation(mActType) ? 2 : 1;
+    size_t const expert_matrix_bytes = hidden_size * hidden_size * 4 * sizeof(WeightStorage);
+
+    auto const stream = mStream->get();
+    auto fc1_slots = mBufferManager->gpu(num_slots * expert_matrix_bytes * gated_multiplier);
+    auto fc2_slots = mBufferManager->gpu(num_slots * expert_matrix_bytes);
+    auto slot_expert = mBufferManager->gpu(num_slots * sizeof(int));
+    auto slot_last_use = mBufferManager->gpu(num_slots * sizeof(int64_t));
+    auto step = mBufferManager->gpu(sizeof(int64_t));
+    check_cuda_error(cudaMemsetAsync(slot_expert->data(), 0xFF, slot_expert->getSizeInBytes(), stream));
+    check_cuda_error(cudaMemsetAsync(slot_last_use->data(), 0, slot_last_use->getSizeInBytes(), stream));
+    check_cuda_error(cudaMemsetAsync(step->data(), 0, step->getSizeInBytes(), stream));
+
+    // The weights stay in device memory, the runner only sees them through their address like mapped host memory
+    auto cache = std::make_shared<MoeExpertCache>();
+    cache->fc1_slots = fc1_slots->data();
+    cache->fc2_slots = fc2_slots->data();
+    cache->num_slots = num_slots;
+    cache->slot_expert = static_cast<int*>(slot_expert->data());
+    cache->slot_last_use = static_cast<int64_t*>(slot_last_use->data());
+    cache->step = static_cast<int64_t*>(step->data());
+    mMoERunner.expert_cache = cache;
+
+    std::vector<DataType> hidden_states(hidden_size * num_tokens);
+    auto raw_unquant_input = populateTokens(hidden_states);
+
+    std::vector<float> probs = {
+        0.5, 0.1, 0.25, 0.15,   //
+        0.03, 0.2, 0.07, 0.7,   //
+        0.25, 0.21, 0.35, 0.19, //
+    };
+
+    std::vector<std::vector<DataType>> hidden_input = {hidden_states};
+    std::vector<std::vector<float>> router_input = {probs};
+    resizeRouterInputs(router_input, num_experts, num_tokens);
+
+    runMoEPermute(hidden_input, router_input, hidden_size, num_experts, k);
+    auto selected_expert = getDataFromDevice(mSelectedExpert, num_tokens * k);
+    compareFinal(selected_expert, router_input[0], raw_unquant_input);
+
+    // The second run starts with the experts left in the cache by the first one
+    runMoEPermute({});
+    compareFinal(selected_expert, router_input[0], raw_unquant_input);
+
+    mMoERunner.expert_cache.reset();
+}
+
+TYPED_TEST(MixtureOfExpertsTest, PermuteExpertCache)
+{
+    if (this->FP8)
+    {
+        GTEST_SKIP() << "The expert cache does not support quantized weights";
+    }
+
+    this->mUseBias = false;
+    // With fewer slots than active experts the layer runs in several rounds and evicts experts between them
+    for (int num_slots : {1, 2, 4})
+    {
+        this->ExpertCacheTest(1, num_slots);
+        this->ExpertCacheTest(2, num_slots);
+        this->ExpertCacheTest(3, num_slots);
+    }
+}
+
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::ExpertCapacityTest(bool reroute_overflow)
+{
+    int64_t const hidden_size = DEFAULT_HIDDEN_SIZE;
+    int64_t const num_experts = 4;
+    int64_t const num_tokens = 4;
+
+    // One row per expert, the first three tokens all prefer expert 0
+    mMoERunner.capacity_factor = 1.f;
+    mMoERunner.reroute_overflow = reroute_overflow;
+    auto overflow = mBufferManager->gpu((num_experts + 1) * sizeof(int64_t));
+    check_cuda_error(cudaMemsetAsync(overflow->data(), 0, overflow->getSizeInBytes(), mStream->get()));
+    mMoERunner.expert_overflow_counts = static_cast<int64_t*>(overflow->data());
+
+    std::vector<DataType> hidden_states(hidden_size * num_tokens);
+    auto raw_unquant_input = populateTokens(hidden_states);
+
+    std::vector<float> probs = {
+        0.5, 0.1, 0.25, 0.15, //
+        0.6, 0.1, 0.2, 0.1,   //
+        0.55, 0.1, 0.15, 0.2, //
+        0.1, 0.6, 0.2, 0.1,   //
+    };
+
+    std::vector<std::vector<DataType>> hidden_input = {hidden_states};
+    std::vector<std::vector<float>> router_input = {probs};
+    resizeRouterInputs(router_input, num_experts, num_tokens);
+
+    runMoEPermute(hidden_input, router_input, hidden_size, num_experts, 1);
+
+    // Dropped rows get the sentinel expert, rerouted rows move to the best expert that still has room
+    std::vector<int> expected_experts{0, 4, 4, 1};
+    std::vector<int64_t> expected_overflow{2, 0, 0, 0, 2};
+    if (reroute_overflow)
+    {
+        expected_experts = {0, 2, 3, 1};
+        expected_overflow.back() = 0;
+    }
+    auto selected_expert = getDataFromDevice(mSelectedExpert, num_tokens);
+    EXPECT_EQ(selected_expert, expected_experts);
+    EXPECT_EQ(getDataFromDevice(static_cast<int64_t const*>(overflow->data()), num_experts + 1), expected_overflow);
+    compareSoftmax(selected_expert, router_input[0]);
+    compareFinal(selected_expert, router_input[0], raw_unquant_input);
+
+    mMoERunner.capacity_factor = 0.f;
+    mMoERunner.reroute_overflow = false;
+    mMoERunner.expert_overflow_counts = nullptr;
+}
+
+TYPED_TEST(MixtureOfExpertsTest, ExpertCapacity)
+{
+    if (this->FP8)
+    {
+        // TODO Remove this when bias + FP8 is supported
+        this->mUseBias = false;
+    }
+
+    this->ExpertCapacityTest(false);
+    this->ExpertCapacityTest(true);
+}
+
 TYPED_TEST(MixtureOfExpertsTest, Finished)
 {
     if (this->FP8)
@@ -1273,6 +1605,402 @@ TYPED_TEST(MixtureOfExpertsTest, ExpertParallelSwiglu)
     this->ExpertParallelTest(2);
 }
 
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::ExpertParallelAllToAllTest(int k)
+{
+    // The rows are finalized by the rank that routed them, which does not hold the FC2 bias of remote experts
+    mUseBias = false;
+
+    int64_t hidden_size = DEFAULT_HIDDEN_SIZE;
+    int parallelism = 2;
+    int64_t num_experts = 4;
+    // Not a multiple of the EP size, the last rank routes fewer tokens
+    int64_t num_tokens = 3;
+
+    std::vector<DataType> hidden_states(hidden_size * num_tokens);
+    auto raw_unquant_input = populateTokens(hidden_states);
+
+    std::vector<float> probs = {
+        0.5, 0.1, 0.25, 0.15,   //
+        0.03, 0.2, 0.07, 0.7,   //
+        0.25, 0.21, 0.35, 0.19, //
+    };
+
+    std::vector<int> expected_experts{0, 3, 2};
+    if (k == 2)
+        expected_experts = {0, 2, 3, 1, 2, 0};
+
+    initBuffersPermute(
+        {hidden_states}, {probs}, hidden_size, num_experts, k, {}, MOEParallelismConfig{1, 0, parallelism, 0});
+    resetOutBuffers();
+
+    auto const tactic = getTactic();
+    auto const group = std::make_shared<InProcessAllToAllTransport::Group>(parallelism);
+
+    // Each rank has its own runner, stream, workspace and outputs, the inputs and weights are shared
+    struct Rank
+    {
+        CutlassMoeFCRunner<DataType, WeightType, OutputType> runner;
+        std::shared_ptr<CudaStream> stream;
+        char* workspace;
+        OutputType* final_output;
+        float* scale_probs;
+        int* source_to_expanded_map;
+        int* selected_expert;
+    };
+
+    std::vector<Rank> ranks(parallelism);
+    for (int i = 0; i < parallelism; i++)
+    {
+        auto& rank = ranks[i];
+        auto const parallelism_config = MOEParallelismConfig{1, 0, parallelism, i};
+        rank.runner.use_all_to_all = true;
+        rank.runner.all_to_all_transport = std::make_shared<InProcessAllToAllTransport>(group, i);
+        rank.runner.setTactic(tactic);
+        rank.stream = std::make_shared<CudaStream>();
+        rank.workspace = allocBuffer<char>(rank.runner.getWorkspaceSize(
+            mTotalTokens, mHiddenSize, mInterSize, mNumExperts, mK, mActType, parallelism_config));
+        rank.final_output = allocBuffer<OutputType>(mTotalTokens * mHiddenSize);
+        rank.scale_probs = allocBuffer<float>(mTotalTokens * mK);
+        rank.source_to_expanded_map = allocBuffer<int>(mTotalTokens * mK);
+        rank.selected_expert = allocBuffer<int>(mTotalTokens * mK);
+        check_cuda_error(cudaMemsetAsync(
+            rank.final_output, 0x0, mTotalTokens * mHiddenSize * sizeof(OutputType), mStream->get()));
+    }
+    check_cuda_error(cudaStreamSynchronize(mStream->get()));
+
+    runRanksConcurrently(parallelism,
+        [&](int i)
+        {
+            auto& rank = ranks[i];
+            auto const parallelism_config = MOEParallelismConfig{1, 0, parallelism, i};
+            auto const [weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, scale1_ptr, scale2_ptr, scale3_ptr]
+                = getWeights(parallelism_config);
+            rank.runner.runMoe(mInputTensor, mInputProbabilities, weight1_ptr, bias1_ptr, mActType, weight2_ptr,
+                bias2_ptr, getQuantParams(scale1_ptr, scale2_ptr, scale3_ptr), mTotalTokens, mHiddenSize, mInterSize,
+                mNumExperts, mK, rank.workspace, rank.final_output, mFinished, mActiveRows, rank.scale_probs,
+                rank.source_to_expanded_map, rank.selected_expert, parallelism_config, mNormMode, rank.stream->get());
+            rank.stream->synchronize();
+        });
+
+    // Without an allreduce, the output of every rank matches the single GPU reference
+    for (int i = 0; i < parallelism; i++)
+    {
+        auto results = getDataFromDevice(ranks[i].final_output, num_tokens * hidden_size);
+        compareFinal(expected_experts, probs, raw_unquant_input, results);
+    }
+}
+
+TYPED_TEST(MixtureOfExpertsTest, ExpertParallelAllToAll)
+{
+    this->ExpertParallelAllToAllTest();
+}
+
+TYPED_TEST(MixtureOfExpertsTest, ExpertParallelAllToAllK2)
+{
+    this->ExpertParallelAllToAllTest(2);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, ExpertParallelAllToAllRenorm)
+{
+    this->mNormMode = MOEExpertScaleNormalizationMode::RENORMALIZE;
+    this->ExpertParallelAllToAllTest(2);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, ExpertParallelAllToAllSwiglu)
+{
+    this->mActType = tensorrt_llm::ActivationType::Swiglu;
+    this->ExpertParallelAllToAllTest();
+    this->ExpertParallelAllToAllTest(2);
+}
+
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::SharedExpertsTest(int k, int num_shared)
+{
+    if constexpr (FP8)
+    {
+        // TODO Remove this when bias + FP8 is supported
+        mUseBias = false;
+    }
+
+    int64_t hidden_size = DEFAULT_HIDDEN_SIZE;
+    int64_t num_experts = 4;
+    int64_t num_tokens = 3;
+    int64_t const k_total = k + num_shared;
+
+    std::vector<DataType> hidden_states(hidden_size * num_tokens);
+    auto raw_unquant_input = populateTokens(hidden_states);
+
+    std::vector<float> probs = {
+        0.5, 0.1, 0.25, 0.15,   //
+        0.03, 0.2, 0.07, 0.7,   //
+        0.25, 0.21, 0.35, 0.19, //
+    };
+
+    // The fixture creates the weights of the experts in its router inputs. The shared experts follow the routed ones
+    // and get a zero probability, so the reference softmax over the padded inputs is the one of the routed experts
+    std::vector<float> padded_probs;
+    for (int64_t token_id = 0; token_id < num_tokens; token_id++)
+    {
+        auto const start = probs.begin() + token_id * num_experts;
+        padded_probs.insert(padded_probs.end(), start, start + num_experts);
+        padded_probs.insert(padded_probs.end(), num_shared, -std::numeric_limits<float>::infinity());
+    }
+
+    mMoERunner.num_shared_experts = num_shared;
+    initBuffersPermute({hidden_states}, {padded_probs}, hidden_size, num_experts + num_shared, k_total, {}, {});
+    resetOutBuffers();
+    // The router only sees the routed experts
+    check_cuda_error(cudaMemcpy(
+        mInputProbabilities, probs.data(), probs.size() * sizeof(float), cudaMemcpyHostToDevice));
+
+    auto const [weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, scale1_ptr, scale2_ptr, scale3_ptr] = getWeights({});
+    mMoERunner.setTactic(getTactic());
+    mMoERunner.runMoe(mInputTensor, mInputProbabilities, weight1_ptr, bias1_ptr, mActType, weight2_ptr, bias2_ptr,
+        getQuantParams(scale1_ptr, scale2_ptr, scale3_ptr), mTotalTokens, mHiddenSize, mInterSize, num_experts, k,
+        mWorkspace, mFinalOutput, mFinished, mActiveRows, mScaleProbs, mSourceToExpandedMap, mSelectedExpert, {},
+        mNormMode, mStream->get());
+    check_cuda_error(cudaStreamSynchronize(mStream->get()));
+    mMoERunner.num_shared_experts = 0;
+
+    std::vector<int> expected_experts{0, 3, 2};
+    if (k == 2)
+        expected_experts = {0, 2, 3, 1, 2, 0};
+
+    // The reference is a separate dense MLP per shared expert added to the routed experts with a scale of one
+    auto selected_expert = getDataFromDevice(mSelectedExpert, num_tokens * k_total);
+    auto final_results = getDataFromDevice(mFinalOutput, num_tokens * hidden_size);
+    auto softmax_probs = softmax(padded_probs);
+    for (int64_t token_id = 0; token_id < num_tokens; token_id++)
+    {
+        float const* token_probs = &softmax_probs[token_id * mNumExperts];
+        int const* token_experts = &expected_experts[token_id * k];
+        float routed_sum = 0.f;
+        for (int k_idx = 0; k_idx < k; k_idx++)
+        {
+            EXPECT_EQ(selected_expert[token_id * k_total + k_idx], token_experts[k_idx]);
+            routed_sum += token_probs[token_experts[k_idx]];
+        }
+        for (int shared_idx = 0; shared_idx < num_shared; shared_idx++)
+        {
+            EXPECT_EQ(selected_expert[token_id * k_total + k + shared_idx], num_experts + shared_idx);
+        }
+        float const norm_factor = mNormMode == MOEExpertScaleNormalizationMode::RENORMALIZE ? 1.f / routed_sum : 1.f;
+
+        for (int64_t hidden_id = 0; hidden_id < hidden_size; hidden_id++)
+        {
+            float const input = static_cast<float>(raw_unquant_input[token_id * hidden_size + hidden_id]);
+            float sum = 0.0f;
+            for (int k_idx = 0; k_idx < k; k_idx++)
+            {
+                int const expert = token_experts[k_idx];
+                sum += calcMLPValWithFinalBias(input, expert) * token_probs[expert] * norm_factor;
+            }
+            for (int shared_idx = 0; shared_idx < num_shared; shared_idx++)
+            {
+                sum += calcMLPValWithFinalBias(input, num_experts + shared_idx);
+            }
+
+            ASSERT_NEAR(OutputType{sum}, final_results[token_id * hidden_size + hidden_id], getTolerance(sum))
+                << "Incorrect final value at position: " << token_id * hidden_size + hidden_id;
+        }
+    }
+}
+
+TYPED_TEST(MixtureOfExpertsTest, SharedExperts)
+{
+    this->SharedExpertsTest(1, 1);
+    this->SharedExpertsTest(2, 2);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, SharedExpertsRenorm)
+{
+    this->mNormMode = MOEExpertScaleNormalizationMode::RENORMALIZE;
+    this->SharedExpertsTest(2, 1);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, SharedExpertsSwiglu)
+{
+    this->mActType = tensorrt_llm::ActivationType::Swiglu;
+    this->SharedExpertsTest(1, 1);
+    this->SharedExpertsTest(2, 2);
+}
+
+template <class TypeParam_>
+void MixtureOfExpertsTest<TypeParam_>::FusedAllReduceTest(int k)
+{
+    if constexpr (!std::is_same_v<DataType, OutputType>)
+    {
+        GTEST_SKIP() << "The fused all reduce requires the MoE output in the activation type";
+    }
+    else
+    {
+        int64_t hidden_size = DEFAULT_HIDDEN_SIZE;
+        int parallelism = 2;
+        int64_t num_experts = 4;
+        int64_t num_tokens = 3;
+        float const eps = 1e-5f;
+
+        std::vector<DataType> hidden_states(hidden_size * num_tokens);
+        populateTokens(hidden_states);
+
+        std::vector<float> probs = {
+            0.5, 0.1, 0.25, 0.15,   //
+            0.03, 0.2, 0.07, 0.7,   //
+            0.25, 0.21, 0.35, 0.19, //
+        };
+
+        initBuffersPermute(
+            {hidden_states}, {probs}, hidden_size, num_experts, k, {}, MOEParallelismConfig{1, 0, parallelism, 0});
+
+        // The reference is the unfused finalize of each EP rank, summed, followed by the residual add and RMS norm
+        std::vector<float> moe_output(num_tokens * hidden_size, 0.f);
+        for (int i = 0; i < parallelism; i++)
+        {
+            runMoEPermute(MOEParallelismConfig{1, 0, parallelism, i});
+            auto const rank_output = getDataFromDevice(mFinalOutput, num_tokens * hidden_size);
+            std::transform(moe_output.begin(), moe_output.end(), rank_output.begin(), moe_output.begin(),
+                [](float acc, OutputType v) { return acc + static_cast<float>(v); });
+        }
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::vector<OutputType> h_residual(num_tokens * hidden_size);
+        std::generate(h_residual.begin(), h_residual.end(), [&]() { return OutputType(dist(gen)); });
+        std::vector<OutputType> h_norm_weight(hidden_size);
+        std::generate(h_norm_weight.begin(), h_norm_weight.end(), [&]() { return OutputType(1.f + 0.5f * dist(gen)); });
+
+        std::vector<float> expected_residual(num_tokens * hidden_size);
+        std::vector<float> expected_output(num_tokens * hidden_size);
+        for (int64_t token_id = 0; token_id < num_tokens; token_id++)
+        {
+            float square_sum = 0.f;
+            for (int64_t hidden_id = 0; hidden_id < hidden_size; hidden_id++)
+            {
+                auto const idx = token_id * hidden_size + hidden_id;
+                expected_residual[idx] = moe_output[idx] + static_cast<float>(h_residual[idx]);
+                square_sum += expected_residual[idx] * expected_residual[idx];
+            }
+            float const denom = 1.f / std::sqrt(square_sum / hidden_size + eps);
+            for (int64_t hidden_id = 0; hidden_id < hidden_size; hidden_id++)
+            {
+                auto const idx = token_id * hidden_size + hidden_id;
+                expected_output[idx] = expected_residual[idx] * denom * static_cast<float>(h_norm_weight[hidden_id]);
+            }
+        }
+
+        auto* residual = allocBuffer<OutputType>(num_tokens * hidden_size);
+        auto* norm_weight = allocBuffer<OutputType>(hidden_size);
+        check_cuda_error(cudaMemcpy(
+            residual, h_residual.data(), h_residual.size() * sizeof(OutputType), cudaMemcpyHostToDevice));
+        check_cuda_error(cudaMemcpy(
+            norm_weight, h_norm_weight.data(), h_norm_weight.size() * sizeof(OutputType), cudaMemcpyHostToDevice));
+
+        // The ranks run on the same device, their all reduce buffers are plain device buffers. The flags are sized
+        // like those of IpcMemory and start at zero, below the barrier flag
+        size_t const num_flags = (MAX_ALL_REDUCE_BLOCKS + 1) * parallelism * 2;
+        std::vector<AllReduceParams> all_reduce_params(parallelism);
+        std::vector<void*> comm_buffers(parallelism);
+        std::vector<uint32_t*> barriers_in(parallelism);
+        std::vector<uint32_t*> barriers_out(parallelism);
+        for (int i = 0; i < parallelism; i++)
+        {
+            comm_buffers[i] = allocBuffer<OutputType>(num_tokens * hidden_size);
+            barriers_in[i] = allocBuffer<uint32_t>(num_flags);
+            barriers_out[i] = allocBuffer<uint32_t>(num_flags);
+            check_cuda_error(cudaMemset(barriers_in[i], 0, num_flags * sizeof(uint32_t)));
+            check_cuda_error(cudaMemset(barriers_out[i], 0, num_flags * sizeof(uint32_t)));
+        }
+
+        // Each rank has its own runner, stream, workspace and outputs, the inputs and weights are shared
+        struct Rank
+        {
+            CutlassMoeFCRunner<DataType, WeightType, OutputType> runner;
+            std::shared_ptr<CudaStream> stream;
+            char* workspace;
+            OutputType* final_output;
+            OutputType* residual_output;
+            float* scale_probs;
+            int* source_to_expanded_map;
+            int* selected_expert;
+        };
+
+        auto const tactic = getTactic();
+        std::vector<Rank> ranks(parallelism);
+        for (int i = 0; i < parallelism; i++)
+        {
+            auto& params = all_reduce_params[i];
+            params.ranks_per_node = parallelism;
+            params.local_rank = i;
+            params.barrier_flag = 1;
+            for (int peer = 0; peer < parallelism; peer++)
+            {
+                params.peer_comm_buffer_ptrs[peer] = comm_buffers[peer];
+                params.peer_barrier_ptrs_in[peer] = barriers_in[peer];
+                params.peer_barrier_ptrs_out[peer] = barriers_out[peer];
+            }
+            params.fusion_params.residual_buffer = residual;
+            params.fusion_params.weight_buffer = norm_weight;
+            params.fusion_params.eps = eps;
+
+            auto& rank = ranks[i];
+            rank.stream = std::make_shared<CudaStream>();
+            rank.final_output = allocBuffer<OutputType>(mTotalTokens * mHiddenSize);
+            rank.residual_output = allocBuffer<OutputType>(mTotalTokens * mHiddenSize);
+            params.fusion_params.intermediate_buffer = rank.residual_output;
+            rank.runner.fused_all_reduce = &params;
+            rank.runner.fused_all_reduce_strategy = AllReduceStrategyType::ONESHOT;
+            rank.runner.setTactic(tactic);
+            rank.workspace = allocBuffer<char>(rank.runner.getWorkspaceSize(mTotalTokens, mHiddenSize, mInterSize,
+                mNumExperts, mK, mActType, MOEParallelismConfig{1, 0, parallelism, i}));
+            rank.scale_probs = allocBuffer<float>(mTotalTokens * mK);
+            rank.source_to_expanded_map = allocBuffer<int>(mTotalTokens * mK);
+            rank.selected_expert = allocBuffer<int>(mTotalTokens * mK);
+        }
+
+        // The one-shot kernels of the ranks wait for each other, they must be in flight at the same time
+        runRanksConcurrently(parallelism,
+            [&](int i)
+            {
+                auto& rank = ranks[i];
+                auto const parallelism_config = MOEParallelismConfig{1, 0, parallelism, i};
+                auto const [weight1_ptr, weight2_ptr, bias1_ptr, bias2_ptr, scale1_ptr, scale2_ptr, scale3_ptr]
+                    = getWeights(parallelism_config);
+                rank.runner.runMoe(mInputTensor, mInputProbabilities, weight1_ptr, bias1_ptr, mActType, weight2_ptr,
+                    bias2_ptr, getQuantParams(scale1_ptr, scale2_ptr, scale3_ptr), mTotalTokens, mHiddenSize,
+                    mInterSize, mNumExperts, mK, rank.workspace, rank.final_output, mFinished, mActiveRows,
+                    rank.scale_probs, rank.source_to_expanded_map, rank.selected_expert, parallelism_config,
+                    mNormMode, rank.stream->get());
+                rank.stream->synchronize();
+            });
+
+        for (int i = 0; i < parallelism; i++)
+        {
+            auto const output = getDataFromDevice(ranks[i].final_output, num_tokens * hidden_size);
+            auto const new_residual = getDataFromDevice(ranks[i].residual_output, num_tokens * hidden_size);
+            for (int64_t idx = 0; idx < num_tokens * hidden_size; idx++)
+            {
+                ASSERT_NEAR(expected_residual[idx], new_residual[idx], getTolerance(expected_residual[idx]))
+                    << "Incorrect residual on rank " << i << " at position: " << idx;
+                ASSERT_NEAR(expected_output[idx], output[idx], getTolerance(expected_output[idx]))
+                    << "Incorrect normalized value on rank " << i << " at position: " << idx;
+            }
+        }
+    }
+}
+
+TYPED_TEST(MixtureOfExpertsTest, FusedAllReduce)
+{
+    this->FusedAllReduceTest();
+    this->FusedAllReduceTest(2);
+}
+
+TYPED_TEST(MixtureOfExpertsTest, FusedAllReduceRenorm)
+{
+    this->mNormMode = MOEExpertScaleNormalizationMode::RENORMALIZE;
+    this->FusedAllReduceTest(2);
+}
+
 template <class TypeParam_>
 void MixtureOfExpertsTest<TypeParam_>::TensorParallelTest(int k)
 {
@@ -1529,6 +2257,37 @@ TYPED_TEST(MixtureOfExpertsTest, ConfigSweep)
     }
 }
 
+// The SM90 grouped GEMMs get the problem shapes and pointers of both FC1 and FC2 from a single setup kernel. Run every
+// SM90 tactic with uneven expert loads, and with only the local experts of an EP rank.
+TYPED_TEST(MixtureOfExpertsTest, ConfigSweepSM90UnevenExperts)
+{
+    auto configs = this->mMoERunner.getTactics();
+    configs.erase(std::remove_if(configs.begin(), configs.end(), [](auto const& conf) { return !conf.is_sm90; }),
+        configs.end());
+    if (configs.empty())
+    {
+        GTEST_SKIP() << "No SM90 tactics on this device";
+    }
+
+    for (auto const activation_type : {tensorrt_llm::ActivationType::Relu, tensorrt_llm::ActivationType::Swiglu})
+    {
+        for (auto const& conf : configs)
+        {
+            SCOPED_TRACE(::testing::Message() << "tile shape " << (int) conf.tile_config_sm90 << " cluster shape "
+                                              << (int) conf.cluster_shape << " activation type "
+                                              << static_cast<int>(activation_type));
+            this->mActType = activation_type;
+            this->mSelectedConfig = conf;
+            this->RoutingSortTest(300, 2);
+            this->ExpertParallelTest(2);
+            if (::testing::Test::HasFailure())
+            {
+                return;
+            }
+        }
+    }
+}
+
 TYPED_TEST(LargeMixtureOfExpertsTest, PermuteVeryLargeExperts)
 {
     // Chosen so that hidden_size * inter_size * num_experts >> 2^32, but we can still fit in 80GB for `half`
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Compares the generation step of MMHA in multi-block mode, with the split balanced on the kv lengths of the batch,
+// to the single-block kernel, for batches with very different lengths.
+class MmhaMultiBlockTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! \brief Runs one generation step of the batch, in multi-block mode if `maxSeqLenTile` > 1.
+    void runKernel(std::vector<int> const& pastLengths, TensorPtr const& kvCache, TensorPtr const& qkv,
+        TensorPtr const& output, int maxSeqLenTile)
+    {
+        auto const batchSize = static_cast<int>(pastLengths.size());
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto const qkvSize = (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+        auto const maxPastLength = *std::max_element(pastLengths.begin(), pastLengths.end());
+
+        // The kernel writes the new token into the cache, every run starts from a copy.
+        auto cacheCopy = BufferManager::pinned(kvCache->getShape(), nvinfer1::DataType::kFLOAT);
+        std::copy_n(bufferCast<float>(*kvCache), kvCache->getSize(), bufferCast<float>(*cacheCopy));
+        auto seqLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto inputLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        for (int bi = 0; bi < batchSize; ++bi)
+        {
+            bufferCast<int>(*seqLengths)[bi] = pastLengths[bi] + 1;
+            bufferCast<int>(*inputLengths)[bi] = pastLengths[bi];
+        }
+        auto const partialSize = maxSeqLenTile * batchSize * mNumHeads;
+        auto partialOut
+            = BufferManager::pinned(ITensor::makeShape({partialSize, mHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto partialSum = BufferManager::pinned(ITensor::makeShape({partialSize}), nvinfer1::DataType::kFLOAT);
+        auto partialMax = BufferManager::pinned(ITensor::makeShape({partialSize}), nvinfer1::DataType::kFLOAT);
+        auto blockCounter
+            = BufferManager::pinned(ITensor::makeShape({batchSize * mNumHeads}), nvinfer1::DataType::kINT32);
+        std::fill_n(bufferCast<int>(*blockCounter), blockCounter->getSize(), 0);
+
+        tk::KVLinearBuffer const cache(batchSize, mMaxAttentionWindow, tokenSize * static_cast<int>(sizeof(float)),
+            mMaxAttentionWindow, 0, false, reinterpret_cast<int8_t*>(bufferCast<float>(*cacheCopy)));
+
+        tk::Masked_multihead_attention_params<float> params;
+        params.out = bufferCast<float>(*output);
+        params.q = bufferCast<float>(*qkv);
+        params.k = params.q + mNumHeads * mHeadSize;
+        params.v = params.k + mNumKvHeads * mHeadSize;
+        params.stride = qkvSize;
+        params.batch_size = batchSize;
+        params.beam_width = 1;
+        params.max_attention_window_size = mMaxAttentionWindow;
+        params.cyclic_attention_window_size = mMaxAttentionWindow;
+        params.length_per_sample = bufferCast<int>(*seqLengths);
+        params.input_lengths = bufferCast<int>(*inputLengths);
+        params.timestep = maxPastLength;
+        params.num_heads = mNumHeads;
+        params.num_kv_heads = mNumKvHeads;
+        params.hidden_size_per_head = mHeadSize;
+        params.position_embedding_type = tk::PositionEmbeddingType::kLEARNED_ABSOLUTE;
+        params.inv_sqrt_dh = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+        params.multi_processor_count = tc::getMultiProcessorCount();
+        if (maxSeqLenTile > 1)
+        {
+            params.multi_block_mode = true;
+            params.max_seq_len_tile = maxSeqLenTile;
+            params.min_seq_len_tile = 1;
+            params.total_kv_length = std::accumulate(pastLengths.begin(), pastLengths.end(), int64_t{batchSize});
+            params.partial_out = bufferCast<float>(*partialOut);
+            params.partial_sum = bufferCast<float>(*partialSum);
+            params.partial_max = bufferCast<float>(*partialMax);
+            params.block_counter = bufferCast<int>(*blockCounter);
+        }
+
+        tk::masked_multihead_attention(params, cache, mStream->get());
+        mStream->synchronize();
+    }
+
+    void runTest(std::vector<int> const& pastLengths)
+    {
+        auto const batchSize = static_cast<int>(pastLengths.size());
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto const qkvSize = (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+        auto const outSize = batchSize * mNumHeads * mHeadSize;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        auto kvCache = BufferManager::pinned(
+            ITensor::makeShape({batchSize, 2, mMaxAttentionWindow, tokenSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*kvCache), kvCache->getSize(), [&]() { return dist(gen); });
+        auto qkv = BufferManager::pinned(ITensor::makeShape({batchSize, qkvSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*qkv), qkv->getSize(), [&]() { return dist(gen); });
+
+        auto reference = BufferManager::pinned(ITensor::makeShape({outSize}), nvinfer1::DataType::kFLOAT);
+        runKernel(pastLengths, kvCache, qkv, reference, 1);
+        auto output = BufferManager::pinned(ITensor::makeShape({outSize}), nvinfer1::DataType::kFLOAT);
+        runKernel(pastLengths, kvCache, qkv, output, mMaxSeqLenTile);
+
+        auto const* ref = bufferCast<float>(*reference);
+        auto const* out = bufferCast<float>(*output);
+        for (int i = 0; i < outSize; ++i)
+        {
+            ASSERT_TRUE(std::isfinite(out[i])) << "index " << i;
+            EXPECT_NEAR(out[i], ref[i], 1e-4f) << "sequence " << i / (mNumHeads * mHeadSize) << ", index " << i;
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+
+    int mNumHeads{4};
+    int mNumKvHeads{2};
+    int mHeadSize{64};
+    int mMaxAttentionWindow{4096};
+    int mMaxSeqLenTile{64};
+};
+
+TEST_F(MmhaMultiBlockTest, SkewedBatch)
+{
+    // The tiles past the end of the short sequences skip their kv loops.
+    runTest({3, 100, 4000});
+    runTest({4000, 17, 1});
+}
+
+TEST_F(MmhaMultiBlockTest, UniformBatch)
+{
+    runTest({1000, 1000, 1000, 1000});
+}
+
+} // namespace
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Compares the generation step of MMHA with position shift (StreamingLLM) to a host reference: the cache holds the keys
+// without position embedding, and each key of the window is rotated by its position in the window.
+class MmhaPositionShiftTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! \brief Rotates `x` in place at `pos`, as the kernels do for GPT-J and GPT-NeoX.
+    void rotate(float* x, int pos, float base, float scale) const
+    {
+        bool const gptj = mPositionEmbeddingType == tk::PositionEmbeddingType::kROPE_GPTJ;
+        int const half = mRotaryDim / 2;
+        std::vector<float> const in(x, x + mRotaryDim);
+        for (int c = 0; c < mRotaryDim; ++c)
+        {
+            int const zid = gptj ? (c & ~1) : 2 * (c % half);
+            float const invFreq = pos * scale / std::pow(base, zid / static_cast<float>(mRotaryDim));
+            float const cos = std::cos(invFreq);
+            float const sin = std::sin(invFreq);
+            bool const isFirst = gptj ? c % 2 == 0 : c < half;
+            float const y = gptj ? in[c ^ 1] : in[isFirst ? c + half : c - half];
+            x[c] = isFirst ? in[c] * cos - y * sin : in[c] * cos + y * sin;
+        }
+    }
+
+    //! \brief Runs one generation step after `pastLength` tokens and compares the output to the reference.
+    void runTest(int pastLength)
+    {
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto const qkvSize = (mNumHeads + 2 * mNumKvHeads) * mHeadSize;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        auto kvCache = BufferManager::pinned(
+            ITensor::makeShape({2, mMaxAttentionWindow, tokenSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*kvCache), kvCache->getSize(), [&]() { return dist(gen); });
+        auto qkv = BufferManager::pinned(ITensor::makeShape({1, qkvSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*qkv), qkv->getSize(), [&]() { return dist(gen); });
+        auto output
+            = BufferManager::pinned(ITensor::makeShape({1, mNumHeads * mHeadSize}), nvinfer1::DataType::kFLOAT);
+        auto seqLength = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*seqLength)[0] = pastLength + 1;
+        auto inputLength = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*inputLength)[0] = mSinkTokenLength;
+
+        tk::KVLinearBuffer const cache(1, mMaxAttentionWindow, tokenSize * static_cast<int>(sizeof(float)),
+            mMaxAttentionWindow, mSinkTokenLength, false, reinterpret_cast<int8_t*>(bufferCast<float>(*kvCache)));
+
+        // The reference, computed before the kernel overwrites the oldest token of the cyclic part of the window.
+        auto const* qkvHost = bufferCast<float>(*qkv);
+        auto const cacheLength = std::min(pastLength, mMaxAttentionWindow);
+        // Tokens of the window by position: the sink tokens, then the latest tokens of the cyclic part.
+        std::vector<int> windowTokens;
+        auto const cyclicLength = mMaxAttentionWindow - mSinkTokenLength;
+        for (int ti = 0; ti < pastLength; ++ti)
+        {
+            if (ti < mSinkTokenLength || ti >= pastLength - cyclicLength)
+            {
+                windowTokens.push_back(ti);
+            }
+        }
+        ASSERT_EQ(static_cast<int>(windowTokens.size()), cacheLength);
+
+        // Dynamic scaling grows the base with the number of cached keys.
+        auto base = mRotaryBase;
+        if (cacheLength > mRotaryMaxPositions)
+        {
+            auto const b = mRotaryScale * cacheLength / mRotaryMaxPositions - (mRotaryScale - 1);
+            base *= std::pow(b, mRotaryDim / static_cast<float>(mRotaryDim - 2));
+        }
+
+        std::vector<float> reference(mNumHeads * mHeadSize);
+        for (int hi = 0; hi < mNumHeads; ++hi)
+        {
+            auto const hiKv = hi / (mNumHeads / mNumKvHeads);
+            std::vector<float> q(qkvHost + hi * mHeadSize, qkvHost + (hi + 1) * mHeadSize);
+            rotate(q.data(), cacheLength, base, 1.f);
+
+            std::vector<std::vector<float>> keys;
+            std::vector<float const*> values;
+            for (int pos = 0; pos < cacheLength; ++pos)
+            {
+                auto const slot = cache.getKVTokenIdx(windowTokens[pos]);
+                auto const* k = static_cast<float const*>(cache.getKBlockPtr(0, slot));
+                auto const* v = static_cast<float const*>(cache.getVBlockPtr(0, slot));
+                auto const offset = cache.getKVLocalIdx(slot, hiKv, mHeadSize, 0);
+                keys.emplace_back(k + offset, k + offset + mHeadSize);
+                rotate(keys.back().data(), pos, base, 1.f);
+                values.push_back(v + offset);
+            }
+            auto const* newK = qkvHost + (mNumHeads + hiKv) * mHeadSize;
+            keys.emplace_back(newK, newK + mHeadSize);
+            rotate(keys.back().data(), cacheLength, base, 1.f);
+            values.push_back(qkvHost + (mNumHeads + mNumKvHeads + hiKv) * mHeadSize);
+
+            std::vector<float> logits(keys.size());
+            for (std::size_t ki = 0; ki < keys.size(); ++ki)
+            {
+                float dot = 0.f;
+                for (int c = 0; c < mHeadSize; ++c)
+                {
+                    dot += q[c] * keys[ki][c];
+                }
+                logits[ki] = dot / std::sqrt(static_cast<float>(mHeadSize));
+            }
+            auto const maxLogit = *std::max_element(logits.begin(), logits.end());
+            float sum = 0.f;
+            for (auto& logit : logits)
+            {
+                logit = std::exp(logit - maxLogit);
+                sum += logit;
+            }
+            for (int c = 0; c < mHeadSize; ++c)
+            {
+                float out = 0.f;
+                for (std::size_t ki = 0; ki < keys.size(); ++ki)
+                {
+                    out += logits[ki] / sum * values[ki][c];
+                }
+                reference[hi * mHeadSize + c] = out;
+            }
+        }
+
+        tk::Masked_multihead_attention_params<float> params;
+        params.out = bufferCast<float>(*output);
+        params.q = bufferCast<float>(*qkv);
+        params.k = params.q + mNumHeads * mHeadSize;
+        params.v = params.k + mNumKvHeads * mHeadSize;
+        params.stride = qkvSize;
+        params.batch_size = 1;
+        params.beam_width = 1;
+        params.max_attention_window_size = mMaxAttentionWindow;
+        params.cyclic_attention_window_size = mMaxAttentionWindow;
+        params.sink_token_length = mSinkTokenLength;
+        params.length_per_sample = bufferCast<int>(*seqLength);
+        params.input_lengths = bufferCast<int>(*inputLength);
+        params.timestep = pastLength;
+        params.num_heads = mNumHeads;
+        params.num_kv_heads = mNumKvHeads;
+        params.hidden_size_per_head = mHeadSize;
+        params.position_embedding_type = mPositionEmbeddingType;
+        params.rotary_embedding_dim = mRotaryDim;
+        params.rotary_embedding_base = mRotaryBase;
+        params.rotary_embedding_scale_type = tk::RotaryScalingType::kDYNAMIC;
+        params.rotary_embedding_scale = mRotaryScale;
+        params.rotary_embedding_max_positions = mRotaryMaxPositions;
+        params.position_shift_enabled = true;
+        params.inv_sqrt_dh = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+        params.multi_processor_count = tc::getMultiProcessorCount();
+
+        tk::masked_multihead_attention(params, cache, mStream->get());
+        mStream->synchronize();
+
+        auto const* out = bufferCast<float>(*output);
+        for (int i = 0; i < mNumHeads * mHeadSize; ++i)
+        {
+            EXPECT_NEAR(out[i], reference[i], 2e-3f) << "past length " << pastLength << ", index " << i;
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+
+    int mNumHeads{4};
+    int mNumKvHeads{2};
+    int mHeadSize{64};
+    int mMaxAttentionWindow{16};
+    int mSinkTokenLength{4};
+    int mRotaryDim{64};
+    float mRotaryBase{10000.f};
+    float mRotaryScale{2.f};
+    // Below the window, so that dynamic scaling changes the base once the window fills up
+    int mRotaryMaxPositions{8};
+    tk::PositionEmbeddingType mPositionEmbeddingType{tk::PositionEmbeddingType::kROPE_GPT_NEOX};
+};
+
+TEST_F(MmhaPositionShiftTest, GptNeoxDynamicScaling)
+{
+    // Before the window wraps around, and after it did
+    runTest(6);
+    runTest(12);
+    runTest(21);
+}
+
+TEST_F(MmhaPositionShiftTest, GptjDynamicScaling)
+{
+    mPositionEmbeddingType = tk::PositionEmbeddingType::kROPE_GPTJ;
+    runTest(6);
+    runTest(12);
+    runTest(21);
+}
+
+} // namespace
@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/moe_gemm/moe_gemm_kernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tkc = tensorrt_llm::kernels::cutlass_kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Groupwise MoE weight scales are [experts, k / group_size, n]. With the per channel scale of a column repeated for
+// every group, the groupwise GEMM must match the per channel GEMM. With a different factor for each group, it must
+// match a GEMM on the host over the int8 weights dequantized with the scale of their group.
+class MoeGroupwiseScalesTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || tc::getSMVersion() < 80)
+        {
+            GTEST_SKIP() << "Groupwise MoE scales require SM80+";
+        }
+        mStream = std::make_shared<CudaStream>();
+
+        // Int weights run the SM80 grouped GEMM on every architecture
+        auto const configs = mRunner.getConfigs();
+        auto const it = std::find_if(configs.begin(), configs.end(), [](auto const& c) { return !c.is_sm90; });
+        ASSERT_NE(it, configs.end());
+        mRunner.setBestConfig(*it);
+
+        auto const numRows = std::accumulate(mRowsPerExpert.begin(), mRowsPerExpert.end(), 0);
+        mTotalRowsBeforeExpert = BufferManager::pinned(ITensor::makeShape({mNumExperts}), nvinfer1::DataType::kINT64);
+        std::partial_sum(
+            mRowsPerExpert.begin(), mRowsPerExpert.end(), bufferCast<std::int64_t>(*mTotalRowsBeforeExpert));
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        mInput = BufferManager::pinned(ITensor::makeShape({numRows, mGemmK}), nvinfer1::DataType::kHALF);
+        std::generate_n(bufferCast<half>(*mInput), mInput->getSize(), [&]() { return half(dist(gen)); });
+
+        std::vector<half> weights(mNumExperts * mGemmK * mGemmN);
+        std::generate(weights.begin(), weights.end(), [&]() { return half(dist(gen)); });
+        std::vector<std::size_t> const shape{static_cast<std::size_t>(mNumExperts), static_cast<std::size_t>(mGemmK),
+            static_cast<std::size_t>(mGemmN)};
+        mWeights = BufferManager::pinned(ITensor::makeShape({mNumExperts, mGemmK, mGemmN}), nvinfer1::DataType::kINT8);
+        mUnprocessedWeights.resize(weights.size());
+        mChannelScales = BufferManager::pinned(ITensor::makeShape({mNumExperts, mGemmN}), nvinfer1::DataType::kHALF);
+        tkc::symmetric_quantize<half, half>(bufferCast<std::int8_t>(*mWeights), mUnprocessedWeights.data(),
+            bufferCast<half>(*mChannelScales), weights.data(), shape, tkc::QuantType::W8_A16, true);
+    }
+
+    //! \brief Runs the grouped GEMM with `scales` of a group of `groupSize` rows of K.
+    std::vector<float> runGemm(ITensor const& scales, SizeType32 groupSize)
+    {
+        auto const numRows = static_cast<SizeType32>(mInput->getShape().d[0]);
+        auto output = BufferManager::pinned(ITensor::makeShape({numRows, mGemmN}), nvinfer1::DataType::kHALF);
+        std::fill_n(bufferCast<half>(*output), output->getSize(), half(0.f));
+
+        // The preprocessing biases the int8 weights into the uint8 range the runner takes
+        auto const* weights = reinterpret_cast<std::uint8_t const*>(bufferCast<std::int8_t>(*mWeights));
+        mRunner.moeGemm(bufferCast<half>(*mInput), weights, bufferCast<half>(scales), bufferCast<half>(*output),
+            bufferCast<std::int64_t>(*mTotalRowsBeforeExpert), tensorrt_llm::HopperGroupedGemmInput{}, numRows, mGemmN,
+            mGemmK, groupSize, mNumExperts, false, mStream->get());
+        mStream->synchronize();
+
+        auto const* out = bufferCast<half>(*output);
+        return std::vector<float>(out, out + output->getSize());
+    }
+
+    //! \brief Groupwise scales with the per channel scale of the column times `groupFactors[g]` for group g.
+    ITensor::SharedPtr makeGroupScales(SizeType32 groupSize, std::vector<float> const& groupFactors) const
+    {
+        auto const numGroups = mGemmK / groupSize;
+        auto scales
+            = BufferManager::pinned(ITensor::makeShape({mNumExperts, numGroups, mGemmN}), nvinfer1::DataType::kHALF);
+        auto const* channelScales = bufferCast<half>(*mChannelScales);
+        auto* groupScales = bufferCast<half>(*scales);
+        for (SizeType32 e = 0; e < mNumExperts; ++e)
+        {
+            for (SizeType32 g = 0; g < numGroups; ++g)
+            {
+                for (SizeType32 n = 0; n < mGemmN; ++n)
+                {
+                    groupScales[(e * numGroups + g) * mGemmN + n]
+                        = half(float(channelScales[e * mGemmN + n]) * groupFactors[g % groupFactors.size()]);
+                }
+            }
+        }
+        return scales;
+    }
+
+    //! \brief The GEMM on the host, the weights of row k dequantized with the scale of group k / groupSize.
+    std::vector<float> referenceGemm(ITensor const& scales, SizeType32 groupSize) const
+    {
+        auto const numGroups = mGemmK / groupSize;
+        auto const* input = bufferCast<half>(*mInput);
+        auto const* groupScales = bufferCast<half>(scales);
+        std::vector<float> output;
+        SizeType32 row = 0;
+        for (SizeType32 e = 0; e < mNumExperts; ++e)
+        {
+            for (SizeType32 r = 0; r < mRowsPerExpert[e]; ++r, ++row)
+            {
+                for (SizeType32 n = 0; n < mGemmN; ++n)
+                {
+                    float acc = 0.f;
+                    for (SizeType32 k = 0; k < mGemmK; ++k)
+                    {
+                        auto const weight = mUnprocessedWeights[(e * mGemmK + k) * mGemmN + n];
+                        auto const scale = float(groupScales[(e * numGroups + k / groupSize) * mGemmN + n]);
+                        acc += float(input[row * mGemmK + k]) * weight * scale;
+                    }
+                    output.push_back(acc);
+                }
+            }
+        }
+        return output;
+    }
+
+    static void expectNear(std::vector<float> const& actual, std::vector<float> const& expected, float relTol)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i)
+        {
+            ASSERT_NEAR(actual[i], expected[i], relTol * std::max(1.f, std::abs(expected[i]))) << "index " << i;
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    tensorrt_llm::MoeGemmRunner<half, std::uint8_t> mRunner;
+
+    SizeType32 mNumExperts{3};
+    // The second expert gets no rows
+    std::vector<SizeType32> mRowsPerExpert{5, 0, 12};
+    SizeType32 mGemmK{256};
+    SizeType32 mGemmN{128};
+
+    ITensor::SharedPtr mTotalRowsBeforeExpert;
+    ITensor::SharedPtr mInput;
+    ITensor::SharedPtr mWeights;
+    ITensor::SharedPtr mChannelScales;
+    std::vector<std::int8_t> mUnprocessedWeights;
+};
+
+TEST_F(MoeGroupwiseScalesTest, RepeatedChannelScalesMatchPerChannel)
+{
+    auto const perChannel = runGemm(*mChannelScales, mGemmK);
+    expectNear(perChannel, referenceGemm(*mChannelScales, mGemmK), 2e-2f);
+    for (SizeType32 groupSize : {64, 128})
+    {
+        SCOPED_TRACE(groupSize);
+        expectNear(runGemm(*makeGroupScales(groupSize, {1.f}), groupSize), perChannel, 1e-2f);
+    }
+}
+
+TEST_F(MoeGroupwiseScalesTest, GroupScalesMatchReference)
+{
+    for (SizeType32 groupSize : {64, 128})
+    {
+        SCOPED_TRACE(groupSize);
+        auto const scales = makeGroupScales(groupSize, {1.f, 0.5f, 2.f, 0.25f});
+        expectNear(runGemm(*scales, groupSize), referenceGemm(*scales, groupSize), 2e-2f);
+    }
+}
+
+} // namespace
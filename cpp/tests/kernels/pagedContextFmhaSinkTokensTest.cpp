@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/kvCacheUtils.h"
+#include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <random>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Paged context FMHA reads token t of a sequence from block t / tokensPerBlock of its blocks, without the sink token
+// bubble of KVBlockArray. The attention plugin only takes the paged path with sink tokens when they fill whole blocks
+// and the context fits in the attention window. This test checks that under these conditions the Q and the paged K/V
+// written by QKV preprocessing, read the way the FMHA kernels read them, are the inputs of the unfused path.
+class PagedContextFmhaSinkTokensTest : public testing::Test
+{
+public:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! \brief Runs QKV preprocessing for paged context FMHA and counts the values that differ from the inputs.
+    int countMismatches(int sinkTokenLength)
+    {
+        auto const tokenSize = mNumKvHeads * mHeadSize;
+        auto const qSize = mNumHeads * mHeadSize;
+        auto const qkvSize = qSize + 2 * tokenSize;
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        auto qkv = BufferManager::pinned(ITensor::makeShape({mSeqLength, qkvSize}), nvinfer1::DataType::kFLOAT);
+        std::generate_n(bufferCast<float>(*qkv), qkv->getSize(), [&]() { return dist(gen); });
+        auto input = BufferManager::pinned(qkv->getShape(), nvinfer1::DataType::kFLOAT);
+        std::copy_n(bufferCast<float>(*qkv), qkv->getSize(), bufferCast<float>(*input));
+        auto q = BufferManager::pinned(ITensor::makeShape({mSeqLength, qSize}), nvinfer1::DataType::kFLOAT);
+
+        auto blockOffsets
+            = BufferManager::pinned(ITensor::makeShape({1, 2, mMaxBlocksPerSeq}), nvinfer1::DataType::kINT32);
+        auto* offsets = bufferCast<std::int32_t>(*blockOffsets);
+        for (int bi = 0; bi < mMaxBlocksPerSeq; ++bi)
+        {
+            offsets[bi] = bi;
+            offsets[mMaxBlocksPerSeq + bi] = mMaxBlocksPerSeq + bi;
+        }
+        auto pool = BufferManager::pinned(
+            ITensor::makeShape({2 * mMaxBlocksPerSeq, mTokensPerBlock * tokenSize}), nvinfer1::DataType::kFLOAT);
+        std::fill_n(bufferCast<float>(*pool), pool->getSize(), 0.f);
+
+        auto seqLengths = BufferManager::pinned(ITensor::makeShape({1}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*seqLengths)[0] = mSeqLength;
+        auto cuSeqLengths = BufferManager::pinned(ITensor::makeShape({2}), nvinfer1::DataType::kINT32);
+        bufferCast<int>(*cuSeqLengths)[0] = 0;
+        bufferCast<int>(*cuSeqLengths)[1] = mSeqLength;
+
+        tk::KVBlockArray const cache(1, mMaxBlocksPerSeq, mTokensPerBlock,
+            tokenSize * static_cast<int>(sizeof(float)), mAttentionWindow, sinkTokenLength, bufferCast<float>(*pool),
+            nullptr, reinterpret_cast<tk::KVCacheIndex*>(offsets));
+
+        tk::QKVPreprocessingParams<float, tk::KVBlockArray> params;
+        params.QKV = bufferCast<float>(*qkv);
+        params.Q = bufferCast<float>(*q);
+        params.kv_cache_buffer = cache;
+        params.seq_lens = bufferCast<int>(*seqLengths);
+        params.cache_seq_lens = bufferCast<int>(*seqLengths);
+        params.cu_seq_lens = bufferCast<int>(*cuSeqLengths);
+        params.batch_size = 1;
+        params.max_input_seq_len = mSeqLength;
+        params.max_kv_seq_len = mSeqLength;
+        params.cyclic_kv_cache_len = mAttentionWindow;
+        params.sink_token_len = sinkTokenLength;
+        params.token_num = mSeqLength;
+        params.head_num = mNumHeads;
+        params.kv_head_num = mNumKvHeads;
+        params.qheads_per_kv_head = mNumHeads / mNumKvHeads;
+        params.size_per_head = mHeadSize;
+        params.position_embedding_type = tk::PositionEmbeddingType::kLEARNED_ABSOLUTE;
+        params.cache_type = tk::KvCacheDataType::BASE;
+        params.enable_paged_kv_fmha = true;
+        params.multi_processor_count = tc::getMultiProcessorCount();
+
+        tk::invokeQKVPreprocessing(params, mStream->get());
+        mStream->synchronize();
+
+        // Without position embedding nor bias, the unfused path attends the input Q, K and V.
+        int mismatches = 0;
+        auto const* in = bufferCast<float>(*input);
+        auto const* qOut = bufferCast<float>(*q);
+        for (int ti = 0; ti < mSeqLength; ++ti)
+        {
+            auto const* tokenIn = in + ti * qkvSize;
+            for (int i = 0; i < qSize; ++i)
+            {
+                EXPECT_EQ(qOut[ti * qSize + i], tokenIn[i]) << "token " << ti << ", index " << i;
+            }
+            // Token ti is read from block ti / tokensPerBlock, the KV token index of KVBlockArray is not applied.
+            auto const* kBlock = static_cast<float const*>(cache.getKBlockPtr(0, ti));
+            auto const* vBlock = static_cast<float const*>(cache.getVBlockPtr(0, ti));
+            for (int hi = 0; hi < mNumKvHeads; ++hi)
+            {
+                for (int c = 0; c < mHeadSize; ++c)
+                {
+                    auto const idx = cache.getKVLocalIdx(ti, hi, mHeadSize, c);
+                    mismatches += kBlock[idx] != tokenIn[qSize + hi * mHeadSize + c];
+                    mismatches += vBlock[idx] != tokenIn[qSize + tokenSize + hi * mHeadSize + c];
+                }
+            }
+        }
+        return mismatches;
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+
+    int mNumHeads{4};
+    int mNumKvHeads{2};
+    int mHeadSize{64};
+    int mTokensPerBlock{8};
+    int mMaxBlocksPerSeq{6};
+    int mAttentionWindow{32};
+    // Fits in the attention window
+    int mSeqLength{29};
+};
+
+TEST_F(PagedContextFmhaSinkTokensTest, BlockAlignedSinkTokens)
+{
+    EXPECT_EQ(countMismatches(0), 0);
+    EXPECT_EQ(countMismatches(mTokensPerBlock), 0);
+    EXPECT_EQ(countMismatches(2 * mTokensPerBlock), 0);
+}
+
+TEST_F(PagedContextFmhaSinkTokensTest, UnalignedSinkTokensLeaveABubble)
+{
+    // The tokens after the sink tokens are shifted by the bubble, which is why the plugin rejects this config.
+    EXPECT_GT(countMismatches(mTokensPerBlock / 2), 0);
+}
+
+} // namespace
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+#include "tensorrt_llm/kernels/quantization.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+namespace tkc = tensorrt_llm::kernels::cutlass_kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The weight-only quantization on the GPU must give the scales and the unprocessed quantized weights of the host
+// symmetric_quantize it replaces for CUDA weights in the checkpoint converters, for a batch of matrices as in MoE. The
+// scales are exact. The device division may be approximate with fast math, so a value may only differ by one step where
+// the quotient is within rounding of a tie.
+class PerChannelWeightQuantizationTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "No CUDA device";
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+
+        mWeight = BufferManager::pinned(
+            ITensor::makeShape({kNumMatrices, kNumRows, kNumCols}), nvinfer1::DataType::kHALF);
+        auto* weight = bufferCast<half>(*mWeight);
+        std::mt19937 gen(42);
+        for (SizeType32 m = 0; m < kNumMatrices; ++m)
+        {
+            // Very different ranges per matrix, and a zero column to take the path of the zero scale
+            std::uniform_real_distribution<float> dist(-std::pow(10.f, m - 1), std::pow(10.f, m - 1));
+            for (SizeType32 i = 0; i < kNumRows * kNumCols; ++i)
+            {
+                weight[m * kNumRows * kNumCols + i] = half(i % kNumCols == kZeroCol ? 0.f : dist(gen));
+            }
+        }
+    }
+
+    //! \brief The signed value of element `index` of quantized weights with `bits` bits, two INT4 per byte.
+    static int unpack(std::vector<int8_t> const& quantized, std::size_t index, int bits)
+    {
+        if (bits == 8)
+        {
+            return quantized[index];
+        }
+        auto const nibble = (quantized[index / 2] >> (4 * (index % 2))) & 0xF;
+        return nibble >= 8 ? nibble - 16 : nibble;
+    }
+
+    //! \brief Compares the GPU quantization of the weights with symmetric_quantize for `quantType`.
+    void checkQuantization(tkc::QuantType quantType)
+    {
+        auto const bits = tkc::get_weight_quant_bits(quantType);
+        auto const numElts = static_cast<std::size_t>(kNumMatrices) * kNumRows * kNumCols;
+        auto const numBytes = numElts * bits / 8;
+
+        std::vector<int8_t> processed(numBytes);
+        std::vector<int8_t> expected(numBytes);
+        std::vector<half> expectedScales(kNumMatrices * kNumCols);
+        tkc::symmetric_quantize<half, half>(processed.data(), expected.data(), expectedScales.data(),
+            bufferCast<half>(*mWeight), {kNumMatrices, kNumRows, kNumCols}, quantType, false);
+
+        auto weight = mManager->copyFrom(*mWeight, MemoryType::kGPU);
+        auto quantized = mManager->gpu(numBytes, nvinfer1::DataType::kINT8);
+        auto scales = mManager->gpu(kNumMatrices * kNumCols, nvinfer1::DataType::kHALF);
+        tk::invokePerChannelWeightQuantization(bufferCast<int8_t>(*quantized), bufferCast<half>(*scales),
+            bufferCast<half>(*weight), kNumMatrices, kNumRows, kNumCols, bits, mStream->get());
+        std::vector<int8_t> actual(numBytes);
+        std::vector<half> actualScales(kNumMatrices * kNumCols);
+        mManager->copy(*quantized, actual.data());
+        mManager->copy(*scales, actualScales.data());
+        mStream->synchronize();
+
+        for (std::size_t i = 0; i < actualScales.size(); ++i)
+        {
+            ASSERT_EQ(static_cast<float>(actualScales[i]), static_cast<float>(expectedScales[i])) << "scale " << i;
+        }
+
+        auto const* src = bufferCast<half>(*mWeight);
+        auto const quantRangeScale = 1.f / static_cast<float>(1 << (bits - 1));
+        for (std::size_t i = 0; i < numElts; ++i)
+        {
+            auto const actualValue = unpack(actual, i, bits);
+            auto const expectedValue = unpack(expected, i, bits);
+            if (actualValue == expectedValue)
+            {
+                continue;
+            }
+            // The unrounded scale of the column, as the host and the kernel divide by it
+            auto const matrix = i / (kNumRows * kNumCols);
+            auto const col = i % kNumCols;
+            float colMax = 0.f;
+            for (SizeType32 row = 0; row < kNumRows; ++row)
+            {
+                auto const value = static_cast<float>(src[(matrix * kNumRows + row) * kNumCols + col]);
+                colMax = std::max(colMax, std::abs(value));
+            }
+            auto const quotient = static_cast<float>(src[i]) / (colMax * quantRangeScale);
+            ASSERT_EQ(std::abs(actualValue - expectedValue), 1) << "index " << i;
+            ASSERT_NEAR(std::abs(quotient - std::trunc(quotient)), 0.5f, 1e-4f) << "index " << i;
+        }
+    }
+
+    static constexpr SizeType32 kNumMatrices{3};
+    static constexpr SizeType32 kNumRows{128};
+    static constexpr SizeType32 kNumCols{256};
+    static constexpr SizeType32 kZeroCol{5};
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+    ITensor::SharedPtr mWeight;
+};
+
+} // namespace
+
+TEST_F(PerChannelWeightQuantizationTest, Int8MatchesHost)
+{
+    checkQuantization(tkc::QuantType::W8_A16);
+}
+
+TEST_F(PerChannelWeightQuantizationTest, Int4MatchesHost)
+{
+    checkQuantization(tkc::QuantType::W4_A16);
+}
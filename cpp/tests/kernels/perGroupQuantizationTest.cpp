@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/quantization.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::kernels;
+namespace tc = tensorrt_llm::common;
+
+class PerGroupQuantizationTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+
+        mSrc = BufferManager::pinned(ITensor::makeShape({kNumGroups, kGroupSize}), nvinfer1::DataType::kFLOAT);
+        auto* src = bufferCast<float>(*mSrc);
+        std::mt19937 gen(42);
+        for (SizeType32 g = 0; g < kNumGroups; ++g)
+        {
+            // Use very different ranges per group to exercise the per-group scales
+            std::uniform_real_distribution<float> dist(-std::pow(10.f, g - 2), std::pow(10.f, g - 2));
+            std::generate(src + g * kGroupSize, src + (g + 1) * kGroupSize, [&]() { return dist(gen); });
+        }
+    }
+
+    void checkRoundTrip(IBuffer const& output, IBuffer const& scales, float tolerance) const
+    {
+        auto const* src = bufferCast<float>(*mSrc);
+        auto const* dst = bufferCast<float>(output);
+        auto const* scale = bufferCast<float>(scales);
+        for (SizeType32 g = 0; g < kNumGroups; ++g)
+        {
+            auto const groupMax = *std::max_element(src + g * kGroupSize, src + (g + 1) * kGroupSize,
+                [](float a, float b) { return std::abs(a) < std::abs(b); });
+            EXPECT_GT(scale[g], 0.f);
+            for (SizeType32 i = g * kGroupSize; i < (g + 1) * kGroupSize; ++i)
+            {
+                EXPECT_NEAR(dst[i], src[i], tolerance * std::abs(groupMax)) << "group " << g << " index " << i;
+            }
+        }
+    }
+
+    static auto constexpr kNumGroups = 5;
+    static auto constexpr kGroupSize = 1024;
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+    IBuffer::SharedPtr mSrc;
+};
+
+TEST_F(PerGroupQuantizationTest, Int4RoundTrip)
+{
+    auto src = mManager->copyFrom(*mSrc, MemoryType::kGPU);
+    auto quantized = mManager->gpu(kNumGroups * kGroupSize / 2, nvinfer1::DataType::kUINT8);
+    auto scales = mManager->gpu(kNumGroups, nvinfer1::DataType::kFLOAT);
+    auto output = mManager->gpu(ITensor::makeShape({kNumGroups, kGroupSize}), nvinfer1::DataType::kFLOAT);
+
+    invokePerGroupInt4Quantization(bufferCast<uint8_t>(*quantized), bufferCast<float>(*src), kNumGroups, kGroupSize,
+        bufferCast<float>(*scales), mStream->get());
+    invokePerGroupInt4Dequantization(bufferCast<float>(*output), bufferCast<uint8_t>(*quantized), kNumGroups,
+        kGroupSize, bufferCast<float>(*scales), mStream->get());
+
+    auto outputHost = mManager->copyFrom(*output, MemoryType::kCPU);
+    auto scalesHost = mManager->copyFrom(*scales, MemoryType::kCPU);
+    mStream->synchronize();
+    // Half a quantization step of 1/7 of the group maximum
+    checkRoundTrip(*outputHost, *scalesHost, 0.5f / 7.f + 1e-5f);
+}
+
+#ifdef ENABLE_FP8
+TEST_F(PerGroupQuantizationTest, Fp8RoundTrip)
+{
+    auto src = mManager->copyFrom(*mSrc, MemoryType::kGPU);
+    auto quantized = mManager->gpu(kNumGroups * kGroupSize, nvinfer1::DataType::kFP8);
+    auto scales = mManager->gpu(kNumGroups, nvinfer1::DataType::kFLOAT);
+    auto output = mManager->gpu(ITensor::makeShape({kNumGroups, kGroupSize}), nvinfer1::DataType::kFLOAT);
+
+    invokePerGroupFp8Quantization(
+        quantized->data(), bufferCast<float>(*src), kNumGroups, kGroupSize, bufferCast<float>(*scales), mStream->get());
+    invokePerGroupFp8Dequantization(bufferCast<float>(*output), quantized->data(), kNumGroups, kGroupSize,
+        bufferCast<float>(*scales), mStream->get());
+
+    auto outputHost = mManager->copyFrom(*output, MemoryType::kCPU);
+    auto scalesHost = mManager->copyFrom(*scales, MemoryType::kCPU);
+    mStream->synchronize();
+    // E4M3 has 3 mantissa bits
+    checkRoundTrip(*outputHost, *scalesHost, 1.f / 16.f);
+}
+#endif
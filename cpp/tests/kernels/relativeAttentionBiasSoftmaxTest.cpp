@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/unfusedAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The implicit T5 relative attention bias added by the masked softmax must match the unfused path it replaces in the
+// attention plugins: addRelativeAttentionBiasUnaligned in implicit mode over QK, then the softmax without bias. This
+// covers the float softmax kernel and, for half QK, the half2 kernels with and without the 4 queries per block.
+class RelativeAttentionBiasSoftmaxTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "No CUDA device";
+        }
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    //! \brief A pinned tensor of `shape` filled with values from `dist`.
+    template <typename T>
+    ITensor::SharedPtr makeRandom(ITensor::Shape const& shape, std::uniform_real_distribution<float>& dist)
+    {
+        ITensor::SharedPtr tensor = BufferManager::pinned(shape, TRTDataType<T>::value);
+        std::generate_n(bufferCast<T>(*tensor), tensor->getSize(), [&]() { return T(dist(mGen)); });
+        return tensor;
+    }
+
+    //! \brief Runs the masked softmax of `qk`, with the implicit bias of `table` if `fuseBias`, and returns the scores.
+    template <typename T, typename T_IN>
+    std::vector<float> runSoftmax(ITensor const& qk, ITensor const& mask, ITensor const& table, SizeType32 seqLen,
+        bool bidirectional, bool fuseBias)
+    {
+        auto scores = BufferManager::pinned(qk.getShape(), TRTDataType<T>::value);
+        tk::MaskedSoftmaxParam<T, T_IN> param;
+        param.attention_score = bufferCast<T>(*scores);
+        param.qk = bufferCast<T_IN>(qk);
+        param.attention_mask = bufferCast<T>(mask);
+        param.batch_size = kBatchSize;
+        param.q_length = seqLen;
+        param.k_length = seqLen;
+        param.num_heads = kNumHeads;
+        param.qk_scale = T(kQkScale);
+        if (fuseBias)
+        {
+            param.relative_attention_bias = bufferCast<T>(table);
+            param.relative_attention_bias_stride = kNumBuckets;
+            param.max_distance = kMaxDistance;
+            param.relative_attention_bidirectional = bidirectional;
+        }
+        tk::invokeMaskedSoftmax(param, mStream->get());
+        mStream->synchronize();
+
+        auto const* data = bufferCast<T>(*scores);
+        std::vector<float> result(scores->getSize());
+        std::transform(data, data + result.size(), result.begin(), [](T v) { return static_cast<float>(v); });
+        return result;
+    }
+
+    //! \brief Compares the fused bias with the unfused path for QK in T_IN and scores in T.
+    template <typename T, typename T_IN>
+    void checkImplicitBias(SizeType32 seqLen, bool bidirectional, float tol)
+    {
+        std::uniform_real_distribution<float> qkDist(-8.f, 8.f);
+        std::uniform_real_distribution<float> biasDist(-2.f, 2.f);
+        auto const qkShape = ITensor::makeShape({kBatchSize, kNumHeads, seqLen, seqLen});
+        auto qk = makeRandom<T_IN>(qkShape, qkDist);
+        auto table = makeRandom<T>(ITensor::makeShape({kNumHeads, kNumBuckets}), biasDist);
+
+        // The second sequence masks its last keys
+        auto mask = BufferManager::pinned(ITensor::makeShape({kBatchSize, seqLen, seqLen}), TRTDataType<T>::value);
+        auto* maskData = bufferCast<T>(*mask);
+        for (SizeType32 i = 0; i < kBatchSize * seqLen * seqLen; ++i)
+        {
+            auto const b = i / (seqLen * seqLen);
+            auto const ki = i % seqLen;
+            maskData[i] = T(b == 1 && ki >= seqLen - 5 ? 0.f : 1.f);
+        }
+
+        auto const fused = runSoftmax<T, T_IN>(*qk, *mask, *table, seqLen, bidirectional, true);
+
+        tk::invokeAddRelativeAttentionBiasUnaligned(bufferCast<T_IN>(*qk), bufferCast<T>(*table), kBatchSize,
+            kNumHeads, seqLen, seqLen, mStream->get(), true, kNumBuckets, kMaxDistance, bidirectional);
+        auto const unfused = runSoftmax<T, T_IN>(*qk, *mask, *table, seqLen, bidirectional, false);
+
+        ASSERT_EQ(fused.size(), unfused.size());
+        for (std::size_t i = 0; i < fused.size(); ++i)
+        {
+            ASSERT_NEAR(fused[i], unfused[i], tol) << "index " << i;
+        }
+    }
+
+    static constexpr SizeType32 kBatchSize{2};
+    static constexpr SizeType32 kNumHeads{3};
+    static constexpr SizeType32 kNumBuckets{32};
+    // Below the sequence lengths, so that the far positions share the last buckets
+    static constexpr SizeType32 kMaxDistance{20};
+    static constexpr float kQkScale{0.5f};
+
+    std::shared_ptr<CudaStream> mStream;
+    std::mt19937 mGen{42};
+};
+
+} // namespace
+
+TEST_F(RelativeAttentionBiasSoftmaxTest, FloatMatchesUnfused)
+{
+    for (bool bidirectional : {true, false})
+    {
+        SCOPED_TRACE(bidirectional);
+        checkImplicitBias<float, float>(37, bidirectional, 1e-5f);
+        checkImplicitBias<half, float>(37, bidirectional, 2e-3f);
+    }
+}
+
+TEST_F(RelativeAttentionBiasSoftmaxTest, HalfMatchesUnfused)
+{
+    for (bool bidirectional : {true, false})
+    {
+        SCOPED_TRACE(bidirectional);
+        // softmax_kernel_h2_v2 takes 4 queries per block when they divide the query length, softmax_kernel_h2 the
+        // others, and odd key lengths go to softmax_kernel
+        for (SizeType32 seqLen : {40, 38, 37})
+        {
+            SCOPED_TRACE(seqLen);
+            checkImplicitBias<half, half>(seqLen, bidirectional, 5e-3f);
+        }
+    }
+}
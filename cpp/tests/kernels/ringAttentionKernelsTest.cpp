@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/ringAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/ringAttention.h"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class RingAttentionKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+    static TensorPtr toBuffer(std::vector<SizeType32> const& values)
+    {
+        auto buffer = BufferManager::pinned(
+            ITensor::makeShape({static_cast<SizeType32>(values.size())}), nvinfer1::DataType::kINT32);
+        std::copy(values.begin(), values.end(), bufferCast<SizeType32>(*buffer));
+        return buffer;
+    }
+
+    //! Copies the tokens of shard shardIdx of packed sequences [numTokens, numHeads, headSize] into a packed shard.
+    TensorPtr toShard(std::vector<float> const& values, SizeType32 numHeads, SizeType32 shardIdx) const
+    {
+        auto const rowSize = numHeads * mHeadSize;
+        auto shard
+            = BufferManager::pinned(ITensor::makeShape({mShardOffsets.back() * rowSize}), nvinfer1::DataType::kFLOAT);
+        auto* shardPtr = bufferCast<float>(*shard);
+        std::fill_n(shardPtr, shard->getSize(), 0.f);
+        SizeType32 seqBegin{0};
+        for (size_t si = 0; si < mSeqLengths.size(); ++si)
+        {
+            auto const shardLength = mShardOffsets[si + 1] - mShardOffsets[si];
+            for (SizeType32 ti = 0; ti < shardLength; ++ti)
+            {
+                auto const tokenIdx = shardIdx * shardLength + ti;
+                if (tokenIdx < mSeqLengths[si])
+                {
+                    std::copy_n(values.begin() + (seqBegin + tokenIdx) * rowSize, rowSize,
+                        shardPtr + (mShardOffsets[si] + ti) * rowSize);
+                }
+            }
+            seqBegin += mSeqLengths[si];
+        }
+        return shard;
+    }
+
+    //! Runs the steps of the ring of every shard on one GPU and compares with the attention over whole sequences.
+    void runAndCompare(std::vector<SizeType32> const& seqLengths, SizeType32 numShards, bool causal)
+    {
+        mSeqLengths = seqLengths;
+        mShardOffsets = RingAttention::getShardOffsets(seqLengths, numShards);
+        SizeType32 numTokens{0};
+        SizeType32 maxShardLength{0};
+        for (size_t si = 0; si < seqLengths.size(); ++si)
+        {
+            numTokens += seqLengths[si];
+            maxShardLength = std::max(maxShardLength, mShardOffsets[si + 1] - mShardOffsets[si]);
+        }
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        std::vector<float> q(numTokens * mNumHeads * mHeadSize);
+        std::vector<float> k(numTokens * mNumKvHeads * mHeadSize);
+        std::vector<float> v(numTokens * mNumKvHeads * mHeadSize);
+        for (auto* values : {&q, &k, &v})
+        {
+            std::generate(values->begin(), values->end(), [&]() { return dist(gen); });
+        }
+
+        auto seqOffsets = toBuffer(mShardOffsets);
+        auto seqLengthsBuffer = toBuffer(seqLengths);
+        auto const numShardTokens = mShardOffsets.back();
+        std::vector<TensorPtr> kShards;
+        std::vector<TensorPtr> vShards;
+        for (SizeType32 shardIdx = 0; shardIdx < numShards; ++shardIdx)
+        {
+            kShards.push_back(toShard(k, mNumKvHeads, shardIdx));
+            vShards.push_back(toShard(v, mNumKvHeads, shardIdx));
+        }
+
+        tk::RingAttentionParams<float> params;
+        params.seqOffsets = bufferCast<SizeType32>(*seqOffsets);
+        params.seqLengths = bufferCast<SizeType32>(*seqLengthsBuffer);
+        params.batchSize = static_cast<SizeType32>(seqLengths.size());
+        params.maxShardLength = maxShardLength;
+        params.numHeads = mNumHeads;
+        params.numKvHeads = mNumKvHeads;
+        params.headSize = mHeadSize;
+        params.causal = causal;
+        params.qkScale = 1.f / std::sqrt(static_cast<float>(mHeadSize));
+
+        for (SizeType32 qShardIdx = 0; qShardIdx < numShards; ++qShardIdx)
+        {
+            auto qShard = toShard(q, mNumHeads, qShardIdx);
+            auto accOut = BufferManager::pinned(
+                ITensor::makeShape({numShardTokens * mNumHeads * mHeadSize}), nvinfer1::DataType::kFLOAT);
+            auto accLse
+                = BufferManager::pinned(ITensor::makeShape({numShardTokens * mNumHeads}), nvinfer1::DataType::kFLOAT);
+            params.q = bufferCast<float>(*qShard);
+            params.accOut = bufferCast<float>(*accOut);
+            params.accLse = bufferCast<float>(*accLse);
+            params.qShardIdx = qShardIdx;
+            for (SizeType32 step = 0; step < numShards; ++step)
+            {
+                params.kvShardIdx = (qShardIdx + numShards - step) % numShards;
+                params.k = bufferCast<float>(*kShards[params.kvShardIdx]);
+                params.v = bufferCast<float>(*vShards[params.kvShardIdx]);
+                params.firstStep = step == 0;
+                if (params.firstStep || !tk::isRingAttentionStepMasked(params))
+                {
+                    tk::invokeRingAttentionStep(params, mStream->get());
+                }
+            }
+            mStream->synchronize();
+
+            auto const* outPtr = bufferCast<float>(*accOut);
+            SizeType32 seqBegin{0};
+            for (size_t si = 0; si < seqLengths.size(); ++si)
+            {
+                auto const shardLength = mShardOffsets[si + 1] - mShardOffsets[si];
+                for (SizeType32 ti = 0; ti < shardLength; ++ti)
+                {
+                    auto const pos = qShardIdx * shardLength + ti;
+                    if (pos >= seqLengths[si])
+                    {
+                        break;
+                    }
+                    auto const numKeys = causal ? pos + 1 : seqLengths[si];
+                    for (SizeType32 hi = 0; hi < mNumHeads; ++hi)
+                    {
+                        auto const kvHeadIdx = hi / (mNumHeads / mNumKvHeads);
+                        auto const* qRow = q.data() + ((seqBegin + pos) * mNumHeads + hi) * mHeadSize;
+                        std::vector<float> scores(numKeys);
+                        for (SizeType32 ki = 0; ki < numKeys; ++ki)
+                        {
+                            auto const* kRow = k.data() + ((seqBegin + ki) * mNumKvHeads + kvHeadIdx) * mHeadSize;
+                            float score{0.f};
+                            for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                            {
+                                score += qRow[ci] * kRow[ci];
+                            }
+                            scores[ki] = score * params.qkScale;
+                        }
+                        auto const maxScore = *std::max_element(scores.begin(), scores.end());
+                        float sum{0.f};
+                        for (auto& score : scores)
+                        {
+                            score = std::exp(score - maxScore);
+                            sum += score;
+                        }
+                        for (SizeType32 ci = 0; ci < mHeadSize; ++ci)
+                        {
+                            float ref{0.f};
+                            for (SizeType32 ki = 0; ki < numKeys; ++ki)
+                            {
+                                ref += scores[ki] / sum
+                                    * v[((seqBegin + ki) * mNumKvHeads + kvHeadIdx) * mHeadSize + ci];
+                            }
+                            auto const row = (mShardOffsets[si] + ti) * mNumHeads + hi;
+                            EXPECT_NEAR(outPtr[row * mHeadSize + ci], ref, 1e-4f)
+                                << "shard " << qShardIdx << " seq " << si << " pos " << pos << " head " << hi;
+                        }
+                    }
+                }
+                seqBegin += seqLengths[si];
+            }
+        }
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    std::vector<SizeType32> mSeqLengths;
+    std::vector<SizeType32> mShardOffsets;
+
+    SizeType32 const mNumHeads{4};
+    SizeType32 const mNumKvHeads{2};
+    SizeType32 const mHeadSize{40};
+};
+
+TEST_F(RingAttentionKernelsTest, CausalMatchesAttentionOverWholeSequences)
+{
+    // Sequences with padded shards, a shard longer than a tile of keys and a sequence shorter than the ring.
+    runAndCompare({37, 150, 3}, 4, true);
+}
+
+TEST_F(RingAttentionKernelsTest, BidirectionalMatchesAttentionOverWholeSequences)
+{
+    runAndCompare({64, 21}, 3, false);
+}
+
+TEST_F(RingAttentionKernelsTest, SingleShard)
+{
+    runAndCompare({45}, 1, true);
+}
+
+} // namespace
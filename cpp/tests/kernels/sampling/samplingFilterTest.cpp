@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/kernels/samplingFilterKernels.h"
+#include "tests/kernels/sampling/samplingTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace tensorrt_llm::tests::kernels::sampling;
+
+namespace
+{
+
+namespace tk = tensorrt_llm::kernels;
+
+using TensorPtr = tensorrt_llm::runtime::ITensor::SharedPtr;
+
+using namespace tensorrt_llm::runtime;
+
+struct FilterTestParam
+{
+    int32_t batchSize{1};
+    int32_t vocabSize{1};
+    std::vector<float> minPs;     // [batchSize]
+    std::vector<float> typicalPs; // [batchSize]
+    std::vector<float> etas;      // [batchSize]
+
+    FilterTestParam& setBatchSize(int32_t bs)
+    {
+        batchSize = bs;
+        return *this;
+    }
+
+    FilterTestParam& setVocabSize(int32_t vs)
+    {
+        vocabSize = vs;
+        return *this;
+    }
+
+    FilterTestParam& setMinPs(std::vector<float> values)
+    {
+        minPs = std::move(values);
+        return *this;
+    }
+
+    FilterTestParam& setTypicalPs(std::vector<float> values)
+    {
+        typicalPs = std::move(values);
+        return *this;
+    }
+
+    FilterTestParam& setEtas(std::vector<float> values)
+    {
+        etas = std::move(values);
+        return *this;
+    }
+};
+
+template <typename T>
+class FilterProbsKernelTest : public SamplingKernelTest<T>
+{
+protected:
+    using SamplingKernelTest<T>::mBufferManager;
+    using SamplingKernelTest<T>::mStream;
+
+    // Tokens kept by the filters, computed on the input distribution
+    std::vector<bool> computeReference(
+        float const* probs, int32_t vocabSize, float minP, float typicalP, float eta) const
+    {
+        auto const maxProb = *std::max_element(probs, probs + vocabSize);
+        float entropy = 0.f;
+        for (int32_t vi = 0; vi < vocabSize; ++vi)
+        {
+            entropy -= probs[vi] > 0.f ? probs[vi] * std::log(probs[vi]) : 0.f;
+        }
+        auto threshold = minP * maxProb;
+        if (eta > 0.f)
+        {
+            threshold = std::max(threshold, std::min(eta, std::sqrt(eta) * std::exp(-entropy)));
+        }
+
+        std::vector<bool> kept(vocabSize);
+        for (int32_t vi = 0; vi < vocabSize; ++vi)
+        {
+            kept[vi] = probs[vi] > 0.f && probs[vi] >= threshold;
+        }
+
+        if (typicalP < 1.f)
+        {
+            std::vector<int32_t> indices(vocabSize);
+            std::iota(indices.begin(), indices.end(), 0);
+            auto const deviation = [&](int32_t vi) { return std::abs(-std::log(probs[vi]) - entropy); };
+            std::sort(indices.begin(), indices.end(),
+                [&](int32_t lhs, int32_t rhs) { return deviation(lhs) < deviation(rhs); });
+            std::vector<bool> typical(vocabSize, false);
+            float mass = 0.f;
+            for (auto const vi : indices)
+            {
+                if (mass >= typicalP)
+                {
+                    break;
+                }
+                typical[vi] = true;
+                mass += probs[vi];
+            }
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                kept[vi] = kept[vi] && typical[vi];
+            }
+        }
+
+        if (std::none_of(kept.begin(), kept.end(), [](bool k) { return k; }))
+        {
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                kept[vi] = probs[vi] == maxProb;
+            }
+        }
+        return kept;
+    }
+
+public:
+    void runTest(FilterTestParam const& param)
+    {
+        auto const batchSize = param.batchSize;
+        auto const maxBatchSize = 2 * batchSize;
+        auto const vocabSize = param.vocabSize;
+        auto const dataType = TRTDataType<T>::value;
+
+        auto logitsHost = BufferManager::pinned(ITensor::makeShape({batchSize, vocabSize}), dataType);
+        auto probsHost = BufferManager::pinned(ITensor::makeShape({batchSize, vocabSize}), dataType);
+        initRandom(bufferCast<T>(*logitsHost), batchSize * vocabSize, -3.0f, 3.0f);
+        computeProb(bufferCast<T>(*probsHost), bufferCast<T>(*logitsHost), batchSize, vocabSize);
+        auto probsDevice = mBufferManager->copyFrom(*probsHost, MemoryType::kGPU);
+
+        auto batchSlots = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto batchSlotsPtr = bufferCast<int32_t>(*batchSlots);
+        std::vector<float> minPs(maxBatchSize, 0.f);
+        std::vector<float> typicalPs(maxBatchSize, 1.f);
+        std::vector<float> etas(maxBatchSize, 0.f);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            batchSlotsPtr[bi] = 2 * bi;
+            minPs[2 * bi] = param.minPs.empty() ? 0.f : param.minPs[bi];
+            typicalPs[2 * bi] = param.typicalPs.empty() ? 1.f : param.typicalPs[bi];
+            etas[2 * bi] = param.etas.empty() ? 0.f : param.etas[bi];
+        }
+        auto minPsDevice = mBufferManager->copyFrom(minPs, ITensor::makeShape({maxBatchSize}), MemoryType::kGPU);
+        auto typicalPsDevice
+            = mBufferManager->copyFrom(typicalPs, ITensor::makeShape({maxBatchSize}), MemoryType::kGPU);
+        auto etasDevice = mBufferManager->copyFrom(etas, ITensor::makeShape({maxBatchSize}), MemoryType::kGPU);
+
+        tk::FilterProbsKernelParams<T> kernelParams;
+        kernelParams.probs = bufferCast<T>(*probsDevice);
+        kernelParams.minPs = bufferCast<float>(*minPsDevice);
+        kernelParams.typicalPs = bufferCast<float>(*typicalPsDevice);
+        kernelParams.etas = bufferCast<float>(*etasDevice);
+        kernelParams.batchSlots = batchSlotsPtr;
+        kernelParams.batchSize = batchSize;
+        kernelParams.maxBatchSize = maxBatchSize;
+        kernelParams.vocabSize = vocabSize;
+        kernelParams.vocabSizePadded = vocabSize;
+        tk::invokeBatchFilterProbs(kernelParams, mStream->get());
+
+        auto outProbsHost = mBufferManager->copyFrom(*probsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+
+        auto const inProbsPtr = bufferCast<T>(*probsHost);
+        auto const outProbsPtr = bufferCast<T>(*outProbsHost);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            auto const batchSlot = batchSlotsPtr[bi];
+            std::vector<float> probs(vocabSize);
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                probs[vi] = static_cast<float>(inProbsPtr[bi * vocabSize + vi]);
+            }
+            auto const kept
+                = computeReference(probs.data(), vocabSize, minPs[batchSlot], typicalPs[batchSlot], etas[batchSlot]);
+            float keptMass = 0.f;
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                keptMass += kept[vi] ? probs[vi] : 0.f;
+            }
+
+            // The boundary of the typical set is found up to the bisection precision
+            int32_t numMismatches = 0;
+            float outMass = 0.f;
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                auto const outProb = static_cast<float>(outProbsPtr[bi * vocabSize + vi]);
+                outMass += outProb;
+                numMismatches += kept[vi] != (outProb > 0.f);
+                if (kept[vi] && outProb > 0.f)
+                {
+                    EXPECT_NEAR(outProb, probs[vi] / keptMass, 1e-2f) << "bi " << bi << " vi " << vi;
+                }
+            }
+            EXPECT_LE(numMismatches, 1) << "bi " << bi;
+            EXPECT_NEAR(outMass, 1.f, 2e-2f) << "bi " << bi;
+        }
+    }
+};
+
+TYPED_TEST_SUITE(FilterProbsKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(FilterProbsKernelTest, NoFilter)
+{
+    this->runTest(FilterTestParam().setBatchSize(4).setVocabSize(100));
+}
+
+TYPED_TEST(FilterProbsKernelTest, MinP)
+{
+    this->runTest(FilterTestParam().setBatchSize(4).setVocabSize(1000).setMinPs({0.05f, 0.1f, 0.5f, 1.0f}));
+}
+
+TYPED_TEST(FilterProbsKernelTest, TypicalP)
+{
+    this->runTest(FilterTestParam().setBatchSize(4).setVocabSize(1000).setTypicalPs({0.2f, 0.5f, 0.9f, 1.0f}));
+}
+
+TYPED_TEST(FilterProbsKernelTest, Eta)
+{
+    this->runTest(FilterTestParam().setBatchSize(4).setVocabSize(1000).setEtas({0.0003f, 0.001f, 0.01f, 0.f}));
+}
+
+TYPED_TEST(FilterProbsKernelTest, MixedBatch)
+{
+    this->runTest(FilterTestParam()
+                      .setBatchSize(4)
+                      .setVocabSize(51200)
+                      .setMinPs({0.1f, 0.f, 0.f, 0.05f})
+                      .setTypicalPs({1.f, 0.9f, 1.f, 0.9f})
+                      .setEtas({0.f, 0.f, 0.0009f, 0.0009f}));
+}
+} // namespace
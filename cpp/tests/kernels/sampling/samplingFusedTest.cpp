@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef TOP_LEVEL_DIR
+#error "Define TOP_LEVEL_DIR"
+#endif
+
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/kernels/fusedSamplingKernels.h"
+#include "tests/kernels/sampling/samplingTest.h"
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+using namespace tensorrt_llm::tests::kernels::sampling;
+
+namespace
+{
+
+template <typename T>
+class FusedSamplingKernelTest : public SamplingKernelTest<T>
+{
+
+protected:
+    using SamplingKernelTest<T>::mStream;
+    using SamplingKernelTest<T>::mBufferManager;
+
+    // Vocab shards sampled on one device, shard candidates are already in the shared workspace
+    SizeType32 mNumShards{1};
+
+    size_t getWorkspaceSize(SamplingKernelTestParam const& params) override
+    {
+        auto const shardSize = tc::ceilDiv(params.vocabSize, mNumShards);
+        return tk::getFusedSamplingWorkspaceSize(params.batchSize, this->mMaxTopK, shardSize, mNumShards);
+    }
+
+    void callTestedFunction(
+        SamplingKernelTestParam const& params, tensorrt_llm::runtime::ITensor::SharedPtr& workspaceDevice) override
+    {
+        auto const maxBatchSize = 2 * params.batchSize;
+
+        // The fused kernel takes the raw logits and computes the softmax itself
+        mLogitsDevice = mBufferManager->copyFrom(*this->mLogitsHost, MemoryType::kGPU);
+        auto const shardSize = tc::ceilDiv(params.vocabSize, mNumShards);
+        mLogitsPtrs = BufferManager::pinned(
+            ITensor::makeShape({mNumShards, params.batchSize}), nvinfer1::DataType::kINT64);
+        auto logitsPtrs = BufferRange<T const*>(*mLogitsPtrs);
+        for (SizeType32 si = 0; si < mNumShards; ++si)
+        {
+            for (SizeType32 bi = 0; bi < params.batchSize; ++bi)
+            {
+                logitsPtrs[si * params.batchSize + bi]
+                    = bufferCast<T>(*mLogitsDevice) + bi * params.vocabSize + si * shardSize;
+            }
+        }
+
+        tk::FusedSamplingKernelParams<T> kernelParams;
+        kernelParams.outputIdsPtrs = bufferCast<int32_t*>(*this->mIdsPtrHost);
+        kernelParams.workspace = workspaceDevice->data();
+        kernelParams.endIds = bufferCast<int32_t>(*this->mEndIdsDevice);
+        kernelParams.sequenceLengths = bufferCast<int32_t>(*this->mSeqLengthsDevice);
+        kernelParams.batchSlots = bufferCast<int32_t>(*this->mBatchSlots);
+        kernelParams.finishedInput = reinterpret_cast<tk::FinishedState*>(
+            bufferCast<tk::FinishedState::UnderlyingType>(*this->mFinishedDevice));
+        kernelParams.finishedOutput = reinterpret_cast<tk::FinishedState*>(
+            bufferCast<tk::FinishedState::UnderlyingType>(*this->mFinishedDevice));
+        kernelParams.skipDecode = bufferCast<bool>(*this->mSkipDecodeDevice);
+        kernelParams.cumLogProbs = bufferCast<float>(*this->mCumLogProbsDevice);
+        kernelParams.outputLogProbs = bufferCast<float>(*this->mOutputLogProbsDevice);
+        kernelParams.curandState = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*this->mCurandStatesDevice));
+        kernelParams.topKs = bufferCast<int32_t>(*this->mTopKsDevice);
+        kernelParams.topPs = bufferCast<float>(*this->mTopPsDevice);
+        kernelParams.maxTopK = this->mMaxTopK;
+        kernelParams.maxTopP = params.topP;
+        kernelParams.batchSize = params.batchSize;
+        kernelParams.maxBatchSize = maxBatchSize;
+        kernelParams.vocabSize = params.vocabSize;
+        kernelParams.vocabSizePadded = params.vocabSize;
+        kernelParams.maxSeqLen = this->mMaxSeqLen;
+        kernelParams.normalizeLogProbs = params.normalizeLogProbs;
+
+        if (mNumShards == 1)
+        {
+            kernelParams.logitsPtrs = reinterpret_cast<T const* const*>(bufferCast<int64_t>(*mLogitsPtrs));
+            tk::invokeFusedPenaltyTopKSampling(kernelParams, mStream->get());
+            return;
+        }
+
+        kernelParams.vocabShardSize = shardSize;
+        kernelParams.numShards = mNumShards;
+        for (SizeType32 si = 0; si < mNumShards; ++si)
+        {
+            kernelParams.logitsPtrs
+                = reinterpret_cast<T const* const*>(bufferCast<int64_t>(*mLogitsPtrs)) + si * params.batchSize;
+            kernelParams.vocabShardBegin = si * shardSize;
+            kernelParams.shardRank = si;
+            tk::invokeFusedPenaltyTopKCandidates(kernelParams, mStream->get());
+        }
+        tk::invokeFusedTopKSamplingFromCandidates(kernelParams, mStream->get());
+    }
+
+private:
+    ITensor::SharedPtr mLogitsDevice;
+    ITensor::SharedPtr mLogitsPtrs;
+};
+
+TYPED_TEST_SUITE(FusedSamplingKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessGreedy)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(1).setTopP(1.0f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessGreedyLarge)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(51200).setTopK(1).setTopP(1.0f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessAncestral)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(4).setTopP(1.0f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessLargeK63)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(51200).setTopK(63).setTopP(1.0f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessTopKTopP)
+{
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(4000).setTopK(63).setTopP(0.3f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessGreedyVocabShards)
+{
+    this->mNumShards = 4;
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(51203).setTopK(1).setTopP(1.0f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, CorrectnessTopKTopPVocabShards)
+{
+    this->mNumShards = 3;
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(10000).setTopK(63).setTopP(0.3f));
+};
+
+TYPED_TEST(FusedSamplingKernelTest, NotSupportedLargerThanK64)
+{
+    EXPECT_THROW(
+        this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(4000).setTopK(65).setTopP(1.0f)),
+        tensorrt_llm::common::TllmException);
+};
+} // end of namespace
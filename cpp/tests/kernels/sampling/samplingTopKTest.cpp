@@ -41,6 +41,8 @@ protected:
     using SamplingKernelTest<T>::mStream;
     using SamplingKernelTest<T>::mBufferManager;
 
+    bool mBatchInvariant{false};
+
     size_t getWorkspaceSize(SamplingKernelTestParam const& params) override
     {
         return tk::getTopKWorkspaceSize<T>(params.batchSize, params.maxTokensPerStep, this->mMaxTopK, params.vocabSize);
@@ -85,6 +87,7 @@ protected:
         kernelParams.normalizeLogProbs = params.normalizeLogProbs;
         kernelParams.logitsHasProbs = params.logitsHasProbs;
         kernelParams.returnAllTopK = params.returnAllTopK;
+        kernelParams.batchInvariant = mBatchInvariant;
 
         // Perform batched TopK sampling
         tk::invokeBatchTopKSampling(kernelParams, this->mStream->get());
@@ -123,6 +126,18 @@ TYPED_TEST(TopKSamplingKernelTest, CorrectnessTopKTopP)
     this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(4000).setTopK(63).setTopP(0.3f));
 };
 
+TYPED_TEST(TopKSamplingKernelTest, CorrectnessBatchInvariant)
+{
+    this->mBatchInvariant = true;
+    this->runTest(SamplingKernelTestParam().setBatchSize(6).setVocabSize(4).setTopK(4).setTopP(1.0f));
+};
+
+TYPED_TEST(TopKSamplingKernelTest, CorrectnessBatchInvariantTopKTopP)
+{
+    this->mBatchInvariant = true;
+    this->runTest(SamplingKernelTestParam().setBatchSize(16).setVocabSize(4000).setTopK(63).setTopP(0.3f));
+};
+
 TYPED_TEST(TopKSamplingKernelTest, NotSupportedLargerThanK1024)
 {
     EXPECT_THROW(
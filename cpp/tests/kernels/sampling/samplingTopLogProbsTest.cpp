@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/kernels/topLogProbsKernels.h"
+#include "tests/kernels/sampling/samplingTest.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <numeric>
+
+using namespace tensorrt_llm::tests::kernels::sampling;
+
+namespace
+{
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+struct TopLogProbsTestParam
+{
+    int32_t batchSize{1};
+    int32_t vocabSize{1};
+    std::vector<int32_t> numTopLogProbs; // [batchSize]
+
+    TopLogProbsTestParam& setBatchSize(int32_t bs)
+    {
+        batchSize = bs;
+        return *this;
+    }
+
+    TopLogProbsTestParam& setVocabSize(int32_t vs)
+    {
+        vocabSize = vs;
+        return *this;
+    }
+
+    TopLogProbsTestParam& setNumTopLogProbs(std::vector<int32_t> values)
+    {
+        numTopLogProbs = std::move(values);
+        return *this;
+    }
+};
+
+template <typename T>
+class TopLogProbsKernelTest : public SamplingKernelTest<T>
+{
+protected:
+    using SamplingKernelTest<T>::mBufferManager;
+    using SamplingKernelTest<T>::mStream;
+
+    static constexpr int32_t kMaxSeqLen = 8;
+    static constexpr int32_t kMaxNumTopLogProbs = tk::TOP_LOG_PROBS_MAX;
+
+public:
+    void runTest(TopLogProbsTestParam const& param)
+    {
+        auto const batchSize = param.batchSize;
+        auto const maxBatchSize = 2 * batchSize;
+        auto const vocabSize = param.vocabSize;
+        auto const dataType = TRTDataType<T>::value;
+
+        auto logitsHost = BufferManager::pinned(ITensor::makeShape({batchSize, vocabSize}), dataType);
+        initRandom(bufferCast<T>(*logitsHost), batchSize * vocabSize, -5.0f, 5.0f);
+        auto logitsDevice = mBufferManager->copyFrom(*logitsHost, MemoryType::kGPU);
+
+        auto batchSlots = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+        auto batchSlotsPtr = bufferCast<int32_t>(*batchSlots);
+        std::vector<int32_t> numTopLogProbs(maxBatchSize, 0);
+        std::vector<int32_t> sequenceLengths(maxBatchSize, 0);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            batchSlotsPtr[bi] = 2 * bi;
+            numTopLogProbs[2 * bi] = param.numTopLogProbs[bi];
+            sequenceLengths[2 * bi] = bi % kMaxSeqLen;
+        }
+        auto numTopLogProbsDevice
+            = mBufferManager->copyFrom(numTopLogProbs, ITensor::makeShape({maxBatchSize}), MemoryType::kGPU);
+        auto sequenceLengthsDevice
+            = mBufferManager->copyFrom(sequenceLengths, ITensor::makeShape({maxBatchSize}), MemoryType::kGPU);
+
+        auto const outputShape = ITensor::makeShape({maxBatchSize, kMaxSeqLen, kMaxNumTopLogProbs});
+        auto topLogProbsDevice = mBufferManager->gpu(outputShape, nvinfer1::DataType::kFLOAT);
+        auto topLogProbIdsDevice = mBufferManager->gpu(outputShape, nvinfer1::DataType::kINT32);
+        mBufferManager->setZero(*topLogProbsDevice);
+        mBufferManager->setZero(*topLogProbIdsDevice);
+
+        tk::TopLogProbsKernelParams<T> kernelParams;
+        kernelParams.logits = bufferCast<T>(*logitsDevice);
+        kernelParams.numTopLogProbs = bufferCast<int32_t>(*numTopLogProbsDevice);
+        kernelParams.sequenceLengths = bufferCast<int32_t>(*sequenceLengthsDevice);
+        kernelParams.batchSlots = batchSlotsPtr;
+        kernelParams.topLogProbs = bufferCast<float>(*topLogProbsDevice);
+        kernelParams.topLogProbIds = bufferCast<int32_t>(*topLogProbIdsDevice);
+        kernelParams.batchSize = batchSize;
+        kernelParams.maxBatchSize = maxBatchSize;
+        kernelParams.maxSeqLen = kMaxSeqLen;
+        kernelParams.vocabSize = vocabSize;
+        kernelParams.vocabSizePadded = vocabSize;
+        kernelParams.maxNumTopLogProbs = kMaxNumTopLogProbs;
+        tk::invokeTopLogProbs(kernelParams, mStream->get());
+
+        auto topLogProbsHost = mBufferManager->copyFrom(*topLogProbsDevice, MemoryType::kCPU);
+        auto topLogProbIdsHost = mBufferManager->copyFrom(*topLogProbIdsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+
+        auto const logitsPtr = bufferCast<T>(*logitsHost);
+        auto const topLogProbsPtr = bufferCast<float>(*topLogProbsHost);
+        auto const topLogProbIdsPtr = bufferCast<int32_t>(*topLogProbIdsHost);
+        for (int32_t bi = 0; bi < batchSize; ++bi)
+        {
+            auto const batchSlot = batchSlotsPtr[bi];
+            std::vector<float> logits(vocabSize);
+            for (int32_t vi = 0; vi < vocabSize; ++vi)
+            {
+                logits[vi] = static_cast<float>(logitsPtr[bi * vocabSize + vi]);
+            }
+            auto const maxLogit = *std::max_element(logits.begin(), logits.end());
+            double sum = 0.0;
+            for (auto const logit : logits)
+            {
+                sum += std::exp(logit - maxLogit);
+            }
+            auto const logSumExp = maxLogit + static_cast<float>(std::log(sum));
+            std::vector<float> sortedLogits(logits);
+            std::sort(sortedLogits.begin(), sortedLogits.end(), std::greater<float>());
+
+            auto const numTop = numTopLogProbs[batchSlot];
+            for (int32_t si = 0; si < kMaxSeqLen; ++si)
+            {
+                auto const offset = (batchSlot * kMaxSeqLen + si) * kMaxNumTopLogProbs;
+                for (int32_t ki = 0; ki < kMaxNumTopLogProbs; ++ki)
+                {
+                    auto const id = topLogProbIdsPtr[offset + ki];
+                    auto const logProb = topLogProbsPtr[offset + ki];
+                    if (si != sequenceLengths[batchSlot] || ki >= numTop)
+                    {
+                        // Only the alternatives of the generated token are written
+                        EXPECT_EQ(id, 0) << "bi " << bi << " si " << si << " ki " << ki;
+                        EXPECT_EQ(logProb, 0.f) << "bi " << bi << " si " << si << " ki " << ki;
+                        continue;
+                    }
+                    ASSERT_GE(id, 0);
+                    ASSERT_LT(id, vocabSize);
+                    // Ties may be returned in any order, compare the logits instead of the ids
+                    EXPECT_EQ(logits[id], sortedLogits[ki]) << "bi " << bi << " ki " << ki;
+                    EXPECT_NEAR(logProb, logits[id] - logSumExp, 1e-3f) << "bi " << bi << " ki " << ki;
+                }
+            }
+        }
+    }
+};
+
+TYPED_TEST_SUITE(TopLogProbsKernelTest, FloatAndHalfTypes);
+
+TYPED_TEST(TopLogProbsKernelTest, SingleAlternative)
+{
+    this->runTest(TopLogProbsTestParam().setBatchSize(4).setVocabSize(100).setNumTopLogProbs({1, 1, 1, 1}));
+}
+
+TYPED_TEST(TopLogProbsKernelTest, MaxAlternatives)
+{
+    auto const n = tk::TOP_LOG_PROBS_MAX;
+    this->runTest(TopLogProbsTestParam().setBatchSize(4).setVocabSize(1000).setNumTopLogProbs({n, n, n, n}));
+}
+
+TYPED_TEST(TopLogProbsKernelTest, SmallVocab)
+{
+    // Fewer tokens than threads, the alternatives of the second request cover the whole vocab
+    this->runTest(TopLogProbsTestParam().setBatchSize(2).setVocabSize(20).setNumTopLogProbs({5, 20}));
+}
+
+TYPED_TEST(TopLogProbsKernelTest, MixedBatch)
+{
+    this->runTest(
+        TopLogProbsTestParam().setBatchSize(6).setVocabSize(51200).setNumTopLogProbs({0, 3, 20, 0, 7, 1}));
+}
+} // namespace
@@ -40,6 +40,15 @@ __global__ void generateRandomNumber(
     }
 }
 
+__global__ void generatePhiloxUniform(float* vals, uint64_t const* seeds, SizeType32 step, SizeType32 numDraws)
+{
+    auto const bid = static_cast<SizeType32>(blockIdx.x);
+    for (auto di = static_cast<SizeType32>(threadIdx.x); di < numDraws; di += static_cast<SizeType32>(blockDim.x))
+    {
+        vals[bid * numDraws + di] = tk::philoxUniform(seeds[bid], step, di);
+    }
+}
+
 class SamplingUtilsKernelTest : public SamplingKernelTest<float>
 {
 };
@@ -90,6 +99,55 @@ TEST_F(SamplingUtilsKernelTest, CurandInitialize)
     }
 }
 
+TEST_F(SamplingUtilsKernelTest, PhiloxUniform)
+{
+    SizeType32 constexpr batchSize{4};
+    SizeType32 constexpr numDraws{256};
+
+    // The first two requests share a seed
+    auto seedsHost = mBufferManager->pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT64);
+    auto seedsHostPtr = reinterpret_cast<uint64_t*>(bufferCast<int64_t>(*seedsHost));
+    std::vector<uint64_t> const seeds{7, 7, 8, 1ULL << 40};
+    std::copy(seeds.begin(), seeds.end(), seedsHostPtr);
+    auto seedsDevice = mBufferManager->copyFrom(*seedsHost, MemoryType::kGPU);
+    auto const* seedsDevicePtr = reinterpret_cast<uint64_t const*>(bufferCast<int64_t>(*seedsDevice));
+
+    auto generate = [&](SizeType32 step)
+    {
+        auto valsDevice = mBufferManager->gpu(ITensor::makeShape({batchSize, numDraws}), nvinfer1::DataType::kFLOAT);
+        generatePhiloxUniform<<<batchSize, 64, 0, mStream->get()>>>(
+            bufferCast<float>(*valsDevice), seedsDevicePtr, step, numDraws);
+        sync_check_cuda_error();
+        auto valsHost = mBufferManager->copyFrom(*valsDevice, MemoryType::kCPU);
+        mStream->synchronize();
+        auto const* valsHostPtr = bufferCast<float>(*valsHost);
+        return std::vector<float>(valsHostPtr, valsHostPtr + batchSize * numDraws);
+    };
+
+    auto const step3 = generate(3);
+    auto const step4 = generate(4);
+    // Stateless: drawing again at the same step gives the same numbers
+    EXPECT_EQ(generate(3), step3);
+
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const begin = step3.begin() + bi * numDraws;
+        auto const sameSeed = bi == 1;
+        EXPECT_EQ(std::equal(begin, begin + numDraws, step3.begin()), sameSeed) << "bi: " << bi;
+        EXPECT_FALSE(std::equal(begin, begin + numDraws, step4.begin() + bi * numDraws)) << "bi: " << bi;
+
+        auto mean = 0.0;
+        for (auto it = begin; it != begin + numDraws; ++it)
+        {
+            EXPECT_GT(*it, 0.f);
+            EXPECT_LE(*it, 1.f);
+            mean += *it;
+        }
+        mean /= numDraws;
+        EXPECT_NEAR(mean, 0.5, 0.1) << "bi: " << bi;
+    }
+}
+
 TEST_F(SamplingUtilsKernelTest, CurandBatchInitialize)
 {
     SizeType32 batchSize = 127;
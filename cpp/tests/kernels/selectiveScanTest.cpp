@@ -0,0 +1,343 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/selectiveScan.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The Mamba selective scan in fp32 over packed sequences of different lengths, written to state slots in a different
+// order than the samples. The context scan split in chunks must match the single pass scan and a scan on the host, for
+// the outputs and for the state left in the slots, starting from zero or from the state in the slots. The generation
+// step, vectorized over 4 channels when they allow it, must match a step on the host.
+class SelectiveScanTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0 || tc::getSMVersion() < 80)
+        {
+            GTEST_SKIP() << "The selective scan requires SM80+";
+        }
+        mStream = std::make_shared<CudaStream>();
+
+        std::mt19937 gen(42);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        auto const fill = [&](ITensor::SharedPtr& tensor, ITensor::DimType64 rows, ITensor::DimType64 cols)
+        {
+            tensor = BufferManager::pinned(ITensor::makeShape({rows, cols}), nvinfer1::DataType::kFLOAT);
+            std::generate_n(bufferCast<float>(*tensor), tensor->getSize(), [&]() { return dist(gen); });
+        };
+
+        auto const numTokens = std::accumulate(mSeqLens.begin(), mSeqLens.end(), 0);
+        fill(mX, numTokens, kDim);
+        fill(mDt, numTokens, kDim);
+        fill(mZ, numTokens, kDim);
+        fill(mBC, numTokens, kDtRank + 2 * kDState);
+        fill(mDtBias, 1, kDim);
+        fill(mD, 1, kDim);
+        fill(mInitialState, kNumSlots, kDState * kDim);
+        // Decaying states, A = -exp(a) like the Mamba A_log
+        fill(mA, kDState, kDim);
+        std::transform(bufferCast<float>(*mA), bufferCast<float>(*mA) + mA->getSize(), bufferCast<float>(*mA),
+            [](float a) { return -std::exp(a); });
+
+        auto const batch = static_cast<SizeType32>(mSeqLens.size());
+        mLastTokenIds = BufferManager::pinned(ITensor::makeShape({batch}), nvinfer1::DataType::kINT32);
+        std::partial_sum(mSeqLens.begin(), mSeqLens.end(), bufferCast<std::int32_t>(*mLastTokenIds));
+        mSlotMapping = BufferManager::pinned(ITensor::makeShape({batch}), nvinfer1::DataType::kINT32);
+        std::copy(mSlots.begin(), mSlots.end(), bufferCast<std::int32_t>(*mSlotMapping));
+    }
+
+    struct Result
+    {
+        std::vector<float> output;
+        std::vector<float> state;
+    };
+
+    //! \brief Parameters of the scan of the packed sequences, over a copy of the initial state in `state`.
+    tk::SSMParamsBase makeParams(ITensor& output, ITensor& state, bool loadInitialState) const
+    {
+        std::copy_n(bufferCast<float>(*mInitialState), mInitialState->getSize(), bufferCast<float>(state));
+
+        tk::SSMParamsBase params{};
+        params.batch = static_cast<int>(mSeqLens.size());
+        params.dim = kDim;
+        params.dstate = kDState;
+        params.dt_rank = kDtRank;
+        params.max_seqlen = -1;
+        params.remove_padding = true;
+        params.is_variable_B = true;
+        params.is_variable_C = true;
+        params.delta_softplus = true;
+        params.A_ptr = mA->data();
+        params.BC_ptr = mBC->data();
+        params.D_ptr = mD->data();
+        params.u_ptr = mX->data();
+        params.delta_ptr = mDt->data();
+        params.delta_bias_ptr = mDtBias->data();
+        params.out_ptr = output.data();
+        params.x_ptr = state.data();
+        params.z_ptr = mZ->data();
+        params.last_token_ids_ptr = bufferCast<std::int32_t>(*mLastTokenIds);
+        params.slot_mapping_ptr = bufferCast<std::int32_t>(*mSlotMapping);
+        params.load_initial_state = loadInitialState;
+        params.num_chunks = 1;
+        return params;
+    }
+
+    //! \brief Runs the context scan in `numChunks` chunks, the way the selective scan plugin sizes them.
+    Result runScan(int numChunks, bool loadInitialState)
+    {
+        auto output = BufferManager::pinned(mX->getShape(), nvinfer1::DataType::kFLOAT);
+        auto state = BufferManager::pinned(mInitialState->getShape(), nvinfer1::DataType::kFLOAT);
+        auto params = makeParams(*output, *state, loadInitialState);
+
+        auto const numTokens = static_cast<int>(mX->getShape().d[0]);
+        params.num_chunks = numChunks;
+        params.chunk_size = tc::divUp(numTokens, numChunks);
+        auto chunkStates = BufferManager::pinned(
+            ITensor::makeShape({params.batch * numChunks, kDState + 1, kDim}), nvinfer1::DataType::kFLOAT);
+        params.chunk_states_ptr = chunkStates->data();
+
+        tk::invokeSelectiveScan<float, float>(params, mStream->get());
+        mStream->synchronize();
+        return {toVector(*output), toVector(*state)};
+    }
+
+    //! \brief The scan on the host, token by token.
+    Result referenceScan(bool loadInitialState) const
+    {
+        auto const* x = bufferCast<float>(*mX);
+        auto const* dt = bufferCast<float>(*mDt);
+        auto const* z = bufferCast<float>(*mZ);
+        auto const* bc = bufferCast<float>(*mBC);
+        auto const* A = bufferCast<float>(*mA);
+        auto const* D = bufferCast<float>(*mD);
+        auto const* dtBias = bufferCast<float>(*mDtBias);
+
+        Result result{std::vector<float>(mX->getSize()), toVector(*mInitialState)};
+        SizeType32 token = 0;
+        for (std::size_t sample = 0; sample < mSeqLens.size(); ++sample)
+        {
+            auto* state = result.state.data() + mSlots[sample] * kDState * kDim;
+            if (!loadInitialState)
+            {
+                std::fill_n(state, kDState * kDim, 0.f);
+            }
+            for (SizeType32 t = 0; t < mSeqLens[sample]; ++t, ++token)
+            {
+                auto const* B = bc + token * (kDtRank + 2 * kDState) + kDtRank;
+                auto const* C = B + kDState;
+                for (SizeType32 c = 0; c < kDim; ++c)
+                {
+                    auto const idx = token * kDim + c;
+                    float const dtB = dt[idx] + dtBias[c];
+                    float const delta = dtB <= 20.f ? std::log1p(std::exp(dtB)) : dtB;
+                    float out = D[c] * x[idx];
+                    for (SizeType32 i = 0; i < kDState; ++i)
+                    {
+                        auto& h = state[i * kDim + c];
+                        h = h * std::exp(A[i * kDim + c] * delta) + B[i] * delta * x[idx];
+                        out += h * C[i];
+                    }
+                    result.output[idx] = out * z[idx] / (1.f + std::exp(-z[idx]));
+                }
+            }
+        }
+        return result;
+    }
+
+    //! \brief Runs one generation step of each sample over `dim` channels in T, compares the outputs and the slots
+    //! with a step on the host over the same T rounded values.
+    template <typename T>
+    void checkGenerationStep(SizeType32 dim, float relTol)
+    {
+        auto const batch = static_cast<SizeType32>(mSlots.size());
+        auto const bcCols = kDtRank + 2 * kDState;
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<float> dist(-1.f, 1.f);
+        auto const make = [&](ITensor::DimType64 rows, ITensor::DimType64 cols, nvinfer1::DataType type)
+        {
+            ITensor::SharedPtr tensor = BufferManager::pinned(ITensor::makeShape({rows, cols}), type);
+            std::vector<float> values(tensor->getSize());
+            for (std::size_t i = 0; i < values.size(); ++i)
+            {
+                if (type == nvinfer1::DataType::kFLOAT)
+                {
+                    values[i] = bufferCast<float>(*tensor)[i] = dist(gen);
+                }
+                else
+                {
+                    bufferCast<T>(*tensor)[i] = T(dist(gen));
+                    values[i] = static_cast<float>(bufferCast<T>(*tensor)[i]);
+                }
+            }
+            return std::make_pair(tensor, values);
+        };
+        auto const type = TRTDataType<T>::value;
+        auto [x, hX] = make(batch, dim, type);
+        auto [dt, hDt] = make(batch, dim, type);
+        auto [z, hZ] = make(batch, dim, type);
+        auto [bc, hBC] = make(batch, bcCols, type);
+        auto [state, hState] = make(kNumSlots, kDState * dim, type);
+        auto [A, hA] = make(kDState, dim, nvinfer1::DataType::kFLOAT);
+        auto [D, hD] = make(1, dim, nvinfer1::DataType::kFLOAT);
+        auto [dtBias, hDtBias] = make(1, dim, nvinfer1::DataType::kFLOAT);
+        for (std::size_t i = 0; i < hA.size(); ++i)
+        {
+            hA[i] = bufferCast<float>(*A)[i] = -std::exp(hA[i]);
+        }
+        auto output = BufferManager::pinned(ITensor::makeShape({batch, dim}), type);
+
+        tk::SSMParamsBase params{};
+        params.batch = batch;
+        params.dim = dim;
+        params.dstate = kDState;
+        params.dt_rank = kDtRank;
+        params.is_variable_B = true;
+        params.is_variable_C = true;
+        params.delta_softplus = true;
+        params.A_ptr = A->data();
+        params.BC_ptr = bc->data();
+        params.D_ptr = D->data();
+        params.u_ptr = x->data();
+        params.delta_ptr = dt->data();
+        params.delta_bias_ptr = dtBias->data();
+        params.out_ptr = output->data();
+        params.x_ptr = state->data();
+        params.z_ptr = z->data();
+        params.slot_mapping_ptr = bufferCast<std::int32_t>(*mSlotMapping);
+        tk::invokeSelectiveScanUpdate<T, float>(params, mStream->get());
+        mStream->synchronize();
+
+        std::vector<float> expectedOutput(batch * dim);
+        for (SizeType32 sample = 0; sample < batch; ++sample)
+        {
+            auto* h = hState.data() + mSlots[sample] * kDState * dim;
+            auto const* B = hBC.data() + sample * bcCols + kDtRank;
+            auto const* C = B + kDState;
+            for (SizeType32 c = 0; c < dim; ++c)
+            {
+                auto const idx = sample * dim + c;
+                float const dtB = hDt[idx] + hDtBias[c];
+                float const delta = dtB <= 20.f ? std::log1p(std::exp(dtB)) : dtB;
+                float out = hD[c] * hX[idx];
+                for (SizeType32 i = 0; i < kDState; ++i)
+                {
+                    auto& hi = h[i * dim + c];
+                    hi = hi * std::exp(hA[i * dim + c] * delta) + B[i] * delta * hX[idx];
+                    out += hi * C[i];
+                }
+                expectedOutput[idx] = out * hZ[idx] / (1.f + std::exp(-hZ[idx]));
+            }
+        }
+
+        auto const toFloats = [](ITensor const& tensor)
+        {
+            auto const* data = bufferCast<T>(tensor);
+            std::vector<float> values(tensor.getSize());
+            std::transform(data, data + values.size(), values.begin(), [](T v) { return static_cast<float>(v); });
+            return values;
+        };
+        expectNear(toFloats(*output), expectedOutput, relTol);
+        // The slot no sample maps to is left as is
+        expectNear(toFloats(*state), hState, relTol);
+    }
+
+    static std::vector<float> toVector(ITensor const& tensor)
+    {
+        auto const* data = bufferCast<float>(tensor);
+        return std::vector<float>(data, data + tensor.getSize());
+    }
+
+    static void expectNear(std::vector<float> const& actual, std::vector<float> const& expected, float relTol)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < actual.size(); ++i)
+        {
+            ASSERT_NEAR(actual[i], expected[i], relTol * std::max(1.f, std::abs(expected[i]))) << "index " << i;
+        }
+    }
+
+    static constexpr SizeType32 kDim{256};
+    static constexpr SizeType32 kDState{16};
+    static constexpr SizeType32 kDtRank{8};
+    static constexpr SizeType32 kNumSlots{4};
+
+    std::shared_ptr<CudaStream> mStream;
+    // A sequence of several chunks, one ending mid-chunk and one shorter than a chunk
+    std::vector<SizeType32> mSeqLens{700, 300, 37};
+    std::vector<SizeType32> mSlots{2, 0, 3};
+
+    ITensor::SharedPtr mX;
+    ITensor::SharedPtr mDt;
+    ITensor::SharedPtr mZ;
+    ITensor::SharedPtr mBC;
+    ITensor::SharedPtr mA;
+    ITensor::SharedPtr mD;
+    ITensor::SharedPtr mDtBias;
+    ITensor::SharedPtr mInitialState;
+    ITensor::SharedPtr mLastTokenIds;
+    ITensor::SharedPtr mSlotMapping;
+};
+
+} // namespace
+
+TEST_F(SelectiveScanTest, ChunkedMatchesSinglePass)
+{
+    for (bool loadInitialState : {false, true})
+    {
+        SCOPED_TRACE(loadInitialState);
+        auto const expected = referenceScan(loadInitialState);
+        auto const singlePass = runScan(1, loadInitialState);
+        expectNear(singlePass.output, expected.output, 1e-3f);
+        expectNear(singlePass.state, expected.state, 1e-3f);
+        for (int numChunks : {2, 4, 8})
+        {
+            SCOPED_TRACE(numChunks);
+            auto const chunked = runScan(numChunks, loadInitialState);
+            expectNear(chunked.output, singlePass.output, 1e-3f);
+            expectNear(chunked.state, singlePass.state, 1e-3f);
+        }
+    }
+}
+
+TEST_F(SelectiveScanTest, GenerationStepMatchesReference)
+{
+    // Vectorized over 4 channels, vectorized with a partial block, and one channel per thread
+    for (SizeType32 dim : {256, 132, 130})
+    {
+        SCOPED_TRACE(dim);
+        checkGenerationStep<float>(dim, 1e-4f);
+        checkGenerationStep<half>(dim, 1e-2f);
+    }
+}
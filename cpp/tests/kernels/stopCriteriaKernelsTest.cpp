@@ -369,6 +369,14 @@ public:
                 }
             }
         }
+
+        // Requests finished at this step, all requests start unfinished
+        auto finishedSlots = BufferRange<SizeType32>(*mFinishedSlots);
+        for (SizeType32 si = 0; si < 2 * batchSize; ++si)
+        {
+            auto const isSet = (static_cast<std::uint32_t>(finishedSlots[si / 32]) >> (si % 32)) & 1u;
+            EXPECT_EQ(isSet == 1u, finishedPtr[si].isFinishedEOS()) << "slot " << si;
+        }
     }
 
     void runStopWordsCriteriaTest(std::vector<std::vector<std::vector<SizeType32>>> const& stopWords,
@@ -399,7 +407,7 @@ public:
             reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinished)),
             bufferCast<SizeType32>(*mSequenceLengths), bufferCast<SizeType32>(*mBatchSlots),
             bufferCast<SizeType32>(*mStopWordsLen), numNewTokens, maxStopWordsLen, batchSize, beamWidth, mMaxSeqLen,
-            mStream->get());
+            nullptr, mStream->get());
 
         verifyStopWordsStopCriteriaResults(0, stopWords, maxStopWordsLen, batchSize, beamWidth, tokensPerStep.size());
     }
@@ -421,12 +429,16 @@ public:
     void runExplicitEOSCriteriaTest(SizeType32 seed, SizeType32 batchSize)
     {
         initData(seed, {}, 0, batchSize, /* beamWidth */ 1);
+        mFinishedSlots = BufferManager::pinned(
+            ITensor::makeShape({static_cast<SizeType32>(tc::divUp(2 * batchSize, 32))}), nvinfer1::DataType::kINT32);
+        std::fill_n(bufferCast<SizeType32>(*mFinishedSlots), mFinishedSlots->getSize(), 0);
 
         tk::invokeExplicitEOSCriterion(reinterpret_cast<TokenIdType const**>(bufferCast<int64_t>(*mOutputIdsPtr)),
             bufferCast<TokenIdType>(*mEndIds),
             reinterpret_cast<tk::FinishedState*>(bufferCast<tk::FinishedState::UnderlyingType>(*mFinished)),
             bufferCast<SizeType32>(*mSequenceLengths), bufferCast<SizeType32>(*mTokensPerStep),
-            bufferCast<SizeType32>(*mBatchSlots), batchSize, /* beamWidth */ 1, mMaxTokensPerStep, mStream->get());
+            bufferCast<SizeType32>(*mFinishedSlots), bufferCast<SizeType32>(*mBatchSlots), batchSize,
+            /* beamWidth */ 1, mMaxTokensPerStep, mStream->get());
 
         verifyExplicitEOSCriteriaResults(seed, batchSize);
     }
@@ -440,6 +452,7 @@ protected:
     TensorPtr mSequenceLengthLimits;
     TensorPtr mFinished;
     TensorPtr mFinishedSum;
+    TensorPtr mFinishedSlots;
 
     TensorPtr mOutputIds;
     TensorPtr mRefOutputIds;
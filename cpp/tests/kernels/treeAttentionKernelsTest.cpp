@@ -0,0 +1,205 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/speculativeDecoding/treeAttentionKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <cmath>
+#include <random>
+
+namespace tk = tensorrt_llm::kernels;
+namespace tksd = tensorrt_llm::kernels::speculative_decoding;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+struct TreeAttentionTestCase
+{
+    std::vector<SizeType32> pastKvLengths;
+    std::vector<SizeType32> treeSizes;
+    SizeType32 numQHeads;
+    SizeType32 numKvHeads;
+    SizeType32 headSize;
+};
+
+class TreeAttentionKernelsTest : public testing::TestWithParam<TreeAttentionTestCase>
+{
+public:
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+};
+
+TEST_P(TreeAttentionKernelsTest, MatchesReference)
+{
+    auto const& tc = GetParam();
+    SizeType32 const batchSize = tc.treeSizes.size();
+    auto const maxQSeqLen = *std::max_element(tc.treeSizes.begin(), tc.treeSizes.end());
+    auto const numPackedMasks = (maxQSeqLen + 31) / 32;
+    SizeType32 maxSeqLen = 0;
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        maxSeqLen = std::max(maxSeqLen, tc.pastKvLengths[bi] + tc.treeSizes[bi]);
+    }
+    auto const headGrpSize = tc.numQHeads / tc.numKvHeads;
+
+    std::vector<SizeType32> cuQSeqLens(batchSize + 1, 0);
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        cuQSeqLens[bi + 1] = cuQSeqLens[bi] + tc.treeSizes[bi];
+    }
+    auto const numTokens = cuQSeqLens[batchSize];
+
+    auto q = BufferManager::pinned(
+        ITensor::makeShape({numTokens, tc.numQHeads, tc.headSize}), nvinfer1::DataType::kFLOAT);
+    auto output = BufferManager::pinned(
+        ITensor::makeShape({numTokens, tc.numQHeads, tc.headSize}), nvinfer1::DataType::kFLOAT);
+    // [batchSize, 2, numKvHeads, maxSeqLen, headSize]
+    auto kvCache = BufferManager::pinned(
+        ITensor::makeShape({batchSize, 2, tc.numKvHeads, maxSeqLen, tc.headSize}), nvinfer1::DataType::kFLOAT);
+    auto cuQSeqLensBuf = BufferManager::pinned(ITensor::makeShape({batchSize + 1}), nvinfer1::DataType::kINT32);
+    auto pastKvLengths = BufferManager::pinned(ITensor::makeShape({batchSize}), nvinfer1::DataType::kINT32);
+    auto packedMask = BufferManager::pinned(
+        ITensor::makeShape({batchSize, maxQSeqLen, numPackedMasks}), nvinfer1::DataType::kINT32);
+
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    auto* qPtr = bufferCast<float>(*q);
+    auto* kvPtr = bufferCast<float>(*kvCache);
+    std::generate_n(qPtr, q->getSize(), [&]() { return dist(gen); });
+    std::generate_n(kvPtr, kvCache->getSize(), [&]() { return dist(gen); });
+    std::copy(cuQSeqLens.begin(), cuQSeqLens.end(), bufferCast<SizeType32>(*cuQSeqLensBuf));
+    std::copy(tc.pastKvLengths.begin(), tc.pastKvLengths.end(), bufferCast<SizeType32>(*pastKvLengths));
+
+    // Random trees, token i attends to itself and its ancestors, the parent of i precedes i.
+    auto* maskPtr = bufferCast<SizeType32>(*packedMask);
+    std::fill_n(maskPtr, packedMask->getSize(), 0);
+    std::vector<std::vector<std::vector<bool>>> visible(batchSize);
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const treeSize = tc.treeSizes[bi];
+        visible[bi].assign(treeSize, std::vector<bool>(treeSize, false));
+        for (SizeType32 ti = 0; ti < treeSize; ++ti)
+        {
+            visible[bi][ti][ti] = true;
+            if (ti > 0)
+            {
+                auto const parent = std::uniform_int_distribution<SizeType32>(0, ti - 1)(gen);
+                for (SizeType32 ki = 0; ki < treeSize; ++ki)
+                {
+                    visible[bi][ti][ki] = visible[bi][ti][ki] || visible[bi][parent][ki];
+                }
+            }
+            for (SizeType32 ki = 0; ki < treeSize; ++ki)
+            {
+                if (visible[bi][ti][ki])
+                {
+                    maskPtr[(bi * maxQSeqLen + ti) * numPackedMasks + ki / 32] |= 1 << (ki % 32);
+                }
+            }
+        }
+    }
+
+    tksd::TreeAttentionParams<float, tk::KVLinearBuffer> params;
+    params.q = qPtr;
+    params.output = bufferCast<float>(*output);
+    params.kvCache = tk::KVLinearBuffer(batchSize, maxSeqLen,
+        static_cast<int32_t>(tc.numKvHeads * tc.headSize * sizeof(float)), maxSeqLen, 0, false,
+        reinterpret_cast<tk::KVLinearBuffer::DataType*>(kvPtr));
+    params.cuQSeqLens = bufferCast<SizeType32>(*cuQSeqLensBuf);
+    params.pastKvLengths = bufferCast<SizeType32>(*pastKvLengths);
+    params.packedMask = maskPtr;
+    params.batchSize = batchSize;
+    params.maxQSeqLen = maxQSeqLen;
+    params.numQHeads = tc.numQHeads;
+    params.numKvHeads = tc.numKvHeads;
+    params.headSize = tc.headSize;
+    params.qkScale = 1.f / std::sqrt(static_cast<float>(tc.headSize));
+
+    tksd::invokeTreeAttention(params, mStream->get());
+    mStream->synchronize();
+
+    auto const kvOffset = [&](SizeType32 bi, SizeType32 kv, SizeType32 head, SizeType32 token)
+    { return (((bi * 2 + kv) * tc.numKvHeads + head) * maxSeqLen + token) * tc.headSize; };
+
+    auto const* outPtr = bufferCast<float>(*output);
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const pastKvLength = tc.pastKvLengths[bi];
+        auto const kvLength = pastKvLength + tc.treeSizes[bi];
+        for (SizeType32 ti = 0; ti < tc.treeSizes[bi]; ++ti)
+        {
+            for (SizeType32 hi = 0; hi < tc.numQHeads; ++hi)
+            {
+                auto const kvHead = hi / headGrpSize;
+                auto const* qRow = qPtr + ((cuQSeqLens[bi] + ti) * tc.numQHeads + hi) * tc.headSize;
+                std::vector<float> scores(kvLength, -INFINITY);
+                float maxScore = -INFINITY;
+                for (SizeType32 ki = 0; ki < kvLength; ++ki)
+                {
+                    if (ki >= pastKvLength && !visible[bi][ti][ki - pastKvLength])
+                    {
+                        continue;
+                    }
+                    auto const* kRow = kvPtr + kvOffset(bi, 0, kvHead, ki);
+                    float dot = 0.f;
+                    for (SizeType32 di = 0; di < tc.headSize; ++di)
+                    {
+                        dot += qRow[di] * kRow[di];
+                    }
+                    scores[ki] = dot * params.qkScale;
+                    maxScore = std::max(maxScore, scores[ki]);
+                }
+                float sum = 0.f;
+                std::vector<float> ref(tc.headSize, 0.f);
+                for (SizeType32 ki = 0; ki < kvLength; ++ki)
+                {
+                    auto const prob = std::exp(scores[ki] - maxScore);
+                    sum += prob;
+                    auto const* vRow = kvPtr + kvOffset(bi, 1, kvHead, ki);
+                    for (SizeType32 di = 0; di < tc.headSize; ++di)
+                    {
+                        ref[di] += prob * vRow[di];
+                    }
+                }
+                auto const* outRow = outPtr + ((cuQSeqLens[bi] + ti) * tc.numQHeads + hi) * tc.headSize;
+                for (SizeType32 di = 0; di < tc.headSize; ++di)
+                {
+                    ASSERT_NEAR(outRow[di], ref[di] / sum, 1e-4f)
+                        << "bi " << bi << " ti " << ti << " hi " << hi << " di " << di;
+                }
+            }
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(TreeAttention, TreeAttentionKernelsTest,
+    testing::Values(TreeAttentionTestCase{{5}, {4}, 4, 4, 64},
+        // Wide trees spanning several row tiles and packed mask words
+        TreeAttentionTestCase{{100, 37}, {64, 40}, 8, 2, 128},
+        // Head size not a multiple of the warp size, empty history
+        TreeAttentionTestCase{{0, 300, 65}, {17, 3, 70}, 4, 1, 80},
+        TreeAttentionTestCase{{31}, {96}, 2, 2, 256}));
+
+} // namespace
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/vocabShortlistKernels.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace tk = tensorrt_llm::kernels;
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+class VocabShortlistKernelsTest : public testing::Test
+{
+public:
+    using TensorPtr = ITensor::SharedPtr;
+
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        // Slot 0 has a full shortlist, slot 2 a partial one, slot 1 is not used
+        std::vector<TokenIdType> const shortlists{3, 7, 8, 20, 31, 40, 0, 0, 0, 0, 0, 0, 1, 2, 30, 2, 2, 2};
+        std::vector<SizeType32> const sizes{6, 0, 3};
+        mShortlists = toBuffer(shortlists);
+        mShortlistSizes = toBuffer(sizes);
+        mBatchSlots = toBuffer(std::vector<SizeType32>{2, 0});
+    }
+
+    template <typename T>
+    static TensorPtr toBuffer(std::vector<T> const& values)
+    {
+        auto buffer = BufferManager::pinned(
+            ITensor::makeShape({static_cast<SizeType32>(values.size())}), TRTDataType<T>::value);
+        std::copy(values.begin(), values.end(), bufferCast<T>(*buffer));
+        return buffer;
+    }
+
+protected:
+    std::shared_ptr<CudaStream> mStream;
+    TensorPtr mShortlists;
+    TensorPtr mShortlistSizes;
+    TensorPtr mBatchSlots;
+
+    SizeType32 const mBatchSize{2};
+    SizeType32 const mMaxBatchSize{3};
+    SizeType32 const mMaxShortlistSize{6};
+    SizeType32 const mVocabSize{48};
+    SizeType32 const mHiddenSize{80};
+};
+
+TEST_F(VocabShortlistKernelsTest, ComputesLogitsOfShortlistedTokens)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(-1.f, 1.f);
+    auto hidden = BufferManager::pinned(ITensor::makeShape({mBatchSize, mHiddenSize}), nvinfer1::DataType::kFLOAT);
+    auto weights = BufferManager::pinned(ITensor::makeShape({mVocabSize, mHiddenSize}), nvinfer1::DataType::kFLOAT);
+    std::generate_n(bufferCast<float>(*hidden), hidden->getSize(), [&]() { return dist(gen); });
+    std::generate_n(bufferCast<float>(*weights), weights->getSize(), [&]() { return dist(gen); });
+    auto logits
+        = BufferManager::pinned(ITensor::makeShape({mBatchSize, mMaxShortlistSize}), nvinfer1::DataType::kFLOAT);
+
+    tk::ShortlistLogitsParams<float> params;
+    params.hiddenStates = bufferCast<float>(*hidden);
+    params.lmHeadWeights = bufferCast<float>(*weights);
+    params.shortlists = bufferCast<TokenIdType>(*mShortlists);
+    params.shortlistSizes = bufferCast<SizeType32>(*mShortlistSizes);
+    params.batchSlots = bufferCast<SizeType32>(*mBatchSlots);
+    params.logits = bufferCast<float>(*logits);
+    params.batchSize = mBatchSize;
+    params.maxBatchSize = mMaxBatchSize;
+    params.hiddenSize = mHiddenSize;
+    params.maxShortlistSize = mMaxShortlistSize;
+    tk::invokeShortlistLogits(params, mStream->get());
+    mStream->synchronize();
+
+    auto const* hiddenPtr = bufferCast<float>(*hidden);
+    auto const* weightsPtr = bufferCast<float>(*weights);
+    auto const* shortlists = bufferCast<TokenIdType>(*mShortlists);
+    auto const* sizes = bufferCast<SizeType32>(*mShortlistSizes);
+    auto const* slots = bufferCast<SizeType32>(*mBatchSlots);
+    auto const* logitsPtr = bufferCast<float>(*logits);
+    for (SizeType32 bi = 0; bi < mBatchSize; ++bi)
+    {
+        auto const slot = slots[bi];
+        for (SizeType32 ci = 0; ci < mMaxShortlistSize; ++ci)
+        {
+            auto const value = logitsPtr[bi * mMaxShortlistSize + ci];
+            if (ci >= sizes[slot])
+            {
+                EXPECT_TRUE(std::isinf(value) && value < 0.f) << "batch " << bi << " candidate " << ci;
+                continue;
+            }
+            auto const tokenId = shortlists[slot * mMaxShortlistSize + ci];
+            float ref{0.f};
+            for (SizeType32 hi = 0; hi < mHiddenSize; ++hi)
+            {
+                ref += hiddenPtr[bi * mHiddenSize + hi] * weightsPtr[tokenId * mHiddenSize + hi];
+            }
+            EXPECT_NEAR(value, ref, 1e-4f) << "batch " << bi << " candidate " << ci;
+        }
+    }
+}
+
+TEST_F(VocabShortlistKernelsTest, MapsSampledPositionsToTokenIds)
+{
+    SizeType32 constexpr maxSeqLen{4};
+    // The sampled positions, 4 for slot 0 and 1 for slot 2, at their sequence lengths
+    auto outputIds = toBuffer(std::vector<TokenIdType>{9, 9, 4, 0, 0, 0, 0, 0, 9, 1, 0, 0});
+    auto sequenceLengths = toBuffer(std::vector<SizeType32>{2, 0, 1});
+    auto* outputIdsPtr = bufferCast<TokenIdType>(*outputIds);
+    auto outputIdsPtrs
+        = BufferManager::pinned(ITensor::makeShape({mMaxBatchSize}), TRTDataType<TokenIdType*>::value);
+    auto* ptrs = reinterpret_cast<TokenIdType**>(bufferCast<int64_t>(*outputIdsPtrs));
+    for (SizeType32 si = 0; si < mMaxBatchSize; ++si)
+    {
+        ptrs[si] = outputIdsPtr + si * maxSeqLen;
+    }
+
+    tk::MapShortlistTokensParams params;
+    params.outputIdsPtrs = ptrs;
+    params.sequenceLengths = bufferCast<SizeType32>(*sequenceLengths);
+    params.shortlists = bufferCast<TokenIdType>(*mShortlists);
+    params.batchSlots = bufferCast<SizeType32>(*mBatchSlots);
+    params.batchSize = mBatchSize;
+    params.maxShortlistSize = mMaxShortlistSize;
+    tk::invokeMapShortlistTokens(params, mStream->get());
+    mStream->synchronize();
+
+    std::vector<TokenIdType> const expected{9, 9, 31, 0, 0, 0, 0, 0, 9, 2, 0, 0};
+    for (std::size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(outputIdsPtr[i], expected[i]) << "index " << i;
+    }
+}
+
+} // namespace
@@ -5,11 +5,13 @@
 #include "cutlass/numeric_types.h"
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/quantization.h"
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
 #include "tensorrt_llm/kernels/cutlass_kernels/fpA_intB_gemm/fpA_intB_gemm.h"
 #include "tensorrt_llm/kernels/preQuantScaleKernel.h"
 #include "tensorrt_llm/kernels/weightOnlyBatchedGemv/kernelLauncher.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
@@ -24,6 +26,7 @@
 #include <vector>
 
 namespace wo = tensorrt_llm::kernels::weight_only;
+namespace tkc = tensorrt_llm::kernels::cutlass_kernels;
 
 void simple_assert(bool flag)
 {
@@ -372,6 +375,170 @@ bool benchmark_and_verify(int m, int n, int k, int groupsize, int warmup, int it
     return pass;
 }
 
+// The CUDA kernel with K split across CTAs must match the same kernel run without a workspace, which never splits
+template <wo::KernelType KT>
+bool verify_split_k(int m, int n, int k, int groupsize)
+{
+    std::srand(20240123);
+    using AType = typename cutlassTypeMapper<KT>::AType;
+    static constexpr int ASizeInBits = sizeof(AType) * 8;
+    static constexpr int WSizeInBits = cutlassTypeMapper<KT>::WSizeInBits;
+    int gs_factor = groupsize == 0 ? 1 : groupsize;
+    printf("Split-K %s\n", cutlassTypeMapper<KT>::str(m, n, k, groupsize).c_str());
+
+    CudaBuffer d_act(m * k * ASizeInBits / 8);
+    CudaBuffer d_weight(k * n * WSizeInBits / 8);
+    CudaBuffer d_scales(n * k / gs_factor * ASizeInBits / 8);
+    CudaBuffer d_zeros(n * k / gs_factor * ASizeInBits / 8);
+    CudaBuffer d_bias(n * ASizeInBits / 8);
+    CudaBuffer d_out(m * n * ASizeInBits / 8);
+    CudaBuffer d_workspace(wo::get_split_k_workspace_size(m, n));
+    std::vector<AType> h_act(m * k), h_scales(n * k / gs_factor), h_zeros(n * k / gs_factor), h_bias(n);
+    std::vector<uint8_t> h_weight(k * n * WSizeInBits / 8);
+    std::vector<AType> h_out1(m * n), h_out2(m * n);
+
+    random_fill(h_act, -1.f, 1.f);
+    random_fill(h_scales, -1.f, 1.f);
+    random_fill(h_zeros, -1.f, 1.f);
+    random_fill(h_bias, -1.f, 1.f);
+    for (uint8_t& v : h_weight)
+    {
+        v = rand() % 256;
+    }
+    d_act.copy_from(h_act.data());
+    d_weight.copy_from(h_weight.data());
+    d_scales.copy_from(h_scales.data());
+    d_zeros.copy_from(h_zeros.data());
+    d_bias.copy_from(h_bias.data());
+
+    void* p_zeros = groupsize != 0 ? d_zeros.data() : nullptr;
+    void* p_bias = groupsize != 0 ? d_bias.data() : nullptr;
+    // alpha is applied when the splits are reduced
+    wo::Params params(d_act.data(), nullptr, d_weight.data(), d_scales.data(), p_zeros, p_bias, d_out.data(), 0.5f, m,
+        n, k, groupsize, KT);
+    run_cuda_kernel(params, 0, 1);
+    d_out.copy_to(h_out1.data());
+
+    // NaN partials unless the kernel wrote them, i.e. did split K
+    cudaMemset(d_workspace.data(), 0xff, d_workspace._size);
+    params.workspace = d_workspace.data();
+    run_cuda_kernel(params, 0, 1);
+    d_out.copy_to(h_out2.data());
+    float first_partial;
+    cudaMemcpy(&first_partial, d_workspace.data(), sizeof(float), cudaMemcpyDeviceToHost);
+    if (std::isnan(first_partial))
+    {
+        printf("K was not split\n");
+        return false;
+    }
+    return compare<AType>(h_out2.data(), h_out1.data(), m * n, 1.f / (1 << (WSizeInBits - 1)));
+}
+
+// The fp8 activation kernel must match the fp16 kernel fed with the same activations upcast to fp16
+bool verify_fp8_act(int m, int n, int k, int groupsize)
+{
+    std::srand(20240123);
+    printf("Kernel FP8Int4Groupwise mnk(%d, %d, %d), gs %d\n", m, n, k, groupsize);
+
+    CudaBuffer d_act_fp8(m * k * sizeof(__nv_fp8_e4m3));
+    CudaBuffer d_act(m * k * sizeof(half));
+    CudaBuffer d_weight(k * n / 2);
+    CudaBuffer d_scales(n * k / groupsize * sizeof(half));
+    CudaBuffer d_zeros(n * k / groupsize * sizeof(half));
+    CudaBuffer d_bias(n * sizeof(half));
+    CudaBuffer d_out(m * n * sizeof(half));
+    std::vector<__nv_fp8_e4m3> h_act_fp8(m * k);
+    std::vector<half> h_act(m * k);
+    std::vector<uint8_t> h_weight(k * n / 2);
+    std::vector<half> h_scales(n * k / groupsize), h_zeros(n * k / groupsize), h_bias(n);
+    std::vector<half> h_out1(m * n), h_out2(m * n);
+
+    random_fill(h_act_fp8, -4.f, 4.f);
+    random_fill(h_scales, -1.f, 1.f);
+    random_fill(h_zeros, -1.f, 1.f);
+    random_fill(h_bias, -1.f, 1.f);
+    for (uint8_t& v : h_weight)
+    {
+        v = rand() % 256;
+    }
+    for (int i = 0; i < m * k; ++i)
+    {
+        h_act[i] = static_cast<half>(static_cast<float>(h_act_fp8[i]));
+    }
+
+    d_act_fp8.copy_from(h_act_fp8.data());
+    d_act.copy_from(h_act.data());
+    d_weight.copy_from(h_weight.data());
+    d_scales.copy_from(h_scales.data());
+    d_zeros.copy_from(h_zeros.data());
+    d_bias.copy_from(h_bias.data());
+
+    // Both kernels use the w4a8 weight layout, so apply_alpha_in_advance is set for the fp16 reference as well
+    wo::Params params(d_act_fp8.data(), nullptr, d_weight.data(), d_scales.data(), d_zeros.data(), d_bias.data(),
+        d_out.data(), 1.f, m, n, k, groupsize, wo::KernelType::FP8Int4Groupwise, true);
+    run_cuda_kernel(params, 0, 1);
+    d_out.copy_to(h_out1.data());
+    wo::Params ref_params(d_act.data(), nullptr, d_weight.data(), d_scales.data(), d_zeros.data(), d_bias.data(),
+        d_out.data(), 1.f, m, n, k, groupsize, wo::KernelType::FP16Int4Groupwise, true);
+    run_cuda_kernel(ref_params, 0, 1);
+    d_out.copy_to(h_out2.data());
+    return compare<half>(h_out1.data(), h_out2.data(), m * n, 1.f / 8);
+}
+
+// The fp4 kernels must match a host GEMM on the weights decoded from the packed E2M1 codes and block scales
+template <typename AType>
+bool verify_fp4(wo::KernelType type, tkc::Fp4Format format, int m, int n, int k)
+{
+    std::srand(20240123);
+    int const block_size = tkc::get_fp4_block_size(format);
+    printf("Kernel %s mnk(%d, %d, %d)\n", format == tkc::Fp4Format::NVFP4 ? "NVFP4" : "MXFP4", m, n, k);
+
+    CudaBuffer d_act(m * k * sizeof(AType));
+    CudaBuffer d_weight(k * n / 2);
+    CudaBuffer d_scales(k / block_size * n);
+    CudaBuffer d_out(m * n * sizeof(AType));
+    std::vector<AType> h_act(m * k);
+    std::vector<float> h_weight_fp(k * n);
+    std::vector<int8_t> h_weight(k * n / 2);
+    std::vector<uint8_t> h_scales(k / block_size * n);
+    std::vector<AType> h_out(m * n), h_ref(m * n);
+
+    random_fill(h_act, -1.f, 1.f);
+    random_fill(h_weight_fp, -0.05f, 0.05f);
+    float global_scale = 1.f;
+    tkc::block_scaled_fp4_quantize(h_weight.data(), h_scales.data(), &global_scale, h_weight_fp.data(),
+        {static_cast<size_t>(k), static_cast<size_t>(n)}, format);
+
+    d_act.copy_from(h_act.data());
+    d_weight.copy_from(h_weight.data());
+    d_scales.copy_from(h_scales.data());
+    wo::Params params(d_act.data(), nullptr, d_weight.data(), d_scales.data(), nullptr, nullptr, d_out.data(),
+        global_scale, m, n, k, block_size, type, true);
+    run_cuda_kernel(params, 0, 1);
+    d_out.copy_to(h_out.data());
+
+    static constexpr float kE2M1[8] = {0.f, 0.5f, 1.f, 1.5f, 2.f, 3.f, 4.f, 6.f};
+    for (int j = 0; j < n; ++j)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            float acc = 0.f;
+            for (int kk = 0; kk < k; ++kk)
+            {
+                uint8_t const code = (h_weight[(j * k + kk) / 2] >> (4 * (kk % 2))) & 0xf;
+                uint8_t const stored_scale = h_scales[kk / block_size * n + j];
+                float const scale = format == tkc::Fp4Format::NVFP4
+                    ? static_cast<float>(reinterpret_cast<__nv_fp8_e4m3 const&>(stored_scale))
+                    : std::ldexp(1.f, stored_scale - 127);
+                float const w = (code & 0x8 ? -1.f : 1.f) * kE2M1[code & 0x7] * scale * global_scale;
+                acc += static_cast<float>(h_act[i * k + kk]) * w;
+            }
+            h_ref[i * n + j] = static_cast<AType>(acc);
+        }
+    }
+    return compare<AType>(h_out.data(), h_ref.data(), m * n, 1.f / 8);
+}
+
 TEST(Kernel, WeightOnly)
 {
     int const arch = tensorrt_llm::common::getSMVersion();
@@ -414,3 +581,53 @@ TEST(Kernel, WeightOnly)
         }
     }
 }
+
+TEST(Kernel, WeightOnlySplitK)
+{
+    int const arch = tensorrt_llm::common::getSMVersion();
+    // Few CTAs along N and many iterations along K, so the heuristic splits K
+    for (auto m : {1, 2, 3, 4})
+    {
+        EXPECT_TRUE(verify_split_k<wo::KernelType::FP16Int8PerChannel>(m, 256, 8192, 0));
+        EXPECT_TRUE(verify_split_k<wo::KernelType::FP16Int4PerChannel>(m, 256, 8192, 0));
+        if (arch >= 75)
+        {
+            EXPECT_TRUE(verify_split_k<wo::KernelType::FP16Int4Groupwise>(m, 256, 8192, 64));
+            EXPECT_TRUE(verify_split_k<wo::KernelType::FP16Int4Groupwise>(m, 256, 8192, 128));
+        }
+    }
+}
+
+TEST(Kernel, WeightOnlyFp8Act)
+{
+    int const arch = tensorrt_llm::common::getSMVersion();
+    if (arch < 89)
+    {
+        GTEST_SKIP() << "W4A8 requires sm89 or newer";
+    }
+    for (auto m : {1, 2, 3, 4})
+    {
+        for (auto groupsize : {64, 128})
+        {
+            EXPECT_TRUE(verify_fp8_act(m, 4096, 4096, groupsize));
+        }
+    }
+}
+
+TEST(Kernel, WeightOnlyFp4)
+{
+    int const arch = tensorrt_llm::common::getSMVersion();
+    if (arch < 80)
+    {
+        GTEST_SKIP() << "fp4 weights require sm80 or newer";
+    }
+    for (auto m : {1, 2, 3, 4})
+    {
+        EXPECT_TRUE(verify_fp4<half>(wo::KernelType::FP16Nvfp4, tkc::Fp4Format::NVFP4, m, 4096, 4096));
+        EXPECT_TRUE(verify_fp4<half>(wo::KernelType::FP16Mxfp4, tkc::Fp4Format::MXFP4, m, 4096, 4096));
+#if defined(ENABLE_BF16)
+        EXPECT_TRUE(verify_fp4<__nv_bfloat16>(wo::KernelType::BF16Nvfp4, tkc::Fp4Format::NVFP4, m, 4096, 4096));
+        EXPECT_TRUE(verify_fp4<__nv_bfloat16>(wo::KernelType::BF16Mxfp4, tkc::Fp4Format::MXFP4, m, 4096, 4096));
+#endif
+    }
+}
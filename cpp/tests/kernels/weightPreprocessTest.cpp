@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/cutlass_kernels/cutlass_preprocessors.h"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace tkc = tensorrt_llm::kernels::cutlass_kernels;
+
+namespace
+{
+
+// The weight preprocessing for the mixed GEMM runs on host threads. Its output must not depend on the number of
+// threads, including when the threads get uneven chunks, and the on-disk cache must give back exactly what it stored
+// and recompute any file that doesn't match the weight.
+class WeightPreprocessTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mCacheDir = fs::temp_directory_path() / ("weightPreprocessTest_" + std::to_string(std::random_device{}()));
+        fs::remove_all(mCacheDir);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mCacheDir);
+    }
+
+    //! \brief Random quantized weight of `shape` for `quantType`, as packed bytes.
+    static std::vector<int8_t> makeWeight(std::vector<size_t> const& shape, tkc::QuantType quantType)
+    {
+        size_t numElts = 1;
+        for (auto const dim : shape)
+        {
+            numElts *= dim;
+        }
+        std::vector<int8_t> weight(numElts * tkc::get_weight_quant_bits(quantType) / 8);
+        std::mt19937 gen(1234);
+        std::uniform_int_distribution<int> dist(-128, 127);
+        for (auto& value : weight)
+        {
+            value = static_cast<int8_t>(dist(gen));
+        }
+        return weight;
+    }
+
+    static std::vector<int8_t> preprocess(std::vector<int8_t> const& weight, std::vector<size_t> const& shape,
+        tkc::QuantType quantType, int arch, int numThreads, std::optional<std::string> const& cacheDir = std::nullopt)
+    {
+        std::vector<int8_t> preprocessed(weight.size());
+        tkc::preprocess_weights_for_mixed_gemm(
+            preprocessed.data(), weight.data(), shape, quantType, arch, numThreads, cacheDir);
+        return preprocessed;
+    }
+
+    //! \brief The single file of the cache directory.
+    fs::path getCacheFile() const
+    {
+        std::vector<fs::path> files;
+        for (auto const& entry : fs::directory_iterator(mCacheDir))
+        {
+            files.push_back(entry.path());
+        }
+        EXPECT_EQ(files.size(), 1);
+        return files.empty() ? fs::path{} : files.front();
+    }
+
+    //! \brief Marks `path` as written long ago, so that a rewrite shows in its write time.
+    static fs::file_time_type age(fs::path const& path)
+    {
+        fs::last_write_time(path, fs::file_time_type::clock::now() - std::chrono::hours(24));
+        return fs::last_write_time(path);
+    }
+
+    static constexpr int kArchs[] = {70, 75, 80, 86, 89, 90};
+    static constexpr tkc::QuantType kQuantTypes[]
+        = {tkc::QuantType::W8_A16, tkc::QuantType::W4_A16, tkc::QuantType::W4_AFP8};
+
+    fs::path mCacheDir;
+};
+
+} // namespace
+
+TEST_F(WeightPreprocessTest, ParallelMatchesSerial)
+{
+    // 2-D and 3-D weights, with the row and expert counts not multiples of the thread counts
+    for (auto const& shape : {std::vector<size_t>{192, 128}, std::vector<size_t>{3, 64, 256}})
+    {
+        for (auto const quantType : kQuantTypes)
+        {
+            auto const weight = makeWeight(shape, quantType);
+            for (auto const arch : kArchs)
+            {
+                SCOPED_TRACE("shape dims " + std::to_string(shape.size()) + " quant type "
+                    + std::to_string(static_cast<int>(quantType)) + " arch " + std::to_string(arch));
+                auto const serial = preprocess(weight, shape, quantType, arch, 1);
+                for (auto const numThreads : {2, 5, 16})
+                {
+                    ASSERT_EQ(preprocess(weight, shape, quantType, arch, numThreads), serial)
+                        << numThreads << " threads";
+                }
+            }
+        }
+    }
+}
+
+TEST_F(WeightPreprocessTest, CacheRoundTrip)
+{
+    std::vector<size_t> const shape{128, 256};
+    for (auto const quantType : kQuantTypes)
+    {
+        SCOPED_TRACE(static_cast<int>(quantType));
+        fs::remove_all(mCacheDir);
+        auto const weight = makeWeight(shape, quantType);
+        auto const expected = preprocess(weight, shape, quantType, 80, 4);
+
+        // A miss stores the file, a hit reads it back without rewriting it
+        EXPECT_EQ(preprocess(weight, shape, quantType, 80, 4, mCacheDir.string()), expected);
+        auto const path = getCacheFile();
+        auto const writeTime = age(path);
+        EXPECT_EQ(preprocess(weight, shape, quantType, 80, 4, mCacheDir.string()), expected);
+        EXPECT_EQ(fs::last_write_time(path), writeTime);
+
+        // Another arch is another file
+        EXPECT_EQ(preprocess(weight, shape, quantType, 75, 4, mCacheDir.string()),
+            preprocess(weight, shape, quantType, 75, 1));
+        EXPECT_EQ(std::distance(fs::directory_iterator(mCacheDir), fs::directory_iterator{}), 2);
+    }
+}
+
+TEST_F(WeightPreprocessTest, CacheRecomputesMismatchingFiles)
+{
+    std::vector<size_t> const shape{128, 256};
+    auto const quantType = tkc::QuantType::W4_A16;
+    auto const weight = makeWeight(shape, quantType);
+    auto const expected = preprocess(weight, shape, quantType, 80, 4);
+    preprocess(weight, shape, quantType, 80, 4, mCacheDir.string());
+    auto const path = getCacheFile();
+    std::vector<char> stored(fs::file_size(path));
+    std::ifstream(path, std::ios::binary).read(stored.data(), static_cast<std::streamsize>(stored.size()));
+
+    auto const checkRecomputed = [&](std::vector<char> const& contents)
+    {
+        std::ofstream(path, std::ios::binary | std::ios::trunc)
+            .write(contents.data(), static_cast<std::streamsize>(contents.size()));
+        auto const writeTime = age(path);
+        EXPECT_EQ(preprocess(weight, shape, quantType, 80, 4, mCacheDir.string()), expected);
+        // The bad file is replaced with a good one
+        EXPECT_NE(fs::last_write_time(path), writeTime);
+        EXPECT_EQ(fs::file_size(path), stored.size());
+    };
+
+    {
+        SCOPED_TRACE("corrupt payload");
+        auto contents = stored;
+        contents.back() ^= 0x5A;
+        checkRecomputed(contents);
+    }
+    {
+        SCOPED_TRACE("truncated payload");
+        checkRecomputed(std::vector<char>(stored.begin(), stored.end() - 16));
+    }
+    {
+        SCOPED_TRACE("trailing bytes");
+        auto contents = stored;
+        contents.push_back(0);
+        checkRecomputed(contents);
+    }
+    {
+        SCOPED_TRACE("corrupt header");
+        auto contents = stored;
+        contents[sizeof(uint32_t)] ^= 0x1;
+        checkRecomputed(contents);
+    }
+    {
+        // The file of another arch under the name of this one, its payload is intact but not the layout of this arch
+        SCOPED_TRACE("file of another key");
+        preprocess(weight, shape, quantType, 75, 4, mCacheDir.string());
+        fs::path otherPath;
+        for (auto const& entry : fs::directory_iterator(mCacheDir))
+        {
+            if (entry.path() != path)
+            {
+                otherPath = entry.path();
+            }
+        }
+        ASSERT_FALSE(otherPath.empty());
+        std::vector<char> contents(fs::file_size(otherPath));
+        std::ifstream(otherPath, std::ios::binary).read(contents.data(), static_cast<std::streamsize>(contents.size()));
+        checkRecomputed(contents);
+    }
+}
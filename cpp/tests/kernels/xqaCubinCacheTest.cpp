@@ -0,0 +1,249 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT/cubinObjRegistry.h"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+namespace tk = tensorrt_llm::kernels;
+namespace jit = tensorrt_llm::kernels::jit;
+
+namespace
+{
+
+// The on-disk cache of the XQA JIT cubins: one file per SM and driver, entries keyed by the full XQA kernel key. A file
+// written by another driver or format, or a corrupted one, must be ignored as a whole so that the cubins are compiled
+// again and the file replaced, and never yield a cubin that differs from the one that was saved.
+class XqaCubinCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mCacheDir = fs::temp_directory_path() / ("xqaCubinCacheTest_" + std::to_string(std::random_device{}()));
+        fs::create_directories(mCacheDir);
+        mPath = mCacheDir / jit::CubinObjRegistry::getCacheFileName(kSM, kDriverVersion);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mCacheDir);
+    }
+
+    static jit::CubinObjKey makeKey(unsigned int sm, unsigned int beamWidth)
+    {
+        tk::XQAKernelLoadHashKey const loadKey{tk::DATA_TYPE_FP16, sm};
+        tk::XQAKernelRuntimeHashKey runtimeKey{};
+        runtimeKey.kv_data_type = tk::DATA_TYPE_FP16;
+        runtimeKey.head_size = 128;
+        runtimeKey.beam_size = beamWidth;
+        runtimeKey.num_q_heads_per_kv = 4;
+        runtimeKey.m_tilesize = 16;
+        runtimeKey.tokens_per_page = 64;
+        runtimeKey.paged_kv_cache = true;
+        runtimeKey.multi_query_tokens = false;
+        return {loadKey, runtimeKey};
+    }
+
+    static std::vector<uint8_t> serialize(jit::CubinObj const& cubin)
+    {
+        std::vector<uint8_t> bytes(cubin.getSerializationSize());
+        cubin.serialize(bytes.data(), bytes.size());
+        return bytes;
+    }
+
+    //! \brief Registry with a cubin per beam width 1 to 3, the content of each cubin names its beam width.
+    static void fill(jit::CubinObjRegistry& registry)
+    {
+        for (unsigned int beamWidth = 1; beamWidth <= 3; ++beamWidth)
+        {
+            registry.insertCubin(
+                makeKey(kSM, beamWidth), jit::CubinObj("cubin of beam width " + std::to_string(beamWidth)));
+        }
+    }
+
+    std::vector<char> readFile() const
+    {
+        std::ifstream file(mPath, std::ios::binary);
+        return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    }
+
+    void writeFile(std::vector<char> const& content) const
+    {
+        std::ofstream(mPath, std::ios::binary | std::ios::trunc)
+            .write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+
+    //! \brief Loads the file into an empty registry, expects it to be rejected without adding anything.
+    void expectRejected() const
+    {
+        jit::CubinObjRegistry loaded;
+        EXPECT_FALSE(loaded.loadFromFile(mPath, kDriverVersion));
+        for (unsigned int beamWidth = 1; beamWidth <= 3; ++beamWidth)
+        {
+            EXPECT_EQ(loaded.getCubin(makeKey(kSM, beamWidth)), nullptr);
+        }
+    }
+
+    static constexpr unsigned int kSM{90};
+    static constexpr int32_t kDriverVersion{12040};
+    // Offsets in the file header
+    static constexpr size_t kVersionOffset{4};
+    static constexpr size_t kKeySizeOffset{12};
+    static constexpr size_t kHeaderSize{24};
+
+    fs::path mCacheDir;
+    fs::path mPath;
+};
+
+} // namespace
+
+TEST_F(XqaCubinCacheTest, FileNameKeysSmAndDriver)
+{
+    EXPECT_EQ(jit::CubinObjRegistry::getCacheFileName(90, 12040), "xqa_jit_sm90_driver12040.cubins");
+    EXPECT_NE(jit::CubinObjRegistry::getCacheFileName(90, 12040), jit::CubinObjRegistry::getCacheFileName(80, 12040));
+    EXPECT_NE(jit::CubinObjRegistry::getCacheFileName(90, 12040), jit::CubinObjRegistry::getCacheFileName(90, 12050));
+}
+
+TEST_F(XqaCubinCacheTest, RoundTrip)
+{
+    EXPECT_FALSE(jit::CubinObjRegistry{}.loadFromFile(mPath, kDriverVersion));
+
+    jit::CubinObjRegistry saved;
+    fill(saved);
+    saved.saveToFile(mPath, kDriverVersion);
+    // The file is replaced through a temporary file, which doesn't stay behind
+    EXPECT_EQ(std::distance(fs::directory_iterator(mCacheDir), fs::directory_iterator{}), 1);
+
+    jit::CubinObjRegistry loaded;
+    ASSERT_TRUE(loaded.loadFromFile(mPath, kDriverVersion));
+    for (unsigned int beamWidth = 1; beamWidth <= 3; ++beamWidth)
+    {
+        auto const key = makeKey(kSM, beamWidth);
+        auto const* cubin = loaded.getCubin(key);
+        ASSERT_NE(cubin, nullptr) << "beam width " << beamWidth;
+        EXPECT_EQ(serialize(*cubin), serialize(*saved.getCubin(key))) << "beam width " << beamWidth;
+    }
+    // Every part of the key counts, the other beam widths and SMs are not in the cache
+    EXPECT_EQ(loaded.getCubin(makeKey(kSM, 4)), nullptr);
+    EXPECT_EQ(loaded.getCubin(makeKey(80, 1)), nullptr);
+}
+
+TEST_F(XqaCubinCacheTest, LoadKeepsExistingCubins)
+{
+    jit::CubinObjRegistry saved;
+    fill(saved);
+    saved.saveToFile(mPath, kDriverVersion);
+
+    jit::CubinObjRegistry registry;
+    jit::CubinObj const existing("compiled by this process");
+    registry.insertCubin(makeKey(kSM, 1), jit::CubinObj(existing));
+    ASSERT_TRUE(registry.loadFromFile(mPath, kDriverVersion));
+    EXPECT_EQ(serialize(*registry.getCubin(makeKey(kSM, 1))), serialize(existing));
+    EXPECT_NE(registry.getCubin(makeKey(kSM, 2)), nullptr);
+}
+
+TEST_F(XqaCubinCacheTest, OtherVersionsAreIgnored)
+{
+    jit::CubinObjRegistry saved;
+    fill(saved);
+    saved.saveToFile(mPath, kDriverVersion);
+    auto const content = readFile();
+    ASSERT_GT(content.size(), kHeaderSize);
+
+    {
+        SCOPED_TRACE("other driver");
+        jit::CubinObjRegistry loaded;
+        EXPECT_FALSE(loaded.loadFromFile(mPath, kDriverVersion + 10));
+        EXPECT_EQ(loaded.getCubin(makeKey(kSM, 1)), nullptr);
+    }
+    {
+        SCOPED_TRACE("other file format");
+        auto patched = content;
+        ++patched[kVersionOffset];
+        writeFile(patched);
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("other key layout");
+        auto patched = content;
+        ++patched[kKeySizeOffset];
+        writeFile(patched);
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("not a cubin cache");
+        writeFile(std::vector<char>(content.size(), 'x'));
+        expectRejected();
+    }
+}
+
+TEST_F(XqaCubinCacheTest, CorruptFileFallsBackToCompilation)
+{
+    jit::CubinObjRegistry saved;
+    fill(saved);
+    saved.saveToFile(mPath, kDriverVersion);
+    auto const content = readFile();
+    ASSERT_GT(content.size(), kHeaderSize + 16);
+
+    {
+        // Still deserializes, only the checksum tells
+        SCOPED_TRACE("flipped bit in a cubin");
+        auto corrupted = content;
+        corrupted[corrupted.size() - 8] ^= 0x4;
+        writeFile(corrupted);
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("truncated");
+        writeFile(std::vector<char>(content.begin(), content.end() - 16));
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("truncated header");
+        writeFile(std::vector<char>(content.begin(), content.begin() + kHeaderSize / 2));
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("trailing bytes");
+        auto corrupted = content;
+        corrupted.insert(corrupted.end(), 4, 0);
+        writeFile(corrupted);
+        expectRejected();
+    }
+    {
+        SCOPED_TRACE("empty");
+        writeFile({});
+        expectRejected();
+    }
+
+    // The compiled cubins replace the corrupted file
+    jit::CubinObjRegistry compiled;
+    fill(compiled);
+    compiled.saveToFile(mPath, kDriverVersion);
+    jit::CubinObjRegistry loaded;
+    ASSERT_TRUE(loaded.loadFromFile(mPath, kDriverVersion));
+    EXPECT_NE(loaded.getCubin(makeKey(kSM, 3)), nullptr);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/kernels/decoderMaskedMultiheadAttention/decoderXQAImplJIT/kernelUtils.h"
+
+namespace tk = tensorrt_llm::kernels;
+
+namespace
+{
+
+tk::XQAParams makeGqaParams(int32_t headSize)
+{
+    tk::XQAParams params{};
+    params.data_type = tk::DATA_TYPE_FP16;
+    params.kv_cache_data_type = tk::DATA_TYPE_FP16;
+    params.beam_width = 1;
+    params.max_attention_window_size = 4096;
+    params.cyclic_attention_window_size = 4096;
+    params.num_q_heads = 32;
+    params.num_kv_heads = 8;
+    params.head_size = headSize;
+    params.unidirectional = 1;
+    params.q_scaling = 1.0f;
+    params.position_embedding_type = tk::PositionEmbeddingType::kROPE_GPT_NEOX;
+    params.mask_type = tk::AttentionMaskType::CAUSAL;
+    params.paged_kv_cache = true;
+    params.tokens_per_block = 64;
+    params.cross_attention = false;
+    params.multi_block_mode = false;
+    return params;
+}
+
+} // namespace
+
+// The precompiled cubins only cover head sizes 128 and 256, the JIT implementation takes the others.
+TEST(XqaSupportConfigTest, JitCoversHeadSizesWithoutCubins)
+{
+    for (auto const headSize : {64, 80, 96, 128, 160, 256})
+    {
+        auto const params = makeGqaParams(headSize);
+        EXPECT_TRUE(tk::jit::supportConfigHMMA(params, tk::kSM_80, true)) << "head size " << headSize;
+        EXPECT_TRUE(tk::jit::supportConfigHMMA(params, tk::kSM_90, true)) << "head size " << headSize;
+    }
+}
+
+TEST(XqaSupportConfigTest, JitRejectsUnsupportedHeadSizes)
+{
+    for (auto const headSize : {8, 72, 100, 272})
+    {
+        auto const params = makeGqaParams(headSize);
+        EXPECT_FALSE(tk::jit::supportConfigHMMA(params, tk::kSM_80, true)) << "head size " << headSize;
+    }
+}
+
+TEST(XqaSupportConfigTest, JitQgmmaCoversFp8KvCache)
+{
+    for (auto const headSize : {64, 80, 96, 160})
+    {
+        auto params = makeGqaParams(headSize);
+        params.kv_cache_data_type = tk::DATA_TYPE_E4M3;
+        EXPECT_TRUE(tk::jit::supportConfigQGMMA(params, tk::kSM_90, true)) << "head size " << headSize;
+        EXPECT_FALSE(tk::jit::supportConfigQGMMA(params, tk::kSM_80, true)) << "head size " << headSize;
+    }
+}
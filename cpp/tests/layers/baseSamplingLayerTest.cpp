@@ -65,8 +65,6 @@ void BaseSamplingLayerTest<T>::setup(uint64_t seed, TestSamplingParams const& pa
 
     mBatchSlots = mBufferManager->pinned(ITensor::makeShape({mBatchSize}), nvinfer1::DataType::kINT32);
 
-    mCurandStatesDevice
-        = mBufferManager->gpu(ITensor::makeShape({mMaxBatchSize, sizeof(curandState_t)}), nvinfer1::DataType::kINT8);
     auto const workspaceSize = mSamplingLayer->getWorkspaceSize();
     mSamplingWorkspaceDevice = mBufferManager->gpu(workspaceSize, nvinfer1::DataType::kINT8);
 
@@ -125,8 +123,6 @@ std::shared_ptr<SamplingInputs> BaseSamplingLayerTest<T>::createInputTensors(int
 
     decodeInputTensors->probsComputed = mComputeProbs;
 
-    decodeInputTensors->curandStates = reinterpret_cast<curandState_t*>(bufferCast<int8_t>(*mCurandStatesDevice));
-
     decodeInputTensors->samplingWorkspace = reinterpret_cast<void*>(bufferCast<int8_t>(*mSamplingWorkspaceDevice));
 
     return decodeInputTensors;
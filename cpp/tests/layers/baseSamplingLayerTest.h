@@ -128,7 +128,6 @@ protected:
     TensorPtr mCumLogProbsDevice;
     TensorPtr mOutputLogProbsDevice;
 
-    TensorPtr mCurandStatesDevice;
     TensorPtr mPenaltyWorkspaceDevice;
     BufferPtr mSamplingWorkspaceDevice;
 
@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 #include <gtest/gtest.h>
+#include <numeric>
 #include <tuple>
 
 #include "tensorrt_llm/common/logger.h"
@@ -170,6 +171,50 @@ TEST_P(LookaheadAlgorithmTest, predict)
     TLLM_LOG_DEBUG("Lookahead acceptance histogram: %s", D(hist).values<SizeType32>().c_str());
 }
 
+TEST(LookaheadAlgorithmWindowTest, fillsWindowFromLongPrompt)
+{
+    srand(42);
+    SizeType32 constexpr W = 4, N = 4, G = 4;
+    SizeType32 maxTokensPerStep;
+    std::tie(maxTokensPerStep, std::ignore, std::ignore, std::ignore)
+        = executor::LookaheadDecodingConfig(W, N, G).calculateSpeculativeResource();
+    auto shape = ITensor::makeShape({maxTokensPerStep});
+    auto shapeSingle = ITensor::makeShape({1});
+
+    auto prepare = [&](SizeType32 promptLen)
+    {
+        // Distinct prompt tokens and a last token that is not in the prompt, so that nothing is guessed from the pool
+        TensorPtr prompt = BufferManager::cpu(ITensor::makeShape({promptLen + 1}), nvinfer1::DataType::kINT32);
+        BufferRange<TokenIdType> promptRange(*prompt);
+        std::iota(promptRange.begin(), promptRange.end(), 0);
+        promptRange[promptLen] = 1000;
+        TensorPtr draftTokens = BufferManager::cpu(shape, nvinfer1::DataType::kINT32);
+        TensorPtr positionIds = BufferManager::cpu(shape, nvinfer1::DataType::kINT32);
+        TensorPtr samplingMask = BufferManager::cpu(shape, nvinfer1::DataType::kBOOL);
+        TensorPtr length = BufferManager::cpu(shapeSingle, nvinfer1::DataType::kINT32);
+        TensorPtr offset = BufferManager::cpu(shapeSingle, nvinfer1::DataType::kINT32);
+        bufferCast<SizeType32>(*offset)[0] = promptLen + 1;
+
+        LookaheadAlgorithm algo(W, N, G);
+        algo.setup(prompt, W, N, G);
+        algo.prepare(draftTokens, positionIds, samplingMask, length, offset, ITensor::slice(prompt, promptLen, 1));
+        return std::make_tuple(draftTokens, positionIds, bufferCast<SizeType32>(*length)[0]);
+    };
+
+    // A short prompt starts the prefilling phase, with one token per line of the window.
+    EXPECT_EQ(std::get<2>(prepare(W + N - 4)), N - 3 + W);
+
+    // A long prompt fills the window, every line continuing the span of the prompt it was taken from.
+    auto [tokens, positions, length] = prepare(32);
+    ASSERT_EQ(length, (N - 1) * W - 1);
+    BufferRange<TokenIdType> tokensRange(*tokens);
+    BufferRange<SizeType32> positionsRange(*positions);
+    for (SizeType32 i = 1; i < length; i++)
+    {
+        EXPECT_EQ(tokensRange[i] - positionsRange[i], tokensRange[0] - positionsRange[0]) << "draft token " << i;
+    }
+}
+
 INSTANTIATE_TEST_CASE_P(CombineLookaheadAlgorithmTest, LookaheadAlgorithmTest,
     testing::Combine( //
         testing::Values(std::make_tuple(1, 1), std::make_tuple(3, 3), std::make_tuple(5, 5), std::make_tuple(7, 7),
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/tokenAutomaton.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::layers;
+using tensorrt_llm::runtime::TokenIdType;
+
+namespace
+{
+bool matches(ByteDfa const& dfa, std::string const& text)
+{
+    auto state = ByteDfa::getInitialState();
+    for (auto const c : text)
+    {
+        state = dfa.next(state, static_cast<std::uint8_t>(c));
+        if (state == ByteDfa::kDeadState)
+        {
+            return false;
+        }
+    }
+    return dfa.isAccepting(state);
+}
+
+bool isAllowed(TokenAutomaton::Bitmask const& mask, TokenIdType tokenId)
+{
+    return (mask[tokenId / TokenAutomaton::kBitsPerWord] >> (tokenId % TokenAutomaton::kBitsPerWord)) & 1;
+}
+
+std::shared_ptr<TokenVocabulary const> makeVocabulary()
+{
+    // 0 is EOS, 1 is another special token
+    std::vector<std::string> tokens{
+        "", "", "{", "}", "\"", "a", "ab", "b", "1", "12", "true", "false", ":", " ", "{\""};
+    return std::make_shared<TokenVocabulary const>(std::move(tokens), std::vector<TokenIdType>{0});
+}
+} // namespace
+
+TEST(ByteDfa, Regex)
+{
+    auto const dfa = ByteDfa::compileRegex("(true|false)");
+    EXPECT_TRUE(matches(dfa, "true"));
+    EXPECT_TRUE(matches(dfa, "false"));
+    EXPECT_FALSE(matches(dfa, "tru"));
+    EXPECT_FALSE(matches(dfa, "truee"));
+
+    auto const number = ByteDfa::compileRegex("-?(0|[1-9]\\d*)(\\.\\d+)?");
+    EXPECT_TRUE(matches(number, "0"));
+    EXPECT_TRUE(matches(number, "-120.25"));
+    EXPECT_FALSE(matches(number, "012"));
+    EXPECT_FALSE(matches(number, "1."));
+
+    auto const repeat = ByteDfa::compileRegex("a{2,3}b{2,}[^x-z]?");
+    EXPECT_FALSE(matches(repeat, "abb"));
+    EXPECT_TRUE(matches(repeat, "aabb"));
+    EXPECT_TRUE(matches(repeat, "aaabbbbw"));
+    EXPECT_FALSE(matches(repeat, "aaaabb"));
+    EXPECT_FALSE(matches(repeat, "aabby"));
+
+    auto const escapes = ByteDfa::compileRegex("\\{\"\\w+\": \\S\\}.");
+    EXPECT_TRUE(matches(escapes, "{\"key_1\": x}!"));
+    EXPECT_FALSE(matches(escapes, "{\"key\":  }!"));
+    EXPECT_FALSE(matches(escapes, "{\"key\": x}\n"));
+}
+
+TEST(ByteDfa, InvalidRegexThrows)
+{
+    using tensorrt_llm::common::TllmException;
+    EXPECT_THROW(ByteDfa::compileRegex("(ab"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("ab)"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("*a"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("a{3,2}"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("[z-a]"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("\\q"), TllmException);
+    EXPECT_THROW(ByteDfa::compileRegex("[^\\s\\S]"), TllmException);
+    EXPECT_NO_THROW(ByteDfa::compileRegex(""));
+}
+
+TEST(TokenAutomaton, Mask)
+{
+    auto const vocabulary = makeVocabulary();
+    TokenAutomaton const automaton{ByteDfa::compileRegex("\\{\"a\": (true|false|1\\d*)\\}"), vocabulary};
+    EXPECT_EQ(automaton.getNumWords(), 1);
+
+    auto state = TokenAutomaton::getInitialState();
+    auto mask = automaton.getMask(state);
+    EXPECT_TRUE(isAllowed(*mask, 2));
+    EXPECT_TRUE(isAllowed(*mask, 14));
+    EXPECT_FALSE(isAllowed(*mask, 0));
+    EXPECT_FALSE(isAllowed(*mask, 1));
+    EXPECT_FALSE(isAllowed(*mask, 5));
+
+    for (TokenIdType const token : {14, 5, 4, 12, 13})
+    {
+        state = automaton.advance(state, token);
+        ASSERT_NE(state, ByteDfa::kDeadState);
+    }
+    mask = automaton.getMask(state);
+    EXPECT_TRUE(isAllowed(*mask, 8));
+    EXPECT_TRUE(isAllowed(*mask, 9));
+    EXPECT_TRUE(isAllowed(*mask, 10));
+    EXPECT_TRUE(isAllowed(*mask, 11));
+    EXPECT_FALSE(isAllowed(*mask, 3));
+    EXPECT_EQ(automaton.advance(state, 3), ByteDfa::kDeadState);
+    // Masks of a state are cached
+    EXPECT_EQ(automaton.getMask(state), mask);
+
+    state = automaton.advance(automaton.advance(state, 9), 3);
+    ASSERT_NE(state, ByteDfa::kDeadState);
+    EXPECT_TRUE(automaton.isAccepting(state));
+    mask = automaton.getMask(state);
+    EXPECT_EQ(mask->front(), 1u);
+    EXPECT_EQ(automaton.advance(state, 0), state);
+    EXPECT_EQ(automaton.advance(state, 1), ByteDfa::kDeadState);
+}
+
+TEST(TokenAutomaton, ConcurrentMasks)
+{
+    std::vector<std::string> tokens(1000);
+    for (std::size_t i = 1; i < tokens.size(); ++i)
+    {
+        tokens[i] = std::to_string(i);
+    }
+    auto const vocabulary = std::make_shared<TokenVocabulary const>(std::move(tokens), std::vector<TokenIdType>{0});
+    TokenAutomaton const automaton{ByteDfa::compileRegex("[1-9]\\d{0,3}"), vocabulary};
+    EXPECT_EQ(automaton.getNumWords(), 32);
+
+    std::vector<std::thread> threads;
+    std::vector<std::shared_ptr<TokenAutomaton::Bitmask const>> masks(4);
+    for (std::size_t i = 0; i < masks.size(); ++i)
+    {
+        threads.emplace_back([&automaton, &masks, i]() { masks[i] = automaton.getMask(0); });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    for (auto const& mask : masks)
+    {
+        EXPECT_EQ(*mask, *masks.front());
+    }
+    EXPECT_FALSE(isAllowed(*masks.front(), 0));
+    for (TokenIdType token = 1; token < 1000; ++token)
+    {
+        EXPECT_TRUE(isAllowed(*masks.front(), token));
+    }
+}
+
+TEST(TokenAutomatonCache, SharesAndEvicts)
+{
+    TokenAutomatonCache cache{makeVocabulary(), 2};
+    auto const first = cache.getRegex("a+");
+    EXPECT_EQ(cache.getRegex("a+"), first);
+    auto const second = cache.getRegex("b+");
+    EXPECT_EQ(cache.getRegex("a+"), first);
+    cache.getRegex("(ab)+");
+    EXPECT_EQ(cache.getNumEntries(), 2);
+    // "b+" was the least recently used
+    EXPECT_EQ(cache.getRegex("a+"), first);
+    EXPECT_NE(cache.getRegex("b+"), second);
+    EXPECT_THROW(cache.getRegex("("), tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/layers/wordsAutomaton.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+using namespace tensorrt_llm::layers;
+using tensorrt_llm::runtime::SizeType32;
+using tensorrt_llm::runtime::TokenIdType;
+
+namespace
+{
+using Words = std::vector<std::vector<TokenIdType>>;
+
+bool endsWith(std::vector<TokenIdType> const& sequence, SizeType32 end, std::vector<TokenIdType> const& word,
+    SizeType32 wordLen)
+{
+    return wordLen <= end && std::equal(word.begin(), word.begin() + wordLen, sequence.begin() + end - wordLen);
+}
+
+// Compares the automaton with the scan of all words at each prefix of the sequence
+void checkSequence(WordsAutomaton const& automaton, Words const& words, std::vector<TokenIdType> const& sequence)
+{
+    auto state = WordsAutomaton::getInitialState();
+    for (SizeType32 end = 0; end <= static_cast<SizeType32>(sequence.size()); ++end)
+    {
+        if (end > 0)
+        {
+            state = automaton.next(state, sequence[end - 1]);
+        }
+        bool expectedMatch{false};
+        std::vector<TokenIdType> expectedBanned;
+        for (auto const& word : words)
+        {
+            auto const wordLen = static_cast<SizeType32>(word.size());
+            expectedMatch |= endsWith(sequence, end, word, wordLen);
+            if (endsWith(sequence, end, word, wordLen - 1))
+            {
+                expectedBanned.push_back(word.back());
+            }
+        }
+        std::sort(expectedBanned.begin(), expectedBanned.end());
+        expectedBanned.erase(std::unique(expectedBanned.begin(), expectedBanned.end()), expectedBanned.end());
+        ASSERT_EQ(automaton.isMatch(state), expectedMatch) << "at " << end;
+        ASSERT_EQ(automaton.getBannedTokens(state), expectedBanned) << "at " << end;
+    }
+}
+} // namespace
+
+TEST(WordsAutomaton, Overlapping)
+{
+    Words const words{{1, 2, 3}, {2, 3}, {3, 4, 1, 2}, {5}, {2, 3}};
+    WordsAutomaton const automaton{words};
+    EXPECT_EQ(automaton.getHeight(), 4);
+    // Root and the prefixes 1, 12, 123, 2, 23, 3, 34, 341, 3412, 5
+    EXPECT_EQ(automaton.getNumStates(), 11);
+
+    checkSequence(automaton, words, {1, 2, 3, 4, 1, 2, 3, 5, 3, 4, 1, 1, 2});
+    checkSequence(automaton, words, {3, 4, 3, 4, 1, 2, 2, 3});
+
+    auto state = WordsAutomaton::getInitialState();
+    for (TokenIdType const token : {3, 4, 1})
+    {
+        state = automaton.next(state, token);
+    }
+    EXPECT_FALSE(automaton.isMatch(state));
+    EXPECT_EQ(automaton.getBannedTokens(state), (std::vector<TokenIdType>{2, 5}));
+    state = automaton.next(state, 2);
+    EXPECT_TRUE(automaton.isMatch(state));
+    EXPECT_EQ(automaton.getBannedTokens(state), (std::vector<TokenIdType>{3, 5}));
+}
+
+TEST(WordsAutomaton, Random)
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<TokenIdType> tokenDist(0, 5);
+    std::uniform_int_distribution<SizeType32> lenDist(1, 4);
+    for (SizeType32 trial = 0; trial < 20; ++trial)
+    {
+        Words words(50);
+        for (auto& word : words)
+        {
+            word.resize(lenDist(gen));
+            std::generate(word.begin(), word.end(), [&]() { return tokenDist(gen); });
+        }
+        WordsAutomaton const automaton{words};
+        std::vector<TokenIdType> sequence(200);
+        std::generate(sequence.begin(), sequence.end(), [&]() { return tokenDist(gen); });
+        checkSequence(automaton, words, sequence);
+    }
+}
+
+TEST(WordsAutomaton, FromWordsList)
+{
+    // Words {7, 8}, {9} and {8, 7, 7} in the format of the decoder inputs
+    std::vector<TokenIdType> const wordsList{7, 8, 9, 8, 7, 7, 2, 3, 6, -1, -1, -1};
+    auto const automaton = WordsAutomaton::fromWordsList(wordsList.data(), 6);
+    checkSequence(*automaton, Words{{7, 8}, {9}, {8, 7, 7}}, {8, 7, 7, 8, 9, 1, 7, 8});
+    EXPECT_EQ(automaton->getHeight(), 3);
+}
+
+TEST(WordsAutomaton, InvalidWordsThrow)
+{
+    using tensorrt_llm::common::TllmException;
+    EXPECT_THROW(WordsAutomaton(Words{{1, 2}, {}}), TllmException);
+    EXPECT_THROW(WordsAutomaton(Words{{1, -2}}), TllmException);
+
+    WordsAutomaton const empty{Words{}};
+    EXPECT_EQ(empty.getNumStates(), 1);
+    EXPECT_FALSE(empty.isMatch(empty.next(WordsAutomaton::getInitialState(), 3)));
+}
@@ -0,0 +1,174 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/plugins/ncclPlugin/allReduceTuningTable.h"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+using tensorrt_llm::plugins::AllReduceTuningTable;
+
+namespace
+{
+
+// The table of the AUTO allreduce tuning: the message size buckets, the key of its file, and a round trip through the
+// file, which must reject any table that doesn't have exactly the buckets and candidates of the plugin.
+class AllReduceTuningTableTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mCacheDir = fs::temp_directory_path() / ("allReduceTuningTableTest_" + std::to_string(std::random_device{}()));
+        fs::remove_all(mCacheDir);
+    }
+
+    void TearDown() override
+    {
+        fs::remove_all(mCacheDir);
+    }
+
+    void writeFile(fs::path const& path, std::string const& contents) const
+    {
+        fs::create_directories(path.parent_path());
+        std::ofstream(path, std::ios::trunc) << contents;
+    }
+
+    static constexpr std::size_t kNumCandidates{7};
+
+    fs::path mCacheDir;
+};
+
+} // namespace
+
+TEST_F(AllReduceTuningTableTest, MessageSizes)
+{
+    // Doubling from 1 KB, the last bucket ends at the largest message
+    EXPECT_EQ(AllReduceTuningTable::getMessageSizes(8192), (std::vector<std::size_t>{1024, 2048, 4096, 8192}));
+    EXPECT_EQ(AllReduceTuningTable::getMessageSizes(5000), (std::vector<std::size_t>{1024, 2048, 4096, 5000}));
+    EXPECT_EQ(AllReduceTuningTable::getMessageSizes(1024), (std::vector<std::size_t>{1024}));
+    EXPECT_EQ(AllReduceTuningTable::getMessageSizes(100), (std::vector<std::size_t>{100}));
+    EXPECT_EQ(AllReduceTuningTable::getMessageSizes(std::size_t{1} << 26).size(), 17);
+}
+
+TEST_F(AllReduceTuningTableTest, FindBucket)
+{
+    AllReduceTuningTable const table{AllReduceTuningTable::getMessageSizes(5000), {3, 1, 4, 0}};
+    EXPECT_EQ(table.find(1), 3);
+    EXPECT_EQ(table.find(1024), 3);
+    EXPECT_EQ(table.find(1025), 1);
+    EXPECT_EQ(table.find(2048), 1);
+    EXPECT_EQ(table.find(4000), 4);
+    EXPECT_EQ(table.find(4097), 0);
+    EXPECT_EQ(table.find(5000), 0);
+    // Larger than the largest message, the static thresholds decide
+    EXPECT_FALSE(table.find(5001).has_value());
+}
+
+TEST_F(AllReduceTuningTableTest, Fastest)
+{
+    // Two sizes of three candidates, ties go to the first candidate
+    std::vector<float> const times{3.f, 1.f, 2.f, 5.f, 5.f, 6.f};
+    EXPECT_EQ(AllReduceTuningTable::getFastest(times, 3), (std::vector<int32_t>{1, 0}));
+}
+
+TEST_F(AllReduceTuningTableTest, CachePath)
+{
+    auto const path = AllReduceTuningTable::getCachePath("/cache", "NVIDIA H100 80GB HBM3", 8, true, 1);
+    EXPECT_EQ(path, fs::path("/cache") / "allreduce_NVIDIA_H100_80GB_HBM3_tp8_nvlink_dtype1.txt");
+
+    // Each part of the key is its own file
+    std::vector<fs::path> const paths{path, AllReduceTuningTable::getCachePath("/cache", "NVIDIA A100", 8, true, 1),
+        AllReduceTuningTable::getCachePath("/cache", "NVIDIA H100 80GB HBM3", 4, true, 1),
+        AllReduceTuningTable::getCachePath("/cache", "NVIDIA H100 80GB HBM3", 8, false, 1),
+        AllReduceTuningTable::getCachePath("/cache", "NVIDIA H100 80GB HBM3", 8, true, 0)};
+    for (std::size_t i = 0; i < paths.size(); ++i)
+    {
+        for (std::size_t j = i + 1; j < paths.size(); ++j)
+        {
+            EXPECT_NE(paths[i], paths[j]);
+        }
+    }
+
+    // The GPU name can't leave the cache directory
+    EXPECT_EQ(AllReduceTuningTable::getCachePath("/cache", "../a/b", 2, false, 0).parent_path(), fs::path("/cache"));
+}
+
+TEST_F(AllReduceTuningTableTest, SaveLoadRoundTrip)
+{
+    auto const sizes = AllReduceTuningTable::getMessageSizes(std::size_t{1} << 20);
+    std::vector<int32_t> candidates(sizes.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+    {
+        candidates[i] = static_cast<int32_t>(i % kNumCandidates);
+    }
+    auto const path = AllReduceTuningTable::getCachePath(mCacheDir.string(), "GPU", 4, true, 0);
+    EXPECT_FALSE(AllReduceTuningTable::load(path, sizes, kNumCandidates).has_value());
+
+    // The directory is created and no temporary file is left behind
+    ASSERT_TRUE(AllReduceTuningTable(sizes, candidates).save(path));
+    EXPECT_EQ(std::distance(fs::directory_iterator(mCacheDir), fs::directory_iterator{}), 1);
+
+    auto const loaded = AllReduceTuningTable::load(path, sizes, kNumCandidates);
+    ASSERT_TRUE(loaded.has_value());
+    EXPECT_EQ(loaded->getSizes(), sizes);
+    EXPECT_EQ(loaded->getCandidates(), candidates);
+
+    // Saving again replaces the table
+    candidates.assign(sizes.size(), 2);
+    ASSERT_TRUE(AllReduceTuningTable(sizes, candidates).save(path));
+    EXPECT_EQ(AllReduceTuningTable::load(path, sizes, kNumCandidates)->getCandidates(), candidates);
+}
+
+TEST_F(AllReduceTuningTableTest, LoadRejectsMismatchingTables)
+{
+    std::vector<std::size_t> const sizes{1024, 2048, 3000};
+    auto const path = mCacheDir / "table.txt";
+
+    writeFile(path, "1024 1\n2048 6\n3000 0\n");
+    ASSERT_TRUE(AllReduceTuningTable::load(path, sizes, kNumCandidates).has_value());
+
+    for (auto const* contents : {
+             "1024 1\n2048 6\n",                 // fewer buckets, e.g. a smaller largest message
+             "1024 1\n2048 6\n3000 0\n4096 1\n", // more buckets
+             "1024 1\n2048 6\n4096 0\n",         // other bounds
+             "1024 1\n2048 7\n3000 0\n",         // unknown candidate
+             "1024 1\n2048 -1\n3000 0\n",        // negative candidate
+             "1024 1\n2048 6\n3000 0\nx\n",      // trailing garbage
+             "1024 1\n2048 six\n3000 0\n",       // not a number
+             "",                                 // empty
+         })
+    {
+        SCOPED_TRACE(contents);
+        writeFile(path, contents);
+        EXPECT_FALSE(AllReduceTuningTable::load(path, sizes, kNumCandidates).has_value());
+    }
+}
+
+TEST_F(AllReduceTuningTableTest, SaveFailure)
+{
+    // The parent of the file is a regular file, the table can't be written
+    writeFile(mCacheDir / "file", "");
+    AllReduceTuningTable const table{{1024}, {0}};
+    EXPECT_FALSE(table.save(mCacheDir / "file" / "table.txt"));
+}
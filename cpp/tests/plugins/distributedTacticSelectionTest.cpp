@@ -0,0 +1,185 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/plugins/common/distributedTacticSelection.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+using tensorrt_llm::plugins::DistributedTacticSelection;
+
+namespace
+{
+
+// The split of the GEMM tactic profiling between the ranks of a session, with all the ranks in one process: each rank
+// profiles the Ms dealt to it, the allgather copies the bytes of the slots of every rank in rank order, and every rank
+// must then know the tactic of each pending M, profiled by exactly one rank.
+class DistributedTacticSelectionTest : public ::testing::Test
+{
+protected:
+    struct Config
+    {
+        int tile;
+        int stages;
+    };
+
+    using Selection = DistributedTacticSelection<Config>::Selection;
+
+    //! \brief Tactic profiled for m, none for the Ms that no tactic runs.
+    static std::optional<Config> profile(int m)
+    {
+        if (m == kUnsupportedM)
+        {
+            return std::nullopt;
+        }
+        return Config{m / 16, m % 5};
+    }
+
+    //! \brief Runs the selection on `worldSize` ranks, returns the Ms profiled by each rank and checks that every rank
+    //! gathers the tactics of all the pending Ms.
+    static std::vector<std::vector<int>> run(std::vector<int> const& pendingMs, int worldSize)
+    {
+        std::vector<DistributedTacticSelection<Config>> ranks;
+        std::vector<std::vector<int>> profiledMs;
+        for (int rank = 0; rank < worldSize; ++rank)
+        {
+            auto& selection = ranks.emplace_back(pendingMs, worldSize, rank);
+            profiledMs.push_back(selection.getLocalMs());
+            for (auto const m : profiledMs.back())
+            {
+                selection.select(m, profile(m));
+            }
+            EXPECT_EQ(selection.getLocalSelections().size(), ranks.front().getSlotsPerRank());
+        }
+
+        // The allgather, each rank sends the bytes of its slots
+        auto const slotsPerRank = ranks.front().getSlotsPerRank();
+        std::vector<Selection> gathered(slotsPerRank * worldSize);
+        for (int rank = 0; rank < worldSize; ++rank)
+        {
+            std::memcpy(static_cast<void*>(gathered.data() + rank * slotsPerRank),
+                ranks[rank].getLocalSelections().data(), slotsPerRank * sizeof(Selection));
+        }
+
+        for (int rank = 0; rank < worldSize; ++rank)
+        {
+            SCOPED_TRACE("rank " + std::to_string(rank));
+            auto& received = ranks[rank].getGatheredSelections();
+            EXPECT_EQ(received.size(), gathered.size());
+            std::memcpy(static_cast<void*>(received.data()), gathered.data(), gathered.size() * sizeof(Selection));
+
+            expectTactics(ranks[rank], pendingMs);
+        }
+        return profiledMs;
+    }
+
+    //! \brief Expects the gathered selections to hold the tactic of each pending M exactly once.
+    static void expectTactics(DistributedTacticSelection<Config> const& selection, std::vector<int> const& pendingMs)
+    {
+        std::map<int, std::optional<Config>> tactics;
+        for (auto const& [m, config] : selection.getSelections())
+        {
+            EXPECT_TRUE(tactics.emplace(m, config).second) << "M " << m << " is selected twice";
+        }
+        EXPECT_EQ(tactics.size(), pendingMs.size());
+        for (auto const m : pendingMs)
+        {
+            SCOPED_TRACE("M " + std::to_string(m));
+            auto const it = tactics.find(m);
+            ASSERT_NE(it, tactics.end());
+            auto const expected = profile(m);
+            ASSERT_EQ(it->second.has_value(), expected.has_value());
+            if (expected)
+            {
+                EXPECT_EQ(it->second->tile, expected->tile);
+                EXPECT_EQ(it->second->stages, expected->stages);
+            }
+        }
+    }
+
+    static constexpr int kUnsupportedM{64};
+};
+
+} // namespace
+
+TEST_F(DistributedTacticSelectionTest, DealsRoundRobin)
+{
+    std::vector<int> const pendingMs{16, 32, 64, 128, 256, 512, 1024};
+    auto const profiledMs = run(pendingMs, 3);
+    EXPECT_EQ(profiledMs, (std::vector<std::vector<int>>{{16, 128, 1024}, {32, 256}, {64, 512}}));
+}
+
+TEST_F(DistributedTacticSelectionTest, EachMProfiledOnce)
+{
+    std::vector<int> pendingMs;
+    for (int m = 8; m <= 8192; m *= 2)
+    {
+        pendingMs.push_back(m);
+    }
+    for (int worldSize : {1, 2, 4, 8, 16})
+    {
+        SCOPED_TRACE("world size " + std::to_string(worldSize));
+        std::vector<int> profiled;
+        for (auto const& ms : run(pendingMs, worldSize))
+        {
+            // The shares differ by at most one M
+            EXPECT_LE(ms.size(), (pendingMs.size() + worldSize - 1) / worldSize);
+            EXPECT_GE(ms.size(), pendingMs.size() / worldSize);
+            profiled.insert(profiled.end(), ms.begin(), ms.end());
+        }
+        std::sort(profiled.begin(), profiled.end());
+        EXPECT_EQ(profiled, pendingMs);
+    }
+}
+
+TEST_F(DistributedTacticSelectionTest, FewerMsThanRanks)
+{
+    // The ranks without an M still take part in the allgather with an unused slot
+    auto const profiledMs = run({256, 512}, 4);
+    EXPECT_EQ(profiledMs, (std::vector<std::vector<int>>{{256}, {512}, {}, {}}));
+    EXPECT_EQ(DistributedTacticSelection<Config>({256, 512}, 4, 3).getSlotsPerRank(), 1);
+}
+
+TEST_F(DistributedTacticSelectionTest, NothingPending)
+{
+    // All the Ms were in the map or the tactic cache, the ranks skip the allgather
+    DistributedTacticSelection<Config> const selection{{}, 4, 1};
+    EXPECT_EQ(selection.getSlotsPerRank(), 0);
+    EXPECT_TRUE(selection.getLocalMs().empty());
+    EXPECT_TRUE(selection.getSelections().empty());
+}
+
+TEST_F(DistributedTacticSelectionTest, ChecksRanksAndMs)
+{
+    EXPECT_THROW((DistributedTacticSelection<Config>{{16}, 2, 2}), tensorrt_llm::common::TllmException);
+    EXPECT_THROW((DistributedTacticSelection<Config>{{16}, 0, 0}), tensorrt_llm::common::TllmException);
+
+    // Rank 1 of 2 profiles 32 only
+    DistributedTacticSelection<Config> selection{{16, 32, 64}, 2, 1};
+    EXPECT_THROW(selection.select(16, Config{1, 1}), tensorrt_llm::common::TllmException);
+    EXPECT_THROW(selection.select(128, Config{1, 1}), tensorrt_llm::common::TllmException);
+    selection.select(32, Config{2, 3});
+    EXPECT_EQ(selection.getLocalSelections()[0].m, 32);
+    EXPECT_EQ(selection.getLocalSelections()[1].m, DistributedTacticSelection<Config>::kNoM);
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/plugins/ncclPlugin/gemmCommOverlapPlugin.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tests/plugins/ncclTestUtils.h"
+
+#include <nccl.h>
+
+#include <set>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tp = tensorrt_llm::plugins;
+namespace tr = tensorrt_llm::runtime;
+
+using tensorrt_llm::tests::createNcclComm;
+
+namespace
+{
+
+// Two ranks run the GemmCommOverlap plugin with more chunks than fit the shard evenly. Its output must match the
+// unfused layers it replaces: a GEMM followed by an NCCL reduce-scatter for REDUCE_SCATTER, an NCCL all-gather followed
+// by a GEMM for ALL_GATHER. The GEMMs of the unfused path run on the host over small integers, so both are exact.
+class GemmCommOverlapTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        auto& comm = COMM_SESSION;
+        if (comm.getSize() != kTpSize || tc::getDeviceCount() < kTpSize)
+        {
+            GTEST_SKIP() << "Requires 2 ranks on 2 GPUs";
+        }
+        mRank = comm.getRank();
+        TLLM_CUDA_CHECK(cudaSetDevice(mRank));
+        mStream = std::make_shared<tr::CudaStream>();
+        mManager = std::make_unique<tr::BufferManager>(mStream);
+        mComm = createNcclComm(comm);
+
+        // Rank dependent activations and weights [N, K], the weights of the shard of this rank
+        mWeight.resize(kN * kK);
+        for (std::size_t i = 0; i < mWeight.size(); ++i)
+        {
+            mWeight[i] = static_cast<float>(static_cast<int>((i * 7 + mRank) % 5) - 2);
+        }
+    }
+
+    //! \brief `rows` rows of K activations of this rank.
+    std::vector<float> makeActivation(int rows) const
+    {
+        std::vector<float> act(rows * kK);
+        for (std::size_t i = 0; i < act.size(); ++i)
+        {
+            act[i] = static_cast<float>(static_cast<int>((i * 3 + mRank * 5) % 5) - 2);
+        }
+        return act;
+    }
+
+    //! \brief act [rows, K] times the transposed weight [N, K] on the host.
+    std::vector<float> hostGemm(std::vector<float> const& act) const
+    {
+        auto const rows = static_cast<int>(act.size()) / kK;
+        std::vector<float> out(rows * kN, 0.f);
+        for (int r = 0; r < rows; ++r)
+        {
+            for (int n = 0; n < kN; ++n)
+            {
+                for (int k = 0; k < kK; ++k)
+                {
+                    out[r * kN + n] += act[r * kK + k] * mWeight[n * kK + k];
+                }
+            }
+        }
+        return out;
+    }
+
+    //! \brief Runs the plugin on `act` with `actRows` rows and an output of `outRows` rows.
+    std::vector<float> runPlugin(tp::GemmCommOp op, std::vector<float> const& act, int actRows, int outRows) const
+    {
+        tp::GemmCommOverlapPlugin plugin{{0, 1}, nvinfer1::DataType::kFLOAT, op, 1, kNumChunks};
+        EXPECT_EQ(plugin.initialize(), 0);
+
+        auto const makeDesc = [](nvinfer1::Dims dims)
+        {
+            nvinfer1::PluginTensorDesc desc{};
+            desc.dims = dims;
+            desc.type = nvinfer1::DataType::kFLOAT;
+            desc.format = nvinfer1::TensorFormat::kLINEAR;
+            return desc;
+        };
+        nvinfer1::PluginTensorDesc const inputDesc[]
+            = {makeDesc(tr::ITensor::makeShape({actRows, kK})), makeDesc(tr::ITensor::makeShape({kN, kK}))};
+        nvinfer1::PluginTensorDesc const outputDesc[] = {makeDesc(tr::ITensor::makeShape({outRows, kN}))};
+
+        auto input = mManager->copyFrom(act, tr::MemoryType::kGPU);
+        auto weight = mManager->copyFrom(mWeight, tr::MemoryType::kGPU);
+        auto output = mManager->gpu(outRows * kN, nvinfer1::DataType::kFLOAT);
+        auto workspace = mManager->gpu(plugin.getWorkspaceSize(inputDesc, 2, outputDesc, 1));
+        void const* inputs[] = {input->data(), weight->data()};
+        void* outputs[] = {output->data()};
+        EXPECT_EQ(plugin.enqueue(inputDesc, outputDesc, inputs, outputs, workspace->data(), mStream->get()), 0);
+
+        std::vector<float> result(outRows * kN);
+        mManager->copy(*output, result.data());
+        mStream->synchronize();
+        plugin.terminate();
+        return result;
+    }
+
+    //! \brief Runs the NCCL collective of the unfused path on `values`, `outSize` elements out.
+    std::vector<float> runCollective(tp::GemmCommOp op, std::vector<float> const& values, std::size_t outSize) const
+    {
+        auto input = mManager->copyFrom(values, tr::MemoryType::kGPU);
+        auto output = mManager->gpu(outSize, nvinfer1::DataType::kFLOAT);
+        if (op == tp::GemmCommOp::REDUCE_SCATTER)
+        {
+            NCCLCHECK(ncclReduceScatter(
+                input->data(), output->data(), outSize, ncclFloat32, ncclSum, *mComm, mStream->get()));
+        }
+        else
+        {
+            NCCLCHECK(ncclAllGather(input->data(), output->data(), values.size(), ncclFloat32, *mComm, mStream->get()));
+        }
+        std::vector<float> result(outSize);
+        mManager->copy(*output, result.data());
+        mStream->synchronize();
+        return result;
+    }
+
+    static void expectEqual(std::vector<float> const& actual, std::vector<float> const& expected)
+    {
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < expected.size(); ++i)
+        {
+            ASSERT_EQ(actual[i], expected[i]) << "index " << i;
+        }
+    }
+
+    static constexpr int kTpSize{2};
+    static constexpr int kK{32};
+    static constexpr int kN{16};
+    // 7 rows per rank in chunks of 3, 3 and 1
+    static constexpr int kShardRows{7};
+    static constexpr int kNumChunks{3};
+
+    int mRank{0};
+    std::shared_ptr<tr::CudaStream> mStream;
+    std::unique_ptr<tr::BufferManager> mManager;
+    std::shared_ptr<ncclComm_t> mComm;
+    std::vector<float> mWeight;
+};
+
+} // namespace
+
+TEST_F(GemmCommOverlapTest, ReduceScatterMatchesUnfused)
+{
+    auto const act = makeActivation(kTpSize * kShardRows);
+    auto const expected
+        = runCollective(tp::GemmCommOp::REDUCE_SCATTER, hostGemm(act), static_cast<std::size_t>(kShardRows) * kN);
+    expectEqual(runPlugin(tp::GemmCommOp::REDUCE_SCATTER, act, kTpSize * kShardRows, kShardRows), expected);
+}
+
+TEST_F(GemmCommOverlapTest, AllGatherMatchesUnfused)
+{
+    auto const act = makeActivation(kShardRows);
+    auto const gathered = runCollective(tp::GemmCommOp::ALL_GATHER, act, kTpSize * act.size());
+    expectEqual(runPlugin(tp::GemmCommOp::ALL_GATHER, act, kShardRows, kTpSize * kShardRows), hostGemm(gathered));
+}
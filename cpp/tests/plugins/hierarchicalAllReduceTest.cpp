@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/plugins/common/plugin.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tests/plugins/ncclTestUtils.h"
+
+#include <nccl.h>
+
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tr = tensorrt_llm::runtime;
+
+using tensorrt_llm::tests::createNcclComm;
+
+namespace
+{
+
+// Four ranks split into two emulated nodes of two ranks. The hierarchical allreduce over the node and cross-node
+// communicators must give the same result as the flat NCCL allreduce over the whole group, which is the path the
+// allreduce plugin takes for groups that do not span nodes evenly. The values are small integers so both are exact.
+class HierarchicalAllReduceTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        auto& comm = COMM_SESSION;
+        if (comm.getSize() != kNumRanks || tc::getDeviceCount() < kNumRanks)
+        {
+            GTEST_SKIP() << "Requires 4 ranks on 4 GPUs";
+        }
+        mRank = comm.getRank();
+        TLLM_CUDA_CHECK(cudaSetDevice(mRank));
+        mStream = std::make_shared<tr::CudaStream>();
+
+        mComm = createNcclComm(comm);
+        mNodeComm = createNcclComm(comm.split(mRank / kNodeSize, mRank));
+        mCrossNodeComm = createNcclComm(comm.split(mRank % kNodeSize, mRank));
+    }
+
+    //! \brief Allreduces `size` floats of value (rank + 1) * (i % 7) with chunks of `chunkBytes`, hierarchically if
+    //! `hierarchical` and with a single NCCL allreduce otherwise.
+    std::vector<float> runAllReduce(std::size_t size, std::size_t chunkBytes, bool hierarchical) const
+    {
+        tr::BufferManager manager{mStream};
+        std::vector<float> values(size);
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            values[i] = static_cast<float>((mRank + 1) * (i % 7));
+        }
+        auto input = manager.copyFrom(values, tr::MemoryType::kGPU);
+        auto output = manager.gpu(size, nvinfer1::DataType::kFLOAT);
+        manager.setZero(*output);
+
+        if (hierarchical)
+        {
+            tr::CudaStream crossNodeStream;
+            cudaEvent_t reduceScattered, crossNodeReduced;
+            TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&reduceScattered, cudaEventDisableTiming));
+            TLLM_CUDA_CHECK(cudaEventCreateWithFlags(&crossNodeReduced, cudaEventDisableTiming));
+            tensorrt_llm::plugins::hierarchicalAllReduce(input->data(), output->data(), size,
+                nvinfer1::DataType::kFLOAT, chunkBytes, *mNodeComm, *mCrossNodeComm, *mComm, mStream->get(),
+                crossNodeStream.get(), reduceScattered, crossNodeReduced);
+            mStream->synchronize();
+            crossNodeStream.synchronize();
+            TLLM_CUDA_CHECK(cudaEventDestroy(reduceScattered));
+            TLLM_CUDA_CHECK(cudaEventDestroy(crossNodeReduced));
+        }
+        else
+        {
+            NCCLCHECK(ncclAllReduce(input->data(), output->data(), size, ncclFloat32, ncclSum, *mComm, mStream->get()));
+            mStream->synchronize();
+        }
+
+        std::vector<float> result(size);
+        manager.copy(*output, result.data());
+        mStream->synchronize();
+        return result;
+    }
+
+    static constexpr int kNumRanks{4};
+    static constexpr int kNodeSize{2};
+
+    int mRank{0};
+    std::shared_ptr<tr::CudaStream> mStream;
+    std::shared_ptr<ncclComm_t> mComm;
+    std::shared_ptr<ncclComm_t> mNodeComm;
+    std::shared_ptr<ncclComm_t> mCrossNodeComm;
+};
+
+} // namespace
+
+TEST_F(HierarchicalAllReduceTest, MatchesFlatAllReduce)
+{
+    // Three chunks of 64 elements, a partial chunk and an element past a multiple of the node size
+    std::size_t constexpr chunkBytes = 64 * sizeof(float);
+    for (std::size_t size : {std::size_t{128}, std::size_t{64 * 3 + 30 + 1}, std::size_t{1}})
+    {
+        SCOPED_TRACE(size);
+        auto const expected = runAllReduce(size, chunkBytes, false);
+        auto const actual = runAllReduce(size, chunkBytes, true);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (std::size_t i = 0; i < size; ++i)
+        {
+            ASSERT_EQ(expected[i], static_cast<float>(10 * (i % 7))) << "index " << i;
+            ASSERT_EQ(actual[i], expected[i]) << "index " << i;
+        }
+    }
+}
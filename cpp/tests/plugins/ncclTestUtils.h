@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include "tensorrt_llm/common/mpiUtils.h"
+#include "tensorrt_llm/plugins/common/plugin.h"
+
+#include <nccl.h>
+
+#include <memory>
+
+namespace tensorrt_llm::tests
+{
+
+//! \brief NCCL communicator over the ranks of `mpiComm`, in the order of their rank in it.
+inline std::shared_ptr<ncclComm_t> createNcclComm(mpi::MpiComm const& mpiComm)
+{
+    ncclUniqueId id;
+    if (mpiComm.getRank() == 0)
+    {
+        NCCLCHECK(ncclGetUniqueId(&id));
+    }
+    mpiComm.bcastValue(id, 0);
+    std::shared_ptr<ncclComm_t> comm(new ncclComm_t,
+        [](ncclComm_t* comm)
+        {
+            ncclCommDestroy(*comm);
+            delete comm;
+        });
+    NCCLCHECK(ncclCommInitRank(comm.get(), mpiComm.getSize(), id, mpiComm.getRank()));
+    return comm;
+}
+
+} // namespace tensorrt_llm::tests
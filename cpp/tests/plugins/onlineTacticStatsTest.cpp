@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/plugins/common/onlineTacticStats.h"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+using tensorrt_llm::plugins::OnlineTacticStats;
+
+TEST(OnlineTacticStatsTest, BucketM)
+{
+    int constexpr maxM = 8192;
+    // Four buckets per power of two, each M rounds up to the end of its bucket
+    EXPECT_EQ(OnlineTacticStats::getBucketM(1, maxM), 1);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(3, maxM), 3);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(5, maxM), 6);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(33, maxM), 48);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(40, maxM), 48);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(48, maxM), 48);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(49, maxM), 64);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(64, maxM), 64);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(65, maxM), 96);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(1000, maxM), 1024);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(1025, maxM), 1536);
+    // Everything from the largest profiled M on is one bucket
+    EXPECT_EQ(OnlineTacticStats::getBucketM(maxM, maxM), maxM);
+    EXPECT_EQ(OnlineTacticStats::getBucketM(3 * maxM, maxM), maxM);
+
+    // The bucket of an M contains the M and is stable
+    for (int m = 1; m <= maxM; ++m)
+    {
+        auto const bucketM = OnlineTacticStats::getBucketM(m, maxM);
+        ASSERT_GE(bucketM, m);
+        ASSERT_EQ(OnlineTacticStats::getBucketM(bucketM, maxM), bucketM) << "m=" << m;
+    }
+}
+
+TEST(OnlineTacticStatsTest, SamplesCandidatesInTurn)
+{
+    OnlineTacticStats stats{3};
+    std::vector<int> numInFlight{0, 0, 0};
+    EXPECT_EQ(stats.getNextCandidate(numInFlight), 0);
+    // Samples in flight count, so the pending ones are not sampled again before they complete
+    numInFlight = {1, 0, 0};
+    EXPECT_EQ(stats.getNextCandidate(numInFlight), 1);
+    numInFlight = {1, 1, 0};
+    EXPECT_EQ(stats.getNextCandidate(numInFlight), 2);
+    stats.addSample(0, 1.f);
+    stats.addSample(1, 1.f);
+    numInFlight = {0, 0, 1};
+    EXPECT_EQ(stats.getNextCandidate(numInFlight), 0);
+}
+
+TEST(OnlineTacticStatsTest, ConvergesToLowestMean)
+{
+    int constexpr samplesPerTactic = 8;
+    OnlineTacticStats stats{3};
+    EXPECT_FALSE(stats.isConverged(samplesPerTactic));
+
+    // Sample in turn as the profiler does, with candidate 1 the fastest
+    std::vector<float> const latencies{2.f, 1.f, 3.f};
+    std::vector<int> const noneInFlight(3, 0);
+    int numSteps = 0;
+    while (!stats.isConverged(samplesPerTactic))
+    {
+        auto const candidate = stats.getNextCandidate(noneInFlight);
+        stats.addSample(candidate, latencies[candidate]);
+        ASSERT_LE(++numSteps, 3 * samplesPerTactic);
+    }
+    EXPECT_EQ(numSteps, 3 * samplesPerTactic);
+    EXPECT_EQ(stats.getBest(), 1);
+    EXPECT_FLOAT_EQ(stats.getMean(1), 1.f);
+}
+
+TEST(OnlineTacticStatsTest, ComparesMeansNotSums)
+{
+    // Samples complete out of order, the slower candidate may have fewer samples and so a lower total
+    OnlineTacticStats stats{2};
+    for (int ii = 0; ii < 12; ++ii)
+    {
+        stats.addSample(0, 1.f);
+    }
+    for (int ii = 0; ii < 8; ++ii)
+    {
+        stats.addSample(1, 1.25f);
+    }
+    EXPECT_TRUE(stats.isConverged(8));
+    EXPECT_EQ(stats.getBest(), 0);
+    EXPECT_FLOAT_EQ(stats.getMean(0), 1.f);
+    EXPECT_FLOAT_EQ(stats.getMean(1), 1.25f);
+}
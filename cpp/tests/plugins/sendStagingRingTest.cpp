@@ -0,0 +1,146 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/plugins/ncclPlugin/sendStagingRing.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tp = tensorrt_llm::plugins;
+namespace tr = tensorrt_llm::runtime;
+
+namespace
+{
+
+// The staging buffers of SendPlugin in a single process: the peer is a device copy out of the staging buffer that
+// starts late on the communication stream, so a buffer overwritten before its send is done shows up in what the peer
+// received. Every message overwrites the input of the producer right after it is staged.
+class SendStagingRingTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "Requires a GPU";
+        }
+        mStream = std::make_shared<tr::CudaStream>();
+        mManager = std::make_unique<tr::BufferManager>(mStream);
+        mInput = mManager->gpu(kMaxBytes);
+        mRing = std::make_unique<tp::SendStagingRing>();
+    }
+
+    //! \brief Stages a message of `bytes` whose bytes are all `value`, the peer receives it after kSendDelay.
+    //! \returns the staging buffer of the message
+    std::size_t send(std::size_t bytes, std::uint8_t value)
+    {
+        mManager->setMem(*mInput, value);
+        mReceived.emplace_back(mManager->gpu(bytes));
+        auto* received = mReceived.back()->data();
+        auto const buffer = mRing->stage(mInput->data(), bytes, mStream->get(),
+            [received, bytes](void const* staged, cudaStream_t commStream)
+            {
+                TLLM_CUDA_CHECK(cudaLaunchHostFunc(
+                    commStream, [](void*) { std::this_thread::sleep_for(kSendDelay); }, nullptr));
+                TLLM_CUDA_CHECK(cudaMemcpyAsync(received, staged, bytes, cudaMemcpyDeviceToDevice, commStream));
+            });
+        // The producer reuses its input right away
+        mManager->setMem(*mInput, 0xff);
+        return buffer;
+    }
+
+    //! \brief Waits for all sends, message i must have been received with all its bytes equal to values[i].
+    void expectReceived(std::vector<std::uint8_t> const& values)
+    {
+        mRing->synchronize();
+        mStream->synchronize();
+        ASSERT_EQ(mReceived.size(), values.size());
+        for (std::size_t i = 0; i < values.size(); ++i)
+        {
+            SCOPED_TRACE("message " + std::to_string(i));
+            auto const host = mManager->copyFrom(*mReceived[i], tr::MemoryType::kCPU);
+            auto const* bytes = static_cast<std::uint8_t const*>(host->data());
+            for (std::size_t j = 0; j < host->getSizeInBytes(); ++j)
+            {
+                ASSERT_EQ(bytes[j], values[i]) << "byte " << j;
+            }
+        }
+    }
+
+    static constexpr std::chrono::milliseconds kSendDelay{100};
+    static constexpr std::size_t kMaxBytes{1 << 20};
+
+    std::shared_ptr<tr::CudaStream> mStream;
+    std::unique_ptr<tr::BufferManager> mManager;
+    tr::IBuffer::SharedPtr mInput;
+    std::vector<tr::IBuffer::SharedPtr> mReceived;
+    std::unique_ptr<tp::SendStagingRing> mRing;
+};
+
+} // namespace
+
+TEST_F(SendStagingRingTest, BuffersAlternate)
+{
+    for (std::uint8_t i = 0; i < 6; ++i)
+    {
+        EXPECT_EQ(send(4096, i + 1), i % tp::SendStagingRing::kNumBuffers);
+    }
+    EXPECT_NE(mRing->getBuffer(0), mRing->getBuffer(1));
+    expectReceived({1, 2, 3, 4, 5, 6});
+}
+
+TEST_F(SendStagingRingTest, ProducerOnlyWaitsForReusedBuffer)
+{
+    // Both buffers are free, the producer doesn't wait for the sends
+    send(4096, 1);
+    send(4096, 2);
+    mStream->synchronize();
+    EXPECT_EQ(cudaStreamQuery(mRing->getCommStream()), cudaErrorNotReady);
+
+    // The third message reuses the buffer of the first one, which must be received before it is overwritten
+    send(4096, 3);
+    send(4096, 4);
+    expectReceived({1, 2, 3, 4});
+}
+
+TEST_F(SendStagingRingTest, BuffersGrow)
+{
+    send(1024, 1);
+    EXPECT_EQ(mRing->getBufferBytes(), 1024);
+
+    // A message that fits doesn't reallocate, a larger one grows the buffers to the minimum size
+    mRing->setMinBufferBytes(64 << 10);
+    send(1024, 2);
+    EXPECT_EQ(mRing->getBufferBytes(), 1024);
+    send(2048, 3);
+    EXPECT_EQ(mRing->getBufferBytes(), 64 << 10);
+
+    // Larger than the minimum size, the buffers take the message
+    send(kMaxBytes, 4);
+    EXPECT_EQ(mRing->getBufferBytes(), kMaxBytes);
+    send(16, 5);
+    expectReceived({1, 2, 3, 4, 5});
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/plugins/common/tacticCache.h"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+using tensorrt_llm::plugins::TacticCache;
+
+namespace
+{
+struct Tactic
+{
+    int tileConfig;
+    int stages;
+};
+
+class TacticCacheTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mPath = std::filesystem::temp_directory_path()
+            / ("tacticCacheTest_" + std::string{::testing::UnitTest::GetInstance()->current_test_info()->name()});
+        std::filesystem::remove(mPath);
+    }
+
+    void TearDown() override
+    {
+        std::filesystem::remove(mPath);
+    }
+
+    std::filesystem::path mPath;
+};
+} // namespace
+
+TEST_F(TacticCacheTest, RoundTrip)
+{
+    {
+        TacticCache cache{mPath, "gpu0"};
+        EXPECT_EQ(cache.size(), 0);
+        EXPECT_FALSE(cache.findValue<std::optional<Tactic>>("gemm|m=8").has_value());
+        cache.insertValue("gemm|m=8", std::optional<Tactic>{Tactic{3, 4}});
+        cache.insertValue("gemm|m=16", std::optional<Tactic>{});
+        cache.save();
+    }
+    TacticCache cache{mPath, "gpu0"};
+    EXPECT_EQ(cache.size(), 2);
+    auto const tactic = cache.findValue<std::optional<Tactic>>("gemm|m=8");
+    ASSERT_TRUE(tactic.has_value() && tactic->has_value());
+    EXPECT_EQ(tactic->value().tileConfig, 3);
+    EXPECT_EQ(tactic->value().stages, 4);
+    auto const noTactic = cache.findValue<std::optional<Tactic>>("gemm|m=16");
+    ASSERT_TRUE(noTactic.has_value());
+    EXPECT_FALSE(noTactic->has_value());
+    // Values of another size are not returned
+    EXPECT_FALSE(cache.findValue<int>("gemm|m=8").has_value());
+}
+
+TEST_F(TacticCacheTest, OtherDeviceIsIgnored)
+{
+    {
+        TacticCache cache{mPath, "gpu0"};
+        cache.insertValue("gemm|m=8", 1);
+        cache.save();
+    }
+    TacticCache cache{mPath, "gpu1"};
+    EXPECT_EQ(cache.size(), 0);
+    cache.insertValue("gemm|m=8", 2);
+    cache.save();
+    EXPECT_EQ(TacticCache(mPath, "gpu1").findValue<int>("gemm|m=8"), 2);
+    EXPECT_EQ(TacticCache(mPath, "gpu0").size(), 0);
+}
+
+TEST_F(TacticCacheTest, CorruptedFileIsIgnored)
+{
+    {
+        TacticCache cache{mPath, "gpu0"};
+        cache.insertValue("gemm|m=8", 1);
+        cache.insertValue("gemm|m=16", 2);
+        cache.save();
+    }
+    auto const size = std::filesystem::file_size(mPath);
+    std::filesystem::resize_file(mPath, size - 2);
+    EXPECT_EQ(TacticCache(mPath, "gpu0").size(), 0);
+
+    {
+        std::ofstream file{mPath, std::ios::binary};
+        file << "garbage";
+    }
+    EXPECT_EQ(TacticCache(mPath, "gpu0").size(), 0);
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/plugins/common/weightStreamingSchedule.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstddef>
+#include <optional>
+#include <string>
+#include <vector>
+
+using tensorrt_llm::plugins::WeightStreamingSchedule;
+
+namespace
+{
+
+// The staging buffers of the weight streaming of GEMM plugins, without CUDA: which buffer each GEMM reads, which
+// weights are copied when, and that after the first pass every GEMM finds its weights prefetched by the previous one.
+class WeightStreamingScheduleTest : public ::testing::Test
+{
+protected:
+    using Staging = WeightStreamingSchedule::Staging;
+
+    //! \brief Runs the GEMM of layer `layer`: acquires its weights in `buffer`, staged now if `staged`, and releases
+    //! them, which prefetches `prefetch`.
+    void runGemm(int layer, std::size_t buffer, bool staged, std::optional<Staging> const& prefetch)
+    {
+        SCOPED_TRACE("layer " + std::to_string(layer));
+        auto const* weights = &mWeights[layer];
+        auto const acquired = mSchedule.acquire(weights, sizeof(mWeights[layer]) * (layer + 1));
+        EXPECT_EQ(acquired.buffer, buffer);
+        EXPECT_EQ(acquired.layer, layer);
+        ASSERT_EQ(acquired.staging.has_value(), staged);
+        if (staged)
+        {
+            EXPECT_EQ(acquired.staging->buffer, buffer);
+            EXPECT_EQ(acquired.staging->layer, layer);
+        }
+        EXPECT_EQ(mSchedule.getCurrentBuffer(), buffer);
+        EXPECT_EQ(mSchedule.getBufferLayer(buffer), layer);
+
+        auto const released = mSchedule.release(weights);
+        ASSERT_EQ(released.has_value(), prefetch.has_value());
+        if (prefetch)
+        {
+            EXPECT_EQ(released->buffer, prefetch->buffer);
+            EXPECT_EQ(released->layer, prefetch->layer);
+            EXPECT_EQ(mSchedule.getBufferLayer(prefetch->buffer), prefetch->layer);
+        }
+    }
+
+    std::array<int, 4> mWeights{};
+    WeightStreamingSchedule mSchedule;
+};
+
+} // namespace
+
+TEST_F(WeightStreamingScheduleTest, LearnsLayersThenPrefetchesOneAhead)
+{
+    // First pass: the layers are learnt in order of first use and staged when they run
+    runGemm(0, 0, true, std::nullopt);
+    runGemm(1, 1, true, std::nullopt);
+    // The last known layer prefetches the first one for the next step
+    runGemm(2, 0, true, Staging{1, 0});
+    ASSERT_EQ(mSchedule.getNumLayers(), 3);
+    for (int layer = 0; layer < 3; ++layer)
+    {
+        EXPECT_EQ(mSchedule.getLayer(layer).weights, &mWeights[layer]);
+        EXPECT_EQ(mSchedule.getLayer(layer).size, sizeof(int) * (layer + 1));
+    }
+
+    // Later steps: the buffers alternate and each GEMM prefetches the next layer into the buffer it doesn't read
+    for (int step = 0; step < 3; ++step)
+    {
+        SCOPED_TRACE("step " + std::to_string(step));
+        runGemm(0, 1, false, Staging{0, 1});
+        runGemm(1, 0, false, Staging{1, 2});
+        runGemm(2, 1, false, Staging{0, 0});
+        runGemm(0, 0, false, Staging{1, 1});
+        runGemm(1, 1, false, Staging{0, 2});
+        runGemm(2, 0, false, Staging{1, 0});
+    }
+    EXPECT_EQ(mSchedule.getNumLayers(), 3);
+}
+
+TEST_F(WeightStreamingScheduleTest, SingleLayer)
+{
+    // Each buffer is staged once, the layer is never prefetched into the buffer it is read from
+    runGemm(0, 0, true, std::nullopt);
+    runGemm(0, 1, true, std::nullopt);
+    for (int step = 0; step < 4; ++step)
+    {
+        runGemm(0, step % 2, false, std::nullopt);
+    }
+}
+
+TEST_F(WeightStreamingScheduleTest, OutOfOrderGemmIsStaged)
+{
+    runGemm(0, 0, true, std::nullopt);
+    runGemm(1, 1, true, std::nullopt);
+    runGemm(2, 0, true, Staging{1, 0});
+
+    // Layer 1 is skipped, layer 2 wasn't prefetched and is staged, then the order resumes
+    runGemm(0, 1, false, Staging{0, 1});
+    runGemm(2, 0, true, std::nullopt);
+    runGemm(0, 1, false, Staging{0, 1});
+    runGemm(1, 0, false, Staging{1, 2});
+
+    // A new layer is appended to the order
+    runGemm(3, 1, true, Staging{0, 0});
+    EXPECT_EQ(mSchedule.getNumLayers(), 4);
+    runGemm(0, 0, false, Staging{1, 1});
+}
+
+TEST_F(WeightStreamingScheduleTest, ReleaseChecksWeights)
+{
+    EXPECT_THROW(mSchedule.release(&mWeights[0]), tensorrt_llm::common::TllmException);
+
+    mSchedule.acquire(&mWeights[0], sizeof(int));
+    mSchedule.acquire(&mWeights[1], sizeof(int));
+    // Only the weights acquired last may be released
+    EXPECT_THROW(mSchedule.release(&mWeights[0]), tensorrt_llm::common::TllmException);
+    EXPECT_FALSE(mSchedule.release(&mWeights[1]).has_value());
+}
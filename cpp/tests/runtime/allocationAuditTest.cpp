@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/runtime/allocationAudit.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <numeric>
+#include <tuple>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+// Counts the host heap allocations of the test for the audit
+void* operator new(std::size_t size)
+{
+    AllocationAudit::recordHostAllocation();
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+    {
+        return ptr;
+    }
+    throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+namespace
+{
+class AllocationAuditTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        AllocationAudit::setEnabled(true);
+        std::ignore = AllocationAudit::takeCounts();
+    }
+
+    void TearDown() override
+    {
+        AllocationAudit::setEnabled(false);
+    }
+};
+} // namespace
+
+TEST_F(AllocationAuditTest, CountsHostAllocationsByTag)
+{
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kDECODER};
+        auto const value = std::make_unique<int>(1);
+        EXPECT_EQ(*value, 1);
+    }
+    auto const counts = AllocationAudit::takeCounts();
+    auto const& decoder = counts[static_cast<std::size_t>(MemoryTimeline::Tag::kDECODER)];
+    EXPECT_EQ(decoder.numHostAllocations, 1);
+    EXPECT_EQ(decoder.numDeviceAllocations, 0);
+    EXPECT_EQ(counts[static_cast<std::size_t>(MemoryTimeline::Tag::kSCHEDULER)].numHostAllocations, 0);
+
+    AllocationAudit::TagCounts decoderOnly{};
+    decoderOnly[static_cast<std::size_t>(MemoryTimeline::Tag::kDECODER)] = decoder;
+    EXPECT_EQ(AllocationAudit::toString(decoderOnly), "decoder: 1 host, 0 device");
+
+    // Taking the counts resets them
+    auto const taken = AllocationAudit::takeCounts();
+    EXPECT_EQ(taken[static_cast<std::size_t>(MemoryTimeline::Tag::kDECODER)].numHostAllocations, 0);
+}
+
+TEST_F(AllocationAuditTest, CountsBufferAllocations)
+{
+    BufferManager manager{std::make_shared<CudaStream>()};
+    std::ignore = AllocationAudit::takeCounts();
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kLORA};
+        auto const gpuBuffer = manager.gpu(64, nvinfer1::DataType::kFLOAT);
+        auto const pinnedBuffer = BufferManager::pinned(64, nvinfer1::DataType::kFLOAT);
+    }
+    auto const counts = AllocationAudit::takeCounts();
+    auto const& lora = counts[static_cast<std::size_t>(MemoryTimeline::Tag::kLORA)];
+    EXPECT_EQ(lora.numDeviceAllocations, 2);
+    // The buffer objects themselves
+    EXPECT_GE(lora.numHostAllocations, 2);
+    manager.getStream().synchronize();
+}
+
+TEST_F(AllocationAuditTest, DetectsAllocationsInSteadyState)
+{
+    std::vector<int> tokens;
+    tokens.reserve(16);
+    std::ignore = AllocationAudit::takeCounts();
+
+    // Reusing the reserved memory does not allocate
+    for (int step = 0; step < 16; ++step)
+    {
+        tokens.push_back(step);
+    }
+    EXPECT_NO_THROW(AllocationAudit::checkNoAllocations("steady state"));
+    EXPECT_EQ(std::accumulate(tokens.begin(), tokens.end(), 0), 120);
+
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kSCHEDULER};
+        tokens.push_back(16);
+    }
+    EXPECT_THROW(AllocationAudit::checkNoAllocations("steady state"), tensorrt_llm::common::TllmException);
+}
+
+TEST_F(AllocationAuditTest, DisabledAuditDoesNotCount)
+{
+    AllocationAudit::setEnabled(false);
+    std::ignore = AllocationAudit::takeCounts();
+    auto const value = std::make_unique<int>(1);
+    AllocationAudit::recordAllocation(MemoryType::kGPU);
+    EXPECT_EQ(AllocationAudit::toString(AllocationAudit::takeCounts()), "");
+    EXPECT_EQ(*value, 1);
+}
@@ -21,6 +21,8 @@
 
 #include <limits>
 #include <memory>
+#include <numeric>
+#include <vector>
 
 using namespace tensorrt_llm::runtime;
 namespace tc = tensorrt_llm::common;
@@ -197,3 +199,27 @@ TEST_F(BufferManagerTest, TrimPoolOnDestruction)
     EXPECT_LE(memoryPoolReserved(), reserved);
     EXPECT_LE(memoryPoolFree(), free);
 }
+
+TEST_F(BufferManagerTest, CachedRoundTrip)
+{
+    BufferManager manager(mStream);
+    auto constexpr size = 1000;
+    std::vector<float> inputCpu(size);
+    std::iota(inputCpu.begin(), inputCpu.end(), 0.f);
+    auto inputGpu = manager.gpuCached(size, nvinfer1::DataType::kFLOAT);
+    EXPECT_EQ(inputGpu->getMemoryType(), MemoryType::kGPU);
+    manager.copy(inputCpu.data(), *inputGpu);
+    auto outputCpu = manager.copyFrom(*inputGpu, MemoryType::kCPU);
+    manager.getStream().synchronize();
+    auto const* outputCpuTyped = bufferCast<float>(*outputCpu);
+    for (std::size_t i = 0; i < inputCpu.size(); ++i)
+    {
+        EXPECT_EQ(inputCpu[i], outputCpuTyped[i]);
+    }
+
+    // A buffer of the same size class freed on the same stream is reused
+    auto const* address = inputGpu->data();
+    inputGpu.reset();
+    auto const tensor = manager.gpuCached(ITensor::makeShape({size}), nvinfer1::DataType::kFLOAT);
+    EXPECT_EQ(tensor->data(), address);
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/cachingPool.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+struct CountingAllocator
+{
+    using PointerType = void*;
+
+    PointerType allocate(std::size_t size)
+    {
+        if (limit != 0 && reserved + size > limit)
+        {
+            throw std::bad_alloc();
+        }
+        reserved += size;
+        ++numAllocations;
+        return std::malloc(size);
+    }
+
+    void deallocate(PointerType ptr, std::size_t size)
+    {
+        reserved -= size;
+        std::free(ptr);
+    }
+
+    std::size_t limit{0};
+    std::size_t reserved{0};
+    std::size_t numAllocations{0};
+};
+
+struct RecordingStreamSync
+{
+    using StreamType = int;
+
+    static void waitForStream(int waiting, int other)
+    {
+        waits.emplace_back(waiting, other);
+    }
+
+    static inline std::vector<std::pair<int, int>> waits;
+};
+
+using Pool = CachingPool<CountingAllocator, RecordingStreamSync>;
+using detail::SizeClasses;
+} // namespace
+
+TEST(CachingPoolTest, SizeClasses)
+{
+    EXPECT_EQ(SizeClasses::getIndex(0), 0);
+    EXPECT_EQ(SizeClasses::getIndex(512), 0);
+    EXPECT_EQ(SizeClasses::getSize(SizeClasses::getIndex(513)), 640);
+    EXPECT_EQ(SizeClasses::getSize(SizeClasses::getIndex(1024)), 1024);
+    EXPECT_EQ(SizeClasses::getSize(SizeClasses::getIndex(1025)), 1280);
+    for (std::size_t size = 1; size < (1 << 20); size += 97)
+    {
+        auto const index = SizeClasses::getIndex(size);
+        EXPECT_GE(SizeClasses::getSize(index), size);
+        EXPECT_LE(SizeClasses::getSize(index), std::max(SizeClasses::kMinSize, size + size / 4));
+        if (index > 0)
+        {
+            EXPECT_LT(SizeClasses::getSize(index - 1), size);
+        }
+    }
+}
+
+TEST(CachingPoolTest, ReusesBlocksOfTheSameStream)
+{
+    RecordingStreamSync::waits.clear();
+    Pool pool;
+    auto* first = pool.allocate(1000, 0);
+    pool.deallocate(first);
+    auto stats = pool.getStats();
+    EXPECT_EQ(stats.cached, 1024);
+    EXPECT_EQ(stats.used, 0);
+
+    // Same class, same stream: no upstream allocation and no synchronization.
+    auto* second = pool.allocate(900, 0);
+    EXPECT_EQ(second, first);
+    stats = pool.getStats();
+    EXPECT_EQ(stats.numCacheHits, 1);
+    EXPECT_EQ(stats.used - stats.requested, 1024 - 900);
+    EXPECT_EQ(stats.reserved, 1024);
+    EXPECT_TRUE(RecordingStreamSync::waits.empty());
+
+    // Different class: new block.
+    auto* third = pool.allocate(5000, 0);
+    EXPECT_NE(third, second);
+    pool.deallocate(second);
+    pool.deallocate(third);
+    EXPECT_THROW(pool.deallocate(third), std::exception);
+
+    pool.emptyCache();
+    stats = pool.getStats();
+    EXPECT_EQ(stats.reserved, 0);
+    EXPECT_EQ(stats.cached, 0);
+}
+
+TEST(CachingPoolTest, CrossStreamReuseWaits)
+{
+    RecordingStreamSync::waits.clear();
+    Pool pool;
+    auto* block = pool.allocate(2048, 1);
+    pool.deallocate(block);
+    EXPECT_EQ(pool.allocate(2048, 2), block);
+    ASSERT_EQ(RecordingStreamSync::waits.size(), 1);
+    EXPECT_EQ(RecordingStreamSync::waits.front(), std::make_pair(2, 1));
+    EXPECT_EQ(pool.getStats().numCrossStreamHits, 1);
+
+    // Freed by stream 2 now, reused by it without waiting.
+    pool.deallocate(block);
+    EXPECT_EQ(pool.allocate(2048, 2), block);
+    EXPECT_EQ(RecordingStreamSync::waits.size(), 1);
+    pool.deallocate(block);
+}
+
+TEST(CachingPoolTest, EmptiesCacheWhenOutOfMemory)
+{
+    CountingAllocator allocator;
+    allocator.limit = 4096;
+    Pool pool{allocator};
+    auto* small = pool.allocate(2048, 0);
+    pool.deallocate(small);
+    // 2048 B cached, 4096 B don't fit next to them.
+    auto* large = pool.allocate(4096, 0);
+    auto const stats = pool.getStats();
+    EXPECT_EQ(stats.reserved, 4096);
+    EXPECT_EQ(stats.cached, 0);
+    EXPECT_THROW(pool.allocate(1, 0), std::bad_alloc);
+    pool.deallocate(large);
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/commTimingTracker.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(CommTimingTrackerTest, AggregatesPerTypeAndStrategy)
+{
+    // The setting is read once per process
+    setenv("TRTLLM_ENABLE_COMM_TIMING_STATS", "1", 1);
+    if (!CommTimingTracker::isEnabled())
+    {
+        GTEST_SKIP() << "Communication timing was disabled before the test";
+    }
+
+    auto& tracker = CommTimingTracker::getInstance();
+    (void) tracker.takeStats();
+    CudaStream stream;
+    auto buffer = BufferManager::gpuSync(1 << 20, nvinfer1::DataType::kINT8);
+    auto const timeMemset = [&](CommTimingTracker::OpType op, char const* strategy)
+    {
+        CommTimingTracker::ScopedTiming const timing{op, buffer->getSizeInBytes(), stream.get(), strategy};
+        TLLM_CUDA_CHECK(cudaMemsetAsync(buffer->data(), 0, buffer->getSizeInBytes(), stream.get()));
+    };
+    timeMemset(CommTimingTracker::OpType::kALLREDUCE, "ONESHOT");
+    timeMemset(CommTimingTracker::OpType::kALLREDUCE, "ONESHOT");
+    timeMemset(CommTimingTracker::OpType::kALLREDUCE, "NCCL");
+    timeMemset(CommTimingTracker::OpType::kSEND, "");
+
+    auto const stats = tracker.takeStats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].op, CommTimingTracker::OpType::kALLREDUCE);
+    EXPECT_EQ(stats[0].strategy, "NCCL");
+    EXPECT_EQ(stats[0].numCalls, 1);
+    EXPECT_EQ(stats[1].strategy, "ONESHOT");
+    EXPECT_EQ(stats[1].numCalls, 2);
+    EXPECT_EQ(stats[1].bytes, 2 * buffer->getSizeInBytes());
+    EXPECT_GE(stats[1].timeMs, 0.f);
+    EXPECT_EQ(stats[2].op, CommTimingTracker::OpType::kSEND);
+    EXPECT_STREQ(CommTimingTracker::getOpName(stats[2].op), "send");
+
+    EXPECT_TRUE(tracker.takeStats().empty());
+}
+
+TEST(CommTimingTrackerTest, SkipsCapturedStreams)
+{
+    if (!CommTimingTracker::isEnabled())
+    {
+        GTEST_SKIP() << "Communication timing is disabled";
+    }
+
+    auto& tracker = CommTimingTracker::getInstance();
+    (void) tracker.takeStats();
+    CudaStream stream;
+    auto buffer = BufferManager::gpuSync(1024, nvinfer1::DataType::kINT8);
+    cudaGraph_t graph;
+    TLLM_CUDA_CHECK(cudaStreamBeginCapture(stream.get(), cudaStreamCaptureModeThreadLocal));
+    {
+        CommTimingTracker::ScopedTiming const timing{
+            CommTimingTracker::OpType::kALLGATHER, buffer->getSizeInBytes(), stream.get()};
+        TLLM_CUDA_CHECK(cudaMemsetAsync(buffer->data(), 0, buffer->getSizeInBytes(), stream.get()));
+    }
+    TLLM_CUDA_CHECK(cudaStreamEndCapture(stream.get(), &graph));
+    TLLM_CUDA_CHECK(cudaGraphDestroy(graph));
+
+    EXPECT_TRUE(tracker.takeStats().empty());
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/cudaGraphCache.h"
+
+#include <gtest/gtest.h>
+
+#include <memory>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(CudaGraphCacheTest, Buckets)
+{
+    CudaGraphBuckets const buckets{48, 2, 4096, 1024};
+    EXPECT_EQ(buckets.getBatchSizes(), (std::vector<SizeType32>{1, 2, 4, 8, 16, 32, 48}));
+    EXPECT_EQ(buckets.getAttentionWindows(), (std::vector<SizeType32>{1024, 2048, 4096}));
+
+    EXPECT_EQ(buckets.getKey(3, 1, 100), (CudaGraphKey{4, 1, 1024}));
+    EXPECT_EQ(buckets.getKey(33, 2, 2049), (CudaGraphKey{48, 2, 4096}));
+    EXPECT_EQ(buckets.getKey(48, 1, 4096), (CudaGraphKey{48, 1, 4096}));
+    EXPECT_FALSE(buckets.getKey(49, 1, 1024).has_value());
+    EXPECT_FALSE(buckets.getKey(1, 3, 1024).has_value());
+    EXPECT_FALSE(buckets.getKey(1, 1, 4097).has_value());
+    EXPECT_FALSE(buckets.getKey(0, 1, 1024).has_value());
+
+    EXPECT_EQ(buckets.getKeys(1).size(), 7 * 3);
+}
+
+TEST(CudaGraphCacheTest, EvictsLeastRecentlyUsed)
+{
+    BasicCudaGraphCache<std::unique_ptr<int>> cache{2};
+    CudaGraphKey const a{1, 1, 1024};
+    CudaGraphKey const b{2, 1, 1024};
+    CudaGraphKey const c{4, 1, 1024};
+    cache.insert(a, std::make_unique<int>(1));
+    cache.insert(b, std::make_unique<int>(2));
+    ASSERT_NE(cache.find(a), nullptr);
+    cache.insert(c, std::make_unique<int>(3));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.find(b), nullptr);
+    ASSERT_NE(cache.find(a), nullptr);
+    EXPECT_EQ(**cache.find(a), 1);
+
+    cache.insert(a, std::make_unique<int>(4));
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(**cache.find(a), 4);
+    EXPECT_EQ(**cache.find(c), 3);
+    cache.clear();
+    EXPECT_EQ(cache.size(), 0);
+}
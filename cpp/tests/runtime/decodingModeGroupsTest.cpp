@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/decodingModeGroups.h"
+
+#include <optional>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace tle = tensorrt_llm::executor;
+
+TEST(DecodingModeGroupsTest, MergesDuplicateModes)
+{
+    auto const topKTopP = tle::DecodingMode::TopKTopP();
+    auto const topK = tle::DecodingMode::TopK().useOccurrencePenalties(false);
+    DecodingModeGroups const groups{{topKTopP, topK, topKTopP}, 4};
+    EXPECT_EQ(groups.getNumGroups(), 2);
+    EXPECT_EQ(groups.getModes().front(), topKTopP);
+    EXPECT_EQ(groups.getModes().back(), topK);
+    for (SizeType32 slot = 0; slot < 4; ++slot)
+    {
+        EXPECT_EQ(groups.getGroup(slot), 0);
+    }
+}
+
+TEST(DecodingModeGroupsTest, RejectsModesThatCantBeGrouped)
+{
+    EXPECT_THROW(DecodingModeGroups({}, 4), tensorrt_llm::common::TllmException);
+    EXPECT_THROW(DecodingModeGroups({tle::DecodingMode::Auto()}, 4), tensorrt_llm::common::TllmException);
+    EXPECT_THROW(DecodingModeGroups({tle::DecodingMode::TopKTopP(), tle::DecodingMode::Medusa()}, 4),
+        tensorrt_llm::common::TllmException);
+    EXPECT_THROW(DecodingModeGroups({tle::DecodingMode::Lookahead()}, 4), tensorrt_llm::common::TllmException);
+    EXPECT_THROW(
+        DecodingModeGroups({tle::DecodingMode::ExplicitDraftTokens()}, 4), tensorrt_llm::common::TllmException);
+}
+
+TEST(DecodingModeGroupsTest, AssignsSlotsAndSplitsBatches)
+{
+    auto const topKTopP = tle::DecodingMode::TopKTopP();
+    auto const topK = tle::DecodingMode::TopK().useOccurrencePenalties(false);
+    auto const batchInvariant = tle::DecodingMode::TopKTopP().useBatchInvariant(true);
+    DecodingModeGroups groups{{topKTopP, topK, batchInvariant}, 6};
+
+    EXPECT_EQ(groups.setSlotMode(0, std::nullopt), 0);
+    EXPECT_EQ(groups.setSlotMode(1, topK), 1);
+    EXPECT_EQ(groups.setSlotMode(2, batchInvariant), 2);
+    EXPECT_EQ(groups.setSlotMode(3, topK), 1);
+    EXPECT_EQ(groups.setSlotMode(4, topKTopP), 0);
+    EXPECT_THROW(groups.setSlotMode(5, tle::DecodingMode::TopP().useTemperature(false)),
+        tensorrt_llm::common::TllmException);
+    EXPECT_EQ(groups.getGroup(5), 0);
+
+    // Indices in the new requests, not slots
+    auto const indices = groups.splitSlots({4, 3, 1, 2});
+    ASSERT_EQ(indices.size(), 3);
+    EXPECT_EQ(indices[0], (std::vector<SizeType32>{0}));
+    EXPECT_EQ(indices[1], (std::vector<SizeType32>{1, 2}));
+    EXPECT_EQ(indices[2], (std::vector<SizeType32>{3}));
+
+    std::vector<bool> const active{true, true, false, true, true};
+    EXPECT_EQ(groups.getActive(0, active), (std::vector<bool>{true, false, false, false, true}));
+    EXPECT_EQ(groups.getActive(1, active), (std::vector<bool>{false, true, false, true, false}));
+    EXPECT_EQ(groups.getActive(2, active), (std::vector<bool>(5, false)));
+    EXPECT_TRUE(groups.hasActive(1, active));
+    EXPECT_FALSE(groups.hasActive(2, active));
+
+    // A slot taken by a request of another group leaves its previous group
+    groups.setSlotMode(1, batchInvariant);
+    EXPECT_EQ(groups.getActive(1, active), (std::vector<bool>{false, false, false, true, false}));
+    EXPECT_EQ(groups.getActive(2, active), (std::vector<bool>{false, true, false, false, false}));
+}
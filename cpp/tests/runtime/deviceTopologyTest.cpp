@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/deviceTopology.h"
+
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace tr = tensorrt_llm::runtime;
+
+using tr::DeviceTopology;
+using tr::SizeType32;
+
+TEST(DeviceTopology, PlaceGroups)
+{
+    // A single island keeps its order
+    EXPECT_EQ(DeviceTopology::placeGroups({{0, 1, 2, 3, 4, 5, 6, 7}}, 4),
+        (std::vector<SizeType32>{0, 1, 2, 3, 4, 5, 6, 7}));
+
+    // NVLink pairs 0-2 and 1-3, each group of two is one pair
+    EXPECT_EQ(DeviceTopology::placeGroups({{0, 2}, {1, 3}}, 2), (std::vector<SizeType32>{0, 2, 1, 3}));
+
+    // Islands of three devices only hold one group of two, the devices left over come last
+    EXPECT_EQ(DeviceTopology::placeGroups({{0, 1, 4}, {2, 3, 5}}, 2), (std::vector<SizeType32>{0, 1, 2, 3, 4, 5}));
+
+    // Groups larger than the islands
+    EXPECT_EQ(DeviceTopology::placeGroups({{0, 3}, {1, 2}}, 4), (std::vector<SizeType32>{0, 1, 2, 3}));
+}
+
+TEST(DeviceTopology, NvlinkIslandsCoverDevices)
+{
+    auto const numDevices = tensorrt_llm::common::getDeviceCount();
+    std::vector<SizeType32> devices(numDevices);
+    std::iota(devices.begin(), devices.end(), 0);
+
+    std::vector<SizeType32> covered;
+    for (auto const& island : DeviceTopology::getNvlinkIslands(devices))
+    {
+        EXPECT_TRUE(std::is_sorted(island.begin(), island.end()));
+        covered.insert(covered.end(), island.begin(), island.end());
+    }
+    std::sort(covered.begin(), covered.end());
+    EXPECT_EQ(covered, devices);
+
+    for (auto const device : devices)
+    {
+        EXPECT_EQ(DeviceTopology::getLinkType(device, device), DeviceTopology::LinkType::kNVLINK);
+        EXPECT_GE(DeviceTopology::getNumaNode(device), -1);
+    }
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/dirtyRowTracker.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+using Segments = std::vector<DirtyRowTracker::Segment>;
+auto constexpr kRowSize = 4;
+auto constexpr kRowSizeInBytes = kRowSize * sizeof(std::int32_t);
+} // namespace
+
+TEST(DirtyRowTracker, FirstUpdateIsAllDirty)
+{
+    DirtyRowTracker tracker;
+    std::vector<std::int32_t> table(3 * kRowSize, 1);
+    int destination{0};
+    EXPECT_EQ(tracker.update(table.data(), 3, kRowSizeInBytes, &destination), (Segments{{0, 3}}));
+    EXPECT_EQ(tracker.getNumDirtyRows(), 3);
+    EXPECT_TRUE(tracker.update(table.data(), 3, kRowSizeInBytes, &destination).empty());
+    EXPECT_EQ(tracker.getNumDirtyRows(), 0);
+}
+
+TEST(DirtyRowTracker, ChangedRowsAreCoalesced)
+{
+    DirtyRowTracker tracker;
+    std::vector<std::int32_t> table(6 * kRowSize, 0);
+    int destination{0};
+    tracker.update(table.data(), 6, kRowSizeInBytes, &destination);
+
+    table[1 * kRowSize + 3] = 7;
+    table[2 * kRowSize] = 7;
+    table[5 * kRowSize + 1] = 7;
+    EXPECT_EQ(tracker.update(table.data(), 6, kRowSizeInBytes, &destination), (Segments{{1, 2}, {5, 1}}));
+    EXPECT_EQ(tracker.getNumDirtyRows(), 3);
+
+    // The shadow holds the new contents
+    table[5 * kRowSize + 1] = 8;
+    EXPECT_EQ(tracker.update(table.data(), 6, kRowSizeInBytes, &destination), (Segments{{5, 1}}));
+}
+
+TEST(DirtyRowTracker, NewDestinationOrShapeIsAllDirty)
+{
+    DirtyRowTracker tracker;
+    std::vector<std::int32_t> table(4 * kRowSize, 0);
+    int destination{0};
+    int otherDestination{0};
+    tracker.update(table.data(), 4, kRowSizeInBytes, &destination);
+    EXPECT_EQ(tracker.update(table.data(), 4, kRowSizeInBytes, &otherDestination), (Segments{{0, 4}}));
+    EXPECT_EQ(tracker.update(table.data(), 2, kRowSizeInBytes, &otherDestination), (Segments{{0, 2}}));
+    EXPECT_EQ(tracker.update(table.data(), 1, 2 * kRowSizeInBytes, &otherDestination), (Segments{{0, 1}}));
+
+    tracker.invalidate();
+    EXPECT_EQ(tracker.update(table.data(), 1, 2 * kRowSizeInBytes, &otherDestination), (Segments{{0, 1}}));
+    EXPECT_TRUE(tracker.update(table.data(), 0, kRowSizeInBytes, &otherDestination).empty());
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/diskBlockStore.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <numeric>
+#include <string>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class DiskBlockStoreTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+        // A directory of its own, so that concurrent runs of the test don't share the file
+        auto dirTemplate = (std::filesystem::temp_directory_path() / "diskBlockStoreTest.XXXXXX").string();
+        ASSERT_NE(::mkdtemp(dirTemplate.data()), nullptr);
+        mDir = dirTemplate;
+        mPath = mDir / "blocks.bin";
+    }
+
+    void TearDown() override
+    {
+        if (!mDir.empty())
+        {
+            std::error_code ec;
+            std::filesystem::remove_all(mDir, ec);
+        }
+    }
+
+    static auto constexpr kBlockSize = 4096;
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+    std::filesystem::path mDir;
+    std::filesystem::path mPath;
+};
+
+namespace
+{
+IBuffer::SharedPtr makeBlock(std::size_t size, std::uint8_t seed)
+{
+    IBuffer::SharedPtr block = BufferManager::pinned(size);
+    auto* data = bufferCast<std::uint8_t>(*block);
+    std::iota(data, data + size, seed);
+    return block;
+}
+} // namespace
+
+TEST_F(DiskBlockStoreTest, RoundTrip)
+{
+    auto constexpr numBlocks = 3;
+    DiskBlockStore store{mPath, kBlockSize, numBlocks, 2};
+    EXPECT_TRUE(std::filesystem::exists(mPath));
+    EXPECT_EQ(store.getNumFreeBlocks(), numBlocks);
+
+    std::vector<IBuffer::SharedPtr> blocks;
+    std::vector<DiskBlockStore::SlotIdType> slots;
+    for (std::uint8_t i = 0; i < numBlocks; ++i)
+    {
+        blocks.push_back(makeBlock(kBlockSize, i));
+        auto slot = store.storeAsync(*blocks.back());
+        ASSERT_TRUE(slot.has_value());
+        slots.push_back(*slot);
+        // Source can be reused as soon as storeAsync returns
+        mManager->setZero(*blocks.back());
+    }
+    EXPECT_EQ(store.getNumFreeBlocks(), 0);
+    EXPECT_FALSE(store.storeAsync(*blocks.front()).has_value());
+
+    for (std::uint8_t i = 0; i < numBlocks; ++i)
+    {
+        auto expected = makeBlock(kBlockSize, i);
+        auto hostDst = BufferManager::pinned(kBlockSize);
+        store.loadAsync(slots[i], *hostDst).get();
+        EXPECT_EQ(std::memcmp(hostDst->data(), expected->data(), kBlockSize), 0);
+
+        auto deviceDst = mManager->gpu(kBlockSize);
+        store.loadAsync(slots[i], *deviceDst).get();
+        auto deviceCopy = mManager->copyFrom(*deviceDst, MemoryType::kCPU);
+        mStream->synchronize();
+        EXPECT_EQ(std::memcmp(deviceCopy->data(), expected->data(), kBlockSize), 0);
+    }
+
+    store.release(slots[1]);
+    EXPECT_EQ(store.getNumFreeBlocks(), 1);
+    auto slot = store.storeAsync(*makeBlock(kBlockSize, 42));
+    ASSERT_TRUE(slot.has_value());
+    EXPECT_EQ(slot.value(), slots[1]);
+    store.sync();
+}
+
+TEST_F(DiskBlockStoreTest, RemovesFile)
+{
+    {
+        DiskBlockStore store{mPath, kBlockSize, 1};
+    }
+    EXPECT_FALSE(std::filesystem::exists(mPath));
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/doubleBufferedPrep.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+using Staging = std::vector<int>;
+} // namespace
+
+TEST(DoubleBufferedPrepTest, AlternatesSlots)
+{
+    DoubleBufferedPrep<Staging> prep{Staging(4), Staging(4)};
+    EXPECT_EQ(prep.getCurrent(), nullptr);
+
+    auto fill = [](int value)
+    { return [value](Staging& staging) { std::fill(staging.begin(), staging.end(), value); }; };
+    auto* first = &prep.prepareSync(fill(0));
+    EXPECT_EQ(prep.getCurrent(), first);
+
+    for (int iteration = 1; iteration < 6; ++iteration)
+    {
+        auto const previous = prep.getCurrent();
+        prep.prepareAsync(fill(iteration));
+        EXPECT_TRUE(prep.isPreparing());
+        // The current slot is untouched while the next iteration is prepared.
+        EXPECT_EQ(previous->front(), iteration - 1);
+        auto& current = prep.acquire();
+        EXPECT_NE(&current, previous);
+        EXPECT_EQ(current, Staging(4, iteration));
+        EXPECT_FALSE(prep.isPreparing());
+    }
+}
+
+TEST(DoubleBufferedPrepTest, PropagatesErrors)
+{
+    DoubleBufferedPrep<Staging> prep{Staging{}, Staging{}};
+    EXPECT_THROW(prep.acquire(), std::exception);
+    prep.prepareAsync([](Staging&) { throw std::runtime_error("prep failed"); });
+    EXPECT_THROW(prep.prepareAsync([](Staging&) {}), std::exception);
+    EXPECT_THROW(prep.acquire(), std::runtime_error);
+    EXPECT_EQ(prep.getCurrent(), nullptr);
+
+    prep.prepareAsync([](Staging& staging) { staging.push_back(1); });
+    EXPECT_EQ(prep.acquire().size(), 1);
+}
+
+TEST(DoubleBufferedPrepTest, WaitsOnDestruction)
+{
+    bool prepared{false};
+    {
+        DoubleBufferedPrep<Staging> prep{Staging{}, Staging{}};
+        prep.prepareAsync(
+            [&prepared](Staging&)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                prepared = true;
+            });
+    }
+    EXPECT_TRUE(prepared);
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/draftTokensHandoff.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/cudaStream.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+class DraftTokensHandoffTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    static SizeType32 constexpr kMaxBatchSize{4};
+    static SizeType32 constexpr kMaxDraftTokens{3};
+    static SizeType32 constexpr kVocabSizePadded{8};
+    static SizeType32 constexpr kMaxSeqLen{16};
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(DraftTokensHandoffTest, TokensAndLogits)
+{
+    DraftTokensHandoff handoff{kMaxBatchSize, kMaxDraftTokens, kVocabSizePadded, nvinfer1::DataType::kFLOAT, *mManager};
+    SizeType32 constexpr batchSlot{2};
+    SizeType32 constexpr sequenceLength{5};
+    handoff.beginRound(batchSlot, sequenceLength);
+
+    // Draft decoder output ids of the request, [beamWidth, maxSeqLen]
+    std::vector<TokenIdType> outputIdsHost(kMaxSeqLen);
+    std::iota(outputIdsHost.begin(), outputIdsHost.end(), 100);
+    ITensor::SharedPtr outputIds
+        = mManager->copyFrom(outputIdsHost, ITensor::makeShape({1, kMaxSeqLen}), MemoryType::kGPU);
+
+    SizeType32 constexpr numDraftTokens{2};
+    for (SizeType32 di = 0; di < numDraftTokens; ++di)
+    {
+        std::vector<float> logitsHost(kVocabSizePadded, static_cast<float>(di + 1));
+        auto logits = mManager->copyFrom(logitsHost, ITensor::makeShape({1, 1, kVocabSizePadded}), MemoryType::kGPU);
+        handoff.addDraftLogits(batchSlot, *logits, *mManager);
+    }
+    EXPECT_EQ(handoff.getNumDraftTokens(batchSlot), numDraftTokens);
+
+    decoder_batch::Request request{outputIds, sequenceLength};
+    handoff.fillTargetRequest(request, batchSlot, outputIds, true);
+    EXPECT_EQ(request.generatedTokensPerEngineStep, numDraftTokens + 1);
+    ASSERT_TRUE(request.draftLogits.has_value());
+
+    auto draftTokensHost = mManager->copyFrom(*request.draftTokens, MemoryType::kCPU);
+    auto draftLogitsHost = mManager->copyFrom(*request.draftLogits.value(), MemoryType::kCPU);
+    mStream->synchronize();
+
+    auto const draftTokens = bufferCast<TokenIdType>(*draftTokensHost);
+    ASSERT_EQ(draftTokensHost->getSize(), numDraftTokens);
+    EXPECT_EQ(draftTokens[0], 100 + sequenceLength);
+    EXPECT_EQ(draftTokens[1], 101 + sequenceLength);
+
+    auto const draftLogits = bufferCast<float>(*draftLogitsHost);
+    ASSERT_EQ(draftLogitsHost->getSize(), numDraftTokens * kVocabSizePadded);
+    for (SizeType32 di = 0; di < numDraftTokens; ++di)
+    {
+        for (SizeType32 vi = 0; vi < kVocabSizePadded; ++vi)
+        {
+            EXPECT_EQ(draftLogits[di * kVocabSizePadded + vi], static_cast<float>(di + 1));
+        }
+    }
+
+    handoff.fillTargetRequest(request, batchSlot, outputIds, false);
+    EXPECT_FALSE(request.draftLogits.has_value());
+
+    EXPECT_EQ(handoff.getNumRewindTokens(batchSlot, 0), 2);
+    EXPECT_EQ(handoff.getNumRewindTokens(batchSlot, 2), 0);
+    EXPECT_THROW((void) handoff.getNumRewindTokens(batchSlot, 3), tensorrt_llm::common::TllmException);
+}
+
+TEST_F(DraftTokensHandoffTest, RoundLimits)
+{
+    DraftTokensHandoff handoff{kMaxBatchSize, kMaxDraftTokens, kVocabSizePadded, nvinfer1::DataType::kFLOAT, *mManager};
+    handoff.beginRound(0, 1);
+    auto logits = mManager->gpu(ITensor::makeShape({1, kVocabSizePadded}), nvinfer1::DataType::kFLOAT);
+    for (SizeType32 di = 0; di < kMaxDraftTokens; ++di)
+    {
+        handoff.addDraftLogits(0, *logits, *mManager);
+    }
+    EXPECT_THROW(handoff.addDraftLogits(0, *logits, *mManager), tensorrt_llm::common::TllmException);
+
+    // A new round starts without draft tokens
+    handoff.beginRound(0, 4);
+    EXPECT_EQ(handoff.getNumDraftTokens(0), 0);
+    auto outputIds = mManager->gpu(ITensor::makeShape({1, kMaxSeqLen}), nvinfer1::DataType::kINT32);
+    decoder_batch::Request request{outputIds, 4};
+    EXPECT_THROW(handoff.fillTargetRequest(request, 0, outputIds, false), tensorrt_llm::common::TllmException);
+
+    auto halfLogits = mManager->gpu(ITensor::makeShape({1, kVocabSizePadded}), nvinfer1::DataType::kHALF);
+    EXPECT_THROW(handoff.addDraftLogits(0, *halfLogits, *mManager), tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/encoderSession.h"
+
+using namespace tensorrt_llm::runtime;
+
+TEST(EncoderSessionTest, Buckets)
+{
+    EncoderSession::Config config;
+    config.maxBatchSize = 6;
+    config.minNumTokens = 4;
+    config.maxNumTokens = 12;
+    auto const buckets = EncoderSession::makeBuckets(config);
+
+    // Batch sizes 1, 2, 4, 6 for 4, 8 and 12 tokens, at most one sequence per token.
+    ASSERT_EQ(buckets.size(), 3 + 4 + 4);
+    EXPECT_EQ(buckets.front().batchSize, 1);
+    EXPECT_EQ(buckets.front().numTokens, 4);
+    EXPECT_EQ(buckets[2].batchSize, 4);
+    EXPECT_EQ(buckets.back().batchSize, 6);
+    EXPECT_EQ(buckets.back().numTokens, 12);
+
+    auto const selected = [&](SizeType32 batchSize, SizeType32 numTokens)
+    {
+        auto const index = EncoderSession::selectBucket(buckets, batchSize, numTokens);
+        EXPECT_TRUE(index.has_value());
+        return buckets[index.value()];
+    };
+    EXPECT_EQ(selected(1, 4).numTokens, 4);
+    EXPECT_EQ(selected(3, 3).batchSize, 4);
+    EXPECT_EQ(selected(3, 3).numTokens, 4);
+    // Padding to 4 sequences takes one token more than the bucket of 4 tokens has.
+    EXPECT_EQ(selected(3, 4).numTokens, 8);
+    EXPECT_EQ(selected(5, 11).batchSize, 6);
+
+    EXPECT_FALSE(EncoderSession::selectBucket(buckets, 7, 7).has_value());
+    EXPECT_FALSE(EncoderSession::selectBucket(buckets, 1, 13).has_value());
+    EXPECT_FALSE(EncoderSession::selectBucket(buckets, 6, 13).has_value());
+    EXPECT_FALSE(EncoderSession::selectBucket(buckets, 0, 0).has_value());
+}
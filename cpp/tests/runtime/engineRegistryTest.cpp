@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/engineRegistry.h"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(EngineRegistryTest, HashEngine)
+{
+    std::string const engine(1001, 'x');
+    auto other = engine;
+    other.back() = 'y';
+    EXPECT_EQ(hashEngine(engine.data(), engine.size()), hashEngine(engine.data(), engine.size()));
+    EXPECT_NE(hashEngine(engine.data(), engine.size()), hashEngine(other.data(), other.size()));
+    EXPECT_NE(hashEngine(engine.data(), engine.size()), hashEngine(engine.data(), engine.size() - 1));
+}
+
+TEST(EngineRegistryTest, SharesLiveEngines)
+{
+    BasicEngineRegistry<int> registry;
+    std::atomic<int> numCreated{0};
+    auto factory = [&numCreated]()
+    {
+        ++numCreated;
+        return std::make_shared<int>(42);
+    };
+
+    auto first = registry.getOrCreate(1, factory);
+    auto second = registry.getOrCreate(1, factory);
+    EXPECT_EQ(first, second);
+    EXPECT_EQ(numCreated, 1);
+    auto third = registry.getOrCreate(2, factory);
+    EXPECT_NE(first, third);
+    EXPECT_EQ(registry.getNumEngines(), 2);
+
+    first.reset();
+    second.reset();
+    EXPECT_EQ(registry.getNumEngines(), 1);
+    // Deserialized again once all users released it.
+    auto fourth = registry.getOrCreate(1, factory);
+    EXPECT_EQ(numCreated, 3);
+
+    EXPECT_THROW(registry.getOrCreate(3, []() { return std::shared_ptr<int>{}; }), std::exception);
+}
+
+TEST(EngineRegistryTest, ConcurrentLoadsDeserializeOnce)
+{
+    BasicEngineRegistry<int> registry;
+    std::atomic<int> numCreated{0};
+    std::vector<std::shared_ptr<int>> engines(8);
+    std::vector<std::thread> threads;
+    for (auto& engine : engines)
+    {
+        threads.emplace_back(
+            [&registry, &numCreated, &engine]()
+            {
+                engine = registry.getOrCreate(7,
+                    [&numCreated]()
+                    {
+                        ++numCreated;
+                        return std::make_shared<int>(0);
+                    });
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(numCreated, 1);
+    for (auto const& engine : engines)
+    {
+        EXPECT_EQ(engine, engines.front());
+    }
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/finishedSyncPolicy.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// The generation loop of GptSession without a GPU. The check of step s reads the finished state of decoder step s - 1,
+// whose results are available `lag` steps after it was enqueued: a blocking check waits for them, a polling check only
+// reads them if they are available and otherwise lets the loop enqueue step s. The decoder finishes all sequences at
+// step `finishedStep`, and at the latest at the last step that fits the maximum sequence length.
+class FinishedSyncPolicyTest : public ::testing::Test
+{
+protected:
+    struct Run
+    {
+        // Step whose check stopped the loop, the engine ran steps 1 to stopStep - 1
+        SizeType32 stopStep;
+        std::vector<SizeType32> blockingSteps;
+    };
+
+    //! \brief Last generation step of a sequence, the context step generates the first token.
+    static SizeType32 getLastStep()
+    {
+        return kMaxSeqLength - kMaxInputLength - 1;
+    }
+
+    static Run run(FinishedSyncPolicy const& policy, SizeType32 finishedStep, SizeType32 lag,
+        bool gatherGenerationLogits = false)
+    {
+        finishedStep = std::min(finishedStep, getLastStep());
+        Run run{};
+        for (SizeType32 step = 1; step < 10 * kMaxSeqLength; ++step)
+        {
+            auto const decoderStep = step - 1;
+            auto const blocking = policy.isBlocking(step, kMaxInputLength, kMaxSeqLength, gatherGenerationLogits);
+            if (blocking)
+            {
+                run.blockingSteps.push_back(step);
+            }
+            auto const available = blocking || lag <= 1;
+            if (available && decoderStep >= finishedStep)
+            {
+                run.stopStep = step;
+                return run;
+            }
+        }
+        ADD_FAILURE() << "The loop doesn't stop";
+        return run;
+    }
+
+    static constexpr SizeType32 kMaxInputLength{10};
+    static constexpr SizeType32 kMaxSeqLength{42};
+};
+
+} // namespace
+
+TEST_F(FinishedSyncPolicyTest, IntervalOneAlwaysBlocks)
+{
+    FinishedSyncPolicy const policy{};
+    EXPECT_FALSE(policy.isPolling());
+    for (SizeType32 lag : {0, 1, 3})
+    {
+        SCOPED_TRACE("lag " + std::to_string(lag));
+        auto const result = run(policy, 7, lag);
+        EXPECT_EQ(result.stopStep, 8);
+        EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{1, 2, 3, 4, 5, 6, 7, 8}));
+    }
+}
+
+TEST_F(FinishedSyncPolicyTest, BlocksEveryInterval)
+{
+    FinishedSyncPolicy const policy{4};
+    EXPECT_TRUE(policy.isPolling());
+    EXPECT_EQ(policy.getInterval(), 4);
+
+    // The decoder lags behind, the loop runs ahead until the next blocking check
+    auto result = run(policy, 7, 3);
+    EXPECT_EQ(result.stopStep, 8);
+    EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{4, 8}));
+    result = run(policy, 9, 3);
+    EXPECT_EQ(result.stopStep, 12);
+    EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{4, 8, 12}));
+
+    // The decoder keeps up, a polling check reads the finished state without waiting
+    result = run(policy, 9, 1);
+    EXPECT_EQ(result.stopStep, 10);
+    EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{4, 8}));
+}
+
+TEST_F(FinishedSyncPolicyTest, RunsAtMostOneIntervalAhead)
+{
+    for (SizeType32 interval : {2, 3, 5, 16})
+    {
+        FinishedSyncPolicy const policy{interval};
+        for (SizeType32 finishedStep = 1; finishedStep <= getLastStep(); ++finishedStep)
+        {
+            SCOPED_TRACE("interval " + std::to_string(interval) + ", finished at " + std::to_string(finishedStep));
+            auto const result = run(policy, finishedStep, 8);
+            EXPECT_GT(result.stopStep, finishedStep);
+            EXPECT_LE(result.stopStep, finishedStep + interval);
+        }
+    }
+}
+
+TEST_F(FinishedSyncPolicyTest, BlocksCloseToMaxSeqLength)
+{
+    // With an interval longer than the sequence, only the last checks block: the loop stops right after the last step
+    // that fits the KV cache and the output buffers
+    FinishedSyncPolicy const policy{1000};
+    auto const result = run(policy, getLastStep(), 8);
+    EXPECT_EQ(result.stopStep, getLastStep() + 1);
+    EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{getLastStep(), getLastStep() + 1}));
+
+    // Sequences that would run past the maximum length are finished by the decoder at the last step
+    EXPECT_EQ(run(policy, 2 * kMaxSeqLength, 8).stopStep, getLastStep() + 1);
+    EXPECT_TRUE(policy.isBlocking(getLastStep() + 5, kMaxInputLength, kMaxSeqLength, false));
+    EXPECT_FALSE(policy.isBlocking(getLastStep() - 1, kMaxInputLength, kMaxSeqLength, false));
+}
+
+TEST_F(FinishedSyncPolicyTest, GenerationLogitsAlwaysBlock)
+{
+    FinishedSyncPolicy const policy{4};
+    auto const result = run(policy, 5, 3, true);
+    EXPECT_EQ(result.stopStep, 6);
+    EXPECT_EQ(result.blockingSteps, (std::vector<SizeType32>{1, 2, 3, 4, 5, 6}));
+}
+
+TEST_F(FinishedSyncPolicyTest, IntervalMustBePositive)
+{
+    EXPECT_THROW(FinishedSyncPolicy{0}, tensorrt_llm::common::TllmException);
+    EXPECT_THROW(FinishedSyncPolicy{-2}, tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tensorrt_llm/runtime/fusionBarrierReport.h"
+#include "tensorrt_llm/common/tllmException.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(FusionBarrierReportTest, MeasuresPluginBoundaries)
+{
+    auto const engineInformation = R"({"Layers": [
+        {"Name": "embedding", "LayerType": "Gather",
+         "Inputs": [{"Dimensions": [-1], "Format/Datatype": "Int32"}],
+         "Outputs": [{"Dimensions": [-1, 1024], "Format/Datatype": "Row major linear FP16 format"}]},
+        {"Name": "identity_plugin", "LayerType": "PluginV2",
+         "Inputs": [{"Dimensions": [-1, 1024], "Format/Datatype": "Row major linear FP16 format"}],
+         "Outputs": [{"Dimensions": [-1, 1024], "Format/Datatype": "Row major linear FP16 format"}]},
+        {"Name": "attention", "LayerType": "PluginV2",
+         "Inputs": [{"Dimensions": [-1, 3072], "Format/Datatype": "Row major linear FP16 format"},
+                    {"Dimensions": [-1], "Format/Datatype": "Int32"}],
+         "Outputs": [{"Dimensions": [-1, 1024], "Format/Datatype": "Row major linear FP32 format"}]}
+    ]})";
+
+    FusionBarrierReport const report{engineInformation};
+    EXPECT_TRUE(report.isDetailed());
+    EXPECT_EQ(report.getNbLayers(), 3);
+    auto const& barriers = report.getBarriers();
+    ASSERT_EQ(barriers.size(), 2);
+
+    // Sorted by traffic
+    EXPECT_EQ(barriers[0].name, "attention");
+    EXPECT_FALSE(barriers[0].isNoOp);
+    EXPECT_EQ(barriers[0].inputBytesPerToken, 3072 * 2 + 4);
+    EXPECT_EQ(barriers[0].outputBytesPerToken, 1024 * 4);
+    EXPECT_EQ(barriers[1].name, "identity_plugin");
+    EXPECT_TRUE(barriers[1].isNoOp);
+    EXPECT_EQ(barriers[1].getBytesPerToken(), 2 * 1024 * 2);
+    EXPECT_EQ(report.getTotalBytesPerToken(), barriers[0].getBytesPerToken() + barriers[1].getBytesPerToken());
+
+    auto const text = report.report(1);
+    EXPECT_NE(text.find("attention"), std::string::npos);
+    // No-op plugins are always listed
+    EXPECT_NE(text.find("identity_plugin"), std::string::npos);
+}
+
+TEST(FusionBarrierReportTest, FindsPluginsByName)
+{
+    FusionBarrierReport const report{R"({"Layers": ["embedding", "PLUGIN_V2_GPTAttention_0", "lm_head"]})"};
+    EXPECT_FALSE(report.isDetailed());
+    EXPECT_EQ(report.getNbLayers(), 3);
+    ASSERT_EQ(report.getBarriers().size(), 1);
+    EXPECT_EQ(report.getBarriers()[0].name, "PLUGIN_V2_GPTAttention_0");
+    EXPECT_EQ(report.getTotalBytesPerToken(), 0.);
+
+    EXPECT_THROW(FusionBarrierReport{"not json"}, tensorrt_llm::common::TllmException);
+}
@@ -18,8 +18,10 @@
 #include <gtest/gtest.h>
 
 #include "tensorrt_llm/common/memoryUtils.h"
+#include "tensorrt_llm/common/tllmException.h"
 #include "tensorrt_llm/executor/types.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/decodingModeGroups.h"
 #include "tensorrt_llm/runtime/gptDecoderBatch.h"
 #include "tensorrt_llm/runtime/modelConfig.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
@@ -251,7 +253,7 @@ void testDecoder(nvinfer1::DataType const dtype, std::vector<SamplingConfig>& sa
     // set up decoder
     auto decoder = GptDecoderBatch(vocabSize, vocabSizePadded, streamPtr, modelConfig.getSpeculativeDecodingMode());
     decoder.setup(decodingMode, batchSize, maxBeamWidth, maxAttentionWindow, sinkTokenLength, maxSeqLength,
-        maxGeneratedTokensPerStep, false, dataType, modelConfig);
+        maxGeneratedTokensPerStep, true, dataType, modelConfig);
 
     std::vector<SizeType32> seqSlots;
     std::vector<decoder_batch::Request> decoderRequests;
@@ -370,7 +372,7 @@ void testDecoderWavefront(nvinfer1::DataType const dtype, std::vector<SamplingCo
     // set up decoder
     auto decoder = GptDecoderBatch(vocabSize, vocabSizePadded, streamPtr, modelConfig.getSpeculativeDecodingMode());
     decoder.setup(decodingMode, batchSize, maxBeamWidth, maxAttentionWindow, sinkTokenLength, maxSeqLength,
-        maxGeneratedTokensPerStep, false, dataType, modelConfig);
+        maxGeneratedTokensPerStep, true, dataType, modelConfig);
 
     std::vector<SizeType32> expectedSteps(batchSize, 0);
     auto expectedLengths = tiledInputLengths;
@@ -661,3 +663,160 @@ INSTANTIATE_TEST_SUITE_P(DecoderTest, ParamDraftTest,
         }
         return name;
     });
+
+TEST(GptDecoderBatchTest, RejectsUnfusedDecoder)
+{
+    auto streamPtr = std::make_shared<CudaStream>();
+    SizeType32 constexpr vocabSize{51200};
+    ModelConfig modelConfig{vocabSize, 2, 0, 16, 1024, nvinfer1::DataType::kFLOAT};
+    modelConfig.useGptAttentionPlugin(false);
+    auto decoder = GptDecoderBatch(vocabSize, vocabSize, streamPtr, modelConfig.getSpeculativeDecodingMode());
+    EXPECT_THROW(decoder.setup(tle::DecodingMode::TopKTopP(), 2, 1, 8, 0, 8, 1, false, nvinfer1::DataType::kFLOAT,
+                     modelConfig),
+        tensorrt_llm::common::TllmException);
+}
+
+namespace
+{
+void testDecoderModeGroups(nvinfer1::DataType const dtype, std::vector<tle::DecodingMode> const& requestModes)
+{
+    TLLM_LOG_TRACE("%s start", __PRETTY_FUNCTION__);
+    SizeType32 constexpr tensorParallelism{1};
+    SizeType32 constexpr pipelineParallelism{1};
+    SizeType32 constexpr localRank{0};
+    WorldConfig const worldConfig{tensorParallelism, pipelineParallelism, localRank};
+
+    SizeType32 constexpr vocabSize{51200};
+    SizeType32 constexpr nbAttentionLayers{2};
+    SizeType32 constexpr nbRnnLayers{0};
+    SizeType32 constexpr nbHeads{16};
+    SizeType32 constexpr hiddenSize{1024};
+    ModelConfig modelConfig{vocabSize, nbAttentionLayers, nbRnnLayers, nbHeads, hiddenSize, dtype};
+    modelConfig.useGptAttentionPlugin(false);
+
+    auto streamPtr = std::make_shared<CudaStream>();
+    BufferManager manager(streamPtr);
+
+    TokenIdType constexpr endId{50257};
+    TokenIdType constexpr padId{50257};
+
+    auto const dataType = modelConfig.getDataType();
+    auto const vocabSizePadded = modelConfig.getVocabSizePadded(worldConfig.getSize());
+
+    auto const batchSize = static_cast<SizeType32>(requestModes.size());
+    SizeType32 constexpr maxBeamWidth{1};
+    SizeType32 constexpr maxInputLength{8};
+    SizeType32 const maxNewTokens{2};
+    auto const maxSeqLength = maxInputLength + maxNewTokens;
+    SizeType32 constexpr maxGeneratedTokensPerStep{1};
+
+    std::vector<SamplingConfig> samplingConfigs(batchSize, SamplingConfig{maxBeamWidth});
+    std::vector<SizeType32> inputLengths(batchSize);
+    std::iota(inputLengths.begin(), inputLengths.end(), 4);
+    std::vector<SizeType32> generatedTokensPerSteps(batchSize, maxGeneratedTokensPerStep);
+    std::vector<SizeType32> acceptedTokensPerStep(batchSize, maxGeneratedTokensPerStep - 1);
+
+    auto constexpr tokenId = 1;
+    auto requests = prepareRequests(batchSize, maxNewTokens, inputLengths, generatedTokensPerSteps,
+        acceptedTokensPerStep, tokenId, endId, padId, manager);
+
+    auto inputs = prepareDecoderInputs(batchSize, maxBeamWidth, maxSeqLength, vocabSizePadded, dataType,
+        samplingConfigs, generatedTokensPerSteps, false, manager);
+    auto outputs = prepareDecoderOutputs(batchSize, maxBeamWidth, maxSeqLength, inputLengths, manager);
+
+    auto const maxAttentionWindow = maxSeqLength;
+    SizeType32 const sinkTokenLength{0};
+
+    // one decoder per group, set up with the mode of the group
+    DecodingModeGroups groups{requestModes, batchSize};
+    std::vector<std::unique_ptr<GptDecoderBatch>> decoders;
+    for (auto const& mode : groups.getModes())
+    {
+        decoders.emplace_back(std::make_unique<GptDecoderBatch>(
+            vocabSize, vocabSizePadded, streamPtr, modelConfig.getSpeculativeDecodingMode()));
+        decoders.back()->setup(mode, batchSize, maxBeamWidth, maxAttentionWindow, sinkTokenLength, maxSeqLength,
+            maxGeneratedTokensPerStep, true, dataType, modelConfig);
+    }
+
+    std::vector<SizeType32> seqSlots(batchSize);
+    std::iota(seqSlots.begin(), seqSlots.end(), 0);
+    for (auto const slot : seqSlots)
+    {
+        groups.setSlotMode(slot, requestModes[slot]);
+    }
+    auto const groupIndices = groups.splitSlots(seqSlots);
+    for (SizeType32 gi = 0; gi < groups.getNumGroups(); ++gi)
+    {
+        std::vector<SizeType32> groupSlots;
+        std::vector<decoder_batch::Request> groupRequests;
+        std::vector<SamplingConfig> groupSamplingConfigs;
+        for (auto const i : groupIndices[gi])
+        {
+            groupSlots.push_back(seqSlots[i]);
+            groupRequests.push_back(requests[i]);
+            groupSamplingConfigs.push_back(samplingConfigs[i]);
+        }
+        decoders[gi]->newRequests(groupSlots, groupRequests, groupSamplingConfigs);
+    }
+    cudaDeviceSynchronize();
+
+    auto expectedLengths = inputLengths;
+    checkSequenceLengths(*outputs.sequenceLengths, expectedLengths, manager);
+
+    std::vector<bool> const active(batchSize, true);
+    for (SizeType32 si = 0; si < maxNewTokens; ++si)
+    {
+        // the slots of the groups are disjoint, so the decoders share the sequence lengths of the step
+        for (SizeType32 gi = 0; gi < groups.getNumGroups(); ++gi)
+        {
+            if (!groups.hasActive(gi, active))
+            {
+                continue;
+            }
+            auto groupInputs = inputs;
+            groupInputs.active = groups.getActive(gi, active);
+            decoders[gi]->forward(outputs, groupInputs);
+        }
+
+        advanceSequenceLengths(expectedLengths, acceptedTokensPerStep, samplingConfigs, batchSize, maxBeamWidth);
+        checkSequenceLengths(*outputs.sequenceLengths, expectedLengths, manager);
+    }
+
+    // every slot is decoded by the decoder of its group only
+    for (SizeType32 bi = 0; bi < batchSize; ++bi)
+    {
+        auto const& decoder = *decoders[groups.getGroup(bi)];
+        EXPECT_TRUE(decoder.getFinished()[bi]) << "slot " << bi;
+        auto outputIds = manager.copyFrom(*decoder.getOutputIds(bi), MemoryType::kCPU);
+        manager.getStream().synchronize();
+        auto const ids = BufferRange<TokenIdType>(*outputIds);
+        ASSERT_EQ(ids.size(), maxSeqLength);
+        EXPECT_THAT(std::vector(ids.begin(), ids.begin() + inputLengths[bi]), ::testing::Each(tokenId));
+        EXPECT_THAT(std::vector(ids.begin() + inputLengths[bi], ids.begin() + expectedLengths[bi]),
+            ::testing::Each(1023));
+        EXPECT_THAT(std::vector(ids.begin() + expectedLengths[bi], ids.end()), ::testing::Each(padId));
+    }
+    for (SizeType32 gi = 0; gi < groups.getNumGroups(); ++gi)
+    {
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            // slots of other groups were never set up in this decoder
+            if (groups.getGroup(bi) != gi)
+            {
+                EXPECT_TRUE(decoders[gi]->getFinished()[bi]) << "group " << gi << " slot " << bi;
+            }
+        }
+    }
+}
+} // namespace
+
+TEST(GptDecoderBatchTest, DecodingModeGroups)
+{
+    auto const topKTopP = tle::DecodingMode::TopKTopP();
+    auto const topKNoPenalties = tle::DecodingMode::TopK().useOccurrencePenalties(false);
+    auto const batchInvariant = tle::DecodingMode::TopKTopP().useBatchInvariant(true);
+    for (auto const dtype : {nvinfer1::DataType::kFLOAT, nvinfer1::DataType::kHALF})
+    {
+        testDecoderModeGroups(dtype, {topKTopP, topKNoPenalties, batchInvariant, topKNoPenalties, topKTopP});
+    }
+}
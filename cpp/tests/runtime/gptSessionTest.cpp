@@ -156,6 +156,7 @@ struct MicroBatchSizes
 {
     std::optional<SizeType32> ctxMicroBatchSize{std::nullopt};
     std::optional<SizeType32> genMicroBatchSize{std::nullopt};
+    bool sortByInputLength{false};
 };
 } // namespace
 
@@ -300,6 +301,7 @@ void testGptSession(fs::path const& modelPath, ModelSpec const& modelSpec, Model
     sessionConfig.decoderPerRequest = modelSpec.mDecoderPerRequest;
     sessionConfig.ctxMicroBatchSize = microBatchSizes.ctxMicroBatchSize;
     sessionConfig.genMicroBatchSize = microBatchSizes.genMicroBatchSize;
+    sessionConfig.sortMicroBatchesByInputLength = microBatchSizes.sortByInputLength;
     sessionConfig.cudaGraphMode = cudaGraphMode;
     sessionConfig.kvCacheConfig.useUvm = false;
 
@@ -362,28 +364,32 @@ void testGptSession(fs::path const& modelPath, ModelSpec const& modelSpec, Model
         for (auto r = 0; r < repetitions; ++r)
         {
             SizeType32 numSteps = 0;
-            generationOutput.onTokenGenerated
-                = [&numSteps, &modelSpec, maxNewTokens](
-                      [[maybe_unused]] GenerationOutput::TensorPtr const& outputIds, SizeType32 step, bool finished)
+            // The micro batches are not sorted when a callback is set, the outputs in input order are checked below.
+            if (!microBatchSizes.sortByInputLength)
             {
-                // check that we execute the callback in each step
-                EXPECT_EQ(step, numSteps);
-                ++numSteps;
-                if (!modelSpec.mRandomEndId)
+                generationOutput.onTokenGenerated
+                    = [&numSteps, &modelSpec, maxNewTokens](
+                          [[maybe_unused]] GenerationOutput::TensorPtr const& outputIds, SizeType32 step, bool finished)
                 {
-                    // check that we only finish after producing `maxNewTokens` tokens
-                    EXPECT_TRUE(!finished || numSteps == maxNewTokens);
-                }
-                // check that `finished` is set to true after producing `maxNewTokens` tokens
-                EXPECT_TRUE(numSteps != maxNewTokens || finished);
-            };
+                    // check that we execute the callback in each step
+                    EXPECT_EQ(step, numSteps);
+                    ++numSteps;
+                    if (!modelSpec.mRandomEndId)
+                    {
+                        // check that we only finish after producing `maxNewTokens` tokens
+                        EXPECT_TRUE(!finished || numSteps == maxNewTokens);
+                    }
+                    // check that `finished` is set to true after producing `maxNewTokens` tokens
+                    EXPECT_TRUE(numSteps != maxNewTokens || finished);
+                };
+            }
 
             session.generate(generationOutput, generationInput, samplingConfig);
 
             // compare outputs
             if (worldConfig.isFirstPipelineParallelRank())
             {
-                if (!modelSpec.mRandomEndId)
+                if (!modelSpec.mRandomEndId && !microBatchSizes.sortByInputLength)
                 {
                     EXPECT_EQ(numSteps, maxNewTokens);
                 }
@@ -474,6 +480,8 @@ std::string generateTestName(testing::TestParamInfo<ParamType> const& info)
         name.append("CBS" + std::to_string(microBatcheSizes.ctxMicroBatchSize.value()));
     if (microBatcheSizes.genMicroBatchSize)
         name.append("GBS" + std::to_string(microBatcheSizes.genMicroBatchSize.value()));
+    if (microBatcheSizes.sortByInputLength)
+        name.append("Sorted");
     if (modelSpec.mPPSize > 1)
         name.append("PP" + std::to_string(modelSpec.mPPSize));
     if (modelSpec.mTPSize > 1)
@@ -593,7 +601,7 @@ INSTANTIATE_TEST_SUITE_P(GptSessionTest, ParamTest,
                 ),
         testing::Values(1, 2),        // beamWidth
         testing::Values(false, true), // cudaGraphMode
-        testing::Values(MicroBatchSizes(), MicroBatchSizes{3, 3}, MicroBatchSizes{3, 6}),
+        testing::Values(MicroBatchSizes(), MicroBatchSizes{3, 3}, MicroBatchSizes{3, 6}, MicroBatchSizes{3, 3, true}),
         testing::Values(false)        // isChatGlmTest
         ),
     generateTestName);
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/logitsGatherer.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+// Every element of row r is r
+std::vector<float> makeRows(SizeType32 numRows, SizeType32 vocabSize)
+{
+    std::vector<float> logits(numRows * vocabSize);
+    for (std::size_t i = 0; i < logits.size(); ++i)
+    {
+        logits[i] = static_cast<float>(i / vocabSize);
+    }
+    return logits;
+}
+
+std::vector<float> gatheredRows(ITensor const& gathered)
+{
+    auto const vocabSize = gathered.getShape().d[1];
+    auto const* data = bufferCast<float>(gathered);
+    std::vector<float> rows;
+    for (std::size_t i = 0; i < gathered.getSize(); i += vocabSize)
+    {
+        for (std::size_t j = i; j < i + vocabSize; ++j)
+        {
+            EXPECT_EQ(data[j], data[i]);
+        }
+        rows.push_back(data[i]);
+    }
+    return rows;
+}
+
+} // namespace
+
+TEST(LogitsGathererTest, GathersContextPositions)
+{
+    SizeType32 constexpr vocabSize{37};
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    LogitsGatherer gatherer{manager};
+
+    std::vector<SizeType32> const inputLengths{3, 5, 2};
+    auto const numTokens = std::accumulate(inputLengths.begin(), inputLengths.end(), SizeType32{0});
+    auto const packed = manager.copyFrom(
+        makeRows(numTokens, vocabSize), ITensor::makeShape({numTokens, vocabSize}), MemoryType::kGPU);
+
+    auto const rows = LogitsGatherer::getContextRows(*packed, inputLengths, 1, {0, 4});
+    EXPECT_EQ(rows, (std::vector<SizeType32>{3, 7}));
+    auto const gathered = gatherer.gather(*packed, rows, MemoryType::kCPU);
+    stream->synchronize();
+    EXPECT_EQ(gathered->getShape().d[0], 2);
+    EXPECT_EQ(gatheredRows(*gathered), (std::vector<float>{3.f, 7.f}));
+
+    // Padded to the longest prompt
+    SizeType32 constexpr maxInputLength{5};
+    auto const batchSize = static_cast<SizeType32>(inputLengths.size());
+    auto const padded = manager.copyFrom(makeRows(batchSize * maxInputLength, vocabSize),
+        ITensor::makeShape({batchSize, maxInputLength, vocabSize}), MemoryType::kGPU);
+    auto const lastRows = LogitsGatherer::getLastContextRows(*padded, inputLengths, 2, 3);
+    EXPECT_EQ(lastRows, (std::vector<SizeType32>{10, 11}));
+    auto const lastGathered = gatherer.gather(*padded, lastRows, MemoryType::kCPU);
+    stream->synchronize();
+    EXPECT_EQ(gatheredRows(*lastGathered), (std::vector<float>{10.f, 11.f}));
+
+    EXPECT_THROW(static_cast<void>(LogitsGatherer::getContextRows(*packed, inputLengths, 2, {2})), std::exception);
+}
+
+TEST(LogitsGathererTest, GathersGenerationSteps)
+{
+    SizeType32 constexpr batchSize{2};
+    SizeType32 constexpr beamWidth{2};
+    SizeType32 constexpr maxOutputLength{4};
+    SizeType32 constexpr vocabSize{16};
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    LogitsGatherer gatherer{manager};
+
+    auto const logits = manager.copyFrom(makeRows(batchSize * beamWidth * maxOutputLength, vocabSize),
+        ITensor::makeShape({batchSize, beamWidth, maxOutputLength, vocabSize}), MemoryType::kGPU);
+    auto const rows = LogitsGatherer::getGenerationRows(*logits, 1, 1, {3, 0});
+    EXPECT_EQ(rows, (std::vector<SizeType32>{15, 12}));
+    auto const gathered = gatherer.gather(*logits, rows);
+    EXPECT_EQ(gathered->getMemoryType(), MemoryType::kGPU);
+    auto const gatheredHost = manager.copyFrom(*gathered, MemoryType::kCPU);
+    stream->synchronize();
+    EXPECT_EQ(gatheredRows(*gatheredHost), (std::vector<float>{15.f, 12.f}));
+}
+
+TEST(LogitsGathererTest, ScoresContinuation)
+{
+    SizeType32 constexpr vocabSize{50};
+    SizeType32 constexpr vocabSizePadded{64};
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    LogitsGatherer gatherer{manager};
+
+    std::vector<SizeType32> const inputLengths{4, 6};
+    auto const numTokens = std::accumulate(inputLengths.begin(), inputLengths.end(), SizeType32{0});
+    std::vector<float> logitsHost(numTokens * vocabSizePadded);
+    for (std::size_t i = 0; i < logitsHost.size(); ++i)
+    {
+        auto const token = static_cast<SizeType32>(i % vocabSizePadded);
+        // The padding must not contribute to the softmax
+        logitsHost[i] = token < vocabSize ? 0.01f * static_cast<float>((i * 7) % 97) : 1e4f;
+    }
+    auto const logits
+        = manager.copyFrom(logitsHost, ITensor::makeShape({numTokens, vocabSizePadded}), MemoryType::kGPU);
+
+    // The continuation is the last 3 tokens of the second prompt
+    auto const rows = LogitsGatherer::getScoringRows(*logits, inputLengths, 1, 3);
+    EXPECT_EQ(rows, (std::vector<SizeType32>{6, 7, 8}));
+    std::vector<TokenIdType> const tokenIds{5, 49, 0};
+    auto const logProbs = gatherer.gatherLogProbs(*logits, rows, tokenIds, vocabSize, MemoryType::kCPU);
+    stream->synchronize();
+    ASSERT_EQ(logProbs->getSize(), rows.size());
+
+    auto const* logProbsData = bufferCast<float>(*logProbs);
+    for (std::size_t i = 0; i < rows.size(); ++i)
+    {
+        auto const* row = logitsHost.data() + static_cast<std::size_t>(rows[i]) * vocabSizePadded;
+        auto const maxVal = *std::max_element(row, row + vocabSize);
+        double sum = 0.;
+        for (SizeType32 token = 0; token < vocabSize; ++token)
+        {
+            sum += std::exp(static_cast<double>(row[token] - maxVal));
+        }
+        auto const expected = static_cast<double>(row[tokenIds[i]] - maxVal) - std::log(sum);
+        EXPECT_NEAR(logProbsData[i], expected, 1e-4);
+    }
+
+    EXPECT_THROW(
+        static_cast<void>(gatherer.gatherLogProbs(*logits, rows, {1, 2, vocabSize}, vocabSize)), std::exception);
+}
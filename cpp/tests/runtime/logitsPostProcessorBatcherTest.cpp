@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/logitsPostProcessorBatcher.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+namespace tle = tensorrt_llm::executor;
+
+namespace
+{
+
+SizeType32 constexpr kBeamWidth{2};
+SizeType32 constexpr kVocabSize{8};
+SizeType32 constexpr kRowSize{kBeamWidth * kVocabSize};
+
+class LogitsPostProcessorBatcherTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        mStream = std::make_shared<CudaStream>();
+        mManager = std::make_unique<BufferManager>(mStream);
+    }
+
+    // Adds 100 times the slot to every logit of a request
+    LogitsPostProcessorBatcher::Callback makeBias()
+    {
+        return [this](std::vector<tle::IdType> const& requestIds, std::vector<SizeType32> const& slots,
+                   ITensor& logits, LogitsPostProcessorBatcher::BeamTokensRefs const&, CudaStream const& stream)
+        {
+            ++mNumCallbacks;
+            mLastSlots = slots;
+            EXPECT_EQ(logits.getShape().nbDims, 3);
+            EXPECT_EQ(logits.getShape().d[0], static_cast<SizeType32>(requestIds.size()));
+            EXPECT_EQ(logits.getShape().d[1], kBeamWidth);
+            EXPECT_EQ(logits.getShape().d[2], kVocabSize);
+            mLastData = logits.data();
+            auto host = mManager->copyFrom(logits, MemoryType::kCPU);
+            stream.synchronize();
+            auto* data = bufferCast<float>(*host);
+            for (std::size_t i = 0; i < slots.size(); ++i)
+            {
+                for (SizeType32 j = 0; j < kRowSize; ++j)
+                {
+                    data[i * kRowSize + j] += 100.f * static_cast<float>(slots[i]);
+                }
+            }
+            mManager->copy(*host, logits);
+            stream.synchronize();
+        };
+    }
+
+    std::vector<float> toHost(ITensor const& tensor)
+    {
+        std::vector<float> values(tensor.getSize());
+        mManager->copy(tensor, values.data());
+        mStream->synchronize();
+        return values;
+    }
+
+    std::shared_ptr<CudaStream> mStream;
+    std::unique_ptr<BufferManager> mManager;
+    SizeType32 mNumCallbacks{0};
+    std::vector<SizeType32> mLastSlots;
+    void const* mLastData{nullptr};
+};
+
+} // namespace
+
+TEST_F(LogitsPostProcessorBatcherTest, ViewsConsecutiveRowsInPlace)
+{
+    SizeType32 constexpr numRequests{3};
+    std::vector<float> values(numRequests * kRowSize, 1.f);
+    auto batch
+        = mManager->copyFrom(values, ITensor::makeShape({numRequests, kBeamWidth, kVocabSize}), MemoryType::kGPU);
+
+    std::vector<tle::Tensor> logits;
+    for (SizeType32 i = 0; i < numRequests; ++i)
+    {
+        logits.push_back(tle::detail::ofITensor(ITensor::slice(batch, i, 1)));
+    }
+    tle::BeamTokens const tokens(kBeamWidth);
+    LogitsPostProcessorBatcher::BeamTokensRefs const beamTokens(numRequests, std::cref(tokens));
+
+    LogitsPostProcessorBatcher batcher{4, makeBias()};
+    auto postProcessor = batcher.getLogitsPostProcessorBatched();
+    postProcessor({10, 11, 12}, logits, beamTokens, mStream);
+
+    EXPECT_EQ(mNumCallbacks, 1);
+    EXPECT_EQ(mLastSlots, (std::vector<SizeType32>{0, 1, 2}));
+    EXPECT_EQ(mLastData, batch->data());
+    auto const result = toHost(*batch);
+    for (SizeType32 i = 0; i < numRequests; ++i)
+    {
+        EXPECT_EQ(result[i * kRowSize], 1.f + 100.f * i);
+        EXPECT_EQ(result[(i + 1) * kRowSize - 1], 1.f + 100.f * i);
+    }
+    auto const stats = batcher.getStats();
+    EXPECT_EQ(stats.numCalls, 1);
+    EXPECT_EQ(stats.numViews, 1);
+    EXPECT_EQ(stats.numGathers, 0);
+}
+
+TEST_F(LogitsPostProcessorBatcherTest, GathersAndScattersSeparateRows)
+{
+    std::vector<ITensor::SharedPtr> rows;
+    std::vector<tle::Tensor> logits;
+    for (SizeType32 i = 0; i < 2; ++i)
+    {
+        std::vector<float> const values(kRowSize, static_cast<float>(i));
+        rows.push_back(mManager->copyFrom(values, ITensor::makeShape({kBeamWidth, kVocabSize}), MemoryType::kGPU));
+    }
+    // Not in the order of the buffers
+    logits.push_back(tle::detail::ofITensor(rows[1]));
+    logits.push_back(tle::detail::ofITensor(rows[0]));
+    tle::BeamTokens const tokens(kBeamWidth);
+    LogitsPostProcessorBatcher::BeamTokensRefs const beamTokens(2, std::cref(tokens));
+
+    LogitsPostProcessorBatcher batcher{4, makeBias()};
+    batcher({20, 21}, logits, beamTokens, mStream);
+
+    EXPECT_EQ(mLastSlots, (std::vector<SizeType32>{0, 1}));
+    EXPECT_NE(mLastData, rows[1]->data());
+    EXPECT_EQ(toHost(*rows[1]), std::vector<float>(kRowSize, 1.f));
+    EXPECT_EQ(toHost(*rows[0]), std::vector<float>(kRowSize, 100.f));
+    EXPECT_EQ(batcher.getStats().numGathers, 1);
+}
+
+TEST_F(LogitsPostProcessorBatcherTest, KeepsSlotsUntilReleased)
+{
+    std::vector<float> values(3 * kRowSize, 0.f);
+    auto batch = mManager->copyFrom(values, ITensor::makeShape({3, kBeamWidth, kVocabSize}), MemoryType::kGPU);
+    auto const makeLogits = [&batch](SizeType32 numRequests)
+    {
+        std::vector<tle::Tensor> logits;
+        for (SizeType32 i = 0; i < numRequests; ++i)
+        {
+            logits.push_back(tle::detail::ofITensor(ITensor::slice(batch, i, 1)));
+        }
+        return logits;
+    };
+    tle::BeamTokens const tokens(kBeamWidth);
+    LogitsPostProcessorBatcher::BeamTokensRefs const beamTokens(3, std::cref(tokens));
+    LogitsPostProcessorBatcher::BeamTokensRefs const twoBeamTokens(2, std::cref(tokens));
+
+    LogitsPostProcessorBatcher batcher{2, makeBias()};
+    auto logits = makeLogits(2);
+    batcher({1, 2}, logits, twoBeamTokens, mStream);
+    EXPECT_EQ(batcher.getNumUsedSlots(), 2);
+
+    // The slots follow the requests, not their position in the batch
+    batcher({2, 1}, logits, twoBeamTokens, mStream);
+    EXPECT_EQ(mLastSlots, (std::vector<SizeType32>{1, 0}));
+
+    // All slots are used
+    logits = makeLogits(3);
+    EXPECT_THROW(batcher({1, 2, 3}, logits, beamTokens, mStream), tensorrt_llm::common::TllmException);
+    EXPECT_EQ(batcher.getNumUsedSlots(), 2);
+
+    batcher.release(1);
+    batcher.release(42);
+    EXPECT_EQ(batcher.getSlot(1), -1);
+    logits = makeLogits(2);
+    batcher({3, 2}, logits, twoBeamTokens, mStream);
+    EXPECT_EQ(mLastSlots, (std::vector<SizeType32>{0, 1}));
+    EXPECT_EQ(batcher.getSlot(3), 0);
+}
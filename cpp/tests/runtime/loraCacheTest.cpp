@@ -20,8 +20,10 @@
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/loraCachePageManagerConfig.h"
 #include "tensorrt_llm/runtime/loraModule.h"
+#include "tensorrt_llm/runtime/loraPrefetcher.h"
 #include "tensorrt_llm/runtime/loraUtils.h"
 #include "tensorrt_llm/runtime/utils/numpyUtils.h"
+#include "tensorrt_llm/runtime/workStealingPool.h"
 #include "tensorrt_llm/runtime/worldConfig.h"
 
 #include <NvInferRuntime.h>
@@ -30,8 +32,11 @@
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
+#include <atomic>
 #include <filesystem>
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace fs = std::filesystem;
 
@@ -356,6 +361,113 @@ TEST_F(LoraCacheTest, basicPutGet)
     }
 }
 
+TEST_F(LoraCacheTest, prefetchFromDisk)
+{
+    auto const adapterDir = fs::temp_directory_path() / "loraPrefetcherTest";
+    fs::create_directories(adapterDir / "1234");
+    fs::copy_file(TEST_SOURCE_LORA_TP2, adapterDir / "1234" / LoraPrefetcher::kWeightsFileName,
+        fs::copy_options::overwrite_existing);
+    fs::copy_file(TEST_KEYS_LORA_TP2, adapterDir / "1234" / LoraPrefetcher::kConfigFileName,
+        fs::copy_options::overwrite_existing);
+
+    {
+        LoraPrefetcher prefetcher(*mLoraCache, adapterDir, std::make_shared<WorkStealingPool>(1));
+        EXPECT_FALSE(prefetcher.prefetch(5678));
+        EXPECT_TRUE(prefetcher.prefetch(1234));
+        prefetcher.wait(1234);
+        EXPECT_TRUE(prefetcher.isReady(1234));
+        // Prefetched tasks can be evicted until they are put
+        EXPECT_TRUE(mLoraCache->isDone(1234));
+    }
+
+    TensorPtr loraReqWeights = utils::loadNpy(*mManager, TEST_SOURCE_LORA_TP2.string(), MemoryType::kCPU);
+    TensorPtr loraReqKeys = utils::loadNpy(*mManager, TEST_KEYS_LORA_TP2.string(), MemoryType::kCPU);
+    mLoraCache->put(1234, loraReqWeights, loraReqKeys);
+    EXPECT_FALSE(mLoraCache->isDone(1234));
+
+    mLoraCache2->put(1234, loraReqWeights, loraReqKeys);
+    auto const& values = *mLoraCache->get(1234);
+    auto const& expectedValues = *mLoraCache2->get(1234);
+    ASSERT_EQ(values.size(), expectedValues.size());
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        EXPECT_EQ(values.at(i), expectedValues.at(i));
+    }
+
+    auto const pagePtr = bufferCast<float>(*mLoraCache->getPagePtr(0));
+    auto const expectedPage = mManager->copyFrom(*mLoraCache2->getPagePtr(0), MemoryType::kCPU);
+    mStream->synchronize();
+    auto const expectedPagePtr = bufferCast<float>(*expectedPage);
+    for (std::size_t i = 0; i < expectedPage->getSize(); ++i)
+    {
+        EXPECT_FLOAT_EQ(pagePtr[i], expectedPagePtr[i]);
+    }
+    fs::remove_all(adapterDir);
+}
+
+TEST_F(LoraCacheTest, concurrentLookupsDuringPutAndEvict)
+{
+    TensorPtr loraReqWeights = utils::loadNpy(*mManager, TEST_SOURCE_LORA_TP2.string(), MemoryType::kCPU);
+    TensorPtr loraReqKeys = utils::loadNpy(*mManager, TEST_KEYS_LORA_TP2.string(), MemoryType::kCPU);
+
+    // has, isLoaded and isDone look tasks up without the cache mutex while the main thread puts tasks and evicts the
+    // done ones to make room for them. The task in progress is never evicted and must be found all along.
+    LoraCache::TaskIdType constexpr pinnedTaskId = 1234;
+    LoraCache::TaskIdType constexpr numTasks = 64;
+    SizeType32 constexpr numReaders = 4;
+    mLoraCache->put(pinnedTaskId, loraReqWeights, loraReqKeys);
+
+    std::atomic<bool> stop{false};
+    std::atomic<SizeType32> numMissed{0};
+    std::vector<std::thread> readers;
+    for (SizeType32 r = 0; r < numReaders; ++r)
+    {
+        readers.emplace_back(
+            [&]()
+            {
+                while (!stop.load())
+                {
+                    if (!mLoraCache->has(pinnedTaskId) || !mLoraCache->isLoaded(pinnedTaskId)
+                        || mLoraCache->isDone(pinnedTaskId))
+                    {
+                        ++numMissed;
+                    }
+                    for (LoraCache::TaskIdType taskId = 0; taskId < numTasks; ++taskId)
+                    {
+                        static_cast<void>(mLoraCache->has(taskId));
+                        static_cast<void>(mLoraCache->isLoaded(taskId));
+                        static_cast<void>(mLoraCache->isDone(taskId));
+                    }
+                }
+            });
+    }
+
+    for (LoraCache::TaskIdType taskId = 0; taskId < numTasks; ++taskId)
+    {
+        mLoraCache->put(taskId, loraReqWeights, loraReqKeys);
+        EXPECT_TRUE(mLoraCache->has(taskId));
+        EXPECT_TRUE(mLoraCache->isLoaded(taskId));
+        mLoraCache->markTaskDone(taskId);
+    }
+    stop = true;
+    for (auto& reader : readers)
+    {
+        reader.join();
+    }
+
+    EXPECT_EQ(numMissed.load(), 0);
+    // The evicted tasks are gone from the index as well, the last ones put are still cached
+    SizeType32 numCached = 0;
+    for (LoraCache::TaskIdType taskId = 0; taskId < numTasks; ++taskId)
+    {
+        EXPECT_EQ(mLoraCache->has(taskId), mLoraCache->isLoaded(taskId)) << "task " << taskId;
+        numCached += mLoraCache->has(taskId) ? 1 : 0;
+    }
+    EXPECT_TRUE(mLoraCache->has(numTasks - 1));
+    EXPECT_GT(numCached, 0);
+    EXPECT_LT(numCached, numTasks);
+}
+
 TEST_F(LoraCacheTest, splitTransposeCpu)
 {
     auto modelConfig = ModelConfig(0, 2, 0, 1, 16, nvinfer1::DataType::kFLOAT);
@@ -419,6 +531,40 @@ TEST_F(LoraCacheTest, splitTransposeCpu)
     }
 }
 
+TEST_F(LoraCacheTest, splitTransposeGpu)
+{
+    SizeType32 const split{2};
+    SizeType32 const batchSize{3};
+    std::vector<std::int32_t> const input{28524, 287, 5093, 12, 23316, 4881, 11, 30022, 263, 8776, 355, 257};
+    auto const inputLength = static_cast<SizeType32>(input.size() / batchSize);
+    auto const inputShape = ITensor::makeShape({batchSize, inputLength});
+    auto const outputShape = ITensor::makeShape({batchSize, inputLength / split});
+
+    auto inputTensor = mManager->copyFrom(input, inputShape, MemoryType::kCPU);
+    auto inputTensorGpu = mManager->copyFrom(input, inputShape, MemoryType::kGPU);
+    for (SizeType32 rank = 0; rank < split; ++rank)
+    {
+        auto expected = mManager->cpu(outputShape, nvinfer1::DataType::kINT32);
+        LoraCache::splitTransposeCpu(*expected, *inputTensor, split, rank);
+
+        // Device to device and host to device
+        for (ITensor const* source : {inputTensorGpu.get(), inputTensor.get()})
+        {
+            auto outputTensorGpu = mManager->gpu(outputShape, nvinfer1::DataType::kINT32);
+            LoraCache::splitTranspose(*outputTensorGpu, *source, split, rank, *mManager);
+            auto outputTensor = mManager->copyFrom(*outputTensorGpu, MemoryType::kCPU);
+            mStream->synchronize();
+
+            auto const expectedPtr = bufferCast<SizeType32>(*expected);
+            auto const outputPtr = bufferCast<SizeType32>(*outputTensor);
+            for (SizeType32 i = 0; i < static_cast<SizeType32>(expected->getSize()); ++i)
+            {
+                EXPECT_EQ(outputPtr[i], expectedPtr[i]) << "rank " << rank << " index " << i;
+            }
+        }
+    }
+}
+
 TEST_F(LoraCacheTest, copyToPages_tp1)
 {
     auto modelConfig = ModelConfig(0, 2, 0, 1, 16, nvinfer1::DataType::kFLOAT);
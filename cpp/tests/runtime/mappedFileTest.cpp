@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/mappedFile.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+namespace fs = std::filesystem;
+
+namespace
+{
+fs::path writeFile(std::vector<char> const& content)
+{
+    auto path = fs::temp_directory_path() / "mappedFileTest.bin";
+    std::ofstream os{path, std::ios::binary};
+    os.write(content.data(), static_cast<std::streamsize>(content.size()));
+    return path;
+}
+} // namespace
+
+TEST(MappedFileTest, MapsContent)
+{
+    // Not a multiple of the chunk size, so the last chunk is partial.
+    std::vector<char> content(10 * 4096 + 123);
+    std::iota(content.begin(), content.end(), 0);
+    auto const path = writeFile(content);
+    for (SizeType32 numThreads : {0, 1, 3, 64})
+    {
+        MappedFile const file{path, numThreads, 4096};
+        ASSERT_EQ(file.size(), content.size());
+        EXPECT_EQ(std::memcmp(file.data(), content.data(), content.size()), 0);
+    }
+    fs::remove(path);
+}
+
+TEST(MappedFileTest, InvalidFile)
+{
+    auto const path = fs::temp_directory_path() / "mappedFileTest_missing.bin";
+    EXPECT_THROW(MappedFile{path}, tensorrt_llm::common::TllmException);
+    auto const empty = writeFile({});
+    EXPECT_THROW(MappedFile{empty}, tensorrt_llm::common::TllmException);
+    fs::remove(empty);
+}
@@ -0,0 +1,105 @@
+/*
+ * SPDX-FileCopyrightText: Copyright (c) 2022-2024 NVIDIA CORPORATION & AFFILIATES. All rights reserved.
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryPlanner.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+auto constexpr kMiB = std::size_t{1} << 20;
+
+// 4 layers of 8 KV heads of 128, 16 KiB of fp16 KV cache per token
+ModelConfig makeModelConfig()
+{
+    ModelConfig modelConfig{32000, 4, 0, 32, 4096, nvinfer1::DataType::kHALF};
+    modelConfig.setNbKvHeads(8);
+    modelConfig.setMaxBatchSize(256);
+    modelConfig.setMaxBeamWidth(1);
+    modelConfig.setMaxInputLen(2048);
+    modelConfig.setMaxSequenceLen(4096);
+    return modelConfig;
+}
+} // namespace
+
+TEST(MemoryPlannerTest, SizesKvBlocks)
+{
+    MemoryPlanner const planner{makeModelConfig(), WorldConfig{}};
+    EXPECT_EQ(planner.getKvBytesPerBlock(nvinfer1::DataType::kHALF, 64), 4 * 2 * 8 * 128 * 64 * 2);
+    EXPECT_EQ(planner.getKvBytesPerBlock(nvinfer1::DataType::kFP8, 64), 4 * 2 * 8 * 128 * 64);
+
+    // Half the layers on a pipeline parallel rank
+    MemoryPlanner const ppPlanner{makeModelConfig(), WorldConfig{1, 2}};
+    EXPECT_EQ(ppPlanner.getKvBytesPerBlock(nvinfer1::DataType::kHALF, 64), 2 * 2 * 8 * 128 * 64 * 2);
+}
+
+TEST(MemoryPlannerTest, SharesContextBlocksBetweenBeams)
+{
+    MemoryPlanner const planner{makeModelConfig(), WorldConfig{}};
+    EXPECT_EQ(planner.getBlocksPerSequence(TrafficShape{128, 64}, 64), 3);
+    // 2 full context blocks shared, the partial block and the generated tokens per beam
+    EXPECT_EQ(planner.getBlocksPerSequence(TrafficShape{150, 64, 4}, 64), 2 + 4 * 2);
+    // Capped by the max sequence length of the engine
+    EXPECT_EQ(planner.getBlocksPerSequence(TrafficShape{4000, 4000}, 64), 64);
+}
+
+TEST(MemoryPlannerTest, SplitsFreeMemory)
+{
+    MemoryPlanner const planner{makeModelConfig(), WorldConfig{}};
+    EngineMemory const engine{1000 * kMiB, 500 * kMiB};
+    MemoryPlannerConfig config{};
+    config.gpuMemoryBytes = 10000 * kMiB;
+    config.tokensPerBlock = 64;
+    config.freeGpuMemoryFraction = 0.5f;
+    config.loraDeviceCachePercent = 0.1f;
+
+    auto const plan = planner.plan(engine, config, TrafficShape{512, 512});
+    auto const logitsBytes = std::size_t{256} * 32000 * 4;
+    EXPECT_EQ(plan.logitsBytes, logitsBytes);
+    auto const freeBytes = 8500 * kMiB - logitsBytes;
+    EXPECT_EQ(plan.kvBytesPerBlock, kMiB);
+    EXPECT_EQ(plan.numKvBlocks, static_cast<SizeType32>(freeBytes / 2 / kMiB));
+    EXPECT_EQ(plan.kvCacheBytes, plan.numKvBlocks * kMiB);
+    EXPECT_EQ(plan.loraCacheBytes, static_cast<std::size_t>(static_cast<double>(freeBytes - plan.kvCacheBytes) * 0.1f));
+    EXPECT_EQ(plan.blocksPerSequence, 16);
+    EXPECT_EQ(plan.maxBatchSize, plan.numKvBlocks / 16);
+    EXPECT_FALSE(plan.limitedByEngine);
+    EXPECT_EQ(plan.maxNumTokens, plan.numKvBlocks * 64);
+}
+
+TEST(MemoryPlannerTest, CapsBatchAtEngineLimit)
+{
+    MemoryPlanner const planner{makeModelConfig(), WorldConfig{}};
+    MemoryPlannerConfig config{};
+    config.gpuMemoryBytes = 80000 * kMiB;
+    config.tokensPerBlock = 64;
+
+    auto const plan = planner.plan(EngineMemory{1000 * kMiB, 500 * kMiB}, config, TrafficShape{64, 64});
+    EXPECT_EQ(plan.maxBatchSize, 256);
+    EXPECT_TRUE(plan.limitedByEngine);
+}
+
+TEST(MemoryPlannerTest, RejectsEngineLargerThanGpu)
+{
+    MemoryPlanner const planner{makeModelConfig(), WorldConfig{}};
+    MemoryPlannerConfig config{};
+    config.gpuMemoryBytes = 1000 * kMiB;
+    EXPECT_THROW(
+        (void) planner.plan(EngineMemory{1000 * kMiB, 500 * kMiB}, config, TrafficShape{64, 64}), std::exception);
+}
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/memoryTimeline.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+void const* address(std::uintptr_t value)
+{
+    return reinterpret_cast<void const*>(value);
+}
+} // namespace
+
+TEST(MemoryTimelineTest, AttributesFreesToTheAllocatingTag)
+{
+    MemoryTimeline timeline{16};
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kKV_CACHE};
+        EXPECT_EQ(MemoryTimeline::getCurrentTag(), MemoryTimeline::Tag::kKV_CACHE);
+        timeline.recordAllocation(MemoryType::kGPU, address(0x1000), 100);
+        {
+            MemoryTimeline::ScopedTag const nested{MemoryTimeline::Tag::kDECODER};
+            timeline.recordAllocation(MemoryType::kGPU, address(0x2000), 30);
+        }
+        EXPECT_EQ(MemoryTimeline::getCurrentTag(), MemoryTimeline::Tag::kKV_CACHE);
+        timeline.recordAllocation(MemoryType::kPINNED, address(0x3000), 50);
+    }
+    EXPECT_EQ(MemoryTimeline::getCurrentTag(), MemoryTimeline::Tag::kUNTAGGED);
+    timeline.recordFree(MemoryType::kGPU, address(0x1000), 100);
+
+    auto const events = timeline.getEvents();
+    ASSERT_EQ(events.size(), 4);
+    EXPECT_EQ(events[3].tag, MemoryTimeline::Tag::kKV_CACHE);
+    EXPECT_EQ(events[3].size, -100);
+    EXPECT_EQ(events[3].tagBytes, 0);
+
+    auto const stats = timeline.takeStats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].memoryType, MemoryType::kGPU);
+    EXPECT_EQ(stats[0].tag, MemoryTimeline::Tag::kKV_CACHE);
+    EXPECT_EQ(stats[0].currentBytes, 0);
+    EXPECT_EQ(stats[0].peakBytes, 100);
+    EXPECT_EQ(stats[0].numAllocations, 1);
+    EXPECT_EQ(stats[0].numFrees, 1);
+    EXPECT_EQ(stats[1].tag, MemoryTimeline::Tag::kDECODER);
+    EXPECT_EQ(stats[1].currentBytes, 30);
+    EXPECT_EQ(stats[2].memoryType, MemoryType::kPINNED);
+    EXPECT_EQ(stats[2].peakBytes, 50);
+
+    // Peaks restart from the current memory
+    auto const next = timeline.takeStats();
+    ASSERT_EQ(next.size(), 2);
+    EXPECT_EQ(next[0].tag, MemoryTimeline::Tag::kDECODER);
+    EXPECT_EQ(next[0].peakBytes, 30);
+    EXPECT_EQ(next[0].numAllocations, 0);
+}
+
+TEST(MemoryTimelineTest, KeepsTheLastEvents)
+{
+    MemoryTimeline timeline{3};
+    for (std::uintptr_t i = 1; i <= 5; ++i)
+    {
+        timeline.recordAllocation(MemoryType::kCPU, address(i), i);
+    }
+    EXPECT_EQ(timeline.getNumDropped(), 2);
+    auto const events = timeline.getEvents();
+    ASSERT_EQ(events.size(), 3);
+    EXPECT_EQ(events[0].size, 3);
+    EXPECT_EQ(events[2].size, 5);
+    EXPECT_EQ(events[2].tagBytes, 15);
+    EXPECT_LE(events[0].timeNs, events[2].timeNs);
+
+    auto const trace = timeline.toChromeTrace();
+    EXPECT_EQ(trace.getNumEvents(), 3);
+    EXPECT_NE(trace.toJson().find("\"name\":\"CPU untagged\",\"ph\":\"C\""), std::string::npos);
+
+    timeline.clear();
+    EXPECT_TRUE(timeline.getEvents().empty());
+    EXPECT_TRUE(timeline.takeStats().empty());
+}
+
+TEST(MemoryTimelineTest, WritesCsv)
+{
+    MemoryTimeline timeline{4};
+    timeline.recordAllocation(MemoryType::kGPU, address(0x10), 8);
+    auto const path = std::filesystem::temp_directory_path() / "memoryTimelineTest.csv";
+    timeline.writeCsv(path);
+    std::ifstream file{path};
+    std::string const contents{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    EXPECT_EQ(contents.rfind("time_us,memory_type,tag,stream,address,size,tag_bytes\n", 0), 0);
+    EXPECT_NE(contents.find(",GPU,untagged,0,"), std::string::npos);
+    std::filesystem::remove(path);
+}
+
+TEST(MemoryTimelineTest, RecordsBufferManagerAllocations)
+{
+    // The setting is read once per process
+    setenv("TRTLLM_ENABLE_MEMORY_TIMELINE", "1", 1);
+    if (!MemoryTimeline::isEnabled())
+    {
+        GTEST_SKIP() << "The memory timeline was disabled before the test";
+    }
+
+    auto& timeline = MemoryTimeline::getInstance();
+    timeline.clear();
+    {
+        MemoryTimeline::ScopedTag const tag{MemoryTimeline::Tag::kLORA};
+        auto pinned = BufferManager::pinned(ITensor::makeShape({256}), nvinfer1::DataType::kINT8);
+        auto gpu = BufferManager::gpuSync(1024, nvinfer1::DataType::kINT8);
+    }
+
+    auto const events = timeline.getEvents();
+    ASSERT_EQ(events.size(), 4);
+    for (auto const& event : events)
+    {
+        EXPECT_EQ(event.tag, MemoryTimeline::Tag::kLORA);
+    }
+    auto const stats = timeline.takeStats();
+    ASSERT_EQ(stats.size(), 2);
+    EXPECT_EQ(stats[0].memoryType, MemoryType::kGPU);
+    EXPECT_EQ(stats[0].peakBytes, 1024);
+    EXPECT_EQ(stats[0].currentBytes, 0);
+    EXPECT_EQ(stats[1].memoryType, MemoryType::kPINNED);
+    EXPECT_EQ(stats[1].peakBytes, 256);
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "tensorrt_llm/runtime/modelResidency.h"
+
+#include <gtest/gtest.h>
+
+namespace tensorrt_llm::runtime
+{
+
+TEST(ModelResidencyManager, PagesOutLeastRecentlyUsed)
+{
+    // Minimum budgets take 30 bytes, two models fit resident.
+    ModelResidencyManager manager{130};
+    for (ModelResidencyManager::ModelIdType id = 0; id < 3; ++id)
+    {
+        manager.addModel(id, 60, 10);
+    }
+    EXPECT_EQ(manager.getUsedBytes(), 30);
+
+    auto plan = manager.acquire(0);
+    ASSERT_TRUE(plan.has_value());
+    EXPECT_TRUE(plan->pageIn);
+    EXPECT_TRUE(plan->pageOut.empty());
+    manager.release(0);
+    plan = manager.acquire(1);
+    EXPECT_TRUE(plan->pageIn);
+    manager.release(1);
+    // Already resident, nothing to do.
+    plan = manager.acquire(0);
+    EXPECT_FALSE(plan->pageIn);
+    manager.release(0);
+    EXPECT_EQ(manager.getUsedBytes(), 130);
+
+    plan = manager.acquire(2);
+    ASSERT_TRUE(plan.has_value());
+    EXPECT_TRUE(plan->pageIn);
+    EXPECT_EQ(plan->pageOut, (std::vector<ModelResidencyManager::ModelIdType>{1}));
+    EXPECT_FALSE(manager.isResident(1));
+    EXPECT_EQ(manager.getUsedBytes(), 130);
+    EXPECT_EQ(manager.orderByResidency({1, 0, 2}), (std::vector<ModelResidencyManager::ModelIdType>{2, 0, 1}));
+}
+
+TEST(ModelResidencyManager, PinnedModelsStay)
+{
+    ModelResidencyManager manager{80};
+    manager.addModel(0, 60, 10);
+    manager.addModel(1, 60, 10);
+    ASSERT_TRUE(manager.acquire(0).has_value());
+    // Model 0 is in use, model 1 has to run streamed.
+    EXPECT_FALSE(manager.acquire(1).has_value());
+    manager.release(0);
+    auto const plan = manager.acquire(1);
+    ASSERT_TRUE(plan.has_value());
+    EXPECT_EQ(plan->pageOut, (std::vector<ModelResidencyManager::ModelIdType>{0}));
+    EXPECT_THROW(manager.addModel(2, 20, 20), tensorrt_llm::common::TllmException);
+}
+
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/moeLoadBalancer.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(MoeExpertLoadTrackerTest, TakeStatsClearsCounters)
+{
+    auto& tracker = MoeExpertLoadTracker::getInstance();
+    CudaStream stream;
+    auto layer = tracker.addLayer(4, 2);
+
+    std::vector<std::int64_t> const counts{3, 7};
+    TLLM_CUDA_CHECK(
+        cudaMemcpy(layer->counts->data(), counts.data(), layer->counts->getSizeInBytes(), cudaMemcpyDefault));
+
+    auto stats = tracker.takeStats(stream);
+    ASSERT_FALSE(stats.empty());
+    EXPECT_EQ(stats.back().firstExpert, 4);
+    EXPECT_EQ(stats.back().expertTokenCounts, counts);
+
+    EXPECT_EQ(stats.back().expertOverflowCounts, (std::vector<std::int64_t>{0, 0}));
+    EXPECT_EQ(stats.back().droppedRows, 0);
+
+    std::vector<std::int64_t> const overflow{1, 2, 3};
+    TLLM_CUDA_CHECK(
+        cudaMemcpy(layer->overflow->data(), overflow.data(), layer->overflow->getSizeInBytes(), cudaMemcpyDefault));
+    stats = tracker.takeStats(stream);
+    EXPECT_EQ(stats.back().expertTokenCounts, (std::vector<std::int64_t>{0, 0}));
+    EXPECT_EQ(stats.back().expertOverflowCounts, (std::vector<std::int64_t>{1, 2}));
+    EXPECT_EQ(stats.back().droppedRows, 3);
+
+    stats = tracker.takeStats(stream);
+    EXPECT_EQ(stats.back().expertOverflowCounts, (std::vector<std::int64_t>{0, 0}));
+
+    // Released layers are no longer reported
+    auto const numLayers = stats.size();
+    layer.reset();
+    EXPECT_EQ(tracker.takeStats(stream).size(), numLayers - 1);
+}
+
+TEST(ExpertReplicationPlannerTest, BalancedLoadIsNotReplicated)
+{
+    ExpertReplicationPlanner planner(8, 4, 2);
+    planner.addCounts({10, 10, 10, 10, 10, 10, 10, 10});
+    auto const plan = planner.plan();
+    for (auto const& ranks : plan.expertRanks)
+    {
+        EXPECT_EQ(ranks.size(), 1);
+    }
+    EXPECT_DOUBLE_EQ(plan.imbalance, 1.0);
+}
+
+TEST(ExpertReplicationPlannerTest, HotExpertIsSplit)
+{
+    // Expert 0 on rank 0 gets as many tokens as all the others together
+    ExpertReplicationPlanner planner(8, 4, 1);
+    planner.addCounts({70, 10, 10, 10, 10, 10, 10, 10});
+    auto const plan = planner.plan();
+
+    ASSERT_GT(plan.expertRanks[0].size(), 1);
+    EXPECT_EQ(plan.expertRanks[0].front(), 0);
+    EXPECT_LT(plan.imbalance, 80.0 / 35.0);
+    double total = 0.0;
+    for (auto const load : plan.rankLoads)
+    {
+        total += load;
+    }
+    EXPECT_DOUBLE_EQ(total, 140.0);
+}
+
+TEST(ExpertReplicationPlannerTest, NoFreeSlots)
+{
+    ExpertReplicationPlanner planner(4, 2, 0);
+    planner.addCounts({100, 0, 0, 0});
+    auto const plan = planner.plan();
+    EXPECT_EQ(plan.expertRanks[0].size(), 1);
+    EXPECT_DOUBLE_EQ(plan.imbalance, 2.0);
+}
+
+TEST(ExpertReplicationPlannerTest, MovingAverage)
+{
+    ExpertReplicationPlanner planner(2, 1, 0, 0.5);
+    planner.addCounts({4, 0});
+    planner.addCounts({0, 4});
+    EXPECT_EQ(planner.getExpertLoads(), (std::vector<double>{2.0, 2.0}));
+}
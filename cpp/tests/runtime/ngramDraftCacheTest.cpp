@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/ngramDraftCache.h"
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+NgramDraftCache::Config makeConfig(std::size_t maxNumTokens = 1024)
+{
+    NgramDraftCache::Config config;
+    config.minNgramLength = 2;
+    config.maxNgramLength = 3;
+    config.maxNumTokens = maxNumTokens;
+    return config;
+}
+
+using VecTokens = NgramDraftCache::VecTokens;
+} // namespace
+
+TEST(NgramDraftCacheTest, ProposesContinuation)
+{
+    NgramDraftCache cache{makeConfig()};
+    cache.addSequence({1, 2, 3, 4, 5, 6});
+
+    EXPECT_EQ(cache.propose({9, 2, 3}, 2), (VecTokens{4, 5}));
+    EXPECT_EQ(cache.propose({9, 2, 3}, 10), (VecTokens{4, 5, 6}));
+    // Single tokens are shorter than minNgramLength
+    EXPECT_TRUE(cache.propose({9, 3}, 2).empty());
+    EXPECT_TRUE(cache.propose({7, 8}, 2).empty());
+    // The end of a sequence has no continuation
+    EXPECT_TRUE(cache.propose({5, 6}, 2).empty());
+}
+
+TEST(NgramDraftCacheTest, PrefersLongestMatch)
+{
+    NgramDraftCache cache{makeConfig()};
+    cache.addSequence({1, 2, 3, 10, 11});
+    cache.addSequence({7, 2, 3, 20, 21});
+
+    // The most recent occurrence of [2, 3] wins, [1, 2, 3] is longer and more specific
+    EXPECT_EQ(cache.propose({2, 3}, 2), (VecTokens{20, 21}));
+    EXPECT_EQ(cache.propose({1, 2, 3}, 2), (VecTokens{10, 11}));
+}
+
+TEST(NgramDraftCacheTest, SharedAcrossInFlightSequences)
+{
+    NgramDraftCache cache{makeConfig()};
+    auto const first = cache.addSequence({1, 2});
+    auto const second = cache.addSequence({5, 1});
+    cache.appendTokens(first, {3, 4});
+
+    // The second request proposes from the output of the first one
+    EXPECT_EQ(cache.propose({5, 1, 2}, 3), (VecTokens{3, 4}));
+
+    // Its own tokens don't hide the continuation, their last n-gram is not indexed yet
+    cache.appendTokens(second, {2, 3});
+    EXPECT_EQ(cache.propose({5, 1, 2, 3}, 3), (VecTokens{4}));
+}
+
+TEST(NgramDraftCacheTest, EvictsOldestSequences)
+{
+    NgramDraftCache cache{makeConfig(10)};
+    cache.addSequence({1, 2, 3, 4});
+    cache.addSequence({5, 6, 7, 8});
+    EXPECT_EQ(cache.getNumSequences(), 2);
+    auto const third = cache.addSequence({9, 10, 11, 12});
+
+    EXPECT_EQ(cache.getNumSequences(), 2);
+    EXPECT_EQ(cache.getNumTokens(), 8);
+    EXPECT_TRUE(cache.propose({1, 2}, 2).empty());
+    EXPECT_EQ(cache.propose({5, 6}, 2), (VecTokens{7, 8}));
+
+    // The sequence being extended is kept even if it is the oldest one
+    cache.appendTokens(third, {13, 14, 15});
+    EXPECT_EQ(cache.getNumSequences(), 1);
+    EXPECT_EQ(cache.propose({12, 13}, 2), (VecTokens{14, 15}));
+}
+
+TEST(NgramDraftCacheTest, RemoveSequence)
+{
+    NgramDraftCache cache{makeConfig()};
+    auto const first = cache.addSequence({1, 2, 3, 4});
+    cache.addSequence({1, 2, 5});
+    cache.removeSequence(first);
+    cache.appendTokens(first, {6});
+
+    EXPECT_EQ(cache.getNumSequences(), 1);
+    EXPECT_EQ(cache.getNumTokens(), 3);
+    EXPECT_EQ(cache.propose({1, 2}, 2), (VecTokens{5}));
+    EXPECT_TRUE(cache.propose({2, 3}, 2).empty());
+}
+
+TEST(NgramDraftCacheTest, ConcurrentUpdates)
+{
+    NgramDraftCache cache{makeConfig(1U << 20U)};
+    SizeType32 constexpr numThreads{4};
+    SizeType32 constexpr numSteps{200};
+    std::vector<std::thread> threads;
+    for (SizeType32 thread = 0; thread < numThreads; ++thread)
+    {
+        threads.emplace_back(
+            [&cache, thread]()
+            {
+                auto const sequenceId = cache.addSequence({thread, thread});
+                for (SizeType32 step = 0; step < numSteps; ++step)
+                {
+                    cache.appendTokens(sequenceId, {step % 10});
+                    [[maybe_unused]] auto const draft = cache.propose({thread, step % 10}, 4);
+                }
+            });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(cache.getNumSequences(), numThreads);
+    EXPECT_EQ(cache.getNumTokens(), numThreads * (numSteps + 2));
+    EXPECT_EQ(cache.propose({3, 4}, 3), (VecTokens{5, 6, 7}));
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/runtime/generationConfig.h"
+#include "tensorrt_llm/runtime/modelConfig.h"
+
+#include <vector>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+
+using LayerType = ModelConfig::LayerType;
+
+} // namespace
+
+TEST(PerLayerAttentionWindowTest, CountLowerRankLayersWithoutLayerTypes)
+{
+    ModelConfig modelConfig{32000, 8, 0, 16, 1024, nvinfer1::DataType::kHALF};
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION), 0);
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 2, 1), 4);
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 4, 3), 6);
+}
+
+TEST(PerLayerAttentionWindowTest, CountLowerRankLayersOfHybridModel)
+{
+    // Two recurrent layers for each attention layer, split over two ranks of 6 layers: the first rank holds 2
+    // attention layers, the second rank 2 more.
+    std::vector<LayerType> layerTypes;
+    for (int i = 0; i < 12; ++i)
+    {
+        layerTypes.push_back(i % 3 == 2 ? LayerType::kATTENTION : LayerType::kRECURRENT);
+    }
+    ModelConfig modelConfig{32000, 4, 8, 16, 1024, nvinfer1::DataType::kHALF};
+    modelConfig.setLayerTypes(layerTypes);
+
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 2, 0), 0);
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 2, 1), 2);
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kRECURRENT, 2, 1), 4);
+    // Three ranks of 4 layers, the first attention layers are layers 2 and 5.
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 3, 1), 1);
+    EXPECT_EQ(modelConfig.countLowerRankLayers(LayerType::kATTENTION, 3, 2), 2);
+}
+
+TEST(PerLayerAttentionWindowTest, WindowsRepeatOverTheLayers)
+{
+    GenerationConfig generationConfig{8, 1, 0, 4096, 0, 4096};
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(0), 4096);
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(7), 4096);
+
+    // Alternating sliding-window and global layers.
+    generationConfig.maxAttentionWindowVec = {512, 4096};
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(0), 512);
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(1), 4096);
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(6), 512);
+    EXPECT_EQ(generationConfig.getMaxAttentionWindow(7), 4096);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/pipelineBubbleTracker.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(PipelineBubbleTrackerTest, FillDrainEstimate)
+{
+    EXPECT_DOUBLE_EQ(PipelineBubbleTracker::estimateFillDrainBubble(1, 1), 0.0);
+    EXPECT_DOUBLE_EQ(PipelineBubbleTracker::estimateFillDrainBubble(4, 4), 3.0 / 7.0);
+    // More micro batches shrink the bubble.
+    EXPECT_LT(
+        PipelineBubbleTracker::estimateFillDrainBubble(16, 4), PipelineBubbleTracker::estimateFillDrainBubble(8, 4));
+}
+
+TEST(PipelineBubbleTrackerTest, MeasuredFraction)
+{
+    using Duration = PipelineBubbleTracker::Duration;
+    PipelineBubbleTracker tracker;
+    EXPECT_EQ(tracker.getBubbleFraction(), 0.0);
+    tracker.addWait(Duration{10.0});
+    tracker.addWait(Duration{15.0});
+    tracker.addLoop(Duration{100.0});
+    EXPECT_DOUBLE_EQ(tracker.getBubbleFraction(), 0.25);
+    tracker.reset();
+    EXPECT_EQ(tracker.getBubbleFraction(), 0.0);
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/promptEmbeddingCache.h"
+
+#include <algorithm>
+#include <memory>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class PromptEmbeddingCacheTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static constexpr SizeType32 kHiddenSize{8};
+    static constexpr SizeType32 kRowsPerPage{4};
+    static constexpr SizeType32 kVocabSize{1000};
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mManager = std::make_unique<BufferManager>(std::make_shared<CudaStream>());
+    }
+
+    //! Embeddings whose every value is `value`.
+    static ITensor::SharedConstPtr makeEmbeddings(SizeType32 numRows, float value)
+    {
+        auto embeddings = BufferManager::pinned(ITensor::makeShape({numRows, kHiddenSize}), nvinfer1::DataType::kFLOAT);
+        auto* data = bufferCast<float>(*embeddings);
+        std::fill(data, data + embeddings->getSize(), value);
+        return embeddings;
+    }
+
+    //! Whether the table holds `value` in the rows of the prompt token ids.
+    bool rowsHaveValue(PromptEmbeddingCache const& cache, PromptEmbeddingCache::VecTokens const& tokenIds, float value)
+    {
+        auto table = mManager->copyFrom(*cache.getTable(), MemoryType::kPINNED);
+        mManager->getStream().synchronize();
+        auto const* data = bufferCast<float>(*table);
+        return std::all_of(tokenIds.begin(), tokenIds.end(),
+            [&](TokenIdType id)
+            {
+                auto const* row = data + static_cast<std::size_t>(id - kVocabSize) * kHiddenSize;
+                return std::all_of(row, row + kHiddenSize, [&](float v) { return v == value; });
+            });
+    }
+
+    std::unique_ptr<BufferManager> mManager;
+};
+
+TEST_F(PromptEmbeddingCacheTest, SharesEntriesByContent)
+{
+    PromptEmbeddingCache cache{4 * kRowsPerPage, kRowsPerPage, kHiddenSize, nvinfer1::DataType::kFLOAT, kVocabSize,
+        *mManager};
+    auto const first = cache.acquire(1, makeEmbeddings(6, 1.f));
+    ASSERT_TRUE(first.has_value());
+    ASSERT_EQ(first->size(), 6);
+    EXPECT_TRUE(std::all_of(first->begin(), first->end(), [](TokenIdType id) { return id >= kVocabSize; }));
+    EXPECT_TRUE(rowsHaveValue(cache, *first, 1.f));
+
+    // The same content gets the same ids, the embeddings are not copied again.
+    auto const second = cache.acquire(1, makeEmbeddings(6, 2.f));
+    EXPECT_EQ(second, first);
+    EXPECT_EQ(cache.acquire(1), first);
+    EXPECT_FALSE(cache.acquire(2).has_value());
+
+    auto const stats = cache.getStats();
+    EXPECT_EQ(stats.numEntries, 1);
+    EXPECT_EQ(stats.numFreePages, 2);
+    EXPECT_EQ(stats.numHits, 2);
+    EXPECT_EQ(stats.numMisses, 1);
+}
+
+TEST_F(PromptEmbeddingCacheTest, EvictsUnreferencedEntries)
+{
+    PromptEmbeddingCache cache{2 * kRowsPerPage, kRowsPerPage, kHiddenSize, nvinfer1::DataType::kFLOAT, kVocabSize,
+        *mManager};
+    ASSERT_TRUE(cache.acquire(1, makeEmbeddings(kRowsPerPage, 1.f)).has_value());
+    ASSERT_TRUE(cache.acquire(2, makeEmbeddings(kRowsPerPage, 2.f)).has_value());
+    // Both entries are held
+    EXPECT_FALSE(cache.acquire(3, makeEmbeddings(1, 3.f)).has_value());
+
+    cache.release(2);
+    auto const third = cache.acquire(3, makeEmbeddings(1, 3.f));
+    ASSERT_TRUE(third.has_value());
+    EXPECT_TRUE(rowsHaveValue(cache, *third, 3.f));
+    EXPECT_FALSE(cache.acquire(2).has_value());
+    EXPECT_EQ(cache.getStats().numEvictions, 1);
+
+    // Released entries stay cached until their pages are needed.
+    cache.release(1);
+    EXPECT_TRUE(cache.acquire(1).has_value());
+}
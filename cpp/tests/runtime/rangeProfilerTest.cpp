@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/rangeProfiler.h"
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+#include <cstdlib>
+#include <filesystem>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+void setSampleEveryRange()
+{
+    // The settings are read once per process
+    setenv("TRTLLM_RANGE_PROFILER_SAMPLE_PERIOD", "1", 1);
+    setenv("TRTLLM_RANGE_PROFILER_CAPACITY", "4", 1);
+}
+} // namespace
+
+TEST(RangeProfilerTest, RecordsNestedRangesInRing)
+{
+    setSampleEveryRange();
+    auto& profiler = RangeProfiler::getInstance();
+    profiler.clear();
+
+    auto const outer = RangeProfiler::registerRange(RangeProfiler::Category::kSCHEDULER, "outer");
+    {
+        RangeProfiler::ScopedRange const outerRange{outer};
+        TLLM_PROFILE_RANGE(kDECODER, "inner");
+    }
+    auto const json = profiler.dump().toJson();
+    EXPECT_NE(json.find("\"name\":\"outer\",\"cat\":\"scheduler\""), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"inner\",\"cat\":\"decoder\""), std::string::npos);
+
+    // Only the last 4 ranges of the thread are kept
+    for (int i = 0; i < 3; ++i)
+    {
+        RangeProfiler::ScopedRange const range{outer};
+    }
+    auto const trace = profiler.dump();
+    EXPECT_EQ(trace.getNumEvents(), 4);
+    EXPECT_EQ(trace.toJson().find("\"name\":\"inner\""), std::string::npos);
+
+    profiler.clear();
+    EXPECT_EQ(profiler.dump().getNumEvents(), 0);
+}
+
+TEST(RangeProfilerTest, TimesWorkOnStream)
+{
+    setSampleEveryRange();
+    auto& profiler = RangeProfiler::getInstance();
+    profiler.clear();
+
+    CudaStream stream;
+    auto buffer = BufferManager::gpuSync(1 << 20, nvinfer1::DataType::kINT8);
+    {
+        TLLM_PROFILE_GPU_RANGE(kPLUGIN, "memset", stream.get());
+        TLLM_CUDA_CHECK(cudaMemsetAsync(buffer->data(), 0, buffer->getSizeInBytes(), stream.get()));
+    }
+    stream.synchronize();
+
+    // One event for the CPU range and one on the GPU track of the thread
+    auto const json = profiler.dump().toJson();
+    EXPECT_NE(json.find("\"args\":{\"device\":"), std::string::npos);
+    EXPECT_NE(json.find(" GPU\"}"), std::string::npos);
+    profiler.clear();
+}
+
+TEST(RangeProfilerTest, DumpsOnSloViolation)
+{
+    setSampleEveryRange();
+    auto& profiler = RangeProfiler::getInstance();
+    {
+        TLLM_PROFILE_RANGE(kRUNTIME, "slow");
+    }
+    auto const dir = std::filesystem::temp_directory_path() / "rangeProfilerTest";
+    EXPECT_FALSE(profiler.dumpOnSloViolation(10., 20., dir));
+    auto const path = profiler.dumpOnSloViolation(30., 20., dir);
+    ASSERT_TRUE(path);
+    EXPECT_TRUE(std::filesystem::exists(path.value()));
+    // Rate limited
+    EXPECT_FALSE(profiler.dumpOnSloViolation(30., 20., dir));
+    std::filesystem::remove_all(dir);
+}
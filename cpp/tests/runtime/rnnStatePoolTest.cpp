@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/rnnStatePool.h"
+
+#include <algorithm>
+#include <memory>
+#include <numeric>
+
+using namespace tensorrt_llm::runtime;
+namespace tc = tensorrt_llm::common;
+
+class RnnStatePoolTest : public ::testing::Test // NOLINT(cppcoreguidelines-pro-type-member-init)
+{
+protected:
+    static constexpr SizeType32 kNumLayers{3};
+    static constexpr SizeType32 kNumSlots{4};
+    static constexpr SizeType32 kTokensPerBlock{4};
+
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP();
+        }
+        mManager = std::make_unique<BufferManager>(std::make_shared<CudaStream>());
+        for (SizeType32 layer = 0; layer < kNumLayers; ++layer)
+        {
+            mBuffers.rnnState.push_back(
+                mManager->gpu(ITensor::makeShape({kNumSlots, 2, 8}), nvinfer1::DataType::kFLOAT));
+            mBuffers.convState.push_back(
+                mManager->gpu(ITensor::makeShape({kNumSlots, 3, 8}), nvinfer1::DataType::kFLOAT));
+        }
+    }
+
+    //! Set the whole state of a slot to a value, different in each layer.
+    void fillSlot(SizeType32 slot, float value)
+    {
+        for (SizeType32 layer = 0; layer < kNumLayers; ++layer)
+        {
+            for (auto const& states : {mBuffers.rnnState[layer], mBuffers.convState[layer]})
+            {
+                auto slotState = ITensor::slice(states, slot, 1);
+                auto host = BufferManager::pinned(slotState->getShape(), nvinfer1::DataType::kFLOAT);
+                auto* data = bufferCast<float>(*host);
+                std::fill(data, data + host->getSize(), value + static_cast<float>(layer));
+                mManager->copy(*host, *slotState);
+            }
+        }
+        mManager->getStream().synchronize();
+    }
+
+    //! Whether the whole state of a slot is what fillSlot wrote for a value.
+    bool slotHasValue(SizeType32 slot, float value)
+    {
+        for (SizeType32 layer = 0; layer < kNumLayers; ++layer)
+        {
+            for (auto const& states : {mBuffers.rnnState[layer], mBuffers.convState[layer]})
+            {
+                auto host = mManager->copyFrom(*ITensor::slice(states, slot, 1), MemoryType::kPINNED);
+                mManager->getStream().synchronize();
+                auto const* data = bufferCast<float>(*host);
+                auto const expected = value + static_cast<float>(layer);
+                if (!std::all_of(data, data + host->getSize(), [&](float v) { return v == expected; }))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static RnnStatePool::VecTokens makeTokens(SizeType32 size, TokenIdType first = 0)
+    {
+        RnnStatePool::VecTokens tokens(size);
+        std::iota(tokens.begin(), tokens.end(), first);
+        return tokens;
+    }
+
+    std::unique_ptr<BufferManager> mManager;
+    RnnStateBuffers mBuffers;
+};
+
+TEST_F(RnnStatePoolTest, RestoresLongestCheckpointedPrefix)
+{
+    RnnStatePool pool{mBuffers, RnnStatePool::Config{kTokensPerBlock, 4, 0}, *mManager};
+    auto const tokens = makeTokens(3 * kTokensPerBlock);
+
+    fillSlot(0, 10.f);
+    pool.checkpoint(tokens, kTokensPerBlock, 0, mBuffers);
+    fillSlot(0, 20.f);
+    pool.checkpoint(tokens, 2 * kTokensPerBlock, 0, mBuffers);
+
+    EXPECT_EQ(pool.restore(tokens, 1, mBuffers), 2 * kTokensPerBlock);
+    EXPECT_TRUE(slotHasValue(1, 20.f));
+
+    // The last token is never covered
+    auto const shortTokens = makeTokens(2 * kTokensPerBlock);
+    EXPECT_EQ(pool.restore(shortTokens, 2, mBuffers), kTokensPerBlock);
+    EXPECT_TRUE(slotHasValue(2, 10.f));
+
+    // Diverges in the second block
+    auto divergent = tokens;
+    divergent[kTokensPerBlock + 1] = -1;
+    EXPECT_EQ(pool.restore(divergent, 3, mBuffers), kTokensPerBlock);
+
+    // Another salt, e.g. LoRA task
+    EXPECT_EQ(pool.restore(tokens, 3, mBuffers, 7), 0);
+    EXPECT_EQ(pool.restore(makeTokens(3 * kTokensPerBlock, 100), 3, mBuffers), 0);
+
+    auto const& stats = pool.getStats();
+    EXPECT_EQ(stats.numGpuCheckpoints, 2);
+    EXPECT_EQ(stats.numHits, 3);
+    EXPECT_EQ(stats.numMisses, 2);
+    EXPECT_EQ(stats.numRestoredTokens, 4 * kTokensPerBlock);
+}
+
+TEST_F(RnnStatePoolTest, OffloadsToHostThenDrops)
+{
+    RnnStatePool pool{mBuffers, RnnStatePool::Config{kTokensPerBlock, 1, 1}, *mManager};
+    auto const tokensA = makeTokens(2 * kTokensPerBlock, 0);
+    auto const tokensB = makeTokens(2 * kTokensPerBlock, 100);
+    auto const tokensC = makeTokens(2 * kTokensPerBlock, 200);
+
+    fillSlot(0, 1.f);
+    pool.checkpoint(tokensA, kTokensPerBlock, 0, mBuffers);
+    fillSlot(0, 2.f);
+    pool.checkpoint(tokensB, kTokensPerBlock, 0, mBuffers);
+    EXPECT_EQ(pool.getStats().numGpuCheckpoints, 1);
+    EXPECT_EQ(pool.getStats().numHostCheckpoints, 1);
+
+    // A was moved to the host pool and is restored from there
+    EXPECT_EQ(pool.restore(tokensA, 1, mBuffers), kTokensPerBlock);
+    EXPECT_TRUE(slotHasValue(1, 1.f));
+
+    // B moves to the host pool, which drops A
+    fillSlot(0, 3.f);
+    pool.checkpoint(tokensC, kTokensPerBlock, 0, mBuffers);
+    EXPECT_EQ(pool.restore(tokensA, 1, mBuffers), 0);
+    EXPECT_EQ(pool.restore(tokensB, 2, mBuffers), kTokensPerBlock);
+    EXPECT_TRUE(slotHasValue(2, 2.f));
+    EXPECT_EQ(pool.restore(tokensC, 3, mBuffers), kTokensPerBlock);
+    EXPECT_TRUE(slotHasValue(3, 3.f));
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/rooflineModel.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+auto constexpr kHiddenSize = 512;
+auto constexpr kMlpHiddenSize = 2048;
+
+ModelConfig makeModelConfig(tensorrt_llm::common::QuantMode quantMode = tensorrt_llm::common::QuantMode::none())
+{
+    ModelConfig modelConfig{1000, 2, 0, 8, kHiddenSize, nvinfer1::DataType::kHALF};
+    modelConfig.setMlpHiddenSize(kMlpHiddenSize);
+    modelConfig.setQuantMode(quantMode);
+    return modelConfig;
+}
+
+// 100 TFLOP/s and 1 TB/s, ridge at 100 FLOP/B
+GpuPeaks const kPeaks{100e12, 1e12};
+} // namespace
+
+TEST(RooflineModelTest, ClassifiesLayerNames)
+{
+    using Kind = RooflineModel::Kind;
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/0/attention/qkv/PLUGIN_V2_Gemm_0"), Kind::kQKV_GEMM);
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/0/attention/PLUGIN_V2_GPTAttention_0"), Kind::kATTENTION);
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/0/attention/dense/PLUGIN_V2_Gemm_0"),
+        Kind::kATTENTION_DENSE_GEMM);
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/1/mlp/gate/MATRIX_MULTIPLY_0"), Kind::kMLP_FC_GEMM);
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/1/mlp/proj/PLUGIN_V2_Gemm_0"), Kind::kMLP_PROJ_GEMM);
+    EXPECT_EQ(RooflineModel::classify("lm_head/PLUGIN_V2_Gemm_0"), Kind::kLM_HEAD_GEMM);
+    EXPECT_EQ(RooflineModel::classify("transformer/layers/0/input_layernorm/PLUGIN_V2_Rmsnorm_0"), Kind::kNORM);
+    EXPECT_EQ(RooflineModel::classify("{ForeignNode[transformer/vocab_embedding...]}"), Kind::kOTHER);
+}
+
+TEST(RooflineModelTest, EstimatesGemms)
+{
+    RooflineModel const model{makeModelConfig(), WorldConfig{}, kPeaks};
+    // 4 context tokens of 2 requests, then 2 generation steps
+    RooflineWorkload const workload{2, 4, 3};
+    auto const numTokens = 2. * 4 + 2. * 2;
+    auto const [flops, bytes] = model.estimate(RooflineModel::Kind::kMLP_FC_GEMM, workload);
+    EXPECT_DOUBLE_EQ(flops, 2. * numTokens * kHiddenSize * kMlpHiddenSize);
+    EXPECT_DOUBLE_EQ(bytes, 3. * kHiddenSize * kMlpHiddenSize * 2 + numTokens * (kHiddenSize + kMlpHiddenSize) * 2);
+
+    // Int4 weights read a quarter of the fp16 weight bytes
+    RooflineModel const int4Model{
+        makeModelConfig(tensorrt_llm::common::QuantMode::int4Weights()), WorldConfig{}, kPeaks};
+    auto const [int4Flops, int4Bytes] = int4Model.estimate(RooflineModel::Kind::kMLP_FC_GEMM, workload);
+    EXPECT_DOUBLE_EQ(int4Flops, flops);
+    EXPECT_DOUBLE_EQ(
+        int4Bytes, 3. * kHiddenSize * kMlpHiddenSize * 0.5 + numTokens * (kHiddenSize + kMlpHiddenSize) * 2);
+
+    auto const [otherFlops, otherBytes] = model.estimate(RooflineModel::Kind::kOTHER, workload);
+    EXPECT_EQ(otherFlops, 0.);
+    EXPECT_EQ(otherBytes, 0.);
+}
+
+TEST(RooflineModelTest, SortsByLostTime)
+{
+    RooflineModel const model{makeModelConfig(), WorldConfig{}, kPeaks};
+    RooflineWorkload const workload{1, 16, 2};
+    auto const layers = model.analyze(
+        {{"layers/0/mlp/fc/gemm", 1.f}, {"layers/0/mlp/proj/gemm", 10.f}, {"layers/0/shuffle", 5.f}}, workload, 2);
+    ASSERT_EQ(layers.size(), 3);
+    EXPECT_EQ(layers[0].name, "layers/0/mlp/proj/gemm");
+    EXPECT_EQ(layers[1].name, "layers/0/mlp/fc/gemm");
+    // Without an estimate, nothing is lost
+    EXPECT_EQ(layers[2].kind, RooflineModel::Kind::kOTHER);
+    EXPECT_EQ(layers[2].getLostTimeMs(), 0.f);
+
+    // 17 tokens per run through a 512x2048 fp16 GEMM are memory bound
+    auto const& fc = layers[1];
+    EXPECT_LT(fc.getArithmeticIntensity(), 100.);
+    EXPECT_FLOAT_EQ(fc.rooflineTimeMs, static_cast<float>(fc.bytes / kPeaks.bytesPerSec * 1e3));
+    EXPECT_NEAR(fc.getEfficiency(), fc.rooflineTimeMs / 1.f, 1e-6);
+    EXPECT_DOUBLE_EQ(fc.getAchievedBytesPerSec(), fc.bytes / 1e-3);
+
+    auto const report = model.report(layers, 1);
+    EXPECT_NE(report.find("*"), std::string::npos);
+    EXPECT_NE(report.find("[memory bound]"), std::string::npos);
+    EXPECT_NE(report.find("mlp_proj_gemm"), std::string::npos);
+}
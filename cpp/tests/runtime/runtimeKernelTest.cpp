@@ -19,8 +19,10 @@
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/common/memoryUtils.h"
 #include "tensorrt_llm/common/stlUtils.h"
+#include "tensorrt_llm/runtime/blockCopyBatch.h"
 #include "tensorrt_llm/runtime/bufferManager.h"
 #include "tensorrt_llm/runtime/common.h"
+#include "tensorrt_llm/runtime/decodingOutput.h"
 #include "tensorrt_llm/runtime/iBuffer.h"
 #include "tensorrt_llm/runtime/iTensor.h"
 #include "tensorrt_llm/runtime/runtimeKernels.h"
@@ -998,3 +1000,224 @@ TEST_F(RuntimeKernelTest, CopyBatchStride5)
 {
     testCopyBatch(5, *mManager, *mStream);
 }
+
+TEST_F(RuntimeKernelTest, BlockCopyBatch)
+{
+    SizeType32 constexpr numBlocks{10};
+    SizeType32 constexpr blockSize{1000};
+    auto const poolShape = ITensor::makeShape({numBlocks, blockSize});
+
+    // Onboard every block of a pinned host pool to the reversed slot of a device pool
+    auto hostPool = BufferManager::pinned(poolShape, nvinfer1::DataType::kINT32);
+    auto hostPoolPtr = bufferCast<std::int32_t>(*hostPool);
+    std::iota(hostPoolPtr, hostPoolPtr + hostPool->getSize(), 0);
+    auto devicePool = mManager->gpu(poolShape, nvinfer1::DataType::kINT32);
+    mManager->setZero(*devicePool);
+
+    auto copyStream = std::make_shared<CudaStream>();
+    // The copies must not overtake the zeroing of the device pool
+    CudaEvent poolReady{};
+    mStream->record(poolReady);
+    copyStream->wait(poolReady);
+    auto const blockSizeInBytes = blockSize * sizeof(std::int32_t);
+    // Smaller than numBlocks so that add() flushes on its own
+    BlockCopyBatch batch{blockSizeInBytes, 4, copyStream};
+    auto devicePoolPtr = bufferCast<std::int32_t>(*devicePool);
+    for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+    {
+        batch.add(hostPoolPtr + bi * blockSize, devicePoolPtr + (numBlocks - 1 - bi) * blockSize);
+    }
+    EXPECT_EQ(batch.getNumQueued(), 2);
+    auto event = batch.flush();
+    ASSERT_NE(event, nullptr);
+    EXPECT_EQ(batch.getNumQueued(), 0);
+    EXPECT_EQ(batch.getNumCopied(), numBlocks);
+    EXPECT_EQ(batch.flush(), nullptr);
+
+    // Only the consumer waits for the copies
+    mStream->wait(*event);
+    auto deviceCopy = mManager->copyFrom(*devicePool, MemoryType::kCPU);
+    mStream->synchronize();
+    auto deviceCopyPtr = bufferCast<std::int32_t>(*deviceCopy);
+    for (SizeType32 bi = 0; bi < numBlocks; ++bi)
+    {
+        for (SizeType32 ti = 0; ti < blockSize; ++ti)
+        {
+            EXPECT_EQ(deviceCopyPtr[(numBlocks - 1 - bi) * blockSize + ti], bi * blockSize + ti)
+                << "Error at block " << bi << " index " << ti;
+        }
+    }
+}
+
+TEST_F(RuntimeKernelTest, PoolPackedHiddenStates)
+{
+    SizeType32 constexpr hiddenSize{300};
+    std::vector<SizeType32> const inputOffsetsVec{0, 3, 4, 9};
+    SizeType32 const batchSize = static_cast<SizeType32>(inputOffsetsVec.size()) - 1;
+    SizeType32 const numTokens = inputOffsetsVec.back();
+
+    // Row t holds t in every channel
+    std::vector<float> inputVec(numTokens * hiddenSize);
+    for (SizeType32 ti = 0; ti < numTokens; ++ti)
+    {
+        std::fill_n(inputVec.begin() + ti * hiddenSize, hiddenSize, static_cast<float>(ti));
+    }
+    TensorPtr input = mManager->copyFrom(inputVec, ITensor::makeShape({numTokens, hiddenSize}), MemoryType::kGPU);
+    TensorPtr inputOffsets
+        = mManager->copyFrom(inputOffsetsVec, ITensor::makeShape({batchSize + 1}), MemoryType::kGPU);
+    TensorPtr output = mManager->gpu(ITensor::makeShape({batchSize, hiddenSize}), nvinfer1::DataType::kFLOAT);
+
+    for (auto const mean : {false, true})
+    {
+        kernels::poolPackedHiddenStates(*output, *input, *inputOffsets, mean, *mStream);
+        std::vector<float> outputVec(output->getSize());
+        mManager->copy(*output, outputVec.data());
+        mStream->synchronize();
+        for (SizeType32 bi = 0; bi < batchSize; ++bi)
+        {
+            auto const begin = inputOffsetsVec[bi];
+            auto const end = inputOffsetsVec[bi + 1];
+            auto const expected = mean ? static_cast<float>(begin + end - 1) / 2.f : static_cast<float>(begin);
+            for (SizeType32 ci = 0; ci < hiddenSize; ++ci)
+            {
+                EXPECT_FLOAT_EQ(outputVec[bi * hiddenSize + ci], expected) << "Error at " << bi << ", " << ci;
+            }
+        }
+    }
+}
+
+TEST_F(RuntimeKernelTest, InitNewRequests)
+{
+    SizeType32 constexpr maxBatchSize{4};
+    SizeType32 constexpr maxBeamWidth{2};
+    SizeType32 constexpr maxSequenceLength{8};
+    SizeType32 constexpr maxTokensPerStep{2};
+    SizeType32 constexpr vocabSizePadded{5};
+    auto constexpr nvTokenIdType = TRTDataType<TokenIdType>::value;
+    auto constexpr nvSizeType = TRTDataType<SizeType32>::value;
+
+    auto const idsShape = ITensor::makeShape({maxBatchSize, maxBeamWidth, maxSequenceLength});
+    auto const beamsShape = ITensor::makeShape({maxBatchSize, maxBeamWidth});
+    auto const stepsShape = ITensor::makeShape({maxTokensPerStep, maxBatchSize, maxBeamWidth});
+    auto outputIds = mManager->gpu(idsShape, nvTokenIdType);
+    auto parentIds = mManager->gpu(idsShape, nvTokenIdType);
+    auto endIds = mManager->gpu(beamsShape, nvTokenIdType);
+    auto lengths = mManager->gpu(beamsShape, nvSizeType);
+    auto sequenceLimitLength = mManager->gpu(ITensor::makeShape({maxBatchSize}), nvSizeType);
+    auto finishedSum = BufferManager::pinned(ITensor::makeShape({maxBatchSize}), nvSizeType);
+    auto newTokensSteps = mManager->gpu(stepsShape, nvTokenIdType);
+    auto finishedSteps = mManager->gpu(stepsShape, nvinfer1::DataType::kUINT8);
+    auto cumLogProbs = mManager->gpu(beamsShape, nvinfer1::DataType::kFLOAT);
+    auto logProbs = mManager->gpu(idsShape, nvinfer1::DataType::kFLOAT);
+    auto embeddingBias = mManager->gpu(ITensor::makeShape({maxBatchSize, vocabSizePadded}), nvinfer1::DataType::kFLOAT);
+
+    // Slots that are not set up keep their values
+    kernels::invokeFill(*outputIds, TokenIdType{-7}, *mStream);
+    kernels::invokeFill(*parentIds, TokenIdType{-7}, *mStream);
+    kernels::invokeFill(*lengths, SizeType32{-7}, *mStream);
+    kernels::invokeFill(*newTokensSteps, TokenIdType{-7}, *mStream);
+    kernels::invokeFill(*finishedSteps, std::uint8_t{7}, *mStream);
+    kernels::invokeFill(*cumLogProbs, 7.f, *mStream);
+    kernels::invokeFill(*logProbs, 7.f, *mStream);
+    kernels::invokeFill(*embeddingBias, 7.f, *mStream);
+    std::fill_n(bufferCast<SizeType32>(*finishedSum), maxBatchSize, 7);
+
+    std::vector<TokenIdType> const inputIdsVec{10, 11, 12, 20};
+    auto inputIds = mManager->copyFrom(inputIdsVec, ITensor::makeShape({4}), MemoryType::kGPU);
+    auto const* inputIdsPtr = bufferCast<TokenIdType>(*inputIds);
+
+    SizeType32 constexpr numRequests{2};
+    auto setups = BufferManager::pinned(
+        ITensor::makeShape({numRequests * static_cast<SizeType32>(sizeof(kernels::NewRequestSetup))}),
+        nvinfer1::DataType::kINT8);
+    auto* setupsPtr = reinterpret_cast<kernels::NewRequestSetup*>(setups->data());
+    setupsPtr[0] = kernels::NewRequestSetup{inputIdsPtr, 3, 2, 2, 3, 6, 1, false, true, true};
+    setupsPtr[1] = kernels::NewRequestSetup{inputIdsPtr + 3, 1, 0, 1, 1, 4, 2, true, false, false};
+
+    kernels::NewRequestsBuffers const buffers{bufferCast<TokenIdType>(*outputIds), bufferCast<TokenIdType>(*parentIds),
+        bufferCast<TokenIdType>(*endIds), bufferCast<SizeType32>(*lengths),
+        bufferCast<SizeType32>(*sequenceLimitLength), bufferCast<SizeType32>(*finishedSum),
+        bufferCast<TokenIdType>(*newTokensSteps), bufferCast<std::uint8_t>(*finishedSteps),
+        bufferCast<float>(*cumLogProbs), bufferCast<float>(*logProbs), bufferCast<float>(*embeddingBias), maxBatchSize,
+        maxBeamWidth, maxSequenceLength, maxTokensPerStep, vocabSizePadded};
+    kernels::invokeInitNewRequests(buffers, *setups, numRequests, *mStream);
+
+    auto outputIdsHost = mManager->copyFrom(*outputIds, MemoryType::kCPU);
+    auto parentIdsHost = mManager->copyFrom(*parentIds, MemoryType::kCPU);
+    auto endIdsHost = mManager->copyFrom(*endIds, MemoryType::kCPU);
+    auto lengthsHost = mManager->copyFrom(*lengths, MemoryType::kCPU);
+    auto sequenceLimitLengthHost = mManager->copyFrom(*sequenceLimitLength, MemoryType::kCPU);
+    auto newTokensStepsHost = mManager->copyFrom(*newTokensSteps, MemoryType::kCPU);
+    auto finishedStepsHost = mManager->copyFrom(*finishedSteps, MemoryType::kCPU);
+    auto cumLogProbsHost = mManager->copyFrom(*cumLogProbs, MemoryType::kCPU);
+    auto logProbsHost = mManager->copyFrom(*logProbs, MemoryType::kCPU);
+    auto embeddingBiasHost = mManager->copyFrom(*embeddingBias, MemoryType::kCPU);
+    mStream->synchronize();
+
+    auto const* outputIdsPtr = bufferCast<TokenIdType>(*outputIdsHost);
+    auto const* parentIdsPtr = bufferCast<TokenIdType>(*parentIdsHost);
+    auto const* logProbsPtr = bufferCast<float>(*logProbsHost);
+    auto const idx = [](SizeType32 slot, SizeType32 beam, SizeType32 column)
+    { return (slot * maxBeamWidth + beam) * maxSequenceLength + column; };
+    for (SizeType32 ci = 0; ci < maxSequenceLength; ++ci)
+    {
+        for (SizeType32 beam = 0; beam < maxBeamWidth; ++beam)
+        {
+            EXPECT_EQ(outputIdsPtr[idx(2, beam, ci)], ci < 3 ? inputIdsVec[ci] : 1) << beam << ", " << ci;
+            EXPECT_EQ(parentIdsPtr[idx(2, beam, ci)], 0);
+            EXPECT_EQ(logProbsPtr[idx(2, beam, ci)], 0.f);
+            // Log probs are only zeroed on request
+            EXPECT_EQ(logProbsPtr[idx(0, beam, ci)], 7.f);
+            EXPECT_EQ(outputIdsPtr[idx(1, beam, ci)], -7);
+        }
+        EXPECT_EQ(outputIdsPtr[idx(0, 0, ci)], ci < 1 ? 20 : 2);
+        EXPECT_EQ(outputIdsPtr[idx(0, 1, ci)], -7);
+        EXPECT_EQ(parentIdsPtr[idx(0, 0, ci)], -7);
+    }
+
+    auto const* endIdsPtr = bufferCast<TokenIdType>(*endIdsHost);
+    auto const* lengthsPtr = bufferCast<SizeType32>(*lengthsHost);
+    auto const* cumLogProbsPtr = bufferCast<float>(*cumLogProbsHost);
+    for (SizeType32 beam = 0; beam < maxBeamWidth; ++beam)
+    {
+        EXPECT_EQ(endIdsPtr[2 * maxBeamWidth + beam], 1);
+        EXPECT_EQ(endIdsPtr[0 * maxBeamWidth + beam], 2);
+        EXPECT_EQ(lengthsPtr[2 * maxBeamWidth + beam], 3);
+        EXPECT_EQ(lengthsPtr[0 * maxBeamWidth + beam], 1);
+        EXPECT_EQ(lengthsPtr[1 * maxBeamWidth + beam], -7);
+        EXPECT_EQ(cumLogProbsPtr[0 * maxBeamWidth + beam], 7.f);
+    }
+    EXPECT_EQ(cumLogProbsPtr[2 * maxBeamWidth + 0], 0.f);
+    EXPECT_EQ(cumLogProbsPtr[2 * maxBeamWidth + 1], DecodingOutput::kNegativeInfinity);
+
+    auto const* sequenceLimitLengthPtr = bufferCast<SizeType32>(*sequenceLimitLengthHost);
+    auto const* finishedSumPtr = bufferCast<SizeType32>(*finishedSum);
+    EXPECT_EQ(sequenceLimitLengthPtr[2], 6);
+    EXPECT_EQ(sequenceLimitLengthPtr[0], 4);
+    EXPECT_EQ(finishedSumPtr[2], 0);
+    EXPECT_EQ(finishedSumPtr[0], 0);
+    EXPECT_EQ(finishedSumPtr[1], 7);
+
+    auto const* newTokensStepsPtr = bufferCast<TokenIdType>(*newTokensStepsHost);
+    auto const* finishedStepsPtr = bufferCast<std::uint8_t>(*finishedStepsHost);
+    for (SizeType32 step = 0; step < maxTokensPerStep; ++step)
+    {
+        for (SizeType32 slot = 0; slot < maxBatchSize; ++slot)
+        {
+            auto const isNew = slot == 0 || slot == 2;
+            for (SizeType32 beam = 0; beam < maxBeamWidth; ++beam)
+            {
+                auto const stepIdx = (step * maxBatchSize + slot) * maxBeamWidth + beam;
+                EXPECT_EQ(newTokensStepsPtr[stepIdx], isNew ? 0 : -7);
+                EXPECT_EQ(finishedStepsPtr[stepIdx], isNew ? 0 : 7);
+            }
+        }
+    }
+
+    auto const* embeddingBiasPtr = bufferCast<float>(*embeddingBiasHost);
+    for (SizeType32 vi = 0; vi < vocabSizePadded; ++vi)
+    {
+        EXPECT_EQ(embeddingBiasPtr[0 * vocabSizePadded + vi], 0.f);
+        EXPECT_EQ(embeddingBiasPtr[2 * vocabSizePadded + vi], 7.f);
+    }
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2022-2023, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/speculationLengthController.h"
+
+#include <gtest/gtest.h>
+
+#include <numeric>
+
+using namespace tensorrt_llm::runtime;
+
+namespace
+{
+SpeculationLengthController::Config makeConfig(SizeType32 computeBoundTokens, double draftTokenCost = 0.0)
+{
+    SpeculationLengthController::Config config;
+    config.maxDraftLength = 4;
+    config.computeBoundTokens = computeBoundTokens;
+    config.draftTokenCost = draftTokenCost;
+    return config;
+}
+} // namespace
+
+TEST(SpeculationLengthControllerTest, ExpectedTokens)
+{
+    EXPECT_DOUBLE_EQ(SpeculationLengthController::expectedTokens(0.5, 0), 1.0);
+    EXPECT_DOUBLE_EQ(SpeculationLengthController::expectedTokens(0.5, 1), 1.5);
+    EXPECT_DOUBLE_EQ(SpeculationLengthController::expectedTokens(0.5, 2), 1.75);
+    EXPECT_DOUBLE_EQ(SpeculationLengthController::expectedTokens(0.0, 3), 1.0);
+}
+
+TEST(SpeculationLengthControllerTest, AcceptanceRate)
+{
+    SpeculationLengthController controller{makeConfig(1024)};
+    EXPECT_DOUBLE_EQ(controller.getAcceptanceRate(7), 0.5);
+    // 3 accepted and 1 rejected
+    controller.update(7, 4, 3);
+    EXPECT_DOUBLE_EQ(controller.getAcceptanceRate(7), 0.75);
+    // All accepted, no failure observed
+    controller.update(7, 2, 2);
+    EXPECT_NEAR(controller.getAcceptanceRate(7), (0.9 * 3 + 2) / (0.9 * 4 + 2), 1e-12);
+    // Steps without draft tokens carry no information
+    controller.update(7, 0, 0);
+    EXPECT_NEAR(controller.getAcceptanceRate(7), (0.9 * 3 + 2) / (0.9 * 4 + 2), 1e-12);
+    controller.removeRequest(7);
+    EXPECT_DOUBLE_EQ(controller.getAcceptanceRate(7), 0.5);
+    EXPECT_ANY_THROW(controller.update(7, 2, 3));
+}
+
+TEST(SpeculationLengthControllerTest, MemoryBoundSpeculatesFully)
+{
+    SpeculationLengthController controller{makeConfig(1024)};
+    controller.update(1, 4, 4);
+    controller.update(2, 4, 1);
+    auto const lengths = controller.computeDraftLengths({1, 2});
+    ASSERT_EQ(lengths.size(), 2);
+    // Draft tokens are free while memory bound, even with a low acceptance rate
+    EXPECT_EQ(lengths[0], 4);
+    EXPECT_EQ(lengths[1], 4);
+}
+
+TEST(SpeculationLengthControllerTest, ComputeBoundStopsSpeculation)
+{
+    SpeculationLengthController controller{makeConfig(64)};
+    std::vector<SpeculationLengthController::RequestIdType> requestIds(128);
+    std::iota(requestIds.begin(), requestIds.end(), 0);
+    for (auto const id : requestIds)
+    {
+        controller.update(id, 4, 2);
+    }
+    auto const lengths = controller.computeDraftLengths(requestIds);
+    for (auto const length : lengths)
+    {
+        EXPECT_EQ(length, 0);
+    }
+}
+
+TEST(SpeculationLengthControllerTest, PrefersHighAcceptance)
+{
+    // 8 requests, 16 tokens before the step becomes compute bound
+    SpeculationLengthController controller{makeConfig(16)};
+    std::vector<SpeculationLengthController::RequestIdType> requestIds(8);
+    std::iota(requestIds.begin(), requestIds.end(), 0);
+    for (auto const id : requestIds)
+    {
+        controller.update(id, 4, id < 4 ? 4 : 0);
+    }
+    auto const lengths = controller.computeDraftLengths(requestIds);
+    auto const numDraftTokens = std::accumulate(lengths.begin(), lengths.end(), 0);
+    EXPECT_GE(numDraftTokens, 8);
+    for (SizeType32 ri = 0; ri < 4; ++ri)
+    {
+        EXPECT_GE(lengths[ri], lengths[ri + 4]);
+        EXPECT_GT(lengths[ri], 0);
+    }
+}
+
+TEST(SpeculationLengthControllerTest, DraftCostLimitsLength)
+{
+    SpeculationLengthController controller{makeConfig(1024, 0.25)};
+    controller.update(1, 4, 1);
+    controller.update(1, 4, 1);
+    auto const lengths = controller.computeDraftLengths({1});
+    ASSERT_EQ(lengths.size(), 1);
+    // Acceptance of 0.5: the first draft token gains 0.5 tokens for 0.25 of cost, the second only 0.25
+    EXPECT_EQ(lengths[0], 1);
+}
+
+TEST(SpeculationLengthControllerTest, Empty)
+{
+    SpeculationLengthController controller{makeConfig(16)};
+    EXPECT_TRUE(controller.computeDraftLengths({}).empty());
+}
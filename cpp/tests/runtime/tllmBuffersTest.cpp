@@ -24,10 +24,14 @@
 #include "tensorrt_llm/runtime/tllmBuffers.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <fstream>
 #include <limits>
 #include <memory>
+#include <numeric>
 #include <random>
 #include <sstream>
+#include <string>
 #include <thread>
 #include <tuple>
 #include <type_traits>
@@ -101,6 +105,79 @@ TEST_F(TllmBuffersTest, PinnedAllocator)
     EXPECT_THROW(allocator.deallocate(ptr, size), std::runtime_error);
 }
 
+namespace
+{
+//! \brief Huge pages of `hugePageSize` bytes that a new mapping can get, the free and the surplus ones.
+std::size_t getAvailableHugePages(std::size_t hugePageSize)
+{
+    auto const dir = "/sys/kernel/mm/hugepages/hugepages-" + std::to_string(hugePageSize >> 10) + "kB/";
+    auto const read = [&dir](char const* name)
+    {
+        std::size_t value{0};
+        std::ifstream(dir + name) >> value;
+        return value;
+    };
+    auto const overcommit = read("nr_overcommit_hugepages");
+    auto const surplus = read("surplus_hugepages");
+    return read("free_hugepages") + (overcommit > surplus ? overcommit - surplus : 0);
+}
+} // namespace
+
+TEST_F(TllmBuffersTest, PinnedHugePagesFallback)
+{
+    if (mDeviceCount == 0)
+        GTEST_SKIP();
+
+    auto constexpr hugePageSize = std::size_t(2) << 20;
+    // Huge pages disabled, or smaller than a huge page
+    EXPECT_EQ(PinnedAllocator::allocateHugePages(4 * hugePageSize, 0), nullptr);
+    EXPECT_EQ(PinnedAllocator::allocateHugePages(hugePageSize - 1, hugePageSize), nullptr);
+    // More huge pages than are available, e.g. none are reserved, PinnedAllocator falls back to cudaHostAlloc
+    auto const available = getAvailableHugePages(hugePageSize);
+    EXPECT_EQ(PinnedAllocator::allocateHugePages((available + 1) * hugePageSize, hugePageSize), nullptr);
+
+    // Memory of cudaHostAlloc isn't released by deallocateHugePages, it is left to cudaFreeHost
+    void* hostPtr{nullptr};
+    TLLM_CUDA_CHECK(cudaHostAlloc(&hostPtr, hugePageSize, cudaHostAllocDefault));
+    EXPECT_FALSE(PinnedAllocator::deallocateHugePages(hostPtr));
+    EXPECT_FALSE(PinnedAllocator::deallocateHugePages(nullptr));
+    EXPECT_EQ(cudaFreeHost(hostPtr), cudaSuccess);
+}
+
+TEST_F(TllmBuffersTest, PinnedHugePages)
+{
+    auto constexpr hugePageSize = std::size_t(2) << 20;
+    if (mDeviceCount == 0 || getAvailableHugePages(hugePageSize) < 2)
+        GTEST_SKIP() << "Requires two free 2 MB huge pages";
+
+    // Rounded up to two huge pages, registered with CUDA
+    auto constexpr size = hugePageSize + 1;
+    auto* ptr = PinnedAllocator::allocateHugePages(size, hugePageSize);
+    ASSERT_NE(ptr, nullptr);
+    cudaPointerAttributes attributes{};
+    TLLM_CUDA_CHECK(cudaPointerGetAttributes(&attributes, ptr));
+    EXPECT_EQ(attributes.type, cudaMemoryTypeHost);
+
+    // Usable by copies from and to the device
+    std::vector<std::uint8_t> expected(size);
+    std::iota(expected.begin(), expected.end(), 0);
+    std::copy(expected.begin(), expected.end(), static_cast<std::uint8_t*>(ptr));
+    void* devicePtr{nullptr};
+    TLLM_CUDA_CHECK(cudaMalloc(&devicePtr, size));
+    TLLM_CUDA_CHECK(cudaMemcpy(devicePtr, ptr, size, cudaMemcpyHostToDevice));
+    std::fill_n(static_cast<std::uint8_t*>(ptr), size, 0);
+    TLLM_CUDA_CHECK(cudaMemcpy(ptr, devicePtr, size, cudaMemcpyDeviceToHost));
+    TLLM_CUDA_CHECK(cudaFree(devicePtr));
+    EXPECT_TRUE(std::equal(expected.begin(), expected.end(), static_cast<std::uint8_t*>(ptr)));
+
+    // Unregistered and unmapped once, the pages are free again
+    EXPECT_TRUE(PinnedAllocator::deallocateHugePages(ptr));
+    EXPECT_FALSE(PinnedAllocator::deallocateHugePages(ptr));
+    auto* again = PinnedAllocator::allocateHugePages(size, hugePageSize);
+    ASSERT_NE(again, nullptr);
+    EXPECT_TRUE(PinnedAllocator::deallocateHugePages(again));
+}
+
 TEST_F(TllmBuffersTest, HostAllocator)
 {
     auto constexpr size = 1024;
@@ -24,6 +24,7 @@
 
 #include "tensorrt_llm/common/cudaUtils.h"
 #include "tensorrt_llm/runtime/rawEngine.h"
+#include "tensorrt_llm/runtime/smPartition.h"
 #include "tensorrt_llm/runtime/tllmLogger.h"
 #include "tensorrt_llm/runtime/tllmRuntime.h"
 
@@ -48,7 +49,7 @@ std::unique_ptr<T> makeUnique(T* ptr)
     return std::unique_ptr<T>(ptr);
 }
 
-std::unique_ptr<trt::IHostMemory> buildMnistEngine(trt::ILogger& logger)
+std::unique_ptr<trt::IHostMemory> buildMnistEngine(trt::ILogger& logger, bool refittable = false)
 {
     EXPECT_TRUE(fs::exists(MNIST_MODEL_PATH));
     auto builder = makeUnique(trt::createInferBuilder(logger));
@@ -59,6 +60,10 @@ std::unique_ptr<trt::IHostMemory> buildMnistEngine(trt::ILogger& logger)
         MNIST_MODEL_PATH.string().c_str(), static_cast<int32_t>(trt::ILogger::Severity::kWARNING));
     EXPECT_TRUE(parsingSuccess);
     auto config = makeUnique(builder->createBuilderConfig());
+    if (refittable)
+    {
+        config->setFlag(trt::BuilderFlag::kREFIT);
+    }
     return makeUnique(builder->buildSerializedNetwork(*network, *config));
 }
 } // namespace
@@ -145,3 +150,101 @@ TEST_F(TllmRuntimeTest, SinglePass)
     auto max = std::max_element(output.begin(), output.end());
     EXPECT_NEAR(*max, 0.140218f, 1e-5f);
 }
+
+TEST_F(TllmRuntimeTest, RefitWeights)
+{
+    auto serializedEngine = buildMnistEngine(mLogger, true);
+    ASSERT_NE(serializedEngine, nullptr);
+    TllmRuntime rt{RawEngine(serializedEngine.get()), &mLogger, 1.0F};
+    auto& engine = rt.getEngine();
+    auto const names = rt.getRefittableWeightNames();
+    ASSERT_FALSE(names.empty());
+    rt.addContext(0);
+
+    auto& allocator = rt.getBufferManager();
+    auto const inputName = engine.getIOTensorName(0);
+    auto const outputName = engine.getIOTensorName(1);
+    TllmRuntime::TensorMap tensorMap{};
+    auto inputBuffer = std::shared_ptr<ITensor>{
+        allocator.gpu(engine.getTensorShape(inputName), engine.getTensorDataType(inputName))};
+    allocator.setZero(*inputBuffer);
+    tensorMap.insert(std::make_pair(inputName, inputBuffer));
+
+    // All weights set to zero, the context created before the refit must output zeros.
+    auto refitter = makeUnique(trt::createInferRefitter(engine, mLogger));
+    TllmRuntime::TensorMap weights{};
+    for (auto const& name : names)
+    {
+        auto const prototype = refitter->getWeightsPrototype(name.c_str());
+        auto values = std::shared_ptr<ITensor>{allocator.gpu(ITensor::makeShape({prototype.count}), prototype.type)};
+        allocator.setZero(*values);
+        weights.insert(std::make_pair(name, values));
+    }
+    rt.refitWeights(weights);
+
+    rt.setInputTensors(0, tensorMap);
+    rt.setOutputTensors(0, tensorMap);
+    auto outputBuffer = tensorMap.at(outputName);
+    rt.executeContext(0);
+    std::vector<float> output(outputBuffer->getSize());
+    allocator.copy(*outputBuffer, output.data());
+    rt.getStream().synchronize();
+    for (auto const value : output)
+    {
+        EXPECT_EQ(value, 0.f);
+    }
+
+    TllmRuntime::TensorMap unknown{{"unknown", weights.begin()->second}};
+    EXPECT_THROW(rt.refitWeights(unknown), tensorrt_llm::common::TllmException);
+}
+
+TEST_F(TllmRuntimeTest, ConcurrentContextsOnSmPartition)
+{
+    TllmRuntime rt{RawEngine(mSerializedEngine.get()), &mLogger, 1.0F};
+    auto& engine = rt.getEngine();
+    auto& allocator = rt.getBufferManager();
+    auto const inputName = engine.getIOTensorName(0);
+    auto const outputName = engine.getIOTensorName(1);
+
+    SmPartition partition{std::max(tc::getMultiProcessorCount() / 4, 1)};
+    EXPECT_GT(partition.getNumReservedSms(), 0);
+    EXPECT_GT(partition.getNumRemainingSms(), 0);
+    std::array const streams{partition.getReservedStream(), partition.getRemainingStream()};
+
+    std::vector<TllmRuntime::TensorMap> tensorMaps(streams.size());
+    for (std::size_t i = 0; i < streams.size(); ++i)
+    {
+        auto const contextIndex = static_cast<SizeType32>(i);
+        rt.addContext(0);
+        rt.setContextStream(contextIndex, streams[i]);
+        EXPECT_EQ(rt.getContextStream(contextIndex).get(), streams[i]->get());
+
+        auto inputBuffer = std::shared_ptr<ITensor>{
+            allocator.gpu(engine.getTensorShape(inputName), engine.getTensorDataType(inputName))};
+        allocator.setZero(*inputBuffer);
+        tensorMaps[i].insert(std::make_pair(inputName, inputBuffer));
+        rt.setInputTensors(contextIndex, tensorMaps[i]);
+        rt.setOutputTensors(contextIndex, tensorMaps[i]);
+        allocator.setZero(*tensorMaps[i].at(outputName));
+    }
+    for (std::size_t i = 0; i < streams.size(); ++i)
+    {
+        EXPECT_TRUE(rt.executeContext(static_cast<SizeType32>(i)));
+    }
+    rt.joinContextStreams();
+
+    // The same outputs as on the stream of the runtime
+    for (auto const& tensorMap : tensorMaps)
+    {
+        auto const& outputBuffer = tensorMap.at(outputName);
+        std::vector<float> output(outputBuffer->getSize());
+        allocator.copy(*outputBuffer, output.data());
+        rt.getStream().synchronize();
+        EXPECT_NEAR(*std::min_element(output.begin(), output.end()), -0.126409f, 1e-5f);
+        EXPECT_NEAR(*std::max_element(output.begin(), output.end()), 0.140218f, 1e-5f);
+    }
+
+    rt.setContextStream(0, nullptr);
+    EXPECT_EQ(rt.getContextStream(0).get(), rt.getStream().get());
+    rt.clearContexts();
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/tokenRing.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(TokenRingTest, PublishesTheLastPositions)
+{
+    SizeType32 constexpr maxBatchSize{2};
+    SizeType32 constexpr maxBeamWidth{1};
+    SizeType32 constexpr maxSequenceLength{10};
+    SizeType32 constexpr capacity{4};
+
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+
+    // Token of position p of slot s is 100 * s + p
+    std::vector<TokenIdType> outputIdsHost(maxBatchSize * maxBeamWidth * maxSequenceLength);
+    std::vector<float> logProbsHost(outputIdsHost.size());
+    for (std::size_t i = 0; i < outputIdsHost.size(); ++i)
+    {
+        outputIdsHost[i] = static_cast<TokenIdType>(100 * (i / maxSequenceLength) + i % maxSequenceLength);
+        logProbsHost[i] = -static_cast<float>(outputIdsHost[i]);
+    }
+    auto const outputIdsShape = ITensor::makeShape({maxBatchSize, maxBeamWidth, maxSequenceLength});
+    auto outputIds = manager.copyFrom(outputIdsHost, outputIdsShape, MemoryType::kGPU);
+    auto logProbs = manager.copyFrom(logProbsHost, outputIdsShape, MemoryType::kGPU);
+
+    TokenRing ring{maxBatchSize, maxBeamWidth, capacity};
+    auto const lengthsShape = ITensor::makeShape({maxBatchSize, maxBeamWidth});
+    auto sequenceLengths = manager.copyFrom(std::vector<SizeType32>{3, 6}, lengthsShape, MemoryType::kGPU);
+    ring.publish(*outputIds, logProbs.get(), *sequenceLengths, maxBatchSize, *stream);
+    stream->synchronize();
+
+    EXPECT_EQ(ring.getPublishedLength(0), 3);
+    EXPECT_EQ(ring.getPublishedLength(1), 6);
+
+    std::vector<TokenIdType> tokens;
+    std::vector<float> tokenLogProbs;
+    ASSERT_TRUE(ring.read(0, 0, 0, 3, tokens, &tokenLogProbs));
+    EXPECT_EQ(tokens, (std::vector<TokenIdType>{0, 1, 2}));
+    EXPECT_EQ(tokenLogProbs, (std::vector<float>{0.f, -1.f, -2.f}));
+
+    // Not published yet
+    EXPECT_FALSE(ring.read(0, 0, 2, 4, tokens));
+    // Overwritten, only the last positions are kept
+    EXPECT_FALSE(ring.read(1, 0, 0, 6, tokens));
+    EXPECT_EQ(tokens.size(), 3);
+    ASSERT_TRUE(ring.read(1, 0, 2, 6, tokens));
+    EXPECT_EQ(tokens, (std::vector<TokenIdType>{0, 1, 2, 102, 103, 104, 105}));
+
+    // The next step publishes the new positions only
+    std::vector<SizeType32> const nextLengths{5, 6};
+    manager.copy(nextLengths.data(), *sequenceLengths);
+    ring.publish(*outputIds, nullptr, *sequenceLengths, 1, *stream);
+    stream->synchronize();
+    EXPECT_EQ(ring.getPublishedLength(0), 5);
+    tokens.clear();
+    ASSERT_TRUE(ring.read(0, 0, 3, 5, tokens));
+    EXPECT_EQ(tokens, (std::vector<TokenIdType>{3, 4}));
+
+    // A new request in slot 0 is published from its input length
+    ring.resetSlot(0, 2, *stream);
+    std::vector<SizeType32> const newRequestLengths{4, 6};
+    manager.copy(newRequestLengths.data(), *sequenceLengths);
+    ring.publish(*outputIds, nullptr, *sequenceLengths, 1, *stream);
+    stream->synchronize();
+    EXPECT_EQ(ring.getPublishedLength(0), 4);
+    tokens.clear();
+    ASSERT_TRUE(ring.read(0, 0, 2, 4, tokens));
+    EXPECT_EQ(tokens, (std::vector<TokenIdType>{2, 3}));
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/virtualMemoryPool.h"
+#include "tensorrt_llm/common/tllmException.h"
+#include "tensorrt_llm/runtime/bufferManager.h"
+#include "tensorrt_llm/runtime/memoryCounters.h"
+
+#include <gtest/gtest.h>
+
+using namespace tensorrt_llm::runtime;
+
+TEST(VirtualMemoryPoolTest, ResizesAtAFixedAddress)
+{
+    auto stream = std::make_shared<CudaStream>();
+    BufferManager manager{stream};
+    auto const gpuBefore = MemoryCounters::getInstance().getGpu();
+
+    // Blocks of 192 KiB do not divide the chunks of 2 MiB
+    auto const blockShape = ITensor::makeShape({2, 3, 8192});
+    SizeType32 constexpr maxNumBlocks{64};
+    VirtualMemoryPool pool{blockShape, nvinfer1::DataType::kFLOAT, maxNumBlocks, 0};
+    EXPECT_EQ(pool.getBlockSizeInBytes(), 192 * 1024);
+    EXPECT_EQ(pool.getNumBlocks(), 0);
+    EXPECT_EQ(pool.getMappedBytes(), 0);
+    auto* const base = pool.data();
+
+    EXPECT_GE(pool.resize(20), 20);
+    EXPECT_EQ(pool.data(), base);
+    EXPECT_EQ(pool.getMappedBytes() % pool.getChunkSizeInBytes(), 0);
+    EXPECT_LT(pool.getMappedBytes(), 20 * pool.getBlockSizeInBytes() + pool.getChunkSizeInBytes());
+    EXPECT_EQ(MemoryCounters::getInstance().getGpu(), gpuBefore + pool.getMappedBytes());
+
+    auto tensor = pool.getTensor();
+    EXPECT_EQ(tensor->getShape().d[0], pool.getNumBlocks());
+    EXPECT_EQ(tensor->getShape().nbDims, 4);
+    EXPECT_EQ(tensor->data(), base);
+    std::vector<float> const values(ITensor::volume(blockShape), 1.f);
+    auto const lastBlock = ITensor::slice(tensor, 19, 1);
+    manager.copy(values.data(), *lastBlock);
+
+    // The blocks before the new size keep their content
+    EXPECT_EQ(pool.resize(maxNumBlocks), maxNumBlocks);
+    EXPECT_EQ(pool.data(), base);
+    EXPECT_EQ(pool.resize(20), pool.getNumBlocks());
+    EXPECT_GE(pool.getNumBlocks(), 20);
+    std::vector<float> copied(values.size());
+    manager.copy(*ITensor::slice(pool.getTensor(), 19, 1), copied.data());
+    stream->synchronize();
+    EXPECT_EQ(copied, values);
+
+    EXPECT_EQ(pool.resize(0), 0);
+    EXPECT_EQ(pool.getMappedBytes(), 0);
+    EXPECT_EQ(MemoryCounters::getInstance().getGpu(), gpuBefore);
+    EXPECT_THROW(pool.resize(maxNumBlocks + 1), tensorrt_llm::common::TllmException);
+}
@@ -0,0 +1,162 @@
+/*
+ * Copyright (c) 2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tensorrt_llm/runtime/workStealingPool.h"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace tensorrt_llm::runtime
+{
+
+TEST(WorkStealingPool, basic)
+{
+    WorkStealingPool pool(2);
+
+    auto fn = []() { return 12345; };
+    auto resultFuture = pool.enqueue<std::function<int()>, int>(std::move(fn));
+
+    auto fn2 = []() { return 12.345f; };
+    auto f2 = pool.enqueue<std::function<float()>, float>(std::move(fn2));
+
+    EXPECT_EQ(resultFuture.get(), 12345);
+    EXPECT_FLOAT_EQ(f2.get(), 12.345f);
+}
+
+TEST(WorkStealingPool, exceptionsAndMoveOnlyTasks)
+{
+    WorkStealingPool pool(2);
+
+    auto failing = pool.enqueue([]() -> int { throw std::runtime_error("task failed"); });
+    EXPECT_THROW(failing.get(), std::runtime_error);
+
+    // Too large for the inline storage of a task, and move-only.
+    auto value = std::make_unique<std::array<int, 64>>();
+    value->fill(7);
+    auto moved = pool.enqueue([value = std::move(value)]() { return value->back(); });
+    EXPECT_EQ(moved.get(), 7);
+}
+
+TEST(WorkStealingPool, bulkEnqueueAndStealing)
+{
+    WorkStealingPool pool(4);
+    std::atomic<int> sum{0};
+    std::vector<std::function<void()>> tasks;
+    for (int i = 1; i <= 1000; ++i)
+    {
+        tasks.emplace_back([&sum, i]() { sum += i; });
+    }
+    auto futures = pool.enqueueBulk(std::move(tasks));
+    ASSERT_EQ(futures.size(), 1000U);
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+    EXPECT_EQ(sum, 500500);
+
+    // Tasks enqueued by a worker go to its own queue, the idle workers steal them.
+    auto nested = pool.enqueue(
+        [&pool]()
+        {
+            std::vector<std::future<int>> inner;
+            for (int i = 0; i < 100; ++i)
+            {
+                inner.push_back(pool.enqueue([i]() { return i; }));
+            }
+            return inner;
+        });
+    int innerSum{0};
+    for (auto& future : nested.get())
+    {
+        innerSum += future.get();
+    }
+    EXPECT_EQ(innerSum, 4950);
+}
+
+TEST(WorkStealingPool, highPriorityFirst)
+{
+    WorkStealingPool pool(1);
+    std::promise<void> release;
+    auto blocker = pool.enqueue([gate = release.get_future().share()]() { gate.wait(); });
+
+    std::vector<int> order;
+    std::vector<std::future<void>> futures;
+    for (int i = 0; i < 3; ++i)
+    {
+        futures.push_back(pool.enqueue([&order, i]() { order.push_back(i); }, TaskPriority::kLOW));
+    }
+    futures.push_back(pool.enqueue([&order]() { order.push_back(100); }, TaskPriority::kHIGH));
+    release.set_value();
+    for (auto& future : futures)
+    {
+        future.get();
+    }
+    EXPECT_EQ(order, (std::vector<int>{100, 0, 1, 2}));
+}
+
+TEST(WorkStealingPool, dropsQueuedTasksOnShutdown)
+{
+    std::atomic<int> numRun{0};
+    std::promise<void> started;
+    std::future<std::future<void>> running;
+    std::vector<std::future<void>> queued;
+    auto const begin = std::chrono::steady_clock::now();
+    {
+        WorkStealingPool pool(1);
+        running = pool.enqueue(
+            [&pool, &started]()
+            {
+                started.set_value();
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                // The pool is shutting down by now and must reject the task instead of losing it.
+                return pool.enqueue([]() {});
+            });
+        for (int i = 0; i < 100; ++i)
+        {
+            queued.push_back(pool.enqueue(
+                [&numRun]()
+                {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                    ++numRun;
+                },
+                TaskPriority::kLOW));
+        }
+        started.get_future().wait();
+    }
+    // Only the running task is waited for, not the queued ones.
+    EXPECT_LT(std::chrono::steady_clock::now() - begin, std::chrono::seconds(5));
+    EXPECT_EQ(numRun, 0);
+    EXPECT_THROW(running.get(), std::runtime_error);
+    for (auto& future : queued)
+    {
+        try
+        {
+            future.get();
+            FAIL() << "A queued task ran after shutdown";
+        }
+        catch (std::future_error const& e)
+        {
+            EXPECT_EQ(e.code(), std::future_errc::broken_promise);
+        }
+    }
+}
+} // namespace tensorrt_llm::runtime
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2022-2024, NVIDIA CORPORATION.  All rights reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gtest/gtest.h>
+
+#include "tensorrt_llm/common/cudaUtils.h"
+#include "tensorrt_llm/kernels/gptKernels.h"
+#include "tensorrt_llm/thop/pagedAttentionOp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace tc = tensorrt_llm::common;
+namespace tk = tensorrt_llm::kernels;
+
+namespace
+{
+
+// The paged masked attention op over a pool with the layout of the KV cache manager: the K and V blocks of a block id
+// are consecutive and the sequences own scattered blocks. Its output must match the attention of the new token over
+// the past tokens read from the pool and itself, computed on the host, with grouped KV heads and with and without
+// multi-block mode. The op must also write the K and V of the new token to the slot of its position in the pool.
+class PagedAttentionOpTest : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        if (tc::getDeviceCount() == 0)
+        {
+            GTEST_SKIP() << "No CUDA device";
+        }
+        torch::manual_seed(42);
+        auto const opts = torch::TensorOptions().device(torch::kCUDA).dtype(torch::kHalf);
+        mPool = torch::rand({kNumBlocks, 2, kNumKVHeads, kTokensPerBlock, kHeadSize}, opts) * 2 - 1;
+        mQkv = torch::rand({kBatchSize, (kNumHeads + 2 * kNumKVHeads) * kHeadSize}, opts) * 2 - 1;
+
+        // [batch, 2, max_blocks_per_seq], the K block of block id b is 2 * b and its V block is 2 * b + 1
+        mBlockOffsets = torch::zeros({kBatchSize, 2, kMaxBlocksPerSeq}, torch::kInt32);
+        auto offsets = mBlockOffsets.accessor<int32_t, 3>();
+        for (int b = 0; b < kBatchSize; ++b)
+        {
+            for (std::size_t i = 0; i < mBlocks[b].size(); ++i)
+            {
+                offsets[b][0][i] = 2 * mBlocks[b][i];
+                offsets[b][1][i] = 2 * mBlocks[b][i] + 1;
+            }
+        }
+    }
+
+    //! \brief Runs the op on a copy of the pool, returns the output and the pool after the call as floats on the host.
+    std::pair<torch::Tensor, torch::Tensor> runOp(bool multiBlockMode) const
+    {
+        auto pool = mPool.clone();
+        auto const lengths = torch::tensor(mPastLengths, torch::kInt32);
+        auto const sequenceLengths = (lengths + 1).to(torch::kCUDA);
+        auto const contextLengths = lengths.to(torch::kCUDA);
+        auto const poolPointers = torch::tensor({reinterpret_cast<int64_t>(pool.data_ptr()), int64_t{0}});
+        auto const maxPastLength = *std::max_element(mPastLengths.begin(), mPastLengths.end());
+
+        auto output = torch_ext::pagedMaskedAttention(mQkv, sequenceLengths, contextLengths,
+            mBlockOffsets.to(torch::kCUDA), poolPointers, torch::nullopt, 0, maxPastLength, 1, kNumHeads, kNumKVHeads,
+            kHeadSize, kTokensPerBlock, kMaxBlocksPerSeq * kTokensPerBlock, 0, 1.0, 0, 10000.0,
+            static_cast<int64_t>(tk::PositionEmbeddingType::kLEARNED_ABSOLUTE), multiBlockMode);
+        return {output.to(torch::kFloat32).cpu(), pool.to(torch::kFloat32).cpu()};
+    }
+
+    //! \brief The K (kv 0) or V (kv 1) of `token` of sequence `b` in `pool`, [num_kv_heads, head_size].
+    torch::Tensor cacheRow(torch::Tensor const& pool, int b, int kv, int token) const
+    {
+        return pool.index({mBlocks[b][token / kTokensPerBlock], kv, torch::indexing::Slice(), token % kTokensPerBlock});
+    }
+
+    //! \brief The attention output of the new token of each sequence on the host, [batch, num_heads * head_size].
+    torch::Tensor referenceAttention() const
+    {
+        auto const pool = mPool.to(torch::kFloat32).cpu();
+        auto const qkv = mQkv.to(torch::kFloat32).cpu();
+        auto const groupSize = kNumHeads / kNumKVHeads;
+        auto output = torch::zeros({kBatchSize, kNumHeads * kHeadSize});
+        for (int b = 0; b < kBatchSize; ++b)
+        {
+            auto const past = static_cast<int>(mPastLengths[b]);
+            auto const q = qkv[b].slice(0, 0, kNumHeads * kHeadSize).view({kNumHeads, kHeadSize});
+            auto const newK = qkv[b].slice(0, kNumHeads * kHeadSize, (kNumHeads + kNumKVHeads) * kHeadSize);
+            auto const newV = qkv[b].slice(0, (kNumHeads + kNumKVHeads) * kHeadSize);
+            std::vector<torch::Tensor> keys, values;
+            for (int t = 0; t < past; ++t)
+            {
+                keys.push_back(cacheRow(pool, b, 0, t));
+                values.push_back(cacheRow(pool, b, 1, t));
+            }
+            keys.push_back(newK.view({kNumKVHeads, kHeadSize}));
+            values.push_back(newV.view({kNumKVHeads, kHeadSize}));
+            // [num_kv_heads, past + 1, head_size]
+            auto const k = torch::stack(keys, 1);
+            auto const v = torch::stack(values, 1);
+            for (int h = 0; h < kNumHeads; ++h)
+            {
+                auto const scores = torch::matmul(k[h / groupSize], q[h]) / std::sqrt(static_cast<float>(kHeadSize));
+                output[b].slice(0, h * kHeadSize, (h + 1) * kHeadSize)
+                    .copy_(torch::matmul(torch::softmax(scores, 0), v[h / groupSize]));
+            }
+        }
+        return output;
+    }
+
+    static constexpr int kBatchSize{2};
+    static constexpr int kNumHeads{4};
+    static constexpr int kNumKVHeads{2};
+    static constexpr int kHeadSize{64};
+    static constexpr int kTokensPerBlock{16};
+    static constexpr int kMaxBlocksPerSeq{3};
+    static constexpr int kNumBlocks{8};
+
+    // The new token of the first sequence starts its second block, the second one is in the middle of its third block
+    std::vector<int32_t> mPastLengths{16, 37};
+    std::vector<std::vector<int32_t>> mBlocks{{5, 1}, {0, 6, 3}};
+
+    torch::Tensor mPool;
+    torch::Tensor mQkv;
+    torch::Tensor mBlockOffsets;
+};
+
+} // namespace
+
+TEST_F(PagedAttentionOpTest, MatchesReference)
+{
+    auto const expected = referenceAttention();
+    auto const qkv = mQkv.to(torch::kFloat32).cpu();
+    for (bool multiBlockMode : {false, true})
+    {
+        SCOPED_TRACE(multiBlockMode);
+        auto const [output, pool] = runOp(multiBlockMode);
+        EXPECT_TRUE(torch::allclose(output, expected, 1e-2, 1e-2))
+            << "max error " << (output - expected).abs().max().item<float>();
+
+        for (int b = 0; b < kBatchSize; ++b)
+        {
+            SCOPED_TRACE(b);
+            auto const newK = qkv[b].slice(0, kNumHeads * kHeadSize, (kNumHeads + kNumKVHeads) * kHeadSize);
+            auto const newV = qkv[b].slice(0, (kNumHeads + kNumKVHeads) * kHeadSize);
+            EXPECT_TRUE(torch::equal(cacheRow(pool, b, 0, mPastLengths[b]), newK.view({kNumKVHeads, kHeadSize})));
+            EXPECT_TRUE(torch::equal(cacheRow(pool, b, 1, mPastLengths[b]), newV.view({kNumKVHeads, kHeadSize})));
+        }
+    }
+}